@@ -1529,6 +1529,10 @@ class WinGeneratorBase(GeneratorBase):
     sql_sources = [
       os.path.join('subversion', 'libsvn_fs_fs', 'rep-cache-db'),
       os.path.join('subversion', 'libsvn_fs_fs', 'revprops-db'),
+      os.path.join('subversion', 'libsvn_fs_fs', 'mergeinfo-index-db'),
+      os.path.join('subversion', 'libsvn_fs_fs', 'log-index-db'),
+      os.path.join('subversion', 'libsvn_fs_fs', 'locks-db'),
+      os.path.join('subversion', 'libsvn_fs_fs', 'node-origins-db'),
       os.path.join('subversion', 'libsvn_wc', 'wc-metadata'),
       os.path.join('subversion', 'libsvn_wc', 'wc-checks'),
       ]
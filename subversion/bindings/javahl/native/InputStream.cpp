@@ -26,7 +26,6 @@
 
 #include "InputStream.h"
 #include "JNIUtil.h"
-#include "JNIByteArray.h"
 
 /**
  * Create an InputStream object.
@@ -35,12 +34,16 @@
 InputStream::InputStream(jobject jthis)
 {
   m_jthis = jthis;
+  m_buffer = NULL;
+  m_bufferSize = 0;
 }
 
 InputStream::~InputStream()
 {
   // The m_jthis does not need to be destroyed, because it is the
   // passed in parameter to the Java method.
+  if (m_buffer != NULL)
+    JNIUtil::getEnv()->DeleteGlobalRef(m_buffer);
 }
 
 /**
@@ -51,10 +54,24 @@ InputStream::~InputStream()
  */
 svn_stream_t *InputStream::getStream(const SVN::Pool &pool)
 {
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // Channels can read straight into Subversion's buffer.
+  bool isChannel = false;
+  jclass clazz = env->FindClass("java/nio/channels/ReadableByteChannel");
+  if (clazz == NULL)
+    env->ExceptionClear();
+  else
+    {
+      isChannel = env->IsInstanceOf(m_jthis, clazz) ? true : false;
+      env->DeleteLocalRef(clazz);
+    }
+
   // Create a stream with this as the baton and set the read and
   // close functions.
   svn_stream_t *ret = svn_stream_create(this, pool.pool());
-  svn_stream_set_read(ret, InputStream::read);
+  svn_stream_set_read(ret, isChannel ? InputStream::readChannel
+                                     : InputStream::read);
   svn_stream_set_close(ret, InputStream::close);
   return ret;
 }
@@ -81,27 +98,36 @@ svn_error_t *InputStream::read(void *baton, char *buffer, apr_size_t *len)
       if (JNIUtil::isJavaExceptionThrown())
         return SVN_NO_ERROR;
 
-      mid = env->GetMethodID(clazz, "read", "([B)I");
+      mid = env->GetMethodID(clazz, "read", "([BII)I");
       if (JNIUtil::isJavaExceptionThrown() || mid == 0)
         return SVN_NO_ERROR;
 
       env->DeleteLocalRef(clazz);
     }
 
-  // Allocate a Java byte array to read the data.
-  jbyteArray data = JNIUtil::makeJByteArray((const signed char*)buffer,
-                                            *len);
-  if (JNIUtil::isJavaExceptionThrown())
-    return SVN_NO_ERROR;
+  // The Java byte array is kept from call to call, and only replaced
+  // when Subversion asks for more data than it holds.
+  if (that->m_buffer == NULL || that->m_bufferSize < *len)
+    {
+      if (that->m_buffer != NULL)
+        env->DeleteGlobalRef(that->m_buffer);
+      that->m_buffer = NULL;
 
-  // Read the data.
-  jint jread = env->CallIntMethod(that->m_jthis, mid, data);
-  if (JNIUtil::isJavaExceptionThrown())
-    return SVN_NO_ERROR;
+      jbyteArray data = env->NewByteArray(*len);
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
 
-  // Put the Java byte array into a helper object to retrieve the
-  // data bytes.
-  JNIByteArray outdata(data, true);
+      that->m_buffer = (jbyteArray) env->NewGlobalRef(data);
+      env->DeleteLocalRef(data);
+      if (that->m_buffer == NULL)
+        return SVN_NO_ERROR;
+
+      that->m_bufferSize = *len;
+    }
+
+  // Read the data.
+  jint jread = env->CallIntMethod(that->m_jthis, mid, that->m_buffer,
+                                  (jint) 0, (jint) *len);
   if (JNIUtil::isJavaExceptionThrown())
     return SVN_NO_ERROR;
 
@@ -109,10 +135,9 @@ svn_error_t *InputStream::read(void *baton, char *buffer, apr_size_t *len)
   if (jread > (jint) *len)
     jread = -1;
 
-  // In the case of success copy the data back to the Subversion
-  // buffer.
+  // In the case of success copy the data to the Subversion buffer.
   if (jread > 0)
-    memcpy(buffer, outdata.getBytes(), jread);
+    env->GetByteArrayRegion(that->m_buffer, 0, jread, (jbyte *) buffer);
 
   // Copy the number of read bytes back to Subversion.
   *len = jread;
@@ -120,6 +145,68 @@ svn_error_t *InputStream::read(void *baton, char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+/**
+ * Implements svn_read_fn_t to read data into Subversion from a Java
+ * object that is a ReadableByteChannel, through a direct ByteBuffer.
+ * @param baton     an InputStream object for the callback
+ * @param buffer    the buffer for the read data
+ * @param len       on input the buffer len, on output the number of read bytes
+ * @return a subversion error or SVN_NO_ERROR
+ */
+svn_error_t *InputStream::readChannel(void *baton, char *buffer,
+                                      apr_size_t *len)
+{
+  JNIEnv *env = JNIUtil::getEnv();
+  // An object of our class is passed in as the baton.
+  InputStream *that = (InputStream*)baton;
+
+  // The method id will not change during the time this library is
+  // loaded, so it can be cached.
+  static jmethodID mid = 0;
+  if (mid == 0)
+    {
+      jclass clazz = env->FindClass("java/nio/channels/ReadableByteChannel");
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      mid = env->GetMethodID(clazz, "read", "(Ljava/nio/ByteBuffer;)I");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        return SVN_NO_ERROR;
+
+      env->DeleteLocalRef(clazz);
+    }
+
+  // Subversion takes a short read for the end of the stream, so keep
+  // reading until the buffer is full or the channel has no more data.
+  apr_size_t total = 0;
+  while (total < *len)
+    {
+      jobject data = env->NewDirectByteBuffer(buffer + total, *len - total);
+      if (data == NULL)
+        {
+          if (JNIUtil::isJavaExceptionThrown())
+            return SVN_NO_ERROR;
+
+          // This VM does not support direct buffers.
+          return read(baton, buffer, len);
+        }
+
+      jint jread = env->CallIntMethod(that->m_jthis, mid, data);
+      env->DeleteLocalRef(data);
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      if (jread <= 0)
+        break;
+
+      total += jread;
+    }
+
+  *len = total;
+
+  return SVN_NO_ERROR;
+}
+
 /**
  * Implements svn_close_fn_t to close the input stream.
  * @param baton     an InputStream object for the callback
@@ -34,6 +34,11 @@
 /**
  * This class contains a Java objects implementing the interface InputStream and
  * implements the functions read & close of svn_stream_t.
+ *
+ * If the Java object also implements java.nio.channels.ReadableByteChannel,
+ * the data is read through a direct ByteBuffer wrapped around Subversion's
+ * own buffer, without any copying.  Otherwise it is read into a byte array
+ * that is reused for every call.
  */
 class InputStream
 {
@@ -42,7 +47,17 @@ class InputStream
    * A local reference to the Java object.
    */
   jobject m_jthis;
+  /**
+   * A global reference to the byte array reused by read(), or NULL.
+   */
+  jbyteArray m_buffer;
+  /**
+   * The length of m_buffer.
+   */
+  apr_size_t m_bufferSize;
   static svn_error_t *read(void *baton, char *buffer, apr_size_t *len);
+  static svn_error_t *readChannel(void *baton, char *buffer,
+                                  apr_size_t *len);
   static svn_error_t *close(void *baton);
  public:
   InputStream(jobject jthis);
@@ -39,6 +39,16 @@
 LogMessageCallback::LogMessageCallback(jobject jcallback)
 {
   m_callback = jcallback;
+  m_batch = false;
+
+  JNIEnv *env = JNIUtil::getEnv();
+  jclass clazz =
+    env->FindClass(JAVA_PACKAGE"/callback/LogMessageBatchCallback");
+  if (JNIUtil::isJavaExceptionThrown())
+    return;
+
+  m_batch = env->IsInstanceOf(m_callback, clazz) ? true : false;
+  env->DeleteLocalRef(clazz);
 }
 
 /**
@@ -49,6 +59,9 @@ LogMessageCallback::~LogMessageCallback()
   // The m_callback does not need to be destroyed because it is the
   // passed in parameter to the Java SVNClientInterface.logMessages
   // method.
+
+  // Drop whatever an aborted log left behind.
+  clearBatch();
 }
 
 svn_error_t *
@@ -158,6 +171,21 @@ LogMessageCallback::singleMessage(svn_log_entry_t *log_entry, apr_pool_t *pool)
   if (log_entry->revprops != NULL && apr_hash_count(log_entry->revprops) > 0)
     jrevprops = CreateJ::PropertyMap(log_entry->revprops, pool);
 
+  if (m_batch)
+    {
+      // NewGlobalRef() of NULL is NULL, which is what gets delivered.
+      m_changedPaths.push_back(env->NewGlobalRef(jChangedPaths));
+      m_revprops.push_back(env->NewGlobalRef(jrevprops));
+      m_revisions.push_back((jlong)log_entry->revision);
+      m_hasChildren.push_back((jboolean)log_entry->has_children);
+      env->PopLocalFrame(NULL);
+
+      if (m_revisions.size() >= BATCH_SIZE)
+        flush();
+
+      return SVN_NO_ERROR;
+    }
+
   env->CallVoidMethod(m_callback,
                       sm_mid,
                       jChangedPaths,
@@ -169,3 +197,118 @@ LogMessageCallback::singleMessage(svn_log_entry_t *log_entry, apr_pool_t *pool)
   env->PopLocalFrame(NULL);
   return SVN_NO_ERROR;
 }
+
+/**
+ * Deliver the collected log messages to a LogMessageBatchCallback.
+ */
+void
+LogMessageCallback::flush()
+{
+  if (m_revisions.empty())
+    return;
+
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // Create a local frame for our references
+  env->PushLocalFrame(LOCAL_FRAME_SIZE);
+  if (JNIUtil::isJavaExceptionThrown())
+    return;
+
+  jsize count = m_revisions.size();
+  jobjectArray jchangedPaths = NULL;
+  jobjectArray jrevprops = NULL;
+  jlongArray jrevisions = NULL;
+  jbooleanArray jhasChildren = NULL;
+  jclass clazzSet = NULL;
+  jclass clazzMap = NULL;
+
+  // The method id will not change during the time this library is
+  // loaded, so it can be cached.
+  static jmethodID mid = 0;
+  if (mid == 0)
+    {
+      jclass clazz =
+        env->FindClass(JAVA_PACKAGE"/callback/LogMessageBatchCallback");
+      if (JNIUtil::isJavaExceptionThrown())
+        goto cleanup;
+
+      mid = env->GetMethodID(clazz, "singleMessages",
+                             "([Ljava/util/Set;[J[Ljava/util/Map;[Z)V");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        goto cleanup;
+    }
+
+  clazzSet = env->FindClass("java/util/Set");
+  if (JNIUtil::isJavaExceptionThrown())
+    goto cleanup;
+
+  clazzMap = env->FindClass("java/util/Map");
+  if (JNIUtil::isJavaExceptionThrown())
+    goto cleanup;
+
+  jchangedPaths = env->NewObjectArray(count, clazzSet, NULL);
+  if (JNIUtil::isJavaExceptionThrown())
+    goto cleanup;
+
+  jrevprops = env->NewObjectArray(count, clazzMap, NULL);
+  if (JNIUtil::isJavaExceptionThrown())
+    goto cleanup;
+
+  for (jsize i = 0; i < count; ++i)
+    {
+      env->SetObjectArrayElement(jchangedPaths, i, m_changedPaths[i]);
+      if (JNIUtil::isJavaExceptionThrown())
+        goto cleanup;
+
+      env->SetObjectArrayElement(jrevprops, i, m_revprops[i]);
+      if (JNIUtil::isJavaExceptionThrown())
+        goto cleanup;
+    }
+
+  jrevisions = env->NewLongArray(count);
+  if (JNIUtil::isJavaExceptionThrown())
+    goto cleanup;
+
+  env->SetLongArrayRegion(jrevisions, 0, count, &m_revisions[0]);
+  if (JNIUtil::isJavaExceptionThrown())
+    goto cleanup;
+
+  jhasChildren = env->NewBooleanArray(count);
+  if (JNIUtil::isJavaExceptionThrown())
+    goto cleanup;
+
+  env->SetBooleanArrayRegion(jhasChildren, 0, count, &m_hasChildren[0]);
+  if (JNIUtil::isJavaExceptionThrown())
+    goto cleanup;
+
+  env->CallVoidMethod(m_callback, mid, jchangedPaths, jrevisions,
+                      jrevprops, jhasChildren);
+  // We clean up regardless of whether an exception is thrown or not,
+  // so we do not need to explicitly check for one.
+
+ cleanup:
+  clearBatch();
+  env->PopLocalFrame(NULL);
+}
+
+/**
+ * Release the log messages not yet delivered.
+ */
+void
+LogMessageCallback::clearBatch()
+{
+  JNIEnv *env = JNIUtil::getEnv();
+
+  for (size_t i = 0; i < m_revisions.size(); ++i)
+    {
+      if (m_changedPaths[i] != NULL)
+        env->DeleteGlobalRef(m_changedPaths[i]);
+      if (m_revprops[i] != NULL)
+        env->DeleteGlobalRef(m_revprops[i]);
+    }
+
+  m_changedPaths.clear();
+  m_revisions.clear();
+  m_revprops.clear();
+  m_hasChildren.clear();
+}
@@ -28,11 +28,16 @@
 #define LOGMESSAGECALLBACK_H
 
 #include <jni.h>
+#include <vector>
 #include "svn_client.h"
 
 /**
  * This class holds a Java callback object, which will receive every
  * log message for which the callback information is requested.
+ *
+ * If the Java object is a LogMessageBatchCallback, the log messages are
+ * collected and handed over BATCH_SIZE at a time.  flush() must be
+ * called once the log is done, to deliver the last batch.
  */
 class LogMessageCallback
 {
@@ -43,6 +48,8 @@ class LogMessageCallback
   static svn_error_t *callback(void *baton,
                                svn_log_entry_t *log_entry,
                                apr_pool_t *pool);
+
+  void flush();
  protected:
   svn_error_t *singleMessage(svn_log_entry_t *log_entry, apr_pool_t *pool);
 
@@ -51,6 +58,24 @@ class LogMessageCallback
    * This a local reference to the Java object.
    */
   jobject m_callback;
+
+  /**
+   * Whether m_callback is a LogMessageBatchCallback.
+   */
+  bool m_batch;
+
+  /**
+   * The log messages not yet delivered, with global references to
+   * their changed paths and revision properties.
+   */
+  std::vector<jobject> m_changedPaths;
+  std::vector<jlong> m_revisions;
+  std::vector<jobject> m_revprops;
+  std::vector<jboolean> m_hasChildren;
+
+  enum { BATCH_SIZE = 100 };
+
+  void clearBatch();
 };
 
 #endif  // LOGMESSAGECALLBACK_H
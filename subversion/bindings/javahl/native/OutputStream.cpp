@@ -26,7 +26,6 @@
 
 #include "OutputStream.h"
 #include "JNIUtil.h"
-#include "JNIByteArray.h"
 
 /**
  * Create an OutputStream object.
@@ -35,6 +34,8 @@
 OutputStream::OutputStream(jobject jthis)
 {
   m_jthis = jthis;
+  m_buffer = NULL;
+  m_bufferSize = 0;
 }
 
 /**
@@ -44,6 +45,8 @@ OutputStream::~OutputStream()
 {
   // The m_jthis does not need to be destroyed, because it is the
   // passed in parameter to the Java method.
+  if (m_buffer != NULL)
+    JNIUtil::getEnv()->DeleteGlobalRef(m_buffer);
 }
 
 /**
@@ -54,10 +57,24 @@ OutputStream::~OutputStream()
  */
 svn_stream_t *OutputStream::getStream(const SVN::Pool &pool)
 {
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // Channels can write straight from Subversion's buffer.
+  bool isChannel = false;
+  jclass clazz = env->FindClass("java/nio/channels/WritableByteChannel");
+  if (clazz == NULL)
+    env->ExceptionClear();
+  else
+    {
+      isChannel = env->IsInstanceOf(m_jthis, clazz) ? true : false;
+      env->DeleteLocalRef(clazz);
+    }
+
   // Create a stream with this as the baton and set the write and
   // close functions.
   svn_stream_t *ret = svn_stream_create(this, pool.pool());
-  svn_stream_set_write(ret, OutputStream::write);
+  svn_stream_set_write(ret, isChannel ? OutputStream::writeChannel
+                                      : OutputStream::write);
   svn_stream_set_close(ret, OutputStream::close);
   return ret;
 }
@@ -87,25 +104,109 @@ svn_error_t *OutputStream::write(void *baton, const char *buffer,
       if (JNIUtil::isJavaExceptionThrown())
         return SVN_NO_ERROR;
 
-      mid = env->GetMethodID(clazz, "write", "([B)V");
+      mid = env->GetMethodID(clazz, "write", "([BII)V");
       if (JNIUtil::isJavaExceptionThrown() || mid == 0)
         return SVN_NO_ERROR;
 
       env->DeleteLocalRef(clazz);
     }
 
-  // convert the data to a Java byte array
-  jbyteArray data = JNIUtil::makeJByteArray((const signed char*)buffer,
-                                            *len);
+  // The Java byte array is kept from call to call, and only replaced
+  // when Subversion writes more data than it holds.
+  if (that->m_buffer == NULL || that->m_bufferSize < *len)
+    {
+      if (that->m_buffer != NULL)
+        env->DeleteGlobalRef(that->m_buffer);
+      that->m_buffer = NULL;
+
+      jbyteArray data = env->NewByteArray(*len);
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      that->m_buffer = (jbyteArray) env->NewGlobalRef(data);
+      env->DeleteLocalRef(data);
+      if (that->m_buffer == NULL)
+        return SVN_NO_ERROR;
+
+      that->m_bufferSize = *len;
+    }
+
+  // copy the data to the Java byte array
+  env->SetByteArrayRegion(that->m_buffer, 0, *len, (const jbyte *) buffer);
   if (JNIUtil::isJavaExceptionThrown())
     return SVN_NO_ERROR;
 
   // write the data
-  env->CallObjectMethod(that->m_jthis, mid, data);
-  if (JNIUtil::isJavaExceptionThrown())
-    return SVN_NO_ERROR;
+  env->CallVoidMethod(that->m_jthis, mid, that->m_buffer,
+                      (jint) 0, (jint) *len);
+  // We return here regardless of whether an exception is thrown or not,
+  // so we do not need to explicitly check for one.
+
+  return SVN_NO_ERROR;
+}
+
+/**
+ * Implements svn_write_fn_t to write data out from Subversion to a Java
+ * object that is a WritableByteChannel, through a direct ByteBuffer.
+ * @param baton     an OutputStream object for the callback
+ * @param buffer    the buffer for the write data
+ * @param len       on input the buffer len, on output the number of written
+ *                  bytes
+ * @return a subversion error or SVN_NO_ERROR
+ */
+svn_error_t *OutputStream::writeChannel(void *baton, const char *buffer,
+                                        apr_size_t *len)
+{
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // An object of our class is passed in as the baton.
+  OutputStream *that = (OutputStream*)baton;
+
+  // The method id will not change during the time this library is
+  // loaded, so it can be cached.
+  static jmethodID mid = 0;
+  if (mid == 0)
+    {
+      jclass clazz = env->FindClass("java/nio/channels/WritableByteChannel");
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      mid = env->GetMethodID(clazz, "write", "(Ljava/nio/ByteBuffer;)I");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        return SVN_NO_ERROR;
+
+      env->DeleteLocalRef(clazz);
+    }
+
+  // The channel only reads from the buffer, so handing it Subversion's
+  // read-only data is safe.
+  jobject data = env->NewDirectByteBuffer((void *) buffer, *len);
+  if (data == NULL)
+    {
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      // This VM does not support direct buffers.
+      return write(baton, buffer, len);
+    }
+
+  // A channel may write less than asked for, so keep going until the
+  // buffer is drained; the ByteBuffer keeps track of the position.
+  apr_size_t total = 0;
+  while (total < *len)
+    {
+      jint jwritten = env->CallIntMethod(that->m_jthis, mid, data);
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      if (jwritten <= 0)
+        break;
+
+      total += jwritten;
+    }
 
   env->DeleteLocalRef(data);
+  *len = total;
 
   return SVN_NO_ERROR;
 }
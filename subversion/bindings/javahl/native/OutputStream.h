@@ -34,6 +34,11 @@
 /**
  * This class contains a Java objects implementing the interface OutputStream
  * and implements the functions write & close of svn_stream_t
+ *
+ * If the Java object also implements java.nio.channels.WritableByteChannel,
+ * the data is written through a direct ByteBuffer wrapped around
+ * Subversion's own buffer, without any copying.  Otherwise it is written
+ * from a byte array that is reused for every call.
  */
 class OutputStream
 {
@@ -41,8 +46,18 @@ class OutputStream
    * A local reference to the Java object.
    */
   jobject m_jthis;
+  /**
+   * A global reference to the byte array reused by write(), or NULL.
+   */
+  jbyteArray m_buffer;
+  /**
+   * The length of m_buffer.
+   */
+  apr_size_t m_bufferSize;
   static svn_error_t *write(void *baton,
                             const char *buffer, apr_size_t *len);
+  static svn_error_t *writeChannel(void *baton,
+                                   const char *buffer, apr_size_t *len);
   static svn_error_t *close(void *baton);
  public:
   OutputStream(jobject jthis);
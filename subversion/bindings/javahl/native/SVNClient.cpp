@@ -176,14 +176,19 @@ SVNClient::status(const char *path, svn_depth_t depth,
 
     rev.kind = svn_opt_revision_unspecified;
 
-    SVN_JNI_ERR(svn_client_status5(&youngest, checkedPath.c_str(),
-                                   &rev, StatusCallback::callback,
-                                   callback,
-                                   depth,
-                                   getAll, onServer, noIgnore,
-                                   ignoreExternals,
-                                   changelists.array(requestPool),
-                                   ctx, requestPool.pool()), );
+    svn_error_t *err = svn_client_status5(&youngest, checkedPath.c_str(),
+                                          &rev, StatusCallback::callback,
+                                          callback,
+                                          depth,
+                                          getAll, onServer, noIgnore,
+                                          ignoreExternals,
+                                          changelists.array(requestPool),
+                                          ctx, requestPool.pool());
+
+    // Deliver what was found even if the walk failed part way, as the
+    // unbatched callback would have.
+    callback->flush();
+    SVN_JNI_ERR(err, );
 }
 
 void SVNClient::username(const char *pi_username)
@@ -249,12 +254,14 @@ void SVNClient::logMessages(const char *path, Revision &pegRevision,
             return;
     }
 
-    SVN_JNI_ERR(svn_client_log5(targets, pegRevision.revision(), ranges,
-                                limit, discoverPaths, stopOnCopy,
-                                includeMergedRevisions,
-                                revProps.array(requestPool),
-                                LogMessageCallback::callback, callback, ctx,
-                                requestPool.pool()), );
+    svn_error_t *err = svn_client_log5(targets, pegRevision.revision(),
+                                       ranges, limit, discoverPaths,
+                                       stopOnCopy, includeMergedRevisions,
+                                       revProps.array(requestPool),
+                                       LogMessageCallback::callback,
+                                       callback, ctx, requestPool.pool());
+    callback->flush();
+    SVN_JNI_ERR(err, );
 }
 
 jlong SVNClient::checkout(const char *moduleName, const char *destPath,
@@ -838,18 +845,20 @@ void SVNClient::getMergeinfoLog(int type, const char *pathOrURL,
     Path srcURL(mergeSourceURL);
     SVN_JNI_ERR(srcURL.error_occured(), );
 
-    SVN_JNI_ERR(svn_client_mergeinfo_log((type == 1),
-                                         urlPath.c_str(),
-                                         pegRevision.revision(),
-                                         srcURL.c_str(),
-                                         srcPegRevision.revision(),
-                                         LogMessageCallback::callback,
-                                         callback,
-                                         discoverChangedPaths,
-                                         depth,
-                                         revProps.array(requestPool),
-                                         ctx,
-                                         requestPool.pool()), );
+    svn_error_t *err = svn_client_mergeinfo_log((type == 1),
+                                                urlPath.c_str(),
+                                                pegRevision.revision(),
+                                                srcURL.c_str(),
+                                                srcPegRevision.revision(),
+                                                LogMessageCallback::callback,
+                                                callback,
+                                                discoverChangedPaths,
+                                                depth,
+                                                revProps.array(requestPool),
+                                                ctx,
+                                                requestPool.pool());
+    callback->flush();
+    SVN_JNI_ERR(err, );
 
     return;
 }
@@ -37,6 +37,15 @@
 StatusCallback::StatusCallback(jobject jcallback)
 {
   m_callback = jcallback;
+  m_batch = false;
+
+  JNIEnv *env = JNIUtil::getEnv();
+  jclass clazz = env->FindClass(JAVA_PACKAGE"/callback/StatusBatchCallback");
+  if (JNIUtil::isJavaExceptionThrown())
+    return;
+
+  m_batch = env->IsInstanceOf(m_callback, clazz) ? true : false;
+  env->DeleteLocalRef(clazz);
 }
 
 /**
@@ -46,6 +55,12 @@ StatusCallback::~StatusCallback()
 {
   // the m_callback does not need to be destroyed, because it is the passed
   // in parameter to the Java SVNClient.status method.
+
+  // Drop whatever an aborted status walk left behind.
+  JNIEnv *env = JNIUtil::getEnv();
+  std::vector<jobject>::iterator it;
+  for (it = m_statuses.begin(); it != m_statuses.end(); ++it)
+    env->DeleteGlobalRef(*it);
 }
 
 svn_error_t *
@@ -75,6 +90,25 @@ StatusCallback::doStatus(const char *local_abspath,
   if (JNIUtil::isJavaExceptionThrown())
     return SVN_NO_ERROR;
 
+  if (m_batch)
+    {
+      jobject jStatus = CreateJ::Status(wc_ctx, local_abspath, status, pool);
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      jobject ref = env->NewGlobalRef(jStatus);
+      if (ref == NULL)
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      m_statuses.push_back(ref);
+      env->PopLocalFrame(NULL);
+
+      if (m_statuses.size() >= BATCH_SIZE)
+        flush();
+
+      return SVN_NO_ERROR;
+    }
+
   static jmethodID mid = 0; // the method id will not change during
   // the time this library is loaded, so
   // it can be cached.
@@ -102,6 +136,66 @@ StatusCallback::doStatus(const char *local_abspath,
   return SVN_NO_ERROR;
 }
 
+/**
+ * Deliver the collected status items to a StatusBatchCallback.
+ */
+void
+StatusCallback::flush()
+{
+  if (m_statuses.empty())
+    return;
+
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // Create a local frame for our references
+  env->PushLocalFrame(LOCAL_FRAME_SIZE);
+  if (JNIUtil::isJavaExceptionThrown())
+    return;
+
+  jobjectArray jstatuses = NULL;
+  static jmethodID mid = 0; // the method id will not change during
+  // the time this library is loaded, so
+  // it can be cached.
+  jclass clazz = env->FindClass(JAVA_PACKAGE"/Status");
+  if (JNIUtil::isJavaExceptionThrown())
+    goto cleanup;
+
+  if (mid == 0)
+    {
+      jclass cbClazz =
+        env->FindClass(JAVA_PACKAGE"/callback/StatusBatchCallback");
+      if (JNIUtil::isJavaExceptionThrown())
+        goto cleanup;
+
+      mid = env->GetMethodID(cbClazz, "doStatuses",
+                             "([L"JAVA_PACKAGE"/Status;)V");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        goto cleanup;
+    }
+
+  jstatuses = env->NewObjectArray(m_statuses.size(), clazz, NULL);
+  if (JNIUtil::isJavaExceptionThrown())
+    goto cleanup;
+
+  for (size_t i = 0; i < m_statuses.size(); ++i)
+    {
+      env->SetObjectArrayElement(jstatuses, i, m_statuses[i]);
+      if (JNIUtil::isJavaExceptionThrown())
+        goto cleanup;
+    }
+
+  env->CallVoidMethod(m_callback, mid, jstatuses);
+  // We clean up regardless of whether an exception is thrown or not,
+  // so we do not need to explicitly check for one.
+
+ cleanup:
+  for (size_t i = 0; i < m_statuses.size(); ++i)
+    env->DeleteGlobalRef(m_statuses[i]);
+  m_statuses.clear();
+
+  env->PopLocalFrame(NULL);
+}
+
 void
 StatusCallback::setWcCtx(svn_wc_context_t *wc_ctx_in)
 {
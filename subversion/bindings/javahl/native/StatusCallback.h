@@ -28,11 +28,17 @@
 #define STATUSCALLBACK_H
 
 #include <jni.h>
+#include <vector>
 #include "svn_client.h"
 
 /**
  * This class holds a Java callback object, each status item
  * for which the callback information is requested.
+ *
+ * If the Java object is a StatusBatchCallback, the status items are
+ * collected and handed over BATCH_SIZE at a time, which saves most of
+ * the upcalls on large working copies.  flush() must be called once
+ * the status walk is done, to deliver the last batch.
  */
 class StatusCallback
 {
@@ -42,6 +48,8 @@ class StatusCallback
 
   void setWcCtx(svn_wc_context_t *);
 
+  void flush();
+
   static svn_error_t* callback(void *baton,
                                const char *local_abspath,
                                const svn_wc_status3_t *status,
@@ -59,6 +67,18 @@ class StatusCallback
   jobject m_callback;
 
   svn_wc_context_t *wc_ctx;
+
+  /**
+   * Whether m_callback is a StatusBatchCallback.
+   */
+  bool m_batch;
+
+  /**
+   * Global references to the Status objects not yet delivered.
+   */
+  std::vector<jobject> m_statuses;
+
+  enum { BATCH_SIZE = 100 };
 };
 
 #endif // STATUSCALLBACK_H
@@ -0,0 +1,59 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+package org.apache.subversion.javahl.callback;
+package org.apache.subversion.javahl.callback;
+
+import org.apache.subversion.javahl.ChangePath;
+
+import java.util.Map;
+import java.util.Set;
+
+/**
+ * A LogMessageCallback that receives the log messages in batches rather
+ * than one at a time.  Element i of each array belongs to the i-th
+ * message of the batch, and the messages, including the ones that end
+ * a list (see LogMessageCallback), arrive in their usual order.
+ *
+ * When a callback implementing this interface is passed to
+ * SVNClientInterface.logMessages or getMergeinfoLog, only
+ * singleMessages is called.
+ *
+ * @since 1.7
+ */
+public interface LogMessageBatchCallback extends LogMessageCallback
+{
+    /**
+     * The method will be called for each batch of log messages.
+     *
+     * @param changedPaths   the sets of the paths that were changed
+     * @param revisions      the revisions of the commits
+     * @param revprops       the requested revision properties of each
+     *                       commit
+     * @param hasChildren    whether or not each entry has child entries
+     */
+    public void singleMessages(Set<ChangePath>[] changedPaths,
+                               long[] revisions,
+                               Map<String, byte[]>[] revprops,
+                               boolean[] hasChildren);
+}
@@ -0,0 +1,47 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+package org.apache.subversion.javahl.callback;
+package org.apache.subversion.javahl.callback;
+
+import org.apache.subversion.javahl.Status;
+
+/**
+ * A StatusCallback that receives the status items in batches rather
+ * than one at a time, which saves most of the calls across the native
+ * boundary when the working copy is large.  The items arrive in the
+ * same order as they would have one at a time.
+ *
+ * When a callback implementing this interface is passed to
+ * SVNClientInterface.status, only doStatuses is called.
+ *
+ * @since 1.7
+ */
+public interface StatusBatchCallback extends StatusCallback
+{
+    /**
+     * the method will be called for each batch of status items
+     * @param statuses  the status objects, never empty
+     */
+    public void doStatuses(Status[] statuses);
+}
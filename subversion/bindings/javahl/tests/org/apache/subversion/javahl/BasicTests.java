@@ -173,6 +173,76 @@ public class BasicTests extends SVNTests
 
     }
 
+    /**
+     * Test that the batched status and log callbacks see the same
+     * items as the ones that get them one at a time.
+     * @throws Throwable
+     */
+    public void testBatchCallbacks() throws Throwable
+    {
+        // build the test setup
+        OneTest thisTest = new OneTest();
+
+        MyStatusCallback single = new MyStatusCallback();
+        client.status(thisTest.getWCPath(), Depth.infinity, false, true,
+                      false, false, null, single);
+
+        final List<Status> statuses = new ArrayList<Status>();
+        final int[] statusCalls = new int[1];
+        client.status(thisTest.getWCPath(), Depth.infinity, false, true,
+                      false, false, null, new StatusBatchCallback() {
+            public void doStatus(Status status)
+            {
+                fail("doStatus called on a batch callback");
+            }
+
+            public void doStatuses(Status[] batch)
+            {
+                assertTrue("empty batch", batch.length > 0);
+                statusCalls[0]++;
+                statuses.addAll(Arrays.asList(batch));
+            }
+        });
+
+        Status[] expected = single.getStatusArray();
+        assertEquals("wrong number of status items", expected.length,
+                     statuses.size());
+        assertTrue("one call per item", statusCalls[0] < expected.length);
+        for (int i = 0; i < expected.length; i++)
+            assertEquals("wrong status path", expected[i].getPath(),
+                         statuses.get(i).getPath());
+
+        final List<Long> revisions = new ArrayList<Long>();
+        List<RevisionRange> ranges = new ArrayList<RevisionRange>(1);
+        ranges.add(new RevisionRange(null, null));
+        Set<String> revProps = new HashSet<String>();
+        revProps.add("svn:log");
+        client.logMessages(thisTest.getWCPath(), null, ranges, false, true,
+                           false, revProps, 0, new LogMessageBatchCallback() {
+            public void singleMessage(Set<ChangePath> changedPaths,
+                                      long revision,
+                                      Map<String, byte[]> revprops,
+                                      boolean hasChildren)
+            {
+                fail("singleMessage called on a batch callback");
+            }
+
+            public void singleMessages(Set<ChangePath>[] changedPaths,
+                                       long[] revs,
+                                       Map<String, byte[]>[] revprops,
+                                       boolean[] hasChildren)
+            {
+                assertEquals(revs.length, changedPaths.length);
+                assertEquals(revs.length, revprops.length);
+                assertEquals(revs.length, hasChildren.length);
+                for (int i = 0; i < revs.length; i++)
+                    revisions.add(revs[i]);
+            }
+        });
+        assertEquals("wrong log revisions",
+                     Arrays.asList(new Long[] { 1L }), revisions);
+    }
+
     /**
      * Test the "out of date" info from {@link
      * org.apache.subversion.javahl.SVNClient#status()}.
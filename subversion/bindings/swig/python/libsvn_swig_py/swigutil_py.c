@@ -1956,6 +1956,51 @@ apr_file_t *svn_swig_py_make_file(PyObject *py_file,
 }
 
 
+/* Read up to *LEN bytes from PY_IO straight into BUFFER by passing a
+   writable buffer object over it to PY_IO's readinto() method.  Unlike
+   read(), this doesn't allocate a string object for every chunk and copy
+   it out again.  The buffer object is only valid during the call, so it
+   is an error for readinto() to keep a reference to it.  Must be called
+   with the Python lock held. */
+static svn_error_t *
+readinto_pyio(PyObject *py_io, char *buffer, apr_size_t *len)
+{
+  PyObject *py_buffer, *result;
+  svn_error_t *err = SVN_NO_ERROR;
+  long bytes;
+
+  if ((py_buffer = PyBuffer_FromReadWriteMemory(buffer, *len)) == NULL)
+    return callback_exception_error();
+
+  if ((result = PyObject_CallMethod(py_io, (char *)"readinto",
+                                    (char *)"O", py_buffer)) == NULL)
+    {
+      err = callback_exception_error();
+    }
+  else if (py_buffer->ob_refcnt > 1)
+    {
+      err = callback_bad_return_error("readinto() kept the buffer");
+    }
+  else if (PyInt_Check(result) || PyLong_Check(result))
+    {
+      bytes = PyInt_AsLong(result);
+      if (bytes < 0 || (apr_size_t)bytes > *len)
+        err = callback_bad_return_error("Bad number of bytes");
+      else
+        /* Writeback, in case this was a short read, indicating EOF */
+        *len = bytes;
+    }
+  else
+    {
+      err = callback_bad_return_error("Not an integer");
+    }
+
+  Py_XDECREF(result);
+  Py_DECREF(py_buffer);
+
+  return err;
+}
+
 static svn_error_t *
 read_handler_pyio(void *baton, char *buffer, apr_size_t *len)
 {
@@ -1973,6 +2018,13 @@ read_handler_pyio(void *baton, char *buffer, apr_size_t *len)
     }
 
   svn_swig_py_acquire_py_lock();
+  if (PyObject_HasAttrString(py_io, "readinto"))
+    {
+      err = readinto_pyio(py_io, buffer, len);
+      svn_swig_py_release_py_lock();
+      return err;
+    }
+
   if ((result = PyObject_CallMethod(py_io, (char *)"read",
                                     (char *)"i", *len)) == NULL)
     {
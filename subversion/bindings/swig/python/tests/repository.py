@@ -139,6 +139,24 @@ class SubversionRepositoryTestCase(unittest.TestCase):
     #        svn_repos_t objects, so the following call segfaults
     #repos.dump_fs2(None, None, None, 0, self.rev, 0, 0, None)
 
+  def test_load_fs2_from_file(self):
+    """Test loading a dump from a file object, which uses readinto()"""
+    dumpfile = tempfile.TemporaryFile()
+    repos.dump_fs2(self.repos, dumpfile, None, 0, self.rev, 0, 0, None)
+    dumpfile.seek(0)
+
+    path = core.svn_dirent_internal_style(tempfile.mkdtemp("-load"))
+    try:
+      loaded_repos = repos.create(path, "", "", None, None)
+      repos.svn_repos_load_fs2(loaded_repos, dumpfile, StringIO(),
+                               repos.svn_repos_load_uuid_ignore, '',
+                               0, 0, None)
+      self.assertEqual(fs.youngest_rev(repos.fs(loaded_repos)), self.rev)
+    finally:
+      loaded_repos = None
+      dumpfile.close()
+      repos.delete(path)
+
   def test_get_logs(self):
     """Test scope of get_logs callbacks"""
     logs = []
@@ -43,6 +43,17 @@ typedef int (*authz_svn__subreq_bypass_func_t)(request_rec *r,
                                               const char *repos_path,
                                               const char *repos_name);
 
+/*
+ * mod_dav_svn to mod_authz_svn query whether everything beneath
+ * REPOS_PATH is readable; returns OK if so
+ */
+#define AUTHZ_SVN__SUBTREE_READABLE_PROV_GRP "dav2authz_subtree_readable"
+#define AUTHZ_SVN__SUBTREE_READABLE_PROV_NAME "mod_authz_svn_subtree_readable"
+#define AUTHZ_SVN__SUBTREE_READABLE_PROV_VER "00.00a"
+typedef int (*authz_svn__subtree_readable_func_t)(request_rec *r,
+                                                  const char *repos_path,
+                                                  const char *repos_name);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -32,6 +32,7 @@
 
 #include "svn_types.h"
 #include "svn_error.h"
+#include "svn_auth.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -188,6 +189,19 @@ svn_auth__ssl_client_cert_pw_set(apr_hash_t *creds,
                                  svn_boolean_t non_interactive,
                                  apr_pool_t *pool);
 
+/* Set *THREAD_BATON to a baton, allocated in RESULT_POOL, that uses the
+ * providers and the credentials cache of AUTH_BATON but has a copy of
+ * its parameters of its own.  Batons made this way may be used by
+ * different threads at the same time: the providers are called by one
+ * thread at a time.  Credentials are still allocated in the pool of
+ * AUTH_BATON, so neither that pool nor AUTH_BATON may be used otherwise
+ * while other threads use such batons.
+ */
+svn_error_t *
+svn_auth__make_thread_baton(svn_auth_baton_t **thread_baton,
+                            svn_auth_baton_t *auth_baton,
+                            apr_pool_t *result_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
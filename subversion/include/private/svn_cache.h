@@ -34,6 +34,7 @@
 #include "svn_types.h"
 #include "svn_error.h"
 #include "svn_iter.h"
+#include "svn_string.h"
 #include "svn_config.h"
 
 
@@ -60,10 +61,13 @@ typedef svn_error_t *(*svn_cache__dup_func_t)(void **out,
 
 /**
  * A function type for deserializing an object @a *out from the string
- * @a data of length @a data_len in the pool @a pool.
+ * @a data of length @a data_len in the pool @a pool.  @a data has been
+ * allocated in @a pool and is owned by the caller.  The function may
+ * therefore modify it in place and let @a *out refer to it, e.g. to
+ * resolve data produced by the svn_temp_serializer__* API.
 */
 typedef svn_error_t *(*svn_cache__deserialize_func_t)(void **out,
-                                                      const char *data,
+                                                      char *data,
                                                       apr_size_t data_len,
                                                       apr_pool_t *pool);
 
@@ -77,6 +81,21 @@ typedef svn_error_t *(*svn_cache__serialize_func_t)(char **data,
                                                     void *in,
                                                     apr_pool_t *pool);
 
+/**
+ * A function type for extracting a part of a cached value without
+ * deserializing all of it.  @a data points to the serialized value of
+ * length @a data_len, as produced by the cache's serialization function.
+ * It is owned by the cache and must neither be modified nor referenced
+ * after the function returns.  The function should allocate the result
+ * @a *out in @a pool.  @a baton is passed through from
+ * svn_cache__get_partial.
+ */
+typedef svn_error_t *(*svn_cache__partial_getter_func_t)(void **out,
+                                                         const char *data,
+                                                         apr_size_t data_len,
+                                                         void *baton,
+                                                         apr_pool_t *pool);
+
 /**
  * A function type for transforming or ignoring errors.  @a pool may
  * be used for temporary allocations.
@@ -113,7 +132,10 @@ typedef struct svn_cache__t svn_cache__t;
  * may certainly be 1).
  *
  * If @a thread_safe is true, and APR is compiled with threads, all
- * accesses to the cache will be protected with a mutex.
+ * accesses to the cache will be protected with a mutex.  Large caches
+ * get split into several segments with a mutex each, so that threads
+ * accessing different keys don't contend for a single lock; the pages
+ * are distributed among the segments and get reused within them.
  *
  * Note that NULL is a legitimate value for cache entries (and @a dup_func
  * will not be called on it).
@@ -173,6 +195,109 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
                                      svn_config_t *config,
                                      apr_pool_t *pool);
 
+/**
+ * An opaque structure representing a membuffer cache object: a
+ * fixed-size block of memory that may be shared by any number of
+ * svn_cache__t instances (see svn_cache__create_membuffer_cache).
+ */
+typedef struct svn_membuffer_t svn_membuffer_t;
+
+/**
+ * Creates a new membuffer cache object in @a *cache.  It will use up to
+ * @a total_size bytes of memory, allocated once in @a pool, of which
+ * @a directory_size bytes will be used for the index; the remainder
+ * holds the serialized cache items.  If @a directory_size is 0, a
+ * suitable default will be used.
+ *
+ * If @a thread_safe is true, and APR is compiled with threads, all
+ * accesses to the cache will be protected with a mutex.
+ *
+ * If @a shared is true, the memory will be taken from anonymous shared
+ * memory and all access will be protected with a cross-process mutex.
+ * All processes forked after this call will then share the cached
+ * data.  If the platform does not support this, raises
+ * SVN_ERR_UNSUPPORTED_FEATURE.
+ */
+svn_error_t *
+svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
+                                  apr_size_t total_size,
+                                  apr_size_t directory_size,
+                                  svn_boolean_t thread_safe,
+                                  svn_boolean_t shared,
+                                  apr_pool_t *pool);
+
+/**
+ * Creates a new cache in @a *cache_p, storing the data in a potentially
+ * shared @a membuffer object.  The elements in the cache will be indexed
+ * by keys of length @a klen, which may be APR_HASH_KEY_STRING if they
+ * are strings.  Values will be serialized for the membuffer using @a
+ * serialize_func and deserialized using @a deserialize_func.  Because
+ * the same membuffer may cache many different kinds of values, @a prefix
+ * should be specified to differentiate this cache from other caches.
+ * @a *cache_p will be allocated in @a pool.
+ *
+ * If @a deserialize_func is NULL, then the data is returned as an
+ * svn_string_t; if @a serialize_func is NULL, then the data is
+ * assumed to be an svn_stringbuf_t.
+ *
+ * These caches are thread safe if @a membuffer is.
+ *
+ * These caches do not support svn_cache__iter.
+ */
+svn_error_t *
+svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
+                                  svn_membuffer_t *membuffer,
+                                  svn_cache__serialize_func_t serialize_func,
+                                  svn_cache__deserialize_func_t deserialize_func,
+                                  apr_ssize_t klen,
+                                  const char *prefix,
+                                  apr_pool_t *pool);
+
+/**
+ * Process-wide cache settings.  These control the membuffer returned
+ * by svn_cache__get_global_membuffer_cache.
+ */
+typedef struct svn_cache__config_t
+{
+  /** Total size of the global membuffer in bytes.  0 disables it. */
+  apr_uint64_t cache_size;
+
+  /** Whether caches should store fulltexts. */
+  svn_boolean_t cache_fulltexts;
+
+  /** Whether the membuffer should be allocated from shared memory, so
+   * that all processes forked later share its contents. */
+  svn_boolean_t shared;
+
+  /** Set this if the caches will only be accessed from one thread. */
+  svn_boolean_t single_threaded;
+} svn_cache__config_t;
+
+/**
+ * Return the current process-wide cache settings.
+ */
+const svn_cache__config_t *
+svn_cache__get_global_config(void);
+
+/**
+ * Replace the process-wide cache settings with a copy of @a settings.
+ *
+ * Since the global membuffer is created only once, this should be
+ * called before any cache has been created.  If @a settings->shared is
+ * set, the global membuffer gets allocated immediately, so that processes
+ * forked after this call share it; errors while doing so are returned.
+ */
+svn_error_t *
+svn_cache__set_global_config(const svn_cache__config_t *settings);
+
+/**
+ * Return the process-wide membuffer, creating it on first use according
+ * to the settings provided by svn_cache__set_global_config.  Returns
+ * NULL if the membuffer has been disabled or could not be created.
+ */
+svn_membuffer_t *
+svn_cache__get_global_membuffer_cache(void);
+
 /**
  * Sets @a handler to be @a cache's error handling routine.  If any
  * error is returned from a call to svn_cache__get or svn_cache__set, @a
@@ -204,6 +329,24 @@ svn_cache__get(void **value,
                const void *key,
                apr_pool_t *pool);
 
+/**
+ * Fetches the values indexed by the @a nkeys keys in @a keys from
+ * @a cache, like svn_cache__get would for each of them: @a values[i]
+ * and @a found[i] receive the result for @a keys[i].  Both arrays must
+ * have room for @a nkeys elements.  Values are allocated in @a pool.
+ *
+ * Caches backed by a remote server, i.e. those created by
+ * svn_cache__create_memcache, fetch all keys in a single round trip.
+ * Other caches simply look up one key after the other.
+ */
+svn_error_t *
+svn_cache__get_many(void **values,
+                    svn_boolean_t *found,
+                    const svn_cache__t *cache,
+                    const void *const *keys,
+                    int nkeys,
+                    apr_pool_t *pool);
+
 /**
  * Stores the value @a value under the key @a key in @a cache.  @a pool
  * is used only for temporary allocations.  The cache makes copies of
@@ -222,6 +365,29 @@ svn_cache__set(svn_cache__t *cache,
                void *value,
                apr_pool_t *pool);
 
+/**
+ * Like svn_cache__get but instead of deserializing the whole value
+ * indexed by @a key, call @a func with @a baton on its serialized
+ * representation and return the result of @a func in @a *value.  For
+ * large values of which only a small part is needed, this avoids
+ * copying and deserializing the rest.  @a pool is passed on to @a func.
+ *
+ * Caches that don't store serialized data, i.e. those created by
+ * svn_cache__create_inprocess, report every value as not found.  Callers
+ * should then fall back to svn_cache__get.
+ *
+ * It is not legal to perform any other cache operations on @a cache
+ * inside @a func.
+ */
+svn_error_t *
+svn_cache__get_partial(void **value,
+                       svn_boolean_t *found,
+                       const svn_cache__t *cache,
+                       const void *key,
+                       svn_cache__partial_getter_func_t func,
+                       void *baton,
+                       apr_pool_t *pool);
+
 /**
  * Iterates over the elements currently in @a cache, calling @a func
  * for each one until there are no more elements or @a func returns an
@@ -248,6 +414,77 @@ svn_cache__iter(svn_boolean_t *completed,
                 svn_iter_apr_hash_cb_t func,
                 void *baton,
                 apr_pool_t *pool);
+
+/**
+ * Usage statistics of a cache, as returned by svn_cache__get_info.
+ * Values a cache implementation cannot determine are reported as 0.
+ */
+typedef struct svn_cache__info_t
+{
+  /** Number of svn_cache__get calls. */
+  apr_uint64_t gets;
+
+  /** Number of svn_cache__get calls that found the requested entry. */
+  apr_uint64_t hits;
+
+  /** Number of svn_cache__set calls. */
+  apr_uint64_t sets;
+
+  /** Number of svn_cache__get and svn_cache__set calls that failed. */
+  apr_uint64_t failures;
+
+  /** Number of entries that have been removed to make room for others. */
+  apr_uint64_t evictions;
+
+  /** Number of bytes currently used by cached data. */
+  apr_uint64_t used_size;
+
+  /** Maximum number of bytes available for cached data. */
+  apr_uint64_t total_size;
+
+  /** Number of entries currently in the cache. */
+  apr_uint64_t used_entries;
+
+  /** Maximum number of entries the cache can hold. */
+  apr_uint64_t total_entries;
+} svn_cache__info_t;
+
+/**
+ * Fill @a *info with the usage statistics of @a cache.  The get, hit,
+ * set and failure counts refer to @a cache itself.  For caches sharing
+ * a membuffer, all other values describe the whole membuffer.
+ *
+ * If @a reset is set, the counters of @a cache will start over at 0.
+ * The counters are not synchronized between threads, i.e. they are
+ * approximations for caches used concurrently.  Use @a pool for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_cache__get_info(const svn_cache__t *cache,
+                    svn_cache__info_t *info,
+                    svn_boolean_t reset,
+                    apr_pool_t *pool);
+
+/**
+ * Fill @a *info with the usage statistics of all caches sharing
+ * @a membuffer.  For shared membuffers, these include all processes.
+ * If @a reset is set, the counters start over at 0.  Use @a pool for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_cache__membuffer_get_info(svn_membuffer_t *membuffer,
+                              svn_cache__info_t *info,
+                              svn_boolean_t reset,
+                              apr_pool_t *pool);
+
+/**
+ * Return a one-line, human-readable summary of @a info for the cache
+ * named @a id, allocated in @a pool.
+ */
+svn_string_t *
+svn_cache__format_info(const char *id,
+                       const svn_cache__info_t *info,
+                       apr_pool_t *pool);
 /** @} */
 
 
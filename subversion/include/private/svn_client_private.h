@@ -49,6 +49,40 @@ svn_client__obliterate_path_rev(const char *url,
                                 svn_client_ctx_t *ctx,
                                 apr_pool_t *pool);
 
+/** Like svn_client_checkout3() with @a allow_unver_obstructions set to
+ * FALSE, but don't fetch the texts of the checked out files: record
+ * only their checksums and leave them out of the working copy until
+ * svn_client__hydrate() fetches them.  Externals are checked out as
+ * usual.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_client__checkout_lazy(svn_revnum_t *result_rev,
+                          const char *URL,
+                          const char *path,
+                          const svn_opt_revision_t *peg_revision,
+                          const svn_opt_revision_t *revision,
+                          svn_depth_t depth,
+                          svn_boolean_t ignore_externals,
+                          svn_client_ctx_t *ctx,
+                          apr_pool_t *pool);
+
+/** Fetch the texts of the files left out by svn_client__checkout_lazy()
+ * at or below each of the working copy @a paths, to the depth @a depth,
+ * and install them.
+ *
+ * If @a ctx->notify_func2 is non-NULL, invoke it with
+ * #svn_wc_notify_restore for each file installed.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_client__hydrate(const apr_array_header_t *paths,
+                    svn_depth_t depth,
+                    svn_client_ctx_t *ctx,
+                    apr_pool_t *pool);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,73 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ *
+ * @file svn_config_private.h
+ * @brief Private config file parsing API.
+ */
+
+#ifndef SVN_CONFIG_PRIVATE_H
+#define SVN_CONFIG_PRIVATE_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/* Expand all the option values in CFG once and for all, and make CFG
+ * read-only: svn_config_set() and svn_config_merge() must no longer be
+ * called on it.  A read-only config doesn't change when it is queried,
+ * so it can be shared between threads without copying.
+ *
+ * Default values passed to svn_config_get() and friends are returned
+ * without variable expansion for a read-only CFG.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+void
+svn_config__set_read_only(svn_config_t *cfg,
+                          apr_pool_t *scratch_pool);
+
+/* Return TRUE if CFG has been made read-only by
+ * svn_config__set_read_only().
+ */
+svn_boolean_t
+svn_config__is_read_only(svn_config_t *cfg);
+
+/* Return a copy of the options in CFG, allocated in RESULT_POOL.  The
+ * copy is not read-only, even if CFG is.
+ */
+svn_config_t *
+svn_config__dup(svn_config_t *cfg,
+                apr_pool_t *result_pool);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_CONFIG_PRIVATE_H */
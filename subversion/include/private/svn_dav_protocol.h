@@ -46,6 +46,42 @@ extern "C" {
 #define SVN_DAV__INCLUDE_DESCENDANTS "include-descendants"
 #define SVN_DAV__VERSION_NAME "version-name"
 
+/** The media type of an update-report response in the binary encoding,
+    and the codes of the records such a response is made of.  See the
+    update-report section of notes/http-and-webdav/webdav-protocol. */
+#define SVN_DAV__BINARY_UPDATE_MIME_TYPE "application/vnd.svn-update"
+#define SVN_DAV__BIN_TARGET_REVISION  'T'
+#define SVN_DAV__BIN_OPEN_ROOT        'R'
+#define SVN_DAV__BIN_DELETE_ENTRY     'X'
+#define SVN_DAV__BIN_ADD_DIR          'A'
+#define SVN_DAV__BIN_OPEN_DIR         'O'
+#define SVN_DAV__BIN_CLOSE_DIR        'Z'
+#define SVN_DAV__BIN_ABSENT_DIR       'B'
+#define SVN_DAV__BIN_ADD_FILE         'a'
+#define SVN_DAV__BIN_OPEN_FILE        'o'
+#define SVN_DAV__BIN_CLOSE_FILE       'z'
+#define SVN_DAV__BIN_ABSENT_FILE      'b'
+#define SVN_DAV__BIN_CHANGE_PROP      'P'
+#define SVN_DAV__BIN_CHECKED_IN       'C'
+#define SVN_DAV__BIN_APPLY_TEXTDELTA  'D'
+#define SVN_DAV__BIN_SVNDIFF_CHUNK    'd'
+#define SVN_DAV__BIN_TEXTDELTA_END    'E'
+#define SVN_DAV__BIN_CLOSE_EDIT       '.'
+#define SVN_DAV__BIN_ERROR            '!'
+
+/** The media type of a POST request body by which a mirror forwards a
+    whole commit to its master, in the same record format, and the codes
+    of the records only such a body contains.  See the "Batched commits"
+    section of notes/http-and-webdav/webdav-protocol. */
+#define SVN_DAV__BATCH_COMMIT_MIME_TYPE "application/vnd.svn-commit"
+#define SVN_DAV__BIN_REVPROP          'V'
+#define SVN_DAV__BIN_LOCK_TOKEN       'L'
+
+/** The media type of a POST request body asking to lock or unlock many
+    paths at once.  See the "Bulk locking" section of
+    notes/http-and-webdav/webdav-protocol. */
+#define SVN_DAV__LOCKS_MIME_TYPE "application/vnd.svn-locks+xml"
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
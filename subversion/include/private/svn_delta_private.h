@@ -0,0 +1,95 @@
+/*
+ * svn_delta_private.h: Private declarations for the delta layer to
+ * be consumed by libsvn_delta and non-libsvn_delta modules.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_DELTA_PRIVATE_H
+#define SVN_DELTA_PRIVATE_H
+
+#include <apr_pools.h>
+
+#include "svn_delta.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** State for composing delta windows that is kept between compositions,
+ * so that its index storage can be reused.
+ *
+ * @since New in 1.7.
+ */
+typedef struct svn_txdelta__compose_ctx_t svn_txdelta__compose_ctx_t;
+
+/** Return a new, empty composition context allocated in @a pool.  All
+ * index storage of compositions using the context is allocated in
+ * @a pool as well and gets recycled for later compositions.
+ *
+ * @since New in 1.7.
+ */
+svn_txdelta__compose_ctx_t *
+svn_txdelta__compose_ctx_create(apr_pool_t *pool);
+
+/** Same as svn_txdelta_compose_windows(), but use @a ctx for all
+ * temporary index structures.  Compositions using the same @a ctx must
+ * not overlap.
+ *
+ * @since New in 1.7.
+ */
+svn_txdelta_window_t *
+svn_txdelta__compose_windows(const svn_txdelta_window_t *window_A,
+                             const svn_txdelta_window_t *window_B,
+                             svn_txdelta__compose_ctx_t *ctx,
+                             apr_pool_t *pool);
+
+/** Return a delta stream that turns the empty stream into @a target,
+ * allocated in @a pool.  Unlike svn_txdelta2() against
+ * svn_stream_empty(), it reads @a target straight into windows of at
+ * most @a window_size bytes (#SVN_DELTA_DEFAULT_WINDOW_SIZE if 0) that
+ * consist of a single new-data op each, without any delta computation.
+ * Every window is allocated in the pool passed for it, so it stays
+ * valid for as long as that pool.
+ *
+ * @since New in 1.7.
+ */
+svn_txdelta_stream_t *
+svn_txdelta__fulltext_stream(svn_stream_t *target,
+                             apr_size_t window_size,
+                             apr_pool_t *pool);
+
+/** Same as svn_txdelta_skip_svndiff_window(), but also set
+ * @a *tview_len to the size of the target view of the skipped window,
+ * i.e. the number of bytes it would have produced.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_txdelta__skip_svndiff_window(apr_size_t *tview_len,
+                                 apr_file_t *file,
+                                 int svndiff_version,
+                                 apr_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_DELTA_PRIVATE_H */
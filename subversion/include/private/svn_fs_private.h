@@ -26,6 +26,7 @@
 #define SVN_FS_PRIVATE_H
 
 #include "svn_fs.h"
+#include "private/svn_cache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -78,6 +79,166 @@ svn_fs__begin_obliteration_txn(svn_fs_txn_t **txn_p,
                                svn_revnum_t rev,
                                apr_pool_t *pool);
 
+/**
+ * Set @a *info_p to a hash mapping the names (<tt>const char *</tt>) of
+ * the caches used by @a fs to their usage statistics
+ * (<tt>svn_cache__info_t *</tt>), allocated in @a pool.  Back ends
+ * without caches return an empty hash.  If @a reset is set, the
+ * counters of these caches start over at 0.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_fs__get_cache_info(apr_hash_t **info_p,
+                       svn_fs_t *fs,
+                       svn_boolean_t reset,
+                       apr_pool_t *pool);
+
+
+/**
+ * Set @a *revision to the youngest revision no younger than @a rev in
+ * which @a path or anything below it changed in @a fs, and @a *added to
+ * whether @a path itself got added or replaced in that revision.  Set
+ * @a *revision to #SVN_INVALID_REVNUM if there is no such revision.
+ *
+ * This is answered from an index kept by the back end, if it has one
+ * covering @a rev, and @a *indexed is set to TRUE.  Otherwise, set
+ * @a *indexed to FALSE and leave the other results alone; the caller
+ * has to find out from the node history instead.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_fs__log_index_prev(svn_boolean_t *indexed,
+                       svn_revnum_t *revision,
+                       svn_boolean_t *added,
+                       svn_fs_t *fs,
+                       const char *path,
+                       svn_revnum_t rev,
+                       apr_pool_t *pool);
+
+/**
+ * Set @a *revision to the youngest revision of @a fs at time @a tm,
+ * with the same result as a binary search over the svn:date revision
+ * properties, as done by svn_repos_dated_revision().
+ *
+ * This is answered from an index kept by the back end, if it has one
+ * covering all revisions, and @a *indexed is set to TRUE.  Otherwise,
+ * set @a *indexed to FALSE and leave @a *revision alone; the caller has
+ * to search the revision properties instead.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_fs__dated_revision(svn_boolean_t *indexed,
+                       svn_revnum_t *revision,
+                       svn_fs_t *fs,
+                       apr_time_t tm,
+                       apr_pool_t *pool);
+
+
+/**
+ * Like svn_fs_dir_entries(), but set @a *entries_p to an array of the
+ * <tt>svn_fs_dirent_t *</tt> entries of the directory at @a path in
+ * @a root, sorted by name as by svn_sort_compare_items_lexically().
+ * Back ends that cache directories sorted already hand them out in
+ * that order without sorting them again.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_fs__dir_entries_sorted(apr_array_header_t **entries_p,
+                           svn_fs_root_t *root,
+                           const char *path,
+                           apr_pool_t *pool);
+
+
+/**
+ * Order the node-revisions @a a and @a b, both from the same
+ * filesystem, by where the back end stores them, returning a value
+ * less than, equal to or greater than zero as for strcmp().  Reading
+ * node-revisions in this order makes for mostly sequential access to
+ * the repository files.  Back ends without a meaningful storage order
+ * consider all node-revisions equal.
+ *
+ * @since New in 1.7.
+ */
+int
+svn_fs__compare_id_locations(const svn_fs_id_t *a,
+                             const svn_fs_id_t *b);
+
+
+/** What to lock a path with in svn_fs__lock_many().
+ *
+ * @since New in 1.7.
+ */
+typedef struct svn_fs__lock_target_t
+{
+  /** The token to use, or NULL to have one generated. */
+  const char *token;
+
+  /** As the @a current_rev argument of svn_fs_lock(). */
+  svn_revnum_t current_rev;
+} svn_fs__lock_target_t;
+
+/** The type of function svn_fs__lock_many() and svn_fs__unlock_many()
+ * call for every path, with the @a lock created for @a path (always
+ * NULL when unlocking), or with @a fs_err saying why @a path could not
+ * be locked or unlocked.  @a fs_err is cleared after the call.  Any
+ * error returned stops the operation; the remaining paths are locked or
+ * unlocked all the same, but go unreported.
+ *
+ * @since New in 1.7.
+ */
+typedef svn_error_t *(*svn_fs__lock_callback_t)(void *baton,
+                                                const char *path,
+                                                const svn_lock_t *lock,
+                                                svn_error_t *fs_err,
+                                                apr_pool_t *pool);
+
+/** Lock every path in @a targets, a hash mapping <tt>const char *</tt>
+ * paths in @a fs to <tt>const svn_fs__lock_target_t *</tt>, as
+ * svn_fs_lock() would lock each, with the same @a comment,
+ * @a is_dav_comment, @a expiration_date and @a steal_lock for all of
+ * them.  Call @a lock_callback, if not NULL, with @a lock_baton for
+ * every path.
+ *
+ * A path that cannot be locked does not stop the others from being
+ * locked.  Back ends that support it take the repository write lock only
+ * once and store all locks in a single transaction.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_fs__lock_many(svn_fs_t *fs,
+                  apr_hash_t *targets,
+                  const char *comment,
+                  svn_boolean_t is_dav_comment,
+                  apr_time_t expiration_date,
+                  svn_boolean_t steal_lock,
+                  svn_fs__lock_callback_t lock_callback,
+                  void *lock_baton,
+                  apr_pool_t *pool);
+
+/** Unlock every path in @a targets, a hash mapping <tt>const char *</tt>
+ * paths in @a fs to <tt>const char *</tt> tokens, as svn_fs_unlock()
+ * would unlock each, with the same @a break_lock for all of them.  An
+ * empty token stands for NULL.  Call @a lock_callback, if not NULL, with
+ * @a lock_baton for every path.
+ *
+ * Like svn_fs__lock_many(), a path that cannot be unlocked does not stop
+ * the others from being unlocked.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_fs__unlock_many(svn_fs_t *fs,
+                    apr_hash_t *targets,
+                    svn_boolean_t break_lock,
+                    svn_fs__lock_callback_t lock_callback,
+                    void *lock_baton,
+                    apr_pool_t *pool);
+
 
 /** Commit the obliteration-txn @a txn. Similar to svn_fs_commit_txn() but
  * replaces the revision @a rev, which must be the same revision as was
@@ -187,6 +187,17 @@ svn_fs__path_change_create_internal(const svn_fs_id_t *node_rev_id,
                                     svn_fs_path_change_kind_t change_kind,
                                     apr_pool_t *pool);
 
+/* Set *ITERATOR to a changed-paths iterator which returns the entries
+   of CHANGES, a hash as returned by svn_fs_paths_changed2(), ordered by
+   svn_path_compare_paths().  This is for back ends which cannot do any
+   better than fetching all changes at once; CHANGES must live at least
+   as long as *ITERATOR.  Allocate *ITERATOR in POOL. */
+svn_error_t *
+svn_fs__paths_changed_iterator_from_hash(
+  svn_fs_path_change_iterator_t **iterator,
+  apr_hash_t *changes,
+  apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -96,6 +96,23 @@ svn_log__get_dir(const char *path, svn_revnum_t rev,
                  apr_uint64_t dirent_fields,
                  apr_pool_t *pool);
 
+/**
+ * Return a log string for a list action.
+ *
+ * @since New in 1.7.
+ */
+const char *
+svn_log__list(const char *path, svn_revnum_t rev, svn_depth_t depth,
+              apr_pool_t *pool);
+
+/**
+ * Return a log string for a get-archive action.
+ *
+ * @since New in 1.7.
+ */
+const char *
+svn_log__get_archive(const char *path, svn_revnum_t rev, apr_pool_t *pool);
+
 /**
  * Return a log string for a get-mergeinfo action.
  *
@@ -198,6 +215,15 @@ svn_log__get_file_revs(const char *path, svn_revnum_t start, svn_revnum_t end,
                        svn_boolean_t include_merged_revisions,
                        apr_pool_t *pool);
 
+/**
+ * Return a log string for a get-file-blame action.
+ *
+ * @since New in 1.7.
+ */
+const char *
+svn_log__get_file_blame(const char *path, svn_revnum_t start,
+                        svn_revnum_t end, apr_pool_t *pool);
+
 /**
  * Return a log string for a lock action.
  *
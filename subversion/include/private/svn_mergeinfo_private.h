@@ -38,6 +38,21 @@ extern "C" {
 #endif /* __cplusplus */
 
 
+/* Set *RANGELIST to the rangelist for the merge source PATH in the
+   mergeinfo string INPUT, allocated in RESULT_POOL, or to NULL if INPUT
+   has none for PATH.  Only parse the lines of INPUT for PATH, like
+   svn_mergeinfo_parse() would; other lines are neither parsed nor
+   validated.  Relative paths in INPUT are treated as absolute paths, as
+   is PATH.  If the lines for PATH cannot be parsed return
+   SVN_ERR_MERGEINFO_PARSE_ERROR.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_mergeinfo__parse_path(apr_array_header_t **rangelist,
+                          const char *input,
+                          const char *path,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
 /* Set inheritability of all ranges in RANGELIST to INHERITABLE.
    If RANGELIST is NULL do nothing. */
 void
@@ -209,8 +224,9 @@ svn_mergeinfo__is_noninheritable(svn_mergeinfo_t mergeinfo,
 
 /* If MERGEINFO_STR is a string representation of non-inheritable mergeinfo
    set *IS_NONINHERITABLE to TRUE, set it to FALSE otherwise.  MERGEINFO_STR
-   may be NULL or empty.  If MERGEINFO_STR cannot be parsed return
-   SVN_ERR_MERGEINFO_PARSE_ERROR. */
+   may be NULL or empty.  If MERGEINFO_STR has any non-inheritable ranges
+   but cannot be parsed return SVN_ERR_MERGEINFO_PARSE_ERROR; strings
+   without any are not parsed at all. */
 svn_error_t *
 svn_mergeinfo__string_has_noninheritable(svn_boolean_t *is_noninheritable,
                                          const char *mergeinfo_str,
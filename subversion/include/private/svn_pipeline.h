@@ -0,0 +1,144 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_pipeline.h
+ * @brief Processing queued items in order on a separate thread
+ */
+
+#ifndef SVN_PIPELINE_H
+#define SVN_PIPELINE_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * A pipeline hands items from the thread that produces them to a single
+ * worker thread, which processes them in the order they were queued.
+ * Up to a fixed number of items are in flight at any time; each one
+ * lives in a "slot" with a pool of its own, which is reused once the
+ * item that occupied it before is done with.
+ *
+ * Pools and their allocators must not be shared between threads, so
+ * the slot pools are root pools; the producer allocates an item in its
+ * slot pool and the worker thread may use that pool, too, while it
+ * processes the item.
+ *
+ * Only a single thread may queue items, wait for them and finish or
+ * close the pipeline.
+ *
+ * @since New in 1.7.
+ */
+typedef struct svn_pipeline__t svn_pipeline__t;
+
+/** Process ITEM, queued on a pipeline, on the pipeline's worker thread.
+ * BATON is the baton given to svn_pipeline__start().  Use SCRATCH_POOL,
+ * which is cleared before each item, for temporary allocations.
+ *
+ * If this returns an error, the pipeline processes no further items.
+ *
+ * @since New in 1.7.
+ */
+typedef svn_error_t *(*svn_pipeline__process_t)(void *baton,
+                                                void *item,
+                                                apr_pool_t *scratch_pool);
+
+/** Return a new pipeline with SLOTS slots whose worker thread calls
+ * PROCESS with BATON for every item queued, or NULL if threads are not
+ * available or the thread could not be started.
+ *
+ * The slots of the last KEEP processed items are not handed out again
+ * yet, e.g. because processing the next item still refers to them; at
+ * most SLOTS - KEEP items are queued but not processed at any time.
+ *
+ * The pipeline is closed, as with svn_pipeline__close(), when POOL is
+ * cleaned up.
+ *
+ * @since New in 1.7.
+ */
+svn_pipeline__t *
+svn_pipeline__start(int slots,
+                    int keep,
+                    svn_pipeline__process_t process,
+                    void *baton,
+                    apr_pool_t *pool);
+
+/** Set *SLOT_POOL to the cleared pool of the slot for the next item to
+ * be queued on PIPELINE, waiting for the worker thread to get far enough
+ * if necessary.  The caller must be done with the item that occupied the
+ * slot before.
+ *
+ * Return a copy of the error processing an item failed with, if any.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_pipeline__next_slot(apr_pool_t **slot_pool,
+                        svn_pipeline__t *pipeline);
+
+/** Queue ITEM, allocated in the pool svn_pipeline__next_slot() returned
+ * last, or living at least as long, for processing on PIPELINE.
+ *
+ * @since New in 1.7.
+ */
+void
+svn_pipeline__queue(svn_pipeline__t *pipeline,
+                    void *item);
+
+/** Wait until item number N, counting from 0, queued on PIPELINE has
+ * been processed and set *ITEM to it.
+ *
+ * Return a copy of the error processing an item failed with, if any.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_pipeline__wait(void **item,
+                   svn_pipeline__t *pipeline,
+                   apr_uint64_t n);
+
+/** Wait until all items queued on PIPELINE have been processed, then
+ * stop its worker thread.  Return the error processing an item failed
+ * with, if any.  The slot pools stay intact until PIPELINE is closed.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_pipeline__finish(svn_pipeline__t *pipeline);
+
+/** Stop the worker thread of PIPELINE, after the item it is processing,
+ * if any, and destroy the pipeline along with its slot pools.
+ *
+ * @since New in 1.7.
+ */
+void
+svn_pipeline__close(svn_pipeline__t *pipeline);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_PIPELINE_H */
@@ -0,0 +1,103 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_ra_svn_private.h
+ * @brief Functions used by the server - Internal routines
+ */
+
+#ifndef SVN_RA_SVN_PRIVATE_H
+#define SVN_RA_SVN_PRIVATE_H
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+
+#include "svn_ra_svn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Read the next command from CONN, setting *CMDNAME to its name and
+   *PARAMS to its parameters, allocated in POOL.  If the connection was
+   closed and ERROR_ON_DISCONNECT is FALSE, set *CMDNAME to NULL instead
+   of returning an error. */
+svn_error_t *
+svn_ra_svn__read_command(const char **cmdname,
+                         apr_array_header_t **params,
+                         svn_ra_svn_conn_t *conn,
+                         svn_boolean_t error_on_disconnect,
+                         apr_pool_t *pool);
+
+/* Handle the command CMDNAME with PARAMS, as read by
+   svn_ra_svn__read_command(), according to CMD_HASH and BATON like
+   svn_ra_svn__handle_command() does.  Set *TERMINATE to TRUE if the
+   command terminates the command loop.  Use POOL for all allocations. */
+svn_error_t *
+svn_ra_svn__run_command(svn_boolean_t *terminate,
+                        apr_hash_t *cmd_hash,
+                        void *baton,
+                        svn_ra_svn_conn_t *conn,
+                        const char *cmdname,
+                        apr_array_header_t *params,
+                        apr_pool_t *pool);
+
+/* Read one command from CONN and handle it according to CMD_HASH, which
+   maps command names to their svn_ra_svn_cmd_entry_t.  This is one
+   iteration of the loop in svn_ra_svn_handle_commands2(), and takes
+   BATON and ERROR_ON_DISCONNECT like it does.  Set *TERMINATE to TRUE
+   if the command terminates the command loop, or if the connection was
+   closed and ERROR_ON_DISCONNECT is FALSE.  Use POOL for all
+   allocations; it may be cleared once this returns. */
+svn_error_t *
+svn_ra_svn__handle_command(svn_boolean_t *terminate,
+                           apr_hash_t *cmd_hash,
+                           void *baton,
+                           svn_ra_svn_conn_t *conn,
+                           svn_boolean_t error_on_disconnect,
+                           apr_pool_t *pool);
+
+/* Return TRUE if reading from CONN won't have to wait for the other
+   side: either CONN or its encryption layer buffered data that hasn't
+   been consumed yet, or data is waiting on the network. */
+svn_boolean_t
+svn_ra_svn__data_available(svn_ra_svn_conn_t *conn);
+
+/* Set *BYTES_READ and *BYTES_WRITTEN to the amount of protocol data
+   received and sent over CONN so far, not counting the effect of
+   compression or encryption. */
+void
+svn_ra_svn__get_io_counts(apr_uint64_t *bytes_read,
+                          apr_uint64_t *bytes_written,
+                          svn_ra_svn_conn_t *conn);
+
+/* Flush CONN and compress everything that is sent over it from now on
+   with zlib, decompressing everything that is received.  Both sides
+   have to do this at the same point of the conversation.  Use POOL for
+   temporary allocations. */
+svn_error_t *
+svn_ra_svn__enable_compression(svn_ra_svn_conn_t *conn, apr_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_RA_SVN_PRIVATE_H */
@@ -32,6 +32,8 @@
 #include "svn_repos.h"
 #include "svn_types.h"
 
+#include "private/svn_fs_private.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -70,6 +72,47 @@ svn_repos__obliterate_path_rev(svn_repos_t *repos,
                                apr_pool_t *pool);
 
 
+/**
+ * Like svn_repos_fs_lock(), but lock all paths in @a targets, a hash
+ * mapping absolute paths in @a repos to <tt>svn_fs__lock_target_t *</tt>,
+ * in one go.  The pre-lock hook runs for each path and the post-lock hook
+ * runs once for all paths that got locked.
+ *
+ * Report the outcome for each path to @a lock_callback / @a lock_baton
+ * as svn_fs__lock_many() does, including the paths rejected by the
+ * pre-lock hook.  Once the callback returns an error, stop calling it,
+ * but still run the post-lock hook, then return that error.  If only
+ * the post-lock hook fails, return #SVN_ERR_REPOS_POST_LOCK_HOOK_FAILED.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_repos__fs_lock_many(svn_repos_t *repos,
+                        apr_hash_t *targets,
+                        const char *comment,
+                        svn_boolean_t is_dav_comment,
+                        apr_time_t expiration_date,
+                        svn_boolean_t steal_lock,
+                        svn_fs__lock_callback_t lock_callback,
+                        void *lock_baton,
+                        apr_pool_t *pool);
+
+/**
+ * Like svn_repos_fs_unlock(), but unlock all paths in @a targets, a hash
+ * mapping absolute paths in @a repos to their <tt>const char *</tt> lock
+ * tokens, in one go.  Hooks and reporting work as in
+ * svn_repos__fs_lock_many().
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_repos__fs_unlock_many(svn_repos_t *repos,
+                          apr_hash_t *targets,
+                          svn_boolean_t break_lock,
+                          svn_fs__lock_callback_t lock_callback,
+                          void *lock_baton,
+                          apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -29,6 +29,8 @@
 #include "svn_types.h"
 #include "svn_checksum.h"
 #include "svn_error.h"
+#include "svn_io.h"
+#include "svn_config.h"
 
 #include "private/svn_token.h"  /* for svn_token_map_t  */
 
@@ -99,11 +101,45 @@ svn_sqlite__set_schema_version(svn_sqlite__db_t *db,
                                apr_pool_t *scratch_pool);
 
 
+/* Options read by svn_sqlite__read_tuning(). */
+#define SVN_SQLITE__OPTION_ENABLE_WAL  "sqlite-enable-wal"
+#define SVN_SQLITE__OPTION_CACHE_SIZE  "sqlite-cache-size"
+#define SVN_SQLITE__OPTION_MMAP_SIZE   "sqlite-mmap-size"
+
+/* Settings applied to a database by svn_sqlite__open(). */
+typedef struct svn_sqlite__tuning_t
+{
+  /* Switch the database to write-ahead logging, so that readers don't
+     block a writer and the writer doesn't block readers.  The journal
+     mode is recorded in the database file and stays in effect for all
+     later connections; FALSE leaves it as it is.  Ignored for read-only
+     connections and when SQLite is older than 3.7.0. */
+  svn_boolean_t enable_wal;
+
+  /* The size of the page cache in kilobytes, or 0 for SQLite's default. */
+  apr_int64_t cache_size;
+
+  /* How many kilobytes of the database file to read through a memory
+     mapping, or 0 for none.  Ignored when SQLite is older than 3.7.17. */
+  apr_int64_t mmap_size;
+} svn_sqlite__tuning_t;
+
+/* Fill in *TUNING from the options SVN_SQLITE__OPTION_* in SECTION of
+   CFG, which may be NULL.  Options that aren't set get the defaults:
+   no write-ahead logging, SQLite's default cache and no memory mapping. */
+svn_error_t *
+svn_sqlite__read_tuning(svn_sqlite__tuning_t *tuning,
+                        svn_config_t *cfg,
+                        const char *section);
+
 /* Open a connection in *DB to the database at PATH. Validate the schema,
    creating/upgrading to LATEST_SCHEMA if needed using the instructions
    in UPGRADE_SQL. The resulting DB is allocated in RESULT_POOL, and any
    temporary allocations are made in SCRATCH_POOL.
 
+   If TUNING is not NULL, apply its settings to the connection before
+   validating the schema.
+
    STATEMENTS is an array of strings which may eventually be executed, the
    last element of which should be NULL.  These strings are not duplicated
    internally, and should have a lifetime at least as long as RESULT_POOL.
@@ -116,6 +152,7 @@ svn_error_t *
 svn_sqlite__open(svn_sqlite__db_t **db, const char *repos_path,
                  svn_sqlite__mode_t mode, const char * const statements[],
                  int latest_schema, const char * const *upgrade_sql,
+                 const svn_sqlite__tuning_t *tuning,
                  apr_pool_t *result_pool, apr_pool_t *scratch_pool);
 
 /* Explicity close the connection in DB. */
@@ -303,13 +340,42 @@ typedef svn_error_t *(*svn_sqlite__transaction_callback_t)(
    CB_FUNC will be wrapped in an SQLite transaction, which will be committed
    if CB_FUNC does not return an error.  If any error is returned from CB_FUNC,
    the transaction will be rolled back.  DB and CB_BATON will be passed to
-   CB_FUNC. SCRATCH_POOL will be passed to the callback (NULL is valid). */
+   CB_FUNC. SCRATCH_POOL will be passed to the callback (NULL is valid).
+
+   Calls may be nested: an inner call becomes part of the outer
+   transaction, and only the outermost call commits.  With SQLite 3.6.8
+   and later, an error in an inner call rolls back just the inner work;
+   with older versions it is rolled back only when the error reaches the
+   outermost call. */
 svn_error_t *
 svn_sqlite__with_transaction(svn_sqlite__db_t *db,
                              svn_sqlite__transaction_callback_t cb_func,
                              void *cb_baton, apr_pool_t *scratch_pool);
 
 
+/* Write usage statistics of the statements executed on DB to STREAM, one
+   line per statement, those that took the most time first.  Each line
+   holds the number of times the statement was executed, the number of
+   rows it returned, the total time in microseconds spent in stepping it,
+   and its text.  This shows which of the statements passed to
+   svn_sqlite__open() dominate an operation.
+
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_sqlite__dump_stats(svn_sqlite__db_t *db,
+                       svn_stream_t *stream,
+                       apr_pool_t *scratch_pool);
+
+/* Return a number that grows whenever rows of DB may have changed
+   through this connection: it counts the rows inserted, updated and
+   deleted, and the rollbacks done by svn_sqlite__with_transaction().
+   Callers caching data read from DB can compare it to tell whether the
+   data may be stale.  Changes made through other connections are not
+   noticed. */
+apr_int64_t
+svn_sqlite__changes_generation(svn_sqlite__db_t *db);
+
+
 /* Hotcopy an SQLite database from SRC_PATH to DST_PATH. */
 svn_error_t *
 svn_sqlite__hotcopy(const char *src_path,
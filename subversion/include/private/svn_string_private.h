@@ -0,0 +1,78 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_string_private.h
+ * @brief Non-public string utility functions.
+ */
+
+
+#ifndef SVN_STRING_PRIVATE_H
+#define SVN_STRING_PRIVATE_H
+
+#include "svn_string.h"    /* loads <apr_pools.h> and "svn_types.h" */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/* Make sure that STR has at least MINIMUM_SIZE bytes of space available
+ * in its memory block, like svn_stringbuf_ensure(), but if it has to grow
+ * the block, make it exactly MINIMUM_SIZE bytes large.
+ *
+ * svn_stringbuf_ensure() doubles the block size until it is big enough,
+ * which suits repeated appends but can leave almost half of a large block
+ * unused.  Use this function instead when the final size is known up
+ * front.  (MINIMUM_SIZE should include space for the terminating NUL.)
+ */
+void
+svn_stringbuf__ensure_exact(svn_stringbuf_t *str, apr_size_t minimum_size);
+
+/* Return a string which uses the contents of STRBUF without copying them.
+ *
+ * No memory is allocated: the returned string overlays the (data, len)
+ * part of STRBUF itself, which has the same layout as svn_string_t.  So STRBUF is consumed by this call;
+ * it must not be used or modified afterwards, and the string lives as
+ * long as STRBUF's pool does.
+ *
+ * Use this instead of svn_string_create_from_buf() when a stringbuf was
+ * only built up to produce the string, to avoid a second copy of the
+ * contents in the same pool.
+ */
+svn_string_t *
+svn_stringbuf__morph_into_string(svn_stringbuf_t *strbuf);
+
+/* Machine words with the same byte repeated in every position, for
+ * scanning buffers a word at a time: all bytes 0x7f and all bytes 0x80.
+ * Adding SVN__LOWER_7BITS_SET to the lower 7 bits of each byte of a word
+ * sets bit 7 of every byte that wasn't zero, without carrying into the
+ * next byte.
+ */
+#define SVN__LOWER_7BITS_SET ((apr_uintptr_t)-1 / 0xff * 0x7f)
+#define SVN__BIT_7_SET       ((apr_uintptr_t)-1 / 0xff * 0x80)
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif  /* SVN_STRING_PRIVATE_H */
@@ -0,0 +1,83 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ *
+ * @file svn_tar.h
+ * @brief Writing tar archives to streams.
+ */
+
+#ifndef SVN_TAR_H
+#define SVN_TAR_H
+
+#include <apr_pools.h>
+#include <apr_time.h>
+
+#include "svn_types.h"
+#include "svn_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/* Write the header of a POSIX tar (ustar) archive member to STREAM.
+ *
+ * NAME is the member's relative path, with '/' separators.  KIND is
+ * svn_node_dir or svn_node_file; a file with a non-NULL LINK_TARGET is
+ * written as a symbolic link to LINK_TARGET.  SIZE is the number of
+ * bytes of a file's contents, which the caller writes to STREAM after
+ * the header, followed by svn_tar__write_padding().  EXECUTABLE sets the
+ * execute bits of a file's mode, and MTIME is the modification time.
+ *
+ * Names, link targets and sizes that don't fit into the ustar header
+ * are written as a pax extended header first.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_tar__write_header(svn_stream_t *stream,
+                      const char *name,
+                      svn_node_kind_t kind,
+                      const char *link_target,
+                      svn_filesize_t size,
+                      svn_boolean_t executable,
+                      apr_time_t mtime,
+                      apr_pool_t *scratch_pool);
+
+/* Write the padding that follows SIZE bytes of member contents to
+ * STREAM.
+ */
+svn_error_t *
+svn_tar__write_padding(svn_stream_t *stream,
+                       svn_filesize_t size);
+
+/* Write the end-of-archive marker to STREAM.
+ */
+svn_error_t *
+svn_tar__write_trailer(svn_stream_t *stream);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_TAR_H */
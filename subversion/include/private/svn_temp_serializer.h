@@ -0,0 +1,150 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_temp_serializer.h
+ * @brief Helper API for serializing _temporarily_ data structures.
+ *
+ * @note This API is intended for efficient serialization and duplication
+ *       of temporary, e.g. cached, data structures ONLY. It is not
+ *       suitable for persistent data.
+ */
+
+#ifndef SVN_TEMP_SERIALIZER_H
+#define SVN_TEMP_SERIALIZER_H
+
+#include <apr_pools.h>
+
+#include "svn_string.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * @defgroup svn_temp_serializer Flat serialization of C structures
+ * @{
+ *
+ * A tree of C structures is copied into a single contiguous buffer.
+ * Every pointer within that buffer is replaced by the offset of its
+ * target relative to the start of the structure that contains the
+ * pointer (NULL pointers remain NULL).  Such a buffer may be copied
+ * and moved around freely; restoring the original structure merely
+ * requires the pointers to be resolved again, which is done by the
+ * svn_temp_deserializer__* functions below.
+ *
+ * Serialization is a depth-first traversal: a structure is added to
+ * the buffer and made the "current" one by svn_temp_serializer__push.
+ * Its sub-structures and strings are then added one by one before
+ * svn_temp_serializer__pop makes its parent current again.
+ */
+
+/**
+ * Opaque serialization context.
+ */
+typedef struct svn_temp_serializer__context_t svn_temp_serializer__context_t;
+
+/**
+ * Begin the serialization process for the @a source_struct of size
+ * @a struct_size and return the new context.  @a source_struct becomes
+ * the current structure.  If @a source_struct is NULL, the structure
+ * pushed first will become the root of the serialized data, starting
+ * at offset 0.  @a suggested_buffer_size is the expected
+ * total size of the serialized data; it may be 0.  All allocations
+ * will be made from @a pool.
+ */
+svn_temp_serializer__context_t *
+svn_temp_serializer__init(const void *source_struct,
+                          apr_size_t struct_size,
+                          apr_size_t suggested_buffer_size,
+                          apr_pool_t *pool);
+
+/**
+ * Append a copy of the structure @a *source_struct of size
+ * @a struct_size to the serialized data in @a context and make the
+ * pointer at @a source_struct, which must be a member of the current
+ * structure, refer to it.  The copy then becomes the current structure.
+ *
+ * If @a *source_struct is NULL, the pointer will be set to NULL.
+ * Every call must be matched by a call to svn_temp_serializer__pop.
+ */
+void
+svn_temp_serializer__push(svn_temp_serializer__context_t *context,
+                          const void * const * source_struct,
+                          apr_size_t struct_size);
+
+/**
+ * Make the parent of the current structure in @a context the current
+ * structure again.
+ */
+void
+svn_temp_serializer__pop(svn_temp_serializer__context_t *context);
+
+/**
+ * Append a copy of the 0-terminated string @a *s to the serialized
+ * data in @a context and make the pointer at @a s, which must be a
+ * member of the current structure, refer to it.  NULL strings are
+ * serialized as NULL pointers.
+ */
+void
+svn_temp_serializer__add_string(svn_temp_serializer__context_t *context,
+                                const char * const * s);
+
+/**
+ * Set the pointer at @a ptr, which must be a member of the current
+ * structure in @a context, to NULL in the serialized data.  Use this
+ * for members that must not or need not be serialized.
+ */
+void
+svn_temp_serializer__set_null(svn_temp_serializer__context_t *context,
+                              const void * const * ptr);
+
+/**
+ * Return the serialized data collected in @a context so far.  The
+ * buffer is allocated in the context's pool and begins with the
+ * structure passed to svn_temp_serializer__init.
+ */
+svn_stringbuf_t *
+svn_temp_serializer__get(svn_temp_serializer__context_t *context);
+
+/**
+ * Replace the serialized pointer at @a ptr, which is a member of the
+ * structure starting at @a buffer, with a real pointer into that
+ * serialized data.  NULL pointers are left untouched.
+ */
+void
+svn_temp_deserializer__resolve(void *buffer, void **ptr);
+
+/**
+ * Like svn_temp_deserializer__resolve but leave the serialized data
+ * unmodified and return the real pointer instead.  Use this to access
+ * serialized data in-place, e.g. without copying it out of a cache.
+ */
+const void *
+svn_temp_deserializer__ptr(const void *buffer, const void * const * ptr);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_TEMP_SERIALIZER_H */
@@ -0,0 +1,109 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ *
+ * @file svn_trace.h
+ * @brief Low-overhead tracing of hot code paths.
+ *
+ * A span is a timed region of code, marked with SVN_TRACE__BEGIN() and
+ * SVN_TRACE__END().  Spans are visible in two ways, neither of which
+ * needs a special build:
+ *
+ * - Where configure found <sys/sdt.h>, each span fires the static
+ *   probes NAME__start and NAME__done of the "subversion" provider,
+ *   which SystemTap or DTrace can attach to in a running process.  The
+ *   done probe gets the span's detail string as its argument.  Without
+ *   an attached tracer a probe costs a single no-op instruction.
+ *
+ * - If the environment variable SVN_TRACE_FILE names a file when the
+ *   first span starts, every span that takes at least SVN_TRACE_THRESHOLD
+ *   microseconds (default 0) is appended to that file as one line of
+ *   tab-separated fields: name, start time and duration, both in
+ *   microseconds, and detail.  Otherwise a span costs one function call.
+ *
+ * Include svn_private_config.h before this file, so that the probes
+ * are compiled in where they are available.
+ */
+
+#ifndef SVN_TRACE_H
+#define SVN_TRACE_H
+
+#include <apr_time.h>
+
+#include "svn_types.h"
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+#ifdef HAVE_SYS_SDT_H
+#define SVN_TRACE__PROBE0(probe) DTRACE_PROBE(subversion, probe)
+#define SVN_TRACE__PROBE1(probe, arg) DTRACE_PROBE1(subversion, probe, arg)
+#else
+#define SVN_TRACE__PROBE0(probe) ((void)0)
+#define SVN_TRACE__PROBE1(probe, arg) ((void)0)
+#endif
+
+/* Start the span NAME, setting the apr_time_t variable START, which
+ * SVN_TRACE__END() needs.  NAME must be a valid C identifier.
+ */
+#define SVN_TRACE__BEGIN(name, start)                                 \
+  do {                                                                \
+    SVN_TRACE__PROBE0(name##__start);                                 \
+    (start) = svn_trace__start();                                     \
+  } while (0)
+
+/* End the span NAME that was started at START.  DETAIL is a string that
+ * identifies what the span worked on, or NULL.
+ */
+#define SVN_TRACE__END(name, start, detail)                           \
+  do {                                                                \
+    SVN_TRACE__PROBE1(name##__done, (detail));                        \
+    if (start)                                                        \
+      svn_trace__record(#name, (detail), (start));                    \
+  } while (0)
+
+/* Return the current time if spans are being recorded, else 0.  Use
+ * SVN_TRACE__BEGIN() instead of calling this directly.
+ */
+apr_time_t
+svn_trace__start(void);
+
+/* Record the span NAME with DETAIL (which may be NULL) that began at
+ * START.  Use SVN_TRACE__END() instead of calling this directly.
+ */
+void
+svn_trace__record(const char *name,
+                  const char *detail,
+                  apr_time_t start);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_TRACE_H */
@@ -92,6 +92,40 @@ svn_wc__changelist_match(svn_wc_context_t *wc_ctx,
                          apr_pool_t *scratch_pool);
 
 
+/* The callback type used by svn_wc__get_changelist_members().  It has
+   the same signature as svn_changelist_receiver_t. */
+typedef svn_error_t *(*svn_wc__changelist_member_func_t)(
+  void *baton,
+  const char *local_abspath,
+  const char *changelist,
+  apr_pool_t *scratch_pool);
+
+/* Call CALLBACK_FUNC with CALLBACK_BATON for LOCAL_ABSPATH and for each
+   file and directory below it, as far as DEPTH says, that is part of one
+   of the changelists in CLHASH (a hash whose keys are const char *
+   changelist names).  Hidden nodes are never reported.
+
+   This reports the same nodes as svn_wc__node_walk_children() with a
+   callback that checks svn_wc__changelist_match(), but it only looks up
+   the nodes that actually are in a changelist.  Apart from those, it
+   costs a couple of indexed queries per directory instead of several
+   queries per node.
+
+   If CANCEL_FUNC is non-NULL, call it with CANCEL_BATON to determine
+   if the client has cancelled the operation.  Use SCRATCH_POOL for
+   temporary allocations. */
+svn_error_t *
+svn_wc__get_changelist_members(svn_wc_context_t *wc_ctx,
+                               const char *local_abspath,
+                               svn_depth_t depth,
+                               apr_hash_t *clhash,
+                               svn_wc__changelist_member_func_t callback_func,
+                               void *callback_baton,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool);
+
+
 /* Set *MODIFIED_P to true if VERSIONED_FILE_ABSPATH is modified with respect
  * to BASE_FILE_ABSPATH, or false if it is not.  The comparison compensates
  * for VERSIONED_FILE_ABSPATH's eol and keyword properties, but leaves
@@ -257,6 +291,79 @@ svn_wc__node_get_children(const apr_array_header_t **children,
                           apr_pool_t *scratch_pool);
 
 
+/**
+ * Set @a *unmodified to a hash whose keys are the basenames of those file
+ * children of @a dir_abspath that certainly have nothing to commit: they
+ * are unchanged BASE nodes without property changes, conflicts or locks,
+ * and their working file is a regular file with the recorded size and
+ * timestamp.
+ *
+ * All children are read with one query per table and one directory
+ * listing, so callers can skip these files instead of examining each of
+ * them separately.  Use @a wc_ctx to access the working copy.  Allocate
+ * @a *unmodified in @a result_pool and use @a scratch_pool for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_wc__node_get_unmodified_files(apr_hash_t **unmodified,
+                                  svn_wc_context_t *wc_ctx,
+                                  const char *dir_abspath,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
+
+/** A text delta of a working file, computed ahead of sending it to the
+ * commit editor.  See svn_wc__text_delta_prepare(). */
+typedef struct svn_wc__text_delta_t svn_wc__text_delta_t;
+
+/**
+ * Set @a *delta to a new text delta of the working file @a local_abspath
+ * against its pristine text, or against the empty text if @a fulltext, as
+ * svn_wc_transmit_text_deltas3() would send it.  If @a want_tempfile, a
+ * repository-normal copy of the file is made while computing the delta;
+ * if @a want_sha1, a new pristine text is.
+ *
+ * Everything is allocated in @a pool, which must stay alive until the
+ * delta has been sent and must not be used by anyone else while
+ * svn_wc__text_delta_compute() runs.  Use @a wc_ctx to access the working
+ * copy.
+ */
+svn_error_t *
+svn_wc__text_delta_prepare(svn_wc__text_delta_t **delta,
+                           svn_boolean_t want_tempfile,
+                           svn_boolean_t want_sha1,
+                           svn_wc_context_t *wc_ctx,
+                           const char *local_abspath,
+                           svn_boolean_t fulltext,
+                           apr_pool_t *pool);
+
+/**
+ * Compute @a delta into a temporary file.  This reads the working file
+ * and the pristine text but doesn't access the working copy database, so
+ * it may run on a different thread than the one which prepared @a delta.
+ * Errors are kept in @a delta and returned by svn_wc__text_delta_send().
+ */
+void
+svn_wc__text_delta_compute(svn_wc__text_delta_t *delta);
+
+/**
+ * Send @a delta, computed by svn_wc__text_delta_compute(), to @a editor
+ * for @a file_baton and close @a file_baton, like
+ * svn_wc_transmit_text_deltas3() does, with the same outputs.  Use
+ * @a wc_ctx to access the working copy.
+ */
+svn_error_t *
+svn_wc__text_delta_send(const char **tempfile,
+                        const svn_checksum_t **new_text_base_md5_checksum,
+                        const svn_checksum_t **new_text_base_sha1_checksum,
+                        svn_wc_context_t *wc_ctx,
+                        svn_wc__text_delta_t *delta,
+                        const svn_delta_editor_t *editor,
+                        void *file_baton,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
+
 /**
  * Fetch the repository root information for a given @a local_abspath into
  * @a *repos_root_url and @a repos_uuid. Use @wc_ctx to access the working copy
@@ -340,6 +447,21 @@ svn_wc__node_get_base_checksum(const svn_checksum_t **checksum,
                                apr_pool_t *result_pool,
                                apr_pool_t *scratch_pool);
 
+/**
+ * Set @a *contents to a readonly stream on the pristine text whose
+ * checksum is @a checksum, if the pristine store of the working copy
+ * containing @a wri_abspath has it, or to @c NULL otherwise.  @a checksum
+ * may be an MD5 or a SHA-1 checksum.  Allocate the stream in @a
+ * result_pool and use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
+                                          svn_wc_context_t *wc_ctx,
+                                          const char *wri_abspath,
+                                          const svn_checksum_t *checksum,
+                                          apr_pool_t *result_pool,
+                                          apr_pool_t *scratch_pool);
+
 /**
  * Set @a *translated_size to the recorded size (in bytes) of the
  * pristine text -- after translation -- associated with @a
@@ -697,6 +819,73 @@ svn_wc__temp_get_keep_local(svn_boolean_t *keep_local,
                             const char *local_abspath,
                             apr_pool_t *scratch_pool);
 
+
+/**
+ * Like svn_wc_get_update_editor4(), but for an editor drive that sends
+ * no file texts, such as the one of svn_ra_do_diff3() with @a text_deltas
+ * FALSE.  Files added by the drive are recorded in BASE with the checksum
+ * passed to close_file(), but neither their text base nor their working
+ * file is written; they are "dehydrated" until svn_wc__hydrate() fetches
+ * their text.  Changing the text of a file that isn't dehydrated is an
+ * error.
+ *
+ * A dehydrated file is reported by status as unmodified rather than
+ * missing, and isn't restored by svn_wc_crawl_revisions5().  An update
+ * with a regular editor that changes its text fetches its old text with
+ * @a fetch_func first.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if the working copy keeps its
+ * pristine texts in the pristine store (SVN_EXPERIMENTAL_PRISTINE).
+ */
+svn_error_t *
+svn_wc__get_lazy_update_editor(const svn_delta_editor_t **editor,
+                               void **edit_baton,
+                               svn_revnum_t *target_revision,
+                               svn_wc_context_t *wc_ctx,
+                               const char *anchor_abspath,
+                               const char *target_basename,
+                               svn_boolean_t use_commit_times,
+                               svn_depth_t depth,
+                               svn_boolean_t depth_is_sticky,
+                               svn_boolean_t allow_unver_obstructions,
+                               const char *diff3_cmd,
+                               const apr_array_header_t *preserved_exts,
+                               svn_wc_get_file_t fetch_func,
+                               void *fetch_baton,
+                               svn_wc_conflict_resolver_func_t conflict_func,
+                               void *conflict_baton,
+                               svn_wc_external_update_t external_func,
+                               void *external_baton,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               svn_wc_notify_func2_t notify_func,
+                               void *notify_baton,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+/**
+ * Fetch the texts of the dehydrated files at or below @a local_abspath,
+ * to the depth @a depth, with @a fetch_func and @a fetch_baton, and
+ * install them as their text bases.  Install the working file of each
+ * one that isn't scheduled for deletion and doesn't exist yet, and
+ * notify #svn_wc_notify_restore for it.
+ *
+ * The caller must hold a write lock on @a local_abspath.
+ *
+ * @see svn_wc__get_lazy_update_editor()
+ */
+svn_error_t *
+svn_wc__hydrate(svn_wc_context_t *wc_ctx,
+                const char *local_abspath,
+                svn_depth_t depth,
+                svn_wc_get_file_t fetch_func,
+                void *fetch_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                svn_wc_notify_func2_t notify_func,
+                void *notify_baton,
+                apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
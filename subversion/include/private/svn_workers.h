@@ -0,0 +1,135 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ *
+ * @file svn_workers.h
+ * @brief Processing queued tasks on several threads
+ */
+
+#ifndef SVN_WORKERS_H
+#define SVN_WORKERS_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * A set of worker threads taking tasks off a shared queue, in the order
+ * they were queued, and processing them concurrently.  The thread that
+ * started the workers queues the tasks and waits for them.
+ *
+ * Pools and their allocators must not be shared between threads, so
+ * every worker has a root pool of its own.
+ *
+ * Once processing a task failed, the workers start no further tasks.
+ *
+ * @since New in 1.7.
+ */
+typedef struct svn_workers__t svn_workers__t;
+
+/**
+ * A task queued on an #svn_workers__t.  Callers typically embed it in
+ * the structure the task works on; its fields are private to the
+ * workers.
+ *
+ * @since New in 1.7.
+ */
+typedef struct svn_workers__task_t
+{
+  void *item;
+  svn_boolean_t done;
+  svn_error_t *err;
+  struct svn_workers__task_t *next;
+} svn_workers__task_t;
+
+/** Process ITEM, the item of a task, on a worker thread.  BATON is the
+ * baton given to svn_workers__start().
+ *
+ * *WORKER_STATE is NULL for the first task a worker processes and keeps
+ * whatever was stored there for the following ones, e.g. a filesystem
+ * opened in WORKER_POOL, the root pool of the worker thread, which lives
+ * until the workers are destroyed.  Use SCRATCH_POOL, which is cleared
+ * before each task, for temporary allocations.
+ *
+ * @since New in 1.7.
+ */
+typedef svn_error_t *(*svn_workers__process_t)(void *baton,
+                                               void **worker_state,
+                                               void *item,
+                                               apr_pool_t *worker_pool,
+                                               apr_pool_t *scratch_pool);
+
+/** Return up to COUNT new worker threads calling PROCESS with BATON for
+ * every task queued, or NULL if threads are not available or no thread
+ * could be started.
+ *
+ * The workers are stopped, as with svn_workers__stop(), and destroyed
+ * when POOL is cleaned up.
+ *
+ * @since New in 1.7.
+ */
+svn_workers__t *
+svn_workers__start(int count,
+                   svn_workers__process_t process,
+                   void *baton,
+                   apr_pool_t *pool);
+
+/** Queue TASK, for processing ITEM, on WORKERS.  TASK must not be queued
+ * already and both must live until svn_workers__wait() returned for it.
+ *
+ * @since New in 1.7.
+ */
+void
+svn_workers__queue(svn_workers__t *workers,
+                   svn_workers__task_t *task,
+                   void *item);
+
+/** Wait until TASK, queued on WORKERS, is done and return the error
+ * processing it failed with, if any.  A task that was not started
+ * because the workers were stopped, or because another task failed,
+ * is done without an error.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_workers__wait(svn_workers__t *workers,
+                  svn_workers__task_t *task);
+
+/** Don't start any of the tasks queued on WORKERS, which are done as of
+ * now, and stop the worker threads once their current tasks are done.
+ * No more tasks may be queued afterwards, but svn_workers__wait() may
+ * still be called for the tasks queued before.
+ *
+ * @since New in 1.7.
+ */
+void
+svn_workers__stop(svn_workers__t *workers);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_WORKERS_H */
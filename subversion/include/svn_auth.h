@@ -817,6 +817,10 @@ svn_auth_get_platform_specific_provider(
  *
  * Create and allocate @a *providers in @a pool.
  *
+ * The providers which live in a separately loaded module (GNOME Keyring
+ * and KWallet) are returned as stand-ins which load that module only when
+ * they are first asked for, or to save, credentials.
+ *
  * Default order of the platform-specific authentication providers:
  *   1. gnome-keyring
  *   2. kwallet
@@ -249,6 +249,33 @@ svn_checksum__from_digest(const unsigned char *digest,
                           apr_pool_t *result_pool);
 
 
+/**
+ * Internal function for creating a context, allocated from @a pool, that
+ * computes both the MD5 and the SHA-1 checksum of the data given to
+ * svn_checksum_update(), in a single pass over it.  svn_checksum_final()
+ * only returns the MD5 checksum; use svn_checksum__final_md5_sha1() to
+ * get both.
+ *
+ * @since New in 1.7
+ */
+svn_checksum_ctx_t *
+svn_checksum__ctx_create_md5_sha1(apr_pool_t *pool);
+
+/**
+ * Internal function for finalizing a context @a ctx created with
+ * svn_checksum__ctx_create_md5_sha1(), returning its MD5 checksum in
+ * @a *md5_checksum and its SHA-1 checksum in @a *sha1_checksum, both
+ * allocated from @a pool.
+ *
+ * @since New in 1.7
+ */
+svn_error_t *
+svn_checksum__final_md5_sha1(svn_checksum_t **md5_checksum,
+                             svn_checksum_t **sha1_checksum,
+                             const svn_checksum_ctx_t *ctx,
+                             apr_pool_t *pool);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
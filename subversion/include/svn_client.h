@@ -883,7 +883,8 @@ typedef struct svn_client_ctx_t
   apr_hash_t *config;
 
   /** a callback to be used to see if the client wishes to cancel the running
-   * operation. */
+   * operation.  If the #SVN_CONFIG_OPTION_PARALLEL_EXTERNALS option is set,
+   * it may be called by several threads at the same time. */
   svn_cancel_func_t cancel_func;
 
   /** a baton to pass to the cancellation callback. */
@@ -4092,6 +4093,36 @@ svn_client_export5(svn_revnum_t *result_rev,
                    svn_client_ctx_t *ctx,
                    apr_pool_t *pool);
 
+/**
+ * Write a POSIX tar archive of the repository tree or file @a from_url
+ * in @a revision, as seen in @a peg_revision, to @a stream.  The members
+ * of the archive are placed below the directory @a prefix; if @a prefix
+ * is @c NULL, the basename of @a from_url is used.
+ *
+ * Unlike svn_client_export5(), this neither expands keywords nor
+ * translates line endings, and leaves out externals: file contents are
+ * in repository normal form.  Where the server supports it, it generates
+ * the whole archive and sends it in a single response.
+ *
+ * End the archive, but don't close @a stream.  If @a result_rev is not
+ * @c NULL, set @a *result_rev to the revision that was archived.
+ *
+ * @a ctx is a context used for authentication and cancellation.
+ *
+ * All allocations are done in @a pool.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_client_export_archive(svn_revnum_t *result_rev,
+                          const char *from_url,
+                          const svn_opt_revision_t *peg_revision,
+                          const svn_opt_revision_t *revision,
+                          const char *prefix,
+                          svn_stream_t *stream,
+                          svn_client_ctx_t *ctx,
+                          apr_pool_t *pool);
+
 /**
  * Similar to svn_client_export5(), but with @a ignore_keywords set
  * to FALSE.
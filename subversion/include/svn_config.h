@@ -71,6 +71,9 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_HTTP_PROXY_EXCEPTIONS     "http-proxy-exceptions"
 #define SVN_CONFIG_OPTION_HTTP_TIMEOUT              "http-timeout"
 #define SVN_CONFIG_OPTION_HTTP_COMPRESSION          "http-compression"
+#define SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS      "http-max-connections"
+#define SVN_CONFIG_OPTION_HTTP_REQS_PER_CONNECTION \
+                                          "http-requests-per-connection"
 #define SVN_CONFIG_OPTION_NEON_DEBUG_MASK           "neon-debug-mask"
 #define SVN_CONFIG_OPTION_HTTP_AUTH_TYPES           "http-auth-types"
 #define SVN_CONFIG_OPTION_SSL_AUTHORITY_FILES       "ssl-authority-files"
@@ -110,8 +113,16 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_MIMETYPES_FILE            "mime-types-file"
 #define SVN_CONFIG_OPTION_PRESERVED_CF_EXTS         "preserved-conflict-file-exts"
 #define SVN_CONFIG_OPTION_INTERACTIVE_CONFLICTS     "interactive-conflicts"
+/** @since New in 1.7. */
+#define SVN_CONFIG_OPTION_MERGEINFO_CACHE           "mergeinfo-cache"
+/** @since New in 1.7. */
+#define SVN_CONFIG_OPTION_PARALLEL_EXTERNALS        "parallel-externals"
 #define SVN_CONFIG_SECTION_TUNNELS              "tunnels"
 #define SVN_CONFIG_SECTION_AUTO_PROPS           "auto-props"
+/** @since New in 1.7. */
+#define SVN_CONFIG_SECTION_WORKING_COPY         "working-copy"
+/** @since New in 1.7. */
+#define SVN_CONFIG_OPTION_SHARED_PRISTINE_DIR       "shared-pristine-directory"
 /** @} */
 
 /** @name Repository conf directory configuration files strings
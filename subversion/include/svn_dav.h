@@ -242,6 +242,22 @@ extern "C" {
 #define SVN_DAV_NS_DAV_SVN_PARTIAL_REPLAY\
             SVN_DAV_PROP_NS_DAV "svn/partial-replay"
 
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) can send an
+ * update-report response in the binary encoding, with the text deltas
+ * as raw svndiff data, when the report asks for it. */
+#define SVN_DAV_NS_DAV_SVN_BINARY_UPDATE\
+            SVN_DAV_PROP_NS_DAV "svn/binary-update"
+
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) can lock or unlock
+ * many paths in a single POST request against its 'me' resource.
+ *
+ * @since New in 1.7.
+ */
+#define SVN_DAV_NS_DAV_SVN_LOCK_MANY\
+            SVN_DAV_PROP_NS_DAV "svn/lock-many"
+
 /** @} */
 
 /** @} */
@@ -92,6 +92,23 @@ svn_delta_version(void);
  * @{
  */
 
+/** The size of the target (and source) views of the delta windows that
+ * svn_txdelta() and svn_txdelta_target_push() produce.
+ *
+ * @since New in 1.7.
+ */
+#define SVN_DELTA_DEFAULT_WINDOW_SIZE 102400
+
+/** The largest window size that svn_txdelta2() and
+ * svn_txdelta_target_push2() accept.  The svndiff parsers accept windows
+ * of up to this size as well.  Older versions reject windows larger than
+ * #SVN_DELTA_DEFAULT_WINDOW_SIZE, so such windows must only be sent to
+ * peers known to handle them.
+ *
+ * @since New in 1.7.
+ */
+#define SVN_DELTA_MAX_WINDOW_SIZE (4 * 1024 * 1024)
+
 /** Action codes for text delta instructions. */
 enum svn_delta_action {
     /* Note: The svndiff implementation relies on the values assigned in
@@ -348,7 +365,25 @@ svn_txdelta_md5_digest(svn_txdelta_stream_t *stream);
  * svn_txdelta_next_window() on @a *stream, it will read from @a source and
  * @a target to gather as much data as it needs.
  *
+ * The windows will cover up to @a window_size bytes of source and target
+ * data each.  If @a window_size is 0, use #SVN_DELTA_DEFAULT_WINDOW_SIZE.
+ * @a window_size must not exceed #SVN_DELTA_MAX_WINDOW_SIZE.  Larger
+ * windows mean fewer windows and better compression for large files, at
+ * the expense of memory.
+ *
  * Do any necessary allocation in a sub-pool of @a pool.
+ *
+ * @since New in 1.7.
+ */
+void
+svn_txdelta2(svn_txdelta_stream_t **stream,
+             svn_stream_t *source,
+             svn_stream_t *target,
+             apr_size_t window_size,
+             apr_pool_t *pool);
+
+/** Similar to svn_txdelta2(), but always using
+ * #SVN_DELTA_DEFAULT_WINDOW_SIZE.
  */
 void
 svn_txdelta(svn_txdelta_stream_t **stream,
@@ -365,6 +400,21 @@ svn_txdelta(svn_txdelta_stream_t **stream,
  * The stream handler functions will read data from @a source as
  * necessary.
  *
+ * @a window_size is interpreted as in svn_txdelta2().
+ *
+ * @since New in 1.7.
+ */
+svn_stream_t *
+svn_txdelta_target_push2(svn_txdelta_window_handler_t handler,
+                         void *handler_baton,
+                         svn_stream_t *source,
+                         apr_size_t window_size,
+                         apr_pool_t *pool);
+
+/**
+ * Similar to svn_txdelta_target_push2(), but always using
+ * #SVN_DELTA_DEFAULT_WINDOW_SIZE.
+ *
  * @since New in 1.1.
  */
 svn_stream_t *
@@ -448,6 +498,26 @@ svn_txdelta_apply(svn_stream_t *source,
 
 /*** Producing and consuming svndiff-format text deltas.  ***/
 
+/** Compression level that makes svndiff version 1 store its data
+ * uncompressed.  This avoids all compression work when writing and
+ * reading the data, at the cost of larger svndiff output.
+ *
+ * @since New in 1.7.
+ */
+#define SVN_DELTA_COMPRESSION_LEVEL_NONE 0
+
+/** Highest compression level supported by svndiff version 1.
+ *
+ * @since New in 1.7.
+ */
+#define SVN_DELTA_COMPRESSION_LEVEL_MAX 9
+
+/** Compression level used by svndiff version 1 unless specified otherwise.
+ *
+ * @since New in 1.7.
+ */
+#define SVN_DELTA_COMPRESSION_LEVEL_DEFAULT 5
+
 /** Prepare to produce an svndiff-format diff from text delta windows.
  * @a output is a writable generic stream to write the svndiff data to.
  * Allocation takes place in a sub-pool of @a pool.  On return, @a *handler
@@ -455,6 +525,25 @@ svn_txdelta_apply(svn_stream_t *source,
  * the value to pass as the @a baton argument to @a *handler. The svndiff
  * version is @a svndiff_version.
  *
+ * For svndiff version 1, @a compression_level gives the zlib compression
+ * level from #SVN_DELTA_COMPRESSION_LEVEL_NONE to
+ * #SVN_DELTA_COMPRESSION_LEVEL_MAX.  Lower levels trade output size for
+ * speed.  Any level produces data that all svndiff version 1 parsers
+ * accept.  @a compression_level is ignored for svndiff version 0.
+ *
+ * @since New in 1.7.
+ */
+void
+svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
+                        void **handler_baton,
+                        svn_stream_t *output,
+                        int svndiff_version,
+                        int compression_level,
+                        apr_pool_t *pool);
+
+/** Similar to svn_txdelta_to_svndiff3, but always using the
+ * #SVN_DELTA_COMPRESSION_LEVEL_DEFAULT compression level.
+ *
  * @since New in 1.4.
  */
 void
@@ -482,6 +571,25 @@ svn_txdelta_to_svndiff(svn_stream_t *output,
  * TRUE, attempting to close this stream before it has handled the entire
  * svndiff data set will result in #SVN_ERR_SVNDIFF_UNEXPECTED_END,
  * else this error condition will be ignored.
+ *
+ * If @a decode_concurrently is @c TRUE and threads are available, the
+ * second and further windows get decompressed on a separate thread while
+ * @a handler is busy with earlier ones.  The thread is only started once
+ * a second window arrives.  @a handler is still invoked on the thread writing
+ * to the stream and in window order, but windows may be passed to it only
+ * on later writes or when closing the stream.
+ *
+ * @since New in 1.7.
+ */
+svn_stream_t *
+svn_txdelta_parse_svndiff2(svn_txdelta_window_handler_t handler,
+                           void *handler_baton,
+                           svn_boolean_t error_on_early_close,
+                           svn_boolean_t decode_concurrently,
+                           apr_pool_t *pool);
+
+/** Similar to svn_txdelta_parse_svndiff2(), but always decoding on the
+ * thread writing to the stream.
  */
 svn_stream_t *
 svn_txdelta_parse_svndiff(svn_txdelta_window_handler_t handler,
@@ -179,6 +179,16 @@ svn_relpath_join(const char *base,
                  const char *component,
                  apr_pool_t *pool);
 
+/** Return TRUE if @a relpath is what svn_relpath_join() would make of
+ * @a base and @a component, without allocating that.
+ *
+ * @since New in 1.7.
+ */
+svn_boolean_t
+svn_relpath__is_joined(const char *relpath,
+                       const char *base,
+                       const char *component);
+
 /** Join a valid base uri (@a base) with a relative path or uri
  * (@a component), allocating the result in @a pool. @a component need
  * not be a single component: it can be a relative path or a '/'
@@ -73,6 +73,16 @@ typedef struct svn_fs_t svn_fs_t;
 #define SVN_FS_CONFIG_BDB_TXN_NOSYNC            "bdb-txn-nosync"
 #define SVN_FS_CONFIG_BDB_LOG_AUTOREMOVE        "bdb-log-autoremove"
 
+/** Commit the Berkeley DB transactions of a filesystem opened with this
+ * option set to "1" without flushing the log to disk, and flush it once
+ * per committed revision instead.  This is meant for bulk loads: a
+ * crash may lose the changes made to an uncommitted Subversion
+ * transaction, but never those of a committed revision.
+ *
+ * @since New in 1.7.
+ */
+#define SVN_FS_CONFIG_BDB_GROUP_COMMIT          "bdb-group-commit"
+
 /* See also svn_fs_type(). */
 /** @since New in 1.1. */
 #define SVN_FS_CONFIG_FS_TYPE                   "fs-type"
@@ -108,6 +118,13 @@ typedef struct svn_fs_t svn_fs_t;
  * @since New in 1.7.
  */
 #define SVN_FS_CONFIG_PRE_1_7_COMPATIBLE        "pre-1.7-compatible"
+
+/** Create repository format compatible with Subversion versions
+ * earlier than 1.8.
+ *
+ * @since New in 1.8.
+ */
+#define SVN_FS_CONFIG_PRE_1_8_COMPATIBLE        "pre-1.8-compatible"
 /** @} */
 
 
@@ -287,8 +304,36 @@ svn_fs_delete_fs(const char *path,
  * means deleting copied, unused logfiles for a Berkeley DB source
  * filesystem.
  *
+ * If @a incremental is @c TRUE and @a dest_path already contains an
+ * earlier hotcopy of the same filesystem, make an effort to copy only
+ * the data that changed since then, leaving @a dest_path usable at its
+ * old state should the copy be interrupted.  Return
+ * #SVN_ERR_UNSUPPORTED_FEATURE if the filesystem type does not support
+ * incremental hotcopies or if @a dest_path does not contain a suitable
+ * filesystem.
+ *
+ * Use @a cancel_func and @a cancel_baton for cancellation support;
+ * either may be @c NULL.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_fs_hotcopy2(const char *src_path,
+                const char *dest_path,
+                svn_boolean_t clean,
+                svn_boolean_t incremental,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *pool);
+
+/**
+ * Similar to svn_fs_hotcopy2(), but with @a incremental always set to
+ * @c FALSE and without cancellation support.
+ *
  * @since New in 1.1.
+ * @deprecated Provided for backward compatibility with the 1.6 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_hotcopy(const char *src_path,
                const char *dest_path,
@@ -1174,6 +1219,49 @@ svn_fs_paths_changed2(apr_hash_t **changed_paths_p,
                       apr_pool_t *pool);
 
 
+/** An iterator over the paths changed under a root.
+ *
+ * @see svn_fs_paths_changed_iterator()
+ * @since New in 1.7.
+ */
+typedef struct svn_fs_path_change_iterator_t svn_fs_path_change_iterator_t;
+
+/** Set @a *iterator to an iterator over the paths changed under @a root,
+ * which returns the same changes as svn_fs_paths_changed2() would, but
+ * one at a time and ordered by svn_path_compare_paths(), i.e. every
+ * directory precedes its descendants.  Fetch the changes with
+ * svn_fs_path_change_get().
+ *
+ * Unlike svn_fs_paths_changed2(), this does not need to keep the
+ * descriptions of all changes in memory at once, which makes a
+ * difference for revisions that change a great many paths.  Whether it
+ * actually saves memory depends on the back end and the kind of @a root.
+ *
+ * Allocate @a *iterator in @a pool.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_fs_paths_changed_iterator(svn_fs_path_change_iterator_t **iterator,
+                              svn_fs_root_t *root,
+                              apr_pool_t *pool);
+
+/** Set @a *path and @a *change to the next changed path of @a iterator
+ * and the description of its change.  If there are no more changes,
+ * set both to @c NULL.
+ *
+ * Allocate the results in @a pool, unless they live in the pool of
+ * @a iterator already.  Callers may clear @a pool between calls.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_fs_path_change_get(const char **path,
+                       svn_fs_path_change2_t **change,
+                       svn_fs_path_change_iterator_t *iterator,
+                       apr_pool_t *pool);
+
+
 /** Same as svn_fs_paths_changed2(), only with #svn_fs_path_change_t * values
  * in the hash (and thus no kind or copyfrom data).
  *
@@ -1201,6 +1289,29 @@ svn_fs_check_path(svn_node_kind_t *kind_p,
                   apr_pool_t *pool);
 
 
+/** Like svn_fs_check_path(), but for all the paths (<tt>const char
+ * *</tt>) in @a paths at once.  Set @a *kinds_p to an array of
+ * #svn_node_kind_t with one element per element of @a paths, in the same
+ * order, using #svn_node_none for paths that do not exist under @a root.
+ * If @a ids_p is not @c NULL, set @a *ids_p to a parallel array of
+ * node revision IDs (<tt>const svn_fs_id_t *</tt>), using @c NULL for
+ * paths that do not exist.  Allocate the results in @a pool.
+ *
+ * The directories shared by several of @a paths are looked up only
+ * once, which makes this much cheaper than calling svn_fs_check_path()
+ * for each path when the paths have common parents.  @a paths need not
+ * be sorted and may contain duplicates.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_fs_check_paths(apr_array_header_t **kinds_p,
+                   apr_array_header_t **ids_p,
+                   svn_fs_root_t *root,
+                   const apr_array_header_t *paths,
+                   apr_pool_t *pool);
+
+
 /** An opaque node history object. */
 typedef struct svn_fs_history_t svn_fs_history_t;
 
@@ -2169,8 +2280,28 @@ typedef svn_error_t *(*svn_fs_pack_notify_t)(void *baton,
  * Possibly update the filesystem located in the directory @a path
  * to use disk space more efficiently.
  *
+ * If @a jobs is larger than 1, the filesystem may use up to @a jobs
+ * threads to process independent parts of the filesystem concurrently.
+ * Notifications will still be sent in order and from the calling thread.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_fs_pack2(const char *db_path,
+             int jobs,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool);
+
+/**
+ * Similar to svn_fs_pack2(), but with @a jobs always set to 1.
+ *
  * @since New in 1.6.
+ * @deprecated Provided for backward compatibility with the 1.6 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_pack(const char *db_path,
             svn_fs_pack_notify_t notify_func,
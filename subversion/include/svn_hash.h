@@ -125,6 +125,22 @@ svn_hash_write_incremental(apr_hash_t *hash,
                            const char *terminator,
                            apr_pool_t *pool);
 
+/**
+ * Like svn_hash_read2(), but parse the hash dump held in @a buf in
+ * place instead of reading it from a stream.  The newlines following
+ * keys and values in @a buf are replaced by NUL characters, and the
+ * keys and the values' data in @a hash point into @a buf, which must
+ * therefore live as long as @a hash.  Only the svn_string_t structures
+ * are allocated, in @a pool.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_hash__parse(apr_hash_t *hash,
+                svn_stringbuf_t *buf,
+                const char *terminator,
+                apr_pool_t *pool);
+
 /**
  * This function behaves like svn_hash_read2(), but it only works
  * on an apr_file_t input, empty files are accepted, and the hash is
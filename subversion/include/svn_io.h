@@ -82,6 +82,30 @@ typedef struct svn_io_dirent_t {
   svn_boolean_t special;
 } svn_io_dirent_t;
 
+/** Represents the kind, special status, size and modification time of
+ * a directory entry.
+ *
+ * @note The first two fields are the same as those of #svn_io_dirent_t.
+ *
+ * @since New in 1.7.
+ */
+typedef struct svn_io_dirent2_t {
+  /** The kind of this entry. */
+  svn_node_kind_t kind;
+  /** If @c kind is #svn_node_file, whether this entry is a special file;
+   * else FALSE.
+   *
+   * @see svn_io_check_special_path().
+   */
+  svn_boolean_t special;
+
+  /** The size of this entry, as reported by lstat(). */
+  svn_filesize_t filesize;
+
+  /** The time this entry was last modified, as reported by lstat(). */
+  apr_time_t mtime;
+} svn_io_dirent2_t;
+
 /** Determine the @a kind of @a path.  @a path should be UTF-8 encoded.
  *
  * If @a path is a file, set @a *kind to #svn_node_file.
@@ -265,6 +289,20 @@ svn_io_create_unique_link(const char **unique_name_p,
                           apr_pool_t *pool);
 
 
+/**
+ * Create a hard link at @a path to the existing file @a dest, so that both
+ * names refer to the same file.  Fail if @a path exists, or if @a dest
+ * is on another file system.  Return #SVN_ERR_UNSUPPORTED_FEATURE on
+ * platforms without hard links.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_io_create_hard_link(const char *path,
+                        const char *dest,
+                        apr_pool_t *pool);
+
+
 /**
  * Set @a *dest to the path that the symlink at @a path references.
  * Allocate the string from @a pool.
@@ -289,6 +327,9 @@ svn_io_temp_dir(const char **dir,
  * Overwrite @a dst if it exists, else create it.  Both @a src and @a dst
  * are utf8-encoded filenames.  If @a copy_perms is TRUE, set @a dst's
  * permissions to match those of @a src.
+ *
+ * Where the file system supports it, @a dst is created as a copy-on-write
+ * clone of @a src, which shares its disk blocks until either is modified.
  */
 svn_error_t *
 svn_io_copy_file(const char *src,
@@ -727,6 +768,14 @@ typedef svn_error_t *(*svn_io_mark_fn_t)(void *baton,
 typedef svn_error_t *(*svn_io_seek_fn_t)(void *baton,
                                          svn_stream_mark_t *mark);
 
+/** Skip handler function for a generic stream. @see svn_stream_t and
+ * svn_stream_skip().
+ *
+ * @since New in 1.7.
+ */
+typedef svn_error_t *(*svn_io_skip_fn_t)(void *baton,
+                                         apr_size_t *len);
+
 /** Line-filtering callback function for a generic stream.
  * @a baton is the stream's baton.
  * @see svn_stream_t, svn_stream_set_baton() and svn_stream_readline().
@@ -811,6 +860,14 @@ void
 svn_stream_set_seek(svn_stream_t *stream,
                     svn_io_seek_fn_t seek_fn);
 
+/** Set @a stream's skip function to @a skip_fn
+ *
+ * @since New in 1.7.
+ */
+void
+svn_stream_set_skip(svn_stream_t *stream,
+                    svn_io_skip_fn_t skip_fn);
+
 /** Set @a stream's line-filtering callback function to @a line_filter_cb
  *
  * @since New in 1.7.
@@ -1102,6 +1159,20 @@ svn_stream_mark(svn_stream_t *stream,
 svn_error_t *
 svn_stream_seek(svn_stream_t *stream, svn_stream_mark_t *mark);
 
+/** Skip over up to @a *len bytes of a generic readable @a stream, as if
+ * they had been read and thrown away.  On return, set @a *len to the
+ * number of bytes skipped, which is less than requested only at the end
+ * of the stream.
+ *
+ * Streams that can do this without reading the data, such as those
+ * reading from regular files, strings or stringbufs, do so.  For all
+ * other streams the data is read in chunks and discarded.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_stream_skip(svn_stream_t *stream, apr_size_t *len);
+
 /** Return a writable stream which, when written to, writes to both of the
  * underlying streams.  Both of these streams will be closed upon closure of
  * the returned stream; use svn_stream_disown() if this is not the desired
@@ -1392,7 +1463,12 @@ svn_io_get_dir_filenames(apr_hash_t **dirents,
 
 /** Read all of the disk entries in directory @a path, a utf8-encoded
  * path.  Set @a *dirents to a hash mapping dirent names (<tt>char *</tt>) to
- * #svn_io_dirent_t structures, allocated in @a pool.
+ * #svn_io_dirent2_t structures, allocated in @a result_pool.
+ *
+ * If @a only_check_type is TRUE, only the @c kind and @c special fields
+ * of the dirents are set, which can usually be done without a stat() per
+ * entry.  Otherwise the @c filesize and @c mtime fields are set as well,
+ * so that callers needing them don't have to stat() each entry again.
  *
  * @note The `.' and `..' directories normally returned by
  * apr_dir_read() are NOT returned in the hash.
@@ -1400,6 +1476,18 @@ svn_io_get_dir_filenames(apr_hash_t **dirents,
  * @note The kind field in the @a dirents is set according to the mapping
  *       as documented for svn_io_check_path()
  *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_io_get_dirents3(apr_hash_t **dirents,
+                    const char *path,
+                    svn_boolean_t only_check_type,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool);
+
+/** Similar to svn_io_get_dirents3(), but with @a only_check_type set
+ * to TRUE and #svn_io_dirent_t values.
+ *
  * @since New in 1.3.
  */
 svn_error_t *
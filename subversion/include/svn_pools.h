@@ -61,13 +61,35 @@ svn_pool_create_ex_debug(apr_pool_t *parent_pool,
                          apr_allocator_t *allocator,
                          const char *file_line);
 
-#if APR_POOL_DEBUG
+#if APR_POOL_DEBUG || defined(SVN_POOL_PROFILE)
 #define svn_pool_create_ex(pool, allocator) \
 svn_pool_create_ex_debug(pool, allocator, APR_POOL__FILE_LINE__)
 
-#endif /* APR_POOL_DEBUG */
+#endif /* APR_POOL_DEBUG || SVN_POOL_PROFILE */
 #endif /* DOXYGEN_SHOULD_SKIP_THIS */
 
+/** Clear @a pool like apr_pool_clear(), keeping its profile going when
+ * Subversion is built with @c SVN_POOL_PROFILE.
+ *
+ * @note This function is for internal use; use svn_pool_clear().
+ * @since New in 1.7.
+ */
+void
+svn_pool__clear_profiled(apr_pool_t *pool);
+
+/** Write the statistics gathered about the pools created at each place
+ * in the code to stderr.  This does nothing unless Subversion is built
+ * with @c SVN_POOL_PROFILE, in which case the report is also written
+ * when the process exits and, where supported and not otherwise used,
+ * upon @c SIGUSR2.  Byte counts are only available with an APR built
+ * with pool debugging.
+ *
+ * @note This function is for internal use.
+ * @since New in 1.7.
+ */
+void
+svn_pool__profile_report(void);
+
 
 /** Create a pool as a subpool of @a parent_pool */
 #define svn_pool_create(parent_pool) svn_pool_create_ex(parent_pool, NULL)
@@ -76,7 +98,11 @@ svn_pool_create_ex_debug(pool, allocator, APR_POOL__FILE_LINE__)
  *
  * This define for @c svn_pool_clear exists for completeness.
  */
+#ifdef SVN_POOL_PROFILE
+#define svn_pool_clear svn_pool__clear_profiled
+#else
 #define svn_pool_clear apr_pool_clear
+#endif
 
 
 /** Destroy a @a pool and all of its children.
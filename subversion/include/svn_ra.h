@@ -137,6 +137,23 @@ typedef svn_error_t *(*svn_ra_get_client_string_func_t)(void *baton,
                                                         const char **name,
                                                         apr_pool_t *pool);
 
+/** A function type which allows the RA layer to ask the client for a
+ * readable stream over the text whose checksum is @a checksum, if the
+ * client already has it locally (e.g. as a pristine text in the working
+ * copy).  Set @a *contents to such a stream allocated in @a pool, or to
+ * @c NULL if the text is not available.  @a checksum may be of any kind.
+ *
+ * The RA layer may use this to avoid fetching file contents it would
+ * otherwise download from the server.
+ *
+ * @since New in 1.7.
+ */
+typedef svn_error_t *(*svn_ra_get_wc_contents_func_t)(
+  void *baton,
+  svn_stream_t **contents,
+  const svn_checksum_t *checksum,
+  apr_pool_t *pool);
+
 
 /**
  * A callback function type for use in @c get_file_revs.
@@ -516,6 +533,15 @@ typedef struct svn_ra_callbacks2_t
    */
   svn_ra_get_client_string_func_t get_client_string;
 
+  /** Callback for fetching file contents that the client already has.
+   * May be NULL if not used.
+   *
+   * As its baton, the general callback baton is used
+   *
+   * @since New in 1.7
+   */
+  svn_ra_get_wc_contents_func_t get_wc_contents;
+
 } svn_ra_callbacks2_t;
 
 /** Similar to svn_ra_callbacks2_t, except that the progress
@@ -1445,6 +1471,137 @@ svn_ra_stat(svn_ra_session_t *session,
             svn_dirent_t **dirent,
             apr_pool_t *pool);
 
+/**
+ * Like svn_ra_stat(), but for each of the @a paths, an array of
+ * <tt>const char *</tt> relative to the @a session's URL.  Set @a *dirents
+ * to a hash mapping each of the @a paths that exists in @a revision to
+ * its @c svn_dirent_t.
+ *
+ * Where the RA layer supports it, all the requests are sent before the
+ * responses are read, which saves a network round trip for each path.
+ *
+ * Use @a pool for all allocations.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_ra_stat_many(svn_ra_session_t *session,
+                 apr_hash_t **dirents,
+                 const apr_array_header_t *paths,
+                 svn_revnum_t revision,
+                 apr_pool_t *pool);
+
+/**
+ * One directory listing returned by svn_ra_get_dir_many().
+ *
+ * @since New in 1.7.
+ */
+typedef struct svn_ra_dir_listing_t
+{
+  /** The entries of the directory, as returned by svn_ra_get_dir2(). */
+  apr_hash_t *dirents;
+
+  /** The revision the directory was listed in. */
+  svn_revnum_t fetched_rev;
+
+  /** The properties of the directory, or @c NULL if not asked for. */
+  apr_hash_t *props;
+} svn_ra_dir_listing_t;
+
+/**
+ * Like svn_ra_get_dir2(), but for each of the @a paths, an array of
+ * <tt>const char *</tt> relative to the @a session's URL.  Set
+ * @a *listings to a hash mapping each of the @a paths to its
+ * @c svn_ra_dir_listing_t.  The entries are listed with the fields in
+ * @a dirent_fields, and the directories' properties are fetched only if
+ * @a want_props is TRUE.
+ *
+ * If any of the @a paths is not a directory in @a revision, return the
+ * error svn_ra_get_dir2() would return for it.
+ *
+ * Where the RA layer supports it, all the requests are sent before the
+ * responses are read, which saves a network round trip for each path.
+ *
+ * Use @a pool for all allocations.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_ra_get_dir_many(svn_ra_session_t *session,
+                    apr_hash_t **listings,
+                    const apr_array_header_t *paths,
+                    svn_revnum_t revision,
+                    apr_uint32_t dirent_fields,
+                    svn_boolean_t want_props,
+                    apr_pool_t *pool);
+
+/**
+ * Callback type for svn_ra_list().  @a path is the path of the entry
+ * relative to the listed directory and @a dirent describes it.  Both are
+ * allocated in @a scratch_pool, which is cleared after each call.
+ *
+ * @since New in 1.7.
+ */
+typedef svn_error_t *(*svn_ra_dirent_receiver_t)(const char *path,
+                                                 svn_dirent_t *dirent,
+                                                 void *baton,
+                                                 apr_pool_t *scratch_pool);
+
+/**
+ * Invoke @a receiver with @a receiver_baton on the entries of the
+ * directory @a path (relative to the @a session's URL) in @a revision,
+ * down to @a depth: for #svn_depth_files only on the files directly in
+ * @a path, for #svn_depth_immediates on all of its children, and for
+ * #svn_depth_infinity on everything below it.  If @a revision is
+ * #SVN_INVALID_REVNUM, list the HEAD revision.
+ *
+ * The entries are reported depth-first, the entries of each directory
+ * sorted by name, and each directory before its contents.  At least the
+ * fields in @a dirent_fields are filled in, like svn_ra_get_dir2() does.
+ * Entries the user may not read are left out.
+ *
+ * Where the RA layer supports it, the whole tree is listed with a single
+ * request; otherwise there is a svn_ra_get_dir2() call per directory.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_ra_list(svn_ra_session_t *session,
+            const char *path,
+            svn_revnum_t revision,
+            svn_depth_t depth,
+            apr_uint32_t dirent_fields,
+            svn_ra_dirent_receiver_t receiver,
+            void *receiver_baton,
+            apr_pool_t *scratch_pool);
+
+/**
+ * Write a POSIX tar archive of @a path (relative to the @a session's
+ * URL) in @a revision to @a stream, as svn_repos_archive() describes
+ * for @a prefix.  If @a revision is #SVN_INVALID_REVNUM, archive the
+ * HEAD revision.  File contents are in repository normal form.  Nodes
+ * the user may not read are left out.
+ *
+ * Where the RA layer supports it, the server generates the archive and
+ * sends it with a single response; otherwise the tree is listed with
+ * svn_ra_list() and every file fetched separately.
+ *
+ * End the archive, but don't close @a stream.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_ra_get_archive(svn_ra_session_t *session,
+                   const char *path,
+                   svn_revnum_t revision,
+                   const char *prefix,
+                   svn_stream_t *stream,
+                   apr_pool_t *scratch_pool);
+
 
 /**
  * Set @a *uuid to the repository's UUID, allocated in @a pool.
@@ -1601,6 +1758,44 @@ svn_ra_get_file_revs(svn_ra_session_t *session,
                      void *handler_baton,
                      apr_pool_t *pool);
 
+/**
+ * Have the server compute which revision last changed each line of the
+ * file @a path as seen in revision @a end, going back as far as revision
+ * @a start, and invoke @a receiver with @a receiver_baton for each run of
+ * lines last changed in the same revision.  Lines that were last changed
+ * before @a start are reported with #SVN_INVALID_REVNUM.  @a path is
+ * relative to the @a session's URL.
+ *
+ * The revisions of the file are compared using the diff options in
+ * @a diff_options, an array of <tt>const char *</tt> as accepted by
+ * svn_diff_file_options_parse().  It may be NULL.  Unless
+ * @a ignore_mime_type is TRUE, fail with #SVN_ERR_CLIENT_IS_BINARY_FILE
+ * if the file has a binary @c svn:mime-type in any of the revisions.
+ *
+ * Unlike svn_ra_get_file_revs2(), this transfers only the annotations,
+ * not the contents of every revision of the file.  The contents of
+ * @a path in @a end must be fetched separately if needed.
+ *
+ * @note This functionality is only available from servers that have the
+ * #SVN_RA_CAPABILITY_FILE_BLAME capability.  Others cause an
+ * #SVN_ERR_RA_NOT_IMPLEMENTED error; the caller may then fall back to
+ * svn_ra_get_file_revs2() and compute the annotations itself.
+ *
+ * Use @a pool for all allocations.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_ra_get_file_blame(svn_ra_session_t *session,
+                      const char *path,
+                      svn_revnum_t start,
+                      svn_revnum_t end,
+                      const apr_array_header_t *diff_options,
+                      svn_boolean_t ignore_mime_type,
+                      svn_blame_chunk_receiver_t receiver,
+                      void *receiver_baton,
+                      apr_pool_t *pool);
+
 /**
  * Lock each path in @a path_revs, which is a hash whose keys are the
  * paths to be locked, and whose values are the corresponding base
@@ -1861,6 +2056,24 @@ svn_ra_has_capability(svn_ra_session_t *session,
  */
 #define SVN_RA_CAPABILITY_COMMIT_REVPROPS "commit-revprops"
 
+/**
+ * The capability of accepting delta windows larger than
+ * #SVN_DELTA_DEFAULT_WINDOW_SIZE, up to #SVN_DELTA_MAX_WINDOW_SIZE.
+ * Text deltas sent to a server with this capability may be created
+ * with a larger window size through svn_txdelta2().
+ *
+ * @since New in 1.7.
+ */
+#define SVN_RA_CAPABILITY_LARGE_DELTA_WINDOWS "large-delta-windows"
+
+/**
+ * The capability of computing blame information on the server, see
+ * svn_ra_get_file_blame().
+ *
+ * @since New in 1.7.
+ */
+#define SVN_RA_CAPABILITY_FILE_BLAME "file-blame"
+
 /*       *** PLEASE READ THIS IF YOU ADD A NEW CAPABILITY ***
  *
  * RA layers generally fetch all capabilities when asked about any
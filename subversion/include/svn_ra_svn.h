@@ -60,6 +60,18 @@ extern "C" {
 #define SVN_RA_SVN_CAP_LOG_REVPROPS "log-revprops"
 /* maps to SVN_RA_CAPABILITY_PARTIAL_REPLAY */
 #define SVN_RA_SVN_CAP_PARTIAL_REPLAY "partial-replay"
+/* maps to SVN_RA_CAPABILITY_LARGE_DELTA_WINDOWS */
+#define SVN_RA_SVN_CAP_LARGE_DELTA_WINDOWS "large-delta-windows"
+/* maps to SVN_RA_CAPABILITY_FILE_BLAME */
+#define SVN_RA_SVN_CAP_FILE_BLAME "file-blame"
+/* the server accepts pipelined get-dir and stat commands */
+#define SVN_RA_SVN_CAP_PIPELINED_READS "pipelined-reads"
+/* the server can compress the whole connection */
+#define SVN_RA_SVN_CAP_COMPRESSED_STREAM "compressed-stream"
+/* the server supports the list command */
+#define SVN_RA_SVN_CAP_LIST "list"
+/* the server supports the get-archive command */
+#define SVN_RA_SVN_CAP_ARCHIVE "archive"
 
 /** ra_svn passes @c svn_dirent_t fields over the wire as a list of
  * words, these are the values used to represent each field.
@@ -37,6 +37,7 @@
 #include "svn_delta.h"
 #include "svn_fs.h"
 #include "svn_io.h"
+#include "svn_diff.h"
 #include "svn_version.h"
 #include "svn_mergeinfo.h"
 
@@ -326,7 +327,22 @@ svn_repos_find_root_path(const char *path,
  * function to @a pool to remove the lock.  If no lock can be acquired,
  * returns error, with undefined effect on @a *repos_p.  If an exclusive
  * lock is present, this blocks until it's gone.
+ *
+ * @a fs_config is passed to the filesystem, and may be NULL.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_repos_open2(svn_repos_t **repos_p,
+                const char *path,
+                apr_hash_t *fs_config,
+                apr_pool_t *pool);
+
+/** Similar to svn_repos_open2() with @a fs_config set to NULL.
+ *
+ * @deprecated Provided for backward compatibility with the 1.6 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_open(svn_repos_t **repos_p,
                const char *path,
@@ -446,8 +462,35 @@ svn_repos_fs(svn_repos_t *repos);
  * source filesystem as part of the copy operation; currently, this
  * means deleting copied, unused logfiles for a Berkeley DB source
  * repository.
+ *
+ * If @a incremental is @c TRUE and @a dst_path already contains an
+ * earlier hotcopy of the same repository, copy only the parts of the
+ * filesystem that changed since then; see svn_fs_hotcopy2().  If
+ * @a dst_path does not contain a repository yet, @a incremental has
+ * no effect.
+ *
+ * Use @a cancel_func and @a cancel_baton for cancellation support;
+ * either may be @c NULL.
+ *
+ * @since New in 1.7.
  */
 svn_error_t *
+svn_repos_hotcopy2(const char *src_path,
+                   const char *dst_path,
+                   svn_boolean_t clean_logs,
+                   svn_boolean_t incremental,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool);
+
+/**
+ * Similar to svn_repos_hotcopy2(), but with @a incremental always set
+ * to @c FALSE and without cancellation support.
+ *
+ * @deprecated Provided for backward compatibility with the 1.6 API.
+ */
+SVN_DEPRECATED
+svn_error_t *
 svn_repos_hotcopy(const char *src_path,
                   const char *dst_path,
                   svn_boolean_t clean_logs,
@@ -456,12 +499,14 @@ svn_repos_hotcopy(const char *src_path,
 
 /**
  * Possibly update the repository, @a repos, to use a more efficient
- * filesystem representation.  Use @a pool for allocations.
+ * filesystem representation.  Up to @a jobs threads may be used to do
+ * that, see svn_fs_pack2().  Use @a pool for allocations.
  *
  * @since New in 1.7.
  */
 svn_error_t *
 svn_repos_fs_pack2(svn_repos_t *repos,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -470,7 +515,7 @@ svn_repos_fs_pack2(svn_repos_t *repos,
 
 /**
  * Similar to svn_repos_fs_pack2(), but with a #svn_fs_pack_notify_t instead
- * of a #svn_repos_notify_t.
+ * of a #svn_repos_notify_t and @a jobs always set to 1.
  *
  * @since New in 1.6.
  * @deprecated Provided for backward compatibility with the 1.6 API.
@@ -1105,6 +1150,8 @@ svn_repos_dir_delta(svn_fs_root_t *src_root,
  * the tree that the client is assumed to have knowledge of, and thus any
  * copies of data from outside that part of the tree will be sent in their
  * entirety, not as simple copies or deltas against a previous version.
+ * A copy whose source is older than @a low_water_mark, but has not changed
+ * since, is sent as a copy from @a low_water_mark instead.
  *
  * The @a editor passed to this function should be aware of the fact
  * that, if @a send_deltas is FALSE, calls to its change_dir_prop(),
@@ -1352,6 +1399,93 @@ svn_repos_stat(svn_dirent_t **dirent,
                const char *path,
                apr_pool_t *pool);
 
+/**
+ * Callback type for svn_repos_list().  @a path is the path of the entry
+ * relative to the listed directory and @a dirent describes it.  Both are
+ * allocated in @a scratch_pool, which is cleared after each call.
+ *
+ * @since New in 1.7.
+ */
+typedef svn_error_t *(*svn_repos_dirent_receiver_t)(const char *path,
+                                                    svn_dirent_t *dirent,
+                                                    void *baton,
+                                                    apr_pool_t *scratch_pool);
+
+/**
+ * Invoke @a receiver with @a receiver_baton on the entries of the
+ * directory @a path in @a root, down to @a depth: for #svn_depth_files
+ * only on the files directly in @a path, for #svn_depth_immediates on
+ * all of its children, and for #svn_depth_infinity on everything below
+ * it.  #svn_depth_empty lists nothing.
+ *
+ * The entries are reported depth-first, the entries of each directory
+ * sorted by name, and each directory before its contents.  Only the
+ * fields of the #svn_dirent_t given in @a dirent_fields (a combination
+ * of the @c SVN_DIRENT_* flags) are filled in; the kind always is.
+ *
+ * If @a authz_read_func is not @c NULL, skip all entries that it doesn't
+ * allow to read, together with everything below them, and return
+ * #SVN_ERR_AUTHZ_UNREADABLE if @a path itself is not readable.  Return
+ * #SVN_ERR_FS_NOT_DIRECTORY if @a path is not a directory.
+ *
+ * All entries are read from @a root, so that a large tree can be listed
+ * without opening anything more than once.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_repos_list(svn_fs_root_t *root,
+               const char *path,
+               svn_depth_t depth,
+               apr_uint32_t dirent_fields,
+               svn_repos_authz_func_t authz_read_func,
+               void *authz_read_baton,
+               svn_repos_dirent_receiver_t receiver,
+               void *receiver_baton,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool);
+
+/**
+ * Write a POSIX tar archive of the node @a path in @a root to @a stream,
+ * reading every node from @a root in a single walk.
+ *
+ * The archive members are named after their path below @a path, under
+ * the directory @a prefix; a directory @a path itself becomes the member
+ * @a prefix.  If @a prefix is empty, the contents of a directory @a path
+ * are at the top of the archive, and a file @a path is named after its
+ * basename.  Directories come before their contents, which are sorted
+ * by name.
+ *
+ * File contents are written in repository normal form, without keyword
+ * expansion or end-of-line translation.  Files with @c svn:executable
+ * set get an executable mode, symbolic links are written as such, and
+ * every member has the date of the revision it was last changed in.
+ *
+ * If @a authz_read_func is not @c NULL, leave out all nodes that it
+ * doesn't allow to read, together with everything below them, and
+ * return #SVN_ERR_AUTHZ_UNREADABLE if @a path itself is not readable.
+ * Return #SVN_ERR_FS_NOT_FOUND if @a path does not exist.
+ *
+ * End the archive, but don't close @a stream.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_repos_archive(svn_fs_root_t *root,
+                  const char *path,
+                  const char *prefix,
+                  svn_repos_authz_func_t authz_read_func,
+                  void *authz_read_baton,
+                  svn_stream_t *stream,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *scratch_pool);
+
 
 /**
  * Given @a path which exists at revision @a start in @a fs, set
@@ -1771,6 +1905,45 @@ svn_repos_get_file_revs(svn_repos_t *repos,
                         void *handler_baton,
                         apr_pool_t *pool);
 
+/**
+ * Compute which revision last changed each line of the file @a path in
+ * @a repos as seen in revision @a end, and invoke @a receiver with
+ * @a receiver_baton for each run of lines last changed in the same
+ * revision.  Lines that were last changed before revision @a start are
+ * reported with #SVN_INVALID_REVNUM.
+ *
+ * The interesting revisions of the file are found as by
+ * svn_repos_get_file_revs2() (without merged revisions), and compared
+ * using @a diff_options, which may be NULL for the default options.
+ * Unlike svn_repos_get_file_revs2(), which leaves the comparison to the
+ * caller, this only hands out the resulting annotations.
+ *
+ * Unless @a ignore_mime_type is TRUE, fail with
+ * #SVN_ERR_CLIENT_IS_BINARY_FILE if the file has a binary
+ * @c svn:mime-type in any of these revisions.
+ *
+ * If optional @a authz_read_func is non-NULL, then use this function
+ * (along with optional @a authz_read_baton) to check the readability
+ * of the rev-path in each interesting revision encountered, and of the
+ * revision properties passed to @a receiver.
+ *
+ * @a pool is used for all allocations.
+ *
+ * @since New in 1.7.
+ */
+svn_error_t *
+svn_repos_get_file_blame(svn_repos_t *repos,
+                         const char *path,
+                         svn_revnum_t start,
+                         svn_revnum_t end,
+                         const svn_diff_file_options_t *diff_options,
+                         svn_boolean_t ignore_mime_type,
+                         svn_repos_authz_func_t authz_read_func,
+                         void *authz_read_baton,
+                         svn_blame_chunk_receiver_t receiver,
+                         void *receiver_baton,
+                         apr_pool_t *pool);
+
 
 /* ---------------------------------------------------------------*/
 
@@ -2265,6 +2438,14 @@ svn_repos_node_from_baton(void *edit_baton);
  * the verified revision and @a warning_text @c NULL. For warnings call @a
  * notify_func with @a warning_text set.
  *
+ * If @a jobs is larger than 1, up to @a jobs threads may be used to
+ * verify several revisions at once, each with a filesystem object of
+ * its own.  Notifications are still sent from the calling thread and
+ * in revision order.  If a revision fails to verify, all revisions
+ * before it get verified and the error for the oldest failing
+ * revision is returned.  @a cancel_func may then get called from any
+ * of these threads.
+ *
  * If @a cancel_func is not @c NULL, call it periodically with @a
  * cancel_baton as argument to see if the caller wishes to cancel the
  * verification.
@@ -2275,6 +2456,7 @@ svn_error_t *
 svn_repos_verify_fs2(svn_repos_t *repos,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
+                     int jobs,
                      svn_repos_notify_func_t notify_func,
                      void *notify_baton,
                      svn_cancel_func_t cancel,
@@ -2283,7 +2465,8 @@ svn_repos_verify_fs2(svn_repos_t *repos,
 
 /**
  * Similar to svn_repos_verify_fs2(), but with a feedback_stream instead of
- * handling feedback via the notify_func handler
+ * handling feedback via the notify_func handler and @a jobs always set
+ * to 1.
  *
  * @since New in 1.5.
  * @deprecated Provided for backward compatibility with the 1.6 API.
@@ -2325,6 +2508,13 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * @a notify_func with @a rev set to the dumped revision and @a warning_text
  * @c NULL. For warnings call @a notify_func with @a warning_text.
  *
+ * If @a jobs is larger than 1, up to @a jobs threads may be used to
+ * dump several revisions at once into temporary files, each with a
+ * filesystem object of its own.  The revisions are still written to
+ * @a dumpstream and notified from the calling thread and in revision
+ * order, so the output does not depend on @a jobs.  @a cancel_func may
+ * then get called from any of these threads.
+ *
  * If @a cancel_func is not @c NULL, it is called periodically with
  * @a cancel_baton as argument to see if the client wishes to cancel
  * the dump.
@@ -2338,6 +2528,7 @@ svn_repos_dump_fs3(svn_repos_t *repos,
                    svn_revnum_t end_rev,
                    svn_boolean_t incremental,
                    svn_boolean_t use_deltas,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -2346,7 +2537,8 @@ svn_repos_dump_fs3(svn_repos_t *repos,
 
 /**
  * Similar to svn_repos_dump_fs3(), but with a feedback_stream instead of
- * handling feedback via the notify_func handler
+ * handling feedback via the notify_func handler and @a jobs always set
+ * to 1.
  *
  * @since New in 1.1.
  * @deprecated Provided for backward compatibility with the 1.6 API.
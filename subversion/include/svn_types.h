@@ -1124,6 +1124,27 @@ typedef unsigned long svn_linenum_t;
  */
 #define SVN_LINENUM_MAX_VALUE ULONG_MAX
 
+/**
+ * A callback invoked by generators of blame information, once for each
+ * run of consecutive lines of a file that were last changed in the same
+ * revision, in order.  The run starts at the zero-based line
+ * @a start_line and extends up to the start of the next run, or to the
+ * end of the file.
+ *
+ * @a revision is the revision that last changed the lines, or
+ * #SVN_INVALID_REVNUM if that happened before the range of revisions
+ * that was asked about.  In the latter case @a rev_props is NULL, else
+ * it holds the properties of @a revision.
+ *
+ * @since New in 1.7.
+ */
+typedef svn_error_t *(*svn_blame_chunk_receiver_t)(
+  void *baton,
+  svn_linenum_t start_line,
+  svn_revnum_t revision,
+  apr_hash_t *rev_props,
+  apr_pool_t *pool);
+
 /** @} */
 
 
@@ -37,6 +37,7 @@
 #include "svn_sorts.h"
 
 #include "private/svn_wc_private.h"
+#include "private/svn_pipeline.h"
 
 #include "svn_private_config.h"
 
@@ -67,12 +68,33 @@ struct blame_chain
   struct apr_pool_t *pool;  /* Allocate members from this pool. */
 };
 
-/* The baton use for the diff output routine. */
+/* The baton use for the diff output routine.  The diff is used to build
+   a new blame chain for the modified file in one pass over the chain of
+   the original file, instead of shifting the chunks of the old chain
+   around for every hunk. */
 struct diff_baton {
   struct blame_chain *chain;
   struct rev *rev;
+  struct blame *walk;  /* the chunk of the old chain that contains the
+                          current position in the original file, followed
+                          by the rest of the old chain */
+  struct blame *last;  /* the last chunk of the new chain, or NULL */
 };
 
+/* The number of revisions whose files are kept around for the diff
+   thread.  The revisions being received may run up to two less than
+   that ahead of the one being diffed. */
+#define PIPELINE_DEPTH 8
+
+/* A revision queued for diffing on the diff thread. */
+typedef struct pending_diff_t
+{
+  const char *last_file;      /* the previous revision of the file */
+  const char *cur_file;       /* this revision of the file */
+  struct blame_chain *chain;  /* the chain to add the blame to */
+  struct rev *rev;            /* the revision to blame the changes on */
+} pending_diff_t;
+
 /* The baton used for a file revision. */
 struct file_rev_baton {
   svn_revnum_t start_rev, end_rev;
@@ -99,6 +121,10 @@ struct file_rev_baton {
   /* pools for files which may need to persist for more than one rev. */
   apr_pool_t *filepool;
   apr_pool_t *prevfilepool;
+
+  /* If not NULL, revisions get diffed on a separate thread, queued on
+     it as pending_diff_t. */
+  svn_pipeline__t *pipeline;
 };
 
 /* The baton used by the txdelta window handler. */
@@ -110,6 +136,7 @@ struct delta_baton {
   svn_stream_t *source_stream;  /* the delta source */
   svn_stream_t *stream;  /* the result of the delta */
   const char *filename;
+  apr_pool_t *filepool;  /* the pool FILENAME lives in */
 };
 
 
@@ -145,104 +172,63 @@ blame_destroy(struct blame_chain *chain,
   chain->avail = blame;
 }
 
-/* Return the blame chunk that contains token OFF, starting the search at
-   BLAME. */
-static struct blame *
-blame_find(struct blame *blame, apr_off_t off)
-{
-  struct blame *prev = NULL;
-  while (blame)
-    {
-      if (blame->start > off) break;
-      prev = blame;
-      blame = blame->next;
-    }
-  return prev;
-}
-
-/* Shift the start-point of BLAME and all subsequence blame-chunks
-   by ADJUST tokens */
+/* Append a chunk of blame associated with REV starting at token START
+   to the new chain of DB, unless it would just continue the last chunk. */
 static void
-blame_adjust(struct blame *blame, apr_off_t adjust)
+blame_append(struct diff_baton *db,
+             struct rev *rev,
+             apr_off_t start)
 {
-  while (blame)
-    {
-      blame->start += adjust;
-      blame = blame->next;
-    }
+  struct blame *blame;
+
+  if (db->last && db->last->rev == rev)
+    return;
+
+  blame = blame_create(db->chain, rev, start);
+  if (db->last)
+    db->last->next = blame;
+  else
+    db->chain->blame = blame;
+  db->last = blame;
 }
 
-/* Delete the blame associated with the region from token START to
-   START + LENGTH */
-static svn_error_t *
-blame_delete_range(struct blame_chain *chain,
-                   apr_off_t start,
-                   apr_off_t length)
+/* Advance DB->walk to the chunk of the old chain that contains token OFF
+   of the original file, destroying the chunks that are passed. */
+static void
+blame_skip(struct diff_baton *db,
+           apr_off_t off)
 {
-  struct blame *first = blame_find(chain->blame, start);
-  struct blame *last = blame_find(chain->blame, start + length);
-  struct blame *tail = last->next;
-
-  if (first != last)
+  while (db->walk && db->walk->next && db->walk->next->start <= off)
     {
-      struct blame *walk = first->next;
-      while (walk != last)
-        {
-          struct blame *next = walk->next;
-          blame_destroy(chain, walk);
-          walk = next;
-        }
-      first->next = last;
-      last->start = start;
-      if (first->start == start)
-        {
-          *first = *last;
-          blame_destroy(chain, last);
-          last = first;
-        }
-    }
+      struct blame *next = db->walk->next;
 
-  if (tail && tail->start == last->start + length)
-    {
-      *last = *tail;
-      blame_destroy(chain, tail);
-      tail = last->next;
+      blame_destroy(db->chain, db->walk);
+      db->walk = next;
     }
-
-  blame_adjust(tail, -length);
-
-  return SVN_NO_ERROR;
 }
 
-/* Insert a chunk of blame associated with REV starting
-   at token START and continuing for LENGTH tokens */
+/* Callback for the common parts of the diff between subsequent revisions:
+   the lines keep their blame. */
 static svn_error_t *
-blame_insert_range(struct blame_chain *chain,
-                   struct rev *rev,
-                   apr_off_t start,
-                   apr_off_t length)
+output_diff_common(void *baton,
+                   apr_off_t original_start,
+                   apr_off_t original_length,
+                   apr_off_t modified_start,
+                   apr_off_t modified_length,
+                   apr_off_t latest_start,
+                   apr_off_t latest_length)
 {
-  struct blame *head = chain->blame;
-  struct blame *point = blame_find(head, start);
-  struct blame *insert;
+  struct diff_baton *db = baton;
+  struct blame *walk;
 
-  if (point->start == start)
-    {
-      insert = blame_create(chain, point->rev, point->start + length);
-      point->rev = rev;
-      insert->next = point->next;
-      point->next = insert;
-    }
-  else
-    {
-      struct blame *middle;
-      middle = blame_create(chain, rev, start);
-      insert = blame_create(chain, point->rev, start + length);
-      middle->next = insert;
-      insert->next = point->next;
-      point->next = middle;
-    }
-  blame_adjust(insert->next, length);
+  blame_skip(db, original_start);
+
+  for (walk = db->walk;
+       walk && walk->start < original_start + original_length;
+       walk = walk->next)
+    blame_append(db, walk->rev,
+                 modified_start + (walk->start > original_start
+                                   ? walk->start - original_start : 0));
 
   return SVN_NO_ERROR;
 }
@@ -259,18 +245,16 @@ output_diff_modified(void *baton,
 {
   struct diff_baton *db = baton;
 
-  if (original_length)
-    SVN_ERR(blame_delete_range(db->chain, modified_start, original_length));
-
+  /* The deleted lines of the original simply don't make it into the new
+     chain. */
   if (modified_length)
-    SVN_ERR(blame_insert_range(db->chain, db->rev, modified_start,
-                               modified_length));
+    blame_append(db, db->rev, modified_start);
 
   return SVN_NO_ERROR;
 }
 
 static const svn_diff_output_fns_t output_fns = {
-        NULL,
+        output_diff_common,
         output_diff_modified
 };
 
@@ -297,16 +281,57 @@ add_file_blame(const char *last_file,
 
       diff_baton.chain = chain;
       diff_baton.rev = rev;
+      diff_baton.walk = chain->blame;
+      diff_baton.last = NULL;
+      chain->blame = NULL;
 
-      /* We have a previous file.  Get the diff and adjust blame info. */
+      /* We have a previous file.  Get the diff and build the new blame
+         chain from the old one. */
       SVN_ERR(svn_diff_file_diff_2(&diff, last_file, cur_file,
                                    diff_options, pool));
       SVN_ERR(svn_diff_output(diff, &diff_baton, &output_fns));
+
+      /* Recycle what is left of the old chain. */
+      while (diff_baton.walk)
+        {
+          struct blame *next = diff_baton.walk->next;
+
+          blame_destroy(chain, diff_baton.walk);
+          diff_baton.walk = next;
+        }
+
+      /* Like the chain of a first revision, the chain of an empty file
+         still has a chunk. */
+      if (!chain->blame)
+        chain->blame = blame_create(chain, rev, 0);
     }
 
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_pipeline__process_t, adding the pending_diff_t ITEM to
+   its chain using BATON, the diff thread's own copy of the
+   svn_diff_file_options_t. */
+static svn_error_t *
+diff_queued(void *baton,
+            void *item,
+            apr_pool_t *scratch_pool)
+{
+  pending_diff_t *diff = item;
+
+  return svn_error_return(add_file_blame(diff->last_file, diff->cur_file,
+                                         diff->chain, diff->rev, baton,
+                                         scratch_pool));
+}
+
+/* Pool cleanup destroying BATON, a root pool. */
+static apr_status_t
+destroy_root_pool(void *baton)
+{
+  svn_pool_destroy(baton);
+  return APR_SUCCESS;
+}
+
 static svn_error_t *
 window_handler(svn_txdelta_window_t *window, void *baton)
 {
@@ -337,9 +362,21 @@ window_handler(svn_txdelta_window_t *window, void *baton)
     chain = frb->chain;
 
   /* Process this file. */
-  SVN_ERR(add_file_blame(frb->last_filename,
-                         dbaton->filename, chain, frb->rev,
-                         frb->diff_options, frb->currpool));
+  if (frb->pipeline)
+    {
+      /* The diff lives in the pool of the file of this revision. */
+      pending_diff_t *diff = apr_palloc(dbaton->filepool, sizeof(*diff));
+
+      diff->last_file = frb->last_filename;
+      diff->cur_file = dbaton->filename;
+      diff->chain = chain;
+      diff->rev = frb->rev;
+      svn_pipeline__queue(frb->pipeline, diff);
+    }
+  else
+    SVN_ERR(add_file_blame(frb->last_filename,
+                           dbaton->filename, chain, frb->rev,
+                           frb->diff_options, frb->currpool));
 
   /* If we are including merged revisions, and the current revision is not a
      merged one, we need to add its blame info to the chain for the original
@@ -467,12 +504,20 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
   else
     filepool = frb->currpool;
 
+  /* The diff thread may still need the files of the last few revisions,
+     so they don't get removed along with the current pool.  The file of
+     revision N - PIPELINE_DEPTH is needed until revision
+     N - PIPELINE_DEPTH + 1 has been diffed against it. */
+  if (frb->pipeline)
+    SVN_ERR(svn_pipeline__next_slot(&filepool, frb->pipeline));
+
   SVN_ERR(svn_stream_open_unique(&delta_baton->stream,
                                  &delta_baton->filename,
                                  NULL,
                                  svn_io_file_del_on_pool_cleanup,
                                  filepool, filepool));
   cur_stream = svn_stream_disown(delta_baton->stream, filepool);
+  delta_baton->filepool = filepool;
 
   /* Get window handler for applying delta. */
   svn_txdelta_apply(last_stream, cur_stream, NULL, NULL,
@@ -583,6 +628,101 @@ normalize_blames(struct blame_chain *chain,
     }
 }
 
+/* The baton for server_blame_receiver(). */
+struct server_blame_baton {
+  struct blame_chain *chain;
+  struct blame *last;   /* the last chunk of CHAIN, or NULL */
+  apr_pool_t *pool;     /* for the revisions */
+};
+
+/* Implements svn_blame_chunk_receiver_t, appending the chunks the server
+   sends to a blame chain. */
+static svn_error_t *
+server_blame_receiver(void *baton,
+                      svn_linenum_t start_line,
+                      svn_revnum_t revision,
+                      apr_hash_t *rev_props,
+                      apr_pool_t *pool)
+{
+  struct server_blame_baton *sbb = baton;
+  struct rev *rev = apr_pcalloc(sbb->pool, sizeof(*rev));
+  struct blame *blame;
+
+  rev->revision = revision;
+  if (rev_props)
+    rev->rev_props = svn_prop_hash_dup(rev_props, sbb->pool);
+
+  blame = blame_create(sbb->chain, rev, start_line);
+  if (sbb->last)
+    sbb->last->next = blame;
+  else
+    sbb->chain->blame = blame;
+  sbb->last = blame;
+
+  return SVN_NO_ERROR;
+}
+
+/* Try to have the server behind RA_SESSION compute the blame information
+   of the file FRB is about, and put it into FRB->chain.  Also fetch the
+   file in FRB->end_rev into a temporary file allocated in POOL and set
+   FRB->last_filename to it.  If the server can't do that, leave
+   FRB->last_filename NULL. */
+static svn_error_t *
+get_server_blame(struct file_rev_baton *frb,
+                 svn_ra_session_t *ra_session,
+                 apr_pool_t *pool)
+{
+  struct server_blame_baton sbb;
+  apr_array_header_t *diff_args = apr_array_make(pool, 3,
+                                                 sizeof(const char *));
+  svn_boolean_t has_server_blame;
+  svn_stream_t *stream;
+  const char *filename;
+  svn_error_t *err;
+
+  SVN_ERR(svn_ra_has_capability(ra_session, &has_server_blame,
+                                SVN_RA_CAPABILITY_FILE_BLAME, pool));
+  if (! has_server_blame)
+    return SVN_NO_ERROR;
+
+  /* Pass the diff options on in the form svn_diff_file_options_parse()
+     accepts. */
+  if (frb->diff_options->ignore_space == svn_diff_file_ignore_space_change)
+    APR_ARRAY_PUSH(diff_args, const char *) = "-b";
+  else if (frb->diff_options->ignore_space == svn_diff_file_ignore_space_all)
+    APR_ARRAY_PUSH(diff_args, const char *) = "-w";
+  if (frb->diff_options->ignore_eol_style)
+    APR_ARRAY_PUSH(diff_args, const char *) = "--ignore-eol-style";
+  if (frb->diff_options->algorithm == svn_diff_file_algorithm_histogram)
+    APR_ARRAY_PUSH(diff_args, const char *) = "--histogram";
+
+  sbb.chain = frb->chain;
+  sbb.last = NULL;
+  sbb.pool = frb->mainpool;
+
+  err = svn_ra_get_file_blame(ra_session, "", frb->start_rev, frb->end_rev,
+                              diff_args, frb->ignore_mime_type,
+                              server_blame_receiver, &sbb, pool);
+  if (err && err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* We still need the text of the lines. */
+  SVN_ERR(svn_stream_open_unique(&stream, &filename, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 pool, pool));
+  SVN_ERR(svn_ra_get_file(ra_session, "", frb->end_rev, stream,
+                          NULL, NULL, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  frb->last_filename = filename;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client_blame5(const char *target,
                   const svn_opt_revision_t *peg_revision,
@@ -666,15 +806,63 @@ svn_client_blame5(const char *target,
       frb.filepool = svn_pool_create(pool);
       frb.prevfilepool = svn_pool_create(pool);
     }
+  frb.pipeline = NULL;
 
-  /* Collect all blame information.
+  /* Let the server compute the blame information if it can, so that we
+     don't have to fetch every revision of the file.  It can't tell us
+     about merged revisions, though. */
+  if (! include_merged_revisions)
+    SVN_ERR(get_server_blame(&frb, ra_session, pool));
+
+  /* Else, collect all blame information ourselves.
      We need to ensure that we get one revision before the start_rev,
      if available so that we can know what was actually changed in the start
      revision. */
-  SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
-                                start_revnum - (start_revnum > 0 ? 1 : 0),
-                                end_revnum, include_merged_revisions,
-                                file_rev_handler, &frb, pool));
+  if (! frb.last_filename)
+    {
+      svn_error_t *err;
+
+      /* Diff each revision against the previous one on a separate thread,
+         while the next ones are still being received.  The merged
+         revisions need to be tracked in order, so we don't bother for
+         those.
+
+         Pools and their allocators must not be shared between threads,
+         so the blame chunks, which only the diff thread allocates while
+         it is running, go into a root pool of their own.  Its cleanup is
+         registered before the pipeline's, so it runs after the thread
+         has stopped. */
+      if (! include_merged_revisions)
+        {
+          apr_pool_t *chain_pool = svn_pool_create(NULL);
+
+          apr_pool_cleanup_register(pool, chain_pool, destroy_root_pool,
+                                    apr_pool_cleanup_null);
+          frb.pipeline = svn_pipeline__start(
+                           PIPELINE_DEPTH, 1, diff_queued,
+                           apr_pmemdup(pool, diff_options,
+                                       sizeof(*diff_options)),
+                           pool);
+          if (frb.pipeline)
+            frb.chain->pool = chain_pool;
+          else
+            apr_pool_cleanup_run(pool, chain_pool, destroy_root_pool);
+        }
+
+      err = svn_ra_get_file_revs2(ra_session, "",
+                                  start_revnum - (start_revnum > 0 ? 1 : 0),
+                                  end_revnum, include_merged_revisions,
+                                  file_rev_handler, &frb, pool);
+
+      if (frb.pipeline)
+        {
+          if (err)
+            svn_pipeline__close(frb.pipeline);
+          else
+            err = svn_pipeline__finish(frb.pipeline);
+        }
+      SVN_ERR(err);
+    }
 
   if (end->kind == svn_opt_revision_working)
     {
@@ -233,7 +233,17 @@ svn_client_get_changelists(const char *path,
   gnb.wc_ctx = ctx->wc_ctx;
   gnb.pool = pool;
   if (changelists)
-    SVN_ERR(svn_hash_from_cstring_keys(&(gnb.changelists), changelists, pool));
+    {
+      /* Look only at the nodes that are in a changelist. */
+      SVN_ERR(svn_hash_from_cstring_keys(&(gnb.changelists), changelists,
+                                         pool));
+      return svn_error_return(
+        svn_wc__get_changelist_members(ctx->wc_ctx, local_abspath, depth,
+                                       gnb.changelists,
+                                       callback_func, callback_baton,
+                                       ctx->cancel_func, ctx->cancel_baton,
+                                       pool));
+    }
   else
     gnb.changelists = NULL;
 
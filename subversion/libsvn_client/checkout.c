@@ -41,6 +41,7 @@
 #include "client.h"
 
 #include "private/svn_wc_private.h"
+#include "private/svn_client_private.h"
 
 #include "svn_private_config.h"
 
@@ -60,6 +61,7 @@ initialize_area(svn_revnum_t *result_rev,
                 svn_boolean_t ignore_externals,
                 svn_boolean_t allow_unver_obstructions,
                 svn_boolean_t innercheckout,
+                svn_boolean_t lazy,
                 svn_client_ctx_t *ctx,
                 apr_pool_t *pool)
 {
@@ -74,7 +76,7 @@ initialize_area(svn_revnum_t *result_rev,
                                     revision, depth, TRUE, ignore_externals,
                                     allow_unver_obstructions,
                                     use_sleep, FALSE, innercheckout,
-                                    ctx, pool));
+                                    lazy, ctx, pool));
 }
 
 
@@ -89,6 +91,7 @@ svn_client__checkout_internal(svn_revnum_t *result_rev,
                               svn_boolean_t ignore_externals,
                               svn_boolean_t allow_unver_obstructions,
                               svn_boolean_t innercheckout,
+                              svn_boolean_t lazy,
                               svn_boolean_t *timestamp_sleep,
                               svn_client_ctx_t *ctx,
                               apr_pool_t *pool)
@@ -189,7 +192,7 @@ svn_client__checkout_internal(svn_revnum_t *result_rev,
       err = initialize_area(result_rev, local_abspath, revision, session_url,
                             repos_root, uuid, revnum, depth, use_sleep,
                             ignore_externals, allow_unver_obstructions,
-                            innercheckout, ctx, pool);
+                            innercheckout, lazy, ctx, pool);
     }
   else if (kind == svn_node_dir)
     {
@@ -202,7 +205,7 @@ svn_client__checkout_internal(svn_revnum_t *result_rev,
           err = initialize_area(result_rev, local_abspath, revision, session_url,
                                 repos_root, uuid, revnum, depth, use_sleep,
                                 ignore_externals, allow_unver_obstructions,
-                                innercheckout, ctx, pool);
+                                innercheckout, lazy, ctx, pool);
         }
       else
         {
@@ -220,7 +223,7 @@ svn_client__checkout_internal(svn_revnum_t *result_rev,
                                                 ignore_externals,
                                                 allow_unver_obstructions,
                                                 use_sleep, FALSE, innercheckout,
-                                                ctx, pool);
+                                                lazy, ctx, pool);
             }
           else
             return svn_error_createf(
@@ -271,6 +274,27 @@ svn_client_checkout3(svn_revnum_t *result_rev,
   return svn_client__checkout_internal(result_rev, URL, local_abspath,
                                        peg_revision, revision, NULL, depth,
                                        ignore_externals,
-                                       allow_unver_obstructions, FALSE, NULL,
-                                       ctx, pool);
+                                       allow_unver_obstructions, FALSE, FALSE,
+                                       NULL, ctx, pool);
+}
+
+svn_error_t *
+svn_client__checkout_lazy(svn_revnum_t *result_rev,
+                          const char *URL,
+                          const char *path,
+                          const svn_opt_revision_t *peg_revision,
+                          const svn_opt_revision_t *revision,
+                          svn_depth_t depth,
+                          svn_boolean_t ignore_externals,
+                          svn_client_ctx_t *ctx,
+                          apr_pool_t *pool)
+{
+  const char *local_abspath;
+
+  SVN_ERR(svn_dirent_get_absolute(&local_abspath, path, pool));
+
+  return svn_client__checkout_internal(result_rev, URL, local_abspath,
+                                       peg_revision, revision, NULL, depth,
+                                       ignore_externals, FALSE, FALSE, TRUE,
+                                       NULL, ctx, pool);
 }
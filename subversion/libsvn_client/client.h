@@ -382,6 +382,11 @@ svn_client__default_walker_error_handler(const char *path,
    The calling application's authentication baton is provided in CTX,
    and allocations related to this session are performed in POOL.
 
+   If BASE_DIR_ABSPATH and COMMIT_ITEMS are NULL and CTX has a session
+   pool reachable from POOL, an idle session to the same repository is reused if there is
+   one, after reparenting it to BASE_URL.  Such a session is not closed
+   but handed back to the session pool when POOL is cleaned up.
+
    NOTE: The reason for the _internal suffix of this function's name is to
    avoid confusion with the public API svn_client_open_ra_session(). */
 svn_error_t *
@@ -394,6 +399,15 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
                                      svn_client_ctx_t *ctx,
                                      apr_pool_t *pool);
 
+/* Give CTX, which is allocated in POOL, a session pool: a set of idle
+   RA sessions kept for reuse by svn_client__open_ra_session_internal().
+   The session pool is stored as userdata of POOL, so only operations
+   allocating in POOL or one of its descendants find it.  The sessions
+   kept in it are closed when POOL is cleared or destroyed. */
+void
+svn_client__session_pool_attach(svn_client_ctx_t *ctx,
+                                apr_pool_t *pool);
+
 
 
 /* ---------------------------------------------------------------- */
@@ -522,6 +536,9 @@ svn_client__make_local_parents(const char *path,
    file.
 
    If INNERUPDATE is true, no anchor check is performed on the update target.
+
+   If LAZY is true, add files without their texts, which are fetched
+   later by svn_client__hydrate(); see svn_wc__get_lazy_update_editor().
 */
 svn_error_t *
 svn_client__update_internal(svn_revnum_t *result_rev,
@@ -534,6 +551,7 @@ svn_client__update_internal(svn_revnum_t *result_rev,
                             svn_boolean_t *timestamp_sleep,
                             svn_boolean_t send_copyfrom_args,
                             svn_boolean_t innerupdate,
+                            svn_boolean_t lazy,
                             svn_client_ctx_t *ctx,
                             apr_pool_t *pool);
 
@@ -599,6 +617,9 @@ typedef struct
    to fail.
 
    If INNERCHECKOUT is true, no anchor check is performed on the target.
+
+   If LAZY is true, check out the files without their texts, as for
+   svn_client__update_internal().
    */
 svn_error_t *
 svn_client__checkout_internal(svn_revnum_t *result_rev,
@@ -611,6 +632,7 @@ svn_client__checkout_internal(svn_revnum_t *result_rev,
                               svn_boolean_t ignore_externals,
                               svn_boolean_t allow_unver_obstructions,
                               svn_boolean_t innercheckout,
+                              svn_boolean_t lazy,
                               svn_boolean_t *timestamp_sleep,
                               svn_client_ctx_t *ctx,
                               apr_pool_t *pool);
@@ -70,6 +70,10 @@ typedef struct import_ctx_t
   /* Whether any changes were made to the repository */
   svn_boolean_t repos_changed;
 
+  /* The default ignore patterns, or NULL if nothing is to be ignored.
+     They are the same for every directory, so they are read once. */
+  apr_array_header_t *ignores;
+
 } import_ctx_t;
 
 
@@ -173,6 +177,9 @@ send_file_contents(const char *path,
  * Accumulate file paths and their batons in FILES, which must be
  * non-null.  (These are used to send postfix textdeltas later).
  *
+ * DIRENT is PATH's entry as read from its parent directory, or NULL
+ * if PATH has not been looked at yet.
+ *
  * If CTX->NOTIFY_FUNC is non-null, invoke it with CTX->NOTIFY_BATON
  * for each file.
  *
@@ -183,6 +190,7 @@ import_file(const svn_delta_editor_t *editor,
             void *dir_baton,
             const char *path,
             const char *edit_path,
+            const svn_io_dirent_t *dirent,
             import_ctx_t *import_ctx,
             svn_client_ctx_t *ctx,
             apr_pool_t *pool)
@@ -198,7 +206,11 @@ import_file(const svn_delta_editor_t *editor,
 
   SVN_ERR(svn_path_check_valid(path, pool));
 
-  SVN_ERR(svn_io_check_special_path(path, &kind, &is_special, pool));
+  /* The directory listing already told us whether this is special. */
+  if (dirent)
+    is_special = dirent->special;
+  else
+    SVN_ERR(svn_io_check_special_path(path, &kind, &is_special, pool));
 
   /* Add the file, using the pool from the FILES hash. */
   SVN_ERR(editor->add_file(edit_path, dir_baton, NULL, SVN_INVALID_REVNUM,
@@ -279,8 +291,7 @@ import_file(const svn_delta_editor_t *editor,
  * EXCLUDES is a hash whose keys are absolute paths to exclude from
  * the import (values are unused).
  *
- * If NO_IGNORE is FALSE, don't import files or directories that match
- * ignore patterns.
+ * Files or directories that match IMPORT_CTX->IGNORES are not imported.
  *
  * If CTX->NOTIFY_FUNC is non-null, invoke it with CTX->NOTIFY_BATON for each
  * directory.
@@ -293,7 +304,6 @@ import_dir(const svn_delta_editor_t *editor,
            const char *edit_path,
            svn_depth_t depth,
            apr_hash_t *excludes,
-           svn_boolean_t no_ignore,
            svn_boolean_t ignore_unknown_node_types,
            import_ctx_t *import_ctx,
            svn_client_ctx_t *ctx,
@@ -302,18 +312,19 @@ import_dir(const svn_delta_editor_t *editor,
   apr_pool_t *subpool = svn_pool_create(pool);  /* iteration pool */
   apr_hash_t *dirents;
   apr_hash_index_t *hi;
-  apr_array_header_t *ignores;
+  const char *dir_abspath = NULL;
 
   SVN_ERR(svn_path_check_valid(path, pool));
 
-  if (!no_ignore)
-    SVN_ERR(svn_wc_get_default_ignores(&ignores, ctx->config, pool));
+  /* Resolve the directory once rather than every entry in it. */
+  if (apr_hash_count(excludes))
+    SVN_ERR(svn_dirent_get_absolute(&dir_abspath, path, pool));
 
   SVN_ERR(svn_io_get_dirents2(&dirents, path, pool));
 
   for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
     {
-      const char *this_path, *this_edit_path, *abs_path;
+      const char *this_path, *this_edit_path;
       const char *filename = svn__apr_hash_index_key(hi);
       const svn_io_dirent_t *dirent = svn__apr_hash_index_val(hi);
 
@@ -352,12 +363,15 @@ import_dir(const svn_delta_editor_t *editor,
       this_edit_path = svn_dirent_join(edit_path, filename, subpool);
 
       /* If this is an excluded path, exclude it. */
-      SVN_ERR(svn_dirent_get_absolute(&abs_path, this_path, subpool));
-      if (apr_hash_get(excludes, abs_path, APR_HASH_KEY_STRING))
+      if (dir_abspath
+          && apr_hash_get(excludes,
+                          svn_dirent_join(dir_abspath, filename, subpool),
+                          APR_HASH_KEY_STRING))
         continue;
 
-      if ((!no_ignore) && svn_wc_match_ignore_list(filename, ignores,
-                                                   subpool))
+      if (import_ctx->ignores
+          && svn_wc_match_ignore_list(filename, import_ctx->ignores,
+                                      subpool))
         continue;
 
       if (dirent->kind == svn_node_dir && depth >= svn_depth_immediates)
@@ -397,8 +411,7 @@ import_dir(const svn_delta_editor_t *editor,
 
             SVN_ERR(import_dir(editor, this_dir_baton, this_path,
                                this_edit_path, depth_below_here, excludes,
-                               no_ignore, ignore_unknown_node_types,
-                               import_ctx, ctx,
+                               ignore_unknown_node_types, import_ctx, ctx,
                                subpool));
           }
 
@@ -408,7 +421,8 @@ import_dir(const svn_delta_editor_t *editor,
       else if (dirent->kind == svn_node_file && depth >= svn_depth_files)
         {
           SVN_ERR(import_file(editor, dir_baton, this_path,
-                              this_edit_path, import_ctx, ctx, subpool));
+                              this_edit_path, dirent, import_ctx, ctx,
+                              subpool));
         }
       else if (dirent->kind != svn_node_dir && dirent->kind != svn_node_file)
         {
@@ -489,11 +503,14 @@ import(const char *path,
 {
   void *root_baton;
   svn_node_kind_t kind;
-  apr_array_header_t *ignores;
   apr_array_header_t *batons = NULL;
   const char *edit_path = "";
   import_ctx_t *import_ctx = apr_pcalloc(pool, sizeof(*import_ctx));
 
+  if (!no_ignore)
+    SVN_ERR(svn_wc_get_default_ignores(&import_ctx->ignores, ctx->config,
+                                       pool));
+
   /* Get a root dir baton.  We pass an invalid revnum to open_root
      to mean "base this on the youngest revision".  Should we have an
      SVN_YOUNGEST_REVNUM defined for these purposes? */
@@ -550,20 +567,18 @@ import(const char *path,
     {
       svn_boolean_t ignores_match = FALSE;
 
-      if (!no_ignore)
-        {
-          SVN_ERR(svn_wc_get_default_ignores(&ignores, ctx->config, pool));
-          ignores_match = svn_wc_match_ignore_list(path, ignores, pool);
-        }
+      if (import_ctx->ignores)
+        ignores_match = svn_wc_match_ignore_list(path, import_ctx->ignores,
+                                                 pool);
       if (!ignores_match)
-        SVN_ERR(import_file(editor, root_baton, path, edit_path,
+        SVN_ERR(import_file(editor, root_baton, path, edit_path, NULL,
                             import_ctx, ctx, pool));
     }
   else if (kind == svn_node_dir)
     {
       SVN_ERR(import_dir(editor, root_baton, path, edit_path,
-                         depth, excludes, no_ignore,
-                         ignore_unknown_node_types, import_ctx, ctx, pool));
+                         depth, excludes, ignore_unknown_node_types,
+                         import_ctx, ctx, pool));
 
     }
   else if (kind == svn_node_none
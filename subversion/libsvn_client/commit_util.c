@@ -44,6 +44,7 @@
 
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_pipeline.h"
 
 /*** Uncomment this to turn on commit driver debugging. ***/
 /*
@@ -736,12 +737,21 @@ harvest_committables(apr_hash_t *committables,
           || (state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)))
     {
       const apr_array_header_t *children;
+      apr_hash_t *unmodified = NULL;
       apr_pool_t *iterpool = svn_pool_create(scratch_pool);
       int i;
 
       SVN_ERR(svn_wc__node_get_children(&children, ctx->wc_ctx, local_abspath,
                                         copy_mode, scratch_pool, iterpool));
 
+      /* Most files of a large working copy are unmodified.  Find them all
+         at once, rather than looking at each of them below.  In copy mode
+         every child is committable.  */
+      if (! copy_mode && ! adds_only)
+        SVN_ERR(svn_wc__node_get_unmodified_files(&unmodified, ctx->wc_ctx,
+                                                  local_abspath,
+                                                  scratch_pool, iterpool));
+
       /* Loop over all other entries in this directory, skipping the
          "this dir" entry. */
       for (i = 0; i < children->nelts; i++)
@@ -755,6 +765,10 @@ harvest_committables(apr_hash_t *committables,
 
           svn_pool_clear(iterpool);
 
+          if (unmodified
+              && apr_hash_get(unmodified, name, APR_HASH_KEY_STRING))
+            continue;
+
           /* Skip the excluded item. */
           SVN_ERR(svn_wc__node_get_depth(&this_depth, ctx->wc_ctx, this_abspath,
                                          iterpool));
@@ -1282,6 +1296,50 @@ struct file_mod_t
 };
 
 
+/* The number of text deltas that may be computed ahead of the one being
+   sent to the commit editor. */
+#define PIPELINE_DEPTH 4
+
+/* Implements svn_pipeline__process_t, computing the svn_wc__text_delta_t
+   ITEM.  Errors are kept with the delta, so this never stops the
+   pipeline. */
+static svn_error_t *
+compute_text_delta(void *baton,
+                   void *item,
+                   apr_pool_t *scratch_pool)
+{
+  svn_wc__text_delta_compute(item);
+  return SVN_NO_ERROR;
+}
+
+/* Prepare the text delta of MOD, with a copy of the working file if
+   WANT_TEMPFILE, and queue it on PIPELINE.  The delta that lived in its
+   slot before must have been sent already.  Use WC_CTX to access the
+   working copy. */
+static svn_error_t *
+queue_text_delta(svn_pipeline__t *pipeline,
+                 const struct file_mod_t *mod,
+                 svn_boolean_t want_tempfile,
+                 svn_wc_context_t *wc_ctx)
+{
+  apr_pool_t *delta_pool;
+  const char *item_abspath;
+  svn_wc__text_delta_t *delta;
+
+  SVN_ERR(svn_pipeline__next_slot(&delta_pool, pipeline));
+
+  SVN_ERR(svn_dirent_get_absolute(&item_abspath, mod->item->path,
+                                  delta_pool));
+  SVN_ERR(svn_wc__text_delta_prepare(
+            &delta, want_tempfile, TRUE, wc_ctx, item_abspath,
+            (mod->item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD) != 0,
+            delta_pool));
+
+  svn_pipeline__queue(pipeline, delta);
+  return SVN_NO_ERROR;
+}
+
+
 /* A baton for use with the path-based editor driver */
 struct path_driver_cb_baton
 {
@@ -1613,8 +1671,11 @@ svn_client__do_commit(const char *base_url,
   apr_hash_t *items_hash = apr_hash_make(pool);
   apr_pool_t *iterpool = svn_pool_create(pool);
   apr_hash_index_t *hi;
+  apr_array_header_t *mods;
   int i;
   struct path_driver_cb_baton cb_baton;
+  svn_pipeline__t *pipeline = NULL;
+  int queued = 0;
   apr_array_header_t *paths =
     apr_array_make(pool, commit_items->nelts, sizeof(const char *));
 
@@ -1662,9 +1723,21 @@ svn_client__do_commit(const char *base_url,
                                 paths, do_item_commit, &cb_baton, pool));
 
   /* Transmit outstanding text deltas. */
+  mods = apr_array_make(pool, apr_hash_count(file_mods),
+                        sizeof(struct file_mod_t *));
   for (hi = apr_hash_first(pool, file_mods); hi; hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(mods, struct file_mod_t *) = svn__apr_hash_index_val(hi);
+
+  /* Compute the deltas of the next few files on another thread while
+     sending this one.  The editor is still driven from this thread, in
+     the same order as without it. */
+  if (mods->nelts > 1)
+    pipeline = svn_pipeline__start(PIPELINE_DEPTH, 0, compute_text_delta,
+                                   NULL, pool);
+
+  for (i = 0; i < mods->nelts; i++)
     {
-      struct file_mod_t *mod = svn__apr_hash_index_val(hi);
+      struct file_mod_t *mod = APR_ARRAY_IDX(mods, i, struct file_mod_t *);
       const svn_client_commit_item3_t *item = mod->item;
       const char *tempfile;
       const svn_checksum_t *new_text_base_md5_checksum;
@@ -1680,6 +1753,14 @@ svn_client__do_commit(const char *base_url,
       if (ctx->cancel_func)
         SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
 
+      if (pipeline)
+        for (; queued < mods->nelts && queued < i + PIPELINE_DEPTH; queued++)
+          SVN_ERR(queue_text_delta(pipeline,
+                                   APR_ARRAY_IDX(mods, queued,
+                                                 struct file_mod_t *),
+                                   new_text_base_abspaths != NULL,
+                                   ctx->wc_ctx));
+
       if (ctx->notify_func2)
         {
           svn_wc_notify_t *notify;
@@ -1694,13 +1775,28 @@ svn_client__do_commit(const char *base_url,
       if (item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
         fulltext = TRUE;
 
-      SVN_ERR(svn_wc_transmit_text_deltas3(new_text_base_abspaths ? &tempfile
-                                                                  : NULL,
-                                           &new_text_base_md5_checksum,
-                                           &new_text_base_sha1_checksum,
-                                           ctx->wc_ctx, item_abspath,
-                                           fulltext, editor, mod->file_baton,
-                                           pool, iterpool));
+      if (pipeline)
+        {
+          void *delta;
+
+          SVN_ERR(svn_pipeline__wait(&delta, pipeline, i));
+          SVN_ERR(svn_wc__text_delta_send(new_text_base_abspaths ? &tempfile
+                                                                 : NULL,
+                                          &new_text_base_md5_checksum,
+                                          &new_text_base_sha1_checksum,
+                                          ctx->wc_ctx, delta,
+                                          editor, mod->file_baton,
+                                          pool, iterpool));
+        }
+      else
+        SVN_ERR(svn_wc_transmit_text_deltas3(new_text_base_abspaths
+                                               ? &tempfile : NULL,
+                                             &new_text_base_md5_checksum,
+                                             &new_text_base_sha1_checksum,
+                                             ctx->wc_ctx, item_abspath,
+                                             fulltext, editor,
+                                             mod->file_baton,
+                                             pool, iterpool));
       if (new_text_base_abspaths && tempfile)
         apr_hash_set(*new_text_base_abspaths, item->path, APR_HASH_KEY_STRING,
                      tempfile);
@@ -1712,6 +1808,9 @@ svn_client__do_commit(const char *base_url,
                      new_text_base_sha1_checksum);
     }
 
+  if (pipeline)
+    svn_pipeline__close(pipeline);
+
   svn_pool_destroy(iterpool);
 
   /* Close the edit. */
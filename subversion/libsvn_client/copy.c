@@ -1439,7 +1439,7 @@ repos_to_wc_copy_single(svn_client__copy_pair_t *pair,
                                             &pair->src_op_revision, NULL,
                                             svn_depth_infinity,
                                             ignore_externals, FALSE, TRUE,
-                                            NULL, ctx, pool));
+                                            FALSE, NULL, ctx, pool));
 
       /* Rewrite URLs recursively, remove wcprops, and mark everything
          as 'copied' -- assuming that the src and dst are from the
@@ -30,6 +30,7 @@
 #include <apr_pools.h>
 #include "svn_client.h"
 #include "svn_error.h"
+#include "client.h"
 
 
 /*** Code. ***/
@@ -55,5 +56,6 @@ svn_client_create_context(svn_client_ctx_t **ctx,
   SVN_ERR(svn_wc_context_create(&(*ctx)->wc_ctx, NULL /* config */, pool,
                                 pool));
   (*ctx)->notify_baton2 = *ctx;
+  svn_client__session_pool_attach(*ctx, pool);
   return SVN_NO_ERROR;
 }
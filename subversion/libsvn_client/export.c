@@ -584,6 +584,10 @@ struct file_baton
      thus flushing its output to disk so we can copy and translate it. */
   svn_stream_t *tmp_stream;
 
+  /* Set if the text written to TMPPATH has been EOL-translated already,
+     because svn:eol-style was known when the text delta came. */
+  svn_boolean_t tmp_translated;
+
   /* The MD5 digest of the file's fulltext.  This is all zeros until
      the last textdelta window handler call returns. */
   unsigned char text_digest[APR_MD5_DIGESTSIZE];
@@ -748,6 +752,21 @@ apply_textdelta(void *file_baton,
 {
   struct file_baton *fb = file_baton;
   struct handler_baton *hb = apr_palloc(pool, sizeof(*hb));
+  svn_stream_t *target;
+  const char *eol = NULL;
+  svn_boolean_t translate = FALSE;
+
+  /* If EOL translation is all the file needs, and we already know that,
+     translate the text on its way into the temporary file rather than
+     copying it once more in close_file(). */
+  if (fb->eol_style_val && ! fb->keywords_val && ! fb->special)
+    {
+      svn_subst_eol_style_t style;
+
+      SVN_ERR(get_eol_style(&style, &eol, fb->eol_style_val->data,
+                            fb->edit_baton->native_eol));
+      translate = TRUE;
+    }
 
   /* Create a temporary file in the same directory as the file. We're going
      to rename the thing into place when we're done. */
@@ -762,8 +781,17 @@ apply_textdelta(void *file_baton,
      close_file() function, so disown it here. */
   /* ### contrast to when we call svn_ra_get_file() which does NOT close the
      ### tmp_stream. we *should* be much more consistent! */
-  svn_txdelta_apply(svn_stream_empty(pool),
-                    svn_stream_disown(fb->tmp_stream, pool),
+  target = svn_stream_disown(fb->tmp_stream, pool);
+  if (translate)
+    {
+      target = svn_subst_stream_translated(target, eol, TRUE, NULL, TRUE,
+                                           pool);
+      fb->tmp_translated = TRUE;
+    }
+
+  /* The digest is taken before translation, so it still matches the
+     repository's checksum. */
+  svn_txdelta_apply(svn_stream_empty(pool), target,
                     fb->text_digest, NULL, pool,
                     &hb->apply_handler, &hb->apply_baton);
 
@@ -861,12 +889,16 @@ close_file(void *file_baton,
         }
     }
 
-  if ((! fb->eol_style_val) && (! fb->keywords_val) && (! fb->special))
+  if ((! fb->eol_style_val || fb->tmp_translated)
+      && (! fb->keywords_val) && (! fb->special))
     {
       SVN_ERR(svn_io_file_rename(fb->tmppath, fb->path, pool));
     }
   else
     {
+      /* If svn:keywords or svn:special only came after the text, the
+         temporary file may be EOL-translated already.  Translating it
+         again with REPAIR set gives the same result. */
       svn_subst_eol_style_t style;
       const char *eol = NULL;
       svn_boolean_t repair = FALSE;
@@ -1117,3 +1149,44 @@ svn_client_export5(svn_revnum_t *result_rev,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_client_export_archive(svn_revnum_t *result_rev,
+                          const char *from_url,
+                          const svn_opt_revision_t *peg_revision,
+                          const svn_opt_revision_t *revision,
+                          const char *prefix,
+                          svn_stream_t *stream,
+                          svn_client_ctx_t *ctx,
+                          apr_pool_t *pool)
+{
+  svn_ra_session_t *ra_session;
+  svn_revnum_t revnum;
+  const char *url;
+
+  SVN_ERR_ASSERT(peg_revision != NULL);
+  SVN_ERR_ASSERT(revision != NULL);
+
+  if (! svn_path_is_url(from_url))
+    return svn_error_createf(SVN_ERR_BAD_URL, NULL,
+                             _("'%s' is not a URL"), from_url);
+
+  peg_revision = svn_cl__rev_default_to_head_or_working(peg_revision,
+                                                        from_url);
+  revision = svn_cl__rev_default_to_peg(revision, peg_revision);
+
+  SVN_ERR(svn_client__ra_session_from_path(&ra_session, &revnum,
+                                           &url, from_url, NULL,
+                                           peg_revision,
+                                           revision, ctx, pool));
+
+  if (! prefix)
+    prefix = svn_path_uri_decode(svn_uri_basename(url, pool), pool);
+
+  SVN_ERR(svn_ra_get_archive(ra_session, "", revnum, prefix, stream, pool));
+
+  if (result_rev)
+    *result_rev = revnum;
+
+  return SVN_NO_ERROR;
+}
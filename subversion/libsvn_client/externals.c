@@ -28,6 +28,9 @@
 /*** Includes. ***/
 
 #include <apr_uri.h>
+#include <apr_strings.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
 #include "svn_wc.h"
 #include "svn_pools.h"
 #include "svn_client.h"
@@ -37,10 +40,13 @@
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
 #include "svn_config.h"
+#include "svn_sorts.h"
 #include "client.h"
 
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_auth_private.h"
+#include "private/svn_config_private.h"
 
 
 /* Closure for handle_external_item_change. */
@@ -65,6 +71,12 @@ struct handle_external_item_change_baton
   svn_boolean_t *timestamp_sleep;
   svn_boolean_t is_export;
 
+  /* If DEFER_FILE_EXTERNALS is set, file externals are not handled but
+     only flagged by setting DEFERRED, because they modify the working
+     copy of their parent directory and that is in use elsewhere. */
+  svn_boolean_t defer_file_externals;
+  svn_boolean_t deferred;
+
   /* A long lived pool.  Put anything in here that needs to outlive
      the hash diffing callback, such as updates to the hash
      entries. */
@@ -202,7 +214,7 @@ switch_dir_external(const char *path,
                                                   revision, svn_depth_unknown,
                                                   FALSE, FALSE, FALSE,
                                                   timestamp_sleep, TRUE,
-                                                  TRUE, ctx, subpool));
+                                                  TRUE, FALSE, ctx, subpool));
               svn_pool_destroy(subpool);
               return SVN_NO_ERROR;
             }
@@ -289,8 +301,8 @@ switch_dir_external(const char *path,
   /* ... Hello, new hotness. */
   return svn_client__checkout_internal(NULL, url, local_abspath, peg_revision,
                                        revision, NULL, svn_depth_infinity,
-                                       FALSE, FALSE, TRUE, timestamp_sleep,
-                                       ctx, pool);
+                                       FALSE, FALSE, TRUE, FALSE,
+                                       timestamp_sleep, ctx, pool);
 }
 
 /* Try to update a file external at PATH to URL at REVISION using a
@@ -811,6 +823,14 @@ handle_external_item_change(const void *key, apr_ssize_t klen,
                                  ra_cache.ra_revnum);
 
       ra_cache.kind_p = &kind;
+
+      if (ib->defer_file_externals && svn_node_file == kind
+          && ! ib->is_export)
+        {
+          ib->deferred = TRUE;
+          svn_pool_clear(ib->iter_pool);
+          return SVN_NO_ERROR;
+        }
     }
 
   /* Not protecting against recursive externals.  Detecting them in
@@ -862,7 +882,7 @@ handle_external_item_change(const void *key, apr_ssize_t klen,
                      &(new_item->peg_revision), &(new_item->revision),
                      &ra_cache,
                      SVN_DEPTH_INFINITY_OR_FILES(TRUE),
-                     FALSE, FALSE, TRUE, ib->timestamp_sleep, ib->ctx,
+                     FALSE, FALSE, TRUE, FALSE, ib->timestamp_sleep, ib->ctx,
                      ib->iter_pool));
           break;
         case svn_node_file:
@@ -1067,10 +1087,452 @@ struct handle_externals_desc_change_baton
   svn_boolean_t *timestamp_sleep;
   svn_boolean_t is_export;
 
+  /* If externals are to be fetched concurrently, the external_job_t *
+     queued for handle_externals_concurrently(), and the number of
+     threads to use for them.  JOBS is NULL otherwise. */
+  apr_array_header_t *jobs;
+  int parallelism;
+
   apr_pool_t *pool;
 };
 
 
+#if APR_HAS_THREADS
+/* An external queued for handle_externals_concurrently(). */
+typedef struct external_job_t
+{
+  /* The arguments of handle_external_item_change_wrapper().  A worker
+     thread gets a copy of the baton of the externals description with
+     a client context and pools of its own. */
+  const char *target_dir;
+  enum svn_hash_diff_key_status status;
+  struct handle_external_item_change_baton ib;
+
+  /* The absolute path of the external. */
+  const char *local_abspath;
+
+  /* Set if the external has to be handled by the main thread, because
+     it is being removed or because it is nested in another one. */
+  svn_boolean_t serial;
+
+  /* Set once a worker thread has handled the external, and the error
+     it returned, which can only be a cancellation. */
+  svn_boolean_t done;
+  svn_error_t *err;
+
+  /* The notifications sent by the worker thread, to be passed on to
+     the caller in order once all workers are done, or NULL if the
+     caller doesn't want notifications. */
+  apr_array_header_t *notifications;
+
+  /* Where the worker thread records whether to sleep for timestamps. */
+  svn_boolean_t timestamp_sleep;
+
+  /* The state shared between all jobs. */
+  struct external_jobs_t *shared;
+
+  /* A root pool for the worker thread, or NULL for serial jobs. */
+  apr_pool_t *pool;
+} external_job_t;
+
+/* State shared by the worker threads of handle_externals_concurrently(). */
+typedef struct external_jobs_t
+{
+  /* The external_job_t * to handle, in the order of the externals
+     descriptions, and the index of the next one to look at. */
+  apr_array_header_t *jobs;
+  int next_job;
+
+  /* Set once a job has been cancelled; no further jobs are started. */
+  svn_boolean_t cancelled;
+
+  /* The context of the caller.  Its callbacks are called with MUTEX
+     held. */
+  svn_client_ctx_t *ctx;
+
+  /* Protects the members above. */
+  apr_thread_mutex_t *mutex;
+} external_jobs_t;
+
+/* Implements svn_wc_notify_func2_t.  Record a copy of NOTIFY in the
+   external_job_t BATON. */
+static void
+collect_notification(void *baton,
+                     const svn_wc_notify_t *notify,
+                     apr_pool_t *pool)
+{
+  external_job_t *job = baton;
+
+  APR_ARRAY_PUSH(job->notifications, svn_wc_notify_t *)
+    = svn_wc_dup_notify(notify, job->pool);
+}
+
+/* Implements svn_ra_progress_notify_func_t.  Pass the progress on to
+   the caller of the external_jobs_t BATON, one thread at a time. */
+static void
+locked_progress_func(apr_off_t progress,
+                     apr_off_t total,
+                     void *baton,
+                     apr_pool_t *pool)
+{
+  external_jobs_t *shared = baton;
+
+  if (apr_thread_mutex_lock(shared->mutex))
+    return;
+
+  shared->ctx->progress_func(progress, total, shared->ctx->progress_baton,
+                             pool);
+  apr_thread_mutex_unlock(shared->mutex);
+}
+
+/* Implements svn_wc_conflict_resolver_func_t.  Ask the caller of the
+   external_jobs_t BATON to resolve the conflict, one thread at a time. */
+static svn_error_t *
+locked_conflict_func(svn_wc_conflict_result_t **result,
+                     const svn_wc_conflict_description_t *description,
+                     void *baton,
+                     apr_pool_t *pool)
+{
+  external_jobs_t *shared = baton;
+  apr_status_t status;
+  svn_error_t *err;
+
+  status = apr_thread_mutex_lock(shared->mutex);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't lock externals mutex"));
+
+  err = shared->ctx->conflict_func(result, description,
+                                   shared->ctx->conflict_baton, pool);
+  apr_thread_mutex_unlock(shared->mutex);
+
+  return svn_error_return(err);
+}
+
+/* Prepare JOB to be handled by a worker thread: give it a root pool and
+   a client context of its own, using the read-only configuration hash
+   CONFIG (which may be NULL).  Callbacks that can't be called from
+   several threads at once are replaced with ones that buffer or
+   serialize the calls. */
+static svn_error_t *
+init_external_job(external_job_t *job,
+                  apr_hash_t *config)
+{
+  svn_client_ctx_t *ctx;
+  svn_config_t *cfg = config ? apr_hash_get(config,
+                                            SVN_CONFIG_CATEGORY_CONFIG,
+                                            APR_HASH_KEY_STRING)
+                             : NULL;
+
+  job->pool = svn_pool_create(NULL);
+
+  ctx = apr_pmemdup(job->pool, job->shared->ctx, sizeof(*ctx));
+  ctx->config = config;
+  /* Being a copy, CTX doesn't find the session pool of the shared
+     context, which isn't thread-safe. */
+  SVN_ERR(svn_wc_context_create(&ctx->wc_ctx, cfg, job->pool, job->pool));
+  if (ctx->auth_baton)
+    SVN_ERR(svn_auth__make_thread_baton(&ctx->auth_baton, ctx->auth_baton,
+                                        job->pool));
+
+  ctx->notify_func = NULL;
+  ctx->notify_baton = NULL;
+  if (ctx->notify_func2)
+    {
+      job->notifications = apr_array_make(job->pool, 16,
+                                          sizeof(svn_wc_notify_t *));
+      ctx->notify_func2 = collect_notification;
+      ctx->notify_baton2 = job;
+    }
+
+  if (ctx->progress_func)
+    {
+      ctx->progress_func = locked_progress_func;
+      ctx->progress_baton = job->shared;
+    }
+
+  if (ctx->conflict_func)
+    {
+      ctx->conflict_func = locked_conflict_func;
+      ctx->conflict_baton = job->shared;
+    }
+
+  job->ib.ctx = ctx;
+  if (job->ib.timestamp_sleep)
+    job->ib.timestamp_sleep = &job->timestamp_sleep;
+  job->ib.defer_file_externals = TRUE;
+  job->ib.pool = job->pool;
+  job->ib.iter_pool = svn_pool_create(job->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function handling the jobs in the external_jobs_t DATA that
+   are not serial, until none are left or one was cancelled. */
+static void * APR_THREAD_FUNC
+external_worker(apr_thread_t *thread, void *data)
+{
+  external_jobs_t *shared = data;
+
+  while (TRUE)
+    {
+      external_job_t *job = NULL;
+
+      /* Fetch the next job, unless somebody else has been cancelled. */
+      if (apr_thread_mutex_lock(shared->mutex))
+        break;
+      while (! shared->cancelled && shared->next_job < shared->jobs->nelts)
+        {
+          job = APR_ARRAY_IDX(shared->jobs, shared->next_job++,
+                              external_job_t *);
+          if (! job->serial)
+            break;
+          job = NULL;
+        }
+      apr_thread_mutex_unlock(shared->mutex);
+
+      if (! job)
+        break;
+
+      job->err = handle_external_item_change_wrapper(job->target_dir,
+                                                     APR_HASH_KEY_STRING,
+                                                     job->status, &job->ib);
+      job->done = TRUE;
+      if (job->err)
+        {
+          apr_thread_mutex_lock(shared->mutex);
+          shared->cancelled = TRUE;
+          apr_thread_mutex_unlock(shared->mutex);
+        }
+    }
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Handle the externals queued in CB->JOBS.  Externals that are neither
+   being removed nor nested in one another are checked out or updated
+   by up to CB->PARALLELISM threads, each with its own working copy
+   context and RA sessions.  Everything else is handled by this thread
+   afterwards.  The caller's notification callback sees the externals
+   in the same order as if they had been handled one by one. */
+static svn_error_t *
+handle_externals_concurrently(struct handle_externals_desc_change_baton *cb)
+{
+  apr_array_header_t *jobs = cb->jobs;
+  external_jobs_t shared = { 0 };
+  apr_thread_t **threads = NULL;
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
+  int concurrent = 0;
+  int started = 0;
+  int i, j;
+
+  /* An external inside another one has to wait for that to be done. */
+  for (i = 0; i < jobs->nelts; i++)
+    {
+      external_job_t *job = APR_ARRAY_IDX(jobs, i, external_job_t *);
+
+      for (j = i + 1; j < jobs->nelts; j++)
+        {
+          external_job_t *other = APR_ARRAY_IDX(jobs, j, external_job_t *);
+
+          if (svn_dirent_is_ancestor(job->local_abspath, other->local_abspath)
+              || svn_dirent_is_ancestor(other->local_abspath,
+                                        job->local_abspath))
+            job->serial = other->serial = TRUE;
+        }
+    }
+
+  for (i = 0; i < jobs->nelts; i++)
+    if (! APR_ARRAY_IDX(jobs, i, external_job_t *)->serial)
+      ++concurrent;
+
+  if (concurrent > 1)
+    {
+      apr_hash_t *config = NULL;
+      apr_status_t status;
+      int threads_wanted = MIN(cb->parallelism, concurrent);
+
+      /* The workers share a read-only copy of the configuration, which
+         also keeps them from fetching nested externals concurrently. */
+      if (cb->ctx->config)
+        {
+          apr_hash_index_t *hi;
+
+          config = apr_hash_make(cb->pool);
+          for (hi = apr_hash_first(cb->pool, cb->ctx->config);
+               hi;
+               hi = apr_hash_next(hi))
+            {
+              const char *category = svn__apr_hash_index_key(hi);
+              svn_config_t *cfg = svn__apr_hash_index_val(hi);
+
+              if (cfg)
+                {
+                  cfg = svn_config__dup(cfg, cb->pool);
+                  if (strcmp(category, SVN_CONFIG_CATEGORY_CONFIG) == 0)
+                    svn_config_set(cfg, SVN_CONFIG_SECTION_MISCELLANY,
+                                   SVN_CONFIG_OPTION_PARALLEL_EXTERNALS, "1");
+                  svn_config__set_read_only(cfg, cb->pool);
+                }
+              apr_hash_set(config, category, APR_HASH_KEY_STRING, cfg);
+            }
+        }
+
+      shared.jobs = jobs;
+      shared.ctx = cb->ctx;
+      status = apr_thread_mutex_create(&shared.mutex,
+                                       APR_THREAD_MUTEX_DEFAULT, cb->pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create externals mutex"));
+
+      for (i = 0; i < jobs->nelts && ! err; i++)
+        {
+          external_job_t *job = APR_ARRAY_IDX(jobs, i, external_job_t *);
+
+          job->shared = &shared;
+          if (! job->serial)
+            err = init_external_job(job, config);
+        }
+
+      /* Failing to start a thread is not fatal: whatever has not been
+         done by the workers is handled by this thread below. */
+      if (! err)
+        {
+          threads = apr_pcalloc(cb->pool, threads_wanted * sizeof(*threads));
+          for (started = 0; started < threads_wanted; ++started)
+            if (apr_thread_create(&threads[started], NULL, external_worker,
+                                  &shared, cb->pool))
+              break;
+        }
+
+      for (i = 0; i < started; ++i)
+        {
+          apr_status_t retval;
+          apr_thread_join(&retval, threads[i]);
+        }
+    }
+
+  /* Pass the notifications of the workers on and handle the remaining
+     externals, all in the original order. */
+  iterpool = svn_pool_create(cb->pool);
+  for (i = 0; i < jobs->nelts && ! err; i++)
+    {
+      external_job_t *job = APR_ARRAY_IDX(jobs, i, external_job_t *);
+
+      svn_pool_clear(iterpool);
+
+      if (job->done && ! job->ib.deferred)
+        {
+          for (j = 0; job->notifications && j < job->notifications->nelts; j++)
+            cb->ctx->notify_func2(cb->ctx->notify_baton2,
+                                  APR_ARRAY_IDX(job->notifications, j,
+                                                svn_wc_notify_t *),
+                                  iterpool);
+
+          if (job->timestamp_sleep)
+            *cb->timestamp_sleep = TRUE;
+
+          err = job->err;
+          job->err = NULL;
+        }
+      else
+        {
+          job->ib.ctx = cb->ctx;
+          job->ib.timestamp_sleep = cb->timestamp_sleep;
+          job->ib.defer_file_externals = FALSE;
+          job->ib.pool = cb->pool;
+          job->ib.iter_pool = iterpool;
+
+          err = handle_external_item_change_wrapper(job->target_dir,
+                                                    APR_HASH_KEY_STRING,
+                                                    job->status, &job->ib);
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  for (i = 0; i < jobs->nelts; i++)
+    {
+      external_job_t *job = APR_ARRAY_IDX(jobs, i, external_job_t *);
+
+      svn_error_clear(job->err);
+      if (job->pool)
+        svn_pool_destroy(job->pool);
+    }
+
+  return svn_error_return(err);
+}
+#endif
+
+/* Handle the change STATUS of the external TARGET_DIR of the externals
+   description IB, or queue it in CB->JOBS if externals are to be
+   fetched concurrently. */
+static svn_error_t *
+handle_or_queue_external(struct handle_externals_desc_change_baton *cb,
+                         struct handle_external_item_change_baton *ib,
+                         const char *target_dir,
+                         enum svn_hash_diff_key_status status)
+{
+#if APR_HAS_THREADS
+  if (cb->jobs)
+    {
+      external_job_t *job = apr_pcalloc(cb->pool, sizeof(*job));
+
+      job->target_dir = target_dir;
+      job->status = status;
+      job->ib = *ib;
+      job->local_abspath = svn_dirent_join(ib->parent_dir_abspath,
+                                           target_dir, cb->pool);
+      job->serial = (status == svn_hash_diff_key_a);
+
+      APR_ARRAY_PUSH(cb->jobs, external_job_t *) = job;
+      return SVN_NO_ERROR;
+    }
+#endif
+
+  return svn_error_return(
+           handle_external_item_change_wrapper(target_dir,
+                                               APR_HASH_KEY_STRING,
+                                               status, ib));
+}
+
+/* Read the number of externals to fetch at the same time from the
+   configuration of CB->CTX, and prepare CB->JOBS if that is more than
+   one. */
+static svn_error_t *
+init_parallelism(struct handle_externals_desc_change_baton *cb)
+{
+#if APR_HAS_THREADS
+  svn_config_t *cfg = cb->ctx->config
+                        ? apr_hash_get(cb->ctx->config,
+                                       SVN_CONFIG_CATEGORY_CONFIG,
+                                       APR_HASH_KEY_STRING)
+                        : NULL;
+  const char *value;
+  char *end;
+  apr_int64_t parallelism;
+
+  svn_config_get(cfg, &value, SVN_CONFIG_SECTION_MISCELLANY,
+                 SVN_CONFIG_OPTION_PARALLEL_EXTERNALS, "1");
+
+  parallelism = apr_strtoi64(value, &end, 10);
+  if (*end || parallelism < 1)
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("Config error: invalid value '%s' for "
+                               "option '%s'"),
+                             value, SVN_CONFIG_OPTION_PARALLEL_EXTERNALS);
+
+  if (parallelism > 1)
+    {
+      cb->parallelism = (int)MIN(parallelism, 64);
+      cb->jobs = apr_array_make(cb->pool, 16, sizeof(external_job_t *));
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+
 /* This implements the 'svn_hash_diff_func_t' interface.
    BATON is of type 'struct handle_externals_desc_change_baton *'.
 */
@@ -1202,24 +1664,18 @@ handle_externals_desc_change(const void *key, apr_ssize_t klen,
       item = APR_ARRAY_IDX(old_desc, i, svn_wc_external_item2_t *);
 
       if (apr_hash_get(new_desc_hash, item->target_dir, APR_HASH_KEY_STRING))
-        SVN_ERR(handle_external_item_change_wrapper(item->target_dir,
-                                                    APR_HASH_KEY_STRING,
-                                                    svn_hash_diff_key_both,
-                                                    &ib));
+        SVN_ERR(handle_or_queue_external(cb, &ib, item->target_dir,
+                                         svn_hash_diff_key_both));
       else
-        SVN_ERR(handle_external_item_change_wrapper(item->target_dir,
-                                                    APR_HASH_KEY_STRING,
-                                                    svn_hash_diff_key_a,
-                                                    &ib));
+        SVN_ERR(handle_or_queue_external(cb, &ib, item->target_dir,
+                                         svn_hash_diff_key_a));
     }
   for (i = 0; new_desc && (i < new_desc->nelts); i++)
     {
       item = APR_ARRAY_IDX(new_desc, i, svn_wc_external_item2_t *);
       if (! apr_hash_get(old_desc_hash, item->target_dir, APR_HASH_KEY_STRING))
-        SVN_ERR(handle_external_item_change_wrapper(item->target_dir,
-                                                    APR_HASH_KEY_STRING,
-                                                    svn_hash_diff_key_b,
-                                                    &ib));
+        SVN_ERR(handle_or_queue_external(cb, &ib, item->target_dir,
+                                         svn_hash_diff_key_b));
     }
 
   /* Now destroy the subpool we pass to the hash differ.  This will
@@ -1263,8 +1719,16 @@ svn_client__handle_externals(apr_hash_t *externals_old,
   cb.is_export         = FALSE;
   cb.pool              = pool;
 
-  return svn_hash_diff(cb.externals_old, cb.externals_new,
-                       handle_externals_desc_change, &cb, pool);
+  SVN_ERR(init_parallelism(&cb));
+  SVN_ERR(svn_hash_diff(cb.externals_old, cb.externals_new,
+                        handle_externals_desc_change, &cb, pool));
+
+#if APR_HAS_THREADS
+  if (cb.jobs)
+    SVN_ERR(handle_externals_concurrently(&cb));
+#endif
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -1295,8 +1759,16 @@ svn_client__fetch_externals(apr_hash_t *externals,
   cb.is_export         = is_export;
   cb.pool              = pool;
 
-  return svn_hash_diff(cb.externals_old, cb.externals_new,
-                       handle_externals_desc_change, &cb, pool);
+  SVN_ERR(init_parallelism(&cb));
+  SVN_ERR(svn_hash_diff(cb.externals_old, cb.externals_new,
+                        handle_externals_desc_change, &cb, pool));
+
+#if APR_HAS_THREADS
+  if (cb.jobs)
+    SVN_ERR(handle_externals_concurrently(&cb));
+#endif
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -0,0 +1,132 @@
+/*
+ * hydrate.c:  fetch the texts left out by a lazy checkout
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include "svn_wc.h"
+#include "svn_client.h"
+#include "svn_dirent_uri.h"
+#include "svn_pools.h"
+#include "client.h"
+
+#include "svn_private_config.h"
+#include "private/svn_wc_private.h"
+#include "private/svn_client_private.h"
+
+
+/*** Code. ***/
+
+/* Baton for hydrate_locked() and fetch_text(). */
+struct hydrate_baton
+{
+  const char *local_abspath;
+  svn_depth_t depth;
+  svn_ra_session_t *session;   /* opened at the repository root */
+  svn_client_ctx_t *ctx;
+};
+
+/* Implements svn_wc_get_file_t, fetching REPOS_RELPATH through the
+   session of BATON, a struct hydrate_baton. */
+static svn_error_t *
+fetch_text(void *baton,
+           const char *repos_relpath,
+           svn_revnum_t revision,
+           svn_stream_t *stream,
+           svn_revnum_t *fetched_rev,
+           apr_hash_t **props,
+           apr_pool_t *pool)
+{
+  struct hydrate_baton *hb = baton;
+
+  return svn_ra_get_file(hb->session, repos_relpath, revision, stream,
+                         fetched_rev, props, pool);
+}
+
+/* Implements svn_wc__with_write_lock_func_t. */
+static svn_error_t *
+hydrate_locked(void *baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  struct hydrate_baton *hb = baton;
+
+  return svn_wc__hydrate(hb->ctx->wc_ctx, hb->local_abspath, hb->depth,
+                         fetch_text, hb,
+                         hb->ctx->cancel_func, hb->ctx->cancel_baton,
+                         hb->ctx->notify_func2, hb->ctx->notify_baton2,
+                         scratch_pool);
+}
+
+svn_error_t *
+svn_client__hydrate(const apr_array_header_t *paths,
+                    svn_depth_t depth,
+                    svn_client_ctx_t *ctx,
+                    apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      const char *repos_root;
+      struct hydrate_baton hb;
+
+      svn_pool_clear(iterpool);
+
+      if (ctx->cancel_func)
+        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+
+      SVN_ERR(svn_dirent_get_absolute(&hb.local_abspath, path, iterpool));
+      SVN_ERR(svn_wc__node_get_repos_info(&repos_root, NULL, ctx->wc_ctx,
+                                          hb.local_abspath, TRUE, TRUE,
+                                          iterpool, iterpool));
+      if (! repos_root)
+        return svn_error_createf(SVN_ERR_ENTRY_MISSING_URL, NULL,
+                                 _("'%s' has no URL"),
+                                 svn_dirent_local_style(path, iterpool));
+
+      SVN_ERR(svn_client__open_ra_session_internal(&hb.session, repos_root,
+                                                   NULL, NULL, FALSE, TRUE,
+                                                   ctx, iterpool));
+      hb.depth = depth;
+      hb.ctx = ctx;
+
+      err = svn_wc__call_with_write_lock(hydrate_locked, &hb, ctx->wc_ctx,
+                                         hb.local_abspath,
+                                         iterpool, iterpool);
+
+      /* Working files were installed with their current time. */
+      svn_io_sleep_for_timestamps(hb.local_abspath, iterpool);
+      if (err)
+        break;
+    }
+
+  svn_pool_destroy(iterpool);
+  return svn_error_return(err);
+}
@@ -26,89 +26,50 @@
 #include "svn_path.h"
 #include "svn_pools.h"
 #include "svn_time.h"
-#include "svn_sorts.h"
 #include "svn_props.h"
 
 #include "client.h"
 
 #include "svn_private_config.h"
 
-/* Get the directory entries of DIR at REV (relative to the root of
-   RA_SESSION), getting at least the fields specified by DIRENT_FIELDS.
-   Use the cancellation function/baton of CTX to check for cancellation.
+/* Baton for list_receiver(). */
+typedef struct list_baton_t
+{
+  /* A hash mapping const char * paths to svn_lock_t objects, or NULL. */
+  apr_hash_t *locks;
+
+  /* The absolute filesystem path of the RA session. */
+  const char *fs_path;
 
-   If DEPTH is svn_depth_empty, return immediately.  If DEPTH is
-   svn_depth_files, invoke LIST_FUNC on the file entries with BATON;
-   if svn_depth_immediates, invoke it on file and directory entries;
-   if svn_depth_infinity, invoke it on file and directory entries and
-   recurse into the directory entries with the same depth.
+  svn_client_ctx_t *ctx;
+  svn_client_list_func_t list_func;
+  void *baton;
+} list_baton_t;
 
-   LOCKS, if non-NULL, is a hash mapping const char * paths to svn_lock_t
-   objects and FS_PATH is the absolute filesystem path of the RA session.
-   Use POOL for temporary allocations.
-*/
+/* Implements svn_ra_dirent_receiver_t.  Pass the entry on to the
+   list_func of the list_baton_t BATON, along with its lock. */
 static svn_error_t *
-get_dir_contents(apr_uint32_t dirent_fields,
-                 const char *dir,
-                 svn_revnum_t rev,
-                 svn_ra_session_t *ra_session,
-                 apr_hash_t *locks,
-                 const char *fs_path,
-                 svn_depth_t depth,
-                 svn_client_ctx_t *ctx,
-                 svn_client_list_func_t list_func,
-                 void *baton,
-                 apr_pool_t *pool)
+list_receiver(const char *path,
+              svn_dirent_t *dirent,
+              void *baton,
+              apr_pool_t *scratch_pool)
 {
-  apr_hash_t *tmpdirents;
-  apr_pool_t *iterpool = svn_pool_create(pool);
-  apr_array_header_t *array;
-  int i;
-
-  if (depth == svn_depth_empty)
-    return SVN_NO_ERROR;
+  list_baton_t *lb = baton;
+  svn_lock_t *lock;
 
-  /* Get the directory's entries, but not its props. */
-  SVN_ERR(svn_ra_get_dir2(ra_session, &tmpdirents, NULL, NULL,
-                          dir, rev, dirent_fields, pool));
+  if (lb->ctx->cancel_func)
+    SVN_ERR(lb->ctx->cancel_func(lb->ctx->cancel_baton));
 
-  if (ctx->cancel_func)
-    SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
-
-  /* Sort the hash, so we can call the callback in a "deterministic" order. */
-  array = svn_sort__hash(tmpdirents, svn_sort_compare_items_lexically, pool);
-  for (i = 0; i < array->nelts; ++i)
+  if (lb->locks)
     {
-      svn_sort__item_t *item = &APR_ARRAY_IDX(array, i, svn_sort__item_t);
-      const char *path;
-      svn_dirent_t *the_ent = apr_hash_get(tmpdirents, item->key, item->klen);
-      svn_lock_t *lock;
-
-      svn_pool_clear(iterpool);
-
-      path = svn_relpath_join(dir, item->key, iterpool);
-
-      if (locks)
-        {
-          const char *abs_path = svn_uri_join(fs_path, path, iterpool);
-          lock = apr_hash_get(locks, abs_path, APR_HASH_KEY_STRING);
-        }
-      else
-        lock = NULL;
-
-      if (the_ent->kind == svn_node_file
-          || depth == svn_depth_immediates
-          || depth == svn_depth_infinity)
-        SVN_ERR(list_func(baton, path, the_ent, lock, fs_path, iterpool));
-
-      if (depth == svn_depth_infinity && the_ent->kind == svn_node_dir)
-        SVN_ERR(get_dir_contents(dirent_fields, path, rev,
-                                 ra_session, locks, fs_path, depth, ctx,
-                                 list_func, baton, iterpool));
+      const char *abs_path = svn_uri_join(lb->fs_path, path, scratch_pool);
+      lock = apr_hash_get(lb->locks, abs_path, APR_HASH_KEY_STRING);
     }
+  else
+    lock = NULL;
 
-  svn_pool_destroy(iterpool);
-  return SVN_NO_ERROR;
+  return lb->list_func(lb->baton, path, dirent, lock, lb->fs_path,
+                       scratch_pool);
 }
 
 svn_error_t *
@@ -268,8 +229,19 @@ svn_client_list2(const char *path_or_url,
       && (depth == svn_depth_files
           || depth == svn_depth_immediates
           || depth == svn_depth_infinity))
-    SVN_ERR(get_dir_contents(dirent_fields, "", rev, ra_session, locks,
-                             fs_path, depth, ctx, list_func, baton, pool));
+    {
+      list_baton_t lb;
+
+      lb.locks = locks;
+      lb.fs_path = fs_path;
+      lb.ctx = ctx;
+      lb.list_func = list_func;
+      lb.baton = baton;
+
+      /* Fetch the whole tree at once, where the RA layer supports it. */
+      SVN_ERR(svn_ra_list(ra_session, "", rev, depth, dirent_fields,
+                          list_receiver, &lb, pool));
+    }
 
   return SVN_NO_ERROR;
 }
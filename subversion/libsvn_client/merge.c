@@ -4076,6 +4076,198 @@ find_gaps_in_merge_source_history(svn_revnum_t *gap_start,
   return SVN_NO_ERROR;
 }
 
+/* A group of children of the merge target, all at the same base revision,
+   whose inherited mergeinfo is to be fetched from the repository. */
+typedef struct repos_mergeinfo_request_t
+{
+  svn_revnum_t revision;
+
+  /* Repository root-relative paths of the children (const char *). */
+  apr_array_header_t *rel_paths;
+
+  /* The children themselves (svn_client__merge_path_t *), parallel
+     to REL_PATHS. */
+  apr_array_header_t *children;
+} repos_mergeinfo_request_t;
+
+/* Helper for populate_remaining_ranges().
+
+   Set the PRE_MERGE_MERGEINFO and INDIRECT_MERGEINFO members of each
+   child in CHILDREN_WITH_MERGEINFO that is not absent, exactly as
+   get_full_mergeinfo() with svn_mergeinfo_inherited would.
+
+   get_full_mergeinfo() opens a new RA session and makes a request of its
+   own for every child whose mergeinfo cannot be found in the working
+   copy.  Instead ask for all such children at the same base revision in
+   a single request, over RA_SESSION temporarily pointed at the repository
+   root REPOS_ROOT_URL.  If such a request fails, fall back to asking for
+   its children one at a time so that any error is reported as before.
+
+   Allocate the mergeinfo in RESULT_POOL. */
+static svn_error_t *
+get_children_recorded_mergeinfo(apr_array_header_t *children_with_mergeinfo,
+                                const char *repos_root_url,
+                                svn_ra_session_t *ra_session,
+                                svn_client_ctx_t *ctx,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  apr_hash_t *requests = apr_hash_make(scratch_pool);
+  apr_hash_index_t *hi;
+  const char *old_session_url;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* Look in the working copy first, just like
+     svn_client__get_wc_or_repos_mergeinfo(), and note which children
+     need the repository. */
+  for (i = 0; i < children_with_mergeinfo->nelts; i++)
+    {
+      svn_client__merge_path_t *child =
+        APR_ARRAY_IDX(children_with_mergeinfo, i, svn_client__merge_path_t *);
+      svn_mergeinfo_catalog_t wc_catalog;
+      svn_boolean_t is_added;
+      apr_hash_t *original_props;
+      const char *url;
+      svn_revnum_t target_rev;
+      repos_mergeinfo_request_t *request;
+
+      if (child->absent)
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_wc__node_is_added(&is_added, ctx->wc_ctx, child->abspath,
+                                    iterpool));
+      SVN_ERR(svn_client__entry_location(&url, &target_rev, ctx->wc_ctx,
+                                         child->abspath,
+                                         svn_opt_revision_working,
+                                         scratch_pool, iterpool));
+
+      child->pre_merge_mergeinfo = NULL;
+      SVN_ERR(svn_client__get_wc_mergeinfo_catalog(&wc_catalog,
+                                                   &child->indirect_mergeinfo,
+                                                   FALSE,
+                                                   svn_mergeinfo_inherited,
+                                                   child->abspath,
+                                                   NULL, NULL, ctx,
+                                                   result_pool, iterpool));
+      if (wc_catalog)
+        {
+          if (apr_hash_count(wc_catalog))
+            child->pre_merge_mergeinfo =
+              svn__apr_hash_index_val(apr_hash_first(iterpool, wc_catalog));
+          continue;
+        }
+
+      /* Local additions, and paths whose pristine mergeinfo was removed
+         by a local modification, effectively have no mergeinfo. */
+      if (is_added)
+        continue;
+
+      SVN_ERR(svn_wc_get_pristine_props(&original_props, ctx->wc_ctx,
+                                        child->abspath, iterpool, iterpool));
+      if (apr_hash_get(original_props, SVN_PROP_MERGEINFO,
+                       APR_HASH_KEY_STRING))
+        continue;
+
+      request = apr_hash_get(requests, &target_rev, sizeof(target_rev));
+      if (! request)
+        {
+          request = apr_palloc(scratch_pool, sizeof(*request));
+          request->revision = target_rev;
+          request->rel_paths = apr_array_make(scratch_pool, 1,
+                                              sizeof(const char *));
+          request->children =
+            apr_array_make(scratch_pool, 1,
+                           sizeof(svn_client__merge_path_t *));
+          apr_hash_set(requests, &request->revision,
+                       sizeof(request->revision), request);
+        }
+      APR_ARRAY_PUSH(request->rel_paths, const char *) =
+        svn_uri_skip_ancestor(repos_root_url, url);
+      APR_ARRAY_PUSH(request->children, svn_client__merge_path_t *) = child;
+    }
+
+  if (apr_hash_count(requests) == 0)
+    {
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_client__ensure_ra_session_url(&old_session_url, ra_session,
+                                            NULL, scratch_pool));
+
+  for (hi = apr_hash_first(scratch_pool, requests); hi; hi = apr_hash_next(hi))
+    {
+      repos_mergeinfo_request_t *request = svn__apr_hash_index_val(hi);
+      svn_mergeinfo_catalog_t repos_catalog;
+      svn_error_t *err;
+      int j;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_ra_get_mergeinfo(ra_session, &repos_catalog,
+                                 request->rel_paths, request->revision,
+                                 svn_mergeinfo_inherited, FALSE,
+                                 result_pool);
+      if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+        {
+          svn_error_clear(err);
+          continue;
+        }
+      else if (err)
+        {
+          /* One bad path spoils the whole request; sort it out the slow
+             way. */
+          svn_error_clear(err);
+          for (j = 0; j < request->children->nelts; j++)
+            {
+              svn_client__merge_path_t *child =
+                APR_ARRAY_IDX(request->children, j,
+                              svn_client__merge_path_t *);
+
+              SVN_ERR(svn_client__get_wc_or_repos_mergeinfo(
+                        &child->pre_merge_mergeinfo,
+                        &child->indirect_mergeinfo, FALSE,
+                        svn_mergeinfo_inherited, NULL, child->abspath,
+                        ctx, result_pool));
+            }
+          continue;
+        }
+
+      if (! repos_catalog)
+        continue;
+
+      for (j = 0; j < request->rel_paths->nelts; j++)
+        {
+          const char *rel_path = APR_ARRAY_IDX(request->rel_paths, j,
+                                               const char *);
+          svn_client__merge_path_t *child =
+            APR_ARRAY_IDX(request->children, j, svn_client__merge_path_t *);
+          svn_mergeinfo_t mergeinfo = apr_hash_get(repos_catalog, rel_path,
+                                                   APR_HASH_KEY_STRING);
+
+          if (! mergeinfo)
+            mergeinfo = apr_hash_get(repos_catalog,
+                                     apr_pstrcat(iterpool, "/", rel_path,
+                                                 (char *)NULL),
+                                     APR_HASH_KEY_STRING);
+          if (mergeinfo)
+            {
+              child->pre_merge_mergeinfo = mergeinfo;
+              child->indirect_mergeinfo = TRUE;
+            }
+        }
+    }
+
+  if (old_session_url)
+    SVN_ERR(svn_ra_reparent(ra_session, old_session_url, scratch_pool));
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* Helper for do_directory_merge().
 
    For each child in CHILDREN_WITH_MERGEINFO, populate that
@@ -4200,6 +4392,12 @@ populate_remaining_ranges(apr_array_header_t *children_with_mergeinfo,
     merge_b->implicit_src_gap = svn_rangelist__initialize(gap_start, gap_end,
                                                           TRUE, pool);
 
+  /* Get the explicit/inherited mergeinfo of all children up front, so
+     that those needing the repository can share round trips. */
+  SVN_ERR(get_children_recorded_mergeinfo(children_with_mergeinfo,
+                                          source_root_url, ra_session,
+                                          merge_b->ctx, pool, iterpool));
+
   for (i = 0; i < children_with_mergeinfo->nelts; i++)
     {
       const char *child_repos_path;
@@ -4226,20 +4424,18 @@ populate_remaining_ranges(apr_array_header_t *children_with_mergeinfo,
       child_url2 = svn_path_url_add_component2(url2, child_repos_path,
                                                iterpool);
 
-      /* Get the explicit/inherited mergeinfo for CHILD.  If CHILD is the
-         merge target then also get its implicit mergeinfo.  Otherwise defer
-         this until we know it is absolutely necessary, since it requires an
-         expensive round trip communication with the server. */
-      SVN_ERR(get_full_mergeinfo(
-        &(child->pre_merge_mergeinfo),
-        /* Get implicit only for merge target. */
-        (i == 0) ? &(child->implicit_mergeinfo) : NULL,
-        &(child->indirect_mergeinfo),
-        svn_mergeinfo_inherited, ra_session,
-        child->abspath,
-        MAX(revision1, revision2),
-        MIN(revision1, revision2),
-        merge_b->ctx, pool, pool));
+      /* CHILD's explicit/inherited mergeinfo is already known.  If CHILD
+         is the merge target then also get its implicit mergeinfo.
+         Otherwise defer this until we know it is absolutely necessary,
+         since it requires an expensive round trip communication with the
+         server. */
+      if (i == 0)
+        SVN_ERR(get_full_mergeinfo(NULL, &(child->implicit_mergeinfo), NULL,
+                                   svn_mergeinfo_inherited, ra_session,
+                                   child->abspath,
+                                   MAX(revision1, revision2),
+                                   MIN(revision1, revision2),
+                                   merge_b->ctx, pool, pool));
 
       /* If CHILD isn't the merge target find its parent. */
       if (i > 0)
@@ -37,6 +37,9 @@
 #include "svn_ra.h"
 #include "svn_client.h"
 #include "svn_hash.h"
+#include "svn_auth.h"
+#include "svn_config.h"
+#include "svn_checksum.h"
 
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_wc_private.h"
@@ -696,6 +699,145 @@ svn_client__mergeinfo_from_segments(svn_mergeinfo_t *mergeinfo_p,
   return SVN_NO_ERROR;
 }
 
+/* The subdirectory of the runtime configuration area in which
+   svn_client__get_history_as_mergeinfo() caches its results. */
+#define HISTORY_CACHE_SUBDIR "mergeinfo-cache"
+
+/* Set *CACHE_PATH to the file in which to cache the history of the node
+   at the session URL of RA_SESSION at PEG_REVNUM, between RANGE_YOUNGEST
+   and RANGE_OLDEST, and *CACHE_KEY to the string identifying it.  Set
+   both to NULL if the configuration of CTX doesn't ask for caching.
+
+   That history never changes (short of obliterating it or reloading
+   the repository), so cache entries don't need to be invalidated. */
+static svn_error_t *
+history_cache_path(const char **cache_path,
+                   const char **cache_key,
+                   svn_ra_session_t *ra_session,
+                   svn_revnum_t peg_revnum,
+                   svn_revnum_t range_youngest,
+                   svn_revnum_t range_oldest,
+                   svn_client_ctx_t *ctx,
+                   apr_pool_t *pool)
+{
+  svn_config_t *cfg = ctx->config
+                      ? apr_hash_get(ctx->config, SVN_CONFIG_CATEGORY_CONFIG,
+                                     APR_HASH_KEY_STRING)
+                      : NULL;
+  svn_boolean_t use_cache;
+  const char *config_dir = NULL;
+  const char *cache_dir;
+  const char *uuid;
+  const char *session_url;
+  const char *rel_path;
+  svn_checksum_t *checksum;
+
+  *cache_path = NULL;
+  *cache_key = NULL;
+
+  SVN_ERR(svn_config_get_bool(cfg, &use_cache, SVN_CONFIG_SECTION_MISCELLANY,
+                              SVN_CONFIG_OPTION_MERGEINFO_CACHE, FALSE));
+  if (! use_cache)
+    return SVN_NO_ERROR;
+
+  if (ctx->auth_baton)
+    config_dir = svn_auth_get_parameter(ctx->auth_baton,
+                                        SVN_AUTH_PARAM_CONFIG_DIR);
+  SVN_ERR(svn_config_get_user_config_path(&cache_dir, config_dir,
+                                          HISTORY_CACHE_SUBDIR, pool));
+  if (! cache_dir)
+    return SVN_NO_ERROR;
+
+  /* Identify the node by repository rather than by URL, so that all
+     ways of reaching the repository share the entries. */
+  SVN_ERR(svn_ra_get_uuid2(ra_session, &uuid, pool));
+  SVN_ERR(svn_ra_get_session_url(ra_session, &session_url, pool));
+  SVN_ERR(svn_ra_get_path_relative_to_root(ra_session, &rel_path,
+                                           session_url, pool));
+
+  *cache_key = apr_psprintf(pool, "%s/%s@%ld:%ld-%ld", uuid, rel_path,
+                            peg_revnum, range_youngest, range_oldest);
+
+  /* Like the credentials in the auth area, the entries are named after
+     the MD5 checksum of their key. */
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_md5, *cache_key,
+                       strlen(*cache_key), pool));
+  *cache_path = svn_dirent_join(cache_dir,
+                                svn_checksum_to_cstring(checksum, pool),
+                                pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MERGEINFO to the mergeinfo cached in CACHE_PATH for CACHE_KEY, or
+   to NULL if there is none. */
+static svn_error_t *
+read_cached_history(svn_mergeinfo_t *mergeinfo,
+                    const char *cache_path,
+                    const char *cache_key,
+                    apr_pool_t *pool)
+{
+  apr_hash_t *hash = apr_hash_make(pool);
+  svn_node_kind_t kind;
+  svn_stream_t *stream;
+  svn_string_t *key;
+  svn_string_t *value;
+
+  *mergeinfo = NULL;
+
+  SVN_ERR(svn_io_check_path(cache_path, &kind, pool));
+  if (kind != svn_node_file)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_stream_open_readonly(&stream, cache_path, pool, pool));
+  SVN_ERR(svn_hash_read2(hash, stream, SVN_HASH_TERMINATOR, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  /* Don't trust the checksum alone. */
+  key = apr_hash_get(hash, "key", APR_HASH_KEY_STRING);
+  value = apr_hash_get(hash, "mergeinfo", APR_HASH_KEY_STRING);
+  if (key && value && strcmp(key->data, cache_key) == 0)
+    SVN_ERR(svn_mergeinfo_parse(mergeinfo, value->data, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Cache MERGEINFO for CACHE_KEY in CACHE_PATH. */
+static svn_error_t *
+write_cached_history(svn_mergeinfo_t mergeinfo,
+                     const char *cache_path,
+                     const char *cache_key,
+                     apr_pool_t *pool)
+{
+  const char *cache_dir = svn_dirent_dirname(cache_path, pool);
+  apr_hash_t *hash = apr_hash_make(pool);
+  svn_string_t *mergeinfo_string;
+  svn_stream_t *stream;
+  const char *tmp_path;
+  svn_error_t *err;
+
+  SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_string, mergeinfo, pool));
+  apr_hash_set(hash, "key", APR_HASH_KEY_STRING,
+               svn_string_create(cache_key, pool));
+  apr_hash_set(hash, "mergeinfo", APR_HASH_KEY_STRING, mergeinfo_string);
+
+  SVN_ERR(svn_io_make_dir_recursively(cache_dir, pool));
+
+  /* Write a temporary file and move it into place, so that concurrent
+     readers never see half an entry. */
+  SVN_ERR(svn_stream_open_unique(&stream, &tmp_path, cache_dir,
+                                 svn_io_file_del_none, pool, pool));
+  err = svn_hash_write2(hash, stream, SVN_HASH_TERMINATOR, pool);
+  err = svn_error_compose_create(err, svn_stream_close(stream));
+  if (! err)
+    err = svn_io_file_rename(tmp_path, cache_path, pool);
+  if (err)
+    return svn_error_compose_create(err,
+                                    svn_io_remove_file2(tmp_path, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client__get_history_as_mergeinfo(svn_mergeinfo_t *mergeinfo_p,
                                      const char *path_or_url,
@@ -711,6 +853,9 @@ svn_client__get_history_as_mergeinfo(svn_mergeinfo_t *mergeinfo_p,
   const char *url;
   apr_pool_t *sesspool = NULL;  /* only used for an RA session we open */
   svn_ra_session_t *session = ra_session;
+  const char *cache_path;
+  const char *cache_key;
+  svn_error_t *err;
 
   /* If PATH_OR_URL is a local path (not a URL), we need to transform
      it into a URL, open an RA session for it, and resolve the peg
@@ -735,11 +880,33 @@ svn_client__get_history_as_mergeinfo(svn_mergeinfo_t *mergeinfo_p,
     range_youngest = peg_revnum;
   if (! SVN_IS_VALID_REVNUM(range_oldest))
     range_oldest = 0;
-  SVN_ERR(svn_client__repos_location_segments(&segments, session, "",
-                                              peg_revnum, range_youngest,
-                                              range_oldest, ctx, pool));
 
-  SVN_ERR(svn_client__mergeinfo_from_segments(mergeinfo_p, segments, pool));
+  /* The cache is only a shortcut, so any trouble with it just means that
+     we ask the repository. */
+  err = history_cache_path(&cache_path, &cache_key, session, peg_revnum,
+                           range_youngest, range_oldest, ctx, pool);
+  if (! err && cache_path)
+    err = read_cached_history(mergeinfo_p, cache_path, cache_key, pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      cache_path = NULL;
+      *mergeinfo_p = NULL;
+    }
+
+  if (! (cache_path && *mergeinfo_p))
+    {
+      SVN_ERR(svn_client__repos_location_segments(&segments, session, "",
+                                                  peg_revnum, range_youngest,
+                                                  range_oldest, ctx, pool));
+
+      SVN_ERR(svn_client__mergeinfo_from_segments(mergeinfo_p, segments,
+                                                  pool));
+
+      if (cache_path)
+        svn_error_clear(write_cached_history(*mergeinfo_p, cache_path,
+                                             cache_key, pool));
+    }
 
   /* If we opened an RA session, ensure its closure. */
   if (sesspool)
@@ -123,6 +123,11 @@ typedef struct {
    * each line in the target stream. */
   apr_array_header_t *lines;
 
+  /* An array containing, for each line marked in LINES, the hash of
+   * that line as computed by hash_line(). Used to rule out lines at
+   * which a hunk cannot match without re-reading the target. */
+  apr_array_header_t *line_hashes;
+
   /* An array containing hunk_info_t structures for hunks already matched. */
   apr_array_header_t *hunks;
 
@@ -361,6 +366,8 @@ init_patch_target(patch_target_t **patch_target,
   target->eol_style = svn_subst_eol_style_none;
   target->lines = apr_array_make(result_pool, 0,
                                  sizeof(svn_stream_mark_t *));
+  target->line_hashes = apr_array_make(result_pool, 0,
+                                       sizeof(unsigned int));
   target->hunks = apr_array_make(result_pool, 0, sizeof(hunk_info_t *));
   target->db_kind = svn_node_none;
   target->kind_on_disk = svn_node_none;
@@ -478,8 +485,24 @@ init_patch_target(patch_target_t **patch_target,
   return SVN_NO_ERROR;
 }
 
+/* Return a hash of LINE with all whitespace removed. Lines which are
+ * equal, or equal when ignoring whitespace, have the same hash.
+ * Do temporary allocations in SCRATCH_POOL. */
+static unsigned int
+hash_line(const char *line, apr_pool_t *scratch_pool)
+{
+  char *stripped_line = apr_pstrdup(scratch_pool, line);
+  apr_ssize_t len;
+
+  apr_collapse_spaces(stripped_line, line);
+  len = strlen(stripped_line);
+
+  return apr_hashfunc_default(stripped_line, &len);
+}
+
 /* Read a *LINE from TARGET. If the line has not been read before
- * mark the line in TARGET->LINES. Allocate *LINE in RESULT_POOL.
+ * mark the line in TARGET->LINES and record its hash in
+ * TARGET->LINE_HASHES. Allocate *LINE in RESULT_POOL.
  * Do temporary allocations in SCRATCH_POOL.
  */
 static svn_error_t *
@@ -490,6 +513,7 @@ read_line(patch_target_t *target,
 {
   svn_stringbuf_t *line_raw;
   const char *eol_str;
+  svn_boolean_t first_read;
 
   if (target->eof)
     {
@@ -498,7 +522,8 @@ read_line(patch_target_t *target,
     }
 
   SVN_ERR_ASSERT(target->current_line <= target->lines->nelts + 1);
-  if (target->current_line == target->lines->nelts + 1)
+  first_read = (target->current_line == target->lines->nelts + 1);
+  if (first_read)
     {
       svn_stream_mark_t *mark;
       SVN_ERR(svn_stream_mark(target->stream, &mark, target->pool));
@@ -516,6 +541,10 @@ read_line(patch_target_t *target,
                                        NULL, FALSE,
                                        target->keywords, FALSE,
                                        result_pool));
+  if (first_read)
+    APR_ARRAY_PUSH(target->line_hashes, unsigned int) =
+      hash_line(*line, scratch_pool);
+
   if (! target->eof)
     target->current_line++;
 
@@ -664,6 +693,62 @@ match_hunk(svn_boolean_t *matched, patch_target_t *target,
   return SVN_NO_ERROR;
 }
 
+/* Set *ANCHOR to the number of the first line of the original text of
+ * HUNK which match_hunk() compares with the target when matching with
+ * fuzz factor FUZZ, and *ANCHOR_HASH to the hash_line() of that line.
+ * If there is no such line, set *ANCHOR to zero.
+ * HUNK->ORIGINAL_TEXT will be reset. Do temporary allocations in POOL. */
+static svn_error_t *
+find_hunk_anchor(svn_linenum_t *anchor, unsigned int *anchor_hash,
+                 patch_target_t *target, const svn_hunk_t *hunk, int fuzz,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *hunk_line;
+  svn_linenum_t lines_read;
+  svn_boolean_t hunk_eof;
+  apr_pool_t *iterpool;
+
+  *anchor = 0;
+
+  lines_read = 0;
+  SVN_ERR(svn_stream_reset(hunk->original_text));
+  iterpool = svn_pool_create(pool);
+  do
+    {
+      const char *hunk_line_translated;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_stream_readline_detect_eol(hunk->original_text,
+                                             &hunk_line, NULL,
+                                             &hunk_eof, iterpool));
+      lines_read++;
+      if (hunk_eof)
+        break;
+
+      /* Lines matching with fuzz are never compared. */
+      if (lines_read <= fuzz && hunk->leading_context > fuzz)
+        continue;
+      if (lines_read > hunk->original_length - fuzz &&
+          hunk->trailing_context > fuzz)
+        continue;
+
+      SVN_ERR(svn_subst_translate_cstring2(hunk_line->data,
+                                           &hunk_line_translated,
+                                           NULL, FALSE,
+                                           target->keywords, FALSE,
+                                           iterpool));
+      *anchor = lines_read;
+      *anchor_hash = hash_line(hunk_line_translated, iterpool);
+    }
+  while (*anchor == 0);
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_stream_reset(hunk->original_text));
+
+  return SVN_NO_ERROR;
+}
+
 /* Scan lines of TARGET for a match of the original text of HUNK,
  * up to but not including the specified UPPER_LINE. Use fuzz factor FUZZ.
  * If UPPER_LINE is zero scan until EOF occurs when reading from TARGET.
@@ -685,13 +770,22 @@ scan_for_match(svn_linenum_t *matched_line, patch_target_t *target,
                apr_pool_t *pool)
 {
   apr_pool_t *iterpool;
+  svn_linenum_t anchor;
+  unsigned int anchor_hash;
 
   *matched_line = 0;
+
+  /* Most lines of the target can be ruled out by looking at the hash of
+   * the target line the first compared line of the hunk would fall on,
+   * provided that target line has been read before. */
+  SVN_ERR(find_hunk_anchor(&anchor, &anchor_hash, target, hunk, fuzz, pool));
+
   iterpool = svn_pool_create(pool);
   while ((target->current_line < upper_line || upper_line == 0) &&
          ! target->eof)
     {
       svn_boolean_t matched;
+      svn_linenum_t anchor_line;
       int i;
 
       svn_pool_clear(iterpool);
@@ -699,8 +793,14 @@ scan_for_match(svn_linenum_t *matched_line, patch_target_t *target,
       if (cancel_func)
         SVN_ERR((cancel_func)(cancel_baton));
 
-      SVN_ERR(match_hunk(&matched, target, hunk, fuzz, ignore_whitespace,
-                         iterpool));
+      anchor_line = target->current_line + anchor - 1;
+      if (anchor > 0 && anchor_line <= target->line_hashes->nelts &&
+          APR_ARRAY_IDX(target->line_hashes, anchor_line - 1,
+                        unsigned int) != anchor_hash)
+        matched = FALSE;
+      else
+        SVN_ERR(match_hunk(&matched, target, hunk, fuzz, ignore_whitespace,
+                           iterpool));
       if (matched)
         {
           svn_boolean_t taken = FALSE;
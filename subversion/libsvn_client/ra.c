@@ -24,6 +24,7 @@
 
 
 #include <apr_pools.h>
+#include <apr_strings.h>
 
 #include "svn_error.h"
 #include "svn_pools.h"
@@ -67,6 +68,45 @@ typedef struct
 
 } callback_baton_t;
 
+/* The most sessions a session pool keeps idle.  More sessions are
+   closed when their users are done with them. */
+#define MAX_IDLE_SESSIONS 8
+
+/* A set of idle RA sessions, kept for reuse by the operations using a
+   client context. */
+typedef struct session_pool_t session_pool_t;
+
+/* An RA session that may be handed out again once its user is done
+   with it. */
+typedef struct pooled_session_t
+{
+  svn_ra_session_t *session;
+
+  /* The callbacks the session was opened with. */
+  const svn_ra_callbacks2_t *cbtable;
+  const callback_baton_t *cb;
+
+  /* The root URL of the repository, or NULL until it was needed. */
+  const char *repos_root_url;
+
+  /* The pool the session lives in, a subpool of OWNER->pool. */
+  apr_pool_t *pool;
+
+  /* The pool of the current user of the session, or NULL while the
+     session is idle. */
+  apr_pool_t *user_pool;
+
+  session_pool_t *owner;
+} pooled_session_t;
+
+struct session_pool_t
+{
+  /* The idle pooled_session_t *, least recently used first. */
+  apr_array_header_t *idle;
+
+  apr_pool_t *pool;
+};
+
 
 
 static svn_error_t *
@@ -280,6 +320,201 @@ get_client_string(void *baton,
   return SVN_NO_ERROR;
 }
 
+
+static svn_error_t *
+get_wc_contents(void *baton,
+                svn_stream_t **contents,
+                const svn_checksum_t *checksum,
+                apr_pool_t *pool)
+{
+  callback_baton_t *cb = baton;
+  svn_error_t *err;
+
+  err = svn_wc__get_pristine_contents_by_checksum(contents, cb->ctx->wc_ctx,
+                                                  cb->base_dir_abspath,
+                                                  checksum, pool, pool);
+
+  /* Not finding the text is fine; the RA layer will just fetch it. */
+  if (err && (err->apr_err == SVN_ERR_WC_NOT_WORKING_COPY
+              || err->apr_err == SVN_ERR_WC_PATH_NOT_FOUND
+              || err->apr_err == SVN_ERR_WC_UPGRADE_REQUIRED))
+    {
+      svn_error_clear(err);
+      *contents = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_return(err);
+}
+
+/* The size of the userdata keys of session pools. */
+#define SESSION_POOL_KEY_SIZE 64
+
+/* Set KEY, a buffer of SESSION_POOL_KEY_SIZE bytes, to the userdata key
+   of the session pool of CTX. */
+static void
+make_session_pool_key(char *key,
+                      const svn_client_ctx_t *ctx)
+{
+  apr_snprintf(key, SESSION_POOL_KEY_SIZE, "svn_client__session_pool-%pp",
+               (const void *)ctx);
+}
+
+void
+svn_client__session_pool_attach(svn_client_ctx_t *ctx,
+                                apr_pool_t *pool)
+{
+  session_pool_t *session_pool
+    = apr_pcalloc(pool, sizeof(*session_pool));
+  char key[SESSION_POOL_KEY_SIZE];
+
+  session_pool->pool = svn_pool_create(pool);
+  session_pool->idle = apr_array_make(session_pool->pool, MAX_IDLE_SESSIONS,
+                                      sizeof(pooled_session_t *));
+
+  make_session_pool_key(key, ctx);
+  apr_pool_userdata_set(session_pool, key, NULL, pool);
+}
+
+/* Return the session pool attached to CTX, looking for it in POOL and
+   its ancestors, or NULL if there is none there. */
+static session_pool_t *
+find_session_pool(const svn_client_ctx_t *ctx,
+                  apr_pool_t *pool)
+{
+  char key[SESSION_POOL_KEY_SIZE];
+
+  make_session_pool_key(key, ctx);
+  for (; pool; pool = apr_pool_parent_get(pool))
+    {
+      void *session_pool;
+
+      apr_pool_userdata_get(&session_pool, key, pool);
+      if (session_pool)
+        return session_pool;
+    }
+
+  return NULL;
+}
+
+/* Remove the idle session at index I from SESSION_POOL. */
+static void
+remove_idle_session(session_pool_t *session_pool,
+                    int i)
+{
+  apr_array_header_t *idle = session_pool->idle;
+
+  memmove(idle->elts + i * idle->elt_size,
+          idle->elts + (i + 1) * idle->elt_size,
+          (idle->nelts - i - 1) * idle->elt_size);
+  idle->nelts--;
+}
+
+/* Pool cleanup handler handing the pooled_session_t DATA back to its
+   session pool when its user's pool goes away. */
+static apr_status_t
+release_session(void *data)
+{
+  pooled_session_t *ps = data;
+  session_pool_t *session_pool = ps->owner;
+
+  ps->user_pool = NULL;
+  if (session_pool->idle->nelts < MAX_IDLE_SESSIONS)
+    APR_ARRAY_PUSH(session_pool->idle, pooled_session_t *) = ps;
+  else
+    svn_pool_destroy(ps->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Pool cleanup handler for the pool of the pooled_session_t DATA, so
+   that the pool of its user doesn't try to release it later. */
+static apr_status_t
+forget_session(void *data)
+{
+  pooled_session_t *ps = data;
+
+  if (ps->user_pool)
+    apr_pool_cleanup_kill(ps->user_pool, ps, release_session);
+
+  return APR_SUCCESS;
+}
+
+/* Hand the pooled session PS out to a user allocating in POOL. */
+static void
+lend_session(pooled_session_t *ps,
+             apr_pool_t *pool)
+{
+  ps->user_pool = pool;
+  apr_pool_cleanup_register(pool, ps, release_session,
+                            apr_pool_cleanup_null);
+}
+
+/* Set *RA_SESSION to an idle session of SESSION_POOL to the
+   repository of BASE_URL, reparented to BASE_URL, or to NULL if there
+   is none.  Only sessions opened with READ_ONLY_WC and with the current
+   callbacks of CTX qualify.  Sessions that fail to reparent, for
+   instance because their connection went away, are closed.  The
+   session is handed back to the pool when POOL is cleaned up. */
+static svn_error_t *
+reuse_session(svn_ra_session_t **ra_session,
+              const char *base_url,
+              svn_boolean_t read_only_wc,
+              session_pool_t *session_pool,
+              svn_client_ctx_t *ctx,
+              apr_pool_t *pool)
+{
+  int i;
+
+  *ra_session = NULL;
+
+  /* Prefer the sessions used most recently. */
+  for (i = session_pool->idle->nelts - 1; i >= 0; i--)
+    {
+      pooled_session_t *ps = APR_ARRAY_IDX(session_pool->idle, i,
+                                           pooled_session_t *);
+      svn_error_t *err;
+
+      if (ps->cb->read_only_wc != read_only_wc
+          || ps->cbtable->auth_baton != ctx->auth_baton
+          || ps->cbtable->progress_func != ctx->progress_func
+          || ps->cbtable->progress_baton != ctx->progress_baton
+          || (ps->cbtable->cancel_func != NULL) != (ctx->cancel_func != NULL))
+        continue;
+
+      if (! ps->repos_root_url)
+        {
+          err = svn_ra_get_repos_root2(ps->session, &ps->repos_root_url,
+                                       ps->pool);
+          if (err)
+            {
+              svn_error_clear(err);
+              remove_idle_session(session_pool, i);
+              svn_pool_destroy(ps->pool);
+              continue;
+            }
+        }
+
+      if (! svn_uri_is_ancestor(ps->repos_root_url, base_url))
+        continue;
+
+      remove_idle_session(session_pool, i);
+      err = svn_ra_reparent(ps->session, base_url, pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(ps->pool);
+          continue;
+        }
+
+      lend_session(ps, pool);
+      *ra_session = ps->session;
+      break;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
                                      const char *base_url,
@@ -290,14 +525,43 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
                                      svn_client_ctx_t *ctx,
                                      apr_pool_t *pool)
 {
-  svn_ra_callbacks2_t *cbtable = apr_pcalloc(pool, sizeof(*cbtable));
-  callback_baton_t *cb = apr_pcalloc(pool, sizeof(*cb));
+  svn_ra_callbacks2_t *cbtable;
+  callback_baton_t *cb;
   const char *uuid = NULL;
+  session_pool_t *session_pool = NULL;
+  pooled_session_t *ps = NULL;
 
   SVN_ERR_ASSERT(base_dir_abspath != NULL || ! use_admin);
   SVN_ERR_ASSERT(base_dir_abspath == NULL
                         || svn_dirent_is_absolute(base_dir_abspath));
 
+  /* Sessions that don't belong to a working copy don't depend on
+     anything the callbacks get from our arguments, so they can be
+     shared by the operations using CTX. */
+  if (! base_dir_abspath && ! commit_items)
+    session_pool = find_session_pool(ctx, pool);
+
+  if (session_pool)
+    {
+      apr_pool_t *ps_pool;
+
+      SVN_ERR(reuse_session(ra_session, base_url, read_only_wc, session_pool,
+                            ctx, pool));
+      if (*ra_session)
+        return SVN_NO_ERROR;
+
+      ps_pool = svn_pool_create(session_pool->pool);
+
+      ps = apr_pcalloc(ps_pool, sizeof(*ps));
+      ps->owner = session_pool;
+      ps->pool = ps_pool;
+      apr_pool_cleanup_register(ps->pool, ps, forget_session,
+                                apr_pool_cleanup_null);
+    }
+
+  cbtable = apr_pcalloc(ps ? ps->pool : pool, sizeof(*cbtable));
+  cb = apr_pcalloc(ps ? ps->pool : pool, sizeof(*cb));
+
   cbtable->open_tmp_file = open_tmp_file;
   cbtable->get_wc_prop = use_admin ? get_wc_prop : NULL;
   cbtable->set_wc_prop = read_only_wc ? NULL : set_wc_prop;
@@ -308,10 +572,11 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
   cbtable->progress_baton = ctx->progress_baton;
   cbtable->cancel_func = ctx->cancel_func ? cancel_callback : NULL;
   cbtable->get_client_string = get_client_string;
+  cbtable->get_wc_contents = base_dir_abspath ? get_wc_contents : NULL;
 
   cb->base_dir_abspath = base_dir_abspath;
   cb->read_only_wc = read_only_wc;
-  cb->pool = pool;
+  cb->pool = ps ? ps->pool : pool;
   cb->commit_items = commit_items;
   cb->ctx = ctx;
 
@@ -332,6 +597,23 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
         SVN_ERR(err);
     }
 
+  if (ps)
+    {
+      svn_error_t *err = svn_ra_open3(&ps->session, base_url, uuid,
+                                      cbtable, cb, ctx->config, ps->pool);
+      if (err)
+        {
+          svn_pool_destroy(ps->pool);
+          return svn_error_return(err);
+        }
+
+      ps->cbtable = cbtable;
+      ps->cb = cb;
+      lend_session(ps, pool);
+      *ra_session = ps->session;
+      return SVN_NO_ERROR;
+    }
+
   return svn_error_return(svn_ra_open3(ra_session, base_url, uuid, cbtable, cb,
                                        ctx->config, pool));
 }
@@ -23,6 +23,7 @@
  */
 
 
+#include "svn_dirent_uri.h"
 #include "svn_props.h"
 #include "svn_pools.h"
 
@@ -63,6 +64,12 @@ struct item_baton {
   /* The kind of this item */
   svn_node_kind_t node_kind;
 
+  /* For directories: the number of entries deleted so far, and the
+     entries of the directory in the start revision, mapping names to
+     svn_dirent_t *.  The latter are fetched on the second deletion. */
+  int deletions;
+  apr_hash_t *source_dirents;
+
   /* The file/directory pool */
   apr_pool_t *item_pool;
 };
@@ -140,13 +147,30 @@ delete_entry(const char *path,
   struct edit_baton *eb = ib->edit_baton;
   svn_client_diff_summarize_t *sum;
   svn_node_kind_t kind;
-
-  /* We need to know if this is a directory or a file */
-  SVN_ERR(svn_ra_check_path(eb->ra_session,
-                            path,
-                            eb->revision,
-                            &kind,
-                            pool));
+  svn_dirent_t *dirent = NULL;
+
+  /* We need to know if this is a directory or a file.  Rather than
+     asking the server for every deleted entry, which costs a round trip
+     each, get the kinds of all entries of the parent once it turns out
+     to have lost more than one. */
+  if (! ib->source_dirents && ++ib->deletions > 1)
+    SVN_ERR(svn_ra_get_dir2(eb->ra_session, &ib->source_dirents, NULL, NULL,
+                            ib->path, eb->revision, SVN_DIRENT_KIND,
+                            ib->item_pool));
+
+  if (ib->source_dirents)
+    dirent = apr_hash_get(ib->source_dirents,
+                          svn_relpath_basename(path, NULL),
+                          APR_HASH_KEY_STRING);
+
+  if (dirent)
+    kind = dirent->kind;
+  else
+    SVN_ERR(svn_ra_check_path(eb->ra_session,
+                              path,
+                              eb->revision,
+                              &kind,
+                              pool));
 
   sum = apr_pcalloc(pool, sizeof(*sum));
   sum->summarize_kind = svn_client_diff_summarize_kind_deleted;
@@ -99,6 +99,7 @@ update_internal(svn_revnum_t *result_rev,
                 svn_boolean_t *timestamp_sleep,
                 svn_boolean_t send_copyfrom_args,
                 svn_boolean_t innerupdate,
+                svn_boolean_t lazy,
                 svn_client_ctx_t *ctx,
                 apr_pool_t *pool)
 {
@@ -221,27 +222,60 @@ update_internal(svn_revnum_t *result_rev,
 
   /* Fetch the update editor.  If REVISION is invalid, that's okay;
      the RA driver will call editor->set_target_revision later on. */
-  SVN_ERR(svn_wc_get_update_editor4(&update_editor, &update_edit_baton,
-                                    &revnum, ctx->wc_ctx, anchor_abspath,
-                                    target, use_commit_times, depth,
-                                    depth_is_sticky, allow_unver_obstructions,
-                                    diff3_cmd, preserved_exts,
-                                    file_fetcher, ffb,
-                                    ctx->conflict_func, ctx->conflict_baton,
-                                    svn_client__external_info_gatherer, &efb,
-                                    ctx->cancel_func, ctx->cancel_baton,
-                                    ctx->notify_func2, ctx->notify_baton2,
-                                    pool, pool));
+  if (lazy)
+    SVN_ERR(svn_wc__get_lazy_update_editor(&update_editor, &update_edit_baton,
+                                           &revnum, ctx->wc_ctx,
+                                           anchor_abspath, target,
+                                           use_commit_times, depth,
+                                           depth_is_sticky,
+                                           allow_unver_obstructions,
+                                           diff3_cmd, preserved_exts,
+                                           file_fetcher, ffb,
+                                           ctx->conflict_func,
+                                           ctx->conflict_baton,
+                                           svn_client__external_info_gatherer,
+                                           &efb,
+                                           ctx->cancel_func, ctx->cancel_baton,
+                                           ctx->notify_func2,
+                                           ctx->notify_baton2,
+                                           pool, pool));
+  else
+    SVN_ERR(svn_wc_get_update_editor4(&update_editor, &update_edit_baton,
+                                      &revnum, ctx->wc_ctx, anchor_abspath,
+                                      target, use_commit_times, depth,
+                                      depth_is_sticky,
+                                      allow_unver_obstructions,
+                                      diff3_cmd, preserved_exts,
+                                      file_fetcher, ffb,
+                                      ctx->conflict_func, ctx->conflict_baton,
+                                      svn_client__external_info_gatherer, &efb,
+                                      ctx->cancel_func, ctx->cancel_baton,
+                                      ctx->notify_func2, ctx->notify_baton2,
+                                      pool, pool));
 
   /* Tell RA to do an update of URL+TARGET to REVISION; if we pass an
      invalid revnum, that means RA will use the latest revision.  */
-  SVN_ERR(svn_ra_do_update2(ra_session,
+  if (lazy)
+    /* A diff of the target against itself, without text deltas, drives
+       the editor like an update that leaves out the file texts. */
+    SVN_ERR(svn_ra_do_diff3(ra_session,
                             &reporter, &report_baton,
                             revnum,
                             target,
                             depth,
-                            send_copyfrom_args,
+                            TRUE /* ignore_ancestry */,
+                            FALSE /* text_deltas */,
+                            svn_path_url_add_component2(anchor_url, target,
+                                                        pool),
                             update_editor, update_edit_baton, pool));
+  else
+    SVN_ERR(svn_ra_do_update2(ra_session,
+                              &reporter, &report_baton,
+                              revnum,
+                              target,
+                              depth,
+                              send_copyfrom_args,
+                              update_editor, update_edit_baton, pool));
 
   SVN_ERR(svn_ra_has_capability(ra_session, &server_supports_depth,
                                 SVN_RA_CAPABILITY_DEPTH, pool));
@@ -316,6 +350,7 @@ svn_client__update_internal(svn_revnum_t *result_rev,
                             svn_boolean_t *timestamp_sleep,
                             svn_boolean_t send_copyfrom_args,
                             svn_boolean_t innerupdate,
+                            svn_boolean_t lazy,
                             svn_client_ctx_t *ctx,
                             apr_pool_t *pool)
 {
@@ -340,7 +375,7 @@ svn_client__update_internal(svn_revnum_t *result_rev,
                          revision, depth, depth_is_sticky,
                          ignore_externals, allow_unver_obstructions,
                          timestamp_sleep, send_copyfrom_args,
-                         innerupdate, ctx, pool);
+                         innerupdate, lazy, ctx, pool);
 
   err2 = svn_wc__release_write_lock(ctx->wc_ctx, anchor_abspath, pool);
 
@@ -392,7 +427,8 @@ svn_client_update3(apr_array_header_t **result_revs,
                                             revision, depth, depth_is_sticky,
                                             ignore_externals,
                                             allow_unver_obstructions,
-                                            &sleep, TRUE, FALSE, ctx, subpool);
+                                            &sleep, TRUE, FALSE, FALSE,
+                                            ctx, subpool);
 
           if (err && err->apr_err != SVN_ERR_WC_NOT_WORKING_COPY)
             {
@@ -29,12 +29,18 @@
 #include "svn_delta.h"
 #include "svn_pools.h"
 #include "delta.h"
+#include "private/svn_delta_private.h"
 
 /* Define a MIN macro if this platform doesn't already have one. */
 #ifndef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
+/* Same for MAX. */
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
 
 /* ==================================================================== */
 /* Support for efficient small-block allocation from pools. */
@@ -136,18 +142,26 @@ typedef struct offset_index_t
   apr_size_t *offs;
 } offset_index_t;
 
-/* Create an index mapping target stream offsets to delta ops in
-   WINDOW. Allocate from POOL. */
+/* Fill NDX with an index mapping target stream offsets to delta ops
+   in WINDOW.  *SIZE is the number of entries NDX->OFFS has room for;
+   if that is not enough, allocate a larger array from POOL and update
+   *SIZE. */
 
-static offset_index_t *
-create_offset_index(const svn_txdelta_window_t *window, apr_pool_t *pool)
+static void
+build_offset_index(offset_index_t *ndx,
+                   apr_size_t *size,
+                   const svn_txdelta_window_t *window,
+                   apr_pool_t *pool)
 {
-  offset_index_t *ndx = apr_palloc(pool, sizeof(*ndx));
   apr_size_t offset = 0;
   int i;
 
   ndx->length = window->num_ops;
-  ndx->offs = apr_palloc(pool, (ndx->length + 1) * sizeof(*ndx->offs));
+  if ((apr_size_t)ndx->length + 1 > *size)
+    {
+      *size = MAX(2 * *size, (apr_size_t)ndx->length + 1);
+      ndx->offs = apr_palloc(pool, *size * sizeof(*ndx->offs));
+    }
 
   for (i = 0; i < ndx->length; ++i)
     {
@@ -155,8 +169,6 @@ create_offset_index(const svn_txdelta_window_t *window, apr_pool_t *pool)
       offset += window->ops[i].length;
     }
   ndx->offs[ndx->length] = offset;
-
-  return ndx;
 }
 
 /* Find the index of the delta op thet defines that data at OFFSET in
@@ -220,15 +232,32 @@ typedef struct range_index_t
   apr_pool_t *pool;
 } range_index_t;
 
-/* Create a range index tree. Allocate from POOL. */
-static range_index_t *
-create_range_index(apr_pool_t *pool)
+/* Empty the range index tree NDX, putting all of its nodes on the free
+   list.  This walks the tree iteratively, rotating left children up,
+   so that degenerate trees don't cause deep recursion. */
+static void
+empty_range_index(range_index_t *ndx)
 {
-  range_index_t *ndx = apr_palloc(pool, sizeof(*ndx));
+  range_index_node_t *node = ndx->tree;
+
+  while (node != NULL)
+    {
+      if (node->left != NULL)
+        {
+          range_index_node_t *const left = node->left;
+          node->left = left->right;
+          left->right = node;
+          node = left;
+        }
+      else
+        {
+          range_index_node_t *const right = node->right;
+          free_block(node, &ndx->free_list);
+          node = right;
+        }
+    }
+
   ndx->tree = NULL;
-  ndx->pool = pool;
-  ndx->free_list = NULL;
-  return ndx;
 }
 
 /* Allocate a node for the range index tree. */
@@ -757,20 +786,43 @@ copy_source_ops(apr_size_t offset, apr_size_t limit,
 /* ==================================================================== */
 /* Bringing it all together. */
 
+struct svn_txdelta__compose_ctx_t
+{
+  /* The offset index of the current window A, and the number of
+     entries its array has room for. */
+  offset_index_t offset_index;
+  apr_size_t offset_index_size;
+
+  /* The range index of the current composition.  Its tree is empty
+     between compositions, but its free list keeps the nodes of earlier
+     ones for reuse. */
+  range_index_t range_index;
+};
+
+svn_txdelta__compose_ctx_t *
+svn_txdelta__compose_ctx_create(apr_pool_t *pool)
+{
+  svn_txdelta__compose_ctx_t *ctx = apr_pcalloc(pool, sizeof(*ctx));
+  ctx->range_index.pool = pool;
+  return ctx;
+}
 
 svn_txdelta_window_t *
-svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
-                            const svn_txdelta_window_t *window_B,
-                            apr_pool_t *pool)
+svn_txdelta__compose_windows(const svn_txdelta_window_t *window_A,
+                             const svn_txdelta_window_t *window_B,
+                             svn_txdelta__compose_ctx_t *ctx,
+                             apr_pool_t *pool)
 {
   svn_txdelta__ops_baton_t build_baton = { 0 };
   svn_txdelta_window_t *composite;
-  apr_pool_t *subpool = svn_pool_create(pool);
-  offset_index_t *offset_index = create_offset_index(window_A, subpool);
-  range_index_t *range_index = create_range_index(subpool);
+  offset_index_t *offset_index = &ctx->offset_index;
+  range_index_t *range_index = &ctx->range_index;
   apr_size_t target_offset = 0;
   int i;
 
+  build_offset_index(offset_index, &ctx->offset_index_size, window_A,
+                     range_index->pool);
+
   /* Read the description of the delta composition algorithm in
      notes/fs-improvements.txt before going any further.
      You have been warned. */
@@ -827,7 +879,7 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
       target_offset += op->length;
     }
 
-  svn_pool_destroy(subpool);
+  empty_range_index(range_index);
 
   composite = svn_txdelta__make_window(&build_baton, pool);
   composite->sview_offset = window_A->sview_offset;
@@ -835,3 +887,18 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
   composite->tview_len = window_B->tview_len;
   return composite;
 }
+
+svn_txdelta_window_t *
+svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
+                            const svn_txdelta_window_t *window_B,
+                            apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_txdelta_window_t *composite
+    = svn_txdelta__compose_windows(window_A, window_B,
+                                   svn_txdelta__compose_ctx_create(subpool),
+                                   pool);
+
+  svn_pool_destroy(subpool);
+  return composite;
+}
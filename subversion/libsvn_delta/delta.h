@@ -42,7 +42,7 @@ extern "C" {
 
 /* The standard size of one svndiff window. */
 
-#define SVN_DELTA_WINDOW_SIZE 102400
+#define SVN_DELTA_WINDOW_SIZE SVN_DELTA_DEFAULT_WINDOW_SIZE
 
 
 /* Context/baton for building an operation sequence. */
@@ -75,11 +75,24 @@ svn_txdelta__make_window(const svn_txdelta__ops_baton_t *build_baton,
                          apr_pool_t *pool);
 
 
-/* Create xdelta window data. Allocate temporary data from POOL. */
+/* A table of source block checksums used by svn_txdelta__xdelta().  It
+   can be reused for all windows of a delta stream. */
+typedef struct svn_txdelta__xdelta_blocks_t svn_txdelta__xdelta_blocks_t;
+
+/* Create a block table for svn_txdelta__xdelta(), allocated in POOL and
+   sized for sources of up to MAX_SOURCE_LEN bytes.  Should a larger
+   source come along, the table grows, again allocating from POOL. */
+svn_txdelta__xdelta_blocks_t *
+svn_txdelta__xdelta_blocks_create(apr_size_t max_source_len,
+                                  apr_pool_t *pool);
+
+/* Create xdelta window data, using BLOCKS as the block table.  If BLOCKS
+   is NULL, use a temporary one.  Allocate temporary data from POOL. */
 void svn_txdelta__xdelta(svn_txdelta__ops_baton_t *build_baton,
                          const char *start,
                          apr_size_t source_len,
                          apr_size_t target_len,
+                         svn_txdelta__xdelta_blocks_t *blocks,
                          apr_pool_t *pool);
 
 
@@ -27,6 +27,9 @@
 #include "svn_delta.h"
 #include "svn_io.h"
 #include "delta.h"
+#include "private/svn_delta_private.h"
+#include "private/svn_string_private.h"
+#include "private/svn_pipeline.h"
 #include "svn_pools.h"
 #include "svn_private_config.h"
 #include <zlib.h>
@@ -40,10 +43,6 @@
    be compressed using zlib as a secondary compressor.  */
 #define MIN_COMPRESS_SIZE 512
 
-/* For svndiff, this is the compression level we pass to zlib.  It
-   should be between 0 and 9, with higher numbers being greater
-   compression.  */
-#define SVNDIFF1_COMPRESS_LEVEL 5
 #define NORMAL_BITS 7
 #define LENGTH_BITS 5
 
@@ -52,12 +51,21 @@
 
 /* We make one of these and get it passed back to us in calls to the
    window handler.  We only use it to record the write function and
-   baton passed to svn_txdelta_to_svndiff2().  */
+   baton passed to svn_txdelta_to_svndiff3().  */
 struct encoder_baton {
   svn_stream_t *output;
   svn_boolean_t header_done;
   int version;
+  int compression_level;
   apr_pool_t *pool;
+
+  /* Scratch buffers for encoding a window, allocated in POOL.  They are
+     emptied and reused for every window, so they only grow to the size
+     of the largest window instead of being allocated anew each time. */
+  svn_stringbuf_t *instructions;
+  svn_stringbuf_t *header;
+  svn_stringbuf_t *compressed_instructions;
+  svn_stringbuf_t *compressed_data;
 };
 
 /* This is at least as big as the largest size of an integer that
@@ -69,9 +77,10 @@ struct encoder_baton {
 /* This is at least as big as the largest size for a single instruction. */
 #define MAX_INSTRUCTION_LEN (2*MAX_ENCODED_INT_LEN+1)
 /* This is at least as big as the largest possible instructions
-   section: in theory, the instructions could be SVN_DELTA_WINDOW_SIZE
+   section: in theory, the instructions could be SVN_DELTA_MAX_WINDOW_SIZE
    1-byte copy-from-source instructions (though this is very unlikely). */
-#define MAX_INSTRUCTION_SECTION_LEN (SVN_DELTA_WINDOW_SIZE*MAX_INSTRUCTION_LEN)
+#define MAX_INSTRUCTION_SECTION_LEN \
+  (SVN_DELTA_MAX_WINDOW_SIZE*MAX_INSTRUCTION_LEN)
 
 /* Encode VAL into the buffer P using the variable-length svndiff
    integer format.  Return the incremented value of P after the
@@ -132,13 +141,17 @@ append_encoded_int(svn_stringbuf_t *header, svn_filesize_t val)
   svn_stringbuf_appendbytes(header, (const char *)buf, p - buf);
 }
 
-/* If IN is a string that is >= MIN_COMPRESS_SIZE, zlib compress it and
-   place the result in OUT, with an integer prepended specifying the
-   original size.  If IN is < MIN_COMPRESS_SIZE, or if the compressed
-   version of IN was no smaller than the original IN, OUT will be a copy
-   of IN with the size prepended as an integer. */
+/* If IN is a string that is >= MIN_COMPRESS_SIZE, zlib compress it at
+   COMPRESSION_LEVEL and place the result in OUT, with an integer
+   prepended specifying the original size.  If IN is < MIN_COMPRESS_SIZE,
+   if COMPRESSION_LEVEL is SVN_DELTA_COMPRESSION_LEVEL_NONE, or if the
+   compressed version of IN was no smaller than the original IN, OUT will
+   be a copy of IN with the size prepended as an integer. */
 static svn_error_t *
-zlib_encode(const char *data, apr_size_t len, svn_stringbuf_t *out)
+zlib_encode(const char *data,
+            apr_size_t len,
+            svn_stringbuf_t *out,
+            int compression_level)
 {
   unsigned long endlen;
   apr_size_t intlen;
@@ -146,18 +159,21 @@ zlib_encode(const char *data, apr_size_t len, svn_stringbuf_t *out)
   append_encoded_int(out, len);
   intlen = out->len;
 
-  if (len < MIN_COMPRESS_SIZE)
+  if (len < MIN_COMPRESS_SIZE
+      || compression_level == SVN_DELTA_COMPRESSION_LEVEL_NONE)
     {
       svn_stringbuf_appendbytes(out, data, len);
     }
   else
     {
-      svn_stringbuf_ensure(out, svnCompressBound(len) + intlen);
+      /* Compressing into a buffer that grows by doubling would leave up
+         to half of it unused; reserve just what compress2() may need. */
+      svn_stringbuf__ensure_exact(out, svnCompressBound(len) + intlen);
       endlen = out->blocksize;
 
       if (compress2((unsigned char *)out->data + intlen, &endlen,
                     (const unsigned char *)data, len,
-                    SVNDIFF1_COMPRESS_LEVEL) != Z_OK)
+                    compression_level) != Z_OK)
         return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA,
                                 NULL,
                                 _("Compression of svndiff data failed"));
@@ -177,10 +193,9 @@ static svn_error_t *
 window_handler(svn_txdelta_window_t *window, void *baton)
 {
   struct encoder_baton *eb = baton;
-  apr_pool_t *pool = svn_pool_create(eb->pool);
-  svn_stringbuf_t *instructions = svn_stringbuf_create("", pool);
-  svn_stringbuf_t *i1 = svn_stringbuf_create("", pool);
-  svn_stringbuf_t *header = svn_stringbuf_create("", pool);
+  svn_stringbuf_t *instructions = eb->instructions;
+  svn_stringbuf_t *header = eb->header;
+  svn_string_t compressed_newdata;
   const svn_string_t *newdata;
   unsigned char ibuf[MAX_INSTRUCTION_LEN], *ip;
   const svn_txdelta_op_t *op;
@@ -217,7 +232,12 @@ window_handler(svn_txdelta_window_t *window, void *baton)
       return svn_stream_close(output);
     }
 
+  svn_stringbuf_setempty(instructions);
+  svn_stringbuf_setempty(header);
+
   /* Encode the instructions.  */
+  svn_stringbuf_ensure(instructions,
+                       window->num_ops * MAX_INSTRUCTION_LEN + 1);
   for (op = window->ops; op < window->ops + window->num_ops; op++)
     {
       /* Encode the action code and length.  */
@@ -243,19 +263,21 @@ window_handler(svn_txdelta_window_t *window, void *baton)
   append_encoded_int(header, window->tview_len);
   if (eb->version == 1)
     {
-      SVN_ERR(zlib_encode(instructions->data, instructions->len, i1));
-      instructions = i1;
+      svn_stringbuf_setempty(eb->compressed_instructions);
+      SVN_ERR(zlib_encode(instructions->data, instructions->len,
+                          eb->compressed_instructions,
+                          eb->compression_level));
+      instructions = eb->compressed_instructions;
     }
   append_encoded_int(header, instructions->len);
   if (eb->version == 1)
     {
-      svn_stringbuf_t *temp = svn_stringbuf_create("", pool);
-      svn_string_t *tempstr = svn_string_create("", pool);
+      svn_stringbuf_setempty(eb->compressed_data);
       SVN_ERR(zlib_encode(window->new_data->data, window->new_data->len,
-                          temp));
-      tempstr->data = temp->data;
-      tempstr->len = temp->len;
-      newdata = tempstr;
+                          eb->compressed_data, eb->compression_level));
+      compressed_newdata.data = eb->compressed_data->data;
+      compressed_newdata.len = eb->compressed_data->len;
+      newdata = &compressed_newdata;
     }
   else
     newdata = window->new_data;
@@ -276,30 +298,52 @@ window_handler(svn_txdelta_window_t *window, void *baton)
       SVN_ERR(svn_stream_write(eb->output, newdata->data, &len));
     }
 
-  svn_pool_destroy(pool);
   return SVN_NO_ERROR;
 }
 
 void
-svn_txdelta_to_svndiff2(svn_txdelta_window_handler_t *handler,
+svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
                         void **handler_baton,
                         svn_stream_t *output,
                         int svndiff_version,
+                        int compression_level,
                         apr_pool_t *pool)
 {
   apr_pool_t *subpool = svn_pool_create(pool);
   struct encoder_baton *eb;
 
+  SVN_ERR_ASSERT_NO_RETURN(compression_level
+                             >= SVN_DELTA_COMPRESSION_LEVEL_NONE
+                           && compression_level
+                             <= SVN_DELTA_COMPRESSION_LEVEL_MAX);
+
   eb = apr_palloc(subpool, sizeof(*eb));
   eb->output = output;
   eb->header_done = FALSE;
   eb->pool = subpool;
   eb->version = svndiff_version;
+  eb->compression_level = compression_level;
+  eb->instructions = svn_stringbuf_create_ensure(0, subpool);
+  eb->header = svn_stringbuf_create_ensure(5 * MAX_ENCODED_INT_LEN,
+                                           subpool);
+  eb->compressed_instructions = svn_stringbuf_create_ensure(0, subpool);
+  eb->compressed_data = svn_stringbuf_create_ensure(0, subpool);
 
   *handler = window_handler;
   *handler_baton = eb;
 }
 
+void
+svn_txdelta_to_svndiff2(svn_txdelta_window_handler_t *handler,
+                        void **handler_baton,
+                        svn_stream_t *output,
+                        int svndiff_version,
+                        apr_pool_t *pool)
+{
+  svn_txdelta_to_svndiff3(handler, handler_baton, output, svndiff_version,
+                          SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, pool);
+}
+
 void
 svn_txdelta_to_svndiff(svn_stream_t *output,
                        apr_pool_t *pool,
@@ -312,6 +356,29 @@ svn_txdelta_to_svndiff(svn_stream_t *output,
 
 /* ----- svndiff to text delta ----- */
 
+/* The number of windows that may be queued for decoding on the decoder
+   thread ahead of the one to be passed to the consumer next. */
+#define PIPELINE_DEPTH 4
+
+/* A window queued for decoding on the decoder thread, allocated in its
+   pipeline slot's pool along with everything it refers to. */
+typedef struct pending_window_t
+{
+  /* The window header, the svndiff version and the still encoded
+     instructions and new data. */
+  svn_filesize_t sview_offset;
+  apr_size_t sview_len;
+  apr_size_t tview_len;
+  apr_size_t inslen;
+  apr_size_t newlen;
+  unsigned char version;
+  const unsigned char *data;
+
+  /* The decoded window and the pool it gets allocated in. */
+  svn_txdelta_window_t window;
+  apr_pool_t *pool;
+} pending_window_t;
+
 /* An svndiff parser object.  */
 struct decode_baton
 {
@@ -324,10 +391,10 @@ struct decode_baton
      subpool.  */
   apr_pool_t *pool;
 
-  /* The current subpool which contains our current window-buffer.  */
+  /* Pool for decoding the current window, cleared after each window.  */
   apr_pool_t *subpool;
 
-  /* The actual svndiff data buffer, living within subpool.  */
+  /* The svndiff data not passed on yet, living within POOL.  */
   svn_stringbuf_t *buffer;
 
   /* The offset and size of the last source view, so that we can check
@@ -347,6 +414,22 @@ struct decode_baton
 
   /* svndiff version in use by delta.  */
   unsigned char version;
+
+  /* Whether windows after the first one should be decoded on a
+     separate thread, and the number of windows seen so far. */
+  svn_boolean_t decode_concurrently;
+  apr_uint64_t windows;
+
+  /* If not NULL, windows get decoded on a separate thread.  QUEUED
+     windows have been queued on it, CONSUMED of them have been passed to
+     the consumer. */
+  svn_pipeline__t *pipeline;
+  apr_uint64_t queued;
+  apr_uint64_t consumed;
+
+  /* Set once a window from the pipeline failed to decode or to be
+     consumed.  Nothing after it gets passed to the consumer. */
+  svn_boolean_t failed;
 };
 
 
@@ -616,7 +699,7 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
 
       ndin = svn_stringbuf_ncreate((const char *)insend, newlen, pool);
       ndout = svn_stringbuf_create("", pool);
-      SVN_ERR(zlib_decode(ndin, ndout, SVN_DELTA_WINDOW_SIZE));
+      SVN_ERR(zlib_decode(ndin, ndout, SVN_DELTA_MAX_WINDOW_SIZE));
 
       newlen = ndout->len;
       data = (unsigned char *)instout->data;
@@ -659,13 +742,94 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_pipeline__process_t, decoding the pending_window_t
+   ITEM into its own pool. */
+static svn_error_t *
+decode_queued(void *baton,
+              void *item,
+              apr_pool_t *scratch_pool)
+{
+  pending_window_t *pw = item;
+
+  return svn_error_return(decode_window(&pw->window, pw->sview_offset,
+                                        pw->sview_len, pw->tview_len,
+                                        pw->inslen, pw->newlen, pw->data,
+                                        pw->pool, pw->version));
+}
+
+/* Pass the windows decoded by DB's pipeline to the consumer, in order,
+   until no more than MAX_PENDING are left in the pipeline.  Wait for
+   the decoder thread if necessary. */
+static svn_error_t *
+consume_decoded_windows(struct decode_baton *db,
+                        apr_uint64_t max_pending)
+{
+  if (db->failed)
+    return svn_error_create(SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
+                            _("Svndiff data contains corrupt window"));
+
+  while (db->queued - db->consumed > max_pending)
+    {
+      void *item;
+      svn_error_t *err;
+
+      err = svn_pipeline__wait(&item, db->pipeline, db->consumed);
+      if (! err)
+        err = db->consumer_func(&((pending_window_t *) item)->window,
+                                db->consumer_baton);
+      if (err)
+        {
+          db->failed = TRUE;
+          return svn_error_return(err);
+        }
+
+      db->consumed++;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue the window with the given header fields, whose instructions and
+   new data start at DATA, for decoding by DB's pipeline.  Pass windows
+   to the consumer as long as more than PIPELINE_DEPTH - 1 are pending,
+   so that the slot of the next window is free. */
+static svn_error_t *
+queue_window(struct decode_baton *db,
+             svn_filesize_t sview_offset,
+             apr_size_t sview_len,
+             apr_size_t tview_len,
+             apr_size_t inslen,
+             apr_size_t newlen,
+             const unsigned char *data)
+{
+  apr_pool_t *slot_pool;
+  pending_window_t *pw;
+
+  SVN_ERR(svn_pipeline__next_slot(&slot_pool, db->pipeline));
+
+  pw = apr_palloc(slot_pool, sizeof(*pw));
+  pw->sview_offset = sview_offset;
+  pw->sview_len = sview_len;
+  pw->tview_len = tview_len;
+  pw->inslen = inslen;
+  pw->newlen = newlen;
+  pw->version = db->version;
+  pw->data = apr_pmemdup(slot_pool, data, inslen + newlen);
+  pw->pool = slot_pool;
+
+  svn_pipeline__queue(db->pipeline, pw);
+  db->queued++;
+
+  return svn_error_return(consume_decoded_windows(db, PIPELINE_DEPTH - 1));
+}
+
 static svn_error_t *
 write_handler(void *baton,
               const char *buffer,
               apr_size_t *len)
 {
   struct decode_baton *db = (struct decode_baton *) baton;
-  const unsigned char *p, *end;
+  const unsigned char *p, *start, *end;
   svn_filesize_t sview_offset;
   apr_size_t sview_len, tview_len, inslen, newlen, remaining;
   apr_size_t buflen = *len;
@@ -699,43 +863,45 @@ write_handler(void *baton,
      b) a non-integral number of windows' worth of data - we shall
         consume the integral portion of the window data, and then
         somewhere in the following loop the decoding of the svndiff
-        data will run out of stuff to decode, and will simply return
-        SVN_NO_ERROR, anxiously awaiting more data.
+        data will run out of stuff to decode, and will simply wait
+        for more data.
+
+     Windows are decoded from where the previous one ended, and only
+     the incomplete rest gets moved to the start of the buffer when
+     we are done, so the buffer can be reused for all windows.
   */
+  start = (const unsigned char *) db->buffer->data;
+  end = (const unsigned char *) db->buffer->data + db->buffer->len;
 
   while (1)
     {
-      apr_pool_t *newpool;
       svn_txdelta_window_t window;
 
       /* Read the header, if we have enough bytes for that.  */
-      p = (const unsigned char *) db->buffer->data;
-      end = (const unsigned char *) db->buffer->data + db->buffer->len;
-
-      p = decode_file_offset(&sview_offset, p, end);
+      p = decode_file_offset(&sview_offset, start, end);
       if (p == NULL)
-        return SVN_NO_ERROR;
+        break;
 
       p = decode_size(&sview_len, p, end);
       if (p == NULL)
-        return SVN_NO_ERROR;
+        break;
 
       p = decode_size(&tview_len, p, end);
       if (p == NULL)
-        return SVN_NO_ERROR;
+        break;
 
       p = decode_size(&inslen, p, end);
       if (p == NULL)
-        return SVN_NO_ERROR;
+        break;
 
       p = decode_size(&newlen, p, end);
       if (p == NULL)
-        return SVN_NO_ERROR;
+        break;
 
-      if (tview_len > SVN_DELTA_WINDOW_SIZE ||
-          sview_len > SVN_DELTA_WINDOW_SIZE ||
+      if (tview_len > SVN_DELTA_MAX_WINDOW_SIZE ||
+          sview_len > SVN_DELTA_MAX_WINDOW_SIZE ||
           /* for svndiff1, newlen includes the original length */
-          newlen > SVN_DELTA_WINDOW_SIZE + MAX_ENCODED_INT_LEN ||
+          newlen > SVN_DELTA_MAX_WINDOW_SIZE + MAX_ENCODED_INT_LEN ||
           inslen > MAX_INSTRUCTION_SECTION_LEN)
         return svn_error_create(SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
                                 _("Svndiff contains a too-large window"));
@@ -759,36 +925,49 @@ write_handler(void *baton,
       /* Wait for more data if we don't have enough bytes for the
          whole window.  */
       if ((apr_size_t) (end - p) < inslen + newlen)
-        return SVN_NO_ERROR;
+        break;
+
+      /* Most texts fit into a single window, which isn't worth starting
+         a thread for.  Decode the second and further ones concurrently,
+         if so asked. */
+      if (db->decode_concurrently && ! db->pipeline && db->windows > 0)
+        {
+          db->pipeline = svn_pipeline__start(PIPELINE_DEPTH, 0, decode_queued,
+                                             NULL, db->pool);
+          db->decode_concurrently = FALSE;
+        }
+      db->windows++;
 
       /* Decode the window and send it off. */
-      SVN_ERR(decode_window(&window, sview_offset, sview_len, tview_len,
-                            inslen, newlen, p, db->subpool,
-                            db->version));
-      SVN_ERR(db->consumer_func(&window, db->consumer_baton));
-
-      /* Make a new subpool and buffer, saving aside the remaining
-         data in the old buffer.  */
-      newpool = svn_pool_create(db->pool);
-      p += inslen + newlen;
-      remaining = db->buffer->data + db->buffer->len - (const char *) p;
-      db->buffer =
-        svn_stringbuf_ncreate((const char *) p, remaining, newpool);
+      if (db->pipeline)
+        SVN_ERR(queue_window(db, sview_offset, sview_len, tview_len,
+                             inslen, newlen, p));
+      else
+        {
+          SVN_ERR(decode_window(&window, sview_offset, sview_len, tview_len,
+                                inslen, newlen, p, db->subpool,
+                                db->version));
+          SVN_ERR(db->consumer_func(&window, db->consumer_baton));
+          svn_pool_clear(db->subpool);
+        }
 
       /* Remember the offset and length of the source view for next time.  */
       db->last_sview_offset = sview_offset;
       db->last_sview_len = sview_len;
 
-      /* We've copied stuff out of the old pool. Toss that pool and use
-         our new pool.
-         ### might be nice to avoid the copy and just use svn_pool_clear
-         ### to get rid of whatever the "other stuff" is. future project...
-      */
-      svn_pool_destroy(db->subpool);
-      db->subpool = newpool;
+      start = p + inslen + newlen;
     }
 
-  /* NOTREACHED */
+  /* Keep only the data of the incomplete window.  */
+  remaining = end - start;
+  if (remaining < db->buffer->len)
+    {
+      memmove(db->buffer->data, start, remaining);
+      db->buffer->len = remaining;
+      db->buffer->data[remaining] = '\0';
+    }
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -805,6 +984,10 @@ close_handler(void *baton)
     return svn_error_create(SVN_ERR_SVNDIFF_UNEXPECTED_END, NULL,
                             _("Unexpected end of svndiff input"));
 
+  /* Pass on whatever is still in the pipeline. */
+  if (db->pipeline)
+    SVN_ERR(consume_decoded_windows(db, 0));
+
   /* Tell the window consumer that we're done, and clean up.  */
   err = db->consumer_func(NULL, db->consumer_baton);
   svn_pool_destroy(db->pool);
@@ -813,10 +996,11 @@ close_handler(void *baton)
 
 
 svn_stream_t *
-svn_txdelta_parse_svndiff(svn_txdelta_window_handler_t handler,
-                          void *handler_baton,
-                          svn_boolean_t error_on_early_close,
-                          apr_pool_t *pool)
+svn_txdelta_parse_svndiff2(svn_txdelta_window_handler_t handler,
+                           void *handler_baton,
+                           svn_boolean_t error_on_early_close,
+                           svn_boolean_t decode_concurrently,
+                           apr_pool_t *pool)
 {
   apr_pool_t *subpool = svn_pool_create(pool);
   struct decode_baton *db = apr_palloc(pool, sizeof(*db));
@@ -826,17 +1010,33 @@ svn_txdelta_parse_svndiff(svn_txdelta_window_handler_t handler,
   db->consumer_baton = handler_baton;
   db->pool = subpool;
   db->subpool = svn_pool_create(subpool);
-  db->buffer = svn_stringbuf_create("", db->subpool);
+  db->buffer = svn_stringbuf_create("", subpool);
   db->last_sview_offset = 0;
   db->last_sview_len = 0;
   db->header_bytes = 0;
   db->error_on_early_close = error_on_early_close;
+  db->decode_concurrently = decode_concurrently;
+  db->windows = 0;
+  db->pipeline = NULL;
+  db->queued = 0;
+  db->consumed = 0;
+  db->failed = FALSE;
   stream = svn_stream_create(db, pool);
   svn_stream_set_write(stream, write_handler);
   svn_stream_set_close(stream, close_handler);
   return stream;
 }
 
+svn_stream_t *
+svn_txdelta_parse_svndiff(svn_txdelta_window_handler_t handler,
+                          void *handler_baton,
+                          svn_boolean_t error_on_early_close,
+                          apr_pool_t *pool)
+{
+  return svn_txdelta_parse_svndiff2(handler, handler_baton,
+                                    error_on_early_close, FALSE, pool);
+}
+
 
 /* Routines for reading one svndiff window at a time. */
 
@@ -896,10 +1096,10 @@ read_window_header(svn_stream_t *stream, svn_filesize_t *sview_offset,
   SVN_ERR(read_one_size(inslen, stream));
   SVN_ERR(read_one_size(newlen, stream));
 
-  if (*tview_len > SVN_DELTA_WINDOW_SIZE ||
-      *sview_len > SVN_DELTA_WINDOW_SIZE ||
+  if (*tview_len > SVN_DELTA_MAX_WINDOW_SIZE ||
+      *sview_len > SVN_DELTA_MAX_WINDOW_SIZE ||
       /* for svndiff1, newlen includes the original length */
-      *newlen > SVN_DELTA_WINDOW_SIZE + MAX_ENCODED_INT_LEN ||
+      *newlen > SVN_DELTA_MAX_WINDOW_SIZE + MAX_ENCODED_INT_LEN ||
       *inslen > MAX_INSTRUCTION_SECTION_LEN)
     return svn_error_create(SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
                             _("Svndiff contains a too-large window"));
@@ -939,18 +1139,30 @@ svn_txdelta_read_svndiff_window(svn_txdelta_window_t **window,
 
 
 svn_error_t *
-svn_txdelta_skip_svndiff_window(apr_file_t *file,
-                                int svndiff_version,
-                                apr_pool_t *pool)
+svn_txdelta__skip_svndiff_window(apr_size_t *tview_len,
+                                 apr_file_t *file,
+                                 int svndiff_version,
+                                 apr_pool_t *pool)
 {
   svn_stream_t *stream = svn_stream_from_aprfile2(file, TRUE, pool);
   svn_filesize_t sview_offset;
-  apr_size_t sview_len, tview_len, inslen, newlen;
+  apr_size_t sview_len, inslen, newlen;
   apr_off_t offset;
 
-  SVN_ERR(read_window_header(stream, &sview_offset, &sview_len, &tview_len,
+  SVN_ERR(read_window_header(stream, &sview_offset, &sview_len, tview_len,
                              &inslen, &newlen));
 
   offset = inslen + newlen;
   return svn_io_file_seek(file, APR_CUR, &offset, pool);
 }
+
+svn_error_t *
+svn_txdelta_skip_svndiff_window(apr_file_t *file,
+                                int svndiff_version,
+                                apr_pool_t *pool)
+{
+  apr_size_t tview_len;
+
+  return svn_txdelta__skip_svndiff_window(&tview_len, file, svndiff_version,
+                                          pool);
+}
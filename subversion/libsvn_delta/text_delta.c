@@ -34,6 +34,7 @@
 #include "svn_checksum.h"
 
 #include "delta.h"
+#include "private/svn_delta_private.h"
 
 
 /* Text delta stream descriptor. */
@@ -56,6 +57,8 @@ struct txdelta_baton {
   svn_boolean_t more;           /* TRUE if there are more data in the pool. */
   svn_filesize_t pos;           /* Offset of next read in source file. */
   char *buf;                    /* Buffer for input data. */
+  apr_size_t window_size;       /* Source and target bytes per window. */
+  svn_txdelta__xdelta_blocks_t *blocks; /* Reused for each window. */
 
   svn_checksum_ctx_t *context;  /* Context for computing the checksum. */
   svn_checksum_t *checksum;     /* If non-NULL, the checksum of TARGET. */
@@ -75,6 +78,8 @@ struct tpush_baton {
 
   /* Private data */
   char *buf;
+  apr_size_t window_size;
+  svn_txdelta__xdelta_blocks_t *blocks;
   svn_filesize_t source_offset;
   apr_size_t source_len;
   svn_boolean_t source_done;
@@ -141,10 +146,12 @@ svn_txdelta__make_window(const svn_txdelta__ops_baton_t *build_baton,
 /* Compute and return a delta window using the xdelta algorithm on
    DATA, which contains SOURCE_LEN bytes of source data and TARGET_LEN
    bytes of target data.  SOURCE_OFFSET gives the offset of the source
-   data, and is simply copied into the window's sview_offset field. */
+   data, and is simply copied into the window's sview_offset field.
+   BLOCKS is the block table to use for xdelta. */
 static svn_txdelta_window_t *
 compute_window(const char *data, apr_size_t source_len, apr_size_t target_len,
-               svn_filesize_t source_offset, apr_pool_t *pool)
+               svn_filesize_t source_offset,
+               svn_txdelta__xdelta_blocks_t *blocks, apr_pool_t *pool)
 {
   svn_txdelta__ops_baton_t build_baton = { 0 };
   svn_txdelta_window_t *window;
@@ -156,7 +163,8 @@ compute_window(const char *data, apr_size_t source_len, apr_size_t target_len,
     svn_txdelta__insert_op(&build_baton, svn_txdelta_new, 0, target_len, data,
                            pool);
   else
-    svn_txdelta__xdelta(&build_baton, data, source_len, target_len, pool);
+    svn_txdelta__xdelta(&build_baton, data, source_len, target_len, blocks,
+                        pool);
 
   /* Create and return the delta window. */
   window = svn_txdelta__make_window(&build_baton, pool);
@@ -317,14 +325,14 @@ txdelta_next_window(svn_txdelta_window_t **window,
                     apr_pool_t *pool)
 {
   struct txdelta_baton *b = baton;
-  apr_size_t source_len = SVN_DELTA_WINDOW_SIZE;
-  apr_size_t target_len = SVN_DELTA_WINDOW_SIZE;
+  apr_size_t source_len = b->window_size;
+  apr_size_t target_len = b->window_size;
 
   /* Read the source stream. */
   if (b->more_source)
     {
       SVN_ERR(svn_stream_read(b->source, b->buf, &source_len));
-      b->more_source = (source_len == SVN_DELTA_WINDOW_SIZE);
+      b->more_source = (source_len == b->window_size);
     }
   else
     source_len = 0;
@@ -347,7 +355,7 @@ txdelta_next_window(svn_txdelta_window_t **window,
     SVN_ERR(svn_checksum_update(b->context, b->buf + source_len, target_len));
 
   *window = compute_window(b->buf, source_len, target_len,
-                           b->pos - source_len, pool);
+                           b->pos - source_len, b->blocks, pool);
 
   /* That's it. */
   return SVN_NO_ERROR;
@@ -389,7 +397,10 @@ svn_txdelta_run(svn_stream_t *source,
   tb.more_source = TRUE;
   tb.more = TRUE;
   tb.pos = 0;
+  tb.window_size = SVN_DELTA_WINDOW_SIZE;
   tb.buf = apr_palloc(scratch_pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  tb.blocks = svn_txdelta__xdelta_blocks_create(SVN_DELTA_WINDOW_SIZE,
+                                                scratch_pool);
   tb.result_pool = result_pool;
 
   if (checksum != NULL)
@@ -421,18 +432,25 @@ svn_txdelta_run(svn_stream_t *source,
 
 
 void
-svn_txdelta(svn_txdelta_stream_t **stream,
-            svn_stream_t *source,
-            svn_stream_t *target,
-            apr_pool_t *pool)
+svn_txdelta2(svn_txdelta_stream_t **stream,
+             svn_stream_t *source,
+             svn_stream_t *target,
+             apr_size_t window_size,
+             apr_pool_t *pool)
 {
   struct txdelta_baton *b = apr_pcalloc(pool, sizeof(*b));
 
+  if (window_size == 0)
+    window_size = SVN_DELTA_WINDOW_SIZE;
+  SVN_ERR_ASSERT_NO_RETURN(window_size <= SVN_DELTA_MAX_WINDOW_SIZE);
+
   b->source = source;
   b->target = target;
   b->more_source = TRUE;
   b->more = TRUE;
-  b->buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  b->window_size = window_size;
+  b->buf = apr_palloc(pool, 2 * window_size);
+  b->blocks = svn_txdelta__xdelta_blocks_create(window_size, pool);
   b->context = svn_checksum_ctx_create(svn_checksum_md5, pool);
   b->result_pool = pool;
 
@@ -440,6 +458,106 @@ svn_txdelta(svn_txdelta_stream_t **stream,
                                       txdelta_md5_digest, pool);
 }
 
+void
+svn_txdelta(svn_txdelta_stream_t **stream,
+            svn_stream_t *source,
+            svn_stream_t *target,
+            apr_pool_t *pool)
+{
+  svn_txdelta2(stream, source, target, SVN_DELTA_WINDOW_SIZE, pool);
+}
+
+
+/* Baton for a delta stream against the empty source. */
+struct fulltext_baton {
+  svn_stream_t *target;
+  apr_size_t window_size;
+  svn_boolean_t more;           /* TRUE until TARGET hit EOF. */
+  svn_checksum_ctx_t *context;  /* Context for computing the checksum. */
+  svn_checksum_t *checksum;     /* Set once TARGET hit EOF. */
+  apr_pool_t *result_pool;      /* For the checksum. */
+};
+
+/* Implements svn_txdelta_next_window_fn_t.  Every window is a single
+   `new' op whose data is read straight into the window's own buffer. */
+static svn_error_t *
+fulltext_next_window(svn_txdelta_window_t **window,
+                     void *baton,
+                     apr_pool_t *pool)
+{
+  struct fulltext_baton *b = baton;
+  apr_size_t len = b->window_size;
+  char *buf;
+  svn_txdelta_window_t *w;
+  svn_txdelta_op_t *op;
+  svn_string_t *new_data;
+
+  if (! b->more)
+    {
+      *window = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  buf = apr_palloc(pool, len);
+  SVN_ERR(svn_stream_read(b->target, buf, &len));
+  if (len == 0)
+    {
+      SVN_ERR(svn_checksum_final(&b->checksum, b->context, b->result_pool));
+      b->more = FALSE;
+      *window = NULL;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(svn_checksum_update(b->context, buf, len));
+
+  op = apr_palloc(pool, sizeof(*op));
+  op->action_code = svn_txdelta_new;
+  op->offset = 0;
+  op->length = len;
+
+  new_data = apr_palloc(pool, sizeof(*new_data));
+  new_data->data = buf;
+  new_data->len = len;
+
+  w = apr_pcalloc(pool, sizeof(*w));
+  w->tview_len = len;
+  w->num_ops = 1;
+  w->ops = op;
+  w->new_data = new_data;
+
+  *window = w;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_md5_digest_fn_t. */
+static const unsigned char *
+fulltext_md5_digest(void *baton)
+{
+  struct fulltext_baton *b = baton;
+
+  return b->checksum ? b->checksum->digest : NULL;
+}
+
+svn_txdelta_stream_t *
+svn_txdelta__fulltext_stream(svn_stream_t *target,
+                             apr_size_t window_size,
+                             apr_pool_t *pool)
+{
+  struct fulltext_baton *b = apr_pcalloc(pool, sizeof(*b));
+
+  if (window_size == 0)
+    window_size = SVN_DELTA_WINDOW_SIZE;
+  SVN_ERR_ASSERT_NO_RETURN(window_size <= SVN_DELTA_MAX_WINDOW_SIZE);
+
+  b->target = target;
+  b->window_size = window_size;
+  b->more = TRUE;
+  b->context = svn_checksum_ctx_create(svn_checksum_md5, pool);
+  b->result_pool = pool;
+
+  return svn_txdelta_stream_create(b, fulltext_next_window,
+                                   fulltext_md5_digest, pool);
+}
+
 
 
 /* Functions for implementing a "target push" delta. */
@@ -462,14 +580,14 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
       /* Make sure we're all full up on source data, if possible. */
       if (tb->source_len == 0 && !tb->source_done)
         {
-          tb->source_len = SVN_DELTA_WINDOW_SIZE;
+          tb->source_len = tb->window_size;
           SVN_ERR(svn_stream_read(tb->source, tb->buf, &tb->source_len));
-          if (tb->source_len < SVN_DELTA_WINDOW_SIZE)
+          if (tb->source_len < tb->window_size)
             tb->source_done = TRUE;
         }
 
-      /* Copy in the target data, up to SVN_DELTA_WINDOW_SIZE. */
-      chunk_len = SVN_DELTA_WINDOW_SIZE - tb->target_len;
+      /* Copy in the target data, up to the window size. */
+      chunk_len = tb->window_size - tb->target_len;
       if (chunk_len > data_len)
         chunk_len = data_len;
       memcpy(tb->buf + tb->source_len + tb->target_len, data, chunk_len);
@@ -478,10 +596,10 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
       tb->target_len += chunk_len;
 
       /* If we're full of target data, compute and fire off a window. */
-      if (tb->target_len == SVN_DELTA_WINDOW_SIZE)
+      if (tb->target_len == tb->window_size)
         {
           window = compute_window(tb->buf, tb->source_len, tb->target_len,
-                                  tb->source_offset, pool);
+                                  tb->source_offset, tb->blocks, pool);
           SVN_ERR(tb->wh(window, tb->whb));
           tb->source_offset += tb->source_len;
           tb->source_len = 0;
@@ -507,7 +625,7 @@ tpush_close_handler(void *baton)
   if (tb->target_len > 0)
     {
       window = compute_window(tb->buf, tb->source_len, tb->target_len,
-                              tb->source_offset, tb->pool);
+                              tb->source_offset, tb->blocks, tb->pool);
       SVN_ERR(tb->wh(window, tb->whb));
     }
 
@@ -517,20 +635,27 @@ tpush_close_handler(void *baton)
 
 
 svn_stream_t *
-svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
-                        void *handler_baton, svn_stream_t *source,
-                        apr_pool_t *pool)
+svn_txdelta_target_push2(svn_txdelta_window_handler_t handler,
+                         void *handler_baton, svn_stream_t *source,
+                         apr_size_t window_size,
+                         apr_pool_t *pool)
 {
   struct tpush_baton *tb;
   svn_stream_t *stream;
 
+  if (window_size == 0)
+    window_size = SVN_DELTA_WINDOW_SIZE;
+  SVN_ERR_ASSERT_NO_RETURN(window_size <= SVN_DELTA_MAX_WINDOW_SIZE);
+
   /* Initialize baton. */
   tb = apr_palloc(pool, sizeof(*tb));
   tb->source = source;
   tb->wh = handler;
   tb->whb = handler_baton;
   tb->pool = pool;
-  tb->buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  tb->window_size = window_size;
+  tb->buf = apr_palloc(pool, 2 * window_size);
+  tb->blocks = svn_txdelta__xdelta_blocks_create(window_size, pool);
   tb->source_offset = 0;
   tb->source_len = 0;
   tb->source_done = FALSE;
@@ -543,8 +668,17 @@ svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
   return stream;
 }
 
+svn_stream_t *
+svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
+                        void *handler_baton, svn_stream_t *source,
+                        apr_pool_t *pool)
+{
+  return svn_txdelta_target_push2(handler, handler_baton, source,
+                                  SVN_DELTA_WINDOW_SIZE, pool);
+}
+
+
 
-
 /* Functions for applying deltas.  */
 
 /* Ensure that BUF has enough space for VIEW_LEN bytes.  */
@@ -635,6 +769,29 @@ svn_txdelta__apply_instructions(svn_txdelta_window_t *window,
 }
 
 
+/* Return TRUE if WINDOW's target view is exactly its new data, i.e.
+   it consists of svn_txdelta_new instructions only, which copy the new
+   data in order. */
+static svn_boolean_t
+is_fulltext_window(const svn_txdelta_window_t *window)
+{
+  const svn_txdelta_op_t *op;
+  apr_size_t tpos = 0;
+
+  if (window->new_data == NULL
+      || window->new_data->len != window->tview_len)
+    return FALSE;
+
+  for (op = window->ops; op < window->ops + window->num_ops; op++)
+    {
+      if (op->action_code != svn_txdelta_new || op->offset != tpos)
+        return FALSE;
+      tpos += op->length;
+    }
+
+  return tpos == window->tview_len;
+}
+
 /* Apply WINDOW to the streams given by APPL.  */
 static svn_error_t *
 apply_window(svn_txdelta_window_t *window, void *baton)
@@ -661,6 +818,17 @@ apply_window(svn_txdelta_window_t *window, void *baton)
                      && (window->sview_offset + window->sview_len
                          >= ab->sbuf_offset + ab->sbuf_len)));
 
+  /* Windows that merely contain the target text, as sent for added files,
+     can be written out directly without assembling them in TBUF. */
+  if (window->sview_len == 0 && is_fulltext_window(window))
+    {
+      len = window->tview_len;
+      if (ab->result_digest)
+        apr_md5_update(&(ab->md5_context), window->new_data->data, len);
+
+      return svn_stream_write(ab->target, window->new_data->data, &len);
+    }
+
   /* Make sure there's enough room in the target buffer.  */
   SVN_ERR(size_buffer(&ab->tbuf, &ab->tbuf_size, window->tview_len, ab->pool));
 
@@ -799,15 +967,10 @@ svn_error_t *svn_txdelta_send_stream(svn_stream_t *stream,
   svn_txdelta_stream_t *txstream;
   svn_error_t *err;
 
-  /* ### this is a hack. we should simply read from the stream, construct
-     ### some windows, and pass those to the handler. there isn't any reason
-     ### to crank up a full "diff" algorithm just to copy a stream.
-     ###
-     ### will fix RSN. */
-
-  /* Create a delta stream which converts an *empty* bytestream into the
-     target bytestream. */
-  svn_txdelta(&txstream, svn_stream_empty(pool), stream, pool);
+  /* Against an empty source, every window is just the stream's data;
+     there is no need to crank up the delta machinery to find that out. */
+  txstream = svn_txdelta__fulltext_stream(stream, SVN_DELTA_WINDOW_SIZE,
+                                          pool);
   err = svn_txdelta_send_txstream(txstream, handler, handler_baton, pool);
 
   if (digest && (! err))
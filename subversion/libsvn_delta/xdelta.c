@@ -23,6 +23,7 @@
 
 
 #include <assert.h>
+#include <string.h>
 
 #include <apr_general.h>        /* for APR_INLINE */
 #include <apr_hash.h>
@@ -80,16 +81,35 @@ adler32_sum(const struct adler32 *ad)
 }
 
 /* Initialize an adler32 checksum structure with DATA, which has length
-   DATALEN.  Return the initialized structure.  */
+   DATALEN.  Return the initialized structure.
+
+   This gives the same result as feeding the bytes through adler32_in()
+   one by one.  Since the sums only matter modulo 2^16, we may let them
+   wrap around and mask them only once at the end.  Four bytes are
+   processed per iteration to shorten the dependency chain on S2.  */
 
 static APR_INLINE struct adler32 *
 init_adler32(struct adler32 *ad, const char *data, apr_uint32_t datalen)
 {
-  ad->s1 = 1;
-  ad->s2 = 0;
-  ad->len = 0;
-  while (datalen--)
-    adler32_in(ad, *(data++));
+  const unsigned char *p = (const unsigned char *)data;
+  apr_uint32_t s1 = 1;
+  apr_uint32_t s2 = 0;
+  apr_uint32_t i = 0;
+
+  for (; i + 4 <= datalen; i += 4, p += 4)
+    {
+      s2 += 4 * s1 + 4 * p[0] + 3 * p[1] + 2 * p[2] + p[3];
+      s1 += p[0] + p[1] + p[2] + p[3];
+    }
+  for (; i < datalen; ++i, ++p)
+    {
+      s1 += *p;
+      s2 += s1;
+    }
+
+  ad->s1 = s1 & ADLER32_MASK;
+  ad->s2 = s2 & ADLER32_MASK;
+  ad->len = datalen;
   return ad;
 }
 
@@ -97,23 +117,36 @@ init_adler32(struct adler32 *ad, const char *data, apr_uint32_t datalen)
    thin air.  Monotone used 64, xdelta1 used 64, rsync uses 128.  */
 #define MATCH_BLOCKSIZE 64
 
+/* Size of a CPU cache line, to which we align the block table. */
+#define CACHE_LINE_SIZE 64
+
 /* Information for a block of the delta source.  The length of the
    block is the smaller of MATCH_BLOCKSIZE and the difference between
-   the size of the source data and the position of this block. */
+   the size of the source data and the position of this block.  Source
+   data never exceeds 4GB, so 32 bits suffice for the position and eight
+   blocks fit into a cache line. */
 struct block
 {
   apr_uint32_t adlersum;
-  apr_size_t pos;
+  apr_uint32_t pos;
 };
 
-/* A hash table, using open addressing, of the blocks of the source. */
-struct blocks
+/* The pos value of an unused slot. */
+#define NO_POSITION ((apr_uint32_t)-1)
+
+/* A hash table, using open addressing, of the blocks of the source.  It
+   gets reused for each window of a delta stream. */
+struct svn_txdelta__xdelta_blocks_t
 {
-  /* The largest valid index of slots. */
+  /* The largest valid index of slots for the current window. */
   apr_size_t max;
-  /* The vector of blocks.  A pos value of (apr_size_t)-1 represents an unused
-     slot. */
+  /* The number of slots allocated, a power of two. */
+  apr_size_t capacity;
+  /* The vector of blocks, aligned to CACHE_LINE_SIZE.  A pos value of
+     NO_POSITION represents an unused slot. */
   struct block *slots;
+  /* Pool to allocate larger slot vectors from. */
+  apr_pool_t *pool;
 };
 
 
@@ -130,12 +163,13 @@ static apr_size_t hash_func(apr_uint32_t sum)
 /* Insert a block with the checksum ADLERSUM at position POS in the source data
    into the table BLOCKS.  Ignore duplicates. */
 static void
-add_block(struct blocks *blocks, apr_uint32_t adlersum, apr_size_t pos)
+add_block(svn_txdelta__xdelta_blocks_t *blocks, apr_uint32_t adlersum,
+          apr_uint32_t pos)
 {
   apr_size_t h = hash_func(adlersum) & blocks->max;
 
   /* This will terminate, since we know that we will not fill the table. */
-  while (blocks->slots[h].pos != (apr_size_t)-1)
+  while (blocks->slots[h].pos != NO_POSITION)
     {
       /* No duplicates! */
       if (blocks->slots[h].adlersum == adlersum)
@@ -147,30 +181,42 @@ add_block(struct blocks *blocks, apr_uint32_t adlersum, apr_size_t pos)
 }
 
 /* Find a block in BLOCKS with the checksum ADLERSUM, returning its position
-   in the source data.  If there is no such block, return (apr_size_t)-1. */
-static apr_size_t
-find_block(const struct blocks *blocks, apr_uint32_t adlersum)
+   in the source data.  If there is no such block, return NO_POSITION. */
+static apr_uint32_t
+find_block(const svn_txdelta__xdelta_blocks_t *blocks, apr_uint32_t adlersum)
 {
   apr_size_t h = hash_func(adlersum) & blocks->max;
 
   while (blocks->slots[h].adlersum != adlersum
-         && blocks->slots[h].pos != (apr_size_t)-1)
+         && blocks->slots[h].pos != NO_POSITION)
     h = (h + 1) & blocks->max;
 
   return blocks->slots[h].pos;
 }
 
-/* Initialize the matches table from DATA of size DATALEN.  This goes
-   through every block of MATCH_BLOCKSIZE bytes in the source and
-   checksums it, inserting the result into the BLOCKS table.  */
+/* Make BLOCKS provide at least NSLOTS slots, a power of two, dropping
+   its current contents if it has to grow. */
 static void
-init_blocks_table(const char *data,
-                   apr_size_t datalen,
-                  struct blocks *blocks,
-                   apr_pool_t *pool)
+ensure_capacity(svn_txdelta__xdelta_blocks_t *blocks, apr_size_t nslots)
+{
+  char *buffer;
+
+  if (nslots <= blocks->capacity)
+    return;
+
+  buffer = apr_palloc(blocks->pool,
+                      nslots * sizeof(*blocks->slots) + CACHE_LINE_SIZE - 1);
+  buffer += (CACHE_LINE_SIZE - (apr_size_t)buffer % CACHE_LINE_SIZE)
+            % CACHE_LINE_SIZE;
+
+  blocks->slots = (struct block *)buffer;
+  blocks->capacity = nslots;
+}
+
+/* Return the number of slots to use for source data of DATALEN bytes. */
+static apr_size_t
+slot_count(apr_size_t datalen)
 {
-  apr_size_t i;
-  struct adler32 adler;
   apr_size_t nblocks;
   apr_size_t nslots = 1;
 
@@ -180,15 +226,39 @@ init_blocks_table(const char *data,
   while (nslots <= nblocks)
     nslots *= 2;
   /* Double the number of slots to avoid a too high load. */
-  nslots *= 2;
+  return nslots * 2;
+}
+
+svn_txdelta__xdelta_blocks_t *
+svn_txdelta__xdelta_blocks_create(apr_size_t max_source_len,
+                                  apr_pool_t *pool)
+{
+  svn_txdelta__xdelta_blocks_t *blocks = apr_pcalloc(pool, sizeof(*blocks));
+
+  blocks->pool = pool;
+  ensure_capacity(blocks, slot_count(max_source_len));
+
+  return blocks;
+}
+
+/* Initialize the matches table BLOCKS from DATA of size DATALEN.  This
+   goes through every block of MATCH_BLOCKSIZE bytes in the source and
+   checksums it, inserting the result into the BLOCKS table.  Only the
+   part of the table needed for DATALEN gets used and cleared.  */
+static void
+init_blocks_table(const char *data,
+                  apr_size_t datalen,
+                  svn_txdelta__xdelta_blocks_t *blocks)
+{
+  apr_size_t i;
+  struct adler32 adler;
+  apr_size_t nslots = slot_count(datalen);
+
+  ensure_capacity(blocks, nslots);
   blocks->max = nslots - 1;
-  blocks->slots = apr_palloc(pool, nslots * sizeof(*(blocks->slots)));
-  for (i = 0; i < nslots; ++i)
-    {
-      /* Avoid using an indeterminate value in the lookup. */
-      blocks->slots[i].adlersum = 0;
-      blocks->slots[i].pos = (apr_size_t)-1;
-    }
+
+  /* All bits set marks a slot as unused. */
+  memset(blocks->slots, 0xff, nslots * sizeof(*blocks->slots));
 
   for (i = 0; i < datalen; i += MATCH_BLOCKSIZE)
     {
@@ -197,8 +267,57 @@ init_blocks_table(const char *data,
         ((i + MATCH_BLOCKSIZE) >= datalen) ? (datalen - i) : MATCH_BLOCKSIZE;
       apr_uint32_t adlersum =
         adler32_sum(init_adler32(&adler, data + i, step));
-      add_block(blocks, adlersum, i);
+      add_block(blocks, adlersum, (apr_uint32_t)i);
+    }
+}
+
+/* Return the number of leading bytes that A and B have in common,
+   comparing at most MAX_LEN bytes.  Whole machine words are compared
+   at once where possible.  */
+static APR_INLINE apr_size_t
+match_length(const char *a, const char *b, apr_size_t max_len)
+{
+  apr_size_t pos = 0;
+
+  for (; pos + sizeof(apr_size_t) <= max_len; pos += sizeof(apr_size_t))
+    {
+      apr_size_t a_word, b_word;
+
+      /* Compilers turn these into plain (unaligned) loads. */
+      memcpy(&a_word, a + pos, sizeof(a_word));
+      memcpy(&b_word, b + pos, sizeof(b_word));
+      if (a_word != b_word)
+        break;
     }
+
+  while (pos < max_len && a[pos] == b[pos])
+    ++pos;
+
+  return pos;
+}
+
+/* Return the number of bytes immediately before A and B that they have
+   in common, comparing at most MAX_LEN bytes.  This is the backward
+   counterpart to match_length().  */
+static APR_INLINE apr_size_t
+reverse_match_length(const char *a, const char *b, apr_size_t max_len)
+{
+  apr_size_t len = 0;
+
+  for (; len + sizeof(apr_size_t) <= max_len; len += sizeof(apr_size_t))
+    {
+      apr_size_t a_word, b_word;
+
+      memcpy(&a_word, a - len - sizeof(a_word), sizeof(a_word));
+      memcpy(&b_word, b - len - sizeof(b_word), sizeof(b_word));
+      if (a_word != b_word)
+        break;
+    }
+
+  while (len < max_len && *(a - len - 1) == *(b - len - 1))
+    ++len;
+
+  return len;
 }
 
 /* Try to find a match for the target data B in BLOCKS, and then
@@ -214,7 +333,7 @@ init_blocks_table(const char *data,
    lookup found a match, regardless of length.  Return FALSE
    otherwise.  */
 static svn_boolean_t
-find_match(const struct blocks *blocks,
+find_match(const svn_txdelta__xdelta_blocks_t *blocks,
            const struct adler32 *rolling,
            const char *a,
            apr_size_t asize,
@@ -228,18 +347,24 @@ find_match(const struct blocks *blocks,
 {
   apr_uint32_t sum = adler32_sum(rolling);
   apr_size_t alen, badvance, apos;
-  apr_size_t tpos, tlen;
+  apr_size_t tpos, tlen, max_len;
+  apr_uint32_t block_pos;
 
-  tpos = find_block(blocks, sum);
+  block_pos = find_block(blocks, sum);
 
   /* See if we have a match.  */
-  if (tpos == (apr_size_t)-1)
+  if (block_pos == NO_POSITION)
     return FALSE;
 
+  tpos = block_pos;
+
   tlen = ((tpos + MATCH_BLOCKSIZE) >= asize)
     ? (asize - tpos) : MATCH_BLOCKSIZE;
 
-  /* Make sure it's not a false match.  */
+  /* Make sure it's not a false match.  Near the end of B, the rolling
+     checksum covers less than a full block. */
+  if (tlen > bsize - bpos)
+    return FALSE;
   if (memcmp(a + tpos, b + bpos, tlen) != 0)
     return FALSE;
 
@@ -247,25 +372,23 @@ find_match(const struct blocks *blocks,
   alen = tlen;
   badvance = tlen;
   /* Extend the match forward as far as possible */
-  while ((apos + alen < asize)
-         && (bpos + badvance < bsize)
-         && (a[apos + alen] == b[bpos + badvance]))
-    {
-      ++alen;
-      ++badvance;
-    }
+  max_len = asize - (apos + alen);
+  if (bsize - (bpos + badvance) < max_len)
+    max_len = bsize - (bpos + badvance);
+  max_len = match_length(a + apos + alen, b + bpos + badvance, max_len);
+  alen += max_len;
+  badvance += max_len;
 
   /* See if we can extend backwards into a previous insert hunk.  */
-  while (apos > 0
-         && bpos > 0
-         && a[apos - 1] == b[bpos - 1]
-         && *pending_insert_lenp > 0)
-    {
-      --(*pending_insert_lenp);
-      --apos;
-      --bpos;
-      ++alen;
-    }
+  max_len = *pending_insert_lenp;
+  if (apos < max_len)
+    max_len = apos;
+  if (bpos < max_len)
+    max_len = bpos;
+  max_len = reverse_match_length(a + apos, b + bpos, max_len);
+  *pending_insert_lenp -= max_len;
+  apos -= max_len;
+  alen += max_len;
 
   *aposp = apos;
   *alenp = alen;
@@ -297,6 +420,8 @@ find_match(const struct blocks *blocks,
    2. So that we can extend a source match backwards into a pending
      insert operation, and possibly remove the need for the insert
      entirely.  This can happen due to stream alignment.
+
+   BLOCKS is used as the match table.
 */
 static void
 compute_delta(svn_txdelta__ops_baton_t *build_baton,
@@ -304,9 +429,9 @@ compute_delta(svn_txdelta__ops_baton_t *build_baton,
               apr_uint32_t asize,
               const char *b,
               apr_uint32_t bsize,
+              svn_txdelta__xdelta_blocks_t *blocks,
               apr_pool_t *pool)
 {
-  struct blocks blocks;
   struct adler32 rolling;
   apr_size_t sz, lo, pending_insert_start = 0, pending_insert_len = 0;
 
@@ -320,7 +445,7 @@ compute_delta(svn_txdelta__ops_baton_t *build_baton,
     }
 
   /* Initialize the matches table.  */
-  init_blocks_table(a, asize, &blocks, pool);
+  init_blocks_table(a, asize, blocks);
 
   /* Initialize our rolling checksum.  */
   init_adler32(&rolling, b, MATCH_BLOCKSIZE);
@@ -332,7 +457,7 @@ compute_delta(svn_txdelta__ops_baton_t *build_baton,
       apr_size_t next;
       svn_boolean_t match;
 
-      match = find_match(&blocks, &rolling, a, asize, b, bsize, lo, &apos,
+      match = find_match(blocks, &rolling, a, asize, b, bsize, lo, &apos,
                          &alen, &badvance, &pending_insert_len);
 
       /* If we didn't find a real match, insert the byte at the target
@@ -354,13 +479,24 @@ compute_delta(svn_txdelta__ops_baton_t *build_baton,
           svn_txdelta__insert_op(build_baton, svn_txdelta_source,
                                  apos, alen, NULL, pool);
         }
-      next = lo;
-      for (; next < lo + badvance; ++next)
+      /* Advance the rolling checksum.  After a long match, it is
+         cheaper to start over at the new position. */
+      next = lo + badvance;
+      if (badvance >= MATCH_BLOCKSIZE)
         {
-          adler32_out(&rolling, b[next]);
-          if (next + MATCH_BLOCKSIZE < bsize)
-            adler32_in(&rolling, b[next + MATCH_BLOCKSIZE]);
+          if (next < bsize)
+            init_adler32(&rolling, b + next,
+                         (next + MATCH_BLOCKSIZE < bsize)
+                           ? MATCH_BLOCKSIZE
+                           : (apr_uint32_t)(bsize - next));
         }
+      else
+        for (; lo < next; ++lo)
+          {
+            adler32_out(&rolling, b[lo]);
+            if (lo + MATCH_BLOCKSIZE < bsize)
+              adler32_in(&rolling, b[lo + MATCH_BLOCKSIZE]);
+          }
       lo = next;
     }
 
@@ -378,13 +514,17 @@ svn_txdelta__xdelta(svn_txdelta__ops_baton_t *build_baton,
                     const char *data,
                     apr_size_t source_len,
                     apr_size_t target_len,
+                    svn_txdelta__xdelta_blocks_t *blocks,
                     apr_pool_t *pool)
 {
   /*  We should never be asked to compute something when the source_len is 0;
       we just use a single insert op there (and rely on zlib for
       compression). */
   assert(source_len != 0);
+  if (blocks == NULL)
+    blocks = svn_txdelta__xdelta_blocks_create(source_len, pool);
+
   compute_delta(build_baton, data, source_len,
                 data + source_len, target_len,
-                pool);
+                blocks, pool);
 }
@@ -42,6 +42,137 @@
 
 /*** Code. ***/
 
+/*** From diff.c, diff3.c and diff4.c ***/
+
+/* Baton for using a #svn_diff_fns_t vtable through #svn_diff_fns2_t. */
+typedef struct fns_wrapper_baton_t
+{
+  void *old_baton;
+  const svn_diff_fns_t *vtable;
+} fns_wrapper_baton_t;
+
+/* Implements svn_diff_fns2_t::datasources_open by opening each datasource
+   on its own.  No identical prefix or suffix is ever reported. */
+static svn_error_t *
+datasources_open(void *baton,
+                 apr_off_t *prefix_lines,
+                 apr_off_t *suffix_lines,
+                 const svn_diff_datasource_e *datasources,
+                 apr_size_t datasources_len)
+{
+  fns_wrapper_baton_t *fwb = baton;
+  apr_size_t i;
+
+  for (i = 0; i < datasources_len; i++)
+    SVN_ERR(fwb->vtable->datasource_open(fwb->old_baton, datasources[i]));
+
+  if (prefix_lines)
+    *prefix_lines = 0;
+  if (suffix_lines)
+    *suffix_lines = 0;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+datasource_close(void *baton,
+                 svn_diff_datasource_e datasource)
+{
+  fns_wrapper_baton_t *fwb = baton;
+  return fwb->vtable->datasource_close(fwb->old_baton, datasource);
+}
+
+static svn_error_t *
+datasource_get_next_token(apr_uint32_t *hash,
+                          void **token,
+                          void *baton,
+                          svn_diff_datasource_e datasource)
+{
+  fns_wrapper_baton_t *fwb = baton;
+  return fwb->vtable->datasource_get_next_token(hash, token, fwb->old_baton,
+                                                datasource);
+}
+
+static svn_error_t *
+token_compare(void *baton,
+              void *ltoken,
+              void *rtoken,
+              int *compare)
+{
+  fns_wrapper_baton_t *fwb = baton;
+  return fwb->vtable->token_compare(fwb->old_baton, ltoken, rtoken, compare);
+}
+
+static void
+token_discard(void *baton,
+              void *token)
+{
+  fns_wrapper_baton_t *fwb = baton;
+  if (fwb->vtable->token_discard != NULL)
+    fwb->vtable->token_discard(fwb->old_baton, token);
+}
+
+static void
+token_discard_all(void *baton)
+{
+  fns_wrapper_baton_t *fwb = baton;
+  if (fwb->vtable->token_discard_all != NULL)
+    fwb->vtable->token_discard_all(fwb->old_baton);
+}
+
+static const svn_diff_fns2_t fns_wrapper_vtable =
+{
+  datasources_open,
+  datasource_close,
+  datasource_get_next_token,
+  token_compare,
+  token_discard,
+  token_discard_all
+};
+
+svn_error_t *
+svn_diff_diff(svn_diff_t **diff,
+              void *diff_baton,
+              const svn_diff_fns_t *vtable,
+              apr_pool_t *pool)
+{
+  fns_wrapper_baton_t fwb;
+
+  fwb.old_baton = diff_baton;
+  fwb.vtable = vtable;
+
+  return svn_diff_diff_2(diff, &fwb, &fns_wrapper_vtable, pool);
+}
+
+svn_error_t *
+svn_diff_diff3(svn_diff_t **diff,
+               void *diff_baton,
+               const svn_diff_fns_t *vtable,
+               apr_pool_t *pool)
+{
+  fns_wrapper_baton_t fwb;
+
+  fwb.old_baton = diff_baton;
+  fwb.vtable = vtable;
+
+  return svn_diff_diff3_2(diff, &fwb, &fns_wrapper_vtable, pool);
+}
+
+svn_error_t *
+svn_diff_diff4(svn_diff_t **diff,
+               void *diff_baton,
+               const svn_diff_fns_t *vtable,
+               apr_pool_t *pool)
+{
+  fns_wrapper_baton_t fwb;
+
+  fwb.old_baton = diff_baton;
+  fwb.vtable = vtable;
+
+  return svn_diff_diff4_2(diff, &fwb, &fns_wrapper_vtable, pool);
+}
+
+
 /*** From diff_file.c ***/
 svn_error_t *
 svn_diff_file_output_unified2(svn_stream_t *output_stream,
@@ -88,9 +88,19 @@ typedef enum svn_diff__normalize_state_t
 } svn_diff__normalize_state_t;
 
 
+/*
+ * Calculate the Longest Common Subsequence between two datasources.
+ * PREFIX_LINES and SUFFIX_LINES are the number of identical lines at the
+ * start and at the end of both datasources that are not part of the
+ * position lists; they are added to the result as common segments.
+ * ALGORITHM selects how the common segments in between are found.
+ */
 svn_diff__lcs_t *
 svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
               svn_diff__position_t *position_list2, /* pointer to tail (ring) */
+              apr_off_t prefix_lines,
+              apr_off_t suffix_lines,
+              svn_diff_file_algorithm_t algorithm,
               apr_pool_t *pool);
 
 
@@ -102,18 +112,45 @@ svn_diff__tree_create(svn_diff__tree_t **tree, apr_pool_t *pool);
 
 
 /*
- * Get all tokens from a datasource.  Return the
+ * Get all tokens from the already opened DATASOURCE and close it.
+ * The first token gets offset PREFIX_LINES + 1.  Return the
  * last item in the (circular) list.
  */
 svn_error_t *
 svn_diff__get_tokens(svn_diff__position_t **position_list,
                      svn_diff__tree_t *tree,
                      void *diff_baton,
-                     const svn_diff_fns_t *vtable,
+                     const svn_diff_fns2_t *vtable,
                      svn_diff_datasource_e datasource,
+                     apr_off_t prefix_lines,
                      apr_pool_t *pool);
 
 
+/* The implementations of svn_diff_diff_2(), svn_diff_diff3_2() and
+ * svn_diff_diff4_2(), finding the common lines with ALGORITHM.
+ */
+svn_error_t *
+svn_diff__diff_2(svn_diff_t **diff,
+                 void *diff_baton,
+                 const svn_diff_fns2_t *vtable,
+                 svn_diff_file_algorithm_t algorithm,
+                 apr_pool_t *pool);
+
+svn_error_t *
+svn_diff__diff3_2(svn_diff_t **diff,
+                  void *diff_baton,
+                  const svn_diff_fns2_t *vtable,
+                  svn_diff_file_algorithm_t algorithm,
+                  apr_pool_t *pool);
+
+svn_error_t *
+svn_diff__diff4_2(svn_diff_t **diff,
+                  void *diff_baton,
+                  const svn_diff_fns2_t *vtable,
+                  svn_diff_file_algorithm_t algorithm,
+                  apr_pool_t *pool);
+
+
 /* Morph a svn_lcs_t into a svn_diff_t. */
 svn_diff_t *
 svn_diff__diff(svn_diff__lcs_t *lcs,
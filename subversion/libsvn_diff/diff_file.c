@@ -72,6 +72,11 @@ typedef struct svn_diff__file_baton_t
   apr_file_t *file[4];
   apr_off_t size[4];
 
+  /* Whether the files are in memory as a whole rather than being read
+   * chunk by chunk.  In that case BUFFER holds the entire file and CHUNK
+   * is always 0. */
+  svn_boolean_t whole;
+
   int chunk[4];
   char *buffer[4];
   char *curp[4];
@@ -198,18 +203,18 @@ map_or_read_file(apr_file_t **file,
 }
 
 
-/* Implements svn_diff_fns_t::datasource_open */
+/* Files of up to this size are tokenized from memory as a whole,
+ * mapping them if possible.  Larger files are read chunk by chunk.
+ */
+#define WHOLE_FILE_MAX_SIZE (64 * 1024 * 1024)
+
+/* Open the file of the datasource with index IDX in FILE_BATON and get
+ * its size.
+ */
 static svn_error_t *
-datasource_open(void *baton, svn_diff_datasource_e datasource)
+open_datasource(svn_diff__file_baton_t *file_baton, int idx)
 {
-  svn_diff__file_baton_t *file_baton = baton;
-  int idx;
   apr_finfo_t finfo;
-  apr_off_t length;
-  char *curp;
-  char *endp;
-
-  idx = datasource_to_index(datasource);
 
   SVN_ERR(svn_io_file_open(&file_baton->file[idx], file_baton->path[idx],
                            APR_READ, APR_OS_DEFAULT, file_baton->pool));
@@ -218,7 +223,71 @@ datasource_open(void *baton, svn_diff_datasource_e datasource)
                                file_baton->file[idx], file_baton->pool));
 
   file_baton->size[idx] = finfo.size;
-  length = finfo.size > CHUNK_SIZE ? CHUNK_SIZE : finfo.size;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Get the entire contents of the opened datasource with index IDX in
+ * FILE_BATON into memory.
+ */
+static svn_error_t *
+load_whole_file(svn_diff__file_baton_t *file_baton, int idx)
+{
+  apr_off_t size = file_baton->size[idx];
+  char *buffer = NULL;
+
+  if (size == 0)
+    return SVN_NO_ERROR;
+
+#if APR_HAS_MMAP
+  /* Normalizing tokens modifies them in place, so we can only map the
+   * file read-only if there is nothing to normalize. */
+  if (size > APR_MMAP_THRESHOLD
+      && ! file_baton->options->ignore_space
+      && ! file_baton->options->ignore_eol_style)
+    {
+      apr_mmap_t *mm;
+      apr_status_t rv;
+
+      rv = apr_mmap_create(&mm, file_baton->file[idx], 0, (apr_size_t) size,
+                           APR_MMAP_READ, file_baton->pool);
+      if (rv == APR_SUCCESS)
+        buffer = mm->mm;
+
+      /* On failure we just fall through and try reading the file into
+       * memory instead.
+       */
+    }
+#endif /* APR_HAS_MMAP */
+
+  if (buffer == NULL)
+    {
+      buffer = apr_palloc(file_baton->pool, (apr_size_t) size);
+      SVN_ERR(svn_io_file_read_full(file_baton->file[idx], buffer,
+                                    (apr_size_t) size, NULL,
+                                    file_baton->pool));
+    }
+
+  file_baton->buffer[idx] = file_baton->curp[idx] = buffer;
+  file_baton->endp[idx] = buffer + size;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Read the first chunk of the opened datasource with index IDX in
+ * FILE_BATON into memory.
+ */
+static svn_error_t *
+load_first_chunk(svn_diff__file_baton_t *file_baton, int idx)
+{
+  apr_off_t length;
+  char *curp;
+  char *endp;
+
+  length = file_baton->size[idx] > CHUNK_SIZE ? CHUNK_SIZE
+                                              : file_baton->size[idx];
 
   if (length == 0)
     return SVN_NO_ERROR;
@@ -234,7 +303,337 @@ datasource_open(void *baton, svn_diff_datasource_e datasource)
 }
 
 
-/* Implements svn_diff_fns_t::datasource_close */
+/* Make CHUNK the chunk in memory for the file with index IDX in
+ * FILE_BATON, unless it already is.
+ */
+static svn_error_t *
+load_chunk(svn_diff__file_baton_t *file_baton, int idx, int chunk)
+{
+  apr_off_t length;
+
+  if (file_baton->chunk[idx] == chunk)
+    return SVN_NO_ERROR;
+
+  length = chunk == offset_to_chunk(file_baton->size[idx])
+         ? offset_in_chunk(file_baton->size[idx])
+         : CHUNK_SIZE;
+
+  file_baton->chunk[idx] = chunk;
+  file_baton->curp[idx] = file_baton->buffer[idx];
+  file_baton->endp[idx] = file_baton->buffer[idx] + length;
+
+  if (length == 0)
+    return SVN_NO_ERROR;
+
+  return read_chunk(file_baton->file[idx], file_baton->path[idx],
+                    file_baton->buffer[idx], length,
+                    chunk_to_offset(chunk), file_baton->pool);
+}
+
+
+/* Find the longest run of complete lines at the start of the FILE_LEN
+ * files with the indices in IDX of FILE_BATON that is identical in all of
+ * them.  Set *PREFIX_OFFSET to its length in bytes and *PREFIX_LINES to
+ * the number of tokens in it.  On return, the chunk containing
+ * *PREFIX_OFFSET is in memory for each file and reading continues at
+ * that offset.
+ */
+static svn_error_t *
+find_identical_prefix(apr_off_t *prefix_offset,
+                      apr_off_t *prefix_lines,
+                      svn_diff__file_baton_t *file_baton,
+                      const int *idx,
+                      apr_size_t file_len)
+{
+  apr_off_t offset = 0;
+  apr_off_t end = file_baton->size[idx[0]];
+  apr_off_t lines = 0;
+  svn_boolean_t had_cr = FALSE;
+  apr_size_t i;
+
+  *prefix_offset = 0;
+  *prefix_lines = 0;
+
+  for (i = 1; i < file_len; i++)
+    if (file_baton->size[idx[i]] < end)
+      end = file_baton->size[idx[i]];
+
+  while (offset < end)
+    {
+      apr_off_t pos = file_baton->whole ? offset : offset_in_chunk(offset);
+      char c;
+
+      if (pos == 0 && offset > 0)
+        for (i = 0; i < file_len; i++)
+          SVN_ERR(load_chunk(file_baton, idx[i],
+                             (int) offset_to_chunk(offset)));
+
+      c = file_baton->buffer[idx[0]][pos];
+      for (i = 1; i < file_len; i++)
+        if (file_baton->buffer[idx[i]][pos] != c)
+          break;
+
+      if (i < file_len)
+        break;
+
+      /* Count the tokens the same way datasource_get_next_token() splits
+       * them: a line ends at "\n", "\r\n" or a lone "\r".  We only ever
+       * cut the prefix right after a "\n", though. */
+      if (had_cr && c != '\n')
+        lines++;
+      had_cr = (c == '\r');
+      offset++;
+
+      if (c == '\n')
+        {
+          lines++;
+          *prefix_offset = offset;
+          *prefix_lines = lines;
+        }
+    }
+
+  for (i = 0; i < file_len; i++)
+    {
+      if (file_baton->whole)
+        {
+          file_baton->curp[idx[i]] = file_baton->buffer[idx[i]]
+                                     + *prefix_offset;
+          continue;
+        }
+
+      SVN_ERR(load_chunk(file_baton, idx[i],
+                         (int) offset_to_chunk(*prefix_offset)));
+      file_baton->curp[idx[i]] = file_baton->buffer[idx[i]]
+                                 + offset_in_chunk(*prefix_offset);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The number of lines of an identical suffix that we don't skip but leave
+ * to the LCS algorithm.  Without them, changes right in front of the
+ * suffix could be aligned worse than they would be otherwise.
+ */
+#define SUFFIX_LINES_TO_KEEP 50
+
+/* Find the longest run of complete lines at the end of the FILE_LEN files
+ * with the indices in IDX of FILE_BATON that is identical in all of them
+ * and doesn't overlap the first PREFIX_OFFSET bytes, less the first
+ * SUFFIX_LINES_TO_KEEP lines of it.  Set *SUFFIX_BYTES to its length in
+ * bytes and *SUFFIX_LINES to the number of tokens in it.  Use POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+find_identical_suffix(apr_off_t *suffix_bytes,
+                      apr_off_t *suffix_lines,
+                      svn_diff__file_baton_t *file_baton,
+                      const int *idx,
+                      apr_size_t file_len,
+                      apr_off_t prefix_offset,
+                      apr_pool_t *pool)
+{
+  char *buffer[4];
+  /* Candidate cuts, as the length of the suffix in bytes and tokens,
+   * kept for the last SUFFIX_LINES_TO_KEEP + 1 line starts found. */
+  apr_off_t cut_bytes[SUFFIX_LINES_TO_KEEP + 1];
+  apr_off_t cut_lines[SUFFIX_LINES_TO_KEEP + 1];
+  int cuts = 0;
+  apr_off_t limit = file_baton->size[idx[0]] - prefix_offset;
+  apr_off_t matched = 0;
+  apr_off_t lines = 0;
+  apr_off_t pos = 0;
+  apr_size_t buffer_len;
+  char next = '\0';
+  apr_size_t i;
+
+  *suffix_bytes = 0;
+  *suffix_lines = 0;
+
+  for (i = 1; i < file_len; i++)
+    if (file_baton->size[idx[i]] - prefix_offset < limit)
+      limit = file_baton->size[idx[i]] - prefix_offset;
+
+  if (limit == 0)
+    return SVN_NO_ERROR;
+
+  /* Files that are in memory as a whole are scanned in one go. */
+  if (file_baton->whole)
+    buffer_len = (apr_size_t) limit;
+  else
+    buffer_len = (apr_size_t) (limit > CHUNK_SIZE ? CHUNK_SIZE : limit);
+
+  if (! file_baton->whole)
+    for (i = 0; i < file_len; i++)
+      buffer[i] = apr_palloc(pool, buffer_len);
+
+  while (matched < limit)
+    {
+      char c;
+
+      if (pos == 0)
+        {
+          pos = limit - matched > (apr_off_t) buffer_len
+              ? (apr_off_t) buffer_len
+              : limit - matched;
+
+          for (i = 0; i < file_len; i++)
+            if (file_baton->whole)
+              buffer[i] = file_baton->buffer[idx[i]]
+                          + file_baton->size[idx[i]] - matched - pos;
+            else
+              SVN_ERR(read_chunk(file_baton->file[idx[i]],
+                                 file_baton->path[idx[i]],
+                                 buffer[i], pos,
+                                 file_baton->size[idx[i]] - matched - pos,
+                                 pool));
+        }
+
+      pos--;
+      c = buffer[0][pos];
+      for (i = 1; i < file_len; i++)
+        if (buffer[i][pos] != c)
+          break;
+
+      if (i < file_len)
+        break;
+
+      /* A line starts right after a "\n". */
+      if (c == '\n' && matched > 0)
+        {
+          cut_bytes[cuts % (SUFFIX_LINES_TO_KEEP + 1)] = matched;
+          cut_lines[cuts % (SUFFIX_LINES_TO_KEEP + 1)] = lines;
+          cuts++;
+        }
+
+      /* Count the tokens ending in the suffix, plus a final line without
+       * an eol marker. */
+      if (c == '\n'
+          || (c == '\r' && (matched == 0 || next != '\n'))
+          || matched == 0)
+        lines++;
+
+      next = c;
+      matched++;
+    }
+
+  /* If we ran out of data to compare, the suffix may still start at a
+   * line boundary in all files. */
+  if (matched == limit)
+    {
+      for (i = 0; i < file_len; i++)
+        {
+          apr_off_t start = file_baton->size[idx[i]] - matched;
+
+          if (start > 0)
+            {
+              char c;
+
+              if (file_baton->whole)
+                c = file_baton->buffer[idx[i]][start - 1];
+              else
+                SVN_ERR(read_chunk(file_baton->file[idx[i]],
+                                   file_baton->path[idx[i]],
+                                   &c, 1, start - 1, pool));
+              if (c != '\n')
+                break;
+            }
+        }
+
+      if (i == file_len)
+        {
+          cut_bytes[cuts % (SUFFIX_LINES_TO_KEEP + 1)] = matched;
+          cut_lines[cuts % (SUFFIX_LINES_TO_KEEP + 1)] = lines;
+          cuts++;
+        }
+    }
+
+  /* Leave the first SUFFIX_LINES_TO_KEEP lines of the suffix in place. */
+  if (cuts > SUFFIX_LINES_TO_KEEP)
+    {
+      *suffix_bytes = cut_bytes[cuts % (SUFFIX_LINES_TO_KEEP + 1)];
+      *suffix_lines = cut_lines[cuts % (SUFFIX_LINES_TO_KEEP + 1)];
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Implements svn_diff_fns2_t::datasources_open */
+static svn_error_t *
+datasources_open(void *baton,
+                 apr_off_t *prefix_lines,
+                 apr_off_t *suffix_lines,
+                 const svn_diff_datasource_e *datasources,
+                 apr_size_t datasources_len)
+{
+  svn_diff__file_baton_t *file_baton = baton;
+  int idx[4];
+  apr_off_t prefix_offset;
+  apr_off_t suffix_bytes;
+  apr_pool_t *subpool;
+  apr_size_t i;
+
+  SVN_ERR_ASSERT(datasources_len <= 4);
+
+  file_baton->whole = TRUE;
+  for (i = 0; i < datasources_len; i++)
+    {
+      idx[i] = datasource_to_index(datasources[i]);
+      SVN_ERR(open_datasource(file_baton, idx[i]));
+
+      if (file_baton->size[idx[i]] > WHOLE_FILE_MAX_SIZE)
+        file_baton->whole = FALSE;
+    }
+
+  for (i = 0; i < datasources_len; i++)
+    {
+      if (file_baton->whole)
+        SVN_ERR(load_whole_file(file_baton, idx[i]));
+      else
+        SVN_ERR(load_first_chunk(file_baton, idx[i]));
+    }
+
+  if (prefix_lines)
+    *prefix_lines = 0;
+  if (suffix_lines)
+    *suffix_lines = 0;
+
+  if (datasources_len < 2 || !prefix_lines || !suffix_lines)
+    return SVN_NO_ERROR;
+
+  /* Lines that are identical in all files at their start or end can't
+   * be part of any difference, so we don't feed them to the LCS
+   * algorithm at all.  That saves a lot of work on large files with
+   * few changes. */
+  SVN_ERR(find_identical_prefix(&prefix_offset, prefix_lines,
+                                file_baton, idx, datasources_len));
+
+  subpool = svn_pool_create(file_baton->pool);
+  SVN_ERR(find_identical_suffix(&suffix_bytes, suffix_lines,
+                                file_baton, idx, datasources_len,
+                                prefix_offset, subpool));
+  svn_pool_destroy(subpool);
+
+  /* Hide the suffix from datasource_get_next_token(). */
+  for (i = 0; i < datasources_len; i++)
+    {
+      file_baton->size[idx[i]] -= suffix_bytes;
+
+      if (file_baton->whole)
+        file_baton->endp[idx[i]] = file_baton->buffer[idx[i]]
+                                   + file_baton->size[idx[i]];
+      else if (file_baton->chunk[idx[i]]
+               == offset_to_chunk(file_baton->size[idx[i]]))
+        file_baton->endp[idx[i]] = file_baton->buffer[idx[i]]
+                                   + offset_in_chunk(file_baton->size[idx[i]]);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Implements svn_diff_fns2_t::datasource_close */
 static svn_error_t *
 datasource_close(void *baton, svn_diff_datasource_e datasource)
 {
@@ -245,7 +644,7 @@ datasource_close(void *baton, svn_diff_datasource_e datasource)
   return SVN_NO_ERROR;
 }
 
-/* Implements svn_diff_fns_t::datasource_get_next_token */
+/* Implements svn_diff_fns2_t::datasource_get_next_token */
 static svn_error_t *
 datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
                           svn_diff_datasource_e datasource)
@@ -272,7 +671,7 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
   last_chunk = offset_to_chunk(file_baton->size[idx]);
 
   if (curp == endp
-      && last_chunk == file_baton->chunk[idx])
+      && (file_baton->whole || last_chunk == file_baton->chunk[idx]))
     {
       return SVN_NO_ERROR;
     }
@@ -311,7 +710,7 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
             }
         }
 
-      if (file_baton->chunk[idx] == last_chunk)
+      if (file_baton->whole || file_baton->chunk[idx] == last_chunk)
         {
           eol = endp;
           break;
@@ -379,7 +778,7 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
 
 #define COMPARE_CHUNK_SIZE 4096
 
-/* Implements svn_diff_fns_t::token_compare */
+/* Implements svn_diff_fns2_t::token_compare */
 static svn_error_t *
 token_compare(void *baton, void *token1, void *token2, int *compare)
 {
@@ -418,6 +817,21 @@ token_compare(void *baton, void *token1, void *token2, int *compare)
       return SVN_NO_ERROR;
     }
 
+  /* If the files are in memory as a whole, so are the normalized tokens,
+   * and we can compare them right there.
+   */
+  if (file_baton->whole)
+    {
+      for (i = 0; i < 2; ++i)
+        {
+          idx[i] = datasource_to_index(file_token[i]->datasource);
+          bufp[i] = file_baton->buffer[idx[i]] + file_token[i]->norm_offset;
+        }
+
+      *compare = memcmp(bufp[0], bufp[1], (size_t) total_length);
+      return SVN_NO_ERROR;
+    }
+
   for (i = 0; i < 2; ++i)
     {
       idx[i] = datasource_to_index(file_token[i]->datasource);
@@ -500,7 +914,7 @@ token_compare(void *baton, void *token1, void *token2, int *compare)
 }
 
 
-/* Implements svn_diff_fns_t::token_discard */
+/* Implements svn_diff_fns2_t::token_discard */
 static void
 token_discard(void *baton, void *token)
 {
@@ -512,7 +926,7 @@ token_discard(void *baton, void *token)
 }
 
 
-/* Implements svn_diff_fns_t::token_discard_all */
+/* Implements svn_diff_fns2_t::token_discard_all */
 static void
 token_discard_all(void *baton)
 {
@@ -523,9 +937,9 @@ token_discard_all(void *baton)
 }
 
 
-static const svn_diff_fns_t svn_diff__file_vtable =
+static const svn_diff_fns2_t svn_diff__file_vtable =
 {
-  datasource_open,
+  datasources_open,
   datasource_close,
   datasource_get_next_token,
   token_compare,
@@ -536,6 +950,9 @@ static const svn_diff_fns_t svn_diff__file_vtable =
 /* Id for the --ignore-eol-style option, which doesn't have a short name. */
 #define SVN_DIFF__OPT_IGNORE_EOL_STYLE 256
 
+/* Id for the --histogram option, which doesn't have a short name. */
+#define SVN_DIFF__OPT_HISTOGRAM 257
+
 /* Options supported by svn_diff_file_options_parse(). */
 static const apr_getopt_option_t diff_options[] =
 {
@@ -543,6 +960,7 @@ static const apr_getopt_option_t diff_options[] =
   { "ignore-all-space", 'w', 0, NULL },
   { "ignore-eol-style", SVN_DIFF__OPT_IGNORE_EOL_STYLE, 0, NULL },
   { "show-c-function", 'p', 0, NULL },
+  { "histogram", SVN_DIFF__OPT_HISTOGRAM, 0, NULL },
   /* ### For compatibility; we don't support the argument to -u, because
    * ### we don't have optional argument support. */
   { "unified", 'u', 0, NULL },
@@ -598,6 +1016,9 @@ svn_diff_file_options_parse(svn_diff_file_options_t *options,
         case 'p':
           options->show_c_function = TRUE;
           break;
+        case SVN_DIFF__OPT_HISTOGRAM:
+          options->algorithm = svn_diff_file_algorithm_histogram;
+          break;
         default:
           break;
         }
@@ -627,7 +1048,8 @@ svn_diff_file_diff_2(svn_diff_t **diff,
   baton.path[1] = modified;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff_2(diff, &baton, &svn_diff__file_vtable,
+                           options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -650,7 +1072,8 @@ svn_diff_file_diff3_2(svn_diff_t **diff,
   baton.path[2] = latest;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff3(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff3_2(diff, &baton, &svn_diff__file_vtable,
+                            options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -675,7 +1098,8 @@ svn_diff_file_diff4_2(svn_diff_t **diff,
   baton.path[3] = ancestor;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff4(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff4_2(diff, &baton, &svn_diff__file_vtable,
+                            options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
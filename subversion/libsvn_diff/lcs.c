@@ -22,9 +22,15 @@
  */
 
 
+#include <stdlib.h>
+
 #include <apr.h>
 #include <apr_pools.h>
 #include <apr_general.h>
+#include <apr_hash.h>
+#include <apr_tables.h>
+
+#include "svn_pools.h"
 
 #include "diff.h"
 
@@ -160,10 +166,39 @@ svn_diff__lcs_reverse(svn_diff__lcs_t *lcs)
 }
 
 
-svn_diff__lcs_t *
-svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
-              svn_diff__position_t *position_list2, /* pointer to tail (ring) */
-              apr_pool_t *pool)
+/* Prepend a new lcs segment of LENGTH common lines, starting at
+ * ORIGINAL_START and MODIFIED_START respectively, to LCS.  The positions
+ * of the new segment are not part of any position list; they only carry
+ * the offsets.  Allocate from POOL.
+ */
+static svn_diff__lcs_t *
+prepend_lcs(svn_diff__lcs_t *lcs, apr_off_t length,
+            apr_off_t original_start, apr_off_t modified_start,
+            apr_pool_t *pool)
+{
+  svn_diff__lcs_t *new_lcs;
+
+  new_lcs = apr_palloc(pool, sizeof(*new_lcs));
+  new_lcs->position[0] = apr_pcalloc(pool, sizeof(*new_lcs->position[0]));
+  new_lcs->position[0]->offset = original_start;
+  new_lcs->position[1] = apr_pcalloc(pool, sizeof(*new_lcs->position[1]));
+  new_lcs->position[1]->offset = modified_start;
+  new_lcs->length = length;
+  new_lcs->refcount = 1;
+  new_lcs->next = lcs;
+
+  return new_lcs;
+}
+
+
+/* Find the common segments of the non-empty position lists POSITION_LIST1
+ * and POSITION_LIST2 using the O(NP) algorithm and return them, the last
+ * segment first.  Allocate from POOL.
+ */
+static svn_diff__lcs_t *
+lcs_onp(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
+        svn_diff__position_t *position_list2, /* pointer to tail (ring) */
+        apr_pool_t *pool)
 {
   int idx;
   apr_off_t length[2];
@@ -171,25 +206,10 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
   apr_off_t d;
   apr_off_t k;
   apr_off_t p = 0;
-  svn_diff__lcs_t *lcs, *lcs_freelist = NULL;
+  svn_diff__lcs_t *lcs_freelist = NULL;
 
   svn_diff__position_t sentinel_position[2];
 
-  /* Since EOF is always a sync point we tack on an EOF link
-   * with sentinel positions
-   */
-  lcs = apr_palloc(pool, sizeof(*lcs));
-  lcs->position[0] = apr_pcalloc(pool, sizeof(*lcs->position[0]));
-  lcs->position[0]->offset = position_list1 ? position_list1->offset + 1 : 1;
-  lcs->position[1] = apr_pcalloc(pool, sizeof(*lcs->position[1]));
-  lcs->position[1]->offset = position_list2 ? position_list2->offset + 1 : 1;
-  lcs->length = 0;
-  lcs->refcount = 1;
-  lcs->next = NULL;
-
-  if (position_list1 == NULL || position_list2 == NULL)
-    return lcs;
-
   /* Calculate length of both sequences to be compared */
   length[0] = position_list1->offset - position_list1->next->offset + 1;
   length[1] = position_list2->offset - position_list2->next->offset + 1;
@@ -243,11 +263,383 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
     }
   while (fp[d].position[1] != &sentinel_position[1]);
 
-  lcs->next = fp[d].lcs;
-  lcs = svn_diff__lcs_reverse(lcs);
-
   position_list1->next = sentinel_position[idx].next;
   position_list2->next = sentinel_position[abs(1 - idx)].next;
 
+  return fp[d].lcs;
+}
+
+
+/*
+ * Histogram diff.
+ *
+ * Instead of looking for a minimal diff, match up the tokens that occur
+ * least often first: in the region being compared, find the token of the
+ * original that occurs the fewest times but also occurs in the modified
+ * datasource, and take the longest run of common tokens around one of its
+ * occurrences as a common segment.  The regions before and after that
+ * segment are compared the same way.  Regions in which all common tokens
+ * occur more than HISTOGRAM_MAX_CHAIN times are left to lcs_onp().
+ *
+ * Since unique and rare tokens (function signatures, distinct XML
+ * elements, ...) anchor the diff, files with lots of repeated tokens
+ * don't make it degenerate the way the O(NP) algorithm does.
+ */
+
+#define HISTOGRAM_MAX_CHAIN 64
+
+/* A common segment found by the histogram diff, given as indexes into the
+ * position arrays of histogram_baton_t. */
+typedef struct histogram_segment_t
+{
+  apr_off_t start[2];
+  apr_off_t length;
+} histogram_segment_t;
+
+typedef struct histogram_baton_t
+{
+  /* The positions of both datasources, in order. */
+  svn_diff__position_t **position[2];
+
+  /* For each of those positions, a small integer identifying its token. */
+  apr_size_t *token[2];
+
+  /* Indexed by token: the number of occurrences in the current region of
+   * the original, and the index of the last of them. */
+  apr_size_t *count;
+  apr_off_t *last;
+
+  /* Indexed like position[0]: the index of the previous occurrence of the
+   * same token in the current region, or -1. */
+  apr_off_t *previous;
+
+  /* The common segments found so far, in no particular order. */
+  apr_array_header_t *segments;
+
+  /* For the regions left to lcs_onp(). */
+  apr_pool_t *iterpool;
+} histogram_baton_t;
+
+/* Add a common segment of LENGTH tokens at START0 and START1 to HB. */
+static void
+histogram_add_segment(histogram_baton_t *hb,
+                      apr_off_t start0, apr_off_t start1, apr_off_t length)
+{
+  histogram_segment_t *segment = apr_array_push(hb->segments);
+
+  segment->start[0] = start0;
+  segment->start[1] = start1;
+  segment->length = length;
+}
+
+/* Find the common segments of the region [LO0, HI0) of the original and
+ * [LO1, HI1) of the modified datasource with lcs_onp() and add them to HB.
+ */
+static void
+histogram_fallback(histogram_baton_t *hb,
+                   apr_off_t lo0, apr_off_t hi0,
+                   apr_off_t lo1, apr_off_t hi1)
+{
+  svn_diff__position_t *tail[2];
+  svn_diff__position_t *next[2];
+  svn_diff__lcs_t *lcs;
+
+  /* Temporarily turn the regions into rings of their own. */
+  tail[0] = hb->position[0][hi0 - 1];
+  tail[1] = hb->position[1][hi1 - 1];
+  next[0] = tail[0]->next;
+  next[1] = tail[1]->next;
+  tail[0]->next = hb->position[0][lo0];
+  tail[1]->next = hb->position[1][lo1];
+
+  for (lcs = lcs_onp(tail[0], tail[1], hb->iterpool); lcs; lcs = lcs->next)
+    histogram_add_segment(hb,
+                          lo0 + lcs->position[0]->offset
+                              - hb->position[0][lo0]->offset,
+                          lo1 + lcs->position[1]->offset
+                              - hb->position[1][lo1]->offset,
+                          lcs->length);
+
+  tail[0]->next = next[0];
+  tail[1]->next = next[1];
+
+  svn_pool_clear(hb->iterpool);
+}
+
+/* Find the common segments of the region [LO0, HI0) of the original and
+ * [LO1, HI1) of the modified datasource and add them to HB.
+ */
+static void
+histogram_region(histogram_baton_t *hb,
+                 apr_off_t lo0, apr_off_t hi0,
+                 apr_off_t lo1, apr_off_t hi1)
+{
+  const apr_size_t *token0 = hb->token[0];
+  const apr_size_t *token1 = hb->token[1];
+
+  while (lo0 < hi0 && lo1 < hi1)
+    {
+      apr_off_t best_start0 = 0;
+      apr_off_t best_start1 = 0;
+      apr_off_t best_length = 0;
+      apr_size_t best_count = HISTOGRAM_MAX_CHAIN;
+      svn_boolean_t has_common = FALSE;
+      apr_off_t i;
+      apr_off_t j;
+
+      /* Build the histogram of the original's region. */
+      for (i = lo0; i < hi0; i++)
+        {
+          apr_size_t t = token0[i];
+
+          hb->previous[i] = hb->count[t] ? hb->last[t] : -1;
+          hb->last[t] = i;
+          hb->count[t]++;
+        }
+
+      /* Look for the longest common run around the rarest token. */
+      j = lo1;
+      while (j < hi1)
+        {
+          apr_size_t t = token1[j];
+          apr_off_t next_j = j + 1;
+
+          if (hb->count[t] == 0)
+            {
+              j = next_j;
+              continue;
+            }
+
+          has_common = TRUE;
+          if (hb->count[t] > best_count)
+            {
+              j = next_j;
+              continue;
+            }
+
+          for (i = hb->last[t]; i >= 0; i = hb->previous[i])
+            {
+              apr_off_t start0 = i;
+              apr_off_t start1 = j;
+              apr_off_t end0 = i + 1;
+              apr_off_t end1 = j + 1;
+              apr_size_t count = hb->count[t];
+
+              while (start0 > lo0 && start1 > lo1
+                     && token0[start0 - 1] == token1[start1 - 1])
+                {
+                  start0--;
+                  start1--;
+                  if (hb->count[token0[start0]] < count)
+                    count = hb->count[token0[start0]];
+                }
+
+              while (end0 < hi0 && end1 < hi1
+                     && token0[end0] == token1[end1])
+                {
+                  if (hb->count[token0[end0]] < count)
+                    count = hb->count[token0[end0]];
+                  end0++;
+                  end1++;
+                }
+
+              if (end1 > next_j)
+                next_j = end1;
+
+              if (end0 - start0 > best_length || count < best_count)
+                {
+                  best_start0 = start0;
+                  best_start1 = start1;
+                  best_length = end0 - start0;
+                  best_count = count;
+                }
+            }
+
+          j = next_j;
+        }
+
+      for (i = lo0; i < hi0; i++)
+        hb->count[token0[i]] = 0;
+
+      if (best_length == 0)
+        {
+          /* Either there's nothing in common at all, or only tokens that
+           * are repeated too often to be good anchors. */
+          if (has_common)
+            histogram_fallback(hb, lo0, hi0, lo1, hi1);
+          return;
+        }
+
+      histogram_add_segment(hb, best_start0, best_start1, best_length);
+
+      /* Recurse into the smaller of the remaining regions and loop for the
+       * other, to keep the recursion shallow. */
+      if (best_start0 - lo0 + best_start1 - lo1
+          < hi0 - (best_start0 + best_length) + hi1 - (best_start1
+                                                       + best_length))
+        {
+          histogram_region(hb, lo0, best_start0, lo1, best_start1);
+          lo0 = best_start0 + best_length;
+          lo1 = best_start1 + best_length;
+        }
+      else
+        {
+          histogram_region(hb, best_start0 + best_length, hi0,
+                           best_start1 + best_length, hi1);
+          hi0 = best_start0;
+          hi1 = best_start1;
+        }
+    }
+}
+
+/* qsort() comparison function for histogram_segment_t. */
+static int
+compare_segments(const void *a, const void *b)
+{
+  const histogram_segment_t *segment_a = a;
+  const histogram_segment_t *segment_b = b;
+
+  if (segment_a->start[0] < segment_b->start[0])
+    return -1;
+
+  return segment_a->start[0] > segment_b->start[0] ? 1 : 0;
+}
+
+/* Like lcs_onp(), but using the histogram diff. */
+static svn_diff__lcs_t *
+lcs_histogram(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
+              svn_diff__position_t *position_list2, /* pointer to tail (ring) */
+              apr_pool_t *pool)
+{
+  histogram_baton_t hb;
+  svn_diff__position_t *list[2];
+  apr_off_t length[2];
+  apr_hash_t *tokens;
+  svn_diff__lcs_t *lcs = NULL;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  int i;
+  apr_off_t j;
+
+  list[0] = position_list1;
+  list[1] = position_list2;
+
+  /* Number the distinct tokens, so that we can use plain arrays for the
+   * histogram. */
+  tokens = apr_hash_make(subpool);
+  for (i = 0; i < 2; i++)
+    {
+      svn_diff__position_t *position = list[i]->next;
+
+      length[i] = list[i]->offset - position->offset + 1;
+      hb.position[i] = apr_palloc(subpool,
+                                  (apr_size_t) length[i]
+                                  * sizeof(*hb.position[i]));
+      hb.token[i] = apr_palloc(subpool,
+                               (apr_size_t) length[i]
+                               * sizeof(*hb.token[i]));
+
+      for (j = 0; j < length[i]; j++, position = position->next)
+        {
+          apr_size_t *token = apr_hash_get(tokens, &position->node,
+                                           sizeof(position->node));
+
+          if (token == NULL)
+            {
+              token = apr_palloc(subpool, sizeof(*token));
+              *token = apr_hash_count(tokens);
+              apr_hash_set(tokens, &position->node, sizeof(position->node),
+                           token);
+            }
+
+          hb.position[i][j] = position;
+          hb.token[i][j] = *token;
+        }
+    }
+
+  hb.count = apr_pcalloc(subpool,
+                         apr_hash_count(tokens) * sizeof(*hb.count));
+  hb.last = apr_palloc(subpool, apr_hash_count(tokens) * sizeof(*hb.last));
+  hb.previous = apr_palloc(subpool,
+                           (apr_size_t) length[0] * sizeof(*hb.previous));
+  hb.segments = apr_array_make(subpool, 16, sizeof(histogram_segment_t));
+  hb.iterpool = svn_pool_create(subpool);
+
+  histogram_region(&hb, 0, length[0], 0, length[1]);
+
+  qsort(hb.segments->elts, hb.segments->nelts, hb.segments->elt_size,
+        compare_segments);
+
+  /* Turn the segments into lcs elements, the last segment first. */
+  for (i = 0; i < hb.segments->nelts; i++)
+    {
+      histogram_segment_t *segment
+        = &APR_ARRAY_IDX(hb.segments, i, histogram_segment_t);
+      svn_diff__lcs_t *new_lcs = apr_palloc(pool, sizeof(*new_lcs));
+
+      new_lcs->position[0] = hb.position[0][segment->start[0]];
+      new_lcs->position[1] = hb.position[1][segment->start[1]];
+      new_lcs->length = segment->length;
+      new_lcs->refcount = 1;
+      new_lcs->next = lcs;
+      lcs = new_lcs;
+    }
+
+  svn_pool_destroy(subpool);
+
+  return lcs;
+}
+
+
+svn_diff__lcs_t *
+svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
+              svn_diff__position_t *position_list2, /* pointer to tail (ring) */
+              apr_off_t prefix_lines,
+              apr_off_t suffix_lines,
+              svn_diff_file_algorithm_t algorithm,
+              apr_pool_t *pool)
+{
+  svn_diff__lcs_t *lcs;
+  svn_diff__lcs_t *segments;
+
+  /* Since EOF is always a sync point we tack on an EOF link
+   * with sentinel positions.  The identical suffix, if any, comes
+   * right before it.
+   */
+  lcs = apr_palloc(pool, sizeof(*lcs));
+  lcs->position[0] = apr_pcalloc(pool, sizeof(*lcs->position[0]));
+  lcs->position[0]->offset = (position_list1 ? position_list1->offset
+                                             : prefix_lines)
+                             + suffix_lines + 1;
+  lcs->position[1] = apr_pcalloc(pool, sizeof(*lcs->position[1]));
+  lcs->position[1]->offset = (position_list2 ? position_list2->offset
+                                             : prefix_lines)
+                             + suffix_lines + 1;
+  lcs->length = 0;
+  lcs->refcount = 1;
+  lcs->next = NULL;
+
+  if (position_list1 == NULL || position_list2 == NULL)
+    segments = NULL;
+  else if (algorithm == svn_diff_file_algorithm_histogram)
+    segments = lcs_histogram(position_list1, position_list2, pool);
+  else
+    segments = lcs_onp(position_list1, position_list2, pool);
+
+  /* The list is still in reverse order here, so the suffix goes
+   * between the EOF link and the last segment found.
+   */
+  if (suffix_lines)
+    lcs->next = prepend_lcs(segments, suffix_lines,
+                            lcs->position[0]->offset - suffix_lines,
+                            lcs->position[1]->offset - suffix_lines,
+                            pool);
+  else
+    lcs->next = segments;
+
+  lcs = svn_diff__lcs_reverse(lcs);
+
+  if (prefix_lines)
+    lcs = prepend_lcs(lcs, prefix_lines, 1, 1, pool);
+
   return lcs;
 }
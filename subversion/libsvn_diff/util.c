@@ -29,6 +29,7 @@
 #include "svn_diff.h"
 #include "svn_types.h"
 #include "svn_ctype.h"
+#include "private/svn_string_private.h"
 
 #include "diff.h"
 
@@ -53,6 +54,18 @@
 #define ADLER_MOD_BLOCK_SIZE 5552
 
 
+/*
+ * Start with CHECKSUM and update the checksum by processing a chunk
+ * of DATA sized LEN.
+ */
+/* Add the byte at DATA[I] to the sums S1 and S2, and likewise for the 16
+ * bytes starting at DATA[I]. */
+#define ADLER_DO1(data, i) do { s1 += (data)[i]; s2 += s1; } while (0)
+#define ADLER_DO2(data, i) ADLER_DO1(data, i); ADLER_DO1(data, i + 1)
+#define ADLER_DO4(data, i) ADLER_DO2(data, i); ADLER_DO2(data, i + 2)
+#define ADLER_DO8(data, i) ADLER_DO4(data, i); ADLER_DO4(data, i + 4)
+#define ADLER_DO16(data)   ADLER_DO8(data, 0); ADLER_DO8(data, 8)
+
 /*
  * Start with CHECKSUM and update the checksum by processing a chunk
  * of DATA sized LEN.
@@ -63,36 +76,39 @@ svn_diff__adler32(apr_uint32_t checksum, const char *data, apr_off_t len)
   const unsigned char *input = (const unsigned char *)data;
   apr_uint32_t s1 = checksum & 0xFFFF;
   apr_uint32_t s2 = checksum >> 16;
-  apr_uint32_t b;
   apr_size_t blocks = len / ADLER_MOD_BLOCK_SIZE;
 
   len %= ADLER_MOD_BLOCK_SIZE;
 
   while (blocks--)
     {
-      int count = ADLER_MOD_BLOCK_SIZE;
+      /* ADLER_MOD_BLOCK_SIZE is a multiple of 16. */
+      int count = ADLER_MOD_BLOCK_SIZE / 16;
       while (count--)
         {
-          b = *input++;
-          s1 += b;
-          s2 += s1;
+          ADLER_DO16(input);
+          input += 16;
         }
 
       s1 %= ADLER_MOD_BASE;
       s2 %= ADLER_MOD_BASE;
     }
 
+  for (; len >= 16; len -= 16)
+    {
+      ADLER_DO16(input);
+      input += 16;
+    }
+
   while (len--)
     {
-      b = *input++;
-      s1 += b;
-      s2 += s1;
+      ADLER_DO1(input, 0);
+      input++;
     }
 
   return ((s2 % ADLER_MOD_BASE) << 16) | (s1 % ADLER_MOD_BASE);
 }
 
-
 svn_boolean_t
 svn_diff_contains_conflicts(svn_diff_t *diff)
 {
@@ -187,6 +203,45 @@ svn_diff_output(svn_diff_t *diff,
 }
 
 
+/* A machine word with the same byte repeated in every position. */
+#define ABOVE_SPACE ((apr_uintptr_t)-1 / 0xff * (0x80 - 0x21))
+
+/* Return the first byte in [BUF, ENDP) that may be whitespace or an eol
+ * character, i.e. that is not above 0x20, or ENDP if there is none.
+ * Bytes above 0x20 never need normalizing, and they make up most of any
+ * text, so skip them a machine word at a time where possible. */
+static APR_INLINE const char *
+skip_plain_bytes(const char *buf, const char *endp)
+{
+  for (; buf < endp && ((apr_uintptr_t)buf & (sizeof(apr_uintptr_t) - 1));
+       ++buf)
+    {
+      if ((unsigned char)*buf <= 0x20)
+        return buf;
+    }
+
+  /* Adding ABOVE_SPACE to the lower 7 bits of a byte sets bit 7 exactly if
+   * they are above 0x20, without carrying into the next byte. */
+  for (; endp - buf >= (apr_ssize_t)sizeof(apr_uintptr_t);
+       buf += sizeof(apr_uintptr_t))
+    {
+      apr_uintptr_t chunk = *(const apr_uintptr_t *)buf;
+
+      if ((((chunk & SVN__LOWER_7BITS_SET) + ABOVE_SPACE) | chunk)
+           & SVN__BIT_7_SET) != SVN__BIT_7_SET)
+        break;
+    }
+
+  for (; buf < endp; ++buf)
+    {
+      if ((unsigned char)*buf <= 0x20)
+        break;
+    }
+
+  return buf;
+}
+
+
 void
 svn_diff__normalize_buffer(char **tgt,
                            apr_off_t *lengthp,
@@ -353,8 +408,16 @@ svn_diff__normalize_buffer(char **tgt,
             {
               /* Non-whitespace character, or whitespace character in
                  svn_diff_file_ignore_space_none mode. */
+              const char *plain_end;
+
               INCLUDE;
               state = svn_diff__normalize_state_normal;
+
+              /* Everything up to the next possible whitespace stays as
+               * it is, so add it to the included block in one go. */
+              plain_end = skip_plain_bytes(curp + 1, endp);
+              include_len += plain_end - (curp + 1);
+              curp = plain_end - 1;
             }
         }
     }
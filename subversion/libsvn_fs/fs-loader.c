@@ -22,6 +22,7 @@
  */
 
 
+#include <stdlib.h>
 #include <string.h>
 #include <apr.h>
 #include <apr_hash.h>
@@ -482,25 +483,37 @@ svn_fs_delete_fs(const char *path, apr_pool_t *pool)
 }
 
 svn_error_t *
-svn_fs_hotcopy(const char *src_path, const char *dest_path,
-               svn_boolean_t clean, apr_pool_t *pool)
+svn_fs_hotcopy2(const char *src_path, const char *dest_path,
+                svn_boolean_t clean, svn_boolean_t incremental,
+                svn_cancel_func_t cancel_func, void *cancel_baton,
+                apr_pool_t *pool)
 {
   fs_library_vtable_t *vtable;
   const char *fs_type;
 
   SVN_ERR(svn_fs_type(&fs_type, src_path, pool));
   SVN_ERR(get_library_vtable(&vtable, fs_type, pool));
-  SVN_ERR(vtable->hotcopy(src_path, dest_path, clean, pool));
+  SVN_ERR(vtable->hotcopy(src_path, dest_path, clean, incremental,
+                          cancel_func, cancel_baton, pool));
   return svn_error_return(write_fs_type(dest_path, fs_type, pool));
 }
 
 svn_error_t *
-svn_fs_pack(const char *path,
-            svn_fs_pack_notify_t notify_func,
-            void *notify_baton,
-            svn_cancel_func_t cancel_func,
-            void *cancel_baton,
-            apr_pool_t *pool)
+svn_fs_hotcopy(const char *src_path, const char *dest_path,
+               svn_boolean_t clean, apr_pool_t *pool)
+{
+  return svn_error_return(svn_fs_hotcopy2(src_path, dest_path, clean,
+                                          FALSE, NULL, NULL, pool));
+}
+
+svn_error_t *
+svn_fs_pack2(const char *path,
+             int jobs,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool)
 {
   svn_error_t *err;
   svn_error_t *err2;
@@ -510,7 +523,7 @@ svn_fs_pack(const char *path,
   SVN_ERR(fs_library_vtable(&vtable, path, pool));
   fs = fs_new(NULL, pool);
   SVN_ERR(acquire_fs_mutex());
-  err = vtable->pack_fs(fs, path, notify_func, notify_baton,
+  err = vtable->pack_fs(fs, path, jobs, notify_func, notify_baton,
                         cancel_func, cancel_baton, pool);
   err2 = release_fs_mutex();
   if (err)
@@ -521,6 +534,18 @@ svn_fs_pack(const char *path,
   return svn_error_return(err2);
 }
 
+svn_error_t *
+svn_fs_pack(const char *path,
+            svn_fs_pack_notify_t notify_func,
+            void *notify_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *pool)
+{
+  return svn_error_return(svn_fs_pack2(path, 1, notify_func, notify_baton,
+                                       cancel_func, cancel_baton, pool));
+}
+
 svn_error_t *
 svn_fs_recover(const char *path,
                svn_cancel_func_t cancel_func, void *cancel_baton,
@@ -609,8 +634,8 @@ svn_error_t *
 svn_fs_hotcopy_berkeley(const char *src_path, const char *dest_path,
                         svn_boolean_t clean_logs, apr_pool_t *pool)
 {
-  return svn_error_return(svn_fs_hotcopy(src_path, dest_path, clean_logs,
-                                         pool));
+  return svn_error_return(svn_fs_hotcopy2(src_path, dest_path, clean_logs,
+                                          FALSE, NULL, NULL, pool));
 }
 
 svn_error_t *
@@ -667,6 +692,41 @@ svn_fs__begin_obliteration_txn(svn_fs_txn_t **txn_p,
                                                              pool));
 }
 
+svn_error_t *
+svn_fs__get_cache_info(apr_hash_t **info_p,
+                       svn_fs_t *fs,
+                       svn_boolean_t reset,
+                       apr_pool_t *pool)
+{
+  return svn_error_return(fs->vtable->get_cache_info(info_p, fs, reset,
+                                                     pool));
+}
+
+svn_error_t *
+svn_fs__log_index_prev(svn_boolean_t *indexed,
+                       svn_revnum_t *revision,
+                       svn_boolean_t *added,
+                       svn_fs_t *fs,
+                       const char *path,
+                       svn_revnum_t rev,
+                       apr_pool_t *pool)
+{
+  return svn_error_return(fs->vtable->log_index_prev(indexed, revision,
+                                                     added, fs, path, rev,
+                                                     pool));
+}
+
+svn_error_t *
+svn_fs__dated_revision(svn_boolean_t *indexed,
+                       svn_revnum_t *revision,
+                       svn_fs_t *fs,
+                       apr_time_t tm,
+                       apr_pool_t *pool)
+{
+  return svn_error_return(fs->vtable->dated_revision(indexed, revision, fs,
+                                                     tm, pool));
+}
+
 svn_error_t *
 svn_fs_commit_txn(const char **conflict_p, svn_revnum_t *new_rev,
                   svn_fs_txn_t *txn, apr_pool_t *pool)
@@ -684,7 +744,7 @@ svn_fs_commit_txn(const char **conflict_p, svn_revnum_t *new_rev,
   SVN_ERR(txn->vtable->commit(conflict_p, new_rev, txn, pool));
 
 #ifdef PACK_AFTER_EVERY_COMMIT
-  SVN_ERR(svn_fs_pack(fs_path, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(fs_path, 1, NULL, NULL, NULL, NULL, pool));
 #endif
 
   return SVN_NO_ERROR;
@@ -840,6 +900,23 @@ svn_fs_paths_changed2(apr_hash_t **changed_paths_p, svn_fs_root_t *root,
   return root->vtable->paths_changed(changed_paths_p, root, pool);
 }
 
+svn_error_t *
+svn_fs_paths_changed_iterator(svn_fs_path_change_iterator_t **iterator,
+                              svn_fs_root_t *root,
+                              apr_pool_t *pool)
+{
+  return root->vtable->paths_changed_iterator(iterator, root, pool);
+}
+
+svn_error_t *
+svn_fs_path_change_get(const char **path,
+                       svn_fs_path_change2_t **change,
+                       svn_fs_path_change_iterator_t *iterator,
+                       apr_pool_t *pool)
+{
+  return iterator->vtable->get(path, change, iterator, pool);
+}
+
 svn_error_t *
 svn_fs_paths_changed(apr_hash_t **changed_paths_p, svn_fs_root_t *root,
                      apr_pool_t *pool)
@@ -877,6 +954,70 @@ svn_fs_check_path(svn_node_kind_t *kind_p, svn_fs_root_t *root,
   return svn_error_return(root->vtable->check_path(kind_p, root, path, pool));
 }
 
+/* A path passed to svn_fs_check_paths() together with its position in
+   the caller's array. */
+typedef struct check_paths_item_t
+{
+  const char *path;
+  int index;
+} check_paths_item_t;
+
+/* qsort()-compatible comparison of two check_paths_item_t, ordering
+   every directory directly in front of its descendants. */
+static int
+compare_check_paths_items(const void *a, const void *b)
+{
+  const check_paths_item_t *item_a = a;
+  const check_paths_item_t *item_b = b;
+
+  return svn_path_compare_paths(item_a->path, item_b->path);
+}
+
+svn_error_t *
+svn_fs_check_paths(apr_array_header_t **kinds_p, apr_array_header_t **ids_p,
+                   svn_fs_root_t *root, const apr_array_header_t *paths,
+                   apr_pool_t *pool)
+{
+  int count = paths->nelts;
+  check_paths_item_t *items = apr_palloc(pool, count * sizeof(*items));
+  apr_array_header_t *sorted = apr_array_make(pool, count,
+                                              sizeof(const char *));
+  svn_node_kind_t *kinds = apr_palloc(pool, count * sizeof(*kinds));
+  const svn_fs_id_t **ids = ids_p ? apr_palloc(pool, count * sizeof(*ids))
+                                  : NULL;
+  int i;
+
+  /* Let the back-end see each directory right before its contents. */
+  for (i = 0; i < count; ++i)
+    {
+      items[i].path
+        = svn_fs__canonicalize_abspath(APR_ARRAY_IDX(paths, i, const char *),
+                                       pool);
+      items[i].index = i;
+    }
+  qsort(items, count, sizeof(*items), compare_check_paths_items);
+  for (i = 0; i < count; ++i)
+    APR_ARRAY_PUSH(sorted, const char *) = items[i].path;
+
+  SVN_ERR(root->vtable->check_paths(kinds, ids, root, sorted, pool));
+
+  /* Return the results in the caller's order. */
+  *kinds_p = apr_array_make(pool, count, sizeof(svn_node_kind_t));
+  (*kinds_p)->nelts = count;
+  for (i = 0; i < count; ++i)
+    APR_ARRAY_IDX(*kinds_p, items[i].index, svn_node_kind_t) = kinds[i];
+
+  if (ids_p)
+    {
+      *ids_p = apr_array_make(pool, count, sizeof(const svn_fs_id_t *));
+      (*ids_p)->nelts = count;
+      for (i = 0; i < count; ++i)
+        APR_ARRAY_IDX(*ids_p, items[i].index, const svn_fs_id_t *) = ids[i];
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_node_history(svn_fs_history_t **history_p, svn_fs_root_t *root,
                     const char *path, apr_pool_t *pool)
@@ -1025,6 +1166,16 @@ svn_fs_dir_entries(apr_hash_t **entries_p, svn_fs_root_t *root,
                                                     pool));
 }
 
+svn_error_t *
+svn_fs__dir_entries_sorted(apr_array_header_t **entries_p,
+                           svn_fs_root_t *root,
+                           const char *path,
+                           apr_pool_t *pool)
+{
+  return svn_error_return(root->vtable->dir_entries_sorted(entries_p, root,
+                                                           path, pool));
+}
+
 svn_error_t *
 svn_fs_make_dir(svn_fs_root_t *root, const char *path, apr_pool_t *pool)
 {
@@ -1269,6 +1420,102 @@ svn_fs_lock(svn_lock_t **lock, svn_fs_t *fs, const char *path,
                                            current_rev, steal_lock, pool));
 }
 
+svn_error_t *
+svn_fs__lock_many(svn_fs_t *fs,
+                  apr_hash_t *targets,
+                  const char *comment,
+                  svn_boolean_t is_dav_comment,
+                  apr_time_t expiration_date,
+                  svn_boolean_t steal_lock,
+                  svn_fs__lock_callback_t lock_callback,
+                  void *lock_baton,
+                  apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+  svn_error_t *cb_err = SVN_NO_ERROR;
+
+  /* The same checks as svn_fs_lock(), done once for all paths. */
+  if (comment)
+    {
+      if (! svn_xml_is_xml_safe(comment, strlen(comment)))
+        return svn_error_create
+          (SVN_ERR_XML_UNESCAPABLE_DATA, NULL,
+           _("Lock comment contains illegal characters"));
+    }
+
+  if (expiration_date < 0)
+        return svn_error_create
+          (SVN_ERR_INCORRECT_PARAMS, NULL,
+           _("Negative expiration date passed to svn_fs_lock"));
+
+  if (fs->vtable->lock_many)
+    return svn_error_return(fs->vtable->lock_many(fs, targets, comment,
+                                                  is_dav_comment,
+                                                  expiration_date,
+                                                  steal_lock, lock_callback,
+                                                  lock_baton, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (hi = apr_hash_first(pool, targets); hi; hi = apr_hash_next(hi))
+    {
+      const char *path = svn__apr_hash_index_key(hi);
+      const svn_fs__lock_target_t *target = svn__apr_hash_index_val(hi);
+      svn_lock_t *lock;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      err = fs->vtable->lock(&lock, fs, path, target->token, comment,
+                             is_dav_comment, expiration_date,
+                             target->current_rev, steal_lock, iterpool);
+      if (!cb_err && lock_callback)
+        cb_err = lock_callback(lock_baton, path, err ? NULL : lock, err,
+                               iterpool);
+      svn_error_clear(err);
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_return(cb_err);
+}
+
+svn_error_t *
+svn_fs__unlock_many(svn_fs_t *fs,
+                    apr_hash_t *targets,
+                    svn_boolean_t break_lock,
+                    svn_fs__lock_callback_t lock_callback,
+                    void *lock_baton,
+                    apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+  svn_error_t *cb_err = SVN_NO_ERROR;
+
+  if (fs->vtable->unlock_many)
+    return svn_error_return(fs->vtable->unlock_many(fs, targets, break_lock,
+                                                    lock_callback, lock_baton,
+                                                    pool));
+
+  iterpool = svn_pool_create(pool);
+  for (hi = apr_hash_first(pool, targets); hi; hi = apr_hash_next(hi))
+    {
+      const char *path = svn__apr_hash_index_key(hi);
+      const char *token = svn__apr_hash_index_val(hi);
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      err = fs->vtable->unlock(fs, path, (token && *token) ? token : NULL,
+                               break_lock, iterpool);
+      if (!cb_err && lock_callback)
+        cb_err = lock_callback(lock_baton, path, NULL, err, iterpool);
+      svn_error_clear(err);
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_return(cb_err);
+}
+
 svn_error_t *
 svn_fs_generate_lock_token(const char **token, svn_fs_t *fs, apr_pool_t *pool)
 {
@@ -1357,6 +1604,15 @@ svn_fs_compare_ids(const svn_fs_id_t *a, const svn_fs_id_t *b)
   return a->vtable->compare(a, b);
 }
 
+int
+svn_fs__compare_id_locations(const svn_fs_id_t *a, const svn_fs_id_t *b)
+{
+  if (a->vtable->compare_location == NULL)
+    return 0;
+
+  return a->vtable->compare_location(a, b);
+}
+
 svn_error_t *
 svn_fs_print_modules(svn_stringbuf_t *output,
                      apr_pool_t *pool)
@@ -27,6 +27,7 @@
 
 #include "svn_version.h"
 #include "svn_fs.h"
+#include "private/svn_fs_private.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -88,12 +89,14 @@ typedef struct fs_library_vtable_t
                              apr_pool_t *common_pool);
   svn_error_t *(*delete_fs)(const char *path, apr_pool_t *pool);
   svn_error_t *(*hotcopy)(const char *src_path, const char *dest_path,
-                          svn_boolean_t clean, apr_pool_t *pool);
+                          svn_boolean_t clean, svn_boolean_t incremental,
+                          svn_cancel_func_t cancel_func, void *cancel_baton,
+                          apr_pool_t *pool);
   const char *(*get_description)(void);
   svn_error_t *(*recover)(svn_fs_t *fs,
                           svn_cancel_func_t cancel_func, void *cancel_baton,
                           apr_pool_t *pool);
-  svn_error_t *(*pack_fs)(svn_fs_t *fs, const char *path,
+  svn_error_t *(*pack_fs)(svn_fs_t *fs, const char *path, int jobs,
                           svn_fs_pack_notify_t notify_func, void *notify_baton,
                           svn_cancel_func_t cancel_func, void *cancel_baton,
                           apr_pool_t *pool);
@@ -196,6 +199,28 @@ typedef struct fs_vtable_t
   svn_error_t *(*bdb_set_errcall)(svn_fs_t *fs,
                                   void (*handler)(const char *errpfx,
                                                   char *msg));
+  svn_error_t *(*get_cache_info)(apr_hash_t **info_p, svn_fs_t *fs,
+                                 svn_boolean_t reset, apr_pool_t *pool);
+  svn_error_t *(*log_index_prev)(svn_boolean_t *indexed,
+                                 svn_revnum_t *revision,
+                                 svn_boolean_t *added, svn_fs_t *fs,
+                                 const char *path, svn_revnum_t rev,
+                                 apr_pool_t *pool);
+  svn_error_t *(*dated_revision)(svn_boolean_t *indexed,
+                                 svn_revnum_t *revision, svn_fs_t *fs,
+                                 apr_time_t tm, apr_pool_t *pool);
+  /* These two may be NULL, in which case the paths are locked or
+     unlocked one at a time through lock() or unlock(). */
+  svn_error_t *(*lock_many)(svn_fs_t *fs, apr_hash_t *targets,
+                            const char *comment, svn_boolean_t is_dav_comment,
+                            apr_time_t expiration_date,
+                            svn_boolean_t steal_lock,
+                            svn_fs__lock_callback_t lock_callback,
+                            void *lock_baton, apr_pool_t *pool);
+  svn_error_t *(*unlock_many)(svn_fs_t *fs, apr_hash_t *targets,
+                              svn_boolean_t break_lock,
+                              svn_fs__lock_callback_t lock_callback,
+                              void *lock_baton, apr_pool_t *pool);
 } fs_vtable_t;
 
 
@@ -233,10 +258,21 @@ typedef struct root_vtable_t
   svn_error_t *(*paths_changed)(apr_hash_t **changed_paths_p,
                                 svn_fs_root_t *root,
                                 apr_pool_t *pool);
+  svn_error_t *(*paths_changed_iterator)
+    (svn_fs_path_change_iterator_t **iterator,
+     svn_fs_root_t *root,
+     apr_pool_t *pool);
 
   /* Generic node operations */
   svn_error_t *(*check_path)(svn_node_kind_t *kind_p, svn_fs_root_t *root,
                              const char *path, apr_pool_t *pool);
+  /* PATHS are canonical and sorted by svn_path_compare_paths().  KINDS
+     and, if not NULL, IDS have as many elements as PATHS. */
+  svn_error_t *(*check_paths)(svn_node_kind_t *kinds,
+                              const svn_fs_id_t **ids,
+                              svn_fs_root_t *root,
+                              const apr_array_header_t *paths,
+                              apr_pool_t *pool);
   svn_error_t *(*node_history)(svn_fs_history_t **history_p,
                                svn_fs_root_t *root, const char *path,
                                apr_pool_t *pool);
@@ -277,6 +313,9 @@ typedef struct root_vtable_t
   /* Directories */
   svn_error_t *(*dir_entries)(apr_hash_t **entries_p, svn_fs_root_t *root,
                               const char *path, apr_pool_t *pool);
+  svn_error_t *(*dir_entries_sorted)(apr_array_header_t **entries_p,
+                                     svn_fs_root_t *root, const char *path,
+                                     apr_pool_t *pool);
   svn_error_t *(*make_dir)(svn_fs_root_t *root, const char *path,
                            apr_pool_t *pool);
   svn_error_t *(*copy)(svn_fs_root_t *from_root, const char *from_path,
@@ -345,10 +384,21 @@ typedef struct history_vtable_t
 } history_vtable_t;
 
 
+typedef struct change_iterator_vtable_t
+{
+  svn_error_t *(*get)(const char **path,
+                      svn_fs_path_change2_t **change,
+                      svn_fs_path_change_iterator_t *iterator,
+                      apr_pool_t *pool);
+} change_iterator_vtable_t;
+
+
 typedef struct id_vtable_t
 {
   svn_string_t *(*unparse)(const svn_fs_id_t *id, apr_pool_t *pool);
   int (*compare)(const svn_fs_id_t *a, const svn_fs_id_t *b);
+  /* May be NULL if the back end has no notion of storage order. */
+  int (*compare_location)(const svn_fs_id_t *a, const svn_fs_id_t *b);
 } id_vtable_t;
 
 
@@ -439,6 +489,14 @@ struct svn_fs_history_t
 };
 
 
+struct svn_fs_path_change_iterator_t
+{
+  /* FSAP-specific vtable and private data */
+  change_iterator_vtable_t *vtable;
+  void *fsap_data;
+};
+
+
 struct svn_fs_id_t
 {
   /* FSAP-specific vtable and private data */
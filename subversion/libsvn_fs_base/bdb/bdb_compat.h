@@ -64,6 +64,17 @@ extern "C" {
 #define SVN_BDB_AUTO_RECOVER (0)
 #endif
 
+/* BDB 4.7 accepts DB_TXN_WRITE_NOSYNC when committing a transaction,
+   which writes the log records to the OS without flushing them to
+   disk.  Older versions only have DB_TXN_NOSYNC, which keeps them in
+   the log buffer. */
+#if defined(DB_TXN_WRITE_NOSYNC) \
+    && (DB_VERSION_MAJOR > 4 || (DB_VERSION_MAJOR == 4 && DB_VERSION_MINOR >= 7))
+#define SVN_BDB_TXN_GROUP_COMMIT (DB_TXN_WRITE_NOSYNC)
+#else
+#define SVN_BDB_TXN_GROUP_COMMIT (DB_TXN_NOSYNC)
+#endif
+
 
 /* Explicit BDB version check. */
 #define SVN_BDB_VERSION_AT_LEAST(major,minor) \
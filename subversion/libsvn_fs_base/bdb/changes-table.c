@@ -258,7 +258,10 @@ svn_fs_bdb__changes_fetch(apr_hash_t **changes_p,
 {
   base_fs_data_t *bfd = fs->fsap_data;
   DBC *cursor;
-  DBT query, result;
+  DBT query;
+  svn_fs_base__bulk_t bulk;
+  const char *data;
+  apr_size_t size;
   int db_err = 0, db_c_err = 0;
   svn_error_t *err = SVN_NO_ERROR;
   apr_hash_t *changes = apr_hash_make(pool);
@@ -271,12 +274,11 @@ svn_fs_bdb__changes_fetch(apr_hash_t **changes_p,
                    bfd->changes->cursor(bfd->changes, trail->db_txn,
                                         &cursor, 0)));
 
-  /* Advance the cursor to the key that we're looking for. */
+  /* Advance the cursor to the key that we're looking for, fetching
+     the records in batches. */
   svn_fs_base__str_to_dbt(&query, key);
-  svn_fs_base__result_dbt(&result);
-  db_err = svn_bdb_dbc_get(cursor, &query, &result, DB_SET);
-  if (! db_err)
-    svn_fs_base__track_dbt(&result, pool);
+  svn_fs_base__bulk_init(&bulk, cursor, &query, DB_SET, 0, pool);
+  db_err = svn_fs_base__bulk_next(&data, &size, &bulk);
 
   while (! db_err)
     {
@@ -286,9 +288,9 @@ svn_fs_bdb__changes_fetch(apr_hash_t **changes_p,
       /* Clear the per-iteration subpool. */
       svn_pool_clear(subpool);
 
-      /* RESULT now contains a change record associated with KEY.  We
+      /* DATA now contains a change record associated with KEY.  We
          need to parse that skel into an change_t structure ...  */
-      result_skel = svn_skel__parse(result.data, result.size, subpool);
+      result_skel = svn_skel__parse(data, size, subpool);
       if (! result_skel)
         {
           err = svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
@@ -336,12 +338,8 @@ svn_fs_bdb__changes_fetch(apr_hash_t **changes_p,
             }
         }
 
-      /* Advance the cursor to the next record with this same KEY, and
-         fetch that record. */
-      svn_fs_base__result_dbt(&result);
-      db_err = svn_bdb_dbc_get(cursor, &query, &result, DB_NEXT_DUP);
-      if (! db_err)
-        svn_fs_base__track_dbt(&result, pool);
+      /* Move on to the next record with this same KEY. */
+      db_err = svn_fs_base__bulk_next(&data, &size, &bulk);
     }
 
   /* Destroy the per-iteration subpool. */
@@ -381,7 +379,10 @@ svn_fs_bdb__changes_fetch_raw(apr_array_header_t **changes_p,
 {
   base_fs_data_t *bfd = fs->fsap_data;
   DBC *cursor;
-  DBT query, result;
+  DBT query;
+  svn_fs_base__bulk_t bulk;
+  const char *data;
+  apr_size_t size;
   int db_err = 0, db_c_err = 0;
   svn_error_t *err = SVN_NO_ERROR;
   change_t *change;
@@ -394,20 +395,19 @@ svn_fs_bdb__changes_fetch_raw(apr_array_header_t **changes_p,
                    bfd->changes->cursor(bfd->changes, trail->db_txn,
                                         &cursor, 0)));
 
-  /* Advance the cursor to the key that we're looking for. */
+  /* Advance the cursor to the key that we're looking for, fetching
+     the records in batches. */
   svn_fs_base__str_to_dbt(&query, key);
-  svn_fs_base__result_dbt(&result);
-  db_err = svn_bdb_dbc_get(cursor, &query, &result, DB_SET);
-  if (! db_err)
-    svn_fs_base__track_dbt(&result, pool);
+  svn_fs_base__bulk_init(&bulk, cursor, &query, DB_SET, 0, pool);
+  db_err = svn_fs_base__bulk_next(&data, &size, &bulk);
 
   while (! db_err)
     {
       svn_skel_t *result_skel;
 
-      /* RESULT now contains a change record associated with KEY.  We
+      /* DATA now contains a change record associated with KEY.  We
          need to parse that skel into an change_t structure ...  */
-      result_skel = svn_skel__parse(result.data, result.size, pool);
+      result_skel = svn_skel__parse(data, size, pool);
       if (! result_skel)
         {
           err = svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
@@ -422,12 +422,8 @@ svn_fs_bdb__changes_fetch_raw(apr_array_header_t **changes_p,
       /* ... and add it to our return array.  */
       APR_ARRAY_PUSH(changes, change_t *) = change;
 
-      /* Advance the cursor to the next record with this same KEY, and
-         fetch that record. */
-      svn_fs_base__result_dbt(&result);
-      db_err = svn_bdb_dbc_get(cursor, &query, &result, DB_NEXT_DUP);
-      if (! db_err)
-        svn_fs_base__track_dbt(&result, pool);
+      /* Move on to the next record with this same KEY. */
+      db_err = svn_fs_base__bulk_next(&data, &size, &bulk);
     }
 
   /* If there are no (more) change records for this KEY, we're
@@ -30,6 +30,7 @@
 #include "svn_private_config.h"
 
 #include "../id.h"
+#include "bdb_compat.h"
 #include "dbt.h"
 
 
@@ -99,6 +100,84 @@ svn_fs_base__track_dbt(DBT *dbt, apr_pool_t *pool)
 }
 
 
+/* Bulk buffers must be a multiple of 1024 bytes, and at least as large
+   as a database page, which is 64k at most.  */
+#define BULK_MIN_SIZE (64 * 1024)
+#define BULK_ALIGN(size) (((size) + 1023) & ~(apr_size_t)1023)
+
+/* Make the buffer of BULK hold at least SIZE bytes.  */
+static void
+bulk_alloc(svn_fs_base__bulk_t *bulk, apr_size_t size)
+{
+  size = size < BULK_MIN_SIZE ? BULK_MIN_SIZE : BULK_ALIGN(size);
+
+  svn_fs_base__clear_dbt(&bulk->buffer);
+  bulk->buffer.data = apr_palloc(bulk->pool, size);
+  bulk->buffer.ulen = (u_int32_t) size;
+  bulk->buffer.flags |= DB_DBT_USERMEM;
+}
+
+
+void
+svn_fs_base__bulk_init(svn_fs_base__bulk_t *bulk,
+                       DBC *cursor,
+                       DBT *key,
+                       u_int32_t flags,
+                       apr_size_t size,
+                       apr_pool_t *pool)
+{
+  bulk->cursor = cursor;
+  bulk->key = key;
+  bulk->flags = flags;
+  bulk->next = NULL;
+  bulk->pool = pool;
+  bulk_alloc(bulk, size);
+}
+
+
+int
+svn_fs_base__bulk_next(const char **data,
+                       apr_size_t *size,
+                       svn_fs_base__bulk_t *bulk)
+{
+  while (1)
+    {
+      int db_err;
+
+      if (bulk->next)
+        {
+          void *item;
+          u_int32_t item_size;
+
+          DB_MULTIPLE_NEXT(bulk->next, &bulk->buffer, item, item_size);
+          if (bulk->next)
+            {
+              *data = item;
+              *size = item_size;
+              return 0;
+            }
+        }
+
+      /* Fetch the next batch.  If not even a single record fits into
+         the buffer, BDB tells us how much space it needs.  */
+      db_err = svn_bdb_dbc_get(bulk->cursor, bulk->key, &bulk->buffer,
+                               bulk->flags | DB_MULTIPLE);
+      if (db_err == SVN_BDB_DB_BUFFER_SMALL)
+        {
+          bulk_alloc(bulk, bulk->buffer.size > bulk->buffer.ulen
+                             ? bulk->buffer.size
+                             : 2 * (apr_size_t) bulk->buffer.ulen);
+          continue;
+        }
+      if (db_err)
+        return db_err;
+
+      bulk->flags = DB_NEXT_DUP;
+      DB_MULTIPLE_INIT(bulk->next, &bulk->buffer);
+    }
+}
+
+
 DBT *
 svn_fs_base__recno_dbt(DBT *dbt, db_recno_t *recno)
 {
@@ -83,6 +83,47 @@ DBT *svn_fs_base__result_dbt(DBT *dbt);
 DBT *svn_fs_base__track_dbt(DBT *dbt, apr_pool_t *pool);
 
 
+/* State for reading the values of duplicate records in batches, using
+   Berkeley DB's bulk retrieval (DB_MULTIPLE).  This saves a cursor
+   operation, and a malloc, per record.  */
+typedef struct svn_fs_base__bulk_t
+{
+  /* The cursor and key used for fetching the next batch.  */
+  DBC *cursor;
+  DBT *key;
+
+  /* Cursor movement for the next batch, without DB_MULTIPLE.  */
+  u_int32_t flags;
+
+  /* The current batch, and our position within it.  NEXT is NULL if
+     there is no batch, or if it has been consumed completely.  */
+  DBT buffer;
+  void *next;
+
+  /* Where to allocate a larger buffer, should a record not fit.  */
+  apr_pool_t *pool;
+} svn_fs_base__bulk_t;
+
+/* Prepare BULK for reading the values of the records with key KEY
+   through CURSOR, starting with the record CURSOR gets positioned at by
+   FLAGS (DB_SET, DB_CURRENT or DB_NEXT_DUP).  Use a buffer of at least
+   SIZE bytes, allocated in POOL.  */
+void svn_fs_base__bulk_init(svn_fs_base__bulk_t *bulk,
+                            DBC *cursor,
+                            DBT *key,
+                            u_int32_t flags,
+                            apr_size_t size,
+                            apr_pool_t *pool);
+
+/* Set *DATA and *SIZE to the value of the next record read through
+   BULK.  *DATA remains valid until the next call for BULK.  Return a
+   Berkeley DB error code, which will be DB_NOTFOUND after the last
+   record with the key of BULK.  The cursor does not get closed.  */
+int svn_fs_base__bulk_next(const char **data,
+                           apr_size_t *size,
+                           svn_fs_base__bulk_t *bulk);
+
+
 /* Prepare DBT for use as a key into a RECNO table.  This call makes
    DBT refer to the db_recno_t pointed to by RECNO as its buffer; the
    record number you assign to *RECNO will be the table key.  */
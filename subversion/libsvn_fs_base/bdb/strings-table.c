@@ -20,6 +20,8 @@
  * ====================================================================
  */
 
+#include <string.h>
+
 #include "bdb_compat.h"
 #include "svn_fs.h"
 #include "svn_pools.h"
@@ -75,6 +77,10 @@ svn_fs_bdb__open_strings_table(DB **strings_p,
 
 /*** Storing and retrieving strings.  ***/
 
+/* The size of the buffers for reading records in batches.  Records
+   larger than that still get fetched one at a time.  */
+#define STRING_BULK_SIZE (1024 * 1024)
+
 /* Allocate *CURSOR and advance it to first row in the set of rows
    whose key is defined by QUERY.  Set *LENGTH to the size of that
    first row.  */
@@ -229,45 +235,55 @@ svn_fs_bdb__string_read(svn_fs_t *fs,
     }
 
   /* The current record contains OFFSET. Fetch the contents now. Note that
-     OFFSET has been moved to be relative to this record. The length could
-     quite easily extend past this record, so we use DB_DBT_PARTIAL and
-     read successive records until we've filled the request.  */
-  while (1)
+     OFFSET has been moved to be relative to this record. We use
+     DB_DBT_PARTIAL to read only what's needed from this record.  */
+  svn_fs_base__clear_dbt(&result);
+  result.data = buf;
+  result.ulen = *len;
+  result.doff = (u_int32_t)offset;
+  result.dlen = *len;
+  result.flags |= (DB_DBT_USERMEM | DB_DBT_PARTIAL);
+  db_err = svn_bdb_dbc_get(cursor, &query, &result, DB_CURRENT);
+  if (db_err)
     {
-      svn_fs_base__clear_dbt(&result);
-      result.data = buf + bytes_read;
-      result.ulen = *len - bytes_read;
-      result.doff = (u_int32_t)offset;
-      result.dlen = *len - bytes_read;
-      result.flags |= (DB_DBT_USERMEM | DB_DBT_PARTIAL);
-      db_err = svn_bdb_dbc_get(cursor, &query, &result, DB_CURRENT);
-      if (db_err)
-        {
-          svn_bdb_dbc_close(cursor);
-          return BDB_WRAP(fs, "reading string", db_err);
-        }
+      svn_bdb_dbc_close(cursor);
+      return BDB_WRAP(fs, "reading string", db_err);
+    }
+  bytes_read = result.size;
 
-      bytes_read += result.size;
-      if (bytes_read == *len)
+  /* The length could quite easily extend past this record.  Read the
+     successive records in batches until we've filled the request.  */
+  if (bytes_read < *len)
+    {
+      svn_fs_base__bulk_t bulk;
+      const char *data;
+      apr_size_t size = *len - bytes_read;
+
+      svn_fs_base__bulk_init(&bulk, cursor, &query, DB_NEXT_DUP,
+                             size < STRING_BULK_SIZE ? size : STRING_BULK_SIZE,
+                             pool);
+      while (bytes_read < *len)
         {
-          /* Done with the cursor. */
-          SVN_ERR(BDB_WRAP(fs, "closing string-reading cursor",
-                           svn_bdb_dbc_close(cursor)));
-          break;
+          db_err = svn_fs_base__bulk_next(&data, &size, &bulk);
+          if (db_err == DB_NOTFOUND)
+            break;
+          if (db_err)
+            {
+              svn_bdb_dbc_close(cursor);
+              return BDB_WRAP(fs, "reading string", db_err);
+            }
+
+          if (size > *len - bytes_read)
+            size = *len - bytes_read;
+          memcpy(buf + bytes_read, data, size);
+          bytes_read += size;
         }
-
-      /* Remember, if any error happens, our cursor has been closed
-         for us. */
-      db_err = get_next_length(&length, cursor, &query);
-      if (db_err == DB_NOTFOUND)
-        break;
-      if (db_err)
-        return BDB_WRAP(fs, "reading string", db_err);
-
-      /* We'll be reading from the beginning of the next record */
-      offset = 0;
     }
 
+  /* Done with the cursor. */
+  SVN_ERR(BDB_WRAP(fs, "closing string-reading cursor",
+                   svn_bdb_dbc_close(cursor)));
+
   *len = bytes_read;
   return SVN_NO_ERROR;
 }
@@ -479,6 +495,9 @@ svn_fs_bdb__string_copy(svn_fs_t *fs,
   DBT result;
   DBT copykey;
   DBC *cursor;
+  svn_fs_base__bulk_t bulk;
+  const char *data;
+  apr_size_t size;
   int db_err;
 
   /* Copy off the old key in case the caller is sharing storage
@@ -495,10 +514,10 @@ svn_fs_bdb__string_copy(svn_fs_t *fs,
   svn_fs_base__str_to_dbt(&query, old_key);
   svn_fs_base__str_to_dbt(&copykey, *new_key);
 
-  svn_fs_base__clear_dbt(&result);
-
-  /* Move to the first record and fetch its data (under BDB's mem mgmt). */
-  db_err = svn_bdb_dbc_get(cursor, &query, &result, DB_SET);
+  /* Move to the first record and fetch the records in batches. */
+  svn_fs_base__bulk_init(&bulk, cursor, &query, DB_SET, STRING_BULK_SIZE,
+                         pool);
+  db_err = svn_fs_base__bulk_next(&data, &size, &bulk);
   if (db_err)
     {
       svn_bdb_dbc_close(cursor);
@@ -507,17 +526,11 @@ svn_fs_bdb__string_copy(svn_fs_t *fs,
 
   while (1)
     {
-      /* ### can we pass a BDB-provided buffer to another BDB function?
-         ### they are supposed to have a duration up to certain points
-         ### of calling back into BDB, but I'm not sure what the exact
-         ### rules are. it is definitely nicer to use BDB buffers here
-         ### to simplify things and reduce copies, but... hrm.
-      */
-
       /* Write the data to the database */
       svn_fs_base__trail_debug(trail, "strings", "put");
-      db_err = bfd->strings->put(bfd->strings, trail->db_txn,
-                                 &copykey, &result, 0);
+      db_err = bfd->strings->put(bfd->strings, trail->db_txn, &copykey,
+                                 svn_fs_base__set_dbt(&result, data, size),
+                                 0);
       if (db_err)
         {
           svn_bdb_dbc_close(cursor);
@@ -525,8 +538,7 @@ svn_fs_bdb__string_copy(svn_fs_t *fs,
         }
 
       /* Read the next chunk. Terminate loop if we're done. */
-      svn_fs_base__clear_dbt(&result);
-      db_err = svn_bdb_dbc_get(cursor, &query, &result, DB_NEXT_DUP);
+      db_err = svn_fs_base__bulk_next(&data, &size, &bulk);
       if (db_err == DB_NOTFOUND)
         break;
       if (db_err)
@@ -42,6 +42,7 @@
 #include "tree.h"
 #include "id.h"
 #include "lock.h"
+#include "trail.h"
 #define SVN_WANT_BDB
 #include "svn_private_config.h"
 
@@ -162,6 +163,10 @@ cleanup_fs(svn_fs_t *fs)
   if (!bdb)
     return SVN_NO_ERROR;
 
+  /* Don't leave group-committed trails behind unflushed.  */
+  if (!svn_fs_bdb__get_panic(bdb))
+    SVN_ERR(svn_fs_base__sync_trails(fs));
+
   /* Close the databases.  */
   SVN_ERR(cleanup_fs_db(fs, &bfd->nodes, "nodes"));
   SVN_ERR(cleanup_fs_db(fs, &bfd->revisions, "revisions"));
@@ -314,6 +319,45 @@ base_bdb_set_errcall(svn_fs_t *fs,
 }
 
 
+static svn_error_t *
+base_get_cache_info(apr_hash_t **info_p,
+                    svn_fs_t *fs,
+                    svn_boolean_t reset,
+                    apr_pool_t *pool)
+{
+  /* BDB does its own caching. */
+  *info_p = apr_hash_make(pool);
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+base_log_index_prev(svn_boolean_t *indexed,
+                    svn_revnum_t *revision,
+                    svn_boolean_t *added,
+                    svn_fs_t *fs,
+                    const char *path,
+                    svn_revnum_t rev,
+                    apr_pool_t *pool)
+{
+  /* There is no log index for BDB; callers walk the node history. */
+  *indexed = FALSE;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+base_dated_revision(svn_boolean_t *indexed,
+                    svn_revnum_t *revision,
+                    svn_fs_t *fs,
+                    apr_time_t tm,
+                    apr_pool_t *pool)
+{
+  /* Nor is there a date index; callers search the revision props. */
+  *indexed = FALSE;
+  return SVN_NO_ERROR;
+}
+
+
 /* Write the DB_CONFIG file. */
 static svn_error_t *
 bdb_write_config(svn_fs_t *fs)
@@ -497,6 +541,11 @@ static fs_vtable_t fs_vtable = {
   svn_fs_base__get_lock,
   svn_fs_base__get_locks,
   base_bdb_set_errcall,
+  base_get_cache_info,
+  base_log_index_prev,
+  base_dated_revision,
+  NULL,
+  NULL
 };
 
 /* Where the format number is stored. */
@@ -522,6 +571,14 @@ open_databases(svn_fs_t *fs,
   /* Initialize the fs's path. */
   fs->path = apr_pstrdup(fs->pool, path);
 
+  if (fs->config)
+    {
+      const char *val = apr_hash_get(fs->config,
+                                     SVN_FS_CONFIG_BDB_GROUP_COMMIT,
+                                     APR_HASH_KEY_STRING);
+      bfd->group_commit = (val && strcmp(val, "0") != 0);
+    }
+
   if (create)
     SVN_ERR(bdb_write_config(fs));
 
@@ -889,6 +946,7 @@ base_bdb_recover(svn_fs_t *fs,
 static svn_error_t *
 base_bdb_pack(svn_fs_t *fs,
               const char *path,
+              int jobs,
               svn_fs_pack_notify_t notify_func,
               void *notify_baton,
               svn_cancel_func_t cancel,
@@ -1161,6 +1219,9 @@ static svn_error_t *
 base_hotcopy(const char *src_path,
              const char *dest_path,
              svn_boolean_t clean_logs,
+             svn_boolean_t incremental,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
              apr_pool_t *pool)
 {
   svn_error_t *err;
@@ -1168,6 +1229,11 @@ base_hotcopy(const char *src_path,
   svn_boolean_t log_autoremove = FALSE;
   int format;
 
+  if (incremental)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("BDB repositories do not support incremental "
+                              "hotcopy"));
+
   /* Check the FS format number to be certain that we know how to
      hotcopy this FS.  Pre-1.2 filesystems did not have a format file (you
      could say they were format "0"), so we will error here.  This is not
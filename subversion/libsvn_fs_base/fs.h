@@ -108,6 +108,11 @@ typedef struct
      transaction trail alive. */
   svn_boolean_t in_txn_trail;
 
+  /* Whether trails get committed without flushing the Berkeley DB log,
+     which then gets flushed once per committed revision.  See
+     SVN_FS_CONFIG_BDB_GROUP_COMMIT. */
+  svn_boolean_t group_commit;
+
   /* The filesystem UUID (or NULL if not-yet-known; see svn_fs_get_uuid). */
   const char *uuid;
 
@@ -123,7 +123,8 @@ svn_fs_base__id_compare(const svn_fs_id_t *a,
 
 static id_vtable_t id_vtable = {
   svn_fs_base__id_unparse,
-  svn_fs_base__id_compare
+  svn_fs_base__id_compare,
+  NULL  /* compare_location: nodes live in tables, not in files */
 };
 
 
@@ -257,10 +257,12 @@ get_one_window(struct compose_handler_baton *cb,
                int cur_chunk)
 {
   svn_stream_t *wstream;
-  char diffdata[4096];   /* hunk of svndiff data */
-  svn_filesize_t off;    /* offset into svndiff data */
+  char diffdata[4];      /* svndiff header */
+  char *svndiff;         /* svndiff data of this window */
+  svn_filesize_t size;   /* size of the svndiff data */
   apr_size_t amt;        /* how much svndiff data to/was read */
   const char *str_key;
+  apr_pool_t *subpool;
 
   apr_array_header_t *chunks = rep->contents.delta.chunks;
   rep_delta_chunk_t *this_chunk, *first_chunk;
@@ -294,18 +296,23 @@ get_one_window(struct compose_handler_baton *cb,
   this_chunk = APR_ARRAY_IDX(chunks, cur_chunk, rep_delta_chunk_t*);
   str_key = this_chunk->string_key;
 
-  /* Run through the svndiff data, at least as far as necessary. */
-  off = 0;
-  do
-    {
-      amt = sizeof(diffdata);
-      SVN_ERR(svn_fs_bdb__string_read(fs, str_key, diffdata,
-                                      off, &amt, cb->trail,
-                                      cb->trail->pool));
-      off += amt;
-      SVN_ERR(svn_stream_write(wstream, diffdata, &amt));
-    }
-  while (amt != 0);
+  /* Read all of the svndiff data at once, so that the string's records
+     get fetched in batches instead of being looked up again for every
+     hunk. */
+  SVN_ERR(svn_fs_bdb__string_size(&size, fs, str_key, cb->trail,
+                                  cb->trail->pool));
+  if (size > SVN_MAX_OBJECT_SIZE)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Svndiff data of string '%s' is too large"),
+                             str_key);
+
+  subpool = svn_pool_create(cb->trail->pool);
+  amt = (apr_size_t) size;
+  svndiff = apr_palloc(subpool, amt);
+  SVN_ERR(svn_fs_bdb__string_read(fs, str_key, svndiff, 0, &amt, cb->trail,
+                                  subpool));
+  SVN_ERR(svn_stream_write(wstream, svndiff, &amt));
+  svn_pool_destroy(subpool);
   SVN_ERR(svn_stream_close(wstream));
 
   SVN_ERR_ASSERT(!cb->init);
@@ -645,18 +652,13 @@ struct rep_read_baton
      trail's pool will be used.  Otherwise, see `pool' below.  */
   trail_t *trail;
 
-  /* MD5 checksum context.  Initialized when the baton is created, updated as
-     we read data, and finalized when the stream is closed. */
-  svn_checksum_ctx_t *md5_checksum_ctx;
+  /* MD5 and SHA1 checksum context.  Initialized when the baton is
+     created, updated as we read data, and finalized when the stream is
+     closed. */
+  svn_checksum_ctx_t *checksum_ctx;
 
-  /* Final resting place of the checksum created by md5_checksum_cxt. */
+  /* Final resting place of the checksums created by checksum_ctx. */
   svn_checksum_t *md5_checksum;
-
-  /* SHA1 checksum context.  Initialized when the baton is created, updated as
-     we read data, and finalized when the stream is closed. */
-  svn_checksum_ctx_t *sha1_checksum_ctx;
-
-  /* Final resting place of the checksum created by sha1_checksum_cxt. */
   svn_checksum_t *sha1_checksum;
 
   /* The length of the rep's contents (as fulltext, that is,
@@ -691,8 +693,7 @@ rep_read_get_baton(struct rep_read_baton **rb_p,
   struct rep_read_baton *b;
 
   b = apr_pcalloc(pool, sizeof(*b));
-  b->md5_checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
-  b->sha1_checksum_ctx = svn_checksum_ctx_create(svn_checksum_sha1, pool);
+  b->checksum_ctx = svn_checksum__ctx_create_md5_sha1(pool);
 
   if (rep_key)
     SVN_ERR(svn_fs_base__rep_contents_size(&(b->size), fs, rep_key,
@@ -897,19 +898,17 @@ txn_body_read_rep(void *baton, trail_t *trail)
        */
       if (! args->rb->checksum_finalized)
         {
-          SVN_ERR(svn_checksum_update(args->rb->md5_checksum_ctx, args->buf,
-                                      *(args->len)));
-          SVN_ERR(svn_checksum_update(args->rb->sha1_checksum_ctx, args->buf,
+          SVN_ERR(svn_checksum_update(args->rb->checksum_ctx, args->buf,
                                       *(args->len)));
 
           if (args->rb->offset == args->rb->size)
             {
               representation_t *rep;
 
-              svn_checksum_final(&args->rb->md5_checksum,
-                                 args->rb->md5_checksum_ctx, trail->pool);
-              svn_checksum_final(&args->rb->sha1_checksum,
-                                 args->rb->sha1_checksum_ctx, trail->pool);
+              SVN_ERR(svn_checksum__final_md5_sha1(&args->rb->md5_checksum,
+                                                   &args->rb->sha1_checksum,
+                                                   args->rb->checksum_ctx,
+                                                   trail->pool));
               args->rb->checksum_finalized = TRUE;
 
               SVN_ERR(svn_fs_bdb__read_rep(&rep, args->rb->fs,
@@ -1014,9 +1013,8 @@ struct rep_write_baton
   /* SHA1 and MD5 checksums.  Initialized when the baton is created,
      updated as we write data, and finalized and stored when the
      stream is closed. */
-  svn_checksum_ctx_t *md5_checksum_ctx;
+  svn_checksum_ctx_t *checksum_ctx;
   svn_checksum_t *md5_checksum;
-  svn_checksum_ctx_t *sha1_checksum_ctx;
   svn_checksum_t *sha1_checksum;
   svn_boolean_t finalized;
 
@@ -1036,8 +1034,7 @@ rep_write_get_baton(svn_fs_t *fs,
   struct rep_write_baton *b;
 
   b = apr_pcalloc(pool, sizeof(*b));
-  b->md5_checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
-  b->sha1_checksum_ctx = svn_checksum_ctx_create(svn_checksum_sha1, pool);
+  b->checksum_ctx = svn_checksum__ctx_create_md5_sha1(pool);
   b->fs = fs;
   b->trail = trail;
   b->pool = pool;
@@ -1117,9 +1114,7 @@ txn_body_write_rep(void *baton, trail_t *trail)
                     args->wb->txn_id,
                     trail,
                     trail->pool));
-  SVN_ERR(svn_checksum_update(args->wb->md5_checksum_ctx,
-                              args->buf, args->len));
-  SVN_ERR(svn_checksum_update(args->wb->sha1_checksum_ctx,
+  SVN_ERR(svn_checksum_update(args->wb->checksum_ctx,
                               args->buf, args->len));
   return SVN_NO_ERROR;
 }
@@ -1199,10 +1194,9 @@ rep_write_close_contents(void *baton)
 
   if (! wb->finalized)
     {
-      SVN_ERR(svn_checksum_final(&wb->md5_checksum, wb->md5_checksum_ctx,
-                                 wb->pool));
-      SVN_ERR(svn_checksum_final(&wb->sha1_checksum, wb->sha1_checksum_ctx,
-                                 wb->pool));
+      SVN_ERR(svn_checksum__final_md5_sha1(&wb->md5_checksum,
+                                           &wb->sha1_checksum,
+                                           wb->checksum_ctx, wb->pool));
       wb->finalized = TRUE;
     }
 
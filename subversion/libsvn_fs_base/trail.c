@@ -156,7 +156,10 @@ commit_trail(trail_t *trail)
          An error during txn commit will abort the transaction anyway. */
       bfd->in_txn_trail = FALSE;
       SVN_ERR(BDB_WRAP(fs, "committing Berkeley DB transaction",
-                       trail->db_txn->commit(trail->db_txn, 0)));
+                       trail->db_txn->commit(trail->db_txn,
+                                             bfd->group_commit
+                                             ? SVN_BDB_TXN_GROUP_COMMIT
+                                             : 0)));
     }
 
   /* Do a checkpoint here, if enough has gone on.
@@ -280,6 +283,19 @@ svn_fs_base__retry_txn(svn_fs_t *fs,
 }
 
 
+svn_error_t *
+svn_fs_base__sync_trails(svn_fs_t *fs)
+{
+  base_fs_data_t *bfd = fs->fsap_data;
+
+  if (! bfd->group_commit)
+    return SVN_NO_ERROR;
+
+  return BDB_WRAP(fs, "flushing Berkeley DB log",
+                  bfd->bdb->env->log_flush(bfd->bdb->env, NULL));
+}
+
+
 svn_error_t *
 svn_fs_base__retry(svn_fs_t *fs,
                    svn_error_t *(*txn_body)(void *baton, trail_t *trail),
@@ -224,6 +224,13 @@ svn_error_t *svn_fs_base__retry(svn_fs_t *fs,
                                 apr_pool_t *pool);
 
 
+/* If the trails of FS are group-committed (see
+   SVN_FS_CONFIG_BDB_GROUP_COMMIT), flush the Berkeley DB log to disk,
+   making all trails committed so far durable.  Otherwise, every trail
+   already was when it got committed, and this is a no-op. */
+svn_error_t *svn_fs_base__sync_trails(svn_fs_t *fs);
+
+
 /* Record that OPeration is being done on TABLE in the TRAIL. */
 #if defined(SVN_FS__TRAIL_DEBUG)
 void svn_fs_base__trail_debug(trail_t *trail, const char *table,
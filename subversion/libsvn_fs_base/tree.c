@@ -1168,6 +1168,143 @@ base_check_path(svn_node_kind_t *kind_p,
 }
 
 
+/* An element of the directory stack walked by txn_body_check_paths. */
+struct check_paths_dir_t
+{
+  /* canonical path of NODE */
+  const char *path;
+
+  /* the node opened for PATH */
+  dag_node_t *node;
+};
+
+
+struct check_paths_args
+{
+  svn_node_kind_t *kinds;
+  const svn_fs_id_t **ids;
+  svn_fs_root_t *root;
+  const apr_array_header_t *paths;
+};
+
+
+/* Because ARGS->paths are sorted such that every directory is directly
+   followed by its contents, keep the chain of directories opened for
+   the previous path on a stack and open only the components below the
+   deepest one that is shared. */
+static svn_error_t *
+txn_body_check_paths(void *baton, trail_t *trail)
+{
+  struct check_paths_args *args = baton;
+  apr_array_header_t *stack = apr_array_make(trail->pool, 16,
+                                             sizeof(struct check_paths_dir_t));
+  struct check_paths_dir_t *top;
+  int i;
+
+  top = apr_array_push(stack);
+  top->path = "/";
+  SVN_ERR(root_node(&top->node, args->root, trail, trail->pool));
+
+  for (i = 0; i < args->paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(args->paths, i, const char *);
+      dag_node_t *here;
+      const char *path_so_far;
+      const char *rest;
+
+      /* Go up to the deepest directory shared with the previous path.
+         The root directory is shared by all of them. */
+      top = &APR_ARRAY_IDX(stack, stack->nelts - 1, struct check_paths_dir_t);
+      while (! svn_uri_is_ancestor(top->path, path))
+        {
+          apr_array_pop(stack);
+          top = &APR_ARRAY_IDX(stack, stack->nelts - 1,
+                               struct check_paths_dir_t);
+        }
+
+      here = top->node;
+      path_so_far = top->path;
+      rest = path + strlen(path_so_far);
+      if (*rest == '/')
+        rest++;
+
+      /* Open the remaining components, pushing each onto the stack. */
+      while (here && *rest)
+        {
+          const char *next;
+          char *entry;
+          dag_node_t *child;
+
+          if (svn_fs_base__dag_node_kind(here) != svn_node_dir)
+            {
+              here = NULL;
+              break;
+            }
+
+          entry = svn_fs__next_entry_name(&next, rest, trail->pool);
+          path_so_far = svn_uri_join(path_so_far, entry, trail->pool);
+
+          child = dag_node_cache_get(args->root, path_so_far, trail->pool);
+          if (! child)
+            {
+              svn_error_t *err = svn_fs_base__dag_open(&child, here, entry,
+                                                       trail, trail->pool);
+              if (err && err->apr_err == SVN_ERR_FS_NOT_FOUND)
+                {
+                  svn_error_clear(err);
+                  here = NULL;
+                  break;
+                }
+              SVN_ERR(err);
+
+              dag_node_cache_set(args->root, path_so_far, child);
+            }
+
+          top = apr_array_push(stack);
+          top->path = path_so_far;
+          top->node = child;
+
+          here = child;
+          rest = next ? next : "";
+        }
+
+      if (here)
+        {
+          args->kinds[i] = svn_fs_base__dag_node_kind(here);
+          if (args->ids)
+            args->ids[i] = svn_fs_base__dag_get_id(here);
+        }
+      else
+        {
+          args->kinds[i] = svn_node_none;
+          if (args->ids)
+            args->ids[i] = NULL;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+base_check_paths(svn_node_kind_t *kinds,
+                 const svn_fs_id_t **ids,
+                 svn_fs_root_t *root,
+                 const apr_array_header_t *paths,
+                 apr_pool_t *pool)
+{
+  struct check_paths_args args;
+
+  args.kinds = kinds;
+  args.ids = ids;
+  args.root = root;
+  args.paths = paths;
+  SVN_ERR(svn_fs_base__retry_txn(root->fs, txn_body_check_paths, &args,
+                                 FALSE, pool));
+  return SVN_NO_ERROR;
+}
+
+
 struct node_prop_args
 {
   svn_string_t **value_p;
@@ -1261,6 +1398,28 @@ base_node_proplist(apr_hash_t **table_p,
   return SVN_NO_ERROR;
 }
 
+/* Implements root_vtable_t.dir_entries_sorted. */
+static svn_error_t *
+base_dir_entries_sorted(apr_array_header_t **entries_p,
+                        svn_fs_root_t *root,
+                        const char *path,
+                        apr_pool_t *pool)
+{
+  apr_hash_t *table;
+  apr_array_header_t *sorted;
+  int i;
+
+  SVN_ERR(base_dir_entries(&table, root, path, pool));
+  sorted = svn_sort__hash(table, svn_sort_compare_items_lexically, pool);
+
+  *entries_p = apr_array_make(pool, sorted->nelts, sizeof(svn_fs_dirent_t *));
+  for (i = 0; i < sorted->nelts; i++)
+    APR_ARRAY_PUSH(*entries_p, svn_fs_dirent_t *)
+      = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
+
+  return SVN_NO_ERROR;
+}
+
 
 struct change_node_prop_args {
   svn_fs_root_t *root;
@@ -2760,6 +2919,9 @@ svn_fs_base__commit_txn(const char **conflict_p,
         }
       else
         {
+          /* Make the new revision durable if its trails weren't. */
+          SVN_ERR(svn_fs_base__sync_trails(fs));
+
           /* Set the return value -- our brand spankin' new revision! */
           *new_rev = commit_args.new_rev;
           break;
@@ -2804,6 +2966,7 @@ svn_fs_base__commit_obliteration_txn(svn_revnum_t replacing_rev,
   commit_args.txn = txn;
   SVN_ERR(svn_fs_base__retry_txn(txn->fs, txn_body_commit_obliteration,
                                  &commit_args, FALSE, pool));
+  SVN_ERR(svn_fs_base__sync_trails(txn->fs));
 
   /* Remove the old txn and any unreferenced data attached to it. */
   /* ### ... */
@@ -4235,6 +4398,20 @@ base_paths_changed(apr_hash_t **changed_paths_p,
 }
 
 
+/* The changes table has no notion of path order, so this fetches all
+   changes at once, just like base_paths_changed(). */
+static svn_error_t *
+base_paths_changed_iterator(svn_fs_path_change_iterator_t **iterator,
+                            svn_fs_root_t *root,
+                            apr_pool_t *pool)
+{
+  apr_hash_t *changes;
+
+  SVN_ERR(base_paths_changed(&changes, root, pool));
+  return svn_fs__paths_changed_iterator_from_hash(iterator, changes, pool);
+}
+
+
 
 /* Our coolio opaque history object. */
 typedef struct
@@ -5514,7 +5691,9 @@ base_get_mergeinfo(svn_mergeinfo_catalog_t *catalog,
 
 static root_vtable_t root_vtable = {
   base_paths_changed,
+  base_paths_changed_iterator,
   base_check_path,
+  base_check_paths,
   base_node_history,
   base_node_id,
   base_node_created_rev,
@@ -5528,6 +5707,7 @@ static root_vtable_t root_vtable = {
   base_change_node_prop,
   base_props_changed,
   base_dir_entries,
+  base_dir_entries_sorted,
   base_make_dir,
   base_copy,
   base_revision_link,
@@ -24,6 +24,7 @@
 #include "fs_fs.h"
 #include "id.h"
 #include "dag.h"
+#include "temp_serializer.h"
 #include "../libsvn_fs/fs-loader.h"
 
 #include "svn_config.h"
@@ -45,66 +46,80 @@ dup_id(void **out,
   return SVN_NO_ERROR;
 }
 
+
+/** Caching directory listings. **/
+/* Implements svn_cache__dup_func_t.  Rather than deep-copying every
+   entry, flatten the listing into a single buffer and resolve it in
+   place. */
+static svn_error_t *
+dup_dir_listing(void **out,
+                const void *in,
+                apr_pool_t *pool)
+{
+  char *data;
+  apr_size_t data_len;
+
+  SVN_ERR(svn_fs_fs__serialize_dir_entries(&data, &data_len,
+                                           (void *)in, /* Cast away const */
+                                           pool));
+  return svn_fs_fs__deserialize_dir_entries(out, data, data_len, pool);
+}
+
+
+/** Caching node-revisions. **/
+/* Implements svn_cache__dup_func_t */
+static svn_error_t *
+dup_node_revision(void **out,
+                  const void *in,
+                  apr_pool_t *pool)
+{
+  char *data;
+  apr_size_t data_len;
+
+  SVN_ERR(svn_fs_fs__serialize_node_revision(&data, &data_len,
+                                             (void *)in, /* Cast away const */
+                                             pool));
+  return svn_fs_fs__deserialize_node_revision(out, data, data_len, pool);
+}
+
+
+/** Caching representation headers. **/
 /* Implements svn_cache__serialize_func_t */
 static svn_error_t *
-serialize_id(char **data,
-             apr_size_t *data_len,
-             void *in,
-             apr_pool_t *pool)
+rep_header_serialize(char **data,
+                     apr_size_t *data_len,
+                     void *in,
+                     apr_pool_t *pool)
 {
-  svn_fs_id_t *id = in;
-  svn_string_t *id_str = svn_fs_fs__id_unparse(id, pool);
-  *data = (char *) id_str->data;
-  *data_len = id_str->len;
+  *data_len = sizeof(struct rep_args);
+  *data = apr_pmemdup(pool, in, *data_len);
 
   return SVN_NO_ERROR;
 }
 
-
 /* Implements svn_cache__deserialize_func_t */
 static svn_error_t *
-deserialize_id(void **out,
-               const char *data,
-               apr_size_t data_len,
-               apr_pool_t *pool)
+rep_header_deserialize(void **out,
+                       char *data,
+                       apr_size_t data_len,
+                       apr_pool_t *pool)
 {
-  svn_fs_id_t *id = svn_fs_fs__id_parse(data, data_len, pool);
-  if (id == NULL)
-    {
-      return svn_error_create(SVN_ERR_FS_NOT_ID, NULL,
-                              _("Bad ID in cache"));
-    }
+  /* DATA is ours and the struct contains no pointers. */
+  if (data_len != sizeof(struct rep_args))
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Bad size for representation header in cache"));
 
-  *out = id;
+  *out = data;
   return SVN_NO_ERROR;
 }
 
-
-/** Caching directory listings. **/
 /* Implements svn_cache__dup_func_t */
 static svn_error_t *
-dup_dir_listing(void **out,
-                const void *in,
-                apr_pool_t *pool)
+dup_rep_header(void **out,
+               const void *in,
+               apr_pool_t *pool)
 {
-  apr_hash_t *new_entries = apr_hash_make(pool);
-  apr_hash_t *entries = (void*)in; /* Cast away const only */
-  apr_hash_index_t *hi;
-
-  for (hi = apr_hash_first(pool, entries); hi; hi = apr_hash_next(hi))
-    {
-      svn_fs_dirent_t *dirent = svn__apr_hash_index_val(hi);
-      svn_fs_dirent_t *new_dirent;
-
-      new_dirent = apr_palloc(pool, sizeof(*new_dirent));
-      new_dirent->name = apr_pstrdup(pool, dirent->name);
-      new_dirent->kind = dirent->kind;
-      new_dirent->id = svn_fs_fs__id_copy(dirent->id, pool);
-      apr_hash_set(new_entries, new_dirent->name, APR_HASH_KEY_STRING,
-                   new_dirent);
-    }
-
-  *out = new_entries;
+  *out = apr_pmemdup(pool, in, sizeof(struct rep_args));
   return SVN_NO_ERROR;
 }
 
@@ -129,7 +144,7 @@ manifest_serialize(char **data,
 /* Implements svn_cache__deserialize_func_t */
 static svn_error_t *
 manifest_deserialize(void **out,
-                     const char *data,
+                     char *data,
                      apr_size_t data_len,
                      apr_pool_t *pool)
 {
@@ -156,6 +171,21 @@ dup_pack_manifest(void **out,
 }
 
 
+static svn_error_t *
+dup_revprops(void **out,
+             const void *in,
+             apr_pool_t *pool)
+{
+  char *data;
+  apr_size_t data_len;
+
+  SVN_ERR(svn_fs_fs__serialize_revprops(&data, &data_len,
+                                        (void *)in, /* Cast away const */
+                                        pool));
+  return svn_fs_fs__deserialize_revprops(out, data, data_len, pool);
+}
+
+
 /* Return a memcache in *MEMCACHE_P for FS if it's configured to use
    memcached, or NULL otherwise.  Also, sets *FAIL_STOP to a boolean
    indicating whether cache errors should be returned to the caller or
@@ -200,10 +230,16 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                                    "/", fs->path, ":",
                                    NULL);
   svn_memcache_t *memcache;
+  svn_membuffer_t *membuffer;
   svn_boolean_t no_handler;
 
   SVN_ERR(read_config(&memcache, &no_handler, fs, pool));
 
+  /* Unless memcached has been configured explicitly, put as much data
+   * as possible into the process-wide membuffer.  All svn_fs_t (and,
+   * if it lives in shared memory, all server processes) share it. */
+  membuffer = memcache ? NULL : svn_cache__get_global_membuffer_cache();
+
   /* Make the cache for revision roots.  For the vast majority of
    * commands, this is only going to contain a few entries (svnadmin
    * dump/verify is an exception here), so to reduce overhead let's
@@ -215,12 +251,21 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   if (memcache)
     SVN_ERR(svn_cache__create_memcache(&(ffd->rev_root_id_cache),
                                        memcache,
-                                       serialize_id,
-                                       deserialize_id,
+                                       svn_fs_fs__serialize_id,
+                                       svn_fs_fs__deserialize_id,
                                        sizeof(svn_revnum_t),
                                        apr_pstrcat(pool, prefix, "RRI",
                                                    NULL),
                                        fs->pool));
+  else if (membuffer)
+    SVN_ERR(svn_cache__create_membuffer_cache(&(ffd->rev_root_id_cache),
+                                              membuffer,
+                                              svn_fs_fs__serialize_id,
+                                              svn_fs_fs__deserialize_id,
+                                              sizeof(svn_revnum_t),
+                                              apr_pstrcat(pool, prefix, "RRI",
+                                                          NULL),
+                                              fs->pool));
   else
     SVN_ERR(svn_cache__create_inprocess(&(ffd->rev_root_id_cache),
                                         dup_id, sizeof(svn_revnum_t),
@@ -241,6 +286,15 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                                        apr_pstrcat(pool, prefix, "DAG",
                                                    NULL),
                                        fs->pool));
+  else if (membuffer)
+    SVN_ERR(svn_cache__create_membuffer_cache(&(ffd->rev_node_cache),
+                                              membuffer,
+                                              svn_fs_fs__dag_serialize,
+                                              svn_fs_fs__dag_deserialize,
+                                              APR_HASH_KEY_STRING,
+                                              apr_pstrcat(pool, prefix, "DAG",
+                                                          NULL),
+                                              fs->pool));
   else
     SVN_ERR(svn_cache__create_inprocess(&(ffd->rev_node_cache),
                                         svn_fs_fs__dag_dup_for_cache,
@@ -255,12 +309,21 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   if (memcache)
     SVN_ERR(svn_cache__create_memcache(&(ffd->dir_cache),
                                        memcache,
-                                       svn_fs_fs__dir_entries_serialize,
-                                       svn_fs_fs__dir_entries_deserialize,
+                                       svn_fs_fs__serialize_dir_entries,
+                                       svn_fs_fs__deserialize_dir_entries,
                                        APR_HASH_KEY_STRING,
                                        apr_pstrcat(pool, prefix, "DIR",
                                                    NULL),
                                        fs->pool));
+  else if (membuffer)
+    SVN_ERR(svn_cache__create_membuffer_cache(&(ffd->dir_cache),
+                                              membuffer,
+                                              svn_fs_fs__serialize_dir_entries,
+                                              svn_fs_fs__deserialize_dir_entries,
+                                              APR_HASH_KEY_STRING,
+                                              apr_pstrcat(pool, prefix, "DIR",
+                                                          NULL),
+                                              fs->pool));
   else
     SVN_ERR(svn_cache__create_inprocess(&(ffd->dir_cache),
                                         dup_dir_listing, APR_HASH_KEY_STRING,
@@ -270,6 +333,94 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
     SVN_ERR(svn_cache__set_error_handler(ffd->dir_cache,
                                          warn_on_cache_errors, fs, pool));
 
+  /* Large binary directories are only looked up in place, which the
+   * in-process cache can't do.  Without a shared cache, they get parsed
+   * into DIR_CACHE like all others. */
+  if (memcache)
+    SVN_ERR(svn_cache__create_memcache(&(ffd->binary_dir_cache),
+                                       memcache,
+                                       /* Values are svn_stringbuf_t */
+                                       NULL, NULL,
+                                       APR_HASH_KEY_STRING,
+                                       apr_pstrcat(pool, prefix, "BINDIR",
+                                                   NULL),
+                                       fs->pool));
+  else if (membuffer)
+    SVN_ERR(svn_cache__create_membuffer_cache(&(ffd->binary_dir_cache),
+                                              membuffer,
+                                              /* Values are svn_stringbuf_t */
+                                              NULL, NULL,
+                                              APR_HASH_KEY_STRING,
+                                              apr_pstrcat(pool, prefix,
+                                                          "BINDIR", NULL),
+                                              fs->pool));
+  else
+    ffd->binary_dir_cache = NULL;
+
+  if (ffd->binary_dir_cache && ! no_handler)
+    SVN_ERR(svn_cache__set_error_handler(ffd->binary_dir_cache,
+                                         warn_on_cache_errors, fs, pool));
+
+  /* Node-revisions of committed revisions, indexed by revision and
+   * offset.  About 300 bytes each. */
+  if (memcache)
+    SVN_ERR(svn_cache__create_memcache(&(ffd->node_revision_cache),
+                                       memcache,
+                                       svn_fs_fs__serialize_node_revision,
+                                       svn_fs_fs__deserialize_node_revision,
+                                       sizeof(pair_cache_key_t),
+                                       apr_pstrcat(pool, prefix, "NODEREVS",
+                                                   NULL),
+                                       fs->pool));
+  else if (membuffer)
+    SVN_ERR(svn_cache__create_membuffer_cache(&(ffd->node_revision_cache),
+                                              membuffer,
+                                              svn_fs_fs__serialize_node_revision,
+                                              svn_fs_fs__deserialize_node_revision,
+                                              sizeof(pair_cache_key_t),
+                                              apr_pstrcat(pool, prefix,
+                                                          "NODEREVS", NULL),
+                                              fs->pool));
+  else
+    SVN_ERR(svn_cache__create_inprocess(&(ffd->node_revision_cache),
+                                        dup_node_revision,
+                                        sizeof(pair_cache_key_t),
+                                        1024, 16, FALSE, fs->pool));
+
+  if (! no_handler)
+    SVN_ERR(svn_cache__set_error_handler(ffd->node_revision_cache,
+                                         warn_on_cache_errors, fs, pool));
+
+  /* Parsed representation headers; these are small, fixed-size
+   * structures of less than 64 bytes. */
+  if (memcache)
+    SVN_ERR(svn_cache__create_memcache(&(ffd->rep_header_cache),
+                                       memcache,
+                                       rep_header_serialize,
+                                       rep_header_deserialize,
+                                       sizeof(pair_cache_key_t),
+                                       apr_pstrcat(pool, prefix, "REPHEADER",
+                                                   NULL),
+                                       fs->pool));
+  else if (membuffer)
+    SVN_ERR(svn_cache__create_membuffer_cache(&(ffd->rep_header_cache),
+                                              membuffer,
+                                              rep_header_serialize,
+                                              rep_header_deserialize,
+                                              sizeof(pair_cache_key_t),
+                                              apr_pstrcat(pool, prefix,
+                                                          "REPHEADER", NULL),
+                                              fs->pool));
+  else
+    SVN_ERR(svn_cache__create_inprocess(&(ffd->rep_header_cache),
+                                        dup_rep_header,
+                                        sizeof(pair_cache_key_t),
+                                        1024, 64, FALSE, fs->pool));
+
+  if (! no_handler)
+    SVN_ERR(svn_cache__set_error_handler(ffd->rep_header_cache,
+                                         warn_on_cache_errors, fs, pool));
+
   /* Only 16 bytes per entry (a revision number + the corresponding offset).
      Since we want ~8k pages, that means 512 entries per page. */
   if (memcache)
@@ -281,6 +432,16 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                                        apr_pstrcat(pool, prefix, "PACK-MANIFEST",
                                                    NULL),
                                        fs->pool));
+  else if (membuffer)
+    SVN_ERR(svn_cache__create_membuffer_cache(&(ffd->packed_offset_cache),
+                                              membuffer,
+                                              manifest_serialize,
+                                              manifest_deserialize,
+                                              sizeof(svn_revnum_t),
+                                              apr_pstrcat(pool, prefix,
+                                                          "PACK-MANIFEST",
+                                                          NULL),
+                                              fs->pool));
   else
     SVN_ERR(svn_cache__create_inprocess(&(ffd->packed_offset_cache),
                                         dup_pack_manifest, sizeof(svn_revnum_t),
@@ -290,6 +451,74 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
     SVN_ERR(svn_cache__set_error_handler(ffd->packed_offset_cache,
                                          warn_on_cache_errors, fs, pool));
 
+  /* Revprops are mostly a log message plus author and date, i.e. a few
+   * hundred bytes.  'svn log' reads them for every revision it shows. */
+  if (memcache)
+    SVN_ERR(svn_cache__create_memcache(&(ffd->revprop_cache),
+                                       memcache,
+                                       svn_fs_fs__serialize_revprops,
+                                       svn_fs_fs__deserialize_revprops,
+                                       sizeof(svn_revnum_t),
+                                       apr_pstrcat(pool, prefix, "REVPROPS",
+                                                   NULL),
+                                       fs->pool));
+  else if (membuffer)
+    SVN_ERR(svn_cache__create_membuffer_cache(&(ffd->revprop_cache),
+                                              membuffer,
+                                              svn_fs_fs__serialize_revprops,
+                                              svn_fs_fs__deserialize_revprops,
+                                              sizeof(svn_revnum_t),
+                                              apr_pstrcat(pool, prefix,
+                                                          "REVPROPS", NULL),
+                                              fs->pool));
+  else
+    SVN_ERR(svn_cache__create_inprocess(&(ffd->revprop_cache),
+                                        dup_revprops, sizeof(svn_revnum_t),
+                                        256, 16, FALSE, fs->pool));
+
+  if (! no_handler)
+    SVN_ERR(svn_cache__set_error_handler(ffd->revprop_cache,
+                                         warn_on_cache_errors, fs, pool));
+
+  /* Decoded txdelta windows can be large and are cheap to re-read from
+   * a local disk, so a round-trip to memcached is unlikely to pay off.
+   * Only keep them in the local membuffer. */
+  if (membuffer)
+    {
+      SVN_ERR(svn_cache__create_membuffer_cache(&(ffd->txdelta_window_cache),
+                                                membuffer,
+                                                svn_fs_fs__serialize_txdelta_window,
+                                                svn_fs_fs__deserialize_txdelta_window,
+                                                sizeof(window_cache_key_t),
+                                                apr_pstrcat(pool, prefix,
+                                                            "TXDELTA_WINDOW",
+                                                            NULL),
+                                                fs->pool));
+      SVN_ERR(svn_cache__create_membuffer_cache(&(ffd->combined_window_cache),
+                                                membuffer,
+                                                svn_fs_fs__serialize_txdelta_window,
+                                                svn_fs_fs__deserialize_txdelta_window,
+                                                sizeof(window_cache_key_t),
+                                                apr_pstrcat(pool, prefix,
+                                                            "COMBINED_WINDOW",
+                                                            NULL),
+                                                fs->pool));
+      if (! no_handler)
+        {
+          SVN_ERR(svn_cache__set_error_handler(ffd->txdelta_window_cache,
+                                               warn_on_cache_errors, fs,
+                                               pool));
+          SVN_ERR(svn_cache__set_error_handler(ffd->combined_window_cache,
+                                               warn_on_cache_errors, fs,
+                                               pool));
+        }
+    }
+  else
+    {
+      ffd->txdelta_window_cache = NULL;
+      ffd->combined_window_cache = NULL;
+    }
+
   if (memcache)
     {
       SVN_ERR(svn_cache__create_memcache(&(ffd->fulltext_cache),
@@ -304,8 +533,76 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
         SVN_ERR(svn_cache__set_error_handler(ffd->fulltext_cache,
                                              warn_on_cache_errors, fs, pool));
     }
+  else if (membuffer && svn_cache__get_global_config()->cache_fulltexts)
+    {
+      SVN_ERR(svn_cache__create_membuffer_cache(&(ffd->fulltext_cache),
+                                                membuffer,
+                                                /* Values are svn_string_t */
+                                                NULL, NULL,
+                                                APR_HASH_KEY_STRING,
+                                                apr_pstrcat(pool, prefix,
+                                                            "TEXT", NULL),
+                                                fs->pool));
+      if (! no_handler)
+        SVN_ERR(svn_cache__set_error_handler(ffd->fulltext_cache,
+                                             warn_on_cache_errors, fs, pool));
+    }
   else
     ffd->fulltext_cache = NULL;
 
   return SVN_NO_ERROR;
 }
+
+
+/* Add the usage statistics of CACHE to INFO under NAME, unless CACHE is
+   NULL.  Allocate the entry in POOL and reset CACHE's counters if RESET
+   is set. */
+static svn_error_t *
+add_cache_info(apr_hash_t *info,
+               const char *name,
+               svn_cache__t *cache,
+               svn_boolean_t reset,
+               apr_pool_t *pool)
+{
+  svn_cache__info_t *cache_info;
+
+  if (cache == NULL)
+    return SVN_NO_ERROR;
+
+  cache_info = apr_palloc(pool, sizeof(*cache_info));
+  SVN_ERR(svn_cache__get_info(cache, cache_info, reset, pool));
+  apr_hash_set(info, name, APR_HASH_KEY_STRING, cache_info);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_cache_info(apr_hash_t **info_p,
+                          svn_fs_t *fs,
+                          svn_boolean_t reset,
+                          apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_hash_t *info = apr_hash_make(pool);
+
+  /* Use the same names as the memcache prefixes. */
+  SVN_ERR(add_cache_info(info, "RRI", ffd->rev_root_id_cache, reset, pool));
+  SVN_ERR(add_cache_info(info, "DAG", ffd->rev_node_cache, reset, pool));
+  SVN_ERR(add_cache_info(info, "DIR", ffd->dir_cache, reset, pool));
+  SVN_ERR(add_cache_info(info, "BINDIR", ffd->binary_dir_cache, reset, pool));
+  SVN_ERR(add_cache_info(info, "NODEREVS", ffd->node_revision_cache,
+                         reset, pool));
+  SVN_ERR(add_cache_info(info, "REPHEADER", ffd->rep_header_cache,
+                         reset, pool));
+  SVN_ERR(add_cache_info(info, "PACK-MANIFEST", ffd->packed_offset_cache,
+                         reset, pool));
+  SVN_ERR(add_cache_info(info, "REVPROPS", ffd->revprop_cache, reset, pool));
+  SVN_ERR(add_cache_info(info, "TXDELTA_WINDOW", ffd->txdelta_window_cache,
+                         reset, pool));
+  SVN_ERR(add_cache_info(info, "COMBINED_WINDOW", ffd->combined_window_cache,
+                         reset, pool));
+  SVN_ERR(add_cache_info(info, "TEXT", ffd->fulltext_cache, reset, pool));
+
+  *info_p = info;
+  return SVN_NO_ERROR;
+}
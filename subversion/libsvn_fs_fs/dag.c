@@ -34,6 +34,7 @@
 #include "key-gen.h"
 #include "fs_fs.h"
 #include "id.h"
+#include "temp_serializer.h"
 
 #include "../libsvn_fs/fs-loader.h"
 
@@ -170,7 +171,7 @@ get_node_revision(node_revision_t **noderev_p,
 
 svn_boolean_t svn_fs_fs__dag_check_mutable(const dag_node_t *node)
 {
-  return (svn_fs_fs__id_txn_id(svn_fs_fs__dag_get_id(node)) != NULL);
+  return svn_fs_fs__id_is_txn(svn_fs_fs__dag_get_id(node));
 }
 
 
@@ -310,16 +311,18 @@ dir_entry_id_from_node(const svn_fs_id_t **id_p,
                        const char *name,
                        apr_pool_t *pool)
 {
-  apr_hash_t *entries;
+  node_revision_t *noderev;
   svn_fs_dirent_t *dirent;
   apr_pool_t *subpool = svn_pool_create(pool);
 
-  SVN_ERR(svn_fs_fs__dag_dir_entries(&entries, parent, subpool, pool));
-  if (entries)
-    dirent = apr_hash_get(entries, name, APR_HASH_KEY_STRING);
-  else
-    dirent = NULL;
+  SVN_ERR(get_node_revision(&noderev, parent, pool));
+  if (noderev->kind != svn_node_dir)
+    return svn_error_create(SVN_ERR_FS_NOT_DIRECTORY, NULL,
+                            _("Can't get entries of non-directory"));
 
+  /* Only fetch the one entry we need; directories may be huge. */
+  SVN_ERR(svn_fs_fs__rep_contents_dir_entry(&dirent, parent->fs, noderev,
+                                            name, subpool));
   *id_p = dirent ? svn_fs_fs__id_copy(dirent->id, pool) : NULL;
 
   svn_pool_destroy(subpool);
@@ -406,7 +409,7 @@ make_entry(dag_node_t **child_p,
 
   SVN_ERR(svn_fs_fs__create_node
           (&new_node_id, svn_fs_fs__dag_get_fs(parent), &new_noderev,
-           svn_fs_fs__id_copy_id(svn_fs_fs__dag_get_id(parent)),
+           svn_fs_fs__id_copy_id(svn_fs_fs__dag_get_id(parent), pool),
            txn_id, pool));
 
   /* Create a new dag_node_t for our new node */
@@ -439,6 +442,25 @@ svn_fs_fs__dag_dir_entries(apr_hash_t **entries,
 }
 
 
+svn_error_t *
+svn_fs_fs__dag_dir_entries_sorted(apr_array_header_t **entries,
+                                  dag_node_t *node,
+                                  apr_pool_t *pool,
+                                  apr_pool_t *node_pool)
+{
+  node_revision_t *noderev;
+
+  SVN_ERR(get_node_revision(&noderev, node, node_pool));
+
+  if (noderev->kind != svn_node_dir)
+    return svn_error_create(SVN_ERR_FS_NOT_DIRECTORY, NULL,
+                            _("Can't get entries of non-directory"));
+
+  return svn_fs_fs__rep_contents_dir_sorted(entries, node->fs, noderev,
+                                            pool);
+}
+
+
 svn_error_t *
 svn_fs_fs__dag_set_entry(dag_node_t *node,
                          const char *entry_name,
@@ -1009,6 +1031,34 @@ svn_fs_fs__dag_get_edit_stream(svn_stream_t **contents,
 }
 
 
+svn_error_t *
+svn_fs_fs__dag_get_delta_edit_handler(svn_txdelta_window_handler_t *handler,
+                                      void **handler_baton,
+                                      dag_node_t *file,
+                                      apr_pool_t *pool)
+{
+  node_revision_t *noderev;
+
+  /* Make sure our node is a file. */
+  if (file->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to set textual contents of a *non*-file node");
+
+  /* Make sure our node is mutable. */
+  if (! svn_fs_fs__dag_check_mutable(file))
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_MUTABLE, NULL,
+       "Attempted to set textual contents of an immutable node");
+
+  /* Get the node revision. */
+  SVN_ERR(get_node_revision(&noderev, file, pool));
+
+  return svn_fs_fs__set_contents_delta(handler, handler_baton, file->fs,
+                                       noderev, pool);
+}
+
+
 
 svn_error_t *
 svn_fs_fs__dag_finalize_edits(dag_node_t *file,
@@ -1076,15 +1126,13 @@ svn_fs_fs__dag_dup_for_cache(void **out,
   return SVN_NO_ERROR;
 }
 
-/* The cache serialization format is:
+/* The cache serialization format is the flat svn_temp_serializer__*
+ * representation of the dag_node_t with all its sub-structures, except
+ * for the FS which will be patched up by the reader.
  *
- * - For mutable nodes: the character 'M', then 'F' for files or 'D'
- *   for directories, then the ID, then '\n', then the created path.
- *
- * - For immutable nodes: the character 'I' followed by the noderev
- *   hash dump (the other fields can be reconstructed from this).  (We
- *   assume that, once constructed, immutable nodes always contain
- *   their noderev.)
+ * The NODE-REVISION of mutable nodes may change at any time.  It will
+ * not be cached and must be re-read on demand.  For immutable nodes, the
+ * noderev gets cached if it has already been read.
  */
 
 svn_error_t *
@@ -1094,104 +1142,60 @@ svn_fs_fs__dag_serialize(char **data,
                          apr_pool_t *pool)
 {
   dag_node_t *node = in;
-  svn_stringbuf_t *buf = svn_stringbuf_create("", pool);
+  svn_stringbuf_t *serialized;
 
-  if (svn_fs_fs__dag_check_mutable(node))
-    {
-      svn_stringbuf_appendcstr(buf, "M");
-      svn_stringbuf_appendcstr(buf, (node->kind == svn_node_file ? "F" : "D"));
-      svn_stringbuf_appendcstr(buf, svn_fs_fs__id_unparse(node->id,
-                                                          pool)->data);
-      svn_stringbuf_appendcstr(buf, "\n");
-      svn_stringbuf_appendcstr(buf, node->created_path);
-    }
+  /* create a serialization context and serialize the dag node as root */
+  svn_temp_serializer__context_t *context =
+      svn_temp_serializer__init(node,
+                                sizeof(*node),
+                                1024,
+                                pool);
+
+  /* for mutable nodes, we will _never_ cache the noderev */
+  if (node->node_revision && !svn_fs_fs__dag_check_mutable(node))
+    svn_fs_fs__noderev_serialize(context, &node->node_revision);
   else
-    {
-      fs_fs_data_t *ffd = node->fs->fsap_data;
-      svn_stringbuf_appendcstr(buf, "I");
-      SVN_ERR(svn_fs_fs__write_noderev(svn_stream_from_stringbuf(buf, pool),
-                                       node->node_revision, ffd->format,
-                                       TRUE, pool));
-    }
+    svn_temp_serializer__set_null(context,
+                                  (const void * const *)&node->node_revision);
+
+  /* the FS is not serializable; the reader will have to provide it */
+  svn_temp_serializer__set_null(context, (const void * const *)&node->fs);
+
+  /* serialize other sub-structures */
+  svn_fs_fs__id_serialize(context, (const svn_fs_id_t * const *)&node->id);
+  svn_fs_fs__id_serialize(context, &node->fresh_root_predecessor_id);
+  svn_temp_serializer__add_string(context, &node->created_path);
+
+  /* return serialized data */
+  serialized = svn_temp_serializer__get(context);
+  *data = serialized->data;
+  *data_len = serialized->len;
 
-  *data = buf->data;
-  *data_len = buf->len;
   return SVN_NO_ERROR;
 }
 
 svn_error_t *
 svn_fs_fs__dag_deserialize(void **out,
-                           const char *data,
+                           char *data,
                            apr_size_t data_len,
                            apr_pool_t *pool)
 {
-  dag_node_t *node = apr_pcalloc(pool, sizeof(*node));
+  dag_node_t *node = (dag_node_t *)data;
 
-  if (data_len == 0)
+  if (data_len < sizeof(*node))
     return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
                             _("Empty noderev in cache"));
 
-  if (*data == 'M')
-    {
-      const char *newline;
-      size_t id_len;
-
-      data++; data_len--;
-      if (data_len == 0)
-        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
-                                _("Kindless noderev in cache"));
-      if (*data == 'F')
-        node->kind = svn_node_file;
-      else if (*data == 'D')
-        node->kind = svn_node_dir;
-      else
-        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                                 _("Unknown kind for noderev in cache: '%c'"),
-                                 *data);
-
-      data++; data_len--;
-      newline = memchr(data, '\n', data_len);
-      if (!newline)
-        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
-                                _("Unterminated ID in cache"));
-      id_len = newline - 1 - data;
-      node->id = svn_fs_fs__id_parse(data, id_len, pool);
-      if (! node->id)
-        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                                 _("Bogus ID '%s' in cache"),
-                                 apr_pstrndup(pool, data, id_len));
-
-      data += id_len; data_len -= id_len;
-      data++; data_len--;
-      if (data_len == 0)
-        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
-                                _("No created path"));
-      node->created_path = apr_pstrndup(pool, data, data_len);
-    }
-  else if (*data == 'I')
-    {
-      node_revision_t *noderev;
-      apr_pool_t *subpool = svn_pool_create(pool);
-      svn_stream_t *stream =
-        svn_stream_from_stringbuf(svn_stringbuf_ncreate(data + 1,
-                                                        data_len - 1,
-                                                        subpool),
-                                  subpool);
-      SVN_ERR(svn_fs_fs__read_noderev(&noderev, stream, pool));
-      node->kind = noderev->kind;
-      node->id = svn_fs_fs__id_copy(noderev->id, pool);
-      node->created_path = apr_pstrdup(pool, noderev->created_path);
-
-      if (noderev->is_fresh_txn_root)
-        node->fresh_root_predecessor_id = noderev->predecessor_id;
-
-      node->node_revision = noderev;
+  /* Correct all pointers in place.  DATA is ours to keep. */
+  svn_fs_fs__id_deserialize(node, &node->id);
+  svn_fs_fs__id_deserialize(node,
+                            (svn_fs_id_t **)&node->fresh_root_predecessor_id);
+  svn_fs_fs__noderev_deserialize(node, &node->node_revision);
+  svn_temp_deserializer__resolve(node, (void **)&node->created_path);
 
-      svn_pool_destroy(subpool);
-    }
-  else
-    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                             _("Unknown node type in cache: '%c'"), *data);
+  if (node->id == NULL)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Bogus ID in cache"));
 
   *out = node;
 
@@ -97,7 +97,7 @@ svn_fs_fs__dag_serialize(char **data,
    Implements svn_cache__deserialize_func_t */
 svn_error_t *
 svn_fs_fs__dag_deserialize(void **out,
-                           const char *data,
+                           char *data,
                            apr_size_t data_len,
                            apr_pool_t *pool);
 
@@ -304,6 +304,13 @@ svn_error_t *svn_fs_fs__dag_dir_entries(apr_hash_t **entries_p,
                                         apr_pool_t *pool,
                                         apr_pool_t *node_pool);
 
+/* Like svn_fs_fs__dag_dir_entries, but set *ENTRIES_P to an array of
+   svn_fs_dirent_t * sorted by entry name. */
+svn_error_t *svn_fs_fs__dag_dir_entries_sorted(apr_array_header_t **entries_p,
+                                               dag_node_t *node,
+                                               apr_pool_t *pool,
+                                               apr_pool_t *node_pool);
+
 
 /* Set ENTRY_NAME in NODE to point to ID (with kind KIND), allocating
    from POOL.  NODE must be a mutable directory.  ID can refer to a
@@ -459,6 +466,24 @@ svn_error_t *svn_fs_fs__dag_get_edit_stream(svn_stream_t **contents,
                                             apr_pool_t *pool);
 
 
+/* Set *HANDLER and *HANDLER_BATON to a window handler that stores the
+   delta windows against the current contents of FILE it receives as
+   they are, as FILE's new contents.  If the filesystem would not store
+   FILE's new contents as a delta against its current contents, set
+   *HANDLER to NULL; use svn_fs_fs__dag_get_edit_stream then.  After
+   the final window, FILE's contents are ready for
+   svn_fs_fs__dag_finalize_edits.
+
+   Use POOL for all allocations, including to cache the node_revision in
+   FILE.
+ */
+svn_error_t *
+svn_fs_fs__dag_get_delta_edit_handler(svn_txdelta_window_handler_t *handler,
+                                      void **handler_baton,
+                                      dag_node_t *file,
+                                      apr_pool_t *pool);
+
+
 /* Signify the completion of edits to FILE made using the stream
    returned by svn_fs_fs__dag_get_edit_stream, allocating from POOL.
 
@@ -0,0 +1,316 @@
+/* date-index.c : the index of revision dates
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <apr_time.h>
+
+#include "svn_private_config.h"
+
+#include "fs.h"
+#include "fs_fs.h"
+#include "date-index.h"
+#include "../libsvn_fs/fs-loader.h"
+
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+#include "svn_time.h"
+
+/* The index is an array of fixed-size entries, one per revision, the
+   entry for revision N starting at offset N * ENTRY_SIZE.  Each entry
+   is the svn:date of its revision in microseconds since the epoch, as a
+   big-endian two's complement number, or NO_DATE if the revision has no
+   svn:date. */
+#define ENTRY_SIZE  8
+#define NO_DATE     APR_INT64_C(0x7fffffffffffffff)
+
+
+/* Encode TM as an index entry into BUF. */
+static void
+encode_entry(unsigned char *buf,
+             apr_time_t tm)
+{
+  apr_uint64_t value = (apr_uint64_t) tm;
+  int i;
+
+  for (i = ENTRY_SIZE - 1; i >= 0; i--)
+    {
+      buf[i] = (unsigned char) (value & 0xff);
+      value >>= 8;
+    }
+}
+
+/* Return the time encoded in the index entry at BUF. */
+static apr_time_t
+decode_entry(const unsigned char *buf)
+{
+  apr_uint64_t value = 0;
+  int i;
+
+  for (i = 0; i < ENTRY_SIZE; i++)
+    value = (value << 8) | buf[i];
+
+  return (apr_time_t) value;
+}
+
+/* Set *COUNT to the number of complete entries in the index FILE. */
+static svn_error_t *
+get_entry_count(svn_revnum_t *count,
+                apr_file_t *file,
+                apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, file, pool));
+  *count = (svn_revnum_t) (finfo.size / ENTRY_SIZE);
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the date index of FS with FLAGS in *FILE, or set *FILE to NULL if
+   there is none.  Allocate *FILE in POOL. */
+static svn_error_t *
+open_index(apr_file_t **file,
+           svn_fs_t *fs,
+           apr_int32_t flags,
+           apr_pool_t *pool)
+{
+  svn_error_t *err;
+
+  err = svn_io_file_open(file, svn_dirent_join(fs->path, DATE_INDEX_NAME,
+                                               pool),
+                         flags, APR_OS_DEFAULT, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_return(err);
+}
+
+svn_error_t *
+svn_fs_fs__create_date_index(svn_fs_t *fs,
+                             apr_pool_t *pool)
+{
+  return svn_io_file_create(svn_dirent_join(fs->path, DATE_INDEX_NAME, pool),
+                            "", pool);
+}
+
+svn_error_t *
+svn_fs_fs__update_date_index(svn_fs_t *fs,
+                             svn_revnum_t youngest,
+                             apr_pool_t *pool)
+{
+  apr_file_t *file;
+  svn_revnum_t count, rev;
+  apr_off_t offset;
+  unsigned char *entries;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(open_index(&file, fs, APR_READ | APR_WRITE, pool));
+  if (! file)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_entry_count(&count, file, pool));
+  if (count > youngest + 1)
+    count = youngest + 1;
+
+  /* Write all missing entries at once, overwriting any partial entry a
+     previous update may have left behind, and drop everything else. */
+  entries = apr_palloc(pool, (youngest + 1 - count) * ENTRY_SIZE + 1);
+  iterpool = svn_pool_create(pool);
+  for (rev = count; rev <= youngest; rev++)
+    {
+      svn_string_t *date;
+      apr_time_t tm = NO_DATE;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__revision_prop(&date, fs, rev,
+                                       SVN_PROP_REVISION_DATE, iterpool));
+      if (date)
+        SVN_ERR(svn_time_from_cstring(&tm, date->data, iterpool));
+
+      encode_entry(entries + (rev - count) * ENTRY_SIZE, tm);
+    }
+  svn_pool_destroy(iterpool);
+
+  offset = (apr_off_t) count * ENTRY_SIZE;
+  SVN_ERR(svn_io_file_trunc(file, offset, pool));
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+  SVN_ERR(svn_io_file_write_full(file, entries,
+                                 (youngest + 1 - count) * ENTRY_SIZE,
+                                 NULL, pool));
+
+  return svn_io_file_close(file, pool);
+}
+
+svn_error_t *
+svn_fs_fs__reset_date_index(svn_fs_t *fs,
+                            svn_revnum_t rev,
+                            apr_pool_t *pool)
+{
+  apr_file_t *file;
+  svn_revnum_t count;
+
+  SVN_ERR(open_index(&file, fs, APR_READ | APR_WRITE, pool));
+  if (! file)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_entry_count(&count, file, pool));
+  if (count > rev)
+    SVN_ERR(svn_io_file_trunc(file, (apr_off_t) rev * ENTRY_SIZE, pool));
+
+  return svn_io_file_close(file, pool);
+}
+
+/* Set *TM to the date of revision REV in the index FILE.  If REV has
+   no svn:date, set *NO_DATE_P to TRUE.  Use POOL for temporary
+   allocations. */
+static svn_error_t *
+read_entry(apr_time_t *tm,
+           svn_boolean_t *no_date_p,
+           apr_file_t *file,
+           svn_revnum_t rev,
+           apr_pool_t *pool)
+{
+  unsigned char buf[ENTRY_SIZE];
+  apr_off_t offset = (apr_off_t) rev * ENTRY_SIZE;
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+  SVN_ERR(svn_io_file_read_full(file, buf, sizeof(buf), NULL, pool));
+
+  *tm = decode_entry(buf);
+  if (*tm == NO_DATE)
+    *no_date_p = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__dated_revision(svn_boolean_t *indexed,
+                          svn_revnum_t *revision,
+                          svn_fs_t *fs,
+                          apr_time_t tm,
+                          apr_pool_t *pool)
+{
+  apr_file_t *file;
+  svn_revnum_t count, rev_mid, rev_top, rev_bot, rev_latest;
+  svn_revnum_t result = SVN_INVALID_REVNUM;
+  svn_boolean_t no_date = FALSE;
+  apr_time_t this_time;
+
+  *indexed = FALSE;
+
+  SVN_ERR(open_index(&file, fs, APR_READ, pool));
+  if (! file)
+    return SVN_NO_ERROR;
+
+  /* The index may lag behind the youngest revision, or, after a hotcopy,
+     run ahead of it. */
+  SVN_ERR(svn_fs_fs__youngest_rev(&rev_latest, fs, pool));
+  SVN_ERR(get_entry_count(&count, file, pool));
+  if (count <= rev_latest)
+    return svn_io_file_close(file, pool);
+
+  /* The same binary search as in svn_repos_dated_revision(), so the
+     answers agree even where svn:date is not monotonic. */
+  rev_bot = 0;
+  rev_top = rev_latest;
+
+  while (rev_bot <= rev_top && ! no_date)
+    {
+      rev_mid = (rev_top + rev_bot) / 2;
+      SVN_ERR(read_entry(&this_time, &no_date, file, rev_mid, pool));
+      if (no_date)
+        break;
+
+      if (this_time > tm) /* we've overshot */
+        {
+          apr_time_t previous_time;
+
+          if ((rev_mid - 1) < 0)
+            {
+              result = 0;
+              break;
+            }
+
+          /* see if time falls between rev_mid and rev_mid-1: */
+          SVN_ERR(read_entry(&previous_time, &no_date, file, rev_mid - 1,
+                             pool));
+          if (no_date)
+            break;
+          if (previous_time <= tm)
+            {
+              result = rev_mid - 1;
+              break;
+            }
+
+          rev_top = rev_mid - 1;
+        }
+
+      else if (this_time < tm) /* we've undershot */
+        {
+          apr_time_t next_time;
+
+          if ((rev_mid + 1) > rev_latest)
+            {
+              result = rev_latest;
+              break;
+            }
+
+          /* see if time falls between rev_mid and rev_mid+1: */
+          SVN_ERR(read_entry(&next_time, &no_date, file, rev_mid + 1,
+                             pool));
+          if (no_date)
+            break;
+          if (next_time > tm)
+            {
+              result = rev_mid;
+              break;
+            }
+
+          rev_bot = rev_mid + 1;
+        }
+
+      else
+        {
+          result = rev_mid;  /* exact match! */
+          break;
+        }
+    }
+
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Like the original search, leave *REVISION alone if nothing matched,
+     but let revisions without svn:date be reported by the caller. */
+  if (! no_date)
+    {
+      *indexed = TRUE;
+      if (SVN_IS_VALID_REVNUM(result))
+        *revision = result;
+    }
+
+  return SVN_NO_ERROR;
+}
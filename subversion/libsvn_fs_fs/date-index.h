@@ -0,0 +1,84 @@
+/* date-index.h : interface to the index of revision dates
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_DATE_INDEX_H
+#define SVN_LIBSVN_FS_FS_DATE_INDEX_H
+
+#include <apr_time.h>
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+#define DATE_INDEX_NAME  "rev-dates"
+
+/* Create an empty date index for FS, replacing any existing one.  Use
+   POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__create_date_index(svn_fs_t *fs,
+                             apr_pool_t *pool);
+
+/* Add the svn:date of all revisions of FS up to and including YOUNGEST
+   which are not in the date index yet.  Revisions younger than YOUNGEST
+   get dropped from the index.  This is a no-op if FS has no date index.
+   The caller must hold the FS write lock.  Use POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__update_date_index(svn_fs_t *fs,
+                             svn_revnum_t youngest,
+                             apr_pool_t *pool);
+
+/* Drop revision REV and all younger revisions of FS from the date index.
+   They will be indexed again by the next svn_fs_fs__update_date_index()
+   call.  The caller must hold the FS write lock.  Use POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__reset_date_index(svn_fs_t *fs,
+                            svn_revnum_t rev,
+                            apr_pool_t *pool);
+
+/* Set *REVISION to the youngest revision of FS at time TM, searching
+   the date index the way svn_repos_dated_revision() searches the
+   svn:date revision properties.  If the index cannot answer that, e.g.
+   because there is no index, it does not cover the youngest revision
+   or a revision without svn:date got in the way, set *INDEXED to FALSE
+   and leave *REVISION alone, else set it to TRUE.  Use POOL for
+   temporary allocations.
+
+   This implements the fs_vtable_t.dated_revision() API. */
+svn_error_t *
+svn_fs_fs__dated_revision(svn_boolean_t *indexed,
+                          svn_revnum_t *revision,
+                          svn_fs_t *fs,
+                          apr_time_t tm,
+                          apr_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_DATE_INDEX_H */
@@ -39,6 +39,8 @@
 #include "tree.h"
 #include "lock.h"
 #include "id.h"
+#include "log-index.h"
+#include "date-index.h"
 #include "svn_private_config.h"
 #include "private/svn_fs_util.h"
 
@@ -85,6 +87,7 @@ fs_serialized_init(svn_fs_t *fs, apr_pool_t *common_pool, apr_pool_t *pool)
     {
       ffsd = apr_pcalloc(common_pool, sizeof(*ffsd));
       ffsd->common_pool = common_pool;
+      ffsd->current_youngest = SVN_INVALID_REVNUM;
 
 #if SVN_FS_FS__USE_LOCK_MUTEX
       /* POSIX fcntl locks are per-process, so we need a mutex for
@@ -102,6 +105,13 @@ fs_serialized_init(svn_fs_t *fs, apr_pool_t *common_pool, apr_pool_t *pool)
       if (status)
         return svn_error_wrap_apr(status,
                                   _("Can't create FSFS txn-current mutex"));
+
+      /* ... and the pack lock. */
+      status = apr_thread_mutex_create(&ffsd->fs_pack_lock,
+                                       APR_THREAD_MUTEX_DEFAULT, common_pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create FSFS pack-lock mutex"));
 #endif
 #if APR_HAS_THREADS
       /* We also need a mutex for synchronising access to the active
@@ -160,7 +170,12 @@ static fs_vtable_t fs_vtable = {
   svn_fs_fs__unlock,
   svn_fs_fs__get_lock,
   svn_fs_fs__get_locks,
-  fs_set_errcall
+  fs_set_errcall,
+  svn_fs_fs__get_cache_info,
+  svn_fs_fs__log_index_prev,
+  svn_fs_fs__dated_revision,
+  svn_fs_fs__lock_many,
+  svn_fs_fs__unlock_many
 };
 
 
@@ -259,6 +274,7 @@ fs_upgrade(svn_fs_t *fs, const char *path, apr_pool_t *pool,
 static svn_error_t *
 fs_pack(svn_fs_t *fs,
         const char *path,
+        int jobs,
         svn_fs_pack_notify_t notify_func,
         void *notify_baton,
         svn_cancel_func_t cancel_func,
@@ -270,7 +286,7 @@ fs_pack(svn_fs_t *fs,
   SVN_ERR(svn_fs_fs__open(fs, path, pool));
   SVN_ERR(svn_fs_fs__initialize_caches(fs, pool));
   SVN_ERR(fs_serialized_init(fs, pool, pool));
-  return svn_fs_fs__pack(fs, notify_func, notify_baton,
+  return svn_fs_fs__pack(fs, jobs, notify_func, notify_baton,
                          cancel_func, cancel_baton, pool);
 }
 
@@ -280,14 +296,21 @@ fs_pack(svn_fs_t *fs,
 /* This implements the fs_library_vtable_t.hotcopy() API.  Copy a
    possibly live Subversion filesystem from SRC_PATH to DEST_PATH.
    The CLEAN_LOGS argument is ignored and included for Subversion
-   1.0.x compatibility.  Perform all temporary allocations in POOL. */
+   1.0.x compatibility.  If INCREMENTAL is TRUE, copy only what changed
+   since an earlier hotcopy to DEST_PATH.  Use optional CANCEL_FUNC and
+   CANCEL_BATON for cancellation support.  Perform all temporary
+   allocations in POOL. */
 static svn_error_t *
 fs_hotcopy(const char *src_path,
            const char *dest_path,
            svn_boolean_t clean_logs,
+           svn_boolean_t incremental,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
            apr_pool_t *pool)
 {
-  return svn_fs_fs__hotcopy(src_path, dest_path, pool);
+  return svn_fs_fs__hotcopy(src_path, dest_path, incremental,
+                            cancel_func, cancel_baton, pool);
 }
 
 
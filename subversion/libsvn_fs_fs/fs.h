@@ -49,6 +49,8 @@ extern "C" {
 #define PATH_FORMAT           "format"           /* Contains format number */
 #define PATH_UUID             "uuid"             /* Contains UUID */
 #define PATH_CURRENT          "current"          /* Youngest revision */
+#define PATH_RECOVERY_IDS     "recovery-ids"     /* Checkpoint of 'current'
+                                                    for recovery */
 #define PATH_LOCK_FILE        "write-lock"       /* Revision lock file */
 #define PATH_REVS_DIR         "revs"             /* Directory of revisions */
 #define PATH_REVPROPS_DIR     "revprops"         /* Directory of revprops */
@@ -57,6 +59,7 @@ extern "C" {
 #define PATH_TXN_PROTOS_DIR   "txn-protorevs"    /* Directory of proto-revs */
 #define PATH_TXN_CURRENT      "txn-current"      /* File with next txn key */
 #define PATH_TXN_CURRENT_LOCK "txn-current-lock" /* Lock for txn-current */
+#define PATH_PACK_LOCK        "pack-lock"        /* Lock for packing */
 #define PATH_LOCKS_DIR        "locks"            /* Directory of locks */
 #define PATH_MIN_UNPACKED_REV "min-unpacked-rev" /* Oldest revision which
                                                     has not been packed. */
@@ -67,10 +70,23 @@ extern "C" {
 /* If you change this, look at tests/svn_test_fs.c(maybe_install_fsfs_conf) */
 #define PATH_CONFIG           "fsfs.conf"        /* Configuration */
 
+/* Names of files within a packed shard directory */
+#define PATH_PACKED_MANIFEST_INDEX "manifest.idx" /* Binary rev offsets */
+
+#define PATH_PACKED_CHANGES_INDEX "changes.idx"  /* Binary changed-paths
+                                                  ranges */
+
+/* Size of a single, big-endian entry in PATH_PACKED_MANIFEST_INDEX.
+   Entries in PATH_PACKED_CHANGES_INDEX consist of two such values: the
+   start of a revision's changed-paths section and the end of that
+   revision, both as offsets within the pack file. */
+#define MANIFEST_INDEX_ENTRY_SIZE 8
+
 /* Names of special files and file extensions for transactions */
 #define PATH_CHANGES       "changes"       /* Records changes made so far */
 #define PATH_TXN_PROPS     "props"         /* Transaction properties */
 #define PATH_NEXT_IDS      "next-ids"      /* Next temporary ID assignments */
+#define PATH_TXN_NODE_LOG  "node-log"      /* Log of new node-revs, if used */
 #define PATH_PREFIX_NODE   "node."         /* Prefix for node filename */
 #define PATH_EXT_TXN       ".txn"          /* Extension of txn dir */
 #define PATH_EXT_CHILDREN  ".children"     /* Extension for dir contents */
@@ -86,11 +102,23 @@ extern "C" {
 #define CONFIG_OPTION_FAIL_STOP          "fail-stop"
 #define CONFIG_SECTION_REP_SHARING       "rep-sharing"
 #define CONFIG_OPTION_ENABLE_REP_SHARING "enable-rep-sharing"
+#define CONFIG_OPTION_BATCH_REVISIONS    "batch-revisions"
+#define CONFIG_OPTION_ENABLE_BLOOM_FILTER "enable-bloom-filter"
+#define CONFIG_SECTION_IO                "io"
+#define CONFIG_OPTION_ENABLE_MMAP        "enable-mmap"
+#define CONFIG_OPTION_PREFETCH_DELTA_CHAINS "prefetch-delta-chains"
+#define CONFIG_SECTION_DELTIFICATION     "deltification"
+#define CONFIG_OPTION_MAX_DELTIFICATION_WALK "max-deltification-walk"
+#define CONFIG_OPTION_DELTA_WINDOW_SIZE  "delta-window-size"
+#define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
+#define CONFIG_SECTION_COMMITS           "commits"
+#define CONFIG_OPTION_PREPARE_OUTSIDE_LOCK "prepare-outside-lock"
+#define CONFIG_OPTION_TXN_NODE_LOG        "txn-node-log"
 
 /* The format number of this filesystem.
    This is independent of the repository format number, and
    independent of any other FS back ends. */
-#define SVN_FS_FS__FORMAT_NUMBER   5
+#define SVN_FS_FS__FORMAT_NUMBER   7
 
 /* The minimum format number that supports svndiff version 1.  */
 #define SVN_FS_FS__MIN_SVNDIFF1_FORMAT 2
@@ -125,6 +153,14 @@ extern "C" {
 /* The minimum format number that supports packed revprop shards. */
 #define SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT 5
 
+/* The minimum format number that stores directories in the sorted,
+   binary format. */
+#define SVN_FS_FS__MIN_BINARY_DIR_FORMAT 6
+
+/* The minimum format number that keeps locks in an SQLite database
+   rather than in digest files. */
+#define SVN_FS_FS__MIN_LOCKS_DB_FORMAT 7
+
 /* Private FSFS-specific data shared between all svn_txn_t objects that
    relate to a particular transaction in a filesystem (as identified
    by transaction id and filesystem UUID).  Objects of this type are
@@ -192,8 +228,33 @@ typedef struct
   /* A lock for intra-process synchronization when locking the
      txn-current file. */
   apr_thread_mutex_t *txn_current_lock;
+
+  /* A lock for intra-process synchronization when grabbing the
+     repository pack lock. */
+  apr_thread_mutex_t *fs_pack_lock;
 #endif
 
+  /* The youngest revision as last read from the 'current' file by any
+     svn_fs_t object in this process, together with the inode, device,
+     size and mtime that 'current' had before it was read.  A reader
+     that finds 'current' unchanged may use YOUNGEST without opening the
+     file.  CURRENT_SEQUENCE is odd while these members are being
+     updated and is incremented again afterwards, so readers need no
+     lock but must retry if the sequence changed under them.  It must
+     only be accessed through svn_atomic_cas. */
+  volatile svn_atomic_t current_sequence;
+  svn_revnum_t current_youngest;
+  apr_ino_t current_inode;
+  apr_dev_t current_device;
+  apr_off_t current_size;
+  apr_time_t current_mtime;
+
+  /* Incremented whenever an svn_fs_t object in this process changes a
+     revision property.  Cached revprops read before that are stale.
+     It must only be accessed through svn_atomic_read and
+     svn_atomic_inc. */
+  volatile svn_atomic_t revprop_generation;
+
   /* The common pool, under which this object is allocated, subpools
      of which are used to allocate the transaction objects. */
   apr_pool_t *common_pool;
@@ -232,6 +293,27 @@ typedef struct
      unparsed FS ID to ###x. */
   svn_cache__t *dir_cache;
 
+  /* A cache of the expanded representations of large immutable
+     directories in binary format, searched in place for single entries;
+     maps from unparsed FS ID to the representation's contents.  NULL if
+     not enabled. */
+  svn_cache__t *binary_dir_cache;
+
+  /* A cache of parsed node-revisions of immutable nodes; maps from
+     (pair_cache_key_t *) to (node_revision_t *). */
+  svn_cache__t *node_revision_cache;
+
+  /* A cache of parsed representation headers; maps from
+     (pair_cache_key_t *) to (struct rep_args *). */
+  svn_cache__t *rep_header_cache;
+
+  /* Caches of decoded txdelta windows (of a single representation) and
+     of windows combined along a delta chain.  Both map from
+     (window_cache_key_t *) to (svn_fs_fs__txdelta_cached_window_t *).
+     NULL if not enabled. */
+  svn_cache__t *txdelta_window_cache;
+  svn_cache__t *combined_window_cache;
+
   /* Fulltext cache; currently only used with memcached.  Maps from
      rep key to svn_string_t. */
   svn_cache__t *fulltext_cache;
@@ -240,6 +322,11 @@ typedef struct
      pack files. */
   svn_cache__t *packed_offset_cache;
 
+  /* Revision property cache; maps revision numbers to
+     (svn_fs_fs__cached_revprops_t *).  Revprops are mutable, so entries
+     must be validated before use; see revision_proplist(). */
+  svn_cache__t *revprop_cache;
+
   /* Data shared between all svn_fs_t objects for a given filesystem. */
   fs_fs_shared_data_t *shared;
 
@@ -249,6 +336,69 @@ typedef struct
   /* Thread-safe boolean */
   svn_atomic_t rep_cache_db_opened;
 
+  /* Recent rep-cache lookup results, mapping SHA1 hex digests to
+     representation_t * or, for keys not found, to a marker value.
+     Allocated in REP_LOOKUP_POOL together with its contents. */
+  apr_hash_t *rep_lookup_cache;
+  apr_pool_t *rep_lookup_pool;
+
+  /* Representations queued for insertion into the rep-cache, mapping
+     SHA1 hex digests to representation_t *.  Allocated in
+     REP_BATCH_POOL together with its contents. */
+  apr_hash_t *rep_batch;
+  apr_pool_t *rep_batch_pool;
+
+  /* The number of revisions whose reps are in REP_BATCH, and the number
+     of revisions after which REP_BATCH gets written to the database. */
+  int rep_batch_revisions;
+  int rep_batch_max_revisions;
+
+  /* The maximum number of reps in the delta chain of a new file rep, or
+     -1 if there is no limit.  Longer chains get cut by writing the rep
+     as a delta against the empty stream instead. */
+  int max_deltification_walk;
+
+  /* The number of bytes covered by each delta window of new file reps. */
+  apr_size_t delta_window_size;
+
+  /* The zlib compression level for the svndiff data of new file reps. */
+  int compression_level;
+
+  /* Whether to use a Bloom filter over the rep-cache keys, and the
+     filter itself.  The latter is NULL if not enabled or unavailable. */
+  svn_boolean_t rep_bloom_enabled;
+  struct rep_bloom_t *rep_bloom;
+
+  /* The index of paths with mergeinfo, or NULL if FS has none. */
+  svn_sqlite__db_t *mergeinfo_index_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t mergeinfo_index_opened;
+
+  /* The index of changed subtrees, or NULL if FS has none. */
+  svn_sqlite__db_t *log_index_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t log_index_opened;
+
+  /* The node origins store, or NULL if it is not available. */
+  svn_sqlite__db_t *node_origins_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t node_origins_db_opened;
+
+  /* Node origins not written to NODE_ORIGINS_DB yet, mapping node IDs to
+     unparsed node-rev IDs (svn_string_t *).  Allocated in
+     NODE_ORIGINS_BATCH_POOL together with its contents. */
+  apr_hash_t *node_origins_batch;
+  apr_pool_t *node_origins_batch_pool;
+
+  /* The lock store of formats with SVN_FS_FS__MIN_LOCKS_DB_FORMAT. */
+  svn_sqlite__db_t *locks_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t locks_db_opened;
+
    /* The sqlite database used for revprops. */
    svn_sqlite__db_t *revprop_db;
 
@@ -261,6 +411,31 @@ typedef struct
   /* Whether rep-sharing is supported by the filesystem
    * and allowed by the configuration. */
   svn_boolean_t rep_sharing_allowed;
+
+  /* Whether pack files and manifests shall be read through memory
+   * mappings rather than file I/O. */
+  svn_boolean_t use_mmap;
+
+  /* Whether the byte ranges of a delta chain shall be announced to the
+   * OS before the chain gets read. */
+  svn_boolean_t prefetch_delta_chains;
+
+  /* Whether commits shall write the new revision's contents before
+   * acquiring the write lock. */
+  svn_boolean_t prepare_commits;
+
+  /* Whether new transactions shall keep their node-revs in a single
+   * append-only log instead of individual files. */
+  svn_boolean_t use_txn_node_log;
+
+  /* Indexes of transaction node logs, mapping the transaction directory
+   * (const char *) to the index.  See txn-log.c.  NULL until first used. */
+  apr_hash_t *txn_logs;
+
+  /* Memory mappings of pack files, mapping the shard number (apr_int64_t)
+   * to an apr_mmap_t.  Pack files are immutable, so the mappings live as
+   * long as FS->pool does.  NULL until the first pack file is mapped. */
+  apr_hash_t *pack_mmaps;
 } fs_fs_data_t;
 
 
@@ -285,6 +460,34 @@ typedef struct
 } transaction_t;
 
 
+/*** Cache keys ***/
+/* Identifies an item within a revision, e.g. a node-rev or a rep header
+ * by its offset.  Both members are 64 bits wide, so there is no padding
+ * and the struct can be used as a fixed-size cache key as it is. */
+typedef struct pair_cache_key_t
+{
+  /* The revision the item belongs to. */
+  apr_int64_t revision;
+
+  /* The offset of the item within the revision. */
+  apr_int64_t second;
+} pair_cache_key_t;
+
+
+/* Identifies a txdelta window by the representation it belongs to and
+ * its index within that representation.  Padding-free, like
+ * pair_cache_key_t. */
+typedef struct window_cache_key_t
+{
+  /* Revision and offset of the representation. */
+  apr_int64_t revision;
+  apr_int64_t offset;
+
+  /* The number of the window within the representation. */
+  apr_int64_t chunk_index;
+} window_cache_key_t;
+
+
 /*** Representation ***/
 /* If you add fields to this, check to see if you need to change
  * svn_fs_fs__rep_copy. */
@@ -360,6 +563,12 @@ typedef struct
      -1 if not known (for backward compatibility). */
   int predecessor_count;
 
+  /* ID of the ancestor whose predecessor count equals PREDECESSOR_COUNT
+     with its rightmost '1' bit cleared, or NULL if that ancestor is the
+     predecessor itself or has not been determined.  Following these
+     links reaches any ancestor in a logarithmic number of steps. */
+  const svn_fs_id_t *predecessor_skip_id;
+
   /* representation key for this node's properties.  may be NULL if
      there are no properties.  */
   representation_t *prop_rep;
@@ -384,6 +593,26 @@ typedef struct
 } node_revision_t;
 
 
+/*** Representation header ***/
+/* This structure is used to hold the information associated with a
+   REP line. */
+struct rep_args
+{
+  svn_boolean_t is_delta;
+  svn_boolean_t is_delta_vs_empty;
+
+  svn_revnum_t base_revision;
+  apr_off_t base_offset;
+  apr_size_t base_length;
+
+  /* Length of the REP line including the terminating newline. */
+  apr_size_t header_size;
+
+  /* For deltas, the svndiff version that follows the REP line. */
+  int svndiff_version;
+};
+
+
 /*** Change ***/
 typedef struct
 {
@@ -36,6 +36,11 @@
 #include <apr_sha1.h>
 #include <apr_strings.h>
 #include <apr_thread_mutex.h>
+#include <apr_mmap.h>
+
+#ifdef HAVE_POSIX_FADVISE
+#include <fcntl.h>
+#endif
 
 #include "svn_pools.h"
 #include "svn_fs.h"
@@ -56,13 +61,22 @@
 #include "fs_fs.h"
 #include "id.h"
 #include "rep-cache.h"
+#include "mergeinfo-index.h"
+#include "log-index.h"
+#include "date-index.h"
+#include "node-origins.h"
+#include "txn-log.h"
+#include "temp_serializer.h"
 
 #include "revprops-db.h"
 
 #include "private/svn_fs_util.h"
+#include "private/svn_delta_private.h"
+#include "private/svn_workers.h"
 #include "../libsvn_fs/fs-loader.h"
 
 #include "svn_private_config.h"
+#include "private/svn_trace.h"
 
 /* An arbitrary maximum path length, so clients can't run us out of memory
  * by giving us arbitrarily large paths. */
@@ -88,6 +102,7 @@
 #define HEADER_TEXT        "text"
 #define HEADER_CPATH       "cpath"
 #define HEADER_PRED        "pred"
+#define HEADER_PREDSKIP    "pred-skip"
 #define HEADER_COPYFROM    "copyfrom"
 #define HEADER_COPYROOT    "copyroot"
 #define HEADER_FRESHTXNRT  "is-fresh-txn-root"
@@ -150,6 +165,12 @@ read_min_unpacked_rev(svn_revnum_t *min_unpacked_rev,
 static svn_error_t *
 update_min_unpacked_rev(svn_fs_t *fs, apr_pool_t *pool);
 
+static svn_error_t *
+move_into_place(const char *old_filename,
+                const char *new_filename,
+                const char *perms_reference,
+                apr_pool_t *pool);
+
 /* Pathname helper functions */
 
 /* Return TRUE is REV is packed in FS, FALSE otherwise. */
@@ -197,6 +218,12 @@ path_lock(svn_fs_t *fs, apr_pool_t *pool)
   return svn_dirent_join(fs->path, PATH_LOCK_FILE, pool);
 }
 
+static APR_INLINE const char *
+path_pack_lock(svn_fs_t *fs, apr_pool_t *pool)
+{
+  return svn_dirent_join(fs->path, PATH_PACK_LOCK, pool);
+}
+
 static const char *
 path_rev_packed(svn_fs_t *fs, svn_revnum_t rev, const char *kind,
                 apr_pool_t *pool)
@@ -382,9 +409,9 @@ path_txn_proto_rev_lock(svn_fs_t *fs, const char *txn_id, apr_pool_t *pool)
 static const char *
 path_txn_node_rev(svn_fs_t *fs, const svn_fs_id_t *id, apr_pool_t *pool)
 {
-  const char *txn_id = svn_fs_fs__id_txn_id(id);
-  const char *node_id = svn_fs_fs__id_node_id(id);
-  const char *copy_id = svn_fs_fs__id_copy_id(id);
+  const char *txn_id = svn_fs_fs__id_txn_id(id, pool);
+  const char *node_id = svn_fs_fs__id_node_id(id, pool);
+  const char *copy_id = svn_fs_fs__id_copy_id(id, pool);
   const char *name = apr_psprintf(pool, PATH_PREFIX_NODE "%s.%s",
                                   node_id, copy_id);
 
@@ -405,14 +432,29 @@ path_txn_node_children(svn_fs_t *fs, const svn_fs_id_t *id, apr_pool_t *pool)
                      PATH_EXT_CHILDREN, NULL);
 }
 
-static APR_INLINE const char *
-path_node_origin(svn_fs_t *fs, const char *node_id, apr_pool_t *pool)
+/* If the transaction of the node-rev ID in FS keeps its node-revs in a
+   node log, set *LOG_DIR to the transaction directory and *NODE_KEY to
+   the key of ID in that log.  Otherwise, set *LOG_DIR to NULL.  Allocate
+   the results in POOL. */
+static svn_error_t *
+get_txn_node_log(const char **log_dir,
+                 const char **node_key,
+                 svn_fs_t *fs,
+                 const svn_fs_id_t *id,
+                 apr_pool_t *pool)
 {
-  size_t len = strlen(node_id);
-  const char *node_id_minus_last_char =
-    (len == 1) ? "0" : apr_pstrmemdup(pool, node_id, len - 1);
-  return svn_dirent_join_many(pool, fs->path, PATH_NODE_ORIGINS_DIR,
-                              node_id_minus_last_char, NULL);
+  const char *txn_dir = path_txn_dir(fs, svn_fs_fs__id_txn_id(id, pool),
+                                     pool);
+  svn_boolean_t exists;
+
+  SVN_ERR(svn_fs_fs__txn_log_exists(&exists, fs, txn_dir, pool));
+
+  *log_dir = exists ? txn_dir : NULL;
+  *node_key = apr_psprintf(pool, "%s.%s",
+                           svn_fs_fs__id_node_id(id, pool),
+                           svn_fs_fs__id_copy_id(id, pool));
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -1096,6 +1138,117 @@ read_config(svn_fs_t *fs,
   else
     ffd->rep_sharing_allowed = FALSE;
 
+  /* Initialize ffd->rep_batch_max_revisions. */
+  {
+    const char *value;
+
+    svn_config_get(ffd->config, &value, CONFIG_SECTION_REP_SHARING,
+                   CONFIG_OPTION_BATCH_REVISIONS, NULL);
+    ffd->rep_batch_max_revisions = 1;
+    if (value)
+      {
+        char *endstr;
+        long batch_revisions = strtol(value, &endstr, 10);
+
+        if (*endstr || batch_revisions < 1)
+          return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                   _("Invalid value '%s' for option '%s'"),
+                                   value, CONFIG_OPTION_BATCH_REVISIONS);
+
+        ffd->rep_batch_max_revisions = (int)batch_revisions;
+      }
+  }
+
+  /* Initialize ffd->max_deltification_walk. */
+  {
+    const char *value;
+
+    svn_config_get(ffd->config, &value, CONFIG_SECTION_DELTIFICATION,
+                   CONFIG_OPTION_MAX_DELTIFICATION_WALK, NULL);
+    ffd->max_deltification_walk = -1;
+    if (value)
+      {
+        char *endstr;
+        long max_walk = strtol(value, &endstr, 10);
+
+        if (*endstr || max_walk < 0 || max_walk > APR_INT32_MAX)
+          return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                   _("Invalid value '%s' for option '%s'"),
+                                   value,
+                                   CONFIG_OPTION_MAX_DELTIFICATION_WALK);
+
+        ffd->max_deltification_walk = (int)max_walk;
+      }
+  }
+
+  /* Initialize ffd->delta_window_size.  The option gives kilobytes. */
+  {
+    const char *value;
+
+    svn_config_get(ffd->config, &value, CONFIG_SECTION_DELTIFICATION,
+                   CONFIG_OPTION_DELTA_WINDOW_SIZE, NULL);
+    ffd->delta_window_size = SVN_DELTA_DEFAULT_WINDOW_SIZE;
+    if (value)
+      {
+        char *endstr;
+        long window_size = strtol(value, &endstr, 10);
+
+        if (*endstr || window_size <= 0
+            || window_size > SVN_DELTA_MAX_WINDOW_SIZE / 1024)
+          return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                   _("Invalid value '%s' for option '%s'"),
+                                   value, CONFIG_OPTION_DELTA_WINDOW_SIZE);
+
+        ffd->delta_window_size = (apr_size_t)window_size * 1024;
+      }
+  }
+
+  /* Initialize ffd->compression_level. */
+  {
+    const char *value;
+
+    svn_config_get(ffd->config, &value, CONFIG_SECTION_DELTIFICATION,
+                   CONFIG_OPTION_COMPRESSION_LEVEL, NULL);
+    ffd->compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
+    if (value)
+      {
+        char *endstr;
+        long level = strtol(value, &endstr, 10);
+
+        if (*endstr || level < SVN_DELTA_COMPRESSION_LEVEL_NONE
+            || level > SVN_DELTA_COMPRESSION_LEVEL_MAX)
+          return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                   _("Invalid value '%s' for option '%s'"),
+                                   value, CONFIG_OPTION_COMPRESSION_LEVEL);
+
+        ffd->compression_level = (int)level;
+      }
+  }
+
+  SVN_ERR(svn_config_get_bool(ffd->config, &ffd->rep_bloom_enabled,
+                              CONFIG_SECTION_REP_SHARING,
+                              CONFIG_OPTION_ENABLE_BLOOM_FILTER, FALSE));
+
+#if APR_HAS_MMAP
+  SVN_ERR(svn_config_get_bool(ffd->config, &ffd->use_mmap,
+                              CONFIG_SECTION_IO, CONFIG_OPTION_ENABLE_MMAP,
+                              FALSE));
+#else
+  ffd->use_mmap = FALSE;
+#endif
+
+  SVN_ERR(svn_config_get_bool(ffd->config, &ffd->prefetch_delta_chains,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_PREFETCH_DELTA_CHAINS, TRUE));
+
+  SVN_ERR(svn_config_get_bool(ffd->config, &ffd->prepare_commits,
+                              CONFIG_SECTION_COMMITS,
+                              CONFIG_OPTION_PREPARE_OUTSIDE_LOCK, FALSE));
+
+  SVN_ERR(svn_config_get_bool(ffd->config, &ffd->use_txn_node_log,
+                              CONFIG_SECTION_COMMITS,
+                              CONFIG_OPTION_TXN_NODE_LOG, FALSE));
+
   return SVN_NO_ERROR;
 }
 
@@ -1142,6 +1295,96 @@ write_config(svn_fs_t *fs,
 "### be switched on and off at will, but for best space-saving results"      NL
 "### should be enabled consistently over the life of the repository."        NL
 "# " CONFIG_OPTION_ENABLE_REP_SHARING " = true"                              NL
+"###"                                                                        NL
+"### New rep-sharing entries are written to the database once per commit."   NL
+"### Bulk operations like 'svnadmin load' may set a larger number of"        NL
+"### revisions to collect before writing them in a single database"          NL
+"### transaction.  Entries not yet written are only visible to the process"  NL
+"### that made the commits."                                                 NL
+"# " CONFIG_OPTION_BATCH_REVISIONS " = 1"                                    NL
+"###"                                                                        NL
+"### Most lookups in the rep-sharing database fail because new content is"   NL
+"### usually unique.  A Bloom filter over the database keys, which is kept"  NL
+"### in memory and in the file 'rep-cache.bloom', lets the filesystem skip"  NL
+"### most of these queries.  This speeds up large imports and loads.  The"   NL
+"### file is rebuilt as needed.  To use the filter, uncomment this line."    NL
+"# " CONFIG_OPTION_ENABLE_BLOOM_FILTER " = true"                             NL
+"###"                                                                        NL
+"### The rep-sharing database is an SQLite database.  With write-ahead"      NL
+"### logging, readers of the database, like other commits and servers"      NL
+"### serving the same repository, no longer block a commit writing to it."   NL
+"### SQLite 3.7.0 or later is needed to access the database afterwards,"     NL
+"### and it must not live on a network file system.  The page cache size"   NL
+"### and the amount of the database read through a memory mapping (which"   NL
+"### needs SQLite 3.7.17) are given in kBytes.  By default, the rollback"    NL
+"### journal, SQLite's default cache and no memory mapping are used."        NL
+"# " SVN_SQLITE__OPTION_ENABLE_WAL " = true"                                 NL
+"# " SVN_SQLITE__OPTION_CACHE_SIZE " = 8192"                                 NL
+"# " SVN_SQLITE__OPTION_MMAP_SIZE " = 65536"                                 NL
+""                                                                           NL
+"[" CONFIG_SECTION_DELTIFICATION "]"                                         NL
+"### File contents are stored as deltas against older versions, which"       NL
+"### are deltas themselves.  Reading a file means combining the whole"       NL
+"### chain of deltas, so files edited very often become slow to read."       NL
+"### This option limits the number of deltas in a chain.  A change that"     NL
+"### would make a longer chain is stored in full, compressed, instead;"      NL
+"### this costs some space but bounds the time it takes to read it."         NL
+"### By default, chains are not limited.  Directories and properties are"    NL
+"### always stored in full.  To limit chains to 16 deltas, uncomment"        NL
+"### this line."                                                             NL
+"# " CONFIG_OPTION_MAX_DELTIFICATION_WALK " = 16"                            NL
+"###"                                                                        NL
+"### Deltas are stored as a series of windows, each covering 100 kBytes"     NL
+"### of the file by default.  Very large files are stored more compactly"    NL
+"### and read with less overhead when the windows are larger.  This option"  NL
+"### sets the window size for new file contents in kBytes, up to 4096."      NL
+"### Deltas stored with windows larger than the default will not be sent"    NL
+"### to clients as they are but computed anew, since older clients cannot"   NL
+"### handle them.  To use 1 MByte windows, uncomment this line."             NL
+"# " CONFIG_OPTION_DELTA_WINDOW_SIZE " = 1024"                               NL
+"###"                                                                        NL
+"### The contents of deltas are compressed with zlib at level 5 by"          NL
+"### default.  Compression costs CPU time when committing and, to a lesser"  NL
+"### degree, when reading.  CPU-bound servers may use a lower level, from"   NL
+"### 9 for the smallest repository down to 0 for no compression at all."     NL
+"### Any level can be read by all Subversion versions that can read the"     NL
+"### repository.  To store deltas uncompressed, uncomment this line."        NL
+"# " CONFIG_OPTION_COMPRESSION_LEVEL " = 0"                                  NL
+""                                                                           NL
+"[" CONFIG_SECTION_IO "]"                                                    NL
+"### Packed revisions can be read through memory mappings of the pack"       NL
+"### files instead of individual file reads.  This saves system calls and"   NL
+"### double buffering for read-heavy servers but requires enough address"    NL
+"### space to map the pack files; it is not recommended on 32 bit systems"   NL
+"### or when the repository lives on a network file system.  To enable"      NL
+"### memory mapped I/O, uncomment this line."                                NL
+"# " CONFIG_OPTION_ENABLE_MMAP " = true"                                     NL
+"###"                                                                        NL
+"### Reading a file means reading a chain of deltas that may be spread"      NL
+"### over many revision or pack files.  Once the chain is known, the"        NL
+"### filesystem tells the OS which parts of those files it is about to"      NL
+"### read, so that they can be fetched ahead of time.  This helps most on"   NL
+"### network file systems.  To turn these hints off, uncomment this line."   NL
+"# " CONFIG_OPTION_PREFETCH_DELTA_CHAINS " = false"                          NL
+""                                                                           NL
+"[" CONFIG_SECTION_COMMITS "]"                                               NL
+"### Commits are serialized by the repository write lock.  Busy servers"     NL
+"### may write and sync the new revision's contents before acquiring that"   NL
+"### lock, leaving only the final steps of the commit to be serialized."     NL
+"### The extra work is wasted if the commit turns out to be out of date"     NL
+"### and has to be merged first.  Repositories in FSFS format 1 or 2 always" NL
+"### commit under the lock.  To prepare commits outside the lock,"           NL
+"### uncomment this line."                                                   NL
+"# " CONFIG_OPTION_PREPARE_OUTSIDE_LOCK " = true"                            NL
+"###"                                                                        NL
+"### Each transaction normally stores every changed node in up to three"     NL
+"### small files of its own.  Commits touching many paths can instead"       NL
+"### append all of that to a single log file per transaction, which saves"   NL
+"### a lot of file system metadata operations.  Only servers that have"      NL
+"### this option can access such transactions, so do not enable it while"    NL
+"### older servers are serving the repository.  To use transaction logs,"    NL
+"### uncomment this line."                                                   NL
+"# " CONFIG_OPTION_TXN_NODE_LOG " = true"                                    NL
 
 ;
 #undef NL
@@ -1239,7 +1482,7 @@ svn_fs_fs__open(svn_fs_t *fs, const char *path, apr_pool_t *pool)
                                                     PATH_REVPROPS_DB,
                                                     NULL),
                                svn_sqlite__mode_readwrite, statements,
-                               0, NULL,
+                               0, NULL, NULL,
                                fs->pool, pool));
     }
 
@@ -1268,10 +1511,52 @@ upgrade_body(void *baton, apr_pool_t *pool)
   fs_fs_data_t *ffd = fs->fsap_data;
   int format, max_files_per_dir;
   const char *format_path = path_format(fs, pool);
+  svn_node_kind_t kind;
 
   /* Read the FS format number and max-files-per-dir setting. */
   SVN_ERR(read_format(&format, &max_files_per_dir, format_path, pool));
 
+  /* Index the paths with mergeinfo in all existing revisions, unless
+     already done.  Up-to-date filesystems get their index rebuilt, too,
+     should it have been removed. */
+  SVN_ERR(svn_io_check_path(svn_dirent_join(fs->path,
+                                            MERGEINFO_INDEX_DB_NAME, pool),
+                            &kind, pool));
+  if (kind == svn_node_none)
+    {
+      svn_revnum_t youngest;
+
+      SVN_ERR(get_youngest(&youngest, fs->path, pool));
+      SVN_ERR(svn_fs_fs__create_mergeinfo_index(fs, pool));
+      SVN_ERR(svn_fs_fs__update_mergeinfo_index(fs, youngest, pool));
+    }
+
+  /* Likewise for the index of changed subtrees used by 'svn log'. */
+  SVN_ERR(svn_io_check_path(svn_dirent_join(fs->path, LOG_INDEX_DB_NAME,
+                                            pool),
+                            &kind, pool));
+  if (kind == svn_node_none)
+    {
+      svn_revnum_t youngest;
+
+      SVN_ERR(get_youngest(&youngest, fs->path, pool));
+      SVN_ERR(svn_fs_fs__create_log_index(fs, pool));
+      SVN_ERR(svn_fs_fs__update_log_index(fs, youngest, pool));
+    }
+
+  /* And for the revision dates used to resolve '-r {DATE}'. */
+  SVN_ERR(svn_io_check_path(svn_dirent_join(fs->path, DATE_INDEX_NAME,
+                                            pool),
+                            &kind, pool));
+  if (kind == svn_node_none)
+    {
+      svn_revnum_t youngest;
+
+      SVN_ERR(get_youngest(&youngest, fs->path, pool));
+      SVN_ERR(svn_fs_fs__create_date_index(fs, pool));
+      SVN_ERR(svn_fs_fs__update_date_index(fs, youngest, pool));
+    }
+
   /* If we're already up-to-date, there's nothing to be done here. */
   if (format == SVN_FS_FS__FORMAT_NUMBER)
     return SVN_NO_ERROR;
@@ -1313,15 +1598,28 @@ upgrade_body(void *baton, apr_pool_t *pool)
                                                           PATH_REVPROPS_DB,
                                                           NULL),
                                svn_sqlite__mode_rwcreate, statements,
-                               0, NULL,
+                               0, NULL, NULL,
                                fs->pool, pool));
       SVN_ERR(svn_sqlite__exec_statements(ffd->revprop_db,
                                           STMT_CREATE_SCHEMA));
     }
 
+  /* Move the locks out of their digest files into the lock database.
+     The digest files stay authoritative until the format is bumped. */
+  if (format < SVN_FS_FS__MIN_LOCKS_DB_FORMAT)
+    SVN_ERR(svn_fs_fs__create_locks_db(fs, pool));
+
   /* Bump the format file. */
-  return write_format(format_path, SVN_FS_FS__FORMAT_NUMBER, max_files_per_dir,
-                      TRUE, pool);
+  SVN_ERR(write_format(format_path, SVN_FS_FS__FORMAT_NUMBER,
+                       max_files_per_dir, TRUE, pool));
+
+  /* The digest files are now stale. */
+  if (format < SVN_FS_FS__MIN_LOCKS_DB_FORMAT)
+    SVN_ERR(svn_io_remove_dir2(svn_dirent_join(fs->path, PATH_LOCKS_DIR,
+                                               pool),
+                               TRUE, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -1472,153 +1770,169 @@ get_youngest(svn_revnum_t *youngest_p,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_fs__hotcopy(const char *src_path,
-                   const char *dst_path,
-                   apr_pool_t *pool)
-{
-  const char *src_subdir, *dst_subdir;
-  svn_revnum_t youngest, rev, min_unpacked_rev, min_unpacked_revprop;
-  apr_pool_t *iterpool;
-  svn_node_kind_t kind;
-  int format, max_files_per_dir;
-
-  /* Check format to be sure we know how to hotcopy this FS. */
-  SVN_ERR(read_format(&format, &max_files_per_dir,
-                      svn_dirent_join(src_path, PATH_FORMAT, pool),
-                      pool));
-  SVN_ERR(check_format(format));
-
-  /* Copy the 'current' file. */
-  SVN_ERR(svn_io_dir_file_copy(src_path, dst_path, PATH_CURRENT, pool));
-
-  /* Copy the uuid. */
-  SVN_ERR(svn_io_dir_file_copy(src_path, dst_path, PATH_UUID, pool));
-
-  /* Copy the config. */
-  SVN_ERR(svn_io_dir_file_copy(src_path, dst_path, PATH_CONFIG, pool));
+/* The interval within which a change to the 'current' file might not
+   be reflected in its mtime, i.e. the mtime granularity of the
+   coarsest filesystems we care about. */
+#define CURRENT_MTIME_SLACK apr_time_from_sec(2)
 
-  /* Copy the rep cache before copying the rev files to make sure all
-     cached references will be present in the copy. */
-  src_subdir = svn_dirent_join(src_path, REP_CACHE_DB_NAME, pool);
-  dst_subdir = svn_dirent_join(dst_path, REP_CACHE_DB_NAME, pool);
-  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
-  if (kind == svn_node_file)
-    SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+/* Set *YOUNGEST_P to the youngest revision of FS, as get_youngest()
+   would.  Unless 'current' changed since any svn_fs_t object in this
+   process last read it, return the value shared via FS's
+   fs_fs_shared_data_t instead of reading the file.  Readers never
+   block each other; concurrent updates of the shared value are
+   resolved by letting the first one win.  Use POOL for temporary
+   allocations. */
+static svn_error_t *
+get_youngest_shared(svn_revnum_t *youngest_p,
+                    svn_fs_t *fs,
+                    apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+  const char *path = svn_fs_fs__path_current(fs, pool);
+  apr_finfo_t finfo;
+  svn_atomic_t sequence;
+  svn_revnum_t youngest;
+  apr_time_t now;
+  svn_error_t *err;
 
-  /* Copy the min unpacked rev, and read its value. */
-  if (format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+  /* We get the stamp *before* reading the file such that a concurrent
+     commit can at worst make us publish an outdated stamp, never an
+     outdated revision.  If we can't get it, e.g. due to a stale NFS
+     handle, leave it to read_current() to retry or to report the
+     problem. */
+  now = apr_time_now();
+  err = svn_io_stat(&finfo, path,
+                    APR_FINFO_IDENT | APR_FINFO_SIZE | APR_FINFO_MTIME,
+                    pool);
+  if (err)
     {
-      const char *min_unpacked_rev_path;
-      min_unpacked_rev_path = svn_dirent_join(src_path, PATH_MIN_UNPACKED_REV,
-                                              pool);
-
-      SVN_ERR(svn_io_dir_file_copy(src_path, dst_path, PATH_MIN_UNPACKED_REV,
-                                   pool));
-      SVN_ERR(read_min_unpacked_rev(&min_unpacked_rev, min_unpacked_rev_path,
-                                    pool));
+      svn_error_clear(err);
+      return get_youngest(youngest_p, fs->path, pool);
     }
-  else
+
+  /* Use the shared value if it is consistent and matches the stamp. */
+  sequence = svn_atomic_cas(&ffsd->current_sequence, 0, 0);
+  if ((sequence & 1) == 0)
     {
-      min_unpacked_rev = 0;
+      youngest = ffsd->current_youngest;
+      if (SVN_IS_VALID_REVNUM(youngest)
+          && ffsd->current_inode == finfo.inode
+          && ffsd->current_device == finfo.device
+          && ffsd->current_size == finfo.size
+          && ffsd->current_mtime == finfo.mtime
+          && svn_atomic_cas(&ffsd->current_sequence, 0, 0) == sequence)
+        {
+          *youngest_p = youngest;
+          return SVN_NO_ERROR;
+        }
     }
 
-  /* Find the youngest revision from this 'current' file. */
-  SVN_ERR(get_youngest(&youngest, dst_path, pool));
-
-  /* Copy the necessary rev files. */
-  src_subdir = svn_dirent_join(src_path, PATH_REVS_DIR, pool);
-  dst_subdir = svn_dirent_join(dst_path, PATH_REVS_DIR, pool);
-
-  SVN_ERR(svn_io_make_dir_recursively(dst_subdir, pool));
+  SVN_ERR(get_youngest(youngest_p, fs->path, pool));
 
-  iterpool = svn_pool_create(pool);
-  /* First, copy packed shards. */
-  for (rev = 0; rev < min_unpacked_rev; rev += max_files_per_dir)
+  /* Don't publish stamps of files that were modified so recently that
+     another modification might still go unnoticed.  Also, let other
+     threads be if they are already updating the shared value. */
+  if (finfo.mtime + CURRENT_MTIME_SLACK < now
+      && (sequence & 1) == 0
+      && svn_atomic_cas(&ffsd->current_sequence, sequence + 1, sequence)
+           == sequence)
     {
-      const char *packed_shard = apr_psprintf(iterpool, "%ld.pack",
-                                              rev / max_files_per_dir);
-      const char *src_subdir_packed_shard;
-      src_subdir_packed_shard = svn_dirent_join(src_subdir, packed_shard,
-                                                iterpool);
-
-      SVN_ERR(svn_io_copy_dir_recursively(src_subdir_packed_shard,
-                                          dst_subdir, packed_shard,
-                                          TRUE /* copy_perms */,
-                                          NULL /* cancel_func */, NULL,
-                                          iterpool));
-      svn_pool_clear(iterpool);
+      ffsd->current_youngest = *youngest_p;
+      ffsd->current_inode = finfo.inode;
+      ffsd->current_device = finfo.device;
+      ffsd->current_size = finfo.size;
+      ffsd->current_mtime = finfo.mtime;
+      svn_atomic_cas(&ffsd->current_sequence, sequence + 2, sequence + 1);
     }
 
-  /* Then, copy non-packed shards. */
-  SVN_ERR_ASSERT(rev == min_unpacked_rev);
-  for (; rev <= youngest; rev++)
-    {
-      const char *src_subdir_shard = src_subdir,
-                 *dst_subdir_shard = dst_subdir;
-
-      if (max_files_per_dir)
-        {
-          const char *shard = apr_psprintf(iterpool, "%ld",
-                                           rev / max_files_per_dir);
-          src_subdir_shard = svn_dirent_join(src_subdir, shard, iterpool);
-          dst_subdir_shard = svn_dirent_join(dst_subdir, shard, iterpool);
-
-          if (rev % max_files_per_dir == 0)
-            {
-              SVN_ERR(svn_io_dir_make(dst_subdir_shard, APR_OS_DEFAULT,
-                                      iterpool));
-              SVN_ERR(svn_fs_fs__dup_perms(dst_subdir_shard, dst_subdir,
-                                           iterpool));
-            }
-        }
+  return SVN_NO_ERROR;
+}
 
-      SVN_ERR(svn_io_dir_file_copy(src_subdir_shard, dst_subdir_shard,
-                                   apr_psprintf(iterpool, "%ld", rev),
-                                   iterpool));
-      svn_pool_clear(iterpool);
-    }
+/* Create the shard directory SHARD_PATH of a hotcopy destination unless
+   it already exists, and give it the permissions of PERMS_REFERENCE.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_make_shard_dir(const char *shard_path,
+                       const char *perms_reference,
+                       apr_pool_t *pool)
+{
+  svn_error_t *err;
 
-  /* Copy the min unpacked revprop file, and read its value. */
-  if (format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-    {
-      const char *min_unpacked_revprop_path;
-      min_unpacked_revprop_path = svn_dirent_join(src_path,
-                                                  PATH_MIN_UNPACKED_REVPROP,
-                                                  pool);
-      SVN_ERR(svn_io_dir_file_copy(src_path, dst_path,
-                                   PATH_MIN_UNPACKED_REVPROP, pool));
-      SVN_ERR(read_min_unpacked_rev(&min_unpacked_revprop,
-                                    min_unpacked_revprop_path, pool));
-    }
-  else
+  err = svn_io_dir_make(shard_path, APR_OS_DEFAULT, pool);
+  if (err && APR_STATUS_IS_EEXIST(err->apr_err))
     {
-      min_unpacked_revprop = 0;
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
     }
+  SVN_ERR(err);
 
-  /* Copy the necessary revprop files. */
-  src_subdir = svn_dirent_join(src_path, PATH_REVPROPS_DIR, pool);
-  dst_subdir = svn_dirent_join(dst_path, PATH_REVPROPS_DIR, pool);
+  return svn_fs_fs__dup_perms(shard_path, perms_reference, pool);
+}
 
-  SVN_ERR(svn_io_make_dir_recursively(dst_subdir, pool));
+/* Set *CHANGED to FALSE if the file DST_FILE seems to be an up-to-date
+   copy of SRC_FILE, i.e. if it exists, has the same size and has not
+   been modified before SRC_FILE was.  Otherwise, set *CHANGED to TRUE.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_file_changed(svn_boolean_t *changed,
+                     const char *src_file,
+                     const char *dst_file,
+                     apr_pool_t *pool)
+{
+  apr_finfo_t src_finfo, dst_finfo;
+  svn_error_t *err;
 
-  /* Copy the packed revprop db. */
-  if (format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+  SVN_ERR(svn_io_stat(&src_finfo, src_file,
+                      APR_FINFO_SIZE | APR_FINFO_MTIME, pool));
+  err = svn_io_stat(&dst_finfo, dst_file,
+                    APR_FINFO_SIZE | APR_FINFO_MTIME, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
     {
-      const char *src_file = svn_dirent_join(src_subdir, PATH_REVPROPS_DB,
-                                             pool);
-      const char *dst_file = svn_dirent_join(dst_subdir, PATH_REVPROPS_DB,
-                                             pool);
-      SVN_ERR(svn_sqlite__hotcopy(src_file, dst_file, pool));
+      svn_error_clear(err);
+      *changed = TRUE;
+      return SVN_NO_ERROR;
     }
+  SVN_ERR(err);
+
+  *changed = src_finfo.size != dst_finfo.size
+          || src_finfo.mtime > dst_finfo.mtime;
+
+  return SVN_NO_ERROR;
+}
 
-  for (rev = min_unpacked_revprop; rev <= youngest; rev++)
+/* Copy the files named after the revisions START_REV through END_REV
+   from SRC_SUBDIR to DST_SUBDIR, e.g. the revs or revprops directory of
+   two filesystems with MAX_FILES_PER_DIR files per shard.  Create
+   missing shard directories in DST_SUBDIR.  If ONLY_IF_CHANGED is TRUE,
+   skip the files that hotcopy_file_changed() considers unchanged.  Use
+   optional CANCEL_FUNC/CANCEL_BATON for cancellation support and POOL
+   for temporary allocations. */
+static svn_error_t *
+hotcopy_copy_rev_files(const char *src_subdir,
+                       const char *dst_subdir,
+                       svn_revnum_t start_rev,
+                       svn_revnum_t end_rev,
+                       int max_files_per_dir,
+                       svn_boolean_t only_if_changed,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t rev;
+
+  for (rev = start_rev; rev <= end_rev; rev++)
     {
       const char *src_subdir_shard = src_subdir,
                  *dst_subdir_shard = dst_subdir;
+      const char *filename;
 
       svn_pool_clear(iterpool);
 
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
       if (max_files_per_dir)
         {
           const char *shard = apr_psprintf(iterpool, "%ld",
@@ -1626,53 +1940,477 @@ svn_fs_fs__hotcopy(const char *src_path,
           src_subdir_shard = svn_dirent_join(src_subdir, shard, iterpool);
           dst_subdir_shard = svn_dirent_join(dst_subdir, shard, iterpool);
 
-          if (rev % max_files_per_dir == 0)
-            {
-              SVN_ERR(svn_io_dir_make(dst_subdir_shard, APR_OS_DEFAULT,
-                                      iterpool));
-              SVN_ERR(svn_fs_fs__dup_perms(dst_subdir_shard, dst_subdir,
+          if (rev == start_rev || rev % max_files_per_dir == 0)
+            SVN_ERR(hotcopy_make_shard_dir(dst_subdir_shard, dst_subdir,
                                            iterpool));
-            }
+        }
+
+      filename = apr_psprintf(iterpool, "%ld", rev);
+      if (only_if_changed)
+        {
+          svn_boolean_t changed;
+
+          SVN_ERR(hotcopy_file_changed(&changed,
+                                       svn_dirent_join(src_subdir_shard,
+                                                       filename, iterpool),
+                                       svn_dirent_join(dst_subdir_shard,
+                                                       filename, iterpool),
+                                       iterpool));
+          if (!changed)
+            continue;
         }
 
       SVN_ERR(svn_io_dir_file_copy(src_subdir_shard, dst_subdir_shard,
-                                   apr_psprintf(iterpool, "%ld", rev),
-                                   iterpool));
+                                   filename, iterpool));
     }
 
   svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
 
-  /* Make an empty transactions directory for now.  Eventually some
-     method of copying in progress transactions will need to be
-     developed.*/
-  dst_subdir = svn_dirent_join(dst_path, PATH_TXNS_DIR, pool);
-  SVN_ERR(svn_io_make_dir_recursively(dst_subdir, pool));
-  if (format >= SVN_FS_FS__MIN_PROTOREVS_DIR_FORMAT)
+/* Remove the shard directories in SUBDIR that hold the revisions
+   START_REV up to, but not including, END_REV, e.g. because a packed
+   shard now replaces them.  MAX_FILES_PER_DIR is the shard size.  Use
+   optional CANCEL_FUNC/CANCEL_BATON for cancellation support and POOL
+   for temporary allocations. */
+static svn_error_t *
+hotcopy_remove_shards(const char *subdir,
+                      svn_revnum_t start_rev,
+                      svn_revnum_t end_rev,
+                      int max_files_per_dir,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t rev;
+
+  for (rev = start_rev; rev < end_rev; rev += max_files_per_dir)
     {
-      dst_subdir = svn_dirent_join(dst_path, PATH_TXN_PROTOS_DIR, pool);
-      SVN_ERR(svn_io_make_dir_recursively(dst_subdir, pool));
-    }
+      const char *shard;
 
-  /* Now copy the locks tree. */
-  src_subdir = svn_dirent_join(src_path, PATH_LOCKS_DIR, pool);
-  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
-  if (kind == svn_node_dir)
-    SVN_ERR(svn_io_copy_dir_recursively(src_subdir, dst_path,
-                                        PATH_LOCKS_DIR, TRUE, NULL,
-                                        NULL, pool));
+      svn_pool_clear(iterpool);
+
+      shard = apr_psprintf(iterpool, "%ld", rev / max_files_per_dir);
+      SVN_ERR(svn_io_remove_dir2(svn_dirent_join(subdir, shard, iterpool),
+                                 TRUE, cancel_func, cancel_baton,
+                                 iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Verify that DST_PATH holds a previous hotcopy of the filesystem at
+   SRC_PATH, which has format FORMAT and shard size MAX_FILES_PER_DIR,
+   such that an incremental hotcopy can bring it up to date.  Set
+   *DST_YOUNGEST, *DST_MIN_UNPACKED_REV and *DST_MIN_UNPACKED_REVPROP to
+   the respective values of the destination.  Use POOL for temporary
+   allocations. */
+static svn_error_t *
+hotcopy_check_destination(svn_revnum_t *dst_youngest,
+                          svn_revnum_t *dst_min_unpacked_rev,
+                          svn_revnum_t *dst_min_unpacked_revprop,
+                          const char *src_path,
+                          const char *dst_path,
+                          int format,
+                          int max_files_per_dir,
+                          apr_pool_t *pool)
+{
+  int dst_format, dst_max_files_per_dir;
+  svn_stringbuf_t *src_uuid, *dst_uuid;
+
+  SVN_ERR(read_format(&dst_format, &dst_max_files_per_dir,
+                      svn_dirent_join(dst_path, PATH_FORMAT, pool),
+                      pool));
+  if (dst_format != format || dst_max_files_per_dir != max_files_per_dir)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("The filesystem at '%s' has a different "
+                               "format or sharding than '%s'; cannot "
+                               "hotcopy incrementally"),
+                             svn_dirent_local_style(dst_path, pool),
+                             svn_dirent_local_style(src_path, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&src_uuid,
+                                   svn_dirent_join(src_path, PATH_UUID,
+                                                   pool),
+                                   pool));
+  SVN_ERR(svn_stringbuf_from_file2(&dst_uuid,
+                                   svn_dirent_join(dst_path, PATH_UUID,
+                                                   pool),
+                                   pool));
+  if (!svn_stringbuf_compare(src_uuid, dst_uuid))
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("The filesystem at '%s' is not a hotcopy "
+                               "of '%s'"),
+                             svn_dirent_local_style(dst_path, pool),
+                             svn_dirent_local_style(src_path, pool));
+
+  SVN_ERR(get_youngest(dst_youngest, dst_path, pool));
+
+  if (format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+    SVN_ERR(read_min_unpacked_rev(dst_min_unpacked_rev,
+                                  svn_dirent_join(dst_path,
+                                                  PATH_MIN_UNPACKED_REV,
+                                                  pool),
+                                  pool));
+  else
+    *dst_min_unpacked_rev = 0;
+
+  if (format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+    SVN_ERR(read_min_unpacked_rev(dst_min_unpacked_revprop,
+                                  svn_dirent_join(dst_path,
+                                                  PATH_MIN_UNPACKED_REVPROP,
+                                                  pool),
+                                  pool));
+  else
+    *dst_min_unpacked_revprop = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy the directory NAME from SRC_PATH to DST_PATH if it exists,
+   replacing what DST_PATH may already contain under that name.  Use
+   optional CANCEL_FUNC/CANCEL_BATON for cancellation support and POOL
+   for temporary allocations. */
+static svn_error_t *
+hotcopy_replace_dir(const char *src_path,
+                    const char *dst_path,
+                    const char *name,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *pool)
+{
+  const char *src_subdir = svn_dirent_join(src_path, name, pool);
+  svn_node_kind_t kind;
 
-  /* Now copy the node-origins cache tree. */
-  src_subdir = svn_dirent_join(src_path, PATH_NODE_ORIGINS_DIR, pool);
   SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
-  if (kind == svn_node_dir)
-    SVN_ERR(svn_io_copy_dir_recursively(src_subdir, dst_path,
-                                        PATH_NODE_ORIGINS_DIR, TRUE, NULL,
-                                        NULL, pool));
+  if (kind != svn_node_dir)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_remove_dir2(svn_dirent_join(dst_path, name, pool), TRUE,
+                             cancel_func, cancel_baton, pool));
+  return svn_io_copy_dir_recursively(src_subdir, dst_path, name,
+                                     TRUE /* copy_perms */,
+                                     cancel_func, cancel_baton, pool);
+}
+
+svn_error_t *
+svn_fs_fs__hotcopy(const char *src_path,
+                   const char *dst_path,
+                   svn_boolean_t incremental,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  const char *src_subdir, *dst_subdir;
+  const char *dst_current_tmp = NULL;
+  svn_revnum_t youngest, rev, min_unpacked_rev, min_unpacked_revprop;
+  svn_revnum_t dst_youngest = SVN_INVALID_REVNUM;
+  svn_revnum_t dst_min_unpacked_rev = 0, dst_min_unpacked_revprop = 0;
+  apr_pool_t *iterpool;
+  svn_node_kind_t kind;
+  int format, max_files_per_dir;
+
+  /* Check format to be sure we know how to hotcopy this FS. */
+  SVN_ERR(read_format(&format, &max_files_per_dir,
+                      svn_dirent_join(src_path, PATH_FORMAT, pool),
+                      pool));
+  SVN_ERR(check_format(format));
+
+  /* An incremental hotcopy into a location that doesn't hold a
+     filesystem yet is just a normal one. */
+  if (incremental)
+    {
+      SVN_ERR(svn_io_check_path(svn_dirent_join(dst_path, PATH_FORMAT, pool),
+                                &kind, pool));
+      if (kind == svn_node_none)
+        incremental = FALSE;
+      else
+        SVN_ERR(hotcopy_check_destination(&dst_youngest,
+                                          &dst_min_unpacked_rev,
+                                          &dst_min_unpacked_revprop,
+                                          src_path, dst_path, format,
+                                          max_files_per_dir, pool));
+    }
+
+  /* Copy the 'current' file.  An incremental hotcopy updates a usable
+     filesystem, so it must not announce the new revisions before they
+     have been copied.  Keep them in a temporary file until then. */
+  if (incremental)
+    {
+      char *buf;
+
+      dst_current_tmp = svn_dirent_join(dst_path, PATH_CURRENT ".hotcopy",
+                                        pool);
+      SVN_ERR(svn_io_copy_file(svn_dirent_join(src_path, PATH_CURRENT, pool),
+                               dst_current_tmp, TRUE, pool));
+      SVN_ERR(read_current(dst_current_tmp, &buf, pool));
+      youngest = SVN_STR_TO_REV(buf);
+
+      if (youngest < dst_youngest)
+        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 _("The filesystem at '%s' is younger than "
+                                   "'%s'; cannot hotcopy incrementally"),
+                                 svn_dirent_local_style(dst_path, pool),
+                                 svn_dirent_local_style(src_path, pool));
+    }
+  else
+    SVN_ERR(svn_io_dir_file_copy(src_path, dst_path, PATH_CURRENT, pool));
+
+  /* Copy the uuid. */
+  SVN_ERR(svn_io_dir_file_copy(src_path, dst_path, PATH_UUID, pool));
+
+  /* Copy the config. */
+  SVN_ERR(svn_io_dir_file_copy(src_path, dst_path, PATH_CONFIG, pool));
+
+  /* Copy the rep cache before copying the rev files to make sure all
+     cached references will be present in the copy.  Any Bloom filter
+     the destination built for its old rep cache may not match the new
+     one; it will be rebuilt on demand. */
+  src_subdir = svn_dirent_join(src_path, REP_CACHE_DB_NAME, pool);
+  dst_subdir = svn_dirent_join(dst_path, REP_CACHE_DB_NAME, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+  if (incremental)
+    SVN_ERR(svn_io_remove_file2(svn_dirent_join(dst_path,
+                                                REP_CACHE_BLOOM_NAME, pool),
+                                TRUE, pool));
+
+  /* Copy the mergeinfo index.  It may cover revisions which will not be
+     copied; the next commit to the destination will drop those. */
+  src_subdir = svn_dirent_join(src_path, MERGEINFO_INDEX_DB_NAME, pool);
+  dst_subdir = svn_dirent_join(dst_path, MERGEINFO_INDEX_DB_NAME, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+
+  /* Likewise for the date index, a plain file. */
+  src_subdir = svn_dirent_join(src_path, DATE_INDEX_NAME, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    SVN_ERR(svn_io_dir_file_copy(src_path, dst_path, DATE_INDEX_NAME, pool));
+
+  /* Copy the recovery checkpoint, if any.  Should it name a revision
+     which did not make it into the copy, recovery will ignore it. */
+  if (format < SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    {
+      SVN_ERR(svn_io_check_path(svn_dirent_join(src_path, PATH_RECOVERY_IDS,
+                                                pool),
+                                &kind, pool));
+      if (kind == svn_node_file)
+        SVN_ERR(svn_io_dir_file_copy(src_path, dst_path, PATH_RECOVERY_IDS,
+                                     pool));
+    }
+
+  /* Read the min unpacked rev.  A normal hotcopy may copy the file right
+     away; an incremental one must wait until the packed shards are in
+     place. */
+  if (format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+    {
+      const char *min_unpacked_rev_path;
+      min_unpacked_rev_path = svn_dirent_join(src_path, PATH_MIN_UNPACKED_REV,
+                                              pool);
+
+      if (incremental)
+        {
+          /* Read the copy that we are going to install later. */
+          min_unpacked_rev_path = svn_dirent_join(dst_path,
+                                                  PATH_MIN_UNPACKED_REV
+                                                  ".hotcopy", pool);
+          SVN_ERR(svn_io_copy_file(svn_dirent_join(src_path,
+                                                   PATH_MIN_UNPACKED_REV,
+                                                   pool),
+                                   min_unpacked_rev_path, TRUE, pool));
+        }
+      else
+        {
+          SVN_ERR(svn_io_dir_file_copy(src_path, dst_path,
+                                       PATH_MIN_UNPACKED_REV, pool));
+        }
+      SVN_ERR(read_min_unpacked_rev(&min_unpacked_rev, min_unpacked_rev_path,
+                                    pool));
+
+      if (min_unpacked_rev < dst_min_unpacked_rev)
+        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 _("The filesystem at '%s' has more packed "
+                                   "shards than '%s'; cannot hotcopy "
+                                   "incrementally"),
+                                 svn_dirent_local_style(dst_path, pool),
+                                 svn_dirent_local_style(src_path, pool));
+    }
+  else
+    {
+      min_unpacked_rev = 0;
+    }
+
+  /* Find the youngest revision from this 'current' file. */
+  if (!incremental)
+    SVN_ERR(get_youngest(&youngest, dst_path, pool));
+
+  /* Copy the necessary rev files. */
+  src_subdir = svn_dirent_join(src_path, PATH_REVS_DIR, pool);
+  dst_subdir = svn_dirent_join(dst_path, PATH_REVS_DIR, pool);
+
+  SVN_ERR(svn_io_make_dir_recursively(dst_subdir, pool));
+
+  iterpool = svn_pool_create(pool);
+  /* First, copy packed shards.  Those that the destination has already
+     packed are immutable and don't need to be copied again. */
+  for (rev = dst_min_unpacked_rev; rev < min_unpacked_rev;
+       rev += max_files_per_dir)
+    {
+      const char *packed_shard = apr_psprintf(iterpool, "%ld.pack",
+                                              rev / max_files_per_dir);
+      const char *src_subdir_packed_shard;
+      src_subdir_packed_shard = svn_dirent_join(src_subdir, packed_shard,
+                                                iterpool);
+
+      /* Get rid of leftovers from an interrupted incremental hotcopy. */
+      if (incremental)
+        SVN_ERR(svn_io_remove_dir2(svn_dirent_join(dst_subdir, packed_shard,
+                                                   iterpool),
+                                   TRUE, cancel_func, cancel_baton,
+                                   iterpool));
+
+      SVN_ERR(svn_io_copy_dir_recursively(src_subdir_packed_shard,
+                                          dst_subdir, packed_shard,
+                                          TRUE /* copy_perms */,
+                                          cancel_func, cancel_baton,
+                                          iterpool));
+      svn_pool_clear(iterpool);
+    }
+
+  /* Then, copy non-packed shards.  Revision files are immutable, too,
+     so skip those that the destination already has. */
+  SVN_ERR_ASSERT(rev == min_unpacked_rev);
+  if (incremental && dst_youngest >= rev)
+    rev = dst_youngest + 1;
+  SVN_ERR(hotcopy_copy_rev_files(src_subdir, dst_subdir, rev, youngest,
+                                 max_files_per_dir, FALSE,
+                                 cancel_func, cancel_baton, pool));
+
+  /* Now that the destination has all the packed shards, switch it over to
+     them and get rid of the revision files they replace. */
+  if (incremental && format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+    {
+      SVN_ERR(move_into_place(svn_dirent_join(dst_path,
+                                              PATH_MIN_UNPACKED_REV
+                                              ".hotcopy", pool),
+                              svn_dirent_join(dst_path,
+                                              PATH_MIN_UNPACKED_REV, pool),
+                              svn_dirent_join(src_path,
+                                              PATH_MIN_UNPACKED_REV, pool),
+                              pool));
+      SVN_ERR(hotcopy_remove_shards(dst_subdir, dst_min_unpacked_rev,
+                                    min_unpacked_rev, max_files_per_dir,
+                                    cancel_func, cancel_baton, pool));
+    }
+
+  /* Read the min unpacked revprop, deferring its installation in the
+     same way as for the min unpacked rev. */
+  if (format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+    {
+      const char *min_unpacked_revprop_path;
+      min_unpacked_revprop_path = svn_dirent_join(dst_path,
+                                                  PATH_MIN_UNPACKED_REVPROP
+                                                  ".hotcopy", pool);
+      SVN_ERR(svn_io_copy_file(svn_dirent_join(src_path,
+                                               PATH_MIN_UNPACKED_REVPROP,
+                                               pool),
+                               min_unpacked_revprop_path, TRUE, pool));
+      SVN_ERR(read_min_unpacked_rev(&min_unpacked_revprop,
+                                    min_unpacked_revprop_path, pool));
+    }
+  else
+    {
+      min_unpacked_revprop = 0;
+    }
+
+  /* Copy the necessary revprop files. */
+  src_subdir = svn_dirent_join(src_path, PATH_REVPROPS_DIR, pool);
+  dst_subdir = svn_dirent_join(dst_path, PATH_REVPROPS_DIR, pool);
+
+  SVN_ERR(svn_io_make_dir_recursively(dst_subdir, pool));
+
+  /* Copy the packed revprop db and install the min unpacked revprop that
+     matches it. */
+  if (format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+    {
+      const char *src_file = svn_dirent_join(src_subdir, PATH_REVPROPS_DB,
+                                             pool);
+      const char *dst_file = svn_dirent_join(dst_subdir, PATH_REVPROPS_DB,
+                                             pool);
+      SVN_ERR(svn_sqlite__hotcopy(src_file, dst_file, pool));
+
+      SVN_ERR(move_into_place(svn_dirent_join(dst_path,
+                                              PATH_MIN_UNPACKED_REVPROP
+                                              ".hotcopy", pool),
+                              svn_dirent_join(dst_path,
+                                              PATH_MIN_UNPACKED_REVPROP,
+                                              pool),
+                              svn_dirent_join(src_path,
+                                              PATH_MIN_UNPACKED_REVPROP,
+                                              pool),
+                              pool));
+    }
+
+  /* Unlike revision files, revprop files may change at any time.  An
+     incremental hotcopy has to check all of them. */
+  SVN_ERR(hotcopy_copy_rev_files(src_subdir, dst_subdir,
+                                 min_unpacked_revprop, youngest,
+                                 max_files_per_dir, incremental,
+                                 cancel_func, cancel_baton, pool));
+
+  if (incremental && min_unpacked_revprop > dst_min_unpacked_revprop)
+    SVN_ERR(hotcopy_remove_shards(dst_subdir, dst_min_unpacked_revprop,
+                                  min_unpacked_revprop, max_files_per_dir,
+                                  cancel_func, cancel_baton, pool));
+
+  svn_pool_destroy(iterpool);
+
+  /* Make an empty transactions directory for now.  Eventually some
+     method of copying in progress transactions will need to be
+     developed.*/
+  dst_subdir = svn_dirent_join(dst_path, PATH_TXNS_DIR, pool);
+  SVN_ERR(svn_io_make_dir_recursively(dst_subdir, pool));
+  if (format >= SVN_FS_FS__MIN_PROTOREVS_DIR_FORMAT)
+    {
+      dst_subdir = svn_dirent_join(dst_path, PATH_TXN_PROTOS_DIR, pool);
+      SVN_ERR(svn_io_make_dir_recursively(dst_subdir, pool));
+    }
+
+  /* Now copy the locks, which newer formats keep in a database. */
+  SVN_ERR(hotcopy_replace_dir(src_path, dst_path, PATH_LOCKS_DIR,
+                              cancel_func, cancel_baton, pool));
+  src_subdir = svn_dirent_join(src_path, LOCKS_DB_NAME, pool);
+  dst_subdir = svn_dirent_join(dst_path, LOCKS_DB_NAME, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+
+  /* Now copy the node-origins cache, both the database and the tree
+     older releases wrote. */
+  SVN_ERR(hotcopy_replace_dir(src_path, dst_path, PATH_NODE_ORIGINS_DIR,
+                              cancel_func, cancel_baton, pool));
+  src_subdir = svn_dirent_join(src_path, NODE_ORIGINS_DB_NAME, pool);
+  dst_subdir = svn_dirent_join(dst_path, NODE_ORIGINS_DB_NAME, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
 
   /* Copy the txn-current file. */
   if (format >= SVN_FS_FS__MIN_TXN_CURRENT_FORMAT)
     SVN_ERR(svn_io_dir_file_copy(src_path, dst_path, PATH_TXN_CURRENT, pool));
 
+  /* Everything the new 'current' refers to is in place now. */
+  if (incremental)
+    SVN_ERR(move_into_place(dst_current_tmp,
+                            svn_dirent_join(dst_path, PATH_CURRENT, pool),
+                            svn_dirent_join(src_path, PATH_CURRENT, pool),
+                            pool));
+
   /* Hotcopied FS is complete. Stamp it with a format file. */
   return write_format(svn_dirent_join(dst_path, PATH_FORMAT, pool),
                       format, max_files_per_dir, FALSE, pool);
@@ -1685,7 +2423,7 @@ svn_fs_fs__youngest_rev(svn_revnum_t *youngest_p,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
 
-  SVN_ERR(get_youngest(youngest_p, fs->path, pool));
+  SVN_ERR(get_youngest_shared(youngest_p, fs, pool));
   ffd->youngest_rev_cache = *youngest_p;
 
   return SVN_NO_ERROR;
@@ -1773,7 +2511,7 @@ ensure_revision_exists(svn_fs_t *fs,
   if (rev <= ffd->youngest_rev_cache)
     return SVN_NO_ERROR;
 
-  SVN_ERR(get_youngest(&(ffd->youngest_rev_cache), fs->path, pool));
+  SVN_ERR(get_youngest_shared(&(ffd->youngest_rev_cache), fs, pool));
 
   /* Check again. */
   if (rev <= ffd->youngest_rev_cache)
@@ -1812,6 +2550,169 @@ open_pack_or_rev_file(apr_file_t **file,
   return svn_error_return(err);
 }
 
+#if APR_HAS_MMAP
+/* Map the file at PATH into memory and return the mapping in *MM,
+   allocated in POOL.  Set *MM to NULL if the file does not exist, is
+   empty or won't fit comfortably into the address space. */
+static svn_error_t *
+map_file(apr_mmap_t **mm,
+         const char *path,
+         apr_pool_t *pool)
+{
+  apr_file_t *file;
+  apr_finfo_t finfo;
+  apr_status_t status;
+  svn_error_t *err;
+
+  *mm = NULL;
+
+  err = svn_io_file_open(&file, path, APR_READ, APR_OS_DEFAULT, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, file, pool));
+
+  /* Mapping fails for empty files.  Leave at least 3/4 of the address
+     space to other uses. */
+  if (finfo.size > 0 && (apr_uint64_t)finfo.size < APR_SIZE_MAX / 4)
+    {
+      status = apr_mmap_create(mm, file, 0, (apr_size_t) finfo.size,
+                               APR_MMAP_READ, pool);
+
+      /* Memory mapping is an optimization only.  Fall back to normal
+         file I/O if it fails. */
+      if (status != APR_SUCCESS)
+        *mm = NULL;
+    }
+
+  /* The mapping remains valid after the file has been closed. */
+  return svn_io_file_close(file, pool);
+}
+#endif
+
+/* If FS has been configured to use memory mapped I/O, set *MM to the
+   mapping of the pack file containing REV; otherwise, or if the file
+   cannot be mapped, set it to NULL.  The mappings are shared by all
+   users of FS.  REV must be a packed revision.  Use POOL for temporary
+   allocations. */
+static svn_error_t *
+get_pack_mmap(apr_mmap_t **mm,
+              svn_fs_t *fs,
+              svn_revnum_t rev,
+              apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  *mm = NULL;
+
+#if APR_HAS_MMAP
+  if (ffd->use_mmap)
+    {
+      apr_int64_t shard = rev / ffd->max_files_per_dir;
+
+      if (ffd->pack_mmaps == NULL)
+        ffd->pack_mmaps = apr_hash_make(fs->pool);
+
+      *mm = apr_hash_get(ffd->pack_mmaps, &shard, sizeof(shard));
+      if (*mm == NULL)
+        {
+          SVN_ERR(map_file(mm, path_rev_packed(fs, rev, "pack", pool),
+                           fs->pool));
+          if (*mm)
+            apr_hash_set(ffd->pack_mmaps,
+                         apr_pmemdup(fs->pool, &shard, sizeof(shard)),
+                         sizeof(shard), *mm);
+        }
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *STREAM to a read-only stream over the data in MM, starting at
+   OFFSET.  Return SVN_ERR_FS_CORRUPT if OFFSET is outside the mapped
+   data.  Allocate the stream in POOL. */
+static svn_error_t *
+stream_from_mmap(svn_stream_t **stream,
+                 apr_mmap_t *mm,
+                 apr_off_t offset,
+                 apr_pool_t *pool)
+{
+  svn_string_t *data;
+
+  if (offset < 0 || (apr_uint64_t)offset >= mm->size)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Offset beyond the end of the pack file"));
+
+  /* Don't copy anything; just point into the mapped memory. */
+  data = apr_palloc(pool, sizeof(*data));
+  data->data = (const char *)mm->mm + offset;
+  data->len = mm->size - (apr_size_t)offset;
+
+  *stream = svn_stream_from_string(data, pool);
+  return SVN_NO_ERROR;
+}
+
+/* Read the COUNT big-endian values stored for REV in the binary index
+   file INDEX_NAME of REV's pack directory in FS into VALUES.  Every
+   revision in such an index has an entry of COUNT values.  Set *FOUND to
+   FALSE if the shard has been packed without that index.  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+read_pack_index(apr_uint64_t *values,
+                apr_size_t count,
+                svn_boolean_t *found,
+                svn_fs_t *fs,
+                svn_revnum_t rev,
+                const char *index_name,
+                apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  unsigned char buffer[2 * MANIFEST_INDEX_ENTRY_SIZE];
+  apr_size_t entry_size = count * MANIFEST_INDEX_ENTRY_SIZE;
+  apr_file_t *file;
+  apr_off_t offset;
+  apr_size_t i, k;
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(entry_size <= sizeof(buffer));
+
+  err = svn_io_file_open(&file, path_rev_packed(fs, rev, index_name, pool),
+                         APR_READ, APR_OS_DEFAULT, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *found = FALSE;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* All entries have the same size, so we can go straight to ours. */
+  offset = (apr_off_t)(rev % ffd->max_files_per_dir) * entry_size;
+  err = svn_io_file_seek(file, APR_SET, &offset, pool);
+  if (! err)
+    err = svn_io_file_read_full(file, buffer, entry_size, NULL, pool);
+  if (err && APR_STATUS_IS_EOF(err->apr_err))
+    err = svn_error_createf(SVN_ERR_FS_CORRUPT, err,
+                            _("Index '%s' lacks revision %ld"),
+                            index_name, rev);
+  SVN_ERR(svn_error_compose_create(err, svn_io_file_close(file, pool)));
+
+  for (k = 0; k < count; ++k)
+    {
+      values[k] = 0;
+      for (i = 0; i < MANIFEST_INDEX_ENTRY_SIZE; ++i)
+        values[k] = (values[k] << 8)
+                  + buffer[k * MANIFEST_INDEX_ENTRY_SIZE + i];
+    }
+
+  *found = TRUE;
+  return SVN_NO_ERROR;
+}
+
 /* Given REV in FS, set *REV_OFFSET to REV's offset in the packed file.
    Use POOL for temporary allocations. */
 static svn_error_t *
@@ -1823,6 +2724,7 @@ get_packed_offset(apr_off_t *rev_offset,
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_stream_t *manifest_stream;
   svn_boolean_t is_cached;
+  apr_uint64_t value;
   apr_int64_t shard;
   apr_array_header_t *manifest;
   apr_pool_t *iterpool;
@@ -1838,10 +2740,38 @@ get_packed_offset(apr_off_t *rev_offset,
       return SVN_NO_ERROR;
     }
 
-  /* Open the manifest file. */
-  SVN_ERR(svn_stream_open_readonly(&manifest_stream,
-                                   path_rev_packed(fs, rev, "manifest", pool),
-                                   pool, pool));
+  /* Shards packed with an index don't need any parsing or caching. */
+  SVN_ERR(read_pack_index(&value, 1, &is_cached, fs, rev,
+                          PATH_PACKED_MANIFEST_INDEX, pool));
+  if (is_cached)
+    {
+      *rev_offset = (apr_off_t)value;
+      return SVN_NO_ERROR;
+    }
+
+  /* Open the manifest file.  It gets read only once, so a temporary
+     mapping in POOL is sufficient. */
+#if APR_HAS_MMAP
+  if (ffd->use_mmap)
+    {
+      apr_mmap_t *mm;
+
+      SVN_ERR(map_file(&mm, path_rev_packed(fs, rev, "manifest", pool),
+                       pool));
+      if (mm)
+        SVN_ERR(stream_from_mmap(&manifest_stream, mm, 0, pool));
+      else
+        manifest_stream = NULL;
+    }
+  else
+#endif
+    manifest_stream = NULL;
+
+  if (manifest_stream == NULL)
+    SVN_ERR(svn_stream_open_readonly(&manifest_stream,
+                                     path_rev_packed(fs, rev, "manifest",
+                                                     pool),
+                                     pool, pool));
 
   /* While we're here, let's just read the entire manifest file into an array,
      so we can cache the entire thing. */
@@ -2045,12 +2975,69 @@ get_node_revision_body(node_revision_t **noderev_p,
                        const svn_fs_id_t *id,
                        apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   apr_file_t *revision_file;
   svn_error_t *err;
+  pair_cache_key_t key;
+
+  /* Node-revs of committed revisions are immutable; try the cache. */
+  if (! svn_fs_fs__id_is_txn(id))
+    {
+      svn_boolean_t found;
+
+      key.revision = svn_fs_fs__id_rev(id);
+      key.second = svn_fs_fs__id_offset(id);
+      SVN_ERR(svn_cache__get((void **) noderev_p, &found,
+                             ffd->node_revision_cache, &key, pool));
+      if (found)
+        return SVN_NO_ERROR;
+    }
+
+  /* Packed node-revs may be parsed directly from the mapped pack file. */
+  if (! svn_fs_fs__id_is_txn(id)
+      && is_packed_rev(fs, svn_fs_fs__id_rev(id)))
+    {
+      apr_mmap_t *mm;
 
-  if (svn_fs_fs__id_txn_id(id))
+      SVN_ERR(get_pack_mmap(&mm, fs, svn_fs_fs__id_rev(id), pool));
+      if (mm)
+        {
+          apr_off_t offset;
+          svn_stream_t *stream;
+
+          SVN_ERR(get_packed_offset(&offset, fs, svn_fs_fs__id_rev(id),
+                                    pool));
+          offset += svn_fs_fs__id_offset(id);
+
+          SVN_ERR(stream_from_mmap(&stream, mm, offset, pool));
+          SVN_ERR(svn_fs_fs__read_noderev(noderev_p, stream, pool));
+          return svn_cache__set(ffd->node_revision_cache, &key, *noderev_p,
+                                pool);
+        }
+    }
+
+  if (svn_fs_fs__id_is_txn(id))
     {
-      /* This is a transaction node-rev. */
+      const char *log_dir, *node_key;
+
+      /* This is a transaction node-rev.  It may live in the node log. */
+      SVN_ERR(get_txn_node_log(&log_dir, &node_key, fs, id, pool));
+      if (log_dir)
+        {
+          svn_stringbuf_t *contents;
+
+          SVN_ERR(svn_fs_fs__txn_log_read(&contents, fs, log_dir,
+                                          svn_fs_fs__txn_log_noderev,
+                                          node_key, pool));
+          if (! contents)
+            return svn_fs_fs__err_dangling_id(fs, id);
+
+          return svn_fs_fs__read_noderev(noderev_p,
+                                         svn_stream_from_stringbuf(contents,
+                                                                   pool),
+                                         pool);
+        }
+
       err = svn_io_file_open(&revision_file, path_txn_node_rev(fs, id, pool),
                              APR_READ | APR_BUFFERED, APR_OS_DEFAULT, pool);
     }
@@ -2074,10 +3061,16 @@ get_node_revision_body(node_revision_t **noderev_p,
       return svn_error_return(err);
     }
 
-  return svn_fs_fs__read_noderev(noderev_p,
-                                 svn_stream_from_aprfile2(revision_file, FALSE,
-                                                          pool),
-                                 pool);
+  SVN_ERR(svn_fs_fs__read_noderev(noderev_p,
+                                  svn_stream_from_aprfile2(revision_file,
+                                                           FALSE, pool),
+                                  pool));
+
+  if (! svn_fs_fs__id_is_txn(id))
+    SVN_ERR(svn_cache__set(ffd->node_revision_cache, &key, *noderev_p,
+                           pool));
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -2123,7 +3116,8 @@ svn_fs_fs__read_noderev(node_revision_t **noderev_p,
   if (value)
     {
       SVN_ERR(read_rep_offsets(&noderev->prop_rep, value,
-                               svn_fs_fs__id_txn_id(noderev->id), TRUE, pool));
+                               svn_fs_fs__id_txn_id(noderev->id, pool), TRUE,
+                               pool));
     }
 
   /* Get the data location. */
@@ -2131,7 +3125,7 @@ svn_fs_fs__read_noderev(node_revision_t **noderev_p,
   if (value)
     {
       SVN_ERR(read_rep_offsets(&noderev->data_rep, value,
-                               svn_fs_fs__id_txn_id(noderev->id),
+                               svn_fs_fs__id_txn_id(noderev->id, pool),
                                (noderev->kind == svn_node_dir), pool));
     }
 
@@ -2153,6 +3147,12 @@ svn_fs_fs__read_noderev(node_revision_t **noderev_p,
     noderev->predecessor_id = svn_fs_fs__id_parse(value, strlen(value),
                                                   pool);
 
+  /* Get the predecessor skip link. */
+  value = apr_hash_get(headers, HEADER_PREDSKIP, APR_HASH_KEY_STRING);
+  if (value)
+    noderev->predecessor_skip_id = svn_fs_fs__id_parse(value, strlen(value),
+                                                       pool);
+
   /* Get the copyroot. */
   value = apr_hash_get(headers, HEADER_COPYROOT, APR_HASH_KEY_STRING);
   if (value == NULL)
@@ -2235,6 +3235,37 @@ svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
   return svn_error_return(err);
 }
 
+svn_error_t *
+svn_fs_fs__get_ancestor(node_revision_t **ancestor_p,
+                        svn_fs_t *fs,
+                        node_revision_t *noderev,
+                        int count,
+                        apr_pool_t *pool)
+{
+  while (noderev->predecessor_count > count)
+    {
+      const svn_fs_id_t *next_id = noderev->predecessor_id;
+      int skip_count = noderev->predecessor_count
+                     & (noderev->predecessor_count - 1);
+
+      /* Take the skip link unless it would overshoot COUNT. */
+      if (noderev->predecessor_skip_id && skip_count >= count)
+        next_id = noderev->predecessor_skip_id;
+
+      if (! next_id)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Node-revision '%s' claims to have "
+                                   "predecessors but lists none"),
+                                 svn_fs_fs__id_unparse(noderev->id,
+                                                       pool)->data);
+
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, next_id, pool));
+    }
+
+  *ancestor_p = noderev;
+  return SVN_NO_ERROR;
+}
+
 
 /* Return a formatted string, compatible with filesystem format FORMAT,
    that represents the location of representation REP.  If
@@ -2293,6 +3324,11 @@ svn_fs_fs__write_noderev(svn_stream_t *outfile,
   SVN_ERR(svn_stream_printf(outfile, pool, HEADER_COUNT ": %d\n",
                             noderev->predecessor_count));
 
+  if (noderev->predecessor_skip_id)
+    SVN_ERR(svn_stream_printf(outfile, pool, HEADER_PREDSKIP ": %s\n",
+                              svn_fs_fs__id_unparse(
+                                noderev->predecessor_skip_id, pool)->data));
+
   if (noderev->data_rep)
     SVN_ERR(svn_stream_printf(outfile, pool, HEADER_TEXT ": %s\n",
                               representation_string(noderev->data_rep,
@@ -2348,14 +3384,30 @@ svn_fs_fs__put_node_revision(svn_fs_t *fs,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   apr_file_t *noderev_file;
-  const char *txn_id = svn_fs_fs__id_txn_id(id);
+  const char *log_dir, *node_key;
 
   noderev->is_fresh_txn_root = fresh_txn_root;
 
-  if (! txn_id)
+  if (! svn_fs_fs__id_is_txn(id))
     return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
                             _("Attempted to write to non-transaction"));
 
+  SVN_ERR(get_txn_node_log(&log_dir, &node_key, fs, id, pool));
+  if (log_dir)
+    {
+      svn_stringbuf_t *contents = svn_stringbuf_create("", pool);
+
+      SVN_ERR(svn_fs_fs__write_noderev(svn_stream_from_stringbuf(contents,
+                                                                 pool),
+                                       noderev, ffd->format,
+                                       svn_fs_fs__fs_supports_mergeinfo(fs),
+                                       pool));
+
+      return svn_fs_fs__txn_log_append(log_dir, svn_fs_fs__txn_log_noderev,
+                                       node_key, contents->data,
+                                       contents->len, pool);
+    }
+
   SVN_ERR(svn_io_file_open(&noderev_file, path_txn_node_rev(fs, id, pool),
                            APR_WRITE | APR_CREATE | APR_TRUNCATE
                            | APR_BUFFERED, APR_OS_DEFAULT, pool));
@@ -2370,18 +3422,6 @@ svn_fs_fs__put_node_revision(svn_fs_t *fs,
 }
 
 
-/* This structure is used to hold the information associated with a
-   REP line. */
-struct rep_args
-{
-  svn_boolean_t is_delta;
-  svn_boolean_t is_delta_vs_empty;
-
-  svn_revnum_t base_revision;
-  apr_off_t base_offset;
-  apr_size_t base_length;
-};
-
 /* Read the next line from file FILE and parse it as a text
    representation entry.  Return the parsed entry in *REP_ARGS_P.
    Perform all allocations in POOL. */
@@ -2400,6 +3440,7 @@ read_rep_line(struct rep_args **rep_args_p,
 
   rep_args = apr_pcalloc(pool, sizeof(*rep_args));
   rep_args->is_delta = FALSE;
+  rep_args->header_size = limit + 1;
 
   if (strcmp(buffer, REP_PLAIN) == 0)
     {
@@ -2482,59 +3523,26 @@ get_fs_id_at_offset(svn_fs_id_t **id_p,
 }
 
 
-/* Given an open revision file REV_FILE in FS for REV, locate the trailer that
-   specifies the offset to the root node-id and to the changed path
-   information.  Store the root node offset in *ROOT_OFFSET and the
-   changed path offset in *CHANGES_OFFSET.  If either of these
-   pointers is NULL, do nothing with it.  If PACKED is true, REV_FILE
-   should be a packed shard file.  Allocate temporary variables from POOL. */
+/* Read the trailer of the revision that ends at offset END within the
+   open file REV_FILE and store the root node offset it specifies in
+   *ROOT_OFFSET and the changed path offset in *CHANGES_OFFSET.  Both are
+   relative to the start of that revision.  If either of these pointers
+   is NULL, do nothing with it.  Allocate temporary variables from POOL. */
 static svn_error_t *
-get_root_changes_offset(apr_off_t *root_offset,
-                        apr_off_t *changes_offset,
-                        apr_file_t *rev_file,
-                        svn_fs_t *fs,
-                        svn_revnum_t rev,
-                        apr_pool_t *pool)
+read_revision_trailer(apr_off_t *root_offset,
+                      apr_off_t *changes_offset,
+                      apr_file_t *rev_file,
+                      apr_off_t end,
+                      apr_pool_t *pool)
 {
-  fs_fs_data_t *ffd = fs->fsap_data;
   apr_off_t offset;
-  apr_off_t rev_offset;
   char buf[64];
   int i, num_bytes;
   apr_size_t len;
-  apr_seek_where_t seek_relative;
-
-  /* Determine where to seek to in the file.
-
-     If we've got a pack file, we want to seek to the end of the desired
-     revision.  But we don't track that, so we seek to the beginning of the
-     next revision.
-
-     Unless the next revision is in a different file, in which case, we can
-     just seek to the end of the pack file -- just like we do in the
-     non-packed case. */
-  if (is_packed_rev(fs, rev) && ((rev + 1) % ffd->max_files_per_dir != 0))
-    {
-      SVN_ERR(get_packed_offset(&offset, fs, rev + 1, pool));
-      seek_relative = APR_SET;
-    }
-  else
-    {
-      seek_relative = APR_END;
-      offset = 0;
-    }
-
-  /* Offset of the revision from the start of the pack file, if applicable. */
-  if (is_packed_rev(fs, rev))
-    SVN_ERR(get_packed_offset(&rev_offset, fs, rev, pool));
-  else
-    rev_offset = 0;
 
   /* We will assume that the last line containing the two offsets
      will never be longer than 64 characters. */
-  SVN_ERR(svn_io_file_seek(rev_file, seek_relative, &offset, pool));
-
-  offset -= sizeof(buf);
+  offset = end - sizeof(buf);
   SVN_ERR(svn_io_file_seek(rev_file, APR_SET, &offset, pool));
 
   /* Read in this last block, from which we will identify the last line. */
@@ -2568,7 +3576,7 @@ get_root_changes_offset(apr_off_t *root_offset,
   i++;
 
   if (root_offset)
-    *root_offset = rev_offset + apr_atoi64(&buf[i]);
+    *root_offset = apr_atoi64(&buf[i]);
 
   /* find the next space */
   for ( ; i < (num_bytes - 2) ; i++)
@@ -2583,7 +3591,61 @@ get_root_changes_offset(apr_off_t *root_offset,
   /* note that apr_atoi64() will stop reading as soon as it encounters
      the final newline. */
   if (changes_offset)
-    *changes_offset = rev_offset + apr_atoi64(&buf[i]);
+    *changes_offset = apr_atoi64(&buf[i]);
+
+  return SVN_NO_ERROR;
+}
+
+/* Given an open revision file REV_FILE in FS for REV, locate the trailer that
+   specifies the offset to the root node-id and to the changed path
+   information.  Store the root node offset in *ROOT_OFFSET and the
+   changed path offset in *CHANGES_OFFSET.  If either of these
+   pointers is NULL, do nothing with it.  If PACKED is true, REV_FILE
+   should be a packed shard file.  Allocate temporary variables from POOL. */
+static svn_error_t *
+get_root_changes_offset(apr_off_t *root_offset,
+                        apr_off_t *changes_offset,
+                        apr_file_t *rev_file,
+                        svn_fs_t *fs,
+                        svn_revnum_t rev,
+                        apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_off_t offset;
+  apr_off_t rev_offset;
+
+  /* Determine where to seek to in the file.
+
+     If we've got a pack file, we want to seek to the end of the desired
+     revision.  But we don't track that, so we seek to the beginning of the
+     next revision.
+
+     Unless the next revision is in a different file, in which case, we can
+     just seek to the end of the pack file -- just like we do in the
+     non-packed case. */
+  if (is_packed_rev(fs, rev) && ((rev + 1) % ffd->max_files_per_dir != 0))
+    {
+      SVN_ERR(get_packed_offset(&offset, fs, rev + 1, pool));
+    }
+  else
+    {
+      offset = 0;
+      SVN_ERR(svn_io_file_seek(rev_file, APR_END, &offset, pool));
+    }
+
+  /* Offset of the revision from the start of the pack file, if applicable. */
+  if (is_packed_rev(fs, rev))
+    SVN_ERR(get_packed_offset(&rev_offset, fs, rev, pool));
+  else
+    rev_offset = 0;
+
+  SVN_ERR(read_revision_trailer(root_offset, changes_offset, rev_file,
+                                offset, pool));
+
+  if (root_offset)
+    *root_offset += rev_offset;
+  if (changes_offset)
+    *changes_offset += rev_offset;
 
   return SVN_NO_ERROR;
 }
@@ -2725,19 +3787,76 @@ set_revision_proplist(svn_fs_t *fs,
   return svn_error_return(svn_sqlite__insert(NULL, stmt));
 }
 
+/* Read the revision property list of revision REV in FS into
+   *PROPLIST_P, allocated in POOL.
+
+   If USE_CACHE is TRUE, try FS's revprop cache first.  Revprops may be
+   changed by any process, so a cached list is only used if the file it
+   has been read from still has the same inode, size and mtime and if no
+   revprop change happened in this process since, i.e. the revprop
+   generation is still the same.  Lists read from files modified too
+   recently for their mtime to tell are not cached. */
 static svn_error_t *
 revision_proplist(apr_hash_t **proplist_p,
                   svn_fs_t *fs,
                   svn_revnum_t rev,
+                  svn_boolean_t use_cache,
                   apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   apr_hash_t *proplist;
+  svn_boolean_t packed;
+  svn_atomic_t generation = 0;
+  apr_time_t now = 0;
+  apr_finfo_t finfo;
 
   SVN_ERR(ensure_revision_exists(fs, rev, pool));
 
-  if (ffd->format < SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT ||
-      rev >= ffd->min_unpacked_revprop)
+  packed = ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT
+           && rev < ffd->min_unpacked_revprop;
+
+  /* As in get_youngest_shared(), take the generation and the stamp
+     before reading, such that we can at worst cache an outdated stamp
+     but never outdated properties. */
+  if (use_cache)
+    {
+      svn_fs_fs__cached_revprops_t *cached;
+      svn_boolean_t found;
+      const char *path = packed
+        ? svn_dirent_join_many(pool, fs->path, PATH_REVPROPS_DIR,
+                               PATH_REVPROPS_DB, NULL)
+        : path_revprops(fs, rev, pool);
+      svn_error_t *err;
+
+      generation = svn_atomic_read(&ffd->shared->revprop_generation);
+      now = apr_time_now();
+      err = svn_io_stat(&finfo, path,
+                        APR_FINFO_IDENT | APR_FINFO_SIZE | APR_FINFO_MTIME,
+                        pool);
+      if (err)
+        {
+          /* Let the code below report or recover from the problem. */
+          svn_error_clear(err);
+          use_cache = FALSE;
+        }
+      else
+        {
+          SVN_ERR(svn_cache__get((void **)&cached, &found,
+                                 ffd->revprop_cache, &rev, pool));
+          if (found
+              && cached->generation == generation
+              && cached->inode == finfo.inode
+              && cached->device == finfo.device
+              && cached->size == finfo.size
+              && cached->mtime == finfo.mtime)
+            {
+              *proplist_p = cached->proplist;
+              return SVN_NO_ERROR;
+            }
+        }
+    }
+
+  if (! packed)
     {
       apr_file_t *revprop_file = NULL;
       svn_error_t *err = SVN_NO_ERROR;
@@ -2807,20 +3926,36 @@ revision_proplist(apr_hash_t **proplist_p,
       SVN_ERR(svn_sqlite__reset(stmt));
     }
 
+  if (use_cache && finfo.mtime + CURRENT_MTIME_SLACK < now)
+    {
+      svn_fs_fs__cached_revprops_t revprops;
+
+      revprops.proplist = proplist;
+      revprops.inode = finfo.inode;
+      revprops.device = finfo.device;
+      revprops.size = finfo.size;
+      revprops.mtime = finfo.mtime;
+      revprops.generation = generation;
+      SVN_ERR(svn_cache__set(ffd->revprop_cache, &rev, &revprops, pool));
+    }
+
   *proplist_p = proplist;
 
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_fs__revision_proplist(apr_hash_t **proplist_p,
-                             svn_fs_t *fs,
-                             svn_revnum_t rev,
-                             apr_pool_t *pool)
+/* Like svn_fs_fs__revision_proplist(), but use FS's revprop cache only
+   if USE_CACHE is TRUE. */
+static svn_error_t *
+get_revision_proplist(apr_hash_t **proplist_p,
+                      svn_fs_t *fs,
+                      svn_revnum_t rev,
+                      svn_boolean_t use_cache,
+                      apr_pool_t *pool)
 {
   svn_error_t *err;
 
-  err = revision_proplist(proplist_p, fs, rev, pool);
+  err = revision_proplist(proplist_p, fs, rev, use_cache, pool);
   if (err && err->apr_err == SVN_ERR_FS_NO_SUCH_REVISION)
     {
       /* If a pack is occurring simultaneously, the min-unpacked-revprop value
@@ -2828,7 +3963,7 @@ svn_fs_fs__revision_proplist(apr_hash_t **proplist_p,
          again. */
       svn_error_clear(err);
       SVN_ERR(update_min_unpacked_revprop(fs, pool));
-      SVN_ERR(revision_proplist(proplist_p, fs, rev, pool));
+      SVN_ERR(revision_proplist(proplist_p, fs, rev, use_cache, pool));
     }
   else if (err)
     return svn_error_return(err);
@@ -2836,6 +3971,16 @@ svn_fs_fs__revision_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__revision_proplist(apr_hash_t **proplist_p,
+                             svn_fs_t *fs,
+                             svn_revnum_t rev,
+                             apr_pool_t *pool)
+{
+  return svn_error_return(get_revision_proplist(proplist_p, fs, rev, TRUE,
+                                                pool));
+}
+
 /* Represents where in the current svndiff data block each
    representation is. */
 struct rep_state
@@ -2847,6 +3992,9 @@ struct rep_state
   apr_off_t end;    /* The end offset of the raw data. */
   int ver;          /* If a delta, what svndiff version? */
   int chunk_index;
+  svn_revnum_t revision;  /* The rep's location, used for cache keys. */
+  apr_off_t offset;
+  svn_boolean_t is_mutable;  /* If set, its windows must not be cached. */
 };
 
 /* See create_rep_state, which wraps this and adds another error. */
@@ -2857,11 +4005,45 @@ create_rep_state_body(struct rep_state **rep_state,
                       svn_fs_t *fs,
                       apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   struct rep_state *rs = apr_pcalloc(pool, sizeof(*rs));
   struct rep_args *ra;
   unsigned char buf[4];
+  pair_cache_key_t key;
+  svn_boolean_t found = FALSE;
 
   SVN_ERR(open_and_seek_representation(&rs->file, fs, rep, pool));
+  rs->revision = rep->revision;
+  rs->offset = rep->offset;
+  rs->is_mutable = rep->txn_id != NULL;
+
+  /* Headers of committed reps are immutable and may have been parsed
+   * before.  In that case, skip them and the svndiff version tag. */
+  key.revision = rep->revision;
+  key.second = rep->offset;
+  if (! rep->txn_id)
+    SVN_ERR(svn_cache__get((void **) &ra, &found, ffd->rep_header_cache,
+                           &key, pool));
+
+  if (found)
+    {
+      SVN_ERR(get_file_offset(&rs->start, rs->file, pool));
+      rs->start += ra->header_size;
+      rs->off = rs->start;
+      rs->end = rs->start + rep->size;
+      *rep_state = rs;
+      *rep_args = ra;
+
+      if (ra->is_delta)
+        {
+          rs->ver = ra->svndiff_version;
+          rs->chunk_index = 0;
+          rs->off += 4;
+        }
+
+      return svn_io_file_seek(rs->file, APR_SET, &rs->off, pool);
+    }
+
   SVN_ERR(read_rep_line(&ra, rs->file, pool));
   SVN_ERR(get_file_offset(&rs->start, rs->file, pool));
   rs->off = rs->start;
@@ -2869,19 +4051,22 @@ create_rep_state_body(struct rep_state **rep_state,
   *rep_state = rs;
   *rep_args = ra;
 
-  if (ra->is_delta == FALSE)
-    /* This is a plaintext, so just return the current rep_state. */
-    return SVN_NO_ERROR;
+  if (ra->is_delta)
+    {
+      /* We are dealing with a delta, find out what version. */
+      SVN_ERR(svn_io_file_read_full(rs->file, buf, sizeof(buf), NULL, pool));
+      if (! ((buf[0] == 'S') && (buf[1] == 'V') && (buf[2] == 'N')))
+        return svn_error_create
+          (SVN_ERR_FS_CORRUPT, NULL,
+           _("Malformed svndiff data in representation"));
+      rs->ver = buf[3];
+      rs->chunk_index = 0;
+      rs->off += 4;
+      ra->svndiff_version = rs->ver;
+    }
 
-  /* We are dealing with a delta, find out what version. */
-  SVN_ERR(svn_io_file_read_full(rs->file, buf, sizeof(buf), NULL, pool));
-  if (! ((buf[0] == 'S') && (buf[1] == 'V') && (buf[2] == 'N')))
-    return svn_error_create
-      (SVN_ERR_FS_CORRUPT, NULL,
-       _("Malformed svndiff data in representation"));
-  rs->ver = buf[3];
-  rs->chunk_index = 0;
-  rs->off += 4;
+  if (! rep->txn_id)
+    SVN_ERR(svn_cache__set(ffd->rep_header_cache, &key, ra, pool));
 
   return SVN_NO_ERROR;
 }
@@ -2916,12 +4101,124 @@ create_rep_state(struct rep_state **rep_state,
   return svn_error_return(err);
 }
 
+#ifdef HAVE_POSIX_FADVISE
+/* A byte range of a revision or pack file that reading a delta chain
+   is going to touch. */
+typedef struct prefetch_range_t
+{
+  /* Identifies the file: the first revision in it. */
+  svn_revnum_t file_rev;
+
+  /* The range [START, END) within the file. */
+  apr_off_t start;
+  apr_off_t end;
+
+  /* Any handle on that file. */
+  apr_file_t *file;
+} prefetch_range_t;
+
+/* Ranges further apart than this are announced separately. */
+#define PREFETCH_GAP 0x10000
+
+/* Order prefetch_range_t elements by file, then by start offset. */
+static int
+compare_prefetch_ranges(const void *a, const void *b)
+{
+  const prefetch_range_t *lhs = a;
+  const prefetch_range_t *rhs = b;
+
+  if (lhs->file_rev != rhs->file_rev)
+    return lhs->file_rev < rhs->file_rev ? -1 : 1;
+  if (lhs->start != rhs->start)
+    return lhs->start < rhs->start ? -1 : 1;
+
+  return 0;
+}
+
+/* Add the data of the committed rep read through RS in FS to RANGES. */
+static void
+add_prefetch_range(apr_array_header_t *ranges,
+                   svn_fs_t *fs,
+                   struct rep_state *rs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  prefetch_range_t *range;
+
+  if (rs == NULL || rs->is_mutable || rs->end <= rs->start)
+    return;
+
+  range = apr_array_push(ranges);
+  range->file_rev = is_packed_rev(fs, rs->revision)
+                  ? rs->revision - rs->revision % ffd->max_files_per_dir
+                  : rs->revision;
+  range->start = rs->start;
+  range->end = rs->end;
+  range->file = rs->file;
+}
+
+/* Tell the OS that the data of all reps in LIST and SRC_STATE, as
+   returned by build_rep_list() for FS, is about to be read.  Ranges in
+   the same revision or pack file are merged where they are close to
+   each other.  This is only a hint; failures are ignored.  Use POOL for
+   temporary allocations. */
+static void
+prefetch_rep_list(apr_array_header_t *list,
+                  struct rep_state *src_state,
+                  svn_fs_t *fs,
+                  apr_pool_t *pool)
+{
+  apr_array_header_t *ranges;
+  prefetch_range_t *current = NULL;
+  int i;
+
+  ranges = apr_array_make(pool, list->nelts + 1, sizeof(prefetch_range_t));
+  for (i = 0; i < list->nelts; ++i)
+    add_prefetch_range(ranges, fs, APR_ARRAY_IDX(list, i,
+                                                 struct rep_state *));
+  add_prefetch_range(ranges, fs, src_state);
+
+  qsort(ranges->elts, ranges->nelts, ranges->elt_size,
+        compare_prefetch_ranges);
+
+  for (i = 0; i <= ranges->nelts; ++i)
+    {
+      prefetch_range_t *range = i < ranges->nelts
+                              ? &APR_ARRAY_IDX(ranges, i, prefetch_range_t)
+                              : NULL;
+
+      if (current && range && range->file_rev == current->file_rev
+          && range->start <= current->end + PREFETCH_GAP)
+        {
+          if (range->end > current->end)
+            current->end = range->end;
+          continue;
+        }
+
+      if (current)
+        {
+          apr_os_file_t fd;
+
+          if (apr_os_file_get(&fd, current->file) == APR_SUCCESS)
+            (void) posix_fadvise(fd, current->start,
+                                 current->end - current->start,
+                                 POSIX_FADV_WILLNEED);
+        }
+
+      current = range;
+    }
+}
+#endif
+
 /* Build an array of rep_state structures in *LIST giving the delta
    reps from first_rep to a plain-text or self-compressed rep.  Set
    *SRC_STATE to the plain-text rep we find at the end of the chain,
    or to NULL if the final delta representation is self-compressed.
    The representation to start from is designated by filesystem FS, id
-   ID, and representation REP. */
+   ID, and representation REP.
+
+   Once the whole chain is known and if FS is configured to do so, the
+   data ranges of its members are announced to the OS, so that they
+   can be fetched before the deltas get combined. */
 static svn_error_t *
 build_rep_list(apr_array_header_t **list,
                struct rep_state **src_state,
@@ -2932,6 +4229,9 @@ build_rep_list(apr_array_header_t **list,
   representation_t rep;
   struct rep_state *rs;
   struct rep_args *rep_args;
+#ifdef HAVE_POSIX_FADVISE
+  fs_fs_data_t *ffd = fs->fsap_data;
+#endif
 
   *list = apr_array_make(pool, 1, sizeof(struct rep_state *));
   rep = *first_rep;
@@ -2943,7 +4243,7 @@ build_rep_list(apr_array_header_t **list,
         {
           /* This is a plaintext, so just return the current rep_state. */
           *src_state = rs;
-          return SVN_NO_ERROR;
+          break;
         }
 
       /* Push this rep onto the list.  If it's self-compressed, we're done. */
@@ -2951,7 +4251,7 @@ build_rep_list(apr_array_header_t **list,
       if (rep_args->is_delta_vs_empty)
         {
           *src_state = NULL;
-          return SVN_NO_ERROR;
+          break;
         }
 
       rep.revision = rep_args->base_revision;
@@ -2959,8 +4259,16 @@ build_rep_list(apr_array_header_t **list,
       rep.size = rep_args->base_length;
       rep.txn_id = NULL;
     }
-}
 
+#ifdef HAVE_POSIX_FADVISE
+  /* A single rep gets read right away; there is nothing to win. */
+  if (ffd->prefetch_delta_chains
+      && (*list)->nelts + (*src_state ? 1 : 0) > 1)
+    prefetch_rep_list(*list, *src_state, fs, pool);
+#endif
+
+  return SVN_NO_ERROR;
+}
 
 struct rep_read_baton
 {
@@ -3009,6 +4317,10 @@ struct rep_read_baton
   /* Pool used to store file handles and other data that is persistant
      for the entire stream read. */
   apr_pool_t *filehandle_pool;
+
+  /* Reused by all window compositions of this read, allocated in
+     FILEHANDLE_POOL on first use. */
+  svn_txdelta__compose_ctx_t *compose_ctx;
 };
 
 /* Create a rep_read_baton structure for node revision NODEREV in
@@ -3052,12 +4364,138 @@ rep_read_get_baton(struct rep_read_baton **rb_p,
   return SVN_NO_ERROR;
 }
 
+/* Look up the window at the current position of RS in CACHE.  If
+   found, set *WINDOW_P to it, allocated in POOL, and advance RS behind
+   it as if the window had been read.  Otherwise set *WINDOW_P to NULL.
+   CACHE may be NULL. */
+static svn_error_t *
+get_cached_window(svn_txdelta_window_t **window_p,
+                  svn_cache__t *cache,
+                  struct rep_state *rs,
+                  apr_pool_t *pool)
+{
+  svn_fs_fs__txdelta_cached_window_t *cached_window;
+  window_cache_key_t key;
+  svn_boolean_t found = FALSE;
+
+  *window_p = NULL;
+  if (cache == NULL || rs->is_mutable)
+    return SVN_NO_ERROR;
+
+  key.revision = rs->revision;
+  key.offset = rs->offset;
+  key.chunk_index = rs->chunk_index;
+  SVN_ERR(svn_cache__get((void **) &cached_window, &found, cache, &key,
+                         pool));
+  if (! found)
+    return SVN_NO_ERROR;
+
+  /* Skip the window's data in the rep file. */
+  *window_p = cached_window->window;
+  rs->chunk_index++;
+  rs->off = cached_window->end_offset;
+
+  return svn_io_file_seek(rs->file, APR_SET, &rs->off, pool);
+}
+
+/* Store WINDOW in CACHE as the window that ended just before the current
+   position of RS.  CACHE may be NULL.  Use POOL for temporaries. */
+static svn_error_t *
+set_cached_window(svn_cache__t *cache,
+                  svn_txdelta_window_t *window,
+                  struct rep_state *rs,
+                  apr_pool_t *pool)
+{
+  svn_fs_fs__txdelta_cached_window_t cached_window;
+  window_cache_key_t key;
+
+  if (cache == NULL || rs->is_mutable)
+    return SVN_NO_ERROR;
+
+  key.revision = rs->revision;
+  key.offset = rs->offset;
+  key.chunk_index = rs->chunk_index - 1;
+
+  cached_window.window = window;
+  cached_window.end_offset = rs->off;
+
+  return svn_cache__set(cache, &key, &cached_window, pool);
+}
+
+/* Look up the windows for chunk CHUNK of the first NREPS reps in RS_LIST
+   in CACHE with a single request, which saves round trips for remote
+   caches.  Set WINDOWS[i] to the window of the i-th rep or to NULL if it
+   is not in CACHE, and advance the states of the reps whose window was
+   found behind it, as get_cached_window would.  CACHE may be NULL.
+   Allocate the windows in POOL. */
+static svn_error_t *
+get_cached_windows(svn_txdelta_window_t **windows,
+                   svn_cache__t *cache,
+                   apr_array_header_t *rs_list,
+                   int nreps,
+                   int chunk,
+                   apr_pool_t *pool)
+{
+  window_cache_key_t *keys;
+  const void **key_ptrs;
+  void **values;
+  svn_boolean_t *found;
+  int *rep_index;
+  int i, nkeys = 0;
+
+  for (i = 0; i < nreps; i++)
+    windows[i] = NULL;
+  if (cache == NULL || nreps == 0)
+    return SVN_NO_ERROR;
+
+  keys = apr_palloc(pool, nreps * sizeof(*keys));
+  key_ptrs = apr_palloc(pool, nreps * sizeof(*key_ptrs));
+  values = apr_palloc(pool, nreps * sizeof(*values));
+  found = apr_palloc(pool, nreps * sizeof(*found));
+  rep_index = apr_palloc(pool, nreps * sizeof(*rep_index));
+
+  for (i = 0; i < nreps; i++)
+    {
+      struct rep_state *rs = APR_ARRAY_IDX(rs_list, i, struct rep_state *);
+
+      if (rs->is_mutable || rs->chunk_index > chunk)
+        continue;
+
+      keys[nkeys].revision = rs->revision;
+      keys[nkeys].offset = rs->offset;
+      keys[nkeys].chunk_index = chunk;
+      key_ptrs[nkeys] = &keys[nkeys];
+      rep_index[nkeys] = i;
+      nkeys++;
+    }
+
+  SVN_ERR(svn_cache__get_many(values, found, cache, key_ptrs, nkeys, pool));
+
+  for (i = 0; i < nkeys; i++)
+    if (found[i])
+      {
+        svn_fs_fs__txdelta_cached_window_t *cached_window = values[i];
+        struct rep_state *rs = APR_ARRAY_IDX(rs_list, rep_index[i],
+                                             struct rep_state *);
+
+        /* Skip this and all earlier windows of the rep. */
+        windows[rep_index[i]] = cached_window->window;
+        rs->chunk_index = chunk + 1;
+        rs->off = cached_window->end_offset;
+        SVN_ERR(svn_io_file_seek(rs->file, APR_SET, &rs->off, pool));
+      }
+
+  return SVN_NO_ERROR;
+}
+
 /* Skip forwards to THIS_CHUNK in REP_STATE and then read the next delta
-   window into *NWIN. */
+   window into *NWIN.  Decoded windows are taken from and added to the
+   txdelta window cache of FS. */
 static svn_error_t *
 read_window(svn_txdelta_window_t **nwin, int this_chunk, struct rep_state *rs,
-            apr_pool_t *pool)
+            svn_fs_t *fs, apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   svn_stream_t *stream;
 
   SVN_ERR_ASSERT(rs->chunk_index <= this_chunk);
@@ -3075,6 +4513,11 @@ read_window(svn_txdelta_window_t **nwin, int this_chunk, struct rep_state *rs,
                                   "representation"));
     }
 
+  /* Maybe, we have decoded this window before. */
+  SVN_ERR(get_cached_window(nwin, ffd->txdelta_window_cache, rs, pool));
+  if (*nwin)
+    return SVN_NO_ERROR;
+
   /* Read the next window. */
   stream = svn_stream_from_aprfile2(rs->file, TRUE, pool);
   SVN_ERR(svn_txdelta_read_svndiff_window(nwin, stream, rs->ver, pool));
@@ -3086,7 +4529,7 @@ read_window(svn_txdelta_window_t **nwin, int this_chunk, struct rep_state *rs,
                             _("Reading one svndiff window read beyond "
                               "the end of the representation"));
 
-  return SVN_NO_ERROR;
+  return set_cached_window(ffd->txdelta_window_cache, *nwin, rs, pool);
 }
 
 /* Get one delta window that is a result of combining all but the last deltas
@@ -3096,18 +4539,45 @@ static svn_error_t *
 get_combined_window(svn_txdelta_window_t **result,
                     struct rep_read_baton *rb)
 {
+  fs_fs_data_t *ffd = rb->fs->fsap_data;
   apr_pool_t *pool, *new_pool;
   int i;
-  svn_txdelta_window_t *window, *nwin;
-  struct rep_state *rs;
+  svn_txdelta_window_t *window, *nwin, **cached;
+  struct rep_state *rs, *first_rs;
 
   SVN_ERR_ASSERT(rb->rs_list->nelts >= 2);
 
   pool = svn_pool_create(rb->pool);
 
+  /* The combined window depends on the original rep and on the chunk
+     only, since all other reps in a committed delta chain are fixed.
+     The other reps' states may lag behind after a cache hit; read_window
+     will skip forward as needed. */
+  first_rs = APR_ARRAY_IDX(rb->rs_list, 0, struct rep_state *);
+  if (first_rs->chunk_index == rb->chunk_index)
+    {
+      SVN_ERR(get_cached_window(&window, ffd->combined_window_cache,
+                                first_rs, pool));
+      if (window)
+        {
+          *result = window;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* The windows to combine are known up front.  Fetch all of them that
+     are cached at once rather than asking the cache for one after the
+     other.  They must survive the pool cycling below; RB->POOL gets
+     cleared for every chunk. */
+  cached = apr_palloc(rb->pool, (rb->rs_list->nelts - 1) * sizeof(*cached));
+  SVN_ERR(get_cached_windows(cached, ffd->txdelta_window_cache,
+                             rb->rs_list, rb->rs_list->nelts - 1,
+                             rb->chunk_index, rb->pool));
+
   /* Read the next window from the original rep. */
-  rs = APR_ARRAY_IDX(rb->rs_list, 0, struct rep_state *);
-  SVN_ERR(read_window(&window, rb->chunk_index, rs, pool));
+  window = cached[0];
+  if (window == NULL)
+    SVN_ERR(read_window(&window, rb->chunk_index, first_rs, rb->fs, pool));
 
   /* Combine in the windows from the other delta reps, if needed. */
   for (i = 1; i < rb->rs_list->nelts - 1; i++)
@@ -3117,16 +4587,28 @@ get_combined_window(svn_txdelta_window_t **result,
 
       rs = APR_ARRAY_IDX(rb->rs_list, i, struct rep_state *);
 
-      SVN_ERR(read_window(&nwin, rb->chunk_index, rs, pool));
+      nwin = cached[i];
+      if (nwin == NULL)
+        SVN_ERR(read_window(&nwin, rb->chunk_index, rs, rb->fs, pool));
 
       /* Combine this window with the current one.  Cycle pools so that we
          only need to hold three windows at a time. */
+      if (rb->compose_ctx == NULL)
+        rb->compose_ctx = svn_txdelta__compose_ctx_create(rb->filehandle_pool);
+
       new_pool = svn_pool_create(rb->pool);
-      window = svn_txdelta_compose_windows(nwin, window, new_pool);
+      window = svn_txdelta__compose_windows(nwin, window, rb->compose_ctx,
+                                            new_pool);
       svn_pool_destroy(pool);
       pool = new_pool;
     }
 
+  /* Windows taken directly from the original rep are in the txdelta
+     window cache already. */
+  if (i > 1)
+    SVN_ERR(set_cached_window(ffd->combined_window_cache, window, first_rs,
+                              pool));
+
   *result = window;
   return SVN_NO_ERROR;
 }
@@ -3217,7 +4699,8 @@ get_contents(struct rep_read_baton *rb,
                  deltas in an old repository; it may be worth
                  considering whether or not this special case is still
                  needed in the future, though. */
-              SVN_ERR(read_window(&lwindow, rb->chunk_index, rs, rb->pool));
+              SVN_ERR(read_window(&lwindow, rb->chunk_index, rs, rb->fs,
+                                  rb->pool));
 
               if (lwindow->src_ops > 0)
                 {
@@ -3274,73 +4757,188 @@ get_contents(struct rep_read_baton *rb,
             }
           else
             {
-              rb->buf_len = lwindow->tview_len;
-              rb->buf = sbuf;
+              rb->buf_len = lwindow->tview_len;
+              rb->buf = sbuf;
+            }
+
+          rb->buf_pos = 0;
+        }
+    }
+
+  *len = cur - buf;
+
+  return SVN_NO_ERROR;
+}
+
+/* BATON is of type `rep_read_baton'; read the next *LEN bytes of the
+   representation and store them in *BUF.  Sum as we read and verify
+   the MD5 sum at the end. */
+static svn_error_t *
+rep_read_contents(void *baton,
+                  char *buf,
+                  apr_size_t *len)
+{
+  struct rep_read_baton *rb = baton;
+
+  /* Get the next block of data. */
+  SVN_ERR(get_contents(rb, buf, len));
+
+  if (rb->current_fulltext)
+    svn_stringbuf_appendbytes(rb->current_fulltext, buf, *len);
+
+  /* Perform checksumming.  We want to check the checksum as soon as
+     the last byte of data is read, in case the caller never performs
+     a short read, but we don't want to finalize the MD5 context
+     twice. */
+  if (!rb->checksum_finalized)
+    {
+      SVN_ERR(svn_checksum_update(rb->md5_checksum_ctx, buf, *len));
+      rb->off += *len;
+      if (rb->off == rb->len)
+        {
+          svn_checksum_t *md5_checksum;
+
+          rb->checksum_finalized = TRUE;
+          svn_checksum_final(&md5_checksum, rb->md5_checksum_ctx, rb->pool);
+          if (!svn_checksum_match(md5_checksum, rb->md5_checksum))
+            return svn_error_createf
+              (SVN_ERR_FS_CORRUPT, NULL,
+               apr_psprintf(rb->pool, "%s:\n%s\n%s\n",
+                            _("Checksum mismatch while reading representation"),
+                            _("   expected:  %s"),
+                            _("     actual:  %s")),
+               svn_checksum_to_cstring_display(rb->md5_checksum, rb->pool),
+               svn_checksum_to_cstring_display(md5_checksum, rb->pool));
+        }
+    }
+
+  if (rb->off == rb->len && rb->current_fulltext)
+    {
+      fs_fs_data_t *ffd = rb->fs->fsap_data;
+      SVN_ERR(svn_cache__set(ffd->fulltext_cache, rb->fulltext_cache_key,
+                             rb->current_fulltext, rb->pool));
+      rb->current_fulltext = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Skip the next *LEN bytes of the rep read through RB and set *LEN to
+   the number of bytes actually skipped.  Delta windows that lie
+   entirely within the skipped range are stepped over in the rep file
+   without being decoded, combined or applied. */
+static svn_error_t *
+skip_contents(struct rep_read_baton *rb,
+              apr_size_t *len)
+{
+  apr_size_t copy_len, remaining = *len;
+  struct rep_state *rs;
+
+  /* A plain text can simply be sought in. */
+  if (rb->rs_list->nelts == 0)
+    {
+      copy_len = remaining;
+      rs = rb->src_state;
+      if (((apr_off_t) copy_len) > rs->end - rs->off)
+        copy_len = (apr_size_t) (rs->end - rs->off);
+      rs->off += copy_len;
+      SVN_ERR(svn_io_file_seek(rs->file, APR_SET, &rs->off, rb->pool));
+      *len = copy_len;
+      return SVN_NO_ERROR;
+    }
+
+  while (remaining > 0)
+    {
+      if (rb->buf)
+        {
+          /* Drop buffered data from a previous chunk first. */
+          copy_len = rb->buf_len - rb->buf_pos;
+          if (copy_len > remaining)
+            copy_len = remaining;
+
+          rb->buf_pos += copy_len;
+          remaining -= copy_len;
+
+          if (rb->buf_pos == rb->buf_len)
+            {
+              svn_pool_clear(rb->pool);
+              rb->buf = NULL;
+            }
+        }
+      else
+        {
+          apr_off_t window_start;
+          apr_size_t tview_len;
+
+          rs = APR_ARRAY_IDX(rb->rs_list, 0, struct rep_state *);
+          if (rs->off == rs->end)
+            break;
+
+          /* Step over the next window of the original rep if all of its
+             output gets skipped.  The other reps of the chain catch up
+             in read_window() once data is read again. */
+          if (rs->chunk_index == rb->chunk_index)
+            {
+              window_start = rs->off;
+              SVN_ERR(svn_txdelta__skip_svndiff_window(&tview_len, rs->file,
+                                                       rs->ver, rb->pool));
+              if (tview_len <= remaining)
+                {
+                  SVN_ERR(get_file_offset(&rs->off, rs->file, rb->pool));
+                  if (rs->off > rs->end)
+                    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                            _("Reading one svndiff window "
+                                              "read beyond the end of the "
+                                              "representation"));
+                  rs->chunk_index++;
+                  rb->chunk_index++;
+                  remaining -= tview_len;
+                  continue;
+                }
+
+              SVN_ERR(svn_io_file_seek(rs->file, APR_SET, &window_start,
+                                       rb->pool));
             }
 
-          rb->buf_pos = 0;
+          /* The skip ends within this window; decode it as usual. */
+          {
+            apr_pool_t *scratch_pool = svn_pool_create(rb->filehandle_pool);
+            char *scratch = apr_palloc(scratch_pool, remaining);
+
+            copy_len = remaining;
+            SVN_ERR(get_contents(rb, scratch, &copy_len));
+            svn_pool_destroy(scratch_pool);
+            remaining -= copy_len;
+            if (copy_len == 0)
+              break;
+          }
         }
     }
 
-  *len = cur - buf;
+  *len -= remaining;
 
   return SVN_NO_ERROR;
 }
 
-/* BATON is of type `rep_read_baton'; read the next *LEN bytes of the
-   representation and store them in *BUF.  Sum as we read and verify
-   the MD5 sum at the end. */
+/* BATON is of type `rep_read_baton'; skip the next *LEN bytes of the
+   representation.  Skipped data cannot be checksummed, so the
+   verification of the full text is given up, as is caching it. */
 static svn_error_t *
-rep_read_contents(void *baton,
-                  char *buf,
-                  apr_size_t *len)
+rep_read_skip(void *baton,
+              apr_size_t *len)
 {
   struct rep_read_baton *rb = baton;
 
-  /* Get the next block of data. */
-  SVN_ERR(get_contents(rb, buf, len));
-
-  if (rb->current_fulltext)
-    svn_stringbuf_appendbytes(rb->current_fulltext, buf, *len);
-
-  /* Perform checksumming.  We want to check the checksum as soon as
-     the last byte of data is read, in case the caller never performs
-     a short read, but we don't want to finalize the MD5 context
-     twice. */
-  if (!rb->checksum_finalized)
-    {
-      SVN_ERR(svn_checksum_update(rb->md5_checksum_ctx, buf, *len));
-      rb->off += *len;
-      if (rb->off == rb->len)
-        {
-          svn_checksum_t *md5_checksum;
-
-          rb->checksum_finalized = TRUE;
-          svn_checksum_final(&md5_checksum, rb->md5_checksum_ctx, rb->pool);
-          if (!svn_checksum_match(md5_checksum, rb->md5_checksum))
-            return svn_error_createf
-              (SVN_ERR_FS_CORRUPT, NULL,
-               apr_psprintf(rb->pool, "%s:\n%s\n%s\n",
-                            _("Checksum mismatch while reading representation"),
-                            _("   expected:  %s"),
-                            _("     actual:  %s")),
-               svn_checksum_to_cstring_display(rb->md5_checksum, rb->pool),
-               svn_checksum_to_cstring_display(md5_checksum, rb->pool));
-        }
-    }
+  SVN_ERR(skip_contents(rb, len));
 
-  if (rb->off == rb->len && rb->current_fulltext)
-    {
-      fs_fs_data_t *ffd = rb->fs->fsap_data;
-      SVN_ERR(svn_cache__set(ffd->fulltext_cache, rb->fulltext_cache_key,
-                             rb->current_fulltext, rb->pool));
-      rb->current_fulltext = NULL;
-    }
+  rb->checksum_finalized = TRUE;
+  rb->current_fulltext = NULL;
+  rb->off += *len;
 
   return SVN_NO_ERROR;
 }
 
-
 /* Returns whether or not the expanded fulltext of the file is
  * cachable based on its size SIZE.  Specifically, if it will fit
  * into a memcached value.  The memcached cutoff seems to be a bit
@@ -3398,6 +4996,7 @@ read_representation(svn_stream_t **contents_p,
 
       *contents_p = svn_stream_create(rb, pool);
       svn_stream_set_read(*contents_p, rep_read_contents);
+      svn_stream_set_skip(*contents_p, rep_read_skip);
       svn_stream_set_close(*contents_p, rep_read_contents_close);
     }
 
@@ -3410,14 +5009,25 @@ svn_fs_fs__get_contents(svn_stream_t **contents_p,
                         node_revision_t *noderev,
                         apr_pool_t *pool)
 {
-  return read_representation(contents_p, fs, noderev->data_rep, pool);
+  apr_time_t start;
+  svn_error_t *err;
+
+  SVN_TRACE__BEGIN(fs_fs_get_contents, start);
+  err = read_representation(contents_p, fs, noderev->data_rep, pool);
+  SVN_TRACE__END(fs_fs_get_contents, start, fs->path);
+
+  return svn_error_return(err);
 }
 
 /* Baton used when reading delta windows. */
 struct delta_read_baton
 {
+  svn_fs_t *fs;
   struct rep_state *rs;
   svn_checksum_t *checksum;
+
+  /* The first window, if it has been read already but not returned. */
+  svn_txdelta_window_t *first_window;
 };
 
 /* This implements the svn_txdelta_next_window_fn_t interface. */
@@ -3427,13 +5037,20 @@ delta_read_next_window(svn_txdelta_window_t **window, void *baton,
 {
   struct delta_read_baton *drb = baton;
 
+  if (drb->first_window)
+    {
+      *window = drb->first_window;
+      drb->first_window = NULL;
+      return SVN_NO_ERROR;
+    }
+
   if (drb->rs->off == drb->rs->end)
     {
       *window = NULL;
       return SVN_NO_ERROR;
     }
 
-  return read_window(window, drb->rs->chunk_index, drb->rs, pool);
+  return read_window(window, drb->rs->chunk_index, drb->rs, drb->fs, pool);
 }
 
 /* This implements the svn_txdelta_md5_digest_fn_t interface. */
@@ -3475,196 +5092,517 @@ svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
         {
           /* Create the delta read baton. */
           struct delta_read_baton *drb = apr_pcalloc(pool, sizeof(*drb));
+          drb->fs = fs;
           drb->rs = rep_state;
           drb->checksum = svn_checksum_dup(target->data_rep->md5_checksum,
                                            pool);
-          *stream_p = svn_txdelta_stream_create(drb, delta_read_next_window,
-                                                delta_read_md5_digest, pool);
-          return SVN_NO_ERROR;
+
+          /* Windows larger than the default are not for everyone to
+             consume.  All windows but the last have the same size, so
+             looking at the first one tells. */
+          if (rep_state->off < rep_state->end)
+            SVN_ERR(read_window(&drb->first_window, rep_state->chunk_index,
+                                rep_state, fs, pool));
+
+          if (! drb->first_window
+              || (drb->first_window->tview_len
+                    <= SVN_DELTA_DEFAULT_WINDOW_SIZE
+                  && drb->first_window->sview_len
+                       <= SVN_DELTA_DEFAULT_WINDOW_SIZE))
+            {
+              *stream_p = svn_txdelta_stream_create(drb,
+                                                    delta_read_next_window,
+                                                    delta_read_md5_digest,
+                                                    pool);
+              return SVN_NO_ERROR;
+            }
         }
-      else
-        SVN_ERR(svn_io_file_close(rep_state->file, pool));
+
+      SVN_ERR(svn_io_file_close(rep_state->file, pool));
     }
 
-  /* Read both fulltexts and construct a delta. */
-  if (source)
-    SVN_ERR(read_representation(&source_stream, fs, source->data_rep, pool));
-  else
-    source_stream = svn_stream_empty(pool);
+  /* Without a source, e.g. for a checkout, the delta is the fulltext;
+     hand it out as is instead of running it through the delta code. */
   SVN_ERR(read_representation(&target_stream, fs, target->data_rep, pool));
+  if (! source)
+    {
+      *stream_p = svn_txdelta__fulltext_stream(target_stream,
+                                               SVN_DELTA_DEFAULT_WINDOW_SIZE,
+                                               pool);
+      return SVN_NO_ERROR;
+    }
+
+  /* Read the source fulltext as well and construct a delta. */
+  SVN_ERR(read_representation(&source_stream, fs, source->data_rep, pool));
   svn_txdelta(stream_p, source_stream, target_stream, pool);
 
   return SVN_NO_ERROR;
 }
 
 
-/* Fetch the contents of a directory into ENTRIES.  Values are stored
-   as filename to string mappings; further conversion is necessary to
-   convert them into svn_fs_dirent_t values. */
+static const char *
+unparse_dir_entry(svn_node_kind_t kind, const svn_fs_id_t *id,
+                  apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "%s %s",
+                      (kind == svn_node_file) ? KIND_FILE : KIND_DIR,
+                      svn_fs_fs__id_unparse(id, pool)->data);
+}
+
+/* Given a hash ENTRIES of dirent structions, return a hash in
+   *STR_ENTRIES_P, that has svn_string_t as the values in the format
+   specified by the fs_fs directory contents file.  Perform
+   allocations in POOL. */
 static svn_error_t *
-get_dir_contents(apr_hash_t *entries,
-                 svn_fs_t *fs,
-                 node_revision_t *noderev,
-                 apr_pool_t *pool)
+unparse_dir_entries(apr_hash_t **str_entries_p,
+                    apr_hash_t *entries,
+                    apr_pool_t *pool)
 {
-  svn_stream_t *contents;
+  apr_hash_index_t *hi;
 
-  if (noderev->data_rep && noderev->data_rep->txn_id)
+  *str_entries_p = apr_hash_make(pool);
+
+  for (hi = apr_hash_first(pool, entries); hi; hi = apr_hash_next(hi))
     {
-      const char *filename = path_txn_node_children(fs, noderev->id, pool);
+      const void *key;
+      apr_ssize_t klen;
+      svn_fs_dirent_t *dirent = svn__apr_hash_index_val(hi);
+      const char *new_val;
 
-      /* The representation is mutable.  Read the old directory
-         contents from the mutable children file, followed by the
-         changes we've made in this transaction. */
-      SVN_ERR(svn_stream_open_readonly(&contents, filename, pool, pool));
-      SVN_ERR(svn_hash_read2(entries, contents, SVN_HASH_TERMINATOR, pool));
-      SVN_ERR(svn_hash_read_incremental(entries, contents, NULL, pool));
-      SVN_ERR(svn_stream_close(contents));
+      apr_hash_this(hi, &key, &klen, NULL);
+      new_val = unparse_dir_entry(dirent->kind, dirent->id, pool);
+      apr_hash_set(*str_entries_p, key, klen,
+                   svn_string_create(new_val, pool));
     }
-  else if (noderev->data_rep)
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Given a hash STR_ENTRIES with values as svn_string_t as specified
+   in an FSFS directory contents listing, return a hash of dirents in
+   *ENTRIES_P.  Perform allocations in POOL. */
+static svn_error_t *
+parse_dir_entries(apr_hash_t **entries_p,
+                  apr_hash_t *str_entries,
+                  apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+
+  *entries_p = apr_hash_make(pool);
+
+  /* Translate the string dir entries into real entries. */
+  for (hi = apr_hash_first(pool, str_entries); hi; hi = apr_hash_next(hi))
     {
-      /* The representation is immutable.  Read it normally. */
-      SVN_ERR(read_representation(&contents, fs, noderev->data_rep, pool));
-      SVN_ERR(svn_hash_read2(entries, contents, SVN_HASH_TERMINATOR, pool));
-      SVN_ERR(svn_stream_close(contents));
+      const char *name = svn__apr_hash_index_key(hi);
+      svn_string_t *str_val = svn__apr_hash_index_val(hi);
+      char *str, *last_str;
+      svn_fs_dirent_t *dirent = apr_pcalloc(pool, sizeof(*dirent));
+
+      str = apr_pstrdup(pool, str_val->data);
+      dirent->name = apr_pstrdup(pool, name);
+
+      str = apr_strtok(str, " ", &last_str);
+      if (str == NULL)
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Directory entry corrupt"));
+
+      if (strcmp(str, KIND_FILE) == 0)
+        {
+          dirent->kind = svn_node_file;
+        }
+      else if (strcmp(str, KIND_DIR) == 0)
+        {
+          dirent->kind = svn_node_dir;
+        }
+      else
+        {
+          return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                  _("Directory entry corrupt"));
+        }
+
+      str = apr_strtok(NULL, " ", &last_str);
+      if (str == NULL)
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Directory entry corrupt"));
+
+      dirent->id = svn_fs_fs__id_parse(str, strlen(str), pool);
+
+      apr_hash_set(*entries_p, dirent->name, APR_HASH_KEY_STRING, dirent);
     }
 
   return SVN_NO_ERROR;
 }
 
+/* Directory representations in the binary format used since
+   SVN_FS_FS__MIN_BINARY_DIR_FORMAT begin with this magic.  Hash dumps
+   always begin with "K " or "END", so both formats can be told apart
+   by their contents alone.  See the structure file for details. */
+#define BINARY_DIR_MAGIC "\0DIR"
+#define BINARY_DIR_MAGIC_LEN 4
 
-static const char *
-unparse_dir_entry(svn_node_kind_t kind, const svn_fs_id_t *id,
-                  apr_pool_t *pool)
+/* Size of the integers used in binary directory representations. */
+#define BINARY_DIR_INT_SIZE 4
+
+/* Directories with representations larger than this will be cached as
+   they are in the binary directory cache and searched for single entries
+   in-place, rather than being parsed and cached as a whole. */
+#define BINARY_DIR_SEARCH_THRESHOLD 0x10000
+
+/* Store VALUE as big-endian, BINARY_DIR_INT_SIZE integer at BYTES. */
+static void
+encode_dir_int(char *bytes,
+               apr_uint32_t value)
 {
-  return apr_psprintf(pool, "%s %s",
-                      (kind == svn_node_file) ? KIND_FILE : KIND_DIR,
-                      svn_fs_fs__id_unparse(id, pool)->data);
+  int i;
+
+  for (i = BINARY_DIR_INT_SIZE - 1; i >= 0; --i)
+    {
+      bytes[i] = (char)(value & 0xff);
+      value >>= 8;
+    }
 }
 
-/* Given a hash ENTRIES of dirent structions, return a hash in
-   *STR_ENTRIES_P, that has svn_string_t as the values in the format
-   specified by the fs_fs directory contents file.  Perform
-   allocations in POOL. */
+/* Append VALUE to BUFFER as big-endian, BINARY_DIR_INT_SIZE integer. */
+static void
+append_dir_int(svn_stringbuf_t *buffer,
+               apr_uint32_t value)
+{
+  char bytes[BINARY_DIR_INT_SIZE];
+
+  encode_dir_int(bytes, value);
+  svn_stringbuf_appendbytes(buffer, bytes, sizeof(bytes));
+}
+
+/* Return the big-endian integer stored at DATA. */
+static apr_uint32_t
+decode_dir_int(const char *data)
+{
+  const unsigned char *bytes = (const unsigned char *)data;
+  apr_uint32_t value = 0;
+  int i;
+
+  for (i = 0; i < BINARY_DIR_INT_SIZE; ++i)
+    value = (value << 8) + bytes[i];
+
+  return value;
+}
+
+/* Return TRUE, if the LEN bytes of directory contents at DATA are in
+   the binary format. */
+static svn_boolean_t
+is_binary_dir(const char *data,
+              apr_size_t len)
+{
+  return len >= BINARY_DIR_MAGIC_LEN + BINARY_DIR_INT_SIZE
+      && memcmp(data, BINARY_DIR_MAGIC, BINARY_DIR_MAGIC_LEN) == 0;
+}
+
+/* Set *DATA_P to the binary representation of the hash ENTRIES of
+   dirents, allocated in POOL. */
+static svn_error_t *
+unparse_binary_dir(svn_stringbuf_t **data_p,
+                   apr_hash_t *entries,
+                   apr_pool_t *pool)
+{
+  apr_array_header_t *sorted;
+  svn_stringbuf_t *data;
+  apr_size_t table_offset;
+  int i;
+
+  /* Lexical order of the keys is strcmp() order for entry names. */
+  sorted = svn_sort__hash(entries, svn_sort_compare_items_lexically, pool);
+
+  data = svn_stringbuf_create_ensure(BINARY_DIR_MAGIC_LEN
+                                     + BINARY_DIR_INT_SIZE
+                                     + sorted->nelts * 64, pool);
+  svn_stringbuf_appendbytes(data, BINARY_DIR_MAGIC, BINARY_DIR_MAGIC_LEN);
+  append_dir_int(data, (apr_uint32_t)sorted->nelts);
+
+  /* Reserve the offset table; it gets filled in below. */
+  table_offset = data->len;
+  for (i = 0; i < sorted->nelts; ++i)
+    append_dir_int(data, 0);
+
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      svn_fs_dirent_t *dirent = item->value;
+      svn_string_t *id = svn_fs_fs__id_unparse(dirent->id, pool);
+      char kind = dirent->kind == svn_node_file ? KIND_FILE[0] : KIND_DIR[0];
+
+      if ((apr_uint64_t)data->len > APR_UINT32_MAX)
+        return svn_error_create(SVN_ERR_FS_GENERAL, NULL,
+                                _("Directory listing too large"));
+
+      /* Patch the table entry for this directory entry. */
+      encode_dir_int(data->data + table_offset + i * BINARY_DIR_INT_SIZE,
+                     (apr_uint32_t)data->len);
+
+      svn_stringbuf_appendbytes(data, &kind, 1);
+      svn_stringbuf_appendbytes(data, item->key, item->klen + 1);
+      svn_stringbuf_appendbytes(data, id->data, id->len + 1);
+    }
+
+  *data_p = data;
+  return SVN_NO_ERROR;
+}
+
+/* Return the number of entries in the binary directory DATA of LEN
+   bytes in *COUNT, making sure the offset table fits into DATA. */
+static svn_error_t *
+get_binary_dir_count(apr_size_t *count,
+                     const char *data,
+                     apr_size_t len)
+{
+  *count = decode_dir_int(data + BINARY_DIR_MAGIC_LEN);
+  if (*count > (len - BINARY_DIR_MAGIC_LEN - BINARY_DIR_INT_SIZE)
+               / BINARY_DIR_INT_SIZE)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Directory entry corrupt"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *NAME, *KIND and *ID to the respective parts of entry number IDX
+   in the binary directory DATA of LEN bytes.  The strings returned
+   point into DATA and are NUL-terminated. */
+static svn_error_t *
+get_binary_dir_entry(const char **name,
+                     svn_node_kind_t *kind,
+                     const char **id,
+                     const char *data,
+                     apr_size_t len,
+                     apr_size_t idx)
+{
+  const char *end = data + len;
+  const char *entry;
+  apr_size_t offset;
+
+  offset = decode_dir_int(data + BINARY_DIR_MAGIC_LEN + BINARY_DIR_INT_SIZE
+                          + idx * BINARY_DIR_INT_SIZE);
+  if (offset >= len)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Directory entry corrupt"));
+
+  entry = data + offset;
+  if (*entry == KIND_FILE[0])
+    *kind = svn_node_file;
+  else if (*entry == KIND_DIR[0])
+    *kind = svn_node_dir;
+  else
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Directory entry corrupt"));
+
+  *name = entry + 1;
+  entry = memchr(*name, '\0', end - *name);
+  if (entry == NULL || entry + 1 >= end)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Directory entry corrupt"));
+
+  *id = entry + 1;
+  if (memchr(*id, '\0', end - *id) == NULL)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Directory entry corrupt"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return in *DIRENT a dirent for NAME, KIND and ID, allocated in POOL. */
+static svn_error_t *
+create_dirent(svn_fs_dirent_t **dirent,
+              const char *name,
+              svn_node_kind_t kind,
+              const char *id,
+              apr_pool_t *pool)
+{
+  *dirent = apr_palloc(pool, sizeof(**dirent));
+  (*dirent)->name = apr_pstrdup(pool, name);
+  (*dirent)->kind = kind;
+  (*dirent)->id = svn_fs_fs__id_parse(id, strlen(id), pool);
+  if ((*dirent)->id == NULL)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Directory entry corrupt"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a hash of dirents in *ENTRIES_P for the binary directory DATA
+   of LEN bytes.  Perform allocations in POOL. */
 static svn_error_t *
-unparse_dir_entries(apr_hash_t **str_entries_p,
-                    apr_hash_t *entries,
-                    apr_pool_t *pool)
+parse_binary_dir(apr_hash_t **entries_p,
+                 const char *data,
+                 apr_size_t len,
+                 apr_pool_t *pool)
 {
-  apr_hash_index_t *hi;
+  apr_size_t count, i;
 
-  *str_entries_p = apr_hash_make(pool);
+  SVN_ERR(get_binary_dir_count(&count, data, len));
 
-  for (hi = apr_hash_first(pool, entries); hi; hi = apr_hash_next(hi))
+  *entries_p = apr_hash_make(pool);
+  for (i = 0; i < count; ++i)
     {
-      const void *key;
-      apr_ssize_t klen;
-      svn_fs_dirent_t *dirent = svn__apr_hash_index_val(hi);
-      const char *new_val;
+      const char *name, *id;
+      svn_node_kind_t kind;
+      svn_fs_dirent_t *dirent;
 
-      apr_hash_this(hi, &key, &klen, NULL);
-      new_val = unparse_dir_entry(dirent->kind, dirent->id, pool);
-      apr_hash_set(*str_entries_p, key, klen,
-                   svn_string_create(new_val, pool));
+      SVN_ERR(get_binary_dir_entry(&name, &kind, &id, data, len, i));
+      SVN_ERR(create_dirent(&dirent, name, kind, id, pool));
+      apr_hash_set(*entries_p, dirent->name, APR_HASH_KEY_STRING, dirent);
     }
 
   return SVN_NO_ERROR;
 }
 
-
-svn_error_t *
-svn_fs_fs__dir_entries_serialize(char **data,
-                                 apr_size_t *data_len,
-                                 void *in,
-                                 apr_pool_t *pool)
+/* Binary search the binary directory DATA of LEN bytes for the entry
+   called NAME and return it in *DIRENT, allocated in POOL.  Set *DIRENT
+   to NULL, if there is no such entry. */
+static svn_error_t *
+find_binary_dir_entry(svn_fs_dirent_t **dirent,
+                      const char *data,
+                      apr_size_t len,
+                      const char *name,
+                      apr_pool_t *pool)
 {
-  apr_hash_t *entries = in;
-  svn_stringbuf_t *buf = svn_stringbuf_create("", pool);
-  svn_stream_t *stream = svn_stream_from_stringbuf(buf, pool);
+  apr_size_t lower = 0;
+  apr_size_t upper;
+
+  SVN_ERR(get_binary_dir_count(&upper, data, len));
 
-  SVN_ERR(unparse_dir_entries(&entries, entries, pool));
-  SVN_ERR(svn_hash_write2(entries, stream, SVN_HASH_TERMINATOR, pool));
+  while (lower < upper)
+    {
+      apr_size_t middle = lower + (upper - lower) / 2;
+      const char *entry_name, *id;
+      svn_node_kind_t kind;
+      int diff;
 
-  *data = buf->data;
-  *data_len = buf->len;
+      SVN_ERR(get_binary_dir_entry(&entry_name, &kind, &id, data, len,
+                                   middle));
+      diff = strcmp(entry_name, name);
+      if (diff == 0)
+        return create_dirent(dirent, entry_name, kind, id, pool);
+
+      if (diff < 0)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
 
+  *dirent = NULL;
   return SVN_NO_ERROR;
 }
 
+/* Look up the entry called BATON, a const char *, in the binary
+   directory DATA of DATA_LEN bytes.  Implements
+   svn_cache__partial_getter_func_t for the binary directory cache. */
+static svn_error_t *
+extract_binary_dir_entry(void **out,
+                         const char *data,
+                         apr_size_t data_len,
+                         void *baton,
+                         apr_pool_t *pool)
+{
+  return find_binary_dir_entry((svn_fs_dirent_t **) out, data, data_len,
+                               baton, pool);
+}
 
-/* Given a hash STR_ENTRIES with values as svn_string_t as specified
-   in an FSFS directory contents listing, return a hash of dirents in
-   *ENTRIES_P.  Perform allocations in POOL. */
+/* Read the whole expanded contents of the immutable representation REP
+   in FS into *CONTENTS, allocated in POOL. */
 static svn_error_t *
-parse_dir_entries(apr_hash_t **entries_p,
-                  apr_hash_t *str_entries,
+read_rep_contents(svn_stringbuf_t **contents,
+                  svn_fs_t *fs,
+                  representation_t *rep,
                   apr_pool_t *pool)
 {
-  apr_hash_index_t *hi;
+  svn_stream_t *stream;
+  svn_filesize_t size = rep->expanded_size ? rep->expanded_size : rep->size;
 
-  *entries_p = apr_hash_make(pool);
+  SVN_ERR(read_representation(&stream, fs, rep, pool));
+  *contents = svn_stringbuf_create_ensure((apr_size_t)size + 1, pool);
 
-  /* Translate the string dir entries into real entries. */
-  for (hi = apr_hash_first(pool, str_entries); hi; hi = apr_hash_next(hi))
-    {
-      const char *name = svn__apr_hash_index_key(hi);
-      svn_string_t *str_val = svn__apr_hash_index_val(hi);
-      char *str, *last_str;
-      svn_fs_dirent_t *dirent = apr_pcalloc(pool, sizeof(*dirent));
+  return svn_stream_copy3(stream, svn_stream_from_stringbuf(*contents, pool),
+                          NULL, NULL, pool);
+}
 
-      str = apr_pstrdup(pool, str_val->data);
-      dirent->name = apr_pstrdup(pool, name);
+/* Given the contents DATA of an immutable directory representation in
+   either format, return a hash of dirents in *ENTRIES_P.  DATA gets
+   modified while parsing.  Perform allocations in POOL. */
+static svn_error_t *
+parse_dir_rep(apr_hash_t **entries_p,
+              svn_stringbuf_t *data,
+              apr_pool_t *pool)
+{
+  apr_hash_t *str_entries;
 
-      str = apr_strtok(str, " ", &last_str);
-      if (str == NULL)
-        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
-                                _("Directory entry corrupt"));
+  if (is_binary_dir(data->data, data->len))
+    return parse_binary_dir(entries_p, data->data, data->len, pool);
 
-      if (strcmp(str, KIND_FILE) == 0)
-        {
-          dirent->kind = svn_node_file;
-        }
-      else if (strcmp(str, KIND_DIR) == 0)
+  str_entries = apr_hash_make(pool);
+  SVN_ERR(svn_hash__parse(str_entries, data, SVN_HASH_TERMINATOR, pool));
+  return parse_dir_entries(entries_p, str_entries, pool);
+}
+
+/* Fetch the contents of the directory NODEREV in FS into *ENTRIES_P, a
+   hash mapping entry names to svn_fs_dirent_t.  Perform allocations in
+   POOL. */
+static svn_error_t *
+get_dir_contents(apr_hash_t **entries_p,
+                 svn_fs_t *fs,
+                 node_revision_t *noderev,
+                 apr_pool_t *pool)
+{
+  svn_stream_t *contents;
+
+  if (noderev->data_rep && noderev->data_rep->txn_id)
+    {
+      const char *log_dir, *node_key;
+      apr_hash_t *entries = apr_hash_make(pool);
+
+      /* The representation is mutable.  Read the old directory
+         contents from the mutable children file or the node log,
+         followed by the changes we've made in this transaction. */
+      SVN_ERR(get_txn_node_log(&log_dir, &node_key, fs, noderev->id, pool));
+      if (log_dir)
         {
-          dirent->kind = svn_node_dir;
+          svn_stringbuf_t *listing;
+
+          SVN_ERR(svn_fs_fs__txn_log_read(&listing, fs, log_dir,
+                                          svn_fs_fs__txn_log_children,
+                                          node_key, pool));
+          if (! listing)
+            return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                     _("Directory listing of node '%s' "
+                                       "missing from transaction"),
+                                     node_key);
+
+          contents = svn_stream_from_stringbuf(listing, pool);
         }
       else
-        {
-          return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
-                                  _("Directory entry corrupt"));
-        }
-
-      str = apr_strtok(NULL, " ", &last_str);
-      if (str == NULL)
-        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
-                                _("Directory entry corrupt"));
-
-      dirent->id = svn_fs_fs__id_parse(str, strlen(str), pool);
+        SVN_ERR(svn_stream_open_readonly(&contents,
+                                         path_txn_node_children(fs,
+                                                                noderev->id,
+                                                                pool),
+                                         pool, pool));
+      SVN_ERR(svn_hash_read2(entries, contents, SVN_HASH_TERMINATOR, pool));
+      SVN_ERR(svn_hash_read_incremental(entries, contents, NULL, pool));
+      SVN_ERR(svn_stream_close(contents));
 
-      apr_hash_set(*entries_p, dirent->name, APR_HASH_KEY_STRING, dirent);
+      return parse_dir_entries(entries_p, entries, pool);
     }
+  else if (noderev->data_rep)
+    {
+      svn_stringbuf_t *data;
 
-  return SVN_NO_ERROR;
-}
-
-svn_error_t *
-svn_fs_fs__dir_entries_deserialize(void **out,
-                                   const char *data,
-                                   apr_size_t data_len,
-                                   apr_pool_t *pool)
-{
-  apr_hash_t *entries = apr_hash_make(pool);
-  svn_stringbuf_t *buf = svn_stringbuf_ncreate(data, data_len, pool);
-  svn_stream_t *stream = svn_stream_from_stringbuf(buf, pool);
+      /* The representation is immutable.  Read it normally. */
+      SVN_ERR(read_rep_contents(&data, fs, noderev->data_rep, pool));
 
-  SVN_ERR(svn_hash_read2(entries, stream, SVN_HASH_TERMINATOR, pool));
-  SVN_ERR(parse_dir_entries(&entries, entries, pool));
+      return parse_dir_rep(entries_p, data, pool);
+    }
 
-  *out = entries;
+  *entries_p = apr_hash_make(pool);
   return SVN_NO_ERROR;
 }
 
-
 svn_error_t *
 svn_fs_fs__rep_contents_dir(apr_hash_t **entries_p,
                             svn_fs_t *fs,
@@ -3673,11 +5611,11 @@ svn_fs_fs__rep_contents_dir(apr_hash_t **entries_p,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   const char *unparsed_id;
-  apr_hash_t *unparsed_entries, *parsed_entries;
+  apr_hash_t *parsed_entries;
 
   /* Are we looking for an immutable directory?  We could try the
    * cache. */
-  if (! svn_fs_fs__id_txn_id(noderev->id))
+  if (! svn_fs_fs__id_is_txn(noderev->id))
     {
       svn_boolean_t found;
 
@@ -3689,18 +5627,145 @@ svn_fs_fs__rep_contents_dir(apr_hash_t **entries_p,
     }
 
   /* Read in the directory hash. */
-  unparsed_entries = apr_hash_make(pool);
-  SVN_ERR(get_dir_contents(unparsed_entries, fs, noderev, pool));
-  SVN_ERR(parse_dir_entries(&parsed_entries, unparsed_entries, pool));
+  SVN_ERR(get_dir_contents(&parsed_entries, fs, noderev, pool));
 
   /* If this is an immutable directory, let's cache the contents. */
-  if (! svn_fs_fs__id_txn_id(noderev->id))
+  if (! svn_fs_fs__id_is_txn(noderev->id))
     SVN_ERR(svn_cache__set(ffd->dir_cache, unparsed_id, parsed_entries, pool));
 
   *entries_p = parsed_entries;
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__rep_contents_dir_sorted(apr_array_header_t **entries_p,
+                                   svn_fs_t *fs,
+                                   node_revision_t *noderev,
+                                   apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_hash_t *entries;
+  apr_array_header_t *sorted;
+  int i;
+
+  /* Cached directories are stored sorted by name already.  Take them
+   * from there without going through a hash. */
+  if (! svn_fs_fs__id_is_txn(noderev->id))
+    {
+      svn_boolean_t found;
+      const char *unparsed_id = svn_fs_fs__id_unparse(noderev->id,
+                                                      pool)->data;
+
+      SVN_ERR(svn_cache__get_partial((void **) entries_p, &found,
+                                     ffd->dir_cache, unparsed_id,
+                                     svn_fs_fs__extract_dir_entries_sorted,
+                                     NULL, pool));
+      if (found)
+        return SVN_NO_ERROR;
+    }
+
+  /* Read (and cache) the directory the usual way and sort it. */
+  SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, fs, noderev, pool));
+  sorted = svn_sort__hash(entries, svn_sort_compare_items_lexically, pool);
+
+  *entries_p = apr_array_make(pool, sorted->nelts, sizeof(svn_fs_dirent_t *));
+  for (i = 0; i < sorted->nelts; ++i)
+    APR_ARRAY_PUSH(*entries_p, svn_fs_dirent_t *)
+      = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
+                                  svn_fs_t *fs,
+                                  node_revision_t *noderev,
+                                  const char *name,
+                                  apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_hash_t *entries;
+  svn_fs_dirent_t *entry;
+  apr_pool_t *subpool;
+
+  /* For immutable directories, extract the one entry directly from the
+   * cached data instead of copying the whole directory. */
+  if (! svn_fs_fs__id_is_txn(noderev->id))
+    {
+      svn_boolean_t found;
+      const char *unparsed_id = svn_fs_fs__id_unparse(noderev->id,
+                                                      pool)->data;
+
+      SVN_ERR(svn_cache__get_partial((void **) dirent, &found,
+                                     ffd->dir_cache, unparsed_id,
+                                     svn_fs_fs__extract_dir_entry,
+                                     (void *) name, pool));
+      if (found)
+        return SVN_NO_ERROR;
+    }
+
+  subpool = svn_pool_create(pool);
+
+  /* Large immutable directories in binary format are cached as they
+   * are and searched in-place.  That saves us from parsing all entries
+   * for a single lookup.  Other large directories get parsed from the
+   * very same data and cached as usual. */
+  if (ffd->binary_dir_cache && ! svn_fs_fs__id_is_txn(noderev->id)
+      && noderev->data_rep
+      && noderev->data_rep->expanded_size >= BINARY_DIR_SEARCH_THRESHOLD)
+    {
+      svn_stringbuf_t *data;
+      svn_boolean_t found;
+      const char *unparsed_id = svn_fs_fs__id_unparse(noderev->id,
+                                                      subpool)->data;
+
+      SVN_ERR(svn_cache__get_partial((void **) dirent, &found,
+                                     ffd->binary_dir_cache, unparsed_id,
+                                     extract_binary_dir_entry,
+                                     (void *) name, pool));
+      if (found)
+        {
+          svn_pool_destroy(subpool);
+          return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(read_rep_contents(&data, fs, noderev->data_rep, subpool));
+
+      if (is_binary_dir(data->data, data->len))
+        {
+          SVN_ERR(svn_cache__set(ffd->binary_dir_cache, unparsed_id, data,
+                                 subpool));
+          SVN_ERR(find_binary_dir_entry(dirent, data->data, data->len,
+                                        name, pool));
+          svn_pool_destroy(subpool);
+          return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(parse_dir_rep(&entries, data, subpool));
+      SVN_ERR(svn_cache__set(ffd->dir_cache, unparsed_id, entries, subpool));
+    }
+  else
+    {
+      /* Read the full directory (populating the cache on the way). */
+      SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, fs, noderev, subpool));
+    }
+
+  /* Copy the requested entry. */
+  entry = apr_hash_get(entries, name, APR_HASH_KEY_STRING);
+  if (entry)
+    {
+      *dirent = apr_palloc(pool, sizeof(**dirent));
+      (*dirent)->name = apr_pstrdup(pool, entry->name);
+      (*dirent)->kind = entry->kind;
+      (*dirent)->id = svn_fs_fs__id_copy(entry->id, pool);
+    }
+  else
+    *dirent = NULL;
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
                         svn_fs_t *fs,
@@ -3714,9 +5779,29 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
 
   if (noderev->prop_rep && noderev->prop_rep->txn_id)
     {
-      const char *filename = path_txn_node_props(fs, noderev->id, pool);
+      const char *log_dir, *node_key;
 
-      SVN_ERR(svn_stream_open_readonly(&stream, filename, pool, pool));
+      SVN_ERR(get_txn_node_log(&log_dir, &node_key, fs, noderev->id, pool));
+      if (log_dir)
+        {
+          svn_stringbuf_t *props;
+
+          SVN_ERR(svn_fs_fs__txn_log_read(&props, fs, log_dir,
+                                          svn_fs_fs__txn_log_props,
+                                          node_key, pool));
+          if (! props)
+            return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                     _("Properties of node '%s' "
+                                       "missing from transaction"),
+                                     node_key);
+
+          stream = svn_stream_from_stringbuf(props, pool);
+        }
+      else
+        SVN_ERR(svn_stream_open_readonly(&stream,
+                                         path_txn_node_props(fs, noderev->id,
+                                                             pool),
+                                         pool, pool));
       SVN_ERR(svn_hash_read2(proplist, stream, SVN_HASH_TERMINATOR, pool));
       SVN_ERR(svn_stream_close(stream));
     }
@@ -3997,42 +6082,49 @@ fold_change(apr_hash_t *changes,
   return SVN_NO_ERROR;
 }
 
-/* The 256 is an arbitrary size large enough to hold the node id and the
- * various flags. */
-#define MAX_CHANGE_LINE_LEN FSFS_MAX_PATH_LEN + 256
-
-/* Read the next entry in the changes record from file FILE and store
-   the resulting change in *CHANGE_P.  If there is no next record,
-   store NULL there.  Perform all allocations from POOL. */
-static svn_error_t *
-read_change(change_t **change_p,
-            apr_file_t *file,
-            apr_pool_t *pool)
+/* Return the next line of the changes data between *DATA and END and
+   advance *DATA to the start of the following line.  The line gets
+   terminated in-place.  Return NULL if there is no data left. */
+static char *
+next_change_line(char **data,
+                 char *end)
 {
-  char buf[MAX_CHANGE_LINE_LEN];
-  apr_size_t len = sizeof(buf);
-  change_t *change;
-  char *str, *last_str, *kind_str;
-  svn_error_t *err;
-
-  /* Default return value. */
-  *change_p = NULL;
+  char *line = *data;
+  char *eol;
 
-  err = svn_io_read_length_line(file, buf, &len, pool);
+  if (line >= end)
+    return NULL;
 
-  /* Check for a blank line. */
-  if (err || (len == 0))
+  eol = memchr(line, '\n', end - line);
+  if (eol)
     {
-      if (err && APR_STATUS_IS_EOF(err->apr_err))
-        {
-          svn_error_clear(err);
-          return SVN_NO_ERROR;
-        }
-      if ((len == 0) && (! err))
-        return SVN_NO_ERROR;
-      return svn_error_return(err);
+      *eol = '\0';
+      *data = eol + 1;
+    }
+  else
+    {
+      /* The last line has no terminator; END is writable though. */
+      *end = '\0';
+      *data = end;
     }
 
+  return line;
+}
+
+/* Parse the changes entry consisting of the NUL-terminated LINE and
+   COPYFROM_LINE and store the resulting change in *CHANGE_P.  Both lines
+   get modified in-place.  COPYFROM_LINE may be NULL if the entry got
+   truncated, which is an error.  Perform all allocations from POOL. */
+static svn_error_t *
+parse_change(change_t **change_p,
+             char *line,
+             char *copyfrom_line,
+             apr_pool_t *pool)
+{
+  char *buf = line;
+  change_t *change;
+  char *str, *last_str, *kind_str;
+
   change = apr_pcalloc(pool, sizeof(*change));
 
   /* Get the node-id of the change. */
@@ -4140,11 +6232,13 @@ read_change(change_t **change_p,
   change->path = apr_pstrdup(pool, last_str);
 
 
-  /* Read the next line, the copyfrom line. */
-  len = sizeof(buf);
-  SVN_ERR(svn_io_read_length_line(file, buf, &len, pool));
+  /* Now the copyfrom line. */
+  buf = copyfrom_line;
+  if (buf == NULL)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Invalid changes line in rev-file"));
 
-  if (len == 0)
+  if (*buf == '\0')
     {
       change->copyfrom_rev = SVN_INVALID_REVNUM;
       change->copyfrom_path = NULL;
@@ -4169,28 +6263,54 @@ read_change(change_t **change_p,
   return SVN_NO_ERROR;
 }
 
-/* Fetch all the changed path entries from FILE and store then in
-   *CHANGED_PATHS.  Folding is done to remove redundant or unnecessary
-   *data.  Store a hash of paths to copyfrom revisions/paths in
-   COPYFROM_HASH if it is non-NULL.  If PREFOLDED is true, assume that
-   the changed-path entries have already been folded (by
-   write_final_changed_path_info) and may be out of order, so we shouldn't
-   remove children of replaced or deleted directories.  Do all
-   allocations in POOL. */
+/* Read the next entry in the changes record between *DATA and END,
+   store the resulting change in *CHANGE_P and advance *DATA past it.
+   If there is no next record, store NULL there.  The changes data
+   gets modified in-place; END must point to a writable byte.  Perform
+   all allocations from POOL. */
+static svn_error_t *
+read_change(change_t **change_p,
+            char **data,
+            char *end,
+            apr_pool_t *pool)
+{
+  char *line;
+
+  /* Default return value. */
+  *change_p = NULL;
+
+  /* Check for a blank line or the end of the data. */
+  line = next_change_line(data, end);
+  if (line == NULL || *line == '\0')
+    return SVN_NO_ERROR;
+
+  return parse_change(change_p, line, next_change_line(data, end), pool);
+}
+
+/* Fetch all the changed path entries from the CHANGES data and store
+   them in *CHANGED_PATHS.  CHANGES gets modified in the process.
+   Folding is done to remove redundant or unnecessary data.  Store a
+   hash of paths to copyfrom revisions/paths in COPYFROM_HASH if it is
+   non-NULL.  If PREFOLDED is true, assume that the changed-path entries
+   have already been folded (by write_final_changed_path_info) and may
+   be out of order, so we shouldn't remove children of replaced or
+   deleted directories.  Do all allocations in POOL. */
 static svn_error_t *
 fetch_all_changes(apr_hash_t *changed_paths,
                   apr_hash_t *copyfrom_hash,
-                  apr_file_t *file,
+                  svn_stringbuf_t *changes,
                   svn_boolean_t prefolded,
                   apr_pool_t *pool)
 {
   change_t *change;
+  char *data = changes->data;
+  char *end = changes->data + changes->len;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
   /* Read in the changes one by one, folding them into our local hash
      as necessary. */
 
-  SVN_ERR(read_change(&change, file, iterpool));
+  SVN_ERR(read_change(&change, &data, end, iterpool));
 
   while (change)
     {
@@ -4218,26 +6338,106 @@ fetch_all_changes(apr_hash_t *changed_paths,
               const char *path = svn__apr_hash_index_key(hi);
               apr_ssize_t klen = svn__apr_hash_index_klen(hi);
 
-              /* If we come across our own path, ignore it. */
-              if (strcmp(change->path, path) == 0)
-                continue;
+              /* If we come across our own path, ignore it. */
+              if (strcmp(change->path, path) == 0)
+                continue;
+
+              /* If we come across a child of our path, remove it. */
+              if (svn_dirent_is_child(change->path, path, iterpool))
+                apr_hash_set(changed_paths, path, klen, NULL);
+            }
+        }
+
+      /* Clear the per-iteration subpool. */
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(read_change(&change, &data, end, iterpool));
+    }
+
+  /* Destroy the per-iteration subpool. */
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CHANGES to the changed-paths section of revision REV in FS,
+   i.e. everything from the start of the changes up to the end of the
+   revision.  Packed shards may provide the section's location in their
+   changes index; otherwise, find it through the revision trailer.
+   Perform all allocations in POOL. */
+static svn_error_t *
+read_changes_section(svn_stringbuf_t **changes,
+                     svn_fs_t *fs,
+                     svn_revnum_t rev,
+                     apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_uint64_t range[2];
+  apr_off_t start, end;
+  apr_size_t len;
+  svn_boolean_t found = FALSE;
+  apr_file_t *revision_file;
+
+  if (is_packed_rev(fs, rev))
+    SVN_ERR(read_pack_index(range, 2, &found, fs, rev,
+                            PATH_PACKED_CHANGES_INDEX, pool));
+
+  if (found)
+    {
+      apr_mmap_t *mm;
+
+      start = (apr_off_t)range[0];
+      end = (apr_off_t)range[1];
+      if (start > end)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Invalid changes index entry for "
+                                   "revision %ld"), rev);
 
-              /* If we come across a child of our path, remove it. */
-              if (svn_dirent_is_child(change->path, path, iterpool))
-                apr_hash_set(changed_paths, path, klen, NULL);
-            }
+      /* Take the data straight from the pack file mapping, if any. */
+      SVN_ERR(get_pack_mmap(&mm, fs, rev, pool));
+      if (mm)
+        {
+          if ((apr_uint64_t)end > mm->size)
+            return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                    _("Offset beyond the end of the pack "
+                                      "file"));
+
+          *changes = svn_stringbuf_ncreate((const char *)mm->mm + start,
+                                           (apr_size_t)(end - start), pool);
+          return SVN_NO_ERROR;
         }
 
-      /* Clear the per-iteration subpool. */
-      svn_pool_clear(iterpool);
+      SVN_ERR(open_pack_or_rev_file(&revision_file, fs, rev, pool));
+    }
+  else
+    {
+      SVN_ERR(open_pack_or_rev_file(&revision_file, fs, rev, pool));
+      SVN_ERR(get_root_changes_offset(NULL, &start, revision_file, fs,
+                                      rev, pool));
+
+      /* The changes extend up to the trailer at the end of the revision. */
+      if (is_packed_rev(fs, rev) && ((rev + 1) % ffd->max_files_per_dir != 0))
+        SVN_ERR(get_packed_offset(&end, fs, rev + 1, pool));
+      else
+        {
+          apr_finfo_t finfo;
 
-      SVN_ERR(read_change(&change, file, iterpool));
+          SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE,
+                                       revision_file, pool));
+          end = finfo.size;
+        }
     }
 
-  /* Destroy the per-iteration subpool. */
-  svn_pool_destroy(iterpool);
+  /* Read the whole section at once and parse it in memory. */
+  len = (apr_size_t)(end - start);
+  *changes = svn_stringbuf_create_ensure(len, pool);
+  SVN_ERR(svn_io_file_seek(revision_file, APR_SET, &start, pool));
+  SVN_ERR(svn_io_file_read_full(revision_file, (*changes)->data, len,
+                                NULL, pool));
+  (*changes)->len = len;
+  (*changes)->data[len] = '\0';
 
-  return SVN_NO_ERROR;
+  return svn_io_file_close(revision_file, pool);
 }
 
 svn_error_t *
@@ -4246,15 +6446,14 @@ svn_fs_fs__txn_changes_fetch(apr_hash_t **changed_paths_p,
                              const char *txn_id,
                              apr_pool_t *pool)
 {
-  apr_file_t *file;
+  svn_stringbuf_t *changes;
   apr_hash_t *changed_paths = apr_hash_make(pool);
 
-  SVN_ERR(svn_io_file_open(&file, path_txn_changes(fs, txn_id, pool),
-                           APR_READ | APR_BUFFERED, APR_OS_DEFAULT, pool));
-
-  SVN_ERR(fetch_all_changes(changed_paths, NULL, file, FALSE, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&changes,
+                                   path_txn_changes(fs, txn_id, pool),
+                                   pool));
 
-  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(fetch_all_changes(changed_paths, NULL, changes, FALSE, pool));
 
   *changed_paths_p = changed_paths;
 
@@ -4268,32 +6467,151 @@ svn_fs_fs__paths_changed(apr_hash_t **changed_paths_p,
                          apr_hash_t *copyfrom_cache,
                          apr_pool_t *pool)
 {
-  apr_off_t changes_offset;
+  svn_stringbuf_t *changes;
   apr_hash_t *changed_paths;
-  apr_file_t *revision_file;
 
   SVN_ERR(ensure_revision_exists(fs, rev, pool));
 
-  SVN_ERR(open_pack_or_rev_file(&revision_file, fs, rev, pool));
-
-  SVN_ERR(get_root_changes_offset(NULL, &changes_offset, revision_file, fs,
-                                  rev, pool));
-
-  SVN_ERR(svn_io_file_seek(revision_file, APR_SET, &changes_offset, pool));
+  SVN_ERR(read_changes_section(&changes, fs, rev, pool));
 
   changed_paths = apr_hash_make(pool);
 
-  SVN_ERR(fetch_all_changes(changed_paths, copyfrom_cache, revision_file,
+  SVN_ERR(fetch_all_changes(changed_paths, copyfrom_cache, changes,
                             TRUE, pool));
 
-  /* Close the revision file. */
-  SVN_ERR(svn_io_file_close(revision_file, pool));
-
   *changed_paths_p = changed_paths;
 
   return SVN_NO_ERROR;
 }
 
+/* One entry of the changes section of a revision. */
+typedef struct change_record_t
+{
+  /* The entry's first line and the changed path at its end.  The
+     copyfrom line directly follows the first line's terminator. */
+  char *line;
+  const char *path;
+} change_record_t;
+
+struct svn_fs_fs__changes_iterator_t
+{
+  /* The entries of the changes section, sorted by path.  Entries with
+     the same path keep their order in the section. */
+  change_record_t *records;
+  int nelts;
+
+  /* Index of the next record to return. */
+  int next;
+};
+
+/* qsort()-compatible comparison of two change_record_t. */
+static int
+compare_change_records(const void *a, const void *b)
+{
+  const change_record_t *record_a = a;
+  const change_record_t *record_b = b;
+  int cmp = svn_path_compare_paths(record_a->path, record_b->path);
+
+  if (cmp)
+    return cmp;
+
+  /* Records of the same path have to be folded in their original order. */
+  return (record_a->line < record_b->line) ? -1 : 1;
+}
+
+svn_error_t *
+svn_fs_fs__changes_iterator_open(svn_fs_fs__changes_iterator_t **iterator,
+                                 svn_fs_t *fs,
+                                 svn_revnum_t rev,
+                                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *changes;
+  apr_array_header_t *records;
+  char *data, *end, *line;
+  svn_fs_fs__changes_iterator_t *it = apr_palloc(pool, sizeof(*it));
+
+  SVN_ERR(ensure_revision_exists(fs, rev, pool));
+
+  SVN_ERR(read_changes_section(&changes, fs, rev, pool));
+
+  /* Split the section into NUL-terminated lines and remember where each
+     entry and its path start.  The entries are parsed only once they
+     get returned. */
+  records = apr_array_make(pool, 16, sizeof(change_record_t));
+  data = changes->data;
+  end = changes->data + changes->len;
+  while ((line = next_change_line(&data, end)) && *line != '\0')
+    {
+      change_record_t *record = apr_array_push(records);
+      char *path = line;
+      int i;
+
+      /* The path follows the node-rev id, action and modification flags. */
+      for (i = 0; i < 4 && path; i++)
+        {
+          path = strchr(path, ' ');
+          if (path)
+            path++;
+        }
+
+      if (path == NULL || next_change_line(&data, end) == NULL)
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Invalid changes line in rev-file"));
+
+      record->line = line;
+      record->path = path;
+    }
+
+  qsort(records->elts, records->nelts, records->elt_size,
+        compare_change_records);
+
+  it->records = (change_record_t *)records->elts;
+  it->nelts = records->nelts;
+  it->next = 0;
+  *iterator = it;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__changes_iterator_next(const char **path,
+                                 svn_fs_path_change2_t **change,
+                                 svn_fs_fs__changes_iterator_t *iterator,
+                                 apr_pool_t *pool)
+{
+  *path = NULL;
+  *change = NULL;
+
+  /* Changes of the same path get folded just like fetch_all_changes()
+     does for prefolded data.  They may also cancel out, in which case
+     we continue with the next path. */
+  while (*change == NULL && iterator->next < iterator->nelts)
+    {
+      apr_hash_t *folded = apr_hash_make(pool);
+      const char *record_path = iterator->records[iterator->next].path;
+
+      do
+        {
+          change_record_t *record = &iterator->records[iterator->next++];
+          change_t *raw_change;
+
+          SVN_ERR(parse_change(&raw_change, record->line,
+                               record->line + strlen(record->line) + 1,
+                               pool));
+          SVN_ERR(fold_change(folded, raw_change, NULL));
+        }
+      while (iterator->next < iterator->nelts
+             && strcmp(iterator->records[iterator->next].path,
+                       record_path) == 0);
+
+      *change = apr_hash_get(folded, record_path, APR_HASH_KEY_STRING);
+      if (*change)
+        *path = apr_pstrdup(pool, record_path);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Copy a revision node-rev SRC into the current transaction TXN_ID in
    the filesystem FS.  This is only used to create the root of a transaction.
    Allocations are from POOL.  */
@@ -4308,19 +6626,20 @@ create_new_txn_noderev_from_rev(svn_fs_t *fs,
 
   SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, src, pool));
 
-  if (svn_fs_fs__id_txn_id(noderev->id))
+  if (svn_fs_fs__id_is_txn(noderev->id))
     return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
                             _("Copying from transactions not allowed"));
 
   noderev->predecessor_id = noderev->id;
   noderev->predecessor_count++;
+  noderev->predecessor_skip_id = NULL;
   noderev->copyfrom_path = NULL;
   noderev->copyfrom_rev = SVN_INVALID_REVNUM;
 
   /* For the transaction root, the copyroot never changes. */
 
-  node_id = svn_fs_fs__id_node_id(noderev->id);
-  copy_id = svn_fs_fs__id_copy_id(noderev->id);
+  node_id = svn_fs_fs__id_node_id(noderev->id, pool);
+  copy_id = svn_fs_fs__id_copy_id(noderev->id, pool);
   noderev->id = svn_fs_fs__id_txn_create(node_id, copy_id, txn_id, pool);
 
   return svn_fs_fs__put_node_revision(fs, noderev->id, noderev, TRUE, pool);
@@ -4494,6 +6813,11 @@ svn_fs_fs__create_txn(svn_fs_txn_t **txn_p,
   txn->vtable = &txn_vtable;
   *txn_p = txn;
 
+  /* Start the node log before the first node-rev gets written. */
+  if (ffd->use_txn_node_log)
+    SVN_ERR(svn_fs_fs__txn_log_create(fs, path_txn_dir(fs, txn->id, pool),
+                                      pool));
+
   /* Create a new root node for this transaction. */
   SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, pool));
   SVN_ERR(create_new_txn_noderev_from_rev(fs, txn->id, root_id, pool));
@@ -4818,6 +7142,7 @@ svn_fs_fs__purge_txn(svn_fs_t *fs,
   /* Remove the shared transaction object associated with this transaction. */
   SVN_ERR(purge_shared_txn(fs, txn_id, pool));
   /* Remove the directory associated with this transaction. */
+  svn_fs_fs__txn_log_forget(fs, path_txn_dir(fs, txn_id, pool));
   SVN_ERR(svn_io_remove_dir2(path_txn_dir(fs, txn_id, pool), FALSE,
                              NULL, NULL, pool));
   if (ffd->format >= SVN_FS_FS__MIN_PROTOREVS_DIR_FORMAT)
@@ -4860,9 +7185,14 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
 {
   representation_t *rep = parent_noderev->data_rep;
   const char *filename = path_txn_node_children(fs, parent_noderev->id, pool);
-  apr_file_t *file;
+  const char *log_dir, *node_key;
+  svn_stringbuf_t *change = NULL;
+  apr_file_t *file = NULL;
   svn_stream_t *out;
 
+  SVN_ERR(get_txn_node_log(&log_dir, &node_key, fs, parent_noderev->id,
+                           pool));
+
   if (!rep || !rep->txn_id)
     {
       const char *unique_suffix;
@@ -4872,15 +7202,32 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
         apr_pool_t *subpool = svn_pool_create(pool);
 
         /* Before we can modify the directory, we need to dump its old
-           contents into a mutable representation file. */
+           contents into a mutable representation file or the node log. */
         SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, fs, parent_noderev,
                                             subpool));
         SVN_ERR(unparse_dir_entries(&entries, entries, subpool));
-        SVN_ERR(svn_io_file_open(&file, filename,
-                                 APR_WRITE | APR_CREATE | APR_BUFFERED,
-                                 APR_OS_DEFAULT, pool));
-        out = svn_stream_from_aprfile2(file, TRUE, pool);
-        SVN_ERR(svn_hash_write2(entries, out, SVN_HASH_TERMINATOR, subpool));
+        if (log_dir)
+          {
+            svn_stringbuf_t *listing = svn_stringbuf_create("", subpool);
+
+            SVN_ERR(svn_hash_write2(entries,
+                                    svn_stream_from_stringbuf(listing,
+                                                              subpool),
+                                    SVN_HASH_TERMINATOR, subpool));
+            SVN_ERR(svn_fs_fs__txn_log_append(log_dir,
+                                              svn_fs_fs__txn_log_children,
+                                              node_key, listing->data,
+                                              listing->len, subpool));
+          }
+        else
+          {
+            SVN_ERR(svn_io_file_open(&file, filename,
+                                     APR_WRITE | APR_CREATE | APR_BUFFERED,
+                                     APR_OS_DEFAULT, pool));
+            out = svn_stream_from_aprfile2(file, TRUE, pool);
+            SVN_ERR(svn_hash_write2(entries, out, SVN_HASH_TERMINATOR,
+                                    subpool));
+          }
 
         svn_pool_destroy(subpool);
       }
@@ -4895,7 +7242,7 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
       SVN_ERR(svn_fs_fs__put_node_revision(fs, parent_noderev->id,
                                            parent_noderev, FALSE, pool));
     }
-  else
+  else if (! log_dir)
     {
       /* The directory rep is already mutable, so just open it for append. */
       SVN_ERR(svn_io_file_open(&file, filename, APR_WRITE | APR_APPEND,
@@ -4903,6 +7250,13 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
       out = svn_stream_from_aprfile2(file, TRUE, pool);
     }
 
+  /* The node log gets the entry change as a record of its own. */
+  if (log_dir)
+    {
+      change = svn_stringbuf_create("", pool);
+      out = svn_stream_from_stringbuf(change, pool);
+    }
+
   /* Append an incremental hash entry for the entry change. */
   if (id)
     {
@@ -4919,6 +7273,11 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
                                 strlen(name), name));
     }
 
+  if (change)
+    return svn_fs_fs__txn_log_append(log_dir, svn_fs_fs__txn_log_entries,
+                                     node_key, change->data, change->len,
+                                     pool);
+
   return svn_io_file_close(file, pool);
 }
 
@@ -5055,8 +7414,8 @@ struct rep_write_baton
      writing to it. */
   void *lockcookie;
 
-  svn_checksum_ctx_t *md5_checksum_ctx;
-  svn_checksum_ctx_t *sha1_checksum_ctx;
+  /* Computes both the MD5 and the SHA-1 checksum. */
+  svn_checksum_ctx_t *checksum_ctx;
 
   apr_pool_t *pool;
 
@@ -5073,8 +7432,7 @@ rep_write_contents(void *baton,
 {
   struct rep_write_baton *b = baton;
 
-  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
+  SVN_ERR(svn_checksum_update(b->checksum_ctx, data, *len));
   b->rep_size += *len;
 
   /* If we are writing a delta, use that stream. */
@@ -5084,15 +7442,57 @@ rep_write_contents(void *baton,
     return svn_stream_write(b->rep_stream, data, len);
 }
 
+/* Set *CHAIN_LENGTH to the number of reps in FS that have to be read
+   to reconstruct REP, REP itself included.  Stop counting once LIMIT
+   has been reached.  Perform temporary allocations in POOL. */
+static svn_error_t *
+get_rep_chain_length(int *chain_length,
+                     svn_fs_t *fs,
+                     representation_t *rep,
+                     int limit,
+                     apr_pool_t *pool)
+{
+  representation_t base = *rep;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int count = 0;
+
+  while (count < limit)
+    {
+      struct rep_state *rs;
+      struct rep_args *rep_args;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(create_rep_state(&rs, &rep_args, &base, fs, iterpool));
+      SVN_ERR(svn_io_file_close(rs->file, iterpool));
+
+      count++;
+      if (! rep_args->is_delta || rep_args->is_delta_vs_empty)
+        break;
+
+      base.revision = rep_args->base_revision;
+      base.offset = rep_args->base_offset;
+      base.size = rep_args->base_length;
+      base.txn_id = NULL;
+    }
+
+  svn_pool_destroy(iterpool);
+  *chain_length = count;
+
+  return SVN_NO_ERROR;
+}
+
 /* Given a node-revision NODEREV in filesystem FS, return the
    representation in *REP to use as the base for a text representation
-   delta.  Perform temporary allocations in *POOL. */
+   delta.  If the chain of the chosen base is as long as FS allows,
+   return NULL instead, so that the new rep starts a new chain.  Perform
+   temporary allocations in *POOL. */
 static svn_error_t *
 choose_delta_base(representation_t **rep,
                   svn_fs_t *fs,
                   node_revision_t *noderev,
                   apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   int count;
   node_revision_t *base;
 
@@ -5111,43 +7511,56 @@ choose_delta_base(representation_t **rep,
   count = noderev->predecessor_count;
   count = count & (count - 1);
 
-  /* Walk back a number of predecessors equal to the difference
-     between count and the original predecessor count.  (For example,
-     if noderev has ten predecessors and we want the eighth file rev,
-     walk back two predecessors.) */
-  base = noderev;
-  while ((count++) < noderev->predecessor_count)
-    SVN_ERR(svn_fs_fs__get_node_revision(&base, fs,
-                                         base->predecessor_id, pool));
+  /* Walk back from our predecessor to the node-rev with that count.
+     (For example, if noderev has ten predecessors and we want the
+     eighth file rev, walk back one more predecessor.)  Older node-revs
+     link to their own skip-delta bases, so this takes just a few steps
+     even where many predecessors lie in between. */
+  SVN_ERR(svn_fs_fs__get_node_revision(&base, fs, noderev->predecessor_id,
+                                       pool));
+  if (noderev->predecessor_count > 0)
+    SVN_ERR(svn_fs_fs__get_ancestor(&base, fs, base, count, pool));
 
   *rep = base->data_rep;
 
+  /* Don't let the delta chain grow beyond the configured limit.  Our
+     new rep will add one more delta to the base's chain. */
+  if (*rep && ffd->max_deltification_walk >= 0)
+    {
+      int chain_length;
+
+      SVN_ERR(get_rep_chain_length(&chain_length, fs, *rep,
+                                   ffd->max_deltification_walk, pool));
+      if (chain_length >= ffd->max_deltification_walk)
+        *rep = NULL;
+    }
+
   return SVN_NO_ERROR;
 }
 
-/* Get a rep_write_baton and store it in *WB_P for the representation
-   indicated by NODEREV in filesystem FS.  Perform allocations in
-   POOL.  Only appropriate for file contents, not for props or
-   directory contents. */
+/* Start writing the representation indicated by NODEREV in filesystem
+   FS as a delta against BASE_REP (NULL for the empty text): store a new
+   rep_write_baton in *WB_P and set *WH_P and *WHB_P to a window handler
+   that writes the svndiff data of the rep.  Perform allocations in
+   POOL.  Only appropriate for file contents, not for props or directory
+   contents. */
 static svn_error_t *
-rep_write_get_baton(struct rep_write_baton **wb_p,
-                    svn_fs_t *fs,
-                    node_revision_t *noderev,
-                    apr_pool_t *pool)
+rep_write_open(struct rep_write_baton **wb_p,
+               svn_txdelta_window_handler_t *wh_p,
+               void **whb_p,
+               svn_fs_t *fs,
+               node_revision_t *noderev,
+               representation_t *base_rep,
+               apr_pool_t *pool)
 {
   struct rep_write_baton *b;
   apr_file_t *file;
-  representation_t *base_rep;
-  svn_stream_t *source;
   const char *header;
-  svn_txdelta_window_handler_t wh;
-  void *whb;
   fs_fs_data_t *ffd = fs->fsap_data;
 
   b = apr_pcalloc(pool, sizeof(*b));
 
-  b->sha1_checksum_ctx = svn_checksum_ctx_create(svn_checksum_sha1, pool);
-  b->md5_checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+  b->checksum_ctx = svn_checksum__ctx_create_md5_sha1(pool);
 
   b->fs = fs;
   b->parent_pool = pool;
@@ -5157,7 +7570,8 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
 
   /* Open the prototype rev file and seek to its end. */
   SVN_ERR(get_writable_proto_rev(&file, &b->lockcookie,
-                                 fs, svn_fs_fs__id_txn_id(noderev->id),
+                                 fs, svn_fs_fs__id_txn_id(noderev->id,
+                                                          b->pool),
                                  b->pool));
 
   b->file = file;
@@ -5165,10 +7579,6 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
 
   SVN_ERR(get_file_offset(&b->rep_offset, file, b->pool));
 
-  /* Get the base for this delta. */
-  SVN_ERR(choose_delta_base(&base_rep, fs, noderev, b->pool));
-  SVN_ERR(read_representation(&source, fs, base_rep, b->pool));
-
   /* Write out the rep header. */
   if (base_rep)
     {
@@ -5189,11 +7599,42 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
 
   /* Prepare to write the svndiff data. */
   if (ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT)
-    svn_txdelta_to_svndiff2(&wh, &whb, b->rep_stream, 1, pool);
+    svn_txdelta_to_svndiff3(wh_p, whb_p, b->rep_stream, 1,
+                            ffd->compression_level, pool);
   else
-    svn_txdelta_to_svndiff2(&wh, &whb, b->rep_stream, 0, pool);
+    svn_txdelta_to_svndiff2(wh_p, whb_p, b->rep_stream, 0, pool);
+
+  *wb_p = b;
+
+  return SVN_NO_ERROR;
+}
+
+/* Get a rep_write_baton and store it in *WB_P for the representation
+   indicated by NODEREV in filesystem FS.  Perform allocations in
+   POOL.  Only appropriate for file contents, not for props or
+   directory contents. */
+static svn_error_t *
+rep_write_get_baton(struct rep_write_baton **wb_p,
+                    svn_fs_t *fs,
+                    node_revision_t *noderev,
+                    apr_pool_t *pool)
+{
+  struct rep_write_baton *b;
+  representation_t *base_rep;
+  svn_stream_t *source;
+  svn_txdelta_window_handler_t wh;
+  void *whb;
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Get the base for this delta. */
+  SVN_ERR(choose_delta_base(&base_rep, fs, noderev, pool));
+
+  SVN_ERR(rep_write_open(&b, &wh, &whb, fs, noderev, base_rep, pool));
+  SVN_ERR(read_representation(&source, fs, base_rep, b->pool));
 
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source, b->pool);
+  b->delta_stream = svn_txdelta_target_push2(wh, whb, source,
+                                             ffd->delta_window_size,
+                                             b->pool);
 
   *wb_p = b;
 
@@ -5227,17 +7668,16 @@ rep_write_contents_close(void *baton)
 
   /* Fill in the rest of the representation field. */
   rep->expanded_size = b->rep_size;
-  rep->txn_id = svn_fs_fs__id_txn_id(b->noderev->id);
+  rep->txn_id = svn_fs_fs__id_txn_id(b->noderev->id, b->parent_pool);
   SVN_ERR(get_new_txn_node_id(&unique_suffix, b->fs, rep->txn_id, b->pool));
   rep->uniquifier = apr_psprintf(b->parent_pool, "%s/%s", rep->txn_id,
                                  unique_suffix);
   rep->revision = SVN_INVALID_REVNUM;
 
   /* Finalize the checksum. */
-  SVN_ERR(svn_checksum_final(&rep->md5_checksum, b->md5_checksum_ctx,
-                              b->parent_pool));
-  SVN_ERR(svn_checksum_final(&rep->sha1_checksum, b->sha1_checksum_ctx,
-                              b->parent_pool));
+  SVN_ERR(svn_checksum__final_md5_sha1(&rep->md5_checksum,
+                                       &rep->sha1_checksum, b->checksum_ctx,
+                                       b->parent_pool));
 
   /* Check and see if we already have a representation somewhere that's
      identical to the one we just wrote out. */
@@ -5290,30 +7730,264 @@ set_representation(svn_stream_t **contents_p,
 {
   struct rep_write_baton *wb;
 
-  if (! svn_fs_fs__id_txn_id(noderev->id))
-    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
-                            _("Attempted to write to non-transaction"));
+  if (! svn_fs_fs__id_is_txn(noderev->id))
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Attempted to write to non-transaction"));
+
+  SVN_ERR(rep_write_get_baton(&wb, fs, noderev, pool));
+
+  *contents_p = svn_stream_create(wb, pool);
+  svn_stream_set_write(*contents_p, rep_write_contents);
+  svn_stream_set_close(*contents_p, rep_write_contents_close);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__set_contents(svn_stream_t **stream,
+                        svn_fs_t *fs,
+                        node_revision_t *noderev,
+                        apr_pool_t *pool)
+{
+  if (noderev->kind != svn_node_file)
+    return svn_error_create(SVN_ERR_FS_NOT_FILE, NULL,
+                            _("Can't set text contents of a directory"));
+
+  return set_representation(stream, fs, noderev, pool);
+}
+
+/* Baton for storing the delta windows of a client as they are. */
+struct rep_write_delta_baton
+{
+  /* The representation being written. */
+  struct rep_write_baton *wb;
+
+  /* The base of the delta, i.e. the current contents. */
+  representation_t *base_rep;
+
+  /* Writes the svndiff encoding of each window to the rep. */
+  svn_txdelta_window_handler_t svndiff_handler;
+  void *svndiff_baton;
+
+  /* Reconstructs the fulltext, which feeds the checksums and, once we
+     compute the delta ourselves, WB's delta stream. */
+  svn_txdelta_window_handler_t apply_handler;
+  void *apply_baton;
+
+  /* Readers expect every window but the last one of a rep to produce
+     WINDOW_SIZE bytes and the window CHUNK_INDEX to only read from that
+     chunk of the base.  A window is held back until the next one shows
+     whether it was the last; HELD_POOL keeps it alive until then. */
+  apr_size_t window_size;
+  int chunk_index;
+  svn_txdelta_window_t *held;
+  apr_pool_t *held_pool;
+
+  /* The windows store as is only up to CHUNK_INDEX; from there on,
+     WB's delta stream computes the rest.  Its windows start at the
+     beginning of chunk CHUNK_INDEX, so their source offsets need to be
+     shifted by SOURCE_OFFSET. */
+  svn_boolean_t computing;
+  svn_filesize_t source_offset;
+};
+
+/* Write handler for the fulltext reconstructed from the stored windows.
+   BATON is a rep_write_baton.  DATA goes into its checksums and, if
+   there is one, its delta stream. */
+static svn_error_t *
+rep_write_checksum_only(void *baton,
+                        const char *data,
+                        apr_size_t *len)
+{
+  struct rep_write_baton *b = baton;
+
+  SVN_ERR(svn_checksum_update(b->checksum_ctx, data, *len));
+  b->rep_size += *len;
+
+  if (b->delta_stream)
+    return svn_stream_write(b->delta_stream, data, len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Window handler between the delta stream computing the remainder of
+   a rep and its svndiff encoder.  BATON is a rep_write_delta_baton. */
+static svn_error_t *
+rep_write_shifted_window(svn_txdelta_window_t *window,
+                         void *baton)
+{
+  struct rep_write_delta_baton *db = baton;
+  svn_txdelta_window_t shifted;
+
+  if (! window)
+    return db->svndiff_handler(NULL, db->svndiff_baton);
+
+  shifted = *window;
+  shifted.sview_offset += db->source_offset;
+  return db->svndiff_handler(&shifted, db->svndiff_baton);
+}
+
+/* Stop storing the incoming windows of DB as they are and compute the
+   delta for everything from chunk DB->chunk_index on instead. */
+static svn_error_t *
+start_computing_delta(struct rep_write_delta_baton *db)
+{
+  fs_fs_data_t *ffd = db->wb->fs->fsap_data;
+  svn_stream_t *source;
+  svn_filesize_t remaining;
+
+  db->source_offset = (svn_filesize_t) db->chunk_index * db->window_size;
+
+  SVN_ERR(read_representation(&source, db->wb->fs, db->base_rep,
+                              db->wb->pool));
+  remaining = db->source_offset;
+  while (remaining > 0)
+    {
+      apr_size_t len = remaining > APR_SIZE_MAX
+                     ? APR_SIZE_MAX : (apr_size_t) remaining;
+
+      SVN_ERR(svn_stream_skip(source, &len));
+      if (len == 0)
+        break;
+      remaining -= len;
+    }
+
+  db->wb->delta_stream = svn_txdelta_target_push2(rep_write_shifted_window,
+                                                  db, source,
+                                                  ffd->delta_window_size,
+                                                  db->wb->pool);
+  db->computing = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return whether WINDOW, as the window DB->chunk_index of the rep of
+   DB, reads and produces no more than readers expect. */
+static svn_boolean_t
+window_fits(const svn_txdelta_window_t *window,
+            struct rep_write_delta_baton *db)
+{
+  if (window->tview_len > db->window_size)
+    return FALSE;
+
+  if (window->src_ops == 0)
+    return TRUE;
+
+  return window->sview_offset
+           == (svn_filesize_t) db->chunk_index * db->window_size
+         && window->sview_len <= db->window_size;
+}
+
+/* Hand WINDOW of DB on: to the svndiff encoder unless we are computing
+   the delta ourselves, and to the fulltext reconstruction. */
+static svn_error_t *
+pass_window(svn_txdelta_window_t *window,
+            struct rep_write_delta_baton *db)
+{
+  if (! db->computing)
+    {
+      SVN_ERR(db->svndiff_handler(window, db->svndiff_baton));
+      db->chunk_index++;
+    }
+
+  return db->apply_handler(window, db->apply_baton);
+}
+
+/* Window handler for svn_fs_fs__set_contents_delta.  BATON is a
+   rep_write_delta_baton. */
+static svn_error_t *
+rep_write_delta_window(svn_txdelta_window_t *window,
+                       void *baton)
+{
+  struct rep_write_delta_baton *db = baton;
+
+  /* The held window may be stored as is if it is the last one or
+     produces a full chunk. */
+  if (db->held)
+    {
+      if (! db->computing && window
+          && db->held->tview_len != db->window_size)
+        SVN_ERR(start_computing_delta(db));
+
+      SVN_ERR(pass_window(db->held, db));
+      svn_pool_clear(db->held_pool);
+      db->held = NULL;
+    }
 
-  SVN_ERR(rep_write_get_baton(&wb, fs, noderev, pool));
+  /* After the last window, this closes the fulltext stream and with it
+     the representation, including any delta stream. */
+  if (! window)
+    {
+      if (! db->computing)
+        SVN_ERR(db->svndiff_handler(NULL, db->svndiff_baton));
+      return db->apply_handler(NULL, db->apply_baton);
+    }
 
-  *contents_p = svn_stream_create(wb, pool);
-  svn_stream_set_write(*contents_p, rep_write_contents);
-  svn_stream_set_close(*contents_p, rep_write_contents_close);
+  if (! db->computing && ! window_fits(window, db))
+    SVN_ERR(start_computing_delta(db));
 
+  if (db->computing)
+    return db->apply_handler(window, db->apply_baton);
+
+  db->held = svn_txdelta_window_dup(window, db->held_pool);
   return SVN_NO_ERROR;
 }
 
 svn_error_t *
-svn_fs_fs__set_contents(svn_stream_t **stream,
-                        svn_fs_t *fs,
-                        node_revision_t *noderev,
-                        apr_pool_t *pool)
+svn_fs_fs__set_contents_delta(svn_txdelta_window_handler_t *handler,
+                              void **handler_baton,
+                              svn_fs_t *fs,
+                              node_revision_t *noderev,
+                              apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
+  representation_t *base_rep = noderev->data_rep;
+  representation_t *chosen_rep;
+  struct rep_write_delta_baton *db;
+  svn_stream_t *source, *fulltext;
+
   if (noderev->kind != svn_node_file)
     return svn_error_create(SVN_ERR_FS_NOT_FILE, NULL,
                             _("Can't set text contents of a directory"));
+  if (! svn_fs_fs__id_is_txn(noderev->id))
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Attempted to write to non-transaction"));
 
-  return set_representation(stream, fs, noderev, pool);
+  /* The incoming windows are against the current contents.  Only if we
+     would deltify against those anyway can we store them as they are;
+     contents written earlier in this txn never qualify. */
+  *handler = NULL;
+  *handler_baton = NULL;
+  SVN_ERR(choose_delta_base(&chosen_rep, fs, noderev, pool));
+  if (base_rep || chosen_rep)
+    {
+      if (! base_rep || ! chosen_rep
+          || ! SVN_IS_VALID_REVNUM(base_rep->revision)
+          || base_rep->revision != chosen_rep->revision
+          || base_rep->offset != chosen_rep->offset)
+        return SVN_NO_ERROR;
+    }
+
+  db = apr_pcalloc(pool, sizeof(*db));
+  SVN_ERR(rep_write_open(&db->wb, &db->svndiff_handler, &db->svndiff_baton,
+                         fs, noderev, base_rep, pool));
+  db->base_rep = base_rep;
+  db->window_size = ffd->delta_window_size;
+  db->held_pool = svn_pool_create(db->wb->pool);
+
+  /* We still need the fulltext for the checksums and for rep-sharing,
+     but applying a delta is much cheaper than computing one. */
+  SVN_ERR(read_representation(&source, fs, base_rep, db->wb->pool));
+  fulltext = svn_stream_create(db->wb, db->wb->pool);
+  svn_stream_set_write(fulltext, rep_write_checksum_only);
+  svn_stream_set_close(fulltext, rep_write_contents_close);
+  svn_txdelta_apply(source, fulltext, NULL, NULL, pool,
+                    &db->apply_handler, &db->apply_baton);
+
+  *handler = rep_write_delta_window;
+  *handler_baton = db;
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -5328,12 +8002,15 @@ svn_fs_fs__create_successor(const svn_fs_id_t **new_id_p,
   const svn_fs_id_t *id;
 
   if (! copy_id)
-    copy_id = svn_fs_fs__id_copy_id(old_idp);
-  id = svn_fs_fs__id_txn_create(svn_fs_fs__id_node_id(old_idp), copy_id,
+    copy_id = svn_fs_fs__id_copy_id(old_idp, pool);
+  id = svn_fs_fs__id_txn_create(svn_fs_fs__id_node_id(old_idp, pool), copy_id,
                                 txn_id, pool);
 
   new_noderev->id = id;
 
+  /* The skip link gets determined when the successor is committed. */
+  new_noderev->predecessor_skip_id = NULL;
+
   if (! new_noderev->copyroot_path)
     {
       new_noderev->copyroot_path = apr_pstrdup(pool,
@@ -5355,23 +8032,39 @@ svn_fs_fs__set_proplist(svn_fs_t *fs,
                         apr_hash_t *proplist,
                         apr_pool_t *pool)
 {
-  const char *filename = path_txn_node_props(fs, noderev->id, pool);
+  const char *log_dir, *node_key;
   apr_file_t *file;
   svn_stream_t *out;
 
-  /* Dump the property list to the mutable property file. */
-  SVN_ERR(svn_io_file_open(&file, filename,
-                           APR_WRITE | APR_CREATE | APR_TRUNCATE
-                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
-  out = svn_stream_from_aprfile2(file, TRUE, pool);
-  SVN_ERR(svn_hash_write2(proplist, out, SVN_HASH_TERMINATOR, pool));
-  SVN_ERR(svn_io_file_close(file, pool));
+  /* Dump the property list to the mutable property file or the
+     node log. */
+  SVN_ERR(get_txn_node_log(&log_dir, &node_key, fs, noderev->id, pool));
+  if (log_dir)
+    {
+      svn_stringbuf_t *props = svn_stringbuf_create("", pool);
+
+      out = svn_stream_from_stringbuf(props, pool);
+      SVN_ERR(svn_hash_write2(proplist, out, SVN_HASH_TERMINATOR, pool));
+      SVN_ERR(svn_fs_fs__txn_log_append(log_dir, svn_fs_fs__txn_log_props,
+                                        node_key, props->data, props->len,
+                                        pool));
+    }
+  else
+    {
+      SVN_ERR(svn_io_file_open(&file, path_txn_node_props(fs, noderev->id,
+                                                          pool),
+                               APR_WRITE | APR_CREATE | APR_TRUNCATE
+                               | APR_BUFFERED, APR_OS_DEFAULT, pool));
+      out = svn_stream_from_aprfile2(file, TRUE, pool);
+      SVN_ERR(svn_hash_write2(proplist, out, SVN_HASH_TERMINATOR, pool));
+      SVN_ERR(svn_io_file_close(file, pool));
+    }
 
   /* Mark the node-rev's prop rep as mutable, if not already done. */
   if (!noderev->prop_rep || !noderev->prop_rep->txn_id)
     {
       noderev->prop_rep = apr_pcalloc(pool, sizeof(*noderev->prop_rep));
-      noderev->prop_rep->txn_id = svn_fs_fs__id_txn_id(noderev->id);
+      noderev->prop_rep->txn_id = svn_fs_fs__id_txn_id(noderev->id, pool);
       SVN_ERR(svn_fs_fs__put_node_revision(fs, noderev->id, noderev, FALSE, pool));
     }
 
@@ -5421,6 +8114,7 @@ struct write_hash_baton
 
   apr_size_t size;
 
+  /* Computes both the MD5 and the SHA-1 checksum. */
   svn_checksum_ctx_t *checksum_ctx;
 };
 
@@ -5443,11 +8137,13 @@ write_hash_handler(void *baton,
 }
 
 /* Write out the hash HASH as a text representation to file FILE.  In
-   the process, record the total size of the dump in *SIZE, and the
-   md5 digest in CHECKSUM.  Perform temporary allocations in POOL. */
+   the process, record the total size of the dump in *SIZE, and its
+   md5 and sha1 digests in *MD5_CHECKSUM and *SHA1_CHECKSUM.  Perform
+   temporary allocations in POOL. */
 static svn_error_t *
 write_hash_rep(svn_filesize_t *size,
-               svn_checksum_t **checksum,
+               svn_checksum_t **md5_checksum,
+               svn_checksum_t **sha1_checksum,
                apr_file_t *file,
                apr_hash_t *hash,
                apr_pool_t *pool)
@@ -5459,7 +8155,7 @@ write_hash_rep(svn_filesize_t *size,
 
   whb->stream = svn_stream_from_aprfile2(file, TRUE, pool);
   whb->size = 0;
-  whb->checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+  whb->checksum_ctx = svn_checksum__ctx_create_md5_sha1(pool);
 
   stream = svn_stream_create(whb, pool);
   svn_stream_set_write(stream, write_hash_handler);
@@ -5469,12 +8165,118 @@ write_hash_rep(svn_filesize_t *size,
   SVN_ERR(svn_hash_write2(hash, stream, SVN_HASH_TERMINATOR, pool));
 
   /* Store the results. */
-  svn_checksum_final(checksum, whb->checksum_ctx, pool);
+  SVN_ERR(svn_checksum__final_md5_sha1(md5_checksum, sha1_checksum,
+                                       whb->checksum_ctx, pool));
   *size = whb->size;
 
   return svn_stream_printf(whb->stream, pool, "ENDREP\n");
 }
 
+/* Write out the directory ENTRIES, a hash of svn_fs_dirent_t, as a
+   binary directory representation to file FILE.  In the process,
+   record the size of the data in *SIZE, and its md5 and sha1 digests
+   in *MD5_CHECKSUM and *SHA1_CHECKSUM.  Perform temporary allocations
+   in POOL. */
+static svn_error_t *
+write_binary_dir_rep(svn_filesize_t *size,
+                     svn_checksum_t **md5_checksum,
+                     svn_checksum_t **sha1_checksum,
+                     apr_file_t *file,
+                     apr_hash_t *entries,
+                     apr_pool_t *pool)
+{
+  svn_stream_t *stream = svn_stream_from_aprfile2(file, TRUE, pool);
+  svn_stringbuf_t *data;
+  svn_checksum_ctx_t *checksum_ctx = svn_checksum__ctx_create_md5_sha1(pool);
+  apr_size_t len;
+
+  SVN_ERR(unparse_binary_dir(&data, entries, pool));
+  SVN_ERR(svn_checksum_update(checksum_ctx, data->data, data->len));
+  SVN_ERR(svn_checksum__final_md5_sha1(md5_checksum, sha1_checksum,
+                                       checksum_ctx, pool));
+  *size = data->len;
+
+  SVN_ERR(svn_stream_printf(stream, pool, "PLAIN\n"));
+  len = data->len;
+  SVN_ERR(svn_stream_write(stream, data->data, &len));
+
+  return svn_stream_printf(stream, pool, "ENDREP\n");
+}
+
+/* The property or directory representation *REP_P of a node-rev in
+   transaction TXN_ID of FS has just been written as a plain rep to the
+   end of FILE, with all of its members filled in except for the
+   uniquifier.  If rep-sharing is enabled and an identical rep exists
+   already, either in the rep cache or in REPS_HASH, drop *REP_P from FILE
+   again and point *REP_P to the existing rep instead.  Otherwise, add
+   *REP_P to REPS_HASH (keyed by its sha1 digest) and append a copy of it
+   to REPS_TO_CACHE, both allocated in REPS_POOL.
+
+   If rep-sharing is disabled, clear the sha1 checksum of *REP_P, so
+   that the node-rev keeps its old format.  Use POOL for allocations. */
+static svn_error_t *
+share_final_rep(representation_t **rep_p,
+                apr_file_t *file,
+                svn_fs_t *fs,
+                const char *txn_id,
+                apr_hash_t *reps_hash,
+                apr_array_header_t *reps_to_cache,
+                apr_pool_t *reps_pool,
+                apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  representation_t *rep = *rep_p;
+  representation_t *old_rep;
+  const char *unique_suffix;
+
+  if (! ffd->rep_sharing_allowed)
+    {
+      rep->sha1_checksum = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR_ASSERT(reps_hash && reps_to_cache && reps_pool);
+
+  SVN_ERR(get_new_txn_node_id(&unique_suffix, fs, txn_id, pool));
+  rep->uniquifier = apr_psprintf(pool, "%s/%s", txn_id, unique_suffix);
+
+  /* Reps written earlier in this revision are not in the cache yet. */
+  SVN_ERR(svn_fs_fs__get_rep_reference(&old_rep, fs, rep->sha1_checksum,
+                                       pool));
+  if (! old_rep)
+    {
+      old_rep = apr_hash_get(reps_hash, rep->sha1_checksum->digest,
+                             APR_SHA1_DIGESTSIZE);
+      if (old_rep)
+        old_rep = svn_fs_fs__rep_copy(old_rep, pool);
+    }
+
+  if (old_rep)
+    {
+      apr_off_t offset = rep->offset;
+
+      /* Erase the data we just wrote. */
+      SVN_ERR(svn_io_file_trunc(file, offset, pool));
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+
+      /* Use the old rep for this content. */
+      old_rep->md5_checksum = rep->md5_checksum;
+      old_rep->uniquifier = rep->uniquifier;
+      old_rep->txn_id = NULL;
+      *rep_p = old_rep;
+    }
+  else
+    {
+      representation_t *rep_copy = svn_fs_fs__rep_copy(rep, reps_pool);
+
+      apr_hash_set(reps_hash, rep_copy->sha1_checksum->digest,
+                   APR_SHA1_DIGESTSIZE, rep_copy);
+      APR_ARRAY_PUSH(reps_to_cache, representation_t *) = rep_copy;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Copy a node-revision specified by id ID in fileystem FS from a
    transaction into the permanent rev-file FILE.  Set *NEW_ID_P to a
    pointer to the new node-id which will be allocated in POOL.
@@ -5485,7 +8287,9 @@ write_hash_rep(svn_filesize_t *size,
    FS formats.
 
    If REPS_TO_CACHE is not NULL, append to it a copy (allocated in
-   REPS_POOL) of each data rep that is new in this revision.
+   REPS_POOL) of each rep that is new in this revision.  REPS_HASH maps
+   the sha1 digests of the property and directory reps written so far in
+   this revision to such copies; see share_final_rep().
 
    Temporary allocations are also from POOL. */
 static svn_error_t *
@@ -5497,6 +8301,7 @@ write_final_rev(const svn_fs_id_t **new_id_p,
                 const char *start_node_id,
                 const char *start_copy_id,
                 apr_array_header_t *reps_to_cache,
+                apr_hash_t *reps_hash,
                 apr_pool_t *reps_pool,
                 apr_pool_t *pool)
 {
@@ -5511,7 +8316,7 @@ write_final_rev(const svn_fs_id_t **new_id_p,
   *new_id_p = NULL;
 
   /* Check to see if this is a transaction node. */
-  if (! svn_fs_fs__id_txn_id(id))
+  if (! svn_fs_fs__id_is_txn(id))
     return SVN_NO_ERROR;
 
   SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool));
@@ -5534,7 +8339,7 @@ write_final_rev(const svn_fs_id_t **new_id_p,
           svn_pool_clear(subpool);
           SVN_ERR(write_final_rev(&new_id, file, rev, fs, dirent->id,
                                   start_node_id, start_copy_id,
-                                  reps_to_cache, reps_pool,
+                                  reps_to_cache, reps_hash, reps_pool,
                                   subpool));
           if (new_id && (svn_fs_fs__id_rev(new_id) == rev))
             dirent->id = svn_fs_fs__id_copy(new_id, pool);
@@ -5543,16 +8348,32 @@ write_final_rev(const svn_fs_id_t **new_id_p,
 
       if (noderev->data_rep && noderev->data_rep->txn_id)
         {
-          /* Write out the contents of this directory as a text rep. */
-          SVN_ERR(unparse_dir_entries(&str_entries, entries, pool));
-
           noderev->data_rep->txn_id = NULL;
           noderev->data_rep->revision = rev;
           SVN_ERR(get_file_offset(&noderev->data_rep->offset, file, pool));
-          SVN_ERR(write_hash_rep(&noderev->data_rep->size,
-                                 &noderev->data_rep->md5_checksum, file,
-                                 str_entries, pool));
+
+          /* Write out the contents of this directory as a plain rep.
+             Newer formats store it sorted and binary, allowing for
+             lookups without parsing the whole listing. */
+          if (ffd->format >= SVN_FS_FS__MIN_BINARY_DIR_FORMAT)
+            {
+              SVN_ERR(write_binary_dir_rep(&noderev->data_rep->size,
+                                           &noderev->data_rep->md5_checksum,
+                                           &noderev->data_rep->sha1_checksum,
+                                           file, entries, pool));
+            }
+          else
+            {
+              SVN_ERR(unparse_dir_entries(&str_entries, entries, pool));
+              SVN_ERR(write_hash_rep(&noderev->data_rep->size,
+                                     &noderev->data_rep->md5_checksum,
+                                     &noderev->data_rep->sha1_checksum,
+                                     file, str_entries, pool));
+            }
           noderev->data_rep->expanded_size = noderev->data_rep->size;
+          SVN_ERR(share_final_rep(&noderev->data_rep, file, fs,
+                                  svn_fs_fs__id_txn_id(id, pool), reps_hash,
+                                  reps_to_cache, reps_pool, pool));
         }
     }
   else
@@ -5576,18 +8397,23 @@ write_final_rev(const svn_fs_id_t **new_id_p,
       SVN_ERR(svn_fs_fs__get_proplist(&proplist, fs, noderev, pool));
       SVN_ERR(get_file_offset(&noderev->prop_rep->offset, file, pool));
       SVN_ERR(write_hash_rep(&noderev->prop_rep->size,
-                             &noderev->prop_rep->md5_checksum, file,
-                             proplist, pool));
+                             &noderev->prop_rep->md5_checksum,
+                             &noderev->prop_rep->sha1_checksum,
+                             file, proplist, pool));
 
       noderev->prop_rep->txn_id = NULL;
       noderev->prop_rep->revision = rev;
+      noderev->prop_rep->expanded_size = noderev->prop_rep->size;
+      SVN_ERR(share_final_rep(&noderev->prop_rep, file, fs,
+                              svn_fs_fs__id_txn_id(id, pool), reps_hash,
+                              reps_to_cache, reps_pool, pool));
     }
 
 
   /* Convert our temporary ID into a permanent revision one. */
   SVN_ERR(get_file_offset(&my_offset, file, pool));
 
-  node_id = svn_fs_fs__id_node_id(noderev->id);
+  node_id = svn_fs_fs__id_node_id(noderev->id, pool);
   if (*node_id == '_')
     {
       if (ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
@@ -5601,7 +8427,7 @@ write_final_rev(const svn_fs_id_t **new_id_p,
   else
     my_node_id = node_id;
 
-  copy_id = svn_fs_fs__id_copy_id(noderev->id);
+  copy_id = svn_fs_fs__id_copy_id(noderev->id, pool);
   if (*copy_id == '_')
     {
       if (ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
@@ -5618,6 +8444,26 @@ write_final_rev(const svn_fs_id_t **new_id_p,
   if (noderev->copyroot_rev == SVN_INVALID_REVNUM)
     noderev->copyroot_rev = rev;
 
+  /* Link to the ancestor that a skip-delta would be based on, unless
+     that is just our predecessor. */
+  noderev->predecessor_skip_id = NULL;
+  if (noderev->predecessor_id && noderev->predecessor_count > 1)
+    {
+      int count = noderev->predecessor_count & (noderev->predecessor_count - 1);
+
+      if (count != noderev->predecessor_count - 1)
+        {
+          node_revision_t *ancestor;
+
+          SVN_ERR(svn_fs_fs__get_node_revision(&ancestor, fs,
+                                               noderev->predecessor_id,
+                                               pool));
+          SVN_ERR(svn_fs_fs__get_ancestor(&ancestor, fs, ancestor, count,
+                                          pool));
+          noderev->predecessor_skip_id = ancestor->id;
+        }
+    }
+
   new_id = svn_fs_fs__id_rev_create(my_node_id, my_copy_id, rev, my_offset,
                                     pool);
 
@@ -5688,7 +8534,7 @@ write_final_changed_path_info(apr_off_t *offset_p,
          leave the change entry pointing to the non-existent temporary
          node, since it will never be used. */
       if ((change->change_kind != svn_fs_path_change_delete) &&
-          (! svn_fs_fs__id_txn_id(id)))
+          (! svn_fs_fs__id_is_txn(id)))
         {
           SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, iterpool));
 
@@ -5764,6 +8610,91 @@ write_current(svn_fs_t *fs, svn_revnum_t rev, const char *next_node_id,
   return move_into_place(tmp_name, name, name, pool);
 }
 
+/* For formats with global ID counters, 'current' gets copied to
+   PATH_RECOVERY_IDS every this many revisions, so that recovery needs to
+   scan the revisions after that checkpoint only. */
+#define RECOVERY_CHECKPOINT_INTERVAL 1000
+
+/* Atomically write REV, NEXT_NODE_ID and NEXT_COPY_ID to the recovery
+   checkpoint of FS, in the format of the 'current' file.  Perform
+   temporary allocations in POOL. */
+static svn_error_t *
+write_recovery_ids(svn_fs_t *fs, svn_revnum_t rev, const char *next_node_id,
+                   const char *next_copy_id, apr_pool_t *pool)
+{
+  const char *buf = apr_psprintf(pool, "%ld %s %s\n", rev, next_node_id,
+                                 next_copy_id);
+  const char *name = svn_dirent_join(fs->path, PATH_RECOVERY_IDS, pool);
+  const char *tmp_name;
+
+  SVN_ERR(svn_io_write_unique(&tmp_name, fs->path, buf, strlen(buf),
+                              svn_io_file_del_none, pool));
+
+  return move_into_place(tmp_name, name, svn_fs_fs__path_current(fs, pool),
+                         pool);
+}
+
+/* Return TRUE iff KEY is a valid, non-empty node or copy ID key. */
+static svn_boolean_t
+is_valid_id_key(const char *key)
+{
+  apr_size_t len = strlen(key);
+  apr_size_t i;
+
+  if (len == 0 || len >= MAX_KEY_SIZE)
+    return FALSE;
+
+  for (i = 0; i < len; i++)
+    if (! ((key[i] >= '0' && key[i] <= '9')
+           || (key[i] >= 'a' && key[i] <= 'z')))
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Read the recovery checkpoint of FS.  Set *REV to the revision it was
+   written for and copy the next node and copy IDs recorded for it to
+   NEXT_NODE_ID and NEXT_COPY_ID, which must be arrays of at least
+   MAX_KEY_SIZE.  If there is no usable checkpoint, set *REV to
+   SVN_INVALID_REVNUM.  Perform temporary allocations in POOL. */
+static svn_error_t *
+read_recovery_ids(svn_revnum_t *rev, char *next_node_id, char *next_copy_id,
+                  svn_fs_t *fs, apr_pool_t *pool)
+{
+  const char *name = svn_dirent_join(fs->path, PATH_RECOVERY_IDS, pool);
+  char *buf, *rev_str, *node_id, *copy_id, *last_str;
+  svn_node_kind_t kind;
+  svn_error_t *err;
+
+  *rev = SVN_INVALID_REVNUM;
+
+  SVN_ERR(svn_io_check_path(name, &kind, pool));
+  if (kind != svn_node_file)
+    return SVN_NO_ERROR;
+  SVN_ERR(read_current(name, &buf, pool));
+
+  /* The checkpoint is merely a hint; ignore it unless it is intact. */
+  rev_str = apr_strtok(buf, " ", &last_str);
+  node_id = apr_strtok(NULL, " ", &last_str);
+  copy_id = apr_strtok(NULL, " ", &last_str);
+  if (! rev_str || ! node_id || ! copy_id
+      || apr_strtok(NULL, " ", &last_str)
+      || ! is_valid_id_key(node_id) || ! is_valid_id_key(copy_id))
+    return SVN_NO_ERROR;
+
+  err = svn_revnum_parse(rev, rev_str, NULL);
+  if (err)
+    {
+      svn_error_clear(err);
+      *rev = SVN_INVALID_REVNUM;
+      return SVN_NO_ERROR;
+    }
+
+  apr_cpystrn(next_node_id, node_id, MAX_KEY_SIZE);
+  apr_cpystrn(next_copy_id, copy_id, MAX_KEY_SIZE);
+  return SVN_NO_ERROR;
+}
+
 /* Update the 'current' file to hold the correct next node and copy_ids
    from transaction TXN_ID in filesystem FS.  The current revision is
    set to REV.  Perform temporary allocations in POOL. */
@@ -5790,7 +8721,15 @@ write_final_current(svn_fs_t *fs,
   svn_fs_fs__add_keys(start_node_id, txn_node_id, new_node_id);
   svn_fs_fs__add_keys(start_copy_id, txn_copy_id, new_copy_id);
 
-  return write_current(fs, rev, new_node_id, new_copy_id, pool);
+  SVN_ERR(write_current(fs, rev, new_node_id, new_copy_id, pool));
+
+  /* The revision is live already.  Without a new checkpoint, recovery
+     merely has to scan more revisions. */
+  if (rev % RECOVERY_CHECKPOINT_INTERVAL == 0)
+    svn_error_clear(write_recovery_ids(fs, rev, new_node_id, new_copy_id,
+                                       pool));
+
+  return SVN_NO_ERROR;
 }
 
 /* Verify that the user registed with FS has all the locks necessary to
@@ -5868,6 +8807,50 @@ verify_locks(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Append the final node-revisions, directory contents and changed-path
+   information of transaction TXN_ID in FS as revision NEW_REV to its
+   PROTO_FILE, followed by the revision trailer.  Then flush PROTO_FILE
+   to disk and close it.
+
+   START_NODE_ID, START_COPY_ID, REPS_TO_CACHE and REPS_POOL are passed
+   through to write_final_rev().  Use POOL for allocations. */
+static svn_error_t *
+write_final_proto_rev(svn_fs_t *fs,
+                      const char *txn_id,
+                      svn_revnum_t new_rev,
+                      apr_file_t *proto_file,
+                      const char *start_node_id,
+                      const char *start_copy_id,
+                      apr_array_header_t *reps_to_cache,
+                      apr_pool_t *reps_pool,
+                      apr_pool_t *pool)
+{
+  const svn_fs_id_t *root_id, *new_root_id;
+  apr_off_t changed_path_offset;
+  char *buf;
+
+  /* Write out all the node-revisions and directory contents. */
+  root_id = svn_fs_fs__id_txn_create("0", "0", txn_id, pool);
+  SVN_ERR(write_final_rev(&new_root_id, proto_file, new_rev, fs, root_id,
+                          start_node_id, start_copy_id,
+                          reps_to_cache,
+                          reps_to_cache ? apr_hash_make(pool) : NULL,
+                          reps_pool, pool));
+
+  /* Write the changed-path information. */
+  SVN_ERR(write_final_changed_path_info(&changed_path_offset, proto_file,
+                                        fs, txn_id, pool));
+
+  /* Write the final line. */
+  buf = apr_psprintf(pool, "\n%" APR_OFF_T_FMT " %" APR_OFF_T_FMT "\n",
+                     svn_fs_fs__id_offset(new_root_id),
+                     changed_path_offset);
+  SVN_ERR(svn_io_file_write_full(proto_file, buf, strlen(buf), NULL,
+                                 pool));
+  SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
+  return svn_io_file_close(proto_file, pool);
+}
+
 /* Baton used for commit_body below. */
 struct commit_baton {
   svn_revnum_t *new_rev_p;
@@ -5875,6 +8858,16 @@ struct commit_baton {
   svn_fs_txn_t *txn;
   apr_array_header_t *reps_to_cache;
   apr_pool_t *reps_pool;
+
+  /* If TRUE, prepare_commit() has already written the proto-rev file
+     as revision TXN->BASE_REV + 1 and PROTO_FILE_LOCKCOOKIE is the
+     lock still held on it.  Otherwise, commit_body() has to do both. */
+  svn_boolean_t prepared;
+  void *proto_file_lockcookie;
+
+  /* The size of the proto-rev file before it was prepared.  The file
+     gets truncated to that size if the prepared commit fails. */
+  apr_off_t proto_file_size;
 };
 
 /* The work-horse for svn_fs_fs__commit, called with the FS write lock.
@@ -5887,13 +8880,9 @@ commit_body(void *baton, apr_pool_t *pool)
   fs_fs_data_t *ffd = cb->fs->fsap_data;
   const char *old_rev_filename, *rev_filename, *proto_filename;
   const char *revprop_filename, *final_revprop;
-  const svn_fs_id_t *root_id, *new_root_id;
   const char *start_node_id = NULL, *start_copy_id = NULL;
   svn_revnum_t old_rev, new_rev;
   apr_file_t *proto_file;
-  void *proto_file_lockcookie;
-  apr_off_t changed_path_offset;
-  char *buf;
   apr_hash_t *txnprops;
   apr_array_header_t *txnprop_list;
   svn_prop_t prop;
@@ -5922,29 +8911,16 @@ commit_body(void *baton, apr_pool_t *pool)
   /* We are going to be one better than this puny old revision. */
   new_rev = old_rev + 1;
 
-  /* Get a write handle on the proto revision file. */
-  SVN_ERR(get_writable_proto_rev(&proto_file, &proto_file_lockcookie,
-                                 cb->fs, cb->txn->id, pool));
-
-  /* Write out all the node-revisions and directory contents. */
-  root_id = svn_fs_fs__id_txn_create("0", "0", cb->txn->id, pool);
-  SVN_ERR(write_final_rev(&new_root_id, proto_file, new_rev, cb->fs, root_id,
-                          start_node_id, start_copy_id,
-                          cb->reps_to_cache, cb->reps_pool,
-                          pool));
-
-  /* Write the changed-path information. */
-  SVN_ERR(write_final_changed_path_info(&changed_path_offset, proto_file,
-                                        cb->fs, cb->txn->id, pool));
-
-  /* Write the final line. */
-  buf = apr_psprintf(pool, "\n%" APR_OFF_T_FMT " %" APR_OFF_T_FMT "\n",
-                     svn_fs_fs__id_offset(new_root_id),
-                     changed_path_offset);
-  SVN_ERR(svn_io_file_write_full(proto_file, buf, strlen(buf), NULL,
-                                 pool));
-  SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
-  SVN_ERR(svn_io_file_close(proto_file, pool));
+  /* Unless prepare_commit() did this already, write the final revision
+     contents to the proto revision file. */
+  if (! cb->prepared)
+    {
+      SVN_ERR(get_writable_proto_rev(&proto_file, &cb->proto_file_lockcookie,
+                                     cb->fs, cb->txn->id, pool));
+      SVN_ERR(write_final_proto_rev(cb->fs, cb->txn->id, new_rev,
+                                    proto_file, start_node_id, start_copy_id,
+                                    cb->reps_to_cache, cb->reps_pool, pool));
+    }
 
   /* We don't unlock the prototype revision file immediately to avoid a
      race with another caller writing to the prototype revision file
@@ -6016,7 +8992,9 @@ commit_body(void *baton, apr_pool_t *pool)
      we can unlock it (since further attempts to write to the file
      will fail as it no longer exists).  We must do this so that we can
      remove the transaction directory later. */
-  SVN_ERR(unlock_proto_rev(cb->fs, cb->txn->id, proto_file_lockcookie, pool));
+  SVN_ERR(unlock_proto_rev(cb->fs, cb->txn->id, cb->proto_file_lockcookie,
+                           pool));
+  cb->proto_file_lockcookie = NULL;
 
   /* Update commit time to ensure that svn:date revprops remain ordered. */
   date.data = svn_time_to_cstring(apr_time_now(), pool);
@@ -6059,6 +9037,13 @@ commit_body(void *baton, apr_pool_t *pool)
 
   *cb->new_rev_p = new_rev;
 
+  /* The mergeinfo index merely speeds up queries.  Failing to update it
+     must not fail a commit which is visible already; the next commit
+     will catch up. */
+  svn_error_clear(svn_fs_fs__update_mergeinfo_index(cb->fs, new_rev, pool));
+  svn_error_clear(svn_fs_fs__update_log_index(cb->fs, new_rev, pool));
+  svn_error_clear(svn_fs_fs__update_date_index(cb->fs, new_rev, pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -6076,6 +9061,7 @@ commit_obliteration_body(void *baton, apr_pool_t *pool)
   const char *start_node_id = NULL, *start_copy_id = NULL;
   svn_revnum_t rev = *cb->new_rev_p;
   svn_revnum_t old_rev = rev, new_rev = rev;  /* ### relics of normal commit */
+  svn_revnum_t youngest;
   apr_file_t *proto_file;
   void *proto_file_lockcookie;
   apr_off_t changed_path_offset;
@@ -6103,8 +9089,9 @@ commit_obliteration_body(void *baton, apr_pool_t *pool)
   root_id = svn_fs_fs__id_txn_create("0", "0", cb->txn->id, pool);
   SVN_ERR(write_final_rev(&new_root_id, proto_file, new_rev, cb->fs, root_id,
                           start_node_id, start_copy_id,
-                          cb->reps_to_cache, cb->reps_pool,
-                          pool));
+                          cb->reps_to_cache,
+                          cb->reps_to_cache ? apr_hash_make(pool) : NULL,
+                          cb->reps_pool, pool));
 
   /* Write the changed-path information. */
   SVN_ERR(write_final_changed_path_info(&changed_path_offset, proto_file,
@@ -6154,45 +9141,134 @@ commit_obliteration_body(void *baton, apr_pool_t *pool)
   /* Remove this transaction directory. */
   SVN_ERR(svn_fs_fs__purge_txn(cb->fs, cb->txn->id, pool));
 
+  /* The mergeinfo of REV and of any copies made from it may have
+     changed, so index those revisions again. */
+  SVN_ERR(svn_fs_fs__reset_mergeinfo_index(cb->fs, rev, pool));
+  SVN_ERR(svn_fs_fs__reset_log_index(cb->fs, rev, pool));
+  SVN_ERR(svn_fs_fs__reset_date_index(cb->fs, rev, pool));
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, cb->fs, pool));
+
+  /* The new node-revisions of REV may use IDs the recovery checkpoint
+     does not account for.  Make recovery scan all revisions again. */
+  if (ffd->format < SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    SVN_ERR(svn_io_remove_file2(svn_dirent_join(cb->fs->path,
+                                                PATH_RECOVERY_IDS, pool),
+                                TRUE, pool));
+
+  svn_error_clear(svn_fs_fs__update_mergeinfo_index(cb->fs, youngest, pool));
+  svn_error_clear(svn_fs_fs__update_log_index(cb->fs, youngest, pool));
+  svn_error_clear(svn_fs_fs__update_date_index(cb->fs, youngest, pool));
+
   return SVN_NO_ERROR;
 }
 
 /* Add the representations in REPS_TO_CACHE (an array of representation_t *)
- * to the rep-cache database of FS. */
+ * to the rep-cache database of FS.  The entries are queued and written in
+ * batches of FFD->REP_BATCH_MAX_REVISIONS revisions. */
 static svn_error_t *
 write_reps_to_cache(svn_fs_t *fs,
                     const apr_array_header_t *reps_to_cache,
                     apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   int i;
 
   for (i = 0; i < reps_to_cache->nelts; i++)
     {
       representation_t *rep = APR_ARRAY_IDX(reps_to_cache, i, representation_t *);
 
-      /* FALSE because we don't care if another parallel commit happened to
-       * collide with us.  (Non-parallel collisions will not be detected.) */
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, rep, FALSE, scratch_pool));
+      /* We don't care if another parallel commit happened to collide
+       * with us.  (Non-parallel collisions will not be detected.) */
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__queue_rep_reference(fs, rep, iterpool));
     }
+  svn_pool_destroy(iterpool);
+
+  if (++ffd->rep_batch_revisions >= ffd->rep_batch_max_revisions)
+    SVN_ERR(svn_fs_fs__flush_rep_references(fs, scratch_pool));
 
   return SVN_NO_ERROR;
 }
 
-/* Implements svn_sqlite__transaction_callback_t. */
+/* Write the final contents of the revision to be created from CB->TXN
+   to its proto-rev file without holding the FS write lock.
+
+   This is possible because a commit can only succeed if the txn's base
+   revision is still the youngest one once the write lock has been
+   acquired, i.e. the new revision number is known in advance.
+   commit_body() will check that and bail out otherwise, in which case
+   rollback_prepared_commit() must be called.  Only FS formats without
+   global node and copy ID counters are supported.
+
+   Use POOL for allocations. */
 static svn_error_t *
-commit_sqlite_txn_callback(void *baton, svn_sqlite__db_t *db,
-                           apr_pool_t *scratch_pool)
+prepare_commit(struct commit_baton *cb,
+               apr_pool_t *pool)
 {
-  struct commit_baton *cb = baton;
+  apr_file_t *proto_file;
+  svn_error_t *err;
 
-  /* Write new entries to the rep-sharing database.
-   *
-   * We use an sqlite transcation to speed things up;
-   * see <http://www.sqlite.org/faq.html#q19>.
-   */
-  SVN_ERR(write_reps_to_cache(cb->fs, cb->reps_to_cache, scratch_pool));
+  SVN_ERR(get_writable_proto_rev(&proto_file, &cb->proto_file_lockcookie,
+                                 cb->fs, cb->txn->id, pool));
+  cb->prepared = TRUE;
 
-  return SVN_NO_ERROR;
+  err = get_file_offset(&cb->proto_file_size, proto_file, pool);
+  if (err)
+    {
+      cb->proto_file_size = -1;
+      svn_error_clear(svn_io_file_close(proto_file, pool));
+      return svn_error_return(err);
+    }
+
+  /* On failure, the caller's rollback will truncate the file again. */
+  err = write_final_proto_rev(cb->fs, cb->txn->id, cb->txn->base_rev + 1,
+                              proto_file, NULL, NULL, cb->reps_to_cache,
+                              cb->reps_pool, pool);
+  if (err)
+    svn_error_clear(svn_io_file_close(proto_file, pool));
+
+  return svn_error_return(err);
+}
+
+/* Undo a prepare_commit() for CB, whose commit failed: strip the final
+   revision contents from the proto-rev file, if they got written, and
+   release the lock on it.  Use POOL for temporary allocations. */
+static svn_error_t *
+rollback_prepared_commit(struct commit_baton *cb,
+                         apr_pool_t *pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (cb->reps_to_cache)
+    apr_array_clear(cb->reps_to_cache);
+
+  /* The proto-rev file has already been moved into place. */
+  if (cb->proto_file_lockcookie == NULL)
+    return SVN_NO_ERROR;
+
+  if (cb->proto_file_size >= 0)
+    {
+      apr_file_t *proto_file;
+
+      err = svn_io_file_open(&proto_file,
+                             path_txn_proto_rev(cb->fs, cb->txn->id, pool),
+                             APR_WRITE, APR_OS_DEFAULT, pool);
+      if (!err)
+        {
+          err = svn_io_file_trunc(proto_file, cb->proto_file_size, pool);
+          err = svn_error_compose_create(err,
+                                         svn_io_file_close(proto_file, pool));
+        }
+    }
+
+  err = svn_error_compose_create(err,
+                                 unlock_proto_rev(cb->fs, cb->txn->id,
+                                                  cb->proto_file_lockcookie,
+                                                  pool));
+  cb->proto_file_lockcookie = NULL;
+
+  return svn_error_return(err);
 }
 
 svn_error_t *
@@ -6203,10 +9279,14 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
 {
   struct commit_baton cb;
   fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err;
 
   cb.new_rev_p = new_rev_p;
   cb.fs = fs;
   cb.txn = txn;
+  cb.prepared = FALSE;
+  cb.proto_file_lockcookie = NULL;
+  cb.proto_file_size = -1;
 
   if (ffd->rep_sharing_allowed)
     {
@@ -6219,15 +9299,36 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
       cb.reps_pool = NULL;
     }
 
-  SVN_ERR(svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool));
+  /* Do as much of the commit as possible before taking the write lock,
+     so concurrent commits will only be serialized for renumbering the
+     revision and bumping the 'current' file. */
+  if (ffd->prepare_commits
+      && ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    {
+      svn_revnum_t youngest;
+
+      /* Don't bother, if we already know that the txn is out of date. */
+      SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, pool));
+      if (txn->base_rev == youngest)
+        {
+          err = prepare_commit(&cb, pool);
+          if (err)
+            return svn_error_compose_create(err,
+                                            rollback_prepared_commit(&cb,
+                                                                     pool));
+        }
+    }
+
+  err = svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool);
+  if (err && cb.prepared)
+    err = svn_error_compose_create(err, rollback_prepared_commit(&cb, pool));
+  SVN_ERR(err);
 
   if (ffd->rep_sharing_allowed)
     {
       /* ### TODO: ignore errors opening the DB (issue #3506) * */
       SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
-      SVN_ERR(svn_sqlite__with_transaction(ffd->rep_cache_db,
-                                           commit_sqlite_txn_callback,
-                                           &cb, pool));
+      SVN_ERR(write_reps_to_cache(fs, cb.reps_to_cache, pool));
     }
 
   return SVN_NO_ERROR;
@@ -6267,9 +9368,7 @@ svn_fs_fs__commit_obliteration(svn_revnum_t rev,
     {
       /* ###
        * SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
-       * SVN_ERR(svn_sqlite__with_transaction(ffd->rep_cache_db,
-       *                                      commit_sqlite_txn_callback,
-       *                                      &cb, pool));
+       * SVN_ERR(write_reps_to_cache(fs, cb.reps_to_cache, pool));
        */
     }
 
@@ -6351,6 +9450,9 @@ svn_fs_fs__create(svn_fs_t *fs,
       else if (apr_hash_get(fs->config, SVN_FS_CONFIG_PRE_1_7_COMPATIBLE,
                                         APR_HASH_KEY_STRING))
         format = 4;
+      else if (apr_hash_get(fs->config, SVN_FS_CONFIG_PRE_1_8_COMPATIBLE,
+                                        APR_HASH_KEY_STRING))
+        format = 6;
     }
   ffd->format = format;
 
@@ -6386,7 +9488,7 @@ svn_fs_fs__create(svn_fs_t *fs,
                                                     PATH_REVPROPS_DB,
                                                     NULL),
                                svn_sqlite__mode_rwcreate, statements,
-                               0, NULL,
+                               0, NULL, NULL,
                                fs->pool, pool));
       SVN_ERR(svn_sqlite__exec_statements(ffd->revprop_db,
                                           STMT_CREATE_SCHEMA));
@@ -6413,6 +9515,20 @@ svn_fs_fs__create(svn_fs_t *fs,
 
   SVN_ERR(write_revision_zero(fs));
 
+  /* Create the index of paths with mergeinfo. */
+  if (format >= SVN_FS_FS__MIN_MERGEINFO_FORMAT)
+    SVN_ERR(svn_fs_fs__create_mergeinfo_index(fs, pool));
+
+  /* And the index of changed subtrees. */
+  SVN_ERR(svn_fs_fs__create_log_index(fs, pool));
+
+  /* And the index of revision dates; the first commit adds r0. */
+  SVN_ERR(svn_fs_fs__create_date_index(fs, pool));
+
+  /* And the lock database. */
+  if (format >= SVN_FS_FS__MIN_LOCKS_DB_FORMAT)
+    SVN_ERR(svn_fs_fs__create_locks_db(fs, pool));
+
   SVN_ERR(write_config(fs, pool));
 
   SVN_ERR(read_config(fs, pool));
@@ -6660,8 +9776,8 @@ recover_find_max_ids(svn_fs_t *fs, svn_revnum_t rev,
           continue;
         }
 
-      node_id = svn_fs_fs__id_node_id(id);
-      copy_id = svn_fs_fs__id_copy_id(id);
+      node_id = svn_fs_fs__id_node_id(id, iterpool);
+      copy_id = svn_fs_fs__id_copy_id(id, iterpool);
 
       if (svn_fs_fs__key_compare(node_id, max_node_id) > 0)
         {
@@ -6759,12 +9875,24 @@ recover_body(void *baton, apr_pool_t *pool)
          filesystem.  Unfortunately, the only way we can get this information
          is to scan all the noderevs of all the revisions and keep track as
          we go along. */
-      svn_revnum_t rev;
+      svn_revnum_t rev, start_rev = 0, checkpoint_rev;
       apr_pool_t *iterpool = svn_pool_create(pool);
       char max_node_id[MAX_KEY_SIZE] = "0", max_copy_id[MAX_KEY_SIZE] = "0";
+      char checkpoint_node_id[MAX_KEY_SIZE], checkpoint_copy_id[MAX_KEY_SIZE];
       apr_size_t len;
 
-      for (rev = 0; rev <= max_rev; rev++)
+      /* Commits record the next IDs every now and then.  All revisions
+         up to such a checkpoint are known to use smaller IDs, so only
+         the ones after it need to be scanned.  A checkpoint beyond the
+         revisions we found is of no use, though. */
+      SVN_ERR(read_recovery_ids(&checkpoint_rev, checkpoint_node_id,
+                                checkpoint_copy_id, fs, pool));
+      if (SVN_IS_VALID_REVNUM(checkpoint_rev) && checkpoint_rev <= max_rev)
+        start_rev = checkpoint_rev + 1;
+      else
+        checkpoint_rev = SVN_INVALID_REVNUM;
+
+      for (rev = start_rev; rev <= max_rev; rev++)
         {
           apr_file_t *rev_file;
           apr_off_t root_offset;
@@ -6791,6 +9919,14 @@ recover_body(void *baton, apr_pool_t *pool)
       len = strlen(max_copy_id);
       svn_fs_fs__next_key(max_copy_id, &len, next_copy_id_buf);
       next_copy_id = next_copy_id_buf;
+
+      if (SVN_IS_VALID_REVNUM(checkpoint_rev))
+        {
+          if (svn_fs_fs__key_compare(checkpoint_node_id, next_node_id) > 0)
+            apr_cpystrn(next_node_id_buf, checkpoint_node_id, MAX_KEY_SIZE);
+          if (svn_fs_fs__key_compare(checkpoint_copy_id, next_copy_id) > 0)
+            apr_cpystrn(next_copy_id_buf, checkpoint_copy_id, MAX_KEY_SIZE);
+        }
     }
 
   /* Before setting current, verify that there is a revprops file
@@ -6899,137 +10035,6 @@ svn_fs_fs__ensure_dir_exists(const char *path,
   return svn_fs_fs__dup_perms(path, fs->path, pool);
 }
 
-/* Set *NODE_ORIGINS to a hash mapping 'const char *' node IDs to
-   'svn_string_t *' node revision IDs.  Use POOL for allocations. */
-static svn_error_t *
-get_node_origins_from_file(svn_fs_t *fs,
-                           apr_hash_t **node_origins,
-                           const char *node_origins_file,
-                           apr_pool_t *pool)
-{
-  apr_file_t *fd;
-  svn_error_t *err;
-  svn_stream_t *stream;
-
-  *node_origins = NULL;
-  err = svn_io_file_open(&fd, node_origins_file,
-                         APR_READ, APR_OS_DEFAULT, pool);
-  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
-    {
-      svn_error_clear(err);
-      return SVN_NO_ERROR;
-    }
-  SVN_ERR(err);
-
-  stream = svn_stream_from_aprfile2(fd, FALSE, pool);
-  *node_origins = apr_hash_make(pool);
-  SVN_ERR(svn_hash_read2(*node_origins, stream, SVN_HASH_TERMINATOR, pool));
-  return svn_stream_close(stream);
-}
-
-svn_error_t *
-svn_fs_fs__get_node_origin(const svn_fs_id_t **origin_id,
-                           svn_fs_t *fs,
-                           const char *node_id,
-                           apr_pool_t *pool)
-{
-  apr_hash_t *node_origins;
-
-  *origin_id = NULL;
-  SVN_ERR(get_node_origins_from_file(fs, &node_origins,
-                                     path_node_origin(fs, node_id, pool),
-                                     pool));
-  if (node_origins)
-    {
-      svn_string_t *origin_id_str =
-        apr_hash_get(node_origins, node_id, APR_HASH_KEY_STRING);
-      if (origin_id_str)
-        *origin_id = svn_fs_fs__id_parse(origin_id_str->data,
-                                         origin_id_str->len, pool);
-    }
-  return SVN_NO_ERROR;
-}
-
-
-/* Helper for svn_fs_fs__set_node_origin.  Takes a NODE_ID/NODE_REV_ID
-   pair and adds it to the NODE_ORIGINS_PATH file.  */
-static svn_error_t *
-set_node_origins_for_file(svn_fs_t *fs,
-                          const char *node_origins_path,
-                          const char *node_id,
-                          svn_string_t *node_rev_id,
-                          apr_pool_t *pool)
-{
-  const char *path_tmp;
-  svn_stream_t *stream;
-  apr_hash_t *origins_hash;
-  svn_string_t *old_node_rev_id;
-
-  SVN_ERR(svn_fs_fs__ensure_dir_exists(svn_dirent_join(fs->path,
-                                                       PATH_NODE_ORIGINS_DIR,
-                                                       pool),
-                                       fs, pool));
-
-  /* Read the previously existing origins (if any), and merge our
-     update with it. */
-  SVN_ERR(get_node_origins_from_file(fs, &origins_hash,
-                                     node_origins_path, pool));
-  if (! origins_hash)
-    origins_hash = apr_hash_make(pool);
-
-  old_node_rev_id = apr_hash_get(origins_hash, node_id, APR_HASH_KEY_STRING);
-
-  if (old_node_rev_id && !svn_string_compare(node_rev_id, old_node_rev_id))
-    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                             _("Node origin for '%s' exists with a different "
-                               "value (%s) than what we were about to store "
-                               "(%s)"),
-                             node_id, old_node_rev_id->data, node_rev_id->data);
-
-  apr_hash_set(origins_hash, node_id, APR_HASH_KEY_STRING, node_rev_id);
-
-  /* Sure, there's a race condition here.  Two processes could be
-     trying to add different cache elements to the same file at the
-     same time, and the entries added by the first one to write will
-     be lost.  But this is just a cache of reconstructible data, so
-     we'll accept this problem in return for not having to deal with
-     locking overhead. */
-
-  /* Create a temporary file, write out our hash, and close the file. */
-  SVN_ERR(svn_stream_open_unique(&stream, &path_tmp,
-                                 svn_dirent_dirname(node_origins_path, pool),
-                                 svn_io_file_del_none, pool, pool));
-  SVN_ERR(svn_hash_write2(origins_hash, stream, SVN_HASH_TERMINATOR, pool));
-  SVN_ERR(svn_stream_close(stream));
-
-  /* Rename the temp file as the real destination */
-  return svn_io_file_rename(path_tmp, node_origins_path, pool);
-}
-
-
-svn_error_t *
-svn_fs_fs__set_node_origin(svn_fs_t *fs,
-                           const char *node_id,
-                           const svn_fs_id_t *node_rev_id,
-                           apr_pool_t *pool)
-{
-  svn_error_t *err;
-  const char *filename = path_node_origin(fs, node_id, pool);
-
-  err = set_node_origins_for_file(fs, filename,
-                                  node_id,
-                                  svn_fs_fs__id_unparse(node_rev_id, pool),
-                                  pool);
-  if (err && APR_STATUS_IS_EACCES(err->apr_err))
-    {
-      /* It's just a cache; stop trying if I can't write. */
-      svn_error_clear(err);
-      err = NULL;
-    }
-  return svn_error_return(err);
-}
-
-
 svn_error_t *
 svn_fs_fs__list_transactions(apr_array_header_t **names_p,
                              svn_fs_t *fs,
@@ -7081,6 +10086,12 @@ svn_fs_fs__open_txn(svn_fs_txn_t **txn_p,
   svn_node_kind_t kind;
   transaction_t *local_txn;
 
+  /* Node-revision IDs keep the txn name in binary form, so reject
+     names that could not be represented there. */
+  if (! svn_fs_fs__id_txn_id_valid(name))
+    return svn_error_create(SVN_ERR_FS_NO_SUCH_TRANSACTION, NULL,
+                            _("No such transaction"));
+
   /* First check to see if the directory exists. */
   SVN_ERR(svn_io_check_path(path_txn_dir(fs, name, pool), &kind, pool));
 
@@ -7123,6 +10134,13 @@ svn_fs_fs__delete_node_revision(svn_fs_t *fs,
                                 apr_pool_t *pool)
 {
   node_revision_t *noderev;
+  const char *log_dir, *node_key;
+
+  /* In a node log, a single record drops everything about the node. */
+  SVN_ERR(get_txn_node_log(&log_dir, &node_key, fs, id, pool));
+  if (log_dir)
+    return svn_fs_fs__txn_log_append(log_dir, svn_fs_fs__txn_log_delete,
+                                     node_key, "", 0, pool);
 
   SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool));
 
@@ -7178,13 +10196,30 @@ static svn_error_t *
 change_rev_prop_body(void *baton, apr_pool_t *pool)
 {
   struct change_rev_prop_baton *cb = baton;
+  fs_fs_data_t *ffd = cb->fs->fsap_data;
   apr_hash_t *table;
 
-  SVN_ERR(svn_fs_fs__revision_proplist(&table, cb->fs, cb->rev, pool));
+  /* Base the change on what is on disk, not on what may be cached. */
+  SVN_ERR(get_revision_proplist(&table, cb->fs, cb->rev, FALSE, pool));
 
   apr_hash_set(table, cb->name, APR_HASH_KEY_STRING, cb->value);
 
-  return set_revision_proplist(cb->fs, cb->rev, table, pool);
+  SVN_ERR(set_revision_proplist(cb->fs, cb->rev, table, pool));
+
+  /* Invalidate the revprops that this process has cached so far. */
+  svn_atomic_inc(&ffd->shared->revprop_generation);
+
+  /* Index the new date of CB->REV, and everything after it again. */
+  if (strcmp(cb->name, SVN_PROP_REVISION_DATE) == 0)
+    {
+      svn_revnum_t youngest;
+
+      SVN_ERR(svn_fs_fs__reset_date_index(cb->fs, cb->rev, pool));
+      SVN_ERR(svn_fs_fs__youngest_rev(&youngest, cb->fs, pool));
+      svn_error_clear(svn_fs_fs__update_date_index(cb->fs, youngest, pool));
+    }
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -7315,28 +10350,52 @@ svn_fs_fs__begin_obliteration_txn(svn_fs_txn_t **txn_p,
 
 
 /****** Packing FSFS shards *********/
-/* Pack a single shard SHARD in REVS_DIR, using POOL for allocations.
+
+/* Append OFFSET to the binary pack index in STREAM. */
+static svn_error_t *
+write_pack_index_value(svn_stream_t *stream,
+                       apr_off_t offset)
+{
+  char buffer[MANIFEST_INDEX_ENTRY_SIZE];
+  apr_size_t len = sizeof(buffer);
+  apr_uint64_t value = (apr_uint64_t)offset;
+  int i;
+
+  /* big-endian, independent of the platform */
+  for (i = MANIFEST_INDEX_ENTRY_SIZE - 1; i >= 0; --i)
+    {
+      buffer[i] = (char)(value & 0xff);
+      value >>= 8;
+    }
+
+  return svn_stream_write(stream, buffer, &len);
+}
+
+/* Squash the revision files of shard SHARD in REVS_DIR into a pack file
+   with manifest, manifest index and changes index, using POOL for
+   allocations.
    CANCEL_FUNC and CANCEL_BATON are what you think they are.
 
+   This leaves the unpacked shard and the min-unpacked-rev file alone,
+   i.e. readers won't see the pack file until publish_rev_shard() gets
+   called.  Hence, this does not require the write lock.
+
    If for some reason we detect a partial packing already performed, we
    remove the pack file and start again. */
 static svn_error_t *
-pack_shard(const char *revs_dir,
-           const char *fs_path,
-           apr_int64_t shard,
-           int max_files_per_dir,
-           svn_fs_pack_notify_t notify_func,
-           void *notify_baton,
-           svn_cancel_func_t cancel_func,
-           void *cancel_baton,
-           apr_pool_t *pool)
+copy_rev_shard(const char *revs_dir,
+               apr_int64_t shard,
+               int max_files_per_dir,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *pool)
 {
-  const char *tmp_path, *final_path;
   const char *pack_file_path, *manifest_file_path, *shard_path;
+  const char *index_file_path, *changes_index_path;
   const char *pack_file_dir;
-  svn_stream_t *pack_stream, *manifest_stream;
+  svn_stream_t *pack_stream, *manifest_stream, *index_stream;
+  svn_stream_t *changes_index_stream;
   svn_revnum_t start_rev, end_rev, rev;
-  svn_stream_t *tmp_stream;
   apr_off_t next_offset;
   apr_pool_t *iterpool;
 
@@ -7346,15 +10405,14 @@ pack_shard(const char *revs_dir,
                         pool);
   pack_file_path = svn_dirent_join(pack_file_dir, "pack", pool);
   manifest_file_path = svn_dirent_join(pack_file_dir, "manifest", pool);
+  index_file_path = svn_dirent_join(pack_file_dir,
+                                    PATH_PACKED_MANIFEST_INDEX, pool);
+  changes_index_path = svn_dirent_join(pack_file_dir,
+                                       PATH_PACKED_CHANGES_INDEX, pool);
   shard_path = svn_dirent_join(revs_dir,
                              apr_psprintf(pool, "%" APR_INT64_T_FMT, shard),
                              pool);
 
-  /* Notify caller we're starting to pack this shard. */
-  if (notify_func)
-    SVN_ERR(notify_func(notify_baton, shard, svn_fs_pack_notify_start,
-                        pool));
-
   /* Remove any existing pack file for this shard, since it is incomplete. */
   SVN_ERR(svn_io_remove_dir2(pack_file_dir, TRUE, cancel_func, cancel_baton,
                              pool));
@@ -7365,6 +10423,10 @@ pack_shard(const char *revs_dir,
                                     pool));
   SVN_ERR(svn_stream_open_writable(&manifest_stream, manifest_file_path,
                                    pool, pool));
+  SVN_ERR(svn_stream_open_writable(&index_stream, index_file_path,
+                                   pool, pool));
+  SVN_ERR(svn_stream_open_writable(&changes_index_stream, changes_index_path,
+                                   pool, pool));
 
   start_rev = (svn_revnum_t) (shard * max_files_per_dir);
   end_rev = (svn_revnum_t) ((shard + 1) * (max_files_per_dir) - 1);
@@ -7375,47 +10437,114 @@ pack_shard(const char *revs_dir,
   for (rev = start_rev; rev <= end_rev; rev++)
     {
       svn_stream_t *rev_stream;
+      apr_file_t *rev_file;
       apr_finfo_t finfo;
+      apr_off_t changes_offset;
       const char *path;
 
       svn_pool_clear(iterpool);
 
-      /* Get the size of the file. */
+      /* Get the size of the file and the start of its changed paths. */
       path = svn_dirent_join(shard_path, apr_psprintf(iterpool, "%ld", rev),
                              iterpool);
-      SVN_ERR(svn_io_stat(&finfo, path, APR_FINFO_SIZE, iterpool));
+      SVN_ERR(svn_io_file_open(&rev_file, path, APR_READ | APR_BUFFERED,
+                               APR_OS_DEFAULT, iterpool));
+      SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, rev_file,
+                                   iterpool));
+      SVN_ERR(read_revision_trailer(NULL, &changes_offset, rev_file,
+                                    finfo.size, iterpool));
 
-      /* Update the manifest. */
+      /* Update the manifest and the indexes. */
       svn_stream_printf(manifest_stream, iterpool, "%" APR_OFF_T_FMT "\n",
                         next_offset);
+      SVN_ERR(write_pack_index_value(index_stream, next_offset));
+      SVN_ERR(write_pack_index_value(changes_index_stream,
+                                     next_offset + changes_offset));
+      SVN_ERR(write_pack_index_value(changes_index_stream,
+                                     next_offset + finfo.size));
       next_offset += finfo.size;
 
       /* Copy all the bits from the rev file to the end of the pack file. */
-      SVN_ERR(svn_stream_open_readonly(&rev_stream, path, iterpool, iterpool));
+      changes_offset = 0;
+      SVN_ERR(svn_io_file_seek(rev_file, APR_SET, &changes_offset, iterpool));
+      rev_stream = svn_stream_from_aprfile2(rev_file, FALSE, iterpool);
       SVN_ERR(svn_stream_copy3(rev_stream, svn_stream_disown(pack_stream,
                                                              iterpool),
                           cancel_func, cancel_baton, iterpool));
     }
+  svn_pool_destroy(iterpool);
 
   SVN_ERR(svn_stream_close(manifest_stream));
+  SVN_ERR(svn_stream_close(index_stream));
+  SVN_ERR(svn_stream_close(changes_index_stream));
   SVN_ERR(svn_stream_close(pack_stream));
-  SVN_ERR(svn_fs_fs__dup_perms(pack_file_dir, shard_path, pool));
+  return svn_fs_fs__dup_perms(pack_file_dir, shard_path, pool);
+}
+
+/* Make the pack file of shard SHARD in REVS_DIR, created by
+   copy_rev_shard(), visible to readers of the filesystem at FS_PATH and
+   remove the now redundant unpacked shard.  The caller must hold the
+   write lock.  Use POOL for allocations. */
+static svn_error_t *
+publish_rev_shard(const char *revs_dir,
+                  const char *fs_path,
+                  apr_int64_t shard,
+                  int max_files_per_dir,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *pool)
+{
+  const char *tmp_path, *final_path, *shard_path;
+  svn_stream_t *tmp_stream;
+
+  shard_path = svn_dirent_join(revs_dir,
+                             apr_psprintf(pool, "%" APR_INT64_T_FMT, shard),
+                             pool);
 
   /* Update the min-unpacked-rev file to reflect our newly packed shard.
    * (ffd->min_unpacked_rev will be updated by open_pack_or_rev_file().)
    */
-  final_path = svn_dirent_join(fs_path, PATH_MIN_UNPACKED_REV, iterpool);
+  final_path = svn_dirent_join(fs_path, PATH_MIN_UNPACKED_REV, pool);
   SVN_ERR(svn_stream_open_unique(&tmp_stream, &tmp_path, fs_path,
-                                   svn_io_file_del_none, iterpool, iterpool));
-  SVN_ERR(svn_stream_printf(tmp_stream, iterpool, "%ld\n",
+                                   svn_io_file_del_none, pool, pool));
+  SVN_ERR(svn_stream_printf(tmp_stream, pool, "%ld\n",
                             (svn_revnum_t) ((shard + 1) * max_files_per_dir)));
   SVN_ERR(svn_stream_close(tmp_stream));
-  SVN_ERR(move_into_place(tmp_path, final_path, final_path, iterpool));
-  svn_pool_destroy(iterpool);
+  SVN_ERR(move_into_place(tmp_path, final_path, final_path, pool));
 
   /* Finally, remove the existing shard directory. */
-  SVN_ERR(svn_io_remove_dir2(shard_path, TRUE, cancel_func, cancel_baton,
-                             pool));
+  return svn_io_remove_dir2(shard_path, TRUE, cancel_func, cancel_baton,
+                            pool);
+}
+
+/* Pack a single shard SHARD in REVS_DIR of the filesystem at FS_PATH,
+   using POOL for allocations.  If COPIED is set, the pack file has
+   already been created by copy_rev_shard() and only needs to be
+   published.  The caller must hold the write lock.  NOTIFY_FUNC,
+   NOTIFY_BATON, CANCEL_FUNC and CANCEL_BATON are what you think they
+   are. */
+static svn_error_t *
+pack_shard(const char *revs_dir,
+           const char *fs_path,
+           apr_int64_t shard,
+           int max_files_per_dir,
+           svn_boolean_t copied,
+           svn_fs_pack_notify_t notify_func,
+           void *notify_baton,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *pool)
+{
+  /* Notify caller we're starting to pack this shard. */
+  if (notify_func)
+    SVN_ERR(notify_func(notify_baton, shard, svn_fs_pack_notify_start,
+                        pool));
+
+  if (! copied)
+    SVN_ERR(copy_rev_shard(revs_dir, shard, max_files_per_dir,
+                           cancel_func, cancel_baton, pool));
+  SVN_ERR(publish_rev_shard(revs_dir, fs_path, shard, max_files_per_dir,
+                            cancel_func, cancel_baton, pool));
 
   /* Notify caller we're starting to pack this shard. */
   if (notify_func)
@@ -7501,56 +10630,88 @@ struct pack_baton
   void *notify_baton;
   svn_cancel_func_t cancel_func;
   void *cancel_baton;
+
+  /* Revision shards FIRST_COPIED up to but not including END_COPIED
+     have already been copied into their pack files by copy_rev_shard(). */
+  apr_int64_t first_copied;
+  apr_int64_t end_copied;
+
+  /* Don't pack shards beyond this one, e.g. because copying it failed.
+     Negative values mean no limit. */
+  apr_int64_t end_shard;
 };
 
+/* Read the pack-relevant state of PB->FS from disk: the format number
+   *FORMAT, *MAX_FILES_PER_DIR, the first revision *MIN_UNPACKED_REV and
+   revprop *MIN_UNPACKED_REVPROP not packed yet and the number of
+   *COMPLETED_SHARDS, limited to PB->END_SHARD.  Use POOL for
+   allocations.  Return an error if the format does not support packing
+   at all. */
 static svn_error_t *
-pack_body(void *baton,
-          apr_pool_t *pool)
+read_pack_state(int *format,
+                int *max_files_per_dir,
+                svn_revnum_t *min_unpacked_rev,
+                svn_revnum_t *min_unpacked_revprop,
+                apr_int64_t *completed_shards,
+                struct pack_baton *pb,
+                apr_pool_t *pool)
 {
-  struct pack_baton *pb = baton;
-  int format, max_files_per_dir;
-  apr_int64_t completed_shards;
-  apr_int64_t i;
   svn_revnum_t youngest;
-  apr_pool_t *iterpool;
-  const char *data_path, *revprops_path;
-  svn_revnum_t min_unpacked_rev;
-  svn_revnum_t min_unpacked_revprop;
 
-  SVN_ERR(read_format(&format, &max_files_per_dir,
+  SVN_ERR(read_format(format, max_files_per_dir,
                       svn_dirent_join(pb->fs->path, PATH_FORMAT, pool),
                       pool));
 
   /* If the repository isn't a new enough format, we don't support packing.
      Return a friendly error to that effect. */
-  if (format < SVN_FS_FS__MIN_PACKED_FORMAT)
+  if (*format < SVN_FS_FS__MIN_PACKED_FORMAT)
     return svn_error_create(SVN_ERR_FS_UNSUPPORTED_FORMAT, NULL,
       _("FS format too old to pack, please upgrade."));
 
-  /* If we aren't using sharding, we can't do any packing, so quit. */
-  if (!max_files_per_dir)
+  /* If we aren't using sharding, we can't do any packing. */
+  *min_unpacked_rev = 0;
+  *min_unpacked_revprop = 0;
+  *completed_shards = 0;
+  if (!*max_files_per_dir)
     return SVN_NO_ERROR;
 
-  SVN_ERR(read_min_unpacked_rev(&min_unpacked_rev,
+  SVN_ERR(read_min_unpacked_rev(min_unpacked_rev,
                                 svn_dirent_join(pb->fs->path,
                                                 PATH_MIN_UNPACKED_REV, pool),
                                 pool));
 
-  if (format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-    {
-      SVN_ERR(read_min_unpacked_rev(&min_unpacked_revprop,
-                                    svn_dirent_join(pb->fs->path,
-                                                    PATH_MIN_UNPACKED_REVPROP,
-                                                    pool),
-                                    pool));
-    }
-  else
-    {
-      min_unpacked_revprop = 0;
-    }
+  if (*format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+    SVN_ERR(read_min_unpacked_rev(min_unpacked_revprop,
+                                  svn_dirent_join(pb->fs->path,
+                                                  PATH_MIN_UNPACKED_REVPROP,
+                                                  pool),
+                                  pool));
 
   SVN_ERR(get_youngest(&youngest, pb->fs->path, pool));
-  completed_shards = (youngest + 1) / max_files_per_dir;
+  *completed_shards = (youngest + 1) / *max_files_per_dir;
+
+  if (pb->end_shard >= 0 && *completed_shards > pb->end_shard)
+    *completed_shards = pb->end_shard;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+pack_body(void *baton,
+          apr_pool_t *pool)
+{
+  struct pack_baton *pb = baton;
+  int format, max_files_per_dir;
+  apr_int64_t completed_shards;
+  apr_int64_t i;
+  apr_pool_t *iterpool;
+  const char *data_path, *revprops_path;
+  svn_revnum_t min_unpacked_rev;
+  svn_revnum_t min_unpacked_revprop;
+
+  SVN_ERR(read_pack_state(&format, &max_files_per_dir, &min_unpacked_rev,
+                          &min_unpacked_revprop, &completed_shards,
+                          pb, pool));
 
   /* See if we've already completed all possible shards thus far. */
   if (min_unpacked_rev == (completed_shards * max_files_per_dir) &&
@@ -7569,6 +10730,7 @@ pack_body(void *baton,
         SVN_ERR(pb->cancel_func(pb->cancel_baton));
 
       SVN_ERR(pack_shard(data_path, pb->fs->path, i, max_files_per_dir,
+                         i >= pb->first_copied && i < pb->end_copied,
                          pb->notify_func, pb->notify_baton,
                          pb->cancel_func, pb->cancel_baton, iterpool));
     }
@@ -7592,8 +10754,159 @@ pack_body(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* State shared between the tasks of copy_rev_shards_concurrently(). */
+typedef struct copy_jobs_t
+{
+  /* Where to find the shards and how large they are. */
+  const char *revs_dir;
+  int max_files_per_dir;
+
+  /* The first shard to copy. */
+  apr_int64_t first_shard;
+
+  /* Per-shard tasks and results, indexed by shard - FIRST_SHARD.  DONE
+     gets set for every shard copied successfully. */
+  svn_workers__task_t *tasks;
+  svn_boolean_t *done;
+
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} copy_jobs_t;
+
+/* Implements svn_workers__process_t, copying shard *ITEM, an apr_int64_t,
+   of BATON, a copy_jobs_t. */
+static svn_error_t *
+copy_shard_task(void *baton,
+                void **worker_state,
+                void *item,
+                apr_pool_t *worker_pool,
+                apr_pool_t *scratch_pool)
+{
+  copy_jobs_t *jobs = baton;
+  apr_int64_t shard = *(apr_int64_t *)item;
+
+  SVN_ERR(copy_rev_shard(jobs->revs_dir, shard, jobs->max_files_per_dir,
+                         jobs->cancel_func, jobs->cancel_baton,
+                         scratch_pool));
+  jobs->done[shard - jobs->first_shard] = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy all completed but unpacked revision shards of PB->FS into pack
+   files, using up to JOBS threads.  Neither the write lock is required
+   nor are the shards published.  Record the range of shards that have
+   been copied successfully in PB.  If copying a shard failed, limit the
+   packing in PB to the shards before it and return the error.  Use POOL
+   for allocations. */
+static svn_error_t *
+copy_rev_shards_concurrently(struct pack_baton *pb,
+                             int jobs,
+                             apr_pool_t *pool)
+{
+  int format, max_files_per_dir;
+  svn_revnum_t min_unpacked_rev, min_unpacked_revprop;
+  apr_int64_t completed_shards, count, i;
+  apr_int64_t *shards;
+  copy_jobs_t shared;
+  svn_workers__t *workers;
+  apr_pool_t *subpool;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(read_pack_state(&format, &max_files_per_dir, &min_unpacked_rev,
+                          &min_unpacked_revprop, &completed_shards,
+                          pb, pool));
+  if (!max_files_per_dir)
+    return SVN_NO_ERROR;
+
+  shared.revs_dir = svn_dirent_join(pb->fs->path, PATH_REVS_DIR, pool);
+  shared.max_files_per_dir = max_files_per_dir;
+  shared.first_shard = min_unpacked_rev / max_files_per_dir;
+  shared.cancel_func = pb->cancel_func;
+  shared.cancel_baton = pb->cancel_baton;
+
+  count = completed_shards - shared.first_shard;
+  if (count <= 0)
+    return SVN_NO_ERROR;
+  if (jobs > count)
+    jobs = (int)count;
+
+  /* Failing to start the workers is not fatal: whatever has not been
+     copied by the time we are done will simply be packed by
+     pack_body(). */
+  subpool = svn_pool_create(pool);
+  workers = svn_workers__start(jobs, copy_shard_task, &shared, subpool);
+  if (! workers)
+    {
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
+    }
+
+  shared.tasks = apr_pcalloc(pool,
+                             (apr_size_t)count * sizeof(*shared.tasks));
+  shared.done = apr_pcalloc(pool, (apr_size_t)count * sizeof(*shared.done));
+  shards = apr_palloc(pool, (apr_size_t)count * sizeof(*shards));
+  for (i = 0; i < count; ++i)
+    {
+      shards[i] = shared.first_shard + i;
+      svn_workers__queue(workers, &shared.tasks[i], &shards[i]);
+    }
+
+  /* Once a shard failed, the workers don't start any further ones.
+     Report the first failure, if any. */
+  for (i = 0; i < count; ++i)
+    {
+      svn_error_t *task_err = svn_workers__wait(workers, &shared.tasks[i]);
+
+      if (err)
+        svn_error_clear(task_err);
+      else
+        err = task_err;
+    }
+  svn_pool_destroy(subpool);
+
+  /* Everything up to the first shard that has not been copied can be
+     published. */
+  for (i = 0; i < count && shared.done[i]; ++i)
+    ;
+
+  pb->first_copied = shared.first_shard;
+  pb->end_copied = shared.first_shard + i;
+  if (i < count && err)
+    pb->end_shard = pb->end_copied;
+
+  return svn_error_return(err);
+}
+
+/* Baton for pack_locked_body(). */
+struct pack_lock_baton
+{
+  struct pack_baton *pb;
+  int jobs;
+};
+
+/* Pack PLB->PB->FS while holding the pack lock.  Shards copied
+   concurrently get published under the write lock later on.  Use POOL
+   for allocations. */
+static svn_error_t *
+pack_locked_body(void *baton,
+                 apr_pool_t *pool)
+{
+  struct pack_lock_baton *plb = baton;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (plb->jobs > 1)
+    err = copy_rev_shards_concurrently(plb->pb, plb->jobs, pool);
+
+  /* Publish what has been copied so far, even if some shards failed. */
+  return svn_error_compose_create(
+           svn_fs_fs__with_write_lock(plb->pb->fs, pack_body, plb->pb, pool),
+           err);
+}
+
 svn_error_t *
 svn_fs_fs__pack(svn_fs_t *fs,
+                int jobs,
                 svn_fs_pack_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
@@ -7601,10 +10914,31 @@ svn_fs_fs__pack(svn_fs_t *fs,
                 apr_pool_t *pool)
 {
   struct pack_baton pb = { 0 };
+  struct pack_lock_baton plb;
+#if SVN_FS_FS__USE_LOCK_MUTEX
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+#endif
+
   pb.fs = fs;
   pb.notify_func = notify_func;
   pb.notify_baton = notify_baton;
   pb.cancel_func = cancel_func;
   pb.cancel_baton = cancel_baton;
-  return svn_fs_fs__with_write_lock(fs, pack_body, &pb, pool);
+  pb.first_copied = 0;
+  pb.end_copied = 0;
+  pb.end_shard = -1;
+
+  plb.pb = &pb;
+  plb.jobs = jobs;
+
+  /* Concurrent pack runs must not interfere with each other's copies.
+     Since copying happens without the write lock, serialize them using
+     a lock file of their own. */
+  return with_some_lock(pack_locked_body, &plb,
+                        path_pack_lock(fs, pool),
+#if SVN_FS_FS__USE_LOCK_MUTEX
+                        ffsd->fs_pack_lock,
+#endif
+                        pool);
 }
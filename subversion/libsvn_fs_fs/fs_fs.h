@@ -36,9 +36,15 @@ svn_error_t *svn_fs_fs__upgrade(svn_fs_t *fs,
                                 apr_pool_t *pool);
 
 /* Copy the fsfs filesystem at SRC_PATH into a new copy at DST_PATH.
+   If INCREMENTAL is TRUE and DST_PATH already holds an older hotcopy
+   of the same filesystem, copy only what changed since then.
+   Use optional CANCEL_FUNC/CANCEL_BATON for cancellation support.
    Use POOL for temporary allocations. */
 svn_error_t *svn_fs_fs__hotcopy(const char *src_path,
                                 const char *dst_path,
+                                svn_boolean_t incremental,
+                                svn_cancel_func_t cancel_func,
+                                void *cancel_baton,
                                 apr_pool_t *pool);
 
 /* Recover the fsfs associated with filesystem FS.
@@ -56,6 +62,17 @@ svn_error_t *svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
                                           const svn_fs_id_t *id,
                                           apr_pool_t *pool);
 
+/* Set *ANCESTOR_P to the node-revision in FS that is in the line of
+   history of NODEREV and has a predecessor count of COUNT, or to
+   NODEREV itself if its predecessor count is not larger than COUNT.
+   Follow the predecessor skip links wherever possible.  Do any
+   allocations in POOL. */
+svn_error_t *svn_fs_fs__get_ancestor(node_revision_t **ancestor_p,
+                                     svn_fs_t *fs,
+                                     node_revision_t *noderev,
+                                     int count,
+                                     apr_pool_t *pool);
+
 /* Store NODEREV as the node-revision for the node whose id is ID in
    FS, after setting its is_fresh_txn_root to FRESH_TXN_ROOT.  Do any
    necessary temporary allocation in POOL. */
@@ -96,22 +113,6 @@ svn_error_t *svn_fs_fs__rev_get_root(svn_fs_id_t **root_id,
                                      svn_revnum_t rev,
                                      apr_pool_t *pool);
 
-/* Serialize a directory contents hash.
-   Implements svn_cache__serialize_func_t */
-svn_error_t *
-svn_fs_fs__dir_entries_serialize(char **data,
-                                 apr_size_t *data_len,
-                                 void *in,
-                                 apr_pool_t *pool);
-
-/* Deserialize a directory contents hash.
-   Implements svn_cache__deserialize_func_t */
-svn_error_t *
-svn_fs_fs__dir_entries_deserialize(void **out,
-                                   const char *data,
-                                   apr_size_t data_len,
-                                   apr_pool_t *pool);
-
 /* Set *ENTRIES to an apr_hash_t of dirent structs that contain the
    directory entries of node-revision NODEREV in filesystem FS.  The
    returned table (and its keys and values) is allocated in POOL,
@@ -121,6 +122,25 @@ svn_error_t *svn_fs_fs__rep_contents_dir(apr_hash_t **entries,
                                          node_revision_t *noderev,
                                          apr_pool_t *pool);
 
+/* Like svn_fs_fs__rep_contents_dir, but set *ENTRIES to an array of
+   svn_fs_dirent_t * sorted by entry name.  Directories in the cache
+   are kept in that order already and don't need to be sorted again. */
+svn_error_t *svn_fs_fs__rep_contents_dir_sorted(apr_array_header_t **entries,
+                                                svn_fs_t *fs,
+                                                node_revision_t *noderev,
+                                                apr_pool_t *pool);
+
+/* Set *DIRENT to the entry NAME in directory node-revision NODEREV in
+   filesystem FS or to NULL if there is no such entry.  For immutable
+   directories, this avoids reading the full directory listing from the
+   cache.  The result is allocated in POOL, which is also used for
+   temporary allocations. */
+svn_error_t *svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
+                                               svn_fs_t *fs,
+                                               node_revision_t *noderev,
+                                               const char *name,
+                                               apr_pool_t *pool);
+
 /* Set *CONTENTS to be a readable svn_stream_t that receives the text
    representation of node-revision NODEREV as seen in filesystem FS.
    Use POOL for temporary allocations. */
@@ -189,6 +209,29 @@ svn_error_t *svn_fs_fs__paths_changed(apr_hash_t **changed_paths_p,
                                       apr_hash_t *copyfrom_cache,
                                       apr_pool_t *pool);
 
+/* An iterator over the paths changed in a revision. */
+typedef struct svn_fs_fs__changes_iterator_t svn_fs_fs__changes_iterator_t;
+
+/* Set *ITERATOR to an iterator over the paths which were changed in
+   revision REV of filesystem FS, returning them ordered by
+   svn_path_compare_paths().  Rather than the folded changes, only the
+   raw changes data of REV is kept in memory.  Allocate *ITERATOR in
+   POOL. */
+svn_error_t *
+svn_fs_fs__changes_iterator_open(svn_fs_fs__changes_iterator_t **iterator,
+                                 svn_fs_t *fs,
+                                 svn_revnum_t rev,
+                                 apr_pool_t *pool);
+
+/* Set *PATH and *CHANGE to the next changed path of ITERATOR and its
+   change, the same as svn_fs_fs__paths_changed() would report for it,
+   or to NULL if there are no more changes.  Allocate them in POOL. */
+svn_error_t *
+svn_fs_fs__changes_iterator_next(const char **path,
+                                 svn_fs_path_change2_t **change,
+                                 svn_fs_fs__changes_iterator_t *iterator,
+                                 apr_pool_t *pool);
+
 /* Create a new transaction in filesystem FS, based on revision REV,
    and store it in *TXN_P.  Allocate all necessary variables from
    POOL. */
@@ -281,6 +324,20 @@ svn_error_t *svn_fs_fs__set_contents(svn_stream_t **stream,
                                      node_revision_t *noderev,
                                      apr_pool_t *pool);
 
+/* Set *HANDLER and *HANDLER_BATON to a window handler that stores the
+   delta windows it receives, which turn the current contents of
+   node-revision NODEREV in filesystem FS into its new contents, as
+   they are as NODEREV's text representation, without computing a new
+   delta.  That is only possible if FS would deltify the new contents
+   against the current ones; if it would not, set *HANDLER to NULL.
+   Allocations are from POOL. */
+svn_error_t *
+svn_fs_fs__set_contents_delta(svn_txdelta_window_handler_t *handler,
+                              void **handler_baton,
+                              svn_fs_t *fs,
+                              node_revision_t *noderev,
+                              apr_pool_t *pool);
+
 /* Create a node revision in FS which is an immediate successor of
    OLD_ID, whose contents are NEW_NR.  Set *NEW_ID_P to the new node
    revision's ID.  Use POOL for any temporary allocation.
@@ -495,46 +552,33 @@ svn_error_t *svn_fs_fs__ensure_dir_exists(const char *path,
                                           svn_fs_t *fs,
                                           apr_pool_t *pool);
 
-/* Update the node origin index for FS, recording the mapping from
-   NODE_ID to NODE_REV_ID.  Use POOL for any temporary allocations.
-
-   Because this is just an "optional" cache, this function does not
-   return an error if the underlying storage is readonly; it still
-   returns an error for other error conditions.
- */
-svn_error_t *
-svn_fs_fs__set_node_origin(svn_fs_t *fs,
-                           const char *node_id,
-                           const svn_fs_id_t *node_rev_id,
-                           apr_pool_t *pool);
-
-/* Set *ORIGIN_ID to the node revision ID from which the history of
-   all nodes in FS whose "Node ID" is NODE_ID springs, as determined
-   by a look in the index.  ORIGIN_ID needs to be parsed in an
-   FS-backend-specific way.  Use POOL for allocations.
-
-   If there is no entry for NODE_ID in the cache, return NULL
-   in *ORIGIN_ID. */
-svn_error_t *
-svn_fs_fs__get_node_origin(const svn_fs_id_t **origin_id,
-                           svn_fs_t *fs,
-                           const char *node_id,
-                           apr_pool_t *pool);
-
-
 /* Sets up the svn_cache__t structures in FS.  POOL is used for
    temporary allocations. */
 svn_error_t *
 svn_fs_fs__initialize_caches(svn_fs_t *fs, apr_pool_t *pool);
 
+/* Set *INFO_P to a hash mapping the names of the caches in FS to their
+   svn_cache__info_t, allocated in POOL.  Reset the cache counters if
+   RESET is set. */
+svn_error_t *
+svn_fs_fs__get_cache_info(apr_hash_t **info_p,
+                          svn_fs_t *fs,
+                          svn_boolean_t reset,
+                          apr_pool_t *pool);
+
 
 /* Possibly pack the repository at PATH.  This just take full shards, and
    combines all the revision files into a single one, with a manifest header.
    Use optional CANCEL_FUNC/CANCEL_BATON for cancellation support.
 
+   If JOBS is larger than 1 and APR supports threads, copy up to JOBS
+   shards concurrently without holding the write lock; it will only be
+   taken to publish the packed shards, in order.
+
    Existing filesystem references need not change.  */
 svn_error_t *
 svn_fs_fs__pack(svn_fs_t *fs,
+                int jobs,
                 svn_fs_pack_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
@@ -28,41 +28,250 @@
 
 
 
-typedef struct {
-  const char *node_id;
-  const char *copy_id;
-  const char *txn_id;
+/* The private part of an FSFS node-revision ID: all numbers, so that
+   comparing IDs takes no string operations and IDs take little room in
+   the caches.  The text form only exists at the disk boundary. */
+typedef struct id_private_t {
+  svn_fs_fs__id_part_t node_id;
+  svn_fs_fs__id_part_t copy_id;
+
+  /* REVISION is SVN_INVALID_REVNUM for a permanent ID. */
+  svn_fs_fs__id_part_t txn_id;
+
   svn_revnum_t rev;
   apr_off_t offset;
 } id_private_t;
 
-
+/* An ID and its private part, allocated (and serialized) in one go. */
+typedef struct fs_fs__id_t {
+  svn_fs_id_t generic;
+  id_private_t pvt;
+} fs_fs__id_t;
+
+
+/* Parsing and unparsing ID parts.  */
+
+/* The most digits a base-36 key, or a decimal number, may have for us
+   to be sure that it fits into 64 bits. */
+#define MAX_KEY_DIGITS 12
+#define MAX_DECIMAL_DIGITS 18
+
+/* Parse the base-36 key at the start of the string from *P to END into
+   *NUMBER and advance *P past it.  Return FALSE if there is no key, or
+   one that wouldn't be written back the same way (such as "007"). */
+static svn_boolean_t
+parse_key(apr_uint64_t *number, const char **p, const char *end)
+{
+  const char *start = *p;
+  apr_uint64_t value = 0;
+
+  for (; *p < end && *p - start < MAX_KEY_DIGITS; (*p)++)
+    {
+      char c = **p;
+
+      if (c >= '0' && c <= '9')
+        value = value * 36 + (c - '0');
+      else if (c >= 'a' && c <= 'z')
+        value = value * 36 + (c - 'a' + 10);
+      else
+        break;
+    }
+
+  if (*p == start || (*start == '0' && *p - start > 1))
+    return FALSE;
+
+  *number = value;
+  return TRUE;
+}
+
+/* Like parse_key(), but for a decimal number into *VALUE. */
+static svn_boolean_t
+parse_decimal(apr_int64_t *value, const char **p, const char *end)
+{
+  const char *start = *p;
+
+  *value = 0;
+  for (; *p < end && *p - start < MAX_DECIMAL_DIGITS; (*p)++)
+    {
+      if (**p < '0' || **p > '9')
+        break;
+      *value = *value * 10 + (**p - '0');
+    }
+
+  return *p != start && (*start != '0' || *p - start == 1);
+}
+
+/* Like parse_key(), but for a revision number into *REV. */
+static svn_boolean_t
+parse_revnum(svn_revnum_t *rev, const char **p, const char *end)
+{
+  apr_int64_t value;
+
+  if (! parse_decimal(&value, p, end) || value > APR_INT32_MAX)
+    return FALSE;
+
+  *rev = (svn_revnum_t)value;
+  return TRUE;
+}
+
+/* Parse the node or copy ID from START to END into *PART. */
+static svn_boolean_t
+part_parse(svn_fs_fs__id_part_t *part, const char *start, const char *end)
+{
+  const char *p = start;
+
+  part->txn_local = (p < end && *p == '_');
+  if (part->txn_local)
+    p++;
+
+  if (! parse_key(&part->number, &p, end))
+    return FALSE;
+
+  part->revision = SVN_INVALID_REVNUM;
+  if (p < end && *p == '-' && ! part->txn_local)
+    {
+      p++;
+      if (! parse_revnum(&part->revision, &p, end))
+        return FALSE;
+    }
+
+  return p == end;
+}
+
+/* Parse the transaction ID from START to END into *PART. */
+static svn_boolean_t
+txn_part_parse(svn_fs_fs__id_part_t *part, const char *start, const char *end)
+{
+  const char *p = start;
+
+  part->txn_local = FALSE;
+  if (! parse_revnum(&part->revision, &p, end)
+      || p == end || *p++ != '-'
+      || ! parse_key(&part->number, &p, end))
+    return FALSE;
+
+  return p == end;
+}
+
+/* Write NUMBER as a base-36 key to the end of the buffer BUF of
+   MAX_KEY_DIGITS + 1 bytes and return where it starts. */
+static const char *
+key_unparse(apr_uint64_t number, char *buf)
+{
+  char *p = buf + MAX_KEY_DIGITS;
+
+  *p = '\0';
+  do
+    {
+      int digit = (int)(number % 36);
+
+      *--p = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+      number /= 36;
+    }
+  while (number);
+
+  return p;
+}
+
+/* Return the text form of the node or copy ID PART, allocated in POOL. */
+static const char *
+part_unparse(const svn_fs_fs__id_part_t *part, apr_pool_t *pool)
+{
+  char buf[MAX_KEY_DIGITS + 1];
+  const char *key = key_unparse(part->number, buf);
+
+  if (part->txn_local)
+    return apr_pstrcat(pool, "_", key, (char *)NULL);
+  if (SVN_IS_VALID_REVNUM(part->revision))
+    return apr_psprintf(pool, "%s-%ld", key, part->revision);
+
+  return apr_pstrdup(pool, key);
+}
+
+/* Return the text form of the transaction ID PART, allocated in POOL. */
+static const char *
+txn_part_unparse(const svn_fs_fs__id_part_t *part, apr_pool_t *pool)
+{
+  char buf[MAX_KEY_DIGITS + 1];
+
+  return apr_psprintf(pool, "%ld-%s", part->revision,
+                      key_unparse(part->number, buf));
+}
+
+svn_boolean_t
+svn_fs_fs__id_part_eq(const svn_fs_fs__id_part_t *a,
+                      const svn_fs_fs__id_part_t *b)
+{
+  return a->number == b->number
+      && a->revision == b->revision
+      && a->txn_local == b->txn_local;
+}
+
+svn_boolean_t
+svn_fs_fs__id_txn_id_valid(const char *txn_id)
+{
+  svn_fs_fs__id_part_t part;
+
+  return txn_part_parse(&part, txn_id, txn_id + strlen(txn_id));
+}
+
+
 /* Accessing ID Pieces.  */
 
+const svn_fs_fs__id_part_t *
+svn_fs_fs__id_node_part(const svn_fs_id_t *id)
+{
+  id_private_t *pvt = id->fsap_data;
+
+  return &pvt->node_id;
+}
+
+
+const svn_fs_fs__id_part_t *
+svn_fs_fs__id_copy_part(const svn_fs_id_t *id)
+{
+  id_private_t *pvt = id->fsap_data;
+
+  return &pvt->copy_id;
+}
+
+
+svn_boolean_t
+svn_fs_fs__id_is_txn(const svn_fs_id_t *id)
+{
+  id_private_t *pvt = id->fsap_data;
+
+  return SVN_IS_VALID_REVNUM(pvt->txn_id.revision);
+}
+
+
 const char *
-svn_fs_fs__id_node_id(const svn_fs_id_t *id)
+svn_fs_fs__id_node_id(const svn_fs_id_t *id, apr_pool_t *pool)
 {
   id_private_t *pvt = id->fsap_data;
 
-  return pvt->node_id;
+  return part_unparse(&pvt->node_id, pool);
 }
 
 
 const char *
-svn_fs_fs__id_copy_id(const svn_fs_id_t *id)
+svn_fs_fs__id_copy_id(const svn_fs_id_t *id, apr_pool_t *pool)
 {
   id_private_t *pvt = id->fsap_data;
 
-  return pvt->copy_id;
+  return part_unparse(&pvt->copy_id, pool);
 }
 
 
 const char *
-svn_fs_fs__id_txn_id(const svn_fs_id_t *id)
+svn_fs_fs__id_txn_id(const svn_fs_id_t *id, apr_pool_t *pool)
 {
   id_private_t *pvt = id->fsap_data;
 
-  return pvt->txn_id;
+  if (! SVN_IS_VALID_REVNUM(pvt->txn_id.revision))
+    return NULL;
+
+  return txn_part_unparse(&pvt->txn_id, pool);
 }
 
 
@@ -88,25 +297,19 @@ svn_string_t *
 svn_fs_fs__id_unparse(const svn_fs_id_t *id,
                       apr_pool_t *pool)
 {
-  const char *txn_rev_id;
   id_private_t *pvt = id->fsap_data;
+  const char *node_id = part_unparse(&pvt->node_id, pool);
+  const char *copy_id = part_unparse(&pvt->copy_id, pool);
 
-  if ((! pvt->txn_id))
-    {
-      txn_rev_id = apr_psprintf(pool, "%ld/%"
-                                APR_OFF_T_FMT, pvt->rev, pvt->offset);
-    }
-  else
-    {
-      txn_rev_id = pvt->txn_id;
-    }
-  return svn_string_createf(pool, "%s.%s.%c%s",
-                            pvt->node_id, pvt->copy_id,
-                            (pvt->txn_id ? 't' : 'r'),
-                            txn_rev_id);
+  if (SVN_IS_VALID_REVNUM(pvt->txn_id.revision))
+    return svn_string_createf(pool, "%s.%s.t%s", node_id, copy_id,
+                              txn_part_unparse(&pvt->txn_id, pool));
+
+  return svn_string_createf(pool, "%s.%s.r%ld/%" APR_OFF_T_FMT,
+                            node_id, copy_id, pvt->rev, pvt->offset);
 }
 
-
+
 /*** Comparing node IDs ***/
 
 svn_boolean_t
@@ -117,13 +320,11 @@ svn_fs_fs__id_eq(const svn_fs_id_t *a,
 
   if (a == b)
     return TRUE;
-  if (strcmp(pvta->node_id, pvtb->node_id) != 0)
+  if (! svn_fs_fs__id_part_eq(&pvta->node_id, &pvtb->node_id))
      return FALSE;
-  if (strcmp(pvta->copy_id, pvtb->copy_id) != 0)
-    return FALSE;
-  if ((pvta->txn_id == NULL) != (pvtb->txn_id == NULL))
+  if (! svn_fs_fs__id_part_eq(&pvta->copy_id, &pvtb->copy_id))
     return FALSE;
-  if (pvta->txn_id && pvtb->txn_id && strcmp(pvta->txn_id, pvtb->txn_id) != 0)
+  if (! svn_fs_fs__id_part_eq(&pvta->txn_id, &pvtb->txn_id))
     return FALSE;
   if (pvta->rev != pvtb->rev)
     return FALSE;
@@ -143,14 +344,15 @@ svn_fs_fs__id_check_related(const svn_fs_id_t *a,
     return TRUE;
   /* If both node_ids start with _ and they have differing transaction
      IDs, then it is impossible for them to be related. */
-  if (pvta->node_id[0] == '_')
+  if (pvta->node_id.txn_local)
     {
-      if (pvta->txn_id && pvtb->txn_id &&
-          (strcmp(pvta->txn_id, pvtb->txn_id) != 0))
+      if (SVN_IS_VALID_REVNUM(pvta->txn_id.revision)
+          && SVN_IS_VALID_REVNUM(pvtb->txn_id.revision)
+          && ! svn_fs_fs__id_part_eq(&pvta->txn_id, &pvtb->txn_id))
         return FALSE;
     }
 
-  return (strcmp(pvta->node_id, pvtb->node_id) == 0);
+  return svn_fs_fs__id_part_eq(&pvta->node_id, &pvtb->node_id);
 }
 
 
@@ -164,32 +366,78 @@ svn_fs_fs__id_compare(const svn_fs_id_t *a,
 }
 
 
-
+int
+svn_fs_fs__id_compare_location(const svn_fs_id_t *a,
+                               const svn_fs_id_t *b)
+{
+  id_private_t *pvta = a->fsap_data, *pvtb = b->fsap_data;
+
+  /* Node-revs in transactions come after all committed ones. */
+  if (pvta->rev != pvtb->rev)
+    {
+      if (! SVN_IS_VALID_REVNUM(pvta->rev))
+        return 1;
+      if (! SVN_IS_VALID_REVNUM(pvtb->rev))
+        return -1;
+
+      return pvta->rev < pvtb->rev ? -1 : 1;
+    }
+
+  if (pvta->offset != pvtb->offset)
+    return pvta->offset < pvtb->offset ? -1 : 1;
+
+  return 0;
+}
+
+
+
 /* Creating ID's.  */
 
 static id_vtable_t id_vtable = {
   svn_fs_fs__id_unparse,
-  svn_fs_fs__id_compare
+  svn_fs_fs__id_compare,
+  svn_fs_fs__id_compare_location
 };
 
 
+/* Return a new ID allocated in POOL, with its private part set up. */
+static fs_fs__id_t *
+id_create(apr_pool_t *pool)
+{
+  fs_fs__id_t *id = apr_palloc(pool, sizeof(*id));
+
+  id->generic.vtable = &id_vtable;
+  id->generic.fsap_data = &id->pvt;
+  return id;
+}
+
+
+/* Parse the text form NODE_ID and COPY_ID into ID. */
+static void
+parse_node_and_copy_ids(fs_fs__id_t *id,
+                        const char *node_id,
+                        const char *copy_id)
+{
+  if (! part_parse(&id->pvt.node_id, node_id, node_id + strlen(node_id))
+      || ! part_parse(&id->pvt.copy_id, copy_id, copy_id + strlen(copy_id)))
+    SVN_ERR_MALFUNCTION_NO_RETURN();
+}
+
+
 svn_fs_id_t *
 svn_fs_fs__id_txn_create(const char *node_id,
                          const char *copy_id,
                          const char *txn_id,
                          apr_pool_t *pool)
 {
-  svn_fs_id_t *id = apr_palloc(pool, sizeof(*id));
-  id_private_t *pvt = apr_palloc(pool, sizeof(*pvt));
-
-  pvt->node_id = apr_pstrdup(pool, node_id);
-  pvt->copy_id = apr_pstrdup(pool, copy_id);
-  pvt->txn_id = apr_pstrdup(pool, txn_id);
-  pvt->rev = SVN_INVALID_REVNUM;
-  pvt->offset = -1;
-  id->vtable = &id_vtable;
-  id->fsap_data = pvt;
-  return id;
+  fs_fs__id_t *id = id_create(pool);
+
+  parse_node_and_copy_ids(id, node_id, copy_id);
+  if (! txn_part_parse(&id->pvt.txn_id, txn_id, txn_id + strlen(txn_id)))
+    SVN_ERR_MALFUNCTION_NO_RETURN();
+  id->pvt.rev = SVN_INVALID_REVNUM;
+  id->pvt.offset = -1;
+  return &id->generic;
 }
 
 
@@ -200,35 +448,25 @@ svn_fs_fs__id_rev_create(const char *node_id,
                          apr_off_t offset,
                          apr_pool_t *pool)
 {
-  svn_fs_id_t *id = apr_palloc(pool, sizeof(*id));
-  id_private_t *pvt = apr_palloc(pool, sizeof(*pvt));
-
-  pvt->node_id = apr_pstrdup(pool, node_id);
-  pvt->copy_id = apr_pstrdup(pool, copy_id);
-  pvt->txn_id = NULL;
-  pvt->rev = rev;
-  pvt->offset = offset;
-  id->vtable = &id_vtable;
-  id->fsap_data = pvt;
-  return id;
+  fs_fs__id_t *id = id_create(pool);
+
+  parse_node_and_copy_ids(id, node_id, copy_id);
+  id->pvt.txn_id.number = 0;
+  id->pvt.txn_id.revision = SVN_INVALID_REVNUM;
+  id->pvt.txn_id.txn_local = FALSE;
+  id->pvt.rev = rev;
+  id->pvt.offset = offset;
+  return &id->generic;
 }
 
 
 svn_fs_id_t *
 svn_fs_fs__id_copy(const svn_fs_id_t *id, apr_pool_t *pool)
 {
-  svn_fs_id_t *new_id = apr_palloc(pool, sizeof(*new_id));
-  id_private_t *new_pvt = apr_palloc(pool, sizeof(*new_pvt));
-  id_private_t *pvt = id->fsap_data;
+  fs_fs__id_t *new_id = id_create(pool);
 
-  new_pvt->node_id = apr_pstrdup(pool, pvt->node_id);
-  new_pvt->copy_id = apr_pstrdup(pool, pvt->copy_id);
-  new_pvt->txn_id = pvt->txn_id ? apr_pstrdup(pool, pvt->txn_id) : NULL;
-  new_pvt->rev = pvt->rev;
-  new_pvt->offset = pvt->offset;
-  new_id->vtable = &id_vtable;
-  new_id->fsap_data = new_pvt;
-  return new_id;
+  new_id->pvt = *(const id_private_t *)id->fsap_data;
+  return &new_id->generic;
 }
 
 
@@ -237,66 +475,98 @@ svn_fs_fs__id_parse(const char *data,
                     apr_size_t len,
                     apr_pool_t *pool)
 {
-  svn_fs_id_t *id;
-  id_private_t *pvt;
-  char *data_copy, *str, *last_str;
-
-  /* Dup the ID data into POOL.  Our returned ID will have references
-     into this memory. */
-  data_copy = apr_pstrmemdup(pool, data, len);
-
-  /* Alloc a new svn_fs_id_t structure. */
-  id = apr_palloc(pool, sizeof(*id));
-  pvt = apr_palloc(pool, sizeof(*pvt));
-  id->vtable = &id_vtable;
-  id->fsap_data = pvt;
-
-  /* Now, we basically just need to "split" this data on `.'
-     characters.  We will use apr_strtok, which will put terminators
-     where each of the '.'s used to be.  Then our new id field will
-     reference string locations inside our duplicate string.*/
+  fs_fs__id_t *id = id_create(pool);
+  const char *end = data + len;
+  const char *dot, *p;
 
   /* Node Id */
-  str = apr_strtok(data_copy, ".", &last_str);
-  if (str == NULL)
+  dot = memchr(data, '.', len);
+  if (dot == NULL || ! part_parse(&id->pvt.node_id, data, dot))
     return NULL;
-  pvt->node_id = str;
 
   /* Copy Id */
-  str = apr_strtok(NULL, ".", &last_str);
-  if (str == NULL)
+  p = dot + 1;
+  dot = memchr(p, '.', end - p);
+  if (dot == NULL || ! part_parse(&id->pvt.copy_id, p, dot))
     return NULL;
-  pvt->copy_id = str;
 
   /* Txn/Rev Id */
-  str = apr_strtok(NULL, ".", &last_str);
-  if (str == NULL)
+  p = dot + 1;
+  if (p == end)
     return NULL;
 
-  if (str[0] == 'r')
+  if (*p == 'r')
     {
       /* This is a revision type ID */
-      pvt->txn_id = NULL;
+      apr_int64_t offset;
 
-      str = apr_strtok(str + 1, "/", &last_str);
-      if (str == NULL)
-        return NULL;
-      pvt->rev = SVN_STR_TO_REV(str);
+      id->pvt.txn_id.number = 0;
+      id->pvt.txn_id.revision = SVN_INVALID_REVNUM;
+      id->pvt.txn_id.txn_local = FALSE;
 
-      str = apr_strtok(NULL, "/", &last_str);
-      if (str == NULL)
+      p++;
+      if (! parse_revnum(&id->pvt.rev, &p, end)
+          || p == end || *p++ != '/'
+          || ! parse_decimal(&offset, &p, end)
+          || p != end)
         return NULL;
-      pvt->offset = apr_atoi64(str);
+      id->pvt.offset = (apr_off_t)offset;
     }
-  else if (str[0] == 't')
+  else if (*p == 't')
     {
       /* This is a transaction type ID */
-      pvt->txn_id = str + 1;
-      pvt->rev = SVN_INVALID_REVNUM;
-      pvt->offset = -1;
+      if (! txn_part_parse(&id->pvt.txn_id, p + 1, end))
+        return NULL;
+      id->pvt.rev = SVN_INVALID_REVNUM;
+      id->pvt.offset = -1;
     }
   else
     return NULL;
 
-  return id;
+  return &id->generic;
+}
+
+/* Serialization and deserialization of ID's.  */
+
+void
+svn_fs_fs__id_serialize(svn_temp_serializer__context_t *context,
+                        const svn_fs_id_t * const *id)
+{
+  /* nothing to do for NULL ids */
+  if (*id == NULL)
+    return;
+
+  /* The ID and its private part are a single block without pointers
+     but the two we restore when deserializing. */
+  svn_temp_serializer__push(context,
+                            (const void * const *)id,
+                            sizeof(fs_fs__id_t));
+  svn_temp_serializer__set_null(context,
+                                (const void * const *)&(*id)->vtable);
+  svn_temp_serializer__set_null(context,
+                                (const void * const *)&(*id)->fsap_data);
+
+  /* return to caller's nesting level */
+  svn_temp_serializer__pop(context);
+}
+
+
+void
+svn_fs_fs__id_deserialize(void *buffer, svn_fs_id_t **id)
+{
+  fs_fs__id_t *fs_fs_id;
+
+  /* The ID may be all there is in the buffer, i.e. be its root.
+   * Don't try to fix up the pointer in that case. */
+  if (*id != buffer)
+    svn_temp_deserializer__resolve(buffer, (void **)id);
+
+  if (*id == NULL)
+    return;
+
+  /* the stored vtable and private data pointer are bogus at best --
+     replace them */
+  fs_fs_id = (fs_fs__id_t *)*id;
+  fs_fs_id->generic.vtable = &id_vtable;
+  fs_fs_id->generic.fsap_data = &fs_fs_id->pvt;
 }
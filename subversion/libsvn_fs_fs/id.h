@@ -24,22 +24,61 @@
 #define SVN_LIBSVN_FS_FS_ID_H
 
 #include "svn_fs.h"
+#include "private/svn_temp_serializer.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
 
+/* A node, copy or transaction ID component of a node-revision ID,
+   decoded from its text form.  Node and copy IDs are a base-36 key,
+   either prefixed with '_' while local to a transaction, or suffixed
+   with "-<rev>" for the revision that made them.  Transaction IDs are
+   "<rev>-<key>". */
+typedef struct svn_fs_fs__id_part_t
+{
+  /* The base-36 key, as a number. */
+  apr_uint64_t number;
+
+  /* The revision in the ID, or SVN_INVALID_REVNUM if there is none. */
+  svn_revnum_t revision;
+
+  /* Whether this is a key local to a transaction ("_<key>"). */
+  svn_boolean_t txn_local;
+} svn_fs_fs__id_part_t;
+
+/* Return true if the ID components A and B are equal. */
+svn_boolean_t svn_fs_fs__id_part_eq(const svn_fs_fs__id_part_t *a,
+                                    const svn_fs_fs__id_part_t *b);
+
+/* Return true if TXN_ID is a well-formed transaction ID. */
+svn_boolean_t svn_fs_fs__id_txn_id_valid(const char *txn_id);
+
+
 /*** ID accessor functions. ***/
 
 /* Get the "node id" portion of ID. */
-const char *svn_fs_fs__id_node_id(const svn_fs_id_t *id);
+const svn_fs_fs__id_part_t *svn_fs_fs__id_node_part(const svn_fs_id_t *id);
 
 /* Get the "copy id" portion of ID. */
-const char *svn_fs_fs__id_copy_id(const svn_fs_id_t *id);
+const svn_fs_fs__id_part_t *svn_fs_fs__id_copy_part(const svn_fs_id_t *id);
+
+/* Return true if ID is a transaction ID rather than a permanent one. */
+svn_boolean_t svn_fs_fs__id_is_txn(const svn_fs_id_t *id);
 
-/* Get the "txn id" portion of ID, or NULL if it is a permanent ID. */
-const char *svn_fs_fs__id_txn_id(const svn_fs_id_t *id);
+/* Get the "node id" portion of ID in text form, allocated in POOL. */
+const char *svn_fs_fs__id_node_id(const svn_fs_id_t *id,
+                                  apr_pool_t *pool);
+
+/* Get the "copy id" portion of ID in text form, allocated in POOL. */
+const char *svn_fs_fs__id_copy_id(const svn_fs_id_t *id,
+                                  apr_pool_t *pool);
+
+/* Get the "txn id" portion of ID in text form, allocated in POOL, or
+   NULL if it is a permanent ID. */
+const char *svn_fs_fs__id_txn_id(const svn_fs_id_t *id,
+                                 apr_pool_t *pool);
 
 /* Get the "rev" portion of ID, or SVN_INVALID_REVNUM if it is a
    transaction ID. */
@@ -65,15 +104,21 @@ svn_boolean_t svn_fs_fs__id_check_related(const svn_fs_id_t *a,
 int svn_fs_fs__id_compare(const svn_fs_id_t *a,
                           const svn_fs_id_t *b);
 
+/* Order the node-revisions A and B by where they are stored: by
+   revision, then by offset within the revision.  Transaction IDs sort
+   after all revision IDs. */
+int svn_fs_fs__id_compare_location(const svn_fs_id_t *a,
+                                   const svn_fs_id_t *b);
+
 /* Create an ID within a transaction based on NODE_ID, COPY_ID, and
-   TXN_ID, allocated in POOL. */
+   TXN_ID, allocated in POOL.  The IDs must be well-formed. */
 svn_fs_id_t *svn_fs_fs__id_txn_create(const char *node_id,
                                       const char *copy_id,
                                       const char *txn_id,
                                       apr_pool_t *pool);
 
 /* Create a permanent ID based on NODE_ID, COPY_ID, REV, and OFFSET,
-   allocated in POOL. */
+   allocated in POOL.  The IDs must be well-formed. */
 svn_fs_id_t *svn_fs_fs__id_rev_create(const char *node_id,
                                       const char *copy_id,
                                       svn_revnum_t rev,
@@ -90,6 +135,17 @@ svn_fs_id_t *svn_fs_fs__id_parse(const char *data,
                                  apr_size_t len,
                                  apr_pool_t *pool);
 
+/* Append the serialized representation of *ID to the serialization
+   CONTEXT.  ID must be a member of the current structure in CONTEXT. */
+void svn_fs_fs__id_serialize(svn_temp_serializer__context_t *context,
+                             const svn_fs_id_t * const *id);
+
+/* Deserialize the *ID inside the serialized structure that starts at
+   BUFFER, i.e. resolve all its pointers in place.  *ID may also be the
+   root of the BUFFER itself. */
+void svn_fs_fs__id_deserialize(void *buffer,
+                               svn_fs_id_t **id);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -40,9 +40,13 @@
 #include "fs_fs.h"
 #include "../libsvn_fs/fs-loader.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_fs_util.h"
+#include "private/svn_sqlite.h"
 #include "svn_private_config.h"
 
+#include "locks-db.h"
+
 /* Names of hash keys used to store a lock for writing to disk. */
 #define PATH_KEY "path"
 #define TOKEN_KEY "token"
@@ -57,6 +61,11 @@
    calculate a subdirectory in which to drop that file. */
 #define DIGEST_SUBDIR_LEN 3
 
+/* The schema of the lock database this code knows how to use. */
+#define LOCKS_DB_SCHEMA_FORMAT 1
+
+LOCKS_DB_SQL_DECLARE_STATEMENTS(statements);
+
 
 
 /*** Generic helper functions. ***/
@@ -314,6 +323,182 @@ read_digest_file(apr_hash_t **children_p,
 
 
 
+/*** Lock database functions. ***/
+
+/* Open the lock database of FS.  This implements the
+   svn_atomic__init_once() callback.  BATON is the svn_fs_t *. */
+static svn_error_t *
+open_locks_db(void *baton,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *db;
+  int version;
+
+  /* The database will be automatically closed when fs->pool is
+     destroyed. */
+  SVN_ERR(svn_sqlite__open(&db,
+                           svn_dirent_join(fs->path, LOCKS_DB_NAME, pool),
+                           svn_sqlite__mode_readwrite, statements,
+                           0, NULL, NULL, fs->pool, pool));
+
+  /* Unlike an index, the lock database cannot simply be ignored. */
+  SVN_ERR(svn_sqlite__read_schema_version(&version, db, pool));
+  if (version != LOCKS_DB_SCHEMA_FORMAT)
+    return svn_error_createf(SVN_ERR_FS_UNSUPPORTED_FORMAT, NULL,
+                             _("Unsupported lock database schema %d in '%s'"),
+                             version,
+                             svn_dirent_local_style(fs->path, pool));
+
+  ffd->locks_db = db;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DB to the lock database of FS, or to NULL if FS keeps its locks
+   in digest files.  Use POOL for temporary allocations. */
+static svn_error_t *
+get_locks_db(svn_sqlite__db_t **db,
+             svn_fs_t *fs,
+             apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->format < SVN_FS_FS__MIN_LOCKS_DB_FORMAT)
+    {
+      *db = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_atomic__init_once(&ffd->locks_db_opened,
+                                open_locks_db, fs, pool));
+  *db = ffd->locks_db;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *LOWER and *UPPER to the bounds of the half-open range of paths
+   strictly below the canonical absolute PATH, except that the range
+   includes PATH itself if that is the root.  Allocate the bounds in
+   POOL. */
+static void
+get_descendant_range(const char **lower,
+                     const char **upper,
+                     const char *path,
+                     apr_pool_t *pool)
+{
+  /* '0' is the character right after '/', so these bounds include
+     "PATH/x" but not "PATH-x" or "PATHx". */
+  if (path[0] == '/' && path[1] == '\0')
+    {
+      *lower = "/";
+      *upper = "0";
+    }
+  else
+    {
+      *lower = apr_pstrcat(pool, path, "/", (char *)NULL);
+      *upper = apr_pstrcat(pool, path, "0", (char *)NULL);
+    }
+}
+
+/* Return the lock in the current row of STMT, a STMT_GET_LOCK or
+   STMT_GET_LOCKS statement, allocated in POOL. */
+static svn_lock_t *
+lock_from_row(svn_sqlite__stmt_t *stmt,
+              apr_pool_t *pool)
+{
+  svn_lock_t *lock = svn_lock_create(pool);
+
+  lock->path = svn_sqlite__column_text(stmt, 0, pool);
+  lock->token = svn_sqlite__column_text(stmt, 1, pool);
+  lock->owner = svn_sqlite__column_text(stmt, 2, pool);
+  lock->comment = svn_sqlite__column_text(stmt, 3, pool);
+  lock->is_dav_comment = svn_sqlite__column_boolean(stmt, 4);
+  lock->creation_date = svn_sqlite__column_int64(stmt, 5);
+  lock->expiration_date = svn_sqlite__column_int64(stmt, 6);
+
+  return lock;
+}
+
+/* Set *LOCK_P to the lock on PATH in the lock database DB, or to NULL if
+   PATH is not locked.  Allocate the lock in POOL. */
+static svn_error_t *
+db_read_lock(svn_lock_t **lock_p,
+             svn_sqlite__db_t *db,
+             const char *path,
+             apr_pool_t *pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_GET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *lock_p = have_row ? lock_from_row(stmt, pool) : NULL;
+
+  return svn_error_return(svn_sqlite__reset(stmt));
+}
+
+/* Set *LOCKS to the locks (svn_lock_t *) on PATH and on all paths below
+   it in the lock database DB, allocated in POOL. */
+static svn_error_t *
+db_read_locks(apr_array_header_t **locks,
+              svn_sqlite__db_t *db,
+              const char *path,
+              apr_pool_t *pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  const char *lower, *upper;
+
+  get_descendant_range(&lower, &upper, path, pool);
+  *locks = apr_array_make(pool, 0, sizeof(svn_lock_t *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_GET_LOCKS));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sss", path, lower, upper));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      APR_ARRAY_PUSH(*locks, svn_lock_t *) = lock_from_row(stmt, pool);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_return(svn_sqlite__reset(stmt));
+}
+
+/* Store LOCK in the lock database DB, replacing any lock on its path. */
+static svn_error_t *
+db_write_lock(svn_sqlite__db_t *db,
+              const svn_lock_t *lock)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_SET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "ssssiii", lock->path, lock->token,
+                            lock->owner, lock->comment,
+                            (apr_int64_t)(lock->is_dav_comment ? 1 : 0),
+                            (apr_int64_t)lock->creation_date,
+                            (apr_int64_t)lock->expiration_date));
+
+  return svn_error_return(svn_sqlite__insert(NULL, stmt));
+}
+
+/* Remove the lock on PATH from the lock database DB. */
+static svn_error_t *
+db_delete_lock(svn_sqlite__db_t *db,
+               const char *path)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_DELETE_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path));
+
+  return svn_error_return(svn_sqlite__update(NULL, stmt));
+}
+
+
+
 /*** Lock helper functions (path here are still FS paths, not on-disk
      schema-supporting paths) ***/
 
@@ -327,9 +512,14 @@ set_lock(svn_fs_t *fs,
   svn_stringbuf_t *this_path = svn_stringbuf_create(lock->path, pool);
   svn_stringbuf_t *last_child = svn_stringbuf_create("", pool);
   apr_pool_t *subpool;
+  svn_sqlite__db_t *db;
 
   SVN_ERR_ASSERT(lock);
 
+  SVN_ERR(get_locks_db(&db, fs, pool));
+  if (db)
+    return svn_error_return(db_write_lock(db, lock));
+
   /* Iterate in reverse, creating the lock for LOCK->path, and then
      just adding entries for its parent, until we reach a parent
      that's already listed in *its* parent. */
@@ -389,9 +579,14 @@ delete_lock(svn_fs_t *fs,
   svn_stringbuf_t *this_path = svn_stringbuf_create(lock->path, pool);
   svn_stringbuf_t *child_to_kill = svn_stringbuf_create("", pool);
   apr_pool_t *subpool;
+  svn_sqlite__db_t *db;
 
   SVN_ERR_ASSERT(lock);
 
+  SVN_ERR(get_locks_db(&db, fs, pool));
+  if (db)
+    return svn_error_return(db_delete_lock(db, lock->path));
+
   /* Iterate in reverse, deleting the lock for LOCK->path, and then
      pruning entries from its parents. */
   subpool = svn_pool_create(pool);
@@ -461,9 +656,14 @@ get_lock(svn_lock_t **lock_p,
          apr_pool_t *pool)
 {
   svn_lock_t *lock;
-  const char *digest_path = digest_path_from_path(fs, path, pool);
+  svn_sqlite__db_t *db;
 
-  SVN_ERR(read_digest_file(NULL, &lock, fs, digest_path, pool));
+  SVN_ERR(get_locks_db(&db, fs, pool));
+  if (db)
+    SVN_ERR(db_read_lock(&lock, db, path, pool));
+  else
+    SVN_ERR(read_digest_file(NULL, &lock, fs,
+                             digest_path_from_path(fs, path, pool), pool));
   if (! lock)
     return SVN_FS__ERR_NO_SUCH_LOCK(fs, path);
 
@@ -516,6 +716,36 @@ get_lock_helper(svn_fs_t *fs,
 }
 
 
+/* Call GET_LOCKS_FUNC/GET_LOCKS_BATON, if set, for LOCK in FS, unless
+   LOCK has expired.  HAVE_WRITE_LOCK should be true if the caller
+   (directly or indirectly) has the FS write lock. */
+static svn_error_t *
+report_lock(svn_fs_t *fs,
+            svn_lock_t *lock,
+            svn_fs_get_locks_callback_t get_locks_func,
+            void *get_locks_baton,
+            svn_boolean_t have_write_lock,
+            apr_pool_t *pool)
+{
+  /* Don't report an expired lock. */
+  if (lock->expiration_date == 0
+      || (apr_time_now() <= lock->expiration_date))
+    {
+      if (get_locks_func)
+        SVN_ERR(get_locks_func(get_locks_baton, lock, pool));
+    }
+  else
+    {
+      /* Only remove the lock if we have the write lock.
+         Read operations shouldn't change the filesystem. */
+      if (have_write_lock)
+        SVN_ERR(delete_lock(fs, lock, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 /* A recursive function that calls GET_LOCKS_FUNC/GET_LOCKS_BATON for
    all locks in and under PATH in FS.
    HAVE_WRITE_LOCK should be true if the caller (directly or indirectly)
@@ -536,22 +766,8 @@ walk_digest_files(svn_fs_t *fs,
   /* First, send up any locks in the current digest file. */
   SVN_ERR(read_digest_file(&children, &lock, fs, digest_path, pool));
   if (lock)
-    {
-      /* Don't report an expired lock. */
-      if (lock->expiration_date == 0
-          || (apr_time_now() <= lock->expiration_date))
-        {
-          if (get_locks_func)
-            SVN_ERR(get_locks_func(get_locks_baton, lock, pool));
-        }
-      else
-        {
-          /* Only remove the lock if we have the write lock.
-             Read operations shouldn't change the filesystem. */
-          if (have_write_lock)
-            SVN_ERR(delete_lock(fs, lock, pool));
-        }
-    }
+    SVN_ERR(report_lock(fs, lock, get_locks_func, get_locks_baton,
+                        have_write_lock, pool));
 
   /* Now, recurse on this thing's child entries (if any; bail otherwise). */
   if (! apr_hash_count(children))
@@ -570,6 +786,48 @@ walk_digest_files(svn_fs_t *fs,
 }
 
 
+/* Call GET_LOCKS_FUNC/GET_LOCKS_BATON for all locks in and under PATH
+   in FS.  HAVE_WRITE_LOCK should be true if the caller (directly or
+   indirectly) has the FS write lock. */
+static svn_error_t *
+walk_locks(svn_fs_t *fs,
+           const char *path,
+           svn_fs_get_locks_callback_t get_locks_func,
+           void *get_locks_baton,
+           svn_boolean_t have_write_lock,
+           apr_pool_t *pool)
+{
+  svn_sqlite__db_t *db;
+  apr_array_header_t *locks;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(get_locks_db(&db, fs, pool));
+  if (! db)
+    return svn_error_return(walk_digest_files(fs,
+                                              digest_path_from_path(fs, path,
+                                                                    pool),
+                                              get_locks_func, get_locks_baton,
+                                              have_write_lock, pool));
+
+  /* One range scan finds them all.  Read them before reporting any, as
+     reporting may delete expired locks. */
+  SVN_ERR(db_read_locks(&locks, db, path, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < locks->nelts; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(report_lock(fs, APR_ARRAY_IDX(locks, i, svn_lock_t *),
+                          get_locks_func, get_locks_baton, have_write_lock,
+                          iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Utility function:  verify that a lock can be used.  Interesting
    errors returned from this function:
 
@@ -628,9 +886,8 @@ svn_fs_fs__allow_locked_operation(const char *path,
   if (recurse)
     {
       /* Discover all locks at or below the path. */
-      const char *digest_path = digest_path_from_path(fs, path, pool);
-      SVN_ERR(walk_digest_files(fs, digest_path, get_locks_callback,
-                                fs, have_write_lock, pool));
+      SVN_ERR(walk_locks(fs, path, get_locks_callback, fs, have_write_lock,
+                         pool));
     }
   else
     {
@@ -908,13 +1165,287 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
                      void *get_locks_baton,
                      apr_pool_t *pool)
 {
-  const char *digest_path;
-
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
   path = svn_fs__canonicalize_abspath(path, pool);
 
-  /* Get the top digest path in our tree of interest, and then walk it. */
-  digest_path = digest_path_from_path(fs, path, pool);
-  return walk_digest_files(fs, digest_path, get_locks_func,
-                           get_locks_baton, FALSE, pool);
+  return walk_locks(fs, path, get_locks_func, get_locks_baton, FALSE, pool);
+}
+
+
+/*** Bulk locking and unlocking ***/
+
+/* The outcome of locking or unlocking one path. */
+struct lock_result_t {
+  const char *path;
+  const svn_fs__lock_target_t *target; /* locking only */
+  const char *token;                   /* unlocking only */
+  svn_lock_t *lock;
+  svn_error_t *err;
+};
+
+/* Baton used for lock_each(), unlock_each() and many_body() below. */
+struct many_baton {
+  svn_fs_t *fs;
+  apr_array_header_t *results; /* of struct lock_result_t */
+  const char *comment;
+  svn_boolean_t is_dav_comment;
+  apr_time_t expiration_date;
+  svn_boolean_t steal_lock;
+  svn_boolean_t break_lock;
+  svn_sqlite__transaction_callback_t each;
+  apr_pool_t *pool;
+};
+
+/* Lock each path in BATON->results, recording the outcome.  This
+   implements svn_sqlite__transaction_callback_t; DB is not used.
+   BATON is a 'struct many_baton *'. */
+static svn_error_t *
+lock_each(void *baton, svn_sqlite__db_t *db, apr_pool_t *scratch_pool)
+{
+  struct many_baton *mb = baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < mb->results->nelts; i++)
+    {
+      struct lock_result_t *result
+        = &APR_ARRAY_IDX(mb->results, i, struct lock_result_t);
+      struct lock_baton lb;
+
+      svn_pool_clear(iterpool);
+
+      lb.lock_p = &result->lock;
+      lb.fs = mb->fs;
+      lb.path = result->path;
+      lb.token = result->target->token;
+      lb.comment = mb->comment;
+      lb.is_dav_comment = mb->is_dav_comment;
+      lb.expiration_date = mb->expiration_date;
+      lb.current_rev = result->target->current_rev;
+      lb.steal_lock = mb->steal_lock;
+      lb.pool = mb->pool;
+
+      result->err = lock_body(&lb, iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Unlock each path in BATON->results, recording the outcome.  This
+   implements svn_sqlite__transaction_callback_t; DB is not used.
+   BATON is a 'struct many_baton *'. */
+static svn_error_t *
+unlock_each(void *baton, svn_sqlite__db_t *db, apr_pool_t *scratch_pool)
+{
+  struct many_baton *mb = baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < mb->results->nelts; i++)
+    {
+      struct lock_result_t *result
+        = &APR_ARRAY_IDX(mb->results, i, struct lock_result_t);
+      struct unlock_baton ub;
+
+      svn_pool_clear(iterpool);
+
+      ub.fs = mb->fs;
+      ub.path = result->path;
+      ub.token = result->token;
+      ub.break_lock = mb->break_lock;
+
+      result->err = unlock_body(&ub, iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements the svn_fs_fs__with_write_lock() 'body' callback
+   type, and assumes that the write lock is held.  Run BATON->each,
+   inside a single transaction of the lock database if there is one, so
+   that the whole batch costs one sync rather than one per path.
+   BATON is a 'struct many_baton *'. */
+static svn_error_t *
+many_body(void *baton, apr_pool_t *pool)
+{
+  struct many_baton *mb = baton;
+  svn_sqlite__db_t *db;
+
+  SVN_ERR(get_locks_db(&db, mb->fs, pool));
+  if (db)
+    return svn_error_return(svn_sqlite__with_transaction(db, mb->each, mb,
+                                                         pool));
+
+  return svn_error_return(mb->each(mb, NULL, pool));
+}
+
+/* Run MB->each under the write lock of MB->fs, then report every entry
+   of MB->results to LOCK_CALLBACK/LOCK_BATON.  The callbacks run only
+   after the write lock is released. */
+static svn_error_t *
+run_many(struct many_baton *mb,
+         svn_fs__lock_callback_t lock_callback,
+         void *lock_baton,
+         apr_pool_t *pool)
+{
+  svn_error_t *err;
+  svn_error_t *cb_err = SVN_NO_ERROR;
+  apr_pool_t *iterpool;
+  int i;
+
+  err = svn_fs_fs__with_write_lock(mb->fs, many_body, mb, pool);
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < mb->results->nelts; i++)
+    {
+      struct lock_result_t *result
+        = &APR_ARRAY_IDX(mb->results, i, struct lock_result_t);
+
+      svn_pool_clear(iterpool);
+      if (!err && !cb_err && lock_callback)
+        cb_err = lock_callback(lock_baton, result->path, result->lock,
+                               result->err, iterpool);
+      svn_error_clear(result->err);
+    }
+  svn_pool_destroy(iterpool);
+
+  if (err)
+    {
+      svn_error_clear(cb_err);
+      return svn_error_return(err);
+    }
+
+  return svn_error_return(cb_err);
+}
+
+svn_error_t *
+svn_fs_fs__lock_many(svn_fs_t *fs,
+                     apr_hash_t *targets,
+                     const char *comment,
+                     svn_boolean_t is_dav_comment,
+                     apr_time_t expiration_date,
+                     svn_boolean_t steal_lock,
+                     svn_fs__lock_callback_t lock_callback,
+                     void *lock_baton,
+                     apr_pool_t *pool)
+{
+  struct many_baton mb;
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_fs__check_fs(fs, TRUE));
+
+  mb.fs = fs;
+  mb.results = apr_array_make(pool, apr_hash_count(targets),
+                              sizeof(struct lock_result_t));
+  mb.comment = comment;
+  mb.is_dav_comment = is_dav_comment;
+  mb.expiration_date = expiration_date;
+  mb.steal_lock = steal_lock;
+  mb.break_lock = FALSE;
+  mb.each = lock_each;
+  mb.pool = pool;
+
+  for (hi = apr_hash_first(pool, targets); hi; hi = apr_hash_next(hi))
+    {
+      struct lock_result_t *result = apr_array_push(mb.results);
+
+      result->path = svn_fs__canonicalize_abspath(svn__apr_hash_index_key(hi),
+                                                  pool);
+      result->target = svn__apr_hash_index_val(hi);
+      result->token = NULL;
+      result->lock = NULL;
+      result->err = SVN_NO_ERROR;
+    }
+
+  return svn_error_return(run_many(&mb, lock_callback, lock_baton, pool));
+}
+
+svn_error_t *
+svn_fs_fs__unlock_many(svn_fs_t *fs,
+                       apr_hash_t *targets,
+                       svn_boolean_t break_lock,
+                       svn_fs__lock_callback_t lock_callback,
+                       void *lock_baton,
+                       apr_pool_t *pool)
+{
+  struct many_baton mb;
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_fs__check_fs(fs, TRUE));
+
+  mb.fs = fs;
+  mb.results = apr_array_make(pool, apr_hash_count(targets),
+                              sizeof(struct lock_result_t));
+  mb.comment = NULL;
+  mb.is_dav_comment = FALSE;
+  mb.expiration_date = 0;
+  mb.steal_lock = FALSE;
+  mb.break_lock = break_lock;
+  mb.each = unlock_each;
+  mb.pool = pool;
+
+  for (hi = apr_hash_first(pool, targets); hi; hi = apr_hash_next(hi))
+    {
+      struct lock_result_t *result = apr_array_push(mb.results);
+      const char *token = svn__apr_hash_index_val(hi);
+
+      result->path = svn_fs__canonicalize_abspath(svn__apr_hash_index_key(hi),
+                                                  pool);
+      result->target = NULL;
+      result->token = (token && *token) ? token : NULL;
+      result->lock = NULL;
+      result->err = SVN_NO_ERROR;
+    }
+
+  return svn_error_return(run_many(&mb, lock_callback, lock_baton, pool));
+}
+
+
+/*** Creating the lock database ***/
+
+/* This implements the svn_fs_get_locks_callback_t interface, where
+   BATON is the svn_sqlite__db_t * to copy LOCK into. */
+static svn_error_t *
+copy_lock_callback(void *baton,
+                   svn_lock_t *lock,
+                   apr_pool_t *pool)
+{
+  return svn_error_return(db_write_lock(baton, lock));
+}
+
+/* Copy all unexpired locks kept in the digest files of FS into DB.
+   This implements svn_sqlite__transaction_callback_t; BATON is the
+   svn_fs_t *. */
+static svn_error_t *
+import_digest_files(void *baton,
+                    svn_sqlite__db_t *db,
+                    apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = baton;
+
+  return svn_error_return(walk_digest_files(fs,
+                                            digest_path_from_path(fs, "/",
+                                                                  scratch_pool),
+                                            copy_lock_callback, db, FALSE,
+                                            scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__create_locks_db(svn_fs_t *fs,
+                           apr_pool_t *pool)
+{
+  const char *db_path = svn_dirent_join(fs->path, LOCKS_DB_NAME, pool);
+  svn_sqlite__db_t *db;
+
+  /* Start over if an earlier attempt got interrupted. */
+  SVN_ERR(svn_io_remove_file2(db_path, TRUE, pool));
+
+  SVN_ERR(svn_sqlite__open(&db, db_path, svn_sqlite__mode_rwcreate,
+                           statements, 0, NULL, NULL, pool, pool));
+  SVN_ERR(svn_sqlite__exec_statements(db, STMT_CREATE_SCHEMA));
+  SVN_ERR(svn_sqlite__with_transaction(db, import_digest_files, fs, pool));
+
+  return svn_error_return(svn_sqlite__close(db));
 }
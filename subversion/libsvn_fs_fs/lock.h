@@ -53,6 +53,23 @@ svn_error_t *svn_fs_fs__unlock(svn_fs_t *fs,
                                svn_boolean_t break_lock,
                                apr_pool_t *pool);
 
+svn_error_t *svn_fs_fs__lock_many(svn_fs_t *fs,
+                                  apr_hash_t *targets,
+                                  const char *comment,
+                                  svn_boolean_t is_dav_comment,
+                                  apr_time_t expiration_date,
+                                  svn_boolean_t steal_lock,
+                                  svn_fs__lock_callback_t lock_callback,
+                                  void *lock_baton,
+                                  apr_pool_t *pool);
+
+svn_error_t *svn_fs_fs__unlock_many(svn_fs_t *fs,
+                                    apr_hash_t *targets,
+                                    svn_boolean_t break_lock,
+                                    svn_fs__lock_callback_t lock_callback,
+                                    void *lock_baton,
+                                    apr_pool_t *pool);
+
 svn_error_t *svn_fs_fs__get_lock(svn_lock_t **lock,
                                  svn_fs_t *fs,
                                  const char *path,
@@ -95,6 +112,12 @@ svn_error_t *svn_fs_fs__allow_locked_operation(const char *path,
                                                svn_boolean_t have_write_lock,
                                                apr_pool_t *pool);
 
+/* Create the lock database of FS, replacing any existing one, and copy
+   into it all unexpired locks found in the digest files of FS.  Use POOL
+   for temporary allocations. */
+svn_error_t *svn_fs_fs__create_locks_db(svn_fs_t *fs,
+                                        apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,64 @@
+/* locks-db.sql -- schema of the lock store
+ *   This is intented for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+pragma auto_vacuum = 1;
+
+/* Every lock in the filesystem.  The dates are apr_time_t values;
+   EXPIRATION_DATE is 0 for locks that never expire. */
+create table locks (path text not null primary key,
+                    token text not null,
+                    owner text not null,
+                    comment text,
+                    is_dav_comment integer not null,
+                    creation_date integer not null,
+                    expiration_date integer not null);
+
+pragma user_version = 1;
+
+
+-- STMT_GET_LOCK
+select path, token, owner, comment, is_dav_comment, creation_date,
+       expiration_date
+from locks
+where path = ?1;
+
+
+-- STMT_GET_LOCKS
+/* The lock on ?1 and all locks in the range [?2, ?3) of paths below
+   it. */
+select path, token, owner, comment, is_dav_comment, creation_date,
+       expiration_date
+from locks
+where path = ?1 or (path >= ?2 and path < ?3);
+
+
+-- STMT_SET_LOCK
+insert or replace into locks (path, token, owner, comment, is_dav_comment,
+                              creation_date, expiration_date)
+values (?1, ?2, ?3, ?4, ?5, ?6, ?7);
+
+
+-- STMT_DELETE_LOCK
+delete from locks
+where path = ?1;
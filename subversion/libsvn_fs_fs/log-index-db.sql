@@ -0,0 +1,70 @@
+/* log-index-db.sql -- schema of the index of changed subtrees
+ *   This is intented for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+pragma auto_vacuum = 1;
+
+/* Every path at or above a path changed in REVISION.  ADDED is 1 if
+   PATH itself got added or replaced in REVISION, 0 otherwise. */
+create table log_changes (path text not null,
+                          revision integer not null,
+                          added integer not null,
+                          primary key (path, revision));
+
+/* The youngest revision whose changes are in log_changes. */
+create table indexed_revision (revision integer not null);
+
+insert into indexed_revision (revision) values (0);
+
+pragma user_version = 1;
+
+
+-- STMT_GET_INDEXED_REVISION
+select revision from indexed_revision;
+
+
+-- STMT_SET_INDEXED_REVISION
+update indexed_revision set revision = ?1;
+
+
+-- STMT_GET_PREV_CHANGE
+select revision, added from log_changes
+where path = ?1 and revision <= ?2
+order by revision desc
+limit 1;
+
+
+-- STMT_ADD_CHANGE
+insert or ignore into log_changes (path, revision, added)
+values (?1, ?2, 0);
+
+
+-- STMT_ADD_ADDITION
+insert or replace into log_changes (path, revision, added)
+values (?1, ?2, 1);
+
+
+-- STMT_TRUNCATE
+/* Forget the changes of all revisions younger than ?1. */
+delete from log_changes
+where revision > ?1;
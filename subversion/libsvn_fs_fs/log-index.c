@@ -0,0 +1,359 @@
+/* log-index.c --- the index of changed subtrees for fsfs
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_hash.h>
+
+#include "svn_private_config.h"
+
+#include "fs.h"
+#include "fs_fs.h"
+#include "log-index.h"
+#include "../libsvn_fs/fs-loader.h"
+
+#include "svn_dirent_uri.h"
+#include "svn_pools.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_fs_util.h"
+#include "private/svn_sqlite.h"
+
+#include "log-index-db.h"
+
+/* A few magic values */
+#define LOG_INDEX_SCHEMA_FORMAT   1
+
+LOG_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+
+/* Open the log index of FS, if there is one.  This implements the
+   svn_atomic__init_once() callback.  BATON is the svn_fs_t *. */
+static svn_error_t *
+open_log_index(void *baton,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *db_path;
+  svn_node_kind_t kind;
+  svn_sqlite__db_t *db;
+  int version;
+
+  /* Like the mergeinfo index, this one never gets created on demand. */
+  db_path = svn_dirent_join(fs->path, LOG_INDEX_DB_NAME, pool);
+  SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+  if (kind != svn_node_file)
+    return SVN_NO_ERROR;
+
+  /* The database will be automatically closed when fs->pool is
+     destroyed. */
+  SVN_ERR(svn_sqlite__open(&db, db_path, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, NULL, fs->pool, pool));
+
+  /* Leave indexes we don't know how to maintain alone. */
+  SVN_ERR(svn_sqlite__read_schema_version(&version, db, pool));
+  if (version != LOG_INDEX_SCHEMA_FORMAT)
+    return svn_error_return(svn_sqlite__close(db));
+
+  ffd->log_index_db = db;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DB to the log index of FS, or to NULL, if FS has none.  Use POOL
+   for temporary allocations. */
+static svn_error_t *
+get_index_db(svn_sqlite__db_t **db,
+             svn_fs_t *fs,
+             apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_ERR(svn_atomic__init_once(&ffd->log_index_opened,
+                                open_log_index, fs, pool));
+  *db = ffd->log_index_db;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *REV to the youngest revision covered by the index DB. */
+static svn_error_t *
+get_indexed_revision(svn_revnum_t *rev,
+                     svn_sqlite__db_t *db)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_GET_INDEXED_REVISION));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *rev = have_row ? svn_sqlite__column_revnum(stmt, 0) : SVN_INVALID_REVNUM;
+
+  return svn_error_return(svn_sqlite__reset(stmt));
+}
+
+/* Record REV as the youngest revision covered by the index DB. */
+static svn_error_t *
+set_indexed_revision(svn_sqlite__db_t *db,
+                     svn_revnum_t rev)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_SET_INDEXED_REVISION));
+  SVN_ERR(svn_sqlite__bindf(stmt, "i", (apr_int64_t)rev));
+
+  return svn_error_return(svn_sqlite__update(NULL, stmt));
+}
+
+/* Record in the index DB that PATH changed in revision REV, and that it
+   got added or replaced in REV if ADDED is set. */
+static svn_error_t *
+add_change(svn_sqlite__db_t *db,
+           const char *path,
+           svn_boolean_t added,
+           svn_revnum_t rev)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db,
+                                    added ? STMT_ADD_ADDITION
+                                          : STMT_ADD_CHANGE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "si", path, (apr_int64_t)rev));
+
+  return svn_error_return(svn_sqlite__update(NULL, stmt));
+}
+
+/* Baton for index_revision() and truncate_index(). */
+struct index_baton_t
+{
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+};
+
+/* Add the changes of revision BATON->REV of BATON->FS to the index DB,
+   the previous revision being the youngest one indexed already.  This
+   implements svn_sqlite__transaction_callback_t.  BATON is a
+   struct index_baton_t *. */
+static svn_error_t *
+index_revision(void *baton,
+               svn_sqlite__db_t *db,
+               apr_pool_t *scratch_pool)
+{
+  struct index_baton_t *b = baton;
+  svn_fs_fs__changes_iterator_t *changes;
+  apr_hash_t *parents = apr_hash_make(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_fs__changes_iterator_open(&changes, b->fs, b->rev,
+                                           scratch_pool));
+
+  while (TRUE)
+    {
+      const char *path;
+      svn_fs_path_change2_t *change;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_fs__changes_iterator_next(&path, &change, changes,
+                                               iterpool));
+      if (! path)
+        break;
+
+      SVN_ERR(add_change(db, path,
+                         change->change_kind == svn_fs_path_change_add
+                         || change->change_kind == svn_fs_path_change_replace,
+                         b->rev));
+
+      /* Every directory above a change changes with it.  Stop at the
+         first one recorded for an earlier change already. */
+      while (! svn_uri_is_root(path, strlen(path)))
+        {
+          path = svn_uri_dirname(path, scratch_pool);
+          if (apr_hash_get(parents, path, APR_HASH_KEY_STRING))
+            break;
+
+          apr_hash_set(parents, path, APR_HASH_KEY_STRING, path);
+          SVN_ERR(add_change(db, path, FALSE, b->rev));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_return(set_indexed_revision(db, b->rev));
+}
+
+/* Drop all revisions younger than BATON->REV from the index DB.  This
+   implements svn_sqlite__transaction_callback_t.  BATON is a
+   struct index_baton_t *. */
+static svn_error_t *
+truncate_index(void *baton,
+               svn_sqlite__db_t *db,
+               apr_pool_t *scratch_pool)
+{
+  struct index_baton_t *b = baton;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_TRUNCATE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "i", (apr_int64_t)b->rev));
+  SVN_ERR(svn_sqlite__update(NULL, stmt));
+
+  return svn_error_return(set_indexed_revision(db, b->rev));
+}
+
+svn_error_t *
+svn_fs_fs__create_log_index(svn_fs_t *fs,
+                            apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *db_path = svn_dirent_join(fs->path, LOG_INDEX_DB_NAME, pool);
+  svn_sqlite__db_t *db;
+
+  /* Make sure no one will open the index behind our back. */
+  SVN_ERR(get_index_db(&db, fs, pool));
+  if (db)
+    {
+      ffd->log_index_db = NULL;
+      SVN_ERR(svn_sqlite__close(db));
+    }
+  SVN_ERR(svn_io_remove_file2(db_path, TRUE, pool));
+
+  SVN_ERR(svn_sqlite__open(&db, db_path, svn_sqlite__mode_rwcreate,
+                           statements, 0, NULL, NULL, fs->pool, pool));
+  SVN_ERR(svn_sqlite__exec_statements(db, STMT_CREATE_SCHEMA));
+  ffd->log_index_db = db;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__update_log_index(svn_fs_t *fs,
+                            svn_revnum_t youngest,
+                            apr_pool_t *pool)
+{
+  svn_sqlite__db_t *db;
+  struct index_baton_t b;
+  svn_revnum_t indexed;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(get_index_db(&db, fs, pool));
+  if (! db)
+    return SVN_NO_ERROR;
+
+  b.fs = fs;
+  SVN_ERR(get_indexed_revision(&indexed, db));
+
+  if (indexed > youngest)
+    {
+      b.rev = youngest;
+      SVN_ERR(svn_sqlite__with_transaction(db, truncate_index, &b, pool));
+      return SVN_NO_ERROR;
+    }
+
+  /* Index each revision atomically, so an interrupted update can be
+     resumed with the first revision missing. */
+  iterpool = svn_pool_create(pool);
+  for (b.rev = indexed + 1; b.rev <= youngest; b.rev++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_sqlite__with_transaction(db, index_revision, &b,
+                                           iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__reset_log_index(svn_fs_t *fs,
+                           svn_revnum_t rev,
+                           apr_pool_t *pool)
+{
+  svn_sqlite__db_t *db;
+  struct index_baton_t b;
+  svn_revnum_t indexed;
+
+  SVN_ERR(get_index_db(&db, fs, pool));
+  if (! db)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_indexed_revision(&indexed, db));
+  if (indexed < rev)
+    return SVN_NO_ERROR;
+
+  b.fs = fs;
+  b.rev = rev - 1;
+
+  return svn_error_return(svn_sqlite__with_transaction(db, truncate_index,
+                                                       &b, pool));
+}
+
+svn_error_t *
+svn_fs_fs__log_index_prev(svn_boolean_t *indexed,
+                          svn_revnum_t *revision,
+                          svn_boolean_t *added,
+                          svn_fs_t *fs,
+                          const char *path,
+                          svn_revnum_t rev,
+                          apr_pool_t *pool)
+{
+  svn_sqlite__db_t *db;
+  svn_sqlite__stmt_t *stmt;
+  svn_revnum_t indexed_rev;
+  svn_boolean_t have_row;
+  svn_error_t *err;
+
+  *indexed = FALSE;
+
+  /* An unusable index is no reason to fail the query; the caller will
+     simply walk the history itself. */
+  err = get_index_db(&db, fs, pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  if (! db)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_indexed_revision(&indexed_rev, db));
+  if (! SVN_IS_VALID_REVNUM(indexed_rev) || indexed_rev < rev)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_GET_PREV_CHANGE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "si",
+                            svn_fs__canonicalize_abspath(path, pool),
+                            (apr_int64_t)rev));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    {
+      *revision = svn_sqlite__column_revnum(stmt, 0);
+      *added = svn_sqlite__column_boolean(stmt, 1);
+    }
+  else
+    {
+      *revision = SVN_INVALID_REVNUM;
+      *added = FALSE;
+    }
+  *indexed = TRUE;
+
+  return svn_error_return(svn_sqlite__reset(stmt));
+}
@@ -0,0 +1,85 @@
+/* log-index.h : interface to the index of changed subtrees
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_LOG_INDEX_H
+#define SVN_LIBSVN_FS_FS_LOG_INDEX_H
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+#define LOG_INDEX_DB_NAME  "log-index.db"
+
+/* Create an empty log index for FS, replacing any existing one.  The
+   index will be up to date for revision 0 only.  Use POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__create_log_index(svn_fs_t *fs,
+                            apr_pool_t *pool);
+
+/* Index the changed paths of all revisions of FS up to and including
+   YOUNGEST which have not been indexed yet.  Revisions younger than
+   YOUNGEST get dropped from the index.  This is a no-op if FS has no
+   log index.  The caller must hold the FS write lock.  Use POOL for
+   temporary allocations. */
+svn_error_t *
+svn_fs_fs__update_log_index(svn_fs_t *fs,
+                            svn_revnum_t youngest,
+                            apr_pool_t *pool);
+
+/* Drop revision REV and all younger revisions of FS from the log index.
+   They will be indexed again by the next svn_fs_fs__update_log_index()
+   call.  The caller must hold the FS write lock.  Use POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__reset_log_index(svn_fs_t *fs,
+                           svn_revnum_t rev,
+                           apr_pool_t *pool);
+
+/* Set *REVISION to the youngest revision no younger than REV in which
+   PATH or anything below it changed in FS, and *ADDED to whether PATH
+   itself got added or replaced in that revision.  Set *REVISION to
+   SVN_INVALID_REVNUM if there is no such revision.  If the log index of
+   FS cannot answer that, e.g. because there is no index or REV has not
+   been indexed yet, set *INDEXED to FALSE and leave the other results
+   alone, else set it to TRUE.  Use POOL for temporary allocations.
+
+   This implements the fs_vtable_t.log_index_prev() API. */
+svn_error_t *
+svn_fs_fs__log_index_prev(svn_boolean_t *indexed,
+                          svn_revnum_t *revision,
+                          svn_boolean_t *added,
+                          svn_fs_t *fs,
+                          const char *path,
+                          svn_revnum_t rev,
+                          apr_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_LOG_INDEX_H */
@@ -0,0 +1,95 @@
+/* mergeinfo-index-db.sql -- schema of the index of paths with mergeinfo
+ *   This is intented for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+pragma auto_vacuum = 1;
+
+/* Every path that carries svn:mergeinfo from revision ADDED up to, but
+   not including, revision REMOVED.  REMOVED is null while the path
+   still carries mergeinfo. */
+create table mergeinfo_paths (path text not null,
+                              added integer not null,
+                              removed integer);
+
+create index i_mergeinfo_path on mergeinfo_paths (path);
+
+/* The youngest revision whose changes are in mergeinfo_paths. */
+create table indexed_revision (revision integer not null);
+
+insert into indexed_revision (revision) values (0);
+
+pragma user_version = 1;
+
+
+-- STMT_GET_INDEXED_REVISION
+select revision from indexed_revision;
+
+
+-- STMT_SET_INDEXED_REVISION
+update indexed_revision set revision = ?1;
+
+
+-- STMT_GET_PATHS
+select path from mergeinfo_paths
+where path >= ?1 and path < ?2
+  and added <= ?3 and (removed is null or removed > ?3);
+
+
+-- STMT_HAS_PATH
+select 1 from mergeinfo_paths
+where path = ?1 and removed is null;
+
+
+-- STMT_ADD_PATH
+insert into mergeinfo_paths (path, added)
+values (?1, ?2);
+
+
+-- STMT_REMOVE_PATH
+update mergeinfo_paths set removed = ?2
+where path = ?1 and removed is null;
+
+
+-- STMT_REMOVE_PATHS
+update mergeinfo_paths set removed = ?3
+where path >= ?1 and path < ?2 and removed is null;
+
+
+-- STMT_PURGE_EMPTY
+delete from mergeinfo_paths
+where removed = added;
+
+
+-- STMT_CLEAR
+delete from mergeinfo_paths;
+
+
+-- STMT_TRUNCATE_ADDED
+/* Forget the changes of all revisions younger than ?1. */
+delete from mergeinfo_paths
+where added > ?1;
+
+
+-- STMT_TRUNCATE_REMOVED
+update mergeinfo_paths set removed = null
+where removed > ?1;
@@ -0,0 +1,499 @@
+/* mergeinfo-index.c --- the index of paths with mergeinfo for fsfs
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_strings.h>
+
+#include "svn_private_config.h"
+
+#include "fs.h"
+#include "fs_fs.h"
+#include "mergeinfo-index.h"
+#include "../libsvn_fs/fs-loader.h"
+
+#include "svn_dirent_uri.h"
+#include "svn_pools.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_sqlite.h"
+
+#include "mergeinfo-index-db.h"
+
+/* A few magic values */
+#define MERGEINFO_INDEX_SCHEMA_FORMAT   1
+
+MERGEINFO_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+
+/* Open the mergeinfo index of FS, if there is one.  This implements the
+   svn_atomic__init_once() callback.  BATON is the svn_fs_t *. */
+static svn_error_t *
+open_mergeinfo_index(void *baton,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *db_path;
+  svn_node_kind_t kind;
+  svn_sqlite__db_t *db;
+  int version;
+
+  /* Unlike the rep cache, the index never gets created on demand.  It
+     is only of any use if it covers all revisions of FS. */
+  db_path = svn_dirent_join(fs->path, MERGEINFO_INDEX_DB_NAME, pool);
+  SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+  if (kind != svn_node_file)
+    return SVN_NO_ERROR;
+
+  /* The database will be automatically closed when fs->pool is
+     destroyed. */
+  SVN_ERR(svn_sqlite__open(&db, db_path, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, NULL, fs->pool, pool));
+
+  /* Leave indexes we don't know how to maintain alone. */
+  SVN_ERR(svn_sqlite__read_schema_version(&version, db, pool));
+  if (version != MERGEINFO_INDEX_SCHEMA_FORMAT)
+    return svn_error_return(svn_sqlite__close(db));
+
+  ffd->mergeinfo_index_db = db;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DB to the mergeinfo index of FS, or to NULL, if FS has none.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+get_index_db(svn_sqlite__db_t **db,
+             svn_fs_t *fs,
+             apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_ERR(svn_atomic__init_once(&ffd->mergeinfo_index_opened,
+                                open_mergeinfo_index, fs, pool));
+  *db = ffd->mergeinfo_index_db;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *LOWER and *UPPER to the bounds of the half-open range of paths
+   strictly below the canonical absolute PATH, except that the range
+   includes PATH itself if that is the root.  Allocate the bounds in
+   POOL. */
+static void
+get_descendant_range(const char **lower,
+                     const char **upper,
+                     const char *path,
+                     apr_pool_t *pool)
+{
+  /* '0' is the character right after '/', so these bounds include
+     "PATH/x" but not "PATH-x" or "PATHx". */
+  if (path[0] == '/' && path[1] == '\0')
+    {
+      *lower = "/";
+      *upper = "0";
+    }
+  else
+    {
+      *lower = apr_pstrcat(pool, path, "/", (char *)NULL);
+      *upper = apr_pstrcat(pool, path, "0", (char *)NULL);
+    }
+}
+
+/* Set *REV to the youngest revision covered by the index DB. */
+static svn_error_t *
+get_indexed_revision(svn_revnum_t *rev,
+                     svn_sqlite__db_t *db)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_GET_INDEXED_REVISION));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *rev = have_row ? svn_sqlite__column_revnum(stmt, 0) : SVN_INVALID_REVNUM;
+
+  return svn_error_return(svn_sqlite__reset(stmt));
+}
+
+/* Record REV as the youngest revision covered by the index DB. */
+static svn_error_t *
+set_indexed_revision(svn_sqlite__db_t *db,
+                     svn_revnum_t rev)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_SET_INDEXED_REVISION));
+  SVN_ERR(svn_sqlite__bindf(stmt, "i", (apr_int64_t)rev));
+
+  return svn_error_return(svn_sqlite__update(NULL, stmt));
+}
+
+/* Set *PATHS to the paths (const char *) in the index DB in the range
+   LOWER to UPPER which carry mergeinfo in revision REV.  Allocate *PATHS
+   in RESULT_POOL. */
+static svn_error_t *
+select_paths(apr_array_header_t **paths,
+             svn_sqlite__db_t *db,
+             const char *lower,
+             const char *upper,
+             svn_revnum_t rev,
+             apr_pool_t *result_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  *paths = apr_array_make(result_pool, 0, sizeof(const char *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_GET_PATHS));
+  SVN_ERR(svn_sqlite__bindf(stmt, "ssi", lower, upper, (apr_int64_t)rev));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      APR_ARRAY_PUSH(*paths, const char *)
+        = svn_sqlite__column_text(stmt, 0, result_pool);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_return(svn_sqlite__reset(stmt));
+}
+
+/* Record in the index DB whether PATH carries mergeinfo as of revision
+   REV, according to HAS_MERGEINFO. */
+static svn_error_t *
+set_path(svn_sqlite__db_t *db,
+         const char *path,
+         svn_boolean_t has_mergeinfo,
+         svn_revnum_t rev)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t indexed;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_HAS_PATH));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path));
+  SVN_ERR(svn_sqlite__step(&indexed, stmt));
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  if (has_mergeinfo && ! indexed)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_ADD_PATH));
+      SVN_ERR(svn_sqlite__bindf(stmt, "si", path, (apr_int64_t)rev));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+  else if (indexed && ! has_mergeinfo)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_REMOVE_PATH));
+      SVN_ERR(svn_sqlite__bindf(stmt, "si", path, (apr_int64_t)rev));
+      SVN_ERR(svn_sqlite__update(NULL, stmt));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Record in the index DB that PATH and all paths below it have been
+   deleted in revision REV.  Use POOL for temporary allocations. */
+static svn_error_t *
+remove_paths(svn_sqlite__db_t *db,
+             const char *path,
+             svn_revnum_t rev,
+             apr_pool_t *pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  const char *lower, *upper;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_REMOVE_PATH));
+  SVN_ERR(svn_sqlite__bindf(stmt, "si", path, (apr_int64_t)rev));
+  SVN_ERR(svn_sqlite__update(NULL, stmt));
+
+  get_descendant_range(&lower, &upper, path, pool);
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_REMOVE_PATHS));
+  SVN_ERR(svn_sqlite__bindf(stmt, "ssi", lower, upper, (apr_int64_t)rev));
+
+  return svn_error_return(svn_sqlite__update(NULL, stmt));
+}
+
+/* Record in the index DB that the paths below COPYFROM_PATH which carry
+   mergeinfo in revision COPYFROM_REV have been copied below PATH in
+   revision REV.  Use POOL for temporary allocations. */
+static svn_error_t *
+copy_paths(svn_sqlite__db_t *db,
+           const char *path,
+           const char *copyfrom_path,
+           svn_revnum_t copyfrom_rev,
+           svn_revnum_t rev,
+           apr_pool_t *pool)
+{
+  apr_array_header_t *copied;
+  const char *lower, *upper;
+  apr_size_t len = strlen(copyfrom_path);
+  int i;
+
+  /* Read all source paths first, as the copy may be below its source. */
+  get_descendant_range(&lower, &upper, copyfrom_path, pool);
+  SVN_ERR(select_paths(&copied, db, lower, upper, copyfrom_rev, pool));
+
+  for (i = 0; i < copied->nelts; i++)
+    {
+      const char *copied_path = APR_ARRAY_IDX(copied, i, const char *);
+      svn_sqlite__stmt_t *stmt;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_ADD_PATH));
+      SVN_ERR(svn_sqlite__bindf(stmt, "si",
+                                svn_uri_join(path, copied_path + len + 1,
+                                             pool),
+                                (apr_int64_t)rev));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for index_revision() and truncate_index(). */
+struct index_baton_t
+{
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+};
+
+/* Add the changes of revision BATON->REV of BATON->FS to the index DB,
+   the previous revision being the youngest one indexed already.  This
+   implements svn_sqlite__transaction_callback_t.  BATON is a
+   struct index_baton_t *. */
+static svn_error_t *
+index_revision(void *baton,
+               svn_sqlite__db_t *db,
+               apr_pool_t *scratch_pool)
+{
+  struct index_baton_t *b = baton;
+  svn_fs_fs__changes_iterator_t *changes;
+  svn_sqlite__stmt_t *stmt;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  /* The changes come parents first, so that deletions and changes below
+     a copy apply to the paths copied. */
+  SVN_ERR(svn_fs_fs__changes_iterator_open(&changes, b->fs, b->rev,
+                                           scratch_pool));
+
+  while (TRUE)
+    {
+      const char *path;
+      svn_fs_path_change2_t *change;
+      node_revision_t *noderev;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_fs__changes_iterator_next(&path, &change, changes,
+                                               iterpool));
+      if (! path)
+        break;
+
+      if (change->change_kind == svn_fs_path_change_delete
+          || change->change_kind == svn_fs_path_change_replace)
+        SVN_ERR(remove_paths(db, path, b->rev, iterpool));
+
+      if (change->change_kind == svn_fs_path_change_delete)
+        continue;
+
+      if (change->copyfrom_path
+          && (change->change_kind == svn_fs_path_change_add
+              || change->change_kind == svn_fs_path_change_replace))
+        SVN_ERR(copy_paths(db, path, change->copyfrom_path,
+                           change->copyfrom_rev, b->rev, iterpool));
+
+      if (change->change_kind != svn_fs_path_change_modify
+          || change->prop_mod)
+        {
+          SVN_ERR(svn_fs_fs__get_node_revision(&noderev, b->fs,
+                                               change->node_rev_id,
+                                               iterpool));
+          SVN_ERR(set_path(db, path, noderev->has_mergeinfo, b->rev));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Paths which got added and removed within REV never carried any
+     mergeinfo. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_PURGE_EMPTY));
+  SVN_ERR(svn_sqlite__update(NULL, stmt));
+
+  return svn_error_return(set_indexed_revision(db, b->rev));
+}
+
+/* Drop all revisions younger than BATON->REV from the index DB.  This
+   implements svn_sqlite__transaction_callback_t.  BATON is a
+   struct index_baton_t *. */
+static svn_error_t *
+truncate_index(void *baton,
+               svn_sqlite__db_t *db,
+               apr_pool_t *scratch_pool)
+{
+  struct index_baton_t *b = baton;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_TRUNCATE_ADDED));
+  SVN_ERR(svn_sqlite__bindf(stmt, "i", (apr_int64_t)b->rev));
+  SVN_ERR(svn_sqlite__update(NULL, stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_TRUNCATE_REMOVED));
+  SVN_ERR(svn_sqlite__bindf(stmt, "i", (apr_int64_t)b->rev));
+  SVN_ERR(svn_sqlite__update(NULL, stmt));
+
+  return svn_error_return(set_indexed_revision(db, b->rev));
+}
+
+svn_error_t *
+svn_fs_fs__create_mergeinfo_index(svn_fs_t *fs,
+                                  apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *db_path = svn_dirent_join(fs->path, MERGEINFO_INDEX_DB_NAME,
+                                        pool);
+  svn_sqlite__db_t *db;
+
+  /* Make sure no one will open the index behind our back. */
+  SVN_ERR(get_index_db(&db, fs, pool));
+  if (db)
+    {
+      ffd->mergeinfo_index_db = NULL;
+      SVN_ERR(svn_sqlite__close(db));
+    }
+  SVN_ERR(svn_io_remove_file2(db_path, TRUE, pool));
+
+  SVN_ERR(svn_sqlite__open(&db, db_path, svn_sqlite__mode_rwcreate,
+                           statements, 0, NULL, NULL, fs->pool, pool));
+  SVN_ERR(svn_sqlite__exec_statements(db, STMT_CREATE_SCHEMA));
+  ffd->mergeinfo_index_db = db;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__update_mergeinfo_index(svn_fs_t *fs,
+                                  svn_revnum_t youngest,
+                                  apr_pool_t *pool)
+{
+  svn_sqlite__db_t *db;
+  struct index_baton_t b;
+  svn_revnum_t indexed;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(get_index_db(&db, fs, pool));
+  if (! db)
+    return SVN_NO_ERROR;
+
+  b.fs = fs;
+  SVN_ERR(get_indexed_revision(&indexed, db));
+
+  /* A hotcopy may have copied the index after more revisions have been
+     committed to the source. */
+  if (indexed > youngest)
+    {
+      b.rev = youngest;
+      SVN_ERR(svn_sqlite__with_transaction(db, truncate_index, &b, pool));
+      return SVN_NO_ERROR;
+    }
+
+  /* Index each revision atomically, so an interrupted update can be
+     resumed with the first revision missing. */
+  iterpool = svn_pool_create(pool);
+  for (b.rev = indexed + 1; b.rev <= youngest; b.rev++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_sqlite__with_transaction(db, index_revision, &b,
+                                           iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__reset_mergeinfo_index(svn_fs_t *fs,
+                                 svn_revnum_t rev,
+                                 apr_pool_t *pool)
+{
+  svn_sqlite__db_t *db;
+  struct index_baton_t b;
+  svn_revnum_t indexed;
+
+  SVN_ERR(get_index_db(&db, fs, pool));
+  if (! db)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_indexed_revision(&indexed, db));
+  if (indexed < rev)
+    return SVN_NO_ERROR;
+
+  b.fs = fs;
+  b.rev = rev - 1;
+
+  return svn_error_return(svn_sqlite__with_transaction(db, truncate_index,
+                                                       &b, pool));
+}
+
+svn_error_t *
+svn_fs_fs__get_mergeinfo_index_paths(apr_array_header_t **paths,
+                                     svn_fs_t *fs,
+                                     svn_revnum_t rev,
+                                     const char *path,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *db;
+  svn_revnum_t indexed;
+  const char *lower, *upper;
+  svn_error_t *err;
+  int i;
+
+  *paths = NULL;
+
+  /* An unusable index is no reason to fail the query; the caller will
+     simply look at the tree itself. */
+  err = get_index_db(&db, fs, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  if (! db)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_indexed_revision(&indexed, db));
+  if (! SVN_IS_VALID_REVNUM(indexed) || indexed < rev)
+    return SVN_NO_ERROR;
+
+  get_descendant_range(&lower, &upper, path, scratch_pool);
+  SVN_ERR(select_paths(paths, db, lower, upper, rev, result_pool));
+
+  /* The range for the root includes the root itself. */
+  for (i = 0; i < (*paths)->nelts; i++)
+    if (strcmp(APR_ARRAY_IDX(*paths, i, const char *), path) == 0)
+      {
+        APR_ARRAY_IDX(*paths, i, const char *)
+          = APR_ARRAY_IDX(*paths, (*paths)->nelts - 1, const char *);
+        apr_array_pop(*paths);
+        break;
+      }
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,82 @@
+/* mergeinfo-index.h : interface to the index of paths with mergeinfo
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H
+#define SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+#define MERGEINFO_INDEX_DB_NAME  "mergeinfo-index.db"
+
+/* Create an empty mergeinfo index for FS, replacing any existing one.
+   The index will be up to date for revision 0 only.  Use POOL for
+   temporary allocations. */
+svn_error_t *
+svn_fs_fs__create_mergeinfo_index(svn_fs_t *fs,
+                                  apr_pool_t *pool);
+
+/* Index the paths with mergeinfo in all revisions of FS up to and
+   including YOUNGEST which have not been indexed yet.  Revisions younger
+   than YOUNGEST get dropped from the index.  This is a no-op if FS has
+   no mergeinfo index.  The caller must hold the FS write lock.  Use POOL
+   for temporary allocations. */
+svn_error_t *
+svn_fs_fs__update_mergeinfo_index(svn_fs_t *fs,
+                                  svn_revnum_t youngest,
+                                  apr_pool_t *pool);
+
+/* Drop revision REV and all younger revisions of FS from the mergeinfo
+   index, e.g. because the contents of REV have been replaced.  They will
+   be indexed again by the next svn_fs_fs__update_mergeinfo_index() call.
+   The caller must hold the FS write lock.  Use POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__reset_mergeinfo_index(svn_fs_t *fs,
+                                 svn_revnum_t rev,
+                                 apr_pool_t *pool);
+
+/* Set *PATHS to an array of the canonical absolute paths (const char *)
+   strictly below PATH which carry mergeinfo in revision REV of FS.  If
+   the mergeinfo index of FS cannot answer that, e.g. because there is
+   no index or REV has not been indexed yet, set *PATHS to NULL.  PATH
+   must be a canonical absolute path.  Allocate *PATHS in RESULT_POOL;
+   use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_mergeinfo_index_paths(apr_array_header_t **paths,
+                                     svn_fs_t *fs,
+                                     svn_revnum_t rev,
+                                     const char *path,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H */
@@ -0,0 +1,42 @@
+/* node-origins-db.sql -- schema of the node origins store
+ *   This is intented for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+pragma auto_vacuum = 1;
+
+/* The node-revision ID NODE_REV_ID where the history of all nodes with
+   the pre-format 3 node ID NODE_ID begins. */
+create table node_origins (node_id text not null primary key,
+                           node_rev_id text not null);
+
+pragma user_version = 1;
+
+
+-- STMT_GET_NODE_ORIGIN
+select node_rev_id from node_origins
+where node_id = ?1;
+
+
+-- STMT_INSERT_NODE_ORIGIN
+insert or ignore into node_origins (node_id, node_rev_id)
+values (?1, ?2);
@@ -0,0 +1,356 @@
+/* node-origins.c --- the node origins store of fsfs
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_hash.h>
+
+#include "svn_private_config.h"
+
+#include "fs.h"
+#include "id.h"
+#include "node-origins.h"
+
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_sqlite.h"
+
+#include "node-origins-db.h"
+
+/* A few magic values */
+#define NODE_ORIGINS_SCHEMA_FORMAT   1
+
+/* Number of queued node origins which get the queue written to the
+   database. */
+#define NODE_ORIGINS_BATCH_SIZE      256
+
+NODE_ORIGINS_DB_SQL_DECLARE_STATEMENTS(statements);
+
+
+/* Return the file in the node-origins directory of FS in which releases
+   before the node origins database stored the origin of NODE_ID.  The
+   file name is NODE_ID without its last character. */
+static const char *
+path_node_origin(svn_fs_t *fs, const char *node_id, apr_pool_t *pool)
+{
+  size_t len = strlen(node_id);
+  const char *node_id_minus_last_char =
+    (len == 1) ? "0" : apr_pstrmemdup(pool, node_id, len - 1);
+  return svn_dirent_join_many(pool, fs->path, PATH_NODE_ORIGINS_DIR,
+                              node_id_minus_last_char, NULL);
+}
+
+/* Set *NODE_ORIGINS to a hash mapping 'const char *' node IDs to
+   'svn_string_t *' node revision IDs.  Use POOL for allocations. */
+static svn_error_t *
+get_node_origins_from_file(svn_fs_t *fs,
+                           apr_hash_t **node_origins,
+                           const char *node_origins_file,
+                           apr_pool_t *pool)
+{
+  apr_file_t *fd;
+  svn_error_t *err;
+  svn_stream_t *stream;
+
+  *node_origins = NULL;
+  err = svn_io_file_open(&fd, node_origins_file,
+                         APR_READ, APR_OS_DEFAULT, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  stream = svn_stream_from_aprfile2(fd, FALSE, pool);
+  *node_origins = apr_hash_make(pool);
+  SVN_ERR(svn_hash_read2(*node_origins, stream, SVN_HASH_TERMINATOR, pool));
+  return svn_stream_close(stream);
+}
+
+/* Pool cleanup function writing the queued node origins of the
+   svn_fs_t * DATA to the database before that gets closed. */
+static apr_status_t
+flush_node_origins_cleanup(void *data)
+{
+  svn_fs_t *fs = data;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  /* There is nobody to report errors to.  Lost entries will simply be
+     calculated again. */
+  svn_error_clear(svn_fs_fs__flush_node_origins(fs, pool));
+
+  svn_pool_destroy(pool);
+  svn_pool_destroy(ffd->node_origins_batch_pool);
+  ffd->node_origins_batch = NULL;
+
+  return APR_SUCCESS;
+}
+
+/* Open, and create if necessary, the node origins database of FS in
+   *DB.  Use POOL for temporary allocations. */
+static svn_error_t *
+open_db(svn_sqlite__db_t **db,
+        svn_fs_t *fs,
+        apr_pool_t *pool)
+{
+  int version;
+  svn_error_t *err;
+
+  /* The database will be automatically closed when fs->pool is
+     destroyed. */
+  SVN_ERR(svn_sqlite__open(db,
+                           svn_dirent_join(fs->path, NODE_ORIGINS_DB_NAME,
+                                           pool),
+                           svn_sqlite__mode_rwcreate, statements,
+                           0, NULL, NULL, fs->pool, pool));
+
+  err = svn_sqlite__read_schema_version(&version, *db, pool);
+  if (!err && version == 0)
+    {
+      /* An uninitialized (no schema) database. */
+      err = svn_sqlite__exec_statements(*db, STMT_CREATE_SCHEMA);
+      version = NODE_ORIGINS_SCHEMA_FORMAT;
+    }
+
+  /* Leave databases we don't know how to maintain alone. */
+  if (!err && version != NODE_ORIGINS_SCHEMA_FORMAT)
+    err = svn_error_createf(SVN_ERR_FS_UNSUPPORTED_FORMAT, NULL,
+                            _("Unsupported node origins schema %d"),
+                            version);
+
+  if (err)
+    {
+      svn_error_clear(svn_sqlite__close(*db));
+      *db = NULL;
+    }
+
+  return svn_error_return(err);
+}
+
+/* Open the node origins database of FS, if possible.  This implements
+   the svn_atomic__init_once() callback.  BATON is the svn_fs_t *. */
+static svn_error_t *
+open_node_origins(void *baton,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *db;
+  svn_error_t *err;
+
+  /* This is just a cache.  If it cannot be opened, e.g. because the
+     repository is read-only, do without it. */
+  err = open_db(&db, fs, pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  /* The batch pool must outlive the sub-pools of FS->POOL, which get
+     destroyed before the cleanup below is run.  Cleanups, in turn, run
+     in reverse order of registration, i.e. before the database gets
+     closed. */
+  ffd->node_origins_batch_pool = svn_pool_create(NULL);
+  ffd->node_origins_batch = apr_hash_make(ffd->node_origins_batch_pool);
+  apr_pool_cleanup_register(fs->pool, fs, flush_node_origins_cleanup,
+                            apr_pool_cleanup_null);
+
+  ffd->node_origins_db = db;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DB to the node origins database of FS, or to NULL, if it is not
+   available.  Use POOL for temporary allocations. */
+static svn_error_t *
+get_node_origins_db(svn_sqlite__db_t **db,
+                    svn_fs_t *fs,
+                    apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_ERR(svn_atomic__init_once(&ffd->node_origins_db_opened,
+                                open_node_origins, fs, pool));
+  *db = ffd->node_origins_db;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_node_origin(const svn_fs_id_t **origin_id,
+                           svn_fs_t *fs,
+                           const char *node_id,
+                           apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *db;
+  svn_string_t *origin_id_str = NULL;
+
+  *origin_id = NULL;
+
+  SVN_ERR(get_node_origins_db(&db, fs, pool));
+  if (db)
+    {
+      origin_id_str = apr_hash_get(ffd->node_origins_batch, node_id,
+                                   APR_HASH_KEY_STRING);
+      if (! origin_id_str)
+        {
+          svn_sqlite__stmt_t *stmt;
+          svn_boolean_t have_row;
+
+          SVN_ERR(svn_sqlite__get_statement(&stmt, db,
+                                            STMT_GET_NODE_ORIGIN));
+          SVN_ERR(svn_sqlite__bindf(stmt, "s", node_id));
+          SVN_ERR(svn_sqlite__step(&have_row, stmt));
+          if (have_row)
+            origin_id_str = svn_string_create(
+                              svn_sqlite__column_text(stmt, 0, NULL), pool);
+          SVN_ERR(svn_sqlite__reset(stmt));
+        }
+    }
+
+  /* Fall back to the files written by older releases. */
+  if (! origin_id_str)
+    {
+      apr_hash_t *node_origins;
+
+      SVN_ERR(get_node_origins_from_file(fs, &node_origins,
+                                         path_node_origin(fs, node_id, pool),
+                                         pool));
+      if (node_origins)
+        origin_id_str = apr_hash_get(node_origins, node_id,
+                                     APR_HASH_KEY_STRING);
+    }
+
+  if (origin_id_str)
+    *origin_id = svn_fs_fs__id_parse(origin_id_str->data,
+                                     origin_id_str->len, pool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__set_node_origin(svn_fs_t *fs,
+                           const char *node_id,
+                           const svn_fs_id_t *node_rev_id,
+                           apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *db;
+  const svn_fs_id_t *old_id;
+  svn_string_t *node_rev_id_str = svn_fs_fs__id_unparse(node_rev_id, pool);
+  svn_error_t *err;
+
+  SVN_ERR(svn_fs_fs__get_node_origin(&old_id, fs, node_id, pool));
+  if (old_id)
+    {
+      svn_string_t *old_node_rev_id = svn_fs_fs__id_unparse(old_id, pool);
+
+      if (!svn_string_compare(node_rev_id_str, old_node_rev_id))
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Node origin for '%s' exists with a "
+                                   "different value (%s) than what we were "
+                                   "about to store (%s)"),
+                                 node_id, old_node_rev_id->data,
+                                 node_rev_id_str->data);
+      return SVN_NO_ERROR;
+    }
+
+  /* It's just a cache; stop trying if I can't write. */
+  SVN_ERR(get_node_origins_db(&db, fs, pool));
+  if (! db)
+    return SVN_NO_ERROR;
+
+  apr_hash_set(ffd->node_origins_batch,
+               apr_pstrdup(ffd->node_origins_batch_pool, node_id),
+               APR_HASH_KEY_STRING,
+               svn_string_dup(node_rev_id_str,
+                              ffd->node_origins_batch_pool));
+
+  if (apr_hash_count(ffd->node_origins_batch) < NODE_ORIGINS_BATCH_SIZE)
+    return SVN_NO_ERROR;
+
+  err = svn_fs_fs__flush_node_origins(fs, pool);
+  if (err && err->apr_err == SVN_ERR_SQLITE_READONLY)
+    {
+      svn_error_clear(err);
+      err = NULL;
+    }
+  return svn_error_return(err);
+}
+
+/* Implements svn_sqlite__transaction_callback_t.  BATON is the svn_fs_t
+   whose queued node origins are to be inserted. */
+static svn_error_t *
+insert_node_origins(void *baton,
+                    svn_sqlite__db_t *db,
+                    apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(scratch_pool, ffd->node_origins_batch);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_sqlite__stmt_t *stmt;
+      const svn_string_t *node_rev_id = svn__apr_hash_index_val(hi);
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, db,
+                                        STMT_INSERT_NODE_ORIGIN));
+      SVN_ERR(svn_sqlite__bindf(stmt, "ss", svn__apr_hash_index_key(hi),
+                                node_rev_id->data));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__flush_node_origins(svn_fs_t *fs,
+                              apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err;
+
+  if (! ffd->node_origins_batch
+      || apr_hash_count(ffd->node_origins_batch) == 0)
+    return SVN_NO_ERROR;
+
+  /* We use an sqlite transcation to speed things up;
+   * see <http://www.sqlite.org/faq.html#q19>. */
+  err = svn_sqlite__with_transaction(ffd->node_origins_db,
+                                     insert_node_origins, fs, pool);
+
+  /* Don't keep failing over the same entries.  They can be calculated
+     again. */
+  svn_pool_clear(ffd->node_origins_batch_pool);
+  ffd->node_origins_batch = apr_hash_make(ffd->node_origins_batch_pool);
+
+  return svn_error_return(err);
+}
@@ -43,3 +43,15 @@ where hash = ?1;
 -- STMT_SET_REP
 insert into rep_cache (hash, revision, offset, size, expanded_size)
 values (?1, ?2, ?3, ?4, ?5);
+
+
+-- STMT_GET_REP_HASHES_AFTER
+select rowid, hash
+from rep_cache
+where rowid > ?1
+order by rowid;
+
+
+-- STMT_GET_MAX_REP_ROWID
+select max(rowid)
+from rep_cache;
@@ -27,6 +27,7 @@
 #include "../libsvn_fs/fs-loader.h"
 
 #include "svn_path.h"
+#include "svn_pools.h"
 
 #include "private/svn_sqlite.h"
 
@@ -35,8 +36,365 @@
 /* A few magic values */
 #define REP_CACHE_SCHEMA_FORMAT   1
 
+/* Number of lookup results to remember per FS object before the lookup
+   cache gets flushed. */
+#define REP_LOOKUP_CACHE_SIZE     4096
+
 REP_CACHE_DB_SQL_DECLARE_STATEMENTS(statements);
 
+/* Lookup cache value for SHA1 digests known to be absent from the
+   database. */
+static representation_t missing_rep;
+
+/* Parameters of the Bloom filter over the rep-cache keys.  With
+   BLOOM_BITS_PER_KEY bits per key and BLOOM_HASHES hash functions, about
+   one lookup in 1000 for a missing key still needs a database query. */
+#define BLOOM_HASHES            8
+#define BLOOM_BITS_PER_KEY      16
+#define BLOOM_MIN_BITS          (1 << 19)
+
+/* The filter gets rebuilt with a larger size once it holds more than
+   one key per BLOOM_MIN_BITS_PER_KEY bits. */
+#define BLOOM_MIN_BITS_PER_KEY  10
+
+/* Rewrite the filter file once this many keys have been added since it
+   has been read. */
+#define BLOOM_SAVE_THRESHOLD    1024
+
+/* A Bloom filter over the SHA1 digests in the rep-cache database.  */
+struct rep_bloom_t
+{
+  /* The bit array and its size in bits, which is a power of two. */
+  unsigned char *bits;
+  apr_uint32_t bit_count;
+
+  /* Number of keys added, including duplicates. */
+  apr_int64_t key_count;
+
+  /* All database rows up to this rowid have been added. */
+  apr_int64_t max_rowid;
+
+  /* Number of keys added since the filter file has been read or written. */
+  apr_int64_t unsaved_count;
+
+  /* The pool of this filter.  It is not a sub-pool of FS->POOL for the
+     same reasons as the other rep-cache pools.  */
+  apr_pool_t *pool;
+};
+
+/* Return a new, empty Bloom filter of BIT_COUNT bits. */
+static struct rep_bloom_t *
+bloom_create(apr_uint32_t bit_count)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  struct rep_bloom_t *bloom = apr_pcalloc(pool, sizeof(*bloom));
+
+  bloom->bit_count = bit_count;
+  bloom->bits = apr_pcalloc(pool, bit_count / 8);
+  bloom->pool = pool;
+
+  return bloom;
+}
+
+/* Return the filter size in bits to use for about KEY_COUNT keys. */
+static apr_uint32_t
+bloom_size(apr_int64_t key_count)
+{
+  apr_uint32_t bit_count = BLOOM_MIN_BITS;
+
+  while (bit_count < APR_UINT32_MAX / 2
+         && bit_count / BLOOM_BITS_PER_KEY < key_count)
+    bit_count *= 2;
+
+  return bit_count;
+}
+
+/* Return the big-endian 32 bit value at DATA. */
+static apr_uint32_t
+bloom_decode(const unsigned char *data)
+{
+  return ((apr_uint32_t)data[0] << 24) + ((apr_uint32_t)data[1] << 16)
+       + ((apr_uint32_t)data[2] << 8) + data[3];
+}
+
+/* Return the position within BLOOM of bit number I for the SHA1 DIGEST.
+   The digest is a cryptographic hash already, so its parts can serve
+   as independent hash values directly. */
+static apr_uint32_t
+bloom_index(const struct rep_bloom_t *bloom,
+            const unsigned char *digest,
+            int i)
+{
+  apr_uint32_t h1 = bloom_decode(digest);
+  apr_uint32_t h2 = bloom_decode(digest + 4) | 1;
+
+  return (h1 + i * h2) & (bloom->bit_count - 1);
+}
+
+/* Add the SHA1 DIGEST to BLOOM. */
+static void
+bloom_add(struct rep_bloom_t *bloom,
+          const unsigned char *digest)
+{
+  int i;
+
+  for (i = 0; i < BLOOM_HASHES; ++i)
+    {
+      apr_uint32_t idx = bloom_index(bloom, digest, i);
+      bloom->bits[idx / 8] |= (unsigned char)(1 << (idx % 8));
+    }
+
+  ++bloom->key_count;
+  ++bloom->unsaved_count;
+}
+
+/* Return FALSE, if the SHA1 DIGEST has definitely not been added to
+   BLOOM. */
+static svn_boolean_t
+bloom_may_contain(const struct rep_bloom_t *bloom,
+                  const unsigned char *digest)
+{
+  int i;
+
+  for (i = 0; i < BLOOM_HASHES; ++i)
+    {
+      apr_uint32_t idx = bloom_index(bloom, digest, i);
+      if ((bloom->bits[idx / 8] & (1 << (idx % 8))) == 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Read the Bloom filter file of FS into *BLOOM.  Set *BLOOM to NULL, if
+   there is no such file or if it is not usable.  The file consists of a
+   header line "<bit count> <key count> <max rowid>\n" followed by the
+   bit array.  Use POOL for temporary allocations. */
+static svn_error_t *
+bloom_read(struct rep_bloom_t **bloom,
+           svn_fs_t *fs,
+           apr_pool_t *pool)
+{
+  svn_stringbuf_t *content;
+  apr_int64_t bit_count, key_count, max_rowid;
+  const char *bits;
+  svn_error_t *err;
+
+  *bloom = NULL;
+
+  err = svn_stringbuf_from_file2(&content,
+                                 svn_dirent_join(fs->path,
+                                                 REP_CACHE_BLOOM_NAME, pool),
+                                 pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  bits = memchr(content->data, '\n', content->len);
+  if (bits == NULL
+      || sscanf(content->data, "%" APR_INT64_T_FMT " %" APR_INT64_T_FMT
+                " %" APR_INT64_T_FMT, &bit_count, &key_count,
+                &max_rowid) != 3
+      || bit_count < BLOOM_MIN_BITS
+      || bit_count > APR_UINT32_MAX / 2 + 1
+      || (bit_count & (bit_count - 1)) != 0
+      || content->data + content->len - (bits + 1) != bit_count / 8)
+    return SVN_NO_ERROR;
+
+  *bloom = bloom_create((apr_uint32_t)bit_count);
+  memcpy((*bloom)->bits, bits + 1, (apr_size_t)bit_count / 8);
+  (*bloom)->key_count = key_count;
+  (*bloom)->max_rowid = max_rowid;
+
+  return SVN_NO_ERROR;
+}
+
+/* Atomically replace the Bloom filter file of FS with the contents of
+   BLOOM.  Use POOL for temporary allocations. */
+static svn_error_t *
+bloom_write(struct rep_bloom_t *bloom,
+            svn_fs_t *fs,
+            apr_pool_t *pool)
+{
+  const char *path = svn_dirent_join(fs->path, REP_CACHE_BLOOM_NAME, pool);
+  const char *tmp_path;
+  svn_stringbuf_t *content;
+
+  content = svn_stringbuf_create(apr_psprintf(pool,
+                                              "%" APR_INT64_T_FMT
+                                              " %" APR_INT64_T_FMT
+                                              " %" APR_INT64_T_FMT "\n",
+                                              (apr_int64_t)bloom->bit_count,
+                                              bloom->key_count,
+                                              bloom->max_rowid),
+                                 pool);
+  svn_stringbuf_appendbytes(content, (const char *)bloom->bits,
+                            bloom->bit_count / 8);
+
+  SVN_ERR(svn_io_write_unique(&tmp_path, fs->path, content->data,
+                              content->len, svn_io_file_del_none, pool));
+  SVN_ERR(svn_io_file_rename(tmp_path, path, pool));
+
+  bloom->unsaved_count = 0;
+  return SVN_NO_ERROR;
+}
+
+/* Add all rows of the database of FS that are not in FFD->REP_BLOOM yet.
+   If the filter gets too full, replace it by a larger one.  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+bloom_catch_up(svn_fs_t *fs,
+               apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  struct rep_bloom_t *bloom = ffd->rep_bloom;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_REP_HASHES_AFTER));
+  SVN_ERR(svn_sqlite__bindf(stmt, "i", bloom->max_rowid));
+
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      svn_checksum_t *checksum;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      err = svn_checksum_parse_hex(&checksum, svn_checksum_sha1,
+                                   svn_sqlite__column_text(stmt, 1, NULL),
+                                   iterpool);
+      if (err)
+        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+
+      bloom_add(bloom, checksum->digest);
+      bloom->max_rowid = svn_sqlite__column_int64(stmt, 0);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+  svn_pool_destroy(iterpool);
+
+  /* Too many false positives?  Then re-populate a larger filter. */
+  if (bloom->key_count > bloom->bit_count / BLOOM_MIN_BITS_PER_KEY)
+    {
+      ffd->rep_bloom = bloom_create(bloom_size(bloom->key_count * 2));
+      svn_pool_destroy(bloom->pool);
+
+      return bloom_catch_up(fs, pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Initialize FFD->REP_BLOOM for FS from its filter file and the
+   database.  Use POOL for temporary allocations. */
+static svn_error_t *
+bloom_open(svn_fs_t *fs,
+           apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_int64_t max_rowid = 0;
+  svn_boolean_t rebuilt = FALSE;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_MAX_REP_ROWID));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row && ! svn_sqlite__column_is_null(stmt, 0))
+    max_rowid = svn_sqlite__column_int64(stmt, 0);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* The database may have been removed and recreated since the filter
+     file has been written. */
+  SVN_ERR(bloom_read(&ffd->rep_bloom, fs, pool));
+  if (ffd->rep_bloom && ffd->rep_bloom->max_rowid > max_rowid)
+    {
+      svn_pool_destroy(ffd->rep_bloom->pool);
+      ffd->rep_bloom = NULL;
+    }
+
+  if (! ffd->rep_bloom)
+    {
+      ffd->rep_bloom = bloom_create(bloom_size(max_rowid));
+      rebuilt = TRUE;
+    }
+
+  SVN_ERR(bloom_catch_up(fs, pool));
+
+  if (rebuilt || ffd->rep_bloom->unsaved_count >= BLOOM_SAVE_THRESHOLD)
+    SVN_ERR(bloom_write(ffd->rep_bloom, fs, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Drop the Bloom filter of FS, if it has one. */
+static void
+bloom_drop(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->rep_bloom)
+    {
+      svn_pool_destroy(ffd->rep_bloom->pool);
+      ffd->rep_bloom = NULL;
+    }
+}
+
+/* Add new database rows of FS to its Bloom filter, if it has one.  The
+   filter merely saves database queries, so drop it rather than failing
+   if that does not work.  Use POOL for temporary allocations. */
+static void
+bloom_update(svn_fs_t *fs,
+             apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err;
+
+  if (! ffd->rep_bloom)
+    return;
+
+  err = bloom_catch_up(fs, pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      bloom_drop(fs);
+    }
+}
+
+
+/* Pool cleanup function writing the queued representations of the
+   svn_fs_t * DATA to the database before that gets closed. */
+static apr_status_t
+flush_rep_batch_cleanup(void *data)
+{
+  svn_fs_t *fs = data;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  /* There is nobody to report errors to.  Missing rep-cache entries
+     only reduce rep-sharing, though. */
+  svn_error_clear(svn_fs_fs__flush_rep_references(fs, pool));
+
+  if (ffd->rep_bloom && ffd->rep_bloom->unsaved_count >= BLOOM_SAVE_THRESHOLD)
+    svn_error_clear(bloom_write(ffd->rep_bloom, fs, pool));
+  bloom_drop(fs);
+
+  svn_pool_destroy(pool);
+  svn_pool_destroy(ffd->rep_batch_pool);
+  svn_pool_destroy(ffd->rep_lookup_pool);
+  ffd->rep_batch = NULL;
+  ffd->rep_lookup_cache = NULL;
+
+  return APR_SUCCESS;
+}
 
 static svn_error_t *
 open_rep_cache(void *baton,
@@ -45,14 +403,18 @@ open_rep_cache(void *baton,
   svn_fs_t *fs = baton;
   fs_fs_data_t *ffd = fs->fsap_data;
   const char *db_path;
+  svn_sqlite__tuning_t tuning;
   int version;
 
+  SVN_ERR(svn_sqlite__read_tuning(&tuning, ffd->config,
+                                  CONFIG_SECTION_REP_SHARING));
+
   /* Open (or create) the sqlite database.  It will be automatically
      closed when fs->pool is destoyed. */
   db_path = svn_dirent_join(fs->path, REP_CACHE_DB_NAME, pool);
   SVN_ERR(svn_sqlite__open(&ffd->rep_cache_db, db_path,
                            svn_sqlite__mode_rwcreate, statements,
-                           0, NULL,
+                           0, NULL, &tuning,
                            fs->pool, pool));
 
   SVN_ERR(svn_sqlite__read_schema_version(&version, ffd->rep_cache_db, pool));
@@ -64,6 +426,30 @@ open_rep_cache(void *baton,
                                           STMT_CREATE_SCHEMA));
     }
 
+  /* These pools must outlive the sub-pools of FS->POOL, which get
+     destroyed before the cleanup below is run.  Cleanups, in turn, run
+     in reverse order of registration, i.e. before the database gets
+     closed. */
+  ffd->rep_lookup_pool = svn_pool_create(NULL);
+  ffd->rep_lookup_cache = apr_hash_make(ffd->rep_lookup_pool);
+  ffd->rep_batch_pool = svn_pool_create(NULL);
+  ffd->rep_batch = apr_hash_make(ffd->rep_batch_pool);
+
+  /* The Bloom filter merely saves database queries.  Don't fail over
+     it, e.g. when the filter file cannot be written. */
+  if (ffd->rep_bloom_enabled)
+    {
+      svn_error_t *err = bloom_open(fs, pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          bloom_drop(fs);
+        }
+    }
+
+  apr_pool_cleanup_register(fs->pool, fs, flush_rep_batch_cleanup,
+                            apr_pool_cleanup_null);
+
   return SVN_NO_ERROR;
 }
 
@@ -76,6 +462,107 @@ svn_fs_fs__open_rep_cache(svn_fs_t *fs,
                                                 open_rep_cache, fs, pool));
 }
 
+/* Return a copy of those members of REP that the database stores,
+   allocated in POOL. */
+static representation_t *
+rep_reference_copy(const representation_t *rep,
+                   apr_pool_t *pool)
+{
+  representation_t *copy = apr_pcalloc(pool, sizeof(*copy));
+
+  copy->sha1_checksum = svn_checksum_dup(rep->sha1_checksum, pool);
+  copy->revision = rep->revision;
+  copy->offset = rep->offset;
+  copy->size = rep->size;
+  copy->expanded_size = rep->expanded_size;
+
+  return copy;
+}
+
+/* Remember REP (which may be &missing_rep) as the lookup result for
+   the SHA1 hex digest KEY in the lookup cache of FS. */
+static void
+cache_lookup_result(svn_fs_t *fs,
+                    const char *key,
+                    representation_t *rep)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (apr_hash_count(ffd->rep_lookup_cache) >= REP_LOOKUP_CACHE_SIZE)
+    {
+      svn_pool_clear(ffd->rep_lookup_pool);
+      ffd->rep_lookup_cache = apr_hash_make(ffd->rep_lookup_pool);
+    }
+
+  if (rep != &missing_rep)
+    rep = rep_reference_copy(rep, ffd->rep_lookup_pool);
+
+  apr_hash_set(ffd->rep_lookup_cache,
+               apr_pstrdup(ffd->rep_lookup_pool, key), APR_HASH_KEY_STRING,
+               rep);
+}
+
+/* Set *REP to the representation stored in the database of FS for the
+   SHA1 hex digest KEY, or to NULL if there is none.  Allocate *REP in
+   POOL. */
+static svn_error_t *
+select_rep_reference(representation_t **rep,
+                     svn_fs_t *fs,
+                     const char *key,
+                     apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", key));
+
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    {
+      *rep = apr_pcalloc(pool, sizeof(**rep));
+      SVN_ERR(svn_checksum_parse_hex(&(*rep)->sha1_checksum,
+                                     svn_checksum_sha1, key, pool));
+      (*rep)->revision = svn_sqlite__column_revnum(stmt, 0);
+      (*rep)->offset = svn_sqlite__column_int64(stmt, 1);
+      (*rep)->size = svn_sqlite__column_int64(stmt, 2);
+      (*rep)->expanded_size = svn_sqlite__column_int64(stmt, 3);
+    }
+  else
+    *rep = NULL;
+
+  return svn_sqlite__reset(stmt);
+}
+
+/* Insert REP into the database of FS, unless there is an entry for
+   its SHA1 key already.  Use POOL for temporary allocations. */
+static svn_error_t *
+insert_rep_reference(svn_fs_t *fs,
+                     representation_t *rep,
+                     apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  representation_t *old_rep;
+  const char *key = svn_checksum_to_cstring(rep->sha1_checksum, pool);
+
+  /* Another process may have added the same rep in the meantime. */
+  SVN_ERR(select_rep_reference(&old_rep, fs, key, pool));
+  if (old_rep)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_SET_REP));
+  SVN_ERR(svn_sqlite__bindf(stmt, "siiii",
+                            key,
+                            (apr_int64_t) rep->revision,
+                            (apr_int64_t) rep->offset,
+                            (apr_int64_t) rep->size,
+                            (apr_int64_t) rep->expanded_size));
+
+  return svn_sqlite__insert(NULL, stmt);
+}
+
 svn_error_t *
 svn_fs_fs__get_rep_reference(representation_t **rep,
                              svn_fs_t *fs,
@@ -83,8 +570,8 @@ svn_fs_fs__get_rep_reference(representation_t **rep,
                              apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  svn_sqlite__stmt_t *stmt;
-  svn_boolean_t have_row;
+  const char *key;
+  representation_t *found;
 
   SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
   if (! ffd->rep_cache_db)
@@ -96,24 +583,32 @@ svn_fs_fs__get_rep_reference(representation_t **rep,
                             _("Only SHA1 checksums can be used as keys in the "
                               "rep_cache table.\n"));
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
-  SVN_ERR(svn_sqlite__bindf(stmt, "s",
-                            svn_checksum_to_cstring(checksum, pool)));
+  key = svn_checksum_to_cstring(checksum, pool);
 
-  SVN_ERR(svn_sqlite__step(&have_row, stmt));
-  if (have_row)
+  /* Queued reps take precedence as they are not in the database, yet.
+     Next, try the results of previous lookups.  Keys recorded as
+     missing may have been added by other processes since, but that
+     can only cost us a rep-sharing opportunity. */
+  found = apr_hash_get(ffd->rep_batch, key, APR_HASH_KEY_STRING);
+  if (! found)
+    found = apr_hash_get(ffd->rep_lookup_cache, key, APR_HASH_KEY_STRING);
+
+  /* Skip the database query for keys that are definitely not in it. */
+  if (! found && ffd->rep_bloom
+      && ! bloom_may_contain(ffd->rep_bloom, checksum->digest))
+    found = &missing_rep;
+
+  if (! found)
     {
-      *rep = apr_pcalloc(pool, sizeof(**rep));
-      (*rep)->sha1_checksum = svn_checksum_dup(checksum, pool);
-      (*rep)->revision = svn_sqlite__column_revnum(stmt, 0);
-      (*rep)->offset = svn_sqlite__column_int64(stmt, 1);
-      (*rep)->size = svn_sqlite__column_int64(stmt, 2);
-      (*rep)->expanded_size = svn_sqlite__column_int64(stmt, 3);
+      SVN_ERR(select_rep_reference(&found, fs, key, pool));
+      cache_lookup_result(fs, key, found ? found : &missing_rep);
     }
-  else
-    *rep = NULL;
 
-  return svn_sqlite__reset(stmt);
+  *rep = (found && found != &missing_rep)
+       ? rep_reference_copy(found, pool)
+       : NULL;
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -124,7 +619,6 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   representation_t *old_rep;
-  svn_sqlite__stmt_t *stmt;
 
   SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
   if (! ffd->rep_cache_db)
@@ -165,13 +659,86 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
         return SVN_NO_ERROR;
     }
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_SET_REP));
-  SVN_ERR(svn_sqlite__bindf(stmt, "siiii",
-                            svn_checksum_to_cstring(rep->sha1_checksum, pool),
-                            (apr_int64_t) rep->revision,
-                            (apr_int64_t) rep->offset,
-                            (apr_int64_t) rep->size,
-                            (apr_int64_t) rep->expanded_size));
+  SVN_ERR(insert_rep_reference(fs, rep, pool));
+  cache_lookup_result(fs, svn_checksum_to_cstring(rep->sha1_checksum, pool),
+                      rep);
+  bloom_update(fs, pool);
 
-  return svn_sqlite__insert(NULL, stmt);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__queue_rep_reference(svn_fs_t *fs,
+                               representation_t *rep,
+                               apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  representation_t *old_rep;
+
+  /* Only the first rep for any given contents gets stored. */
+  SVN_ERR(svn_fs_fs__get_rep_reference(&old_rep, fs, rep->sha1_checksum,
+                                       pool));
+  if (old_rep)
+    return SVN_NO_ERROR;
+
+  rep = rep_reference_copy(rep, ffd->rep_batch_pool);
+  apr_hash_set(ffd->rep_batch,
+               svn_checksum_to_cstring(rep->sha1_checksum,
+                                       ffd->rep_batch_pool),
+               APR_HASH_KEY_STRING, rep);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_sqlite__transaction_callback_t.  BATON is the svn_fs_t
+   whose queued reps are to be inserted. */
+static svn_error_t *
+insert_rep_batch(void *baton,
+                 svn_sqlite__db_t *db,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(scratch_pool, ffd->rep_batch);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(insert_rep_reference(fs, svn__apr_hash_index_val(hi),
+                                   iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__flush_rep_references(svn_fs_t *fs,
+                                apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_hash_index_t *hi;
+
+  ffd->rep_batch_revisions = 0;
+  if (! ffd->rep_batch || apr_hash_count(ffd->rep_batch) == 0)
+    return SVN_NO_ERROR;
+
+  /* We use an sqlite transcation to speed things up;
+   * see <http://www.sqlite.org/faq.html#q19>. */
+  SVN_ERR(svn_sqlite__with_transaction(ffd->rep_cache_db, insert_rep_batch,
+                                       fs, pool));
+  bloom_update(fs, pool);
+
+  /* The reps are in the database now and may be found there. */
+  for (hi = apr_hash_first(pool, ffd->rep_batch); hi; hi = apr_hash_next(hi))
+    cache_lookup_result(fs, svn__apr_hash_index_key(hi),
+                        svn__apr_hash_index_val(hi));
+
+  svn_pool_clear(ffd->rep_batch_pool);
+  ffd->rep_batch = apr_hash_make(ffd->rep_batch_pool);
+
+  return SVN_NO_ERROR;
 }
@@ -33,6 +33,7 @@ extern "C" {
 
 
 #define REP_CACHE_DB_NAME        "rep-cache.db"
+#define REP_CACHE_BLOOM_NAME     "rep-cache.bloom"
 
 /* Open and create, if needed, the rep cache database associated with FS.
    Use POOL for temporary allocations. */
@@ -62,6 +63,26 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                              svn_boolean_t reject_dup,
                              apr_pool_t *pool);
 
+/* Queue the representation REP in FS for insertion into the rep cache
+   database with the next svn_fs_fs__flush_rep_references(), unless there
+   is a mapping for REP->SHA1_CHECKSUM already.  Until then, REP will only
+   be found by svn_fs_fs__get_rep_reference() calls for this FS object.
+   Use POOL for temporary allocations.
+
+   The rep cache database must have been opened. */
+svn_error_t *
+svn_fs_fs__queue_rep_reference(svn_fs_t *fs,
+                               representation_t *rep,
+                               apr_pool_t *pool);
+
+/* Insert all representations queued for FS by
+   svn_fs_fs__queue_rep_reference() into the rep cache database, using
+   a single SQLite transaction.  Queued representations will also be
+   flushed when FS gets closed.  Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__flush_rep_references(svn_fs_t *fs,
+                                apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
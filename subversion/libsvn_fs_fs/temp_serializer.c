@@ -0,0 +1,765 @@
+/* temp_serializer.c: serialization functions for caching of FSFS structures
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_pools.h>
+
+#include "svn_pools.h"
+#include "svn_delta.h"
+
+#include "id.h"
+#include "svn_fs.h"
+
+#include "private/svn_temp_serializer.h"
+
+#include "temp_serializer.h"
+
+#include "svn_private_config.h"
+
+/* Utility to serialize the checksum *CS within the serialization
+ * CONTEXT.  CS must be a member of the current structure.
+ */
+static void
+serialize_checksum(svn_temp_serializer__context_t *context,
+                   svn_checksum_t * const *cs)
+{
+  const svn_checksum_t *checksum = *cs;
+  if (checksum == NULL)
+    return;
+
+  svn_temp_serializer__push(context,
+                            (const void * const *)cs,
+                            sizeof(*checksum));
+
+  /* The digest is arbitrary binary data; copy it as a "structure". */
+  svn_temp_serializer__push(context,
+                            (const void * const *)&checksum->digest,
+                            svn_checksum_size(checksum));
+  svn_temp_serializer__pop(context);
+
+  svn_temp_serializer__pop(context);
+}
+
+/* Utility to deserialize the *CS within the serialized structure that
+ * starts at BUFFER.
+ */
+static void
+deserialize_checksum(void *buffer, svn_checksum_t **cs)
+{
+  svn_temp_deserializer__resolve(buffer, (void **)cs);
+  if (*cs == NULL)
+    return;
+
+  svn_temp_deserializer__resolve(*cs, (void **)&(*cs)->digest);
+}
+
+/* Utility to serialize the representation *REPRESENTATION within the
+ * serialization CONTEXT.  REPRESENTATION must be a member of the
+ * current structure.
+ */
+static void
+serialize_representation(svn_temp_serializer__context_t *context,
+                         representation_t * const *representation)
+{
+  const representation_t *rep = *representation;
+  if (rep == NULL)
+    return;
+
+  svn_temp_serializer__push(context,
+                            (const void * const *)representation,
+                            sizeof(*rep));
+
+  serialize_checksum(context, &rep->md5_checksum);
+  serialize_checksum(context, &rep->sha1_checksum);
+  svn_temp_serializer__add_string(context, &rep->txn_id);
+  svn_temp_serializer__add_string(context, &rep->uniquifier);
+
+  svn_temp_serializer__pop(context);
+}
+
+/* Utility to deserialize the *REPRESENTATION within the serialized
+ * structure that starts at BUFFER.
+ */
+static void
+deserialize_representation(void *buffer,
+                           representation_t **representation)
+{
+  representation_t *rep;
+
+  svn_temp_deserializer__resolve(buffer, (void **)representation);
+  rep = *representation;
+  if (rep == NULL)
+    return;
+
+  deserialize_checksum(rep, &rep->md5_checksum);
+  deserialize_checksum(rep, &rep->sha1_checksum);
+  svn_temp_deserializer__resolve(rep, (void **)&rep->txn_id);
+  svn_temp_deserializer__resolve(rep, (void **)&rep->uniquifier);
+}
+
+void
+svn_fs_fs__noderev_serialize(svn_temp_serializer__context_t *context,
+                             node_revision_t * const *noderev_p)
+{
+  const node_revision_t *noderev = *noderev_p;
+  if (noderev == NULL)
+    return;
+
+  /* serialize the noderev struct itself */
+  svn_temp_serializer__push(context,
+                            (const void * const *)noderev_p,
+                            sizeof(*noderev));
+
+  /* serialize sub-structures */
+  svn_fs_fs__id_serialize(context, &noderev->id);
+  svn_fs_fs__id_serialize(context, &noderev->predecessor_id);
+  svn_fs_fs__id_serialize(context, &noderev->predecessor_skip_id);
+  serialize_representation(context, &noderev->prop_rep);
+  serialize_representation(context, &noderev->data_rep);
+
+  svn_temp_serializer__add_string(context, &noderev->copyfrom_path);
+  svn_temp_serializer__add_string(context, &noderev->copyroot_path);
+  svn_temp_serializer__add_string(context, &noderev->created_path);
+
+  /* return to the caller's nesting level */
+  svn_temp_serializer__pop(context);
+}
+
+/* Resolve all pointers within the serialized NODEREV in place.
+ */
+static void
+deserialize_noderev_members(node_revision_t *noderev)
+{
+  svn_fs_fs__id_deserialize(noderev, (svn_fs_id_t **)&noderev->id);
+  svn_fs_fs__id_deserialize(noderev,
+                            (svn_fs_id_t **)&noderev->predecessor_id);
+  svn_fs_fs__id_deserialize(noderev,
+                            (svn_fs_id_t **)&noderev->predecessor_skip_id);
+  deserialize_representation(noderev, &noderev->prop_rep);
+  deserialize_representation(noderev, &noderev->data_rep);
+
+  svn_temp_deserializer__resolve(noderev, (void **)&noderev->copyfrom_path);
+  svn_temp_deserializer__resolve(noderev, (void **)&noderev->copyroot_path);
+  svn_temp_deserializer__resolve(noderev, (void **)&noderev->created_path);
+}
+
+void
+svn_fs_fs__noderev_deserialize(void *buffer,
+                               node_revision_t **noderev_p)
+{
+  svn_temp_deserializer__resolve(buffer, (void **)noderev_p);
+  if (*noderev_p == NULL)
+    return;
+
+  /* fix up the sub-structures */
+  deserialize_noderev_members(*noderev_p);
+}
+
+
+/* Implements svn_cache__serialize_func_t */
+svn_error_t *
+svn_fs_fs__serialize_id(char **data,
+                        apr_size_t *data_len,
+                        void *in,
+                        apr_pool_t *pool)
+{
+  const svn_fs_id_t *id = in;
+  svn_stringbuf_t *serialized;
+
+  /* create an (empty) serialization context with plenty of buffer space */
+  svn_temp_serializer__context_t *context =
+      svn_temp_serializer__init(NULL, 0, 250, pool);
+
+  /* serialize the id; it becomes the root of the buffer */
+  svn_fs_fs__id_serialize(context, &id);
+
+  /* return serialized data */
+  serialized = svn_temp_serializer__get(context);
+  *data = serialized->data;
+  *data_len = serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t */
+svn_error_t *
+svn_fs_fs__deserialize_id(void **out,
+                          char *data,
+                          apr_size_t data_len,
+                          apr_pool_t *pool)
+{
+  /* The ID is the root of DATA; its sub-structures follow it. */
+  svn_fs_id_t *id = (svn_fs_id_t *)data;
+
+  /* fixup of all pointers etc. */
+  svn_fs_fs__id_deserialize(id, &id);
+
+  /* done */
+  *out = id;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__serialize_func_t */
+svn_error_t *
+svn_fs_fs__serialize_node_revision(char **buffer,
+                                   apr_size_t *buffer_size,
+                                   void *item,
+                                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *serialized;
+  node_revision_t *noderev = item;
+
+  /* create an (empty) serialization context with plenty of buffer space */
+  svn_temp_serializer__context_t *context =
+      svn_temp_serializer__init(NULL, 0, 503, pool);
+
+  /* serialize the noderev; it becomes the root of the buffer */
+  svn_fs_fs__noderev_serialize(context, &noderev);
+
+  /* return serialized data */
+  serialized = svn_temp_serializer__get(context);
+  *buffer = serialized->data;
+  *buffer_size = serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t */
+svn_error_t *
+svn_fs_fs__deserialize_node_revision(void **item,
+                                     char *buffer,
+                                     apr_size_t buffer_size,
+                                     apr_pool_t *pool)
+{
+  /* The noderev is the root of BUFFER; its sub-structures follow it. */
+  node_revision_t *noderev = (node_revision_t *)buffer;
+
+  /* fixup of all pointers etc. */
+  deserialize_noderev_members(noderev);
+
+  /* done */
+  *item = noderev;
+  return SVN_NO_ERROR;
+}
+
+/* Utility to serialize the string *STR within the serialization CONTEXT.
+ * Unlike svn_temp_serializer__add_string, this handles arbitrary binary
+ * data.  STR must be a member of the current structure.
+ */
+static void
+serialize_svn_string(svn_temp_serializer__context_t *context,
+                     const svn_string_t * const *str)
+{
+  const svn_string_t *string = *str;
+
+  /* Nothing to do for NULL string references. */
+  if (string == NULL)
+    return;
+
+  svn_temp_serializer__push(context,
+                            (const void * const *)str,
+                            sizeof(*string));
+
+  /* The string data may contain NULs; copy it as a "structure" including
+   * a terminating 0 for convenience. */
+  svn_temp_serializer__push(context,
+                            (const void * const *)&string->data,
+                            string->len + 1);
+  svn_temp_serializer__pop(context);
+
+  svn_temp_serializer__pop(context);
+}
+
+/* Utility to deserialize the *STR within the serialized structure that
+ * starts at BUFFER.
+ */
+static void
+deserialize_svn_string(void *buffer, svn_string_t **str)
+{
+  svn_temp_deserializer__resolve(buffer, (void **)str);
+  if (*str == NULL)
+    return;
+
+  svn_temp_deserializer__resolve(*str, (void **)&(*str)->data);
+}
+
+/* Implements svn_cache__serialize_func_t */
+svn_error_t *
+svn_fs_fs__serialize_txdelta_window(char **buffer,
+                                    apr_size_t *buffer_size,
+                                    void *item,
+                                    apr_pool_t *pool)
+{
+  svn_fs_fs__txdelta_cached_window_t *window_info = item;
+  svn_txdelta_window_t *window = window_info->window;
+  svn_temp_serializer__context_t *context;
+  svn_stringbuf_t *serialized;
+
+  /* The window's ops and data make up almost all of the size. */
+  apr_size_t text_len = window->new_data ? window->new_data->len : 0;
+  context = svn_temp_serializer__init(window_info,
+                                      sizeof(*window_info),
+                                      500 + text_len
+                                      + window->num_ops
+                                        * sizeof(*window->ops),
+                                      pool);
+
+  /* the window and its sub-structures */
+  svn_temp_serializer__push(context,
+                            (const void * const *)&window_info->window,
+                            sizeof(*window));
+
+  svn_temp_serializer__push(context,
+                            (const void * const *)&window->ops,
+                            window->num_ops * sizeof(*window->ops));
+  svn_temp_serializer__pop(context);
+
+  serialize_svn_string(context, &window->new_data);
+
+  svn_temp_serializer__pop(context);
+
+  /* return the serialized result */
+  serialized = svn_temp_serializer__get(context);
+  *buffer = serialized->data;
+  *buffer_size = serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t */
+svn_error_t *
+svn_fs_fs__deserialize_txdelta_window(void **item,
+                                      char *buffer,
+                                      apr_size_t buffer_size,
+                                      apr_pool_t *pool)
+{
+  svn_txdelta_window_t *window;
+
+  /* BUFFER is ours and starts with the cached window wrapper. */
+  svn_fs_fs__txdelta_cached_window_t *window_info =
+      (svn_fs_fs__txdelta_cached_window_t *)buffer;
+
+  svn_temp_deserializer__resolve(window_info,
+                                 (void **)&window_info->window);
+  window = window_info->window;
+
+  svn_temp_deserializer__resolve(window, (void **)&window->ops);
+  deserialize_svn_string(window, (svn_string_t **)&window->new_data);
+
+  /* done */
+  *item = window_info;
+  return SVN_NO_ERROR;
+}
+
+
+/* Serialized directory contents: the number of entries and an array of
+ * dirent pointers, sorted by entry name.  The latter allows for binary
+ * search when accessing the serialized data in-place.
+ */
+typedef struct hash_data_t
+{
+  /* number of entries in the directory */
+  apr_size_t count;
+
+  /* COUNT dirents, sorted by name */
+  svn_fs_dirent_t **entries;
+} hash_data_t;
+
+/* qsort-compatible comparison of two svn_fs_dirent_t * by name. */
+static int
+compare_dirent_id_names(const void *lhs, const void *rhs)
+{
+  return strcmp((*(const svn_fs_dirent_t * const *)lhs)->name,
+                (*(const svn_fs_dirent_t * const *)rhs)->name);
+}
+
+/* Implements svn_cache__serialize_func_t */
+svn_error_t *
+svn_fs_fs__serialize_dir_entries(char **data,
+                                 apr_size_t *data_len,
+                                 void *in,
+                                 apr_pool_t *pool)
+{
+  apr_hash_t *entries = in;
+  hash_data_t hash_data;
+  apr_hash_index_t *hi;
+  apr_size_t i = 0;
+  svn_temp_serializer__context_t *context;
+  svn_stringbuf_t *serialized;
+
+  /* calculate sizes */
+  apr_size_t count = apr_hash_count(entries);
+  apr_size_t entries_len = count * sizeof(svn_fs_dirent_t *);
+
+  /* copy the hash entries to an auxiliary struct of known layout */
+  hash_data.count = count;
+  hash_data.entries = apr_palloc(pool, entries_len);
+
+  for (hi = apr_hash_first(pool, entries); hi; hi = apr_hash_next(hi), ++i)
+    hash_data.entries[i] = svn__apr_hash_index_val(hi);
+
+  /* sort entry index by name */
+  qsort(hash_data.entries, count, sizeof(*hash_data.entries),
+        compare_dirent_id_names);
+
+  /* estimate the size of the serialized data; names and ids take
+   * roughly 100 bytes per entry */
+  context = svn_temp_serializer__init(&hash_data,
+                                      sizeof(hash_data),
+                                      50 + count * 200 + entries_len,
+                                      pool);
+
+  /* serialize entry references */
+  svn_temp_serializer__push(context,
+                            (const void * const *)&hash_data.entries,
+                            entries_len);
+
+  /* serialize the individual entries and their sub-structures */
+  for (i = 0; i < count; ++i)
+    {
+      const svn_fs_dirent_t *entry = hash_data.entries[i];
+
+      svn_temp_serializer__push(context,
+                                (const void * const *)&hash_data.entries[i],
+                                sizeof(*entry));
+      svn_fs_fs__id_serialize(context, &entry->id);
+      svn_temp_serializer__add_string(context, &entry->name);
+      svn_temp_serializer__pop(context);
+    }
+
+  svn_temp_serializer__pop(context);
+
+  /* return the serialized result */
+  serialized = svn_temp_serializer__get(context);
+  *data = serialized->data;
+  *data_len = serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t */
+svn_error_t *
+svn_fs_fs__deserialize_dir_entries(void **out,
+                                   char *data,
+                                   apr_size_t data_len,
+                                   apr_pool_t *pool)
+{
+  /* DATA is ours, so the entries can be fixed up in place. */
+  hash_data_t *hash_data = (hash_data_t *)data;
+  apr_hash_t *result = apr_hash_make(pool);
+  apr_size_t i;
+
+  /* resolve the reference to the entries array */
+  svn_temp_deserializer__resolve(hash_data, (void **)&hash_data->entries);
+
+  /* fix up the entries in place and add them to the result hash */
+  for (i = 0; i < hash_data->count; ++i)
+    {
+      svn_fs_dirent_t *entry;
+
+      svn_temp_deserializer__resolve(hash_data->entries,
+                                     (void **)&hash_data->entries[i]);
+      entry = hash_data->entries[i];
+
+      svn_temp_deserializer__resolve(entry, (void **)&entry->name);
+      svn_fs_fs__id_deserialize(entry, (svn_fs_id_t **)&entry->id);
+
+      apr_hash_set(result, entry->name, APR_HASH_KEY_STRING, entry);
+    }
+
+  /* done */
+  *out = result;
+  return SVN_NO_ERROR;
+}
+
+/* Return the index of the first entry in the sorted array ENTRIES of
+ * COUNT serialized dirents whose name is not smaller than NAME.  Set
+ * *FOUND to TRUE, if that entry's name matches NAME exactly.  ENTRIES
+ * has not been deserialized, i.e. all pointers are still offsets.
+ */
+static apr_size_t
+find_entry(svn_fs_dirent_t **entries,
+           const char *name,
+           apr_size_t count,
+           svn_boolean_t *found)
+{
+  /* binary search for the desired entry by name */
+  apr_size_t lower = 0;
+  apr_size_t upper = count;
+  apr_size_t middle;
+
+  for (middle = upper / 2; lower < upper; middle = (upper + lower) / 2)
+    {
+      const svn_fs_dirent_t *entry =
+          svn_temp_deserializer__ptr(entries,
+                                     (const void * const *)&entries[middle]);
+      const char *entry_name =
+          svn_temp_deserializer__ptr(entry,
+                                     (const void * const *)&entry->name);
+
+      int diff = strcmp(entry_name, name);
+      if (diff < 0)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+
+  /* check whether we actually found a match */
+  *found = FALSE;
+  if (lower < count)
+    {
+      const svn_fs_dirent_t *entry =
+          svn_temp_deserializer__ptr(entries,
+                                     (const void * const *)&entries[lower]);
+      const char *entry_name =
+          svn_temp_deserializer__ptr(entry,
+                                     (const void * const *)&entry->name);
+
+      if (strcmp(entry_name, name) == 0)
+        *found = TRUE;
+    }
+
+  return lower;
+}
+
+/* Implements svn_cache__partial_getter_func_t */
+svn_error_t *
+svn_fs_fs__extract_dir_entry(void **out,
+                             const char *data,
+                             apr_size_t data_len,
+                             void *baton,
+                             apr_pool_t *pool)
+{
+  const hash_data_t *hash_data = (const hash_data_t *)data;
+  const char *name = baton;
+  svn_boolean_t found;
+
+  /* resolve the reference to the entries array */
+  svn_fs_dirent_t **entries = (svn_fs_dirent_t **)
+      svn_temp_deserializer__ptr(hash_data,
+                                 (const void * const *)&hash_data->entries);
+
+  /* binary search for the desired entry by name */
+  apr_size_t pos = find_entry(entries, name, hash_data->count, &found);
+
+  /* de-serialize that entry or return NULL, if no match has been found */
+  *out = NULL;
+  if (found)
+    {
+      const svn_fs_dirent_t *source =
+          svn_temp_deserializer__ptr(entries,
+                                     (const void * const *)&entries[pos]);
+
+      /* Entries have been serialized one-by-one, each one followed by
+       * its sub-structures.  Thus, the next entry (or the end of DATA)
+       * marks the end of the current one's data. */
+      const char *end = pos + 1 < hash_data->count
+                      ? svn_temp_deserializer__ptr(entries,
+                           (const void * const *)&entries[pos + 1])
+                      : data + data_len;
+      apr_size_t size = end - (const char *)source;
+
+      /* copy & deserialize the entry */
+      svn_fs_dirent_t *new_entry = apr_palloc(pool, size);
+      memcpy(new_entry, source, size);
+
+      svn_temp_deserializer__resolve(new_entry, (void **)&new_entry->name);
+      svn_fs_fs__id_deserialize(new_entry, (svn_fs_id_t **)&new_entry->id);
+      *(svn_fs_dirent_t **)out = new_entry;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__partial_getter_func_t */
+svn_error_t *
+svn_fs_fs__extract_dir_entries_sorted(void **out,
+                                      const char *data,
+                                      apr_size_t data_len,
+                                      void *baton,
+                                      apr_pool_t *pool)
+{
+  /* DATA belongs to the cache, so fix up a copy of it. */
+  hash_data_t *hash_data = apr_palloc(pool, data_len);
+  apr_array_header_t *result;
+  apr_size_t i;
+
+  memcpy(hash_data, data, data_len);
+  svn_temp_deserializer__resolve(hash_data, (void **)&hash_data->entries);
+
+  /* the entries have been serialized in name order already */
+  result = apr_array_make(pool, (int)hash_data->count,
+                          sizeof(svn_fs_dirent_t *));
+  for (i = 0; i < hash_data->count; ++i)
+    {
+      svn_fs_dirent_t *entry;
+
+      svn_temp_deserializer__resolve(hash_data->entries,
+                                     (void **)&hash_data->entries[i]);
+      entry = hash_data->entries[i];
+
+      svn_temp_deserializer__resolve(entry, (void **)&entry->name);
+      svn_fs_fs__id_deserialize(entry, (svn_fs_id_t **)&entry->id);
+
+      APR_ARRAY_PUSH(result, svn_fs_dirent_t *) = entry;
+    }
+
+  /* done */
+  *out = result;
+  return SVN_NO_ERROR;
+}
+
+/* Serialized revision property list: the stamp of
+ * svn_fs_fs__cached_revprops_t followed by the number of properties and
+ * two parallel arrays of their names and values.
+ */
+typedef struct revprops_data_t
+{
+  /* copied from svn_fs_fs__cached_revprops_t */
+  apr_ino_t inode;
+  apr_dev_t device;
+  apr_off_t size;
+  apr_time_t mtime;
+  svn_atomic_t generation;
+
+  /* number of properties */
+  apr_size_t count;
+
+  /* COUNT property names and values */
+  const char **names;
+  svn_string_t **values;
+} revprops_data_t;
+
+/* Implements svn_cache__serialize_func_t */
+svn_error_t *
+svn_fs_fs__serialize_revprops(char **data,
+                              apr_size_t *data_len,
+                              void *in,
+                              apr_pool_t *pool)
+{
+  svn_fs_fs__cached_revprops_t *revprops = in;
+  revprops_data_t revprops_data;
+  apr_hash_index_t *hi;
+  apr_size_t i = 0;
+  svn_temp_serializer__context_t *context;
+  svn_stringbuf_t *serialized;
+
+  /* calculate sizes */
+  apr_size_t count = apr_hash_count(revprops->proplist);
+  apr_size_t names_len = count * sizeof(const char *);
+  apr_size_t values_len = count * sizeof(svn_string_t *);
+
+  /* copy the hash entries to an auxiliary struct of known layout */
+  revprops_data.inode = revprops->inode;
+  revprops_data.device = revprops->device;
+  revprops_data.size = revprops->size;
+  revprops_data.mtime = revprops->mtime;
+  revprops_data.generation = revprops->generation;
+  revprops_data.count = count;
+  revprops_data.names = apr_palloc(pool, names_len);
+  revprops_data.values = apr_palloc(pool, values_len);
+
+  for (hi = apr_hash_first(pool, revprops->proplist);
+       hi;
+       hi = apr_hash_next(hi), ++i)
+    {
+      revprops_data.names[i] = svn__apr_hash_index_key(hi);
+      revprops_data.values[i] = svn__apr_hash_index_val(hi);
+    }
+
+  /* log messages make up for most of the size; estimate the rest */
+  context = svn_temp_serializer__init(&revprops_data,
+                                      sizeof(revprops_data),
+                                      (size_t)revprops->size + 100
+                                      + count * 50,
+                                      pool);
+
+  /* serialize the names */
+  svn_temp_serializer__push(context,
+                            (const void * const *)&revprops_data.names,
+                            names_len);
+  for (i = 0; i < count; ++i)
+    svn_temp_serializer__add_string(context, &revprops_data.names[i]);
+  svn_temp_serializer__pop(context);
+
+  /* serialize the values */
+  svn_temp_serializer__push(context,
+                            (const void * const *)&revprops_data.values,
+                            values_len);
+  for (i = 0; i < count; ++i)
+    serialize_svn_string(context,
+                         (const svn_string_t * const *)
+                           &revprops_data.values[i]);
+  svn_temp_serializer__pop(context);
+
+  /* return the serialized result */
+  serialized = svn_temp_serializer__get(context);
+  *data = serialized->data;
+  *data_len = serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t */
+svn_error_t *
+svn_fs_fs__deserialize_revprops(void **out,
+                                char *data,
+                                apr_size_t data_len,
+                                apr_pool_t *pool)
+{
+  /* DATA is ours, so the names and values can be fixed up in place. */
+  revprops_data_t *revprops_data = (revprops_data_t *)data;
+  svn_fs_fs__cached_revprops_t *revprops = apr_palloc(pool,
+                                                      sizeof(*revprops));
+  apr_size_t i;
+
+  revprops->inode = revprops_data->inode;
+  revprops->device = revprops_data->device;
+  revprops->size = revprops_data->size;
+  revprops->mtime = revprops_data->mtime;
+  revprops->generation = revprops_data->generation;
+  revprops->proplist = apr_hash_make(pool);
+
+  /* resolve the references to the arrays */
+  svn_temp_deserializer__resolve(revprops_data,
+                                 (void **)&revprops_data->names);
+  svn_temp_deserializer__resolve(revprops_data,
+                                 (void **)&revprops_data->values);
+
+  /* fix up the properties in place and add them to the result hash */
+  for (i = 0; i < revprops_data->count; ++i)
+    {
+      svn_temp_deserializer__resolve(revprops_data->names,
+                                     (void **)&revprops_data->names[i]);
+      deserialize_svn_string(revprops_data->values,
+                             &revprops_data->values[i]);
+
+      apr_hash_set(revprops->proplist, revprops_data->names[i],
+                   APR_HASH_KEY_STRING, revprops_data->values[i]);
+    }
+
+  /* done */
+  *out = revprops;
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,186 @@
+/* temp_serializer.h : serialization functions for caching of FSFS structures
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS__TEMP_SERIALIZER_H
+#define SVN_LIBSVN_FS__TEMP_SERIALIZER_H
+
+#include "svn_delta.h"
+#include "fs.h"
+#include "private/svn_temp_serializer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* The functions below serialize FSFS structures into the flat,
+   relocatable format of the svn_temp_serializer__* API.  Values
+   read back from a cache need no parsing and no per-member allocation;
+   their pointers simply get resolved in place. */
+
+/* Append the serialized representation of *NODEREV_P to the
+   serialization CONTEXT.  NODEREV_P must be a member of the current
+   structure in CONTEXT. */
+void
+svn_fs_fs__noderev_serialize(svn_temp_serializer__context_t *context,
+                             node_revision_t * const *noderev_p);
+
+/* Deserialize the *NODEREV_P inside the serialized structure that
+   starts at BUFFER, i.e. resolve all its pointers in place. */
+void
+svn_fs_fs__noderev_deserialize(void *buffer,
+                               node_revision_t **noderev_p);
+
+/* Implements svn_cache__serialize_func_t for node_revision_t */
+svn_error_t *
+svn_fs_fs__serialize_node_revision(char **buffer,
+                                   apr_size_t *buffer_size,
+                                   void *item,
+                                   apr_pool_t *pool);
+
+/* Implements svn_cache__deserialize_func_t for node_revision_t */
+svn_error_t *
+svn_fs_fs__deserialize_node_revision(void **item,
+                                     char *buffer,
+                                     apr_size_t buffer_size,
+                                     apr_pool_t *pool);
+
+/* A decoded txdelta window as it gets cached, together with the
+   position just behind it within its representation. */
+typedef struct svn_fs_fs__txdelta_cached_window_t
+{
+  /* the txdelta window itself */
+  svn_txdelta_window_t *window;
+
+  /* file offset right after the window's data */
+  apr_off_t end_offset;
+} svn_fs_fs__txdelta_cached_window_t;
+
+/* Implements svn_cache__serialize_func_t for
+   svn_fs_fs__txdelta_cached_window_t */
+svn_error_t *
+svn_fs_fs__serialize_txdelta_window(char **buffer,
+                                    apr_size_t *buffer_size,
+                                    void *item,
+                                    apr_pool_t *pool);
+
+/* Implements svn_cache__deserialize_func_t for
+   svn_fs_fs__txdelta_cached_window_t */
+svn_error_t *
+svn_fs_fs__deserialize_txdelta_window(void **item,
+                                      char *buffer,
+                                      apr_size_t buffer_size,
+                                      apr_pool_t *pool);
+
+/* Implements svn_cache__serialize_func_t for svn_fs_id_t */
+svn_error_t *
+svn_fs_fs__serialize_id(char **data,
+                        apr_size_t *data_len,
+                        void *in,
+                        apr_pool_t *pool);
+
+/* Implements svn_cache__deserialize_func_t for svn_fs_id_t */
+svn_error_t *
+svn_fs_fs__deserialize_id(void **out,
+                          char *data,
+                          apr_size_t data_len,
+                          apr_pool_t *pool);
+
+/* Implements svn_cache__serialize_func_t for a directory contents hash,
+   i.e. an apr_hash_t mapping entry names to svn_fs_dirent_t.  The
+   entries get stored sorted by name. */
+svn_error_t *
+svn_fs_fs__serialize_dir_entries(char **data,
+                                 apr_size_t *data_len,
+                                 void *in,
+                                 apr_pool_t *pool);
+
+/* Implements svn_cache__deserialize_func_t for a directory contents
+   hash serialized by svn_fs_fs__serialize_dir_entries. */
+svn_error_t *
+svn_fs_fs__deserialize_dir_entries(void **out,
+                                   char *data,
+                                   apr_size_t data_len,
+                                   apr_pool_t *pool);
+
+/* Implements svn_cache__partial_getter_func_t for a single
+   svn_fs_dirent_t within a directory contents hash serialized by
+   svn_fs_fs__serialize_dir_entries.  BATON is the entry name (a
+   const char *).  *OUT will be set to a copy of the entry allocated
+   in POOL or to NULL if there is no such entry. */
+svn_error_t *
+svn_fs_fs__extract_dir_entry(void **out,
+                             const char *data,
+                             apr_size_t data_len,
+                             void *baton,
+                             apr_pool_t *pool);
+
+/* Implements svn_cache__partial_getter_func_t for all entries of a
+   directory contents hash serialized by
+   svn_fs_fs__serialize_dir_entries.  *OUT will be set to an array of
+   svn_fs_dirent_t * sorted by entry name, allocated in POOL.  BATON is
+   unused. */
+svn_error_t *
+svn_fs_fs__extract_dir_entries_sorted(void **out,
+                                      const char *data,
+                                      apr_size_t data_len,
+                                      void *baton,
+                                      apr_pool_t *pool);
+
+/* A revision property list as it gets cached, together with the stamp
+   of the file it has been read from and the revprop generation of the
+   process at that time. */
+typedef struct svn_fs_fs__cached_revprops_t
+{
+  /* the revision properties, mapping names to svn_string_t * */
+  apr_hash_t *proplist;
+
+  /* inode, device, size and mtime of the revprop file or database */
+  apr_ino_t inode;
+  apr_dev_t device;
+  apr_off_t size;
+  apr_time_t mtime;
+
+  /* fs_fs_shared_data_t.revprop_generation before the file was read */
+  svn_atomic_t generation;
+} svn_fs_fs__cached_revprops_t;
+
+/* Implements svn_cache__serialize_func_t for
+   svn_fs_fs__cached_revprops_t */
+svn_error_t *
+svn_fs_fs__serialize_revprops(char **data,
+                              apr_size_t *data_len,
+                              void *in,
+                              apr_pool_t *pool);
+
+/* Implements svn_cache__deserialize_func_t for
+   svn_fs_fs__cached_revprops_t */
+svn_error_t *
+svn_fs_fs__deserialize_revprops(void **out,
+                                char *data,
+                                apr_size_t data_len,
+                                apr_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS__TEMP_SERIALIZER_H */
@@ -52,12 +52,13 @@
 
 #include "fs.h"
 #include "err.h"
-#include "key-gen.h"
 #include "dag.h"
 #include "lock.h"
 #include "tree.h"
 #include "fs_fs.h"
 #include "id.h"
+#include "mergeinfo-index.h"
+#include "node-origins.h"
 
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_fs_util.h"
@@ -454,7 +455,7 @@ get_copy_inheritance(copy_id_inherit_t *inherit_p,
                      apr_pool_t *pool)
 {
   const svn_fs_id_t *child_id, *parent_id, *copyroot_id;
-  const char *child_copy_id, *parent_copy_id;
+  const svn_fs_fs__id_part_t *child_copy_id, *parent_copy_id;
   const char *id_path = NULL;
   svn_fs_root_t *copyroot_root;
   dag_node_t *copyroot_node;
@@ -466,11 +467,11 @@ get_copy_inheritance(copy_id_inherit_t *inherit_p,
   /* Initialize some convenience variables. */
   child_id = svn_fs_fs__dag_get_id(child->node);
   parent_id = svn_fs_fs__dag_get_id(child->parent->node);
-  child_copy_id = svn_fs_fs__id_copy_id(child_id);
-  parent_copy_id = svn_fs_fs__id_copy_id(parent_id);
+  child_copy_id = svn_fs_fs__id_copy_part(child_id);
+  parent_copy_id = svn_fs_fs__id_copy_part(parent_id);
 
   /* If this child is already mutable, we have nothing to do. */
-  if (svn_fs_fs__id_txn_id(child_id))
+  if (svn_fs_fs__id_is_txn(child_id))
     {
       *inherit_p = copy_id_inherit_self;
       *copy_src_path = NULL;
@@ -484,14 +485,16 @@ get_copy_inheritance(copy_id_inherit_t *inherit_p,
 
   /* Special case: if the child's copy ID is '0', use the parent's
      copy ID. */
-  if (strcmp(child_copy_id, "0") == 0)
+  if (child_copy_id->number == 0
+      && ! SVN_IS_VALID_REVNUM(child_copy_id->revision)
+      && ! child_copy_id->txn_local)
     return SVN_NO_ERROR;
 
   /* Compare the copy IDs of the child and its parent.  If they are
      the same, then the child is already on the same branch as the
      parent, and should use the same mutability copy ID that the
      parent will use. */
-  if (svn_fs_fs__key_compare(child_copy_id, parent_copy_id) == 0)
+  if (svn_fs_fs__id_part_eq(child_copy_id, parent_copy_id))
     return SVN_NO_ERROR;
 
   /* If the child is on the same branch that the parent is on, the
@@ -743,7 +746,7 @@ make_path_mutable(svn_fs_root_t *root,
         {
         case copy_id_inherit_parent:
           parent_id = svn_fs_fs__dag_get_id(parent_path->parent->node);
-          copy_id = svn_fs_fs__id_copy_id(parent_id);
+          copy_id = svn_fs_fs__id_copy_id(parent_id, pool);
           break;
 
         case copy_id_inherit_new:
@@ -770,8 +773,8 @@ make_path_mutable(svn_fs_root_t *root,
 
       child_id = svn_fs_fs__dag_get_id(parent_path->node);
       copyroot_id = svn_fs_fs__dag_get_id(copyroot_node);
-      if (strcmp(svn_fs_fs__id_node_id(child_id),
-                 svn_fs_fs__id_node_id(copyroot_id)) != 0)
+      if (! svn_fs_fs__id_part_eq(svn_fs_fs__id_node_part(child_id),
+                                  svn_fs_fs__id_node_part(copyroot_id)))
         is_parent_copyroot = TRUE;
 
       /* Now make this node mutable.  */
@@ -801,6 +804,84 @@ make_path_mutable(svn_fs_root_t *root,
 }
 
 
+/* Set *NODE_P to the node identified by the canonical PATH in the
+   revision root ROOT, allocated in POOL, like open_path() with neither
+   flags nor TXN_ID would, but without building the parent path.
+
+   All nodes of a revision are immutable and get cached under their
+   path regardless of which root they were looked up in, so rather than
+   walking down from the root directory, start at the deepest ancestor
+   of PATH that is in the DAG node cache.  The caller has already
+   checked the cache for PATH itself. */
+static svn_error_t *
+open_rev_path_node(dag_node_t **node_p,
+                   svn_fs_root_t *root,
+                   const char *path,
+                   apr_pool_t *pool)
+{
+  dag_node_t *here = NULL;
+  const char *path_so_far;
+  const char *rest;
+  apr_size_t len = strlen(path);
+
+  /* Find the deepest cached ancestor, falling back to the root. */
+  while (! here)
+    {
+      while (len > 0 && path[len] != '/')
+        len--;
+
+      if (len == 0)
+        {
+          path_so_far = "/";
+          SVN_ERR(root_node(&here, root, pool));
+        }
+      else
+        {
+          path_so_far = apr_pstrmemdup(pool, path, len);
+          SVN_ERR(dag_node_cache_get(&here, root, path_so_far, pool));
+          if (! here)
+            len--;
+        }
+    }
+
+  /* Open the remaining components, caching each node we find. */
+  rest = path + len + 1;
+  while (*rest)
+    {
+      const char *next;
+      char *entry;
+      dag_node_t *child;
+      svn_error_t *err;
+
+      /* We'd better be in a directory. */
+      if (svn_fs_fs__dag_node_kind(here) != svn_node_dir)
+        SVN_ERR_W(SVN_FS__ERR_NOT_DIRECTORY(root->fs, path_so_far),
+                  apr_psprintf(pool, _("Failure opening '%s'"), path));
+
+      entry = svn_fs__next_entry_name(&next, rest, pool);
+      path_so_far = svn_uri_join(path_so_far, entry, pool);
+
+      err = svn_fs_fs__dag_open(&child, here, entry, pool);
+      if (err && err->apr_err == SVN_ERR_FS_NOT_FOUND)
+        {
+          svn_error_clear(err);
+          return SVN_FS__NOT_FOUND(root, path);
+        }
+      SVN_ERR(err);
+
+      SVN_ERR(dag_node_cache_set(root, path_so_far, child, pool));
+
+      here = child;
+      if (! next)
+        break;
+      rest = next;
+    }
+
+  *node_p = here;
+  return SVN_NO_ERROR;
+}
+
+
 /* Open the node identified by PATH in ROOT.  Set DAG_NODE_P to the
  *node we find, allocated in POOL.  Return the error
  *SVN_ERR_FS_NOT_FOUND if this node doesn't exist. */
@@ -818,7 +899,12 @@ get_dag(dag_node_t **dag_node_p,
 
   /* First we look for the DAG in our cache. */
   SVN_ERR(dag_node_cache_get(&node, root, path, pool));
-  if (! node)
+  if (! node && ! root->is_txn_root)
+    {
+      /* Revision roots don't need the parent path. */
+      SVN_ERR(open_rev_path_node(&node, root, path, pool));
+    }
+  else if (! node)
     {
       /* Call open_path with no flags, as we want this to return an error
          if the node for which we are searching doesn't exist. */
@@ -971,6 +1057,119 @@ svn_fs_fs__check_path(svn_node_kind_t *kind_p,
   return svn_error_return(err);
 }
 
+/* An element of the directory stack walked by fs_check_paths. */
+typedef struct check_paths_dir_t
+{
+  /* canonical path of NODE */
+  const char *path;
+
+  /* the node opened for PATH */
+  dag_node_t *node;
+} check_paths_dir_t;
+
+/* Implements root_vtable_t.check_paths.  Because PATHS are sorted such
+   that every directory is directly followed by its contents, keep the
+   chain of directories opened for the previous path on a stack and
+   open only the components below the deepest one that is shared. */
+static svn_error_t *
+fs_check_paths(svn_node_kind_t *kinds,
+               const svn_fs_id_t **ids,
+               svn_fs_root_t *root,
+               const apr_array_header_t *paths,
+               apr_pool_t *pool)
+{
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  apr_array_header_t *stack = apr_array_make(scratch_pool, 16,
+                                             sizeof(check_paths_dir_t));
+  check_paths_dir_t *top;
+  int i;
+
+  top = apr_array_push(stack);
+  top->path = "/";
+  SVN_ERR(root_node(&top->node, root, scratch_pool));
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      dag_node_t *here;
+      const char *path_so_far;
+      const char *rest;
+
+      /* Go up to the deepest directory shared with the previous path.
+         The root directory is shared by all of them. */
+      top = &APR_ARRAY_IDX(stack, stack->nelts - 1, check_paths_dir_t);
+      while (! svn_uri_is_ancestor(top->path, path))
+        {
+          apr_array_pop(stack);
+          top = &APR_ARRAY_IDX(stack, stack->nelts - 1, check_paths_dir_t);
+        }
+
+      here = top->node;
+      path_so_far = top->path;
+      rest = path + strlen(path_so_far);
+      if (*rest == '/')
+        rest++;
+
+      /* Open the remaining components, pushing each onto the stack. */
+      while (here && *rest)
+        {
+          const char *next;
+          char *entry;
+          dag_node_t *child;
+
+          if (svn_fs_fs__dag_node_kind(here) != svn_node_dir)
+            {
+              here = NULL;
+              break;
+            }
+
+          entry = svn_fs__next_entry_name(&next, rest, scratch_pool);
+          path_so_far = svn_uri_join(path_so_far, entry, scratch_pool);
+
+          SVN_ERR(dag_node_cache_get(&child, root, path_so_far,
+                                     scratch_pool));
+          if (! child)
+            {
+              svn_error_t *err = svn_fs_fs__dag_open(&child, here, entry,
+                                                     scratch_pool);
+              if (err && err->apr_err == SVN_ERR_FS_NOT_FOUND)
+                {
+                  svn_error_clear(err);
+                  here = NULL;
+                  break;
+                }
+              SVN_ERR(err);
+
+              SVN_ERR(dag_node_cache_set(root, path_so_far, child,
+                                         scratch_pool));
+            }
+
+          top = apr_array_push(stack);
+          top->path = path_so_far;
+          top->node = child;
+
+          here = child;
+          rest = next ? next : "";
+        }
+
+      if (here)
+        {
+          kinds[i] = svn_fs_fs__dag_node_kind(here);
+          if (ids)
+            ids[i] = svn_fs_fs__id_copy(svn_fs_fs__dag_get_id(here), pool);
+        }
+      else
+        {
+          kinds[i] = svn_node_none;
+          if (ids)
+            ids[i] = NULL;
+        }
+    }
+
+  svn_pool_destroy(scratch_pool);
+  return SVN_NO_ERROR;
+}
+
 /* Set *VALUE_P to the value of the property named PROPNAME of PATH in
    ROOT.  If the node has no property by that name, set *VALUE_P to
    zero.  Allocate the result in POOL. */
@@ -1152,7 +1351,7 @@ update_ancestry(svn_fs_t *fs,
 {
   node_revision_t *noderev;
 
-  if (svn_fs_fs__id_txn_id(target_id) == NULL)
+  if (! svn_fs_fs__id_is_txn(target_id))
     return svn_error_createf
       (SVN_ERR_FS_NOT_MUTABLE, NULL,
        _("Unexpected immutable node at '%s'"), target_path);
@@ -1462,14 +1661,14 @@ merge(svn_stringbuf_t *conflict_p,
 
           /* If either SOURCE-ENTRY or TARGET-ENTRY is not a direct
              modification of ANCESTOR-ENTRY, declare a conflict. */
-          if (strcmp(svn_fs_fs__id_node_id(s_entry->id),
-                     svn_fs_fs__id_node_id(a_entry->id)) != 0
-              || strcmp(svn_fs_fs__id_copy_id(s_entry->id),
-                        svn_fs_fs__id_copy_id(a_entry->id)) != 0
-              || strcmp(svn_fs_fs__id_node_id(t_entry->id),
-                        svn_fs_fs__id_node_id(a_entry->id)) != 0
-              || strcmp(svn_fs_fs__id_copy_id(t_entry->id),
-                        svn_fs_fs__id_copy_id(a_entry->id)) != 0)
+          if (! svn_fs_fs__id_part_eq(svn_fs_fs__id_node_part(s_entry->id),
+                                      svn_fs_fs__id_node_part(a_entry->id))
+              || ! svn_fs_fs__id_part_eq(svn_fs_fs__id_copy_part(s_entry->id),
+                                         svn_fs_fs__id_copy_part(a_entry->id))
+              || ! svn_fs_fs__id_part_eq(svn_fs_fs__id_node_part(t_entry->id),
+                                         svn_fs_fs__id_node_part(a_entry->id))
+              || ! svn_fs_fs__id_part_eq(svn_fs_fs__id_copy_part(t_entry->id),
+                                         svn_fs_fs__id_copy_part(a_entry->id)))
             return conflict_err(conflict_p,
                                 svn_dirent_join(target_path,
                                                 a_entry->name,
@@ -1851,6 +2050,19 @@ fs_dir_entries(apr_hash_t **table_p,
   return svn_fs_fs__dag_dir_entries(table_p, node, pool, pool);
 }
 
+/* Implements root_vtable_t.dir_entries_sorted. */
+static svn_error_t *
+fs_dir_entries_sorted(apr_array_header_t **entries_p,
+                      svn_fs_root_t *root,
+                      const char *path,
+                      apr_pool_t *pool)
+{
+  dag_node_t *node;
+
+  SVN_ERR(get_dag(&node, root, path, pool));
+  return svn_fs_fs__dag_dir_entries_sorted(entries_p, node, pool, pool);
+}
+
 
 /* Create a new directory named PATH in ROOT.  The new directory has
    no entries, and no properties.  ROOT must be the root of a
@@ -2378,6 +2590,15 @@ window_consumer(svn_txdelta_window_t *window, void *baton)
      cb->target_string. */
   SVN_ERR(tb->interpreter(window, tb->interpreter_baton));
 
+  /* Windows that get stored as they are need no buffering. */
+  if (! tb->target_string)
+    {
+      if (! window)
+        SVN_ERR(svn_fs_fs__dag_finalize_edits(tb->node, tb->result_checksum,
+                                              tb->pool));
+      return SVN_NO_ERROR;
+    }
+
   /* ### the write_to_string() callback for the txdelta's output stream
      ### should be doing all the flush determination logic, not here.
      ### in a drastic case, a window could generate a LOT more than the
@@ -2468,6 +2689,18 @@ apply_textdelta(void *baton, apr_pool_t *pool)
            svn_checksum_to_cstring_display(checksum, pool));
     }
 
+  /* If the new contents would get stored as a delta against the base
+     text anyway, store the incoming windows as they are rather than
+     computing the same kind of delta all over again. */
+  SVN_ERR(svn_fs_fs__dag_get_delta_edit_handler(&(tb->interpreter),
+                                                &(tb->interpreter_baton),
+                                                tb->node, tb->pool));
+  if (tb->interpreter)
+    return add_change(tb->root->fs, txn_id, tb->path,
+                      svn_fs_fs__dag_get_id(tb->node),
+                      svn_fs_path_change_modify, TRUE, FALSE, svn_node_file,
+                      SVN_INVALID_REVNUM, NULL, pool);
+
   /* Make a readable "source" stream out of the current contents of
      ROOT/PATH; obviously, this must done in the context of a db_txn.
      The stream is returned in tb->source_stream. */
@@ -2764,6 +2997,51 @@ fs_paths_changed(apr_hash_t **changed_paths_p,
     }
 }
 
+/* Implements change_iterator_vtable_t.get for revision roots. */
+static svn_error_t *
+fs_change_iterator_get(const char **path,
+                       svn_fs_path_change2_t **change,
+                       svn_fs_path_change_iterator_t *iterator,
+                       apr_pool_t *pool)
+{
+  return svn_fs_fs__changes_iterator_next(path, change, iterator->fsap_data,
+                                          pool);
+}
+
+static change_iterator_vtable_t change_iterator_vtable = {
+  fs_change_iterator_get
+};
+
+/* Set *ITERATOR to an iterator over the paths changed under ROOT.
+   Transactions keep their changes unfolded and in no useful order, so
+   those have to be fetched all at once.  Allocate *ITERATOR in POOL. */
+static svn_error_t *
+fs_paths_changed_iterator(svn_fs_path_change_iterator_t **iterator,
+                          svn_fs_root_t *root,
+                          apr_pool_t *pool)
+{
+  if (root->is_txn_root)
+    {
+      apr_hash_t *changes;
+
+      SVN_ERR(svn_fs_fs__txn_changes_fetch(&changes, root->fs, root->txn,
+                                           pool));
+      return svn_fs__paths_changed_iterator_from_hash(iterator, changes,
+                                                      pool);
+    }
+  else
+    {
+      svn_fs_fs__changes_iterator_t *changes;
+
+      SVN_ERR(svn_fs_fs__changes_iterator_open(&changes, root->fs,
+                                               root->rev, pool));
+      *iterator = apr_palloc(pool, sizeof(**iterator));
+      (*iterator)->vtable = &change_iterator_vtable;
+      (*iterator)->fsap_data = changes;
+      return SVN_NO_ERROR;
+    }
+}
+
 
 
 /* Our coolio opaque history object. */
@@ -2995,16 +3273,17 @@ fs_node_origin_rev(svn_revnum_t *revision,
 {
   svn_fs_t *fs = root->fs;
   const svn_fs_id_t *given_noderev_id, *cached_origin_id;
-  const char *node_id, *dash;
+  const svn_fs_fs__id_part_t *node_part;
+  const char *node_id;
 
   path = svn_fs__canonicalize_abspath(path, pool);
 
   /* Check the cache first. */
   SVN_ERR(fs_node_id(&given_noderev_id, root, path, pool));
-  node_id = svn_fs_fs__id_node_id(given_noderev_id);
+  node_part = svn_fs_fs__id_node_part(given_noderev_id);
 
   /* Is it a brand new uncommitted node? */
-  if (node_id[0] == '_')
+  if (node_part->txn_local)
     {
       *revision = SVN_INVALID_REVNUM;
       return SVN_NO_ERROR;
@@ -3012,13 +3291,14 @@ fs_node_origin_rev(svn_revnum_t *revision,
 
   /* Maybe this is a new-style node ID that just has the revision
      sitting right in it. */
-  dash = strchr(node_id, '-');
-  if (dash && *(dash+1))
+  if (SVN_IS_VALID_REVNUM(node_part->revision))
     {
-      *revision = SVN_STR_TO_REV(dash + 1);
+      *revision = node_part->revision;
       return SVN_NO_ERROR;
     }
 
+  node_id = svn_fs_fs__id_node_id(given_noderev_id, pool);
+
   /* OK, it's an old-style ID?  Maybe it's cached. */
   SVN_ERR(svn_fs_fs__get_node_origin(&cached_origin_id,
                                      fs,
@@ -3039,6 +3319,7 @@ fs_node_origin_rev(svn_revnum_t *revision,
     svn_stringbuf_t *lastpath = svn_stringbuf_create(path, pool);
     svn_revnum_t lastrev = SVN_INVALID_REVNUM;
     dag_node_t *node;
+    node_revision_t *noderev;
     const svn_fs_id_t *pred_id;
 
     /* Walk the closest-copy chain back to the first copy in our history.
@@ -3071,8 +3352,12 @@ fs_node_origin_rev(svn_revnum_t *revision,
         lastrev = currev;
       }
 
-    /* Walk the predecessor links back to origin. */
+    /* Walk the predecessor links back to origin, taking the skip links
+       as far as they go. */
     SVN_ERR(fs_node_id(&pred_id, curroot, lastpath->data, predidpool));
+    SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, pred_id, predidpool));
+    SVN_ERR(svn_fs_fs__get_ancestor(&noderev, fs, noderev, 0, predidpool));
+    pred_id = noderev->id;
     while (pred_id)
       {
         svn_pool_clear(subpool);
@@ -3094,7 +3379,7 @@ fs_node_origin_rev(svn_revnum_t *revision,
 
     /* Wow, I don't want to have to do all that again.  Let's cache
        the result. */
-    if (node_id[0] != '_')
+    if (! node_part->txn_local)
       SVN_ERR(svn_fs_fs__set_node_origin(fs, node_id,
                                          svn_fs_fs__dag_get_id(node), pool));
 
@@ -3375,6 +3660,42 @@ assemble_history(svn_fs_t *fs,
 
 /* mergeinfo queries */
 
+/* Add the mergeinfo of NODE, which lives at PATH under some root and
+   claims to have mergeinfo, to RESULT_CATALOG.  Allocate the additions
+   in RESULT_POOL; use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+add_node_mergeinfo(svn_mergeinfo_catalog_t result_catalog,
+                   const char *path,
+                   dag_node_t *node,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  apr_hash_t *proplist;
+  svn_mergeinfo_t mergeinfo;
+  svn_string_t *mergeinfo_string;
+
+  SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, node, scratch_pool));
+  mergeinfo_string = apr_hash_get(proplist, SVN_PROP_MERGEINFO,
+                                  APR_HASH_KEY_STRING);
+  if (!mergeinfo_string)
+    {
+      svn_string_t *idstr = svn_fs_fs__id_unparse(svn_fs_fs__dag_get_id(node),
+                                                  scratch_pool);
+      return svn_error_createf
+        (SVN_ERR_FS_CORRUPT, NULL,
+         _("Node-revision #'%s' claims to have mergeinfo but doesn't"),
+         idstr->data);
+    }
+
+  SVN_ERR(svn_mergeinfo_parse(&mergeinfo, mergeinfo_string->data,
+                              result_pool));
+
+  apr_hash_set(result_catalog, apr_pstrdup(result_pool, path),
+               APR_HASH_KEY_STRING, mergeinfo);
+
+  return SVN_NO_ERROR;
+}
+
 /* DIR_DAG is a directory DAG node which has mergeinfo in its
    descendants.  This function iterates over its children.  For each
    child with immediate mergeinfo, it adds its mergeinfo to
@@ -3419,33 +3740,8 @@ crawl_directory_dag_for_mergeinfo(svn_fs_root_t *root,
                                                             iterpool));
 
       if (has_mergeinfo)
-        {
-          /* Save this partisular node's mergeinfo. */
-          apr_hash_t *proplist;
-          svn_mergeinfo_t kid_mergeinfo;
-          svn_string_t *mergeinfo_string;
-
-          SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, kid_dag, iterpool));
-          mergeinfo_string = apr_hash_get(proplist, SVN_PROP_MERGEINFO,
-                                          APR_HASH_KEY_STRING);
-          if (!mergeinfo_string)
-            {
-              svn_string_t *idstr = svn_fs_fs__id_unparse(dirent->id, iterpool);
-              return svn_error_createf
-                (SVN_ERR_FS_CORRUPT, NULL,
-                 _("Node-revision #'%s' claims to have mergeinfo but doesn't"),
-                 idstr->data);
-            }
-
-          SVN_ERR(svn_mergeinfo_parse(&kid_mergeinfo,
-                                      mergeinfo_string->data,
-                                      result_pool));
-
-          apr_hash_set(result_catalog,
-                       apr_pstrdup(result_pool, kid_path),
-                       APR_HASH_KEY_STRING,
-                       kid_mergeinfo);
-        }
+        SVN_ERR(add_node_mergeinfo(result_catalog, kid_path, kid_dag,
+                                   result_pool, iterpool));
 
       if (go_down)
         SVN_ERR(crawl_directory_dag_for_mergeinfo(root,
@@ -3603,18 +3899,56 @@ add_descendant_mergeinfo(svn_mergeinfo_catalog_t result_catalog,
 {
   dag_node_t *this_dag;
   svn_boolean_t go_down;
+  const char *canon_path;
+  apr_array_header_t *mergeinfo_paths;
 
   SVN_ERR(get_dag(&this_dag, root, path, pool));
   SVN_ERR(svn_fs_fs__dag_has_descendants_with_mergeinfo(&go_down,
                                                         this_dag,
                                                         pool));
-  if (go_down)
-    SVN_ERR(crawl_directory_dag_for_mergeinfo(root,
-                                              path,
-                                              this_dag,
-                                              result_catalog,
-                                              pool,
-                                              result_pool));
+  if (! go_down)
+    return SVN_NO_ERROR;
+
+  /* Prefer the mergeinfo index over crawling the whole subtree. */
+  canon_path = svn_fs__canonicalize_abspath(path, pool);
+  SVN_ERR(svn_fs_fs__get_mergeinfo_index_paths(&mergeinfo_paths, root->fs,
+                                               root->rev, canon_path,
+                                               pool, pool));
+  if (mergeinfo_paths)
+    {
+      apr_pool_t *iterpool = svn_pool_create(pool);
+      apr_size_t len = strlen(canon_path);
+      int i;
+
+      /* Report the paths relative to PATH, as the crawl would. */
+      if (len == 1)
+        len = 0;
+
+      for (i = 0; i < mergeinfo_paths->nelts; i++)
+        {
+          const char *kid_path = APR_ARRAY_IDX(mergeinfo_paths, i,
+                                               const char *);
+          dag_node_t *kid_dag;
+
+          svn_pool_clear(iterpool);
+
+          SVN_ERR(get_dag(&kid_dag, root, kid_path, iterpool));
+          SVN_ERR(add_node_mergeinfo(result_catalog,
+                                     svn_uri_join(path, kid_path + len + 1,
+                                                  iterpool),
+                                     kid_dag, result_pool, iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(crawl_directory_dag_for_mergeinfo(root,
+                                            path,
+                                            this_dag,
+                                            result_catalog,
+                                            pool,
+                                            result_pool));
   return SVN_NO_ERROR;
 }
 
@@ -3689,7 +4023,9 @@ fs_get_mergeinfo(svn_mergeinfo_catalog_t *catalog,
 /* The vtable associated with root objects. */
 static root_vtable_t root_vtable = {
   fs_paths_changed,
+  fs_paths_changed_iterator,
   svn_fs_fs__check_path,
+  fs_check_paths,
   fs_node_history,
   fs_node_id,
   svn_fs_fs__node_created_rev,
@@ -3703,6 +4039,7 @@ static root_vtable_t root_vtable = {
   fs_change_node_prop,
   fs_props_changed,
   fs_dir_entries,
+  fs_dir_entries_sorted,
   fs_make_dir,
   fs_copy,
   fs_revision_link,
@@ -0,0 +1,405 @@
+/* txn-log.c --- the node-revision log of fsfs transactions
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_hash.h>
+#include <apr_strings.h>
+
+#include "svn_private_config.h"
+
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+
+#include "fs.h"
+#include "txn-log.h"
+
+/* Each record in the node log is a header line
+
+     <kind> <node-key> <length>\n
+
+   followed by LENGTH bytes of data and a newline.  Writers only ever
+   append complete records, so a record extending past the end of the
+   file is still being written and will be indexed on the next read. */
+
+/* Record kind names, indexed by svn_fs_fs__txn_log_kind_t. */
+static const char * const kind_names[] =
+  { "noderev", "props", "children", "entries", "delete" };
+
+/* Upper limit for the length of a record header. */
+#define MAX_HEADER_LEN 200
+
+
+/* The location of a record's data in the log. */
+typedef struct log_span_t
+{
+  /* Offset of the data, or -1 if there is no such record. */
+  apr_off_t offset;
+
+  /* Length of the data. */
+  apr_size_t len;
+} log_span_t;
+
+/* What the index knows about a node. */
+typedef struct log_node_t
+{
+  /* The latest node-rev and property list records. */
+  log_span_t noderev;
+  log_span_t props;
+
+  /* The latest complete directory listing followed by the incremental
+     entries written after it, as log_span_t.  Empty if there is no
+     listing. */
+  apr_array_header_t *children;
+} log_node_t;
+
+/* The index of a transaction's node log. */
+typedef struct txn_log_t
+{
+  /* Whether the transaction has a node log at all. */
+  svn_boolean_t exists;
+
+  /* Number of bytes at the start of the log indexed so far. */
+  apr_off_t indexed;
+
+  /* const char * node key -> log_node_t *, for the records indexed so
+     far. */
+  apr_hash_t *nodes;
+
+  /* The pool holding this structure, a sub-pool of FS->pool. */
+  apr_pool_t *pool;
+} txn_log_t;
+
+
+/* Return the path of the node log in TXN_DIR, allocated in POOL. */
+static const char *
+path_txn_node_log(const char *txn_dir, apr_pool_t *pool)
+{
+  return svn_dirent_join(txn_dir, PATH_TXN_NODE_LOG, pool);
+}
+
+/* Return an error about a malformed node log in TXN_DIR. */
+static svn_error_t *
+log_corrupt(const char *txn_dir, apr_pool_t *pool)
+{
+  return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                           _("Malformed node log in transaction '%s'"),
+                           svn_dirent_local_style(txn_dir, pool));
+}
+
+/* Set *LOG to the index for the transaction in TXN_DIR of FS, creating
+   an empty one if there is none yet.  Use POOL for temporary
+   allocations. */
+static svn_error_t *
+get_log(txn_log_t **log,
+        svn_fs_t *fs,
+        const char *txn_dir,
+        apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *log_pool;
+  svn_node_kind_t kind;
+
+  if (! ffd->txn_logs)
+    ffd->txn_logs = apr_hash_make(fs->pool);
+
+  *log = apr_hash_get(ffd->txn_logs, txn_dir, APR_HASH_KEY_STRING);
+  if (*log)
+    return SVN_NO_ERROR;
+
+  /* The log is created together with the transaction, so whether it
+     exists will not change while we cache the answer. */
+  SVN_ERR(svn_io_check_path(path_txn_node_log(txn_dir, pool), &kind, pool));
+
+  log_pool = svn_pool_create(fs->pool);
+  *log = apr_pcalloc(log_pool, sizeof(**log));
+  (*log)->exists = (kind == svn_node_file);
+  (*log)->nodes = apr_hash_make(log_pool);
+  (*log)->pool = log_pool;
+
+  apr_hash_set(ffd->txn_logs, apr_pstrdup(log_pool, txn_dir),
+               APR_HASH_KEY_STRING, *log);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the index entry of NODE_KEY in LOG, creating it if necessary. */
+static log_node_t *
+get_node(txn_log_t *log,
+         const char *node_key)
+{
+  log_node_t *node = apr_hash_get(log->nodes, node_key, APR_HASH_KEY_STRING);
+
+  if (! node)
+    {
+      node = apr_pcalloc(log->pool, sizeof(*node));
+      node->noderev.offset = -1;
+      node->props.offset = -1;
+      node->children = apr_array_make(log->pool, 1, sizeof(log_span_t));
+      apr_hash_set(log->nodes, apr_pstrdup(log->pool, node_key),
+                   APR_HASH_KEY_STRING, node);
+    }
+
+  return node;
+}
+
+/* Add the complete records between LOG->INDEXED and SIZE in FILE, the
+   node log in TXN_DIR, to LOG.  Use POOL for temporary allocations. */
+static svn_error_t *
+index_tail(txn_log_t *log,
+           apr_file_t *file,
+           apr_off_t size,
+           const char *txn_dir,
+           apr_pool_t *pool)
+{
+  apr_off_t pos = log->indexed;
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &pos, pool));
+
+  while (pos < size)
+    {
+      char buf[MAX_HEADER_LEN];
+      apr_size_t limit = sizeof(buf);
+      char *node_key, *len_str, *end;
+      apr_int64_t len;
+      log_span_t span;
+      log_node_t *node;
+      int kind;
+      svn_error_t *err;
+
+      /* A partial header belongs to a record still being written. */
+      err = svn_io_read_length_line(file, buf, &limit, pool);
+      if (err && APR_STATUS_IS_EOF(err->apr_err))
+        {
+          svn_error_clear(err);
+          break;
+        }
+      SVN_ERR(err);
+
+      node_key = strchr(buf, ' ');
+      if (! node_key)
+        return log_corrupt(txn_dir, pool);
+      *node_key++ = '\0';
+
+      len_str = strchr(node_key, ' ');
+      if (! len_str)
+        return log_corrupt(txn_dir, pool);
+      *len_str++ = '\0';
+
+      len = apr_strtoi64(len_str, &end, 10);
+      if (*len_str == '\0' || *end != '\0' || len < 0)
+        return log_corrupt(txn_dir, pool);
+
+      for (kind = 0; kind <= svn_fs_fs__txn_log_delete; ++kind)
+        if (strcmp(buf, kind_names[kind]) == 0)
+          break;
+      if (kind > svn_fs_fs__txn_log_delete)
+        return log_corrupt(txn_dir, pool);
+
+      span.offset = pos + limit + 1;
+      span.len = (apr_size_t)len;
+
+      /* So does data extending past the end of the file. */
+      if (span.offset + span.len + 1 > size)
+        break;
+
+      node = get_node(log, node_key);
+      switch (kind)
+        {
+          case svn_fs_fs__txn_log_noderev:
+            node->noderev = span;
+            break;
+
+          case svn_fs_fs__txn_log_props:
+            node->props = span;
+            break;
+
+          case svn_fs_fs__txn_log_children:
+            apr_array_clear(node->children);
+            APR_ARRAY_PUSH(node->children, log_span_t) = span;
+            break;
+
+          case svn_fs_fs__txn_log_entries:
+            if (node->children->nelts == 0)
+              return log_corrupt(txn_dir, pool);
+            APR_ARRAY_PUSH(node->children, log_span_t) = span;
+            break;
+
+          default:
+            node->noderev.offset = -1;
+            node->props.offset = -1;
+            apr_array_clear(node->children);
+            break;
+        }
+
+      pos = span.offset + span.len + 1;
+      log->indexed = pos;
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &pos, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs_fs__txn_log_create(svn_fs_t *fs,
+                          const char *txn_dir,
+                          apr_pool_t *pool)
+{
+  txn_log_t *log;
+
+  SVN_ERR(svn_io_file_create(path_txn_node_log(txn_dir, pool), "", pool));
+  SVN_ERR(get_log(&log, fs, txn_dir, pool));
+  log->exists = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__txn_log_exists(svn_boolean_t *exists,
+                          svn_fs_t *fs,
+                          const char *txn_dir,
+                          apr_pool_t *pool)
+{
+  txn_log_t *log;
+
+  SVN_ERR(get_log(&log, fs, txn_dir, pool));
+  *exists = log->exists;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__txn_log_append(const char *txn_dir,
+                          svn_fs_fs__txn_log_kind_t kind,
+                          const char *node_key,
+                          const char *data,
+                          apr_size_t len,
+                          apr_pool_t *pool)
+{
+  const char *header = apr_psprintf(pool, "%s %s %" APR_SIZE_T_FMT "\n",
+                                    kind_names[kind], node_key, len);
+  svn_stringbuf_t *record;
+  apr_file_t *file;
+
+  /* Assemble the whole record first, so it gets written in one go. */
+  record = svn_stringbuf_create_ensure(strlen(header) + len + 1, pool);
+  svn_stringbuf_appendcstr(record, header);
+  svn_stringbuf_appendbytes(record, data, len);
+  svn_stringbuf_appendbytes(record, "\n", 1);
+
+  SVN_ERR(svn_io_file_open(&file, path_txn_node_log(txn_dir, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, record->data, record->len, NULL,
+                                 pool));
+
+  return svn_io_file_close(file, pool);
+}
+
+svn_error_t *
+svn_fs_fs__txn_log_read(svn_stringbuf_t **contents,
+                        svn_fs_t *fs,
+                        const char *txn_dir,
+                        svn_fs_fs__txn_log_kind_t kind,
+                        const char *node_key,
+                        apr_pool_t *pool)
+{
+  txn_log_t *log;
+  log_node_t *node;
+  apr_array_header_t *spans;
+  apr_file_t *file;
+  apr_finfo_t finfo;
+  apr_size_t total = 0;
+  int i;
+
+  SVN_ERR(get_log(&log, fs, txn_dir, pool));
+  SVN_ERR_ASSERT(log->exists);
+
+  /* Pick up whatever has been appended since we last looked. */
+  SVN_ERR(svn_io_file_open(&file, path_txn_node_log(txn_dir, pool),
+                           APR_READ | APR_BUFFERED, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, file, pool));
+  if (finfo.size > log->indexed)
+    SVN_ERR(index_tail(log, file, finfo.size, txn_dir, pool));
+
+  /* Collect the spans to return. */
+  node = apr_hash_get(log->nodes, node_key, APR_HASH_KEY_STRING);
+  if (node && kind == svn_fs_fs__txn_log_children)
+    {
+      spans = node->children;
+    }
+  else
+    {
+      spans = apr_array_make(pool, 1, sizeof(log_span_t));
+
+      if (node && kind == svn_fs_fs__txn_log_noderev
+          && node->noderev.offset >= 0)
+        APR_ARRAY_PUSH(spans, log_span_t) = node->noderev;
+      else if (node && kind == svn_fs_fs__txn_log_props
+               && node->props.offset >= 0)
+        APR_ARRAY_PUSH(spans, log_span_t) = node->props;
+    }
+
+  if (spans->nelts == 0)
+    {
+      *contents = NULL;
+      return svn_io_file_close(file, pool);
+    }
+
+  /* Read them into a single buffer. */
+  for (i = 0; i < spans->nelts; ++i)
+    total += APR_ARRAY_IDX(spans, i, log_span_t).len;
+
+  *contents = svn_stringbuf_create_ensure(total, pool);
+  for (i = 0; i < spans->nelts; ++i)
+    {
+      log_span_t *span = &APR_ARRAY_IDX(spans, i, log_span_t);
+      apr_off_t offset = span->offset;
+
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+      SVN_ERR(svn_io_file_read_full(file, (*contents)->data + (*contents)->len,
+                                    span->len, NULL, pool));
+      (*contents)->len += span->len;
+    }
+  (*contents)->data[(*contents)->len] = '\0';
+
+  return svn_io_file_close(file, pool);
+}
+
+void
+svn_fs_fs__txn_log_forget(svn_fs_t *fs,
+                          const char *txn_dir)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  txn_log_t *log;
+
+  if (! ffd->txn_logs)
+    return;
+
+  log = apr_hash_get(ffd->txn_logs, txn_dir, APR_HASH_KEY_STRING);
+  if (log)
+    {
+      apr_hash_set(ffd->txn_logs, txn_dir, APR_HASH_KEY_STRING, NULL);
+      svn_pool_destroy(log->pool);
+    }
+}
@@ -0,0 +1,115 @@
+/* txn-log.h : interface to the node-revision log of fsfs transactions
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_TXN_LOG_H
+#define SVN_LIBSVN_FS_FS_TXN_LOG_H
+
+#include "svn_error.h"
+#include "svn_string.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/* A transaction may keep its node-revs, their mutable property lists
+   and directory listings in a single append-only file, the "node log",
+   instead of one to three files per node.  Every write appends one
+   record; an index of the records, built on demand and kept in FS'
+   private data, tells readers where the latest data for a node is.
+   The log is read like the individual files when the transaction gets
+   committed and goes away with the transaction directory. */
+
+/* The kinds of records in a node log. */
+typedef enum svn_fs_fs__txn_log_kind_t
+{
+  /* A node-rev, in the same format as a node.<nid>.<cid> file. */
+  svn_fs_fs__txn_log_noderev,
+
+  /* A node's property list, as a hash dump. */
+  svn_fs_fs__txn_log_props,
+
+  /* A complete directory listing, as a hash dump. */
+  svn_fs_fs__txn_log_children,
+
+  /* An incremental hash dump entry changing the latest listing. */
+  svn_fs_fs__txn_log_entries,
+
+  /* The node-rev and all its data have been deleted. */
+  svn_fs_fs__txn_log_delete
+} svn_fs_fs__txn_log_kind_t;
+
+
+/* Create an empty node log in the transaction directory TXN_DIR of FS.
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__txn_log_create(svn_fs_t *fs,
+                          const char *txn_dir,
+                          apr_pool_t *pool);
+
+/* Set *EXISTS to whether the transaction in TXN_DIR of FS has a node
+   log.  Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__txn_log_exists(svn_boolean_t *exists,
+                          svn_fs_t *fs,
+                          const char *txn_dir,
+                          apr_pool_t *pool);
+
+/* Append a record of KIND for the node NODE_KEY ("<nid>.<cid>") with
+   the LEN bytes at DATA to the node log in TXN_DIR.  The record is
+   written with a single append, so concurrent writers will not
+   interleave.  Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__txn_log_append(const char *txn_dir,
+                          svn_fs_fs__txn_log_kind_t kind,
+                          const char *node_key,
+                          const char *data,
+                          apr_size_t len,
+                          apr_pool_t *pool);
+
+/* Set *CONTENTS to the latest data of KIND for the node NODE_KEY in the
+   node log in TXN_DIR of FS, or to NULL if there is none.  For
+   svn_fs_fs__txn_log_children, that is the latest complete listing
+   followed by all incremental entries written after it.  KIND must be
+   one of svn_fs_fs__txn_log_noderev, svn_fs_fs__txn_log_props or
+   svn_fs_fs__txn_log_children.  Allocate *CONTENTS in POOL. */
+svn_error_t *
+svn_fs_fs__txn_log_read(svn_stringbuf_t **contents,
+                        svn_fs_t *fs,
+                        const char *txn_dir,
+                        svn_fs_fs__txn_log_kind_t kind,
+                        const char *node_key,
+                        apr_pool_t *pool);
+
+/* Drop any information about the node log in TXN_DIR that FS may have
+   cached.  Call this when the transaction goes away. */
+void
+svn_fs_fs__txn_log_forget(svn_fs_t *fs,
+                          const char *txn_dir);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_TXN_LOG_H */
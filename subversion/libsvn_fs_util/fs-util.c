@@ -29,6 +29,7 @@
 #include "svn_fs.h"
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
+#include "svn_sorts.h"
 #include "svn_private_config.h"
 
 #include "private/svn_fs_util.h"
@@ -149,3 +150,62 @@ svn_fs__path_change_create_internal(const svn_fs_id_t *node_rev_id,
 
   return change;
 }
+
+/* The FSAP data of an iterator over a hash of changes. */
+typedef struct hash_change_iterator_t
+{
+  /* The entries of the changes hash, sorted by path. */
+  apr_array_header_t *sorted;
+
+  /* Index of the next entry to return. */
+  int next;
+} hash_change_iterator_t;
+
+/* Implements change_iterator_vtable_t.get. */
+static svn_error_t *
+hash_change_iterator_get(const char **path,
+                         svn_fs_path_change2_t **change,
+                         svn_fs_path_change_iterator_t *iterator,
+                         apr_pool_t *pool)
+{
+  hash_change_iterator_t *hci = iterator->fsap_data;
+
+  if (hci->next < hci->sorted->nelts)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(hci->sorted, hci->next,
+                                              svn_sort__item_t);
+      *path = item->key;
+      *change = item->value;
+      hci->next++;
+    }
+  else
+    {
+      *path = NULL;
+      *change = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static change_iterator_vtable_t hash_change_iterator_vtable = {
+  hash_change_iterator_get
+};
+
+svn_error_t *
+svn_fs__paths_changed_iterator_from_hash(
+  svn_fs_path_change_iterator_t **iterator,
+  apr_hash_t *changes,
+  apr_pool_t *pool)
+{
+  hash_change_iterator_t *hci = apr_palloc(pool, sizeof(*hci));
+
+  hci->sorted = svn_sort__hash(changes, svn_sort_compare_items_as_paths,
+                               pool);
+  hci->next = 0;
+
+  *iterator = apr_palloc(pool, sizeof(**iterator));
+  (*iterator)->vtable = &hash_change_iterator_vtable;
+  (*iterator)->fsap_data = hci;
+
+  return SVN_NO_ERROR;
+}
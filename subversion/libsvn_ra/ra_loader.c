@@ -42,11 +42,15 @@
 #include "svn_ra.h"
 #include "svn_xml.h"
 #include "svn_path.h"
+#include "svn_dirent_uri.h"
+#include "svn_props.h"
+#include "svn_sorts.h"
 #include "svn_dso.h"
 #include "svn_config.h"
 #include "ra_loader.h"
 
 #include "private/svn_ra_private.h"
+#include "private/svn_tar.h"
 #include "svn_private_config.h"
 
 
@@ -844,6 +848,308 @@ svn_error_t *svn_ra_stat(svn_ra_session_t *session,
   return session->vtable->stat(session, path, revision, dirent, pool);
 }
 
+svn_error_t *svn_ra_stat_many(svn_ra_session_t *session,
+                              apr_hash_t **dirents,
+                              const apr_array_header_t *paths,
+                              svn_revnum_t revision,
+                              apr_pool_t *pool)
+{
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    SVN_ERR_ASSERT(*APR_ARRAY_IDX(paths, i, const char *) != '/');
+
+  if (session->vtable->stat_many)
+    return session->vtable->stat_many(session, dirents, paths, revision,
+                                      pool);
+
+  *dirents = apr_hash_make(pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_dirent_t *dirent;
+
+      SVN_ERR(session->vtable->stat(session, path, revision, &dirent, pool));
+      if (dirent)
+        apr_hash_set(*dirents, path, APR_HASH_KEY_STRING, dirent);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *svn_ra_get_dir_many(svn_ra_session_t *session,
+                                 apr_hash_t **listings,
+                                 const apr_array_header_t *paths,
+                                 svn_revnum_t revision,
+                                 apr_uint32_t dirent_fields,
+                                 svn_boolean_t want_props,
+                                 apr_pool_t *pool)
+{
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    SVN_ERR_ASSERT(*APR_ARRAY_IDX(paths, i, const char *) != '/');
+
+  if (session->vtable->get_dir_many)
+    return session->vtable->get_dir_many(session, listings, paths, revision,
+                                         dirent_fields, want_props, pool);
+
+  *listings = apr_hash_make(pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_ra_dir_listing_t *listing = apr_pcalloc(pool, sizeof(*listing));
+
+      SVN_ERR(session->vtable->get_dir(session, &listing->dirents,
+                                       &listing->fetched_rev,
+                                       want_props ? &listing->props : NULL,
+                                       path, revision, dirent_fields, pool));
+      apr_hash_set(*listings, path, APR_HASH_KEY_STRING, listing);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_ra_list() for the directory PATH in REVISION, whose path
+   relative to the listed directory is REL_PATH, with one get_dir call per
+   directory.  If REVISION is SVN_INVALID_REVNUM, set it to the revision
+   that was listed. */
+static svn_error_t *
+list_dir(svn_ra_session_t *session,
+         const char *path,
+         const char *rel_path,
+         svn_revnum_t *revision,
+         svn_depth_t depth,
+         apr_uint32_t dirent_fields,
+         svn_ra_dirent_receiver_t receiver,
+         void *receiver_baton,
+         apr_pool_t *pool)
+{
+  apr_hash_t *dirents;
+  apr_array_header_t *sorted;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(session->vtable->get_dir(session, &dirents, revision, NULL,
+                                   path, *revision,
+                                   dirent_fields | SVN_DIRENT_KIND, pool));
+
+  sorted = svn_sort__hash(dirents, svn_sort_compare_items_lexically, pool);
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      svn_dirent_t *dirent = item->value;
+      const char *child_rel_path;
+
+      svn_pool_clear(iterpool);
+
+      if (dirent->kind != svn_node_file && depth == svn_depth_files)
+        continue;
+
+      child_rel_path = svn_relpath_join(rel_path, item->key, iterpool);
+      SVN_ERR(receiver(child_rel_path, dirent, receiver_baton, iterpool));
+
+      if (depth == svn_depth_infinity && dirent->kind == svn_node_dir)
+        SVN_ERR(list_dir(session, svn_relpath_join(path, item->key, iterpool),
+                         child_rel_path, revision, depth, dirent_fields,
+                         receiver, receiver_baton, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *svn_ra_list(svn_ra_session_t *session,
+                         const char *path,
+                         svn_revnum_t revision,
+                         svn_depth_t depth,
+                         apr_uint32_t dirent_fields,
+                         svn_ra_dirent_receiver_t receiver,
+                         void *receiver_baton,
+                         apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(*path != '/');
+
+  if (session->vtable->list)
+    {
+      svn_error_t *err = session->vtable->list(session, path, revision,
+                                               depth, dirent_fields,
+                                               receiver, receiver_baton,
+                                               scratch_pool);
+
+      if (! err || err->apr_err != SVN_ERR_RA_NOT_IMPLEMENTED)
+        return svn_error_return(err);
+      svn_error_clear(err);
+    }
+
+  if (depth == svn_depth_empty)
+    return SVN_NO_ERROR;
+
+  return list_dir(session, path, "", &revision, depth, dirent_fields,
+                  receiver, receiver_baton, scratch_pool);
+}
+
+/* An entry of the tree archived by svn_ra_get_archive(). */
+typedef struct archive_entry_t
+{
+  const char *rel_path;
+  svn_dirent_t *dirent;
+} archive_entry_t;
+
+/* Append an archive_entry_t for PATH and DIRENT to the array BATON.
+   Implements svn_ra_dirent_receiver_t. */
+static svn_error_t *
+collect_archive_entry(const char *path,
+                      svn_dirent_t *dirent,
+                      void *baton,
+                      apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *entries = baton;
+  archive_entry_t *entry = apr_palloc(entries->pool, sizeof(*entry));
+
+  entry->rel_path = apr_pstrdup(entries->pool, path);
+  entry->dirent = svn_dirent_dup(dirent, entries->pool);
+  APR_ARRAY_PUSH(entries, archive_entry_t *) = entry;
+  return SVN_NO_ERROR;
+}
+
+/* Write the file PATH in REVISION, whose size and date DIRENT gives, to
+   the archive STREAM as NAME, fetching it through SESSION. */
+static svn_error_t *
+archive_file(svn_ra_session_t *session,
+             const char *path,
+             svn_revnum_t revision,
+             const char *name,
+             const svn_dirent_t *dirent,
+             svn_stream_t *stream,
+             apr_pool_t *pool)
+{
+  apr_hash_t *props;
+  svn_boolean_t executable;
+
+  SVN_ERR(session->vtable->get_file(session, path, revision, NULL, NULL,
+                                    &props, pool));
+
+  if (apr_hash_get(props, SVN_PROP_SPECIAL, APR_HASH_KEY_STRING))
+    {
+      svn_stringbuf_t *buf = svn_stringbuf_create("", pool);
+      apr_size_t len;
+
+      SVN_ERR(session->vtable->get_file(session, path, revision,
+                                        svn_stream_from_stringbuf(buf, pool),
+                                        NULL, NULL, pool));
+      if (strncmp(buf->data, "link ", 5) == 0)
+        return svn_tar__write_header(stream, name, svn_node_file,
+                                     buf->data + 5, 0, FALSE, dirent->time,
+                                     pool);
+
+      SVN_ERR(svn_tar__write_header(stream, name, svn_node_file, NULL,
+                                    buf->len, FALSE, dirent->time, pool));
+      len = buf->len;
+      SVN_ERR(svn_stream_write(stream, buf->data, &len));
+      return svn_tar__write_padding(stream, buf->len);
+    }
+
+  executable = apr_hash_get(props, SVN_PROP_EXECUTABLE, APR_HASH_KEY_STRING)
+               != NULL;
+  SVN_ERR(svn_tar__write_header(stream, name, svn_node_file, NULL,
+                                dirent->size, executable, dirent->time,
+                                pool));
+  SVN_ERR(session->vtable->get_file(session, path, revision,
+                                    svn_stream_disown(stream, pool),
+                                    NULL, NULL, pool));
+  return svn_tar__write_padding(stream, dirent->size);
+}
+
+svn_error_t *svn_ra_get_archive(svn_ra_session_t *session,
+                                const char *path,
+                                svn_revnum_t revision,
+                                const char *prefix,
+                                svn_stream_t *stream,
+                                apr_pool_t *scratch_pool)
+{
+  svn_dirent_t *dirent;
+  apr_array_header_t *entries;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR_ASSERT(*path != '/');
+
+  if (session->vtable->get_archive)
+    {
+      svn_error_t *err = session->vtable->get_archive(session, path,
+                                                      revision, prefix,
+                                                      stream, scratch_pool);
+
+      if (! err || err->apr_err != SVN_ERR_RA_NOT_IMPLEMENTED)
+        return svn_error_return(err);
+      svn_error_clear(err);
+    }
+
+  /* Archive the same revision throughout. */
+  if (! SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(session->vtable->get_latest_revnum(session, &revision,
+                                               scratch_pool));
+
+  SVN_ERR(session->vtable->stat(session, path, revision, &dirent,
+                                scratch_pool));
+  if (! dirent)
+    return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                             _("Path '%s' not found in revision %ld"),
+                             path, revision);
+
+  if (dirent->kind == svn_node_file)
+    {
+      if (! *prefix)
+        {
+          const char *url;
+
+          SVN_ERR(session->vtable->get_session_url(session, &url,
+                                                   scratch_pool));
+          prefix = svn_path_uri_decode(
+                     svn_uri_basename(svn_path_url_add_component2(
+                                        url, path, scratch_pool),
+                                      scratch_pool),
+                     scratch_pool);
+        }
+      SVN_ERR(archive_file(session, path, revision, prefix, dirent, stream,
+                           scratch_pool));
+      return svn_tar__write_trailer(stream);
+    }
+
+  if (*prefix)
+    SVN_ERR(svn_tar__write_header(stream, prefix, svn_node_dir, NULL, 0,
+                                  FALSE, dirent->time, scratch_pool));
+
+  entries = apr_array_make(scratch_pool, 0, sizeof(archive_entry_t *));
+  SVN_ERR(svn_ra_list(session, path, revision, svn_depth_infinity,
+                      SVN_DIRENT_KIND | SVN_DIRENT_SIZE | SVN_DIRENT_TIME,
+                      collect_archive_entry, entries, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < entries->nelts; i++)
+    {
+      archive_entry_t *entry = APR_ARRAY_IDX(entries, i, archive_entry_t *);
+      const char *name;
+
+      svn_pool_clear(iterpool);
+      name = svn_relpath_join(prefix, entry->rel_path, iterpool);
+
+      if (entry->dirent->kind == svn_node_dir)
+        SVN_ERR(svn_tar__write_header(stream, name, svn_node_dir, NULL, 0,
+                                      FALSE, entry->dirent->time, iterpool));
+      else
+        SVN_ERR(archive_file(session,
+                             svn_relpath_join(path, entry->rel_path,
+                                              iterpool),
+                             revision, name, entry->dirent, stream,
+                             iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_tar__write_trailer(stream);
+}
+
 svn_error_t *svn_ra_get_uuid2(svn_ra_session_t *session,
                               const char **uuid,
                               apr_pool_t *pool)
@@ -959,6 +1265,28 @@ svn_error_t *svn_ra_get_file_revs2(svn_ra_session_t *session,
   return err;
 }
 
+svn_error_t *svn_ra_get_file_blame(svn_ra_session_t *session,
+                                   const char *path,
+                                   svn_revnum_t start,
+                                   svn_revnum_t end,
+                                   const apr_array_header_t *diff_options,
+                                   svn_boolean_t ignore_mime_type,
+                                   svn_blame_chunk_receiver_t receiver,
+                                   void *receiver_baton,
+                                   apr_pool_t *pool)
+{
+  SVN_ERR_ASSERT(*path != '/');
+
+  if (! session->vtable->get_file_blame)
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL,
+                            _("Server-side blame is not supported by this "
+                              "Repository Access method"));
+
+  return session->vtable->get_file_blame(session, path, start, end,
+                                         diff_options, ignore_mime_type,
+                                         receiver, receiver_baton, pool);
+}
+
 svn_error_t *svn_ra_lock(svn_ra_session_t *session,
                          apr_hash_t *path_revs,
                          const char *comment,
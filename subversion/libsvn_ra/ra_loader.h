@@ -263,6 +263,49 @@ typedef struct svn_ra__vtable_t {
                                       svn_revnum_t revision,
                                       const char *path,
                                       apr_pool_t *pool);
+  /* May be NULL if the RA layer doesn't support it; see
+     svn_ra_get_file_blame(). */
+  svn_error_t *(*get_file_blame)(svn_ra_session_t *session,
+                                 const char *path,
+                                 svn_revnum_t start,
+                                 svn_revnum_t end,
+                                 const apr_array_header_t *diff_options,
+                                 svn_boolean_t ignore_mime_type,
+                                 svn_blame_chunk_receiver_t receiver,
+                                 void *receiver_baton,
+                                 apr_pool_t *pool);
+  /* May be NULL, in which case svn_ra_stat_many() and
+     svn_ra_get_dir_many() handle one path at a time. */
+  svn_error_t *(*stat_many)(svn_ra_session_t *session,
+                            apr_hash_t **dirents,
+                            const apr_array_header_t *paths,
+                            svn_revnum_t revision,
+                            apr_pool_t *pool);
+  svn_error_t *(*get_dir_many)(svn_ra_session_t *session,
+                               apr_hash_t **listings,
+                               const apr_array_header_t *paths,
+                               svn_revnum_t revision,
+                               apr_uint32_t dirent_fields,
+                               svn_boolean_t want_props,
+                               apr_pool_t *pool);
+  /* May be NULL or return SVN_ERR_RA_NOT_IMPLEMENTED, in which case
+     svn_ra_list() calls get_dir for each directory. */
+  svn_error_t *(*list)(svn_ra_session_t *session,
+                       const char *path,
+                       svn_revnum_t revision,
+                       svn_depth_t depth,
+                       apr_uint32_t dirent_fields,
+                       svn_ra_dirent_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *scratch_pool);
+  /* May be NULL or return SVN_ERR_RA_NOT_IMPLEMENTED, in which case
+     svn_ra_get_archive() lists the tree and fetches each file. */
+  svn_error_t *(*get_archive)(svn_ra_session_t *session,
+                              const char *path,
+                              svn_revnum_t revision,
+                              const char *prefix,
+                              svn_stream_t *stream,
+                              apr_pool_t *scratch_pool);
 
 } svn_ra__vtable_t;
 
@@ -25,6 +25,7 @@
 #include "svn_ra.h"
 #include "svn_fs.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_repos.h"
 #include "svn_pools.h"
 #include "svn_time.h"
@@ -1190,6 +1191,43 @@ svn_ra_local__get_location_segments(svn_ra_session_t *session,
 }
 
 
+/* Baton for lock_many_callback(). */
+struct lock_baton_t
+{
+  /* Maps the absolute FS paths back to the session relative paths. */
+  apr_hash_t *rel_paths;
+
+  svn_boolean_t do_lock;
+  svn_ra_lock_callback_t lock_func;
+  void *lock_baton;
+};
+
+/* This implements svn_fs__lock_callback_t.  Pass the outcome for PATH on
+   to BATON->lock_func, whatever the error: the other paths are locked
+   (or unlocked) anyway, so aborting would only hide their outcome.
+   BATON is a 'struct lock_baton_t *'. */
+static svn_error_t *
+lock_many_callback(void *baton,
+                   const char *path,
+                   const svn_lock_t *lock,
+                   svn_error_t *fs_err,
+                   apr_pool_t *pool)
+{
+  struct lock_baton_t *b = baton;
+  const char *rel_path;
+
+  if (! b->lock_func)
+    return SVN_NO_ERROR;
+
+  rel_path = apr_hash_get(b->rel_paths, path, APR_HASH_KEY_STRING);
+  if (! rel_path)
+    rel_path = path;
+
+  return b->lock_func(b->lock_baton, rel_path, b->do_lock,
+                      b->do_lock ? (svn_lock_t *)lock : NULL, fs_err, pool);
+}
+
+
 static svn_error_t *
 svn_ra_local__lock(svn_ra_session_t *session,
                    apr_hash_t *path_revs,
@@ -1200,51 +1238,38 @@ svn_ra_local__lock(svn_ra_session_t *session,
                    apr_pool_t *pool)
 {
   svn_ra_local__session_baton_t *sess = session->priv;
+  apr_hash_t *targets = apr_hash_make(pool);
+  struct lock_baton_t b;
   apr_hash_index_t *hi;
-  apr_pool_t *iterpool = svn_pool_create(pool);
 
   /* A username is absolutely required to lock a path. */
   SVN_ERR(get_username(session, pool));
 
+  b.rel_paths = apr_hash_make(pool);
+  b.do_lock = TRUE;
+  b.lock_func = lock_func;
+  b.lock_baton = lock_baton;
+
   for (hi = apr_hash_first(pool, path_revs); hi; hi = apr_hash_next(hi))
     {
-      svn_lock_t *lock;
-      const void *key;
-      const char *path;
-      void *val;
-      svn_revnum_t *revnum;
-      const char *abs_path;
-      svn_error_t *err, *callback_err = NULL;
-
-      svn_pool_clear(iterpool);
-      apr_hash_this(hi, &key, NULL, &val);
-      path = key;
-      revnum = val;
-
-      abs_path = svn_dirent_join(sess->fs_path->data, path, iterpool);
-
-      /* This wrapper will call pre- and post-lock hooks. */
-      err = svn_repos_fs_lock(&lock, sess->repos, abs_path, NULL, comment,
-                              FALSE /* not DAV comment */,
-                              0 /* no expiration */, *revnum, force,
-                              iterpool);
-
-      if (err && !SVN_ERR_IS_LOCK_ERROR(err))
-        return err;
-
-      if (lock_func)
-        callback_err = lock_func(lock_baton, path, TRUE, err ? NULL : lock,
-                                 err, iterpool);
-
-      svn_error_clear(err);
-
-      if (callback_err)
-        return callback_err;
+      const char *path = svn__apr_hash_index_key(hi);
+      svn_revnum_t *revnum = svn__apr_hash_index_val(hi);
+      svn_fs__lock_target_t *target = apr_palloc(pool, sizeof(*target));
+      const char *abs_path = svn_dirent_join(sess->fs_path->data, path,
+                                             pool);
+
+      target->token = NULL;
+      target->current_rev = *revnum;
+      apr_hash_set(targets, abs_path, APR_HASH_KEY_STRING, target);
+      apr_hash_set(b.rel_paths, abs_path, APR_HASH_KEY_STRING, path);
     }
 
-  svn_pool_destroy(iterpool);
-
-  return SVN_NO_ERROR;
+  /* This wrapper will call pre- and post-lock hooks, and locks all
+     paths under a single FS write lock. */
+  return svn_repos__fs_lock_many(sess->repos, targets, comment,
+                                 FALSE /* not DAV comment */,
+                                 0 /* no expiration */, force,
+                                 lock_many_callback, &b, pool);
 }
 
 
@@ -1257,51 +1282,34 @@ svn_ra_local__unlock(svn_ra_session_t *session,
                      apr_pool_t *pool)
 {
   svn_ra_local__session_baton_t *sess = session->priv;
+  apr_hash_t *targets = apr_hash_make(pool);
+  struct lock_baton_t b;
   apr_hash_index_t *hi;
-  apr_pool_t *iterpool = svn_pool_create(pool);
 
   /* A username is absolutely required to unlock a path. */
   SVN_ERR(get_username(session, pool));
 
+  b.rel_paths = apr_hash_make(pool);
+  b.do_lock = FALSE;
+  b.lock_func = lock_func;
+  b.lock_baton = lock_baton;
+
   for (hi = apr_hash_first(pool, path_tokens); hi; hi = apr_hash_next(hi))
     {
-      const void *key;
-      const char *path;
-      void *val;
-      const char *abs_path, *token;
-      svn_error_t *err, *callback_err = NULL;
-
-      svn_pool_clear(iterpool);
-      apr_hash_this(hi, &key, NULL, &val);
-      path = key;
-      /* Since we can't store NULL values in a hash, we turn "" to
-         NULL here. */
-      if (strcmp(val, "") != 0)
-        token = val;
-      else
-        token = NULL;
-
-      abs_path = svn_dirent_join(sess->fs_path->data, path, iterpool);
-
-      /* This wrapper will call pre- and post-unlock hooks. */
-      err = svn_repos_fs_unlock(sess->repos, abs_path, token, force,
-                                iterpool);
-
-      if (err && !SVN_ERR_IS_UNLOCK_ERROR(err))
-        return err;
-
-      if (lock_func)
-        callback_err = lock_func(lock_baton, path, FALSE, NULL, err, iterpool);
-
-      svn_error_clear(err);
-
-      if (callback_err)
-        return callback_err;
+      const char *path = svn__apr_hash_index_key(hi);
+      const char *abs_path = svn_dirent_join(sess->fs_path->data, path,
+                                             pool);
+
+      /* Tokens stay as they are; "" stands for NULL here as well. */
+      apr_hash_set(targets, abs_path, APR_HASH_KEY_STRING,
+                   svn__apr_hash_index_val(hi));
+      apr_hash_set(b.rel_paths, abs_path, APR_HASH_KEY_STRING, path);
     }
 
-  svn_pool_destroy(iterpool);
-
-  return SVN_NO_ERROR;
+  /* This wrapper will call pre- and post-unlock hooks, and unlocks all
+     paths under a single FS write lock. */
+  return svn_repos__fs_unlock_many(sess->repos, targets, force,
+                                   lock_many_callback, &b, pool);
 }
 
 
@@ -1381,7 +1389,9 @@ svn_ra_local__has_capability(svn_ra_session_t *session,
   if (strcmp(capability, SVN_RA_CAPABILITY_DEPTH) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_LOG_REVPROPS) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_PARTIAL_REPLAY) == 0
-      || strcmp(capability, SVN_RA_CAPABILITY_COMMIT_REVPROPS) == 0)
+      || strcmp(capability, SVN_RA_CAPABILITY_COMMIT_REVPROPS) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_LARGE_DELTA_WINDOWS) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_FILE_BLAME) == 0)
     {
       *has = TRUE;
     }
@@ -1446,6 +1456,80 @@ svn_ra_local__obliterate_path_rev(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_ra__vtable_t.get_file_blame. */
+static svn_error_t *
+svn_ra_local__get_file_blame(svn_ra_session_t *session,
+                             const char *path,
+                             svn_revnum_t start,
+                             svn_revnum_t end,
+                             const apr_array_header_t *diff_options,
+                             svn_boolean_t ignore_mime_type,
+                             svn_blame_chunk_receiver_t receiver,
+                             void *receiver_baton,
+                             apr_pool_t *pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  const char *abs_path = svn_dirent_join(sess->fs_path->data, path, pool);
+  svn_diff_file_options_t *options = svn_diff_file_options_create(pool);
+
+  if (diff_options)
+    SVN_ERR(svn_diff_file_options_parse(options, diff_options, pool));
+
+  return svn_repos_get_file_blame(sess->repos, abs_path, start, end,
+                                  options, ignore_mime_type, NULL, NULL,
+                                  receiver, receiver_baton, pool);
+}
+
+/* Implements svn_ra__vtable_t.list. */
+static svn_error_t *
+svn_ra_local__list(svn_ra_session_t *session,
+                   const char *path,
+                   svn_revnum_t revision,
+                   svn_depth_t depth,
+                   apr_uint32_t dirent_fields,
+                   svn_ra_dirent_receiver_t receiver,
+                   void *receiver_baton,
+                   apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  const char *abs_path = svn_dirent_join(sess->fs_path->data, path,
+                                         scratch_pool);
+  svn_fs_root_t *root;
+
+  if (! SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(svn_fs_youngest_rev(&revision, sess->fs, scratch_pool));
+  SVN_ERR(svn_fs_revision_root(&root, sess->fs, revision, scratch_pool));
+
+  return svn_repos_list(root, abs_path, depth, dirent_fields, NULL, NULL,
+                        receiver, receiver_baton,
+                        sess->callbacks ? sess->callbacks->cancel_func : NULL,
+                        sess->callback_baton, scratch_pool);
+}
+
+/* Implements svn_ra__vtable_t.get_archive. */
+static svn_error_t *
+svn_ra_local__get_archive(svn_ra_session_t *session,
+                          const char *path,
+                          svn_revnum_t revision,
+                          const char *prefix,
+                          svn_stream_t *stream,
+                          apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  const char *abs_path = svn_dirent_join(sess->fs_path->data, path,
+                                         scratch_pool);
+  svn_fs_root_t *root;
+
+  if (! SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(svn_fs_youngest_rev(&revision, sess->fs, scratch_pool));
+  SVN_ERR(svn_fs_revision_root(&root, sess->fs, revision, scratch_pool));
+
+  return svn_repos_archive(root, abs_path, prefix, NULL, NULL, stream,
+                           sess->callbacks ? sess->callbacks->cancel_func
+                                           : NULL,
+                           sess->callback_baton, scratch_pool);
+}
+
 /*----------------------------------------------------------------*/
 
 static const svn_version_t *
@@ -1493,7 +1577,12 @@ static const svn_ra__vtable_t ra_local_vtable =
   svn_ra_local__has_capability,
   svn_ra_local__replay_range,
   svn_ra_local__get_deleted_rev,
-  svn_ra_local__obliterate_path_rev
+  svn_ra_local__obliterate_path_rev,
+  svn_ra_local__get_file_blame,
+  NULL, /* svn_ra_local__stat_many */
+  NULL, /* svn_ra_local__get_dir_many */
+  svn_ra_local__list,
+  svn_ra_local__get_archive
 };
 
 
@@ -153,7 +153,7 @@ svn_ra_local__split_URL(svn_repos_t **repos,
        _("Unable to open repository '%s'"), URL);
 
   /* Attempt to open a repository at URL. */
-  err = svn_repos_open(repos, repos_root, pool);
+  err = svn_repos_open2(repos, repos_root, NULL, pool);
   if (err)
     return svn_error_createf
       (SVN_ERR_RA_LOCAL_REPOS_OPEN_FAILED, err,
@@ -338,6 +338,14 @@ svn_ra_neon__has_capability(svn_ra_session_t *session,
       return SVN_NO_ERROR;
     }
 
+  /* The HTTP servers don't announce these, so play it safe. */
+  if (strcmp(capability, SVN_RA_CAPABILITY_LARGE_DELTA_WINDOWS) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_FILE_BLAME) == 0)
+    {
+      *has = FALSE;
+      return SVN_NO_ERROR;
+    }
+
  cap_result = apr_hash_get(ras->capabilities,
                            capability,
                            APR_HASH_KEY_STRING);
@@ -1203,7 +1203,12 @@ static const svn_ra__vtable_t neon_vtable = {
   svn_ra_neon__has_capability,
   svn_ra_neon__replay_range,
   svn_ra_neon__get_deleted_rev,
-  NULL  /* svn_ra_neon__obliterate_path_rev */
+  NULL, /* svn_ra_neon__obliterate_path_rev */
+  NULL, /* svn_ra_neon__get_file_blame */
+  NULL, /* svn_ra_neon__stat_many */
+  NULL, /* svn_ra_neon__get_dir_many */
+  NULL, /* svn_ra_neon__list */
+  NULL  /* svn_ra_neon__get_archive */
 };
 
 svn_error_t *
@@ -24,6 +24,7 @@
 
 
 #include <apr_uri.h>
+#include <apr_xml.h>
 
 #include <expat.h>
 
@@ -38,8 +39,10 @@
 #include "svn_delta.h"
 #include "svn_version.h"
 #include "svn_path.h"
+#include "svn_dirent_uri.h"
 #include "svn_time.h"
 #include "svn_private_config.h"
+#include "private/svn_dav_protocol.h"
 
 #include "ra_serf.h"
 
@@ -564,6 +567,320 @@ svn_ra_serf__get_lock(svn_ra_session_t *ra_session,
   return SVN_NO_ERROR;
 }
 
+/*** Locking and unlocking many paths in one request ***/
+
+/* Baton for the lock-many response parser. */
+typedef struct lock_many_ctx_t {
+  apr_pool_t *pool;
+
+  /* Whether we are locking, rather than unlocking. */
+  svn_boolean_t do_lock;
+
+  /* The comment of the new locks, which the server doesn't echo. */
+  const char *comment;
+
+  /* Maps the FS paths we asked for to the session relative paths. */
+  apr_hash_t *rel_paths;
+
+  svn_ra_lock_callback_t lock_func;
+  void *lock_baton;
+
+  /* The path and error code of the <S:failed> (path is NULL for
+     <S:error>) whose message we are collecting, if IN_ERROR. */
+  svn_boolean_t in_error;
+  const char *error_path;
+  apr_status_t error_code;
+  svn_stringbuf_t *error_msg;
+
+  /* What went wrong besides the single paths, if anything. */
+  svn_error_t *error;
+
+  svn_boolean_t read_headers;
+  int status_code;
+  const char *reason;
+
+  svn_boolean_t done;
+} lock_many_ctx_t;
+
+/* Return the session relative path for the FS path PATH in CTX. */
+static const char *
+lock_many_rel_path(lock_many_ctx_t *ctx, const char *path)
+{
+  const char *rel_path = apr_hash_get(ctx->rel_paths, path,
+                                      APR_HASH_KEY_STRING);
+
+  return rel_path ? rel_path : path;
+}
+
+/*
+ * Expat callback invoked on a start element tag for a lock-many response.
+ */
+static svn_error_t *
+start_lock_many(svn_ra_serf__xml_parser_t *parser,
+                void *userData,
+                svn_ra_serf__dav_props_t name,
+                const char **attrs)
+{
+  lock_many_ctx_t *ctx = userData;
+  const char *path = svn_xml_get_attr_value("path", attrs);
+
+  if (strcmp(name.name, "locked") == 0 && path)
+    {
+      svn_lock_t *lock = svn_lock_create(parser->pool);
+      const char *date;
+
+      lock->path = lock_many_rel_path(ctx, path);
+      lock->token = apr_pstrdup(parser->pool,
+                                svn_xml_get_attr_value("token", attrs));
+      lock->owner = apr_pstrdup(parser->pool,
+                                svn_xml_get_attr_value("owner", attrs));
+      lock->comment = ctx->comment;
+
+      date = svn_xml_get_attr_value("creationdate", attrs);
+      if (date)
+        SVN_ERR(svn_time_from_cstring(&lock->creation_date, date,
+                                      parser->pool));
+      date = svn_xml_get_attr_value("expirationdate", attrs);
+      if (date)
+        SVN_ERR(svn_time_from_cstring(&lock->expiration_date, date,
+                                      parser->pool));
+
+      if (ctx->lock_func)
+        SVN_ERR(ctx->lock_func(ctx->lock_baton, lock->path, TRUE, lock,
+                               NULL, parser->pool));
+    }
+  else if (strcmp(name.name, "unlocked") == 0 && path)
+    {
+      if (ctx->lock_func)
+        SVN_ERR(ctx->lock_func(ctx->lock_baton,
+                               lock_many_rel_path(ctx, path), FALSE,
+                               NULL, NULL, parser->pool));
+    }
+  else if (strcmp(name.name, "failed") == 0
+           || strcmp(name.name, "error") == 0)
+    {
+      const char *code = svn_xml_get_attr_value("code", attrs);
+
+      ctx->in_error = TRUE;
+      ctx->error_path = path ? apr_pstrdup(parser->pool, path) : NULL;
+      ctx->error_code = code ? atoi(code) : SVN_ERR_RA_DAV_REQUEST_FAILED;
+      ctx->error_msg = svn_stringbuf_create("", parser->pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/*
+ * Expat callback invoked on an end element tag for a lock-many response.
+ */
+static svn_error_t *
+end_lock_many(svn_ra_serf__xml_parser_t *parser,
+              void *userData,
+              svn_ra_serf__dav_props_t name)
+{
+  lock_many_ctx_t *ctx = userData;
+  svn_error_t *err;
+
+  if (! ctx->in_error
+      || (strcmp(name.name, "failed") != 0
+          && strcmp(name.name, "error") != 0))
+    return SVN_NO_ERROR;
+
+  ctx->in_error = FALSE;
+  err = svn_error_create(ctx->error_code, NULL, ctx->error_msg->data);
+
+  if (! ctx->error_path)
+    {
+      ctx->error = svn_error_compose_create(ctx->error, err);
+      return SVN_NO_ERROR;
+    }
+
+  if (ctx->lock_func)
+    {
+      svn_error_t *callback_err;
+
+      callback_err = ctx->lock_func(ctx->lock_baton,
+                                    lock_many_rel_path(ctx, ctx->error_path),
+                                    ctx->do_lock, NULL, err, parser->pool);
+      svn_error_clear(err);
+      return callback_err;
+    }
+
+  svn_error_clear(err);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+cdata_lock_many(svn_ra_serf__xml_parser_t *parser,
+                void *userData,
+                const char *data,
+                apr_size_t len)
+{
+  lock_many_ctx_t *ctx = userData;
+
+  if (ctx->in_error)
+    svn_stringbuf_appendbytes(ctx->error_msg, data, len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_serf__response_handler_t */
+static svn_error_t *
+handle_lock_many(serf_request_t *request,
+                 serf_bucket_t *response,
+                 void *handler_baton,
+                 apr_pool_t *pool)
+{
+  svn_ra_serf__xml_parser_t *xml_ctx = handler_baton;
+  lock_many_ctx_t *ctx = xml_ctx->user_data;
+
+  if (ctx->read_headers == FALSE)
+    {
+      serf_status_line sl;
+
+      serf_bucket_response_status(response, &sl);
+      ctx->status_code = sl.code;
+      ctx->reason = sl.reason;
+      ctx->read_headers = TRUE;
+    }
+
+  /* The server refused the request as a whole. */
+  if (ctx->status_code >= 400)
+    {
+      svn_error_t *err;
+
+      err = svn_ra_serf__handle_server_error(request, response, pool);
+      if (!err)
+        {
+          err = svn_error_createf(SVN_ERR_RA_DAV_REQUEST_FAILED, NULL,
+                                  ctx->do_lock
+                                    ? _("Lock request failed: %d %s")
+                                    : _("Unlock request failed: %d %s"),
+                                  ctx->status_code, ctx->reason);
+        }
+      return err;
+    }
+
+  return svn_ra_serf__handle_xml_parser(request, response,
+                                        handler_baton, pool);
+}
+
+/* Lock (if DO_LOCK) or unlock the paths in TARGETS, a hash mapping
+   session relative paths to svn_revnum_t * (when locking) or to
+   const char * lock tokens (when unlocking), in a single POST request
+   against SESSION's 'me' resource.  The other arguments are as for
+   svn_ra_serf__lock() or svn_ra_serf__unlock(). */
+static svn_error_t *
+lock_many(svn_ra_serf__session_t *session,
+          svn_boolean_t do_lock,
+          apr_hash_t *targets,
+          const char *comment,
+          svn_boolean_t force,
+          svn_ra_lock_callback_t lock_func,
+          void *lock_baton,
+          apr_pool_t *pool)
+{
+  lock_many_ctx_t *ctx;
+  svn_ra_serf__handler_t *handler;
+  svn_ra_serf__xml_parser_t *parser_ctx;
+  serf_bucket_t *buckets;
+  serf_bucket_alloc_t *alloc = session->bkt_alloc;
+  const char *session_path, *root_tag, *target_tag;
+  apr_hash_index_t *hi;
+  svn_error_t *err;
+
+  ctx = apr_pcalloc(pool, sizeof(*ctx));
+  ctx->pool = pool;
+  ctx->do_lock = do_lock;
+  ctx->comment = comment;
+  ctx->rel_paths = apr_hash_make(pool);
+  ctx->lock_func = lock_func;
+  ctx->lock_baton = lock_baton;
+
+  /* The server takes FS paths. */
+  SVN_ERR(svn_ra_serf__get_relative_path(&session_path,
+                                         session->repos_url.path,
+                                         session, NULL, pool));
+  session_path = svn_uri_join("/", session_path, pool);
+
+  root_tag = do_lock ? "S:lock-many" : "S:unlock-many";
+  target_tag = do_lock ? "S:lock-target" : "S:unlock-target";
+
+  buckets = serf_bucket_aggregate_create(alloc);
+
+  svn_ra_serf__add_xml_header_buckets(buckets, alloc);
+  svn_ra_serf__add_open_tag_buckets(buckets, alloc, root_tag,
+                                    "xmlns:S", SVN_XML_NAMESPACE,
+                                    do_lock ? "steal-lock" : "break-lock",
+                                    force ? "true" : NULL,
+                                    NULL);
+
+  if (do_lock && comment)
+    svn_ra_serf__add_tag_buckets(buckets, "S:comment", comment, alloc);
+
+  for (hi = apr_hash_first(pool, targets); hi; hi = apr_hash_next(hi))
+    {
+      const char *path = svn__apr_hash_index_key(hi);
+      const char *fs_path = svn_uri_join(session_path, path, pool);
+      const char *quoted_path = apr_xml_quote_string(pool, fs_path, 1);
+
+      apr_hash_set(ctx->rel_paths, fs_path, APR_HASH_KEY_STRING, path);
+
+      if (do_lock)
+        {
+          svn_revnum_t *revnum = svn__apr_hash_index_val(hi);
+
+          svn_ra_serf__add_open_tag_buckets(
+            buckets, alloc, target_tag,
+            "path", quoted_path,
+            "rev", SVN_IS_VALID_REVNUM(*revnum)
+                     ? apr_ltoa(pool, *revnum) : NULL,
+            NULL);
+        }
+      else
+        {
+          const char *token = svn__apr_hash_index_val(hi);
+
+          svn_ra_serf__add_open_tag_buckets(
+            buckets, alloc, target_tag,
+            "path", quoted_path,
+            "token", (token && *token)
+                       ? apr_xml_quote_string(pool, token, 1) : NULL,
+            NULL);
+        }
+      svn_ra_serf__add_close_tag_buckets(buckets, alloc, target_tag);
+    }
+
+  svn_ra_serf__add_close_tag_buckets(buckets, alloc, root_tag);
+
+  handler = apr_pcalloc(pool, sizeof(*handler));
+
+  handler->method = "POST";
+  handler->path = session->me_resource;
+  handler->body_buckets = buckets;
+  handler->body_type = SVN_DAV__LOCKS_MIME_TYPE;
+  handler->conn = session->conns[0];
+  handler->session = session;
+
+  parser_ctx = apr_pcalloc(pool, sizeof(*parser_ctx));
+
+  parser_ctx->pool = pool;
+  parser_ctx->user_data = ctx;
+  parser_ctx->start = start_lock_many;
+  parser_ctx->end = end_lock_many;
+  parser_ctx->cdata = cdata_lock_many;
+  parser_ctx->done = &ctx->done;
+
+  handler->response_handler = handle_lock_many;
+  handler->response_baton = parser_ctx;
+
+  svn_ra_serf__request_create(handler);
+  err = svn_ra_serf__context_run_wait(&ctx->done, session, pool);
+
+  return svn_error_compose_create(err, ctx->error);
+}
+
+
 svn_error_t *
 svn_ra_serf__lock(svn_ra_session_t *ra_session,
                   apr_hash_t *path_revs,
@@ -577,6 +894,12 @@ svn_ra_serf__lock(svn_ra_session_t *ra_session,
   apr_hash_index_t *hi;
   apr_pool_t *subpool;
 
+  /* Newer servers lock all paths at once, running the post-lock hook
+     just once. */
+  if (session->lock_many && SVN_RA_SERF__HAVE_HTTPV2_SUPPORT(session))
+    return lock_many(session, TRUE, path_revs, comment, force,
+                     lock_func, lock_baton, pool);
+
   subpool = svn_pool_create(pool);
 
   for (hi = apr_hash_first(pool, path_revs); hi; hi = apr_hash_next(hi))
@@ -679,6 +1002,12 @@ svn_ra_serf__unlock(svn_ra_session_t *ra_session,
   apr_hash_index_t *hi;
   apr_pool_t *subpool;
 
+  /* Newer servers unlock all paths at once, and find the tokens of the
+     locks to break themselves. */
+  if (session->lock_many && SVN_RA_SERF__HAVE_HTTPV2_SUPPORT(session))
+    return lock_many(session, FALSE, path_tokens, NULL, force,
+                     lock_func, lock_baton, pool);
+
   subpool = svn_pool_create(pool);
 
   for (hi = apr_hash_first(pool, path_tokens); hi; hi = apr_hash_next(hi))
@@ -68,9 +68,10 @@ typedef enum {
 typedef struct {
   apr_pool_t *pool;
 
-  /* The currently collected value as we build it up */
-  const char *tmp;
-  apr_size_t tmp_len;
+  /* The currently collected value as we build it up, emptied whenever
+     an element's value has been consumed so that the buffer is reused
+     for the rest of the item. */
+  svn_stringbuf_t *tmp;
 
   /* Temporary change path - ultimately inserted into changed_paths hash. */
   svn_log_changed_path2_t *tmp_path;
@@ -119,6 +120,7 @@ push_state(svn_ra_serf__xml_parser_t *parser,
 
       info = apr_pcalloc(parser->state->pool, sizeof(*info));
       info->log_entry = svn_log_entry_create(parser->state->pool);
+      info->tmp = svn_stringbuf_create("", parser->state->pool);
 
       info->pool = parser->state->pool;
       info->log_entry->revision = SVN_INVALID_REVNUM;
@@ -338,8 +340,8 @@ end_log(svn_ra_serf__xml_parser_t *parser,
   else if (state == VERSION &&
            strcmp(name.name, SVN_DAV__VERSION_NAME) == 0)
     {
-      info->log_entry->revision = SVN_STR_TO_REV(info->tmp);
-      info->tmp_len = 0;
+      info->log_entry->revision = SVN_STR_TO_REV(info->tmp->data);
+      svn_stringbuf_setempty(info->tmp);
       svn_ra_serf__xml_pop_state(parser);
     }
   else if (state == CREATOR &&
@@ -349,10 +351,10 @@ end_log(svn_ra_serf__xml_parser_t *parser,
         {
           apr_hash_set(info->log_entry->revprops, SVN_PROP_REVISION_AUTHOR,
                        APR_HASH_KEY_STRING,
-                       svn_string_ncreate(info->tmp, info->tmp_len,
+                       svn_string_ncreate(info->tmp->data, info->tmp->len,
                                           info->pool));
         }
-      info->tmp_len = 0;
+      svn_stringbuf_setempty(info->tmp);
       svn_ra_serf__xml_pop_state(parser);
     }
   else if (state == DATE &&
@@ -362,10 +364,10 @@ end_log(svn_ra_serf__xml_parser_t *parser,
         {
           apr_hash_set(info->log_entry->revprops, SVN_PROP_REVISION_DATE,
                        APR_HASH_KEY_STRING,
-                       svn_string_ncreate(info->tmp, info->tmp_len,
+                       svn_string_ncreate(info->tmp->data, info->tmp->len,
                                           info->pool));
         }
-      info->tmp_len = 0;
+      svn_stringbuf_setempty(info->tmp);
       svn_ra_serf__xml_pop_state(parser);
     }
   else if (state == COMMENT &&
@@ -375,18 +377,19 @@ end_log(svn_ra_serf__xml_parser_t *parser,
         {
           apr_hash_set(info->log_entry->revprops, SVN_PROP_REVISION_LOG,
                        APR_HASH_KEY_STRING,
-                       svn_string_ncreate(info->tmp, info->tmp_len,
+                       svn_string_ncreate(info->tmp->data, info->tmp->len,
                                           info->pool));
         }
-      info->tmp_len = 0;
+      svn_stringbuf_setempty(info->tmp);
       svn_ra_serf__xml_pop_state(parser);
     }
   else if (state == REVPROP)
     {
       apr_hash_set(info->log_entry->revprops, info->revprop_name,
                    APR_HASH_KEY_STRING,
-                   svn_string_ncreate(info->tmp, info->tmp_len, info->pool));
-      info->tmp_len = 0;
+                   svn_string_ncreate(info->tmp->data, info->tmp->len,
+                                      info->pool));
+      svn_stringbuf_setempty(info->tmp);
       svn_ra_serf__xml_pop_state(parser);
     }
   else if (state == HAS_CHILDREN &&
@@ -406,8 +409,8 @@ end_log(svn_ra_serf__xml_parser_t *parser,
     {
       char *path;
 
-      path = apr_pstrmemdup(info->pool, info->tmp, info->tmp_len);
-      info->tmp_len = 0;
+      path = apr_pstrmemdup(info->pool, info->tmp->data, info->tmp->len);
+      svn_stringbuf_setempty(info->tmp);
 
       apr_hash_set(info->log_entry->changed_paths2, path, APR_HASH_KEY_STRING,
                    info->tmp_path);
@@ -443,8 +446,7 @@ cdata_log(svn_ra_serf__xml_parser_t *parser,
       case REPLACED_PATH:
       case DELETED_PATH:
       case MODIFIED_PATH:
-        svn_ra_serf__expand_string(&info->tmp, &info->tmp_len,
-                                   data, len, parser->state->pool);
+        svn_stringbuf_appendbytes(info->tmp, data, len);
         break;
       default:
         break;
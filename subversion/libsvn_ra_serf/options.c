@@ -317,6 +317,14 @@ capabilities_headers_iterator_callback(void *baton,
                        SVN_RA_CAPABILITY_PARTIAL_REPLAY,
                        APR_HASH_KEY_STRING, capability_yes);
         }
+      if (svn_cstring_match_glob_list(SVN_DAV_NS_DAV_SVN_BINARY_UPDATE, vals))
+        {
+          orc->session->binary_updates = TRUE;
+        }
+      if (svn_cstring_match_glob_list(SVN_DAV_NS_DAV_SVN_LOCK_MANY, vals))
+        {
+          orc->session->lock_many = TRUE;
+        }
     }
 
   /* SVN-specific headers -- if present, server supports HTTP protocol v2 */
@@ -509,6 +517,14 @@ svn_ra_serf__has_capability(svn_ra_session_t *ra_session,
       return SVN_NO_ERROR;
     }
 
+  /* The HTTP servers don't announce these, so play it safe. */
+  if (strcmp(capability, SVN_RA_CAPABILITY_LARGE_DELTA_WINDOWS) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_FILE_BLAME) == 0)
+    {
+      *has = FALSE;
+      return SVN_NO_ERROR;
+    }
+
   cap_result = apr_hash_get(serf_sess->capabilities,
                             capability,
                             APR_HASH_KEY_STRING);
@@ -203,6 +203,12 @@ struct svn_ra_serf__session_t {
      constants' addresses, therefore). */
   apr_hash_t *capabilities;
 
+  /* Can the server send update reports in the binary encoding? */
+  svn_boolean_t binary_updates;
+
+  /* Can the server lock and unlock many paths in one request? */
+  svn_boolean_t lock_many;
+
   /* Are we using a proxy? */
   int using_proxy;
 
@@ -225,6 +231,19 @@ struct svn_ra_serf__session_t {
   /* Connection timeout value */
   long timeout;
 
+  /* The most connections to open, including the main one, and the number
+     of outstanding requests per connection it takes to open another one
+     while fetching files for an update. */
+  int max_connections;
+  int reqs_per_conn;
+
+  /* The number of times the server answered a GET with 503 (Service
+     Unavailable) and the request was sent again. */
+  int busy_responses;
+
+  /* The number of bytes read from all connections so far. */
+  apr_off_t bytes_read;
+
   /*** HTTP v2 protocol stuff. ***
    *
    * We assume that if mod_dav_svn sends one of the special v2 OPTIONs
@@ -532,6 +551,12 @@ typedef struct {
 
   /* Marks whether a snapshot was set on the body bucket. */
   svn_boolean_t body_snapshot_set;
+
+  /* The number of times a GET was sent again after a 503 response. */
+  int busy_retries;
+
+  /* When the request was last set up, for tracing; 0 if not traced. */
+  apr_time_t trace_start;
 } svn_ra_serf__handler_t;
 
 /*
@@ -130,6 +130,41 @@ load_http_auth_types(apr_pool_t *pool, svn_config_t *config,
   return SVN_NO_ERROR;
 }
 #define DEFAULT_HTTP_TIMEOUT 3600
+#define DEFAULT_MAX_CONNECTIONS 4
+#define DEFAULT_REQS_PER_CONN 8
+
+/* The most connections we let http-max-connections ask for. */
+#define MAX_CONNECTIONS_LIMIT 32
+
+/* Set *VALUE to the positive number STR, which is the value of the
+   config option OPTION, or to DEFAULT_VALUE if STR is NULL.  Values
+   above MAX_VALUE are clamped to it. */
+static svn_error_t *
+parse_positive_int(int *value,
+                   const char *str,
+                   const char *option,
+                   int default_value,
+                   int max_value)
+{
+  char *endstr;
+  long int val;
+
+  if (! str)
+    {
+      *value = default_value;
+      return SVN_NO_ERROR;
+    }
+
+  val = strtol(str, &endstr, 10);
+  if (*endstr || val < 1)
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("Invalid config: '%s' must be a positive "
+                               "number"), option);
+
+  *value = (val > max_value) ? max_value : (int) val;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 load_config(svn_ra_serf__session_t *session,
             apr_hash_t *config_hash,
@@ -140,6 +175,8 @@ load_config(svn_ra_serf__session_t *session,
   const char *proxy_host = NULL;
   const char *port_str = NULL;
   const char *timeout_str = NULL;
+  const char *max_conns_str = NULL;
+  const char *reqs_per_conn_str = NULL;
   const char *exceptions;
   unsigned int proxy_port;
   svn_boolean_t is_exception = FALSE;
@@ -162,6 +199,10 @@ load_config(svn_ra_serf__session_t *session,
                               SVN_CONFIG_OPTION_HTTP_COMPRESSION, TRUE));
   svn_config_get(config, &timeout_str, SVN_CONFIG_SECTION_GLOBAL,
                  SVN_CONFIG_OPTION_HTTP_TIMEOUT, NULL);
+  svn_config_get(config, &max_conns_str, SVN_CONFIG_SECTION_GLOBAL,
+                 SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS, NULL);
+  svn_config_get(config, &reqs_per_conn_str, SVN_CONFIG_SECTION_GLOBAL,
+                 SVN_CONFIG_OPTION_HTTP_REQS_PER_CONNECTION, NULL);
 
   if (session->wc_callbacks->auth_baton)
     {
@@ -226,6 +267,11 @@ load_config(svn_ra_serf__session_t *session,
                                   session->using_compression));
       svn_config_get(config, &timeout_str, server_group,
                      SVN_CONFIG_OPTION_HTTP_TIMEOUT, timeout_str);
+      svn_config_get(config, &max_conns_str, server_group,
+                     SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS, max_conns_str);
+      svn_config_get(config, &reqs_per_conn_str, server_group,
+                     SVN_CONFIG_OPTION_HTTP_REQS_PER_CONNECTION,
+                     reqs_per_conn_str);
 
       svn_auth_set_parameter(session->wc_callbacks->auth_baton,
                              SVN_AUTH_PARAM_SERVER_GROUP, server_group);
@@ -267,6 +313,13 @@ load_config(svn_ra_serf__session_t *session,
   else
     session->timeout = apr_time_from_sec(DEFAULT_HTTP_TIMEOUT);
 
+  SVN_ERR(parse_positive_int(&session->max_connections, max_conns_str,
+                             SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS,
+                             DEFAULT_MAX_CONNECTIONS, MAX_CONNECTIONS_LIMIT));
+  SVN_ERR(parse_positive_int(&session->reqs_per_conn, reqs_per_conn_str,
+                             SVN_CONFIG_OPTION_HTTP_REQS_PER_CONNECTION,
+                             DEFAULT_REQS_PER_CONN, APR_INT32_MAX));
+
   /* Convert the proxy port value, if any. */
   if (port_str)
     {
@@ -316,11 +369,16 @@ load_config(svn_ra_serf__session_t *session,
   return SVN_NO_ERROR;
 }
 #undef DEFAULT_HTTP_TIMEOUT
+#undef DEFAULT_MAX_CONNECTIONS
+#undef DEFAULT_REQS_PER_CONN
+#undef MAX_CONNECTIONS_LIMIT
 
 static void
 svn_ra_serf__progress(void *progress_baton, apr_off_t read, apr_off_t written)
 {
-  const svn_ra_serf__session_t *serf_sess = progress_baton;
+  svn_ra_serf__session_t *serf_sess = progress_baton;
+
+  serf_sess->bytes_read = read;
   if (serf_sess->wc_progress_func)
     {
       serf_sess->wc_progress_func(read + written, -1,
@@ -383,7 +441,9 @@ svn_ra_serf__open(svn_ra_session_t *session,
                             svn_ra_serf__cleanup_serf_session,
                             apr_pool_cleanup_null);
 
-  serf_sess->conns = apr_palloc(serf_sess->pool, sizeof(*serf_sess->conns) * 4);
+  serf_sess->conns = apr_palloc(serf_sess->pool,
+                                sizeof(*serf_sess->conns)
+                                  * serf_sess->max_connections);
 
   serf_sess->conns[0] = apr_pcalloc(serf_sess->pool,
                                     sizeof(*serf_sess->conns[0]));
@@ -882,7 +942,9 @@ svn_ra_serf__get_dir(svn_ra_session_t *ra_session,
       revision = SVN_INVALID_REVNUM;
     }
 
-  /* If we're asked for children, fetch them now. */
+  /* If we're asked for children, fetch them now.  The Depth: 1 response
+     describes the directory itself as well, so it also provides the
+     directory properties if those are wanted. */
   if (dirents)
     {
       struct path_dirent_visitor_t dirent_walk;
@@ -894,6 +956,14 @@ svn_ra_serf__get_dir(svn_ra_session_t *ra_session,
       /* Check if the path is really a directory. */
       SVN_ERR(resource_is_directory (props, path, revision));
 
+      if (ret_props)
+        {
+          *ret_props = apr_hash_make(pool);
+          svn_ra_serf__walk_all_props(props, path, revision,
+                                      svn_ra_serf__set_flat_props,
+                                      *ret_props, pool);
+        }
+
       /* We're going to create two hashes to help the walker along.
        * We're going to return the 2nd one back to the caller as it
        * will have the basenames it expects.
@@ -908,8 +978,8 @@ svn_ra_serf__get_dir(svn_ra_session_t *ra_session,
       *dirents = dirent_walk.base_paths;
     }
 
-  /* If we're asked for the directory properties, fetch them too. */
-  if (ret_props)
+  /* If we're asked for the directory properties only, fetch them now. */
+  else if (ret_props)
     {
       props = apr_hash_make(pool);
       *ret_props = apr_hash_make(pool);
@@ -1023,7 +1093,12 @@ static const svn_ra__vtable_t serf_vtable = {
   svn_ra_serf__has_capability,
   svn_ra_serf__replay_range,
   svn_ra_serf__get_deleted_rev,
-  NULL  /* svn_ra_serf__obliterate_path_rev */
+  NULL, /* svn_ra_serf__obliterate_path_rev */
+  NULL, /* svn_ra_serf__get_file_blame */
+  NULL, /* svn_ra_serf__stat_many */
+  NULL, /* svn_ra_serf__get_dir_many */
+  NULL, /* svn_ra_serf__list */
+  NULL  /* svn_ra_serf__get_archive */
 };
 
 svn_error_t *
@@ -42,6 +42,7 @@
 #include "svn_path.h"
 #include "svn_base64.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 
 #include "svn_private_config.h"
 
@@ -204,6 +205,10 @@ typedef struct report_info_t
   /* Has the server told us to go fetch - only valid if we had it already */
   svn_boolean_t fetch_file;
 
+  /* The new contents of this file, if the client already had them and we
+     don't need to GET them. */
+  svn_stream_t *cached_contents;
+
   /* The properties for this file */
   apr_hash_t *props;
 
@@ -221,9 +226,14 @@ typedef struct report_info_t
    */
   const char *prop_ns;
   const char *prop_name;
-  const char *prop_val;
-  apr_size_t prop_val_len;
   const char *prop_encoding;
+
+  /* The value of that property as received so far, and, if it is
+   * base64-encoded, the stream that decodes the cdata into PROP_VAL as it
+   * arrives, so that the encoded form is never held in full.
+   */
+  svn_stringbuf_t *prop_val;
+  svn_stream_t *prop_stream;
 } report_info_t;
 
 /*
@@ -301,6 +311,9 @@ struct report_context_t {
   /* Do we want the server to send copyfrom args or not? */
   svn_boolean_t send_copyfrom_args;
 
+  /* Did we ask for the report in the binary encoding? */
+  svn_boolean_t binary;
+
   /* Path -> lock token mapping. */
   apr_hash_t *lock_path_tokens;
 
@@ -335,6 +348,26 @@ struct report_context_t {
   /* Are we done parsing the REPORT response? */
   svn_boolean_t done;
 
+  /* The number of connections, including the main one, that requests for
+     files get spread across.  adjust_fetch_connections() moves it between
+     2 and the session's max_connections. */
+  int target_conns;
+
+  /* The throughput measured over the last interval, in bytes per
+     microsecond, and when the current one started and how many bytes
+     the session had read by then. */
+  double last_rate;
+  apr_time_t sample_start;
+  apr_off_t sample_bytes;
+
+  /* Set if TARGET_CONNS was raised at the start of the current interval,
+     to see whether that pays off.  It may not be raised again before
+     GROW_BLOCKED_UNTIL. */
+  svn_boolean_t probing;
+  apr_time_t grow_blocked_until;
+
+  /* The session's busy_responses when we last looked. */
+  int seen_busy_responses;
 };
 
 
@@ -426,6 +459,26 @@ push_state(svn_ra_serf__xml_parser_t *parser,
   return parser->state->private;
 }
 
+/* Prepare INFO to collect the value of a property whose cdata is in
+ * ENCODING (NULL if none), allocating in POOL, the pool of the parser
+ * state that ends with the property.
+ */
+static void
+start_prop_val(report_info_t *info,
+               const char *encoding,
+               apr_pool_t *pool)
+{
+  info->prop_encoding = encoding;
+  info->prop_val = svn_stringbuf_create("", pool);
+
+  if (encoding && strcmp(encoding, "base64") == 0)
+    info->prop_stream =
+      svn_base64_decode(svn_stream_from_stringbuf(info->prop_val, pool),
+                        pool);
+  else
+    info->prop_stream = NULL;
+}
+
 
 /** Wrappers around our various property walkers **/
 
@@ -808,9 +861,9 @@ handle_fetch(serf_request_t *request,
       if (val && svn_cstring_casecmp(val, "application/vnd.svn-svndiff") == 0)
         {
           fetch_ctx->delta_stream =
-              svn_txdelta_parse_svndiff(info->textdelta,
-                                        info->textdelta_baton,
-                                        TRUE, info->editor_pool);
+              svn_txdelta_parse_svndiff2(info->textdelta,
+                                         info->textdelta_baton,
+                                         TRUE, TRUE, info->editor_pool);
         }
       else
         {
@@ -1096,6 +1149,16 @@ handle_propchange_only(report_info_t *info)
                                                     info->editor_pool,
                                                     &info->textdelta,
                                                     &info->textdelta_baton));
+
+      if (info->cached_contents)
+        {
+          SVN_ERR(svn_txdelta_send_stream(info->cached_contents,
+                                          info->textdelta,
+                                          info->textdelta_baton,
+                                          NULL, info->editor_pool));
+          SVN_ERR(svn_stream_close(info->cached_contents));
+          info->cached_contents = NULL;
+        }
     }
 
   if (info->lock_token)
@@ -1161,10 +1224,45 @@ fetch_file(report_context_t *ctx, report_info_t *info)
       ctx->active_propfinds++;
     }
 
+  /* If the client already has the new text (e.g. as a pristine of
+   * another file), send it from there instead of fetching it.
+   */
+  info->cached_contents = NULL;
+  if (info->fetch_file && ctx->text_deltas
+      && ctx->sess->wc_callbacks->get_wc_contents)
+    {
+      const char *md5_hex;
+
+      md5_hex = svn_ra_serf__get_ver_prop(info->props, info->base_name,
+                                          info->base_rev,
+                                          SVN_DAV_PROP_NS_DAV,
+                                          "md5-checksum");
+      if (md5_hex)
+        {
+          svn_checksum_t *checksum;
+          svn_error_t *err;
+
+          err = svn_checksum_parse_hex(&checksum, svn_checksum_md5,
+                                       md5_hex, info->pool);
+          if (!err && checksum)
+            err = ctx->sess->wc_callbacks->get_wc_contents(
+                                              ctx->sess->wc_callback_baton,
+                                              &info->cached_contents,
+                                              checksum, info->pool);
+
+          /* Any problem here just means we fetch the text as usual. */
+          if (err)
+            {
+              svn_error_clear(err);
+              info->cached_contents = NULL;
+            }
+        }
+    }
+
   /* If we've been asked to fetch the file or its an add, do so.
    * Otherwise, handle the case where only the properties changed.
    */
-  if (info->fetch_file && ctx->text_deltas)
+  if (info->fetch_file && ctx->text_deltas && !info->cached_contents)
     {
       report_fetch_t *fetch_ctx;
 
@@ -1515,9 +1613,7 @@ start_report(svn_ra_serf__xml_parser_t *parser,
           info = push_state(parser, ctx, IGNORE_PROP_NAME);
           info->prop_ns = name.namespace;
           info->prop_name = apr_pstrdup(parser->state->pool, name.name);
-          info->prop_encoding = NULL;
-          info->prop_val = NULL;
-          info->prop_val_len = 0;
+          start_prop_val(info, NULL, parser->state->pool);
         }
       else if (strcmp(name.name, "set-prop") == 0 ||
                strcmp(name.name, "remove-prop") == 0)
@@ -1545,9 +1641,8 @@ start_report(svn_ra_serf__xml_parser_t *parser,
           info->prop_ns = apr_pstrmemdup(info->dir->pool, full_prop_name,
                                          colon - full_prop_name);
           info->prop_name = apr_pstrdup(parser->state->pool, colon);
-          info->prop_encoding = svn_xml_get_attr_value("encoding", attrs);
-          info->prop_val = NULL;
-          info->prop_val_len = 0;
+          start_prop_val(info, svn_xml_get_attr_value("encoding", attrs),
+                         parser->state->pool);
         }
       else if (strcmp(name.name, "prop") == 0)
         {
@@ -1575,9 +1670,7 @@ start_report(svn_ra_serf__xml_parser_t *parser,
           info = push_state(parser, ctx, IGNORE_PROP_NAME);
           info->prop_ns = name.namespace;
           info->prop_name = apr_pstrdup(parser->state->pool, name.name);
-          info->prop_encoding = NULL;
-          info->prop_val = NULL;
-          info->prop_val_len = 0;
+          start_prop_val(info, NULL, parser->state->pool);
         }
       else if (strcmp(name.name, "prop") == 0)
         {
@@ -1626,9 +1719,8 @@ start_report(svn_ra_serf__xml_parser_t *parser,
           info->prop_ns = apr_pstrmemdup(info->dir->pool, full_prop_name,
                                          colon - full_prop_name);
           info->prop_name = apr_pstrdup(parser->state->pool, colon);
-          info->prop_encoding = svn_xml_get_attr_value("encoding", attrs);
-          info->prop_val = NULL;
-          info->prop_val_len = 0;
+          start_prop_val(info, svn_xml_get_attr_value("encoding", attrs),
+                         parser->state->pool);
         }
       else
         {
@@ -1647,8 +1739,7 @@ start_report(svn_ra_serf__xml_parser_t *parser,
 
       info->prop_ns = name.namespace;
       info->prop_name = apr_pstrdup(parser->state->pool, name.name);
-      info->prop_val = NULL;
-      info->prop_val_len = 0;
+      start_prop_val(info, info->prop_encoding, parser->state->pool);
     }
 
   return SVN_NO_ERROR;
@@ -1925,47 +2016,36 @@ end_report(svn_ra_serf__xml_parser_t *parser,
           dir->ns_list = ns;
         }
 
+      if (info->prop_stream)
+        {
+          /* Flush whatever the decoder still holds. */
+          SVN_ERR(svn_stream_close(info->prop_stream));
+          info->prop_stream = NULL;
+        }
+      else if (info->prop_encoding)
+        {
+          return svn_error_createf(SVN_ERR_RA_DAV_MALFORMED_DATA,
+                                   NULL,
+                                   _("Got unrecognized encoding '%s'"),
+                                   info->prop_encoding);
+        }
+
       if (strcmp(name.name, "remove-prop") != 0)
         {
           props = info->props;
           pool = info->pool;
+          set_val = apr_pmemdup(pool, info->prop_val->data,
+                                info->prop_val->len);
+          set_val_str = svn_string_ncreate(set_val, info->prop_val->len,
+                                           pool);
         }
       else
         {
           props = dir->removed_props;
           pool = dir->pool;
-          info->prop_val = "";
-          info->prop_val_len = 1;
+          set_val_str = svn_string_ncreate("", 1, pool);
         }
 
-      if (info->prop_encoding)
-        {
-          if (strcmp(info->prop_encoding, "base64") == 0)
-            {
-              svn_string_t encoded;
-              const svn_string_t *decoded;
-
-              encoded.data = info->prop_val;
-              encoded.len = info->prop_val_len;
-
-              decoded = svn_base64_decode_string(&encoded, parser->state->pool);
-
-              info->prop_val = decoded->data;
-              info->prop_val_len = decoded->len;
-            }
-          else
-            {
-              return svn_error_createf(SVN_ERR_RA_DAV_MALFORMED_DATA,
-                                       NULL,
-                                       _("Got unrecognized encoding '%s'"),
-                                       info->prop_encoding);
-            }
-
-        }
-
-      set_val = apr_pmemdup(pool, info->prop_val, info->prop_val_len);
-      set_val_str = svn_string_ncreate(set_val, info->prop_val_len, pool);
-
       svn_ra_serf__set_ver_prop(props, info->base_name, info->base_rev,
                                 ns->namespace, ns->url, set_val_str, pool);
       svn_ra_serf__xml_pop_state(parser);
@@ -1992,13 +2072,462 @@ cdata_report(svn_ra_serf__xml_parser_t *parser,
     {
       report_info_t *info = parser->state->private;
 
-      svn_ra_serf__expand_string(&info->prop_val, &info->prop_val_len,
-                                 data, len, parser->state->pool);
+      if (info->prop_stream)
+        SVN_ERR(svn_stream_write(info->prop_stream, data, &len));
+      else
+        svn_stringbuf_appendbytes(info->prop_val, data, len);
     }
 
   return SVN_NO_ERROR;
 }
 
+
+/** Reading a report in the binary encoding **/
+
+/* A directory or file that is open while reading a binary report. */
+typedef struct bin_node_t
+{
+  /* The directory we're in, or NULL for the root. */
+  struct bin_node_t *parent;
+
+  svn_boolean_t is_dir;
+
+  /* Our path relative to the root of the edit, and our editor baton. */
+  const char *path;
+  void *baton;
+
+  /* Lives until we close the node. */
+  apr_pool_t *pool;
+} bin_node_t;
+
+/* The state of reading the response to a REPORT that asked for the
+   binary encoding. */
+typedef struct bin_report_t
+{
+  report_context_t *report;
+
+  /* Reads the response instead if the server sent XML after all. */
+  svn_ra_serf__xml_parser_t *parser_ctx;
+
+  /* Did we look at the response headers yet, and did they say the
+     response is binary? */
+  svn_boolean_t read_headers;
+  svn_boolean_t is_binary;
+
+  /* What we read of the response beyond the last complete record. */
+  svn_stringbuf_t *buf;
+
+  /* The innermost open node, or NULL if none. */
+  bin_node_t *node;
+
+  /* The svndiff parser of the text delta being received, if any. */
+  svn_stream_t *delta_stream;
+
+  /* Did we see the end of the edit? */
+  svn_boolean_t closed;
+
+  /* For allocations that last for one record only. */
+  apr_pool_t *scratch_pool;
+} bin_report_t;
+
+/* Return the 4-byte big-endian number at DATA. */
+static apr_size_t
+decode_length(const char *data)
+{
+  const unsigned char *p = (const unsigned char *)data;
+
+  return ((apr_size_t)p[0] << 24) | ((apr_size_t)p[1] << 16)
+         | ((apr_size_t)p[2] << 8) | (apr_size_t)p[3];
+}
+
+static svn_error_t *
+malformed_record(char code)
+{
+  return svn_error_createf(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                           _("Malformed '%c' record in update report"),
+                           code);
+}
+
+/* Set *FIELDS to the fields of the record with code CODE whose LEN bytes
+   of payload are at DATA, as an array of svn_string_t *.  Allocate in
+   POOL. */
+static svn_error_t *
+parse_fields(apr_array_header_t **fields,
+             char code,
+             const char *data,
+             apr_size_t len,
+             apr_pool_t *pool)
+{
+  *fields = apr_array_make(pool, 3, sizeof(svn_string_t *));
+
+  while (len > 0)
+    {
+      apr_size_t field_len;
+
+      if (len < 4)
+        return malformed_record(code);
+
+      field_len = decode_length(data);
+      if (field_len > len - 4)
+        return malformed_record(code);
+
+      APR_ARRAY_PUSH(*fields, svn_string_t *)
+        = svn_string_ncreate(data + 4, field_len, pool);
+      data += 4 + field_len;
+      len -= 4 + field_len;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#define FIELD(fields, i) (APR_ARRAY_IDX(fields, i, svn_string_t *)->data)
+
+/* Open a node called NAME in the innermost open directory of BIN and
+   make it the innermost node. */
+static bin_node_t *
+push_node(bin_report_t *bin, svn_boolean_t is_dir, const char *name)
+{
+  apr_pool_t *pool = svn_pool_create(bin->node->pool);
+  bin_node_t *node = apr_pcalloc(pool, sizeof(*node));
+
+  node->parent = bin->node;
+  node->is_dir = is_dir;
+  node->path = svn_relpath_join(bin->node->path, name, pool);
+  node->pool = pool;
+
+  bin->node = node;
+  return node;
+}
+
+/* Forget the innermost node of BIN, whose editor baton is closed. */
+static void
+pop_node(bin_report_t *bin)
+{
+  bin_node_t *node = bin->node;
+
+  bin->node = node->parent;
+  svn_pool_destroy(node->pool);
+}
+
+/* Drive the update editor of BIN as the record with code CODE, whose LEN
+   bytes of payload are at DATA, says. */
+static svn_error_t *
+process_record(bin_report_t *bin,
+               char code,
+               const char *data,
+               apr_size_t len)
+{
+  report_context_t *report = bin->report;
+  const svn_delta_editor_t *editor = report->update_editor;
+  apr_pool_t *pool = bin->scratch_pool;
+  bin_node_t *node = bin->node;
+  apr_array_header_t *fields;
+  svn_boolean_t in_dir = (node && node->is_dir);
+  svn_boolean_t in_file = (node && ! node->is_dir && ! bin->delta_stream);
+
+  /* The text delta data is the only thing that's not made of fields. */
+  if (code == SVN_DAV__BIN_SVNDIFF_CHUNK)
+    {
+      if (! bin->delta_stream)
+        return malformed_record(code);
+
+      return svn_stream_write(bin->delta_stream, data, &len);
+    }
+
+  SVN_ERR(parse_fields(&fields, code, data, len, pool));
+
+  switch (code)
+    {
+      case SVN_DAV__BIN_TARGET_REVISION:
+        if (fields->nelts < 1)
+          return malformed_record(code);
+        return editor->set_target_revision(report->update_baton,
+                                           SVN_STR_TO_REV(FIELD(fields, 0)),
+                                           pool);
+
+      case SVN_DAV__BIN_OPEN_ROOT:
+        if (node || bin->closed || fields->nelts < 1)
+          return malformed_record(code);
+
+        node = apr_pcalloc(report->pool, sizeof(*node));
+        node->is_dir = TRUE;
+        node->path = "";
+        node->pool = svn_pool_create(report->pool);
+        bin->node = node;
+
+        if (report->destination &&
+            report->sess->wc_callbacks->invalidate_wc_props)
+          {
+            SVN_ERR(report->sess->wc_callbacks->invalidate_wc_props(
+                        report->sess->wc_callback_baton,
+                        report->update_target,
+                        SVN_RA_SERF__WC_CHECKED_IN_URL, pool));
+          }
+
+        return editor->open_root(report->update_baton,
+                                 SVN_STR_TO_REV(FIELD(fields, 0)),
+                                 node->pool, &node->baton);
+
+      case SVN_DAV__BIN_ADD_DIR:
+      case SVN_DAV__BIN_ADD_FILE:
+        {
+          svn_boolean_t is_dir = (code == SVN_DAV__BIN_ADD_DIR);
+          const char *copyfrom_path = NULL;
+          svn_revnum_t copyfrom_rev = SVN_INVALID_REVNUM;
+
+          if (! in_dir || fields->nelts < 1)
+            return malformed_record(code);
+
+          if (fields->nelts >= 3)
+            {
+              copyfrom_path = FIELD(fields, 1);
+              copyfrom_rev = SVN_STR_TO_REV(FIELD(fields, 2));
+            }
+
+          node = push_node(bin, is_dir, FIELD(fields, 0));
+          if (is_dir)
+            return editor->add_directory(node->path, node->parent->baton,
+                                         copyfrom_path, copyfrom_rev,
+                                         node->pool, &node->baton);
+          else
+            return editor->add_file(node->path, node->parent->baton,
+                                    copyfrom_path, copyfrom_rev,
+                                    node->pool, &node->baton);
+        }
+
+      case SVN_DAV__BIN_OPEN_DIR:
+      case SVN_DAV__BIN_OPEN_FILE:
+        {
+          svn_boolean_t is_dir = (code == SVN_DAV__BIN_OPEN_DIR);
+          svn_revnum_t base_rev;
+
+          if (! in_dir || fields->nelts < 2)
+            return malformed_record(code);
+
+          base_rev = SVN_STR_TO_REV(FIELD(fields, 1));
+          node = push_node(bin, is_dir, FIELD(fields, 0));
+          if (is_dir)
+            return editor->open_directory(node->path, node->parent->baton,
+                                          base_rev, node->pool,
+                                          &node->baton);
+          else
+            return editor->open_file(node->path, node->parent->baton,
+                                     base_rev, node->pool, &node->baton);
+        }
+
+      case SVN_DAV__BIN_DELETE_ENTRY:
+        if (! in_dir || fields->nelts < 1)
+          return malformed_record(code);
+        return editor->delete_entry(svn_relpath_join(node->path,
+                                                     FIELD(fields, 0),
+                                                     pool),
+                                    SVN_INVALID_REVNUM, node->baton, pool);
+
+      case SVN_DAV__BIN_ABSENT_DIR:
+        if (! in_dir || fields->nelts < 1)
+          return malformed_record(code);
+        return editor->absent_directory(svn_relpath_join(node->path,
+                                                         FIELD(fields, 0),
+                                                         pool),
+                                        node->baton, pool);
+
+      case SVN_DAV__BIN_ABSENT_FILE:
+        if (! in_dir || fields->nelts < 1)
+          return malformed_record(code);
+        return editor->absent_file(svn_relpath_join(node->path,
+                                                    FIELD(fields, 0), pool),
+                                   node->baton, pool);
+
+      case SVN_DAV__BIN_CHANGE_PROP:
+      case SVN_DAV__BIN_CHECKED_IN:
+        {
+          const char *name;
+          const svn_string_t *value;
+
+          if (! (in_dir || in_file) || fields->nelts < 1)
+            return malformed_record(code);
+
+          /* A checked-in URL is kept as a wc prop, as with XML reports. */
+          if (code == SVN_DAV__BIN_CHECKED_IN)
+            {
+              name = SVN_RA_SERF__WC_CHECKED_IN_URL;
+              value = svn_string_create(FIELD(fields, 0), node->pool);
+            }
+          else
+            {
+              name = apr_pstrdup(node->pool, FIELD(fields, 0));
+              value = (fields->nelts > 1)
+                ? svn_string_dup(APR_ARRAY_IDX(fields, 1, svn_string_t *),
+                                 node->pool)
+                : NULL;
+            }
+
+          if (node->is_dir)
+            return editor->change_dir_prop(node->baton, name, value,
+                                           node->pool);
+          else
+            return editor->change_file_prop(node->baton, name, value,
+                                            node->pool);
+        }
+
+      case SVN_DAV__BIN_APPLY_TEXTDELTA:
+        {
+          svn_txdelta_window_handler_t handler;
+          void *handler_baton;
+
+          if (! in_file)
+            return malformed_record(code);
+
+          SVN_ERR(editor->apply_textdelta(node->baton,
+                                          fields->nelts
+                                            ? FIELD(fields, 0) : NULL,
+                                          node->pool,
+                                          &handler, &handler_baton));
+          bin->delta_stream = svn_txdelta_parse_svndiff(handler,
+                                                        handler_baton,
+                                                        TRUE, node->pool);
+          return SVN_NO_ERROR;
+        }
+
+      case SVN_DAV__BIN_TEXTDELTA_END:
+        if (! bin->delta_stream)
+          return malformed_record(code);
+        SVN_ERR(svn_stream_close(bin->delta_stream));
+        bin->delta_stream = NULL;
+        return SVN_NO_ERROR;
+
+      case SVN_DAV__BIN_CLOSE_FILE:
+        if (! in_file)
+          return malformed_record(code);
+        SVN_ERR(editor->close_file(node->baton,
+                                   fields->nelts ? FIELD(fields, 0) : NULL,
+                                   node->pool));
+        pop_node(bin);
+        return SVN_NO_ERROR;
+
+      case SVN_DAV__BIN_CLOSE_DIR:
+        if (! in_dir)
+          return malformed_record(code);
+        SVN_ERR(editor->close_directory(node->baton, node->pool));
+        pop_node(bin);
+        return SVN_NO_ERROR;
+
+      case SVN_DAV__BIN_CLOSE_EDIT:
+        /* finish_report() calls close_edit once the response is done. */
+        if (node)
+          return malformed_record(code);
+        bin->closed = TRUE;
+        return SVN_NO_ERROR;
+
+      case SVN_DAV__BIN_ERROR:
+        {
+          svn_error_t *err = NULL;
+          int i;
+
+          if (fields->nelts < 2 || fields->nelts % 2)
+            return malformed_record(code);
+
+          /* The server sends the outermost error first. */
+          for (i = fields->nelts - 2; i >= 0; i -= 2)
+            err = svn_error_create(atoi(FIELD(fields, i)), err,
+                                   FIELD(fields, i + 1));
+          return err;
+        }
+
+      default:
+        return malformed_record(code);
+    }
+}
+
+#undef FIELD
+
+/* Drive the update editor with the complete records in BIN's buffer,
+   and keep what's left of it for the next read. */
+static svn_error_t *
+process_records(bin_report_t *bin)
+{
+  svn_stringbuf_t *buf = bin->buf;
+  apr_size_t offset = 0;
+
+  while (buf->len - offset >= 5)
+    {
+      const char *record = buf->data + offset;
+      apr_size_t len = decode_length(record + 1);
+
+      if (len > buf->len - offset - 5)
+        break;
+
+      svn_pool_clear(bin->scratch_pool);
+      SVN_ERR(process_record(bin, record[0], record + 5, len));
+      offset += 5 + len;
+    }
+
+  if (offset)
+    {
+      memmove(buf->data, buf->data + offset, buf->len - offset);
+      buf->len -= offset;
+      buf->data[buf->len] = '\0';
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_serf__response_handler_t, reading the response to
+   an update REPORT that asked for the binary encoding.  A server that
+   doesn't allow bulk updates sends an ordinary XML report instead, so
+   that gets handed to the XML parser. */
+static svn_error_t *
+handle_binary_report(serf_request_t *request,
+                     serf_bucket_t *response,
+                     void *handler_baton,
+                     apr_pool_t *pool)
+{
+  bin_report_t *bin = handler_baton;
+  const char *data;
+  apr_size_t len;
+  apr_status_t status;
+
+  if (! bin->read_headers)
+    {
+      serf_bucket_t *hdrs = serf_bucket_response_get_headers(response);
+      const char *val = serf_bucket_headers_get(hdrs, "Content-Type");
+
+      bin->is_binary = (val && strncmp(val, SVN_DAV__BINARY_UPDATE_MIME_TYPE,
+                                       sizeof(SVN_DAV__BINARY_UPDATE_MIME_TYPE)
+                                       - 1) == 0);
+      bin->read_headers = TRUE;
+    }
+
+  if (! bin->is_binary)
+    return svn_ra_serf__handle_xml_parser(request, response,
+                                          bin->parser_ctx, pool);
+
+  while (1)
+    {
+      status = serf_bucket_read(response, 8000, &data, &len);
+      if (SERF_BUCKET_READ_ERROR(status))
+        return svn_error_wrap_apr(status, NULL);
+
+      svn_stringbuf_appendbytes(bin->buf, data, len);
+      SVN_ERR(process_records(bin));
+
+      if (APR_STATUS_IS_EOF(status))
+        {
+          bin->report->done = TRUE;
+          if (! bin->closed || bin->buf->len)
+            return svn_error_create(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                                    _("The update report ended "
+                                      "prematurely"));
+        }
+
+      if (status)
+        return svn_error_wrap_apr(status, NULL);
+
+      /* feed me! */
+    }
+  /* not reached */
+}
+
 
 /** Editor callbacks given to callers to create request body */
 
@@ -2117,23 +2646,28 @@ link_path(void *report_baton,
   return APR_SUCCESS;
 }
 
-/** Max. number of connctions we'll open to the server. */
-#define MAX_NR_OF_CONNS 4
-/** Minimum nr. of outstanding requests needed before a new connection is
- *  opened. */
-#define REQS_PER_CONN 8
+/** Number of connections an update starts out with, at most. */
+#define INITIAL_FETCH_CONNS 4
+/** How often the throughput of an update gets measured. */
+#define SAMPLE_INTERVAL apr_time_from_sec(1)
+/** How long an update sticks to fewer connections after more of them
+ * didn't help, or the server said it was too busy. */
+#define GROW_BACKOFF apr_time_from_sec(10)
 
 /** This function creates a new connection for this serf session, but only
- * if the number of ACTIVE_REQS > REQS_PER_CONN or if there currently is
- * only one main connection open.
+ * if there are fewer than MAX_CONNS and either the number of ACTIVE_REQS
+ * exceeds the session's reqs_per_conn for each open one, or there
+ * currently is only one main connection open.
  */
 static svn_error_t *
-open_connection_if_needed(svn_ra_serf__session_t *sess, int active_reqs)
+open_connection_if_needed(svn_ra_serf__session_t *sess, int active_reqs,
+                          int max_conns)
 {
-  /* For each REQS_PER_CONN outstanding requests open a new connection, with
-   * a minimum of 1 extra connection. */
-  if (sess->num_conns == 1 ||
-      ((active_reqs / REQS_PER_CONN) > sess->num_conns))
+  /* For each reqs_per_conn outstanding requests open a new connection,
+   * with a minimum of 1 extra connection. */
+  if (sess->num_conns < max_conns &&
+      (sess->num_conns == 1 ||
+       ((active_reqs / sess->reqs_per_conn) > sess->num_conns)))
     {
       int cur = sess->num_conns;
       apr_status_t status;
@@ -2175,6 +2709,63 @@ open_connection_if_needed(svn_ra_serf__session_t *sess, int active_reqs)
   return SVN_NO_ERROR;
 }
 
+/** Adjust the number of connections REPORT spreads its requests for
+ * files across.  Whenever the server answered a request with 503, halve
+ * it.  Otherwise, once per SAMPLE_INTERVAL, compare the throughput to
+ * that of the previous interval: if the last extra connection didn't
+ * improve it by at least 10%, drop that connection again; if there are
+ * enough requests waiting to keep another connection busy, try one more.
+ */
+static void
+adjust_fetch_connections(report_context_t *report)
+{
+  svn_ra_serf__session_t *sess = report->sess;
+  apr_time_t now = apr_time_now();
+  int min_conns = (sess->max_connections > 1) ? 2 : 1;
+  int active_reqs = report->active_fetches + report->active_propfinds;
+  double rate;
+
+  if (sess->busy_responses != report->seen_busy_responses)
+    {
+      report->seen_busy_responses = sess->busy_responses;
+      report->target_conns = MAX(min_conns, report->target_conns / 2);
+      report->probing = FALSE;
+      report->grow_blocked_until = now + GROW_BACKOFF;
+      report->last_rate = 0;
+      report->sample_start = now;
+      report->sample_bytes = sess->bytes_read;
+      return;
+    }
+
+  if (now - report->sample_start < SAMPLE_INTERVAL)
+    return;
+
+  rate = (double) (sess->bytes_read - report->sample_bytes)
+           / (now - report->sample_start);
+
+  if (report->probing && rate < report->last_rate * 1.1)
+    {
+      report->target_conns--;
+      report->grow_blocked_until = now + GROW_BACKOFF;
+    }
+  report->probing = FALSE;
+
+  /* Only try another connection if the ones we have are all in use and
+     would open another one, were it not for the target. */
+  if (report->target_conns < sess->max_connections
+      && now >= report->grow_blocked_until
+      && sess->num_conns >= report->target_conns
+      && (active_reqs / sess->reqs_per_conn) > sess->num_conns)
+    {
+      report->target_conns++;
+      report->probing = TRUE;
+    }
+
+  report->last_rate = rate;
+  report->sample_start = now;
+  report->sample_bytes = sess->bytes_read;
+}
+
 static svn_error_t *
 finish_report(void *report_baton,
               apr_pool_t *pool)
@@ -2218,15 +2809,35 @@ finish_report(void *report_baton,
      do anything with it. The error in parser_ctx->error is sufficient. */
   parser_ctx->status_code = &status_code;
 
-  handler->response_handler = svn_ra_serf__handle_xml_parser;
-  handler->response_baton = parser_ctx;
+  if (report->binary)
+    {
+      bin_report_t *bin = apr_pcalloc(pool, sizeof(*bin));
+
+      bin->report = report;
+      bin->parser_ctx = parser_ctx;
+      bin->buf = svn_stringbuf_create("", pool);
+      bin->scratch_pool = svn_pool_create(pool);
+
+      handler->response_handler = handle_binary_report;
+      handler->response_baton = bin;
+    }
+  else
+    {
+      handler->response_handler = svn_ra_serf__handle_xml_parser;
+      handler->response_baton = parser_ctx;
+    }
 
   svn_ra_serf__request_create(handler);
 
+  report->target_conns = MIN(sess->max_connections, INITIAL_FETCH_CONNS);
+  report->sample_start = apr_time_now();
+  report->sample_bytes = sess->bytes_read;
+  report->seen_busy_responses = sess->busy_responses;
+
   /* Open the first extra connection. */
-  SVN_ERR(open_connection_if_needed(sess, 0));
+  SVN_ERR(open_connection_if_needed(sess, 0, report->target_conns));
 
-  sess->cur_conn = 1;
+  sess->cur_conn = (sess->num_conns > 1) ? 1 : 0;
   closed_root = FALSE;
 
   while (!report->done || report->active_fetches || report->active_propfinds)
@@ -2247,13 +2858,14 @@ finish_report(void *report_baton,
         }
 
       /* Open extra connections if we have enough requests to send. */
-      if (sess->num_conns < MAX_NR_OF_CONNS)
-        SVN_ERR(open_connection_if_needed(sess, report->active_fetches +
-                                          report->active_propfinds));
-
-      /* Switch our connection. */
-      if (!report->done)
-         if (++sess->cur_conn == sess->num_conns)
+      adjust_fetch_connections(report);
+      SVN_ERR(open_connection_if_needed(sess, report->active_fetches +
+                                        report->active_propfinds,
+                                        report->target_conns));
+
+      /* Switch our connection, skipping any beyond the target. */
+      if (!report->done && sess->num_conns > 1)
+         if (++sess->cur_conn >= MIN(sess->num_conns, report->target_conns))
              sess->cur_conn = 1;
 
       /* prune our propfind list if they are done. */
@@ -2384,8 +2996,9 @@ finish_report(void *report_baton,
   /* FIXME subpool */
   return report->update_editor->close_edit(report->update_baton, sess->pool);
 }
-#undef MAX_NR_OF_CONNS
-#undef EXP_REQS_PER_CONN
+#undef INITIAL_FETCH_CONNS
+#undef SAMPLE_INTERVAL
+#undef GROW_BACKOFF
 
 static svn_error_t *
 abort_report(void *report_baton,
@@ -2460,6 +3073,10 @@ make_update_reporter(svn_ra_session_t *ra_session,
   report->text_deltas = text_deltas;
   report->lock_path_tokens = apr_hash_make(pool);
 
+  /* Have the whole edit, text deltas included, sent in the one response
+     if the server knows how to. */
+  report->binary = sess->binary_updates;
+
   report->source = src_path;
   report->destination = dest_path;
   report->update_target = update_target;
@@ -2476,6 +3093,8 @@ make_update_reporter(svn_ra_session_t *ra_session,
   svn_ra_serf__add_open_tag_buckets(report->buckets, report->sess->bkt_alloc,
                                     "S:update-report",
                                     "xmlns:S", SVN_XML_NAMESPACE,
+                                    "binary",
+                                    report->binary ? "true" : NULL,
                                     NULL);
 
   svn_ra_serf__add_tag_buckets(report->buckets,
@@ -2531,6 +3150,15 @@ make_update_reporter(svn_ra_session_t *ra_session,
                                "S:depth", svn_depth_to_word(depth),
                                report->sess->bkt_alloc);
 
+  /* Servers only send text deltas inline when asked for the whole edit,
+     and then they honor this. */
+  if (report->binary && ! report->text_deltas)
+    {
+      svn_ra_serf__add_tag_buckets(report->buckets,
+                                   "S:text-deltas", "no",
+                                   report->sess->bkt_alloc);
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -38,6 +38,7 @@
 #include "svn_private_config.h"
 #include "svn_xml.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_trace.h"
 
 #include "ra_serf.h"
 
@@ -1251,6 +1252,10 @@ svn_ra_serf__credentials_callback(char **username, char **password,
   return APR_SUCCESS;
 }
 
+/* How often a GET gets sent again when the server answers it with 503
+   (Service Unavailable), before that counts as an error. */
+#define MAX_BUSY_RETRIES 5
+
 /* Implements the serf_response_handler_t interface.  Wait for HTTP
    response status and headers, and invoke CTX->response_handler() to
    carry out operation-specific processing.  Afterwards, check for
@@ -1374,6 +1379,22 @@ handle_response(serf_request_t *request,
           return status;
         }
     }
+  else if (sl.code == 503 && strcmp(ctx->method, "GET") == 0
+           && ctx->busy_retries < MAX_BUSY_RETRIES)
+    {
+      /* 503 Service Unavailable: the server is too busy right now.  A GET
+         can safely be sent again; count the response, so that an update
+         fetching files over several connections can back off. */
+      status = svn_ra_serf__response_discard_handler(request, response,
+                                                     NULL, pool);
+      if (! APR_STATUS_IS_EAGAIN(status))
+        {
+          ctx->session->busy_responses++;
+          ctx->busy_retries++;
+          svn_ra_serf__request_create(ctx);
+        }
+      return status;
+    }
   else if (sl.code == 409 || sl.code >= 500)
     {
       /* 409 Conflict: can indicate a hook error.
@@ -1439,6 +1460,11 @@ handle_response(serf_request_t *request,
     }
 
 cleanup:
+  /* The request is complete once its response has been read to the end
+     or it has failed. */
+  if (status && !APR_STATUS_IS_EAGAIN(status))
+    SVN_TRACE__END(ra_serf_request, ctx->trace_start, ctx->method);
+
   /* If a snapshot was set on the body bucket, it wasn't destroyed when the
      request was sent, we have to destroy it now upon successful handling of
      the response. */
@@ -1472,6 +1498,7 @@ setup_request(serf_request_t *request,
   svn_ra_serf__handler_t *ctx = setup_baton;
   serf_bucket_t *headers_bkt;
 
+  SVN_TRACE__BEGIN(ra_serf_request, ctx->trace_start);
   *acceptor = svn_ra_serf__accept_response;
   *acceptor_baton = ctx->session;
 
@@ -1586,7 +1613,8 @@ svn_ra_serf__discover_vcc(const char **vcc_url,
                           apr_pool_t *pool)
 {
   apr_hash_t *props;
-  const char *path, *relative_path, *present_path = "", *uuid;
+  const char *path, *relative_path, *uuid;
+  svn_error_t *err;
 
   /* If we've already got the information our caller seeks, just return it.  */
   if (session->vcc_url && session->repos_root_str)
@@ -1606,49 +1634,88 @@ svn_ra_serf__discover_vcc(const char **vcc_url,
   *vcc_url = NULL;
   uuid = NULL;
 
-  do
+  err = svn_ra_serf__retrieve_props(props, session, conn, path,
+                                    SVN_INVALID_REVNUM, "0", base_props, pool);
+  if (err)
     {
-      svn_error_t *err = svn_ra_serf__retrieve_props(props, session, conn,
-                                                     path, SVN_INVALID_REVNUM,
-                                                     "0", base_props, pool);
-      if (! err)
+      apr_array_header_t *ancestors, *prop_ctxs;
+      int i;
+
+      if (err->apr_err != SVN_ERR_FS_NOT_FOUND)
+        return err;  /* found a _real_ error */
+
+      /* This happens when the path is missing in HEAD, and we have to
+         find its nearest ancestor that exists.  Rather than trying the
+         ancestors one round trip at a time, pipeline a PROPFIND for each
+         of them on the connection and pick the deepest that succeeded. */
+      svn_error_clear(err);
+      err = SVN_NO_ERROR;
+
+      ancestors = apr_array_make(pool, 8, sizeof(const char *));
+      prop_ctxs = apr_array_make(pool, 8,
+                                 sizeof(svn_ra_serf__propfind_context_t *));
+      for (path = svn_uri_dirname(path, pool);
+           !svn_path_is_empty(path);
+           path = svn_uri_dirname(path, pool))
         {
-          *vcc_url =
-              svn_ra_serf__get_ver_prop(props, path,
-                                        SVN_INVALID_REVNUM,
-                                        "DAV:",
-                                        "version-controlled-configuration");
-
-          relative_path = svn_ra_serf__get_ver_prop(props, path,
-                                                    SVN_INVALID_REVNUM,
-                                                    SVN_DAV_PROP_NS_DAV,
-                                                    "baseline-relative-path");
-
-          uuid = svn_ra_serf__get_ver_prop(props, path,
-                                           SVN_INVALID_REVNUM,
-                                           SVN_DAV_PROP_NS_DAV,
-                                           "repository-uuid");
-          break;
+          svn_ra_serf__propfind_context_t *prop_ctx = NULL;
+
+          SVN_ERR(svn_ra_serf__deliver_props(&prop_ctx, props, session, conn,
+                                             path, SVN_INVALID_REVNUM, "0",
+                                             base_props, TRUE, NULL, pool));
+          APR_ARRAY_PUSH(ancestors, const char *) = path;
+          APR_ARRAY_PUSH(prop_ctxs, svn_ra_serf__propfind_context_t *)
+            = prop_ctx;
+
+          if (strcmp(path, "/") == 0)
+            break;
         }
-      else
+
+      /* Wait for all of the responses, even after finding our answer,
+         so that none of the requests outlives PROPS. */
+      path = NULL;
+      for (i = 0; i < ancestors->nelts; i++)
         {
-          if (err->apr_err != SVN_ERR_FS_NOT_FOUND)
+          svn_ra_serf__propfind_context_t *prop_ctx
+            = APR_ARRAY_IDX(prop_ctxs, i, svn_ra_serf__propfind_context_t *);
+          svn_error_t *wait_err = SVN_NO_ERROR;
+
+          if (prop_ctx)
+            wait_err = svn_ra_serf__wait_for_props(prop_ctx, session, pool);
+
+          if (! wait_err)
             {
-              return err;  /* found a _real_ error */
+              if (! path)
+                path = APR_ARRAY_IDX(ancestors, i, const char *);
             }
+          else if (wait_err->apr_err == SVN_ERR_FS_NOT_FOUND)
+            svn_error_clear(wait_err);
+          else if (! err)
+            err = wait_err;
           else
-            {
-              /* This happens when the file is missing in HEAD. */
-              svn_error_clear(err);
-
-              /* Okay, strip off. */
-              present_path = svn_uri_join(svn_uri_basename(path, pool),
-                                          present_path, pool);
-              path = svn_uri_dirname(path, pool);
-            }
+            svn_error_clear(wait_err);
         }
+
+      if (! path && err)
+        return err;
+      svn_error_clear(err);
+    }
+
+  if (path)
+    {
+      *vcc_url = svn_ra_serf__get_ver_prop(props, path, SVN_INVALID_REVNUM,
+                                           "DAV:",
+                                           "version-controlled-configuration");
+
+      relative_path = svn_ra_serf__get_ver_prop(props, path,
+                                                SVN_INVALID_REVNUM,
+                                                SVN_DAV_PROP_NS_DAV,
+                                                "baseline-relative-path");
+
+      uuid = svn_ra_serf__get_ver_prop(props, path, SVN_INVALID_REVNUM,
+                                       SVN_DAV_PROP_NS_DAV,
+                                       "repository-uuid");
     }
-  while (!svn_path_is_empty(path));
 
   if (!*vcc_url)
     {
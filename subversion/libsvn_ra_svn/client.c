@@ -47,6 +47,8 @@
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
 
+#include "private/svn_ra_svn_private.h"
+
 #include "ra_svn.h"
 
 #ifdef SVN_HAVE_SASL
@@ -64,6 +66,10 @@
 #define DEPTH_TO_RECURSE(d)    \
         ((d) == svn_depth_unknown || (d) > svn_depth_files)
 
+/* The number of pipelined read commands that may wait for their
+   responses at the same time, see read_pipelined_responses(). */
+#define READ_PIPELINE_DEPTH 32
+
 typedef struct {
   svn_ra_svn__session_baton_t *sess_baton;
   apr_pool_t *pool;
@@ -553,6 +559,20 @@ static svn_error_t *parse_url(const char *url, apr_uri_t *uri,
    are provided by the caller of ra_svn_open. If tunnel_argv is non-null,
    it points to a program argument list to use when invoking the tunnel agent.
 */
+/* Return TRUE if CONN is a TCP connection to a remote host.  Tunnels
+   and loopback connections don't gain anything from compression. */
+static svn_boolean_t
+is_remote_connection(svn_ra_svn_conn_t *conn)
+{
+  const char *ip = conn->remote_ip;
+
+  if (ip == NULL)
+    return FALSE;
+  if (strncmp(ip, "::ffff:", 7) == 0)
+    ip += 7;
+  return (strncmp(ip, "127.", 4) != 0 && strcmp(ip, "::1") != 0);
+}
+
 static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                  const char *url,
                                  const apr_uri_t *uri,
@@ -567,6 +587,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   apr_uint64_t minver, maxver;
   apr_array_header_t *mechlist, *server_caplist, *repos_caplist;
   const char *client_string = NULL;
+  svn_boolean_t compress;
 
   sess = apr_palloc(pool, sizeof(*sess));
   sess->pool = pool;
@@ -619,10 +640,16 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
     SVN_ERR(sess->callbacks->get_client_string(sess->callbacks_baton,
                                                &client_string, pool));
 
+  /* Compress the rest of the conversation if the server can, unless
+   * the server is on this machine. */
+  compress = (svn_ra_svn_has_capability(conn,
+                                        SVN_RA_SVN_CAP_COMPRESSED_STREAM)
+              && is_remote_connection(conn));
+
   /* In protocol version 2, we send back our protocol version, our
    * capability list, and the URL, and subsequently there is an auth
    * request. */
-  SVN_ERR(svn_ra_svn_write_tuple(conn, pool, "n(wwwwww)cc(?c)",
+  SVN_ERR(svn_ra_svn_write_tuple(conn, pool, "n(wwwwwww?w)cc(?c)",
                                  (apr_uint64_t) 2,
                                  SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                  SVN_RA_SVN_CAP_SVNDIFF1,
@@ -630,7 +657,13 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                  SVN_RA_SVN_CAP_DEPTH,
                                  SVN_RA_SVN_CAP_MERGEINFO,
                                  SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                 SVN_RA_SVN_CAP_LARGE_DELTA_WINDOWS,
+                                 compress
+                                   ? SVN_RA_SVN_CAP_COMPRESSED_STREAM
+                                   : NULL,
                                  url, "SVN/" SVN_VERSION, client_string));
+  if (compress)
+    SVN_ERR(svn_ra_svn__enable_compression(conn, pool));
   SVN_ERR(handle_auth_request(sess, pool));
 
   /* This is where the security layer would go into effect if we
@@ -1036,22 +1069,11 @@ static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
-                                   apr_hash_t **dirents,
-                                   svn_revnum_t *fetched_rev,
-                                   apr_hash_t **props,
-                                   const char *path,
-                                   svn_revnum_t rev,
-                                   apr_uint32_t dirent_fields,
-                                   apr_pool_t *pool)
+/* Write the words for the fields in DIRENT_FIELDS to CONN. */
+static svn_error_t *write_dirent_fields(svn_ra_svn_conn_t *conn,
+                                        apr_pool_t *pool,
+                                        apr_uint32_t dirent_fields)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
-  apr_array_header_t *proplist, *dirlist;
-  int i;
-
-  SVN_ERR(svn_ra_svn_write_tuple(conn, pool, "w(c(?r)bb(!", "get-dir", path,
-                                 rev, (props != NULL), (dirents != NULL)));
   if (dirent_fields & SVN_DIRENT_KIND)
     SVN_ERR(svn_ra_svn_write_word(conn, pool, SVN_RA_SVN_DIRENT_KIND));
   if (dirent_fields & SVN_DIRENT_SIZE)
@@ -1064,15 +1086,74 @@ static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
     SVN_ERR(svn_ra_svn_write_word(conn, pool, SVN_RA_SVN_DIRENT_TIME));
   if (dirent_fields & SVN_DIRENT_LAST_AUTHOR)
     SVN_ERR(svn_ra_svn_write_word(conn, pool, SVN_RA_SVN_DIRENT_LAST_AUTHOR));
+  return SVN_NO_ERROR;
+}
 
-  SVN_ERR(svn_ra_svn_write_tuple(conn, pool, "!))"));
+/* Write a get-dir command for PATH in REV to CONN, asking for the
+   directory's properties and entries as WANT_PROPS and WANT_CONTENTS say,
+   and for the entry fields in DIRENT_FIELDS.  If PIPELINED, tell the
+   server that further commands follow without waiting for the response.
+   Use POOL for temporary allocations. */
+static svn_error_t *write_get_dir_cmd(svn_ra_svn_conn_t *conn,
+                                      apr_pool_t *pool,
+                                      const char *path,
+                                      svn_revnum_t rev,
+                                      svn_boolean_t want_props,
+                                      svn_boolean_t want_contents,
+                                      apr_uint32_t dirent_fields,
+                                      svn_boolean_t pipelined)
+{
+  SVN_ERR(svn_ra_svn_write_tuple(conn, pool, "w(c(?r)bb(!", "get-dir", path,
+                                 rev, want_props, want_contents));
+  SVN_ERR(write_dirent_fields(conn, pool, dirent_fields));
 
-  SVN_ERR(handle_auth_request(sess_baton, pool));
-  SVN_ERR(svn_ra_svn_read_cmd_response(conn, pool, "rll", &rev, &proplist,
-                                       &dirlist));
+  if (pipelined)
+    return svn_ra_svn_write_tuple(conn, pool, "!)b)", TRUE);
+  return svn_ra_svn_write_tuple(conn, pool, "!))");
+}
+
+/* Interpret the directory entry ELT of a get-dir or list response,
+   setting *NAME and *DIRENT, allocated in POOL. */
+static svn_error_t *parse_dirent(const char **name,
+                                 svn_dirent_t **dirent,
+                                 svn_ra_svn_item_t *elt,
+                                 apr_pool_t *pool)
+{
+  const char *kind, *cdate, *cauthor;
+  svn_boolean_t has_props;
+  apr_uint64_t size;
+  svn_revnum_t crev;
+
+  if (elt->kind != SVN_RA_SVN_LIST)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Dirlist element not a list"));
+  SVN_ERR(svn_ra_svn_parse_tuple(elt->u.list, pool, "cwnbr(?c)(?c)",
+                                 name, &kind, &size, &has_props,
+                                 &crev, &cdate, &cauthor));
+  *name = svn_uri_canonicalize(*name, pool);
+  *dirent = apr_palloc(pool, sizeof(**dirent));
+  (*dirent)->kind = svn_node_kind_from_word(kind);
+  (*dirent)->size = size;/* FIXME: svn_filesize_t */
+  (*dirent)->has_props = has_props;
+  (*dirent)->created_rev = crev;
+  if (cdate)
+    SVN_ERR(svn_time_from_cstring(&(*dirent)->time, cdate, pool));
+  else
+    (*dirent)->time = 0;
+  (*dirent)->last_author = cauthor;
+  return SVN_NO_ERROR;
+}
+
+/* Interpret PROPLIST and DIRLIST from a get-dir response, setting *PROPS
+   and *DIRENTS, unless they are NULL.  Allocate them in POOL. */
+static svn_error_t *parse_get_dir_response(apr_hash_t **dirents,
+                                           apr_hash_t **props,
+                                           const apr_array_header_t *proplist,
+                                           const apr_array_header_t *dirlist,
+                                           apr_pool_t *pool)
+{
+  int i;
 
-  if (fetched_rev)
-    *fetched_rev = rev;
   if (props)
     SVN_ERR(svn_ra_svn_parse_proplist(proplist, pool, props));
 
@@ -1084,33 +1165,130 @@ static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
   *dirents = apr_hash_make(pool);
   for (i = 0; i < dirlist->nelts; i++)
     {
-      const char *name, *kind, *cdate, *cauthor;
-      svn_boolean_t has_props;
+      const char *name;
       svn_dirent_t *dirent;
-      apr_uint64_t size;
-      svn_revnum_t crev;
-      svn_ra_svn_item_t *elt = &APR_ARRAY_IDX(dirlist, i, svn_ra_svn_item_t);
 
-      if (elt->kind != SVN_RA_SVN_LIST)
-        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
-                                _("Dirlist element not a list"));
-      SVN_ERR(svn_ra_svn_parse_tuple(elt->u.list, pool, "cwnbr(?c)(?c)",
-                                     &name, &kind, &size, &has_props,
-                                     &crev, &cdate, &cauthor));
-      name = svn_uri_canonicalize(name, pool);
-      dirent = apr_palloc(pool, sizeof(*dirent));
-      dirent->kind = svn_node_kind_from_word(kind);
-      dirent->size = size;/* FIXME: svn_filesize_t */
-      dirent->has_props = has_props;
-      dirent->created_rev = crev;
-      SVN_ERR(svn_time_from_cstring(&dirent->time, cdate, pool));
-      dirent->last_author = cauthor;
+      SVN_ERR(parse_dirent(&name, &dirent,
+                           &APR_ARRAY_IDX(dirlist, i, svn_ra_svn_item_t),
+                           pool));
       apr_hash_set(*dirents, name, APR_HASH_KEY_STRING, dirent);
     }
 
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
+                                   apr_hash_t **dirents,
+                                   svn_revnum_t *fetched_rev,
+                                   apr_hash_t **props,
+                                   const char *path,
+                                   svn_revnum_t rev,
+                                   apr_uint32_t dirent_fields,
+                                   apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_array_header_t *proplist, *dirlist;
+
+  SVN_ERR(write_get_dir_cmd(conn, pool, path, rev, (props != NULL),
+                            (dirents != NULL), dirent_fields, FALSE));
+
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+  SVN_ERR(svn_ra_svn_read_cmd_response(conn, pool, "rll", &rev, &proplist,
+                                       &dirlist));
+
+  if (fetched_rev)
+    *fetched_rev = rev;
+
+  return parse_get_dir_response(dirents, props, proplist, dirlist, pool);
+}
+
+static svn_error_t *ra_svn_list(svn_ra_session_t *session,
+                                const char *path,
+                                svn_revnum_t rev,
+                                svn_depth_t depth,
+                                apr_uint32_t dirent_fields,
+                                svn_ra_dirent_receiver_t receiver,
+                                void *receiver_baton,
+                                apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool;
+
+  if (! svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_LIST))
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL,
+                            _("Server does not support listing trees"));
+
+  SVN_ERR(svn_ra_svn_write_tuple(conn, pool, "w(c(?r)w(!", "list", path,
+                                 rev, svn_depth_to_word(depth)));
+  SVN_ERR(write_dirent_fields(conn, pool, dirent_fields));
+  SVN_ERR(svn_ra_svn_write_tuple(conn, pool, "!))"));
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+
+  /* The entries arrive as they are found, terminated by "done". */
+  iterpool = svn_pool_create(pool);
+  while (1)
+    {
+      svn_ra_svn_item_t *item;
+      const char *entry_path;
+      svn_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn_read_item(conn, iterpool, &item));
+      if (item->kind == SVN_RA_SVN_WORD && strcmp(item->u.word, "done") == 0)
+        break;
+      SVN_ERR(parse_dirent(&entry_path, &dirent, item, iterpool));
+      SVN_ERR(receiver(entry_path, dirent, receiver_baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_ra_svn_read_cmd_response(conn, pool, "");
+}
+
+static svn_error_t *ra_svn_get_archive(svn_ra_session_t *session,
+                                       const char *path,
+                                       svn_revnum_t rev,
+                                       const char *prefix,
+                                       svn_stream_t *stream,
+                                       apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool;
+
+  if (! svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_ARCHIVE))
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL,
+                            _("Server does not support archives"));
+
+  SVN_ERR(svn_ra_svn_write_cmd(conn, pool, "get-archive", "c(?r)c",
+                               path, rev, prefix));
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+  SVN_ERR(svn_ra_svn_read_cmd_response(conn, pool, ""));
+
+  /* The archive arrives in chunks, terminated by an empty string. */
+  iterpool = svn_pool_create(pool);
+  while (1)
+    {
+      svn_ra_svn_item_t *item;
+      apr_size_t len;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn_read_item(conn, iterpool, &item));
+      if (item->kind != SVN_RA_SVN_STRING)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Non-string as part of archive"));
+      if (item->u.string->len == 0)
+        break;
+
+      len = item->u.string->len;
+      SVN_ERR(svn_stream_write(stream, item->u.string->data, &len));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_ra_svn_read_cmd_response(conn, pool, "");
+}
+
 /* If REVISION is SVN_INVALID_REVNUM, no value is sent to the
    server, which defaults to youngest. */
 static svn_error_t *ra_svn_get_mergeinfo(svn_ra_session_t *session,
@@ -1520,22 +1698,12 @@ static svn_error_t *handle_unsupported_cmd(svn_error_t *err,
 }
 
 
-static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
-                                const char *path, svn_revnum_t rev,
-                                svn_dirent_t **dirent, apr_pool_t *pool)
+/* Set *DIRENT to the dirent in LIST, the response to a stat command,
+   or to NULL if LIST is NULL.  Allocate it in POOL. */
+static svn_error_t *parse_stat_response(svn_dirent_t **dirent,
+                                        const apr_array_header_t *list,
+                                        apr_pool_t *pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
-  apr_array_header_t *list = NULL;
-  svn_dirent_t *the_dirent;
-
-  SVN_ERR(svn_ra_svn_write_cmd(conn, pool, "stat", "c(?r)", path, rev));
-
-  SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess_baton, pool),
-                                 _("'stat' not implemented")));
-
-  SVN_ERR(svn_ra_svn_read_cmd_response(conn, pool, "(?l)", &list));
-
   if (! list)
     {
       *dirent = NULL;
@@ -1546,6 +1714,7 @@ static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
       svn_boolean_t has_props;
       svn_revnum_t crev;
       apr_uint64_t size;
+      svn_dirent_t *the_dirent;
 
       SVN_ERR(svn_ra_svn_parse_tuple(list, pool, "wnbr(?c)(?c)",
                                      &kind, &size, &has_props,
@@ -1565,6 +1734,306 @@ static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
+                                const char *path, svn_revnum_t rev,
+                                svn_dirent_t **dirent, apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_array_header_t *list = NULL;
+
+  SVN_ERR(svn_ra_svn_write_cmd(conn, pool, "stat", "c(?r)", path, rev));
+
+  SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess_baton, pool),
+                                 _("'stat' not implemented")));
+
+  SVN_ERR(svn_ra_svn_read_cmd_response(conn, pool, "(?l)", &list));
+
+  return parse_stat_response(dirent, list, pool);
+}
+
+/* Read the response to a pipelined command from SESS's connection.  If
+   the server reports success, set *PARAMS to the parameters of the
+   response and *CMD_ERR to NULL.  If it reports that the command failed,
+   set *PARAMS to NULL and *CMD_ERR to the error; the connection can still
+   be used then.  Errors from the connection itself are returned.
+
+   Pipelined commands never get a real authentication request: the server
+   fails them instead (see read_pipelined_responses()).  Use POOL for all
+   allocations. */
+static svn_error_t *read_pipelined_response(apr_array_header_t **params,
+                                            svn_error_t **cmd_err,
+                                            svn_ra_svn__session_baton_t *sess,
+                                            apr_pool_t *pool)
+{
+  svn_ra_svn_conn_t *conn = sess->conn;
+  apr_array_header_t *mechlist;
+  const char *status, *realm;
+
+  *cmd_err = NULL;
+
+  /* First the (trivial) auth request, then the actual response. */
+  SVN_ERR(svn_ra_svn_read_tuple(conn, pool, "wl", &status, params));
+  if (strcmp(status, "success") == 0)
+    {
+      SVN_ERR(svn_ra_svn_parse_tuple(*params, pool, "lc", &mechlist,
+                                     &realm));
+      if (mechlist->nelts != 0)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Unexpected authentication request for "
+                                  "a pipelined command"));
+      SVN_ERR(svn_ra_svn_read_tuple(conn, pool, "wl", &status, params));
+    }
+
+  if (strcmp(status, "success") == 0)
+    return SVN_NO_ERROR;
+  else if (strcmp(status, "failure") == 0)
+    {
+      *cmd_err = svn_ra_svn__handle_failure_status(*params, pool);
+      *params = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_createf(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                           _("Unknown status '%s' in command response"),
+                           status);
+}
+
+/* Baton for the functions used by read_pipelined_responses(). */
+typedef struct pipelined_reads_baton_t
+{
+  /* The paths the commands are for, and the revision. */
+  const apr_array_header_t *paths;
+  svn_revnum_t rev;
+
+  /* Arguments of get-dir. */
+  apr_uint32_t dirent_fields;
+  svn_boolean_t want_props;
+
+  /* The results, keyed by path. */
+  apr_hash_t *results;
+} pipelined_reads_baton_t;
+
+/* Write the pipelined command for PATH described by B to CONN. */
+typedef svn_error_t *(*write_pipelined_cmd_t)(svn_ra_svn_conn_t *conn,
+                                              const char *path,
+                                              pipelined_reads_baton_t *b,
+                                              apr_pool_t *pool);
+
+/* Handle PARAMS, the successful response to the command for PATH, and
+   record the result in B. */
+typedef svn_error_t *(*parse_pipelined_response_t)(
+  const char *path,
+  const apr_array_header_t *params,
+  pipelined_reads_baton_t *b,
+  apr_pool_t *pool);
+
+/* Send a command for each of B->PATHS to SESS's connection with WRITE_CMD,
+   and handle the responses in order with PARSE_RESPONSE, while keeping at
+   most READ_PIPELINE_DEPTH commands waiting for their responses.  Bounding
+   them keeps the server from blocking on writing responses while the
+   client still writes commands.
+
+   The server does not ask for authentication in response to a pipelined
+   command; if one fails because it would have needed that, add its path
+   to *RETRY, to be handled one at a time later.  If other commands fail,
+   return the first of those errors, once all responses have been read.
+   Use POOL for all allocations. */
+static svn_error_t *read_pipelined_responses(apr_array_header_t **retry,
+                                             svn_ra_svn__session_baton_t *sess,
+                                             write_pipelined_cmd_t write_cmd,
+                                             parse_pipelined_response_t
+                                               parse_response,
+                                             pipelined_reads_baton_t *b,
+                                             apr_pool_t *pool)
+{
+  svn_ra_svn_conn_t *conn = sess->conn;
+  svn_error_t *first_err = SVN_NO_ERROR;
+  svn_error_t *err = SVN_NO_ERROR;
+  int sent = 0;
+  int i;
+
+  *retry = apr_array_make(pool, 0, sizeof(const char *));
+
+  for (i = 0; !err && i < b->paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(b->paths, i, const char *);
+      apr_array_header_t *params;
+      svn_error_t *cmd_err;
+
+      for (; !err && sent < b->paths->nelts
+             && sent < i + READ_PIPELINE_DEPTH; sent++)
+        err = write_cmd(conn, APR_ARRAY_IDX(b->paths, sent, const char *),
+                        b, pool);
+
+      /* Reading flushes the commands written so far. */
+      if (!err)
+        err = read_pipelined_response(&params, &cmd_err, sess, pool);
+      if (err)
+        break;
+
+      if (cmd_err && cmd_err->apr_err == SVN_ERR_RA_NOT_AUTHORIZED)
+        {
+          APR_ARRAY_PUSH(*retry, const char *) = path;
+          svn_error_clear(cmd_err);
+        }
+      else if (cmd_err && first_err)
+        svn_error_clear(cmd_err);
+      else if (cmd_err)
+        first_err = cmd_err;
+      else if (!first_err)
+        first_err = parse_response(path, params, b, pool);
+    }
+
+  if (err)
+    {
+      svn_error_clear(first_err);
+      return err;
+    }
+
+  return first_err;
+}
+
+/* Implements write_pipelined_cmd_t for stat. */
+static svn_error_t *write_stat_cmd(svn_ra_svn_conn_t *conn,
+                                   const char *path,
+                                   pipelined_reads_baton_t *b,
+                                   apr_pool_t *pool)
+{
+  return svn_ra_svn_write_cmd(conn, pool, "stat", "c(?r)b", path, b->rev,
+                              TRUE);
+}
+
+/* Implements parse_pipelined_response_t for stat. */
+static svn_error_t *parse_stat_cmd_response(const char *path,
+                                            const apr_array_header_t *params,
+                                            pipelined_reads_baton_t *b,
+                                            apr_pool_t *pool)
+{
+  apr_array_header_t *list;
+  svn_dirent_t *dirent;
+
+  SVN_ERR(svn_ra_svn_parse_tuple(params, pool, "(?l)", &list));
+  SVN_ERR(parse_stat_response(&dirent, list, pool));
+  if (dirent)
+    apr_hash_set(b->results, path, APR_HASH_KEY_STRING, dirent);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *ra_svn_stat_many(svn_ra_session_t *session,
+                                     apr_hash_t **dirents,
+                                     const apr_array_header_t *paths,
+                                     svn_revnum_t rev,
+                                     apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  pipelined_reads_baton_t b = { 0 };
+  const apr_array_header_t *retry = paths;
+  apr_array_header_t *refused;
+  int i;
+
+  b.paths = paths;
+  b.rev = rev;
+  b.results = apr_hash_make(pool);
+
+  if (svn_ra_svn_has_capability(sess_baton->conn,
+                                SVN_RA_SVN_CAP_PIPELINED_READS))
+    {
+      SVN_ERR(read_pipelined_responses(&refused, sess_baton, write_stat_cmd,
+                                       parse_stat_cmd_response, &b, pool));
+      retry = refused;
+    }
+
+  for (i = 0; i < retry->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(retry, i, const char *);
+      svn_dirent_t *dirent;
+
+      SVN_ERR(ra_svn_stat(session, path, rev, &dirent, pool));
+      if (dirent)
+        apr_hash_set(b.results, path, APR_HASH_KEY_STRING, dirent);
+    }
+
+  *dirents = b.results;
+  return SVN_NO_ERROR;
+}
+
+/* Implements write_pipelined_cmd_t for get-dir. */
+static svn_error_t *write_get_dir_pipelined(svn_ra_svn_conn_t *conn,
+                                            const char *path,
+                                            pipelined_reads_baton_t *b,
+                                            apr_pool_t *pool)
+{
+  return write_get_dir_cmd(conn, pool, path, b->rev, b->want_props, TRUE,
+                           b->dirent_fields, TRUE);
+}
+
+/* Implements parse_pipelined_response_t for get-dir. */
+static svn_error_t *parse_get_dir_cmd_response(const char *path,
+                                               const apr_array_header_t
+                                                 *params,
+                                               pipelined_reads_baton_t *b,
+                                               apr_pool_t *pool)
+{
+  svn_ra_dir_listing_t *listing = apr_pcalloc(pool, sizeof(*listing));
+  apr_array_header_t *proplist, *dirlist;
+
+  SVN_ERR(svn_ra_svn_parse_tuple(params, pool, "rll", &listing->fetched_rev,
+                                 &proplist, &dirlist));
+  SVN_ERR(parse_get_dir_response(&listing->dirents,
+                                 b->want_props ? &listing->props : NULL,
+                                 proplist, dirlist, pool));
+  apr_hash_set(b->results, path, APR_HASH_KEY_STRING, listing);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *ra_svn_get_dir_many(svn_ra_session_t *session,
+                                        apr_hash_t **listings,
+                                        const apr_array_header_t *paths,
+                                        svn_revnum_t rev,
+                                        apr_uint32_t dirent_fields,
+                                        svn_boolean_t want_props,
+                                        apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  pipelined_reads_baton_t b = { 0 };
+  const apr_array_header_t *retry = paths;
+  apr_array_header_t *refused;
+  int i;
+
+  b.paths = paths;
+  b.rev = rev;
+  b.dirent_fields = dirent_fields;
+  b.want_props = want_props;
+  b.results = apr_hash_make(pool);
+
+  if (svn_ra_svn_has_capability(sess_baton->conn,
+                                SVN_RA_SVN_CAP_PIPELINED_READS))
+    {
+      SVN_ERR(read_pipelined_responses(&refused, sess_baton,
+                                       write_get_dir_pipelined,
+                                       parse_get_dir_cmd_response, &b, pool));
+      retry = refused;
+    }
+
+  for (i = 0; i < retry->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(retry, i, const char *);
+      svn_ra_dir_listing_t *listing = apr_pcalloc(pool, sizeof(*listing));
+
+      SVN_ERR(ra_svn_get_dir(session, &listing->dirents,
+                             &listing->fetched_rev,
+                             want_props ? &listing->props : NULL,
+                             path, rev, dirent_fields, pool));
+      apr_hash_set(b.results, path, APR_HASH_KEY_STRING, listing);
+    }
+
+  *listings = b.results;
+  return SVN_NO_ERROR;
+}
+
 
 static svn_error_t *ra_svn_get_locations(svn_ra_session_t *session,
                                          apr_hash_t **locations,
@@ -2357,6 +2826,11 @@ static svn_error_t *ra_svn_has_capability(svn_ra_session_t *session,
   else if (strcmp(capability, SVN_RA_CAPABILITY_COMMIT_REVPROPS) == 0)
     *has = svn_ra_svn_has_capability(sess->conn,
                                      SVN_RA_SVN_CAP_COMMIT_REVPROPS);
+  else if (strcmp(capability, SVN_RA_CAPABILITY_LARGE_DELTA_WINDOWS) == 0)
+    *has = svn_ra_svn_has_capability(sess->conn,
+                                     SVN_RA_SVN_CAP_LARGE_DELTA_WINDOWS);
+  else if (strcmp(capability, SVN_RA_CAPABILITY_FILE_BLAME) == 0)
+    *has = svn_ra_svn_has_capability(sess->conn, SVN_RA_SVN_CAP_FILE_BLAME);
   else  /* Don't know any other capabilities, so error. */
     {
       return svn_error_createf
@@ -2390,6 +2864,74 @@ ra_svn_get_deleted_rev(svn_ra_session_t *session,
   return svn_ra_svn_read_cmd_response(conn, pool, "r", revision_deleted);
 }
 
+static svn_error_t *
+ra_svn_get_file_blame(svn_ra_session_t *session,
+                      const char *path,
+                      svn_revnum_t start,
+                      svn_revnum_t end,
+                      const apr_array_header_t *diff_options,
+                      svn_boolean_t ignore_mime_type,
+                      svn_blame_chunk_receiver_t receiver,
+                      void *receiver_baton,
+                      apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_boolean_t is_done;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (! svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_FILE_BLAME))
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL,
+                            _("Server does not support server-side blame"));
+
+  /* Transmit the parameters. */
+  SVN_ERR(svn_ra_svn_write_tuple(conn, pool, "w(crr(!", "get-file-blame",
+                                 path, start, end));
+  for (i = 0; diff_options && i < diff_options->nelts; i++)
+    SVN_ERR(svn_ra_svn_write_cstring(conn, pool,
+                                     APR_ARRAY_IDX(diff_options, i,
+                                                   const char *)));
+  SVN_ERR(svn_ra_svn_write_tuple(conn, pool, "!)b)", ignore_mime_type));
+
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+
+  /* Parse the blame chunks. */
+  iterpool = svn_pool_create(pool);
+  is_done = FALSE;
+  while (!is_done)
+    {
+      svn_ra_svn_item_t *item;
+      apr_uint64_t start_line;
+      svn_revnum_t rev;
+      apr_array_header_t *rev_proplist;
+      apr_hash_t *rev_props = NULL;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn_read_item(conn, iterpool, &item));
+      if (item->kind == SVN_RA_SVN_WORD && strcmp(item->u.word, "done") == 0)
+        is_done = TRUE;
+      else if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Blame chunk not a list"));
+      else
+        {
+          SVN_ERR(svn_ra_svn_parse_tuple(item->u.list, iterpool, "n(?r)l",
+                                         &start_line, &rev, &rev_proplist));
+          if (SVN_IS_VALID_REVNUM(rev))
+            SVN_ERR(svn_ra_svn_parse_proplist(rev_proplist, iterpool,
+                                              &rev_props));
+          SVN_ERR(receiver(receiver_baton, (svn_linenum_t) start_line, rev,
+                           rev_props, iterpool));
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Read the response. This is so the server would have a chance to
+   * report an error. */
+  return svn_ra_svn_read_cmd_response(conn, pool, "");
+}
+
 
 static const svn_ra__vtable_t ra_svn_vtable = {
   svn_ra_svn_version,
@@ -2427,7 +2969,12 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_has_capability,
   ra_svn_replay_range,
   ra_svn_get_deleted_rev,
-  NULL  /* ra_svn_obliterate_path_rev */
+  NULL, /* ra_svn_obliterate_path_rev */
+  ra_svn_get_file_blame,
+  ra_svn_stat_many,
+  ra_svn_get_dir_many,
+  ra_svn_list,
+  ra_svn_get_archive
 };
 
 svn_error_t *
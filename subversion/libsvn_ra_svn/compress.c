@@ -0,0 +1,261 @@
+/*
+ * compress.c :  zlib compression of a whole ra_svn connection
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <string.h>
+#include <zlib.h>
+
+#include <apr_general.h>
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+#include "svn_ra_svn.h"
+#include "svn_private_config.h"
+
+#include "private/svn_ra_svn_private.h"
+
+#include "ra_svn.h"
+
+/* The compression level used for outgoing data.  Protocol data is
+   very repetitive, so the fastest level already gets most of the
+   gain without making the server CPU-bound. */
+#define COMPRESSION_LEVEL Z_BEST_SPEED
+
+/* Size of the buffer compressed data is read into. */
+#define COMPRESSED_READBUF_SIZE 16384
+
+typedef struct compress_baton_t {
+  /* The stream that carries the compressed data. */
+  svn_ra_svn__stream_t *stream;
+
+  z_stream in;
+  z_stream out;
+
+  /* Compressed data read from STREAM that IN.next_in points into. */
+  char *read_buf;
+
+  /* Compressed output of the last write that STREAM didn't take yet,
+     and the number of input bytes that output stands for. */
+  svn_stringbuf_t *write_buf;
+  const char *write_ptr;
+  apr_size_t write_len;
+  apr_size_t write_consumed;
+
+  /* TRUE if the last inflate() filled the caller's buffer, so that it
+     may still hold decompressed data that didn't fit. */
+  svn_boolean_t read_full;
+} compress_baton_t;
+
+/* Release the zlib state of the compress_baton_t BATON. */
+static apr_status_t
+cleanup_compression(void *baton)
+{
+  compress_baton_t *b = baton;
+
+  inflateEnd(&b->in);
+  deflateEnd(&b->out);
+  return APR_SUCCESS;
+}
+
+/* Return an error for the zlib status ZERR of STRM. */
+static svn_error_t *
+zlib_error(z_stream *strm, int zerr, const char *message)
+{
+  return svn_error_createf(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                           "%s (zlib error %d: %s)", message, zerr,
+                           strm->msg ? strm->msg : "");
+}
+
+/* Implements svn_read_fn_t. */
+static svn_error_t *
+compress_read_cb(void *baton, char *buffer, apr_size_t *len)
+{
+  compress_baton_t *b = baton;
+  int zerr;
+
+  b->in.next_out = (Bytef *) buffer;
+  b->in.avail_out = (uInt) *len;
+
+  /* A single block of compressed data may span several reads. */
+  while (b->in.avail_out == *len)
+    {
+      if (b->in.avail_in == 0 && !b->read_full)
+        {
+          apr_size_t len2 = COMPRESSED_READBUF_SIZE;
+
+          SVN_ERR(svn_ra_svn__stream_read(b->stream, b->read_buf, &len2));
+          if (len2 == 0)
+            {
+              *len = 0;
+              return SVN_NO_ERROR;
+            }
+          b->in.next_in = (Bytef *) b->read_buf;
+          b->in.avail_in = (uInt) len2;
+        }
+
+      zerr = inflate(&b->in, Z_SYNC_FLUSH);
+      if (zerr == Z_STREAM_END)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Unexpected end of compressed data"));
+      if (zerr != Z_OK && zerr != Z_BUF_ERROR)
+        return zlib_error(&b->in, zerr,
+                          _("Can't decompress data from connection"));
+
+      b->read_full = (b->in.avail_out == 0);
+    }
+
+  *len -= b->in.avail_out;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t.  Like sasl_write_cb(), this reports *LEN
+   as 0 if the underlying stream would block, and expects to be called
+   again with the same arguments. */
+static svn_error_t *
+compress_write_cb(void *baton, const char *buffer, apr_size_t *len)
+{
+  compress_baton_t *b = baton;
+  int zerr;
+
+  if (b->write_len == 0)
+    {
+      svn_stringbuf_setempty(b->write_buf);
+      b->out.next_in = (Bytef *) buffer;
+      b->out.avail_in = (uInt) *len;
+
+      /* Flush everything, since the marshaller only writes when it
+         wants the data to reach the other side. */
+      do
+        {
+          svn_stringbuf_ensure(b->write_buf, b->write_buf->len
+                                             + COMPRESSED_READBUF_SIZE);
+          b->out.next_out = (Bytef *) b->write_buf->data + b->write_buf->len;
+          b->out.avail_out = (uInt) (b->write_buf->blocksize
+                                     - b->write_buf->len - 1);
+          zerr = deflate(&b->out, Z_SYNC_FLUSH);
+          if (zerr != Z_OK && zerr != Z_BUF_ERROR)
+            return zlib_error(&b->out, zerr,
+                              _("Can't compress data for connection"));
+          b->write_buf->len = (char *) b->out.next_out - b->write_buf->data;
+        }
+      while (b->out.avail_out == 0);
+
+      b->write_ptr = b->write_buf->data;
+      b->write_len = b->write_buf->len;
+      b->write_consumed = *len;
+    }
+
+  while (b->write_len > 0)
+    {
+      apr_size_t tmplen = b->write_len;
+
+      SVN_ERR(svn_ra_svn__stream_write(b->stream, b->write_ptr, &tmplen));
+      if (tmplen == 0)
+        {
+          *len = 0;
+          return SVN_NO_ERROR;
+        }
+      b->write_ptr += tmplen;
+      b->write_len -= tmplen;
+    }
+
+  *len = b->write_consumed;
+  return SVN_NO_ERROR;
+}
+
+/* Implements ra_svn_timeout_fn_t. */
+static void
+compress_timeout_cb(void *baton, apr_interval_time_t interval)
+{
+  compress_baton_t *b = baton;
+  svn_ra_svn__stream_timeout(b->stream, interval);
+}
+
+/* Implements ra_svn_pending_fn_t.  Compressed data that was read but
+   not inflated yet counts as pending, even if it turns out to be only
+   part of a block. */
+static svn_boolean_t
+compress_pending_cb(void *baton)
+{
+  compress_baton_t *b = baton;
+
+  if (b->in.avail_in > 0 || b->read_full)
+    return TRUE;
+  return svn_ra_svn__stream_pending(b->stream);
+}
+
+svn_error_t *
+svn_ra_svn__enable_compression(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
+{
+  compress_baton_t *b;
+  int zerr;
+
+  if (conn->compressed)
+    return SVN_NO_ERROR;
+
+  /* Flush the connection, as we're about to replace its stream. */
+  SVN_ERR(svn_ra_svn_flush(conn, pool));
+
+  b = apr_pcalloc(conn->pool, sizeof(*b));
+  b->read_buf = apr_palloc(conn->pool, COMPRESSED_READBUF_SIZE);
+  b->write_buf = svn_stringbuf_create_ensure(COMPRESSED_READBUF_SIZE,
+                                             conn->pool);
+
+  zerr = inflateInit(&b->in);
+  if (zerr != Z_OK)
+    return zlib_error(&b->in, zerr, _("Can't initialize decompression"));
+  zerr = deflateInit(&b->out, COMPRESSION_LEVEL);
+  if (zerr != Z_OK)
+    {
+      inflateEnd(&b->in);
+      return zlib_error(&b->out, zerr, _("Can't initialize compression"));
+    }
+  apr_pool_cleanup_register(conn->pool, b, cleanup_compression,
+                            apr_pool_cleanup_null);
+
+  /* Anything left in the read buffer was sent after the other side
+     switched to compression, so it has to be inflated, too. */
+  if (conn->read_end > conn->read_ptr)
+    {
+      apr_size_t len = conn->read_end - conn->read_ptr;
+      char *data = apr_pmemdup(conn->pool, conn->read_ptr, len);
+
+      b->in.next_in = (Bytef *) data;
+      b->in.avail_in = (uInt) len;
+      conn->read_end = conn->read_ptr;
+    }
+
+  /* Wrap the existing stream. */
+  b->stream = conn->stream;
+  conn->stream = svn_ra_svn__stream_create(b, compress_read_cb,
+                                           compress_write_cb,
+                                           compress_timeout_cb,
+                                           compress_pending_cb, conn->pool);
+  conn->compressed = TRUE;
+
+  return SVN_NO_ERROR;
+}
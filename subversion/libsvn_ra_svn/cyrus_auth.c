@@ -624,6 +624,10 @@ static void sasl_timeout_cb(void *baton, apr_interval_time_t interval)
 static svn_boolean_t sasl_pending_cb(void *baton)
 {
   sasl_baton_t *sasl_baton = baton;
+
+  /* Data already decoded counts as pending, too. */
+  if (sasl_baton->read_buf && sasl_baton->read_len > 0)
+    return TRUE;
   return svn_ra_svn__stream_pending(sasl_baton->stream);
 }
 
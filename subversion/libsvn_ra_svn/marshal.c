@@ -38,6 +38,8 @@
 #include "svn_pools.h"
 #include "svn_ra_svn.h"
 #include "svn_private_config.h"
+#include "private/svn_ra_svn_private.h"
+#include "private/svn_trace.h"
 
 #include "ra_svn.h"
 
@@ -58,12 +60,19 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn(apr_socket_t *sock,
   conn->encrypted = FALSE;
 #endif
   conn->session = NULL;
+  conn->read_buf = apr_palloc(pool, SVN_RA_SVN__READBUF_SIZE);
+  conn->read_buf_size = SVN_RA_SVN__READBUF_SIZE;
   conn->read_ptr = conn->read_buf;
   conn->read_end = conn->read_buf;
+  conn->write_buf = apr_palloc(pool, SVN_RA_SVN__WRITEBUF_SIZE);
+  conn->write_buf_size = SVN_RA_SVN__WRITEBUF_SIZE;
   conn->write_pos = 0;
   conn->block_handler = NULL;
   conn->block_baton = NULL;
   conn->capabilities = apr_hash_make(pool);
+  conn->compressed = FALSE;
+  conn->bytes_read = 0;
+  conn->bytes_written = 0;
   conn->pool = pool;
 
   if (sock != NULL)
@@ -132,6 +141,20 @@ svn_boolean_t svn_ra_svn__input_waiting(svn_ra_svn_conn_t *conn,
   return svn_ra_svn__stream_pending(conn->stream);
 }
 
+svn_boolean_t svn_ra_svn__data_available(svn_ra_svn_conn_t *conn)
+{
+  return (conn->read_ptr < conn->read_end
+          || svn_ra_svn__stream_pending(conn->stream));
+}
+
+void svn_ra_svn__get_io_counts(apr_uint64_t *bytes_read,
+                               apr_uint64_t *bytes_written,
+                               svn_ra_svn_conn_t *conn)
+{
+  *bytes_read = conn->bytes_read;
+  *bytes_written = conn->bytes_written;
+}
+
 /* --- WRITE BUFFER MANAGEMENT --- */
 
 /* Write bytes into the write buffer until either the write buffer is
@@ -141,7 +164,7 @@ static const char *writebuf_push(svn_ra_svn_conn_t *conn, const char *data,
 {
   apr_ssize_t buflen, copylen;
 
-  buflen = sizeof(conn->write_buf) - conn->write_pos;
+  buflen = conn->write_buf_size - conn->write_pos;
   copylen = (buflen < end - data) ? buflen : end - data;
   memcpy(conn->write_buf + conn->write_pos, data, copylen);
   conn->write_pos += copylen;
@@ -176,6 +199,7 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
           SVN_ERR(conn->block_handler(conn, subpool, conn->block_baton));
         }
       data += count;
+      conn->bytes_written += count;
 
       if (session)
         {
@@ -196,7 +220,7 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 /* Write data from the write buffer out to the socket. */
 static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
 {
-  int write_pos = conn->write_pos;
+  apr_size_t write_pos = conn->write_pos;
 
   /* Clear conn->write_pos first in case the block handler does a read. */
   conn->write_pos = 0;
@@ -204,22 +228,116 @@ static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Write data from the write buffer, followed by the LEN bytes at DATA,
+ * out to the socket, with as few system calls as the stream allows. */
+static svn_error_t *writebuf_flush_with(svn_ra_svn_conn_t *conn,
+                                        apr_pool_t *pool,
+                                        const char *data, apr_size_t len)
+{
+  struct iovec vec[2];
+  int first = 0;
+  apr_size_t count;
+  apr_pool_t *subpool = NULL;
+  svn_ra_svn__session_baton_t *session = conn->session;
+
+  vec[0].iov_base = conn->write_buf;
+  vec[0].iov_len = conn->write_pos;
+  vec[1].iov_base = (char *)data;
+  vec[1].iov_len = len;
+
+  /* Clear conn->write_pos first in case the block handler does a read. */
+  conn->write_pos = 0;
+
+  while (TRUE)
+    {
+      while (first < 2 && vec[first].iov_len == 0)
+        first++;
+      if (first == 2)
+        break;
+
+      if (session && session->callbacks &&
+          session->callbacks->cancel_func)
+        SVN_ERR((session->callbacks->cancel_func)
+                   (session->callbacks_baton));
+
+      SVN_ERR(svn_ra_svn__stream_writev(conn->stream, vec + first,
+                                        2 - first, &count));
+      if (count == 0)
+        {
+          if (!subpool)
+            subpool = svn_pool_create(pool);
+          else
+            svn_pool_clear(subpool);
+          SVN_ERR(conn->block_handler(conn, subpool, conn->block_baton));
+        }
+      conn->bytes_written += count;
+
+      if (session)
+        {
+          const svn_ra_callbacks2_t *cb = session->callbacks;
+          session->bytes_written += count;
+
+          if (cb && cb->progress_func)
+            (cb->progress_func)(session->bytes_written + session->bytes_read,
+                                -1, cb->progress_baton, subpool);
+        }
+
+      /* Skip what has been written. */
+      while (count > 0)
+        {
+          apr_size_t skip = (count < vec[first].iov_len)
+                            ? count : vec[first].iov_len;
+
+          vec[first].iov_base = (char *)vec[first].iov_base + skip;
+          vec[first].iov_len -= skip;
+          count -= skip;
+          if (vec[first].iov_len == 0)
+            first++;
+        }
+    }
+
+  if (subpool)
+    svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+/* Double the size of the write buffer, which must be empty, unless it
+ * has reached SVN_RA_SVN__MAX_BUF_SIZE. */
+static void writebuf_grow(svn_ra_svn_conn_t *conn)
+{
+  if (conn->write_pos == 0
+      && conn->write_buf_size < SVN_RA_SVN__MAX_BUF_SIZE)
+    {
+      conn->write_buf_size *= 2;
+      conn->write_buf = apr_palloc(conn->pool, conn->write_buf_size);
+    }
+}
+
 static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                    const char *data, apr_size_t len)
 {
   const char *end = data + len;
 
-  if (conn->write_pos > 0 && conn->write_pos + len > sizeof(conn->write_buf))
+  if (conn->write_pos + len > conn->write_buf_size)
     {
+      /* We're sending more than fits into the buffer, so let it grow for
+         what may follow. */
+      if (len >= conn->write_buf_size / 2)
+        {
+          /* Send large items, like svndiff chunks, right from the
+             caller's memory instead of copying them. */
+          SVN_ERR(writebuf_flush_with(conn, pool, data, len));
+          writebuf_grow(conn);
+          return SVN_NO_ERROR;
+        }
+
       /* Fill and then empty the write buffer. */
       data = writebuf_push(conn, data, end);
       SVN_ERR(writebuf_flush(conn, pool));
+      writebuf_grow(conn);
     }
 
-  if (end - data > (apr_ssize_t)sizeof(conn->write_buf))
-    SVN_ERR(writebuf_output(conn, pool, data, end - data));
-  else
-    writebuf_push(conn, data, end);
+  writebuf_push(conn, data, end);
   return SVN_NO_ERROR;
 }
 
@@ -267,6 +385,7 @@ static svn_error_t *readbuf_input(svn_ra_svn_conn_t *conn, char *data,
   SVN_ERR(svn_ra_svn__stream_read(conn->stream, data, len));
   if (*len == 0)
     return svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
+  conn->bytes_read += *len;
 
   if (session)
     {
@@ -288,7 +407,17 @@ static svn_error_t *readbuf_fill(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
 
   SVN_ERR_ASSERT(conn->read_ptr == conn->read_end);
   SVN_ERR(writebuf_flush(conn, pool));
-  len = sizeof(conn->read_buf);
+
+  /* If the last read filled the whole buffer, more data is probably
+     coming in; read it in larger chunks. */
+  if (conn->read_end == conn->read_buf + conn->read_buf_size
+      && conn->read_buf_size < SVN_RA_SVN__MAX_BUF_SIZE)
+    {
+      conn->read_buf_size *= 2;
+      conn->read_buf = apr_palloc(conn->pool, conn->read_buf_size);
+    }
+
+  len = conn->read_buf_size;
   SVN_ERR(readbuf_input(conn, conn->read_buf, &len, pool));
   conn->read_ptr = conn->read_buf;
   conn->read_end = conn->read_buf + len;
@@ -324,7 +453,7 @@ static svn_error_t *readbuf_read(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   data = readbuf_drain(conn, data, end);
 
   /* Read large chunks directly into buffer. */
-  while (end - data > (apr_ssize_t)sizeof(conn->read_buf))
+  while (end - data > (apr_ssize_t)conn->read_buf_size)
     {
       SVN_ERR(writebuf_flush(conn, pool));
       count = end - data;
@@ -346,7 +475,7 @@ static svn_error_t *readbuf_read(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 static svn_error_t *readbuf_skip_leading_garbage(svn_ra_svn_conn_t *conn,
                                                  apr_pool_t *pool)
 {
-  char buf[256];  /* Must be smaller than sizeof(conn->read_buf) - 1. */
+  char buf[256];  /* Must be smaller than SVN_RA_SVN__READBUF_SIZE - 1. */
   const char *p, *end;
   apr_size_t len;
   svn_boolean_t lparen = FALSE;
@@ -536,15 +665,19 @@ svn_error_t *svn_ra_svn_write_tuple(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 
 /* --- READING DATA ITEMS --- */
 
+/* The largest string length we allocate memory for before any of the
+ * string's data has arrived.  Longer strings get their memory as the data
+ * comes in, so that the sender can't make us allocate an arbitrary amount
+ * of memory without actually sending us that much data. */
+#define SUSPICIOUS_HUGE_STRING 0x100000
+
 /* Read LEN bytes from CONN into already-allocated structure ITEM.
  * Afterwards, *ITEM is of type 'SVN_RA_SVN_STRING', and its string
  * data is allocated in POOL. */
 static svn_error_t *read_string(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                 svn_ra_svn_item_t *item, apr_uint64_t len)
 {
-  char readbuf[4096];
-  apr_size_t readbuf_len;
-  svn_stringbuf_t *stringbuf = svn_stringbuf_create("", pool);
+  svn_stringbuf_t *stringbuf;
 
   /* We can't store strings longer than the maximum size of apr_size_t,
    * so check for wrapping */
@@ -552,16 +685,35 @@ static svn_error_t *read_string(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
     return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
                             _("String length larger than maximum"));
 
-  while (len)
+  if (len <= (apr_uint64_t)(conn->read_end - conn->read_ptr))
+    {
+      /* The whole string has been read already; copy it straight out of
+       * the read buffer. */
+      stringbuf = svn_stringbuf_ncreate(conn->read_ptr, (apr_size_t)len,
+                                        pool);
+      conn->read_ptr += len;
+    }
+  else
     {
-      readbuf_len = len > sizeof(readbuf) ? sizeof(readbuf) : (apr_size_t)len;
-
-      SVN_ERR(readbuf_read(conn, pool, readbuf, readbuf_len));
-      /* Read into a stringbuf_t to so we don't allow the sender to allocate
-       * an arbitrary amount of memory without actually sending us that much
-       * data */
-      svn_stringbuf_appendbytes(stringbuf, readbuf, readbuf_len);
-      len -= readbuf_len;
+      /* Read the data right into the string.  readbuf_read() bypasses the
+       * read buffer for large amounts, so svndiff chunks and the like get
+       * copied only once, from the connection into their final place. */
+      stringbuf = svn_stringbuf_create_ensure(
+                    len < SUSPICIOUS_HUGE_STRING ? (apr_size_t)len
+                                                 : SUSPICIOUS_HUGE_STRING,
+                    pool);
+      while (len)
+        {
+          apr_size_t chunk_len = len < SUSPICIOUS_HUGE_STRING
+                                 ? (apr_size_t)len : SUSPICIOUS_HUGE_STRING;
+
+          svn_stringbuf_ensure(stringbuf, stringbuf->len + chunk_len + 1);
+          SVN_ERR(readbuf_read(conn, pool, stringbuf->data + stringbuf->len,
+                               chunk_len));
+          stringbuf->len += chunk_len;
+          len -= chunk_len;
+        }
+      stringbuf->data[stringbuf->len] = '\0';
     }
 
   item->kind = SVN_RA_SVN_STRING;
@@ -876,8 +1028,15 @@ svn_error_t *svn_ra_svn_read_cmd_response(svn_ra_svn_conn_t *conn,
   const char *status;
   apr_array_header_t *params;
   svn_error_t *err;
+  apr_time_t start;
+
+  /* The span covers waiting for the server to answer. */
+  SVN_TRACE__BEGIN(ra_svn_read_cmd_response, start);
+  err = svn_ra_svn_read_tuple(conn, pool, "wl", &status, &params);
+  SVN_TRACE__END(ra_svn_read_cmd_response, start,
+                 err ? "error" : status);
+  SVN_ERR(err);
 
-  SVN_ERR(svn_ra_svn_read_tuple(conn, pool, "wl", &status, &params));
   if (strcmp(status, "success") == 0)
     {
       va_start(ap, fmt);
@@ -895,6 +1054,87 @@ svn_error_t *svn_ra_svn_read_cmd_response(svn_ra_svn_conn_t *conn,
                            status);
 }
 
+svn_error_t *svn_ra_svn__read_command(const char **cmdname,
+                                      apr_array_header_t **params,
+                                      svn_ra_svn_conn_t *conn,
+                                      svn_boolean_t error_on_disconnect,
+                                      apr_pool_t *pool)
+{
+  svn_error_t *err;
+
+  err = svn_ra_svn_read_tuple(conn, pool, "wl", cmdname, params);
+  if (err)
+    {
+      if (!error_on_disconnect
+          && err->apr_err == SVN_ERR_RA_SVN_CONNECTION_CLOSED)
+        {
+          svn_error_clear(err);
+          *cmdname = NULL;
+          return SVN_NO_ERROR;
+        }
+      return err;
+    }
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *svn_ra_svn__run_command(svn_boolean_t *terminate,
+                                     apr_hash_t *cmd_hash,
+                                     void *baton,
+                                     svn_ra_svn_conn_t *conn,
+                                     const char *cmdname,
+                                     apr_array_header_t *params,
+                                     apr_pool_t *pool)
+{
+  const svn_ra_svn_cmd_entry_t *command;
+  svn_error_t *err, *write_err;
+
+  *terminate = FALSE;
+  command = apr_hash_get(cmd_hash, cmdname, APR_HASH_KEY_STRING);
+
+  if (command)
+    err = (*command->handler)(conn, pool, params, baton);
+  else
+    {
+      err = svn_error_createf(SVN_ERR_RA_SVN_UNKNOWN_CMD, NULL,
+                              _("Unknown command '%s'"), cmdname);
+      err = svn_error_create(SVN_ERR_RA_SVN_CMD_ERR, err, NULL);
+    }
+
+  if (err && err->apr_err == SVN_ERR_RA_SVN_CMD_ERR)
+    {
+      write_err = svn_ra_svn_write_cmd_failure(conn, pool, err->child);
+      svn_error_clear(err);
+      if (write_err)
+        return write_err;
+    }
+  else if (err)
+    return err;
+
+  *terminate = (command && command->terminate);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *svn_ra_svn__handle_command(svn_boolean_t *terminate,
+                                        apr_hash_t *cmd_hash,
+                                        void *baton,
+                                        svn_ra_svn_conn_t *conn,
+                                        svn_boolean_t error_on_disconnect,
+                                        apr_pool_t *pool)
+{
+  const char *cmdname;
+  apr_array_header_t *params;
+
+  SVN_ERR(svn_ra_svn__read_command(&cmdname, &params, conn,
+                                   error_on_disconnect, pool));
+  if (! cmdname)
+    {
+      *terminate = TRUE;
+      return SVN_NO_ERROR;
+    }
+  return svn_ra_svn__run_command(terminate, cmd_hash, baton, conn,
+                                 cmdname, params, pool);
+}
+
 svn_error_t *svn_ra_svn_handle_commands2(svn_ra_svn_conn_t *conn,
                                          apr_pool_t *pool,
                                          const svn_ra_svn_cmd_entry_t *commands,
@@ -903,53 +1143,18 @@ svn_error_t *svn_ra_svn_handle_commands2(svn_ra_svn_conn_t *conn,
 {
   apr_pool_t *subpool = svn_pool_create(pool);
   apr_pool_t *iterpool = svn_pool_create(subpool);
-  const char *cmdname;
   const svn_ra_svn_cmd_entry_t *command;
-  svn_error_t *err, *write_err;
-  apr_array_header_t *params;
   apr_hash_t *cmd_hash = apr_hash_make(subpool);
+  svn_boolean_t terminate = FALSE;
 
   for (command = commands; command->cmdname; command++)
     apr_hash_set(cmd_hash, command->cmdname, APR_HASH_KEY_STRING, command);
 
-  while (1)
+  while (!terminate)
     {
       svn_pool_clear(iterpool);
-      err = svn_ra_svn_read_tuple(conn, iterpool, "wl", &cmdname, &params);
-      if (err)
-        {
-          if (!error_on_disconnect
-              && err->apr_err == SVN_ERR_RA_SVN_CONNECTION_CLOSED)
-            {
-              svn_error_clear(err);
-              svn_pool_destroy(subpool);
-              return SVN_NO_ERROR;
-            }
-          return err;
-        }
-      command = apr_hash_get(cmd_hash, cmdname, APR_HASH_KEY_STRING);
-
-      if (command)
-        err = (*command->handler)(conn, iterpool, params, baton);
-      else
-        {
-          err = svn_error_createf(SVN_ERR_RA_SVN_UNKNOWN_CMD, NULL,
-                                  _("Unknown command '%s'"), cmdname);
-          err = svn_error_create(SVN_ERR_RA_SVN_CMD_ERR, err, NULL);
-        }
-
-      if (err && err->apr_err == SVN_ERR_RA_SVN_CMD_ERR)
-        {
-          write_err = svn_ra_svn_write_cmd_failure(conn, iterpool, err->child);
-          svn_error_clear(err);
-          if (write_err)
-            return write_err;
-        }
-      else if (err)
-        return err;
-
-      if (command && command->terminate)
-        break;
+      SVN_ERR(svn_ra_svn__handle_command(&terminate, cmd_hash, baton, conn,
+                                         error_on_disconnect, iterpool));
     }
   svn_pool_destroy(iterpool);
   svn_pool_destroy(subpool);
@@ -56,9 +56,12 @@ typedef svn_error_t *(*ra_svn_block_handler_t)(svn_ra_svn_conn_t *conn,
                                                apr_pool_t *pool,
                                                void *baton);
 
-/* The size of our per-connection read and write buffers. */
+/* The initial size of our per-connection read and write buffers.  They
+ * double in size whenever they get filled, up to SVN_RA_SVN__MAX_BUF_SIZE,
+ * so that bulk transfers need fewer system calls. */
 #define SVN_RA_SVN__READBUF_SIZE 4096
 #define SVN_RA_SVN__WRITEBUF_SIZE 4096
+#define SVN_RA_SVN__MAX_BUF_SIZE (128 * 1024)
 
 /* Create forward reference */
 typedef struct svn_ra_svn__session_baton_t svn_ra_svn__session_baton_t;
@@ -75,17 +78,21 @@ struct svn_ra_svn_conn_st {
   apr_socket_t *sock;
   svn_boolean_t encrypted;
 #endif
-  char read_buf[SVN_RA_SVN__READBUF_SIZE];
+  char *read_buf;
+  apr_size_t read_buf_size;
   char *read_ptr;
   char *read_end;
-  char write_buf[SVN_RA_SVN__WRITEBUF_SIZE];
-  int write_pos;
+  char *write_buf;
+  apr_size_t write_buf_size;
+  apr_size_t write_pos;
   const char *uuid;
   const char *repos_root;
   ra_svn_block_handler_t block_handler;
   void *block_baton;
   apr_hash_t *capabilities;
   char *remote_ip;
+  svn_boolean_t compressed;
+  apr_uint64_t bytes_read, bytes_written; /* before any compression */
   apr_pool_t *pool;
 };
 
@@ -148,12 +155,31 @@ svn_ra_svn__stream_t *svn_ra_svn__stream_create(void *baton,
                                                 ra_svn_pending_fn_t pending_cb,
                                                 apr_pool_t *pool);
 
+/* Callback function that writes the NVEC buffers in VEC to BATON, like
+ * svn_write_fn_t, setting *LEN to the number of bytes written. */
+typedef svn_error_t *(*ra_svn_writev_fn_t)(void *baton,
+                                           const struct iovec *vec,
+                                           int nvec,
+                                           apr_size_t *len);
+
+/* Let STREAM write several buffers at once using WRITEV_CB. */
+void svn_ra_svn__stream_set_writev(svn_ra_svn__stream_t *stream,
+                                   ra_svn_writev_fn_t writev_cb);
+
 /* Write *LEN bytes from DATA to STREAM, returning the number of bytes
  * written in *LEN.
  */
 svn_error_t *svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
                                       const char *data, apr_size_t *len);
 
+/* Write the NVEC buffers in VEC to STREAM, in order, returning the number
+ * of bytes written in *LEN.  If STREAM can't write several buffers at
+ * once, this writes (part of) the first non-empty one only.
+ */
+svn_error_t *svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                                       const struct iovec *vec, int nvec,
+                                       apr_size_t *len);
+
 /* Read *LEN bytes from STREAM into DATA, returning the number of bytes
  * read in *LEN.
  */
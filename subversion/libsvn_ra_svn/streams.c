@@ -40,6 +40,7 @@ struct svn_ra_svn__stream_st {
   void *baton;
   ra_svn_pending_fn_t pending_fn;
   ra_svn_timeout_fn_t timeout_fn;
+  ra_svn_writev_fn_t writev_fn;
 };
 
 typedef struct {
@@ -92,6 +93,18 @@ file_write_cb(void *baton, const char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+/* Implements ra_svn_writev_fn_t */
+static svn_error_t *
+file_writev_cb(void *baton, const struct iovec *vec, int nvec,
+               apr_size_t *len)
+{
+  file_baton_t *b = baton;
+  apr_status_t status = apr_file_writev(b->out_file, vec, nvec, len);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't write to connection"));
+  return SVN_NO_ERROR;
+}
+
 /* Implements ra_svn_timeout_fn_t */
 static void
 file_timeout_cb(void *baton, apr_interval_time_t interval)
@@ -119,14 +132,17 @@ svn_ra_svn__stream_from_files(apr_file_t *in_file,
                               apr_pool_t *pool)
 {
   file_baton_t *b = apr_palloc(pool, sizeof(*b));
+  svn_ra_svn__stream_t *s;
 
   b->in_file = in_file;
   b->out_file = out_file;
   b->pool = pool;
 
-  return svn_ra_svn__stream_create(b, file_read_cb, file_write_cb,
-                                   file_timeout_cb, file_pending_cb,
-                                   pool);
+  s = svn_ra_svn__stream_create(b, file_read_cb, file_write_cb,
+                                file_timeout_cb, file_pending_cb,
+                                pool);
+  svn_ra_svn__stream_set_writev(s, file_writev_cb);
+  return s;
 }
 
 /* Functions to implement a socket backed svn_ra_svn__stream_t. */
@@ -171,6 +187,18 @@ sock_write_cb(void *baton, const char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+/* Implements ra_svn_writev_fn_t */
+static svn_error_t *
+sock_writev_cb(void *baton, const struct iovec *vec, int nvec,
+               apr_size_t *len)
+{
+  sock_baton_t *b = baton;
+  apr_status_t status = apr_socket_sendv(b->sock, vec, nvec, len);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't write to connection"));
+  return SVN_NO_ERROR;
+}
+
 /* Implements ra_svn_timeout_fn_t */
 static void
 sock_timeout_cb(void *baton, apr_interval_time_t interval)
@@ -197,13 +225,16 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
                              apr_pool_t *pool)
 {
   sock_baton_t *b = apr_palloc(pool, sizeof(*b));
+  svn_ra_svn__stream_t *s;
 
   b->sock = sock;
   b->pool = pool;
 
-  return svn_ra_svn__stream_create(b, sock_read_cb, sock_write_cb,
-                                   sock_timeout_cb, sock_pending_cb,
-                                   pool);
+  s = svn_ra_svn__stream_create(b, sock_read_cb, sock_write_cb,
+                                sock_timeout_cb, sock_pending_cb,
+                                pool);
+  svn_ra_svn__stream_set_writev(s, sock_writev_cb);
+  return s;
 }
 
 svn_ra_svn__stream_t *
@@ -224,9 +255,17 @@ svn_ra_svn__stream_create(void *baton,
   s->baton = baton;
   s->timeout_fn = timeout_cb;
   s->pending_fn = pending_cb;
+  s->writev_fn = NULL;
   return s;
 }
 
+void
+svn_ra_svn__stream_set_writev(svn_ra_svn__stream_t *stream,
+                              ra_svn_writev_fn_t writev_cb)
+{
+  stream->writev_fn = writev_cb;
+}
+
 svn_error_t *
 svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
                          const char *data, apr_size_t *len)
@@ -234,6 +273,24 @@ svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
   return svn_stream_write(stream->stream, data, len);
 }
 
+svn_error_t *
+svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                          const struct iovec *vec, int nvec,
+                          apr_size_t *len)
+{
+  if (stream->writev_fn)
+    return stream->writev_fn(stream->baton, vec, nvec, len);
+
+  while (nvec > 1 && vec->iov_len == 0)
+    {
+      vec++;
+      nvec--;
+    }
+
+  *len = vec->iov_len;
+  return svn_stream_write(stream->stream, vec->iov_base, len);
+}
+
 svn_error_t *
 svn_ra_svn__stream_read(svn_ra_svn__stream_t *stream, char *data,
                         apr_size_t *len)
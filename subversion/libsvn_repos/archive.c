@@ -0,0 +1,246 @@
+/* archive.c --- writing tar archives of repository trees
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_path.h"
+#include "svn_props.h"
+#include "svn_time.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+#include "svn_private_config.h"
+
+#include "private/svn_fs_private.h"
+#include "private/svn_tar.h"
+#include "repos.h"
+
+/* The state of an archive being written. */
+typedef struct archive_baton_t
+{
+  svn_fs_root_t *root;
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
+  svn_stream_t *stream;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* The dates of the revisions seen so far, mapping svn_revnum_t to
+     apr_time_t, both allocated in POOL.  Most nodes of a tree share
+     their last changed revision with many others. */
+  apr_hash_t *dates;
+  apr_pool_t *pool;
+} archive_baton_t;
+
+/* Set *MTIME to the date of the revision in which PATH was last changed,
+   using the cache in AB. */
+static svn_error_t *
+get_mtime(apr_time_t *mtime,
+          archive_baton_t *ab,
+          const char *path,
+          apr_pool_t *scratch_pool)
+{
+  svn_revnum_t rev;
+  apr_time_t *date;
+
+  SVN_ERR(svn_fs_node_created_rev(&rev, ab->root, path, scratch_pool));
+  date = apr_hash_get(ab->dates, &rev, sizeof(rev));
+  if (! date)
+    {
+      svn_string_t *datestring;
+      svn_revnum_t *key = apr_palloc(ab->pool, sizeof(*key));
+
+      date = apr_pcalloc(ab->pool, sizeof(*date));
+      SVN_ERR(svn_fs_revision_prop(&datestring, svn_fs_root_fs(ab->root),
+                                   rev, SVN_PROP_REVISION_DATE,
+                                   scratch_pool));
+      if (datestring)
+        SVN_ERR(svn_time_from_cstring(date, datestring->data, scratch_pool));
+
+      *key = rev;
+      apr_hash_set(ab->dates, key, sizeof(*key), date);
+    }
+
+  *mtime = *date;
+  return SVN_NO_ERROR;
+}
+
+/* Write the file PATH to the archive AB as NAME. */
+static svn_error_t *
+archive_file(archive_baton_t *ab,
+             const char *path,
+             const char *name,
+             apr_pool_t *pool)
+{
+  apr_hash_t *props;
+  apr_time_t mtime;
+  svn_filesize_t size;
+  svn_stream_t *contents;
+  svn_boolean_t executable;
+
+  SVN_ERR(get_mtime(&mtime, ab, path, pool));
+  SVN_ERR(svn_fs_node_proplist(&props, ab->root, path, pool));
+  SVN_ERR(svn_fs_file_contents(&contents, ab->root, path, pool));
+
+  if (apr_hash_get(props, SVN_PROP_SPECIAL, APR_HASH_KEY_STRING))
+    {
+      svn_string_t *special;
+
+      /* Write symlinks as such; other special files keep their
+         repository form. */
+      SVN_ERR(svn_string_from_stream(&special, contents, pool, pool));
+      if (strncmp(special->data, "link ", 5) == 0)
+        return svn_tar__write_header(ab->stream, name, svn_node_file,
+                                     special->data + 5, 0, FALSE, mtime,
+                                     pool);
+      contents = svn_stream_from_string(special, pool);
+    }
+
+  executable = apr_hash_get(props, SVN_PROP_EXECUTABLE, APR_HASH_KEY_STRING)
+               != NULL;
+  SVN_ERR(svn_fs_file_length(&size, ab->root, path, pool));
+  SVN_ERR(svn_tar__write_header(ab->stream, name, svn_node_file, NULL,
+                                size, executable, mtime, pool));
+  SVN_ERR(svn_stream_copy3(contents, svn_stream_disown(ab->stream, pool),
+                           ab->cancel_func, ab->cancel_baton, pool));
+  return svn_tar__write_padding(ab->stream, size);
+}
+
+/* Write the contents of the directory PATH to the archive AB, below
+   the member name NAME. */
+static svn_error_t *
+archive_dir(archive_baton_t *ab,
+            const char *path,
+            const char *name,
+            apr_pool_t *pool)
+{
+  apr_array_header_t *entries;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_fs__dir_entries_sorted(&entries, ab->root, path, pool));
+
+  for (i = 0; i < entries->nelts; i++)
+    {
+      svn_fs_dirent_t *fs_dirent = APR_ARRAY_IDX(entries, i,
+                                                 svn_fs_dirent_t *);
+      const char *child_path, *child_name;
+
+      svn_pool_clear(iterpool);
+
+      if (ab->cancel_func)
+        SVN_ERR(ab->cancel_func(ab->cancel_baton));
+
+      child_path = svn_path_join(path, fs_dirent->name, iterpool);
+      if (ab->authz_read_func)
+        {
+          svn_boolean_t readable;
+
+          SVN_ERR(ab->authz_read_func(&readable, ab->root, child_path,
+                                      ab->authz_read_baton, iterpool));
+          if (! readable)
+            continue;
+        }
+
+      child_name = svn_relpath_join(name, fs_dirent->name, iterpool);
+      if (fs_dirent->kind == svn_node_dir)
+        {
+          apr_time_t mtime;
+
+          SVN_ERR(get_mtime(&mtime, ab, child_path, iterpool));
+          SVN_ERR(svn_tar__write_header(ab->stream, child_name, svn_node_dir,
+                                        NULL, 0, FALSE, mtime, iterpool));
+          SVN_ERR(archive_dir(ab, child_path, child_name, iterpool));
+        }
+      else
+        SVN_ERR(archive_file(ab, child_path, child_name, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_archive(svn_fs_root_t *root,
+                  const char *path,
+                  const char *prefix,
+                  svn_repos_authz_func_t authz_read_func,
+                  void *authz_read_baton,
+                  svn_stream_t *stream,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *scratch_pool)
+{
+  archive_baton_t ab;
+  svn_node_kind_t kind;
+
+  if (authz_read_func)
+    {
+      svn_boolean_t readable;
+
+      SVN_ERR(authz_read_func(&readable, root, path, authz_read_baton,
+                              scratch_pool));
+      if (! readable)
+        return svn_error_create(SVN_ERR_AUTHZ_UNREADABLE, NULL,
+                                _("Unreadable path encountered; "
+                                  "access denied"));
+    }
+
+  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+  if (kind == svn_node_none)
+    return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                             _("Path '%s' not found"), path);
+
+  ab.root = root;
+  ab.authz_read_func = authz_read_func;
+  ab.authz_read_baton = authz_read_baton;
+  ab.stream = stream;
+  ab.cancel_func = cancel_func;
+  ab.cancel_baton = cancel_baton;
+  ab.dates = apr_hash_make(scratch_pool);
+  ab.pool = scratch_pool;
+
+  if (kind == svn_node_file)
+    SVN_ERR(archive_file(&ab, path,
+                         *prefix ? prefix : svn_uri_basename(path,
+                                                             scratch_pool),
+                         scratch_pool));
+  else
+    {
+      if (*prefix)
+        {
+          apr_time_t mtime;
+
+          SVN_ERR(get_mtime(&mtime, &ab, path, scratch_pool));
+          SVN_ERR(svn_tar__write_header(stream, prefix, svn_node_dir, NULL,
+                                        0, FALSE, mtime, scratch_pool));
+        }
+      SVN_ERR(archive_dir(&ab, path, prefix, scratch_pool));
+    }
+
+  return svn_tar__write_trailer(stream);
+}
@@ -25,6 +25,8 @@
 
 #include <apr_pools.h>
 #include <apr_file_io.h>
+#include <apr_lib.h>
+#include <apr_strings.h>
 
 #include "svn_pools.h"
 #include "svn_error.h"
@@ -33,37 +35,55 @@
 #include "svn_repos.h"
 #include "svn_config.h"
 #include "svn_ctype.h"
+#include "private/svn_config_private.h"
 
 
 /*** Structures. ***/
 
-/* Information for the config enumerators called during authz
-   lookup. */
-struct authz_lookup_baton {
-  /* The authz configuration. */
-  svn_config_t *config;
-
-  /* The user to authorize. */
-  const char *user;
+/* One rule of an authz file section. */
+typedef struct authz_rule_t
+{
+  /* The name part of the rule's name-value pair: who it applies to. */
+  const char *match;
 
-  /* Explicitly granted rights. */
+  /* The access the rule explicitly grants and denies. */
   svn_repos_authz_access_t allow;
-  /* Explicitly denied rights. */
   svn_repos_authz_access_t deny;
+} authz_rule_t;
 
-  /* The rights required by the caller of the lookup. */
-  svn_repos_authz_access_t required_access;
+/* The rules of one section of an authz file. */
+typedef struct authz_section_t
+{
+  /* The section name, usually a path with an optional repository
+     name in front. */
+  const char *name;
 
-  /* The following are used exclusively in recursive lookups. */
+  /* The rules of the section, as authz_rule_t. */
+  apr_array_header_t *rules;
+} authz_section_t;
 
-  /* The path in the repository to authorize. */
-  const char *repos_path;
-  /* repos_path prefixed by the repository name. */
-  const char *qualified_repos_path;
+/* What the rules of one section that apply to a given user explicitly
+   grant and deny together. */
+typedef struct authz_access_t
+{
+  /* The section name. */
+  const char *section;
 
-  /* Whether, at the end of a recursive lookup, access is granted. */
-  svn_boolean_t access;
-};
+  svn_repos_authz_access_t allow;
+  svn_repos_authz_access_t deny;
+} authz_access_t;
+
+/* The rules of an authz file resolved for one user. */
+typedef struct authz_user_t
+{
+  /* Maps the case-folded names of the sections that have rules applying
+     to the user (section names are case-insensitive in svn_config_t) to
+     their authz_access_t *. */
+  apr_hash_t *sections;
+
+  /* The same authz_access_t *, for walks over all of them. */
+  apr_array_header_t *accesses;
+} authz_user_t;
 
 /* Information for the config enumeration functions called during the
    validation process. */
@@ -73,15 +93,28 @@ struct authz_validate_baton {
                            enumerator, if any. */
 };
 
-/* Currently this structure is just a wrapper around a
-   svn_config_t. */
+/* An authz file, with its rules compiled when it is read, and resolved
+   for each user on first use, so that an access check only needs hash
+   lookups for the path and its parents. */
 struct svn_authz_t
 {
   svn_config_t *cfg;
+
+  /* All sections of CFG, as authz_section_t *. */
+  apr_array_header_t *sections;
+
+  /* The rules resolved for the users checked so far: maps user names to
+     authz_user_t *.  ANONYMOUS is the same for the anonymous user, or
+     NULL. */
+  apr_hash_t *users;
+  authz_user_t *anonymous;
+
+  /* The pool all of the above is allocated in. */
+  apr_pool_t *pool;
 };
 
 
-
+
 /*** Checking access. ***/
 
 /* Determine whether the REQUIRED access is granted given what authz
@@ -195,25 +228,29 @@ authz_group_contains_user(svn_config_t *cfg,
 }
 
 
-/* Determines whether an authz rule applies to the current
- * user, given the name part of the rule's name-value pair
- * in RULE_MATCH_STRING and the authz_lookup_baton object
- * B with the username in question.
+/* Determines whether an authz rule applies to USER (NULL for anonymous
+ * access), given the name part of the rule's name-value pair in
+ * RULE_MATCH_STRING.  The group and alias definitions are in CFG.
+ * GROUPS caches which groups USER is a member of, mapping group names
+ * to "y" or "n".  Use POOL for temporary allocations.
  */
 static svn_boolean_t
 authz_line_applies_to_user(const char *rule_match_string,
-                           struct authz_lookup_baton *b,
+                           svn_config_t *cfg,
+                           const char *user,
+                           apr_hash_t *groups,
                            apr_pool_t *pool)
 {
   /* If the rule has an inversion, recurse and invert the result. */
   if (rule_match_string[0] == '~')
-    return !authz_line_applies_to_user(&rule_match_string[1], b, pool);
+    return !authz_line_applies_to_user(&rule_match_string[1], cfg, user,
+                                       groups, pool);
 
   /* Check for special tokens. */
   if (strcmp(rule_match_string, "$anonymous") == 0)
-    return (b->user == NULL);
+    return (user == NULL);
   if (strcmp(rule_match_string, "$authenticated") == 0)
-    return (b->user != NULL);
+    return (user != NULL);
 
   /* Check for a wildcard rule. */
   if (strcmp(rule_match_string, "*") == 0)
@@ -230,224 +267,257 @@ authz_line_applies_to_user(const char *rule_match_string,
   /* If the session is anonymous, then a user/group
    * rule definitely won't match.
    */
-  if (b->user == NULL)
+  if (user == NULL)
     return FALSE;
 
   /* Process the rule depending on whether it is
    * a user, alias or group rule.
    */
   if (rule_match_string[0] == '@')
-    return authz_group_contains_user(
-      b->config, &rule_match_string[1], b->user, pool);
+    {
+      const char *group = &rule_match_string[1];
+      const char *member = apr_hash_get(groups, group, APR_HASH_KEY_STRING);
+
+      if (member == NULL)
+        {
+          member = authz_group_contains_user(cfg, group, user, pool)
+                     ? "y" : "n";
+          apr_hash_set(groups, group, APR_HASH_KEY_STRING, member);
+        }
+
+      return (*member == 'y');
+    }
   else if (rule_match_string[0] == '&')
-    return authz_alias_is_user(
-      b->config, &rule_match_string[1], b->user, pool);
+    return authz_alias_is_user(cfg, &rule_match_string[1], user, pool);
   else
-    return (strcmp(b->user, rule_match_string) == 0);
+    return (strcmp(user, rule_match_string) == 0);
+}
+
+
+/* Return NAME with its ASCII letters folded to lower case, the way
+   svn_config_t compares section names, allocated in POOL. */
+static const char *
+authz_fold_case(const char *name, apr_pool_t *pool)
+{
+  char *folded = apr_pstrdup(pool, name);
+  char *p;
+
+  for (p = folded; *p; p++)
+    *p = (char)apr_tolower(*p);
+
+  return folded;
 }
 
 
-/* Callback to parse one line of an authz file and update the
- * authz_baton accordingly.
+/* Return the rules of AUTHZ resolved for USER, resolving them first if
+ * this is the first check for USER.  Use SCRATCH_POOL for temporary
+ * allocations.
  */
-static svn_boolean_t
-authz_parse_line(const char *name, const char *value,
-                 void *baton, apr_pool_t *pool)
+static authz_user_t *
+authz_get_user_rules(svn_authz_t *authz,
+                     const char *user,
+                     apr_pool_t *scratch_pool)
 {
-  struct authz_lookup_baton *b = baton;
+  authz_user_t *rules;
+  apr_hash_t *groups;
+  apr_pool_t *iterpool;
+  int i, j;
+
+  rules = user ? apr_hash_get(authz->users, user, APR_HASH_KEY_STRING)
+               : authz->anonymous;
+  if (rules)
+    return rules;
+
+  rules = apr_palloc(authz->pool, sizeof(*rules));
+  rules->sections = apr_hash_make(authz->pool);
+  rules->accesses = apr_array_make(authz->pool, 0, sizeof(authz_access_t *));
+
+  groups = apr_hash_make(scratch_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < authz->sections->nelts; i++)
+    {
+      const authz_section_t *section
+        = APR_ARRAY_IDX(authz->sections, i, authz_section_t *);
+      svn_repos_authz_access_t allow = svn_authz_none;
+      svn_repos_authz_access_t deny = svn_authz_none;
 
-  /* Stop if the rule doesn't apply to this user. */
-  if (!authz_line_applies_to_user(name, b, pool))
-    return TRUE;
+      for (j = 0; j < section->rules->nelts; j++)
+        {
+          const authz_rule_t *rule
+            = &APR_ARRAY_IDX(section->rules, j, authz_rule_t);
+
+          svn_pool_clear(iterpool);
+          if (authz_line_applies_to_user(rule->match, authz->cfg, user,
+                                         groups, iterpool))
+            {
+              allow |= rule->allow;
+              deny |= rule->deny;
+            }
+        }
 
-  /* Set the access grants for the rule. */
-  if (strchr(value, 'r'))
-    b->allow |= svn_authz_read;
-  else
-    b->deny |= svn_authz_read;
+      /* A section none of whose rules apply is as good as absent. */
+      if (allow != svn_authz_none || deny != svn_authz_none)
+        {
+          authz_access_t *access = apr_palloc(authz->pool, sizeof(*access));
+
+          access->section = section->name;
+          access->allow = allow;
+          access->deny = deny;
+          APR_ARRAY_PUSH(rules->accesses, authz_access_t *) = access;
+          apr_hash_set(rules->sections,
+                       authz_fold_case(section->name, authz->pool),
+                       APR_HASH_KEY_STRING, access);
+        }
+    }
+  svn_pool_destroy(iterpool);
 
-  if (strchr(value, 'w'))
-    b->allow |= svn_authz_write;
+  if (user)
+    apr_hash_set(authz->users, apr_pstrdup(authz->pool, user),
+                 APR_HASH_KEY_STRING, rules);
   else
-    b->deny |= svn_authz_write;
+    authz->anonymous = rules;
 
-  return TRUE;
+  return rules;
 }
 
 
-/* Callback to parse a section and update the authz_baton if the
- * section denies access to the subtree the baton describes.
+/* Add what the section NAME of RULES grants and denies to *ALLOW and
+ * *DENY.  Use POOL for temporary allocations.
  */
-static svn_boolean_t
-authz_parse_section(const char *section_name, void *baton, apr_pool_t *pool)
+static void
+authz_add_section_access(svn_repos_authz_access_t *allow,
+                         svn_repos_authz_access_t *deny,
+                         const authz_user_t *rules,
+                         const char *name,
+                         apr_pool_t *pool)
 {
-  struct authz_lookup_baton *b = baton;
-  svn_boolean_t conclusive;
-
-  /* Does the section apply to us? */
-  if (svn_path_is_ancestor(b->qualified_repos_path,
-                           section_name) == FALSE
-      && svn_path_is_ancestor(b->repos_path,
-                              section_name) == FALSE)
-    return TRUE;
-
-  /* Work out what this section grants. */
-  b->allow = b->deny = 0;
-  svn_config_enumerate2(b->config, section_name,
-                        authz_parse_line, b, pool);
-
-  /* Has the section explicitly determined an access? */
-  conclusive = authz_access_is_determined(b->allow, b->deny,
-                                          b->required_access);
+  const authz_access_t *access
+    = apr_hash_get(rules->sections, authz_fold_case(name, pool),
+                   APR_HASH_KEY_STRING);
 
-  /* Is access granted OR inconclusive? */
-  b->access = authz_access_is_granted(b->allow, b->deny,
-                                      b->required_access)
-    || !conclusive;
-
-  /* As long as access isn't conclusively denied, carry on. */
-  return b->access;
+  if (access)
+    {
+      *allow |= access->allow;
+      *deny |= access->deny;
+    }
 }
 
 
-/* Validate access to the given user for the given path.  This
- * function checks rules for exactly the given path, and first tries
- * to access a section specific to the given repository before falling
- * back to pan-repository rules.
+/* Validate access to the user whose rules are RULES for the given
+ * path.  This function checks rules for exactly the given path, and
+ * first tries to access a section specific to the given repository
+ * before falling back to pan-repository rules.
  *
  * Update *access_granted to inform the caller of the outcome of the
  * lookup.  Return a boolean indicating whether the access rights were
  * successfully determined.
  */
 static svn_boolean_t
-authz_get_path_access(svn_config_t *cfg, const char *repos_name,
-                      const char *path, const char *user,
+authz_get_path_access(const authz_user_t *rules, const char *repos_name,
+                      const char *path,
                       svn_repos_authz_access_t required_access,
                       svn_boolean_t *access_granted,
                       apr_pool_t *pool)
 {
-  const char *qualified_path;
-  struct authz_lookup_baton baton = { 0 };
-
-  baton.config = cfg;
-  baton.user = user;
+  svn_repos_authz_access_t allow = svn_authz_none;
+  svn_repos_authz_access_t deny = svn_authz_none;
 
   /* Try to locate a repository-specific block first. */
-  qualified_path = apr_pstrcat(pool, repos_name, ":", path, NULL);
-  svn_config_enumerate2(cfg, qualified_path,
-                        authz_parse_line, &baton, pool);
+  authz_add_section_access(&allow, &deny, rules,
+                           apr_pstrcat(pool, repos_name, ":", path, NULL),
+                           pool);
 
-  *access_granted = authz_access_is_granted(baton.allow, baton.deny,
-                                            required_access);
+  *access_granted = authz_access_is_granted(allow, deny, required_access);
 
   /* If the first test has determined access, stop now. */
-  if (authz_access_is_determined(baton.allow, baton.deny,
-                                 required_access))
+  if (authz_access_is_determined(allow, deny, required_access))
     return TRUE;
 
   /* No repository specific rule, try pan-repository rules. */
-  svn_config_enumerate2(cfg, path, authz_parse_line, &baton, pool);
+  authz_add_section_access(&allow, &deny, rules, path, pool);
 
-  *access_granted = authz_access_is_granted(baton.allow, baton.deny,
-                                            required_access);
-  return authz_access_is_determined(baton.allow, baton.deny,
-                                    required_access);
+  *access_granted = authz_access_is_granted(allow, deny, required_access);
+  return authz_access_is_determined(allow, deny, required_access);
 }
 
 
-/* Validate access to the given user for the subtree starting at the
- * given path.  This function walks the whole authz file in search of
- * rules applying to paths in the requested subtree which deny the
- * requested access.
+/* Validate access to the user whose rules are RULES for the subtree
+ * starting at the given path.  This function walks the sections with
+ * rules for the user in search of rules applying to paths in the
+ * requested subtree which deny the requested access.
  *
- * As soon as one is found, or else when the whole ACL file has been
+ * As soon as one is found, or else when all of them have been
  * searched, return the updated authorization status.
  */
 static svn_boolean_t
-authz_get_tree_access(svn_config_t *cfg, const char *repos_name,
-                      const char *path, const char *user,
+authz_get_tree_access(const authz_user_t *rules, const char *repos_name,
+                      const char *path,
                       svn_repos_authz_access_t required_access,
                       apr_pool_t *pool)
 {
-  struct authz_lookup_baton baton = { 0 };
-
-  baton.config = cfg;
-  baton.user = user;
-  baton.required_access = required_access;
-  baton.repos_path = path;
-  baton.qualified_repos_path = apr_pstrcat(pool, repos_name,
-                                           ":", path, NULL);
-  /* Default to access granted if no rules say otherwise. */
-  baton.access = TRUE;
-
-  svn_config_enumerate_sections2(cfg, authz_parse_section,
-                                 &baton, pool);
-
-  return baton.access;
-}
-
-
-/* Callback to parse sections of the configuration file, looking for
-   any kind of granted access.  Implements the
-   svn_config_section_enumerator2_t interface. */
-static svn_boolean_t
-authz_global_parse_section(const char *section_name, void *baton,
-                           apr_pool_t *pool)
-{
-  struct authz_lookup_baton *b = baton;
+  const char *qualified_path = apr_pstrcat(pool, repos_name, ":", path,
+                                           NULL);
+  int i;
 
-  /* Does the section apply to the query? */
-  if (section_name[0] == '/'
-      || strncmp(section_name, b->repos_path,
-                 strlen(b->repos_path)) == 0)
+  for (i = 0; i < rules->accesses->nelts; i++)
     {
-      b->allow = b->deny = svn_authz_none;
-
-      svn_config_enumerate2(b->config, section_name,
-                            authz_parse_line, baton, pool);
-      b->access = authz_access_is_granted(b->allow, b->deny,
-                                          b->required_access);
-
-      /* Continue as long as we don't find a determined, granted access. */
-      return !(b->access
-               && authz_access_is_determined(b->allow, b->deny,
-                                             b->required_access));
+      const authz_access_t *access
+        = APR_ARRAY_IDX(rules->accesses, i, authz_access_t *);
+
+      /* Does the section apply to us? */
+      if (svn_path_is_ancestor(qualified_path, access->section) == FALSE
+          && svn_path_is_ancestor(path, access->section) == FALSE)
+        continue;
+
+      /* Access is denied if the section explicitly denies it. */
+      if (authz_access_is_determined(access->allow, access->deny,
+                                     required_access)
+          && ! authz_access_is_granted(access->allow, access->deny,
+                                       required_access))
+        return FALSE;
     }
 
+  /* Default to access granted if no rules say otherwise. */
   return TRUE;
 }
 
 
-/* Walk through the authz CFG to check if USER has the REQUIRED_ACCESS
+/* Check whether the user whose rules are RULES has the REQUIRED_ACCESS
  * to any path within the REPOSITORY.  Return TRUE if so.  Use POOL
  * for temporary allocations. */
 static svn_boolean_t
-authz_get_global_access(svn_config_t *cfg, const char *repos_name,
-                        const char *user,
+authz_get_global_access(const authz_user_t *rules, const char *repos_name,
                         svn_repos_authz_access_t required_access,
                         apr_pool_t *pool)
 {
-  struct authz_lookup_baton baton = { 0 };
-
-  baton.config = cfg;
-  baton.user = user;
-  baton.required_access = required_access;
-  baton.access = FALSE; /* Deny access by default. */
-  baton.repos_path = apr_pstrcat(pool, repos_name, ":/", NULL);
+  const char *repos_path = apr_pstrcat(pool, repos_name, ":/", NULL);
+  apr_size_t repos_path_len = strlen(repos_path);
+  int i;
 
-  svn_config_enumerate_sections2(cfg, authz_global_parse_section,
-                                 &baton, pool);
+  for (i = 0; i < rules->accesses->nelts; i++)
+    {
+      const authz_access_t *access
+        = APR_ARRAY_IDX(rules->accesses, i, authz_access_t *);
+
+      /* Does the section apply to the query? */
+      if (access->section[0] != '/'
+          && strncmp(access->section, repos_path, repos_path_len) != 0)
+        continue;
+
+      /* Stop as soon as we find a determined, granted access. */
+      if (authz_access_is_granted(access->allow, access->deny,
+                                  required_access)
+          && authz_access_is_determined(access->allow, access->deny,
+                                        required_access))
+        return TRUE;
+    }
 
   /* If walking the configuration was inconclusive, deny access. */
-  if (!authz_access_is_determined(baton.allow,
-                                  baton.deny, baton.required_access))
-    return FALSE;
-
-  return baton.access;
+  return FALSE;
 }
 
 
-
+
 /*** Validating the authz file. ***/
 
 /* Check for errors in GROUP's definition of CFG.  The errors
@@ -709,13 +779,64 @@ static svn_boolean_t authz_validate_section(const char *name,
 
 
 
+/*** Compiling the authz file. ***/
+
+/* Callback to add the rule NAME = VALUE to the authz_section_t BATON.
+   Implements the svn_config_enumerator2_t interface. */
+static svn_boolean_t
+authz_compile_rule(const char *name, const char *value,
+                   void *baton, apr_pool_t *pool)
+{
+  authz_section_t *section = baton;
+  authz_rule_t *rule = apr_array_push(section->rules);
+
+  rule->match = apr_pstrdup(section->rules->pool, name);
+  rule->allow = rule->deny = svn_authz_none;
+
+  /* Set the access grants for the rule. */
+  if (strchr(value, 'r'))
+    rule->allow |= svn_authz_read;
+  else
+    rule->deny |= svn_authz_read;
+
+  if (strchr(value, 'w'))
+    rule->allow |= svn_authz_write;
+  else
+    rule->deny |= svn_authz_write;
+
+  return TRUE;
+}
+
+
+/* Callback to add the section NAME of the configuration to the
+   svn_authz_t BATON.  Implements the svn_config_section_enumerator2_t
+   interface. */
+static svn_boolean_t
+authz_compile_section(const char *name, void *baton, apr_pool_t *pool)
+{
+  svn_authz_t *authz = baton;
+  authz_section_t *section = apr_palloc(authz->pool, sizeof(*section));
+
+  /* The groups and aliases sections are compiled like the others.  As
+     their names are no paths, no lookup ever uses them. */
+  section->name = apr_pstrdup(authz->pool, name);
+  section->rules = apr_array_make(authz->pool, 0, sizeof(authz_rule_t));
+  svn_config_enumerate2(authz->cfg, name, authz_compile_rule, section,
+                        pool);
+  APR_ARRAY_PUSH(authz->sections, authz_section_t *) = section;
+
+  return TRUE;
+}
+
+
+
 /*** Public functions. ***/
 
 svn_error_t *
 svn_repos_authz_read(svn_authz_t **authz_p, const char *file,
                      svn_boolean_t must_exist, apr_pool_t *pool)
 {
-  svn_authz_t *authz = apr_palloc(pool, sizeof(*authz));
+  svn_authz_t *authz = apr_pcalloc(pool, sizeof(*authz));
   struct authz_validate_baton baton = { 0 };
 
   baton.err = SVN_NO_ERROR;
@@ -729,6 +850,16 @@ svn_repos_authz_read(svn_authz_t **authz_p, const char *file,
                                  &baton, pool);
   SVN_ERR(baton.err);
 
+  /* Compile the rules for the lookups. */
+  authz->pool = pool;
+  authz->users = apr_hash_make(pool);
+  authz->sections = apr_array_make(pool, 0, sizeof(authz_section_t *));
+  svn_config_enumerate_sections2(authz->cfg, authz_compile_section,
+                                 authz, pool);
+
+  /* The rules won't change anymore; expand them once and for all. */
+  svn_config__set_read_only(authz->cfg, pool);
+
   *authz_p = authz;
   return SVN_NO_ERROR;
 }
@@ -742,19 +873,19 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
                              apr_pool_t *pool)
 {
   const char *current_path = path;
+  const authz_user_t *rules = authz_get_user_rules(authz, user, pool);
 
   /* If PATH is NULL, do a global access lookup. */
   if (!path)
     {
-      *access_granted = authz_get_global_access(authz->cfg, repos_name,
-                                                user, required_access,
-                                                pool);
+      *access_granted = authz_get_global_access(rules, repos_name,
+                                                required_access, pool);
       return SVN_NO_ERROR;
     }
 
   /* Determine the granted access for the requested path. */
-  while (!authz_get_path_access(authz->cfg, repos_name,
-                                current_path, user,
+  while (!authz_get_path_access(rules, repos_name,
+                                current_path,
                                 required_access,
                                 access_granted,
                                 pool))
@@ -772,12 +903,12 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
       current_path = svn_dirent_dirname(current_path, pool);
     }
 
-  /* If the caller requested recursive access, we need to walk through
-     the entire authz config to see whether any child paths are denied
-     to the requested user. */
+  /* If the caller requested recursive access, we need to look through
+     the rules for the user to see whether any child paths are denied
+     to them. */
   if (*access_granted && (required_access & svn_authz_recursive))
-    *access_granted = authz_get_tree_access(authz->cfg, repos_name, path,
-                                            user, required_access, pool);
+    *access_granted = authz_get_tree_access(rules, repos_name, path,
+                                            required_access, pool);
 
   return SVN_NO_ERROR;
 }
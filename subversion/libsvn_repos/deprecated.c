@@ -137,6 +137,14 @@ svn_repos_get_commit_editor(const svn_delta_editor_t **editor,
 }
 
 /*** From repos.c ***/
+svn_error_t *
+svn_repos_open(svn_repos_t **repos_p,
+               const char *path,
+               apr_pool_t *pool)
+{
+  return svn_repos_open2(repos_p, path, NULL, pool);
+}
+
 svn_error_t *
 svn_repos_recover2(const char *path,
                    svn_boolean_t nonblocking,
@@ -157,6 +165,16 @@ svn_repos_recover(const char *path,
   return svn_repos_recover2(path, FALSE, NULL, NULL, pool);
 }
 
+svn_error_t *
+svn_repos_hotcopy(const char *src_path,
+                  const char *dst_path,
+                  svn_boolean_t clean_logs,
+                  apr_pool_t *pool)
+{
+  return svn_repos_hotcopy2(src_path, dst_path, clean_logs, FALSE,
+                            NULL, NULL, pool);
+}
+
 /*** From reporter.c ***/
 svn_error_t *
 svn_repos_begin_report(void **report_baton,
@@ -336,7 +354,7 @@ svn_repos_fs_pack(svn_repos_t *repos,
   pnwb.notify_func = notify_func;
   pnwb.notify_baton = notify_baton;
 
-  return svn_repos_fs_pack2(repos, pack_notify_wrapper_func, &pnwb,
+  return svn_repos_fs_pack2(repos, 1, pack_notify_wrapper_func, &pnwb,
                             cancel_func, cancel_baton, pool);
 }
 
@@ -587,6 +605,7 @@ svn_repos_dump_fs2(svn_repos_t *repos,
                                              end_rev,
                                              incremental,
                                              use_deltas,
+                                             1,
                                              feedback_stream
                                                ? repos_notify_handler
                                                : NULL,
@@ -608,6 +627,7 @@ svn_repos_verify_fs(svn_repos_t *repos,
   return svn_error_return(svn_repos_verify_fs2(repos,
                                                start_rev,
                                                end_rev,
+                                               1,
                                                feedback_stream
                                                  ? repos_notify_handler
                                                  : NULL,
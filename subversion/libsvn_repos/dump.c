@@ -35,6 +35,8 @@
 #include "svn_props.h"
 
 #include "private/svn_mergeinfo_private.h"
+#include "private/svn_workers.h"
+
 
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
@@ -1009,6 +1011,451 @@ write_revision_record(svn_stream_t *stream,
 
 
 
+/*----------------------------------------------------------------------*/
+
+/* Processing revisions concurrently */
+
+/* The number of revisions per job that may be processed ahead of the
+   oldest revision not reported yet. */
+#define REVISION_WINDOW_PER_JOB 16
+
+/* Process revision REV of FS on a worker thread and set *DATA to the
+   result, to be passed to the revision_report_func_t.  BATON is shared
+   between all workers and must not be modified.  Send warnings to
+   NOTIFY_FUNC / NOTIFY_BATON.  Allocate *DATA in RESULT_POOL and use
+   SCRATCH_POOL for temporary allocations. */
+typedef svn_error_t *(*revision_work_func_t)(void **data,
+                                             svn_fs_t *fs,
+                                             svn_revnum_t rev,
+                                             void *baton,
+                                             svn_repos_notify_func_t notify_func,
+                                             void *notify_baton,
+                                             svn_cancel_func_t cancel_func,
+                                             void *cancel_baton,
+                                             apr_pool_t *result_pool,
+                                             apr_pool_t *scratch_pool);
+
+/* Consume DATA, the result of processing revision REV, on the thread
+   that called process_revisions_concurrently().  BATON is the report
+   baton passed to that function.  Use SCRATCH_POOL for temporary
+   allocations. */
+typedef svn_error_t *(*revision_report_func_t)(void *baton,
+                                               svn_revnum_t rev,
+                                               void *data,
+                                               apr_pool_t *scratch_pool);
+
+/* State shared between the tasks of process_revisions_concurrently(). */
+typedef struct revision_jobs_t
+{
+  /* The filesystem each worker opens on its own. */
+  const char *fs_path;
+
+  /* How to process a revision. */
+  revision_work_func_t work_func;
+  void *work_baton;
+
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} revision_jobs_t;
+
+/* The task processing a single revision concurrently and its outcome. */
+typedef struct revision_result_t
+{
+  svn_workers__task_t task;
+  svn_revnum_t rev;
+
+  /* The result of the revision_work_func_t. */
+  void *data;
+
+  /* Warnings (const char *) issued while processing the revision, or
+     NULL if there were none. */
+  apr_array_header_t *warnings;
+
+  /* Root pool containing DATA and WARNINGS, or NULL. */
+  apr_pool_t *pool;
+} revision_result_t;
+
+/* Implements svn_repos_notify_func_t.  Record warnings in BATON, a
+   revision_result_t, for them to be reported by the main thread. */
+static void
+collect_warning(void *baton,
+                const svn_repos_notify_t *notify,
+                apr_pool_t *scratch_pool)
+{
+  revision_result_t *result = baton;
+
+  if (notify->action != svn_repos_notify_warning)
+    return;
+
+  if (! result->warnings)
+    result->warnings = apr_array_make(result->pool, 1,
+                                      sizeof(const char *));
+  APR_ARRAY_PUSH(result->warnings, const char *)
+    = apr_pstrdup(result->pool, notify->warning);
+}
+
+/* Implements svn_workers__process_t.  Process the revision of ITEM, a
+   revision_result_t, as BATON, a revision_jobs_t, says, using the
+   svn_fs_t of this worker in *WORKER_STATE. */
+static svn_error_t *
+revision_task(void *baton,
+              void **worker_state,
+              void *item,
+              apr_pool_t *worker_pool,
+              apr_pool_t *scratch_pool)
+{
+  revision_jobs_t *jobs = baton;
+  revision_result_t *result = item;
+
+  if (! *worker_state)
+    {
+      svn_fs_t *fs;
+
+      SVN_ERR(svn_fs_open(&fs, jobs->fs_path, NULL, worker_pool));
+      *worker_state = fs;
+    }
+
+  if (jobs->cancel_func)
+    SVN_ERR(jobs->cancel_func(jobs->cancel_baton));
+
+  result->pool = svn_pool_create(NULL);
+  return jobs->work_func(&result->data, *worker_state, result->rev,
+                         jobs->work_baton, collect_warning, result,
+                         jobs->cancel_func, jobs->cancel_baton,
+                         result->pool, scratch_pool);
+}
+
+/* Process revisions START_REV through END_REV of FS by calling
+   WORK_FUNC with WORK_BATON for each of them on up to JOBS threads.
+   Each thread uses an svn_fs_t of its own.  Back on this thread and
+   in revision order, send the warnings issued for every revision to
+   NOTIFY_FUNC / NOTIFY_BATON and pass the result to REPORT_FUNC with
+   REPORT_BATON.  Stop at and return the first error in revision order,
+   after all revisions before it have been reported.  If no thread
+   could be started, set *STARTED to FALSE and don't process anything.
+   WORK_FUNC may call CANCEL_FUNC with CANCEL_BATON from any thread.
+   Use POOL for allocations. */
+static svn_error_t *
+process_revisions_concurrently(svn_boolean_t *started,
+                               svn_fs_t *fs,
+                               svn_revnum_t start_rev,
+                               svn_revnum_t end_rev,
+                               int jobs,
+                               revision_work_func_t work_func,
+                               void *work_baton,
+                               revision_report_func_t report_func,
+                               void *report_baton,
+                               svn_repos_notify_func_t notify_func,
+                               void *notify_baton,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *pool)
+{
+  revision_jobs_t shared;
+  revision_result_t *results;
+  svn_workers__t *workers;
+  apr_pool_t *subpool, *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_revnum_t rev, next_rev;
+  int window, i;
+
+  if (jobs > end_rev - start_rev + 1)
+    jobs = (int)(end_rev - start_rev + 1);
+
+  shared.fs_path = svn_fs_path(fs, pool);
+  shared.work_func = work_func;
+  shared.work_baton = work_baton;
+  shared.cancel_func = cancel_func;
+  shared.cancel_baton = cancel_baton;
+
+  subpool = svn_pool_create(pool);
+  workers = svn_workers__start(jobs, revision_task, &shared, subpool);
+  *started = (workers != NULL);
+  if (! *started)
+    {
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
+    }
+
+  /* No more than WINDOW revisions, starting at the oldest one not
+     reported yet, are queued at any time.  Their tasks and results are
+     in RESULTS[rev % WINDOW]. */
+  window = jobs * REVISION_WINDOW_PER_JOB;
+  results = apr_pcalloc(subpool, window * sizeof(*results));
+  for (next_rev = start_rev;
+       next_rev <= end_rev && next_rev < start_rev + window;
+       next_rev++)
+    {
+      results[next_rev % window].rev = next_rev;
+      svn_workers__queue(workers, &results[next_rev % window].task,
+                         &results[next_rev % window]);
+    }
+
+  /* Report the revisions in order as they become available.  Once a
+     revision failed, no further ones get started, but all revisions
+     before it have been started already and get processed. */
+  iterpool = svn_pool_create(pool);
+  for (rev = start_rev; rev <= end_rev && !err; rev++)
+    {
+      revision_result_t *result = &results[rev % window];
+
+      svn_pool_clear(iterpool);
+
+      err = svn_workers__wait(workers, &result->task);
+
+      if (result->warnings && notify_func)
+        {
+          svn_repos_notify_t *warning
+            = svn_repos_notify_create(svn_repos_notify_warning, iterpool);
+
+          for (i = 0; i < result->warnings->nelts; ++i)
+            {
+              warning->warning = APR_ARRAY_IDX(result->warnings, i,
+                                               const char *);
+              notify_func(notify_baton, warning, iterpool);
+            }
+        }
+
+      if (! err)
+        err = report_func(report_baton, rev, result->data, iterpool);
+
+      /* Make room for the next revision. */
+      if (result->pool)
+        svn_pool_destroy(result->pool);
+      result->data = NULL;
+      result->warnings = NULL;
+      result->pool = NULL;
+
+      if (! err && next_rev <= end_rev)
+        {
+          results[next_rev % window].rev = next_rev;
+          svn_workers__queue(workers, &results[next_rev % window].task,
+                             &results[next_rev % window]);
+          next_rev++;
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Discard the results of the revisions after the failed one. */
+  svn_workers__stop(workers);
+  for (; rev < next_rev; rev++)
+    {
+      revision_result_t *result = &results[rev % window];
+
+      svn_error_clear(svn_workers__wait(workers, &result->task));
+      if (result->pool)
+        svn_pool_destroy(result->pool);
+    }
+  svn_pool_destroy(subpool);
+
+  return svn_error_return(err);
+}
+
+
+/* Write the dump of revision REV of FS, which is part of a dump
+   starting at START_REV with the given INCREMENTAL and USE_DELTAS
+   flags, to STREAM.  Send warnings to NOTIFY_FUNC / NOTIFY_BATON.  Set
+   *FOUND_OLD_REFERENCE and *FOUND_OLD_MERGEINFO if the revision refers
+   to copy sources or merge sources before START_REV, respectively.
+   Use POOL for all allocations. */
+static svn_error_t *
+dump_one_revision(svn_boolean_t *found_old_reference,
+                  svn_boolean_t *found_old_mergeinfo,
+                  svn_stream_t *stream,
+                  svn_fs_t *fs,
+                  svn_revnum_t rev,
+                  svn_revnum_t start_rev,
+                  svn_boolean_t incremental,
+                  svn_boolean_t use_deltas,
+                  svn_repos_notify_func_t notify_func,
+                  void *notify_baton,
+                  apr_pool_t *pool)
+{
+  const svn_delta_editor_t *dump_editor;
+  void *dump_edit_baton;
+  svn_revnum_t from_rev, to_rev;
+  svn_fs_root_t *to_root;
+  svn_boolean_t use_deltas_for_rev;
+
+  *found_old_reference = FALSE;
+  *found_old_mergeinfo = FALSE;
+
+  /* Special-case the initial revision dump: it needs to contain
+     *all* nodes, because it's the foundation of all future
+     revisions in the dumpfile. */
+  if ((rev == start_rev) && (! incremental))
+    {
+      /* Special-special-case a dump of revision 0. */
+      if (rev == 0)
+        {
+          /* Just write out the one revision 0 record and move on.
+             The parser might want to use its properties. */
+          return write_revision_record(stream, fs, 0, pool);
+        }
+
+      /* Compare START_REV to revision 0, so that everything
+         appears to be added.  */
+      from_rev = 0;
+      to_rev = rev;
+    }
+  else
+    {
+      /* In the normal case, we want to compare consecutive revs. */
+      from_rev = rev - 1;
+      to_rev = rev;
+    }
+
+  /* Write the revision record. */
+  SVN_ERR(write_revision_record(stream, fs, to_rev, pool));
+
+  /* Fetch the editor which dumps nodes to a file.  Regardless of
+     what we've been told, don't use deltas for the first rev of a
+     non-incremental dump. */
+  use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
+  SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, to_rev,
+                          "/", stream, notify_func, notify_baton,
+                          start_rev, use_deltas_for_rev, FALSE, pool));
+
+  /* Drive the editor in one way or another. */
+  SVN_ERR(svn_fs_revision_root(&to_root, fs, to_rev, pool));
+
+  /* If this is the first revision of a non-incremental dump,
+     we're in for a full tree dump.  Otherwise, we want to simply
+     replay the revision.  */
+  if ((rev == start_rev) && (! incremental))
+    {
+      svn_fs_root_t *from_root;
+      SVN_ERR(svn_fs_revision_root(&from_root, fs, from_rev, pool));
+      SVN_ERR(svn_repos_dir_delta2(from_root, "/", "",
+                                   to_root, "/",
+                                   dump_editor, dump_edit_baton,
+                                   NULL,
+                                   NULL,
+                                   FALSE, /* don't send text-deltas */
+                                   svn_depth_infinity,
+                                   FALSE, /* don't send entry props */
+                                   FALSE, /* don't ignore ancestry */
+                                   pool));
+    }
+  else
+    {
+      SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
+                                dump_editor, dump_edit_baton,
+                                NULL, NULL, pool));
+    }
+
+  *found_old_reference
+    = ((struct edit_baton *)dump_edit_baton)->found_old_reference;
+  *found_old_mergeinfo
+    = ((struct edit_baton *)dump_edit_baton)->found_old_mergeinfo;
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for dump_work(), shared between all worker threads. */
+struct dump_work_baton
+{
+  svn_revnum_t start_rev;
+  svn_boolean_t incremental;
+  svn_boolean_t use_deltas;
+
+  /* Where to put the temporary files holding the revisions dumped. */
+  const char *temp_dir;
+};
+
+/* The dump of a single revision, as produced by dump_work(). */
+struct dumped_rev
+{
+  /* Temporary file holding the dump.  It gets deleted together with
+     the pool it has been created in. */
+  const char *path;
+
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+};
+
+/* Implements revision_work_func_t for svn_repos_dump_fs3().  BATON is
+   a struct dump_work_baton and *DATA will be set to a struct
+   dumped_rev. */
+static svn_error_t *
+dump_work(void **data,
+          svn_fs_t *fs,
+          svn_revnum_t rev,
+          void *baton,
+          svn_repos_notify_func_t notify_func,
+          void *notify_baton,
+          svn_cancel_func_t cancel_func,
+          void *cancel_baton,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  struct dump_work_baton *wb = baton;
+  struct dumped_rev *dumped = apr_pcalloc(result_pool, sizeof(*dumped));
+  svn_stream_t *stream;
+
+  SVN_ERR(svn_stream_open_unique(&stream, &dumped->path, wb->temp_dir,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 result_pool, scratch_pool));
+  SVN_ERR(dump_one_revision(&dumped->found_old_reference,
+                            &dumped->found_old_mergeinfo,
+                            stream, fs, rev, wb->start_rev,
+                            wb->incremental, wb->use_deltas,
+                            notify_func, notify_baton, scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  *data = dumped;
+  return SVN_NO_ERROR;
+}
+
+/* Baton for report_dumped_rev(). */
+struct dump_report_baton
+{
+  svn_stream_t *stream;
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+  svn_repos_notify_func_t notify_func;
+  void *notify_baton;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+};
+
+/* Implements revision_report_func_t for svn_repos_dump_fs3().  Append
+   DATA, a struct dumped_rev, to the output stream in BATON, a struct
+   dump_report_baton. */
+static svn_error_t *
+report_dumped_rev(void *baton,
+                  svn_revnum_t rev,
+                  void *data,
+                  apr_pool_t *scratch_pool)
+{
+  struct dump_report_baton *rb = baton;
+  struct dumped_rev *dumped = data;
+  svn_stream_t *dump;
+
+  SVN_ERR(svn_stream_open_readonly(&dump, dumped->path,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_copy3(dump, svn_stream_disown(rb->stream,
+                                                   scratch_pool),
+                           rb->cancel_func, rb->cancel_baton,
+                           scratch_pool));
+
+  if (dumped->found_old_reference)
+    rb->found_old_reference = TRUE;
+  if (dumped->found_old_mergeinfo)
+    rb->found_old_mergeinfo = TRUE;
+
+  if (rb->notify_func)
+    {
+      svn_repos_notify_t *notify
+        = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
+                                  scratch_pool);
+      notify->revision = rev;
+      rb->notify_func(rb->notify_baton, notify, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* The main dumper. */
 svn_error_t *
 svn_repos_dump_fs3(svn_repos_t *repos,
@@ -1017,14 +1464,13 @@ svn_repos_dump_fs3(svn_repos_t *repos,
                    svn_revnum_t end_rev,
                    svn_boolean_t incremental,
                    svn_boolean_t use_deltas,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *pool)
 {
-  const svn_delta_editor_t *dump_editor;
-  void *dump_edit_baton = NULL;
   svn_revnum_t i;
   svn_fs_t *fs = svn_repos_fs(repos);
   apr_pool_t *subpool = svn_pool_create(pool);
@@ -1033,6 +1479,7 @@ svn_repos_dump_fs3(svn_repos_t *repos,
   int version;
   svn_boolean_t found_old_reference = FALSE;
   svn_boolean_t found_old_mergeinfo = FALSE;
+  svn_boolean_t dumped = FALSE;
   svn_repos_notify_t *notify;
 
   /* Determine the current youngest revision of the filesystem. */
@@ -1079,17 +1526,47 @@ svn_repos_dump_fs3(svn_repos_t *repos,
   SVN_ERR(svn_stream_printf(stream, pool, SVN_REPOS_DUMPFILE_UUID
                             ": %s\n\n", uuid));
 
+  /* Let worker threads dump the revisions into temporary files and
+     append those here in order, such that the output is the same as
+     for a dump on this thread only. */
+  if (jobs > 1 && start_rev < end_rev)
+    {
+      struct dump_work_baton wb;
+      struct dump_report_baton rb;
+
+      wb.start_rev = start_rev;
+      wb.incremental = incremental;
+      wb.use_deltas = use_deltas;
+      SVN_ERR(svn_io_temp_dir(&wb.temp_dir, pool));
+
+      rb.stream = stream;
+      rb.found_old_reference = FALSE;
+      rb.found_old_mergeinfo = FALSE;
+      rb.notify_func = notify_func;
+      rb.notify_baton = notify_baton;
+      rb.cancel_func = cancel_func;
+      rb.cancel_baton = cancel_baton;
+
+      SVN_ERR(process_revisions_concurrently(&dumped, fs, start_rev,
+                                             end_rev, jobs,
+                                             dump_work, &wb,
+                                             report_dumped_rev, &rb,
+                                             notify_func, notify_baton,
+                                             cancel_func, cancel_baton,
+                                             pool));
+      found_old_reference = rb.found_old_reference;
+      found_old_mergeinfo = rb.found_old_mergeinfo;
+    }
+
   /* Create a notify object that we can reuse in the loop. */
   if (notify_func)
     notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
                                      pool);
 
   /* Main loop:  we're going to dump revision i.  */
-  for (i = start_rev; i <= end_rev; i++)
+  for (i = start_rev; !dumped && i <= end_rev; i++)
     {
-      svn_revnum_t from_rev, to_rev;
-      svn_fs_root_t *to_root;
-      svn_boolean_t use_deltas_for_rev;
+      svn_boolean_t old_reference, old_mergeinfo;
 
       svn_pool_clear(subpool);
 
@@ -1097,86 +1574,21 @@ svn_repos_dump_fs3(svn_repos_t *repos,
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Special-case the initial revision dump: it needs to contain
-         *all* nodes, because it's the foundation of all future
-         revisions in the dumpfile. */
-      if ((i == start_rev) && (! incremental))
-        {
-          /* Special-special-case a dump of revision 0. */
-          if (i == 0)
-            {
-              /* Just write out the one revision 0 record and move on.
-                 The parser might want to use its properties. */
-              SVN_ERR(write_revision_record(stream, fs, 0, subpool));
-              to_rev = 0;
-              goto loop_end;
-            }
+      SVN_ERR(dump_one_revision(&old_reference, &old_mergeinfo,
+                                stream, fs, i, start_rev,
+                                incremental, use_deltas,
+                                notify_func, notify_baton, subpool));
 
-          /* Compare START_REV to revision 0, so that everything
-             appears to be added.  */
-          from_rev = 0;
-          to_rev = i;
-        }
-      else
-        {
-          /* In the normal case, we want to compare consecutive revs. */
-          from_rev = i - 1;
-          to_rev = i;
-        }
-
-      /* Write the revision record. */
-      SVN_ERR(write_revision_record(stream, fs, to_rev, subpool));
-
-      /* Fetch the editor which dumps nodes to a file.  Regardless of
-         what we've been told, don't use deltas for the first rev of a
-         non-incremental dump. */
-      use_deltas_for_rev = use_deltas && (incremental || i != start_rev);
-      SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, to_rev,
-                              "/", stream, notify_func, notify_baton,
-                              start_rev, use_deltas_for_rev, FALSE, subpool));
-
-      /* Drive the editor in one way or another. */
-      SVN_ERR(svn_fs_revision_root(&to_root, fs, to_rev, subpool));
-
-      /* If this is the first revision of a non-incremental dump,
-         we're in for a full tree dump.  Otherwise, we want to simply
-         replay the revision.  */
-      if ((i == start_rev) && (! incremental))
-        {
-          svn_fs_root_t *from_root;
-          SVN_ERR(svn_fs_revision_root(&from_root, fs, from_rev, subpool));
-          SVN_ERR(svn_repos_dir_delta2(from_root, "/", "",
-                                       to_root, "/",
-                                       dump_editor, dump_edit_baton,
-                                       NULL,
-                                       NULL,
-                                       FALSE, /* don't send text-deltas */
-                                       svn_depth_infinity,
-                                       FALSE, /* don't send entry props */
-                                       FALSE, /* don't ignore ancestry */
-                                       subpool));
-        }
-      else
-        {
-          SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
-                                    dump_editor, dump_edit_baton,
-                                    NULL, NULL, subpool));
-        }
-
-    loop_end:
       if (notify_func)
         {
-          notify->revision = to_rev;
+          notify->revision = i;
           notify_func(notify_baton, notify, subpool);
         }
 
-      if (dump_edit_baton) /* We never get an edit baton for r0. */
-        {
-          if (((struct edit_baton *)dump_edit_baton)->found_old_reference)
-            found_old_reference = TRUE;
-          if (((struct edit_baton *)dump_edit_baton)->found_old_mergeinfo)
-            found_old_mergeinfo = TRUE;
-        }
+      if (old_reference)
+        found_old_reference = TRUE;
+      if (old_mergeinfo)
+        found_old_mergeinfo = TRUE;
     }
 
   if (notify_func)
@@ -1277,10 +1689,103 @@ verify_close_directory(void *dir_baton,
   return close_directory(dir_baton, pool);
 }
 
+/* Verify revision REV of FS, which is part of a verification starting
+   at START_REV.  Pass NOTIFY_FUNC / NOTIFY_BATON to the dump editor but
+   don't send any svn_repos_notify_verify_rev_end notification.  Use
+   POOL for all allocations. */
+static svn_error_t *
+verify_one_revision(svn_fs_t *fs,
+                    svn_revnum_t rev,
+                    svn_revnum_t start_rev,
+                    svn_repos_notify_func_t notify_func,
+                    void *notify_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *pool)
+{
+  svn_delta_editor_t *dump_editor;
+  void *dump_edit_baton;
+  const svn_delta_editor_t *cancel_editor;
+  void *cancel_edit_baton;
+  svn_fs_root_t *to_root;
+  apr_hash_t *props;
+
+  /* Get cancellable dump editor, but with our close_directory handler. */
+  SVN_ERR(get_dump_editor((const svn_delta_editor_t **)&dump_editor,
+                          &dump_edit_baton, fs, rev, "",
+                          svn_stream_empty(pool),
+                          notify_func, notify_baton,
+                          start_rev,
+                          FALSE, TRUE, /* use_deltas, verify */
+                          pool));
+  dump_editor->close_directory = verify_close_directory;
+  SVN_ERR(svn_delta_get_cancellation_editor(cancel_func, cancel_baton,
+                                            dump_editor, dump_edit_baton,
+                                            &cancel_editor,
+                                            &cancel_edit_baton,
+                                            pool));
+
+  SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, pool));
+  SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
+                            cancel_editor, cancel_edit_baton,
+                            NULL, NULL, pool));
+  return svn_fs_revision_proplist(&props, fs, rev, pool);
+}
+
+/* Implements revision_work_func_t for svn_repos_verify_fs2().  BATON
+   is the svn_revnum_t at which the verification started. */
+static svn_error_t *
+verify_work(void **data,
+            svn_fs_t *fs,
+            svn_revnum_t rev,
+            void *baton,
+            svn_repos_notify_func_t notify_func,
+            void *notify_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  const svn_revnum_t *start_rev = baton;
+
+  *data = NULL;
+  return verify_one_revision(fs, rev, *start_rev, notify_func, notify_baton,
+                             cancel_func, cancel_baton, scratch_pool);
+}
+
+/* Baton for report_verified_rev(). */
+struct verify_report_baton
+{
+  svn_repos_notify_func_t notify_func;
+  void *notify_baton;
+};
+
+/* Implements revision_report_func_t for svn_repos_verify_fs2(). */
+static svn_error_t *
+report_verified_rev(void *baton,
+                    svn_revnum_t rev,
+                    void *data,
+                    apr_pool_t *scratch_pool)
+{
+  struct verify_report_baton *rb = baton;
+
+  if (rb->notify_func)
+    {
+      svn_repos_notify_t *notify
+        = svn_repos_notify_create(svn_repos_notify_verify_rev_end,
+                                  scratch_pool);
+      notify->revision = rev;
+      rb->notify_func(rb->notify_baton, notify, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos_verify_fs2(svn_repos_t *repos,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
+                     int jobs,
                      svn_repos_notify_func_t notify_func,
                      void *notify_baton,
                      svn_cancel_func_t cancel_func,
@@ -1290,7 +1795,7 @@ svn_repos_verify_fs2(svn_repos_t *repos,
   svn_fs_t *fs = svn_repos_fs(repos);
   svn_revnum_t youngest;
   svn_revnum_t rev;
-  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_pool_t *iterpool;
   svn_repos_notify_t *notify;
 
   /* Determine the current youngest revision of the filesystem. */
@@ -1314,42 +1819,37 @@ svn_repos_verify_fs2(svn_repos_t *repos,
                                "(youngest revision is %ld)"),
                              end_rev, youngest);
 
+  if (jobs > 1 && start_rev < end_rev)
+    {
+      struct verify_report_baton rb;
+      svn_boolean_t started;
+
+      rb.notify_func = notify_func;
+      rb.notify_baton = notify_baton;
+      SVN_ERR(process_revisions_concurrently(&started, fs,
+                                             start_rev, end_rev, jobs,
+                                             verify_work, &start_rev,
+                                             report_verified_rev, &rb,
+                                             notify_func, notify_baton,
+                                             cancel_func, cancel_baton,
+                                             pool));
+      if (started)
+        return SVN_NO_ERROR;
+    }
+
   /* Create a notify object that we can reuse within the loop. */
   if (notify_func)
     notify = svn_repos_notify_create(svn_repos_notify_verify_rev_end,
                                      pool);
 
+  iterpool = svn_pool_create(pool);
   for (rev = start_rev; rev <= end_rev; rev++)
     {
-      svn_delta_editor_t *dump_editor;
-      void *dump_edit_baton;
-      const svn_delta_editor_t *cancel_editor;
-      void *cancel_edit_baton;
-      svn_fs_root_t *to_root;
-      apr_hash_t *props;
-
       svn_pool_clear(iterpool);
 
-      /* Get cancellable dump editor, but with our close_directory handler. */
-      SVN_ERR(get_dump_editor((const svn_delta_editor_t **)&dump_editor,
-                              &dump_edit_baton, fs, rev, "",
-                              svn_stream_empty(pool), 
-                              notify_func, notify_baton,
-                              start_rev,
-                              FALSE, TRUE, /* use_deltas, verify */
-                              iterpool));
-      dump_editor->close_directory = verify_close_directory;
-      SVN_ERR(svn_delta_get_cancellation_editor(cancel_func, cancel_baton,
-                                                dump_editor, dump_edit_baton,
-                                                &cancel_editor,
-                                                &cancel_edit_baton,
-                                                iterpool));
-
-      SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, iterpool));
-      SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
-                                cancel_editor, cancel_edit_baton,
-                                NULL, NULL, iterpool));
-      SVN_ERR(svn_fs_revision_proplist(&props, fs, rev, iterpool));
+      SVN_ERR(verify_one_revision(fs, rev, start_rev,
+                                  notify_func, notify_baton,
+                                  cancel_func, cancel_baton, iterpool));
 
       if (notify_func)
         {
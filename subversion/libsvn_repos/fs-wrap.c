@@ -33,6 +33,7 @@
 #include "svn_time.h"
 #include "repos.h"
 #include "svn_private_config.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_utf_private.h"
 
 
@@ -506,6 +507,238 @@ svn_repos_fs_unlock(svn_repos_t *repos,
 }
 
 
+/* Baton for lock_many_callback(). */
+struct lock_many_baton_t
+{
+  /* The paths locked or unlocked so far, for the post-(un)lock hook. */
+  apr_array_header_t *paths;
+
+  /* The caller's callback, and the first error it returned. */
+  svn_fs__lock_callback_t lock_callback;
+  void *lock_baton;
+  svn_error_t *cb_err;
+};
+
+/* Report the outcome for PATH to the callback in B, unless that
+   callback failed already. */
+static void
+report_outcome(struct lock_many_baton_t *b,
+               const char *path,
+               const svn_lock_t *lock,
+               svn_error_t *fs_err,
+               apr_pool_t *pool)
+{
+  if (!b->cb_err && b->lock_callback)
+    b->cb_err = b->lock_callback(b->lock_baton, path, lock, fs_err, pool);
+}
+
+/* This implements svn_fs__lock_callback_t.  Remember PATH for the hook
+   if it got locked or unlocked, and pass the outcome on.  BATON is a
+   'struct lock_many_baton_t *'. */
+static svn_error_t *
+lock_many_callback(void *baton,
+                   const char *path,
+                   const svn_lock_t *lock,
+                   svn_error_t *fs_err,
+                   apr_pool_t *pool)
+{
+  struct lock_many_baton_t *b = baton;
+
+  if (!fs_err)
+    APR_ARRAY_PUSH(b->paths, const char *) = apr_pstrdup(b->paths->pool,
+                                                         path);
+  report_outcome(b, path, lock, fs_err, pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the first of ERR, B->cb_err and HOOK_ERR that is set, clearing
+   the others. */
+static svn_error_t *
+many_result(svn_error_t *err,
+            struct lock_many_baton_t *b,
+            svn_error_t *hook_err)
+{
+  if (err)
+    {
+      svn_error_clear(b->cb_err);
+      svn_error_clear(hook_err);
+      return svn_error_return(err);
+    }
+
+  if (b->cb_err)
+    {
+      svn_error_clear(hook_err);
+      return svn_error_return(b->cb_err);
+    }
+
+  return svn_error_return(hook_err);
+}
+
+
+svn_error_t *
+svn_repos__fs_lock_many(svn_repos_t *repos,
+                        apr_hash_t *targets,
+                        const char *comment,
+                        svn_boolean_t is_dav_comment,
+                        apr_time_t expiration_date,
+                        svn_boolean_t steal_lock,
+                        svn_fs__lock_callback_t lock_callback,
+                        void *lock_baton,
+                        apr_pool_t *pool)
+{
+  svn_error_t *err;
+  svn_error_t *hook_err = SVN_NO_ERROR;
+  svn_fs_access_t *access_ctx = NULL;
+  const char *username = NULL;
+  apr_hash_t *fs_targets = apr_hash_make(pool);
+  struct lock_many_baton_t b;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(svn_fs_get_access(&access_ctx, repos->fs));
+  if (access_ctx)
+    SVN_ERR(svn_fs_access_get_username(&username, access_ctx));
+
+  if (! username)
+    return svn_error_create
+      (SVN_ERR_FS_NO_USER, NULL,
+       _("Cannot lock paths, no authenticated username available"));
+
+  b.paths = apr_array_make(pool, apr_hash_count(targets),
+                           sizeof(const char *));
+  b.lock_callback = lock_callback;
+  b.lock_baton = lock_baton;
+  b.cb_err = SVN_NO_ERROR;
+
+  /* Run the pre-lock hook for each path.  The paths it rejects are
+     reported right away and not locked. */
+  iterpool = svn_pool_create(pool);
+  for (hi = apr_hash_first(pool, targets); hi; hi = apr_hash_next(hi))
+    {
+      const char *path = svn__apr_hash_index_key(hi);
+      const svn_fs__lock_target_t *target = svn__apr_hash_index_val(hi);
+      const char *new_token;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_repos__hooks_pre_lock(repos, &new_token, path, username,
+                                      comment, steal_lock, iterpool);
+      if (err)
+        {
+          report_outcome(&b, path, NULL, err, iterpool);
+          svn_error_clear(err);
+          continue;
+        }
+
+      if (*new_token)
+        {
+          svn_fs__lock_target_t *new_target = apr_palloc(pool,
+                                                         sizeof(*new_target));
+
+          new_target->token = apr_pstrdup(pool, new_token);
+          new_target->current_rev = target->current_rev;
+          target = new_target;
+        }
+
+      apr_hash_set(fs_targets, path, APR_HASH_KEY_STRING, target);
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Lock. */
+  err = svn_fs__lock_many(repos->fs, fs_targets, comment, is_dav_comment,
+                          expiration_date, steal_lock, lock_many_callback, &b,
+                          pool);
+
+  /* Run post-lock hook once for all paths that got locked. */
+  if (b.paths->nelts)
+    {
+      hook_err = svn_repos__hooks_post_lock(repos, b.paths, username, pool);
+      if (hook_err)
+        hook_err = svn_error_create(SVN_ERR_REPOS_POST_LOCK_HOOK_FAILED,
+                                    hook_err,
+                                    _("Lock succeeded, but post-lock hook "
+                                      "failed"));
+    }
+
+  return many_result(err, &b, hook_err);
+}
+
+
+svn_error_t *
+svn_repos__fs_unlock_many(svn_repos_t *repos,
+                          apr_hash_t *targets,
+                          svn_boolean_t break_lock,
+                          svn_fs__lock_callback_t lock_callback,
+                          void *lock_baton,
+                          apr_pool_t *pool)
+{
+  svn_error_t *err;
+  svn_error_t *hook_err = SVN_NO_ERROR;
+  svn_fs_access_t *access_ctx = NULL;
+  const char *username = NULL;
+  apr_hash_t *fs_targets = apr_hash_make(pool);
+  struct lock_many_baton_t b;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(svn_fs_get_access(&access_ctx, repos->fs));
+  if (access_ctx)
+    SVN_ERR(svn_fs_access_get_username(&username, access_ctx));
+
+  if (! break_lock && ! username)
+    return svn_error_create
+      (SVN_ERR_FS_NO_USER, NULL,
+       _("Cannot unlock paths, no authenticated username available"));
+
+  b.paths = apr_array_make(pool, apr_hash_count(targets),
+                           sizeof(const char *));
+  b.lock_callback = lock_callback;
+  b.lock_baton = lock_baton;
+  b.cb_err = SVN_NO_ERROR;
+
+  /* Run the pre-unlock hook for each path.  The paths it rejects are
+     reported right away and not unlocked. */
+  iterpool = svn_pool_create(pool);
+  for (hi = apr_hash_first(pool, targets); hi; hi = apr_hash_next(hi))
+    {
+      const char *path = svn__apr_hash_index_key(hi);
+      const char *token = svn__apr_hash_index_val(hi);
+
+      svn_pool_clear(iterpool);
+
+      err = svn_repos__hooks_pre_unlock(repos, path, username, token,
+                                        break_lock, iterpool);
+      if (err)
+        {
+          report_outcome(&b, path, NULL, err, iterpool);
+          svn_error_clear(err);
+          continue;
+        }
+
+      apr_hash_set(fs_targets, path, APR_HASH_KEY_STRING, token);
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Unlock. */
+  err = svn_fs__unlock_many(repos->fs, fs_targets, break_lock,
+                            lock_many_callback, &b, pool);
+
+  /* Run post-unlock hook once for all paths that got unlocked. */
+  if (b.paths->nelts)
+    {
+      hook_err = svn_repos__hooks_post_unlock(repos, b.paths, username, pool);
+      if (hook_err)
+        hook_err = svn_error_create(SVN_ERR_REPOS_POST_UNLOCK_HOOK_FAILED,
+                                    hook_err,
+                                    _("Unlock succeeded, but post-unlock "
+                                      "hook failed"));
+    }
+
+  return many_result(err, &b, hook_err);
+}
+
+
 struct get_locks_baton_t
 {
   svn_fs_t *fs;
@@ -665,6 +898,7 @@ pack_notify_func(void *baton,
 
 svn_error_t *
 svn_repos_fs_pack2(svn_repos_t *repos,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -676,10 +910,10 @@ svn_repos_fs_pack2(svn_repos_t *repos,
   pnb.notify_func = notify_func;
   pnb.notify_baton = notify_baton;
 
-  return svn_fs_pack(repos->db_path,
-                     notify_func ? pack_notify_func : NULL,
-                     notify_func ? &pnb : NULL,
-                     cancel_func, cancel_baton, pool);
+  return svn_fs_pack2(repos->db_path, jobs,
+                      notify_func ? pack_notify_func : NULL,
+                      notify_func ? &pnb : NULL,
+                      cancel_func, cancel_baton, pool);
 }
 
 
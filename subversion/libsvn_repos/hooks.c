@@ -27,19 +27,95 @@
 #include <apr_pools.h>
 #include <apr_file_io.h>
 
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <apr_portable.h>
+#endif
+
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
+
 #include "svn_error.h"
+#include "svn_config.h"
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 #include "svn_path.h"
+#include "svn_pools.h"
 #include "svn_repos.h"
 #include "svn_utf.h"
 #include "repos.h"
 #include "svn_private_config.h"
+#include "private/svn_atomic.h"
+#include "private/svn_dep_compat.h"
 #include "private/svn_fs_private.h"
 
 
 
 /*** Hook drivers. ***/
 
+/* Return the error for the failure of the hook NAME, which ended with
+   EXITWHY and EXITCODE and wrote UTF8_STDERR to its stderr. */
+static svn_error_t *
+hook_failure(const char *name, apr_exit_why_e exitwhy, int exitcode,
+             const char *utf8_stderr, apr_pool_t *pool)
+{
+  svn_stringbuf_t *failure_message;
+
+  if (!APR_PROC_CHECK_EXIT(exitwhy))
+    {
+      failure_message = svn_stringbuf_createf(pool,
+        _("'%s' hook failed (did not exit cleanly: "
+          "apr_exit_why_e was %d, exitcode was %d).  "),
+        name, exitwhy, exitcode);
+    }
+  else
+    {
+      const char *action;
+      if (strcmp(name, "start-commit") == 0
+          || strcmp(name, "pre-commit") == 0)
+        action = _("Commit");
+      else if (strcmp(name, "pre-revprop-change") == 0)
+        action = _("Revprop change");
+      else if (strcmp(name, "pre-obliterate") == 0)
+        action = _("Obliteration");
+      else if (strcmp(name, "pre-lock") == 0)
+        action = _("Lock");
+      else if (strcmp(name, "pre-unlock") == 0)
+        action = _("Unlock");
+      else
+        action = NULL;
+      if (action == NULL)
+        failure_message = svn_stringbuf_createf(
+            pool, _("%s hook failed (exit code %d)"),
+            name, exitcode);
+      else
+        failure_message = svn_stringbuf_createf(
+            pool, _("%s blocked by %s hook (exit code %d)"),
+            action, name, exitcode);
+    }
+
+  if (utf8_stderr[0])
+    {
+      svn_stringbuf_appendcstr(failure_message,
+                               _(" with output:\n"));
+      svn_stringbuf_appendcstr(failure_message, utf8_stderr);
+    }
+  else
+    {
+      svn_stringbuf_appendcstr(failure_message,
+                               _(" with no output."));
+    }
+
+  return svn_error_create(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
+                          failure_message->data);
+}
+
 /* Helper function for run_hook_cmd().  Wait for a hook to finish
    executing and return either SVN_NO_ERROR if the hook script completed
    without error, or an error describing the reason for failure.
@@ -61,7 +137,7 @@ check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
                   apr_file_t *read_errhandle, apr_pool_t *pool)
 {
   svn_error_t *err, *err2;
-  svn_stringbuf_t *native_stderr, *failure_message;
+  svn_stringbuf_t *native_stderr;
   const char *utf8_stderr;
   int exitcode;
   apr_exit_why_e exitwhy;
@@ -110,54 +186,136 @@ check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
         error in the messages above before we clear it here. */
   svn_error_clear(err2);
 
-  if (!APR_PROC_CHECK_EXIT(exitwhy))
+  return hook_failure(name, exitwhy, exitcode, utf8_stderr, pool);
+}
+
+#ifndef WIN32
+/* Send the request of the hook NAME with the arguments ARGS (not
+   including the program name in ARGS[0]) and the contents of
+   STDIN_HANDLE, if not NULL, to the hook server listening on the Unix
+   socket at SOCKET_PATH, and wait for its answer.
+
+   The request and the answer are hashes in the format of
+   svn_hash_write2(), each ended by SVN_HASH_TERMINATOR.  The request
+   holds the hook's name as "hook", its arguments as "arg1", "arg2" and
+   so on, and what the hook would read on stdin as "stdin".  The answer
+   must hold the hook's exit code as a decimal number in "exit-code",
+   and may hold the UTF-8 text of the hook's output in "stdout" and
+   "stderr".  The server sees one request per connection.
+
+   Return the hook's failure as run_hook_cmd() does, and set *RESULT
+   as it does, too. */
+static svn_error_t *
+run_hook_server(svn_string_t **result,
+                const char *name,
+                const char *socket_path,
+                const char **args,
+                apr_file_t *stdin_handle,
+                apr_pool_t *pool)
+{
+  struct sockaddr_un addr;
+  const char *local_path;
+  apr_os_file_t fd;
+  apr_file_t *conn;
+  apr_status_t apr_err;
+  svn_error_t *err;
+  svn_stream_t *stream;
+  apr_hash_t *request = apr_hash_make(pool);
+  apr_hash_t *response = apr_hash_make(pool);
+  const svn_string_t *exit_code, *hook_stderr;
+  int i;
+
+  apr_hash_set(request, "hook", APR_HASH_KEY_STRING,
+               svn_string_create(name, pool));
+  for (i = 1; args[i]; i++)
+    apr_hash_set(request, apr_psprintf(pool, "arg%d", i),
+                 APR_HASH_KEY_STRING, svn_string_create(args[i], pool));
+  if (stdin_handle)
     {
-      failure_message = svn_stringbuf_createf(pool,
-        _("'%s' hook failed (did not exit cleanly: "
-          "apr_exit_why_e was %d, exitcode was %d).  "),
-        name, exitwhy, exitcode);
+      svn_stringbuf_t *stdin_content;
+
+      SVN_ERR(svn_stringbuf_from_aprfile(&stdin_content, stdin_handle, pool));
+      apr_hash_set(request, "stdin", APR_HASH_KEY_STRING,
+                   svn_string_create_from_buf(stdin_content, pool));
     }
-  else
+
+  SVN_ERR(svn_utf_cstring_from_utf8(&local_path, socket_path, pool));
+  if (strlen(local_path) >= sizeof(addr.sun_path))
+    return svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
+                             _("Path of hook server socket '%s' is too long"),
+                             svn_dirent_local_style(socket_path, pool));
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, local_path);
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't create socket for '%s' hook"), name);
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
     {
-      const char *action;
-      if (strcmp(name, "start-commit") == 0
-          || strcmp(name, "pre-commit") == 0)
-        action = _("Commit");
-      else if (strcmp(name, "pre-revprop-change") == 0)
-        action = _("Revprop change");
-      else if (strcmp(name, "pre-obliterate") == 0)
-        action = _("Obliteration");
-      else if (strcmp(name, "pre-lock") == 0)
-        action = _("Lock");
-      else if (strcmp(name, "pre-unlock") == 0)
-        action = _("Unlock");
-      else
-        action = NULL;
-      if (action == NULL)
-        failure_message = svn_stringbuf_createf(
-            pool, _("%s hook failed (exit code %d)"),
-            name, exitcode);
-      else
-        failure_message = svn_stringbuf_createf(
-            pool, _("%s blocked by %s hook (exit code %d)"),
-            action, name, exitcode);
+      apr_err = apr_get_netos_error();
+      close(fd);
+      return svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE,
+                               svn_error_wrap_apr(apr_err, NULL),
+                               _("Failed to contact hook server '%s' "
+                                 "for '%s' hook"),
+                               svn_dirent_local_style(socket_path, pool),
+                               name);
     }
 
-  if (utf8_stderr[0])
+  apr_err = apr_os_file_put(&conn, &fd, APR_READ | APR_WRITE | APR_BUFFERED,
+                            pool);
+  if (apr_err)
     {
-      svn_stringbuf_appendcstr(failure_message,
-                               _(" with output:\n"));
-      svn_stringbuf_appendcstr(failure_message, utf8_stderr);
+      close(fd);
+      return svn_error_wrap_apr(apr_err,
+                                _("Can't use socket for '%s' hook"), name);
     }
-  else
+
+  stream = svn_stream_from_aprfile2(conn, TRUE, pool);
+  err = svn_hash_write2(request, stream, SVN_HASH_TERMINATOR, pool);
+  if (! err)
     {
-      svn_stringbuf_appendcstr(failure_message,
-                               _(" with no output."));
+      apr_err = apr_file_flush(conn);
+      if (apr_err)
+        err = svn_error_wrap_apr(apr_err,
+                                 _("Can't write to hook server for '%s' "
+                                   "hook"), name);
     }
+  if (! err)
+    err = svn_hash_read2(response, stream, SVN_HASH_TERMINATOR, pool);
 
-  return svn_error_create(SVN_ERR_REPOS_HOOK_FAILURE, err,
-                          failure_message->data);
+  apr_err = apr_file_close(conn);
+  if (err)
+    return svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE, err,
+                             _("Failed to run '%s' hook on hook server"),
+                             name);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err,
+                              _("Can't close socket for '%s' hook"), name);
+
+  exit_code = apr_hash_get(response, "exit-code", APR_HASH_KEY_STRING);
+  if (! exit_code)
+    return svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
+                             _("Hook server gave no exit code for '%s' "
+                               "hook"), name);
+
+  if (result)
+    {
+      *result = apr_hash_get(response, "stdout", APR_HASH_KEY_STRING);
+      if (! *result)
+        *result = svn_string_create("", pool);
+    }
+
+  if (atoi(exit_code->data) == 0)
+    return SVN_NO_ERROR;
+
+  hook_stderr = apr_hash_get(response, "stderr", APR_HASH_KEY_STRING);
+  return hook_failure(name, APR_PROC_EXIT, atoi(exit_code->data),
+                      hook_stderr ? hook_stderr->data : "", pool);
 }
+#endif
 
 /* NAME, CMD and ARGS are the name, path to and arguments for the hook
    program that is to be run.  The hook's exit status will be checked,
@@ -168,7 +326,10 @@ check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
    no stdin to the hook.
 
    If RESULT is non-null, set *RESULT to the stdout of the hook or to
-   a zero-length string if the hook generates no output on stdout. */
+   a zero-length string if the hook generates no output on stdout.
+
+   If CMD is the socket of a hook server, have the server handle the
+   hook instead of running a program. */
 static svn_error_t *
 run_hook_cmd(svn_string_t **result,
              const char *name,
@@ -183,6 +344,13 @@ run_hook_cmd(svn_string_t **result,
   svn_error_t *err;
   apr_proc_t cmd_proc;
 
+#ifndef WIN32
+  if (strcmp(svn_dirent_basename(cmd, NULL),
+             SVN_REPOS__HOOK_SERVER_SOCKET) == 0)
+    return svn_error_return(run_hook_server(result, name, cmd, args,
+                                            stdin_handle, pool));
+#endif
+
   /* Create a pipe to access stderr of the child. */
   apr_err = apr_file_pipe_create(&read_errhandle, &write_errhandle, pool);
   if (apr_err)
@@ -315,13 +483,512 @@ create_temp_file(apr_file_t **f, const svn_string_t *value, apr_pool_t *pool)
 }
 
 
+/*** Asynchronous post-event hooks. ***/
+
+/* Post-commit and post-revprop-change hooks can't change the outcome
+   of what they report on, so a repository may have them run in the
+   background by enabling the [async-hooks] section of conf/hooks.conf:
+
+     [async-hooks]
+     enabled = yes
+     max-running = 2
+     max-queued = 64
+
+   Before we return, each hook run is recorded as a job file in the
+   repository's hook-queue directory.  Jobs which a process didn't get
+   to before it went away are picked up by the next process which
+   queues a hook for the repository.  A job file is renamed by adding
+   RUNNING_SUFFIX while its hook runs, and removed afterwards, so an
+   interrupted hook is not run again.
+
+   A process runs at most MAX-RUNNING hooks of a repository at a time,
+   on threads which wait for more jobs once started.  Once MAX-QUEUED
+   jobs are waiting, further hooks run in the foreground again, which
+   slows commits down to the pace of the hooks instead of letting the
+   queue grow without bound.  When the process exits, it waits for its
+   queued jobs.
+
+   Nobody is left to tell about the failure of a queued hook, so such
+   failures are ignored.  The settings are read once per process.
+   Without threads, or with APR older than 1.3, hooks always run in
+   the foreground. */
+
+/* We need threads, and pre-cleanups to wait for them before the pools
+   they use go away. */
+#if APR_HAS_THREADS && APR_VERSION_AT_LEAST(1, 3, 0)
+#define ASYNC_HOOKS
+#endif
+
+#ifdef ASYNC_HOOKS
+
+#define ASYNC_HOOKS_SECTION   "async-hooks"
+#define JOB_PREFIX            "job"
+#define JOB_SUFFIX            ".hook"
+#define RUNNING_SUFFIX        ".running"
+
+/* The background hooks of one repository in this process. */
+typedef struct hook_queue_t
+{
+  /* Whether the repository wants hooks in the background at all. */
+  svn_boolean_t enabled;
+
+  /* The directory holding the job files. */
+  const char *dir;
+
+  /* The configured limits. */
+  int max_running;
+  int max_queued;
+
+  /* The number of jobs we know of that no thread has taken yet, the
+     number of threads and whether they should stop once the queue is
+     empty.  These are protected by MUTEX, and COND is broadcast when
+     any of them changes. */
+  int queued;
+  int running;
+  svn_boolean_t stopping;
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+} hook_queue_t;
+
+/* The queues of all repositories in this process, keyed by absolute
+   repository path, the pool they and their threads live in and the
+   mutex protecting both. */
+static volatile svn_atomic_t hook_queues_init_state = 0;
+static apr_hash_t *hook_queues = NULL;
+static apr_pool_t *hook_queues_pool = NULL;
+static apr_thread_mutex_t *hook_queues_mutex = NULL;
+
+/* Pool pre-cleanup stopping the threads of all hook queues once they
+   have run the queued jobs. */
+static apr_status_t
+drain_hook_queues(void *data)
+{
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(NULL, hook_queues); hi; hi = apr_hash_next(hi))
+    {
+      hook_queue_t *queue = svn__apr_hash_index_val(hi);
+
+      if (! queue->enabled)
+        continue;
+
+      apr_thread_mutex_lock(queue->mutex);
+      queue->stopping = TRUE;
+      apr_thread_cond_broadcast(queue->cond);
+      while (queue->running > 0)
+        apr_thread_cond_wait(queue->cond, queue->mutex);
+      apr_thread_mutex_unlock(queue->mutex);
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Implements the svn_atomic__init_once init_func. */
+static svn_error_t *
+init_hook_queues(void *baton, apr_pool_t *pool)
+{
+  apr_status_t apr_err;
+
+  hook_queues_pool = svn_pool_create(NULL);
+  apr_err = apr_thread_mutex_create(&hook_queues_mutex,
+                                    APR_THREAD_MUTEX_DEFAULT,
+                                    hook_queues_pool);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err, _("Can't create mutex"));
+  hook_queues = apr_hash_make(hook_queues_pool);
+
+  /* The threads work in subpools of HOOK_QUEUES_POOL, so wait for them
+     before those go away. */
+  apr_pool_pre_cleanup_register(hook_queues_pool, NULL, drain_hook_queues);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if NAME is the name of a job file no thread has taken
+   yet. */
+static svn_boolean_t
+is_job_name(const char *name)
+{
+  apr_size_t len = strlen(name);
+
+  return (strncmp(name, JOB_PREFIX, strlen(JOB_PREFIX)) == 0
+          && len > strlen(JOB_SUFFIX)
+          && strcmp(name + len - strlen(JOB_SUFFIX), JOB_SUFFIX) == 0);
+}
+
+/* Set *NAME to the name of a job file in the queue directory DIR
+   which no thread has taken yet, or to NULL if there is none.
+   Allocate *NAME in POOL. */
+static svn_error_t *
+find_job(const char **name, const char *dir, apr_pool_t *pool)
+{
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+
+  *name = NULL;
+  SVN_ERR(svn_io_get_dirents3(&dirents, dir, TRUE, pool, pool));
+  for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *entry = svn__apr_hash_index_key(hi);
+      apr_size_t len = strlen(entry);
+
+      /* Take the oldest job, as far as we can tell by name. */
+      if (is_job_name(entry)
+          && (! *name || strlen(*name) > len
+              || (strlen(*name) == len && strcmp(*name, entry) > 0)))
+        *name = entry;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Take one job from the queue directory DIR and run its hook, if
+   another thread or process hasn't taken them all yet.  Use POOL for
+   all allocations. */
+static svn_error_t *
+run_job(const char *dir, apr_pool_t *pool)
+{
+  const char *name, *path, *running_path;
+  apr_hash_t *job = apr_hash_make(pool);
+  apr_array_header_t *args;
+  const svn_string_t *hook_name, *cmd, *arg, *stdin_content;
+  apr_file_t *stdin_handle = NULL;
+  svn_stream_t *stream;
+  svn_error_t *err;
+
+  /* Claim a job by renaming it, and look for another one if some other
+     process got there first. */
+  while (1)
+    {
+      SVN_ERR(find_job(&name, dir, pool));
+      if (! name)
+        return SVN_NO_ERROR;
+
+      path = svn_dirent_join(dir, name, pool);
+      running_path = apr_pstrcat(pool, path, RUNNING_SUFFIX, NULL);
+      err = svn_io_file_rename(path, running_path, pool);
+      if (! err)
+        break;
+      if (! APR_STATUS_IS_ENOENT(err->apr_err))
+        return svn_error_return(err);
+      svn_error_clear(err);
+    }
+
+  /* A job file may still be empty if we claimed it while its writer
+     was about to move the job's contents in, see queue_hook().  The
+     writer's rename brings it back for another turn. */
+  err = svn_stream_open_readonly(&stream, running_path, pool, pool);
+  if (! err)
+    {
+      err = svn_hash_read2(job, stream, SVN_HASH_TERMINATOR, pool);
+      svn_error_clear(svn_stream_close(stream));
+    }
+
+  hook_name = apr_hash_get(job, "hook", APR_HASH_KEY_STRING);
+  cmd = apr_hash_get(job, "cmd", APR_HASH_KEY_STRING);
+  if (! err && hook_name && cmd)
+    {
+      args = apr_array_make(pool, 8, sizeof(const char *));
+      APR_ARRAY_PUSH(args, const char *) = cmd->data;
+      while ((arg = apr_hash_get(job, apr_psprintf(pool, "arg%d",
+                                                   args->nelts),
+                                 APR_HASH_KEY_STRING)))
+        APR_ARRAY_PUSH(args, const char *) = arg->data;
+      APR_ARRAY_PUSH(args, const char *) = NULL;
+
+      stdin_content = apr_hash_get(job, "stdin", APR_HASH_KEY_STRING);
+      if (stdin_content)
+        err = create_temp_file(&stdin_handle, stdin_content, pool);
+
+      if (! err)
+        err = run_hook_cmd(NULL, hook_name->data, cmd->data,
+                           (const char **)args->elts, stdin_handle, pool);
+      if (stdin_handle)
+        svn_error_clear(svn_io_file_close(stdin_handle, pool));
+    }
+
+  /* There is no one to report the hook's failure to. */
+  svn_error_clear(err);
+
+  return svn_io_remove_file2(running_path, TRUE, pool);
+}
+
+/* The thread function running the jobs of the hook_queue_t DATA. */
+static void * APR_THREAD_FUNC
+hook_queue_worker(apr_thread_t *thread, void *data)
+{
+  hook_queue_t *queue = data;
+  apr_pool_t *iterpool = svn_pool_create(hook_queues_pool);
+
+  apr_thread_mutex_lock(queue->mutex);
+  while (1)
+    {
+      while (! queue->queued && ! queue->stopping)
+        apr_thread_cond_wait(queue->cond, queue->mutex);
+      if (! queue->queued)
+        break;
+      queue->queued--;
+      apr_thread_mutex_unlock(queue->mutex);
+
+      svn_pool_clear(iterpool);
+      svn_error_clear(run_job(queue->dir, iterpool));
+
+      apr_thread_mutex_lock(queue->mutex);
+    }
+  queue->running--;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  /* We don't call apr_thread_exit(), which would destroy the thread's
+     pool; drain_hook_queues() may be waiting for us while that pool is
+     being cleaned up.  There are only a few threads per queue. */
+  svn_pool_destroy(iterpool);
+  return NULL;
+}
+
+/* Start a thread for QUEUE, whose QUEUE->running already counts it,
+   and return TRUE if that worked.  HOOK_QUEUES_MUTEX must be held, and
+   QUEUE->mutex must not be. */
+static svn_boolean_t
+start_hook_worker(hook_queue_t *queue)
+{
+  apr_threadattr_t *attr;
+  apr_thread_t *thread;
+
+  if (apr_threadattr_create(&attr, hook_queues_pool) == APR_SUCCESS
+      && apr_threadattr_detach_set(attr, 1) == APR_SUCCESS
+      && apr_thread_create(&thread, attr, hook_queue_worker, queue,
+                           hook_queues_pool) == APR_SUCCESS)
+    return TRUE;
+
+  /* The jobs stay queued for the other threads or the next process. */
+  apr_thread_mutex_lock(queue->mutex);
+  queue->running--;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+  return FALSE;
+}
+
+/* Set *QUEUE to the background hook queue of REPOS, setting it up if
+   this is the first time we need it in this process.  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+get_hook_queue(hook_queue_t **queue, svn_repos_t *repos, apr_pool_t *pool)
+{
+  const char *repos_path;
+  apr_status_t apr_err;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_atomic__init_once(&hook_queues_init_state, init_hook_queues,
+                                NULL, pool));
+  SVN_ERR(svn_dirent_get_absolute(&repos_path, repos->path, pool));
+
+  apr_err = apr_thread_mutex_lock(hook_queues_mutex);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err, _("Can't lock mutex"));
+
+  *queue = apr_hash_get(hook_queues, repos_path, APR_HASH_KEY_STRING);
+  if (! *queue)
+    {
+      svn_config_t *cfg;
+      const char *value;
+      apr_hash_t *dirents;
+      apr_hash_index_t *hi;
+
+      *queue = apr_pcalloc(hook_queues_pool, sizeof(**queue));
+      err = svn_config_read(&cfg,
+                            svn_dirent_join(repos->conf_path,
+                                            SVN_REPOS__CONF_HOOKS_CONF,
+                                            pool),
+                            FALSE, pool);
+      if (! err)
+        err = svn_config_get_bool(cfg, &(*queue)->enabled,
+                                  ASYNC_HOOKS_SECTION, "enabled", FALSE);
+      if (! err && (*queue)->enabled)
+        {
+          svn_config_get(cfg, &value, ASYNC_HOOKS_SECTION, "max-running",
+                         "2");
+          (*queue)->max_running = atoi(value) > 0 ? atoi(value) : 1;
+          svn_config_get(cfg, &value, ASYNC_HOOKS_SECTION, "max-queued",
+                         "64");
+          (*queue)->max_queued = atoi(value) > 0 ? atoi(value) : 1;
+          (*queue)->dir = svn_dirent_join(repos_path,
+                                          SVN_REPOS__HOOK_QUEUE_DIR,
+                                          hook_queues_pool);
+          err = svn_io_make_dir_recursively((*queue)->dir, pool);
+        }
+      if (! err && (*queue)->enabled)
+        {
+          apr_err = apr_thread_mutex_create(&(*queue)->mutex,
+                                            APR_THREAD_MUTEX_DEFAULT,
+                                            hook_queues_pool);
+          if (! apr_err)
+            apr_err = apr_thread_cond_create(&(*queue)->cond,
+                                             hook_queues_pool);
+          if (apr_err)
+            err = svn_error_wrap_apr(apr_err, _("Can't create mutex"));
+        }
+
+      /* Pick up the jobs a previous process left behind. */
+      if (! err && (*queue)->enabled)
+        {
+          err = svn_io_get_dirents3(&dirents, (*queue)->dir, TRUE,
+                                    pool, pool);
+          for (hi = apr_hash_first(pool, dirents);
+               ! err && hi;
+               hi = apr_hash_next(hi))
+            {
+              if (is_job_name(svn__apr_hash_index_key(hi)))
+                (*queue)->queued++;
+            }
+        }
+
+      if (err)
+        (*queue)->enabled = FALSE;
+      apr_hash_set(hook_queues, apr_pstrdup(hook_queues_pool, repos_path),
+                   APR_HASH_KEY_STRING, *queue);
+
+      /* Only the threads we start here use the queue yet, and they
+         don't change RUNNING until told to stop. */
+      if ((*queue)->enabled)
+        while ((*queue)->running < (*queue)->queued
+               && (*queue)->running < (*queue)->max_running)
+          {
+            (*queue)->running++;
+            if (! start_hook_worker(*queue))
+              break;
+          }
+    }
+
+  apr_thread_mutex_unlock(hook_queues_mutex);
+
+  /* If we can't run hooks in the background, run them in the
+     foreground as always. */
+  svn_error_clear(err);
+  return SVN_NO_ERROR;
+}
+
+/* Record the run of the hook NAME, with the program CMD and the
+   arguments ARGS (as for run_hook_cmd()) and the contents of
+   STDIN_HANDLE, if not NULL, as stdin, as a job of QUEUE.  Set *QUEUED
+   to TRUE if we did, or to FALSE if the queue is full.  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+queue_hook(svn_boolean_t *queued,
+           hook_queue_t *queue,
+           const char *name,
+           const char *cmd,
+           const char **args,
+           apr_file_t *stdin_handle,
+           apr_pool_t *pool)
+{
+  apr_hash_t *job = apr_hash_make(pool);
+  svn_stringbuf_t *contents = svn_stringbuf_create("", pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(contents, pool);
+  const char *tmp_path, *job_path;
+  apr_file_t *job_file;
+  apr_status_t apr_err;
+  svn_boolean_t new_thread;
+  int i;
+
+  apr_err = apr_thread_mutex_lock(queue->mutex);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err, _("Can't lock mutex"));
+  *queued = (queue->queued < queue->max_queued);
+  apr_thread_mutex_unlock(queue->mutex);
+  if (! *queued)
+    return SVN_NO_ERROR;
+
+  apr_hash_set(job, "hook", APR_HASH_KEY_STRING,
+               svn_string_create(name, pool));
+  apr_hash_set(job, "cmd", APR_HASH_KEY_STRING,
+               svn_string_create(cmd, pool));
+  for (i = 1; args[i]; i++)
+    apr_hash_set(job, apr_psprintf(pool, "arg%d", i), APR_HASH_KEY_STRING,
+                 svn_string_create(args[i], pool));
+  if (stdin_handle)
+    {
+      svn_stringbuf_t *stdin_content;
+
+      SVN_ERR(svn_stringbuf_from_aprfile(&stdin_content, stdin_handle, pool));
+      apr_hash_set(job, "stdin", APR_HASH_KEY_STRING,
+                   svn_string_create_from_buf(stdin_content, pool));
+    }
+  SVN_ERR(svn_hash_write2(job, stream, SVN_HASH_TERMINATOR, pool));
+
+  /* Write the job under a name the workers ignore, reserve a job name
+     and move the job there, so that no worker sees half a job. */
+  SVN_ERR(svn_io_write_unique(&tmp_path, queue->dir, contents->data,
+                              contents->len, svn_io_file_del_none, pool));
+  SVN_ERR(svn_io_open_uniquely_named(&job_file, &job_path, queue->dir,
+                                     JOB_PREFIX, JOB_SUFFIX,
+                                     svn_io_file_del_none, pool, pool));
+  SVN_ERR(svn_io_file_close(job_file, pool));
+  SVN_ERR(svn_io_file_rename(tmp_path, job_path, pool));
+
+  apr_err = apr_thread_mutex_lock(queue->mutex);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err, _("Can't lock mutex"));
+  queue->queued++;
+  new_thread = (queue->running < queue->max_running);
+  if (new_thread)
+    queue->running++;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  if (new_thread)
+    {
+      apr_err = apr_thread_mutex_lock(hook_queues_mutex);
+      if (apr_err)
+        return svn_error_wrap_apr(apr_err, _("Can't lock mutex"));
+      start_hook_worker(queue);
+      apr_thread_mutex_unlock(hook_queues_mutex);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* ASYNC_HOOKS */
+
+/* Run the post-event hook NAME with CMD, ARGS and STDIN_HANDLE as
+   run_hook_cmd() does, or queue it to run in the background if REPOS
+   is configured for that. */
+static svn_error_t *
+run_post_hook(svn_repos_t *repos,
+              const char *name,
+              const char *cmd,
+              const char **args,
+              apr_file_t *stdin_handle,
+              apr_pool_t *pool)
+{
+#ifdef ASYNC_HOOKS
+  hook_queue_t *queue;
+
+  SVN_ERR(get_hook_queue(&queue, repos, pool));
+  if (queue->enabled)
+    {
+      svn_boolean_t queued;
+
+      SVN_ERR(queue_hook(&queued, queue, name, cmd, args, stdin_handle,
+                         pool));
+      if (queued)
+        return SVN_NO_ERROR;
+    }
+#endif
+
+  return run_hook_cmd(NULL, name, cmd, args, stdin_handle, pool);
+}
+
+
 /* Check if the HOOK program exists and is a file or a symbolic link, using
    POOL for temporary allocations.
 
    If the hook exists but is a broken symbolic link, set *BROKEN_LINK
    to TRUE, else if the hook program exists set *BROKEN_LINK to FALSE.
 
-   Return the hook program if found, else return NULL and don't touch
+   Return the hook program if found.  Failing that, return the socket
+   of the repository's hook server, if there is one, and set
+   *BROKEN_LINK to FALSE.  Else return NULL and don't touch
    *BROKEN_LINK.
 */
 static const char*
@@ -366,6 +1033,26 @@ check_hook_cmd(const char *hook, svn_boolean_t *broken_link, apr_pool_t *pool)
         }
       svn_error_clear(err);
     }
+
+#ifndef WIN32
+  {
+    const char *socket_path
+      = svn_dirent_join(svn_dirent_dirname(hook, pool),
+                        SVN_REPOS__HOOK_SERVER_SOCKET, pool);
+    const char *local_path;
+    apr_finfo_t finfo;
+
+    if (!(err = svn_utf_cstring_from_utf8(&local_path, socket_path, pool))
+        && apr_stat(&finfo, local_path, APR_FINFO_TYPE, pool) == APR_SUCCESS
+        && finfo.filetype == APR_SOCK)
+      {
+        *broken_link = FALSE;
+        return socket_path;
+      }
+    svn_error_clear(err);
+  }
+#endif
+
   return NULL;
 }
 
@@ -524,8 +1211,8 @@ svn_repos__hooks_post_commit(svn_repos_t *repos,
       args[2] = apr_psprintf(pool, "%ld", rev);
       args[3] = NULL;
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_COMMIT, hook, args, NULL,
-                           pool));
+      SVN_ERR(run_post_hook(repos, SVN_REPOS__HOOK_POST_COMMIT, hook, args,
+                            NULL, pool));
     }
 
   return SVN_NO_ERROR;
@@ -634,8 +1321,8 @@ svn_repos__hooks_post_revprop_change(svn_repos_t *repos,
       args[5] = action_string;
       args[6] = NULL;
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_REVPROP_CHANGE, hook,
-                           args, stdin_handle, pool));
+      SVN_ERR(run_post_hook(repos, SVN_REPOS__HOOK_POST_REVPROP_CHANGE,
+                            hook, args, stdin_handle, pool));
 
       SVN_ERR(svn_io_file_close(stdin_handle, pool));
     }
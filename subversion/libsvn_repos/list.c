@@ -0,0 +1,182 @@
+/* list.c --- listing directory trees in a single walk
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_path.h"
+#include "svn_time.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+#include "svn_private_config.h"
+
+#include "private/svn_fs_private.h"
+
+#include "repos.h"
+
+/* Fill in the fields of DIRENT given by DIRENT_FIELDS for the node PATH
+   in ROOT, whose kind is KIND.  Allocate in POOL. */
+static svn_error_t *
+fill_dirent(svn_dirent_t *dirent,
+            svn_fs_root_t *root,
+            const char *path,
+            svn_node_kind_t kind,
+            apr_uint32_t dirent_fields,
+            apr_pool_t *pool)
+{
+  dirent->kind = kind;
+
+  if ((dirent_fields & SVN_DIRENT_SIZE) && kind == svn_node_file)
+    SVN_ERR(svn_fs_file_length(&dirent->size, root, path, pool));
+
+  if (dirent_fields & SVN_DIRENT_HAS_PROPS)
+    {
+      apr_hash_t *props;
+
+      SVN_ERR(svn_fs_node_proplist(&props, root, path, pool));
+      dirent->has_props = (apr_hash_count(props) > 0);
+    }
+
+  if (dirent_fields & (SVN_DIRENT_CREATED_REV | SVN_DIRENT_TIME
+                       | SVN_DIRENT_LAST_AUTHOR))
+    {
+      const char *datestring;
+
+      SVN_ERR(svn_repos_get_committed_info(&dirent->created_rev,
+                                           &datestring,
+                                           &dirent->last_author,
+                                           root, path, pool));
+      if (datestring)
+        SVN_ERR(svn_time_from_cstring(&dirent->time, datestring, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Report the entries of the directory PATH in ROOT, whose path relative
+   to the listed directory is REL_PATH, as svn_repos_list() does for
+   DEPTH.  The other parameters are those of svn_repos_list(). */
+static svn_error_t *
+list_dir(svn_fs_root_t *root,
+         const char *path,
+         const char *rel_path,
+         svn_depth_t depth,
+         apr_uint32_t dirent_fields,
+         svn_repos_authz_func_t authz_read_func,
+         void *authz_read_baton,
+         svn_repos_dirent_receiver_t receiver,
+         void *receiver_baton,
+         svn_cancel_func_t cancel_func,
+         void *cancel_baton,
+         apr_pool_t *pool)
+{
+  apr_array_header_t *entries;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_fs__dir_entries_sorted(&entries, root, path, pool));
+
+  for (i = 0; i < entries->nelts; i++)
+    {
+      svn_fs_dirent_t *fs_dirent = APR_ARRAY_IDX(entries, i,
+                                                 svn_fs_dirent_t *);
+      const char *child_path, *child_rel_path;
+      svn_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      if (fs_dirent->kind != svn_node_file && depth == svn_depth_files)
+        continue;
+
+      child_path = svn_path_join(path, fs_dirent->name, iterpool);
+      if (authz_read_func)
+        {
+          svn_boolean_t readable;
+
+          SVN_ERR(authz_read_func(&readable, root, child_path,
+                                  authz_read_baton, iterpool));
+          if (! readable)
+            continue;
+        }
+
+      child_rel_path = svn_relpath_join(rel_path, fs_dirent->name, iterpool);
+      dirent = apr_pcalloc(iterpool, sizeof(*dirent));
+      SVN_ERR(fill_dirent(dirent, root, child_path, fs_dirent->kind,
+                          dirent_fields, iterpool));
+      SVN_ERR(receiver(child_rel_path, dirent, receiver_baton, iterpool));
+
+      if (depth == svn_depth_infinity && fs_dirent->kind == svn_node_dir)
+        SVN_ERR(list_dir(root, child_path, child_rel_path, depth,
+                         dirent_fields, authz_read_func, authz_read_baton,
+                         receiver, receiver_baton, cancel_func, cancel_baton,
+                         iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_list(svn_fs_root_t *root,
+               const char *path,
+               svn_depth_t depth,
+               apr_uint32_t dirent_fields,
+               svn_repos_authz_func_t authz_read_func,
+               void *authz_read_baton,
+               svn_repos_dirent_receiver_t receiver,
+               void *receiver_baton,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool)
+{
+  svn_node_kind_t kind;
+
+  if (authz_read_func)
+    {
+      svn_boolean_t readable;
+
+      SVN_ERR(authz_read_func(&readable, root, path, authz_read_baton,
+                              scratch_pool));
+      if (! readable)
+        return svn_error_create(SVN_ERR_AUTHZ_UNREADABLE, NULL,
+                                _("Unreadable path encountered; "
+                                  "access denied"));
+    }
+
+  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+  if (kind != svn_node_dir)
+    return svn_error_createf(SVN_ERR_FS_NOT_DIRECTORY, NULL,
+                             _("Path '%s' not a directory"), path);
+
+  if (depth == svn_depth_empty)
+    return SVN_NO_ERROR;
+
+  return list_dir(root, path, "", depth, dirent_fields,
+                  authz_read_func, authz_read_baton,
+                  receiver, receiver_baton, cancel_func, cancel_baton,
+                  scratch_pool);
+}
@@ -557,8 +557,24 @@ parse_text_block(svn_stream_t *stream,
         SVN_ERR(svn_stream_write(text_stream, "", &wlen));
     }
 
-  /* Regardless of whether or not we have a sink for our data, we
-     need to read it. */
+  /* Without a sink for our data, just get past it. */
+  if (! text_stream)
+    {
+      while (content_length)
+        {
+          if (content_length >= buflen)
+            rlen = buflen;
+          else
+            rlen = (apr_size_t) content_length;
+
+          num_to_read = rlen;
+          SVN_ERR(svn_stream_skip(stream, &rlen));
+          content_length -= rlen;
+          if (rlen != num_to_read)
+            return stream_ran_dry();
+        }
+    }
+
   while (content_length)
     {
       if (content_length >= buflen)
@@ -572,17 +588,14 @@ parse_text_block(svn_stream_t *stream,
       if (rlen != num_to_read)
         return stream_ran_dry();
 
-      if (text_stream)
+      /* write however many bytes you read. */
+      wlen = rlen;
+      SVN_ERR(svn_stream_write(text_stream, buffer, &wlen));
+      if (wlen != rlen)
         {
-          /* write however many bytes you read. */
-          wlen = rlen;
-          SVN_ERR(svn_stream_write(text_stream, buffer, &wlen));
-          if (wlen != rlen)
-            {
-              /* Uh oh, didn't write as many bytes as we read. */
-              return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
-                                      _("Unexpected EOF writing contents"));
-            }
+          /* Uh oh, didn't write as many bytes as we read. */
+          return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
+                                  _("Unexpected EOF writing contents"));
         }
     }
 
@@ -886,7 +899,7 @@ svn_repos_parse_dumpstream2(svn_stream_t *stream,
                 rlen = (apr_size_t) remaining;
 
               num_to_read = rlen;
-              SVN_ERR(svn_stream_read(stream, buffer, &rlen));
+              SVN_ERR(svn_stream_skip(stream, &rlen));
               remaining -= rlen;
               if (rlen != num_to_read)
                 return stream_ran_dry();
@@ -36,7 +36,11 @@
 #include "svn_sorts.h"
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
+#include "svn_hash.h"
 #include "repos.h"
+#include "private/svn_cache.h"
+#include "private/svn_fs_private.h"
+#include "private/svn_workers.h"
 
 
 
@@ -179,27 +183,23 @@ detect_changed(apr_hash_t **changed,
                void *authz_read_baton,
                apr_pool_t *pool)
 {
-  apr_hash_t *changes;
-  apr_hash_index_t *hi;
+  svn_fs_path_change_iterator_t *changes;
   apr_pool_t *subpool = svn_pool_create(pool);
   svn_boolean_t found_readable = FALSE;
   svn_boolean_t found_unreadable = FALSE;
 
   *changed = apr_hash_make(pool);
-  SVN_ERR(svn_fs_paths_changed2(&changes, root, pool));
 
-  if (apr_hash_count(changes) == 0)
-    /* No paths changed in this revision?  Uh, sure, I guess the
-       revision is readable, then.  */
-    return SVN_NO_ERROR;
+  /* Walk the changes one at a time rather than fetching them all
+     up-front; huge revisions would otherwise need their changes in
+     memory twice. */
+  SVN_ERR(svn_fs_paths_changed_iterator(&changes, root, pool));
 
-  for (hi = apr_hash_first(pool, changes); hi; hi = apr_hash_next(hi))
+  while (TRUE)
     {
       /* NOTE:  Much of this loop is going to look quite similar to
          svn_repos_check_revision_access(), but we have to do more things
          here, so we'll live with the duplication. */
-      const void *key;
-      void *val;
       svn_fs_path_change2_t *change;
       const char *path;
       char action;
@@ -207,10 +207,9 @@ detect_changed(apr_hash_t **changed,
 
       svn_pool_clear(subpool);
 
-      /* KEY will be the path, VAL the change. */
-      apr_hash_this(hi, &key, NULL, &val);
-      path = (const char *) key;
-      change = val;
+      SVN_ERR(svn_fs_path_change_get(&path, &change, changes, subpool));
+      if (! path)
+        break;
 
       /* Skip path if unreadable. */
       if (authz_read_func)
@@ -265,8 +264,14 @@ detect_changed(apr_hash_t **changed,
           const char *copyfrom_path;
           svn_revnum_t copyfrom_rev;
 
-          SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
-                                     root, path, subpool));
+          if (change->copyfrom_known)
+            {
+              copyfrom_rev = change->copyfrom_rev;
+              copyfrom_path = change->copyfrom_path;
+            }
+          else
+            SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                       root, path, subpool));
 
           if (copyfrom_path && SVN_IS_VALID_REVNUM(copyfrom_rev))
             {
@@ -298,6 +303,11 @@ detect_changed(apr_hash_t **changed,
 
   svn_pool_destroy(subpool);
 
+  /* No paths changed in this revision?  Uh, sure, I guess the
+     revision is readable, then.  */
+  if (! found_readable && ! found_unreadable)
+    return SVN_NO_ERROR;
+
   if (! found_readable)
     /* Every changed-path was unreadable. */
     return svn_error_create(SVN_ERR_AUTHZ_UNREADABLE,
@@ -333,8 +343,463 @@ struct path_info
   svn_fs_history_t *hist;
   apr_pool_t *newpool;
   apr_pool_t *oldpool;
+
+  /* If the history is being traced on worker threads, the locations
+     found there, else NULL. */
+  struct history_prefetch_t *prefetch;
 };
 
+/* Set INFO->DONE if the history location INFO->PATH in INFO->HISTORY_REV
+ * predates START or, if AUTHZ_READ_FUNC is not NULL, is not readable
+ * according to it and AUTHZ_READ_BATON.  Use POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+check_history_location(struct path_info *info,
+                       svn_fs_t *fs,
+                       svn_repos_authz_func_t authz_read_func,
+                       void *authz_read_baton,
+                       svn_revnum_t start,
+                       apr_pool_t *pool)
+{
+  if (info->history_rev < start)
+    {
+      info->done = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  if (authz_read_func)
+    {
+      svn_fs_root_t *root;
+      svn_boolean_t readable;
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, info->history_rev, pool));
+      SVN_ERR(authz_read_func(&readable, root, info->path->data,
+                              authz_read_baton, pool));
+      if (! readable)
+        info->done = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Advance to the next history for the path like get_history(), but look
+ * up the revision in the log index of FS rather than walking the node
+ * history: the node at INFO->PATH changed last in the youngest revision
+ * in which anything at or below that path changed, unless the node got
+ * added or copied in between.  Set *HANDLED to FALSE and leave INFO
+ * alone if FS has no usable index or a copy may be involved; the caller
+ * has to walk the node history then.  INFO->HIST must be NULL.
+ *
+ * START, AUTHZ_READ_FUNC and AUTHZ_READ_BATON are as for get_history().
+ */
+static svn_error_t *
+get_indexed_history(svn_boolean_t *handled,
+                    struct path_info *info,
+                    svn_fs_t *fs,
+                    svn_repos_authz_func_t authz_read_func,
+                    void *authz_read_baton,
+                    svn_revnum_t start,
+                    apr_pool_t *pool)
+{
+  apr_pool_t *subpool;
+  svn_fs_root_t *root, *copy_root;
+  const char *copy_path;
+  svn_revnum_t rev;
+  svn_boolean_t indexed, added;
+
+  *handled = FALSE;
+
+  SVN_ERR(svn_fs__log_index_prev(&indexed, &rev, &added, fs,
+                                 info->path->data, info->history_rev, pool));
+  if (! indexed)
+    return SVN_NO_ERROR;
+
+  subpool = svn_pool_create(pool);
+
+  /* Copies, including those of parent directories, are left to the node
+     history, which knows whether to cross them and where to.  They are
+     rare enough. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, info->history_rev, subpool));
+  SVN_ERR(svn_fs_closest_copy(&copy_root, &copy_path, root,
+                              info->path->data, subpool));
+  if (copy_root
+      && svn_fs_revision_root_revision(copy_root) == info->history_rev)
+    {
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
+    }
+
+  if (! info->first_time)
+    {
+      /* We are at the revision the node got added in; that is where its
+         history starts. */
+      if (rev == info->history_rev && added)
+        {
+          svn_pool_destroy(subpool);
+          info->done = TRUE;
+          *handled = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(svn_fs__log_index_prev(&indexed, &rev, &added, fs,
+                                     info->path->data,
+                                     info->history_rev - 1, subpool));
+    }
+
+  /* Without any change before the copy the node came from, the next
+     history location is the copy itself. */
+  if (! SVN_IS_VALID_REVNUM(rev)
+      || (copy_root && rev <= svn_fs_revision_root_revision(copy_root)))
+    {
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
+    }
+
+  info->history_rev = rev;
+  info->first_time = FALSE;
+  *handled = TRUE;
+
+  SVN_ERR(check_history_location(info, fs, authz_read_func,
+                                 authz_read_baton, start, subpool));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Tracing the histories of multiple paths on worker threads */
+
+/* The number of worker threads tracing path histories, and the number
+   of history locations they find for a path at a time. */
+#define HISTORY_THREADS 4
+#define HISTORY_BATCH 32
+
+/* A history location found on a worker thread. */
+typedef struct history_location_t
+{
+  const char *path;
+  svn_revnum_t rev;
+} history_location_t;
+
+/* Consecutive history locations of a path, found on a worker thread. */
+typedef struct history_batch_t
+{
+  /* Root pool containing this batch. */
+  apr_pool_t *pool;
+
+  /* The locations (history_location_t), youngest first. */
+  apr_array_header_t *locations;
+
+  /* Set if the history ends with LOCATIONS, or they reach beyond the
+     start of the requested range. */
+  svn_boolean_t last;
+
+  /* The error tracing the history, or SVN_NO_ERROR. */
+  svn_error_t *err;
+} history_batch_t;
+
+/* State shared between the main thread and the history workers. */
+typedef struct history_tracers_t
+{
+  /* The filesystem each worker opens on its own, and how to trace the
+     histories in it. */
+  const char *fs_path;
+  svn_boolean_t strict;
+  svn_revnum_t start;
+
+  /* The workers tracing the batches. */
+  svn_workers__t *workers;
+
+  /* All paths being traced (history_prefetch_t *). */
+  apr_array_header_t *prefetches;
+} history_tracers_t;
+
+/* The state of tracing the history of one path on worker threads. */
+typedef struct history_prefetch_t
+{
+  history_tracers_t *tracers;
+
+  /* The batch being consumed by the main thread and the index of the
+     next location in it.  NULL before the first batch arrived. */
+  history_batch_t *current;
+  int next;
+
+  /* The batch requested next, or NULL, and the task tracing it.  Only
+     that task touches PENDING until it is done. */
+  history_batch_t *pending;
+  svn_workers__task_t task;
+
+  /* Where to continue the history for the PENDING batch: the location
+     to start from, and whether it has not been reported yet. */
+  const char *resume_path;
+  svn_revnum_t resume_rev;
+  svn_boolean_t first_time;
+} history_prefetch_t;
+
+/* Fill BATCH with up to HISTORY_BATCH history locations of the path
+   which PREFETCH traces, following its resume point, using FS and the
+   settings in TRACERS.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+trace_history_batch(history_batch_t *batch,
+                    const history_prefetch_t *prefetch,
+                    const history_tracers_t *tracers,
+                    svn_fs_t *fs,
+                    apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  svn_fs_history_t *hist;
+
+  batch->locations = apr_array_make(batch->pool, HISTORY_BATCH,
+                                    sizeof(history_location_t));
+
+  /* Open the history the same way get_history() does without a held
+     history object. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, prefetch->resume_rev,
+                               scratch_pool));
+  SVN_ERR(svn_fs_node_history(&hist, root, prefetch->resume_path,
+                              scratch_pool));
+  SVN_ERR(svn_fs_history_prev(&hist, hist, ! tracers->strict,
+                              scratch_pool));
+  if (hist && ! prefetch->first_time)
+    SVN_ERR(svn_fs_history_prev(&hist, hist, ! tracers->strict,
+                                scratch_pool));
+
+  while (hist)
+    {
+      history_location_t *location = apr_array_push(batch->locations);
+      const char *path;
+
+      SVN_ERR(svn_fs_history_location(&path, &location->rev, hist,
+                                      scratch_pool));
+      location->path = apr_pstrdup(batch->pool, path);
+
+      /* The next batch continues from the last location. */
+      if (location->rev < tracers->start
+          || batch->locations->nelts == HISTORY_BATCH)
+        break;
+
+      SVN_ERR(svn_fs_history_prev(&hist, hist, ! tracers->strict,
+                                  scratch_pool));
+    }
+
+  batch->last = (! hist
+                 || APR_ARRAY_IDX(batch->locations,
+                                  batch->locations->nelts - 1,
+                                  history_location_t).rev < tracers->start);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_workers__process_t.  Trace the pending batch of ITEM,
+   a history_prefetch_t, as BATON, a history_tracers_t, says, using the
+   svn_fs_t of this worker in *WORKER_STATE.  Errors are recorded in the
+   batch, such that they don't stop the tracing of the other paths. */
+static svn_error_t *
+trace_history_task(void *baton,
+                   void **worker_state,
+                   void *item,
+                   apr_pool_t *worker_pool,
+                   apr_pool_t *scratch_pool)
+{
+  history_tracers_t *tracers = baton;
+  history_prefetch_t *prefetch = item;
+  history_batch_t *batch = prefetch->pending;
+
+  if (! *worker_state)
+    {
+      svn_fs_t *fs;
+
+      batch->err = svn_fs_open(&fs, tracers->fs_path, NULL, worker_pool);
+      if (batch->err)
+        return SVN_NO_ERROR;
+      *worker_state = fs;
+    }
+
+  batch->err = trace_history_batch(batch, prefetch, tracers,
+                                   *worker_state, scratch_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Queue the next batch of PREFETCH, continuing the history from PATH in
+   REV, for a worker to trace.  If FIRST_TIME is set, that location has
+   not been reported yet.  PATH must stay valid until the batch has been
+   traced. */
+static void
+request_history_batch(history_prefetch_t *prefetch,
+                      const char *path,
+                      svn_revnum_t rev,
+                      svn_boolean_t first_time)
+{
+  history_tracers_t *tracers = prefetch->tracers;
+  apr_pool_t *batch_pool = svn_pool_create(NULL);
+  history_batch_t *batch = apr_pcalloc(batch_pool, sizeof(*batch));
+
+  batch->pool = batch_pool;
+
+  prefetch->pending = batch;
+  prefetch->resume_path = path;
+  prefetch->resume_rev = rev;
+  prefetch->first_time = first_time;
+  svn_workers__queue(tracers->workers, &prefetch->task, prefetch);
+}
+
+/* Destroy BATCH, if not NULL, clearing any error it holds. */
+static void
+destroy_history_batch(history_batch_t *batch)
+{
+  if (batch)
+    {
+      svn_error_clear(batch->err);
+      svn_pool_destroy(batch->pool);
+    }
+}
+
+/* Stop and join the workers of DATA, a history_tracers_t, and release
+   all batches.  This is a pool cleanup handler. */
+static apr_status_t
+stop_history_tracers(void *data)
+{
+  history_tracers_t *tracers = data;
+  int i;
+
+  svn_workers__stop(tracers->workers);
+
+  for (i = 0; i < tracers->prefetches->nelts; ++i)
+    {
+      history_prefetch_t *prefetch
+        = APR_ARRAY_IDX(tracers->prefetches, i, history_prefetch_t *);
+
+      destroy_history_batch(prefetch->pending);
+      destroy_history_batch(prefetch->current);
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Return worker threads for tracing the histories of up to PATH_COUNT
+   paths of FS, as far back as START and following copies unless STRICT
+   is set, or NULL if no thread could be started.  The workers get
+   stopped when POOL is cleaned up. */
+static history_tracers_t *
+start_history_tracers(svn_fs_t *fs,
+                      int path_count,
+                      svn_revnum_t start,
+                      svn_boolean_t strict,
+                      apr_pool_t *pool)
+{
+  history_tracers_t *tracers = apr_pcalloc(pool, sizeof(*tracers));
+
+  tracers->fs_path = svn_fs_path(fs, pool);
+  tracers->strict = strict;
+  tracers->start = start;
+  tracers->workers = svn_workers__start(MIN(HISTORY_THREADS, path_count),
+                                        trace_history_task, tracers, pool);
+  if (! tracers->workers)
+    return NULL;
+
+  tracers->prefetches = apr_array_make(pool, path_count,
+                                       sizeof(history_prefetch_t *));
+
+  /* Registered after the cleanup of the workers, so this runs first. */
+  apr_pool_cleanup_register(pool, tracers, stop_history_tracers,
+                            apr_pool_cleanup_null);
+
+  return tracers;
+}
+
+/* Set INFO->PREFETCH to trace the history of INFO->PATH, starting at
+   INFO->HISTORY_REV, on the worker threads of TRACERS.  Allocate it in
+   POOL, which must live as long as TRACERS. */
+static void
+prefetch_history(struct path_info *info,
+                 history_tracers_t *tracers,
+                 apr_pool_t *pool)
+{
+  history_prefetch_t *prefetch = apr_pcalloc(pool, sizeof(*prefetch));
+
+  prefetch->tracers = tracers;
+  APR_ARRAY_PUSH(tracers->prefetches, history_prefetch_t *) = prefetch;
+  info->prefetch = prefetch;
+
+  request_history_batch(prefetch, apr_pstrdup(pool, info->path->data),
+                        info->history_rev, TRUE);
+}
+
+/* Advance to the next history for the path like get_history(), taking
+ * the location from INFO->PREFETCH.  Ask for the batch after the next
+ * as soon as a batch gets used, so that the workers stay one batch
+ * ahead.
+ */
+static svn_error_t *
+get_prefetched_history(struct path_info *info,
+                       svn_fs_t *fs,
+                       svn_repos_authz_func_t authz_read_func,
+                       void *authz_read_baton,
+                       svn_revnum_t start,
+                       apr_pool_t *pool)
+{
+  history_prefetch_t *prefetch = info->prefetch;
+  history_tracers_t *tracers = prefetch->tracers;
+  history_location_t *location;
+
+  if (! prefetch->current
+      || prefetch->next == prefetch->current->locations->nelts)
+    {
+      history_batch_t *batch;
+
+      if (prefetch->current && prefetch->current->last)
+        {
+          info->done = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(svn_workers__wait(tracers->workers, &prefetch->task));
+      batch = prefetch->pending;
+      prefetch->pending = NULL;
+
+      /* The worker is done with the resume point in the current batch. */
+      destroy_history_batch(prefetch->current);
+      prefetch->current = batch;
+      prefetch->next = 0;
+
+      if (batch->err)
+        {
+          svn_error_t *err = batch->err;
+
+          batch->err = SVN_NO_ERROR;
+          batch->last = TRUE;
+          batch->locations = apr_array_make(batch->pool, 0,
+                                            sizeof(history_location_t));
+          return svn_error_return(err);
+        }
+
+      if (! batch->locations->nelts)
+        {
+          info->done = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      if (! batch->last)
+        {
+          location = &APR_ARRAY_IDX(batch->locations,
+                                    batch->locations->nelts - 1,
+                                    history_location_t);
+          request_history_batch(prefetch, location->path, location->rev,
+                                FALSE);
+        }
+    }
+
+  location = &APR_ARRAY_IDX(prefetch->current->locations, prefetch->next++,
+                            history_location_t);
+  svn_stringbuf_set(info->path, location->path);
+  info->history_rev = location->rev;
+  info->first_time = FALSE;
+
+  return svn_error_return(check_history_location(info, fs, authz_read_func,
+                                                 authz_read_baton, start,
+                                                 pool));
+}
+
 /* Advance to the next history for the path.
  *
  * If INFO->HIST is not NULL we do this using that existing history object,
@@ -365,6 +830,12 @@ get_history(struct path_info *info,
   apr_pool_t *subpool;
   const char *path;
 
+  if (info->prefetch)
+    return svn_error_return(get_prefetched_history(info, fs,
+                                                   authz_read_func,
+                                                   authz_read_baton,
+                                                   start, pool));
+
   if (info->hist)
     {
       subpool = info->newpool;
@@ -375,6 +846,13 @@ get_history(struct path_info *info,
     }
   else
     {
+      svn_boolean_t handled;
+
+      SVN_ERR(get_indexed_history(&handled, info, fs, authz_read_func,
+                                  authz_read_baton, start, pool));
+      if (handled)
+        return SVN_NO_ERROR;
+
       subpool = svn_pool_create(pool);
 
       /* Open the history located at the last rev we were at. */
@@ -727,12 +1205,167 @@ fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
   return SVN_NO_ERROR;
 }
 
+/* The result of fs_mergeinfo_changed() for one revision, as cached. */
+typedef struct mergeinfo_changes_t
+{
+  svn_mergeinfo_catalog_t deleted;
+  svn_mergeinfo_catalog_t added;
+} mergeinfo_changes_t;
+
+/* Implements svn_cache__serialize_func_t for mergeinfo_changes_t.
+   The changes are written as a hash dump mapping "-PATH" and "+PATH"
+   to the deleted and added mergeinfo of PATH in their string form. */
+static svn_error_t *
+serialize_mergeinfo_changes(char **data,
+                            apr_size_t *data_len,
+                            void *in,
+                            apr_pool_t *pool)
+{
+  mergeinfo_changes_t *changes = in;
+  apr_hash_t *hash = apr_hash_make(pool);
+  svn_stringbuf_t *buf = svn_stringbuf_create("", pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(pool, changes->added); hi; hi = apr_hash_next(hi))
+    {
+      const char *path = svn__apr_hash_index_key(hi);
+      svn_mergeinfo_t deleted = apr_hash_get(changes->deleted, path,
+                                             APR_HASH_KEY_STRING);
+      svn_string_t *value;
+
+      SVN_ERR(svn_mergeinfo_to_string(&value, deleted, pool));
+      apr_hash_set(hash, apr_pstrcat(pool, "-", path, (char *)NULL),
+                   APR_HASH_KEY_STRING, value);
+      SVN_ERR(svn_mergeinfo_to_string(&value, svn__apr_hash_index_val(hi),
+                                      pool));
+      apr_hash_set(hash, apr_pstrcat(pool, "+", path, (char *)NULL),
+                   APR_HASH_KEY_STRING, value);
+    }
+
+  SVN_ERR(svn_hash_write2(hash, svn_stream_from_stringbuf(buf, pool),
+                          SVN_HASH_TERMINATOR, pool));
+  *data = buf->data;
+  *data_len = buf->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for mergeinfo_changes_t. */
+static svn_error_t *
+deserialize_mergeinfo_changes(void **out,
+                              char *data,
+                              apr_size_t data_len,
+                              apr_pool_t *pool)
+{
+  mergeinfo_changes_t *changes = apr_palloc(pool, sizeof(*changes));
+  apr_hash_t *hash = apr_hash_make(pool);
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_hash_read2(hash,
+                         svn_stream_from_string(svn_string_ncreate(data,
+                                                                   data_len,
+                                                                   pool),
+                                                pool),
+                         SVN_HASH_TERMINATOR, pool));
+
+  changes->deleted = apr_hash_make(pool);
+  changes->added = apr_hash_make(pool);
+  for (hi = apr_hash_first(pool, hash); hi; hi = apr_hash_next(hi))
+    {
+      const char *key = svn__apr_hash_index_key(hi);
+      svn_string_t *value = svn__apr_hash_index_val(hi);
+      svn_mergeinfo_t mergeinfo;
+
+      SVN_ERR(svn_mergeinfo_parse(&mergeinfo, value->data, pool));
+      apr_hash_set(key[0] == '-' ? changes->deleted : changes->added,
+                   key + 1, APR_HASH_KEY_STRING, mergeinfo);
+    }
+
+  *out = changes;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__dup_func_t for mergeinfo_changes_t. */
+static svn_error_t *
+dup_mergeinfo_changes(void **out,
+                      const void *in,
+                      apr_pool_t *pool)
+{
+  const mergeinfo_changes_t *changes = in;
+  mergeinfo_changes_t *copy = apr_palloc(pool, sizeof(*copy));
+
+  copy->deleted = svn_mergeinfo_catalog_dup(changes->deleted, pool);
+  copy->added = svn_mergeinfo_catalog_dup(changes->added, pool);
+
+  *out = copy;
+  return SVN_NO_ERROR;
+}
+
+/* Set *CACHE to a cache of the fs_mergeinfo_changed() results for the
+   revisions of FS, keyed by revision number.  The process-wide membuffer
+   makes them outlive the request; without one, the cache at least saves
+   the repeated diffs within it.  Allocate *CACHE in POOL. */
+static svn_error_t *
+create_mergeinfo_changes_cache(svn_cache__t **cache,
+                               svn_fs_t *fs,
+                               apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *uuid;
+
+  if (! membuffer)
+    return svn_cache__create_inprocess(cache, dup_mergeinfo_changes,
+                                       sizeof(svn_revnum_t), 16, 16, FALSE,
+                                       pool);
+
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, pool));
+  return svn_cache__create_membuffer_cache(cache, membuffer,
+                                           serialize_mergeinfo_changes,
+                                           deserialize_mergeinfo_changes,
+                                           sizeof(svn_revnum_t),
+                                           apr_pstrcat(pool, "repos:", uuid,
+                                                       "/", svn_fs_path(fs,
+                                                                        pool),
+                                                       ":MIC", (char *)NULL),
+                                           pool);
+}
+
+/* Like fs_mergeinfo_changed(), but take the result from CACHE, if it is
+   there, and put it there otherwise. */
+static svn_error_t *
+cached_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
+                         svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
+                         svn_cache__t *cache,
+                         svn_fs_t *fs,
+                         svn_revnum_t rev,
+                         apr_pool_t *pool)
+{
+  mergeinfo_changes_t *changes;
+  svn_boolean_t found;
+
+  SVN_ERR(svn_cache__get((void **)&changes, &found, cache, &rev, pool));
+  if (! found)
+    {
+      changes = apr_palloc(pool, sizeof(*changes));
+      SVN_ERR(fs_mergeinfo_changed(&changes->deleted, &changes->added,
+                                   fs, rev, pool));
+      SVN_ERR(svn_cache__set(cache, &rev, changes, pool));
+    }
+
+  *deleted_mergeinfo_catalog = changes->deleted;
+  *added_mergeinfo_catalog = changes->added;
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Determine what (if any) mergeinfo for PATHS was modified in
    revision REV, returning the diffs as a single combined rangelist in
-   *COMBINED_MERGEINFO.  Use POOL for all allocations. */
+   *COMBINED_MERGEINFO.  Look up the mergeinfo changes of REV in
+   MERGEINFO_CACHE.  Use POOL for all allocations. */
 static svn_error_t *
 get_combined_mergeinfo_changes(svn_mergeinfo_t *combined_mergeinfo,
+                               svn_cache__t *mergeinfo_cache,
                                svn_fs_t *fs,
                                const apr_array_header_t *paths,
                                svn_revnum_t rev,
@@ -760,9 +1393,9 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *combined_mergeinfo,
   SVN_ERR(svn_fs_revision_root(&root, fs, rev, subpool));
 
   /* Fetch the mergeinfo changes for REV. */
-  SVN_ERR(fs_mergeinfo_changed(&deleted_mergeinfo_catalog,
-                               &added_mergeinfo_catalog,
-                               fs, rev, subpool));
+  SVN_ERR(cached_mergeinfo_changed(&deleted_mergeinfo_catalog,
+                                   &added_mergeinfo_catalog,
+                                   mergeinfo_cache, fs, rev, subpool));
 
   /* Check our PATHS for any changes to their inherited mergeinfo.
      (We deal with changes to mergeinfo directly *on* the paths in the
@@ -1048,8 +1681,21 @@ get_path_histories(apr_array_header_t **histories,
 {
   svn_fs_root_t *root;
   apr_pool_t *iterpool;
+  svn_revnum_t rev;
+  svn_boolean_t indexed, added;
+  history_tracers_t *tracers = NULL;
   int i;
 
+  /* Histories held open would not be used if there is a log index. */
+  SVN_ERR(svn_fs__log_index_prev(&indexed, &rev, &added, fs, "/", hist_end,
+                                 pool));
+
+  /* Without an index, each history step is a read from the filesystem.
+     Trace the histories of multiple paths in parallel then. */
+  if (! indexed && paths->nelts > 1)
+    tracers = start_history_tracers(fs, paths->nelts, hist_start,
+                                    strict_node_history, pool);
+
   /* Create a history object for each path so we can walk through
      them all at the same time until we have all changes or LIMIT
      is reached.
@@ -1086,8 +1732,20 @@ get_path_histories(apr_array_header_t **histories,
       info->done = FALSE;
       info->history_rev = hist_end;
       info->first_time = TRUE;
+      info->prefetch = NULL;
 
-      if (i < MAX_OPEN_HISTORIES)
+      /* Have all histories traced before waiting for any of them. */
+      if (tracers)
+        {
+          info->hist = NULL;
+          info->oldpool = NULL;
+          info->newpool = NULL;
+          prefetch_history(info, tracers, pool);
+          APR_ARRAY_PUSH(*histories, struct path_info *) = info;
+          continue;
+        }
+
+      if (i < MAX_OPEN_HISTORIES && ! indexed)
         {
           SVN_ERR(svn_fs_node_history(&info->hist, root, this_path, pool));
           info->newpool = svn_pool_create(pool);
@@ -1108,6 +1766,13 @@ get_path_histories(apr_array_header_t **histories,
     }
   svn_pool_destroy(iterpool);
 
+  if (tracers)
+    for (i = 0; i < (*histories)->nelts; i++)
+      SVN_ERR(get_history(APR_ARRAY_IDX(*histories, i, struct path_info *),
+                          fs, strict_node_history,
+                          authz_read_func, authz_read_baton,
+                          hist_start, pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -1329,6 +1994,7 @@ combine_mergeinfo_path_lists(apr_array_header_t **combined_list,
 /* Pity that C is so ... linear. */
 static svn_error_t *
 do_logs(svn_fs_t *fs,
+        svn_cache__t *mergeinfo_cache,
         const apr_array_header_t *paths,
         svn_revnum_t hist_start,
         svn_revnum_t hist_end,
@@ -1358,6 +2024,7 @@ do_logs(svn_fs_t *fs,
 static svn_error_t *
 handle_merged_revisions(svn_revnum_t rev,
                         svn_fs_t *fs,
+                        svn_cache__t *mergeinfo_cache,
                         svn_mergeinfo_t mergeinfo,
                         svn_boolean_t discover_changed_paths,
                         svn_boolean_t strict_node_history,
@@ -1388,7 +2055,8 @@ handle_merged_revisions(svn_revnum_t rev,
         = APR_ARRAY_IDX(combined_list, i, struct path_list_range *);
 
       svn_pool_clear(iterpool);
-      err = do_logs(fs, pl_range->paths, pl_range->range.start,
+      err = do_logs(fs, mergeinfo_cache, pl_range->paths,
+                    pl_range->range.start,
                     pl_range->range.end, 0, discover_changed_paths,
                     strict_node_history, TRUE, revprops, TRUE,
                     receiver, receiver_baton, authz_read_func,
@@ -1415,10 +2083,15 @@ handle_merged_revisions(svn_revnum_t rev,
    the logs back as we find them, else buffer the logs and send them back
    in youngest->oldest order.
 
+   If INCLUDE_MERGED_REVISIONS is TRUE, MERGEINFO_CACHE is the cache
+   of per-revision mergeinfo changes made by
+   create_mergeinfo_changes_cache(); it is unused otherwise.
+
    Other parameters are the same as svn_repos_get_logs4().
  */
 static svn_error_t *
 do_logs(svn_fs_t *fs,
+        svn_cache__t *mergeinfo_cache,
         const apr_array_header_t *paths,
         svn_revnum_t hist_start,
         svn_revnum_t hist_end,
@@ -1499,8 +2172,10 @@ do_logs(svn_fs_t *fs,
                                                          struct path_info *);
                   APR_ARRAY_PUSH(cur_paths, const char *) = info->path->data;
                 }
-              SVN_ERR(get_combined_mergeinfo_changes(&mergeinfo, fs, cur_paths,
-                                                     current, iterpool));
+              SVN_ERR(get_combined_mergeinfo_changes(&mergeinfo,
+                                                     mergeinfo_cache, fs,
+                                                     cur_paths, current,
+                                                     iterpool));
               has_children = (apr_hash_count(mergeinfo) > 0);
             }
 
@@ -1514,7 +2189,8 @@ do_logs(svn_fs_t *fs,
                                authz_read_func, authz_read_baton, iterpool));
               if (has_children)
                 {
-                  SVN_ERR(handle_merged_revisions(current, fs, mergeinfo,
+                  SVN_ERR(handle_merged_revisions(current, fs,
+                                                  mergeinfo_cache, mergeinfo,
                                                   discover_changed_paths,
                                                   strict_node_history, revprops,
                                                   receiver, receiver_baton,
@@ -1579,7 +2255,8 @@ do_logs(svn_fs_t *fs,
                            authz_read_baton, iterpool));
           if (has_children)
             {
-              SVN_ERR(handle_merged_revisions(current, fs, mergeinfo,
+              SVN_ERR(handle_merged_revisions(current, fs,
+                                              mergeinfo_cache, mergeinfo,
                                               discover_changed_paths,
                                               strict_node_history, revprops,
                                               receiver, receiver_baton,
@@ -1616,6 +2293,7 @@ svn_repos_get_logs4(svn_repos_t *repos,
   svn_revnum_t head = SVN_INVALID_REVNUM;
   svn_fs_t *fs = repos->fs;
   svn_boolean_t descending_order;
+  svn_cache__t *mergeinfo_cache = NULL;
 
   /* Setup log range. */
   SVN_ERR(svn_fs_youngest_rev(&head, fs, pool));
@@ -1684,7 +2362,12 @@ svn_repos_get_logs4(svn_repos_t *repos,
       return SVN_NO_ERROR;
     }
 
-  return do_logs(repos->fs, paths, start, end, limit,
+  /* Many revisions merged into REV tend to come up again as merged
+     into other revisions, or in later log requests. */
+  if (include_merged_revisions)
+    SVN_ERR(create_mergeinfo_changes_cache(&mergeinfo_cache, fs, pool));
+
+  return do_logs(repos->fs, mergeinfo_cache, paths, start, end, limit,
                  discover_changed_paths, strict_node_history,
                  include_merged_revisions, revprops, descending_order,
                  receiver, receiver_baton,
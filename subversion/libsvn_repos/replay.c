@@ -136,6 +136,10 @@ struct path_driver_cb_baton
   int base_path_len;
 
   svn_revnum_t low_water_mark;
+  /* The root of LOW_WATER_MARK, if that is older than the revision we're
+     replaying, else NULL. */
+  svn_fs_root_t *low_water_root;
+
   /* Stack of active copy operations. */
   apr_array_header_t *copies;
 
@@ -225,7 +229,7 @@ add_subdir(svn_fs_root_t *source_root,
 
       if (authz_read_func)
         SVN_ERR(authz_read_func(&readable, target_root, new_path,
-                                authz_read_baton, pool));
+                                authz_read_baton, subpool));
 
       if (! readable)
         continue;
@@ -250,12 +254,15 @@ add_subdir(svn_fs_root_t *source_root,
           svn_txdelta_stream_t *delta_stream;
           svn_checksum_t *checksum;
 
+          /* Everything about this file, including its delta stream, lives
+             in SUBPOOL.  Copies of large trees would otherwise pile up
+             the data of all of their files in POOL. */
           SVN_ERR(editor->add_file(new_path, *dir_baton, NULL,
-                                   SVN_INVALID_REVNUM, pool, &file_baton));
+                                   SVN_INVALID_REVNUM, subpool, &file_baton));
 
           SVN_ERR(svn_fs_node_proplist(&props, target_root, new_path, subpool));
 
-          for (phi = apr_hash_first(pool, props);
+          for (phi = apr_hash_first(subpool, props);
                phi;
                phi = apr_hash_next(phi))
             {
@@ -269,24 +276,25 @@ add_subdir(svn_fs_root_t *source_root,
                                                subpool));
             }
 
-          SVN_ERR(editor->apply_textdelta(file_baton, NULL, pool,
+          SVN_ERR(editor->apply_textdelta(file_baton, NULL, subpool,
                                           &delta_handler,
                                           &delta_handler_baton));
 
           SVN_ERR(svn_fs_get_file_delta_stream
                   (&delta_stream, NULL, NULL, target_root, new_path,
-                   pool));
+                   subpool));
 
           SVN_ERR(svn_txdelta_send_txstream(delta_stream,
                                             delta_handler,
                                             delta_handler_baton,
-                                            pool));
+                                            subpool));
 
           SVN_ERR(svn_fs_file_checksum(&checksum, svn_checksum_md5, target_root,
-                                       new_path, TRUE, pool));
+                                       new_path, TRUE, subpool));
           SVN_ERR(editor->close_file(file_baton,
-                                     svn_checksum_to_cstring(checksum, pool),
-                                     pool));
+                                     svn_checksum_to_cstring(checksum,
+                                                             subpool),
+                                     subpool));
         }
       else
         SVN_ERR_MALFUNCTION();
@@ -418,6 +426,36 @@ path_driver_cb_func(void **dir_baton,
             }
         }
 
+      /* The receiver does not know copy sources prior to the low water
+         mark.  But if the source is still the same node there, it can
+         copy it from the low water mark instead, which saves sending the
+         whole subtree. */
+      if (copyfrom_path
+          && cb->low_water_root
+          && cb->low_water_mark > copyfrom_rev
+          && src_readable
+          && is_within_base_path(copyfrom_path + 1, base_path, base_path_len))
+        {
+          svn_node_kind_t kind;
+
+          SVN_ERR(svn_fs_check_path(&kind, cb->low_water_root, copyfrom_path,
+                                    pool));
+          if (kind == change->node_kind)
+            {
+              const svn_fs_id_t *id, *low_water_id;
+
+              SVN_ERR(svn_fs_node_id(&id, copyfrom_root, copyfrom_path,
+                                     pool));
+              SVN_ERR(svn_fs_node_id(&low_water_id, cb->low_water_root,
+                                     copyfrom_path, pool));
+              if (svn_fs_compare_ids(id, low_water_id) == 0)
+                {
+                  copyfrom_root = cb->low_water_root;
+                  copyfrom_rev = cb->low_water_mark;
+                }
+            }
+        }
+
       /* If we have a copyfrom path, and we can't read it or we're just
          ignoring it, or the copyfrom rev is prior to the low water mark
          then we just null them out and do a raw add with no history at
@@ -735,6 +773,40 @@ svn_repos_replay2(svn_fs_root_t *root,
         }
     }
 
+  /* Filesystems that don't record node kinds in their changes leave them
+     to us; look them all up at once rather than one at a time while
+     driving the editor. */
+  {
+    apr_array_header_t *unknown_paths
+      = apr_array_make(pool, 0, sizeof(const char *));
+    apr_array_header_t *unknown_changes
+      = apr_array_make(pool, 0, sizeof(svn_fs_path_change2_t *));
+    apr_array_header_t *kinds;
+    int i;
+
+    for (i = 0; i < paths->nelts; i++)
+      {
+        const char *path = APR_ARRAY_IDX(paths, i, const char *);
+        svn_fs_path_change2_t *change
+          = apr_hash_get(changed_paths, path, APR_HASH_KEY_STRING);
+
+        if (change->node_kind == svn_node_unknown
+            && change->change_kind != svn_fs_path_change_delete)
+          {
+            APR_ARRAY_PUSH(unknown_paths, const char *) = path;
+            APR_ARRAY_PUSH(unknown_changes, svn_fs_path_change2_t *) = change;
+          }
+      }
+
+    if (unknown_paths->nelts)
+      {
+        SVN_ERR(svn_fs_check_paths(&kinds, NULL, root, unknown_paths, pool));
+        for (i = 0; i < kinds->nelts; i++)
+          APR_ARRAY_IDX(unknown_changes, i, svn_fs_path_change2_t *)->node_kind
+            = APR_ARRAY_IDX(kinds, i, svn_node_kind_t);
+      }
+  }
+
   /* If we were not given a low water mark, assume that everything is there,
      all the way back to revision 0. */
   if (! SVN_IS_VALID_REVNUM(low_water_mark))
@@ -750,8 +822,17 @@ svn_repos_replay2(svn_fs_root_t *root,
   cb_baton.base_path = base_path;
   cb_baton.base_path_len = base_path_len;
   cb_baton.low_water_mark = low_water_mark;
+  cb_baton.low_water_root = NULL;
   cb_baton.compare_root = NULL;
 
+  if (low_water_mark > 0
+      && low_water_mark < (svn_fs_is_revision_root(root)
+                           ? svn_fs_revision_root_revision(root)
+                           : svn_fs_txn_root_base_revision(root) + 1))
+    SVN_ERR(svn_fs_revision_root(&cb_baton.low_water_root,
+                                 svn_fs_root_fs(root), low_water_mark,
+                                 pool));
+
   if (send_deltas)
     {
       SVN_ERR(svn_fs_revision_root(&cb_baton.compare_root,
@@ -21,6 +21,8 @@
  * ====================================================================
  */
 
+#include <stdlib.h>       /* for qsort()   */
+
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
 #include "svn_types.h"
@@ -32,36 +34,56 @@
 #include "svn_props.h"
 #include "repos.h"
 #include "svn_private_config.h"
+#include "private/svn_fs_private.h"
 
 #define NUM_CACHED_SOURCE_ROOTS 4
 
-/* Theory of operation: we write report operations out to a temporary
-   file as we receive them.  When the report is finished, we read the
-   operations back out again, using them to guide the progression of
-   the delta between the source and target revs.
-
-   Temporary file format: we use a simple ad-hoc format to store the
-   report operations.  Each report operation is the concatention of
-   the following ("+/-" indicates the single character '+' or '-';
-   <length> and <revnum> are written out as decimal strings):
-
-     +/-                      '-' marks the end of the report
-     If previous is +:
-       <length>:<bytes>       Length-counted path string
-       +/-                    '+' indicates the presence of link_path
-       If previous is +:
-         <length>:<bytes>     Length-counted link_path string
-       +/-                    '+' indicates presence of revnum
-       If previous is +:
-         <revnum>:            Revnum of set_path or link_path
-       +/-                    '+' indicates depth other than svn_depth_infinity
-       If previous is +:
-         <depth>:             "X","E","F","M" =>
+/* The largest number of revisions between the oldest revision in a
+   report and the target revision for which we summarize the changes
+   up front.  Beyond it, reading all the changed-path lists costs more
+   than we can hope to save. */
+#define MAX_SUMMARY_REVISIONS 128
+
+/* The amount of report data we keep in memory.  Larger reports are
+   moved to a temporary file. */
+#define REPORT_MEMORY_LIMIT (64 * 1024)
+
+/* The flags of a recorded report operation, see below. */
+#define REPORT_ENTRY       0x01
+#define REPORT_LINK_PATH   0x02
+#define REPORT_REV         0x04
+#define REPORT_DEPTH       0x08
+#define REPORT_START_EMPTY 0x10
+#define REPORT_LOCK_TOKEN  0x20
+
+/* Theory of operation: we record report operations as we receive
+   them, in memory as long as the report is small and in a temporary
+   file once it grows beyond REPORT_MEMORY_LIMIT.  When the report is
+   finished, we read the operations back out again, using them to
+   guide the progression of the delta between the source and target
+   revs.
+
+   Report format: we use a simple binary format to store the report
+   operations.  <number> is an unsigned integer written seven bits per
+   byte, least significant bits first, with the high bit set in all but
+   the last byte.  Each report operation is the concatenation of the
+   following:
+
+     <flags>                  One byte; 0 marks the end of the report,
+                              otherwise REPORT_ENTRY and any of the
+                              other REPORT_* bits below
+     <number><bytes>          Length-counted path string
+     If REPORT_LINK_PATH:
+       <number><bytes>        Length-counted link_path string
+     If REPORT_REV:
+       <number>               Revnum of set_path or link_path
+     If REPORT_DEPTH (depth other than svn_depth_infinity):
+       <depth>                "X","E","F","M" =>
                                  svn_depth_{exclude,empty,files,immediates}
-       +/-                    '+' indicates start_empty field set
-       +/-                    '+' indicates presence of lock_token field.
-       If previous is +:
-         <length>:<bytes>     Length-counted lock_token string
+     If REPORT_LOCK_TOKEN:
+       <number><bytes>        Length-counted lock_token string
+
+   REPORT_START_EMPTY stands for the start_empty field.
 
    Terminology: for brevity, this file frequently uses the prefixes
    "s_" for source, "t_" for target, and "e_" for editor.  Also, to
@@ -109,8 +131,15 @@ typedef struct report_baton_t
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
 
-  /* The temporary file in which we are stashing the report. */
+  /* The report as recorded so far, and the pool to record it in.
+     TEMPFILE is NULL while the report fits in REPORT_BUF; once it
+     doesn't, the whole report goes to TEMPFILE instead. */
+  svn_stringbuf_t *report_buf;
   apr_file_t *tempfile;
+  apr_pool_t *report_pool;
+
+  /* The stream we read the finished report back from. */
+  svn_stream_t *reader;
 
   /* For the actual editor drive, we'll need a lookahead path info
      entry, a cache of FS roots, and a pool to store them. */
@@ -118,6 +147,17 @@ typedef struct report_baton_t
   svn_fs_root_t *t_root;
   svn_fs_root_t *s_roots[NUM_CACHED_SOURCE_ROOTS];
   apr_pool_t *pool;
+
+  /* The oldest revision given by a set_path in the report. */
+  svn_revnum_t min_rev;
+
+  /* A summary of the changes made in revisions MIN_REV+1 through T_REV,
+     or NULL if we didn't build one.  CHANGED_BELOW maps FS paths to the
+     youngest revision which changed the path or anything below it;
+     REPLACED maps FS paths to the youngest revision which added,
+     replaced or deleted the path.  The values are svn_revnum_t *. */
+  apr_hash_t *changed_below;
+  apr_hash_t *replaced;
 } report_baton_t;
 
 /* The type of a function that accepts changes to an object's property
@@ -137,21 +177,42 @@ static svn_error_t *delta_dirs(report_baton_t *b, svn_revnum_t s_rev,
                                svn_depth_t requested_depth,
                                apr_pool_t *pool);
 
+static svn_error_t *write_report_data(report_baton_t *b, const char *data,
+                                      apr_size_t len, apr_pool_t *pool);
+
 /* --- READING PREVIOUSLY STORED REPORT INFORMATION --- */
 
+/* Read a byte from TEMP into *C. */
 static svn_error_t *
-read_number(apr_uint64_t *num, apr_file_t *temp, apr_pool_t *pool)
+read_byte(unsigned char *c, svn_stream_t *temp)
 {
-  char c;
+  apr_size_t len = 1;
+
+  SVN_ERR(svn_stream_read(temp, (char *)c, &len));
+  if (len != 1)
+    return svn_error_create(SVN_ERR_REPOS_BAD_REVISION_REPORT, NULL,
+                            _("Unexpected end of report"));
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+read_number(apr_uint64_t *num, svn_stream_t *temp)
+{
+  unsigned char c;
+  int shift = 0;
 
   *num = 0;
-  while (1)
+  do
     {
-      SVN_ERR(svn_io_file_getc(&c, temp, pool));
-      if (c == ':')
-        break;
-      *num = *num * 10 + (c - '0');
+      if (shift > 63)
+        return svn_error_create(SVN_ERR_REPOS_BAD_REVISION_REPORT, NULL,
+                                _("Invalid number in report"));
+      SVN_ERR(read_byte(&c, temp));
+      *num |= (apr_uint64_t)(c & 0x7f) << shift;
+      shift += 7;
     }
+  while (c & 0x80);
+
   return SVN_NO_ERROR;
 }
 
@@ -161,13 +222,13 @@ read_number(apr_uint64_t *num, apr_file_t *temp, apr_pool_t *pool)
 #endif
 
 static svn_error_t *
-read_string(const char **str, apr_file_t *temp, apr_pool_t *pool)
+read_string(const char **str, svn_stream_t *temp, apr_pool_t *pool)
 {
   apr_uint64_t len;
-  apr_size_t size;
+  apr_size_t size, read_len;
   char *buf;
 
-  SVN_ERR(read_number(&len, temp, pool));
+  SVN_ERR(read_number(&len, temp));
 
   /* Len can never be less than zero.  But could len be so large that
      len + 1 wraps around and we end up passing 0 to apr_palloc(),
@@ -188,39 +249,24 @@ read_string(const char **str, apr_file_t *temp, apr_pool_t *pool)
 
   size = (apr_size_t)len;
   buf = apr_palloc(pool, size+1);
-  SVN_ERR(svn_io_file_read_full(temp, buf, size, NULL, pool));
+  read_len = size;
+  SVN_ERR(svn_stream_read(temp, buf, &read_len));
+  if (read_len != size)
+    return svn_error_create(SVN_ERR_REPOS_BAD_REVISION_REPORT, NULL,
+                            _("Unexpected end of report"));
   buf[len] = 0;
   *str = buf;
   return SVN_NO_ERROR;
 }
 
+/* Read a single character to set *DEPTH from TEMP.  PATH is the path
+   to which the depth applies, and is used for error reporting only. */
 static svn_error_t *
-read_rev(svn_revnum_t *rev, apr_file_t *temp, apr_pool_t *pool)
-{
-  char c;
-  apr_uint64_t num;
-
-  SVN_ERR(svn_io_file_getc(&c, temp, pool));
-  if (c == '+')
-    {
-      SVN_ERR(read_number(&num, temp, pool));
-      *rev = (svn_revnum_t) num;
-    }
-  else
-    *rev = SVN_INVALID_REVNUM;
-  return SVN_NO_ERROR;
-}
-
-/* Read a single character to set *DEPTH (having already read '+')
-   from TEMP.  PATH is the path to which the depth applies, and is
-   used for error reporting only. */
-static svn_error_t *
-read_depth(svn_depth_t *depth, apr_file_t *temp, const char *path,
-           apr_pool_t *pool)
+read_depth(svn_depth_t *depth, svn_stream_t *temp, const char *path)
 {
-  char c;
+  unsigned char c;
 
-  SVN_ERR(svn_io_file_getc(&c, temp, pool));
+  SVN_ERR(read_byte(&c, temp));
   switch (c)
     {
     case 'X':
@@ -250,12 +296,13 @@ read_depth(svn_depth_t *depth, apr_file_t *temp, const char *path,
 /* Read a report operation *PI out of TEMP.  Set *PI to NULL if we
    have reached the end of the report. */
 static svn_error_t *
-read_path_info(path_info_t **pi, apr_file_t *temp, apr_pool_t *pool)
+read_path_info(path_info_t **pi, svn_stream_t *temp, apr_pool_t *pool)
 {
-  char c;
+  unsigned char flags;
+  apr_uint64_t num;
 
-  SVN_ERR(svn_io_file_getc(&c, temp, pool));
-  if (c == '-')
+  SVN_ERR(read_byte(&flags, temp));
+  if (! (flags & REPORT_ENTRY))
     {
       *pi = NULL;
       return SVN_NO_ERROR;
@@ -263,21 +310,23 @@ read_path_info(path_info_t **pi, apr_file_t *temp, apr_pool_t *pool)
 
   *pi = apr_palloc(pool, sizeof(**pi));
   SVN_ERR(read_string(&(*pi)->path, temp, pool));
-  SVN_ERR(svn_io_file_getc(&c, temp, pool));
-  if (c == '+')
+  if (flags & REPORT_LINK_PATH)
     SVN_ERR(read_string(&(*pi)->link_path, temp, pool));
   else
     (*pi)->link_path = NULL;
-  SVN_ERR(read_rev(&(*pi)->rev, temp, pool));
-  SVN_ERR(svn_io_file_getc(&c, temp, pool));
-  if (c == '+')
-    SVN_ERR(read_depth(&((*pi)->depth), temp, (*pi)->path, pool));
+  if (flags & REPORT_REV)
+    {
+      SVN_ERR(read_number(&num, temp));
+      (*pi)->rev = (svn_revnum_t) num;
+    }
+  else
+    (*pi)->rev = SVN_INVALID_REVNUM;
+  if (flags & REPORT_DEPTH)
+    SVN_ERR(read_depth(&((*pi)->depth), temp, (*pi)->path));
   else
     (*pi)->depth = svn_depth_infinity;
-  SVN_ERR(svn_io_file_getc(&c, temp, pool));
-  (*pi)->start_empty = (c == '+');
-  SVN_ERR(svn_io_file_getc(&c, temp, pool));
-  if (c == '+')
+  (*pi)->start_empty = (flags & REPORT_START_EMPTY) != 0;
+  if (flags & REPORT_LOCK_TOKEN)
     SVN_ERR(read_string(&(*pi)->lock_token, temp, pool));
   else
     (*pi)->lock_token = NULL;
@@ -293,7 +342,7 @@ relevant(path_info_t *pi, const char *prefix, apr_size_t plen)
           (!*prefix || pi->path[plen] == '/'));
 }
 
-/* Fetch the next pathinfo from B->tempfile for a descendant of
+/* Fetch the next pathinfo from B->reader for a descendant of
    PREFIX.  If the next pathinfo is for an immediate child of PREFIX,
    set *ENTRY to the path component of the report information and
    *INFO to the path information for that entry.  If the next pathinfo
@@ -340,7 +389,7 @@ fetch_path_info(report_baton_t *b, const char **entry, path_info_t **info,
           *entry = relpath;
           *info = b->lookahead;
           subpool = svn_pool_create(b->pool);
-          SVN_ERR(read_path_info(&b->lookahead, b->tempfile, subpool));
+          SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
         }
     }
   return SVN_NO_ERROR;
@@ -358,7 +407,7 @@ skip_path_info(report_baton_t *b, const char *prefix)
     {
       svn_pool_destroy(b->lookahead->pool);
       subpool = svn_pool_create(b->pool);
-      SVN_ERR(read_path_info(&b->lookahead, b->tempfile, subpool));
+      SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
     }
   return SVN_NO_ERROR;
 }
@@ -414,6 +463,107 @@ get_source_root(report_baton_t *b, svn_fs_root_t **s_root, svn_revnum_t rev)
   return SVN_NO_ERROR;
 }
 
+/* Build B->changed_below and B->replaced from the changes made in the
+   revisions after B->min_rev up to B->t_rev, if those are few enough to
+   be worth it.  Allocate the summary in B->pool, and use POOL for
+   temporary allocations.
+
+   We don't summarize for switches, since source and target paths
+   differ there anyway. */
+static svn_error_t *
+summarize_changes(report_baton_t *b, apr_pool_t *pool)
+{
+  apr_pool_t *iterpool;
+  svn_revnum_t rev;
+
+  b->changed_below = NULL;
+  b->replaced = NULL;
+
+  if (b->is_switch
+      || ! SVN_IS_VALID_REVNUM(b->min_rev)
+      || b->min_rev >= b->t_rev
+      || b->t_rev - b->min_rev > MAX_SUMMARY_REVISIONS
+      || b->t_path[0] != '/')
+    return SVN_NO_ERROR;
+
+  b->changed_below = apr_hash_make(b->pool);
+  b->replaced = apr_hash_make(b->pool);
+  iterpool = svn_pool_create(pool);
+
+  for (rev = b->min_rev + 1; rev <= b->t_rev; rev++)
+    {
+      svn_fs_root_t *root;
+      apr_hash_t *changes;
+      apr_hash_index_t *hi;
+      svn_revnum_t *revp = apr_palloc(b->pool, sizeof(*revp));
+
+      svn_pool_clear(iterpool);
+      *revp = rev;
+
+      SVN_ERR(svn_fs_revision_root(&root, b->repos->fs, rev, iterpool));
+      SVN_ERR(svn_fs_paths_changed2(&changes, root, iterpool));
+
+      for (hi = apr_hash_first(iterpool, changes); hi; hi = apr_hash_next(hi))
+        {
+          const char *path = svn__apr_hash_index_key(hi);
+          svn_fs_path_change2_t *change = svn__apr_hash_index_val(hi);
+
+          if (change->change_kind != svn_fs_path_change_modify)
+            apr_hash_set(b->replaced, apr_pstrdup(b->pool, path),
+                         APR_HASH_KEY_STRING, revp);
+
+          /* Mark the path and its parents, stopping at the first one
+             which another change in this revision already marked. */
+          while (apr_hash_get(b->changed_below, path, APR_HASH_KEY_STRING)
+                 != revp)
+            {
+              apr_hash_set(b->changed_below, apr_pstrdup(b->pool, path),
+                           APR_HASH_KEY_STRING, revp);
+              if (svn_path_is_empty(path) || strcmp(path, "/") == 0)
+                break;
+              path = svn_uri_dirname(path, iterpool);
+            }
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if the summary in B proves that the node at S_REV/S_PATH
+   and everything below it is the same as at B->t_rev/T_PATH, so that
+   there is nothing to compare.  Return FALSE if it doesn't, or if there
+   is no summary.  Use POOL for temporary allocations. */
+static svn_boolean_t
+unchanged_subtree(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
+                  const char *t_path, apr_pool_t *pool)
+{
+  const svn_revnum_t *revp;
+  const char *path;
+
+  if (! b->changed_below || ! s_path
+      || s_rev < b->min_rev || s_rev > b->t_rev
+      || strcmp(s_path, t_path) != 0)
+    return FALSE;
+
+  revp = apr_hash_get(b->changed_below, t_path, APR_HASH_KEY_STRING);
+  if (revp && *revp > s_rev)
+    return FALSE;
+
+  /* Adding, replacing or deleting a parent changes the whole subtree
+     without listing the paths below it. */
+  for (path = t_path; ; path = svn_uri_dirname(path, pool))
+    {
+      revp = apr_hash_get(b->replaced, path, APR_HASH_KEY_STRING);
+      if (revp && *revp > s_rev)
+        return FALSE;
+      if (svn_path_is_empty(path) || strcmp(path, "/") == 0)
+        break;
+    }
+
+  return TRUE;
+}
+
 /* Call the directory property-setting function of B->editor to set
    the property NAME to VALUE on DIR_BATON. */
 static svn_error_t *
@@ -498,6 +648,9 @@ delta_proplists(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 
   if (s_path)
     {
+      if (unchanged_subtree(b, s_rev, s_path, t_path, pool))
+        return SVN_NO_ERROR;
+
       SVN_ERR(get_source_root(b, &s_root, s_rev));
 
       /* Is this deltification worth our time? */
@@ -549,6 +702,9 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
 
   if (s_path)
     {
+      if (unchanged_subtree(b, s_rev, s_path, t_path, pool))
+        return SVN_NO_ERROR;
+
       SVN_ERR(get_source_root(b, &s_root, s_rev));
 
       /* Is this delta calculation worth our time?  If we are ignoring
@@ -947,6 +1103,18 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
    These rules are enforced by the is_depth_upgrade() function and by
    various other checks below.
 */
+/* qsort()-compatible comparison of two svn_fs_dirent_t *, ordering them
+   by where their node-revisions are stored, then by name. */
+static int
+compare_dirents_by_location(const void *a, const void *b)
+{
+  const svn_fs_dirent_t *entry_a = *(const svn_fs_dirent_t * const *)a;
+  const svn_fs_dirent_t *entry_b = *(const svn_fs_dirent_t * const *)b;
+  int diff = svn_fs__compare_id_locations(entry_a->id, entry_b->id);
+
+  return diff ? diff : strcmp(entry_a->name, entry_b->name);
+}
+
 static svn_error_t *
 delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
            const char *t_path, void *dir_baton, const char *e_path,
@@ -955,8 +1123,10 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 {
   svn_fs_root_t *s_root;
   apr_hash_t *s_entries = NULL, *t_entries;
+  apr_array_header_t *t_sorted;
   apr_hash_index_t *hi;
   apr_pool_t *subpool;
+  int i;
   const char *name, *s_fullpath, *t_fullpath, *e_fullpath;
   path_info_t *info;
 
@@ -970,13 +1140,19 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
   if (requested_depth > svn_depth_empty
       || requested_depth == svn_depth_unknown)
     {
-      /* Get the list of entries in each of source and target. */
+      /* Get the list of entries in each of source and target.  If
+         nothing changed here, the source has the target's entries. */
+      SVN_ERR(svn_fs_dir_entries(&t_entries, b->t_root, t_path, pool));
       if (s_path && !start_empty)
         {
-          SVN_ERR(get_source_root(b, &s_root, s_rev));
-          SVN_ERR(svn_fs_dir_entries(&s_entries, s_root, s_path, pool));
+          if (unchanged_subtree(b, s_rev, s_path, t_path, pool))
+            s_entries = apr_hash_copy(pool, t_entries);
+          else
+            {
+              SVN_ERR(get_source_root(b, &s_root, s_rev));
+              SVN_ERR(svn_fs_dir_entries(&s_entries, s_root, s_path, pool));
+            }
         }
-      SVN_ERR(svn_fs_dir_entries(&t_entries, b->t_root, t_path, pool));
 
       /* Iterate over the report information for this directory. */
       subpool = svn_pool_create(pool);
@@ -1088,13 +1264,23 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
             }
         }
 
-      /* Loop over the dirents in the target. */
+      /* Loop over the dirents in the target.  Visit them in storage
+         order, so that sending their contents reads the repository
+         mostly front to back instead of jumping around in it. */
+      t_sorted = apr_array_make(pool, apr_hash_count(t_entries),
+                                sizeof(const svn_fs_dirent_t *));
       for (hi = apr_hash_first(pool, t_entries); hi; hi = apr_hash_next(hi))
+        APR_ARRAY_PUSH(t_sorted, const svn_fs_dirent_t *)
+          = svn__apr_hash_index_val(hi);
+      qsort(t_sorted->elts, t_sorted->nelts, t_sorted->elt_size,
+            compare_dirents_by_location);
+
+      for (i = 0; i < t_sorted->nelts; i++)
         {
           const svn_fs_dirent_t *s_entry, *t_entry;
 
           svn_pool_clear(subpool);
-          t_entry = svn__apr_hash_index_val(hi);
+          t_entry = APR_ARRAY_IDX(t_sorted, i, const svn_fs_dirent_t *);
 
           if (is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
             {
@@ -1216,14 +1402,20 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
   /* Save our pool to manage the lookahead and fs_root cache with. */
   b->pool = pool;
 
-  /* Add an end marker and rewind the temporary file. */
-  SVN_ERR(svn_io_file_write_full(b->tempfile, "-", 1, NULL, pool));
-  offset = 0;
-  SVN_ERR(svn_io_file_seek(b->tempfile, APR_SET, &offset, pool));
+  /* Add an end marker and get ready to read the report back. */
+  SVN_ERR(write_report_data(b, "", 1, pool));
+  if (b->tempfile)
+    {
+      offset = 0;
+      SVN_ERR(svn_io_file_seek(b->tempfile, APR_SET, &offset, pool));
+      b->reader = svn_stream_from_aprfile2(b->tempfile, TRUE, pool);
+    }
+  else
+    b->reader = svn_stream_from_stringbuf(b->report_buf, pool);
 
   /* Read the first pathinfo from the report and verify that it is a top-level
      set_path entry. */
-  SVN_ERR(read_path_info(&info, b->tempfile, pool));
+  SVN_ERR(read_path_info(&info, b->reader, pool));
   if (!info || strcmp(info->path, b->s_operand) != 0
       || info->link_path || !SVN_IS_VALID_REVNUM(info->rev))
     return svn_error_create(SVN_ERR_REPOS_BAD_REVISION_REPORT, NULL,
@@ -1232,7 +1424,7 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
 
   /* Initialize the lookahead pathinfo. */
   subpool = svn_pool_create(pool);
-  SVN_ERR(read_path_info(&b->lookahead, b->tempfile, subpool));
+  SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
 
   if (b->lookahead && strcmp(b->lookahead->path, b->s_operand) == 0)
     {
@@ -1250,7 +1442,7 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
           b->lookahead->depth = info->depth;
         }
       info = b->lookahead;
-      SVN_ERR(read_path_info(&b->lookahead, b->tempfile, subpool));
+      SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
     }
 
   /* Open the target root and initialize the source root cache. */
@@ -1258,6 +1450,9 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
   for (i = 0; i < NUM_CACHED_SOURCE_ROOTS; i++)
     b->s_roots[i] = NULL;
 
+  /* Find out which subtrees the reported revisions leave unchanged. */
+  SVN_ERR(summarize_changes(b, pool));
+
   {
     svn_error_t *err = drive(b, s_rev, info, pool);
     if (err == SVN_NO_ERROR)
@@ -1269,46 +1464,117 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
 
 /* --- COLLECTING THE REPORT INFORMATION --- */
 
-/* Record a report operation into the temporary file.  Return an error
-   if DEPTH is svn_depth_unknown. */
+/* Append the LEN bytes at DATA to the report in B, moving the report
+   to a temporary file if it gets too large to keep in memory. */
+static svn_error_t *
+write_report_data(report_baton_t *b, const char *data, apr_size_t len,
+                  apr_pool_t *pool)
+{
+  if (! b->tempfile)
+    {
+      if (b->report_buf->len + len <= REPORT_MEMORY_LIMIT)
+        {
+          svn_stringbuf_appendbytes(b->report_buf, data, len);
+          return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(svn_io_open_unique_file3(&b->tempfile, NULL, NULL,
+                                       svn_io_file_del_on_pool_cleanup,
+                                       b->report_pool, pool));
+      SVN_ERR(svn_io_file_write_full(b->tempfile, b->report_buf->data,
+                                     b->report_buf->len, NULL, pool));
+      svn_stringbuf_setempty(b->report_buf);
+    }
+
+  return svn_io_file_write_full(b->tempfile, data, len, NULL, pool);
+}
+
+/* Append NUM to BUF in the report's number format. */
+static void
+append_number(svn_stringbuf_t *buf, apr_uint64_t num)
+{
+  char c;
+
+  while (num >= 0x80)
+    {
+      c = (char)((num & 0x7f) | 0x80);
+      svn_stringbuf_appendbytes(buf, &c, 1);
+      num >>= 7;
+    }
+  c = (char)num;
+  svn_stringbuf_appendbytes(buf, &c, 1);
+}
+
+/* Append the length-counted string STR to BUF. */
+static void
+append_string(svn_stringbuf_t *buf, const char *str)
+{
+  apr_size_t len = strlen(str);
+
+  append_number(buf, len);
+  svn_stringbuf_appendbytes(buf, str, len);
+}
+
+/* Record a report operation.  Return an error if DEPTH is
+   svn_depth_unknown. */
 static svn_error_t *
 write_path_info(report_baton_t *b, const char *path, const char *lpath,
                 svn_revnum_t rev, svn_depth_t depth,
                 svn_boolean_t start_empty,
                 const char *lock_token, apr_pool_t *pool)
 {
-  const char *lrep, *rrep, *drep, *ltrep, *rep;
+  svn_stringbuf_t *rep;
+  char flags = REPORT_ENTRY;
+  char depth_char;
 
   /* Munge the path to be anchor-relative, so that we can use edit paths
      as report paths. */
   path = svn_path_join(b->s_operand, path, pool);
 
-  lrep = lpath ? apr_psprintf(pool, "+%" APR_SIZE_T_FMT ":%s",
-                              strlen(lpath), lpath) : "-";
-  rrep = (SVN_IS_VALID_REVNUM(rev)) ?
-    apr_psprintf(pool, "+%ld:", rev) : "-";
+  /* Remember the oldest revision the working copy has. */
+  if (! lpath && SVN_IS_VALID_REVNUM(rev)
+      && (! SVN_IS_VALID_REVNUM(b->min_rev) || rev < b->min_rev))
+    b->min_rev = rev;
 
   if (depth == svn_depth_exclude)
-    drep = "+X";
+    depth_char = 'X';
   else if (depth == svn_depth_empty)
-    drep = "+E";
+    depth_char = 'E';
   else if (depth == svn_depth_files)
-    drep = "+F";
+    depth_char = 'F';
   else if (depth == svn_depth_immediates)
-    drep = "+M";
+    depth_char = 'M';
   else if (depth == svn_depth_infinity)
-    drep = "-";
+    depth_char = 0;
   else
     return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
                              _("Unsupported report depth '%s'"),
                              svn_depth_to_word(depth));
 
-  ltrep = lock_token ? apr_psprintf(pool, "+%" APR_SIZE_T_FMT ":%s",
-                                    strlen(lock_token), lock_token) : "-";
-  rep = apr_psprintf(pool, "+%" APR_SIZE_T_FMT ":%s%s%s%s%c%s",
-                     strlen(path), path, lrep, rrep, drep,
-                     start_empty ? '+' : '-', ltrep);
-  return svn_io_file_write_full(b->tempfile, rep, strlen(rep), NULL, pool);
+  if (lpath)
+    flags |= REPORT_LINK_PATH;
+  if (SVN_IS_VALID_REVNUM(rev))
+    flags |= REPORT_REV;
+  if (depth_char)
+    flags |= REPORT_DEPTH;
+  if (start_empty)
+    flags |= REPORT_START_EMPTY;
+  if (lock_token)
+    flags |= REPORT_LOCK_TOKEN;
+
+  rep = svn_stringbuf_create_ensure(strlen(path) + 16, pool);
+  svn_stringbuf_appendbytes(rep, &flags, 1);
+  append_string(rep, path);
+  if (lpath)
+    append_string(rep, lpath);
+  if (SVN_IS_VALID_REVNUM(rev))
+    append_number(rep, rev);
+  if (depth_char)
+    svn_stringbuf_appendbytes(rep, &depth_char, 1);
+  if (lock_token)
+    append_string(rep, lock_token);
+
+  return write_report_data(b, rep->data, rep->len, pool);
 }
 
 svn_error_t *
@@ -1350,7 +1616,8 @@ svn_repos_finish_report(void *baton, apr_pool_t *pool)
   svn_error_t *finish_err, *close_err;
 
   finish_err = finish_report(b, pool);
-  close_err = svn_io_file_close(b->tempfile, pool);
+  close_err = b->tempfile ? svn_io_file_close(b->tempfile, pool)
+                          : SVN_NO_ERROR;
   if (finish_err)
     svn_error_clear(close_err);
   return finish_err ? finish_err : close_err;
@@ -1361,7 +1628,7 @@ svn_repos_abort_report(void *baton, apr_pool_t *pool)
 {
   report_baton_t *b = baton;
 
-  return svn_io_file_close(b->tempfile, pool);
+  return b->tempfile ? svn_io_file_close(b->tempfile, pool) : SVN_NO_ERROR;
 }
 
 /* --- BEGINNING THE REPORT --- */
@@ -1408,10 +1675,13 @@ svn_repos_begin_report2(void **report_baton,
   b->edit_baton = edit_baton;
   b->authz_read_func = authz_read_func;
   b->authz_read_baton = authz_read_baton;
+  b->min_rev = SVN_INVALID_REVNUM;
+  b->changed_below = NULL;
+  b->replaced = NULL;
 
-  SVN_ERR(svn_io_open_unique_file3(&b->tempfile, NULL, NULL,
-                                   svn_io_file_del_on_pool_cleanup,
-                                   pool, pool));
+  b->report_buf = svn_stringbuf_create("", pool);
+  b->tempfile = NULL;
+  b->report_pool = pool;
 
   /* Hand reporter back to client. */
   *report_baton = b;
@@ -1477,7 +1477,8 @@ check_repos_format(svn_repos_t *repos,
 /* Set *REPOS_P to a repository at PATH which has been opened.
    See lock_repos() above regarding EXCLUSIVE and NONBLOCKING.
    OPEN_FS indicates whether the Subversion filesystem should be opened,
-   the handle being placed into repos->fs.
+   the handle being placed into repos->fs, using FS_CONFIG (which may be
+   NULL).
    Do all allocation in POOL.  */
 static svn_error_t *
 get_repos(svn_repos_t **repos_p,
@@ -1485,6 +1486,7 @@ get_repos(svn_repos_t **repos_p,
           svn_boolean_t exclusive,
           svn_boolean_t nonblocking,
           svn_boolean_t open_fs,
+          apr_hash_t *fs_config,
           apr_pool_t *pool)
 {
   svn_repos_t *repos;
@@ -1503,7 +1505,7 @@ get_repos(svn_repos_t **repos_p,
 
   /* Open up the filesystem only after obtaining the lock. */
   if (open_fs)
-    SVN_ERR(svn_fs_open(&repos->fs, repos->db_path, NULL, pool));
+    SVN_ERR(svn_fs_open(&repos->fs, repos->db_path, fs_config, pool));
 
   *repos_p = repos;
   return SVN_NO_ERROR;
@@ -1541,14 +1543,15 @@ svn_repos_find_root_path(const char *path,
 
 
 svn_error_t *
-svn_repos_open(svn_repos_t **repos_p,
-               const char *path,
-               apr_pool_t *pool)
+svn_repos_open2(svn_repos_t **repos_p,
+                const char *path,
+                apr_hash_t *fs_config,
+                apr_pool_t *pool)
 {
   /* Fetch a repository object initialized with a shared read/write
      lock on the database. */
 
-  return get_repos(repos_p, path, FALSE, FALSE, TRUE, pool);
+  return get_repos(repos_p, path, FALSE, FALSE, TRUE, fs_config, pool);
 }
 
 
@@ -1569,7 +1572,7 @@ svn_repos_upgrade(const char *path,
      least prevent others from trying to read or write to it while we
      run recovery. (Other backends should do their own locking; see
      lock_repos.) */
-  SVN_ERR(get_repos(&repos, path, TRUE, nonblocking, FALSE, subpool));
+  SVN_ERR(get_repos(&repos, path, TRUE, nonblocking, FALSE, NULL, subpool));
 
   if (start_callback)
     SVN_ERR(start_callback(start_callback_baton));
@@ -1738,7 +1741,7 @@ svn_repos_recover3(const char *path,
      lock_repos.) */
   SVN_ERR(get_repos(&repos, path, TRUE, nonblocking,
                     FALSE,    /* don't try to open the db yet. */
-                    subpool));
+                    NULL, subpool));
 
   if (start_callback)
     SVN_ERR(start_callback(start_callback_baton));
@@ -1763,7 +1766,7 @@ svn_error_t *svn_repos_db_logfiles(apr_array_header_t **logfiles,
   SVN_ERR(get_repos(&repos, path,
                     FALSE, FALSE,
                     FALSE,     /* Do not open fs. */
-                    pool));
+                    NULL, pool));
 
   SVN_ERR(svn_fs_berkeley_logfiles(logfiles,
                                    svn_repos_db_env(repos, pool),
@@ -1785,6 +1788,7 @@ svn_error_t *svn_repos_db_logfiles(apr_array_header_t **logfiles,
 struct hotcopy_ctx_t {
   const char *dest;     /* target location to construct */
   size_t src_len; /* len of the source path*/
+  svn_boolean_t incremental; /* update an existing copy at DEST */
 };
 
 /** Called by (svn_io_dir_walk).
@@ -1834,7 +1838,8 @@ static svn_error_t *hotcopy_structure(void *baton,
   target = svn_dirent_join(ctx->dest, sub_path, pool);
 
   if (finfo->filetype == APR_DIR)
-    return create_repos_dir(target, pool);
+    return ctx->incremental ? svn_io_make_dir_recursively(target, pool)
+                            : create_repos_dir(target, pool);
   else if (finfo->filetype == APR_REG)
     return svn_io_copy_file(path, target, TRUE, pool);
   else if (finfo->filetype == APR_LNK)
@@ -1863,20 +1868,24 @@ lock_db_logs_file(svn_repos_t *repos,
 
 /* Make a copy of a repository with hot backup of fs. */
 svn_error_t *
-svn_repos_hotcopy(const char *src_path,
-                  const char *dst_path,
-                  svn_boolean_t clean_logs,
-                  apr_pool_t *pool)
+svn_repos_hotcopy2(const char *src_path,
+                   const char *dst_path,
+                   svn_boolean_t clean_logs,
+                   svn_boolean_t incremental,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
 {
   svn_repos_t *src_repos;
   svn_repos_t *dst_repos;
   struct hotcopy_ctx_t hotcopy_context;
+  svn_node_kind_t kind;
 
   /* Try to open original repository */
   SVN_ERR(get_repos(&src_repos, src_path,
                     FALSE, FALSE,
                     FALSE,    /* don't try to open the db yet. */
-                    pool));
+                    NULL, pool));
 
   /* If we are going to clean logs, then get an exclusive lock on
      db-logs.lock, to ensure that no one else will work with logs.
@@ -1886,34 +1895,68 @@ svn_repos_hotcopy(const char *src_path,
 
   SVN_ERR(lock_db_logs_file(src_repos, clean_logs, pool));
 
+  /* An incremental hotcopy needs an earlier copy to update. */
+  if (incremental)
+    {
+      SVN_ERR(svn_io_check_path(svn_dirent_join(dst_path, SVN_REPOS__FORMAT,
+                                                pool),
+                                &kind, pool));
+      if (kind == svn_node_none)
+        incremental = FALSE;
+    }
+
+  if (incremental)
+    {
+      /* Exclusively lock the existing copy.  No one should be accessing
+         it while we update it. */
+      SVN_ERR(get_repos(&dst_repos, dst_path, TRUE, FALSE,
+                        FALSE,    /* don't try to open the db yet. */
+                        NULL, pool));
+
+      if (dst_repos->format != src_repos->format
+          || strcmp(dst_repos->fs_type, src_repos->fs_type) != 0)
+        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 _("The repository at '%s' has a different "
+                                   "format than '%s'; cannot hotcopy "
+                                   "incrementally"),
+                                 svn_dirent_local_style(dst_path, pool),
+                                 svn_dirent_local_style(src_path, pool));
+    }
+
   /* Copy the repository to a new path, with exception of
      specially handled directories */
 
   hotcopy_context.dest = dst_path;
   hotcopy_context.src_len = strlen(src_path);
+  hotcopy_context.incremental = incremental;
   SVN_ERR(svn_io_dir_walk(src_path,
                           0,
                           hotcopy_structure,
                           &hotcopy_context,
                           pool));
 
-  /* Prepare dst_repos object so that we may create locks,
-     so that we may open repository */
+  if (!incremental)
+    {
+      /* Prepare dst_repos object so that we may create locks,
+         so that we may open repository */
 
-  dst_repos = create_svn_repos_t(dst_path, pool);
-  dst_repos->fs_type = src_repos->fs_type;
-  dst_repos->format = src_repos->format;
+      dst_repos = create_svn_repos_t(dst_path, pool);
+      dst_repos->fs_type = src_repos->fs_type;
+      dst_repos->format = src_repos->format;
 
-  SVN_ERR(create_locks(dst_repos, pool));
+      SVN_ERR(create_locks(dst_repos, pool));
 
-  SVN_ERR(svn_io_dir_make_sgid(dst_repos->db_path, APR_OS_DEFAULT, pool));
+      SVN_ERR(svn_io_dir_make_sgid(dst_repos->db_path, APR_OS_DEFAULT,
+                                   pool));
 
-  /* Exclusively lock the new repository.
-     No one should be accessing it at the moment */
-  SVN_ERR(lock_repos(dst_repos, TRUE, FALSE, pool));
+      /* Exclusively lock the new repository.
+         No one should be accessing it at the moment */
+      SVN_ERR(lock_repos(dst_repos, TRUE, FALSE, pool));
+    }
 
-  SVN_ERR(svn_fs_hotcopy(src_repos->db_path, dst_repos->db_path,
-                         clean_logs, pool));
+  SVN_ERR(svn_fs_hotcopy2(src_repos->db_path, dst_repos->db_path,
+                          clean_logs, incremental, cancel_func, cancel_baton,
+                          pool));
 
   /* Destination repository is ready.  Stamp it with a format number. */
   return svn_io_write_version_file
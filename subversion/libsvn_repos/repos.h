@@ -63,6 +63,7 @@ extern "C" {
 #define SVN_REPOS__LOCK_DIR    "locks"      /* Lock files live here. */
 #define SVN_REPOS__HOOK_DIR    "hooks"      /* Hook programs. */
 #define SVN_REPOS__CONF_DIR    "conf"       /* Configuration files. */
+#define SVN_REPOS__HOOK_QUEUE_DIR "hook-queue" /* Queued hook runs. */
 
 /* Things for which we keep lockfiles. */
 #define SVN_REPOS__DB_LOCKFILE "db.lock" /* Our Berkeley lockfile. */
@@ -83,6 +84,10 @@ extern "C" {
 #define SVN_REPOS__HOOK_PRE_UNLOCK      "pre-unlock"
 #define SVN_REPOS__HOOK_POST_UNLOCK     "post-unlock"
 
+/* In the repository hooks directory, the Unix socket of a hook server
+   which handles the hooks that have no program of their own. */
+#define SVN_REPOS__HOOK_SERVER_SOCKET   "hook-server.sock"
+
 
 /* The extension added to the names of example hook scripts. */
 #define SVN_REPOS__HOOK_DESC_EXT        ".tmpl"
@@ -91,6 +96,9 @@ extern "C" {
 /* The configuration file for svnserve, in the repository conf directory. */
 #define SVN_REPOS__CONF_SVNSERVE_CONF "svnserve.conf"
 
+/* The configuration file for hooks, in the repository conf directory. */
+#define SVN_REPOS__CONF_HOOKS_CONF "hooks.conf"
+
 /* In the svnserve default configuration, these are the suggested
    locations for the passwd and authz files (in the repository conf
    directory), and we put example templates there. */
@@ -30,6 +30,7 @@
 #include "svn_error_codes.h"
 #include "svn_fs.h"
 #include "svn_repos.h"
+#include "svn_diff.h"
 #include "svn_string.h"
 #include "svn_time.h"
 #include "svn_sorts.h"
@@ -37,6 +38,8 @@
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
 #include "repos.h"
+#include "private/svn_cache.h"
+#include "private/svn_fs_private.h"
 
 
 /* Note:  this binary search assumes that the datestamp properties on
@@ -82,6 +85,12 @@ svn_repos_dated_revision(svn_revnum_t *revision,
   svn_revnum_t rev_mid, rev_top, rev_bot, rev_latest;
   apr_time_t this_time;
   svn_fs_t *fs = repos->fs;
+  svn_boolean_t indexed;
+
+  /* The back end may have the dates of all revisions at hand. */
+  SVN_ERR(svn_fs__dated_revision(&indexed, revision, fs, tm, pool));
+  if (indexed)
+    return SVN_NO_ERROR;
 
   /* Initialize top and bottom values of binary search. */
   SVN_ERR(svn_fs_youngest_rev(&rev_latest, fs, pool));
@@ -1074,6 +1083,103 @@ get_merged_mergeinfo(apr_hash_t **merged_mergeinfo,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_cache__serialize_func_t for svn_mergeinfo_t. */
+static svn_error_t *
+serialize_mergeinfo(char **data,
+                    apr_size_t *data_len,
+                    void *in,
+                    apr_pool_t *pool)
+{
+  svn_string_t *value;
+
+  SVN_ERR(svn_mergeinfo_to_string(&value, in, pool));
+  *data = (char *)value->data;
+  *data_len = value->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for svn_mergeinfo_t. */
+static svn_error_t *
+deserialize_mergeinfo(void **out,
+                      char *data,
+                      apr_size_t data_len,
+                      apr_pool_t *pool)
+{
+  svn_mergeinfo_t mergeinfo;
+
+  SVN_ERR(svn_mergeinfo_parse(&mergeinfo,
+                              apr_pstrmemdup(pool, data, data_len), pool));
+  *out = mergeinfo;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__dup_func_t for svn_mergeinfo_t. */
+static svn_error_t *
+dup_mergeinfo(void **out,
+              const void *in,
+              apr_pool_t *pool)
+{
+  *out = svn_mergeinfo_dup((svn_mergeinfo_t)in, pool);
+  return SVN_NO_ERROR;
+}
+
+/* Set *CACHE to a cache of the get_merged_mergeinfo() results for the
+   files in FS, keyed by "REV:PATH".  These only depend on committed
+   history and thus never go stale.  The process-wide membuffer lets
+   repeated requests for the same file share them; without one, the
+   cache only lasts for the request.  Allocate *CACHE in POOL. */
+static svn_error_t *
+create_merged_mergeinfo_cache(svn_cache__t **cache,
+                              svn_fs_t *fs,
+                              apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *uuid;
+
+  if (! membuffer)
+    return svn_cache__create_inprocess(cache, dup_mergeinfo,
+                                       APR_HASH_KEY_STRING, 16, 16, FALSE,
+                                       pool);
+
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, pool));
+  return svn_cache__create_membuffer_cache(cache, membuffer,
+                                           serialize_mergeinfo,
+                                           deserialize_mergeinfo,
+                                           APR_HASH_KEY_STRING,
+                                           apr_pstrcat(pool, "repos:", uuid,
+                                                       "/", svn_fs_path(fs,
+                                                                        pool),
+                                                       ":MMI", (char *)NULL),
+                                           pool);
+}
+
+/* Like get_merged_mergeinfo(), but take the result from CACHE, if it is
+   there, and put it there otherwise. */
+static svn_error_t *
+cached_merged_mergeinfo(apr_hash_t **merged_mergeinfo,
+                        svn_cache__t *cache,
+                        svn_repos_t *repos,
+                        struct path_revision *old_path_rev,
+                        apr_pool_t *pool)
+{
+  const char *key = apr_psprintf(pool, "%ld:%s", old_path_rev->revnum,
+                                 old_path_rev->path);
+  svn_boolean_t found;
+
+  SVN_ERR(svn_cache__get((void **)merged_mergeinfo, &found, cache, key,
+                         pool));
+  if (! found)
+    {
+      SVN_ERR(get_merged_mergeinfo(merged_mergeinfo, repos, old_path_rev,
+                                   pool));
+      SVN_ERR(svn_cache__set(cache, key, *merged_mergeinfo, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 find_interesting_revisions(apr_array_header_t *path_revisions,
                            svn_repos_t *repos,
@@ -1083,6 +1189,7 @@ find_interesting_revisions(apr_array_header_t *path_revisions,
                            svn_boolean_t include_merged_revisions,
                            svn_boolean_t mark_as_merged,
                            apr_hash_t *duplicate_path_revs,
+                           svn_cache__t *merged_mergeinfo_cache,
                            svn_repos_authz_func_t authz_read_func,
                            void *authz_read_baton,
                            apr_pool_t *pool)
@@ -1147,8 +1254,9 @@ find_interesting_revisions(apr_array_header_t *path_revisions,
       APR_ARRAY_PUSH(path_revisions, struct path_revision *) = path_rev;
 
       if (include_merged_revisions)
-        SVN_ERR(get_merged_mergeinfo(&path_rev->merged_mergeinfo, repos,
-                                     path_rev, pool));
+        SVN_ERR(cached_merged_mergeinfo(&path_rev->merged_mergeinfo,
+                                        merged_mergeinfo_cache, repos,
+                                        path_rev, pool));
       else
         path_rev->merged_mergeinfo = NULL;
 
@@ -1192,6 +1300,7 @@ find_merged_revisions(apr_array_header_t **merged_path_revisions_out,
                       const apr_array_header_t *mainline_path_revisions,
                       svn_repos_t *repos,
                       apr_hash_t *duplicate_path_revs,
+                      svn_cache__t *merged_mergeinfo_cache,
                       svn_repos_authz_func_t authz_read_func,
                       void *authz_read_baton,
                       apr_pool_t *pool)
@@ -1252,6 +1361,7 @@ find_merged_revisions(apr_array_header_t **merged_path_revisions_out,
                                                      range->start, range->end,
                                                      TRUE, TRUE,
                                                      duplicate_path_revs,
+                                                     merged_mergeinfo_cache,
                                                      authz_read_func,
                                                      authz_read_baton, pool));
                 }
@@ -1403,9 +1513,14 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
 {
   apr_array_header_t *mainline_path_revisions, *merged_path_revisions;
   apr_hash_t *duplicate_path_revs;
+  svn_cache__t *merged_mergeinfo_cache = NULL;
   struct send_baton sb;
   int mainline_pos, merged_pos;
 
+  if (include_merged_revisions)
+    SVN_ERR(create_merged_mergeinfo_cache(&merged_mergeinfo_cache,
+                                          repos->fs, pool));
+
   /* Get the revisions we are interested in. */
   duplicate_path_revs = apr_hash_make(pool);
   mainline_path_revisions = apr_array_make(pool, 0,
@@ -1413,13 +1528,15 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
   SVN_ERR(find_interesting_revisions(mainline_path_revisions, repos, path,
                                      start, end, include_merged_revisions,
                                      FALSE, duplicate_path_revs,
+                                     merged_mergeinfo_cache,
                                      authz_read_func, authz_read_baton, pool));
 
   /* If we are including merged revisions, go get those, too. */
   if (include_merged_revisions)
     SVN_ERR(find_merged_revisions(&merged_path_revisions,
                                   mainline_path_revisions, repos,
-                                  duplicate_path_revs, authz_read_func,
+                                  duplicate_path_revs,
+                                  merged_mergeinfo_cache, authz_read_func,
                                   authz_read_baton, pool));
   else
     merged_path_revisions = apr_array_make(pool, 0,
@@ -1491,3 +1608,254 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
 
   return SVN_NO_ERROR;
 }
+
+/* One run of lines of a file that were last changed in the same revision,
+   for svn_repos_get_file_blame(). */
+struct blame_chunk
+{
+  apr_off_t start;        /* the first line of the run */
+  svn_revnum_t revision;  /* the revision that last changed it */
+};
+
+/* Baton for the diff output functions of svn_repos_get_file_blame().  The
+   chunks of the modified file are built in one pass over the chunks of the
+   original. */
+struct blame_baton
+{
+  /* The chunks of the original file, and the index of the one containing
+     the current position in it. */
+  apr_array_header_t *chunks;
+  int walk;
+
+  /* The chunks of the modified file, built by the diff output functions. */
+  apr_array_header_t *new_chunks;
+
+  /* The revision of the modified file. */
+  svn_revnum_t revision;
+};
+
+/* Append a chunk for REVISION starting at line START to BB->new_chunks,
+   unless it would just continue the last one. */
+static void
+blame_append(struct blame_baton *bb,
+             svn_revnum_t revision,
+             apr_off_t start)
+{
+  struct blame_chunk *chunk;
+
+  if (bb->new_chunks->nelts > 0
+      && APR_ARRAY_IDX(bb->new_chunks, bb->new_chunks->nelts - 1,
+                       struct blame_chunk).revision == revision)
+    return;
+
+  chunk = apr_array_push(bb->new_chunks);
+  chunk->start = start;
+  chunk->revision = revision;
+}
+
+/* Implements svn_diff_output_fns_t.output_common.  The lines keep the
+   revisions of the original. */
+static svn_error_t *
+blame_output_common(void *baton,
+                    apr_off_t original_start,
+                    apr_off_t original_length,
+                    apr_off_t modified_start,
+                    apr_off_t modified_length,
+                    apr_off_t latest_start,
+                    apr_off_t latest_length)
+{
+  struct blame_baton *bb = baton;
+  int i;
+
+  /* Skip the chunks that end before this range. */
+  while (bb->walk + 1 < bb->chunks->nelts
+         && APR_ARRAY_IDX(bb->chunks, bb->walk + 1,
+                          struct blame_chunk).start <= original_start)
+    bb->walk++;
+
+  for (i = bb->walk; i < bb->chunks->nelts; i++)
+    {
+      const struct blame_chunk *chunk = &APR_ARRAY_IDX(bb->chunks, i,
+                                                       struct blame_chunk);
+
+      if (chunk->start >= original_start + original_length)
+        break;
+
+      blame_append(bb, chunk->revision,
+                   modified_start + (chunk->start > original_start
+                                     ? chunk->start - original_start : 0));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_diff_output_fns_t.output_diff_modified.  The modified
+   lines are blamed on the new revision, the deleted ones simply go. */
+static svn_error_t *
+blame_output_modified(void *baton,
+                      apr_off_t original_start,
+                      apr_off_t original_length,
+                      apr_off_t modified_start,
+                      apr_off_t modified_length,
+                      apr_off_t latest_start,
+                      apr_off_t latest_length)
+{
+  struct blame_baton *bb = baton;
+
+  if (modified_length)
+    blame_append(bb, bb->revision, modified_start);
+
+  return SVN_NO_ERROR;
+}
+
+static const svn_diff_output_fns_t blame_output_fns = {
+  blame_output_common,
+  blame_output_modified
+};
+
+svn_error_t *
+svn_repos_get_file_blame(svn_repos_t *repos,
+                         const char *path,
+                         svn_revnum_t start,
+                         svn_revnum_t end,
+                         const svn_diff_file_options_t *diff_options,
+                         svn_boolean_t ignore_mime_type,
+                         svn_repos_authz_func_t authz_read_func,
+                         void *authz_read_baton,
+                         svn_blame_chunk_receiver_t receiver,
+                         void *receiver_baton,
+                         apr_pool_t *pool)
+{
+  apr_array_header_t *path_revisions;
+  apr_array_header_t *chunks;
+  struct blame_baton bb;
+  apr_pool_t *iter_pool, *last_pool;
+  svn_fs_root_t *last_root = NULL;
+  const char *last_path = NULL;
+  svn_string_t *last_text = NULL;
+  int i;
+
+  if (! diff_options)
+    diff_options = svn_diff_file_options_create(pool);
+
+  /* Get the revisions we are interested in, including the one that was
+     current before START, so that we know what START itself changed. */
+  path_revisions = apr_array_make(pool, 0, sizeof(struct path_revision *));
+  SVN_ERR(find_interesting_revisions(path_revisions, repos, path,
+                                     start > 0 ? start - 1 : 0, end,
+                                     FALSE, FALSE, apr_hash_make(pool), NULL,
+                                     authz_read_func, authz_read_baton,
+                                     pool));
+
+  /* We must have at least one revision to get. */
+  SVN_ERR_ASSERT(path_revisions->nelts > 0);
+
+  chunks = apr_array_make(pool, 16, sizeof(struct blame_chunk));
+  bb.new_chunks = apr_array_make(pool, 16, sizeof(struct blame_chunk));
+
+  /* We switch between two pools while looping, since we need the root and
+     the text of the last revision. */
+  iter_pool = svn_pool_create(pool);
+  last_pool = svn_pool_create(pool);
+
+  /* Walk the revisions from oldest to youngest. */
+  for (i = path_revisions->nelts - 1; i >= 0; i--)
+    {
+      struct path_revision *path_rev = APR_ARRAY_IDX(path_revisions, i,
+                                                     struct path_revision *);
+      svn_fs_root_t *root;
+      svn_stream_t *contents;
+      svn_string_t *text;
+      apr_pool_t *tmp_pool;
+
+      svn_pool_clear(iter_pool);
+
+      SVN_ERR(svn_fs_revision_root(&root, repos->fs, path_rev->revnum,
+                                   iter_pool));
+
+      if (! ignore_mime_type)
+        {
+          svn_string_t *mime_type;
+
+          SVN_ERR(svn_fs_node_prop(&mime_type, root, path_rev->path,
+                                   SVN_PROP_MIME_TYPE, iter_pool));
+          if (mime_type && svn_mime_type_is_binary(mime_type->data))
+            return svn_error_createf
+              (SVN_ERR_CLIENT_IS_BINARY_FILE, NULL,
+               _("Cannot calculate blame information for binary file '%s'"),
+               path);
+        }
+
+      if (last_root)
+        {
+          svn_boolean_t contents_changed;
+
+          SVN_ERR(svn_fs_contents_changed(&contents_changed, last_root,
+                                          last_path, root, path_rev->path,
+                                          iter_pool));
+          if (! contents_changed)
+            continue;
+        }
+
+      SVN_ERR(svn_fs_file_contents(&contents, root, path_rev->path,
+                                   iter_pool));
+      SVN_ERR(svn_string_from_stream(&text, contents, iter_pool, iter_pool));
+
+      apr_array_clear(bb.new_chunks);
+      bb.chunks = chunks;
+      bb.walk = 0;
+      bb.revision = path_rev->revnum < start ? SVN_INVALID_REVNUM
+                                             : path_rev->revnum;
+
+      if (last_text)
+        {
+          svn_diff_t *diff;
+
+          SVN_ERR(svn_diff_mem_string_diff(&diff, last_text, text,
+                                           diff_options, iter_pool));
+          SVN_ERR(svn_diff_output(diff, &bb, &blame_output_fns));
+        }
+
+      /* Even an empty file has a chunk. */
+      if (bb.new_chunks->nelts == 0)
+        blame_append(&bb, bb.revision, 0);
+
+      chunks = bb.new_chunks;
+      bb.new_chunks = bb.chunks;
+
+      /* Remember root, path and text for the next iteration. */
+      last_root = root;
+      last_path = path_rev->path;
+      last_text = text;
+
+      /* Swap the pools. */
+      tmp_pool = iter_pool;
+      iter_pool = last_pool;
+      last_pool = tmp_pool;
+    }
+
+  /* Hand out the annotations. */
+  for (i = 0; i < chunks->nelts; i++)
+    {
+      const struct blame_chunk *chunk = &APR_ARRAY_IDX(chunks, i,
+                                                       struct blame_chunk);
+      apr_hash_t *rev_props = NULL;
+
+      svn_pool_clear(iter_pool);
+
+      if (SVN_IS_VALID_REVNUM(chunk->revision))
+        SVN_ERR(svn_repos_fs_revision_proplist(&rev_props, repos,
+                                               chunk->revision,
+                                               authz_read_func,
+                                               authz_read_baton,
+                                               iter_pool));
+
+      SVN_ERR(receiver(receiver_baton, (svn_linenum_t) chunk->start,
+                       chunk->revision, rev_props, iter_pool));
+    }
+
+  svn_pool_destroy(last_pool);
+  svn_pool_destroy(iter_pool);
+
+  return SVN_NO_ERROR;
+}
@@ -25,6 +25,7 @@
 #include <apr_pools.h>
 #include <apr_tables.h>
 #include <apr_strings.h>
+#include <apr_thread_mutex.h>
 
 #include "svn_types.h"
 #include "svn_string.h"
@@ -33,6 +34,7 @@
 #include "svn_config.h"
 #include "svn_private_config.h"
 #include "svn_dso.h"
+#include "private/svn_auth_private.h"
 
 /* The good way to think of this machinery is as a set of tables.
 
@@ -83,6 +85,13 @@ struct svn_auth_baton_t
   /* run-time credentials cache. */
   apr_hash_t *creds_cache;
 
+#if APR_HAS_THREADS
+  /* Serializes the use of the providers, the credentials cache and
+     POOL between this baton and the batons made from it by
+     svn_auth__make_thread_baton().  NULL until the first such baton
+     is made. */
+  apr_thread_mutex_t *mutex;
+#endif
 };
 
 /* Abstracted iteration baton */
@@ -161,14 +170,77 @@ svn_auth_get_parameter(svn_auth_baton_t *auth_baton,
 }
 
 
-
 svn_error_t *
-svn_auth_first_credentials(void **credentials,
-                           svn_auth_iterstate_t **state,
-                           const char *cred_kind,
-                           const char *realmstring,
-                           svn_auth_baton_t *auth_baton,
-                           apr_pool_t *pool)
+svn_auth__make_thread_baton(svn_auth_baton_t **thread_baton,
+                            svn_auth_baton_t *auth_baton,
+                            apr_pool_t *result_pool)
+{
+  svn_auth_baton_t *ab = apr_pmemdup(result_pool, auth_baton, sizeof(*ab));
+
+#if APR_HAS_THREADS
+  if (! auth_baton->mutex)
+    {
+      apr_status_t status = apr_thread_mutex_create(&auth_baton->mutex,
+                                                    APR_THREAD_MUTEX_DEFAULT,
+                                                    auth_baton->pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create auth mutex"));
+    }
+  ab->mutex = auth_baton->mutex;
+#endif
+
+  /* The RA layers set parameters per session, so those can't be
+     shared.  Everything else is only used under the mutex. */
+  ab->parameters = apr_hash_copy(result_pool, auth_baton->parameters);
+
+  *thread_baton = ab;
+  return SVN_NO_ERROR;
+}
+
+/* Lock the mutex of AUTH_BATON, if it has one. */
+static svn_error_t *
+lock_auth_baton(svn_auth_baton_t *auth_baton)
+{
+#if APR_HAS_THREADS
+  if (auth_baton->mutex)
+    {
+      apr_status_t status = apr_thread_mutex_lock(auth_baton->mutex);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't lock auth mutex"));
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Unlock the mutex of AUTH_BATON, if it has one, and return ERR. */
+static svn_error_t *
+unlock_auth_baton(svn_auth_baton_t *auth_baton,
+                  svn_error_t *err)
+{
+#if APR_HAS_THREADS
+  if (auth_baton->mutex)
+    {
+      apr_status_t status = apr_thread_mutex_unlock(auth_baton->mutex);
+      if (status && ! err)
+        return svn_error_wrap_apr(status, _("Can't unlock auth mutex"));
+    }
+#endif
+
+  return err;
+}
+
+
+
+/* The body of svn_auth_first_credentials(), called with the mutex
+   of AUTH_BATON held. */
+static svn_error_t *
+first_credentials(void **credentials,
+                  svn_auth_iterstate_t **state,
+                  const char *cred_kind,
+                  const char *realmstring,
+                  svn_auth_baton_t *auth_baton,
+                  apr_pool_t *pool)
 {
   int i = 0;
   provider_set_t *table;
@@ -241,11 +313,27 @@ svn_auth_first_credentials(void **credentials,
   return SVN_NO_ERROR;
 }
 
-
 svn_error_t *
-svn_auth_next_credentials(void **credentials,
-                          svn_auth_iterstate_t *state,
-                          apr_pool_t *pool)
+svn_auth_first_credentials(void **credentials,
+                           svn_auth_iterstate_t **state,
+                           const char *cred_kind,
+                           const char *realmstring,
+                           svn_auth_baton_t *auth_baton,
+                           apr_pool_t *pool)
+{
+  SVN_ERR(lock_auth_baton(auth_baton));
+  return unlock_auth_baton(auth_baton,
+                           first_credentials(credentials, state, cred_kind,
+                                             realmstring, auth_baton, pool));
+}
+
+
+/* The body of svn_auth_next_credentials(), called with the mutex of
+   the auth baton of STATE held. */
+static svn_error_t *
+next_credentials(void **credentials,
+                 svn_auth_iterstate_t *state,
+                 apr_pool_t *pool)
 {
   svn_auth_baton_t *auth_baton = state->auth_baton;
   svn_auth_provider_object_t *provider;
@@ -294,10 +382,22 @@ svn_auth_next_credentials(void **credentials,
   return SVN_NO_ERROR;
 }
 
-
 svn_error_t *
-svn_auth_save_credentials(svn_auth_iterstate_t *state,
+svn_auth_next_credentials(void **credentials,
+                          svn_auth_iterstate_t *state,
                           apr_pool_t *pool)
+{
+  SVN_ERR(lock_auth_baton(state->auth_baton));
+  return unlock_auth_baton(state->auth_baton,
+                           next_credentials(credentials, state, pool));
+}
+
+
+/* The body of svn_auth_save_credentials(), called with the mutex of
+   the auth baton of STATE held. */
+static svn_error_t *
+save_credentials(svn_auth_iterstate_t *state,
+                 apr_pool_t *pool)
 {
   int i;
   svn_auth_provider_object_t *provider;
@@ -361,6 +461,18 @@ svn_auth_save_credentials(svn_auth_iterstate_t *state,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_auth_save_credentials(svn_auth_iterstate_t *state,
+                          apr_pool_t *pool)
+{
+  if (! state)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(lock_auth_baton(state->auth_baton));
+  return unlock_auth_baton(state->auth_baton,
+                           save_credentials(state, pool));
+}
+
 svn_auth_ssl_server_cert_info_t *
 svn_auth_ssl_server_cert_info_dup
   (const svn_auth_ssl_server_cert_info_t *info, apr_pool_t *pool)
@@ -481,6 +593,164 @@ svn_auth_get_platform_specific_provider
   return SVN_NO_ERROR;
 }
 
+#if defined(SVN_HAVE_GNOME_KEYRING) || defined(SVN_HAVE_KWALLET)
+/* Baton of a provider whose implementation lives in one of the
+   libsvn_auth_* DSOs.  The DSO is only loaded, and the keyring or wallet
+   client library initialized, when the provider is first used. */
+typedef struct lazy_provider_baton_t
+{
+  /* Arguments for svn_auth_get_platform_specific_provider(). */
+  const char *provider_name;
+  const char *provider_type;
+
+  /* Whether we tried to load the provider yet. */
+  svn_boolean_t loaded;
+
+  /* The provider from the DSO, or NULL if the DSO isn't available. */
+  svn_auth_provider_object_t *provider;
+
+  /* The pool the provider was created in. */
+  apr_pool_t *pool;
+} lazy_provider_baton_t;
+
+/* Make sure LPB->provider has been loaded. */
+static svn_error_t *
+load_lazy_provider(lazy_provider_baton_t *lpb)
+{
+  if (! lpb->loaded)
+    {
+      SVN_ERR(svn_auth_get_platform_specific_provider(&lpb->provider,
+                                                      lpb->provider_name,
+                                                      lpb->provider_type,
+                                                      lpb->pool));
+      lpb->loaded = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+lazy_first_credentials(void **credentials,
+                       void **iter_baton,
+                       void *provider_baton,
+                       apr_hash_t *parameters,
+                       const char *realmstring,
+                       apr_pool_t *pool)
+{
+  lazy_provider_baton_t *lpb = provider_baton;
+
+  SVN_ERR(load_lazy_provider(lpb));
+  if (! lpb->provider)
+    {
+      *credentials = NULL;
+      *iter_baton = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return lpb->provider->vtable->first_credentials(credentials, iter_baton,
+                                                  lpb->provider->provider_baton,
+                                                  parameters, realmstring,
+                                                  pool);
+}
+
+static svn_error_t *
+lazy_next_credentials(void **credentials,
+                      void *iter_baton,
+                      void *provider_baton,
+                      apr_hash_t *parameters,
+                      const char *realmstring,
+                      apr_pool_t *pool)
+{
+  lazy_provider_baton_t *lpb = provider_baton;
+
+  if (! lpb->provider || ! lpb->provider->vtable->next_credentials)
+    {
+      *credentials = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return lpb->provider->vtable->next_credentials(credentials, iter_baton,
+                                                 lpb->provider->provider_baton,
+                                                 parameters, realmstring,
+                                                 pool);
+}
+
+static svn_error_t *
+lazy_save_credentials(svn_boolean_t *saved,
+                      void *credentials,
+                      void *provider_baton,
+                      apr_hash_t *parameters,
+                      const char *realmstring,
+                      apr_pool_t *pool)
+{
+  lazy_provider_baton_t *lpb = provider_baton;
+
+  SVN_ERR(load_lazy_provider(lpb));
+  if (! lpb->provider || ! lpb->provider->vtable->save_credentials)
+    {
+      *saved = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  return lpb->provider->vtable->save_credentials(saved, credentials,
+                                                 lpb->provider->provider_baton,
+                                                 parameters, realmstring,
+                                                 pool);
+}
+
+static const svn_auth_provider_t lazy_simple_provider = {
+  SVN_AUTH_CRED_SIMPLE,
+  lazy_first_credentials,
+  lazy_next_credentials,
+  lazy_save_credentials
+};
+
+static const svn_auth_provider_t lazy_ssl_client_cert_pw_provider = {
+  SVN_AUTH_CRED_SSL_CLIENT_CERT_PW,
+  lazy_first_credentials,
+  lazy_next_credentials,
+  lazy_save_credentials
+};
+#endif
+
+/* Like svn_auth_get_platform_specific_provider(), but for the providers
+   which are loaded from a DSO, return a stand-in that defers loading it
+   until credentials are actually asked for or saved.  Most commands
+   never talk to a repository that wants a password, so they shouldn't
+   pay for loading and initializing GNOME Keyring or KWallet. */
+static svn_error_t *
+get_deferred_provider(svn_auth_provider_object_t **provider,
+                      const char *provider_name,
+                      const char *provider_type,
+                      apr_pool_t *pool)
+{
+#if defined(SVN_HAVE_GNOME_KEYRING) || defined(SVN_HAVE_KWALLET)
+  const svn_auth_provider_t *vtable = NULL;
+  lazy_provider_baton_t *lpb;
+
+  if (strcmp(provider_type, "simple") == 0)
+    vtable = &lazy_simple_provider;
+  else if (strcmp(provider_type, "ssl_client_cert_pw") == 0)
+    vtable = &lazy_ssl_client_cert_pw_provider;
+
+  if (vtable)
+    {
+      lpb = apr_pcalloc(pool, sizeof(*lpb));
+      lpb->provider_name = provider_name;
+      lpb->provider_type = provider_type;
+      lpb->pool = pool;
+
+      *provider = apr_palloc(pool, sizeof(**provider));
+      (*provider)->vtable = vtable;
+      (*provider)->provider_baton = lpb;
+      return SVN_NO_ERROR;
+    }
+#endif
+
+  return svn_auth_get_platform_specific_provider(provider, provider_name,
+                                                 provider_type, pool);
+}
+
 svn_error_t *
 svn_auth_get_platform_specific_client_providers
   (apr_array_header_t **providers,
@@ -519,18 +789,14 @@ svn_auth_get_platform_specific_client_providers
       /* GNOME Keyring */
       if (apr_strnatcmp(password_store, "gnome-keyring") == 0)
         {
-          SVN_ERR(svn_auth_get_platform_specific_provider(&provider,
-                                                          "gnome_keyring",
-                                                          "simple",
-                                                          pool));
+          SVN_ERR(get_deferred_provider(&provider, "gnome_keyring",
+                                        "simple", pool));
 
           if (provider)
             APR_ARRAY_PUSH(*providers, svn_auth_provider_object_t *) = provider;
 
-          SVN_ERR(svn_auth_get_platform_specific_provider(&provider,
-                                                          "gnome_keyring",
-                                                          "ssl_client_cert_pw",
-                                                          pool));
+          SVN_ERR(get_deferred_provider(&provider, "gnome_keyring",
+                                        "ssl_client_cert_pw", pool));
 
           if (provider)
             APR_ARRAY_PUSH(*providers, svn_auth_provider_object_t *) = provider;
@@ -541,18 +807,14 @@ svn_auth_get_platform_specific_client_providers
       /* KWallet */
       if (apr_strnatcmp(password_store, "kwallet") == 0)
         {
-          SVN_ERR(svn_auth_get_platform_specific_provider(&provider,
-                                                          "kwallet",
-                                                          "simple",
-                                                          pool));
+          SVN_ERR(get_deferred_provider(&provider, "kwallet",
+                                        "simple", pool));
 
           if (provider)
             APR_ARRAY_PUSH(*providers, svn_auth_provider_object_t *) = provider;
 
-          SVN_ERR(svn_auth_get_platform_specific_provider(&provider,
-                                                          "kwallet",
-                                                          "ssl_client_cert_pw",
-                                                          pool));
+          SVN_ERR(get_deferred_provider(&provider, "kwallet",
+                                        "ssl_client_cert_pw", pool));
           if (provider)
             APR_ARRAY_PUSH(*providers, svn_auth_provider_object_t *) = provider;
 
@@ -23,6 +23,7 @@
 
 #include <assert.h>
 
+#include <apr_allocator.h>
 #include <apr_thread_mutex.h>
 
 #include "svn_pools.h"
@@ -31,7 +32,16 @@
 
 #include "cache.h"
 
-/* The (internal) cache object. */
+/* Thread-safe caches get split into up to this many segments (a power
+ * of two), each one with its own lock, so that threads looking up
+ * different keys rarely contend for the same mutex. */
+#define MAX_SEGMENT_COUNT 16
+
+/* ... but each segment gets at least this many pages, so that small
+ * caches keep a single LRU list. */
+#define MIN_SEGMENT_PAGES 8
+
+/* One segment of the cache: an independent LRU cache of its own. */
 typedef struct {
   /* Maps from a key (of size CACHE->KLEN) to a struct cache_entry. */
   apr_hash_t *hash;
@@ -43,6 +53,8 @@ typedef struct {
   /* The number of pages we're allowed to allocate before having to
    * try to reuse one. */
   apr_int64_t unallocated_pages;
+  /* The number of pages this cache may use in total. */
+  apr_int64_t total_pages;
   /* Number of cache entries stored on each page.  Must be at least 1. */
   apr_int64_t items_per_page;
 
@@ -60,9 +72,13 @@ typedef struct {
    * currently on PARTIAL_PAGE. */
   apr_int64_t partial_page_number_filled;
 
-  /* The pool that the svn_cache__t itself, HASH, and all pages are
-   * allocated in; subpools of this pool are used for the cache_entry
-   * structs, as well as the dup'd values and hash keys.
+  /* Number of entries dropped because their page got reused. */
+  apr_uint64_t evictions;
+
+  /* The pool that all pages of this segment are allocated in;
+   * subpools of this pool are used for the cache_entry structs, as
+   * well as the dup'd values and hash keys.  Unless the cache has only
+   * one segment, this pool has an allocator of its own.
    */
   apr_pool_t *cache_pool;
 
@@ -74,6 +90,18 @@ typedef struct {
 #endif
 } inprocess_cache_t;
 
+/* The (internal) cache object.  A key always lives in the segment that
+ * its hash value selects. */
+typedef struct {
+  /* SEGMENT_COUNT == 1 << SEGMENT_BITS segments. */
+  inprocess_cache_t *segments;
+  int segment_count;
+  int segment_bits;
+
+  /* Size of the keys, as in inprocess_cache_t. */
+  apr_ssize_t klen;
+} segmented_cache_t;
+
 /* A cache page; all items on the page are allocated from the same
  * pool. */
 struct cache_page {
@@ -170,6 +198,25 @@ duplicate_key(inprocess_cache_t *cache,
     return apr_pmemdup(pool, key, cache->klen);
 }
 
+/* Return the segment of CACHE responsible for KEY. */
+static inprocess_cache_t *
+get_segment(segmented_cache_t *cache,
+            const void *key)
+{
+  apr_ssize_t klen = cache->klen;
+  apr_uint32_t hash;
+
+  if (cache->segment_count == 1)
+    return cache->segments;
+
+  /* The segment hashes use the low bits of the same hash function to
+   * find their buckets.  Select segments by well-mixed high bits
+   * instead, so that the keys within a segment still spread over all
+   * of its buckets. */
+  hash = (apr_uint32_t)apr_hashfunc_default(key, &klen) * 0x9e3779b1;
+  return &cache->segments[hash >> (32 - cache->segment_bits)];
+}
+
 /* If applicable, locks CACHE's mutex. */
 static svn_error_t *
 lock_cache(inprocess_cache_t *cache)
@@ -212,7 +259,7 @@ inprocess_cache_get(void **value_p,
                     const void *key,
                     apr_pool_t *pool)
 {
-  inprocess_cache_t *cache = cache_void;
+  inprocess_cache_t *cache = get_segment(cache_void, key);
   struct cache_entry *entry;
   svn_error_t *err;
 
@@ -269,7 +316,7 @@ inprocess_cache_set(void *cache_void,
                     void *value,
                     apr_pool_t *pool)
 {
-  inprocess_cache_t *cache = cache_void;
+  inprocess_cache_t *cache = get_segment(cache_void, key);
   struct cache_entry *existing_entry;
   svn_error_t *err = SVN_NO_ERROR;
 
@@ -327,8 +374,10 @@ inprocess_cache_set(void *cache_void,
 
       SVN_ERR_ASSERT(oldest_page != cache->sentinel);
 
-      /* Erase the page and put it in cache->partial_page. */
+      /* Erase the page and put it in cache->partial_page.  All pages
+       * in the list are full. */
       erase_page(cache, oldest_page);
+      cache->evictions += cache->items_per_page;
     }
 
   SVN_ERR_ASSERT(cache->partial_page != NULL);
@@ -397,22 +446,66 @@ inprocess_cache_iter(svn_boolean_t *completed,
                      void *user_baton,
                      apr_pool_t *pool)
 {
-  inprocess_cache_t *cache = cache_void;
+  segmented_cache_t *segmented = cache_void;
   struct cache_iter_baton b;
+  int i;
   b.user_cb = user_cb;
   b.user_baton = user_baton;
 
-  SVN_ERR(lock_cache(cache));
-  return unlock_cache(cache,
-                      svn_iter_apr_hash(completed, cache->hash, iter_cb, &b,
-                                        pool));
+  *completed = TRUE;
+  for (i = 0; i < segmented->segment_count && *completed; ++i)
+    {
+      inprocess_cache_t *cache = &segmented->segments[i];
 
+      SVN_ERR(lock_cache(cache));
+      SVN_ERR(unlock_cache(cache,
+                           svn_iter_apr_hash(completed, cache->hash,
+                                             iter_cb, &b, pool)));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+inprocess_cache_get_info(void *cache_void,
+                         svn_cache__info_t *info,
+                         svn_boolean_t reset,
+                         apr_pool_t *pool)
+{
+  segmented_cache_t *segmented = cache_void;
+  int i;
+
+  /* We can't tell the size of the dup'ed values. */
+  info->evictions = 0;
+  info->used_entries = 0;
+  info->total_entries = 0;
+
+  for (i = 0; i < segmented->segment_count; ++i)
+    {
+      inprocess_cache_t *cache = &segmented->segments[i];
+
+      SVN_ERR(lock_cache(cache));
+
+      info->evictions += cache->evictions;
+      info->used_entries += apr_hash_count(cache->hash);
+      info->total_entries += cache->total_pages * cache->items_per_page;
+
+      if (reset)
+        cache->evictions = 0;
+
+      SVN_ERR(unlock_cache(cache, SVN_NO_ERROR));
+    }
+
+  return SVN_NO_ERROR;
 }
 
 static svn_cache__vtable_t inprocess_cache_vtable = {
   inprocess_cache_get,
+  NULL, /* values are not serialized */
+  NULL, /* get_many: lookups are local */
   inprocess_cache_set,
-  inprocess_cache_iter
+  inprocess_cache_iter,
+  inprocess_cache_get_info
 };
 
 svn_error_t *
@@ -425,40 +518,84 @@ svn_cache__create_inprocess(svn_cache__t **cache_p,
                             apr_pool_t *pool)
 {
   svn_cache__t *wrapper = apr_pcalloc(pool, sizeof(*wrapper));
-  inprocess_cache_t *cache = apr_pcalloc(pool, sizeof(*cache));
-
-  cache->hash = apr_hash_make(pool);
-  cache->klen = klen;
-
-  cache->dup_func = dup_func;
+  segmented_cache_t *segmented = apr_pcalloc(pool, sizeof(*segmented));
+  int i;
 
   SVN_ERR_ASSERT(pages >= 1);
-  cache->unallocated_pages = pages;
   SVN_ERR_ASSERT(items_per_page >= 1);
-  cache->items_per_page = items_per_page;
-
-  cache->sentinel = apr_pcalloc(pool, sizeof(*(cache->sentinel)));
-  cache->sentinel->prev = cache->sentinel;
-  cache->sentinel->next = cache->sentinel;
-  /* The sentinel doesn't need a pool.  (We're happy to crash if we
-   * accidentally try to treat it like a real page.) */
 
+  /* Only caches shared between threads need more than one segment. */
+  segmented->segment_count = 1;
+  segmented->segment_bits = 0;
 #if APR_HAS_THREADS
   if (thread_safe)
+    while (segmented->segment_count < MAX_SEGMENT_COUNT
+           && segmented->segment_count * 2 * MIN_SEGMENT_PAGES <= pages)
+      {
+        segmented->segment_count *= 2;
+        segmented->segment_bits++;
+      }
+#endif
+
+  segmented->klen = klen;
+  segmented->segments = apr_pcalloc(pool, segmented->segment_count
+                                          * sizeof(*segmented->segments));
+
+  for (i = 0; i < segmented->segment_count; ++i)
     {
-      apr_status_t status = apr_thread_mutex_create(&(cache->mutex),
-                                                    APR_THREAD_MUTEX_DEFAULT,
-                                                    pool);
-      if (status)
-        return svn_error_wrap_apr(status,
-                                  _("Can't create cache mutex"));
-    }
+      inprocess_cache_t *cache = &segmented->segments[i];
+
+      cache->klen = klen;
+
+      cache->dup_func = dup_func;
+
+      /* Distribute the pages evenly. */
+      cache->unallocated_pages = pages / segmented->segment_count
+                               + (i < pages % segmented->segment_count);
+      cache->total_pages = cache->unallocated_pages;
+      cache->items_per_page = items_per_page;
+
+      cache->sentinel = apr_pcalloc(pool, sizeof(*(cache->sentinel)));
+      cache->sentinel->prev = cache->sentinel;
+      cache->sentinel->next = cache->sentinel;
+      /* The sentinel doesn't need a pool.  (We're happy to crash if we
+       * accidentally try to treat it like a real page.) */
+
+#if APR_HAS_THREADS
+      if (thread_safe)
+        {
+          apr_status_t status
+            = apr_thread_mutex_create(&(cache->mutex),
+                                      APR_THREAD_MUTEX_DEFAULT, pool);
+          if (status)
+            return svn_error_wrap_apr(status,
+                                      _("Can't create cache mutex"));
+        }
 #endif
 
-  cache->cache_pool = pool;
+      /* Segments allocate their pages and hash entries concurrently, so
+       * each one needs a pool with an allocator of its own. */
+      if (segmented->segment_count > 1)
+        {
+          apr_allocator_t *allocator;
+          apr_status_t status = apr_allocator_create(&allocator);
+          if (status)
+            return svn_error_wrap_apr(status,
+                                      _("Can't create cache allocator"));
+
+          cache->cache_pool = svn_pool_create_ex(pool, allocator);
+          apr_allocator_owner_set(allocator, cache->cache_pool);
+        }
+      else
+        cache->cache_pool = pool;
+
+      /* The hash allocates its entries from the pool it was made in, so
+       * it must be the segment's pool, too. */
+      cache->hash = apr_hash_make(cache->cache_pool);
+    }
 
   wrapper->vtable = &inprocess_cache_vtable;
-  wrapper->cache_internal = cache;
+  wrapper->cache_internal = segmented;
 
   *cache_p = wrapper;
   return SVN_NO_ERROR;
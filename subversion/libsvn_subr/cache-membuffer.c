@@ -0,0 +1,866 @@
+/*
+ * cache-membuffer.c: in-memory caching for Subversion
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <assert.h>
+
+#include <apr_md5.h>
+#include <apr_thread_mutex.h>
+#include <apr_global_mutex.h>
+#include <apr_shm.h>
+
+#include "svn_pools.h"
+#include "svn_string.h"
+
+#include "svn_private_config.h"
+
+#include "cache.h"
+
+/*
+ * This svn_cache__t implementation stores serialized objects in a single,
+ * fixed-size block of memory that is allocated once when the membuffer is
+ * created.  Many svn_cache__t instances (e.g. all the FSFS caches of all
+ * repositories opened by a server process) can share one membuffer; the
+ * cache prefix given to svn_cache__create_membuffer_cache keeps their
+ * entries apart.
+ *
+ * The memory block consists of three parts:
+ *
+ * - a small header holding the global state of the membuffer,
+ *
+ * - the directory: an array of entry groups.  Each group holds up to
+ *   GROUP_SIZE entries.  The group an entry belongs to is selected by
+ *   its key, so lookup is O(1).  If a group is full, its least used
+ *   entry gets evicted to make room for a new one.
+ *
+ * - the data buffer.  It is used as a ring buffer: new items are always
+ *   appended at CURRENT_DATA.  All used entries form a doubly linked list
+ *   sorted by their data offsets, and HEADER->NEXT points to the first
+ *   entry at or behind CURRENT_DATA.  Entries that get in the way of
+ *   a new item are either dropped or, if they have been read since they
+ *   were last moved, moved in front of CURRENT_DATA.  Thus, frequently
+ *   used items survive many passes of the insertion point while items
+ *   that are not read will eventually be evicted.
+ *
+ * Since all references within the memory block are offsets and indexes
+ * rather than pointers, the block can be placed in shared memory and be
+ * used by all processes that get forked after the membuffer has been
+ * created.  In that case, a global (cross-process) mutex serializes all
+ * access to it.
+ *
+ * Keys are not stored in the cache.  Instead, the MD5 digest of the
+ * cache prefix and the key is used to identify an entry.
+ */
+
+/* Number of entries per directory group.
+ */
+#define GROUP_SIZE 8
+
+/* Alignment of all items in the data buffer.  Must be a power of 2.
+ */
+#define ITEM_ALIGNMENT 16
+
+/* Don't accept items taking more than that fraction of the data buffer.
+ */
+#define MAX_ITEM_FRACTION 4
+
+/* An entry index indicating "no entry".
+ */
+#define NO_INDEX APR_UINT32_MAX
+
+/* An offset value marking unused entries.
+ */
+#define NO_OFFSET APR_UINT64_MAX
+
+/* Round SIZE up to the next multiple of ITEM_ALIGNMENT.
+ */
+#define ALIGN_VALUE(size) \
+  (((size) + ITEM_ALIGNMENT - 1) & ~((apr_uint64_t)ITEM_ALIGNMENT - 1))
+
+/* The key that identifies a cache entry: the MD5 digest of prefix + key.
+ */
+typedef apr_uint64_t entry_key_t[APR_MD5_DIGESTSIZE / sizeof(apr_uint64_t)];
+
+/* A single directory entry.
+ */
+typedef struct entry_t
+{
+  /* The identifier of this entry; only valid if OFFSET != NO_OFFSET. */
+  entry_key_t key;
+
+  /* Position of the serialized item within the data buffer or NO_OFFSET
+   * if this entry is not in use. */
+  apr_uint64_t offset;
+
+  /* Size of the serialized item in bytes. */
+  apr_uint64_t size;
+
+  /* Number of reads since the item was added or last moved. */
+  apr_uint32_t hit_count;
+
+  /* Index of the used entry with the next lower / higher offset, or
+   * NO_INDEX if there is none. */
+  apr_uint32_t previous;
+  apr_uint32_t next;
+} entry_t;
+
+/* The global state of a membuffer.  It is stored at the beginning of
+ * the memory block, i.e. it is shared between processes if the block is.
+ */
+typedef struct membuffer_header_t
+{
+  /* Used entries with the lowest and highest offset (or NO_INDEX). */
+  apr_uint32_t first;
+  apr_uint32_t last;
+
+  /* The first used entry at or behind CURRENT_DATA (or NO_INDEX). */
+  apr_uint32_t next;
+
+  /* Insertion point for the next item in the data buffer. */
+  apr_uint64_t current_data;
+
+  /* Number of bytes in the data buffer currently used by items. */
+  apr_uint64_t data_used;
+
+  /* Number of entries currently in use. */
+  apr_uint64_t used_entries;
+
+  /* Access statistics summed over all caches using this membuffer. */
+  apr_uint64_t gets;
+  apr_uint64_t hits;
+  apr_uint64_t sets;
+  apr_uint64_t evictions;
+} membuffer_header_t;
+
+/* The process-local handle to a membuffer memory block.
+ */
+struct svn_membuffer_t
+{
+  /* The control data at the beginning of the memory block. */
+  membuffer_header_t *header;
+
+  /* The directory: GROUP_COUNT * GROUP_SIZE entries. */
+  entry_t *directory;
+  apr_uint32_t group_count;
+
+  /* The data buffer of DATA_SIZE bytes. */
+  unsigned char *data;
+  apr_uint64_t data_size;
+
+  /* Items larger than this will not be cached. */
+  apr_uint64_t max_entry_size;
+
+#if APR_HAS_THREADS
+  /* Lock for intra-process synchronization, or NULL if the membuffer
+   * is neither thread-safe nor shared. */
+  apr_thread_mutex_t *mutex;
+#endif
+
+  /* Lock for inter-process synchronization, or NULL if the membuffer
+   * is not shared. */
+  apr_global_mutex_t *global_mutex;
+};
+
+
+/* Return the index of ENTRY within CACHE's directory.
+ */
+static APR_INLINE apr_uint32_t
+get_index(svn_membuffer_t *cache, entry_t *entry)
+{
+  return (apr_uint32_t)(entry - cache->directory);
+}
+
+/* Return the entry at INDEX within CACHE's directory.
+ */
+static APR_INLINE entry_t *
+get_entry(svn_membuffer_t *cache, apr_uint32_t idx)
+{
+  return &cache->directory[idx];
+}
+
+/* If applicable, acquire the lock(s) of CACHE.
+ */
+static svn_error_t *
+lock_cache(svn_membuffer_t *cache)
+{
+  apr_status_t status;
+
+  if (cache->global_mutex)
+    {
+      status = apr_global_mutex_lock(cache->global_mutex);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't lock cache mutex"));
+
+      return SVN_NO_ERROR;
+    }
+
+#if APR_HAS_THREADS
+  if (cache->mutex)
+    {
+      status = apr_thread_mutex_lock(cache->mutex);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't lock cache mutex"));
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* If applicable, release the lock(s) of CACHE, then return ERR.
+ */
+static svn_error_t *
+unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
+{
+  apr_status_t status = APR_SUCCESS;
+
+  if (cache->global_mutex)
+    status = apr_global_mutex_unlock(cache->global_mutex);
+#if APR_HAS_THREADS
+  else if (cache->mutex)
+    status = apr_thread_mutex_unlock(cache->mutex);
+#endif
+
+  if (status && !err)
+    return svn_error_wrap_apr(status, _("Can't unlock cache mutex"));
+
+  return err;
+}
+
+/* Remove ENTRY from the offset-sorted list of used entries in CACHE and
+ * mark it as unused.  Its data will be overwritten eventually.
+ */
+static void
+drop_entry(svn_membuffer_t *cache, entry_t *entry)
+{
+  membuffer_header_t *header = cache->header;
+  apr_uint32_t idx = get_index(cache, entry);
+
+  if (header->next == idx)
+    header->next = entry->next;
+
+  if (entry->previous == NO_INDEX)
+    header->first = entry->next;
+  else
+    get_entry(cache, entry->previous)->next = entry->next;
+
+  if (entry->next == NO_INDEX)
+    header->last = entry->previous;
+  else
+    get_entry(cache, entry->next)->previous = entry->previous;
+
+  header->data_used -= entry->size;
+  header->used_entries--;
+
+  entry->offset = NO_OFFSET;
+}
+
+/* Link the unused ENTRY into CACHE's entry list at the current insertion
+ * point and advance the latter.  ENTRY->SIZE must already be set and the
+ * data buffer must have enough room at CURRENT_DATA.
+ */
+static void
+insert_entry(svn_membuffer_t *cache, entry_t *entry)
+{
+  membuffer_header_t *header = cache->header;
+  apr_uint32_t idx = get_index(cache, entry);
+
+  entry->offset = header->current_data;
+  entry->next = header->next;
+  entry->previous = header->next == NO_INDEX
+                  ? header->last
+                  : get_entry(cache, header->next)->previous;
+
+  if (entry->previous == NO_INDEX)
+    header->first = idx;
+  else
+    get_entry(cache, entry->previous)->next = idx;
+
+  if (entry->next == NO_INDEX)
+    header->last = idx;
+  else
+    get_entry(cache, entry->next)->previous = idx;
+
+  header->current_data += ALIGN_VALUE(entry->size);
+  header->data_used += entry->size;
+  header->used_entries++;
+}
+
+/* Return the used entry for KEY in CACHE, or NULL if there is none.
+ * If FIND_EMPTY is set, return an unused entry of the group that KEY
+ * maps to instead, evicting the least used entry of that group if
+ * necessary.
+ */
+static entry_t *
+find_entry(svn_membuffer_t *cache,
+           const entry_key_t key,
+           svn_boolean_t find_empty)
+{
+  entry_t *group = get_entry(cache, (apr_uint32_t)(key[0]
+                                                   % cache->group_count)
+                                    * GROUP_SIZE);
+  entry_t *victim = NULL;
+  int i;
+
+  for (i = 0; i < GROUP_SIZE; ++i)
+    {
+      entry_t *entry = &group[i];
+
+      if (entry->offset == NO_OFFSET)
+        {
+          if (find_empty)
+            return entry;
+
+          continue;
+        }
+
+      if (!find_empty
+          && entry->key[0] == key[0]
+          && entry->key[1] == key[1])
+        return entry;
+
+      if (victim == NULL || entry->hit_count < victim->hit_count)
+        victim = entry;
+    }
+
+  if (!find_empty)
+    return NULL;
+
+  /* The group is full.  Make room by evicting its least used entry. */
+  drop_entry(cache, victim);
+  cache->header->evictions++;
+  return victim;
+}
+
+/* Make sure that there are at least SIZE bytes available at CACHE's
+ * insertion point by advancing the insertion point, dropping entries
+ * and moving frequently used ones.  Return FALSE if that failed.
+ */
+static svn_boolean_t
+ensure_data_insertable(svn_membuffer_t *cache, apr_uint64_t size)
+{
+  membuffer_header_t *header = cache->header;
+  apr_uint64_t moved_size = 0;
+  int wraps = 0;
+
+  if (size > cache->max_entry_size)
+    return FALSE;
+
+  while (TRUE)
+    {
+      apr_uint64_t end = header->next == NO_INDEX
+                       ? cache->data_size
+                       : get_entry(cache, header->next)->offset;
+
+      if (header->current_data + size <= end)
+        return TRUE;
+
+      if (header->next == NO_INDEX)
+        {
+          /* We hit the end of the buffer.  Start over at its beginning
+           * (leaving the tail unused for this round). */
+          if (++wraps > 2)
+            return FALSE;
+
+          header->current_data = 0;
+          header->next = header->first;
+        }
+      else
+        {
+          entry_t *entry = get_entry(cache, header->next);
+
+          /* Items that have been read since we passed them last time
+           * get moved in front of the insertion point, but let's not
+           * shuffle around more than the size of the buffer per insert.
+           * Halving the hit count lets popular items age, too. */
+          if (entry->hit_count && moved_size < cache->data_size)
+            {
+              apr_uint64_t aligned_size = ALIGN_VALUE(entry->size);
+
+              if (entry->offset != header->current_data)
+                memmove(cache->data + header->current_data,
+                        cache->data + entry->offset,
+                        (apr_size_t)entry->size);
+
+              entry->offset = header->current_data;
+              entry->hit_count /= 2;
+              header->current_data += aligned_size;
+              header->next = entry->next;
+              moved_size += aligned_size;
+            }
+          else
+            {
+              drop_entry(cache, entry);
+              header->evictions++;
+            }
+        }
+    }
+}
+
+/* Store the serialized item DATA of SIZE bytes under KEY in CACHE,
+ * replacing any previous value for KEY.  The caller must hold the
+ * cache lock.
+ */
+static void
+membuffer_store(svn_membuffer_t *cache,
+                const entry_key_t key,
+                const char *data,
+                apr_size_t size)
+{
+  entry_t *entry = find_entry(cache, key, FALSE);
+
+  cache->header->sets++;
+
+  if (entry)
+    drop_entry(cache, entry);
+
+  if (!ensure_data_insertable(cache, size))
+    return;
+
+  entry = find_entry(cache, key, TRUE);
+  entry->key[0] = key[0];
+  entry->key[1] = key[1];
+  entry->size = size;
+  entry->hit_count = 0;
+
+  memcpy(cache->data + cache->header->current_data, data, size);
+  insert_entry(cache, entry);
+}
+
+/* Look up KEY in CACHE.  If found, return a copy of the serialized item
+ * in *DATA, allocated in POOL, and its size in *SIZE.  Otherwise, set
+ * *DATA to NULL.  The caller must hold the cache lock.
+ */
+static void
+membuffer_fetch(char **data,
+                apr_size_t *size,
+                svn_membuffer_t *cache,
+                const entry_key_t key,
+                apr_pool_t *pool)
+{
+  entry_t *entry = find_entry(cache, key, FALSE);
+
+  cache->header->gets++;
+
+  if (entry == NULL)
+    {
+      *data = NULL;
+      *size = 0;
+      return;
+    }
+
+  *size = (apr_size_t)entry->size;
+  *data = apr_palloc(pool, *size + 1);
+  memcpy(*data, cache->data + entry->offset, *size);
+  (*data)[*size] = '\0';
+
+  entry->hit_count++;
+  cache->header->hits++;
+}
+
+/* Look up KEY in CACHE.  If found, call FUNC with BATON on the
+ * serialized item in place and return its result in *ITEM, allocated
+ * in POOL.  Otherwise, set *FOUND to FALSE.  The caller must hold the
+ * cache lock.
+ */
+static svn_error_t *
+membuffer_fetch_partial(void **item,
+                        svn_boolean_t *found,
+                        svn_membuffer_t *cache,
+                        const entry_key_t key,
+                        svn_cache__partial_getter_func_t func,
+                        void *baton,
+                        apr_pool_t *pool)
+{
+  entry_t *entry = find_entry(cache, key, FALSE);
+
+  cache->header->gets++;
+
+  if (entry == NULL)
+    {
+      *found = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  entry->hit_count++;
+  cache->header->hits++;
+  *found = TRUE;
+
+  return func(item, (const char *)cache->data + entry->offset,
+              (apr_size_t)entry->size, baton, pool);
+}
+
+svn_error_t *
+svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
+                                  apr_size_t total_size,
+                                  apr_size_t directory_size,
+                                  svn_boolean_t thread_safe,
+                                  svn_boolean_t shared,
+                                  apr_pool_t *pool)
+{
+  svn_membuffer_t *c = apr_pcalloc(pool, sizeof(*c));
+  apr_uint64_t group_size = GROUP_SIZE * sizeof(entry_t);
+  apr_uint64_t header_size = ALIGN_VALUE(sizeof(membuffer_header_t));
+  apr_uint64_t group_count;
+  apr_uint64_t i;
+  char *base;
+
+  /* Default to 1/16th of the memory spent on the directory and don't
+   * let the directory take more than half of it. */
+  if (directory_size == 0)
+    directory_size = total_size / 16;
+  if (directory_size > total_size / 2)
+    directory_size = total_size / 2;
+
+  group_count = directory_size / group_size;
+  if (group_count == 0)
+    group_count = 1;
+  if (group_count > NO_INDEX / GROUP_SIZE)
+    group_count = NO_INDEX / GROUP_SIZE;
+
+  if (total_size < header_size + group_count * group_size + ITEM_ALIGNMENT)
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("Cache size of %" APR_SIZE_T_FMT
+                               " bytes is too small"),
+                             total_size);
+
+  c->group_count = (apr_uint32_t)group_count;
+  c->data_size = (total_size - header_size - group_count * group_size)
+               & ~((apr_uint64_t)ITEM_ALIGNMENT - 1);
+  c->max_entry_size = c->data_size / MAX_ITEM_FRACTION;
+
+  if (shared)
+    {
+#if APR_HAS_SHARED_MEMORY && APR_HAS_FORK
+      apr_shm_t *shm;
+      apr_status_t status;
+
+      /* Anonymous shared memory is inherited by all forked children. */
+      status = apr_shm_create(&shm, total_size, NULL, pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't allocate shared memory for "
+                                    "the cache"));
+      base = apr_shm_baseaddr_get(shm);
+
+      /* Use fcntl() locks where available: unlike process-shared
+       * pthread mutexes and SysV semaphores, they don't get destroyed
+       * for all processes when one of them runs its pool cleanups. */
+#if APR_HAS_FCNTL_SERIALIZE
+      status = apr_global_mutex_create(&c->global_mutex, NULL,
+                                       APR_LOCK_FCNTL, pool);
+#else
+      status = apr_global_mutex_create(&c->global_mutex, NULL,
+                                       APR_LOCK_DEFAULT, pool);
+#endif
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create cache mutex"));
+#else
+      return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                              _("Shared memory caches are not supported "
+                                "on this platform"));
+#endif
+    }
+  else
+    {
+      base = apr_palloc(pool, total_size);
+
+#if APR_HAS_THREADS
+      if (thread_safe)
+        {
+          apr_status_t status
+            = apr_thread_mutex_create(&c->mutex, APR_THREAD_MUTEX_DEFAULT,
+                                      pool);
+          if (status)
+            return svn_error_wrap_apr(status,
+                                      _("Can't create cache mutex"));
+        }
+#endif
+    }
+
+  c->header = (membuffer_header_t *)base;
+  c->directory = (entry_t *)(base + header_size);
+  c->data = (unsigned char *)(base + header_size + group_count * group_size);
+
+  c->header->first = NO_INDEX;
+  c->header->last = NO_INDEX;
+  c->header->next = NO_INDEX;
+  c->header->current_data = 0;
+  c->header->data_used = 0;
+  c->header->used_entries = 0;
+  c->header->gets = 0;
+  c->header->hits = 0;
+  c->header->sets = 0;
+  c->header->evictions = 0;
+
+  for (i = 0; i < group_count * GROUP_SIZE; ++i)
+    c->directory[i].offset = NO_OFFSET;
+
+  *cache = c;
+  return SVN_NO_ERROR;
+}
+
+
+/*** The svn_cache__t front-end. ***/
+
+/* An svn_cache__t instance backed by a membuffer.
+ */
+typedef struct membuffer_cache_t
+{
+  /* The memory block shared with other caches. */
+  svn_membuffer_t *membuffer;
+
+  /* Used to marshal values in and out of the membuffer. */
+  svn_cache__serialize_func_t serializer;
+  svn_cache__deserialize_func_t deserializer;
+
+  /* MD5 digest of the cache prefix; it separates our entries from those
+   * of other caches using the same membuffer. */
+  unsigned char prefix[APR_MD5_DIGESTSIZE];
+
+  /* The size of the key: either a fixed number of bytes or
+   * APR_HASH_KEY_STRING. */
+  apr_ssize_t klen;
+} membuffer_cache_t;
+
+/* Set *ENTRY_KEY to the membuffer key for KEY in CACHE.
+ */
+static void
+combine_key(entry_key_t entry_key,
+            membuffer_cache_t *cache,
+            const void *key)
+{
+  apr_md5_ctx_t context;
+  unsigned char digest[APR_MD5_DIGESTSIZE];
+  apr_size_t len = cache->klen == APR_HASH_KEY_STRING
+                 ? strlen(key)
+                 : (apr_size_t)cache->klen;
+
+  apr_md5_init(&context);
+  apr_md5_update(&context, cache->prefix, sizeof(cache->prefix));
+  apr_md5_update(&context, key, len);
+  apr_md5_final(digest, &context);
+
+  memcpy(entry_key, digest, sizeof(digest));
+}
+
+static svn_error_t *
+membuffer_cache_get(void **value_p,
+                    svn_boolean_t *found,
+                    void *cache_void,
+                    const void *key,
+                    apr_pool_t *pool)
+{
+  membuffer_cache_t *cache = cache_void;
+  entry_key_t entry_key;
+  char *data;
+  apr_size_t size;
+
+  combine_key(entry_key, cache, key);
+
+  SVN_ERR(lock_cache(cache->membuffer));
+  membuffer_fetch(&data, &size, cache->membuffer, entry_key, pool);
+  SVN_ERR(unlock_cache(cache->membuffer, SVN_NO_ERROR));
+
+  if (data == NULL)
+    {
+      *found = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Deserialize outside the lock; we own our copy of the data. */
+  if (cache->deserializer)
+    {
+      SVN_ERR((cache->deserializer)(value_p, data, size, pool));
+    }
+  else
+    {
+      svn_string_t *value = apr_pcalloc(pool, sizeof(*value));
+      value->data = data;
+      value->len = size;
+      *value_p = value;
+    }
+
+  *found = TRUE;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+membuffer_cache_get_partial(void **value_p,
+                            svn_boolean_t *found,
+                            void *cache_void,
+                            const void *key,
+                            svn_cache__partial_getter_func_t func,
+                            void *baton,
+                            apr_pool_t *pool)
+{
+  membuffer_cache_t *cache = cache_void;
+  entry_key_t entry_key;
+  svn_error_t *err;
+
+  combine_key(entry_key, cache, key);
+
+  /* FUNC works on the shared data, so it must be called under the lock. */
+  SVN_ERR(lock_cache(cache->membuffer));
+  err = membuffer_fetch_partial(value_p, found, cache->membuffer,
+                                entry_key, func, baton, pool);
+  return unlock_cache(cache->membuffer, err);
+}
+
+static svn_error_t *
+membuffer_cache_set(void *cache_void,
+                    const void *key,
+                    void *value,
+                    apr_pool_t *pool)
+{
+  membuffer_cache_t *cache = cache_void;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  entry_key_t entry_key;
+  char *data;
+  apr_size_t size;
+
+  combine_key(entry_key, cache, key);
+
+  if (cache->serializer)
+    {
+      SVN_ERR((cache->serializer)(&data, &size, value, subpool));
+    }
+  else
+    {
+      svn_stringbuf_t *value_str = value;
+      data = value_str->data;
+      size = value_str->len;
+    }
+
+  SVN_ERR(lock_cache(cache->membuffer));
+  membuffer_store(cache->membuffer, entry_key, data, size);
+  SVN_ERR(unlock_cache(cache->membuffer, SVN_NO_ERROR));
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+membuffer_cache_iter(svn_boolean_t *completed,
+                     void *cache_void,
+                     svn_iter_apr_hash_cb_t user_cb,
+                     void *user_baton,
+                     apr_pool_t *pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Can't iterate a membuffer-based cache"));
+}
+
+/* Fill in the size, entry and eviction members of INFO for MEMBUFFER.
+ * The caller must hold the cache lock.
+ */
+static void
+get_membuffer_info(svn_membuffer_t *membuffer,
+                   svn_cache__info_t *info,
+                   svn_boolean_t reset)
+{
+  membuffer_header_t *header = membuffer->header;
+
+  info->evictions = header->evictions;
+  info->used_size = header->data_used;
+  info->total_size = membuffer->data_size;
+  info->used_entries = header->used_entries;
+  info->total_entries = (apr_uint64_t)membuffer->group_count * GROUP_SIZE;
+
+  if (reset)
+    header->evictions = 0;
+}
+
+static svn_error_t *
+membuffer_cache_get_info(void *cache_void,
+                         svn_cache__info_t *info,
+                         svn_boolean_t reset,
+                         apr_pool_t *pool)
+{
+  membuffer_cache_t *cache = cache_void;
+
+  /* Resetting the eviction count would affect all caches in the
+   * membuffer.  Leave that to svn_cache__membuffer_get_info. */
+  SVN_ERR(lock_cache(cache->membuffer));
+  get_membuffer_info(cache->membuffer, info, FALSE);
+  return unlock_cache(cache->membuffer, SVN_NO_ERROR);
+}
+
+static svn_cache__vtable_t membuffer_cache_vtable = {
+  membuffer_cache_get,
+  membuffer_cache_get_partial,
+  NULL, /* get_many: lookups are local */
+  membuffer_cache_set,
+  membuffer_cache_iter,
+  membuffer_cache_get_info
+};
+
+svn_error_t *
+svn_cache__membuffer_get_info(svn_membuffer_t *membuffer,
+                              svn_cache__info_t *info,
+                              svn_boolean_t reset,
+                              apr_pool_t *pool)
+{
+  membuffer_header_t *header = membuffer->header;
+
+  memset(info, 0, sizeof(*info));
+
+  SVN_ERR(lock_cache(membuffer));
+
+  get_membuffer_info(membuffer, info, reset);
+  info->gets = header->gets;
+  info->hits = header->hits;
+  info->sets = header->sets;
+
+  if (reset)
+    {
+      header->gets = 0;
+      header->hits = 0;
+      header->sets = 0;
+    }
+
+  return unlock_cache(membuffer, SVN_NO_ERROR);
+}
+
+svn_error_t *
+svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
+                                  svn_membuffer_t *membuffer,
+                                  svn_cache__serialize_func_t serializer,
+                                  svn_cache__deserialize_func_t deserializer,
+                                  apr_ssize_t klen,
+                                  const char *prefix,
+                                  apr_pool_t *pool)
+{
+  svn_cache__t *wrapper = apr_pcalloc(pool, sizeof(*wrapper));
+  membuffer_cache_t *cache = apr_pcalloc(pool, sizeof(*cache));
+
+  cache->membuffer = membuffer;
+  cache->serializer = serializer;
+  cache->deserializer = deserializer;
+  cache->klen = klen;
+  apr_md5(cache->prefix, prefix, strlen(prefix));
+
+  wrapper->vtable = &membuffer_cache_vtable;
+  wrapper->cache_internal = cache;
+
+  *cache_p = wrapper;
+  return SVN_NO_ERROR;
+}
@@ -124,6 +124,31 @@ build_key(memcache_t *cache,
 }
 
 
+/* Turn the LEN bytes of DATA fetched for CACHE into *VALUE_P, allocated
+   in POOL.  DATA must live in POOL, too, since the result may use it in
+   place. */
+static svn_error_t *
+unmarshal_value(void **value_p,
+                memcache_t *cache,
+                char *data,
+                apr_size_t data_len,
+                apr_pool_t *pool)
+{
+  if (cache->deserialize_func)
+    {
+      SVN_ERR((cache->deserialize_func)(value_p, data, data_len, pool));
+    }
+  else
+    {
+      svn_string_t *value = apr_pcalloc(pool, sizeof(*value));
+      value->data = data;
+      value->len = data_len;
+      *value_p = value;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 memcache_get(void **value_p,
              svn_boolean_t *found,
@@ -140,8 +165,9 @@ memcache_get(void **value_p,
 
   mc_key = build_key(cache, key, subpool);
 
+  /* The deserializer may use the data in place, so it must live in POOL. */
   apr_err = apr_memcache_getp(cache->memcache,
-                              (cache->deserialize_func ? subpool : pool),
+                              pool,
                               mc_key,
                               &data,
                               &data_len,
@@ -157,17 +183,117 @@ memcache_get(void **value_p,
                               _("Unknown memcached error while reading"));
 
   /* We found it! */
-  if (cache->deserialize_func)
+  SVN_ERR(unmarshal_value(value_p, cache, data, data_len, pool));
+  *found = TRUE;
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+memcache_get_many(void **values,
+                  svn_boolean_t *found,
+                  void *cache_void,
+                  const void *const *keys,
+                  int nkeys,
+                  apr_pool_t *pool)
+{
+  memcache_t *cache = cache_void;
+  apr_status_t apr_err;
+  apr_hash_t *mc_values = NULL;
+  const char **mc_keys;
+  int i;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  if (nkeys == 0)
     {
-      SVN_ERR((cache->deserialize_func)(value_p, data, data_len, pool));
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
     }
-  else
+
+  mc_keys = apr_palloc(subpool, nkeys * sizeof(*mc_keys));
+  for (i = 0; i < nkeys; i++)
     {
-      svn_string_t *value = apr_pcalloc(pool, sizeof(*value));
-      value->data = data;
-      value->len = data_len;
-      *value_p = value;
+      mc_keys[i] = build_key(cache, keys[i], subpool);
+      apr_memcache_add_multget_key(subpool, mc_keys[i], &mc_values);
+    }
+
+  /* All keys go out in one request per server.  The deserializer may
+     use the data in place, so it must live in POOL. */
+  apr_err = apr_memcache_multgetp(cache->memcache, subpool, pool, mc_values);
+  if (apr_err == APR_NOTFOUND)
+    {
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
     }
+  else if (apr_err != APR_SUCCESS)
+    return svn_error_wrap_apr(apr_err,
+                              _("Unknown memcached error while reading"));
+
+  for (i = 0; i < nkeys; i++)
+    {
+      apr_memcache_value_t *value = apr_hash_get(mc_values, mc_keys[i],
+                                                 APR_HASH_KEY_STRING);
+      int j;
+
+      if (value == NULL || value->status != APR_SUCCESS || !value->data)
+        continue;
+
+      /* Keys that occur more than once share one entry in MC_VALUES,
+         and the deserializer may have modified its data already. */
+      for (j = 0; j < i; j++)
+        if (found[j] && strcmp(mc_keys[j], mc_keys[i]) == 0)
+          break;
+
+      if (j < i)
+        values[i] = values[j];
+      else
+        SVN_ERR(unmarshal_value(&values[i], cache, value->data, value->len,
+                                pool));
+      found[i] = TRUE;
+    }
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+memcache_get_partial(void **value_p,
+                     svn_boolean_t *found,
+                     void *cache_void,
+                     const void *key,
+                     svn_cache__partial_getter_func_t func,
+                     void *baton,
+                     apr_pool_t *pool)
+{
+  memcache_t *cache = cache_void;
+  apr_status_t apr_err;
+  char *data;
+  const char *mc_key;
+  apr_size_t data_len;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  mc_key = build_key(cache, key, subpool);
+
+  /* The memcached server has no notion of partial reads.  But we can at
+   * least avoid deserializing all the data into POOL. */
+  apr_err = apr_memcache_getp(cache->memcache,
+                              subpool,
+                              mc_key,
+                              &data,
+                              &data_len,
+                              NULL /* ignore flags */);
+  if (apr_err == APR_NOTFOUND)
+    {
+      *found = FALSE;
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
+    }
+  else if (apr_err != APR_SUCCESS || !data)
+    return svn_error_wrap_apr(apr_err,
+                              _("Unknown memcached error while reading"));
+
+  SVN_ERR(func(value_p, data, data_len, baton, pool));
   *found = TRUE;
 
   svn_pool_destroy(subpool);
@@ -222,10 +348,23 @@ memcache_iter(svn_boolean_t *completed,
                           _("Can't iterate a memcached cache"));
 }
 
+static svn_error_t *
+memcache_get_info(void *cache_void,
+                  svn_cache__info_t *info,
+                  svn_boolean_t reset,
+                  apr_pool_t *pool)
+{
+  /* Sizes and evictions are only known to the memcached servers. */
+  return SVN_NO_ERROR;
+}
+
 static svn_cache__vtable_t memcache_vtable = {
   memcache_get,
+  memcache_get_partial,
+  memcache_get_many,
   memcache_set,
-  memcache_iter
+  memcache_iter,
+  memcache_get_info
 };
 
 svn_error_t *
@@ -21,6 +21,12 @@
  * ====================================================================
  */
 
+#include <string.h>
+
+#include "svn_string.h"
+#include "svn_private_config.h"
+#include "private/svn_trace.h"
+
 #include "cache.h"
 
 svn_error_t *
@@ -55,16 +61,104 @@ svn_cache__get(void **value_p,
                const void *key,
                apr_pool_t *pool)
 {
+  /* The statistics are not part of the cache contents; they may be
+     updated even through a const pointer. */
+  svn_cache__t *stats = (svn_cache__t *)cache;
+  svn_error_t *err;
+  apr_time_t start;
+
   /* In case any errors happen and are quelched, make sure we start
      out with FOUND set to false. */
   *found = FALSE;
-  return handle_error(cache,
-                      (cache->vtable->get)(value_p,
-                                           found,
-                                           cache->cache_internal,
-                                           key,
-                                           pool),
-                      pool);
+  SVN_TRACE__BEGIN(cache_get, start);
+  err = (cache->vtable->get)(value_p,
+                             found,
+                             cache->cache_internal,
+                             key,
+                             pool);
+  SVN_TRACE__END(cache_get, start, *found ? "hit" : "miss");
+
+  stats->gets++;
+  if (err)
+    stats->failures++;
+  else if (*found)
+    stats->hits++;
+
+  return handle_error(cache, err, pool);
+}
+
+svn_error_t *
+svn_cache__get_many(void **values,
+                    svn_boolean_t *found,
+                    const svn_cache__t *cache,
+                    const void *const *keys,
+                    int nkeys,
+                    apr_pool_t *pool)
+{
+  svn_cache__t *stats = (svn_cache__t *)cache;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  for (i = 0; i < nkeys; i++)
+    found[i] = FALSE;
+
+  if (cache->vtable->get_many)
+    err = (cache->vtable->get_many)(values,
+                                    found,
+                                    cache->cache_internal,
+                                    keys,
+                                    nkeys,
+                                    pool);
+  else
+    for (i = 0; i < nkeys && !err; i++)
+      err = (cache->vtable->get)(&values[i],
+                                 &found[i],
+                                 cache->cache_internal,
+                                 keys[i],
+                                 pool);
+
+  stats->gets += nkeys;
+  if (err)
+    stats->failures++;
+  else
+    for (i = 0; i < nkeys; i++)
+      if (found[i])
+        stats->hits++;
+
+  return handle_error(cache, err, pool);
+}
+
+svn_error_t *
+svn_cache__get_partial(void **value,
+                       svn_boolean_t *found,
+                       const svn_cache__t *cache,
+                       const void *key,
+                       svn_cache__partial_getter_func_t func,
+                       void *baton,
+                       apr_pool_t *pool)
+{
+  svn_cache__t *stats = (svn_cache__t *)cache;
+  svn_error_t *err;
+
+  *found = FALSE;
+  if (cache->vtable->get_partial == NULL)
+    return SVN_NO_ERROR;
+
+  err = (cache->vtable->get_partial)(value,
+                                     found,
+                                     cache->cache_internal,
+                                     key,
+                                     func,
+                                     baton,
+                                     pool);
+
+  stats->gets++;
+  if (err)
+    stats->failures++;
+  else if (*found)
+    stats->hits++;
+
+  return handle_error(cache, err, pool);
 }
 
 svn_error_t *
@@ -73,12 +167,16 @@ svn_cache__set(svn_cache__t *cache,
                void *value,
                apr_pool_t *pool)
 {
-  return handle_error(cache,
-                      (cache->vtable->set)(cache->cache_internal,
-                                           key,
-                                           value,
-                                           pool),
-                      pool);
+  svn_error_t *err = (cache->vtable->set)(cache->cache_internal,
+                                          key,
+                                          value,
+                                          pool);
+
+  cache->sets++;
+  if (err)
+    cache->failures++;
+
+  return handle_error(cache, err, pool);
 }
 
 
@@ -96,3 +194,59 @@ svn_cache__iter(svn_boolean_t *completed,
                                pool);
 }
 
+
+
+svn_error_t *
+svn_cache__get_info(const svn_cache__t *cache,
+                    svn_cache__info_t *info,
+                    svn_boolean_t reset,
+                    apr_pool_t *pool)
+{
+  svn_cache__t *stats = (svn_cache__t *)cache;
+
+  memset(info, 0, sizeof(*info));
+  SVN_ERR((cache->vtable->get_info)(cache->cache_internal, info, reset,
+                                    pool));
+
+  info->gets = cache->gets;
+  info->hits = cache->hits;
+  info->sets = cache->sets;
+  info->failures = cache->failures;
+
+  if (reset)
+    {
+      stats->gets = 0;
+      stats->hits = 0;
+      stats->sets = 0;
+      stats->failures = 0;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_string_t *
+svn_cache__format_info(const char *id,
+                       const svn_cache__info_t *info,
+                       apr_pool_t *pool)
+{
+  /* Hit rate in 0.1 percent units. */
+  apr_uint64_t hit_rate = info->gets ? info->hits * 1000 / info->gets : 0;
+
+  return svn_string_createf(pool,
+                            "%s: gets %" APR_UINT64_T_FMT
+                            ", hits %" APR_UINT64_T_FMT
+                            " (%" APR_UINT64_T_FMT ".%d%%)"
+                            ", sets %" APR_UINT64_T_FMT
+                            ", failures %" APR_UINT64_T_FMT
+                            ", evictions %" APR_UINT64_T_FMT
+                            ", entries %" APR_UINT64_T_FMT
+                            " of %" APR_UINT64_T_FMT
+                            ", bytes %" APR_UINT64_T_FMT
+                            " of %" APR_UINT64_T_FMT,
+                            id, info->gets, info->hits,
+                            hit_rate / 10, (int)(hit_rate % 10),
+                            info->sets, info->failures, info->evictions,
+                            info->used_entries, info->total_entries,
+                            info->used_size, info->total_size);
+}
@@ -37,6 +37,25 @@ typedef struct {
                       const void *key,
                       apr_pool_t *pool);
 
+  /* May be NULL if the implementation does not keep serialized data. */
+  svn_error_t *(*get_partial)(void **value,
+                              svn_boolean_t *found,
+                              void *cache_implementation,
+                              const void *key,
+                              svn_cache__partial_getter_func_t func,
+                              void *baton,
+                              apr_pool_t *pool);
+
+  /* Look up NKEYS keys at once.  May be NULL if the implementation gains
+     nothing over individual lookups; the front end then calls GET for
+     each key. */
+  svn_error_t *(*get_many)(void **values,
+                           svn_boolean_t *found,
+                           void *cache_implementation,
+                           const void *const *keys,
+                           int nkeys,
+                           apr_pool_t *pool);
+
   svn_error_t *(*set)(void *cache_implementation,
                       const void *key,
                       void *value,
@@ -47,6 +66,13 @@ typedef struct {
                        svn_iter_apr_hash_cb_t func,
                        void *baton,
                        apr_pool_t *pool);
+
+  /* Fill in the size, entry and eviction members of INFO.  The access
+     counters are maintained by the svn_cache__t front end. */
+  svn_error_t *(*get_info)(void *cache_implementation,
+                           svn_cache__info_t *info,
+                           svn_boolean_t reset,
+                           apr_pool_t *pool);
 } svn_cache__vtable_t;
 
 struct svn_cache__t {
@@ -54,6 +80,12 @@ struct svn_cache__t {
   svn_cache__error_handler_t error_handler;
   void *error_baton;
   void *cache_internal;
+
+  /* Access statistics, see svn_cache__info_t. */
+  apr_uint64_t gets;
+  apr_uint64_t hits;
+  apr_uint64_t sets;
+  apr_uint64_t failures;
 };
 
 
@@ -0,0 +1,107 @@
+/*
+ * cache_config.c : configuration of internal caches
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_cache.h"
+
+/* The process-wide cache settings.  Keep the defaults in sync with the
+ * documentation of the svnserve and mod_dav_svn options.
+ */
+static svn_cache__config_t cache_settings =
+  {
+    0x1000000,   /* 16 MB for the global membuffer */
+    TRUE,        /* cache fulltexts */
+    FALSE,       /* process-local memory */
+    FALSE        /* assume multi-threaded operation */
+  };
+
+/* Initialization state of GLOBAL_MEMBUFFER. */
+static volatile svn_atomic_t membuffer_init_state = 0;
+
+/* The process-wide membuffer; NULL if disabled or not created yet. */
+static svn_membuffer_t *global_membuffer = NULL;
+
+const svn_cache__config_t *
+svn_cache__get_global_config(void)
+{
+  return &cache_settings;
+}
+
+/* Create GLOBAL_MEMBUFFER according to CACHE_SETTINGS.  Implements the
+ * init_func of svn_atomic__init_once.
+ */
+static svn_error_t *
+init_global_membuffer(void *baton, apr_pool_t *unused_pool)
+{
+  apr_pool_t *pool;
+  apr_uint64_t cache_size = cache_settings.cache_size;
+
+  if (cache_size == 0)
+    return SVN_NO_ERROR;
+
+  /* Don't let a misconfiguration exceed the address space. */
+  if (cache_size > APR_SIZE_MAX / 2)
+    cache_size = APR_SIZE_MAX / 2;
+
+  /* The membuffer lives as long as the process does. */
+  pool = svn_pool_create(NULL);
+
+  return svn_cache__membuffer_cache_create(&global_membuffer,
+                                           (apr_size_t)cache_size,
+                                           0,
+                                           ! cache_settings.single_threaded,
+                                           cache_settings.shared,
+                                           pool);
+}
+
+svn_membuffer_t *
+svn_cache__get_global_membuffer_cache(void)
+{
+  svn_error_t *err = svn_atomic__init_once(&membuffer_init_state,
+                                           init_global_membuffer,
+                                           NULL, NULL);
+
+  /* Caching is an optimization; without a membuffer, callers simply
+   * fall back to other caches. */
+  if (err)
+    {
+      svn_error_clear(err);
+      return NULL;
+    }
+
+  return global_membuffer;
+}
+
+svn_error_t *
+svn_cache__set_global_config(const svn_cache__config_t *settings)
+{
+  cache_settings = *settings;
+
+  if (settings->shared && settings->cache_size)
+    return svn_atomic__init_once(&membuffer_init_state,
+                                 init_global_membuffer, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
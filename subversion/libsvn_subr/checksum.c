@@ -293,10 +293,19 @@ svn_checksum_empty_checksum(svn_checksum_kind_t kind,
   return svn_checksum__from_digest(digest, kind, pool);
 }
 
+/* The amount of data a context computing two checksums at once feeds
+   to one of them before going on with the other.  Small enough for the
+   data to still be in the CPU cache for the second one. */
+#define PAIR_CHUNK_SIZE (8 * 1024)
+
 struct svn_checksum_ctx_t
 {
   void *apr_ctx;
   svn_checksum_kind_t kind;
+
+  /* The SHA-1 context that goes along with the MD5 one in APR_CTX, if
+     this was created by svn_checksum__ctx_create_md5_sha1(); else NULL. */
+  apr_sha1_ctx_t *sha1_ctx;
 };
 
 svn_checksum_ctx_t *
@@ -306,6 +315,7 @@ svn_checksum_ctx_create(svn_checksum_kind_t kind,
   svn_checksum_ctx_t *ctx = apr_palloc(pool, sizeof(*ctx));
 
   ctx->kind = kind;
+  ctx->sha1_ctx = NULL;
   switch (kind)
     {
       case svn_checksum_md5:
@@ -325,11 +335,39 @@ svn_checksum_ctx_create(svn_checksum_kind_t kind,
   return ctx;
 }
 
+svn_checksum_ctx_t *
+svn_checksum__ctx_create_md5_sha1(apr_pool_t *pool)
+{
+  svn_checksum_ctx_t *ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+
+  ctx->sha1_ctx = apr_palloc(pool, sizeof(*ctx->sha1_ctx));
+  apr_sha1_init(ctx->sha1_ctx);
+
+  return ctx;
+}
+
 svn_error_t *
 svn_checksum_update(svn_checksum_ctx_t *ctx,
                     const void *data,
                     apr_size_t len)
 {
+  if (ctx->sha1_ctx)
+    {
+      const char *p = data;
+
+      while (len > 0)
+        {
+          apr_size_t chunk = len < PAIR_CHUNK_SIZE ? len : PAIR_CHUNK_SIZE;
+
+          apr_md5_update(ctx->apr_ctx, p, chunk);
+          apr_sha1_update(ctx->sha1_ctx, p, (unsigned int)chunk);
+          p += chunk;
+          len -= chunk;
+        }
+
+      return SVN_NO_ERROR;
+    }
+
   switch (ctx->kind)
     {
       case svn_checksum_md5:
@@ -373,6 +411,21 @@ svn_checksum_final(svn_checksum_t **checksum,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_checksum__final_md5_sha1(svn_checksum_t **md5_checksum,
+                             svn_checksum_t **sha1_checksum,
+                             const svn_checksum_ctx_t *ctx,
+                             apr_pool_t *pool)
+{
+  SVN_ERR_ASSERT(ctx->sha1_ctx);
+
+  SVN_ERR(svn_checksum_final(md5_checksum, ctx, pool));
+  *sha1_checksum = svn_checksum_create(svn_checksum_sha1, pool);
+  apr_sha1_final((unsigned char *)(*sha1_checksum)->digest, ctx->sha1_ctx);
+
+  return SVN_NO_ERROR;
+}
+
 apr_size_t
 svn_checksum_size(const svn_checksum_t *checksum)
 {
@@ -33,6 +33,8 @@
 #include "svn_pools.h"
 #include "config_impl.h"
 
+#include "private/svn_config_private.h"
+
 #include "svn_private_config.h"
 
 
@@ -77,12 +79,11 @@ struct cfg_option_t
 
 
 
-svn_error_t *
-svn_config_read(svn_config_t **cfgp, const char *file,
-                svn_boolean_t must_exist, apr_pool_t *pool)
+/* Return a new, empty config allocated in POOL. */
+static svn_config_t *
+create_config(apr_pool_t *pool)
 {
   svn_config_t *cfg = apr_palloc(pool, sizeof(*cfg));
-  svn_error_t *err;
 
   cfg->sections = apr_hash_make(pool);
   cfg->pool = pool;
@@ -90,6 +91,18 @@ svn_config_read(svn_config_t **cfgp, const char *file,
   cfg->x_values = FALSE;
   cfg->tmp_key = svn_stringbuf_create("", pool);
   cfg->tmp_value = svn_stringbuf_create("", pool);
+  cfg->read_only = FALSE;
+  cfg->long_keys = NULL;
+
+  return cfg;
+}
+
+svn_error_t *
+svn_config_read(svn_config_t **cfgp, const char *file,
+                svn_boolean_t must_exist, apr_pool_t *pool)
+{
+  svn_config_t *cfg = create_config(pool);
+  svn_error_t *err;
 
   /* Yes, this is platform-specific code in Subversion, but there's no
      practical way to migrate it into APR, as it's simultaneously
@@ -365,6 +378,108 @@ make_hash_key(char *key)
 }
 
 
+/* The longest key of a read-only config that lookups canonicalize in a
+   buffer on the stack. */
+#define MAX_STACK_KEY_LEN 255
+
+/* An entry of one of the tables of a read-only config whose key is
+   longer than MAX_STACK_KEY_LEN. */
+typedef struct long_key_t
+{
+  /* The table. */
+  apr_hash_t *hash;
+
+  /* The entry's key, already canonical, and its length. */
+  const char *key;
+  apr_size_t len;
+
+  void *value;
+} long_key_t;
+
+/* Return the entry for KEY in HASH, one of the tables of CFG, or NULL
+   if there is none.  KEY is only copied to be canonicalized if it isn't
+   lower case already, which it usually is. */
+static void *
+get_hash_value(apr_hash_t *hash, svn_config_t *cfg, const char *key)
+{
+  const char *p;
+  char buffer[MAX_STACK_KEY_LEN + 1];
+  apr_size_t len;
+  int i;
+
+  for (p = key; *p != 0; ++p)
+    if (apr_isupper(*p))
+      break;
+
+  if (*p == 0)
+    return apr_hash_get(hash, key, p - key);
+
+  if (! cfg->read_only)
+    {
+      svn_stringbuf_set(cfg->tmp_key, key);
+      make_hash_key(cfg->tmp_key->data);
+      return apr_hash_get(hash, cfg->tmp_key->data, cfg->tmp_key->len);
+    }
+
+  /* A read-only config may be in use by other threads, so don't touch
+     its temporaries. */
+  len = (p - key) + strlen(p);
+  if (len <= MAX_STACK_KEY_LEN)
+    {
+      memcpy(buffer, key, len + 1);
+      return apr_hash_get(hash, make_hash_key(buffer), len);
+    }
+
+  /* Compare longer keys to the few entries that have one instead. */
+  for (i = 0; i < cfg->long_keys->nelts; i++)
+    {
+      const long_key_t *entry = &APR_ARRAY_IDX(cfg->long_keys, i,
+                                               long_key_t);
+      apr_size_t j;
+
+      if (entry->hash != hash || entry->len != len)
+        continue;
+
+      for (j = 0; j < len; j++)
+        if (apr_tolower(key[j]) != entry->key[j])
+          break;
+
+      if (j == len)
+        return entry->value;
+    }
+
+  return NULL;
+}
+
+/* Append an entry to LONG_KEYS for each entry of HASH whose key is longer
+   than MAX_STACK_KEY_LEN.  Use POOL for the iteration. */
+static void
+add_long_keys(apr_array_header_t *long_keys,
+              apr_hash_t *hash,
+              apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(pool, hash); hi; hi = apr_hash_next(hi))
+    {
+      const void *key;
+      apr_ssize_t klen;
+      void *value;
+      long_key_t *entry;
+
+      apr_hash_this(hi, &key, &klen, &value);
+      if (klen <= MAX_STACK_KEY_LEN)
+        continue;
+
+      entry = apr_array_push(long_keys);
+      entry->hash = hash;
+      entry->key = key;
+      entry->len = klen;
+      entry->value = value;
+    }
+}
+
+
 /* Return a pointer to an option in CFG, or NULL if it doesn't exist.
    if SECTIONP is non-null, return a pointer to the option's section.
    OPTION may be NULL. */
@@ -372,28 +487,16 @@ static cfg_option_t *
 find_option(svn_config_t *cfg, const char *section, const char *option,
             cfg_section_t **sectionp)
 {
-  void *sec_ptr;
+  void *sec_ptr = get_hash_value(cfg->sections, cfg, section);
 
-  /* Canonicalize the hash key */
-  svn_stringbuf_set(cfg->tmp_key, section);
-  make_hash_key(cfg->tmp_key->data);
-
-  sec_ptr = apr_hash_get(cfg->sections, cfg->tmp_key->data,
-                         cfg->tmp_key->len);
   if (sectionp != NULL)
     *sectionp = sec_ptr;
 
   if (sec_ptr != NULL && option != NULL)
     {
       cfg_section_t *sec = sec_ptr;
-      cfg_option_t *opt;
+      cfg_option_t *opt = get_hash_value(sec->options, cfg, option);
 
-      /* Canonicalize the option key */
-      svn_stringbuf_set(cfg->tmp_key, option);
-      make_hash_key(cfg->tmp_key->data);
-
-      opt = apr_hash_get(sec->options, cfg->tmp_key->data,
-                         cfg->tmp_key->len);
       /* NOTE: ConfigParser's sections are case sensitive. */
       if (opt == NULL
           && apr_strnatcasecmp(section, SVN_CONFIG__DEFAULT_SECTION) != 0)
@@ -551,6 +654,13 @@ svn_config_get(svn_config_t *cfg, const char **valuep,
         {
           make_string_from_option(valuep, cfg, sec, opt, NULL);
         }
+      else if (default_value == NULL
+               || cfg->read_only
+               || strstr(default_value, FMT_START) == NULL)
+        {
+          /* Nothing to expand, or we can't do it. */
+          *valuep = default_value;
+        }
       else
         {
           apr_pool_t *tmp_pool = svn_pool_create(cfg->x_pool);
@@ -582,6 +692,8 @@ svn_config_set(svn_config_t *cfg,
   cfg_section_t *sec;
   cfg_option_t *opt;
 
+  SVN_ERR_ASSERT_NO_RETURN(! cfg->read_only);
+
   remove_expansions(cfg);
 
   opt = find_option(cfg, section, option, &sec);
@@ -728,7 +840,8 @@ svn_config_enumerate_sections(svn_config_t *cfg,
 {
   apr_hash_index_t *sec_ndx;
   int count = 0;
-  apr_pool_t *subpool = svn_pool_create(cfg->x_pool);
+  /* Subpools of a read-only config's pools can't be created safely. */
+  apr_pool_t *subpool = svn_pool_create(cfg->read_only ? NULL : cfg->x_pool);
 
   for (sec_ndx = apr_hash_first(subpool, cfg->sections);
        sec_ndx != NULL;
@@ -793,7 +906,8 @@ svn_config_enumerate(svn_config_t *cfg, const char *section,
   if (sec == NULL)
     return 0;
 
-  subpool = svn_pool_create(cfg->x_pool);
+  /* Subpools of a read-only config's pools can't be created safely. */
+  subpool = svn_pool_create(cfg->read_only ? NULL : cfg->x_pool);
   count = 0;
   for (opt_ndx = apr_hash_first(subpool, sec->options);
        opt_ndx != NULL;
@@ -966,6 +1080,59 @@ svn_config_get_server_setting_bool(svn_config_t *cfg,
 }
 
 
+/* Expand the value of OPTION for good.  Implements the callback of
+   for_each_option(), with CFG as the baton. */
+static svn_boolean_t
+expand_callback(void *baton, cfg_section_t *section, cfg_option_t *option)
+{
+  const char *value;
+
+  make_string_from_option(&value, baton, section, option, NULL);
+  return FALSE;
+}
+
+void
+svn_config__set_read_only(svn_config_t *cfg,
+                          apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+
+  if (cfg->read_only)
+    return;
+
+  for_each_option(cfg, cfg, scratch_pool, expand_callback);
+
+  cfg->long_keys = apr_array_make(cfg->pool, 0, sizeof(long_key_t));
+  add_long_keys(cfg->long_keys, cfg->sections, scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, cfg->sections);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      cfg_section_t *sec = svn__apr_hash_index_val(hi);
+
+      add_long_keys(cfg->long_keys, sec->options, scratch_pool);
+    }
+
+  cfg->read_only = TRUE;
+}
+
+svn_boolean_t
+svn_config__is_read_only(svn_config_t *cfg)
+{
+  return cfg->read_only;
+}
+
+svn_config_t *
+svn_config__dup(svn_config_t *cfg,
+                apr_pool_t *result_pool)
+{
+  svn_config_t *dup = create_config(result_pool);
+
+  for_each_option(cfg, dup, result_pool, merge_callback);
+  return dup;
+}
+
+
 svn_boolean_t
 svn_config_has_section(svn_config_t *cfg, const char *section)
 {
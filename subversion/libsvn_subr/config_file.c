@@ -731,6 +731,13 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###   http-timeout               Timeout for HTTP requests in seconds"
                                                                              NL
         "###   http-compression           Whether to compress HTTP requests" NL
+        "###   http-max-connections       Maximum number of connections used"
+                                                                             NL
+        "###                              to fetch files in parallel (serf)" NL
+        "###   http-requests-per-connection"                                 NL
+        "###                              Number of outstanding requests"    NL
+        "###                              per connection before another one" NL
+        "###                              is opened (serf)"                  NL
         "###   neon-debug-mask            Debug mask for Neon HTTP library"  NL
 #ifdef SVN_NEON_0_26
         "###   http-auth-types            Auth types to use for HTTP library"NL
@@ -881,6 +888,8 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
 #ifdef SVN_NEON_0_26
         "# http-auth-types = basic;digest;negotiate"                         NL
 #endif
+        "# http-max-connections = 4"                                         NL
+        "# http-requests-per-connection = 8"                                 NL
         "# No http-timeout, so just use the builtin default."                NL
         "# No neon-debug-mask, so neon debugging is disabled."               NL
         "# ssl-authority-files = /path/to/CAcert.pem;/path/to/CAcert2.pem"   NL
@@ -1049,6 +1058,48 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### Set interactive-conflicts to 'no' to disable interactive"       NL
         "### conflict resolution prompting.  It defaults to 'yes'."          NL
         "# interactive-conflicts = no"                                       NL
+        "### Set mergeinfo-cache to 'yes' to keep the history of merge"      NL
+        "### sources and targets, which 'svn merge' and 'svn mergeinfo'"     NL
+        "### look up in the repository, in the 'mergeinfo-cache'"            NL
+        "### subdirectory of the runtime configuration area.  It defaults"   NL
+        "### to 'no'.  Clear that directory after a repository has been"     NL
+        "### loaded from a dump or had history obliterated."                 NL
+        "# mergeinfo-cache = yes"                                            NL
+        "### Set parallel-externals to the number of externals which"        NL
+        "### checkout, update and switch may fetch at the same time, each"   NL
+        "### over a connection of its own.  Notifications are still"         NL
+        "### printed one external after the other.  File externals and"      NL
+        "### externals nested in each other are always fetched one by one."  NL
+        "### It defaults to 1."                                              NL
+        "# parallel-externals = 4"                                           NL
+        ""                                                                   NL
+        "### Section for configuring working copy databases."                NL
+        "[working-copy]"                                                     NL
+        "### Set sqlite-enable-wal to 'yes' to switch the working copy"      NL
+        "### databases to SQLite's write-ahead log, so that a long 'svn"     NL
+        "### status' and an 'svn update' of the same working copy don't"     NL
+        "### block each other.  Working copies switched this way can only"   NL
+        "### be used with SQLite 3.7.0 or later, and not on network file"    NL
+        "### systems.  It defaults to 'no'."                                 NL
+        "# sqlite-enable-wal = yes"                                          NL
+        "### Set sqlite-cache-size to the size of the page cache of each"    NL
+        "### working copy database in kBytes.  It defaults to SQLite's"      NL
+        "### default."                                                       NL
+        "# sqlite-cache-size = 8192"                                         NL
+        "### Set sqlite-mmap-size to the number of kBytes of each working"   NL
+        "### copy database to read through a memory mapping (SQLite 3.7.17"  NL
+        "### or later).  It defaults to 0, for no memory mapping."           NL
+        "# sqlite-mmap-size = 65536"                                         NL
+        "### Set shared-pristine-directory to a directory in which working"  NL
+        "### copies share the pristine copies of their files.  A working"    NL
+        "### copy that fetches a file already in that directory links to"    NL
+        "### it instead of keeping a copy of its own, which saves disk"      NL
+        "### space when checking out many branches of the same repository."  NL
+        "### The directory must be on the same file system as the working"   NL
+        "### copies, and must only be writable by you.  Files in it with a"  NL
+        "### single link are no longer used by any working copy and may be"  NL
+        "### removed.  Hard links are not used on Windows."                  NL
+        "# shared-pristine-directory = /home/me/.svn-pristines"              NL
         ""                                                                   NL
         "### Section for configuring automatic properties."                  NL
         "[auto-props]"                                                       NL
@@ -63,6 +63,15 @@ struct svn_config_t
   /* Temporary value used for expanded default values in svn_config_get.
      (Using a stringbuf so that frequent resetting is efficient.) */
   svn_stringbuf_t *tmp_value;
+
+  /* Set by svn_config__set_read_only().  All values have been expanded,
+     and nothing in here may change anymore, not even the temporaries
+     above. */
+  svn_boolean_t read_only;
+
+  /* For a read-only config, the table entries whose keys are too long
+     to be canonicalized on the stack during lookups.  NULL otherwise. */
+  apr_array_header_t *long_keys;
 };
 
 
@@ -1198,6 +1198,24 @@ svn_relpath_join(const char *base,
   return path;
 }
 
+svn_boolean_t
+svn_relpath__is_joined(const char *relpath,
+                       const char *base,
+                       const char *component)
+{
+  apr_size_t blen = strlen(base);
+
+  /* If either is empty the join is the other */
+  if (blen == 0)
+    return strcmp(relpath, component) == 0;
+  if (*component == '\0')
+    return strcmp(relpath, base) == 0;
+
+  return (strncmp(relpath, base, blen) == 0
+          && relpath[blen] == '/'
+          && strcmp(relpath + blen + 1, component) == 0);
+}
+
 char *
 svn_uri_join(const char *base, const char *component, apr_pool_t *pool)
 {
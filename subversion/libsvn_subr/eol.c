@@ -28,10 +28,42 @@
 #include <apr_file_io.h>
 #include "svn_io.h"
 #include "private/svn_eol_private.h"
+#include "private/svn_string_private.h"
+
+/* Machine words with the same byte repeated in every position. */
+#define R_MASK          ((apr_uintptr_t)-1 / 0xff * '\r')
+#define N_MASK          ((apr_uintptr_t)-1 / 0xff * '\n')
 
 char *
 svn_eol__find_eol_start(char *buf, apr_size_t len)
 {
+  /* Get to a word boundary byte by byte ... */
+  for (; len > 0 && ((apr_uintptr_t)buf & (sizeof(apr_uintptr_t) - 1));
+       ++buf, --len)
+    {
+      if (*buf == '\n' || *buf == '\r')
+        return buf;
+    }
+
+  /* ... then skip whole words without any CR or LF in them.  A byte of
+   * R_TEST or N_TEST is zero exactly if the respective byte of the word is
+   * CR or LF; adding SVN__LOWER_7BITS_SET to the lower 7 bits sets bit 7
+   * of each byte that isn't, without carrying into the next byte. */
+  for (; len >= sizeof(apr_uintptr_t);
+       buf += sizeof(apr_uintptr_t), len -= sizeof(apr_uintptr_t))
+    {
+      apr_uintptr_t chunk = *(const apr_uintptr_t *)buf;
+      apr_uintptr_t r_test = chunk ^ R_MASK;
+      apr_uintptr_t n_test = chunk ^ N_MASK;
+
+      r_test |= (r_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+      n_test |= (n_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+
+      if ((r_test & n_test & SVN__BIT_7_SET) != SVN__BIT_7_SET)
+        break;
+    }
+
+  /* The word containing the eol, if any, and the tail. */
   for (; len > 0; ++buf, --len)
     {
       if (*buf == '\n' || *buf == '\r')
@@ -24,8 +24,10 @@
 
 
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
 #include <apr_version.h>
+#include <apr_strings.h>
 #include <apr_pools.h>
 #include <apr_hash.h>
 #include <apr_file_io.h>
@@ -90,6 +92,7 @@ hash_read(apr_hash_t *hash, svn_stream_t *stream, const char *terminator,
   svn_boolean_t eof;
   apr_size_t len, keylen, vallen;
   char c, *end, *keybuf, *valbuf;
+  svn_string_t *value;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
   while (1)
@@ -135,9 +138,13 @@ hash_read(apr_hash_t *hash, svn_stream_t *stream, const char *terminator,
               if (vallen == (size_t) ULONG_MAX || *end != '\0')
                 return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
 
-              valbuf = apr_palloc(iterpool, vallen + 1);
+              /* Read the value straight into its final place. */
+              value = apr_palloc(pool, sizeof(*value));
+              valbuf = apr_palloc(pool, vallen + 1);
               SVN_ERR(svn_stream_read(stream, valbuf, &vallen));
               valbuf[vallen] = '\0';
+              value->data = valbuf;
+              value->len = vallen;
 
               /* Suck up extra newline after val data */
               len = 1;
@@ -146,8 +153,7 @@ hash_read(apr_hash_t *hash, svn_stream_t *stream, const char *terminator,
                 return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
 
               /* Add a new hash entry. */
-              apr_hash_set(hash, keybuf, keylen,
-                           svn_string_ncreate(valbuf, vallen, pool));
+              apr_hash_set(hash, keybuf, keylen, value);
             }
           else
             return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
@@ -185,25 +191,61 @@ hash_read(apr_hash_t *hash, svn_stream_t *stream, const char *terminator,
 }
 
 
-/* Implements svn_hash_write2 and svn_hash_write_incremental. */
+/* The most a "K <len>\n" style line can take:  the prefix, up to 20
+   digits and the newline. */
+#define MAX_LENGTH_LINE_SIZE 23
+
+/* Append to BUF a line made of the character KIND, a space, LEN in
+   decimal and a newline, followed by the LEN bytes at DATA and another
+   newline. */
+static void
+append_entry(svn_stringbuf_t *buf, char kind, const char *data,
+             apr_size_t len)
+{
+  char line[MAX_LENGTH_LINE_SIZE + 1];
+  int line_len = apr_snprintf(line, sizeof(line), "%c %" APR_SIZE_T_FMT "\n",
+                              kind, len);
+
+  svn_stringbuf_appendbytes(buf, line, line_len);
+  svn_stringbuf_appendbytes(buf, data, len);
+  svn_stringbuf_appendbytes(buf, "\n", 1);
+}
+
+/* Implements svn_hash_write2 and svn_hash_write_incremental.  Format the
+   whole hash into a single buffer sized up front, and write that in one
+   go. */
 static svn_error_t *
 hash_write(apr_hash_t *hash, apr_hash_t *oldhash, svn_stream_t *stream,
            const char *terminator, apr_pool_t *pool)
 {
-  apr_pool_t *subpool;
   apr_size_t len;
-  apr_array_header_t *list;
+  apr_array_header_t *list, *oldlist = NULL;
+  svn_stringbuf_t *buf;
   int i;
 
-  subpool = svn_pool_create(pool);
-
   list = svn_sort__hash(hash, svn_sort_compare_items_lexically, pool);
+  if (oldhash)
+    oldlist = svn_sort__hash(oldhash, svn_sort_compare_items_lexically,
+                             pool);
+
+  /* Make room for everything we might write. */
+  len = terminator ? strlen(terminator) + 1 : 0;
   for (i = 0; i < list->nelts; i++)
     {
       svn_sort__item_t *item = &APR_ARRAY_IDX(list, i, svn_sort__item_t);
-      svn_string_t *valstr = item->value;
+      const svn_string_t *valstr = item->value;
 
-      svn_pool_clear(subpool);
+      len += item->klen + valstr->len + 2 * (MAX_LENGTH_LINE_SIZE + 1);
+    }
+  for (i = 0; oldlist && i < oldlist->nelts; i++)
+    len += APR_ARRAY_IDX(oldlist, i, svn_sort__item_t).klen
+           + MAX_LENGTH_LINE_SIZE + 1;
+  buf = svn_stringbuf_create_ensure(len, pool);
+
+  for (i = 0; i < list->nelts; i++)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(list, i, svn_sort__item_t);
+      svn_string_t *valstr = item->value;
 
       /* Don't output entries equal to the ones in oldhash, if present. */
       if (oldhash)
@@ -214,41 +256,27 @@ hash_write(apr_hash_t *hash, apr_hash_t *oldhash, svn_stream_t *stream,
             continue;
         }
 
-      /* Write it out. */
-      SVN_ERR(svn_stream_printf(stream, subpool,
-                                "K %" APR_SSIZE_T_FMT "\n%s\n"
-                                "V %" APR_SIZE_T_FMT "\n",
-                                item->klen, (const char *) item->key,
-                                valstr->len));
-      len = valstr->len;
-      SVN_ERR(svn_stream_write(stream, valstr->data, &len));
-      SVN_ERR(svn_stream_printf(stream, subpool, "\n"));
+      append_entry(buf, 'K', item->key, item->klen);
+      append_entry(buf, 'V', valstr->data, valstr->len);
     }
 
-  if (oldhash)
+  /* Output a deletion entry for each property in oldhash but not hash. */
+  for (i = 0; oldlist && i < oldlist->nelts; i++)
     {
-      /* Output a deletion entry for each property in oldhash but not hash. */
-      list = svn_sort__hash(oldhash, svn_sort_compare_items_lexically,
-                            pool);
-      for (i = 0; i < list->nelts; i++)
-        {
-          svn_sort__item_t *item = &APR_ARRAY_IDX(list, i, svn_sort__item_t);
-
-          svn_pool_clear(subpool);
+      svn_sort__item_t *item = &APR_ARRAY_IDX(oldlist, i, svn_sort__item_t);
 
-          /* If it's not present in the new hash, write out a D entry. */
-          if (! apr_hash_get(hash, item->key, item->klen))
-            SVN_ERR(svn_stream_printf(stream, subpool,
-                                      "D %" APR_SSIZE_T_FMT "\n%s\n",
-                                      item->klen, (const char *) item->key));
-        }
+      if (! apr_hash_get(hash, item->key, item->klen))
+        append_entry(buf, 'D', item->key, item->klen);
     }
 
   if (terminator)
-    SVN_ERR(svn_stream_printf(stream, subpool, "%s\n", terminator));
+    {
+      svn_stringbuf_appendcstr(buf, terminator);
+      svn_stringbuf_appendbytes(buf, "\n", 1);
+    }
 
-  svn_pool_destroy(subpool);
-  return SVN_NO_ERROR;
+  len = buf->len;
+  return svn_stream_write(stream, buf->data, &len);
 }
 
 
@@ -268,6 +296,71 @@ svn_error_t *svn_hash_read_incremental(apr_hash_t *hash,
 }
 
 
+/* Parse the length line "<KIND> <len>\n" at *P, of which END is the
+   bound, into *LEN, and the following LEN bytes of data and newline into
+   *DATA, replacing that newline by a NUL.  Advance *P past all of it.
+   Return a malformed file error if there is no such entry at *P. */
+static svn_error_t *
+parse_entry(char **data, apr_size_t *len, char kind, char **p,
+            const char *end)
+{
+  char *eol = memchr(*p, '\n', end - *p);
+  char *num_end;
+  unsigned long num;
+
+  if (eol == NULL || eol - *p < 3 || (*p)[0] != kind || (*p)[1] != ' ')
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+
+  num = strtoul(*p + 2, &num_end, 10);
+  if (num == ULONG_MAX || num_end != eol
+      || num >= (unsigned long)(end - (eol + 1)) || eol[1 + num] != '\n')
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+
+  *data = eol + 1;
+  *len = num;
+  (*data)[num] = '\0';
+  *p = *data + num + 1;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_hash__parse(apr_hash_t *hash,
+                svn_stringbuf_t *buf,
+                const char *terminator,
+                apr_pool_t *pool)
+{
+  char *p = buf->data;
+  const char *end = buf->data + buf->len;
+  apr_size_t term_len = terminator ? strlen(terminator) : 0;
+
+  while (1)
+    {
+      const char *eol = memchr(p, '\n', end - p);
+      apr_size_t line_len = (eol ? eol : end) - p;
+      char *key, *valdata;
+      apr_size_t keylen;
+      svn_string_t *value;
+
+      /* Check for the end of the hash, which may lack its newline. */
+      if ((!terminator && !eol && line_len == 0)
+          || (terminator && line_len == term_len
+              && memcmp(p, terminator, term_len) == 0))
+        break;
+
+      SVN_ERR(parse_entry(&key, &keylen, 'K', &p, end));
+
+      value = apr_palloc(pool, sizeof(*value));
+      SVN_ERR(parse_entry(&valdata, &value->len, 'V', &p, end));
+      value->data = valdata;
+
+      apr_hash_set(hash, key, keylen, value);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_hash_write2(apr_hash_t *hash, svn_stream_t *stream,
                 const char *terminator, apr_pool_t *pool)
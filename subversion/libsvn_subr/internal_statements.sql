@@ -23,3 +23,24 @@
 
 -- STMT_DUMMY_SELECT_FOR_BACKUP
 SELECT * FROM SQLITE_MASTER;
+
+-- STMT_INTERNAL_BEGIN_TRANSACTION
+BEGIN TRANSACTION;
+
+-- STMT_INTERNAL_COMMIT_TRANSACTION
+COMMIT TRANSACTION;
+
+-- STMT_INTERNAL_ROLLBACK_TRANSACTION
+ROLLBACK TRANSACTION;
+
+/* The savepoint statements need SQLite 3.6.8 or later.  Like all of these
+   statements, they are only prepared when they are used. */
+
+-- STMT_INTERNAL_SAVEPOINT_SVN
+SAVEPOINT svn;
+
+-- STMT_INTERNAL_RELEASE_SAVEPOINT_SVN
+RELEASE SAVEPOINT svn;
+
+-- STMT_INTERNAL_ROLLBACK_TO_SAVEPOINT_SVN
+ROLLBACK TO SAVEPOINT svn;
@@ -29,6 +29,17 @@
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>        /* for AT_SYMLINK_NOFOLLOW */
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>  /* for SYS_copy_file_range */
+#include <linux/fs.h>     /* for FICLONE */
+#endif
+
 #ifndef APR_STATUS_IS_EPERM
 #include <errno.h>
 #ifdef EPERM
@@ -561,6 +572,37 @@ svn_io_create_unique_link(const char **unique_name_p,
 #endif
 }
 
+svn_error_t *
+svn_io_create_hard_link(const char *path,
+                        const char *dest,
+                        apr_pool_t *pool)
+{
+#ifndef WIN32
+  const char *path_apr;
+  const char *dest_apr;
+  int rv;
+
+  SVN_ERR(cstring_from_utf8(&path_apr, path, pool));
+  SVN_ERR(cstring_from_utf8(&dest_apr, dest, pool));
+
+  do {
+    rv = link(dest_apr, path_apr);
+  } while (rv == -1 && APR_STATUS_IS_EINTR(apr_get_os_error()));
+
+  if (rv == -1)
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't create hard link '%s' to '%s'"),
+                              svn_dirent_local_style(path, pool),
+                              svn_dirent_local_style(dest, pool));
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Hard links are not supported on this "
+                            "platform"));
+#endif
+}
+
 svn_error_t *
 svn_io_read_link(svn_string_t **dest,
                  const char *path,
@@ -666,6 +708,108 @@ svn_io_temp_dir(const char **dir,
 
 /*** Creating, copying and appending files. ***/
 
+/* Make the empty TO_FILE share the contents of FROM_FILE through a
+ * copy-on-write clone, as offered by Btrfs and XFS on Linux.  This
+ * takes no time and no disk space until either file is modified.
+ *
+ * Return APR_ENOTIMPL if the platform or the file system doesn't support
+ * this, or the files are on different file systems, leaving TO_FILE
+ * unchanged.
+ */
+static apr_status_t
+clone_contents(apr_file_t *from_file,
+               apr_file_t *to_file)
+{
+#ifdef FICLONE
+  apr_os_file_t from_fd;
+  apr_os_file_t to_fd;
+
+  if (apr_os_file_get(&from_fd, from_file) == APR_SUCCESS
+      && apr_os_file_get(&to_fd, to_file) == APR_SUCCESS
+      && ioctl(to_fd, FICLONE, from_fd) == 0)
+    return APR_SUCCESS;
+#endif
+
+  return APR_ENOTIMPL;
+}
+
+/* The most we ask the kernel to copy in one go in kernel_copy_contents().
+ * Smaller requests let a copy of a huge file be interrupted sooner. */
+#define KERNEL_COPY_CHUNK_SIZE (64 * 1024 * 1024)
+
+/* Transfer the contents of FROM_FILE, from its current position, to the
+ * empty TO_FILE without passing them through our own buffers:  with
+ * copy_file_range(), which lets the file system copy server-side or share
+ * blocks where it can, or with sendfile() otherwise.  Both are available
+ * on Linux only.
+ *
+ * Return APR_ENOTIMPL if neither works for these files before anything
+ * was copied, leaving TO_FILE unchanged.
+ */
+static apr_status_t
+kernel_copy_contents(apr_file_t *from_file,
+                     apr_file_t *to_file)
+{
+#ifdef __linux__
+  apr_os_file_t from_fd;
+  apr_os_file_t to_fd;
+  svn_boolean_t copied = FALSE;
+#ifdef SYS_copy_file_range
+  svn_boolean_t use_copy_file_range = TRUE;
+#else
+  svn_boolean_t use_copy_file_range = FALSE;
+#endif
+
+  if (apr_os_file_get(&from_fd, from_file) != APR_SUCCESS
+      || apr_os_file_get(&to_fd, to_file) != APR_SUCCESS)
+    return APR_ENOTIMPL;
+
+  while (1)
+    {
+      ssize_t bytes_this_time;
+
+#ifdef SYS_copy_file_range
+      if (use_copy_file_range)
+        {
+          bytes_this_time = syscall(SYS_copy_file_range, from_fd, NULL,
+                                    to_fd, NULL, KERNEL_COPY_CHUNK_SIZE, 0);
+
+          /* Old kernels, and copies across file systems before Linux 5.3,
+             refuse; sendfile() may still do. */
+          if (bytes_this_time < 0 && ! copied
+              && (errno == ENOSYS || errno == EXDEV || errno == EINVAL
+                  || errno == EOPNOTSUPP))
+            {
+              use_copy_file_range = FALSE;
+              continue;
+            }
+        }
+      else
+#endif
+        bytes_this_time = sendfile(to_fd, from_fd, NULL,
+                                   KERNEL_COPY_CHUNK_SIZE);
+
+      if (bytes_this_time < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          if (! copied && (errno == ENOSYS || errno == EINVAL))
+            return APR_ENOTIMPL;
+
+          return APR_FROM_OS_ERROR(errno);
+        }
+
+      if (bytes_this_time == 0)
+        return APR_SUCCESS;
+
+      copied = TRUE;
+    }
+#else
+  return APR_ENOTIMPL;
+#endif
+}
+
 /* Transfer the contents of FROM_FILE to TO_FILE, using POOL for temporary
  * allocations.
  *
@@ -751,7 +895,13 @@ svn_io_copy_file(const char *src,
                                    svn_dirent_dirname(dst, pool),
                                    svn_io_file_del_none, pool, pool));
 
-  apr_err = copy_contents(from_file, to_file, pool);
+  /* Share the blocks of SRC if we can, and copy them if we can't:
+     in the kernel, or through our own buffer as a last resort. */
+  apr_err = clone_contents(from_file, to_file);
+  if (apr_err)
+    apr_err = kernel_copy_contents(from_file, to_file);
+  if (apr_err == APR_ENOTIMPL)
+    apr_err = copy_contents(from_file, to_file, pool);
 
   if (apr_err)
     {
@@ -1120,18 +1270,30 @@ svn_io_sleep_for_timestamps(const char *path, apr_pool_t *pool)
         {
           svn_error_clear(err); /* Fall back on original behavior */
         }
+      else if (finfo.mtime % 1000)
+        {
+          /* The filesystem reports mtimes finer than a millisecond, so
+             it keeps at least the microseconds that APR and the working
+             copy db use for timestamps.  A file changed from now on gets
+             a different timestamp than the ones we just recorded, as
+             soon as the clock has moved past them; that has happened
+             already unless we're within the very same microsecond. */
+          if (apr_time_now() <= finfo.mtime)
+            apr_sleep(1000);
+
+          return;
+        }
       else if (finfo.mtime % APR_USEC_PER_SEC)
         {
           /* Very simplistic but safe approach:
-              If the filesystem has < sec mtime we can be reasonably sure
-              that the filesystem has <= millisecond precision.
+              If the filesystem has < sec mtime (but none of the above
+              sub-millisecond digits) we can be reasonably sure that
+              the filesystem has millisecond precision.
 
-             ## Perhaps find a better algorithm here. This will fail once
-                in every 1000 cases on a millisecond precision filesystem.
-
-                But better to fail once in every thousand cases than every
-                time, like we did before.
-                (All tested filesystems I know have at least microsecond precision.)
+             ## This will fail once in every 1000 cases on a filesystem
+                with 10ms or coarser precision.  (Filesystems with
+                microsecond precision end up here once in every 1000
+                cases, which merely costs the millisecond below.)
 
              Note for further research on algorithm:
                FAT32 has < 1 sec precision on ctime, but 2 sec on mtime */
@@ -2023,19 +2185,153 @@ svn_io_get_dir_filenames(apr_hash_t **dirents,
   return SVN_NO_ERROR;
 }
 
+#ifdef __linux__
+/* Read the entries of the open directory DIR, whose path is PATH, into
+   DIRENTS like svn_io_get_dirents3() does.
+
+   apr_dir_read() builds the full path of each entry to stat it whenever
+   more than its type is wanted.  Here, the type comes from readdir()
+   where the file system provides it, and anything else from fstatat()
+   relative to DIR, without building paths. */
+static svn_error_t *
+read_dirents_at(apr_hash_t *dirents,
+                DIR *dir,
+                const char *path,
+                svn_boolean_t only_check_type,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  int dir_fd = dirfd(dir);
+
+  while (1)
+    {
+      struct dirent *entry;
+      struct stat st;
+      const char *name;
+      svn_io_dirent2_t *dirent;
+      int type;
+
+      errno = 0;
+      entry = readdir(dir);
+      if (entry == NULL)
+        {
+          if (errno)
+            return svn_error_wrap_apr(APR_FROM_OS_ERROR(errno),
+                                      _("Can't read directory '%s'"),
+                                      svn_dirent_local_style(path,
+                                                             scratch_pool));
+          break;
+        }
+
+      if ((entry->d_name[0] == '.')
+          && ((entry->d_name[1] == '\0')
+              || ((entry->d_name[1] == '.')
+                  && (entry->d_name[2] == '\0'))))
+        continue;
+
+      type = entry->d_type;
+      if (!only_check_type || type == DT_UNKNOWN)
+        {
+          if (fstatat(dir_fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+            {
+              /* Gone since we read the directory. */
+              if (errno == ENOENT)
+                continue;
+
+              return svn_error_wrap_apr(APR_FROM_OS_ERROR(errno),
+                                        _("Can't read directory '%s'"),
+                                        svn_dirent_local_style(path,
+                                                               scratch_pool));
+            }
+
+          if (S_ISREG(st.st_mode))
+            type = DT_REG;
+          else if (S_ISDIR(st.st_mode))
+            type = DT_DIR;
+          else if (S_ISLNK(st.st_mode))
+            type = DT_LNK;
+          else
+            type = DT_UNKNOWN;
+        }
+
+      dirent = apr_pcalloc(result_pool, sizeof(*dirent));
+      SVN_ERR(entry_name_to_utf8(&name, entry->d_name, path, result_pool));
+
+      /* As map_apr_finfo_to_node_kind(). */
+      if (type == DT_REG)
+        dirent->kind = svn_node_file;
+      else if (type == DT_DIR)
+        dirent->kind = svn_node_dir;
+      else if (type == DT_LNK)
+        {
+          dirent->kind = svn_node_file;
+          dirent->special = TRUE;
+        }
+      else
+        dirent->kind = svn_node_unknown;
+
+      if (!only_check_type)
+        {
+          dirent->filesize = st.st_size;
+          /* The same sub-second precision as apr_stat(). */
+          dirent->mtime = apr_time_make(st.st_mtim.tv_sec,
+                                        st.st_mtim.tv_nsec / 1000);
+        }
+
+      apr_hash_set(dirents, name, APR_HASH_KEY_STRING, dirent);
+    }
+
+  return SVN_NO_ERROR;
+}
+#endif
+
 svn_error_t *
-svn_io_get_dirents2(apr_hash_t **dirents,
+svn_io_get_dirents3(apr_hash_t **dirents,
                     const char *path,
-                    apr_pool_t *pool)
+                    svn_boolean_t only_check_type,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
 {
+#ifdef __linux__
+  const char *path_apr;
+  DIR *dir;
+  svn_error_t *err;
+
+  *dirents = apr_hash_make(result_pool);
+
+  /* opendir() doesn't like "" directories either */
+  if (path[0] == '\0')
+    path = ".";
+
+  SVN_ERR(cstring_from_utf8(&path_apr, path, scratch_pool));
+
+  dir = opendir(path_apr);
+  if (dir == NULL)
+    return svn_error_wrap_apr(APR_FROM_OS_ERROR(errno),
+                              _("Can't open directory '%s'"),
+                              svn_dirent_local_style(path, scratch_pool));
+
+  err = read_dirents_at(*dirents, dir, path, only_check_type,
+                        result_pool, scratch_pool);
+
+  if (closedir(dir) != 0 && !err)
+    return svn_error_wrap_apr(APR_FROM_OS_ERROR(errno),
+                              _("Error closing directory '%s'"),
+                              svn_dirent_local_style(path, scratch_pool));
+
+  return svn_error_return(err);
+#else
   apr_status_t status;
   apr_dir_t *this_dir;
   apr_finfo_t this_entry;
   apr_int32_t flags = APR_FINFO_TYPE | APR_FINFO_NAME;
 
-  *dirents = apr_hash_make(pool);
+  if (!only_check_type)
+    flags |= APR_FINFO_SIZE | APR_FINFO_MTIME;
 
-  SVN_ERR(svn_io_dir_open(&this_dir, path, pool));
+  *dirents = apr_hash_make(result_pool);
+
+  SVN_ERR(svn_io_dir_open(&this_dir, path, scratch_pool));
 
   for (status = apr_dir_read(&this_entry, flags, this_dir);
        status == APR_SUCCESS;
@@ -2051,28 +2347,48 @@ svn_io_get_dirents2(apr_hash_t **dirents,
       else
         {
           const char *name;
-          svn_io_dirent_t *dirent = apr_palloc(pool, sizeof(*dirent));
+          svn_io_dirent2_t *dirent = apr_pcalloc(result_pool,
+                                                 sizeof(*dirent));
 
-          SVN_ERR(entry_name_to_utf8(&name, this_entry.name, path, pool));
+          SVN_ERR(entry_name_to_utf8(&name, this_entry.name, path,
+                                     result_pool));
 
           map_apr_finfo_to_node_kind(&(dirent->kind),
                                      &(dirent->special),
                                      &this_entry);
 
+          if (!only_check_type)
+            {
+              dirent->filesize = this_entry.size;
+              dirent->mtime = this_entry.mtime;
+            }
+
           apr_hash_set(*dirents, name, APR_HASH_KEY_STRING, dirent);
         }
     }
 
   if (! (APR_STATUS_IS_ENOENT(status)))
     return svn_error_wrap_apr(status, _("Can't read directory '%s'"),
-                              svn_dirent_local_style(path, pool));
+                              svn_dirent_local_style(path, scratch_pool));
 
   status = apr_dir_close(this_dir);
   if (status)
     return svn_error_wrap_apr(status, _("Error closing directory '%s'"),
-                              svn_dirent_local_style(path, pool));
+                              svn_dirent_local_style(path, scratch_pool));
 
   return SVN_NO_ERROR;
+#endif
+}
+
+svn_error_t *
+svn_io_get_dirents2(apr_hash_t **dirents,
+                    const char *path,
+                    apr_pool_t *pool)
+{
+  /* The kind and special fields of svn_io_dirent2_t are laid out just
+     like those of svn_io_dirent_t, so this is portable for the same
+     reason as svn_io_get_dirents(). */
+  return svn_io_get_dirents3(dirents, path, TRUE, pool, pool);
 }
 
 svn_error_t *
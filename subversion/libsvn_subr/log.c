@@ -113,6 +113,22 @@ svn_log__get_dir(const char *path, svn_revnum_t rev,
                       want_props ? " props" : "");
 }
 
+const char *
+svn_log__list(const char *path, svn_revnum_t rev, svn_depth_t depth,
+              apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "list %s r%ld%s",
+                      svn_path_uri_encode(path, pool), rev,
+                      log_depth(depth, pool));
+}
+
+const char *
+svn_log__get_archive(const char *path, svn_revnum_t rev, apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "get-archive %s r%ld",
+                      svn_path_uri_encode(path, pool), rev);
+}
+
 const char *
 svn_log__get_mergeinfo(const apr_array_header_t *paths,
                        svn_mergeinfo_inheritance_t inherit,
@@ -305,6 +321,14 @@ svn_log__get_file_revs(const char *path, svn_revnum_t start, svn_revnum_t end,
                       log_include_merged_revisions(include_merged_revisions));
 }
 
+const char *
+svn_log__get_file_blame(const char *path, svn_revnum_t start,
+                        svn_revnum_t end, apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "get-file-blame %s r%ld:%ld",
+                      svn_path_uri_encode(path, pool), start, end);
+}
+
 const char *
 svn_log__lock(const apr_array_header_t *paths,
               svn_boolean_t steal, apr_pool_t *pool)
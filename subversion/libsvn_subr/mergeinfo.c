@@ -22,6 +22,7 @@
  */
 #include <assert.h>
 #include <ctype.h>
+#include <string.h>
 
 #include "svn_path.h"
 #include "svn_types.h"
@@ -33,6 +34,7 @@
 #include "svn_string.h"
 #include "svn_mergeinfo.h"
 #include "private/svn_mergeinfo_private.h"
+#include "private/svn_string_private.h"
 #include "svn_private_config.h"
 #include "svn_hash.h"
 
@@ -254,12 +256,14 @@ combine_with_lastrange(const svn_merge_range_t *new_range,
 {
   svn_merge_range_t *lastrange;
   svn_merge_range_t combined_range;
+  int lastrange_idx;
 
   /* We don't accept a NULL RANGELIST. */
   SVN_ERR_ASSERT(rangelist);
 
-  if (rangelist->nelts > 0)
-    lastrange = APR_ARRAY_IDX(rangelist, rangelist->nelts - 1, svn_merge_range_t *);
+  lastrange_idx = rangelist->nelts - 1;
+  if (lastrange_idx >= 0)
+    lastrange = APR_ARRAY_IDX(rangelist, lastrange_idx, svn_merge_range_t *);
   else
     lastrange = NULL;
 
@@ -431,8 +435,11 @@ combine_with_lastrange(const svn_merge_range_t *new_range,
                 }
 
               /* Some of the above cases might have put *RANGELIST out of
-                 order, so re-sort.*/
-              qsort(rangelist->elts, rangelist->nelts, rangelist->elt_size,
+                 order, so re-sort.  Only the (at most three) ranges that
+                 replaced *LASTRANGE can be affected, the ranges before it
+                 don't intersect NEW_RANGE. */
+              qsort(rangelist->elts + lastrange_idx * rangelist->elt_size,
+                    rangelist->nelts - lastrange_idx, rangelist->elt_size,
                     svn_sort_compare_ranges);
         }
     }
@@ -705,13 +712,84 @@ svn_mergeinfo_parse(svn_mergeinfo_t *mergeinfo,
 }
 
 
+svn_error_t *
+svn_mergeinfo__parse_path(apr_array_header_t **rangelist,
+                          const char *input,
+                          const char *path,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  const char *end = input + strlen(input);
+  const char *curr = input;
+  apr_size_t path_len;
+  svn_mergeinfo_t mergeinfo = apr_hash_make(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* Like parse_pathname(), ignore the leading slash, which relative
+     paths lack. */
+  if (*path == '/')
+    path++;
+  path_len = strlen(path);
+
+  while (curr < end && !err)
+    {
+      const char *line_end = memchr(curr, '\n', end - curr);
+      const char *line_path = (*curr == '/') ? curr + 1 : curr;
+      const char *last_colon = NULL;
+      const char *p;
+
+      if (!line_end)
+        line_end = end;
+
+      /* A pathname may contain colons, see parse_pathname(). */
+      for (p = curr; p < line_end; p++)
+        if (*p == ':')
+          last_colon = p;
+
+      /* Only parse the lines for PATH. */
+      if (last_colon && line_path <= last_colon
+          && (apr_size_t)(last_colon - line_path) == path_len
+          && memcmp(line_path, path, path_len) == 0)
+        {
+          const char *line = curr;
+
+          err = parse_revision_line(&line, end, mergeinfo, scratch_pool);
+        }
+
+      curr = (line_end < end) ? line_end + 1 : end;
+    }
+
+  /* Always return SVN_ERR_MERGEINFO_PARSE_ERROR as the topmost error. */
+  if (err && err->apr_err != SVN_ERR_MERGEINFO_PARSE_ERROR)
+    err = svn_error_createf(SVN_ERR_MERGEINFO_PARSE_ERROR, err,
+                            _("Could not parse mergeinfo string '%s'"),
+                            input);
+  SVN_ERR(err);
+
+  /* Any lines found were all for the same absolute path. */
+  if (apr_hash_count(mergeinfo))
+    *rangelist = svn_rangelist_dup(
+      svn__apr_hash_index_val(apr_hash_first(scratch_pool, mergeinfo)),
+      result_pool);
+  else
+    *rangelist = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_rangelist_merge(apr_array_header_t **rangelist,
                     const apr_array_header_t *changes,
                     apr_pool_t *pool)
 {
   int i, j;
-  apr_array_header_t *output = apr_array_make(pool, 1,
+  /* Merging only yields more ranges than the inputs have together if
+     ranges of differing inheritability overlap, so OUTPUT rarely needs
+     to grow. */
+  apr_array_header_t *output = apr_array_make(pool,
+                                              (*rangelist)->nelts
+                                              + changes->nelts,
                                               sizeof(svn_merge_range_t *));
   i = 0;
   j = 0;
@@ -922,7 +1000,10 @@ rangelist_intersect_or_remove(apr_array_header_t **output,
   int i1, i2, lasti2;
   svn_merge_range_t working_elt2;
 
-  *output = apr_array_make(pool, 1, sizeof(svn_merge_range_t *));
+  /* Neither the intersection nor the difference can have more ranges than
+     both rangelists together, so *OUTPUT never needs to grow. */
+  *output = apr_array_make(pool, rangelist1->nelts + rangelist2->nelts,
+                           sizeof(svn_merge_range_t *));
 
   i1 = 0;
   i2 = 0;
@@ -1292,54 +1373,31 @@ svn_error_t *
 svn_mergeinfo_merge(svn_mergeinfo_t mergeinfo, svn_mergeinfo_t changes,
                     apr_pool_t *pool)
 {
-  apr_array_header_t *sorted1, *sorted2;
-  int i, j;
-
-  sorted1 = svn_sort__hash(mergeinfo, svn_sort_compare_items_as_paths, pool);
-  sorted2 = svn_sort__hash(changes, svn_sort_compare_items_as_paths, pool);
+  apr_hash_index_t *hi;
 
-  i = 0;
-  j = 0;
-  while (i < sorted1->nelts && j < sorted2->nelts)
+  /* Only the paths in both hashes need merging, so there is no need to
+     put either hash in order. */
+  for (hi = apr_hash_first(pool, changes); hi; hi = apr_hash_next(hi))
     {
-      svn_sort__item_t elt1, elt2;
-      int res;
-
-      elt1 = APR_ARRAY_IDX(sorted1, i, svn_sort__item_t);
-      elt2 = APR_ARRAY_IDX(sorted2, j, svn_sort__item_t);
-      res = svn_sort_compare_items_as_paths(&elt1, &elt2);
-
-      if (res == 0)
-        {
-          apr_array_header_t *rl1, *rl2;
+      const void *key;
+      apr_ssize_t klen;
+      void *value;
+      apr_array_header_t *rangelist;
 
-          rl1 = elt1.value;
-          rl2 = elt2.value;
+      apr_hash_this(hi, &key, &klen, &value);
+      rangelist = apr_hash_get(mergeinfo, key, klen);
 
-          SVN_ERR(svn_rangelist_merge(&rl1, rl2,
-                                      pool));
-          apr_hash_set(mergeinfo, elt1.key, elt1.klen, rl1);
-          i++;
-          j++;
-        }
-      else if (res < 0)
+      if (rangelist)
         {
-          i++;
+          SVN_ERR(svn_rangelist_merge(&rangelist, value, pool));
+          apr_hash_set(mergeinfo, key, klen, rangelist);
         }
       else
         {
-          apr_hash_set(mergeinfo, elt2.key, elt2.klen, elt2.value);
-          j++;
+          apr_hash_set(mergeinfo, key, klen, value);
         }
     }
 
-  /* Copy back any remaining elements from the second hash. */
-  for (; j < sorted2->nelts; j++)
-    {
-      svn_sort__item_t elt = APR_ARRAY_IDX(sorted2, j, svn_sort__item_t);
-      apr_hash_set(mergeinfo, elt.key, elt.klen, elt.value);
-    }
-
   return SVN_NO_ERROR;
 }
 
@@ -1439,7 +1497,7 @@ svn_rangelist_to_string(svn_string_t **output,
       svn_stringbuf_appendcstr(buf, range_to_string(range, pool));
     }
 
-  *output = svn_string_create_from_buf(buf, pool);
+  *output = svn_stringbuf__morph_into_string(buf);
 
   return SVN_NO_ERROR;
 }
@@ -1493,7 +1551,7 @@ svn_mergeinfo_to_string(svn_string_t **output, svn_mergeinfo_t input,
     {
       svn_stringbuf_t *mergeinfo_buf;
       SVN_ERR(mergeinfo_to_stringbuf(&mergeinfo_buf, input, NULL, pool));
-      *output = svn_string_create_from_buf(mergeinfo_buf, pool);
+      *output = svn_stringbuf__morph_into_string(mergeinfo_buf);
     }
   else
     {
@@ -1783,13 +1841,15 @@ svn_rangelist_dup(const apr_array_header_t *rangelist, apr_pool_t *pool)
 {
   apr_array_header_t *new_rl = apr_array_make(pool, rangelist->nelts,
                                               sizeof(svn_merge_range_t *));
+  /* Allocate all the ranges in one go. */
+  svn_merge_range_t *copies = apr_palloc(pool, rangelist->nelts
+                                               * sizeof(*copies));
   int i;
 
   for (i = 0; i < rangelist->nelts; i++)
     {
-      APR_ARRAY_PUSH(new_rl, svn_merge_range_t *) =
-        svn_merge_range_dup(APR_ARRAY_IDX(rangelist, i, svn_merge_range_t *),
-                            pool);
+      copies[i] = *APR_ARRAY_IDX(rangelist, i, svn_merge_range_t *);
+      APR_ARRAY_PUSH(new_rl, svn_merge_range_t *) = &copies[i];
     }
 
   return new_rl;
@@ -1869,7 +1929,7 @@ svn_mergeinfo__catalog_to_formatted_string(svn_string_t **output,
      otherwise, return a new string containing only a newline
      character.  */
   if (output_buf)
-    *output = svn_string_create_from_buf(output_buf, pool);
+    *output = svn_stringbuf__morph_into_string(output_buf);
   else
     *output = svn_string_create("\n", pool);
 
@@ -1903,7 +1963,7 @@ svn_mergeinfo__to_formatted_string(svn_string_t **output,
     }
 #endif
 
-  *output = output_buf ? svn_string_create_from_buf(output_buf, pool)
+  *output = output_buf ? svn_stringbuf__morph_into_string(output_buf)
                        : svn_string_create("", pool);
   return SVN_NO_ERROR;
 }
@@ -2061,7 +2121,9 @@ svn_mergeinfo__string_has_noninheritable(svn_boolean_t *is_noninheritable,
 {
   *is_noninheritable = FALSE;
 
-  if (mergeinfo_str)
+  /* Non-inheritable ranges are marked with a '*', so there is nothing to
+     parse without one. */
+  if (mergeinfo_str && strchr(mergeinfo_str, '*'))
     {
       svn_mergeinfo_t mergeinfo;
 
@@ -0,0 +1,332 @@
+/* pipeline.c : process queued items in order on a separate thread
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <assert.h>
+
+#include <apr_pools.h>
+
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
+
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "private/svn_pipeline.h"
+
+#if APR_HAS_THREADS
+
+struct svn_pipeline__t
+{
+  /* Item number N, counting from 0, lives in ITEMS[N % SLOTS] and is
+     allocated in SLOT_POOLS[N % SLOTS].  QUEUED items have been queued
+     so far and PROCESSED of them have been processed.  The slots of the
+     last KEEP processed items are not handed out again. */
+  int slots;
+  int keep;
+  void **items;
+  apr_pool_t **slot_pools;
+  apr_uint64_t queued;
+  apr_uint64_t processed;
+
+  /* The function processing the items on the worker thread and its
+     baton. */
+  svn_pipeline__process_t process;
+  void *baton;
+
+  /* The error processing an item failed with, if any.  The worker
+     thread stops at the first error. */
+  svn_error_t *err;
+
+  /* Access to QUEUED, PROCESSED, ERR and SHUTDOWN is serialized by MUTEX
+     and COND gets signalled whenever any of them changes. */
+  svn_boolean_t shutdown;
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* Pools and their allocators must not be shared between threads, so
+     the slot pools and THREAD_POOL, the scratch pool of the worker
+     thread, are root pools.  POOL holds the structure itself, its
+     mutex, condition and thread.  OWNER_POOL is the pool whose cleanup
+     closes the pipeline. */
+  apr_pool_t *thread_pool;
+  apr_pool_t *pool;
+  apr_pool_t *owner_pool;
+  apr_thread_t *thread;
+};
+
+/* Thread function processing the items queued on DATA, a
+   svn_pipeline__t, in order until told to shut down or until
+   processing an item fails. */
+static void * APR_THREAD_FUNC
+pipeline_thread(apr_thread_t *thread, void *data)
+{
+  svn_pipeline__t *pl = data;
+
+  while (TRUE)
+    {
+      void *item;
+      svn_error_t *err;
+
+      apr_thread_mutex_lock(pl->mutex);
+      while (! pl->shutdown && pl->processed == pl->queued)
+        apr_thread_cond_wait(pl->cond, pl->mutex);
+      if (pl->shutdown)
+        {
+          apr_thread_mutex_unlock(pl->mutex);
+          break;
+        }
+      item = pl->items[pl->processed % pl->slots];
+      apr_thread_mutex_unlock(pl->mutex);
+
+      svn_pool_clear(pl->thread_pool);
+      err = pl->process(pl->baton, item, pl->thread_pool);
+
+      apr_thread_mutex_lock(pl->mutex);
+      if (err)
+        pl->err = err;
+      else
+        pl->processed++;
+      apr_thread_cond_broadcast(pl->cond);
+      apr_thread_mutex_unlock(pl->mutex);
+
+      if (err)
+        break;
+    }
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Stop the worker thread of PL, if it is still running, after the item
+   it is processing, if any. */
+static void
+stop_thread(svn_pipeline__t *pl)
+{
+  apr_status_t retval;
+
+  if (! pl->thread)
+    return;
+
+  apr_thread_mutex_lock(pl->mutex);
+  pl->shutdown = TRUE;
+  apr_thread_cond_broadcast(pl->cond);
+  apr_thread_mutex_unlock(pl->mutex);
+  apr_thread_join(&retval, pl->thread);
+  pl->thread = NULL;
+}
+
+/* Pool cleanup stopping the worker thread of BATON, a svn_pipeline__t,
+   and destroying the pipeline along with its slot pools. */
+static apr_status_t
+cleanup_pipeline(void *baton)
+{
+  svn_pipeline__t *pl = baton;
+  int i;
+
+  stop_thread(pl);
+  svn_error_clear(pl->err);
+
+  for (i = 0; i < pl->slots; i++)
+    svn_pool_destroy(pl->slot_pools[i]);
+  svn_pool_destroy(pl->thread_pool);
+  svn_pool_destroy(pl->pool);
+
+  return APR_SUCCESS;
+}
+
+svn_pipeline__t *
+svn_pipeline__start(int slots,
+                    int keep,
+                    svn_pipeline__process_t process,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  apr_pool_t *pipeline_pool;
+  svn_pipeline__t *pl;
+  int i;
+
+  assert(keep >= 0 && slots > keep);
+
+  pipeline_pool = svn_pool_create(NULL);
+  pl = apr_pcalloc(pipeline_pool, sizeof(*pl));
+
+  if (apr_thread_mutex_create(&pl->mutex, APR_THREAD_MUTEX_DEFAULT,
+                              pipeline_pool)
+      || apr_thread_cond_create(&pl->cond, pipeline_pool))
+    {
+      svn_pool_destroy(pipeline_pool);
+      return NULL;
+    }
+
+  pl->slots = slots;
+  pl->keep = keep;
+  pl->items = apr_pcalloc(pipeline_pool, slots * sizeof(*pl->items));
+  pl->slot_pools = apr_palloc(pipeline_pool,
+                              slots * sizeof(*pl->slot_pools));
+  for (i = 0; i < slots; i++)
+    pl->slot_pools[i] = svn_pool_create(NULL);
+  pl->process = process;
+  pl->baton = baton;
+  pl->thread_pool = svn_pool_create(NULL);
+  pl->pool = pipeline_pool;
+  pl->owner_pool = pool;
+
+  if (apr_thread_create(&pl->thread, NULL, pipeline_thread, pl,
+                        pipeline_pool))
+    {
+      pl->thread = NULL;
+      cleanup_pipeline(pl);
+      return NULL;
+    }
+
+  apr_pool_cleanup_register(pool, pl, cleanup_pipeline,
+                            apr_pool_cleanup_null);
+  return pl;
+}
+
+svn_error_t *
+svn_pipeline__next_slot(apr_pool_t **slot_pool,
+                        svn_pipeline__t *pipeline)
+{
+  svn_error_t *err;
+
+  apr_thread_mutex_lock(pipeline->mutex);
+  while (! pipeline->err
+         && pipeline->queued - pipeline->processed
+              >= (apr_uint64_t)(pipeline->slots - pipeline->keep))
+    apr_thread_cond_wait(pipeline->cond, pipeline->mutex);
+  err = svn_error_dup(pipeline->err);
+  apr_thread_mutex_unlock(pipeline->mutex);
+
+  SVN_ERR(err);
+
+  *slot_pool = pipeline->slot_pools[pipeline->queued % pipeline->slots];
+  svn_pool_clear(*slot_pool);
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_pipeline__queue(svn_pipeline__t *pipeline,
+                    void *item)
+{
+  apr_thread_mutex_lock(pipeline->mutex);
+  pipeline->items[pipeline->queued % pipeline->slots] = item;
+  pipeline->queued++;
+  apr_thread_cond_broadcast(pipeline->cond);
+  apr_thread_mutex_unlock(pipeline->mutex);
+}
+
+svn_error_t *
+svn_pipeline__wait(void **item,
+                   svn_pipeline__t *pipeline,
+                   apr_uint64_t n)
+{
+  svn_error_t *err;
+
+  apr_thread_mutex_lock(pipeline->mutex);
+  while (! pipeline->err && pipeline->processed <= n)
+    apr_thread_cond_wait(pipeline->cond, pipeline->mutex);
+  err = svn_error_dup(pipeline->err);
+  apr_thread_mutex_unlock(pipeline->mutex);
+
+  SVN_ERR(err);
+
+  *item = pipeline->items[n % pipeline->slots];
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_pipeline__finish(svn_pipeline__t *pipeline)
+{
+  svn_error_t *err;
+
+  apr_thread_mutex_lock(pipeline->mutex);
+  while (! pipeline->err && pipeline->processed < pipeline->queued)
+    apr_thread_cond_wait(pipeline->cond, pipeline->mutex);
+  apr_thread_mutex_unlock(pipeline->mutex);
+
+  stop_thread(pipeline);
+
+  err = pipeline->err;
+  pipeline->err = NULL;
+  return svn_error_return(err);
+}
+
+void
+svn_pipeline__close(svn_pipeline__t *pipeline)
+{
+  apr_pool_cleanup_run(pipeline->owner_pool, pipeline, cleanup_pipeline);
+}
+
+#else /* ! APR_HAS_THREADS */
+
+/* Without threads, svn_pipeline__start() never returns a pipeline the
+   other functions could be called with. */
+
+svn_pipeline__t *
+svn_pipeline__start(int slots,
+                    int keep,
+                    svn_pipeline__process_t process,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  return NULL;
+}
+
+svn_error_t *
+svn_pipeline__next_slot(apr_pool_t **slot_pool,
+                        svn_pipeline__t *pipeline)
+{
+  SVN_ERR_MALFUNCTION();
+}
+
+void
+svn_pipeline__queue(svn_pipeline__t *pipeline,
+                    void *item)
+{
+  SVN_ERR_MALFUNCTION_NO_RETURN();
+}
+
+svn_error_t *
+svn_pipeline__wait(void **item,
+                   svn_pipeline__t *pipeline,
+                   apr_uint64_t n)
+{
+  SVN_ERR_MALFUNCTION();
+}
+
+svn_error_t *
+svn_pipeline__finish(svn_pipeline__t *pipeline)
+{
+  SVN_ERR_MALFUNCTION();
+}
+
+void
+svn_pipeline__close(svn_pipeline__t *pipeline)
+{
+  SVN_ERR_MALFUNCTION_NO_RETURN();
+}
+
+#endif /* APR_HAS_THREADS */
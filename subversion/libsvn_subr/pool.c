@@ -31,6 +31,16 @@
 
 #include "svn_pools.h"
 
+#ifdef SVN_POOL_PROFILE
+#include <signal.h>
+#include <string.h>
+#include <apr_time.h>
+#include <apr_thread_mutex.h>
+
+#include "svn_types.h"
+#include "private/svn_atomic.h"
+#endif /* SVN_POOL_PROFILE */
+
 
 #if APR_POOL_DEBUG
 /* file_line for the non-debug case. */
@@ -55,6 +65,333 @@ abort_on_pool_failure(int retcode)
 }
 
 
+
+/*** Pool profiling. ***/
+
+#ifdef SVN_POOL_PROFILE
+
+/* Statistics about all the pools created at one place in the code.  A
+   pool's life, as far as these are concerned, ends when it is cleared
+   or destroyed; a cleared pool starts a new life. */
+typedef struct pool_site_t
+{
+  const char *file_line;
+  struct pool_site_t *next;     /* in the same bucket of SITES */
+
+  apr_uint64_t created;         /* pools created here */
+  apr_uint64_t lives;           /* lives ended, by clearing or destroying */
+  apr_uint64_t live;            /* pools currently alive */
+  apr_uint64_t peak_live;       /* the most pools alive at once */
+  apr_interval_time_t total_lifetime;   /* of the ended lives */
+  apr_interval_time_t max_lifetime;
+#if APR_POOL_DEBUG
+  apr_uint64_t total_bytes;     /* allocated during the ended lives */
+  apr_size_t peak_bytes;        /* the most used during any one life */
+#endif
+} pool_site_t;
+
+/* Attached to each pool while it is profiled. */
+typedef struct pool_life_t
+{
+  pool_site_t *site;
+  apr_pool_t *pool;
+  apr_time_t born;
+} pool_life_t;
+
+/* Pool userdata key for the current pool_life_t. */
+#define POOL_LIFE_KEY "svn-pool-profile-life"
+
+/* The pool sites, hashed by their file_line. */
+#define SITE_BUCKETS 4096
+static pool_site_t *sites[SITE_BUCKETS];
+
+static volatile svn_atomic_t profile_init_state = 0;
+#if APR_HAS_THREADS
+static apr_thread_mutex_t *profile_mutex = NULL;
+#endif
+
+/* Set from a signal handler to ask for a report at the next chance. */
+static volatile sig_atomic_t report_requested = 0;
+
+static void
+lock_profile(void)
+{
+#if APR_HAS_THREADS
+  if (profile_mutex)
+    apr_thread_mutex_lock(profile_mutex);
+#endif
+}
+
+static void
+unlock_profile(void)
+{
+#if APR_HAS_THREADS
+  if (profile_mutex)
+    apr_thread_mutex_unlock(profile_mutex);
+#endif
+}
+
+/* qsort() comparison putting the most memory hungry sites first:  by
+   peak bytes where we know them, or else by the most pools alive. */
+static int
+compare_sites(const void *a, const void *b)
+{
+  const pool_site_t *site_a = *(const pool_site_t * const *)a;
+  const pool_site_t *site_b = *(const pool_site_t * const *)b;
+
+#if APR_POOL_DEBUG
+  if (site_a->peak_bytes != site_b->peak_bytes)
+    return site_a->peak_bytes < site_b->peak_bytes ? 1 : -1;
+#endif
+  if (site_a->peak_live != site_b->peak_live)
+    return site_a->peak_live < site_b->peak_live ? 1 : -1;
+  return strcmp(site_a->file_line, site_b->file_line);
+}
+
+void
+svn_pool__profile_report(void)
+{
+  pool_site_t **list;
+  pool_site_t *site;
+  apr_size_t count = 0;
+  apr_size_t i;
+
+  lock_profile();
+
+  for (i = 0; i < SITE_BUCKETS; i++)
+    for (site = sites[i]; site; site = site->next)
+      count++;
+
+  list = malloc(count * sizeof(*list) + 1);
+  if (list == NULL)
+    {
+      unlock_profile();
+      return;
+    }
+
+  count = 0;
+  for (i = 0; i < SITE_BUCKETS; i++)
+    for (site = sites[i]; site; site = site->next)
+      list[count++] = site;
+  qsort(list, count, sizeof(*list), compare_sites);
+
+  fprintf(stderr, "Subversion pool profile, by creation site:\n"
+#if APR_POOL_DEBUG
+          "%12s %12s "
+#endif
+          "%10s %10s %10s %10s %12s %12s  %s\n",
+#if APR_POOL_DEBUG
+          "peak bytes", "total bytes",
+#endif
+          "created", "lives", "live", "peak live",
+          "avg usec", "max usec", "site");
+
+  for (i = 0; i < count; i++)
+    {
+      site = list[i];
+      fprintf(stderr,
+#if APR_POOL_DEBUG
+              "%12" APR_SIZE_T_FMT " %12" APR_UINT64_T_FMT " "
+#endif
+              "%10" APR_UINT64_T_FMT " %10" APR_UINT64_T_FMT
+              " %10" APR_UINT64_T_FMT " %10" APR_UINT64_T_FMT
+              " %12" APR_INT64_T_FMT " %12" APR_INT64_T_FMT "  %s\n",
+#if APR_POOL_DEBUG
+              site->peak_bytes, site->total_bytes,
+#endif
+              site->created, site->lives, site->live, site->peak_live,
+              (apr_int64_t)(site->lives
+                              ? site->total_lifetime / site->lives : 0),
+              (apr_int64_t)site->max_lifetime,
+              site->file_line);
+    }
+  fflush(stderr);
+
+  unlock_profile();
+  free(list);
+}
+
+
+#ifdef SIGUSR2
+static void
+request_report(int signum)
+{
+  report_requested = 1;
+}
+#endif
+
+#if APR_HAS_THREADS
+static apr_status_t
+forget_profile_mutex(void *data)
+{
+  profile_mutex = NULL;
+  return APR_SUCCESS;
+}
+#endif
+
+/* Set up the profiling state the first time it is needed.  This can't
+   use svn_atomic__init_once(), which creates errors and thus pools. */
+static void
+init_profile(void)
+{
+  svn_atomic_t status = svn_atomic_cas(&profile_init_state, 1, 0);
+
+  if (status == 0)
+    {
+#if APR_HAS_THREADS
+      apr_pool_t *mutex_pool;
+
+      /* The report at exit may come after apr_terminate(). */
+      if (apr_pool_create(&mutex_pool, NULL) == APR_SUCCESS
+          && apr_thread_mutex_create(&profile_mutex,
+                                     APR_THREAD_MUTEX_DEFAULT,
+                                     mutex_pool) == APR_SUCCESS)
+        apr_pool_cleanup_register(mutex_pool, NULL, forget_profile_mutex,
+                                  apr_pool_cleanup_null);
+#endif
+      atexit(svn_pool__profile_report);
+
+#ifdef SIGUSR2
+      /* Report on SIGUSR2, unless the application uses it itself. */
+      {
+        void (*previous)(int) = signal(SIGUSR2, request_report);
+
+        if (previous != SIG_DFL && previous != SIG_ERR)
+          signal(SIGUSR2, previous);
+      }
+#endif
+
+      svn_atomic_cas(&profile_init_state, 2, 1);
+    }
+  else
+    {
+      while (status != 2)
+        {
+          apr_sleep(APR_USEC_PER_SEC / 1000);
+          status = svn_atomic_cas(&profile_init_state, 2, 2);
+        }
+    }
+}
+
+/* Return the site for FILE_LINE, creating it if necessary.  The caller
+   must hold the profile lock. */
+static pool_site_t *
+get_site(const char *file_line)
+{
+  apr_uint32_t hash = 5381;
+  const char *p;
+  pool_site_t *site;
+
+  for (p = file_line; *p; p++)
+    hash = hash * 33 + (unsigned char)*p;
+
+  for (site = sites[hash % SITE_BUCKETS]; site; site = site->next)
+    if (site->file_line == file_line || strcmp(site->file_line, file_line) == 0)
+      return site;
+
+  site = calloc(1, sizeof(*site));
+  if (site == NULL)
+    abort_on_pool_failure(APR_ENOMEM);
+  site->file_line = file_line;
+  site->next = sites[hash % SITE_BUCKETS];
+  sites[hash % SITE_BUCKETS] = site;
+
+  return site;
+}
+
+/* Pool cleanup ending the pool_life_t DATA. */
+static apr_status_t
+end_pool_life(void *data)
+{
+  pool_life_t *life = data;
+  pool_site_t *site = life->site;
+  apr_interval_time_t lifetime = apr_time_now() - life->born;
+#if APR_POOL_DEBUG
+  apr_size_t bytes = apr_pool_num_bytes(life->pool, FALSE);
+#endif
+
+  lock_profile();
+  site->lives++;
+  site->live--;
+  site->total_lifetime += lifetime;
+  if (lifetime > site->max_lifetime)
+    site->max_lifetime = lifetime;
+#if APR_POOL_DEBUG
+  site->total_bytes += bytes;
+  if (bytes > site->peak_bytes)
+    site->peak_bytes = bytes;
+#endif
+  unlock_profile();
+
+  return APR_SUCCESS;
+}
+
+/* Start profiling a new life of POOL, accounting it to FILE_LINE.
+   NEW_POOL says whether POOL was just created, rather than cleared. */
+static void
+begin_pool_life(apr_pool_t *pool, const char *file_line,
+                svn_boolean_t new_pool)
+{
+  pool_life_t *life;
+
+  if (profile_init_state != 2)
+    init_profile();
+
+  if (report_requested)
+    {
+      report_requested = 0;
+      svn_pool__profile_report();
+    }
+
+  life = apr_palloc(pool, sizeof(*life));
+  life->pool = pool;
+  life->born = apr_time_now();
+
+  lock_profile();
+  life->site = get_site(file_line);
+  if (new_pool)
+    life->site->created++;
+  life->site->live++;
+  if (life->site->live > life->site->peak_live)
+    life->site->peak_live = life->site->live;
+  unlock_profile();
+
+  apr_pool_userdata_setn(life, POOL_LIFE_KEY, NULL, pool);
+  apr_pool_cleanup_register(pool, life, end_pool_life,
+                            apr_pool_cleanup_null);
+}
+
+#else /* SVN_POOL_PROFILE */
+
+void
+svn_pool__profile_report(void)
+{
+}
+
+#endif /* SVN_POOL_PROFILE */
+
+void
+svn_pool__clear_profiled(apr_pool_t *pool)
+{
+#ifdef SVN_POOL_PROFILE
+  void *data;
+  const char *file_line = NULL;
+
+  if (apr_pool_userdata_get(&data, POOL_LIFE_KEY, pool) == APR_SUCCESS
+      && data)
+    file_line = ((pool_life_t *)data)->site->file_line;
+
+  /* This ends the pool's current life, and loses its userdata. */
+  apr_pool_clear(pool);
+
+  if (file_line)
+    begin_pool_life(pool, file_line, FALSE);
+#else
+  apr_pool_clear(pool);
+#endif
+}
+
+
 #if APR_POOL_DEBUG
 #undef svn_pool_create_ex
 #endif /* APR_POOL_DEBUG */
@@ -66,6 +403,9 @@ svn_pool_create_ex(apr_pool_t *parent_pool, apr_allocator_t *allocator)
 {
   apr_pool_t *pool;
   apr_pool_create_ex(&pool, parent_pool, abort_on_pool_failure, allocator);
+#ifdef SVN_POOL_PROFILE
+  begin_pool_life(pool, "svn:<undefined>", TRUE);
+#endif
   return pool;
 }
 
@@ -74,7 +414,15 @@ apr_pool_t *
 svn_pool_create_ex_debug(apr_pool_t *pool, apr_allocator_t *allocator,
                          const char *file_line)
 {
+#ifdef SVN_POOL_PROFILE
+  apr_pool_t *new_pool;
+
+  apr_pool_create_ex(&new_pool, pool, abort_on_pool_failure, allocator);
+  begin_pool_life(new_pool, file_line, TRUE);
+  return new_pool;
+#else
   return svn_pool_create_ex(pool, allocator);
+#endif
 }
 
 #else /* APR_POOL_DEBUG */
@@ -86,6 +434,9 @@ svn_pool_create_ex_debug(apr_pool_t *parent_pool, apr_allocator_t *allocator,
   apr_pool_t *pool;
   apr_pool_create_ex_debug(&pool, parent_pool, abort_on_pool_failure,
                            allocator, file_line);
+#ifdef SVN_POOL_PROFILE
+  begin_pool_life(pool, file_line, TRUE);
+#endif
   return pool;
 }
 
@@ -202,14 +202,42 @@ is_valid_proplist_skel(const svn_skel_t *skel)
 }
 
 
-static svn_skel_t *parse(const char *data, apr_size_t len,
-                         apr_pool_t *pool);
-static svn_skel_t *list(const char *data, apr_size_t len,
-                        apr_pool_t *pool);
-static svn_skel_t *implicit_atom(const char *data, apr_size_t len,
-                                 apr_pool_t *pool);
-static svn_skel_t *explicit_atom(const char *data, apr_size_t len,
-                                 apr_pool_t *pool);
+/* The parser runs twice over its input.  The first pass only validates
+   the data and counts the skel objects it would need; the second pass
+   fills in the objects, all of which live in a single array allocated
+   in between.  That saves one pool allocation per atom and keeps the
+   result tightly packed, in pre-order, for the callers that walk it.  */
+typedef struct skel_arena_t
+{
+  /* The objects to fill, or NULL during the counting pass.  */
+  svn_skel_t *nodes;
+
+  /* Number of objects handed out (or counted) so far.  */
+  apr_size_t count;
+} skel_arena_t;
+
+
+/* Return the next unused skel object from ARENA, or NULL if ARENA is
+   only counting.  */
+static APR_INLINE svn_skel_t *
+new_skel(skel_arena_t *arena)
+{
+  if (arena->nodes)
+    return &arena->nodes[arena->count++];
+
+  arena->count++;
+  return NULL;
+}
+
+
+static const char *parse(const char *data, const char *end,
+                         skel_arena_t *arena, svn_skel_t **skel_p);
+static const char *list(const char *data, const char *end,
+                        skel_arena_t *arena, svn_skel_t **skel_p);
+static const char *implicit_atom(const char *data, const char *end,
+                                 skel_arena_t *arena, svn_skel_t **skel_p);
+static const char *explicit_atom(const char *data, const char *end,
+                                 skel_arena_t *arena, svn_skel_t **skel_p);
 
 
 svn_skel_t *
@@ -217,46 +245,64 @@ svn_skel__parse(const char *data,
                 apr_size_t len,
                 apr_pool_t *pool)
 {
-  return parse(data, len, pool);
+  skel_arena_t arena = { NULL, 0 };
+  svn_skel_t *skel = NULL;
+
+  /* Validate and count.  */
+  if (! parse(data, data + len, &arena, NULL))
+    return NULL;
+
+  /* Fill.  This cannot fail since the data has been checked above.  */
+  arena.nodes = apr_pcalloc(pool, arena.count * sizeof(*arena.nodes));
+  arena.count = 0;
+  parse(data, data + len, &arena, &skel);
+
+  return skel;
 }
 
 
-/* Parse any kind of skel object --- atom, or list.  */
-static svn_skel_t *
+/* Parse any kind of skel object --- atom, or list --- starting at
+   DATA and not extending past END.  Unless ARENA is only counting,
+   set *SKEL_P to the object taken from ARENA.  Return the address of
+   the first byte after the object, or NULL if it is malformed.  */
+static const char *
 parse(const char *data,
-      apr_size_t len,
-      apr_pool_t *pool)
+      const char *end,
+      skel_arena_t *arena,
+      svn_skel_t **skel_p)
 {
   char c;
 
   /* The empty string isn't a valid skel.  */
-  if (len <= 0)
+  if (data >= end)
     return NULL;
 
   c = *data;
 
   /* Is it a list, or an atom?  */
   if (c == '(')
-    return list(data, len, pool);
+    return list(data, end, arena, skel_p);
 
   /* Is it a string with an implicit length?  */
   if (skel_char_type[(unsigned char) c] == type_name)
-    return implicit_atom(data, len, pool);
+    return implicit_atom(data, end, arena, skel_p);
 
   /* Otherwise, we assume it's a string with an explicit length;
      svn_skel__getsize will catch the error.  */
   else
-    return explicit_atom(data, len, pool);
+    return explicit_atom(data, end, arena, skel_p);
 }
 
 
-static svn_skel_t *
+static const char *
 list(const char *data,
-     apr_size_t len,
-     apr_pool_t *pool)
+     const char *end,
+     skel_arena_t *arena,
+     svn_skel_t **skel_p)
 {
-  const char *end = data + len;
   const char *list_start;
+  svn_skel_t *s;
+  svn_skel_t **tail;
 
   /* Verify that the list starts with an opening paren.  At the
      moment, all callers have checked this already, but it's more
@@ -264,6 +310,11 @@ list(const char *data,
   if (data >= end || *data != '(')
     return NULL;
 
+  /* Take the list object before its children, so that the arena is
+     filled in pre-order and the root skel comes first.  */
+  s = new_skel(arena);
+  tail = s ? &s->children : NULL;
+
   /* Mark where the list starts.  */
   list_start = data;
 
@@ -271,68 +322,61 @@ list(const char *data,
   data++;
 
   /* Parse the children.  */
-  {
-    svn_skel_t *children = NULL;
-    svn_skel_t **tail = &children;
+  for (;;)
+    {
+      svn_skel_t *element = NULL;
 
-    for (;;)
-      {
-        svn_skel_t *element;
+      /* Skip any whitespace.  */
+      while (data < end
+             && skel_char_type[(unsigned char) *data] == type_space)
+        data++;
 
-        /* Skip any whitespace.  */
-        while (data < end
-               && skel_char_type[(unsigned char) *data] == type_space)
+      /* End of data, but no closing paren?  */
+      if (data >= end)
+        return NULL;
+
+      /* End of list?  */
+      if (*data == ')')
+        {
           data++;
+          break;
+        }
 
-        /* End of data, but no closing paren?  */
-        if (data >= end)
-          return NULL;
-
-        /* End of list?  */
-        if (*data == ')')
-          {
-            data++;
-            break;
-          }
-
-        /* Parse the next element in the list.  */
-        element = parse(data, end - data, pool);
-        if (! element)
-          return NULL;
-
-        /* Link that element into our list.  */
-        element->next = NULL;
-        *tail = element;
-        tail = &element->next;
-
-        /* Advance past that element.  */
-        data = element->data + element->len;
-      }
+      /* Parse the next element in the list and advance past it.  */
+      data = parse(data, end, arena, &element);
+      if (! data)
+        return NULL;
 
-    /* Construct the return value.  */
-    {
-      svn_skel_t *s = apr_pcalloc(pool, sizeof(*s));
+      /* Link that element into our list.  */
+      if (tail)
+        {
+          *tail = element;
+          tail = &element->next;
+        }
+    }
 
+  /* Complete the return value.  */
+  if (s)
+    {
       s->is_atom = FALSE;
       s->data = list_start;
       s->len = data - list_start;
-      s->children = children;
-
-      return s;
+      *skel_p = s;
     }
-  }
+
+  return data;
 }
 
 
 /* Parse an atom with implicit length --- one that starts with a name
    character, terminated by whitespace, '(', ')', or end-of-data.  */
-static svn_skel_t *
+static const char *
 implicit_atom(const char *data,
-              apr_size_t len,
-              apr_pool_t *pool)
+              const char *end,
+              skel_arena_t *arena,
+              svn_skel_t **skel_p)
 {
   const char *start = data;
-  const char *end = data + len;
   svn_skel_t *s;
 
   /* Verify that the atom starts with a name character.  At the
@@ -347,24 +391,28 @@ implicit_atom(const char *data,
          && skel_char_type[(unsigned char) *data] != type_paren)
     ;
 
-  /* Allocate the skel representing this string.  */
-  s = apr_pcalloc(pool, sizeof(*s));
-  s->is_atom = TRUE;
-  s->data = start;
-  s->len = data - start;
+  /* Fill in the skel representing this string.  */
+  s = new_skel(arena);
+  if (s)
+    {
+      s->is_atom = TRUE;
+      s->data = start;
+      s->len = data - start;
+      *skel_p = s;
+    }
 
-  return s;
+  return data;
 }
 
 
 /* Parse an atom with explicit length --- one that starts with a byte
    length, as a decimal ASCII number.  */
-static svn_skel_t *
+static const char *
 explicit_atom(const char *data,
-              apr_size_t len,
-              apr_pool_t *pool)
+              const char *end,
+              skel_arena_t *arena,
+              svn_skel_t **skel_p)
 {
-  const char *end = data + len;
   const char *next;
   apr_size_t size;
   svn_skel_t *s;
@@ -383,74 +431,61 @@ explicit_atom(const char *data,
   data++;
 
   /* Check the length.  */
-  if (data + size > end)
+  if (size > (apr_size_t)(end - data))
     return NULL;
 
-  /* Allocate the skel representing this string.  */
-  s = apr_pcalloc(pool, sizeof(*s));
-  s->is_atom = TRUE;
-  s->data = data;
-  s->len = size;
+  /* Fill in the skel representing this string.  */
+  s = new_skel(arena);
+  if (s)
+    {
+      s->is_atom = TRUE;
+      s->data = data;
+      s->len = size;
+      *skel_p = s;
+    }
 
-  return s;
+  return data + size;
 }
 
-
 
 /* Unparsing skeletons.  */
 
-static apr_size_t estimate_unparsed_size(const svn_skel_t *skel);
-static svn_stringbuf_t *unparse(const svn_skel_t *skel,
-                                svn_stringbuf_t *str,
-                                apr_pool_t *pool);
+/* Unparsing also takes two passes: the first computes the exact size
+   of the result, so that the second can write straight into a buffer
+   that never needs to grow.  */
+
+static apr_size_t unparsed_size(const svn_skel_t *skel);
+static char *unparse(const svn_skel_t *skel, char *buf);
 
 
 svn_stringbuf_t *
 svn_skel__unparse(const svn_skel_t *skel, apr_pool_t *pool)
 {
-  svn_stringbuf_t *str;
+  apr_size_t size = unparsed_size(skel);
+  svn_stringbuf_t *str = svn_stringbuf_create_ensure(size, pool);
+
+  str->len = unparse(skel, str->data) - str->data;
+  str->data[str->len] = '\0';
 
-  /* Allocate a string to hold the data.  */
-  str = apr_palloc(pool, sizeof(*str));
-  str->pool = pool;
-  str->blocksize = estimate_unparsed_size(skel) + 200;
-  str->data = apr_palloc(pool, str->blocksize);
-  str->len = 0;
+  SVN_ERR_ASSERT_NO_RETURN(str->len == size);
 
-  return unparse(skel, str, pool);
+  return str;
 }
 
 
-/* Return an estimate of the number of bytes that the external
-   representation of SKEL will occupy.  Since reallocing is expensive
-   in pools, it's worth trying to get the buffer size right the first
-   time.  */
+/* Return the number of decimal digits needed to represent VALUE.  */
 static apr_size_t
-estimate_unparsed_size(const svn_skel_t *skel)
+decimal_digits(apr_size_t value)
 {
-  if (skel->is_atom)
+  apr_size_t digits = 1;
+
+  while (value >= 10)
     {
-      if (skel->len < 100)
-        /* If we have to use the explicit-length form, that'll be
-           two bytes for the length, one byte for the space, and
-           the contents.  */
-        return skel->len + 3;
-      else
-        return skel->len + 30;
+      value /= 10;
+      digits++;
     }
-  else
-    {
-      int total_len;
-      svn_skel_t *child;
 
-      /* Allow space for opening and closing parens, and a space
-         between each pair of elements.  */
-      total_len = 2;
-      for (child = skel->children; child; child = child->next)
-        total_len += estimate_unparsed_size(child) + 1;
-
-      return total_len;
-    }
+  return digits;
 }
 
 
@@ -486,62 +521,83 @@ use_implicit(const svn_skel_t *skel)
 }
 
 
-/* Append the concrete representation of SKEL to the string STR.
-   Grow S with new space from POOL as necessary.  */
-static svn_stringbuf_t *
-unparse(const svn_skel_t *skel, svn_stringbuf_t *str, apr_pool_t *pool)
+/* Return the exact number of bytes that the external representation
+   of SKEL will occupy.  */
+static apr_size_t
+unparsed_size(const svn_skel_t *skel)
 {
   if (skel->is_atom)
     {
-      /* Append an atom to STR.  */
       if (use_implicit(skel))
-        svn_stringbuf_appendbytes(str, skel->data, skel->len);
-      else
-        {
-          /* Append the length to STR.  */
-          char buf[200];
-          int length_len;
+        return skel->len;
+
+      /* The length, one byte for the space, and the contents.  */
+      return decimal_digits(skel->len) + 1 + skel->len;
+    }
+  else
+    {
+      apr_size_t total_len;
+      svn_skel_t *child;
+
+      /* Allow space for opening and closing parens, and a space
+         between each pair of elements.  */
+      total_len = 2;
+      for (child = skel->children; child; child = child->next)
+        total_len += unparsed_size(child) + (child->next ? 1 : 0);
 
-          length_len = putsize(buf, sizeof(buf), skel->len);
+      return total_len;
+    }
+}
+
+
+/* Write the concrete representation of SKEL to BUF, which must be
+   large enough to hold it.  Return the address of the first byte
+   after it.  */
+static char *
+unparse(const svn_skel_t *skel, char *buf)
+{
+  if (skel->is_atom)
+    {
+      /* Write the length and a space, if needed.  */
+      if (! use_implicit(skel))
+        {
+          int length_len = putsize(buf, decimal_digits(skel->len),
+                                   skel->len);
 
           SVN_ERR_ASSERT_NO_RETURN(length_len > 0);
 
-          /* Make sure we have room for the length, the space, and the
-             atom's contents.  */
-          svn_stringbuf_ensure(str, str->len + length_len + 1 + skel->len);
-          svn_stringbuf_appendbytes(str, buf, length_len);
-          str->data[str->len++] = ' ';
-          svn_stringbuf_appendbytes(str, skel->data, skel->len);
+          buf += length_len;
+          *buf++ = ' ';
         }
+
+      /* Write the atom's contents.  */
+      if (skel->len)
+        memcpy(buf, skel->data, skel->len);
+      buf += skel->len;
     }
   else
     {
-      /* Append a list to STR.  */
       svn_skel_t *child;
 
       /* Emit an opening parenthesis.  */
-      svn_stringbuf_ensure(str, str->len + 1);
-      str->data[str->len++] = '(';
+      *buf++ = '(';
 
-      /* Append each element.  Emit a space between each pair of elements.  */
+      /* Write each element.  Emit a space between each pair of
+         elements.  */
       for (child = skel->children; child; child = child->next)
         {
-          unparse(child, str, pool);
+          buf = unparse(child, buf);
           if (child->next)
-            {
-              svn_stringbuf_ensure(str, str->len + 1);
-              str->data[str->len++] = ' ';
-            }
+            *buf++ = ' ';
         }
 
       /* Emit a closing parenthesis.  */
-      svn_stringbuf_appendbytes(str, ")", 1);
+      *buf++ = ')';
     }
 
-  return str;
+  return buf;
 }
 
-
 
 /* Building skels.  */
 
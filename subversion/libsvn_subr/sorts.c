@@ -132,6 +132,108 @@ svn_sort_compare_ranges(const void *a, const void *b)
   return item1->start < item2->start ? -1 : 1;
 }
 
+/* Arrays with fewer items than this are sorted by qsort() right away,
+   and partitions of the multi-key quicksort below of fewer items than
+   this get finished by insertion sort. */
+#define RADIX_SORT_THRESHOLD 32
+
+/* Return the byte at DEPTH in ITEM's key as a sort key for
+   radix_sort(), or -1 if the key ends before DEPTH.  With AS_PATHS,
+   '/' sorts before all other bytes, as in svn_path_compare_paths(). */
+static APR_INLINE int
+key_byte(const svn_sort__item_t *item, apr_size_t depth,
+         svn_boolean_t as_paths)
+{
+  int c;
+
+  if (depth >= (apr_size_t)item->klen)
+    return -1;
+
+  c = ((const unsigned char *)item->key)[depth];
+  return (as_paths && c == '/') ? 0 : c;
+}
+
+/* Compare the keys of A and B from DEPTH onwards, ordering them the
+   same way as key_byte() does. */
+static int
+compare_keys_from(const svn_sort__item_t *a, const svn_sort__item_t *b,
+                  apr_size_t depth, svn_boolean_t as_paths)
+{
+  while (TRUE)
+    {
+      int ca = key_byte(a, depth, as_paths);
+      int cb = key_byte(b, depth, as_paths);
+
+      if (ca != cb)
+        return ca - cb;
+      if (ca < 0)
+        return 0;
+
+      ++depth;
+    }
+}
+
+/* Sort the N ITEMS, whose keys all share their first DEPTH bytes, by
+   multi-key quicksort (Bentley & Sedgewick): partition three-ways on
+   the key byte at DEPTH and continue with the next byte only within
+   the middle partition.  Unlike a plain qsort() with strcmp(), common
+   prefixes get looked at just once, which matters for large
+   directories full of similar names. */
+static void
+radix_sort(svn_sort__item_t *items, int n, apr_size_t depth,
+           svn_boolean_t as_paths)
+{
+  while (n >= RADIX_SORT_THRESHOLD)
+    {
+      int lt = 0, gt = n - 1, i = 0;
+      int pivot = key_byte(&items[n / 2], depth, as_paths);
+      svn_sort__item_t tmp;
+
+      while (i <= gt)
+        {
+          int c = key_byte(&items[i], depth, as_paths);
+
+          if (c < pivot)
+            {
+              tmp = items[lt]; items[lt++] = items[i]; items[i++] = tmp;
+            }
+          else if (c > pivot)
+            {
+              tmp = items[gt]; items[gt--] = items[i]; items[i] = tmp;
+            }
+          else
+            ++i;
+        }
+
+      /* [0, LT) < PIVOT, [LT, GT] == PIVOT, (GT, N) > PIVOT */
+      radix_sort(items, lt, depth, as_paths);
+      if (pivot >= 0)
+        radix_sort(items + lt, gt - lt + 1, depth + 1, as_paths);
+
+      items += gt + 1;
+      n -= gt + 1;
+    }
+
+  /* finish small partitions by insertion sort */
+  if (n > 1)
+    {
+      int i, j;
+
+      for (i = 1; i < n; ++i)
+        {
+          svn_sort__item_t tmp = items[i];
+
+          for (j = i;
+               j > 0 && compare_keys_from(&items[j - 1], &tmp,
+                                          depth, as_paths) > 0;
+               --j)
+            items[j] = items[j - 1];
+
+          items[j] = tmp;
+        }
+    }
+}
+
 apr_array_header_t *
 svn_sort__hash(apr_hash_t *ht,
                int (*comparison_func)(const svn_sort__item_t *,
@@ -152,9 +254,16 @@ svn_sort__hash(apr_hash_t *ht,
       apr_hash_this(hi, &item->key, &item->klen, &item->value);
     }
 
-  /* now quicksort the array.  */
-  qsort(ary->elts, ary->nelts, ary->elt_size,
-        (int (*)(const void *, const void *))comparison_func);
+  /* Now sort the array.  Large arrays with one of our standard
+     orderings get sorted by radix instead of by comparison. */
+  if (ary->nelts >= RADIX_SORT_THRESHOLD
+      && (comparison_func == svn_sort_compare_items_lexically
+          || comparison_func == svn_sort_compare_items_as_paths))
+    radix_sort((svn_sort__item_t *)ary->elts, ary->nelts, 0,
+               comparison_func == svn_sort_compare_items_as_paths);
+  else
+    qsort(ary->elts, ary->nelts, ary->elt_size,
+          (int (*)(const void *, const void *))comparison_func);
 
   return ary;
 }
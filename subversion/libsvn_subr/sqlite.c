@@ -20,7 +20,10 @@
  * ====================================================================
  */
 
+#include <errno.h>
+
 #include <apr_pools.h>
+#include <apr_strings.h>
 
 #include "svn_types.h"
 #include "svn_error.h"
@@ -37,6 +40,7 @@
 #include "private/svn_atomic.h"
 #include "private/svn_skel.h"
 #include "private/svn_token.h"
+#include "private/svn_trace.h"
 
 #ifdef SQLITE3_DEBUG
 #include "private/svn_debug.h"
@@ -52,6 +56,10 @@
 
 INTERNAL_STATEMENTS_SQL_DECLARE_STATEMENTS(internal_statements);
 
+/* The number of statements in internal_statements. */
+#define NBR_INTERNAL_STATEMENTS \
+  (sizeof(internal_statements) / sizeof(internal_statements[0]) - 1)
+
 
 #ifdef SQLITE3_DEBUG
 /* An sqlite query execution callback. */
@@ -70,7 +78,18 @@ struct svn_sqlite__db_t
   const char * const *statement_strings;
   int nbr_statements;
   svn_sqlite__stmt_t **prepared_stmts;
+
+  /* The statements of internal_statements used on this database, like
+     those for transaction control, prepared when first used. */
+  svn_sqlite__stmt_t *internal_stmts[NBR_INTERNAL_STATEMENTS];
+
   apr_pool_t *state_pool;
+
+  /* The number of svn_sqlite__with_transaction() calls we are in. */
+  int transaction_depth;
+
+  /* The number of rollbacks done by svn_sqlite__with_transaction(). */
+  int rollbacks;
 };
 
 struct svn_sqlite__stmt_t
@@ -78,6 +97,11 @@ struct svn_sqlite__stmt_t
   sqlite3_stmt *s3stmt;
   svn_sqlite__db_t *db;
   svn_boolean_t needs_reset;
+
+  /* Usage statistics, see svn_sqlite__dump_stats(). */
+  apr_int64_t executions;
+  apr_int64_t rows;
+  apr_interval_time_t time;
 };
 
 
@@ -151,11 +175,31 @@ svn_sqlite__get_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
   return SVN_NO_ERROR;
 }
 
+/* Execute the internal statement STMT_IDX on DB, which must not return
+   any rows.  Unlike exec_sql(), this prepares the statement only once. */
+static svn_error_t *
+exec_internal(svn_sqlite__db_t *db, int stmt_idx)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  if (db->internal_stmts[stmt_idx] == NULL)
+    SVN_ERR(svn_sqlite__prepare(&db->internal_stmts[stmt_idx], db,
+                                internal_statements[stmt_idx],
+                                db->state_pool));
+
+  stmt = db->internal_stmts[stmt_idx];
+
+  if (stmt->needs_reset)
+    SVN_ERR(svn_sqlite__reset(stmt));
+
+  return svn_error_return(svn_sqlite__step_done(stmt));
+}
+
 svn_error_t *
 svn_sqlite__prepare(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
                     const char *text, apr_pool_t *result_pool)
 {
-  *stmt = apr_palloc(result_pool, sizeof(**stmt));
+  *stmt = apr_pcalloc(result_pool, sizeof(**stmt));
   (*stmt)->db = db;
   (*stmt)->needs_reset = FALSE;
 
@@ -199,7 +243,19 @@ svn_sqlite__step_row(svn_sqlite__stmt_t *stmt)
 svn_error_t *
 svn_sqlite__step(svn_boolean_t *got_row, svn_sqlite__stmt_t *stmt)
 {
-  int sqlite_result = sqlite3_step(stmt->s3stmt);
+  apr_time_t start = apr_time_now();
+  apr_time_t trace_start;
+  int sqlite_result;
+
+  SVN_TRACE__BEGIN(sqlite_step, trace_start);
+  sqlite_result = sqlite3_step(stmt->s3stmt);
+  SVN_TRACE__END(sqlite_step, trace_start, sqlite3_sql(stmt->s3stmt));
+
+  stmt->time += apr_time_now() - start;
+  if (!stmt->needs_reset)
+    stmt->executions++;
+  if (sqlite_result == SQLITE_ROW)
+    stmt->rows++;
 
   if (sqlite_result != SQLITE_DONE && sqlite_result != SQLITE_ROW)
     {
@@ -855,6 +911,12 @@ close_apr(void *data)
         err = svn_error_compose_create(
                         svn_sqlite__finalize(db->prepared_stmts[i]), err);
     }
+  for (i = 0; i < NBR_INTERNAL_STATEMENTS; i++)
+    {
+      if (db->internal_stmts[i])
+        err = svn_error_compose_create(
+                        svn_sqlite__finalize(db->internal_stmts[i]), err);
+    }
 
   result = sqlite3_close(db->db3);
 
@@ -874,10 +936,97 @@ close_apr(void *data)
   return APR_SUCCESS;
 }
 
+/* Set *VALUE to the non-negative integer given for OPTION in SECTION of
+   CFG, or to 0 if the option isn't set. */
+static svn_error_t *
+read_size_option(apr_int64_t *value,
+                 svn_config_t *cfg,
+                 const char *section,
+                 const char *option)
+{
+  const char *str;
+
+  svn_config_get(cfg, &str, section, option, NULL);
+  *value = 0;
+  if (str)
+    {
+      char *endstr;
+
+      errno = 0;
+      *value = apr_strtoi64(str, &endstr, 10);
+      if (*str == '\0' || *endstr || errno || *value < 0)
+        return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                 _("Invalid value '%s' for option '%s'"),
+                                 str, option);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_sqlite__read_tuning(svn_sqlite__tuning_t *tuning,
+                        svn_config_t *cfg,
+                        const char *section)
+{
+  SVN_ERR(svn_config_get_bool(cfg, &tuning->enable_wal, section,
+                              SVN_SQLITE__OPTION_ENABLE_WAL, FALSE));
+  SVN_ERR(read_size_option(&tuning->cache_size, cfg, section,
+                           SVN_SQLITE__OPTION_CACHE_SIZE));
+  SVN_ERR(read_size_option(&tuning->mmap_size, cfg, section,
+                           SVN_SQLITE__OPTION_MMAP_SIZE));
+
+  return SVN_NO_ERROR;
+}
+
+/* Apply the settings in TUNING to DB, which has been opened in MODE. */
+static svn_error_t *
+apply_tuning(svn_sqlite__db_t *db,
+             svn_sqlite__mode_t mode,
+             const svn_sqlite__tuning_t *tuning,
+             apr_pool_t *scratch_pool)
+{
+  if (tuning->cache_size > 0)
+    {
+      svn_sqlite__stmt_t *stmt;
+      apr_int64_t page_size;
+
+      /* Old versions of SQLite only take the cache size in pages. */
+      SVN_ERR(svn_sqlite__prepare(&stmt, db, "PRAGMA page_size;",
+                                  scratch_pool));
+      SVN_ERR(svn_sqlite__step_row(stmt));
+      page_size = svn_sqlite__column_int64(stmt, 0);
+      SVN_ERR(svn_sqlite__finalize(stmt));
+
+      if (page_size > 0)
+        SVN_ERR(exec_sql(db, apr_psprintf(scratch_pool,
+                                          "PRAGMA cache_size=%"
+                                          APR_INT64_T_FMT ";",
+                                          (tuning->cache_size * 1024
+                                           + page_size - 1) / page_size)));
+    }
+
+#if SQLITE_VERSION_AT_LEAST(3,7,17)
+  if (tuning->mmap_size > 0)
+    SVN_ERR(exec_sql(db, apr_psprintf(scratch_pool,
+                                      "PRAGMA mmap_size=%" APR_INT64_T_FMT ";",
+                                      tuning->mmap_size * 1024)));
+#endif
+
+#if SQLITE_VERSION_AT_LEAST(3,7,0)
+  /* Changing the journal mode needs write access.  If the file system
+     can't do the shared memory WAL needs, SQLite keeps the old mode. */
+  if (tuning->enable_wal && mode != svn_sqlite__mode_readonly)
+    SVN_ERR(exec_sql(db, "PRAGMA journal_mode=WAL;"));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  svn_sqlite__mode_t mode, const char * const statements[],
                  int latest_schema, const char * const *upgrade_sql,
+                 const svn_sqlite__tuning_t *tuning,
                  apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
   SVN_ERR(svn_atomic__init_once(&sqlite_init_state,
@@ -914,6 +1063,9 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
   SVN_ERR(exec_sql(*db, "PRAGMA foreign_keys=ON;"));
 #endif
 
+  if (tuning)
+    SVN_ERR(apply_tuning(*db, mode, tuning, scratch_pool));
+
   /* Validate the schema, upgrading if necessary. */
   if (upgrade_sql != NULL)
     SVN_ERR(check_format(*db, latest_schema, upgrade_sql, scratch_pool));
@@ -959,17 +1111,126 @@ svn_sqlite__with_transaction(svn_sqlite__db_t *db,
 {
   svn_error_t *err;
 
-  SVN_ERR(exec_sql(db, "BEGIN TRANSACTION;"));
+  /* SQLite doesn't nest transactions.  Inside of another transaction,
+     use a savepoint, so that an error can still roll back just the work
+     done by CB_FUNC. */
+  if (db->transaction_depth == 0)
+    SVN_ERR(exec_internal(db, STMT_INTERNAL_BEGIN_TRANSACTION));
+#if SQLITE_VERSION_AT_LEAST(3,6,8)
+  else
+    SVN_ERR(exec_internal(db, STMT_INTERNAL_SAVEPOINT_SVN));
+#endif
+
+  db->transaction_depth++;
   err = cb_func(cb_baton, db, scratch_pool);
+  db->transaction_depth--;
 
   /* Commit or rollback the sqlite transaction. */
   if (err)
     {
-      svn_error_clear(exec_sql(db, "ROLLBACK TRANSACTION;"));
+      db->rollbacks++;
+      if (db->transaction_depth == 0)
+        svn_error_clear(exec_internal(db,
+                                      STMT_INTERNAL_ROLLBACK_TRANSACTION));
+#if SQLITE_VERSION_AT_LEAST(3,6,8)
+      else
+        {
+          svn_error_clear(exec_internal(
+                            db, STMT_INTERNAL_ROLLBACK_TO_SAVEPOINT_SVN));
+          svn_error_clear(exec_internal(
+                            db, STMT_INTERNAL_RELEASE_SAVEPOINT_SVN));
+        }
+#endif
       return svn_error_return(err);
     }
 
-  return svn_error_return(exec_sql(db, "COMMIT TRANSACTION;"));
+  if (db->transaction_depth == 0)
+    return svn_error_return(
+             exec_internal(db, STMT_INTERNAL_COMMIT_TRANSACTION));
+#if SQLITE_VERSION_AT_LEAST(3,6,8)
+  else
+    return svn_error_return(
+             exec_internal(db, STMT_INTERNAL_RELEASE_SAVEPOINT_SVN));
+#else
+  return SVN_NO_ERROR;
+#endif
+}
+
+apr_int64_t
+svn_sqlite__changes_generation(svn_sqlite__db_t *db)
+{
+  return (apr_int64_t)sqlite3_total_changes(db->db3) + db->rollbacks;
+}
+
+/* A statement and its text, for svn_sqlite__dump_stats(). */
+typedef struct stmt_stats_t
+{
+  const svn_sqlite__stmt_t *stmt;
+  const char *text;
+} stmt_stats_t;
+
+/* qsort() comparison function sorting stmt_stats_t by descending time. */
+static int
+compare_stmt_time(const void *a, const void *b)
+{
+  const stmt_stats_t *stats_a = a;
+  const stmt_stats_t *stats_b = b;
+
+  if (stats_a->stmt->time > stats_b->stmt->time)
+    return -1;
+
+  return stats_a->stmt->time < stats_b->stmt->time ? 1 : 0;
+}
+
+svn_error_t *
+svn_sqlite__dump_stats(svn_sqlite__db_t *db,
+                       svn_stream_t *stream,
+                       apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *stats = apr_array_make(scratch_pool, 16,
+                                             sizeof(stmt_stats_t));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < db->nbr_statements; i++)
+    if (db->prepared_stmts[i] && db->prepared_stmts[i]->executions)
+      {
+        stmt_stats_t *item = apr_array_push(stats);
+
+        item->stmt = db->prepared_stmts[i];
+        item->text = db->statement_strings[i];
+      }
+
+  for (i = 0; i < NBR_INTERNAL_STATEMENTS; i++)
+    if (db->internal_stmts[i] && db->internal_stmts[i]->executions)
+      {
+        stmt_stats_t *item = apr_array_push(stats);
+
+        item->stmt = db->internal_stmts[i];
+        item->text = internal_statements[i];
+      }
+
+  qsort(stats->elts, stats->nelts, stats->elt_size, compare_stmt_time);
+
+  for (i = 0; i < stats->nelts; i++)
+    {
+      const stmt_stats_t *item = &APR_ARRAY_IDX(stats, i, stmt_stats_t);
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_stream_printf(stream, iterpool,
+                                "%10" APR_INT64_T_FMT
+                                " %10" APR_INT64_T_FMT
+                                " %12" APR_INT64_T_FMT " %s\n",
+                                item->stmt->executions,
+                                item->stmt->rows,
+                                (apr_int64_t) item->stmt->time,
+                                item->text));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -980,7 +1241,7 @@ svn_sqlite__hotcopy(const char *src_path,
   svn_sqlite__db_t *src_db;
 
   SVN_ERR(svn_sqlite__open(&src_db, src_path, svn_sqlite__mode_readonly,
-                           internal_statements, 0, NULL,
+                           internal_statements, 0, NULL, NULL,
                            scratch_pool, scratch_pool));
 
 #if SQLITE_VERSION_AT_LEAST(3,6,11)
@@ -990,7 +1251,8 @@ svn_sqlite__hotcopy(const char *src_path,
     int rc1, rc2;
 
     SVN_ERR(svn_sqlite__open(&dst_db, dst_path, svn_sqlite__mode_rwcreate,
-                             NULL, 0, NULL, scratch_pool, scratch_pool));
+                             NULL, 0, NULL, NULL,
+                             scratch_pool, scratch_pool));
     backup = sqlite3_backup_init(dst_db->db3, "main", src_db->db3, "main");
     if (!backup)
       return svn_error_createf(SVN_ERR_SQLITE_ERROR, NULL,
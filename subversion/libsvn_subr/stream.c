@@ -53,6 +53,7 @@ struct svn_stream_t {
   svn_io_reset_fn_t reset_fn;
   svn_io_mark_fn_t mark_fn;
   svn_io_seek_fn_t seek_fn;
+  svn_io_skip_fn_t skip_fn;
   svn_io_line_filter_cb_t line_filter_cb;
   svn_io_line_transformer_cb_t line_transformer_cb;
 };
@@ -73,6 +74,7 @@ svn_stream_create(void *baton, apr_pool_t *pool)
   stream->reset_fn = NULL;
   stream->mark_fn = NULL;
   stream->seek_fn = NULL;
+  stream->skip_fn = NULL;
   stream->line_filter_cb = NULL;
   stream->line_transformer_cb = NULL;
   return stream;
@@ -123,6 +125,12 @@ svn_stream_set_seek(svn_stream_t *stream, svn_io_seek_fn_t seek_fn)
   stream->seek_fn = seek_fn;
 }
 
+void
+svn_stream_set_skip(svn_stream_t *stream, svn_io_skip_fn_t skip_fn)
+{
+  stream->skip_fn = skip_fn;
+}
+
 void
 svn_stream_set_line_filter_callback(svn_stream_t *stream,
                                     svn_io_line_filter_cb_t line_filter_cb)
@@ -182,6 +190,42 @@ svn_stream_seek(svn_stream_t *stream, svn_stream_mark_t *mark)
   return stream->seek_fn(stream->baton, mark);
 }
 
+/* Skip up to *LEN bytes by reading them with READ_FN and BATON and
+ * throwing them away.  Set *LEN to the number of bytes skipped. */
+static svn_error_t *
+skip_by_reading(svn_read_fn_t read_fn, void *baton, apr_size_t *len)
+{
+  char buffer[SVN__STREAM_CHUNK_SIZE];
+  apr_size_t to_skip = *len;
+
+  *len = 0;
+  while (to_skip > 0)
+    {
+      apr_size_t count = to_skip < sizeof(buffer) ? to_skip : sizeof(buffer);
+      apr_size_t requested = count;
+
+      SVN_ERR(read_fn(baton, buffer, &count));
+      *len += count;
+      to_skip -= count;
+      if (count != requested)
+        break;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_stream_skip(svn_stream_t *stream, apr_size_t *len)
+{
+  if (stream->skip_fn == NULL)
+    {
+      SVN_ERR_ASSERT(stream->read_fn != NULL);
+      return skip_by_reading(stream->read_fn, stream->baton, len);
+    }
+
+  return stream->skip_fn(stream->baton, len);
+}
+
 svn_error_t *
 svn_stream_close(svn_stream_t *stream)
 {
@@ -303,6 +347,130 @@ scan_eol(const char **eol, svn_stream_t *stream, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* How much stream_read_line_chunky() reads at a time.  Most lines are
+ * shorter than this, and reading much more would be wasted effort. */
+#define LINE_CHUNK_SIZE 128
+
+/* Return the first occurrence of the EOL_LEN bytes at EOL in the LEN
+ * bytes at DATA, or NULL if there is none. */
+static const char *
+find_eol(const char *data, apr_size_t len, const char *eol,
+         apr_size_t eol_len)
+{
+  const char *end = data + len;
+
+  while (data < end)
+    {
+      const char *p = memchr(data, eol[0], end - data);
+
+      if (p == NULL || (apr_size_t)(end - p) < eol_len)
+        return NULL;
+      if (memcmp(p, eol, eol_len) == 0)
+        return p;
+      data = p + 1;
+    }
+
+  return NULL;
+}
+
+/* Append to STR the bytes of STREAM up to the next occurrence of EOL,
+ * consuming but not appending EOL itself, one byte at a time.  Set *EOF
+ * if STREAM runs out first. */
+static svn_error_t *
+stream_read_line_bytewise(svn_stringbuf_t *str,
+                          svn_boolean_t *eof,
+                          const char *eol,
+                          svn_stream_t *stream)
+{
+  const char *match = eol;
+  apr_size_t numbytes = 1;
+  char c;
+
+  while (*match)
+    {
+      SVN_ERR(svn_stream_read(stream, &c, &numbytes));
+      if (numbytes != 1)
+        {
+          /* a 'short' read means the stream has run out. */
+          *eof = TRUE;
+          /* We know we don't have a whole EOL sequence, but ensure we
+           * don't chop off any partial EOL sequence that we may have. */
+          match = eol;
+          /* Process this short (or empty) line just like any other
+           * except with *EOF set. */
+          break;
+        }
+
+      if (c == *match)
+        match++;
+      else
+        match = eol;
+
+      svn_stringbuf_appendbytes(str, &c, 1);
+    }
+
+  svn_stringbuf_chop(str, match - eol);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like stream_read_line_bytewise(), but for a STREAM that can be marked,
+ * sought and skipped cheaply:  read ahead LINE_CHUNK_SIZE bytes at a time
+ * until EOL turns up, then go back and step over just the line and EOL.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+stream_read_line_chunky(svn_stringbuf_t *str,
+                        svn_boolean_t *eof,
+                        const char *eol,
+                        svn_stream_t *stream,
+                        apr_pool_t *scratch_pool)
+{
+  apr_size_t eol_len = strlen(eol);
+  apr_size_t start = str->len;
+  apr_size_t scanned = str->len;
+  const char *eol_pos;
+  apr_size_t consumed;
+  svn_stream_mark_t *mark;
+
+  SVN_ERR(svn_stream_mark(stream, &mark, scratch_pool));
+
+  while (1)
+    {
+      apr_size_t numbytes = LINE_CHUNK_SIZE;
+
+      svn_stringbuf_ensure(str, str->len + LINE_CHUNK_SIZE + 1);
+      SVN_ERR(svn_stream_read(stream, str->data + str->len, &numbytes));
+      str->len += numbytes;
+      str->data[str->len] = '\0';
+
+      eol_pos = find_eol(str->data + scanned, str->len - scanned,
+                         eol, eol_len);
+      if (eol_pos || numbytes < LINE_CHUNK_SIZE)
+        break;
+
+      /* An EOL may straddle this chunk and the next one. */
+      if (str->len - start >= eol_len)
+        scanned = str->len - eol_len + 1;
+    }
+
+  /* Without an EOL, everything up to the end of STREAM is the line, and
+     we have consumed exactly that. */
+  if (! eol_pos)
+    {
+      *eof = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  consumed = eol_pos - (str->data + start) + eol_len;
+  str->len = eol_pos - str->data;
+  str->data[str->len] = '\0';
+
+  /* Hand back what we read beyond the EOL.  Reading the line again is
+     cheaper than asking a file stream where its end is. */
+  SVN_ERR(svn_stream_seek(stream, mark));
+  return skip_by_reading(stream->read_fn, stream->baton, &consumed);
+}
+
 /* Guts of svn_stream_readline() and svn_stream_readline_detect_eol().
  * Returns the line read from STREAM in *STRINGBUF, and indicates
  * end-of-file in *EOF.  If DETECT_EOL is TRUE, the end-of-line indicator
@@ -321,22 +489,21 @@ stream_readline(svn_stringbuf_t **stringbuf,
   apr_pool_t *iterpool;
   svn_boolean_t filtered;
   const char *eol_str;
+  /* Only streams backed by memory or plain files know how to skip, and
+     for those marking and seeking is cheap and reliable. */
+  svn_boolean_t chunky = (stream->mark_fn && stream->seek_fn
+                          && stream->skip_fn);
 
   *eof = FALSE;
 
   iterpool = svn_pool_create(pool);
   do
     {
-      apr_size_t numbytes;
-      const char *match;
-      char c;
-
       svn_pool_clear(iterpool);
 
-      /* Since we're reading one character at a time, let's at least
-         optimize for the 90% case.  90% of the time, we can avoid the
-         stringbuf ever having to realloc() itself if we start it out at
-         80 chars.  */
+      /* Most lines are shorter than 80 chars, so this usually saves the
+         stringbuf from having to realloc() itself when reading one
+         character at a time.  */
       str = svn_stringbuf_create_ensure(80, iterpool);
 
       if (detect_eol)
@@ -353,33 +520,12 @@ stream_readline(svn_stringbuf_t **stringbuf,
       else
         eol_str = *eol;
 
-      /* Read into STR up to and including the next EOL sequence. */
-      match = eol_str;
-      numbytes = 1;
-      while (*match)
-        {
-          SVN_ERR(svn_stream_read(stream, &c, &numbytes));
-          if (numbytes != 1)
-            {
-              /* a 'short' read means the stream has run out. */
-              *eof = TRUE;
-              /* We know we don't have a whole EOL sequence, but ensure we
-               * don't chop off any partial EOL sequence that we may have. */
-              match = eol_str;
-              /* Process this short (or empty) line just like any other
-               * except with *EOF set. */
-              break;
-            }
-
-          if (c == *match)
-            match++;
-          else
-            match = eol_str;
-
-          svn_stringbuf_appendbytes(str, &c, 1);
-        }
-
-      svn_stringbuf_chop(str, match - eol_str);
+      /* Read into STR up to the next EOL sequence, consuming it. */
+      if (chunky)
+        SVN_ERR(stream_read_line_chunky(str, eof, eol_str, stream,
+                                        iterpool));
+      else
+        SVN_ERR(stream_read_line_bytewise(str, eof, eol_str, stream));
 
       SVN_ERR(line_filter(stream, &filtered, str->data, iterpool));
     }
@@ -536,6 +682,13 @@ seek_handler_empty(void *baton, svn_stream_mark_t *mark)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+skip_handler_empty(void *baton, apr_size_t *len)
+{
+  *len = 0;
+  return SVN_NO_ERROR;
+}
+
 
 svn_stream_t *
 svn_stream_empty(apr_pool_t *pool)
@@ -548,6 +701,7 @@ svn_stream_empty(apr_pool_t *pool)
   svn_stream_set_reset(stream, reset_handler_empty);
   svn_stream_set_mark(stream, mark_handler_empty);
   svn_stream_set_seek(stream, seek_handler_empty);
+  svn_stream_set_skip(stream, skip_handler_empty);
   return stream;
 }
 
@@ -642,6 +796,12 @@ seek_handler_disown(void *baton, svn_stream_mark_t *mark)
   return svn_stream_seek(baton, mark);
 }
 
+static svn_error_t *
+skip_handler_disown(void *baton, apr_size_t *len)
+{
+  return svn_stream_skip(baton, len);
+}
+
 svn_stream_t *
 svn_stream_disown(svn_stream_t *stream, apr_pool_t *pool)
 {
@@ -652,6 +812,8 @@ svn_stream_disown(svn_stream_t *stream, apr_pool_t *pool)
   svn_stream_set_reset(s, reset_handler_disown);
   svn_stream_set_mark(s, mark_handler_disown);
   svn_stream_set_seek(s, seek_handler_disown);
+  if (stream->skip_fn)
+    svn_stream_set_skip(s, skip_handler_disown);
 
   return s;
 }
@@ -743,6 +905,41 @@ seek_handler_apr(void *baton, svn_stream_mark_t *mark)
   return SVN_NO_ERROR;
 }
 
+/* A skip handler (#svn_io_skip_fn_t) that moves the file pointer instead
+   of reading the data.  Only for regular files. */
+static svn_error_t *
+skip_handler_apr(void *baton, apr_size_t *len)
+{
+  struct baton_apr *btn = baton;
+  apr_off_t pos, end;
+
+  if (btn->start >= 0 && btn->end > 0)
+    {
+      end = btn->end;
+    }
+  else
+    {
+      apr_finfo_t finfo;
+
+      SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, btn->file,
+                                   btn->pool));
+      end = finfo.size;
+    }
+
+  pos = 0;
+  SVN_ERR(svn_io_file_seek(btn->file, APR_CUR, &pos, btn->pool));
+  if (btn->start >= 0 && pos < btn->start)
+    pos = btn->start;
+
+  if (pos >= end)
+    *len = 0;
+  else if (end - pos < (apr_off_t)*len)
+    *len = (apr_size_t)(end - pos);
+
+  pos += *len;
+  return svn_io_file_seek(btn->file, APR_SET, &pos, btn->pool);
+}
+
 svn_error_t *
 svn_stream_open_readonly(svn_stream_t **stream,
                          const char *path,
@@ -805,6 +1002,7 @@ svn_stream_from_aprfile2(apr_file_t *file,
 {
   struct baton_apr *baton;
   svn_stream_t *stream;
+  apr_finfo_t finfo;
 
   if (file == NULL)
     return svn_stream_empty(pool);
@@ -821,6 +1019,13 @@ svn_stream_from_aprfile2(apr_file_t *file,
   svn_stream_set_mark(stream, mark_handler_apr);
   svn_stream_set_seek(stream, seek_handler_apr);
 
+  /* Pipes and the like can only be skipped by reading them, and a
+     buffered one might seem to seek fine for a while.  Leave them to
+     the generic code. */
+  if (apr_file_info_get(&finfo, APR_FINFO_TYPE, file) == APR_SUCCESS
+      && finfo.filetype == APR_REG)
+    svn_stream_set_skip(stream, skip_handler_apr);
+
   if (! disown)
     svn_stream_set_close(stream, close_handler_apr);
 
@@ -898,6 +1103,7 @@ svn_stream_from_aprfile_range_readonly(apr_file_t *file,
   svn_stream_set_reset(stream, reset_handler_apr);
   svn_stream_set_mark(stream, mark_handler_apr);
   svn_stream_set_seek(stream, seek_handler_apr);
+  svn_stream_set_skip(stream, skip_handler_apr);
 
   if (! disown)
     svn_stream_set_close(stream, close_handler_apr);
@@ -1456,6 +1662,17 @@ seek_handler_stringbuf(void *baton, svn_stream_mark_t *mark)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+skip_handler_stringbuf(void *baton, apr_size_t *len)
+{
+  struct stringbuf_stream_baton *btn = baton;
+  apr_size_t left_to_read = btn->str->len - btn->amt_read;
+
+  *len = (*len > left_to_read) ? left_to_read : *len;
+  btn->amt_read += *len;
+  return SVN_NO_ERROR;
+}
+
 svn_stream_t *
 svn_stream_from_stringbuf(svn_stringbuf_t *str,
                           apr_pool_t *pool)
@@ -1475,6 +1692,7 @@ svn_stream_from_stringbuf(svn_stringbuf_t *str,
   svn_stream_set_reset(stream, reset_handler_stringbuf);
   svn_stream_set_mark(stream, mark_handler_stringbuf);
   svn_stream_set_seek(stream, seek_handler_stringbuf);
+  svn_stream_set_skip(stream, skip_handler_stringbuf);
   return stream;
 }
 
@@ -1496,6 +1714,17 @@ read_handler_string(void *baton, char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+skip_handler_string(void *baton, apr_size_t *len)
+{
+  struct string_stream_baton *btn = baton;
+  apr_size_t left_to_read = btn->str->len - btn->amt_read;
+
+  *len = (*len > left_to_read) ? left_to_read : *len;
+  btn->amt_read += *len;
+  return SVN_NO_ERROR;
+}
+
 svn_stream_t *
 svn_stream_from_string(const svn_string_t *str,
                        apr_pool_t *pool)
@@ -1511,6 +1740,7 @@ svn_stream_from_string(const svn_string_t *str,
   baton->amt_read = 0;
   stream = svn_stream_create(baton, pool);
   svn_stream_set_read(stream, read_handler_string);
+  svn_stream_set_skip(stream, skip_handler_string);
   return stream;
 }
 
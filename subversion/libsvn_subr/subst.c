@@ -46,6 +46,7 @@
 #include "svn_pools.h"
 
 #include "svn_private_config.h"
+#include "private/svn_string_private.h"
 
 
 /**
@@ -797,6 +798,72 @@ struct translation_baton
 };
 
 
+/* Machine words with the same byte repeated in every position. */
+#define R_MASK          ((apr_uintptr_t)-1 / 0xff * '\r')
+#define N_MASK          ((apr_uintptr_t)-1 / 0xff * '\n')
+#define DOLLAR_MASK     ((apr_uintptr_t)-1 / 0xff * '$')
+
+/* Return a pointer to the first character in [P, END) that is marked in
+ * INTERESTING, or END if there is none.
+ *
+ * Only '$', CR and LF are ever interesting, so whole machine words that
+ * contain none of them are skipped at once, the same way
+ * svn_eol__find_eol_start() does. */
+static const char *
+find_interesting(const char *p, const char *end, const char *interesting)
+{
+  while (p < end)
+    {
+      const char *stop;
+
+      /* Get to a word boundary byte by byte ... */
+      for (; p < end && ((apr_uintptr_t)p & (sizeof(apr_uintptr_t) - 1));
+           ++p)
+        {
+          if (interesting[(unsigned char)*p])
+            return p;
+        }
+
+      /* ... then skip whole words without any '$', CR or LF in them.  A
+       * byte of a test word is zero exactly if the respective byte of the
+       * chunk is the character tested for; adding SVN__LOWER_7BITS_SET to
+       * the lower 7 bits sets bit 7 of each byte that isn't, without
+       * carrying into the next byte. */
+      for (; end - p >= (apr_ssize_t)sizeof(apr_uintptr_t);
+           p += sizeof(apr_uintptr_t))
+        {
+          apr_uintptr_t chunk = *(const apr_uintptr_t *)p;
+          apr_uintptr_t r_test = chunk ^ R_MASK;
+          apr_uintptr_t n_test = chunk ^ N_MASK;
+          apr_uintptr_t dollar_test = chunk ^ DOLLAR_MASK;
+
+          r_test |= (r_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+          n_test |= (n_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+          dollar_test |= (dollar_test & SVN__LOWER_7BITS_SET)
+                         + SVN__LOWER_7BITS_SET;
+
+          if ((r_test & n_test & dollar_test & SVN__BIT_7_SET)
+              != SVN__BIT_7_SET)
+            break;
+        }
+
+      /* The word containing a candidate, or the tail.  The candidate may
+       * not be interesting after all, e.g. a '$' when there are no
+       * keywords; then continue with the next word. */
+      stop = (end - p >= (apr_ssize_t)sizeof(apr_uintptr_t))
+           ? p + sizeof(apr_uintptr_t)
+           : end;
+      for (; p < stop; ++p)
+        {
+          if (interesting[(unsigned char)*p])
+            return p;
+        }
+    }
+
+  return end;
+}
+
+
 /* Allocate a baton for use with translate_chunk() in POOL and
  * initialize it for the first iteration.
  *
@@ -945,13 +1012,7 @@ translate_chunk(svn_stream_t *dst,
             }
 
           /* We're in the boring state; look for interest characters. */
-          len = 0;
-
-          /* We wanted memcspn(), but lacking that, the loop below has
-             the same effect. Also, skip NUL characters.
-          */
-          while ((p + len) < end && !interesting[(unsigned char)p[len]])
-            len++;
+          len = find_interesting(p, end, interesting) - p;
 
           if (len)
             SVN_ERR(translate_write(dst, p, len));
@@ -48,6 +48,7 @@ struct encode_baton {
   unsigned char buf[3];         /* Bytes waiting to be encoded */
   int buflen;                   /* Number of bytes waiting */
   int linelen;                  /* Bytes output so far on this line */
+  svn_stringbuf_t *encoded;     /* Output buffer, reused for each write */
   apr_pool_t *pool;
 };
 
@@ -71,30 +72,60 @@ encode_group(const unsigned char *in, char *out)
    data from call to call, and *LINELEN carries the length of the
    current output line.  Make INBUF have room for three characters and
    initialize *INBUFLEN and *LINELEN to 0.  Output will be appended to
-   STR.  Include newlines every so often if BREAK_LINES is true. */
+   STR.  Include newlines every so often if BREAK_LINES is true.
+
+   The output buffer is grown once up front, and complete groups are
+   encoded from DATA straight into it, up to a line at a time. */
 static void
 encode_bytes(svn_stringbuf_t *str, const void *data, apr_size_t len,
              unsigned char *inbuf, int *inbuflen, int *linelen,
              svn_boolean_t break_lines)
 {
-  char group[4];
-  const char *p = data, *end = p + len;
+  const unsigned char *p = data, *end = p + len;
+  apr_size_t maxlen = (len / 3 + 2) * 4;
 
-  /* Keep encoding three-byte groups until we run out.  */
-  while (*inbuflen + (end - p) >= 3)
+  if (break_lines)
+    maxlen += maxlen / BASE64_LINELEN + 1;
+  svn_stringbuf_ensure(str, str->len + maxlen + 1);
+
+  /* Complete the group left over from the previous call.  */
+  if (*inbuflen > 0 && *inbuflen + len >= 3)
     {
       memcpy(inbuf + *inbuflen, p, 3 - *inbuflen);
       p += (3 - *inbuflen);
-      encode_group(inbuf, group);
-      svn_stringbuf_appendbytes(str, group, 4);
+      encode_group(inbuf, str->data + str->len);
+      str->len += 4;
       *inbuflen = 0;
       *linelen += 4;
       if (break_lines && *linelen == BASE64_LINELEN)
         {
-          svn_stringbuf_appendcstr(str, "\n");
+          str->data[str->len++] = '\n';
+          *linelen = 0;
+        }
+    }
+
+  /* Keep encoding three-byte groups until we run out.  */
+  while (end - p >= 3)
+    {
+      apr_size_t groups = (end - p) / 3;
+      char *out = str->data + str->len;
+      apr_size_t i;
+
+      if (break_lines && groups > (apr_size_t)(BASE64_LINELEN - *linelen) / 4)
+        groups = (BASE64_LINELEN - *linelen) / 4;
+
+      for (i = 0; i < groups; i++, p += 3, out += 4)
+        encode_group(p, out);
+
+      str->len += groups * 4;
+      *linelen += (int)groups * 4;
+      if (break_lines && *linelen == BASE64_LINELEN)
+        {
+          str->data[str->len++] = '\n';
           *linelen = 0;
         }
     }
+  str->data[str->len] = '\0';
 
   /* Tack any extra input onto *INBUF.  */
   memcpy(inbuf + *inbuflen, p, end - p);
@@ -131,18 +162,16 @@ static svn_error_t *
 encode_data(void *baton, const char *data, apr_size_t *len)
 {
   struct encode_baton *eb = baton;
-  apr_pool_t *subpool = svn_pool_create(eb->pool);
-  svn_stringbuf_t *encoded = svn_stringbuf_create("", subpool);
   apr_size_t enclen;
-  svn_error_t *err = SVN_NO_ERROR;
 
   /* Encode this block of data and write it out.  */
-  encode_bytes(encoded, data, *len, eb->buf, &eb->buflen, &eb->linelen, TRUE);
-  enclen = encoded->len;
+  svn_stringbuf_setempty(eb->encoded);
+  encode_bytes(eb->encoded, data, *len, eb->buf, &eb->buflen, &eb->linelen,
+               TRUE);
+  enclen = eb->encoded->len;
   if (enclen != 0)
-    err = svn_stream_write(eb->output, encoded->data, &enclen);
-  svn_pool_destroy(subpool);
-  return err;
+    SVN_ERR(svn_stream_write(eb->output, eb->encoded->data, &enclen));
+  return SVN_NO_ERROR;
 }
 
 
@@ -179,6 +208,7 @@ svn_base64_encode(svn_stream_t *output, apr_pool_t *pool)
   eb->output = output;
   eb->buflen = 0;
   eb->linelen = 0;
+  eb->encoded = svn_stringbuf_create("", subpool);
   eb->pool = subpool;
   stream = svn_stream_create(eb, pool);
   svn_stream_set_write(stream, encode_data);
@@ -221,6 +251,7 @@ struct decode_baton {
   unsigned char buf[4];         /* Bytes waiting to be decoded */
   int buflen;                   /* Number of bytes waiting */
   svn_boolean_t done;           /* True if we already saw an '=' */
+  svn_stringbuf_t *decoded;     /* Output buffer, reused for each write */
   apr_pool_t *pool;
 };
 
@@ -264,21 +295,52 @@ static const signed char reverse_base64[256] = {
    from call to call, and *DONE keeps track of whether we've seen an
    '=' which terminates the encoded data.  Have room for four bytes in
    INBUF and initialize *INBUFLEN to 0 and *DONE to FALSE.  Output
-   will be appended to STR.  */
+   will be appended to STR.
+
+   Runs of four valid characters are decoded straight into STR a group
+   at a time; only line breaks, padding and invalid characters go
+   through INBUF one at a time.  */
 static void
 decode_bytes(svn_stringbuf_t *str, const char *data, apr_size_t len,
              unsigned char *inbuf, int *inbuflen, svn_boolean_t *done)
 {
-  const char *p;
+  const char *p, *end = data + len;
   char group[3];
   signed char find;
 
-  /* Resize the stringbuf to make room for the (approximate) size of
-     output, to avoid repeated resizes later. */
-  svn_stringbuf_ensure(str, (len / 4) * 3 + 3);
+  /* Resize the stringbuf to make room for the size of the output, so
+     that we can decode into it directly. */
+  svn_stringbuf_ensure(str, str->len + (len / 4) * 3 + 3 + 1);
 
-  for (p = data; !*done && p < data + len; p++)
+  for (p = data; !*done && p < end; p++)
     {
+      if (*inbuflen == 0)
+        {
+          char *out = str->data + str->len;
+
+          while (end - p >= 4)
+            {
+              signed char a = reverse_base64[(unsigned char)p[0]];
+              signed char b = reverse_base64[(unsigned char)p[1]];
+              signed char c = reverse_base64[(unsigned char)p[2]];
+              signed char d = reverse_base64[(unsigned char)p[3]];
+
+              if ((a | b | c | d) < 0)
+                break;
+
+              out[0] = (char)((a << 2) | (b >> 4));
+              out[1] = (char)(((b & 0xf) << 4) | (c >> 2));
+              out[2] = (char)(((c & 0x3) << 6) | d);
+              out += 3;
+              p += 4;
+            }
+          str->len = out - str->data;
+          str->data[str->len] = '\0';
+
+          if (p == end)
+            break;
+        }
+
       if (*p == '=')
         {
           /* We are at the end and have to decode a partial group.  */
@@ -311,22 +373,17 @@ static svn_error_t *
 decode_data(void *baton, const char *data, apr_size_t *len)
 {
   struct decode_baton *db = baton;
-  apr_pool_t *subpool;
-  svn_stringbuf_t *decoded;
   apr_size_t declen;
-  svn_error_t *err = SVN_NO_ERROR;
 
   /* Decode this block of data.  */
-  subpool = svn_pool_create(db->pool);
-  decoded = svn_stringbuf_create("", subpool);
-  decode_bytes(decoded, data, *len, db->buf, &db->buflen, &db->done);
+  svn_stringbuf_setempty(db->decoded);
+  decode_bytes(db->decoded, data, *len, db->buf, &db->buflen, &db->done);
 
-  /* Write the output, clean up, go home.  */
-  declen = decoded->len;
+  /* Write the output and go home.  */
+  declen = db->decoded->len;
   if (declen != 0)
-    err = svn_stream_write(db->output, decoded->data, &declen);
-  svn_pool_destroy(subpool);
-  return err;
+    SVN_ERR(svn_stream_write(db->output, db->decoded->data, &declen));
+  return SVN_NO_ERROR;
 }
 
 
@@ -354,6 +411,7 @@ svn_base64_decode(svn_stream_t *output, apr_pool_t *pool)
   db->output = output;
   db->buflen = 0;
   db->done = FALSE;
+  db->decoded = svn_stringbuf_create("", subpool);
   db->pool = subpool;
   stream = svn_stream_create(db, pool);
   svn_stream_set_write(stream, decode_data);
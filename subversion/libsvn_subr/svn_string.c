@@ -30,6 +30,7 @@
 #include <apr_fnmatch.h>
 #include "svn_string.h"  /* loads "svn_types.h" and <apr_pools.h> */
 #include "svn_ctype.h"
+#include "private/svn_string_private.h"
 
 
 
@@ -384,6 +385,38 @@ svn_stringbuf_ensure(svn_stringbuf_t *str, apr_size_t minimum_size)
 }
 
 
+void
+svn_stringbuf__ensure_exact(svn_stringbuf_t *str, apr_size_t minimum_size)
+{
+  if (str->blocksize < minimum_size)
+    {
+      str->data = (char *) my__realloc(str->data,
+                                       str->len + 1,
+                                       minimum_size,
+                                       str->pool);
+      str->blocksize = minimum_size;
+    }
+}
+
+
+svn_string_t *
+svn_stringbuf__morph_into_string(svn_stringbuf_t *strbuf)
+{
+  /* svn_string_t and svn_stringbuf_t are public structures whose layout
+     cannot change, and svn_string_t is the same as the (data, len) part
+     of svn_stringbuf_t.  So we can hand out that part of STRBUF as the
+     string.  STRBUF itself must not be used any more, because growing
+     it could move the data away from under the string. */
+#ifdef SVN_DEBUG
+  /* Make any further appends to STRBUF fail loudly. */
+  strbuf->pool = NULL;
+  strbuf->blocksize = strbuf->len + 1;
+#endif
+
+  return (svn_string_t *)(&strbuf->data);
+}
+
+
 void
 svn_stringbuf_appendbytes(svn_stringbuf_t *str, const char *bytes,
                           apr_size_t count)
@@ -0,0 +1,268 @@
+/*
+ * svn_temp_serializer.c: implement the temporary structure serialization API
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "private/svn_temp_serializer.h"
+
+/* This is a very efficient serialization and especially efficient
+ * deserialization framework.  The idea is just to concatenate all
+ * sub-structures and strings into a single buffer while preserving
+ * proper member alignment.  Pointers will be replaced by the respective
+ * data offsets in the buffer when that target that it pointed to gets
+ * serialized, i.e. appended to the data buffer written so far.
+ *
+ * Hence, deserialization can be simply done by copying the buffer and
+ * adjusting the pointers.  No fine-grained allocation and copying is
+ * necessary.
+ */
+
+/* An element in the structure stack.  It contains a pointer to the
+ * source structure such that the relative offset of a pointer within
+ * that structure can be determined.  TARGET_OFFSET is the position of
+ * the structure's copy within the serialized data.
+ */
+typedef struct source_stack_t
+{
+  /* the source structure passed in to *_init or *_push */
+  const void *source_struct;
+
+  /* offset within the target buffer to where the structure got copied */
+  apr_size_t target_offset;
+
+  /* parent stack entry.  Will be NULL for the root entry.
+   * Items in the svn_temp_serializer__context_t recycler will use this
+   * to link to the next unused item. */
+  struct source_stack_t *upper;
+} source_stack_t;
+
+/* Serialization context info.  It basically consists of the buffer
+ * holding the serialized result and the stack of source structure
+ * information.
+ */
+struct svn_temp_serializer__context_t
+{
+  /* allocations are made from this pool */
+  apr_pool_t *pool;
+
+  /* the buffer holding all serialized data */
+  svn_stringbuf_t *buffer;
+
+  /* the stack of structures being serialized.  If NULL, there is no
+   * current structure, e.g. because the context has been created for
+   * a NULL root structure. */
+  source_stack_t *source;
+
+  /* unused stack elements will be put here for later reuse. */
+  source_stack_t *recycler;
+};
+
+/* Make sure the serialized data len is a multiple of the default
+ * alignment, i.e. structures may be serialized properly from that
+ * point onwards.
+ */
+static void
+align_buffer_end(svn_temp_serializer__context_t *context)
+{
+  apr_size_t current_len = context->buffer->len;
+  apr_size_t aligned_len = APR_ALIGN_DEFAULT(current_len);
+
+  if (aligned_len != current_len)
+    {
+      svn_stringbuf_ensure(context->buffer, aligned_len + 1);
+      memset(context->buffer->data + current_len, 0,
+             aligned_len - current_len);
+      context->buffer->len = aligned_len;
+      context->buffer->data[aligned_len] = 0;
+    }
+}
+
+/* Store the current end of the serialized data buffer as offset in the
+ * pointer member SOURCE_POINTER of the current structure in CONTEXT.
+ * If POINT_TO_END is FALSE, store NULL instead.
+ */
+static void
+store_current_end_pointer(svn_temp_serializer__context_t *context,
+                          const void * const * source_pointer,
+                          svn_boolean_t point_to_end)
+{
+  apr_size_t ptr_offset;
+  apr_size_t *target_ptr;
+
+  /* if *source_pointer is the root struct, there will be no parent
+   * structure to relate it to */
+  if (context->source == NULL)
+    return;
+
+  /* position of the serialized pointer relative to the begin of the
+   * buffer */
+  ptr_offset = (const char *)source_pointer
+             - (const char *)context->source->source_struct
+             + context->source->target_offset;
+
+  /* the offset must be within the serialized data. Otherwise, you forgot
+   * to serialize the respective sub-struct. */
+  assert(context->buffer->len > ptr_offset);
+
+  /* use the serialized pointer as a storage for the offset, relative to
+   * the begin of the structure that contains it */
+  target_ptr = (apr_size_t *)(context->buffer->data + ptr_offset);
+
+  *target_ptr = point_to_end
+              ? context->buffer->len - context->source->target_offset
+              : 0;
+}
+
+svn_temp_serializer__context_t *
+svn_temp_serializer__init(const void *source_struct,
+                          apr_size_t struct_size,
+                          apr_size_t suggested_buffer_size,
+                          apr_pool_t *pool)
+{
+  apr_size_t init_size = suggested_buffer_size < struct_size
+                       ? struct_size
+                       : suggested_buffer_size;
+
+  svn_temp_serializer__context_t *context = apr_palloc(pool,
+                                                       sizeof(*context));
+  context->pool = pool;
+  context->buffer = svn_stringbuf_create_ensure(init_size, pool);
+  context->recycler = NULL;
+
+  /* the root structure is at offset 0 and has no parent.  Without one,
+   * the first pushed structure will become the root. */
+  if (source_struct)
+    {
+      context->source = apr_palloc(pool, sizeof(*context->source));
+      context->source->source_struct = source_struct;
+      context->source->target_offset = 0;
+      context->source->upper = NULL;
+
+      svn_stringbuf_appendbytes(context->buffer, source_struct, struct_size);
+    }
+  else
+    context->source = NULL;
+
+  return context;
+}
+
+void
+svn_temp_serializer__push(svn_temp_serializer__context_t *context,
+                          const void * const * source_struct,
+                          apr_size_t struct_size)
+{
+  const void *source = *source_struct;
+  source_stack_t *new;
+
+  /* recycle an old entry or create a new one for the structure stack */
+  if (context->recycler)
+    {
+      new = context->recycler;
+      context->recycler = new->upper;
+    }
+  else
+    new = apr_palloc(context->pool, sizeof(*new));
+
+  /* the child structure will be stored at the end of the buffer. */
+  if (source)
+    align_buffer_end(context);
+
+  /* set the pointer to the now current struct in the parent */
+  store_current_end_pointer(context, source_struct, source != NULL);
+
+  /* make the new struct the current one */
+  new->source_struct = source;
+  new->target_offset = context->buffer->len;
+  new->upper = context->source;
+  context->source = new;
+
+  /* serialize the struct itself */
+  if (source)
+    svn_stringbuf_appendbytes(context->buffer, source, struct_size);
+}
+
+void
+svn_temp_serializer__pop(svn_temp_serializer__context_t *context)
+{
+  source_stack_t *old = context->source;
+
+  /* we may pop the original struct but not further */
+  assert(context->source);
+
+  /* one level up the structure stack */
+  context->source = context->source->upper;
+
+  /* put the old stack element into the recycler for later reuse */
+  old->upper = context->recycler;
+  context->recycler = old;
+}
+
+void
+svn_temp_serializer__add_string(svn_temp_serializer__context_t *context,
+                                const char * const * s)
+{
+  const char *string = *s;
+
+  /* Store the offset at which the string data will be appended.
+   * Strings don't need special alignment. */
+  store_current_end_pointer(context, (const void * const *)s,
+                            string != NULL);
+
+  /* append the string data */
+  if (string)
+    svn_stringbuf_appendbytes(context->buffer, string, strlen(string) + 1);
+}
+
+void
+svn_temp_serializer__set_null(svn_temp_serializer__context_t *context,
+                              const void * const * ptr)
+{
+  store_current_end_pointer(context, ptr, FALSE);
+}
+
+svn_stringbuf_t *
+svn_temp_serializer__get(svn_temp_serializer__context_t *context)
+{
+  return context->buffer;
+}
+
+void
+svn_temp_deserializer__resolve(void *buffer, void **ptr)
+{
+  /* Only resolve non-NULL pointers. */
+  if (*ptr)
+    {
+      /* replace the PTR_OFFSET in *ptr with the pointer to the actual
+       * data. */
+      *ptr = (char *)buffer + *(apr_size_t *)ptr;
+    }
+}
+
+const void *
+svn_temp_deserializer__ptr(const void *buffer, const void * const * ptr)
+{
+  return *ptr
+    ? (const char *)buffer + *(const apr_size_t *)ptr
+    : NULL;
+}
@@ -0,0 +1,266 @@
+/*
+ * tar.c :  writing tar archives to streams
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <string.h>
+
+#include <apr_strings.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_string.h"
+#include "svn_io.h"
+
+#include "private/svn_tar.h"
+
+
+/* Archives are written in blocks of this size. */
+#define TAR_BLOCK_SIZE 512
+
+/* Offsets and lengths of the ustar header fields we fill in. */
+#define NAME_OFFSET 0
+#define NAME_LEN 100
+#define MODE_OFFSET 100
+#define UID_OFFSET 108
+#define GID_OFFSET 116
+#define SIZE_OFFSET 124
+#define SIZE_LEN 12
+#define MTIME_OFFSET 136
+#define CHKSUM_OFFSET 148
+#define TYPEFLAG_OFFSET 156
+#define LINKNAME_OFFSET 157
+#define MAGIC_OFFSET 257
+#define VERSION_OFFSET 263
+#define PREFIX_OFFSET 345
+#define PREFIX_LEN 155
+
+/* The largest size that fits into the 11 octal digits of the size field. */
+#define MAX_USTAR_SIZE APR_INT64_C(077777777777)
+
+/* The name of the pax extended header members, as GNU tar writes it. */
+#define PAX_HEADER_NAME "././@PaxHeader"
+
+static const char zero_block[TAR_BLOCK_SIZE] = { 0 };
+
+/* Write VALUE to the LEN bytes at FIELD as a zero-padded octal number
+   followed by a NUL.  The value must fit. */
+static void
+put_octal(char *field, apr_size_t len, apr_uint64_t value)
+{
+  field[--len] = '\0';
+  while (len > 0)
+    {
+      field[--len] = (char)('0' + (value & 7));
+      value >>= 3;
+    }
+}
+
+/* Write a header block for a member of type TYPEFLAG to STREAM.  NAME,
+   PREFIX and LINKNAME (which may be NULL) must fit into their fields. */
+static svn_error_t *
+write_block(svn_stream_t *stream,
+            const char *prefix,
+            const char *name,
+            const char *linkname,
+            char typeflag,
+            unsigned int mode,
+            apr_uint64_t size,
+            apr_time_t mtime)
+{
+  char block[TAR_BLOCK_SIZE];
+  apr_size_t len = sizeof(block);
+  apr_uint32_t sum = 0;
+  apr_size_t i;
+
+  memset(block, 0, sizeof(block));
+  memcpy(block + NAME_OFFSET, name, strlen(name));
+  put_octal(block + MODE_OFFSET, 8, mode);
+  put_octal(block + UID_OFFSET, 8, 0);
+  put_octal(block + GID_OFFSET, 8, 0);
+  put_octal(block + SIZE_OFFSET, SIZE_LEN, size);
+  put_octal(block + MTIME_OFFSET, 12, mtime > 0 ? apr_time_sec(mtime) : 0);
+  block[TYPEFLAG_OFFSET] = typeflag;
+  if (linkname)
+    memcpy(block + LINKNAME_OFFSET, linkname, strlen(linkname));
+  memcpy(block + MAGIC_OFFSET, "ustar", 6);
+  memcpy(block + VERSION_OFFSET, "00", 2);
+  memcpy(block + PREFIX_OFFSET, prefix, strlen(prefix));
+
+  /* The checksum is computed with the checksum field set to spaces. */
+  memset(block + CHKSUM_OFFSET, ' ', 8);
+  for (i = 0; i < sizeof(block); i++)
+    sum += (unsigned char)block[i];
+  put_octal(block + CHKSUM_OFFSET, 7, sum);
+
+  return svn_stream_write(stream, block, &len);
+}
+
+/* Split the member name NAME into a ustar *PREFIX and *SHORT_NAME at a
+   slash.  Return FALSE if NAME can't be split that way. */
+static svn_boolean_t
+split_name(const char **prefix,
+           const char **short_name,
+           const char *name,
+           apr_pool_t *pool)
+{
+  apr_size_t len = strlen(name);
+  apr_size_t i = len > NAME_LEN + 1 ? len - NAME_LEN - 1 : 0;
+
+  /* The name part must not be empty, which rules out the trailing slash
+     of a directory. */
+  for (; i + 1 < len && i <= PREFIX_LEN; i++)
+    if (name[i] == '/')
+      {
+        *prefix = apr_pstrndup(pool, name, i);
+        *short_name = name + i + 1;
+        return TRUE;
+      }
+
+  return FALSE;
+}
+
+/* Append the pax extended header record KEY=VALUE to BUF. */
+static void
+append_pax_record(svn_stringbuf_t *buf,
+                  const char *key,
+                  const char *value,
+                  apr_pool_t *pool)
+{
+  /* A record is "LEN KEY=VALUE\n", where LEN counts its own digits. */
+  apr_size_t rest = strlen(key) + strlen(value) + 3;
+  apr_size_t len = rest + 1;
+  const char *len_str = apr_psprintf(pool, "%" APR_SIZE_T_FMT, len);
+
+  while (strlen(len_str) + rest != len)
+    {
+      len = strlen(len_str) + rest;
+      len_str = apr_psprintf(pool, "%" APR_SIZE_T_FMT, len);
+    }
+
+  svn_stringbuf_appendcstr(buf, len_str);
+  svn_stringbuf_appendbytes(buf, " ", 1);
+  svn_stringbuf_appendcstr(buf, key);
+  svn_stringbuf_appendbytes(buf, "=", 1);
+  svn_stringbuf_appendcstr(buf, value);
+  svn_stringbuf_appendbytes(buf, "\n", 1);
+}
+
+svn_error_t *
+svn_tar__write_header(svn_stream_t *stream,
+                      const char *name,
+                      svn_node_kind_t kind,
+                      const char *link_target,
+                      svn_filesize_t size,
+                      svn_boolean_t executable,
+                      apr_time_t mtime,
+                      apr_pool_t *scratch_pool)
+{
+  const char *prefix = "";
+  const char *short_name;
+  svn_stringbuf_t *pax = NULL;
+  char typeflag;
+  unsigned int mode;
+
+  if (kind == svn_node_dir)
+    {
+      name = apr_pstrcat(scratch_pool, name, "/", (char *)NULL);
+      typeflag = '5';
+      mode = 0755;
+      size = 0;
+    }
+  else if (link_target)
+    {
+      typeflag = '2';
+      mode = 0777;
+      size = 0;
+    }
+  else
+    {
+      typeflag = '0';
+      mode = executable ? 0755 : 0644;
+    }
+
+  short_name = name;
+  if (strlen(name) > NAME_LEN
+      && ! split_name(&prefix, &short_name, name, scratch_pool))
+    {
+      pax = svn_stringbuf_create("", scratch_pool);
+      append_pax_record(pax, "path", name, scratch_pool);
+      short_name = apr_pstrndup(scratch_pool, name, NAME_LEN);
+    }
+
+  if (link_target && strlen(link_target) > NAME_LEN)
+    {
+      if (! pax)
+        pax = svn_stringbuf_create("", scratch_pool);
+      append_pax_record(pax, "linkpath", link_target, scratch_pool);
+      link_target = apr_pstrndup(scratch_pool, link_target, NAME_LEN);
+    }
+
+  if (size > MAX_USTAR_SIZE)
+    {
+      if (! pax)
+        pax = svn_stringbuf_create("", scratch_pool);
+      append_pax_record(pax, "size",
+                        apr_psprintf(scratch_pool, "%" SVN_FILESIZE_T_FMT,
+                                     size),
+                        scratch_pool);
+      size = 0;
+    }
+
+  if (pax)
+    {
+      apr_size_t len = pax->len;
+
+      SVN_ERR(write_block(stream, "", PAX_HEADER_NAME, NULL, 'x', 0644,
+                          pax->len, mtime));
+      SVN_ERR(svn_stream_write(stream, pax->data, &len));
+      SVN_ERR(svn_tar__write_padding(stream, pax->len));
+    }
+
+  return write_block(stream, prefix, short_name, link_target, typeflag,
+                     mode, (apr_uint64_t) size, mtime);
+}
+
+svn_error_t *
+svn_tar__write_padding(svn_stream_t *stream,
+                       svn_filesize_t size)
+{
+  apr_size_t len = (apr_size_t) (size % TAR_BLOCK_SIZE);
+
+  if (len == 0)
+    return SVN_NO_ERROR;
+
+  len = TAR_BLOCK_SIZE - len;
+  return svn_stream_write(stream, zero_block, &len);
+}
+
+svn_error_t *
+svn_tar__write_trailer(svn_stream_t *stream)
+{
+  apr_size_t len = sizeof(zero_block);
+
+  SVN_ERR(svn_stream_write(stream, zero_block, &len));
+  len = sizeof(zero_block);
+  return svn_stream_write(stream, zero_block, &len);
+}
@@ -0,0 +1,101 @@
+/*
+ * trace.c :  recording spans of hot code paths
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <apr_time.h>
+
+#include "svn_types.h"
+#include "svn_private_config.h"
+#include "private/svn_atomic.h"
+#include "private/svn_trace.h"
+
+
+/* The states of the recorder. */
+#define TRACE_UNKNOWN 0   /* the environment has not been looked at yet */
+#define TRACE_STARTING 1  /* some thread is looking at it right now */
+#define TRACE_OFF 2
+#define TRACE_ON 3
+
+static volatile svn_atomic_t trace_state = TRACE_UNKNOWN;
+
+/* The file spans are written to and the shortest span worth writing, set
+   up before TRACE_STATE becomes TRACE_ON. */
+static FILE *trace_file = NULL;
+static apr_interval_time_t trace_threshold = 0;
+
+/* Set up the recorder from the environment. */
+static void
+init_trace(void)
+{
+  const char *path = getenv("SVN_TRACE_FILE");
+  const char *threshold = getenv("SVN_TRACE_THRESHOLD");
+
+  if (path && *path)
+    trace_file = fopen(path, "a");
+
+  if (trace_file)
+    {
+      /* One write per span keeps lines of different threads apart. */
+      setvbuf(trace_file, NULL, _IOLBF, BUFSIZ);
+      if (threshold)
+        trace_threshold = atol(threshold);
+    }
+
+  svn_atomic_set(&trace_state, trace_file ? TRACE_ON : TRACE_OFF);
+}
+
+apr_time_t
+svn_trace__start(void)
+{
+  svn_atomic_t state = svn_atomic_read(&trace_state);
+
+  if (state == TRACE_UNKNOWN
+      && svn_atomic_cas(&trace_state, TRACE_STARTING, TRACE_UNKNOWN)
+         == TRACE_UNKNOWN)
+    {
+      init_trace();
+      state = svn_atomic_read(&trace_state);
+    }
+
+  /* Spans that start while another thread sets up the recorder are
+     simply not recorded. */
+  return state == TRACE_ON ? apr_time_now() : 0;
+}
+
+void
+svn_trace__record(const char *name,
+                  const char *detail,
+                  apr_time_t start)
+{
+  apr_interval_time_t duration = apr_time_now() - start;
+
+  if (duration < trace_threshold)
+    return;
+
+  fprintf(trace_file, "%s\t%" APR_TIME_T_FMT "\t%" APR_TIME_T_FMT "\t%s\n",
+          name, start, duration, detail ? detail : "");
+}
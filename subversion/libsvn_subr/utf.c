@@ -29,6 +29,8 @@
 #include <apr_strings.h>
 #include <apr_lib.h>
 #include <apr_xlate.h>
+#include <apr_atomic.h>
+#include <apr_portable.h>
 
 #include "svn_string.h"
 #include "svn_error.h"
@@ -38,6 +40,7 @@
 #include "svn_private_config.h"
 #include "win32_xlate.h"
 
+#include "private/svn_string_private.h"
 #include "private/svn_utf_private.h"
 
 
@@ -79,6 +82,24 @@ typedef struct xlate_handle_node_t {
    memory leak. */
 static apr_hash_t *xlate_handle_hash = NULL;
 
+/* Most translations are between the native encoding and UTF-8, and most
+   of the time no more than one of them runs at once.  So we keep one
+   handle for each of these directions outside of the hash, where a
+   thread can take it and put it back with an atomic compare-and-swap
+   instead of locking xlate_handle_mutex.  The hash only comes into play
+   when translations overlap. */
+static volatile void *xlate_ntou_static_node = NULL;
+static volatile void *xlate_uton_static_node = NULL;
+
+/* TRUE if svn_utf_initialize() found that the native encoding is UTF-8,
+   so that converting between the two only needs validating the data. */
+static svn_boolean_t native_is_utf8 = FALSE;
+
+/* The node returned for conversions between the native encoding and
+   UTF-8 when NATIVE_IS_UTF8.  It has no handle, and is never cached. */
+static xlate_handle_node_t native_utf8_node = { NULL, TRUE, NULL, NULL,
+                                                NULL };
+
 /* Clean up the xlate handle cache. */
 static apr_status_t
 xlate_cleanup(void *arg)
@@ -90,10 +111,34 @@ xlate_cleanup(void *arg)
   xlate_handle_mutex = NULL;
 #endif
   xlate_handle_hash = NULL;
+  xlate_ntou_static_node = NULL;
+  xlate_uton_static_node = NULL;
 
   return APR_SUCCESS;
 }
 
+/* Return the place outside of the hash where the node for USERDATA_KEY
+   is cached, or NULL if there is none. */
+static volatile void **
+get_static_node_slot(const char *userdata_key)
+{
+  if (strcmp(userdata_key, SVN_UTF_NTOU_XLATE_HANDLE) == 0)
+    return &xlate_ntou_static_node;
+  else if (strcmp(userdata_key, SVN_UTF_UTON_XLATE_HANDLE) == 0)
+    return &xlate_uton_static_node;
+  else
+    return NULL;
+}
+
+/* Return TRUE if the character encoding name CHARSET means UTF-8. */
+static svn_boolean_t
+charset_is_utf8(const char *charset)
+{
+  return (charset
+          && (svn_cstring_casecmp(charset, "UTF-8") == 0
+              || svn_cstring_casecmp(charset, "UTF8") == 0));
+}
+
 /* Set the handle of ARG to NULL. */
 static apr_status_t
 xlate_handle_node_cleanup(void *arg)
@@ -130,6 +175,10 @@ svn_utf_initialize(apr_pool_t *pool)
       xlate_handle_hash = apr_hash_make(subpool);
       apr_pool_cleanup_register(subpool, NULL, xlate_cleanup,
                                 apr_pool_cleanup_null);
+
+#ifndef WIN32
+      native_is_utf8 = charset_is_utf8(apr_os_locale_encoding(subpool));
+#endif
     }
 }
 
@@ -183,6 +232,24 @@ get_xlate_handle_node(xlate_handle_node_t **ret,
     {
       if (xlate_handle_hash)
         {
+          volatile void **slot = get_static_node_slot(userdata_key);
+
+          /* Try the node kept outside of the hash first. */
+          if (slot)
+            {
+              old_node = (void *)*slot;
+              if (old_node
+                  && apr_atomic_casptr(slot, NULL, old_node) == old_node)
+                {
+                  if (old_node->valid)
+                    {
+                      *ret = old_node;
+                      return SVN_NO_ERROR;
+                    }
+                }
+              old_node = NULL;
+            }
+
 #if APR_HAS_THREADS
           apr_err = apr_thread_mutex_lock(xlate_handle_mutex);
           if (apr_err != APR_SUCCESS)
@@ -319,11 +386,17 @@ put_xlate_handle_node(xlate_handle_node_t *node,
                       apr_pool_t *pool)
 {
   assert(node->next == NULL);
-  if (!userdata_key)
+  if (!userdata_key || node == &native_utf8_node)
     return;
   if (xlate_handle_hash)
     {
       xlate_handle_node_t **node_p;
+      volatile void **slot = get_static_node_slot(userdata_key);
+
+      /* Keep it outside of the hash, if there is room there. */
+      if (slot && apr_atomic_casptr(slot, node, NULL) == NULL)
+        return;
+
 #if APR_HAS_THREADS
       if (apr_thread_mutex_lock(xlate_handle_mutex) != APR_SUCCESS)
         SVN_ERR_MALFUNCTION_NO_RETURN();
@@ -358,6 +431,12 @@ put_xlate_handle_node(xlate_handle_node_t *node,
 static svn_error_t *
 get_ntou_xlate_handle_node(xlate_handle_node_t **ret, apr_pool_t *pool)
 {
+  if (native_is_utf8)
+    {
+      *ret = &native_utf8_node;
+      return SVN_NO_ERROR;
+    }
+
   return get_xlate_handle_node(ret, SVN_APR_UTF8_CHARSET,
                                SVN_APR_LOCALE_CHARSET,
                                SVN_UTF_NTOU_XLATE_HANDLE, pool);
@@ -372,6 +451,12 @@ get_ntou_xlate_handle_node(xlate_handle_node_t **ret, apr_pool_t *pool)
 static svn_error_t *
 get_uton_xlate_handle_node(xlate_handle_node_t **ret, apr_pool_t *pool)
 {
+  if (native_is_utf8)
+    {
+      *ret = &native_utf8_node;
+      return SVN_NO_ERROR;
+    }
+
   return get_xlate_handle_node(ret, SVN_APR_LOCALE_CHARSET,
                                SVN_APR_UTF8_CHARSET,
                                SVN_UTF_UTON_XLATE_HANDLE, pool);
@@ -528,6 +613,35 @@ check_non_ascii(const char *data, apr_size_t len, apr_pool_t *pool)
 {
   const char *data_start = data;
 
+  /* Skip over printable ASCII, octets 0x20 to 0x7e, an aligned machine
+     word at a time as far as it goes.  The loop below deals with what
+     is left, including whitespace and errors. */
+  for (; len > 0 && ((apr_uintptr_t)data % sizeof(apr_size_t)) != 0;
+       --len, data++)
+    if (! ((unsigned char)*data >= 0x20 && (unsigned char)*data < 0x7f))
+      break;
+
+  if (((apr_uintptr_t)data % sizeof(apr_size_t)) == 0)
+    {
+      const apr_size_t ones = (apr_size_t)-1 / 0xff;
+      const apr_size_t high_bits = ones * 0x80;
+
+      while (len >= sizeof(apr_size_t))
+        {
+          apr_size_t word = *(const apr_size_t *)data;
+
+          /* Any octet >= 0x80, < 0x20 or == 0x7f? */
+          if ((word & high_bits)
+              || ((word - ones * 0x20) & ~word & high_bits)
+              || (((word ^ (ones * 0x7f)) - ones) & ~(word ^ (ones * 0x7f))
+                  & high_bits))
+            break;
+
+          data += sizeof(apr_size_t);
+          len -= sizeof(apr_size_t);
+        }
+    }
+
   for (; len > 0; --len, data++)
     {
       if ((! apr_isascii(*data))
@@ -615,6 +729,22 @@ check_utf8(const char *data, apr_size_t len, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Verify that the LEN bytes at DATA can be passed through unchanged by
+   NODE, which has no handle: if NODE is NATIVE_UTF8_NODE, they must be
+   valid UTF-8, or else safe ASCII.  Otherwise, return an error with code
+   APR_EINVAL. */
+static svn_error_t *
+check_untranslated(xlate_handle_node_t *node,
+                   const char *data,
+                   apr_size_t len,
+                   apr_pool_t *pool)
+{
+  if (node == &native_utf8_node)
+    return check_utf8(data, len, pool);
+  else
+    return check_non_ascii(data, len, pool);
+}
+
 /* Verify that the NULL terminated sequence DATA is valid UTF-8.
    If it is not, return an error with code APR_EINVAL. */
 static svn_error_t *
@@ -645,7 +775,7 @@ svn_utf_stringbuf_to_utf8(svn_stringbuf_t **dest,
     }
   else
     {
-      err = check_non_ascii(src->data, src->len, pool);
+      err = check_untranslated(node, src->data, src->len, pool);
       if (! err)
         *dest = svn_stringbuf_dup(src, pool);
     }
@@ -673,11 +803,11 @@ svn_utf_string_to_utf8(const svn_string_t **dest,
       if (! err)
         err = check_utf8(destbuf->data, destbuf->len, pool);
       if (! err)
-        *dest = svn_string_create_from_buf(destbuf, pool);
+        *dest = svn_stringbuf__morph_into_string(destbuf);
     }
   else
     {
-      err = check_non_ascii(src->data, src->len, pool);
+      err = check_untranslated(node, src->data, src->len, pool);
       if (! err)
         *dest = svn_string_dup(src, pool);
     }
@@ -708,7 +838,11 @@ convert_cstring(const char **dest,
   else
     {
       apr_size_t len = strlen(src);
-      SVN_ERR(check_non_ascii(src, len, pool));
+
+      /* Our callers check that UTF-8 data is valid, so all that's left
+         to check is ASCII-only data. */
+      if (node != &native_utf8_node)
+        SVN_ERR(check_non_ascii(src, len, pool));
       *dest = apr_pstrmemdup(pool, src, len);
     }
   return SVN_NO_ERROR;
@@ -780,7 +914,7 @@ svn_utf_stringbuf_from_utf8(svn_stringbuf_t **dest,
     }
   else
     {
-      err = check_non_ascii(src->data, src->len, pool);
+      err = check_untranslated(node, src->data, src->len, pool);
       if (! err)
         *dest = svn_stringbuf_dup(src, pool);
     }
@@ -809,11 +943,11 @@ svn_utf_string_from_utf8(const svn_string_t **dest,
         err = convert_to_stringbuf(node, src->data, src->len,
                                    &dbuf, pool);
       if (! err)
-        *dest = svn_string_create_from_buf(dbuf, pool);
+        *dest = svn_stringbuf__morph_into_string(dbuf);
     }
   else
     {
-      err = check_non_ascii(src->data, src->len, pool);
+      err = check_untranslated(node, src->data, src->len, pool);
       if (! err)
         *dest = svn_string_dup(src, pool);
     }
@@ -950,7 +1084,7 @@ svn_utf_cstring_from_utf8_string(const char **dest,
     }
   else
     {
-      err = check_non_ascii(src->data, src->len, pool);
+      err = check_untranslated(node, src->data, src->len, pool);
       if (! err)
         *dest = apr_pstrmemdup(pool, src->data, src->len);
     }
@@ -58,6 +58,32 @@
 
 #include "private/svn_utf_private.h"
 
+/* A word with the high bit set in each of its bytes. */
+#define HIGH_BITS ((apr_size_t)-1 / 0xff * 0x80)
+
+/* Return a pointer to the first octet in DATA, up to END, that is not
+   seven-bit ASCII, or END if there is none.  Long runs of ASCII are
+   checked a machine word at a time. */
+static const char *
+first_non_ascii(const char *data, const char *end)
+{
+  while (data < end && ((apr_uintptr_t)data % sizeof(apr_size_t)) != 0)
+    {
+      if ((unsigned char)*data >= 0x80)
+        return data;
+      ++data;
+    }
+
+  while (end - data >= (apr_ssize_t)sizeof(apr_size_t)
+         && (*(const apr_size_t *)data & HIGH_BITS) == 0)
+    data += sizeof(apr_size_t);
+
+  while (data < end && (unsigned char)*data < 0x80)
+    ++data;
+
+  return data;
+}
+
 /* Lookup table to categorise each octet in the string. */
 static const char octet_category[256] = {
   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x00-0x7f */
@@ -257,8 +283,19 @@ svn_utf__last_valid(const char *data, apr_size_t len)
   int state = FSM_START;
   while (data < end)
     {
-      unsigned char octet = *data++;
-      int category = octet_category[octet];
+      unsigned char octet;
+      int category;
+
+      if (state == FSM_START)
+        {
+          data = first_non_ascii(data, end);
+          start = data;
+          if (data == end)
+            break;
+        }
+
+      octet = *data++;
+      category = octet_category[octet];
       state = machine[state][category];
       if (state == FSM_START)
         start = data;
@@ -286,8 +323,18 @@ svn_utf__is_valid(const char *data, apr_size_t len)
   int state = FSM_START;
   while (data < end)
     {
-      unsigned char octet = *data++;
-      int category = octet_category[octet];
+      unsigned char octet;
+      int category;
+
+      if (state == FSM_START)
+        {
+          data = first_non_ascii(data, end);
+          if (data == end)
+            break;
+        }
+
+      octet = *data++;
+      category = octet_category[octet];
       state = machine[state][category];
     }
   return state == FSM_START;
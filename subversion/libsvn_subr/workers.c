@@ -0,0 +1,295 @@
+/* workers.c : process queued tasks on several threads
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
+
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "private/svn_workers.h"
+
+#if APR_HAS_THREADS
+
+/* A worker thread and its root pool. */
+typedef struct worker_t
+{
+  svn_workers__t *workers;
+  apr_thread_t *thread;
+  apr_pool_t *pool;
+} worker_t;
+
+struct svn_workers__t
+{
+  /* The function processing the tasks and its baton. */
+  svn_workers__process_t process;
+  void *baton;
+
+  /* The tasks queued but not started yet, linked through their NEXT
+     fields, oldest first.  Once STOPPED is set, no more tasks get
+     started.  Access to these and to the DONE and ERR fields of all
+     tasks is serialized by MUTEX, and COND gets signalled whenever
+     any of them changes. */
+  svn_workers__task_t *first;
+  svn_workers__task_t *last;
+  svn_boolean_t stopped;
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* The COUNT workers that are running or have not been joined yet. */
+  worker_t *workers;
+  int count;
+
+  /* Root pool for the structure itself, its mutex, condition and
+     threads, as it must outlive any pool a worker might use. */
+  apr_pool_t *pool;
+};
+
+/* Stop starting the tasks of WORKERS: mark those queued but not started
+   as done.  The caller must hold the mutex of WORKERS. */
+static void
+drop_queued(svn_workers__t *workers)
+{
+  svn_workers__task_t *task;
+
+  for (task = workers->first; task; task = task->next)
+    task->done = TRUE;
+
+  workers->first = NULL;
+  workers->last = NULL;
+  workers->stopped = TRUE;
+  apr_thread_cond_broadcast(workers->cond);
+}
+
+/* Thread function processing the tasks of DATA->WORKERS until they get
+   stopped.  DATA is a worker_t. */
+static void * APR_THREAD_FUNC
+worker_thread(apr_thread_t *thread, void *data)
+{
+  worker_t *worker = data;
+  svn_workers__t *workers = worker->workers;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+  void *state = NULL;
+
+  while (TRUE)
+    {
+      svn_workers__task_t *task;
+      svn_error_t *err;
+
+      apr_thread_mutex_lock(workers->mutex);
+      while (! workers->stopped && ! workers->first)
+        apr_thread_cond_wait(workers->cond, workers->mutex);
+      if (workers->stopped)
+        {
+          apr_thread_mutex_unlock(workers->mutex);
+          break;
+        }
+      task = workers->first;
+      workers->first = task->next;
+      if (! workers->first)
+        workers->last = NULL;
+      apr_thread_mutex_unlock(workers->mutex);
+
+      svn_pool_clear(iterpool);
+      err = workers->process(workers->baton, &state, task->item,
+                             worker->pool, iterpool);
+
+      apr_thread_mutex_lock(workers->mutex);
+      task->err = err;
+      task->done = TRUE;
+      if (err)
+        drop_queued(workers);
+      apr_thread_cond_broadcast(workers->cond);
+      apr_thread_mutex_unlock(workers->mutex);
+    }
+
+  svn_pool_destroy(iterpool);
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Stop the tasks and join the threads of WORKERS, if that has not been
+   done yet. */
+static void
+join_workers(svn_workers__t *workers)
+{
+  int i;
+
+  apr_thread_mutex_lock(workers->mutex);
+  drop_queued(workers);
+  apr_thread_mutex_unlock(workers->mutex);
+
+  for (i = 0; i < workers->count; i++)
+    {
+      apr_status_t retval;
+
+      apr_thread_join(&retval, workers->workers[i].thread);
+      svn_pool_destroy(workers->workers[i].pool);
+    }
+  workers->count = 0;
+}
+
+/* Pool cleanup stopping and destroying BATON, a svn_workers__t. */
+static apr_status_t
+cleanup_workers(void *baton)
+{
+  svn_workers__t *workers = baton;
+
+  join_workers(workers);
+  svn_pool_destroy(workers->pool);
+
+  return APR_SUCCESS;
+}
+
+svn_workers__t *
+svn_workers__start(int count,
+                   svn_workers__process_t process,
+                   void *baton,
+                   apr_pool_t *pool)
+{
+  apr_pool_t *workers_pool = svn_pool_create(NULL);
+  svn_workers__t *workers = apr_pcalloc(workers_pool, sizeof(*workers));
+
+  if (apr_thread_mutex_create(&workers->mutex, APR_THREAD_MUTEX_DEFAULT,
+                              workers_pool)
+      || apr_thread_cond_create(&workers->cond, workers_pool))
+    {
+      svn_pool_destroy(workers_pool);
+      return NULL;
+    }
+
+  workers->process = process;
+  workers->baton = baton;
+  workers->pool = workers_pool;
+  workers->workers = apr_pcalloc(workers_pool,
+                                 count * sizeof(*workers->workers));
+
+  for (; workers->count < count; workers->count++)
+    {
+      worker_t *worker = &workers->workers[workers->count];
+
+      worker->workers = workers;
+      worker->pool = svn_pool_create(NULL);
+      if (apr_thread_create(&worker->thread, NULL, worker_thread, worker,
+                            workers_pool))
+        {
+          svn_pool_destroy(worker->pool);
+          break;
+        }
+    }
+
+  if (! workers->count)
+    {
+      svn_pool_destroy(workers_pool);
+      return NULL;
+    }
+
+  apr_pool_cleanup_register(pool, workers, cleanup_workers,
+                            apr_pool_cleanup_null);
+  return workers;
+}
+
+void
+svn_workers__queue(svn_workers__t *workers,
+                   svn_workers__task_t *task,
+                   void *item)
+{
+  task->item = item;
+  task->done = FALSE;
+  task->err = SVN_NO_ERROR;
+  task->next = NULL;
+
+  apr_thread_mutex_lock(workers->mutex);
+  if (workers->stopped)
+    task->done = TRUE;
+  else if (workers->last)
+    workers->last->next = task;
+  else
+    workers->first = task;
+  if (! task->done)
+    workers->last = task;
+  apr_thread_cond_broadcast(workers->cond);
+  apr_thread_mutex_unlock(workers->mutex);
+}
+
+svn_error_t *
+svn_workers__wait(svn_workers__t *workers,
+                  svn_workers__task_t *task)
+{
+  svn_error_t *err;
+
+  apr_thread_mutex_lock(workers->mutex);
+  while (! task->done)
+    apr_thread_cond_wait(workers->cond, workers->mutex);
+  err = task->err;
+  task->err = SVN_NO_ERROR;
+  apr_thread_mutex_unlock(workers->mutex);
+
+  return svn_error_return(err);
+}
+
+void
+svn_workers__stop(svn_workers__t *workers)
+{
+  join_workers(workers);
+}
+
+#else /* ! APR_HAS_THREADS */
+
+/* Without threads, svn_workers__start() never returns workers the other
+   functions could be called with. */
+
+svn_workers__t *
+svn_workers__start(int count,
+                   svn_workers__process_t process,
+                   void *baton,
+                   apr_pool_t *pool)
+{
+  return NULL;
+}
+
+void
+svn_workers__queue(svn_workers__t *workers,
+                   svn_workers__task_t *task,
+                   void *item)
+{
+  SVN_ERR_MALFUNCTION_NO_RETURN();
+}
+
+svn_error_t *
+svn_workers__wait(svn_workers__t *workers,
+                  svn_workers__task_t *task)
+{
+  SVN_ERR_MALFUNCTION();
+}
+
+void
+svn_workers__stop(svn_workers__t *workers)
+{
+  SVN_ERR_MALFUNCTION_NO_RETURN();
+}
+
+#endif /* APR_HAS_THREADS */
@@ -100,22 +100,55 @@ svn_xml_is_xml_safe(const char *data, apr_size_t len)
 
 /*** XML escaping. ***/
 
-/* ### ...?
+/* Flags for the characters which xml_escape() may have to replace by
+   an entity reference.  All of them are below 64, so any byte outside
+   of this table -- including every byte of a multi-byte UTF-8 sequence
+   -- is copied as-is. */
+#define XML_ESCAPE_CDATA 1
+#define XML_ESCAPE_ATTR  2
+#define XML_ESCAPE_BOTH  (XML_ESCAPE_CDATA | XML_ESCAPE_ATTR)
+
+static const unsigned char xml_escape_class[64] =
+  {
+    /* 0x00 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x08 */ 0, XML_ESCAPE_ATTR, XML_ESCAPE_ATTR, 0,
+               0, XML_ESCAPE_BOTH, 0, 0,                 /* \t \n \r */
+    /* 0x10 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x18 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20 */ 0, 0, XML_ESCAPE_ATTR, 0,
+               0, 0, XML_ESCAPE_BOTH, XML_ESCAPE_ATTR,   /* " & ' */
+    /* 0x28 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x30 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x38 */ 0, 0, 0, 0,
+               XML_ESCAPE_BOTH, 0, XML_ESCAPE_BOTH, 0    /* < > */
+  };
+
+/* Return non-zero if the character C must be escaped in the context
+   given by the XML_ESCAPE_* FLAGS. */
+#define XML_NEEDS_ESCAPE(c, flags) \
+  ((unsigned char)(c) < 64 && (xml_escape_class[(unsigned char)(c)] & (flags)))
+
+/* Escape LEN bytes of DATA for use in the context given by the
+ * XML_ESCAPE_* FLAGS.  Runs of bytes which need no escaping are
+ * copied into the output in one go.
  *
  * If *OUTSTR is @c NULL, set *OUTSTR to a new stringbuf allocated
  * in POOL, else append to the existing stringbuf there.
  */
 static void
-xml_escape_cdata(svn_stringbuf_t **outstr,
-                 const char *data,
-                 apr_size_t len,
-                 apr_pool_t *pool)
+xml_escape(svn_stringbuf_t **outstr,
+           const char *data,
+           apr_size_t len,
+           unsigned char flags,
+           apr_pool_t *pool)
 {
   const char *end = data + len;
   const char *p = data, *q;
 
   if (*outstr == NULL)
-    *outstr = svn_stringbuf_create("", pool);
+    *outstr = svn_stringbuf_create_ensure(len, pool);
+  else
+    svn_stringbuf_ensure(*outstr, (*outstr)->len + len + 1);
 
   while (1)
     {
@@ -130,28 +163,58 @@ xml_escape_cdata(svn_stringbuf_t **outstr,
          golly, if we say we want to escape a '\r', we want to make
          sure it remains a '\r'!  */
       q = p;
-      while (q < end && *q != '&' && *q != '<' && *q != '>' && *q != '\r')
+      while (q < end && ! XML_NEEDS_ESCAPE(*q, flags))
         q++;
-      svn_stringbuf_appendbytes(*outstr, p, q - p);
+      if (q > p)
+        svn_stringbuf_appendbytes(*outstr, p, q - p);
 
       /* We may already be a winner.  */
       if (q == end)
         break;
 
       /* Append the entity reference for the character.  */
-      if (*q == '&')
-        svn_stringbuf_appendcstr(*outstr, "&amp;");
-      else if (*q == '<')
-        svn_stringbuf_appendcstr(*outstr, "&lt;");
-      else if (*q == '>')
-        svn_stringbuf_appendcstr(*outstr, "&gt;");
-      else if (*q == '\r')
-        svn_stringbuf_appendcstr(*outstr, "&#13;");
+      switch (*q)
+        {
+          case '&':
+            svn_stringbuf_appendbytes(*outstr, "&amp;", 5);
+            break;
+          case '<':
+            svn_stringbuf_appendbytes(*outstr, "&lt;", 4);
+            break;
+          case '>':
+            svn_stringbuf_appendbytes(*outstr, "&gt;", 4);
+            break;
+          case '"':
+            svn_stringbuf_appendbytes(*outstr, "&quot;", 6);
+            break;
+          case '\'':
+            svn_stringbuf_appendbytes(*outstr, "&apos;", 6);
+            break;
+          case '\r':
+            svn_stringbuf_appendbytes(*outstr, "&#13;", 5);
+            break;
+          case '\n':
+            svn_stringbuf_appendbytes(*outstr, "&#10;", 5);
+            break;
+          case '\t':
+            svn_stringbuf_appendbytes(*outstr, "&#9;", 4);
+            break;
+        }
 
       p = q + 1;
     }
 }
 
+/* Escape LEN bytes of DATA for use as character data. */
+static void
+xml_escape_cdata(svn_stringbuf_t **outstr,
+                 const char *data,
+                 apr_size_t len,
+                 apr_pool_t *pool)
+{
+  xml_escape(outstr, data, len, XML_ESCAPE_CDATA, pool);
+}
+
 /* Essentially the same as xml_escape_cdata, with the addition of
    whitespace and quote characters. */
 static void
@@ -160,50 +223,9 @@ xml_escape_attr(svn_stringbuf_t **outstr,
                 apr_size_t len,
                 apr_pool_t *pool)
 {
-  const char *end = data + len;
-  const char *p = data, *q;
-
-  if (*outstr == NULL)
-    *outstr = svn_stringbuf_create_ensure(len, pool);
-
-  while (1)
-    {
-      /* Find a character which needs to be quoted and append bytes up
-         to that point. */
-      q = p;
-      while (q < end && *q != '&' && *q != '<' && *q != '>'
-             && *q != '"' && *q != '\'' && *q != '\r'
-             && *q != '\n' && *q != '\t')
-        q++;
-      svn_stringbuf_appendbytes(*outstr, p, q - p);
-
-      /* We may already be a winner.  */
-      if (q == end)
-        break;
-
-      /* Append the entity reference for the character.  */
-      if (*q == '&')
-        svn_stringbuf_appendcstr(*outstr, "&amp;");
-      else if (*q == '<')
-        svn_stringbuf_appendcstr(*outstr, "&lt;");
-      else if (*q == '>')
-        svn_stringbuf_appendcstr(*outstr, "&gt;");
-      else if (*q == '"')
-        svn_stringbuf_appendcstr(*outstr, "&quot;");
-      else if (*q == '\'')
-        svn_stringbuf_appendcstr(*outstr, "&apos;");
-      else if (*q == '\r')
-        svn_stringbuf_appendcstr(*outstr, "&#13;");
-      else if (*q == '\n')
-        svn_stringbuf_appendcstr(*outstr, "&#10;");
-      else if (*q == '\t')
-        svn_stringbuf_appendcstr(*outstr, "&#9;");
-
-      p = q + 1;
-    }
+  xml_escape(outstr, data, len, XML_ESCAPE_ATTR, pool);
 }
 
-
 void
 svn_xml_escape_cdata_stringbuf(svn_stringbuf_t **outstr,
                                const svn_stringbuf_t *string,
@@ -99,7 +99,9 @@ restore_file(svn_wc__db_t *db,
    last-commit-time.
 
    Set RESTORED to TRUE if the node is successfull restored. RESTORED will
-   be FALSE if restoring this node is not supported.
+   be FALSE if restoring this node is not supported.  A file checked out
+   without its text has nothing to be restored from, but isn't missing
+   either; set RESTORED to TRUE without restoring it.
 
    This function does all temporary allocations in SCRATCH_POOL
  */
@@ -119,6 +121,16 @@ restore_node(svn_boolean_t *restored,
      directories after we move to a single database and pristine store. */
   if (kind == svn_wc__db_kind_file || kind == svn_wc__db_kind_symlink)
     {
+      svn_boolean_t dehydrated;
+
+      SVN_ERR(svn_wc__internal_is_dehydrated(&dehydrated, db, local_abspath,
+                                             NULL, scratch_pool));
+      if (dehydrated)
+        {
+          *restored = TRUE;
+          return SVN_NO_ERROR;
+        }
+
       /* ... recreate file from text-base, and ... */
       SVN_ERR(restore_file(db, local_abspath, use_commit_times,
                            scratch_pool));
@@ -230,6 +242,7 @@ report_revisions_and_depths(svn_wc__db_t *db,
 {
   const char *dir_abspath;
   const apr_array_header_t *base_children;
+  apr_hash_t *base_infos;
   apr_hash_t *dirents;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   int i;
@@ -243,6 +256,8 @@ report_revisions_and_depths(svn_wc__db_t *db,
   dir_abspath = svn_dirent_join(anchor_abspath, dir_path, scratch_pool);
   SVN_ERR(svn_wc__db_base_get_children(&base_children, db, dir_abspath,
                                        scratch_pool, iterpool));
+  SVN_ERR(svn_wc__db_base_get_children_info(&base_infos, db, dir_abspath,
+                                            scratch_pool, iterpool));
   SVN_ERR(svn_io_get_dir_filenames(&dirents, dir_abspath, scratch_pool));
 
   /*** Do the real reporting and recursing. ***/
@@ -266,7 +281,9 @@ report_revisions_and_depths(svn_wc__db_t *db,
    * call the external_func callback. */
   if (external_func)
     {
-      const apr_array_header_t *all_children;
+      apr_hash_t *all_children;
+      apr_hash_t *conflicts;
+      apr_hash_index_t *hi;
 
       SVN_ERR(read_externals_info(db, dir_abspath, external_func,
                                   external_baton, dir_depth, iterpool));
@@ -274,31 +291,26 @@ report_revisions_and_depths(svn_wc__db_t *db,
       /* Also do this for added children. They aren't part of the base
        * tree so we don't recurse into them. But our caller might still
        * want to pull externals into them as part of the update operation. */
-      SVN_ERR(svn_wc__db_read_children(&all_children, db, dir_abspath,
-                                       scratch_pool, iterpool));
-      for (i = 0; i < all_children->nelts; ++i)
+      SVN_ERR(svn_wc__db_read_children_info(&all_children, &conflicts,
+                                            db, dir_abspath,
+                                            scratch_pool, iterpool));
+      for (hi = apr_hash_first(scratch_pool, all_children);
+           hi;
+           hi = apr_hash_next(hi))
         {
-          const char *child = APR_ARRAY_IDX(all_children, i, const char *);
-          const char *this_abspath;
-          svn_wc__db_status_t this_status;
-          svn_wc__db_kind_t this_kind;
-          svn_depth_t this_depth;
+          const char *child = svn__apr_hash_index_key(hi);
+          const struct svn_wc__db_info_t *info = svn__apr_hash_index_val(hi);
 
           svn_pool_clear(iterpool);
 
-          this_abspath = svn_dirent_join(dir_abspath, child, iterpool);
-          SVN_ERR(svn_wc__db_read_info(&this_status, &this_kind, NULL, NULL,
-                                       NULL, NULL, NULL, NULL, NULL, NULL,
-                                       &this_depth, NULL, NULL, NULL, NULL,
-                                       NULL, NULL, NULL, NULL, NULL, NULL,
-                                       NULL, NULL, NULL,
-                                       db, this_abspath, iterpool, iterpool));
-          if (this_kind == svn_wc__db_kind_dir &&
-              this_status == svn_wc__db_status_added)
+          if (info->kind == svn_wc__db_kind_dir &&
+              info->status == svn_wc__db_status_added)
             {
-              SVN_ERR(read_externals_info(db, this_abspath, external_func,
-                                          external_baton, this_depth,
-                                          iterpool));
+              SVN_ERR(read_externals_info(db,
+                                          svn_dirent_join(dir_abspath, child,
+                                                          iterpool),
+                                          external_func, external_baton,
+                                          info->depth, iterpool));
             }
         }
     }
@@ -316,7 +328,7 @@ report_revisions_and_depths(svn_wc__db_t *db,
       svn_depth_t this_depth;
       svn_wc__db_lock_t *this_lock;
       svn_boolean_t this_switched;
-      svn_error_t *err;
+      const struct svn_wc__db_base_info_t *this_info;
 
       /* Clear the iteration subpool here because the loop has a bunch
          of 'continue' jump statements. */
@@ -326,35 +338,20 @@ report_revisions_and_depths(svn_wc__db_t *db,
       this_path = svn_dirent_join(dir_path, child, iterpool);
       this_abspath = svn_dirent_join(dir_abspath, child, iterpool);
 
-      err = svn_wc__db_base_get_info(&this_status, &this_kind, &this_rev,
-                                     &this_repos_relpath, &this_repos_root_url,
-                                     NULL, NULL, NULL, NULL, NULL, &this_depth,
-                                     NULL, NULL, NULL, &this_lock,
-                                     db, this_abspath, iterpool, iterpool);
-      if (err)
-        {
-          if (err->apr_err != SVN_ERR_WC_PATH_NOT_FOUND)
-            return svn_error_return(err);
-
-          /* THIS_ABSPATH was listed as a BASE child of DIR_ABSPATH. Yet,
-             we just got an error trying to read it. What gives? :-P
-
-             This happens when THIS_ABSPATH is a subdirectory that is
-             marked in the parent stub as "not-present". The subdir is
-             then removed. Later, an addition is scheduled, putting the
-             subdirectory back, but ONLY containing WORKING nodes.
-
-             Thus, the BASE fetch comes out of the subdir, and fails.
-
-             For this case, we go ahead and treat this as a simple
-             not-present, and ignore whatever is in the subdirectory.  */
-          svn_error_clear(err);
-
-          this_status = svn_wc__db_status_not_present;
-
-          /* Note: the other THIS_* local variables pass to base_get_info
-             are NOT set at this point. But we don't need them...  */
-        }
+      this_info = apr_hash_get(base_infos, child, APR_HASH_KEY_STRING);
+      this_status = this_info->status;
+      this_kind = this_info->kind;
+      this_rev = this_info->revnum;
+      this_repos_relpath = this_info->repos_relpath;
+      this_repos_root_url = this_info->repos_root_url;
+      this_depth = this_info->depth;
+      this_lock = this_info->lock;
+
+      /* A not-present status may also mean that THIS_ABSPATH is a
+         subdirectory that is marked in the parent stub as "not-present",
+         was removed, and then got scheduled for addition again, so that
+         it ONLY contains WORKING nodes.  We treat this as a simple
+         not-present, and ignore whatever is in the subdirectory.  */
 
       /* Note: some older code would attempt to check the parent stub
          of subdirectories for the not-present state. That check was
@@ -479,16 +476,8 @@ report_revisions_and_depths(svn_wc__db_t *db,
                                                 iterpool);
         }
       else
-        {
-          const char *childname = svn_relpath_is_child(dir_repos_relpath,
-                                                       this_repos_relpath,
-                                                       NULL);
-
-          if (childname == NULL || strcmp(childname, child) != 0)
-            this_switched = TRUE;
-          else
-            this_switched = FALSE;
-        }
+        this_switched = ! svn_relpath__is_joined(this_repos_relpath,
+                                                 dir_repos_relpath, child);
 
       /* Tweak THIS_DEPTH to a useful value.  */
       if (this_depth == svn_depth_unknown)
@@ -990,9 +979,8 @@ svn_wc_crawl_revisions5(svn_wc_context_t *wc_ctx,
       if (err)
         goto abort_report;
 
-      if (strcmp(repos_relpath,
-                 svn_relpath_join(parent_repos_relpath, base,
-                                  scratch_pool)) != 0)
+      if (! svn_relpath__is_joined(repos_relpath, parent_repos_relpath,
+                                   base))
         {
           /* This file is disjoint with respect to its parent
              directory.  Since we are looking at the actual target of
@@ -1107,70 +1095,104 @@ copying_stream(svn_stream_t *source,
   return stream;
 }
 
-svn_error_t *
-svn_wc__internal_transmit_text_deltas(const char **tempfile,
-                                      const svn_checksum_t **new_text_base_md5_checksum,
-                                      const svn_checksum_t **new_text_base_sha1_checksum,
-                                      svn_wc__db_t *db,
-                                      const char *local_abspath,
-                                      svn_boolean_t fulltext,
-                                      const svn_delta_editor_t *editor,
-                                      void *file_baton,
-                                      apr_pool_t *result_pool,
-                                      apr_pool_t *scratch_pool)
+/* A text delta of a working file against its pristine text, set up by
+   prepare_text_delta() and sent by finish_text_delta(). */
+struct svn_wc__text_delta_t
 {
-  svn_txdelta_window_handler_t handler;
-  void *wh_baton;
+  const char *local_abspath;
+
+  /* The pool everything below lives in. */
+  apr_pool_t *pool;
+
+  /* Delta source (possibly empty) and target (LOCAL_ABSPATH translated
+     to normal form). */
+  svn_stream_t *base_stream;
+  svn_stream_t *local_stream;
+
+  /* The stored (or calculated) MD5 checksum of BASE_STREAM, and if it was
+     stored, the one actually calculated while reading it. */
   const svn_checksum_t *expected_md5_checksum;
-  svn_checksum_t *verify_checksum = NULL;  /* calc'd MD5 of BASE_STREAM */
-  svn_checksum_t *local_md5_checksum;  /* calc'd MD5 of LOCAL_STREAM */
-  svn_checksum_t *local_sha1_checksum;  /* calc'd SHA1 of LOCAL_STREAM */
+  svn_checksum_t *verify_checksum;
+
+  /* The checksums of LOCAL_STREAM, calculated while reading it. */
+  svn_checksum_t *local_md5_checksum;
+  svn_checksum_t *local_sha1_checksum;
+
+  /* The repository-normal copy of LOCAL_ABSPATH, if wanted, and the new
+     pristine text, if wanted. */
+  const char *tempfile;
   const char *new_pristine_tmp_abspath;
+
+  /* For deltas computed ahead of sending them: the svndiff written by
+     svn_wc__text_delta_compute(), and the error it ran into. */
+  svn_stream_t *spool_stream;
+  const char *spool_abspath;
   svn_error_t *err;
-  svn_stream_t *base_stream;  /* delta source */
-  svn_stream_t *local_stream;  /* delta target: LOCAL_ABSPATH transl. to NF */
+};
+
+/* Set *DELTA to a new text delta of LOCAL_ABSPATH in DB, sending a
+   fulltext if FULLTEXT.  If WANT_TEMPFILE, arrange for a copy of the
+   working file in repository-normal form; if WANT_SHA1, for a new
+   pristine text.  If SPOOL, also open a temporary file for the svndiff.
+
+   Allocate *DELTA, and do all other allocations, in POOL: the streams
+   keep using it while the delta is being computed. */
+static svn_error_t *
+prepare_text_delta(svn_wc__text_delta_t **delta,
+                   svn_boolean_t want_tempfile,
+                   svn_boolean_t want_sha1,
+                   svn_boolean_t spool,
+                   svn_wc__db_t *db,
+                   const char *local_abspath,
+                   svn_boolean_t fulltext,
+                   apr_pool_t *pool)
+{
+  svn_wc__text_delta_t *td = apr_pcalloc(pool, sizeof(*td));
+
+  td->local_abspath = apr_pstrdup(pool, local_abspath);
+  td->pool = pool;
 
   /* Translated input */
-  SVN_ERR(svn_wc__internal_translated_stream(&local_stream, db,
+  SVN_ERR(svn_wc__internal_translated_stream(&td->local_stream, db,
                                              local_abspath, local_abspath,
                                              SVN_WC_TRANSLATE_TO_NF,
-                                             scratch_pool, scratch_pool));
+                                             pool, pool));
 
   /* If the caller wants a copy of the working file translated to
    * repository-normal form, make the copy by tee-ing the stream and set
-   * *TEMPFILE to the path to it. */
-  if (tempfile)
+   * TD->TEMPFILE to the path to it. */
+  if (want_tempfile)
     {
       svn_stream_t *tempstream;
 
-      SVN_ERR(svn_wc__text_base_deterministic_tmp_path(tempfile,
+      SVN_ERR(svn_wc__text_base_deterministic_tmp_path(&td->tempfile,
                                                        db, local_abspath,
-                                                       result_pool));
+                                                       pool));
 
       /* Make an untranslated copy of the working file in the
          administrative tmp area because a) we need to detranslate eol
          and keywords anyway, and b) after the commit, we're going to
          copy the tmp file to become the new text base anyway. */
-      SVN_ERR(svn_stream_open_writable(&tempstream, *tempfile,
-                                       scratch_pool, scratch_pool));
+      SVN_ERR(svn_stream_open_writable(&tempstream, td->tempfile,
+                                       pool, pool));
 
       /* Wrap the translated stream with a new stream that writes the
          translated contents into the new text base file as we read from it.
          Note that the new text base file will be closed when the new stream
          is closed. */
-      local_stream = copying_stream(local_stream, tempstream, scratch_pool);
+      td->local_stream = copying_stream(td->local_stream, tempstream, pool);
     }
-  if (new_text_base_sha1_checksum)
+  if (want_sha1)
     {
       svn_stream_t *new_pristine_stream;
 
       SVN_ERR(svn_wc__open_writable_base(&new_pristine_stream,
-                                         &new_pristine_tmp_abspath,
-                                         NULL, &local_sha1_checksum,
+                                         &td->new_pristine_tmp_abspath,
+                                         NULL, &td->local_sha1_checksum,
                                          db, local_abspath,
-                                         scratch_pool, scratch_pool));
-      local_stream = copying_stream(local_stream, new_pristine_stream,
-                                    scratch_pool);
+                                         pool, pool));
+      td->local_stream = copying_stream(td->local_stream,
+                                        new_pristine_stream, pool);
     }
 
   /* Set BASE_STREAM to a stream providing the base (source) content for the
@@ -1180,29 +1202,29 @@ svn_wc__internal_transmit_text_deltas(const char **tempfile,
   if (! fulltext)
     {
       /* Compute delta against the pristine contents */
-      SVN_ERR(svn_wc__get_pristine_contents(&base_stream, db, local_abspath,
-                                            scratch_pool, scratch_pool));
-      if (base_stream == NULL)
-        base_stream = svn_stream_empty(scratch_pool);
+      SVN_ERR(svn_wc__get_pristine_contents(&td->base_stream, db,
+                                            local_abspath, pool, pool));
+      if (td->base_stream == NULL)
+        td->base_stream = svn_stream_empty(pool);
 
       SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL,
                                    NULL, NULL, NULL,
                                    NULL, NULL, NULL,
                                    NULL, NULL,
-                                   &expected_md5_checksum, NULL,
+                                   &td->expected_md5_checksum, NULL,
                                    NULL, NULL, NULL, NULL, NULL,
                                    NULL, NULL, NULL,
                                    NULL, NULL, NULL,
                                    db, local_abspath,
-                                   scratch_pool, scratch_pool));
+                                   pool, pool));
       /* SVN_EXPERIMENTAL_PRISTINE:
          If we got a SHA-1, get the corresponding MD-5. */
-      if (expected_md5_checksum
-          && expected_md5_checksum->kind != svn_checksum_md5)
-        SVN_ERR(svn_wc__db_pristine_get_md5(&expected_md5_checksum,
+      if (td->expected_md5_checksum
+          && td->expected_md5_checksum->kind != svn_checksum_md5)
+        SVN_ERR(svn_wc__db_pristine_get_md5(&td->expected_md5_checksum,
                                             db, local_abspath,
-                                            expected_md5_checksum,
-                                            scratch_pool, scratch_pool));
+                                            td->expected_md5_checksum,
+                                            pool, pool));
 
       /* ### We want expected_md5_checksum to ALWAYS be present, but on old
          working copies maybe it won't be (unclear?).  If it is there,
@@ -1216,13 +1238,14 @@ svn_wc__internal_transmit_text_deltas(const char **tempfile,
          calculate it a second time during the later reading of the stream
          for the purpose of verification, and will leave VERIFY_CHECKSUM as
          NULL. */
-      if (expected_md5_checksum)
+      if (td->expected_md5_checksum)
         {
           /* Arrange to set VERIFY_CHECKSUM to the MD5 of what is *actually*
              found when the base stream is read. */
-          base_stream = svn_stream_checksummed2(base_stream, &verify_checksum,
-                                                NULL, svn_checksum_md5, TRUE,
-                                                scratch_pool);
+          td->base_stream = svn_stream_checksummed2(td->base_stream,
+                                                    &td->verify_checksum,
+                                                    NULL, svn_checksum_md5,
+                                                    TRUE, pool);
         }
       else
         {
@@ -1233,68 +1256,124 @@ svn_wc__internal_transmit_text_deltas(const char **tempfile,
            * pristine text, by reading the text and calculating it. */
           /* ### we should ALREADY have the checksum for pristine. */
           SVN_ERR(svn_wc__get_pristine_contents(&p_stream, db, local_abspath,
-                                                scratch_pool, scratch_pool));
+                                                pool, pool));
           if (p_stream == NULL)
-            p_stream = svn_stream_empty(scratch_pool);
+            p_stream = svn_stream_empty(pool);
 
           p_stream = svn_stream_checksummed2(p_stream, &p_checksum,
                                              NULL, svn_checksum_md5, TRUE,
-                                             scratch_pool);
+                                             pool);
 
           /* Closing this will cause a full read/checksum. */
           SVN_ERR(svn_stream_close(p_stream));
 
-          expected_md5_checksum = p_checksum;
+          td->expected_md5_checksum = p_checksum;
         }
     }
   else
     {
       /* Send a fulltext. */
-      base_stream = svn_stream_empty(scratch_pool);
-      expected_md5_checksum = NULL;
+      td->base_stream = svn_stream_empty(pool);
+      td->expected_md5_checksum = NULL;
     }
 
-  /* Tell the editor that we're about to apply a textdelta to the
-     file baton; the editor returns to us a window consumer and baton.  */
-  {
-    /* apply_textdelta() is working against a base with this checksum */
-    const char *base_digest_hex = NULL;
-
-    if (expected_md5_checksum)
-      /* ### Why '..._display()'?  expected_md5_checksum should never be all-
-       * zero, but if it is, we would want to pass NULL not an all-zero
-       * digest to apply_textdelta(), wouldn't we? */
-      base_digest_hex = svn_checksum_to_cstring_display(expected_md5_checksum,
-                                                        scratch_pool);
-
-    SVN_ERR(editor->apply_textdelta(file_baton, base_digest_hex, scratch_pool,
-                                    &handler, &wh_baton));
-  }
+  if (spool)
+    {
+      const char *temp_dir_abspath;
+
+      SVN_ERR(svn_wc__db_pristine_get_tempdir(&temp_dir_abspath, db,
+                                              local_abspath, pool, pool));
+      SVN_ERR(svn_stream_open_unique(&td->spool_stream, &td->spool_abspath,
+                                     temp_dir_abspath,
+                                     svn_io_file_del_on_pool_cleanup,
+                                     pool, pool));
+    }
+
+  *delta = td;
+  return SVN_NO_ERROR;
+}
+
+/* Run the delta processing of TD, throwing windows at HANDLER/BATON, and
+   close TD's streams.  Return the error of the delta processing, if any,
+   unwrapped.  This doesn't access the working copy database. */
+static svn_error_t *
+run_text_delta(svn_wc__text_delta_t *td,
+               svn_txdelta_window_handler_t handler,
+               void *handler_baton,
+               apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
 
   /* Run diff processing, throwing windows at the handler. */
-  err = svn_txdelta_run(base_stream, local_stream,
-                        handler, wh_baton,
-                        svn_checksum_md5, &local_md5_checksum,
+  err = svn_txdelta_run(td->base_stream, td->local_stream,
+                        handler, handler_baton,
+                        svn_checksum_md5, &td->local_md5_checksum,
                         NULL, NULL,
-                        scratch_pool, scratch_pool);
+                        td->pool, scratch_pool);
 
   /* Close the two streams to force writing the digest,
      if we already have an error, ignore this one. */
   if (err)
     {
-      svn_error_clear(svn_stream_close(base_stream));
-      svn_error_clear(svn_stream_close(local_stream));
+      svn_error_clear(svn_stream_close(td->base_stream));
+      svn_error_clear(svn_stream_close(td->local_stream));
     }
   else
     {
-      SVN_ERR(svn_stream_close(base_stream));
-      SVN_ERR(svn_stream_close(local_stream));
+      err = svn_stream_close(td->base_stream);
+      if (! err)
+        err = svn_stream_close(td->local_stream);
     }
 
+  return err;
+}
+
+/* Tell EDITOR that we're about to apply a textdelta of TD to FILE_BATON,
+   and set *HANDLER and *HANDLER_BATON to the window consumer it returns. */
+static svn_error_t *
+apply_text_delta(svn_txdelta_window_handler_t *handler,
+                 void **handler_baton,
+                 const svn_wc__text_delta_t *td,
+                 const svn_delta_editor_t *editor,
+                 void *file_baton,
+                 apr_pool_t *scratch_pool)
+{
+  /* apply_textdelta() is working against a base with this checksum */
+  const char *base_digest_hex = NULL;
+
+  if (td->expected_md5_checksum)
+    /* ### Why '..._display()'?  expected_md5_checksum should never be all-
+     * zero, but if it is, we would want to pass NULL not an all-zero
+     * digest to apply_textdelta(), wouldn't we? */
+    base_digest_hex = svn_checksum_to_cstring_display(
+                        td->expected_md5_checksum, scratch_pool);
+
+  return svn_error_return(editor->apply_textdelta(file_baton,
+                                                  base_digest_hex,
+                                                  scratch_pool,
+                                                  handler, handler_baton));
+}
+
+/* Finish sending TD to EDITOR, after run_text_delta() returned ERR:
+   verify the base checksum, install the new pristine text and close
+   FILE_BATON.  Set *TEMPFILE and the checksums, if not NULL, as for
+   svn_wc_transmit_text_deltas3(). */
+static svn_error_t *
+finish_text_delta(const char **tempfile,
+                  const svn_checksum_t **new_text_base_md5_checksum,
+                  const svn_checksum_t **new_text_base_sha1_checksum,
+                  svn_wc__db_t *db,
+                  const svn_wc__text_delta_t *td,
+                  svn_error_t *err,
+                  const svn_delta_editor_t *editor,
+                  void *file_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
   /* If we have an error, it may be caused by a corrupt text base.
      Check the checksum and discard `err' if they don't match. */
-  if (expected_md5_checksum && verify_checksum
-      && !svn_checksum_match(expected_md5_checksum, verify_checksum))
+  if (td->expected_md5_checksum && td->verify_checksum
+      && !svn_checksum_match(td->expected_md5_checksum, td->verify_checksum))
     {
       /* The entry checksum does not match the actual text
          base checksum.  Extreme badness. Of course,
@@ -1311,50 +1390,166 @@ svn_wc__internal_transmit_text_deltas(const char **tempfile,
       /* Deliberately ignore errors; the error about the
          checksum mismatch is more important to return. */
       svn_error_clear(err);
-      if (tempfile)
-        svn_error_clear(svn_io_remove_file2(*tempfile, TRUE, scratch_pool));
+      if (td->tempfile)
+        svn_error_clear(svn_io_remove_file2(td->tempfile, TRUE,
+                                            scratch_pool));
 
       return svn_error_createf(SVN_ERR_WC_CORRUPT_TEXT_BASE, NULL,
                                _("Checksum mismatch for text base of '%s':\n"
                                  "   expected:  %s\n"
                                  "     actual:  %s\n"),
-                               svn_dirent_local_style(local_abspath,
+                               svn_dirent_local_style(td->local_abspath,
                                                       scratch_pool),
                                svn_checksum_to_cstring_display(
-                                 expected_md5_checksum, scratch_pool),
+                                 td->expected_md5_checksum, scratch_pool),
                                svn_checksum_to_cstring_display(
-                                 verify_checksum, scratch_pool));
+                                 td->verify_checksum, scratch_pool));
     }
 
   /* Now, handle that delta transmission error if any, so we can stop
      thinking about it after this point. */
   SVN_ERR_W(err, apr_psprintf(scratch_pool,
                               _("While preparing '%s' for commit"),
-                              svn_dirent_local_style(local_abspath,
+                              svn_dirent_local_style(td->local_abspath,
                                                      scratch_pool)));
 
+  if (tempfile)
+    *tempfile = td->tempfile ? apr_pstrdup(result_pool, td->tempfile) : NULL;
   if (new_text_base_md5_checksum)
-    *new_text_base_md5_checksum = svn_checksum_dup(local_md5_checksum,
+    *new_text_base_md5_checksum = svn_checksum_dup(td->local_md5_checksum,
                                                    result_pool);
   if (new_text_base_sha1_checksum)
     {
 #ifdef SVN_EXPERIMENTAL_PRISTINE
-      SVN_ERR(svn_wc__db_pristine_install(db, new_pristine_tmp_abspath,
-                                          local_sha1_checksum,
-                                          local_md5_checksum,
+      SVN_ERR(svn_wc__db_pristine_install(db, td->new_pristine_tmp_abspath,
+                                          td->local_sha1_checksum,
+                                          td->local_md5_checksum,
                                           scratch_pool));
 #endif
-      *new_text_base_sha1_checksum = svn_checksum_dup(local_sha1_checksum,
+      *new_text_base_sha1_checksum = svn_checksum_dup(td->local_sha1_checksum,
                                                       result_pool);
     }
 
   /* Close the file baton, and get outta here. */
   return editor->close_file(file_baton,
-                            svn_checksum_to_cstring(local_md5_checksum,
+                            svn_checksum_to_cstring(td->local_md5_checksum,
                                                     scratch_pool),
                             scratch_pool);
 }
 
+svn_error_t *
+svn_wc__internal_transmit_text_deltas(const char **tempfile,
+                                      const svn_checksum_t **new_text_base_md5_checksum,
+                                      const svn_checksum_t **new_text_base_sha1_checksum,
+                                      svn_wc__db_t *db,
+                                      const char *local_abspath,
+                                      svn_boolean_t fulltext,
+                                      const svn_delta_editor_t *editor,
+                                      void *file_baton,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool)
+{
+  svn_wc__text_delta_t *td;
+  svn_txdelta_window_handler_t handler;
+  void *wh_baton;
+  svn_error_t *err;
+
+  SVN_ERR(prepare_text_delta(&td, tempfile != NULL,
+                             new_text_base_sha1_checksum != NULL, FALSE,
+                             db, local_abspath, fulltext, scratch_pool));
+
+  /* Tell the editor that we're about to apply a textdelta to the
+     file baton; the editor returns to us a window consumer and baton.  */
+  SVN_ERR(apply_text_delta(&handler, &wh_baton, td, editor, file_baton,
+                           scratch_pool));
+
+  err = run_text_delta(td, handler, wh_baton, scratch_pool);
+
+  return svn_error_return(finish_text_delta(tempfile,
+                                            new_text_base_md5_checksum,
+                                            new_text_base_sha1_checksum,
+                                            db, td, err, editor, file_baton,
+                                            result_pool, scratch_pool));
+}
+
+svn_error_t *
+svn_wc__text_delta_prepare(svn_wc__text_delta_t **delta,
+                           svn_boolean_t want_tempfile,
+                           svn_boolean_t want_sha1,
+                           svn_wc_context_t *wc_ctx,
+                           const char *local_abspath,
+                           svn_boolean_t fulltext,
+                           apr_pool_t *pool)
+{
+  return svn_error_return(prepare_text_delta(delta, want_tempfile, want_sha1,
+                                             TRUE, wc_ctx->db, local_abspath,
+                                             fulltext, pool));
+}
+
+void
+svn_wc__text_delta_compute(svn_wc__text_delta_t *delta)
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  apr_pool_t *scratch_pool = svn_pool_create(delta->pool);
+  svn_error_t *err;
+
+  /* Windows are re-read right away, so don't spend time compressing
+     them. */
+  svn_txdelta_to_svndiff2(&handler, &handler_baton, delta->spool_stream, 0,
+                          delta->pool);
+
+  err = run_text_delta(delta, handler, handler_baton, scratch_pool);
+
+  /* The svndiff handler closed the spool stream when it got the final
+     NULL window; make sure it's closed if it didn't get that far. */
+  if (err)
+    svn_error_clear(svn_stream_close(delta->spool_stream));
+
+  delta->err = err;
+  svn_pool_destroy(scratch_pool);
+}
+
+svn_error_t *
+svn_wc__text_delta_send(const char **tempfile,
+                        const svn_checksum_t **new_text_base_md5_checksum,
+                        const svn_checksum_t **new_text_base_sha1_checksum,
+                        svn_wc_context_t *wc_ctx,
+                        svn_wc__text_delta_t *delta,
+                        const svn_delta_editor_t *editor,
+                        void *file_baton,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = delta->err;
+
+  delta->err = SVN_NO_ERROR;
+  if (! err)
+    {
+      svn_txdelta_window_handler_t handler;
+      void *wh_baton;
+      svn_stream_t *spool;
+
+      SVN_ERR(apply_text_delta(&handler, &wh_baton, delta, editor,
+                               file_baton, scratch_pool));
+
+      /* Replay the windows to the editor. */
+      SVN_ERR(svn_stream_open_readonly(&spool, delta->spool_abspath,
+                                       scratch_pool, scratch_pool));
+      err = svn_stream_copy3(spool,
+                             svn_txdelta_parse_svndiff(handler, wh_baton,
+                                                       TRUE, scratch_pool),
+                             NULL, NULL, scratch_pool);
+    }
+
+  return svn_error_return(finish_text_delta(tempfile,
+                                            new_text_base_md5_checksum,
+                                            new_text_base_sha1_checksum,
+                                            wc_ctx->db, delta, err,
+                                            editor, file_baton,
+                                            result_pool, scratch_pool));
+}
+
 svn_error_t *
 svn_wc_transmit_text_deltas3(const char **tempfile,
                              const svn_checksum_t **new_text_base_md5_checksum,
@@ -482,6 +482,30 @@ svn_wc__get_pristine_contents(svn_stream_t **contents,
                               const char *local_abspath,
                               apr_pool_t *result_pool,
                               apr_pool_t *scratch_pool)
+{
+  const char *pristine_abspath;
+
+  SVN_ERR(svn_wc__get_pristine_contents_path(&pristine_abspath, db,
+                                             local_abspath,
+                                             scratch_pool, scratch_pool));
+  if (pristine_abspath == NULL)
+    {
+      *contents = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_return(svn_stream_open_readonly(contents, pristine_abspath,
+                                                   result_pool,
+                                                   scratch_pool));
+}
+
+
+svn_error_t *
+svn_wc__get_pristine_contents_path(const char **pristine_abspath,
+                                   svn_wc__db_t *db,
+                                   const char *local_abspath,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool)
 {
   svn_wc__db_status_t status;
   svn_wc__db_kind_t kind;
@@ -514,7 +538,7 @@ svn_wc__get_pristine_contents(svn_stream_t **contents,
       if (status == svn_wc__db_status_added)
         {
           /* Simply added. The pristine base does not exist. */
-          *contents = NULL;
+          *pristine_abspath = NULL;
           return SVN_NO_ERROR;
         }
     }
@@ -544,18 +568,18 @@ svn_wc__get_pristine_contents(svn_stream_t **contents,
 
 #ifdef SVN_EXPERIMENTAL_PRISTINE
   if (sha1_checksum)
-    SVN_ERR(svn_wc__db_pristine_read(contents, db, local_abspath,
-                                     sha1_checksum,
-                                     result_pool, scratch_pool));
+    SVN_ERR(svn_wc__db_pristine_get_path(pristine_abspath, db, local_abspath,
+                                         sha1_checksum,
+                                         result_pool, scratch_pool));
   else
-    *contents = NULL;
+    *pristine_abspath = NULL;
 #else
   {
     const char *text_base;
     svn_error_t *err, *err2;
 
     err = svn_wc__text_base_path_to_read(&text_base, db, local_abspath,
-                                         scratch_pool, scratch_pool);
+                                         result_pool, scratch_pool);
     /* ### now for some ugly hackiness. right now, file externals will
        ### sometimes put their pristine contents into the revert base,
        ### because they think they're *replaced* nodes, rather than
@@ -577,10 +601,9 @@ svn_wc__get_pristine_contents(svn_stream_t **contents,
         svn_error_clear(err);
 
         SVN_ERR(svn_wc__text_revert_path_to_read(&text_base, db, local_abspath,
-                                                 scratch_pool));
+                                                 result_pool));
       }
-    SVN_ERR(svn_stream_open_readonly(contents, text_base,
-                                     result_pool, scratch_pool));
+    *pristine_abspath = text_base;
   }
 #endif
 
@@ -697,6 +720,39 @@ svn_wc__open_adm_stream(svn_stream_t **stream,
 }
 
 
+/* Baton for a stream computing both the MD5 and the SHA-1 checksum of the
+   data written to it. */
+struct md5_sha1_baton
+{
+  svn_stream_t *stream;
+  svn_checksum_ctx_t *checksum_ctx;
+  svn_checksum_t **md5_checksum;
+  svn_checksum_t **sha1_checksum;
+  apr_pool_t *pool;
+};
+
+/* Implements svn_write_fn_t for a struct md5_sha1_baton. */
+static svn_error_t *
+md5_sha1_write(void *baton, const char *data, apr_size_t *len)
+{
+  struct md5_sha1_baton *b = baton;
+
+  SVN_ERR(svn_checksum_update(b->checksum_ctx, data, *len));
+  return svn_stream_write(b->stream, data, len);
+}
+
+/* Implements svn_close_fn_t for a struct md5_sha1_baton. */
+static svn_error_t *
+md5_sha1_close(void *baton)
+{
+  struct md5_sha1_baton *b = baton;
+
+  SVN_ERR(svn_checksum__final_md5_sha1(b->md5_checksum, b->sha1_checksum,
+                                       b->checksum_ctx, b->pool));
+  return svn_stream_close(b->stream);
+}
+
+
 svn_error_t *
 svn_wc__open_writable_base(svn_stream_t **stream,
                            const char **temp_base_abspath,
@@ -717,10 +773,25 @@ svn_wc__open_writable_base(svn_stream_t **stream,
                                  temp_dir_abspath,
                                  svn_io_file_del_none,
                                  result_pool, scratch_pool));
-  if (md5_checksum)
+  if (md5_checksum && sha1_checksum)
+    {
+      /* Compute both in one go. */
+      struct md5_sha1_baton *b = apr_palloc(result_pool, sizeof(*b));
+
+      b->stream = *stream;
+      b->checksum_ctx = svn_checksum__ctx_create_md5_sha1(result_pool);
+      b->md5_checksum = md5_checksum;
+      b->sha1_checksum = sha1_checksum;
+      b->pool = result_pool;
+
+      *stream = svn_stream_create(b, result_pool);
+      svn_stream_set_write(*stream, md5_sha1_write);
+      svn_stream_set_close(*stream, md5_sha1_close);
+    }
+  else if (md5_checksum)
     *stream = svn_stream_checksummed2(*stream, NULL, md5_checksum,
                                       svn_checksum_md5, FALSE, result_pool);
-  if (sha1_checksum)
+  else if (sha1_checksum)
     *stream = svn_stream_checksummed2(*stream, NULL, sha1_checksum,
                                       svn_checksum_sha1, FALSE, result_pool);
 
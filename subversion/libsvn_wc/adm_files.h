@@ -106,6 +106,18 @@ svn_wc__get_pristine_contents(svn_stream_t **contents,
                               apr_pool_t *scratch_pool);
 
 
+/* Like svn_wc__get_pristine_contents(), but set *PRISTINE_ABSPATH to the
+ * path of the file holding the pristine text instead of opening it, or to
+ * NULL if the file is locally added. The path is allocated in RESULT_POOL.
+ */
+svn_error_t *
+svn_wc__get_pristine_contents_path(const char **pristine_abspath,
+                                   svn_wc__db_t *db,
+                                   const char *local_abspath,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool);
+
+
 /* Set *CONTENTS to a readonly stream on the pristine text of the base
  * version of LOCAL_ABSPATH in DB.  If LOCAL_ABSPATH is locally replaced,
  * this is distinct from svn_wc__get_pristine_contents(), otherwise it is
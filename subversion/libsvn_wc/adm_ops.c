@@ -1397,10 +1397,6 @@ mark_item_copied(svn_wc__db_t *db,
   SVN_ERR(svn_wc__db_temp_working_set_props(db, local_abspath, props,
                                             scratch_pool));
 
-  /* Remove now obsolete dav cache values.  */
-  SVN_ERR(svn_wc__db_base_set_dav_cache(db, local_abspath, NULL,
-                                        scratch_pool));
-  
   return SVN_NO_ERROR;
 }
 
@@ -1419,6 +1415,11 @@ mark_tree_copied(svn_wc__db_t *db,
   const apr_array_header_t *children;
   int i;
 
+  /* Remove the now obsolete dav cache values of the directory and all
+     of its children at once, instead of node by node below. */
+  SVN_ERR(svn_wc__db_base_clear_dav_cache_recursive(db, dir_abspath,
+                                                    iterpool));
+
   /* Tweak "this_dir" */
   SVN_ERR(tweak_node(db, dir_abspath, svn_wc__db_kind_dir, FALSE,
                      new_repos_relpath, new_repos_root_url, new_repos_uuid,
@@ -1832,11 +1833,6 @@ svn_wc_add4(svn_wc_context_t *wc_ctx,
                                    parent_entry->repos,
                                    parent_entry->uuid,
                                    pool));
-
-          /* Clean out the now-obsolete dav cache values.  */
-          /* ### put this into above walk. clear all cached values.  */
-          SVN_ERR(svn_wc__db_base_set_dav_cache(db, local_abspath, NULL,
-                                                pool));
         }
     }
 
@@ -1951,17 +1947,20 @@ svn_wc_register_file_external(svn_wc_context_t *wc_ctx,
 */
 
 
-/* */
+/* Queue reverting the prop and text mods of LOCAL_ABSPATH in DB and,
+   if RUN_WQ, run the work queue. */
 static svn_error_t *
 revert_admin_things(svn_boolean_t *reverted,
                     svn_wc__db_t *db,
                     const char *local_abspath,
                     svn_boolean_t use_commit_times,
+                    svn_boolean_t run_wq,
                     apr_pool_t *pool)
 {
   SVN_ERR(svn_wc__wq_add_revert(reverted, db, local_abspath, use_commit_times,
                                 pool));
-  SVN_ERR(svn_wc__wq_run(db, local_abspath, NULL, NULL, pool));
+  if (run_wq)
+    SVN_ERR(svn_wc__wq_run(db, local_abspath, NULL, NULL, pool));
 
   return SVN_NO_ERROR;
 }
@@ -1972,7 +1971,8 @@ revert_admin_things(svn_boolean_t *reverted,
    using; this function may choose to override that value as needed.
 
    See svn_wc_revert4() for the interpretations of
-   USE_COMMIT_TIMES, CANCEL_FUNC and CANCEL_BATON.
+   USE_COMMIT_TIMES, CANCEL_FUNC and CANCEL_BATON.  If RUN_WQ is FALSE,
+   prop and text mods are only queued for reverting.
 
    Set *DID_REVERT to true if actually reverting anything, else do not
    touch *DID_REVERT.
@@ -1985,6 +1985,7 @@ revert_entry(svn_depth_t *depth,
              const char *local_abspath,
              svn_node_kind_t disk_kind,
              svn_boolean_t use_commit_times,
+             svn_boolean_t run_wq,
              svn_cancel_func_t cancel_func,
              void *cancel_baton,
              svn_boolean_t *did_revert,
@@ -2146,7 +2147,7 @@ revert_entry(svn_depth_t *depth,
     {
       /* Revert the prop and text mods (if any). */
       SVN_ERR(revert_admin_things(&reverted, db, local_abspath,
-                                  use_commit_times, pool));
+                                  use_commit_times, run_wq, pool));
 
       /* Force recursion on replaced directories. */
       if (kind == svn_wc__db_kind_dir && replaced)
@@ -2164,12 +2165,17 @@ revert_entry(svn_depth_t *depth,
 /* This is just the guts of svn_wc_revert4() save that it accepts a
    hash CHANGELIST_HASH whose keys are changelist names instead of an
    array of said names.  See svn_wc_revert4() for additional
-   documentation. */
+   documentation.
+
+   If RUN_WQ is FALSE, reverting the prop and text mods of LOCAL_ABSPATH
+   itself is only queued, for the caller to run the work queue of its
+   parent directory once for all of its files. */
 static svn_error_t *
 revert_internal(svn_wc__db_t *db,
                 const char *local_abspath,
                 svn_depth_t depth,
                 svn_boolean_t use_commit_times,
+                svn_boolean_t run_wq,
                 apr_hash_t *changelist_hash,
                 svn_cancel_func_t cancel_func,
                 void *cancel_baton,
@@ -2278,7 +2284,7 @@ revert_internal(svn_wc__db_t *db,
          we provide a base_name from the parent path. */
       if (!unversioned)
         SVN_ERR(revert_entry(&depth, db, local_abspath, disk_kind,
-                             use_commit_times,
+                             use_commit_times, run_wq,
                              cancel_func, cancel_baton,
                              &reverted, pool));
 
@@ -2295,6 +2301,7 @@ revert_internal(svn_wc__db_t *db,
     {
       const apr_array_header_t *children;
       apr_hash_t *nodes = apr_hash_make(pool);
+      apr_hash_t *unmodified;
       svn_depth_t depth_under_here = depth;
       int i;
       apr_pool_t *iterpool = svn_pool_create(pool);
@@ -2305,6 +2312,17 @@ revert_internal(svn_wc__db_t *db,
       SVN_ERR(svn_wc__db_read_children(&children, db, local_abspath, pool,
                                        iterpool));
 
+      /* Files that certainly have nothing to revert are found in bulk, so
+         that a large tree with a few changes doesn't cost a full look at
+         every file.  (Unversioned tree conflict victims are handled
+         below.) */
+      if (disk_kind == svn_node_dir)
+        SVN_ERR(svn_wc__internal_get_unmodified_files(&unmodified, db,
+                                                      local_abspath,
+                                                      pool, iterpool));
+      else
+        unmodified = apr_hash_make(pool);
+
       for (i = 0; i < children->nelts; i++)
         {
           const char *name = APR_ARRAY_IDX(children, i, const char *);
@@ -2323,6 +2341,9 @@ revert_internal(svn_wc__db_t *db,
 
           apr_hash_set(nodes, name, APR_HASH_KEY_STRING, name);
 
+          if (apr_hash_get(unmodified, name, APR_HASH_KEY_STRING))
+            continue;
+
           SVN_ERR(svn_wc__db_read_kind(&child_db_kind, db, node_abspath, FALSE,
                                        iterpool));
 
@@ -2332,13 +2353,25 @@ revert_internal(svn_wc__db_t *db,
               (child_db_kind != svn_wc__db_kind_symlink))
             continue;
 
-          /* Revert the entry. */
-          SVN_ERR(revert_internal(db, node_abspath,
-                                  depth_under_here, use_commit_times,
-                                  changelist_hash, cancel_func, cancel_baton,
-                                  notify_func, notify_baton, iterpool));
+          /* Revert the entry.  Files only queue their work items, so
+             that this directory's work queue is run once for all of
+             them. */
+          err = revert_internal(db, node_abspath,
+                                depth_under_here, use_commit_times,
+                                child_db_kind != svn_wc__db_kind_file,
+                                changelist_hash, cancel_func, cancel_baton,
+                                notify_func, notify_baton, iterpool);
+          if (err)
+            {
+              /* Don't leave the reverts queued so far for a cleanup. */
+              svn_error_clear(svn_wc__wq_run(db, local_abspath, NULL, NULL,
+                                             iterpool));
+              return svn_error_return(err);
+            }
         }
 
+      SVN_ERR(svn_wc__wq_run(db, local_abspath, NULL, NULL, iterpool));
+
       /* Visit any unversioned children that are tree conflict victims. */
       {
         const apr_array_header_t *conflict_victims;
@@ -2379,7 +2412,8 @@ revert_internal(svn_wc__db_t *db,
                 if (conflict->kind == svn_wc_conflict_kind_tree)
                   SVN_ERR(revert_internal(db, conflict->local_abspath,
                                           svn_depth_empty,
-                                          use_commit_times, changelist_hash,
+                                          use_commit_times, TRUE,
+                                          changelist_hash,
                                           cancel_func, cancel_baton,
                                           notify_func, notify_baton,
                                           iterpool));
@@ -2413,7 +2447,8 @@ svn_wc_revert4(svn_wc_context_t *wc_ctx,
 
   return svn_error_return(revert_internal(wc_ctx->db,
                                           local_abspath, depth,
-                                          use_commit_times, changelist_hash,
+                                          use_commit_times, TRUE,
+                                          changelist_hash,
                                           cancel_func, cancel_baton,
                                           notify_func, notify_baton,
                                           pool));
@@ -2462,6 +2497,47 @@ svn_wc_get_pristine_contents2(svn_stream_t **contents,
                                                         scratch_pool));
 }
 
+svn_error_t *
+svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
+                                          svn_wc_context_t *wc_ctx,
+                                          const char *wri_abspath,
+                                          const svn_checksum_t *checksum,
+                                          apr_pool_t *result_pool,
+                                          apr_pool_t *scratch_pool)
+{
+  const svn_checksum_t *sha1_checksum = checksum;
+  svn_boolean_t present;
+
+  *contents = NULL;
+
+  if (checksum->kind != svn_checksum_sha1)
+    {
+      svn_error_t *err;
+
+      err = svn_wc__db_pristine_get_sha1(&sha1_checksum, wc_ctx->db,
+                                         wri_abspath, checksum,
+                                         scratch_pool, scratch_pool);
+      if (err && err->apr_err == SVN_ERR_WC_DB_ERROR)
+        {
+          /* Not in the pristine store. */
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+      SVN_ERR(err);
+    }
+
+  SVN_ERR(svn_wc__db_pristine_check(&present, wc_ctx->db, wri_abspath,
+                                    sha1_checksum, svn_wc__db_checkmode_usable,
+                                    scratch_pool));
+  if (! present)
+    return SVN_NO_ERROR;
+
+  return svn_error_return(svn_wc__db_pristine_read(contents, wc_ctx->db,
+                                                   wri_abspath, sha1_checksum,
+                                                   result_pool,
+                                                   scratch_pool));
+}
+
 svn_error_t *
 svn_wc__internal_remove_from_revision_control(svn_wc__db_t *db,
                                               const char *local_abspath,
@@ -2974,3 +3050,118 @@ svn_wc__changelist_match(svn_wc_context_t *wc_ctx,
   return svn_wc__internal_changelist_match(wc_ctx->db, local_abspath, clhash,
                                            scratch_pool);
 }
+
+
+/* Helper for svn_wc__get_changelist_members(): report the members of the
+   changelists in CLHASH among the children of DIR_ABSPATH, and in the
+   subdirectories below it as far as DEPTH says. */
+static svn_error_t *
+get_changelist_members(svn_wc_context_t *wc_ctx,
+                       const char *dir_abspath,
+                       svn_depth_t depth,
+                       apr_hash_t *clhash,
+                       svn_wc__changelist_member_func_t callback_func,
+                       void *callback_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool)
+{
+  apr_hash_t *changelists;
+  const apr_array_header_t *subdirs;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (depth == svn_depth_empty)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__db_read_children_changelists(
+                       &changelists,
+                       depth == svn_depth_infinity ? &subdirs : NULL,
+                       wc_ctx->db, dir_abspath, scratch_pool, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, changelists);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *changelist = svn__apr_hash_index_val(hi);
+      const char *child_abspath;
+      svn_node_kind_t kind;
+
+      if (! apr_hash_get(clhash, changelist, APR_HASH_KEY_STRING))
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      child_abspath = svn_dirent_join(dir_abspath,
+                                      svn__apr_hash_index_key(hi),
+                                      iterpool);
+
+      /* Skip hidden nodes, as svn_wc__node_walk_children() would. */
+      SVN_ERR(svn_wc_read_kind(&kind, wc_ctx, child_abspath, FALSE,
+                               iterpool));
+      if (kind == svn_node_file
+          || (kind == svn_node_dir && depth >= svn_depth_immediates))
+        SVN_ERR(callback_func(callback_baton, child_abspath, changelist,
+                              iterpool));
+    }
+
+  if (depth == svn_depth_infinity)
+    for (i = 0; i < subdirs->nelts; i++)
+      {
+        svn_pool_clear(iterpool);
+
+        if (cancel_func)
+          SVN_ERR(cancel_func(cancel_baton));
+
+        SVN_ERR(get_changelist_members(
+                       wc_ctx,
+                       svn_dirent_join(dir_abspath,
+                                       APR_ARRAY_IDX(subdirs, i,
+                                                     const char *),
+                                       iterpool),
+                       depth, clhash, callback_func, callback_baton,
+                       cancel_func, cancel_baton, iterpool));
+      }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__get_changelist_members(svn_wc_context_t *wc_ctx,
+                               const char *local_abspath,
+                               svn_depth_t depth,
+                               apr_hash_t *clhash,
+                               svn_wc__changelist_member_func_t callback_func,
+                               void *callback_baton,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool)
+{
+  svn_wc__db_kind_t kind;
+  svn_depth_t node_depth;
+  const char *changelist;
+
+  SVN_ERR(svn_wc__db_read_info(NULL, &kind, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, &node_depth, NULL,
+                               NULL, NULL, &changelist,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL,
+                               wc_ctx->db, local_abspath,
+                               scratch_pool, scratch_pool));
+
+  if (changelist
+      && apr_hash_get(clhash, changelist, APR_HASH_KEY_STRING) != NULL)
+    SVN_ERR(callback_func(callback_baton, local_abspath, changelist,
+                          scratch_pool));
+
+  if (kind != svn_wc__db_kind_dir || node_depth == svn_depth_exclude)
+    return SVN_NO_ERROR;
+
+  return svn_error_return(
+    get_changelist_members(wc_ctx, local_abspath, depth, clhash,
+                           callback_func, callback_baton,
+                           cancel_func, cancel_baton, scratch_pool));
+}
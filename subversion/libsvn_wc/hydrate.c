@@ -0,0 +1,424 @@
+/*
+ * hydrate.c:  files checked out without their texts
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* A lazy checkout (see svn_wc__get_lazy_update_editor()) records the
+   BASE nodes of files, with their checksums, but neither their text
+   bases nor their working files.  The basenames of these "dehydrated"
+   files are listed, one per line, in the file SVN_WC__ADM_DEHYDRATED
+   in the administrative area of their directory.
+
+   A file only counts as dehydrated while it is listed *and* has no text
+   base, so names that stay on the list after a file was hydrated,
+   deleted or replaced by something else are harmless.  */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+#include <apr_tables.h>
+
+#include "svn_pools.h"
+#include "svn_types.h"
+#include "svn_string.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+
+#include "wc.h"
+#include "log.h"
+#include "adm_files.h"
+#include "workqueue.h"
+#include "wc_db.h"
+
+#include "svn_private_config.h"
+#include "private/svn_wc_private.h"
+
+
+svn_error_t *
+svn_wc__read_dehydrated(apr_hash_t **names,
+                        const char *dir_abspath,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  svn_error_t *err;
+  int i;
+
+  *names = apr_hash_make(result_pool);
+
+  err = svn_stringbuf_from_file2(&contents,
+                                 svn_wc__adm_child(dir_abspath,
+                                                   SVN_WC__ADM_DEHYDRATED,
+                                                   scratch_pool),
+                                 scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  lines = svn_cstring_split(contents->data, "\n", FALSE, result_pool);
+  for (i = 0; i < lines->nelts; i++)
+    {
+      const char *name = APR_ARRAY_IDX(lines, i, const char *);
+
+      apr_hash_set(*names, name, APR_HASH_KEY_STRING, name);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Set *MISSING to TRUE if the text base of the file LOCAL_ABSPATH
+   doesn't exist, otherwise to FALSE.  */
+static svn_error_t *
+text_base_missing(svn_boolean_t *missing,
+                  svn_wc__db_t *db,
+                  const char *local_abspath,
+                  apr_pool_t *scratch_pool)
+{
+#ifndef SVN_EXPERIMENTAL_PRISTINE
+  const char *text_base_abspath;
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_wc__text_base_path(&text_base_abspath, db, local_abspath,
+                                 scratch_pool));
+  SVN_ERR(svn_io_check_path(text_base_abspath, &kind, scratch_pool));
+  *missing = (kind == svn_node_none);
+#else
+  /* Lazy checkouts are not supported with a pristine store, so nothing
+     ever got dehydrated. */
+  *missing = FALSE;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__internal_is_dehydrated(svn_boolean_t *dehydrated,
+                               svn_wc__db_t *db,
+                               const char *local_abspath,
+                               apr_hash_t *names,
+                               apr_pool_t *scratch_pool)
+{
+  const char *dir_abspath;
+  const char *name;
+
+  svn_dirent_split(local_abspath, &dir_abspath, &name, scratch_pool);
+  if (! names)
+    SVN_ERR(svn_wc__read_dehydrated(&names, dir_abspath,
+                                    scratch_pool, scratch_pool));
+
+  if (apr_hash_get(names, name, APR_HASH_KEY_STRING))
+    SVN_ERR(text_base_missing(dehydrated, db, local_abspath, scratch_pool));
+  else
+    *dehydrated = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__set_dehydrated(const char *dir_abspath,
+                       apr_hash_t *added,
+                       apr_hash_t *removed,
+                       apr_pool_t *scratch_pool)
+{
+  const char *list_abspath = svn_wc__adm_child(dir_abspath,
+                                               SVN_WC__ADM_DEHYDRATED,
+                                               scratch_pool);
+  apr_hash_t *names;
+  apr_hash_index_t *hi;
+  svn_stringbuf_t *contents;
+  const char *tmp_abspath;
+
+  SVN_ERR(svn_wc__read_dehydrated(&names, dir_abspath,
+                                  scratch_pool, scratch_pool));
+
+  if (added)
+    names = apr_hash_overlay(scratch_pool, added, names);
+  if (removed)
+    for (hi = apr_hash_first(scratch_pool, removed); hi;
+         hi = apr_hash_next(hi))
+      apr_hash_set(names, svn__apr_hash_index_key(hi), APR_HASH_KEY_STRING,
+                   NULL);
+
+  if (apr_hash_count(names) == 0)
+    return svn_error_return(svn_io_remove_file2(list_abspath, TRUE,
+                                                scratch_pool));
+
+  contents = svn_stringbuf_create("", scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, names); hi; hi = apr_hash_next(hi))
+    {
+      svn_stringbuf_appendcstr(contents, svn__apr_hash_index_key(hi));
+      svn_stringbuf_appendbytes(contents, "\n", 1);
+    }
+
+  /* Replace the list atomically, so that it never loses names. */
+  SVN_ERR(svn_io_write_unique(&tmp_abspath,
+                              svn_wc__adm_child(dir_abspath, SVN_WC__ADM_TMP,
+                                                scratch_pool),
+                              contents->data, contents->len,
+                              svn_io_file_del_none, scratch_pool));
+  return svn_error_return(svn_io_file_rename(tmp_abspath, list_abspath,
+                                             scratch_pool));
+}
+
+
+/* Fetch the text of the dehydrated file LOCAL_ABSPATH in DIR_ABSPATH with
+   FETCH_FUNC and FETCH_BATON, and queue the work items that install it as
+   its text base, and as its working file if that doesn't exist and the
+   file isn't scheduled for deletion.  Set *INSTALLED to TRUE if the
+   working file is going to be installed.  */
+static svn_error_t *
+hydrate_file(svn_boolean_t *installed,
+             svn_wc__db_t *db,
+             const char *local_abspath,
+             const char *dir_abspath,
+             svn_wc_get_file_t fetch_func,
+             void *fetch_baton,
+             apr_pool_t *scratch_pool)
+{
+#ifndef SVN_EXPERIMENTAL_PRISTINE
+  svn_wc__db_status_t status;
+  svn_revnum_t revision;
+  const char *repos_relpath;
+  const svn_checksum_t *checksum;
+  svn_stream_t *contents;
+  const char *tmp_text_base_abspath;
+  const char *text_base_abspath;
+  svn_checksum_t *md5_checksum;
+  svn_checksum_t *sha1_checksum;
+  svn_node_kind_t kind;
+  svn_skel_t *work_items;
+
+  SVN_ERR(svn_wc__db_base_get_info(NULL, NULL, &revision, &repos_relpath,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   &checksum, NULL, NULL, NULL,
+                                   db, local_abspath,
+                                   scratch_pool, scratch_pool));
+  if (! repos_relpath)
+    SVN_ERR(svn_wc__db_scan_base_repos(&repos_relpath, NULL, NULL,
+                                       db, local_abspath,
+                                       scratch_pool, scratch_pool));
+
+  /* The stream computes the checksums when it is closed. */
+  SVN_ERR(svn_wc__open_writable_base(&contents, &tmp_text_base_abspath,
+                                     &md5_checksum, &sha1_checksum,
+                                     db, local_abspath,
+                                     scratch_pool, scratch_pool));
+  SVN_ERR(fetch_func(fetch_baton, repos_relpath, revision, contents,
+                     NULL, NULL, scratch_pool));
+  SVN_ERR(svn_stream_close(contents));
+
+  if (! svn_checksum_match(checksum, md5_checksum))
+    {
+      svn_error_clear(svn_io_remove_file2(tmp_text_base_abspath, TRUE,
+                                          scratch_pool));
+      return svn_error_createf(SVN_ERR_CHECKSUM_MISMATCH, NULL,
+                    _("Checksum mismatch for '%s':\n"
+                      "   expected:  %s\n"
+                      "     actual:  %s\n"),
+                    svn_dirent_local_style(local_abspath, scratch_pool),
+                    svn_checksum_to_cstring_display(checksum, scratch_pool),
+                    svn_checksum_to_cstring_display(md5_checksum,
+                                                    scratch_pool));
+    }
+
+  SVN_ERR(svn_wc__text_base_path(&text_base_abspath, db, local_abspath,
+                                 scratch_pool));
+  SVN_ERR(svn_wc__loggy_move(&work_items, db, dir_abspath,
+                             tmp_text_base_abspath, text_base_abspath,
+                             scratch_pool));
+
+  /* Whatever the user put in the file's place stays there, as a local
+     modification. */
+  SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL,
+                               db, local_abspath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_check_path(local_abspath, &kind, scratch_pool));
+  *installed = (kind == svn_node_none && status == svn_wc__db_status_normal);
+
+  if (*installed)
+    {
+      svn_skel_t *work_item;
+
+      SVN_ERR(svn_wc__wq_build_file_install(&work_item, db, local_abspath,
+                                            NULL /* source_abspath */,
+                                            FALSE /* use_commit_times */,
+                                            TRUE /* record_fileinfo */,
+                                            scratch_pool, scratch_pool));
+      work_items = svn_wc__wq_merge(work_items, work_item, scratch_pool);
+    }
+
+  return svn_error_return(svn_wc__db_wq_add(db, dir_abspath, work_items,
+                                            scratch_pool));
+#else
+  /* text_base_missing() never finds a dehydrated file to get here. */
+  SVN_ERR_MALFUNCTION();
+#endif
+}
+
+
+/* Baton for find_dehydrated(). */
+struct find_baton
+{
+  svn_wc__db_t *db;
+
+  /* The directory whose list of dehydrated files NAMES is, allocated in
+     DIR_POOL, which is cleared whenever the walk gets to another one. */
+  const char *dir_abspath;
+  apr_hash_t *names;
+  apr_pool_t *dir_pool;
+
+  /* The absolute paths of the dehydrated files found, allocated in
+     POOL. */
+  apr_array_header_t *files;
+  apr_pool_t *pool;
+};
+
+/* Add LOCAL_ABSPATH to the files of WALK_BATON, a struct find_baton, if
+   it is a dehydrated file.  Implements svn_wc__node_found_func_t.  */
+static svn_error_t *
+find_dehydrated(const char *local_abspath,
+                void *walk_baton,
+                apr_pool_t *scratch_pool)
+{
+  struct find_baton *fb = walk_baton;
+  svn_wc__db_kind_t kind;
+  const char *dir_abspath;
+  svn_boolean_t dehydrated;
+
+  SVN_ERR(svn_wc__db_read_kind(&kind, fb->db, local_abspath, FALSE,
+                               scratch_pool));
+  if (kind != svn_wc__db_kind_file)
+    return SVN_NO_ERROR;
+
+  dir_abspath = svn_dirent_dirname(local_abspath, scratch_pool);
+  if (! fb->dir_abspath || strcmp(dir_abspath, fb->dir_abspath) != 0)
+    {
+      svn_pool_clear(fb->dir_pool);
+      fb->dir_abspath = apr_pstrdup(fb->dir_pool, dir_abspath);
+      SVN_ERR(svn_wc__read_dehydrated(&fb->names, dir_abspath,
+                                      fb->dir_pool, scratch_pool));
+    }
+
+  SVN_ERR(svn_wc__internal_is_dehydrated(&dehydrated, fb->db, local_abspath,
+                                         fb->names, scratch_pool));
+  if (dehydrated)
+    APR_ARRAY_PUSH(fb->files, const char *) = apr_pstrdup(fb->pool,
+                                                           local_abspath);
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__hydrate(svn_wc_context_t *wc_ctx,
+                const char *local_abspath,
+                svn_depth_t depth,
+                svn_wc_get_file_t fetch_func,
+                void *fetch_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                svn_wc_notify_func2_t notify_func,
+                void *notify_baton,
+                apr_pool_t *scratch_pool)
+{
+  svn_wc__db_t *db = wc_ctx->db;
+  struct find_baton fb;
+  apr_hash_t *hydrated;
+  const char *hydrated_dir_abspath = NULL;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  fb.db = db;
+  fb.dir_abspath = NULL;
+  fb.names = NULL;
+  fb.dir_pool = svn_pool_create(scratch_pool);
+  fb.files = apr_array_make(scratch_pool, 0, sizeof(const char *));
+  fb.pool = scratch_pool;
+
+  SVN_ERR(svn_wc__internal_walk_children(db, local_abspath, FALSE,
+                                         find_dehydrated, &fb, depth,
+                                         cancel_func, cancel_baton,
+                                         scratch_pool));
+  svn_pool_destroy(fb.dir_pool);
+
+  /* The walk mostly finds the files of a directory one after another;
+     take the names of each such run off the directory's list at once. */
+  hydrated = apr_hash_make(scratch_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < fb.files->nelts; i++)
+    {
+      const char *file_abspath = APR_ARRAY_IDX(fb.files, i, const char *);
+      const char *dir_abspath;
+      const char *name;
+      svn_boolean_t installed;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      svn_dirent_split(file_abspath, &dir_abspath, &name, scratch_pool);
+      if (hydrated_dir_abspath && strcmp(dir_abspath, hydrated_dir_abspath))
+        {
+          SVN_ERR(svn_wc__set_dehydrated(hydrated_dir_abspath, NULL,
+                                         hydrated, iterpool));
+          hydrated = apr_hash_make(scratch_pool);
+        }
+      hydrated_dir_abspath = dir_abspath;
+
+      SVN_ERR(hydrate_file(&installed, db, file_abspath, dir_abspath,
+                           fetch_func, fetch_baton, iterpool));
+      SVN_ERR(svn_wc__wq_run(db, dir_abspath, cancel_func, cancel_baton,
+                             iterpool));
+      apr_hash_set(hydrated, name, APR_HASH_KEY_STRING, name);
+
+      if (installed && notify_func)
+        {
+          svn_wc_notify_t *notify = svn_wc_create_notify(file_abspath,
+                                                         svn_wc_notify_restore,
+                                                         iterpool);
+
+          notify->kind = svn_node_file;
+          (*notify_func)(notify_baton, notify, iterpool);
+        }
+    }
+
+  if (hydrated_dir_abspath)
+    SVN_ERR(svn_wc__set_dehydrated(hydrated_dir_abspath, NULL, hydrated,
+                                   iterpool));
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
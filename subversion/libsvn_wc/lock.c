@@ -1118,8 +1118,8 @@ child_is_disjoint(svn_boolean_t *disjoint,
 
   if (strcmp(parent_repos_root, node_repos_root) != 0 ||
       strcmp(parent_repos_uuid, node_repos_uuid) != 0 ||
-      strcmp(svn_relpath_join(parent_repos_relpath, base, scratch_pool),
-             node_repos_relpath) != 0)
+      ! svn_relpath__is_joined(node_repos_relpath, parent_repos_relpath,
+                               base))
     {
       *disjoint = TRUE;
     }
@@ -324,12 +324,46 @@ init_conflict_markers(const char **target_marker,
     *right_marker = ">>>>>>> .new";
 }
 
+/* Files no larger than this are merged in memory by do_text_merge(). */
+#define IN_MEMORY_MERGE_LIMIT (1024 * 1024)
+
+/* Set *CONTENTS to the contents of the file at PATH if it is no larger
+ * than IN_MEMORY_MERGE_LIMIT, and to NULL otherwise.  Allocate *CONTENTS
+ * in POOL. */
+static svn_error_t *
+read_small_file(svn_string_t **contents,
+                const char *path,
+                apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+  svn_stringbuf_t *buf;
+
+  *contents = NULL;
+
+  SVN_ERR(svn_io_stat(&finfo, path, APR_FINFO_SIZE, pool));
+  if (finfo.size > IN_MEMORY_MERGE_LIMIT)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_stringbuf_from_file2(&buf, path, pool));
+
+  *contents = apr_palloc(pool, sizeof(**contents));
+  (*contents)->data = buf->data;
+  (*contents)->len = buf->len;
+
+  return SVN_NO_ERROR;
+}
+
 /* Do a 3-way merge of the files at paths LEFT, DETRANSLATED_TARGET,
  * and RIGHT, using diff options provided in OPTIONS.  Store the merge
  * result in the file RESULT_F.
  * If there are conflicts, set *CONTAINS_CONFLICTS to true, and use
  * TARGET_LABEL, LEFT_LABEL, and RIGHT_LABEL as labels for conflict
  * markers.  Else, set *CONTAINS_CONFLICTS to false.
+ *
+ * If all three files are small, read each of them once and merge them
+ * in memory instead of letting the file diff code read every file twice
+ * (once to diff it and once more to write the output).
+ *
  * Do all allocations in POOL. */
 static svn_error_t*
 do_text_merge(svn_boolean_t *contains_conflicts,
@@ -348,23 +382,50 @@ do_text_merge(svn_boolean_t *contains_conflicts,
   const char *target_marker;
   const char *left_marker;
   const char *right_marker;
+  svn_string_t *left_contents;
+  svn_string_t *target_contents = NULL;
+  svn_string_t *right_contents = NULL;
 
   init_conflict_markers(&target_marker, &left_marker, &right_marker,
                         target_label, left_label, right_label, pool);
 
-  SVN_ERR(svn_diff_file_diff3_2(&diff, left, detranslated_target, right,
-                                options, pool));
+  SVN_ERR(read_small_file(&left_contents, left, pool));
+  if (left_contents)
+    SVN_ERR(read_small_file(&target_contents, detranslated_target, pool));
+  if (target_contents)
+    SVN_ERR(read_small_file(&right_contents, right, pool));
 
   ostream = svn_stream_from_aprfile2(result_f, TRUE, pool);
 
-  SVN_ERR(svn_diff_file_output_merge2(ostream, diff,
-                                      left, detranslated_target, right,
-                                      left_marker,
-                                      target_marker,
-                                      right_marker,
-                                      "=======", /* separator */
-                                      svn_diff_conflict_display_modified_latest,
-                                      pool));
+  if (right_contents)
+    {
+      SVN_ERR(svn_diff_mem_string_diff3(&diff, left_contents,
+                                        target_contents, right_contents,
+                                        options, pool));
+      SVN_ERR(svn_diff_mem_string_output_merge2(
+                ostream, diff,
+                left_contents, target_contents, right_contents,
+                left_marker,
+                target_marker,
+                right_marker,
+                "=======", /* separator */
+                svn_diff_conflict_display_modified_latest,
+                pool));
+    }
+  else
+    {
+      SVN_ERR(svn_diff_file_diff3_2(&diff, left, detranslated_target, right,
+                                    options, pool));
+      SVN_ERR(svn_diff_file_output_merge2(
+                ostream, diff,
+                left, detranslated_target, right,
+                left_marker,
+                target_marker,
+                right_marker,
+                "=======", /* separator */
+                svn_diff_conflict_display_modified_latest,
+                pool));
+    }
   SVN_ERR(svn_stream_close(ostream));
 
   *contains_conflicts = svn_diff_contains_conflicts(diff);
@@ -100,6 +100,72 @@ svn_wc__node_get_children(const apr_array_header_t **children,
 }
 
 
+svn_error_t *
+svn_wc__internal_get_unmodified_files(apr_hash_t **unmodified,
+                                      svn_wc__db_t *db,
+                                      const char *dir_abspath,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool)
+{
+  apr_hash_t *nodes;
+  apr_hash_t *conflicts;
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts, db,
+                                        dir_abspath,
+                                        scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_get_dirents3(&dirents, dir_abspath, FALSE,
+                              scratch_pool, scratch_pool));
+
+  *unmodified = apr_hash_make(result_pool);
+
+  for (hi = apr_hash_first(scratch_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = svn__apr_hash_index_key(hi);
+      const struct svn_wc__db_info_t *info = svn__apr_hash_index_val(hi);
+      const svn_io_dirent2_t *dirent;
+
+      if (info->kind != svn_wc__db_kind_file
+          || info->status != svn_wc__db_status_normal
+          || info->base_shadowed
+          || info->props_mod
+          || info->conflicted
+          || info->lock
+          || apr_hash_get(conflicts, name, APR_HASH_KEY_STRING))
+        continue;
+
+      /* The same heuristic svn_wc__internal_text_modified_p() uses. */
+      dirent = apr_hash_get(dirents, name, APR_HASH_KEY_STRING);
+      if (dirent == NULL
+          || dirent->kind != svn_node_file
+          || dirent->special
+          || (info->translated_size != SVN_WC_ENTRY_WORKING_SIZE_UNKNOWN
+              && dirent->filesize != info->translated_size)
+          || dirent->mtime != info->last_mod_time)
+        continue;
+
+      apr_hash_set(*unmodified, apr_pstrdup(result_pool, name),
+                   APR_HASH_KEY_STRING, "");
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__node_get_unmodified_files(apr_hash_t **unmodified,
+                                  svn_wc_context_t *wc_ctx,
+                                  const char *dir_abspath,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  return svn_error_return(svn_wc__internal_get_unmodified_files(
+                            unmodified, wc_ctx->db, dir_abspath,
+                            result_pool, scratch_pool));
+}
+
+
 svn_error_t *
 svn_wc__node_get_repos_info(const char **repos_root_url,
                             const char **repos_uuid,
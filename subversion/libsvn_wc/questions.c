@@ -265,6 +265,149 @@ svn_wc__versioned_file_modcheck(svn_boolean_t *modified_p,
                             scratch_pool));
 }
 
+/* Set *HANDLED to whether the working file LOCAL_ABSPATH could be
+   compared with its pristine text through NODE_CHECKSUM, the recorded
+   checksum of that text, and if so, set *MODIFIED_P to whether it
+   differs.
+
+   This reads only the working file: it is detranslated to normal form
+   if necessary, and its checksum is compared with NODE_CHECKSUM.  Special
+   files, and files that would have to be compared in working copy form
+   (COMPARE_TEXTBASES is false), are not handled.  */
+static svn_error_t *
+compare_with_checksum(svn_boolean_t *handled,
+                      svn_boolean_t *modified_p,
+                      svn_wc__db_t *db,
+                      const char *local_abspath,
+                      const svn_checksum_t *node_checksum,
+                      svn_boolean_t compare_textbases,
+                      apr_pool_t *scratch_pool)
+{
+  svn_subst_eol_style_t eol_style;
+  const char *eol_str;
+  apr_hash_t *keywords;
+  svn_boolean_t special;
+  svn_boolean_t need_translation;
+  svn_stream_t *v_stream;  /* versioned_file */
+  svn_checksum_t *checksum;
+
+  *handled = FALSE;
+
+  SVN_ERR(svn_wc__get_special(&special, db, local_abspath, scratch_pool));
+  if (special)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__get_eol_style(&eol_style, &eol_str, db, local_abspath,
+                                scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__get_keywords(&keywords, db, local_abspath, NULL,
+                               scratch_pool, scratch_pool));
+
+  need_translation = svn_subst_translation_required(eol_style, eol_str,
+                                                    keywords, FALSE, TRUE);
+  if (need_translation && !compare_textbases)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_stream_open_readonly(&v_stream, local_abspath,
+                                   scratch_pool, scratch_pool));
+
+  if (need_translation)
+    {
+      if (eol_style == svn_subst_eol_style_native)
+        eol_str = SVN_SUBST_NATIVE_EOL_STR;
+      else if (eol_style != svn_subst_eol_style_fixed
+               && eol_style != svn_subst_eol_style_none)
+        return svn_error_create(SVN_ERR_IO_UNKNOWN_EOL, NULL, NULL);
+
+      /* Detranslate into normal form, "repairing" the EOL style if it is
+         inconsistent, as compare_and_verify() does. */
+      v_stream = svn_subst_stream_translated(v_stream, eol_str,
+                                             TRUE /* repair */,
+                                             keywords, FALSE /* expand */,
+                                             scratch_pool);
+    }
+
+  v_stream = svn_stream_checksummed2(v_stream, &checksum, NULL,
+                                     node_checksum->kind, TRUE,
+                                     scratch_pool);
+  SVN_ERR(svn_stream_close(v_stream));
+
+  *handled = TRUE;
+  *modified_p = !svn_checksum_match(checksum, node_checksum);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MODIFIED_P to whether LOCAL_ABSPATH differs from its pristine
+   text, by reading both.  FORCE_COMPARISON and COMPARE_TEXTBASES are as
+   for svn_wc__internal_text_modified_p(). */
+static svn_error_t *
+compare_with_pristine(svn_boolean_t *modified_p,
+                      svn_wc__db_t *db,
+                      const char *local_abspath,
+                      svn_boolean_t force_comparison,
+                      svn_boolean_t compare_textbases,
+                      apr_pool_t *scratch_pool)
+{
+  svn_stream_t *pristine_stream;
+  svn_error_t *err;
+
+  /* Unless we're asked to verify the pristine text, its recorded checksum
+     tells us all we need to know about it.  Only unmodified files that
+     were copied or added have their pristine text elsewhere (or none).  */
+  if (! force_comparison)
+    {
+      svn_wc__db_status_t status;
+      const svn_checksum_t *node_checksum;
+      svn_boolean_t handled;
+
+      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL,
+                                   &node_checksum, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL,
+                                   db, local_abspath,
+                                   scratch_pool, scratch_pool));
+
+      if (status == svn_wc__db_status_normal && node_checksum)
+        {
+          SVN_ERR(compare_with_checksum(&handled, modified_p, db,
+                                        local_abspath, node_checksum,
+                                        compare_textbases, scratch_pool));
+          if (handled)
+            return SVN_NO_ERROR;
+        }
+    }
+
+  /* If there's no text-base file, we have to assume the working file
+     is modified.  For example, a file scheduled for addition but not
+     yet committed. */
+  /* We used to stat for the working base here, but we just give
+     compare_and_verify a try; we'll check for errors afterwards */
+  err = svn_wc__get_pristine_contents(&pristine_stream, db, local_abspath,
+                                      scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *modified_p = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(err);
+
+  if (pristine_stream == NULL)
+    {
+      *modified_p = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Check all bytes, and verify checksum if requested. */
+  return svn_error_return(compare_and_verify(modified_p, db, local_abspath,
+                                             pristine_stream,
+                                             compare_textbases,
+                                             force_comparison,
+                                             scratch_pool));
+}
+
 svn_error_t *
 svn_wc__internal_text_modified_p(svn_boolean_t *modified_p,
                                  svn_wc__db_t *db,
@@ -273,7 +416,6 @@ svn_wc__internal_text_modified_p(svn_boolean_t *modified_p,
                                  svn_boolean_t compare_textbases,
                                  apr_pool_t *scratch_pool)
 {
-  svn_stream_t *pristine_stream;
   svn_error_t *err;
   apr_finfo_t finfo;
 
@@ -361,34 +503,43 @@ svn_wc__internal_text_modified_p(svn_boolean_t *modified_p,
     }
 
  compare_them:
-  /* If there's no text-base file, we have to assume the working file
-     is modified.  For example, a file scheduled for addition but not
-     yet committed. */
-  /* We used to stat for the working base here, but we just give
-     compare_and_verify a try; we'll check for errors afterwards */
-  err = svn_wc__get_pristine_contents(&pristine_stream, db, local_abspath,
-                                      scratch_pool, scratch_pool);
-  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+  return svn_error_return(compare_with_pristine(modified_p, db,
+                                                local_abspath,
+                                                force_comparison,
+                                                compare_textbases,
+                                                scratch_pool));
+}
+
+svn_error_t *
+svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
+                                 svn_wc__db_t *db,
+                                 const char *local_abspath,
+                                 const svn_io_dirent2_t *dirent,
+                                 svn_filesize_t recorded_size,
+                                 apr_time_t recorded_mod_time,
+                                 svn_boolean_t compare_textbases,
+                                 apr_pool_t *scratch_pool)
+{
+  /* Same as in svn_wc__internal_text_modified_p(), but without stat()ing
+     the file or reading the recorded values again. */
+  if (dirent->kind != svn_node_file)
     {
-      svn_error_clear(err);
-      *modified_p = TRUE;
+      *modified_p = FALSE;
       return SVN_NO_ERROR;
     }
 
-  SVN_ERR(err);
-
-  if (pristine_stream == NULL)
+  if ((recorded_size == SVN_WC_ENTRY_WORKING_SIZE_UNKNOWN
+       || dirent->filesize == recorded_size)
+      && dirent->mtime == recorded_mod_time)
     {
-      *modified_p = TRUE;
+      *modified_p = FALSE;
       return SVN_NO_ERROR;
     }
 
-  /* Check all bytes, and verify checksum if requested. */
-  return svn_error_return(compare_and_verify(modified_p, db, local_abspath,
-                                             pristine_stream,
-                                             compare_textbases,
-                                             force_comparison,
-                                             scratch_pool));
+  return svn_error_return(compare_with_pristine(modified_p, db,
+                                                local_abspath,
+                                                FALSE, compare_textbases,
+                                                scratch_pool));
 }
 
 
@@ -23,6 +23,8 @@
 
 #include "svn_wc.h"
 #include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_pools.h"
 #include "wc_db.h"
 #include "wc.h"
 #include "props.h"
@@ -31,7 +33,7 @@
 
 #include "svn_private_config.h"
 
-/* A baton for analyze_status(). */
+/* A baton for analyze_status() and analyze_dir(). */
 struct walk_baton
 {
   svn_wc_revision_status_t *result;           /* where to put the result */
@@ -40,14 +42,12 @@ struct walk_baton
   svn_wc__db_t *db;
 };
 
-/* An svn_wc__node_found_func_t callback function for analyzing the wc
- * status of LOCAL_ABSPATH.  Update the status information in BATON->result.
+/* Analyze the wc status of LOCAL_ABSPATH, the root of the walk.  Update the status information in BATON->result.
  * BATON is a 'struct walk_baton'.
  *
- * Implementation note: Since it can be invoked for a lot of paths in
- * a wc but some data, i.e. if the wc is switched or has modifications, is
- * expensive to calculate, we optimize by checking if those values are
- * already set before runnning the db operations.
+ * Implementation note: Since some data, i.e. if the wc is switched or has
+ * modifications, is expensive to calculate, we optimize by checking if
+ * those values are already set before runnning the db operations.
  *
  * Temporary allocations are made in SCRATCH_POOL. */
 static svn_error_t *
@@ -144,6 +144,230 @@ analyze_status(const char *local_abspath,
   return SVN_NO_ERROR;
 }
 
+/* Update WB->result with the revision RECORDED_REV of a node, unless
+ * that is invalid. */
+static void
+record_revision(struct walk_baton *wb,
+                svn_revnum_t recorded_rev)
+{
+  /* Added files have a revision of no interest */
+  if (recorded_rev == SVN_INVALID_REVNUM)
+    return;
+
+  if (wb->result->min_rev == SVN_INVALID_REVNUM
+      || recorded_rev < wb->result->min_rev)
+    wb->result->min_rev = recorded_rev;
+
+  if (wb->result->max_rev == SVN_INVALID_REVNUM
+      || recorded_rev > wb->result->max_rev)
+    wb->result->max_rev = recorded_rev;
+}
+
+/* Analyze the wc status of LOCAL_ABSPATH, a child of a directory whose
+ * BASE node lives at DIR_REPOS_RELPATH in DIR_REPOS_ROOT_URL, and update
+ * WB->result.  DIR_REPOS_RELPATH may be NULL if that location is not
+ * known.  INFO is the node's information as read by
+ * svn_wc__db_read_children_info() and DIRENT the file's entry as read by
+ * svn_io_get_dirents3(), or NULL if it isn't on disk or wasn't read.
+ *
+ * This is analyze_status() without any per-node queries in the common
+ * cases.  Temporary allocations are made in SCRATCH_POOL. */
+static svn_error_t *
+analyze_child(struct walk_baton *wb,
+              const char *local_abspath,
+              const struct svn_wc__db_info_t *info,
+              const svn_io_dirent2_t *dirent,
+              const char *dir_repos_relpath,
+              const char *dir_repos_root_url,
+              apr_pool_t *scratch_pool)
+{
+  /* See analyze_status() for the hidden nodes. */
+  if (info->status == svn_wc__db_status_excluded
+      || info->status == svn_wc__db_status_absent)
+    {
+      wb->result->sparse_checkout = TRUE;
+      return SVN_NO_ERROR;
+    }
+  else if (info->status == svn_wc__db_status_not_present)
+    {
+      return SVN_NO_ERROR;
+    }
+  else if (info->status == svn_wc__db_status_added
+           || info->status == svn_wc__db_status_obstructed_add
+           || info->status == svn_wc__db_status_deleted
+           || info->status == svn_wc__db_status_obstructed_delete)
+    {
+      wb->result->modified = TRUE;
+    }
+
+  if (! wb->result->switched)
+    {
+      if (dir_repos_relpath == NULL)
+        {
+          svn_boolean_t wc_root;
+          svn_boolean_t switched;
+
+          SVN_ERR(svn_wc__check_wc_root(&wc_root, NULL, &switched, wb->db,
+                                        local_abspath, scratch_pool));
+
+          wb->result->switched |= switched;
+        }
+      else if (info->repos_relpath
+               && ! (info->repos_root_url && dir_repos_root_url
+                     && strcmp(info->repos_root_url, dir_repos_root_url)))
+        {
+          /* Like svn_wc__check_wc_root(): only a node with a location of
+             its own in the parent's repository can be switched. */
+          wb->result->switched
+            |= ! svn_relpath__is_joined(info->repos_relpath,
+                                        dir_repos_relpath,
+                                        svn_dirent_basename(local_abspath,
+                                                            NULL));
+        }
+    }
+
+  record_revision(wb, wb->committed ? info->changed_rev : info->revnum);
+
+#if (SVN_WC__VERSION < SVN_WC__PROPS_IN_DB)
+  if (! wb->result->modified)
+    {
+      svn_boolean_t props_mod;
+
+      SVN_ERR(svn_wc__props_modified(&props_mod, wb->db, local_abspath,
+                                     scratch_pool));
+      wb->result->modified |= props_mod;
+    }
+#else
+  wb->result->modified |= info->props_mod;
+#endif
+
+  if (! wb->result->modified && info->kind == svn_wc__db_kind_file)
+    {
+      svn_boolean_t text_mod;
+
+      if (dirent)
+        SVN_ERR(svn_wc__internal_file_modified_p(&text_mod, wb->db,
+                                                 local_abspath, dirent,
+                                                 info->translated_size,
+                                                 info->last_mod_time,
+                                                 TRUE, scratch_pool));
+      else
+        SVN_ERR(svn_wc__internal_text_modified_p(&text_mod, wb->db,
+                                                 local_abspath,
+                                                 FALSE,
+                                                 TRUE,
+                                                 scratch_pool));
+      wb->result->modified |= text_mod;
+    }
+
+  wb->result->sparse_checkout |= (info->depth != svn_depth_infinity
+                                  && info->depth != svn_depth_unknown);
+  return SVN_NO_ERROR;
+}
+
+/* Analyze the wc status of all nodes below the directory DIR_ABSPATH,
+ * whose BASE node lives at DIR_REPOS_RELPATH in DIR_REPOS_ROOT_URL, or
+ * at an unknown location if DIR_REPOS_RELPATH is NULL.  Update
+ * WB->result.
+ *
+ * Rather than querying the database for each node, this reads all
+ * children of a directory at once, and the sizes and timestamps of the
+ * files along with them for the modification checks.
+ *
+ * Temporary allocations are made in SCRATCH_POOL. */
+static svn_error_t *
+analyze_dir(struct walk_baton *wb,
+            const char *dir_abspath,
+            const char *dir_repos_relpath,
+            const char *dir_repos_root_url,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *scratch_pool)
+{
+  apr_hash_t *nodes;
+  apr_hash_t *conflicts;
+  apr_hash_t *dirents = NULL;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts, wb->db,
+                                        dir_abspath, scratch_pool,
+                                        scratch_pool));
+
+  /* The on-disk information is only needed to look for modifications. */
+  if (! wb->result->modified)
+    {
+      svn_error_t *err = svn_io_get_dirents3(&dirents, dir_abspath, FALSE,
+                                             scratch_pool, scratch_pool);
+
+      if (err && (APR_STATUS_IS_ENOENT(err->apr_err)
+                  || APR_STATUS_IS_ENOTDIR(err->apr_err)))
+        svn_error_clear(err);
+      else
+        SVN_ERR(err);
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = svn__apr_hash_index_key(hi);
+      const struct svn_wc__db_info_t *info = svn__apr_hash_index_val(hi);
+      const char *child_abspath;
+      const char *child_repos_relpath;
+      const char *child_repos_root_url;
+
+      svn_pool_clear(iterpool);
+
+      /* See if someone wants to cancel this operation. */
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      child_abspath = svn_dirent_join(dir_abspath, name, iterpool);
+
+      SVN_ERR(analyze_child(wb, child_abspath, info,
+                            dirents ? apr_hash_get(dirents, name,
+                                                   APR_HASH_KEY_STRING)
+                                    : NULL,
+                            dir_repos_relpath, dir_repos_root_url,
+                            iterpool));
+
+      /* Hidden directories have nothing below them. */
+      if (info->kind != svn_wc__db_kind_dir
+          || info->status == svn_wc__db_status_excluded
+          || info->status == svn_wc__db_status_absent
+          || info->status == svn_wc__db_status_not_present)
+        continue;
+
+      /* Where does the subdirectory's BASE node live? */
+      if (info->repos_relpath)
+        {
+          child_repos_relpath = info->repos_relpath;
+          child_repos_root_url = info->repos_root_url ? info->repos_root_url
+                                                      : dir_repos_root_url;
+        }
+      else if (dir_repos_relpath
+               && (info->status == svn_wc__db_status_normal
+                   || info->status == svn_wc__db_status_incomplete))
+        {
+          child_repos_relpath = svn_relpath_join(dir_repos_relpath, name,
+                                                 iterpool);
+          child_repos_root_url = dir_repos_root_url;
+        }
+      else
+        {
+          child_repos_relpath = NULL;
+          child_repos_root_url = NULL;
+        }
+
+      SVN_ERR(analyze_dir(wb, child_abspath, child_repos_relpath,
+                          child_repos_root_url, cancel_func, cancel_baton,
+                          iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc_revision_status2(svn_wc_revision_status_t **result_p,
                         svn_wc_context_t *wc_ctx,
@@ -157,6 +381,11 @@ svn_wc_revision_status2(svn_wc_revision_status_t **result_p,
 {
   struct walk_baton wb;
   const char *url;
+  svn_wc__db_status_t status;
+  svn_wc__db_kind_t kind;
+  svn_depth_t depth;
+  const char *repos_relpath;
+  const char *repos_root_url;
   svn_wc_revision_status_t *result = apr_palloc(result_pool, sizeof(*result));
   *result_p = result;
 
@@ -196,13 +425,30 @@ svn_wc_revision_status2(svn_wc_revision_status_t **result_p,
         }
     }
 
-  SVN_ERR(svn_wc__node_walk_children(wc_ctx,
-                                     local_abspath,
-                                     TRUE /* show_hidden */,
-                                     analyze_status, &wb,
-                                     svn_depth_infinity,
-                                     cancel_func, cancel_baton,
-                                     scratch_pool));
+  /* Look at the root, and then at everything below it, in the same way
+     svn_wc__node_walk_children() would visit the nodes. */
+  SVN_ERR(analyze_status(local_abspath, &wb, scratch_pool));
 
-  return SVN_NO_ERROR;
+  SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, &repos_relpath,
+                               &repos_root_url, NULL, NULL, NULL, NULL,
+                               NULL, &depth, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, wc_ctx->db, local_abspath, scratch_pool,
+                               scratch_pool));
+
+  if (kind != svn_wc__db_kind_dir || depth == svn_depth_exclude)
+    return SVN_NO_ERROR;
+
+  /* Switched children can only be spotted cheaply below a BASE node. */
+  if (status != svn_wc__db_status_normal
+      && status != svn_wc__db_status_incomplete)
+    repos_relpath = NULL;
+  else if (repos_relpath == NULL)
+    SVN_ERR(svn_wc__db_scan_base_repos(&repos_relpath, &repos_root_url, NULL,
+                                       wc_ctx->db, local_abspath,
+                                       scratch_pool, scratch_pool));
+
+  return svn_error_return(analyze_dir(&wb, local_abspath, repos_relpath,
+                                      repos_root_url, cancel_func,
+                                      cancel_baton, scratch_pool));
 }
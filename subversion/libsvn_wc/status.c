@@ -45,6 +45,7 @@
 #include "svn_private_config.h"
 
 #include "wc.h"
+#include "adm_files.h"
 #include "lock.h"
 #include "props.h"
 #include "entries.h"
@@ -78,6 +79,10 @@ struct walk_status_baton
 
   /* Repository locks, if set. */
   apr_hash_t *repos_locks;
+
+  /*** Change journal handling ***/
+  /* The change journal of the working copy, if one is being kept. */
+  struct status_journal_t *journal;
 };
 
 /*** Editor batons ***/
@@ -250,6 +255,14 @@ internal_status(svn_wc_status3_t **status,
    *STATUS in POOL.  LOCAL_ABSPATH must be absolute.  Use SCRATCH_POOL for
    temporary allocations.
 
+   INFO is the node's information as read by svn_wc__db_read_children_info(),
+   or NULL, in which case it is read from DB.
+
+   DIRENT is LOCAL_ABSPATH's entry as read by svn_io_get_dirents3() with
+   its size and modification time, or NULL.  If both INFO and DIRENT are
+   given, they are used to check for text modifications without another
+   stat() or database lookup.
+
    PARENT_ENTRY is the entry for the parent directory of LOCAL_ABSPATH, it
    may be NULL if LOCAL_ABSPATH is a working copy root.
    The lifetime of PARENT_ENTRY's pool is not important.
@@ -271,6 +284,8 @@ static svn_error_t *
 assemble_status(svn_wc_status3_t **status,
                 svn_wc__db_t *db,
                 const char *local_abspath,
+                const struct svn_wc__db_info_t *info,
+                const svn_io_dirent2_t *dirent,
                 const char *parent_repos_root_url,
                 const char *parent_repos_relpath,
                 svn_node_kind_t path_kind,
@@ -311,20 +326,43 @@ assemble_status(svn_wc_status3_t **status,
   enum svn_wc_status_kind pristine_text_status = svn_wc_status_none;
   enum svn_wc_status_kind pristine_prop_status = svn_wc_status_none;
 
+  if (info)
+    {
+      db_status = info->status;
+      db_kind = info->kind;
+      revision = info->revnum;
+      repos_relpath = info->repos_relpath;
+      repos_root_url = info->repos_root_url;
+      changed_rev = info->changed_rev;
+      changed_date = info->changed_date;
+      changed_author = info->changed_author;
+      depth = info->depth;
+      changelist = info->changelist;
+      prop_modified_p = info->props_mod;
+      base_shadowed = info->base_shadowed;
+      conflicted = info->conflicted;
+      lock = info->lock;
+    }
+  else
+    SVN_ERR(svn_wc__db_read_info(&db_status, &db_kind, &revision,
+                                 &repos_relpath, &repos_root_url, NULL,
+                                 &changed_rev, &changed_date,
+                                 &changed_author, NULL, &depth, NULL, NULL,
+                                 NULL, &changelist, NULL, NULL, NULL, NULL,
+                                 NULL, &prop_modified_p, &base_shadowed,
+                                 &conflicted, &lock, db, local_abspath,
+                                 result_pool, scratch_pool));
+
   /* Find out whether the path is a tree conflict victim.
    * This function will set tree_conflict to NULL if the path
-   * is not a victim. */
-  SVN_ERR(svn_wc__db_op_read_tree_conflict(&tree_conflict, db, local_abspath,
-                                           scratch_pool, scratch_pool));
-
-  SVN_ERR(svn_wc__db_read_info(&db_status, &db_kind, &revision,
-                               &repos_relpath, &repos_root_url, NULL,
-                               &changed_rev, &changed_date,
-                               &changed_author, NULL, &depth, NULL, NULL,
-                               NULL, &changelist, NULL, NULL, NULL, NULL,
-                               NULL, &prop_modified_p, &base_shadowed,
-                               &conflicted, &lock, db, local_abspath,
-                               result_pool, scratch_pool));
+   * is not a victim.  A node that is not conflicted at all can't be a
+   * tree conflict victim either. */
+  if (conflicted)
+    SVN_ERR(svn_wc__db_op_read_tree_conflict(&tree_conflict, db,
+                                             local_abspath,
+                                             scratch_pool, scratch_pool));
+  else
+    tree_conflict = NULL;
 
   /* ### Temporary until we've revved svn_wc_status3_t to only use
    * ### repos_{root_url,relpath} */
@@ -355,9 +393,9 @@ assemble_status(svn_wc_status3_t **status,
             }
           else
             {
-              switched_p = (strcmp(svn_relpath_join(parent_repos_relpath, base,
-                                                    scratch_pool),
-                                   repos_relpath) != 0);
+              switched_p = ! svn_relpath__is_joined(repos_relpath,
+                                                    parent_repos_relpath,
+                                                    base);
             }
         }
     }
@@ -480,10 +518,17 @@ assemble_status(svn_wc_status3_t **status,
 #endif /* HAVE_SYMLINK */
           )
         {
-          err = svn_wc__internal_text_modified_p(&text_modified_p,
-                                                 db, local_abspath,
-                                                 FALSE, TRUE,
-                                                 scratch_pool);
+          if (info && dirent)
+            err = svn_wc__internal_file_modified_p(&text_modified_p,
+                                                   db, local_abspath, dirent,
+                                                   info->translated_size,
+                                                   info->last_mod_time,
+                                                   TRUE, scratch_pool);
+          else
+            err = svn_wc__internal_text_modified_p(&text_modified_p,
+                                                   db, local_abspath,
+                                                   FALSE, TRUE,
+                                                   scratch_pool);
 
           if (err)
             {
@@ -595,7 +640,16 @@ assemble_status(svn_wc_status3_t **status,
         }
       else if (path_kind == svn_node_none)
         {
-          if (final_text_status != svn_wc_status_deleted)
+          svn_boolean_t dehydrated = FALSE;
+
+          /* A file checked out without its text isn't missing. */
+          if (final_text_status != svn_wc_status_deleted
+              && db_kind == svn_wc__db_kind_file)
+            SVN_ERR(svn_wc__internal_is_dehydrated(&dehydrated, db,
+                                                   local_abspath, NULL,
+                                                   scratch_pool));
+
+          if (final_text_status != svn_wc_status_deleted && ! dehydrated)
             final_text_status = svn_wc_status_missing;
         }
       /* ### We can do this db_kind to node_kind translation since the cases
@@ -759,6 +813,8 @@ assemble_unversioned(svn_wc_status3_t **status,
 static svn_error_t *
 send_status_structure(const struct walk_status_baton *wb,
                       const char *local_abspath,
+                      const struct svn_wc__db_info_t *info,
+                      const svn_io_dirent2_t *dirent,
                       const char *parent_repos_root_url,
                       const char *parent_repos_relpath,
                       svn_node_kind_t path_kind,
@@ -779,12 +835,20 @@ send_status_structure(const struct walk_status_baton *wb,
       svn_wc__db_status_t status;
       svn_boolean_t base_shadowed;
 
-      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, &repos_relpath, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, &base_shadowed, NULL, NULL, 
-                                   wb->db, local_abspath,
-                                   scratch_pool, scratch_pool));
+      if (info)
+        {
+          status = info->status;
+          repos_relpath = info->repos_relpath;
+          base_shadowed = info->base_shadowed;
+        }
+      else
+        SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, &repos_relpath,
+                                     NULL, NULL, NULL, NULL, NULL, NULL,
+                                     NULL, NULL, NULL, NULL, NULL, NULL,
+                                     NULL, NULL, NULL, NULL, NULL,
+                                     &base_shadowed, NULL, NULL,
+                                     wb->db, local_abspath,
+                                     scratch_pool, scratch_pool));
 
       /* A switched path can be deleted: check the right relpath */
       if (status == svn_wc__db_status_deleted && base_shadowed)
@@ -810,7 +874,7 @@ send_status_structure(const struct walk_status_baton *wb,
         }
     }
 
-  SVN_ERR(assemble_status(&statstruct, wb->db, local_abspath,
+  SVN_ERR(assemble_status(&statstruct, wb->db, local_abspath, info, dirent,
                           parent_repos_root_url, parent_repos_relpath,
                           path_kind, path_special, get_all, is_ignored,
                           repos_lock, scratch_pool, scratch_pool));
@@ -984,18 +1048,18 @@ get_dir_status(const struct walk_status_baton *wb,
                void *cancel_baton,
                apr_pool_t *scratch_pool);
 
-/* Handle LOCAL_ABSPATH (whose entry is ENTRY).  All other arguments
-   are the same as those passed to get_dir_status(), the function
-   for which this one is a helper.  */
+/* Handle LOCAL_ABSPATH, whose information as read by
+   svn_wc__db_read_children_info() is INFO and whose entry as read by
+   svn_io_get_dirents3() is DIRENT, or NULL if it isn't on disk.  All
+   other arguments are the same as those passed to get_dir_status(), the
+   function for which this one is a helper.  */
 static svn_error_t *
 handle_dir_entry(const struct walk_status_baton *wb,
                  const char *local_abspath,
-                 svn_wc__db_status_t status,
-                 svn_wc__db_kind_t db_kind,
+                 const struct svn_wc__db_info_t *info,
                  const char *dir_repos_root_url,
                  const char *dir_repos_relpath,
-                 svn_node_kind_t path_kind,
-                 svn_boolean_t path_special,
+                 const svn_io_dirent2_t *dirent,
                  const apr_array_header_t *ignores,
                  svn_depth_t depth,
                  svn_boolean_t get_all,
@@ -1007,16 +1071,16 @@ handle_dir_entry(const struct walk_status_baton *wb,
                  apr_pool_t *pool)
 {
   /* We are looking at a directory on-disk.  */
-  if (path_kind == svn_node_dir
-      && db_kind == svn_wc__db_kind_dir)
+  if (dirent && dirent->kind == svn_node_dir
+      && info->kind == svn_wc__db_kind_dir)
     {
       /* Descend only if the subdirectory is a working copy directory (which
          we've discovered because we got a THIS_DIR entry. And only descend
          if DEPTH permits it, of course.  */
 
-      if (status != svn_wc__db_status_obstructed
-          && status != svn_wc__db_status_obstructed_add
-          && status != svn_wc__db_status_obstructed_delete
+      if (info->status != svn_wc__db_status_obstructed
+          && info->status != svn_wc__db_status_obstructed_add
+          && info->status != svn_wc__db_status_obstructed_delete
           && (depth == svn_depth_unknown
               || depth == svn_depth_immediates
               || depth == svn_depth_infinity))
@@ -1032,7 +1096,7 @@ handle_dir_entry(const struct walk_status_baton *wb,
         {
           /* ENTRY is a child entry (file or parent stub). Or we have a
              directory entry but DEPTH is limiting our recursion.  */
-          SVN_ERR(send_status_structure(wb, local_abspath,
+          SVN_ERR(send_status_structure(wb, local_abspath, info, NULL,
                                         dir_repos_root_url,
                                         dir_repos_relpath, svn_node_dir,
                                         FALSE /* path_special */,
@@ -1043,10 +1107,12 @@ handle_dir_entry(const struct walk_status_baton *wb,
   else
     {
       /* This is a file/symlink on-disk or not a directory in the db.  */
-      SVN_ERR(send_status_structure(wb, local_abspath,
+      SVN_ERR(send_status_structure(wb, local_abspath, info, dirent,
                                     dir_repos_root_url,
-                                    dir_repos_relpath, path_kind,
-                                    path_special, get_all, 
+                                    dir_repos_relpath,
+                                    dirent ? dirent->kind : svn_node_none,
+                                    dirent ? dirent->special : FALSE,
+                                    get_all,
                                     FALSE /* is_ignored */,
                                     status_func, status_baton, pool));
     }
@@ -1106,6 +1172,352 @@ handle_externals(const struct walk_status_baton *wb,
 }
 
 
+/*** Change journal ***/
+
+/* A watcher such as tools/dev/wc-watch.py may keep a change journal in
+   the administrative area of the directory it watches.  Its first line
+   is "svn-status-journal 1 TOKEN", where TOKEN identifies the watcher
+   run.  Every following line is the path, relative to the watched
+   directory and "." for itself, of a directory in which something was
+   created, removed or written to, including in its administrative area.
+   The watcher removes the journal when it stops or misses events, and
+   touches it regularly while it runs.
+
+   The status walk records the directories whose entries it found
+   unchanged next to the journal, in a file whose first line is
+   "svn-status-clean 1 TOKEN OFFSET", followed by their paths.  Later
+   walks don't read the entries of those directories from disk, unless
+   the journal mentions them after its first OFFSET bytes. */
+#define JOURNAL_NAME "status-journal"
+#define JOURNAL_HEADER "svn-status-journal 1 "
+#define CLEAN_NAME "status-clean"
+#define CLEAN_HEADER "svn-status-clean 1 "
+
+/* A journal that hasn't been touched for this long isn't trusted, since
+   its watcher apparently died without removing it. */
+#define JOURNAL_MAX_AGE apr_time_from_sec(60)
+
+struct status_journal_t
+{
+  /* The directory the journal describes. */
+  const char *root_abspath;
+
+  /* The token of the watcher run that wrote the journal. */
+  const char *token;
+
+  /* The length of the complete lines of the journal that were read. */
+  apr_size_t offset;
+
+  /* The paths, relative to ROOT_ABSPATH, of the directories whose
+     entries are known to be unchanged, mapped to "".  The walk updates
+     it as it goes. */
+  apr_hash_t *clean;
+};
+
+/* Set *LINE to the next complete line in the buffer between *POS and
+   END, without its newline, and advance *POS past it.  A line reading
+   "." is returned as "".  Return FALSE if there is no complete line
+   left.  Allocate *LINE in POOL. */
+static svn_boolean_t
+next_line(const char **line,
+          const char **pos,
+          const char *end,
+          apr_pool_t *pool)
+{
+  const char *eol = memchr(*pos, '\n', end - *pos);
+
+  if (! eol)
+    return FALSE;
+
+  if (eol - *pos == 1 && **pos == '.')
+    *line = "";
+  else
+    *line = apr_pstrmemdup(pool, *pos, eol - *pos);
+  *pos = eol + 1;
+  return TRUE;
+}
+
+/* Read the file at PATH into *CONTENTS, allocated in POOL, or set
+   *CONTENTS to NULL if it can't be read.  The watcher may remove its
+   journal at any time. */
+static void
+read_journal_file(svn_stringbuf_t **contents,
+                  const char *path,
+                  apr_pool_t *pool)
+{
+  svn_error_t *err = svn_stringbuf_from_file2(contents, path, pool);
+
+  if (err)
+    {
+      svn_error_clear(err);
+      *contents = NULL;
+    }
+}
+
+/* Set *JOURNAL to the change journal that describes DIR_ABSPATH, kept in
+   the administrative area of DIR_ABSPATH or one of its ancestors, or to
+   NULL if there is none that can be trusted.  Allocate *JOURNAL in
+   RESULT_POOL and do temporary allocations in SCRATCH_POOL. */
+static svn_error_t *
+open_journal(struct status_journal_t **journal,
+             const char *dir_abspath,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  const char *root_abspath = dir_abspath;
+  const char *journal_path;
+  svn_stringbuf_t *contents, *clean_contents;
+  const char *line, *pos, *end, *clean_pos, *clean_end;
+  const char *offset_str;
+  char *offset_end;
+  apr_int64_t clean_offset;
+  apr_finfo_t finfo;
+  svn_error_t *err;
+  struct status_journal_t *jrnl;
+
+  *journal = NULL;
+
+  /* Look for the journal in the administrative areas above DIR_ABSPATH,
+     as far up as there are any. */
+  while (TRUE)
+    {
+      svn_node_kind_t kind;
+
+      journal_path = svn_wc__adm_child(root_abspath, JOURNAL_NAME,
+                                       scratch_pool);
+      err = svn_io_stat(&finfo, journal_path, APR_FINFO_MTIME, scratch_pool);
+      if (! err)
+        break;
+      svn_error_clear(err);
+
+      if (svn_dirent_is_root(root_abspath, strlen(root_abspath)))
+        return SVN_NO_ERROR;
+
+      root_abspath = svn_dirent_dirname(root_abspath, scratch_pool);
+      SVN_ERR(svn_io_check_path(svn_wc__adm_child(root_abspath, NULL,
+                                                  scratch_pool),
+                                &kind, scratch_pool));
+      if (kind != svn_node_dir)
+        return SVN_NO_ERROR;
+    }
+
+  if (apr_time_now() - finfo.mtime > JOURNAL_MAX_AGE)
+    return SVN_NO_ERROR;
+
+  read_journal_file(&contents, journal_path, scratch_pool);
+  if (! contents)
+    return SVN_NO_ERROR;
+
+  pos = contents->data;
+  end = contents->data + contents->len;
+  if (! next_line(&line, &pos, end, scratch_pool)
+      || strncmp(line, JOURNAL_HEADER, sizeof(JOURNAL_HEADER) - 1) != 0)
+    return SVN_NO_ERROR;
+
+  jrnl = apr_pcalloc(result_pool, sizeof(*jrnl));
+  jrnl->root_abspath = apr_pstrdup(result_pool, root_abspath);
+  jrnl->token = apr_pstrdup(result_pool, line + sizeof(JOURNAL_HEADER) - 1);
+  jrnl->clean = apr_hash_make(result_pool);
+
+  /* Only complete lines count; the watcher may be writing the last one. */
+  while (end > pos && end[-1] != '\n')
+    end--;
+  jrnl->offset = end - contents->data;
+  *journal = jrnl;
+
+  /* Start from the directories the last walk found unchanged, if it was
+     made while the same watcher was running. */
+  read_journal_file(&clean_contents,
+                    svn_wc__adm_child(root_abspath, CLEAN_NAME,
+                                      scratch_pool),
+                    scratch_pool);
+  if (! clean_contents)
+    return SVN_NO_ERROR;
+
+  clean_pos = clean_contents->data;
+  clean_end = clean_contents->data + clean_contents->len;
+  if (! next_line(&line, &clean_pos, clean_end, scratch_pool)
+      || strncmp(line, CLEAN_HEADER, sizeof(CLEAN_HEADER) - 1) != 0)
+    return SVN_NO_ERROR;
+
+  line += sizeof(CLEAN_HEADER) - 1;
+  offset_str = strrchr(line, ' ');
+  if (! offset_str
+      || strlen(jrnl->token) != (apr_size_t)(offset_str - line)
+      || strncmp(line, jrnl->token, offset_str - line) != 0)
+    return SVN_NO_ERROR;
+
+  clean_offset = apr_strtoi64(offset_str + 1, &offset_end, 10);
+  if (*offset_end || offset_end == offset_str + 1
+      || clean_offset < 0 || clean_offset > (apr_int64_t)jrnl->offset)
+    return SVN_NO_ERROR;
+
+  while (next_line(&line, &clean_pos, clean_end, scratch_pool))
+    apr_hash_set(jrnl->clean, apr_pstrdup(result_pool, line),
+                 APR_HASH_KEY_STRING, "");
+
+  /* Forget about the directories that changed since. */
+  pos = contents->data + clean_offset;
+  while (next_line(&line, &pos, end, scratch_pool))
+    apr_hash_set(jrnl->clean, line, APR_HASH_KEY_STRING, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Record the directories JOURNAL knows to be unchanged for the next
+   walk.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_journal_clean(const struct status_journal_t *journal,
+                    apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  apr_hash_index_t *hi;
+  apr_file_t *file;
+  const char *tmp_path;
+
+  contents = svn_stringbuf_createf(scratch_pool,
+                                   CLEAN_HEADER "%s %" APR_SIZE_T_FMT "\n",
+                                   journal->token, journal->offset);
+  for (hi = apr_hash_first(scratch_pool, journal->clean); hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *relpath = svn__apr_hash_index_key(hi);
+
+      svn_stringbuf_appendcstr(contents, *relpath ? relpath : ".");
+      svn_stringbuf_appendbytes(contents, "\n", 1);
+    }
+
+  SVN_ERR(svn_io_open_uniquely_named(&file, &tmp_path,
+                                     svn_wc__adm_child(journal->root_abspath,
+                                                       NULL, scratch_pool),
+                                     CLEAN_NAME, ".tmp", svn_io_file_del_none,
+                                     scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, contents->data, contents->len, NULL,
+                                 scratch_pool));
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  return svn_error_return(
+           svn_io_file_rename(tmp_path,
+                              svn_wc__adm_child(journal->root_abspath,
+                                                CLEAN_NAME, scratch_pool),
+                              scratch_pool));
+}
+
+/* Return TRUE if the entries DIRENTS of a directory, as read from disk,
+   match what NODES and CONFLICTS, as read by
+   svn_wc__db_read_children_info(), say about its children closely
+   enough for unchanged_dirents() to rebuild them: every child that is
+   present in the working copy is a file with its recorded size and
+   modification time or a directory, there is nothing else on disk apart
+   from the administrative area, and there are no tree conflicts.  Use
+   POOL for temporary allocations. */
+static svn_boolean_t
+dirents_unchanged(apr_hash_t *dirents,
+                  apr_hash_t *nodes,
+                  apr_hash_t *conflicts,
+                  apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+
+  if (apr_hash_count(conflicts) > 0)
+    return FALSE;
+
+  for (hi = apr_hash_first(pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = svn__apr_hash_index_key(hi);
+      const struct svn_wc__db_info_t *info = svn__apr_hash_index_val(hi);
+      const svn_io_dirent2_t *dirent = apr_hash_get(dirents, name,
+                                                    APR_HASH_KEY_STRING);
+
+      if (info->status == svn_wc__db_status_excluded
+          || info->status == svn_wc__db_status_absent
+          || info->status == svn_wc__db_status_not_present)
+        {
+          if (dirent)
+            return FALSE;
+          continue;
+        }
+
+      if ((info->status != svn_wc__db_status_normal
+           && info->status != svn_wc__db_status_added)
+          || ! dirent || dirent->special)
+        return FALSE;
+
+      if (info->kind == svn_wc__db_kind_dir)
+        {
+          if (dirent->kind != svn_node_dir)
+            return FALSE;
+        }
+      else if (info->kind == svn_wc__db_kind_file)
+        {
+          if (dirent->kind != svn_node_file
+              || dirent->mtime != info->last_mod_time
+              || (info->translated_size != SVN_WC_ENTRY_WORKING_SIZE_UNKNOWN
+                  && dirent->filesize != info->translated_size))
+            return FALSE;
+        }
+      else
+        return FALSE;
+    }
+
+  for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = svn__apr_hash_index_key(hi);
+
+      if (! apr_hash_get(nodes, name, APR_HASH_KEY_STRING)
+          && ! svn_wc_is_adm_dir(name, pool))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Set *DIRENTS to the entries of a directory whose children NODES, as
+   read by svn_wc__db_read_children_info(), were found to match them by
+   dirents_unchanged(), rebuilt from NODES, or to NULL if NODES changed
+   in a way that doesn't allow that anymore.  Allocate *DIRENTS in
+   RESULT_POOL and do temporary allocations in SCRATCH_POOL. */
+static void
+unchanged_dirents(apr_hash_t **dirents,
+                  apr_hash_t *nodes,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+
+  *dirents = apr_hash_make(result_pool);
+
+  for (hi = apr_hash_first(scratch_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = svn__apr_hash_index_key(hi);
+      const struct svn_wc__db_info_t *info = svn__apr_hash_index_val(hi);
+      svn_io_dirent2_t *dirent;
+
+      if (info->status == svn_wc__db_status_excluded
+          || info->status == svn_wc__db_status_absent
+          || info->status == svn_wc__db_status_not_present)
+        continue;
+
+      if ((info->status != svn_wc__db_status_normal
+           && info->status != svn_wc__db_status_added)
+          || (info->kind != svn_wc__db_kind_file
+              && info->kind != svn_wc__db_kind_dir))
+        {
+          *dirents = NULL;
+          return;
+        }
+
+      dirent = apr_pcalloc(result_pool, sizeof(*dirent));
+      dirent->kind = (info->kind == svn_wc__db_kind_dir) ? svn_node_dir
+                                                         : svn_node_file;
+      dirent->special = FALSE;
+      dirent->filesize = info->translated_size;
+      dirent->mtime = info->last_mod_time;
+      apr_hash_set(*dirents, name, APR_HASH_KEY_STRING, dirent);
+    }
+}
+
+
 /* Send svn_wc_status3_t * structures for the directory LOCAL_ABSPATH and
    for all its entries through STATUS_FUNC/STATUS_BATON, or, if SELECTED
    is non-NULL, only for that directory entry.
@@ -1143,6 +1555,7 @@ get_dir_status(const struct walk_status_baton *wb,
   apr_array_header_t *patterns = NULL;
   svn_wc__db_status_t dir_status;
   svn_depth_t dir_depth;
+  const char *journal_relpath = NULL;
   apr_pool_t *iterpool, *subpool = svn_pool_create(scratch_pool);
 
   /* See if someone wants to cancel this operation. */
@@ -1155,16 +1568,45 @@ get_dir_status(const struct walk_status_baton *wb,
   /* Make our iteration pool. */
   iterpool = svn_pool_create(subpool);
 
-  /* Load list of childnodes. */
-  {
-    const apr_array_header_t *child_nodes;
+  /* Load the information about all childnodes at once. */
+  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts, wb->db,
+                                        local_abspath, subpool, iterpool));
+
+  /* If the change journal says nothing changed here since the last walk,
+     and that walk found the entries on disk to match the working copy,
+     don't read them again.  Only keep track of the directories whose
+     children are all looked at. */
+  dirents = NULL;
+  if (wb->journal && selected == NULL
+      && (depth == svn_depth_immediates || depth == svn_depth_infinity)
+      && svn_dirent_is_ancestor(wb->journal->root_abspath, local_abspath))
+    {
+      journal_relpath = svn_dirent_skip_ancestor(wb->journal->root_abspath,
+                                                 local_abspath);
+      if (strchr(journal_relpath, '\n'))
+        journal_relpath = NULL;
+      else if (apr_hash_get(wb->journal->clean, journal_relpath,
+                            APR_HASH_KEY_STRING))
+        unchanged_dirents(&dirents, nodes, subpool, iterpool);
+    }
+
+  if (dirents)
+    journal_relpath = NULL;
+  else
+    SVN_ERR(svn_io_get_dirents3(&dirents, local_abspath, FALSE,
+                                subpool, iterpool));
 
-    SVN_ERR(svn_wc__db_read_children(&child_nodes, wb->db, local_abspath,
-                                     iterpool, iterpool));
-    SVN_ERR(svn_hash_from_cstring_keys(&nodes, child_nodes, subpool));
-  }
+  if (journal_relpath)
+    {
+      apr_hash_t *clean = wb->journal->clean;
 
-  SVN_ERR(svn_io_get_dirents2(&dirents, local_abspath, subpool));
+      if (dirents_unchanged(dirents, nodes, conflicts, iterpool))
+        apr_hash_set(clean,
+                     apr_pstrdup(apr_hash_pool_get(clean), journal_relpath),
+                     APR_HASH_KEY_STRING, "");
+      else
+        apr_hash_set(clean, journal_relpath, APR_HASH_KEY_STRING, NULL);
+    }
 
   SVN_ERR(svn_wc__db_read_info(&dir_status, NULL, NULL, &dir_repos_relpath,
                                &dir_repos_root_url, NULL, NULL, NULL, NULL,
@@ -1198,16 +1640,9 @@ get_dir_status(const struct walk_status_baton *wb,
 
   if (selected == NULL)
     {
-      const apr_array_header_t *victims;
       /* Create a hash containing all children */
       all_children = apr_hash_overlay(subpool, nodes, dirents);
 
-      SVN_ERR(svn_wc__db_read_conflict_victims(&victims,
-                                               wb->db, local_abspath,
-                                               iterpool, iterpool));
-
-      SVN_ERR(svn_hash_from_cstring_keys(&conflicts, victims, subpool));
-
       /* Optimize for the no-tree-conflict case */
       if (apr_hash_count(conflicts) > 0)
         all_children = apr_hash_overlay(subpool, conflicts, all_children);
@@ -1242,7 +1677,7 @@ get_dir_status(const struct walk_status_baton *wb,
     {
       /* Handle "this-dir" first. */
       if (! skip_this_dir)
-        SVN_ERR(send_status_structure(wb, local_abspath,
+        SVN_ERR(send_status_structure(wb, local_abspath, NULL, NULL,
                                       parent_repos_root_url,
                                       parent_repos_relpath, svn_node_dir,
                                       FALSE /* path_special */,
@@ -1263,7 +1698,7 @@ get_dir_status(const struct walk_status_baton *wb,
       const void *key;
       apr_ssize_t klen;
       const char *node_abspath;
-      svn_io_dirent_t *dirent_p;
+      svn_io_dirent2_t *dirent_p;
 
       svn_pool_clear(iterpool);
 
@@ -1276,40 +1711,26 @@ get_dir_status(const struct walk_status_baton *wb,
       if (apr_hash_get(nodes, key, klen))
         {
           /* Versioned node */
-          svn_wc__db_status_t node_status;
-          svn_wc__db_kind_t node_kind;
-          svn_boolean_t hidden;
-
-          SVN_ERR(svn_wc__db_read_info(&node_status, &node_kind, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL,
-                                   wb->db, node_abspath, iterpool, iterpool));
-
-          SVN_ERR(svn_wc__db_node_hidden(&hidden, wb->db, node_abspath,
-                                         iterpool));
-
-          /* Hidden looks in the parent stubs, which should not be necessary
-             later. Also skip excluded/absent/not-present working nodes, which
-             only have an implied status via their parent. */
-          if (!hidden
-              && node_status != svn_wc__db_status_excluded
-              && node_status != svn_wc__db_status_absent
-              && node_status != svn_wc__db_status_not_present)
+          const struct svn_wc__db_info_t *info = apr_hash_get(nodes, key,
+                                                              klen);
+
+          /* Skip excluded/absent/not-present nodes, which only have an
+             implied status via their parent. */
+          if (info->status != svn_wc__db_status_excluded
+              && info->status != svn_wc__db_status_absent
+              && info->status != svn_wc__db_status_not_present)
             {
-              if (depth == svn_depth_files && node_kind == svn_wc__db_kind_dir)
+              if (depth == svn_depth_files
+                  && info->kind == svn_wc__db_kind_dir)
                 continue;
 
               /* Handle this entry (possibly recursing). */
               SVN_ERR(handle_dir_entry(wb,
                                        node_abspath,
-                                       node_status,
-                                       node_kind,
+                                       info,
                                        dir_repos_root_url,
                                        dir_repos_relpath,
-                                       dirent_p ? dirent_p->kind
-                                                : svn_node_none,
-                                       dirent_p ? dirent_p->special : FALSE,
+                                       dirent_p,
                                        ignore_patterns,
                                        depth == svn_depth_infinity
                                                            ? depth
@@ -2363,6 +2784,7 @@ svn_wc_get_status_editor5(const svn_delta_editor_t **editor,
 
   eb->wb.db             = wc_ctx->db;
   eb->wb.target_abspath = eb->target_abspath;
+  eb->wb.journal        = NULL;
   eb->wb.external_func  = external_func;
   eb->wb.external_baton = external_baton;
   eb->wb.externals      = apr_hash_make(result_pool);
@@ -2439,6 +2861,7 @@ svn_wc_walk_status(svn_wc_context_t *wc_ctx,
   wb.external_baton = external_baton;
   wb.repos_root = NULL;
   wb.repos_locks = NULL;
+  wb.journal = NULL;
 
   /* Use the caller-provided ignore patterns if provided; the build-time
      configured defaults otherwise. */
@@ -2473,6 +2896,9 @@ svn_wc_walk_status(svn_wc_context_t *wc_ctx,
     }
   else if (kind == svn_node_dir && local_kind == svn_node_dir)
     {
+      SVN_ERR(open_journal(&wb.journal, local_abspath, scratch_pool,
+                           scratch_pool));
+
       SVN_ERR(get_dir_status(&wb,
                              local_abspath,
                              NULL,
@@ -2488,6 +2914,11 @@ svn_wc_walk_status(svn_wc_context_t *wc_ctx,
                              cancel_func,
                              cancel_baton,
                              scratch_pool));
+
+      /* Recording what was found is only an optimization for the next
+         walk, so failing to do so is not an error. */
+      if (wb.journal)
+        svn_error_clear(write_journal_clean(wb.journal, scratch_pool));
     }
   else
     {
@@ -2638,6 +3069,7 @@ internal_status(svn_wc_status3_t **status,
     }
 
   return svn_error_return(assemble_status(status, db, local_abspath,
+                                          NULL, NULL,
                                           parent_repos_root_url,
                                           parent_repos_relpath, path_kind,
                                           path_special,
@@ -311,6 +311,74 @@ svn_wc__read_tree_conflicts(apr_hash_t **conflicts,
   return SVN_NO_ERROR;
 }
 
+/* Return TRUE if the valid conflict skel C_SKEL describes a tree
+ * conflict on the victim VICTIM_BASENAME of length LEN. */
+static svn_boolean_t
+is_conflict_on(const svn_skel_t *c_skel,
+               const char *victim_basename,
+               apr_size_t len)
+{
+  const svn_skel_t *victim = c_skel->children->next;
+
+  return victim->len == len
+         && memcmp(victim->data, victim_basename, len) == 0;
+}
+
+/* Parse CONFLICT_DATA, or an empty list if that is NULL, into *SKEL,
+ * allocated in POOL. */
+static svn_error_t *
+parse_tree_conflicts_skel(svn_skel_t **skel,
+                          const char *conflict_data,
+                          apr_pool_t *pool)
+{
+  if (conflict_data == NULL)
+    *skel = svn_skel__make_empty_list(pool);
+  else
+    *skel = svn_skel__parse(conflict_data, strlen(conflict_data), pool);
+
+  if (*skel == NULL)
+    return svn_error_create(SVN_ERR_WC_CORRUPT, NULL,
+                            _("Error parsing tree conflict skel"));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__read_tree_conflict(const svn_wc_conflict_description2_t **conflict,
+                           const char *conflict_data,
+                           const char *victim_abspath,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  const char *victim_basename = svn_dirent_basename(victim_abspath, NULL);
+  apr_size_t len = strlen(victim_basename);
+  svn_skel_t *skel;
+
+  *conflict = NULL;
+  if (conflict_data == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(parse_tree_conflicts_skel(&skel, conflict_data, scratch_pool));
+
+  /* Only the victim's description gets converted; the others are merely
+     matched by name. */
+  for (skel = skel->children; skel != NULL; skel = skel->next)
+    {
+      if (!is_valid_conflict_skel(skel))
+        return svn_error_create(SVN_ERR_WC_CORRUPT, NULL,
+                                _("Invalid conflict info in tree conflict "
+                                  "description"));
+
+      if (is_conflict_on(skel, victim_basename, len))
+        return svn_wc__deserialize_conflict(conflict, skel,
+                                            svn_dirent_dirname(victim_abspath,
+                                                               scratch_pool),
+                                            result_pool, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Prepend to SKEL the string corresponding to enumeration value N, as found
  * in MAP. */
 static svn_error_t *
@@ -446,6 +514,50 @@ svn_wc__write_tree_conflicts(const char **conflict_data,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__set_tree_conflict_data(const char **new_conflict_data,
+                               const char *conflict_data,
+                               const char *victim_basename,
+                               const svn_wc_conflict_description2_t *conflict,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  apr_size_t len = strlen(victim_basename);
+  svn_skel_t *skel;
+  svn_skel_t **c_skel_p;
+
+  SVN_ERR(parse_tree_conflicts_skel(&skel, conflict_data, scratch_pool));
+
+  /* Unlink the victim's old description, if any, from the list.  All
+     other descriptions get written back exactly as they were read. */
+  for (c_skel_p = &skel->children; *c_skel_p; c_skel_p = &(*c_skel_p)->next)
+    {
+      if (!is_valid_conflict_skel(*c_skel_p))
+        return svn_error_create(SVN_ERR_WC_CORRUPT, NULL,
+                                _("Invalid conflict info in tree conflict "
+                                  "description"));
+
+      if (is_conflict_on(*c_skel_p, victim_basename, len))
+        {
+          *c_skel_p = (*c_skel_p)->next;
+          break;
+        }
+    }
+
+  if (conflict)
+    {
+      svn_skel_t *c_skel;
+
+      SVN_ERR(svn_wc__serialize_conflict(&c_skel, conflict,
+                                         scratch_pool, scratch_pool));
+      svn_skel__prepend(c_skel, skel);
+    }
+
+  *new_conflict_data = svn_skel__unparse(skel, result_pool)->data;
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_wc__del_tree_conflict(svn_wc_context_t *wc_ctx,
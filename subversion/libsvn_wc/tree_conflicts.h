@@ -106,6 +106,38 @@ svn_wc__read_tree_conflicts(apr_hash_t **conflicts,
                             const char *dir_path,
                             apr_pool_t *pool);
 
+/*
+ * Set *CONFLICT to the tree conflict on LOCAL_ABSPATH described in
+ * CONFLICT_DATA, the tree conflict data of LOCAL_ABSPATH's parent
+ * directory, or to NULL if there is none.  Unlike
+ * svn_wc__read_tree_conflicts(), this converts only the one description
+ * that is asked for.  Allocate *CONFLICT in RESULT_POOL and use
+ * SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__read_tree_conflict(const svn_wc_conflict_description2_t **conflict,
+                           const char *conflict_data,
+                           const char *local_abspath,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/*
+ * Set *NEW_CONFLICT_DATA to a copy of the tree conflict data
+ * CONFLICT_DATA (which may be NULL) in which the description for the
+ * victim VICTIM_BASENAME has been replaced by CONFLICT, or removed if
+ * CONFLICT is NULL.  The other descriptions are copied without being
+ * converted from and back to svn_wc_conflict_description2_t.  Allocate
+ * the result in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_wc__set_tree_conflict_data(const char **new_conflict_data,
+                               const char *conflict_data,
+                               const char *victim_basename,
+                               const svn_wc_conflict_description2_t *conflict,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
 /* Token mapping tables.  */
 extern const svn_token_map_t svn_wc__operation_map[];
 extern const svn_token_map_t svn_wc__conflict_action_map[];
@@ -59,6 +59,7 @@
 #include "workqueue.h"
 
 #include "private/svn_wc_private.h"
+#include "private/svn_pipeline.h"
 
 /* Checks whether a svn_wc__db_status_t indicates whether a node is
    present in a working copy. Used by the editor implementation */
@@ -243,6 +244,10 @@ struct edit_baton
   svn_wc_get_file_t fetch_func;
   void *fetch_baton;
 
+  /* Set if the driver sends no file texts, and files are added without
+     them; see svn_wc__get_lazy_update_editor().  */
+  svn_boolean_t lazy;
+
   /* Subtrees that were skipped during the edit, and therefore shouldn't
      have their revision/url info updated at the end.  If a path is a
      directory, its descendants will also be skipped.  The keys are absolute
@@ -335,6 +340,17 @@ struct dir_baton
      we only receive the changes in/for children and properties.*/
   svn_boolean_t was_incomplete;
 
+  /* The basenames of the files in this directory that were added without
+     their texts, and of those that got their texts, during this edit.
+     Both are keys of hashes allocated in POOL. */
+  apr_hash_t *dehydrated;
+  apr_hash_t *hydrated;
+
+  /* The basenames listed as dehydrated in this directory's
+     administrative area when the edit started, allocated in POOL, or NULL
+     until the first file in it gets opened.  */
+  apr_hash_t *listed_dehydrated;
+
   /* The pool in which this baton itself is allocated. */
   apr_pool_t *pool;
 };
@@ -395,19 +411,176 @@ struct handler_baton
   /* The stream used to calculate the source checksums */
   svn_stream_t *source_checksum_stream;
 
-  /* A calculated MD5 digest of NEW_TEXT_BASE_TMP_ABSPATH.
-     This is initialized to all zeroes when the baton is created, then
-     populated with the MD5 digest of the resultant fulltext after the
-     last window is handled by the handler returned from
-     apply_textdelta(). */
-  unsigned char new_text_base_md5_digest[APR_MD5_DIGESTSIZE];
-
-  /* A calculated SHA-1 of NEW_TEXT_BASE_TMP_ABSPATH, which we'll use for
-     eventually writing the pristine. */
-  svn_checksum_t * new_text_base_sha1_checksum;
+  /* The calculated MD5 and SHA-1 checksums of NEW_TEXT_BASE_TMP_ABSPATH.
+     These are NULL until the last window has been handled by the handler
+     returned from apply_textdelta().  We'll use the SHA-1 for eventually
+     writing the pristine. */
+  svn_checksum_t *new_text_base_md5_checksum;
+  svn_checksum_t *new_text_base_sha1_checksum;
 };
 
 
+/* The amount of text written by the thread applying the delta before a
+   writer thread takes over, and the number of writes that may be queued
+   for that thread.  Smaller texts never start a thread. */
+#define WRITE_BEHIND_THRESHOLD (1024 * 1024)
+#define WRITE_BEHIND_DEPTH 16
+
+/* Baton for a stream writing a new text base and calculating its MD5 and
+   SHA-1 checksums.  When the text gets large and threads are available,
+   the writing and checksumming move to a separate thread, so that they
+   overlap with decoding and applying the delta. */
+typedef struct text_base_writer_t
+{
+  /* The file being written and its path.  While PIPELINE exists, these
+     and the checksum context are used by its worker thread only. */
+  apr_file_t *file;
+  const char *path;
+  svn_checksum_ctx_t *checksum_ctx;  /* Computes both MD5 and SHA-1. */
+
+  /* The number of bytes written on the thread applying the delta. */
+  apr_size_t written;
+
+  /* Where to put the checksums when closing the stream, and the pool to
+     allocate them in. */
+  svn_checksum_t **md5_checksum;
+  svn_checksum_t **sha1_checksum;
+  apr_pool_t *pool;
+
+  /* If not NULL, the writes are queued on this pipeline as svn_string_t
+     and done on its worker thread. */
+  svn_pipeline__t *pipeline;
+} text_base_writer_t;
+
+/* Write LEN bytes of DATA to the file of B and add them to its checksums.
+   This doesn't allocate, so it may be called from the writer thread. */
+static apr_status_t
+write_and_checksum(text_base_writer_t *b, const char *data, apr_size_t len)
+{
+  apr_status_t status = apr_file_write_full(b->file, data, len, NULL);
+
+  if (status)
+    return status;
+
+  /* A context for both checksums can't fail. */
+  svn_error_clear(svn_checksum_update(b->checksum_ctx, data, len));
+  return APR_SUCCESS;
+}
+
+/* Implements svn_pipeline__process_t, writing out the svn_string_t ITEM
+   for BATON, a text_base_writer_t. */
+static svn_error_t *
+write_queued(void *baton,
+             void *item,
+             apr_pool_t *scratch_pool)
+{
+  text_base_writer_t *b = baton;
+  const svn_string_t *chunk = item;
+  apr_status_t status = write_and_checksum(b, chunk->data, chunk->len);
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't write to file '%s'"),
+                              svn_dirent_local_style(b->path,
+                                                     scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t for a text_base_writer_t. */
+static svn_error_t *
+text_base_writer_write(void *baton, const char *data, apr_size_t *len)
+{
+  text_base_writer_t *b = baton;
+  apr_status_t status;
+
+  /* Try to start the writer thread once, when the text gets large.  If
+     that fails, just continue to write on this thread. */
+  if (! b->pipeline && b->written <= WRITE_BEHIND_THRESHOLD
+      && b->written + *len > WRITE_BEHIND_THRESHOLD)
+    b->pipeline = svn_pipeline__start(WRITE_BEHIND_DEPTH, 0, write_queued,
+                                      b, b->pool);
+
+  if (b->pipeline)
+    {
+      apr_pool_t *slot_pool;
+
+      SVN_ERR(svn_pipeline__next_slot(&slot_pool, b->pipeline));
+      svn_pipeline__queue(b->pipeline,
+                          svn_string_ncreate(data, *len, slot_pool));
+      return SVN_NO_ERROR;
+    }
+
+  status = write_and_checksum(b, data, *len);
+  b->written += *len;
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't write to file '%s'"),
+                              svn_dirent_local_style(b->path, b->pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t for a text_base_writer_t. */
+static svn_error_t *
+text_base_writer_close(void *baton)
+{
+  text_base_writer_t *b = baton;
+
+  if (b->pipeline)
+    {
+      svn_error_t *err = svn_pipeline__finish(b->pipeline);
+
+      svn_pipeline__close(b->pipeline);
+      b->pipeline = NULL;
+      if (err)
+        {
+          svn_error_clear(svn_io_file_close(b->file, b->pool));
+          return svn_error_return(err);
+        }
+    }
+
+  SVN_ERR(svn_io_file_close(b->file, b->pool));
+
+  return svn_checksum__final_md5_sha1(b->md5_checksum, b->sha1_checksum,
+                                      b->checksum_ctx, b->pool);
+}
+
+/* Like svn_wc__open_writable_base(), but always calculating both
+   checksums, and doing the work on a separate thread for large texts.
+   The checksums are set when the stream is closed. */
+static svn_error_t *
+open_text_base_writer(svn_stream_t **stream,
+                      const char **temp_base_abspath,
+                      svn_checksum_t **md5_checksum,
+                      svn_checksum_t **sha1_checksum,
+                      svn_wc__db_t *db,
+                      const char *local_abspath,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  text_base_writer_t *b = apr_pcalloc(result_pool, sizeof(*b));
+  const char *temp_dir_abspath;
+
+  SVN_ERR(svn_wc__db_pristine_get_tempdir(&temp_dir_abspath, db, local_abspath,
+                                          scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_open_unique_file3(&b->file, temp_base_abspath,
+                                   temp_dir_abspath, svn_io_file_del_none,
+                                   result_pool, scratch_pool));
+
+  b->path = *temp_base_abspath;
+  b->checksum_ctx = svn_checksum__ctx_create_md5_sha1(result_pool);
+  b->md5_checksum = md5_checksum;
+  b->sha1_checksum = sha1_checksum;
+  b->pool = result_pool;
+
+  *stream = svn_stream_create(b, result_pool);
+  svn_stream_set_write(*stream, text_base_writer_write);
+  svn_stream_set_close(*stream, text_base_writer_close);
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Get an empty file in the temporary area for WRI_ABSPATH.  The file will
    not be set for automatic deletion, and the name will be returned in
    TMP_FILENAME.
@@ -662,6 +835,8 @@ make_dir_baton(struct dir_baton **d_p,
   d->bump_info    = bdi;
   d->old_revision = SVN_INVALID_REVNUM;
   d->adding_dir   = adding;
+  d->dehydrated   = apr_hash_make(dir_pool);
+  d->hydrated     = apr_hash_make(dir_pool);
 
   /* The caller of this function needs to fill these in. */
   d->ambient_depth = svn_depth_unknown;
@@ -1032,6 +1207,14 @@ struct file_baton
   /* Set if we've received an apply_textdelta for this file. */
   svn_boolean_t received_textdelta;
 
+  /* Set if this file has no text in the working copy, because it was
+     checked out without it (see svn_wc__get_lazy_update_editor()). */
+  svn_boolean_t dehydrated;
+
+  /* Set if the text of this dehydrated file changed in a lazy edit,
+     which doesn't send it. */
+  svn_boolean_t dehydrated_text_changed;
+
   /* An array of svn_prop_t structures, representing all the property
      changes to be applied to this file.  Once a file baton is
      initialized, this is never NULL, but it may have zero elements.  */
@@ -1148,8 +1331,7 @@ window_handler(svn_txdelta_window_t *window, void *baton)
 
       /* ... and its checksums. */
       fb->new_text_base_md5_checksum =
-        svn_checksum__from_digest(hb->new_text_base_md5_digest,
-                                  svn_checksum_md5, fb->pool);
+        svn_checksum_dup(hb->new_text_base_md5_checksum, fb->pool);
       fb->new_text_base_sha1_checksum =
         svn_checksum_dup(hb->new_text_base_sha1_checksum, fb->pool);
     }
@@ -2900,6 +3082,87 @@ build_write_actual_props(svn_skel_t **work_item,
 }
 
 
+/* Baton for close_directory_txn(). */
+struct close_directory_baton
+{
+  struct dir_baton *db;
+
+  /* The BASE node's new properties, changed_* values and depth. */
+  apr_hash_t *props;
+  svn_revnum_t changed_rev;
+  apr_time_t changed_date;
+  const char *changed_author;
+  svn_depth_t depth;
+
+  /* The work items to install along with the BASE node. */
+  svn_skel_t *work_items;
+
+  /* The result of the property merge, or NULL if there was none. */
+  apr_hash_t *new_base_props;
+  apr_hash_t *new_actual_props;
+};
+
+/* Write the new BASE and ACTUAL metadata of the directory described by
+   the struct close_directory_baton BATON, and queue its work items.
+   close_directory() runs this in a single transaction.  This implements
+   svn_wc__db_txn_callback_t. */
+static svn_error_t *
+close_directory_txn(void *baton,
+                    apr_pool_t *scratch_pool)
+{
+  struct close_directory_baton *cdb = baton;
+  struct dir_baton *db = cdb->db;
+  struct edit_baton *eb = db->edit_baton;
+  svn_skel_t *work_items;
+
+  SVN_ERR(svn_wc__db_base_add_directory(
+            eb->db, db->local_abspath,
+            db->new_relpath,
+            eb->repos_root, eb->repos_uuid,
+            *eb->target_revision,
+            cdb->props,
+            cdb->changed_rev, cdb->changed_date, cdb->changed_author,
+            NULL /* children */,
+            cdb->depth,
+            NULL /* conflict */,
+            cdb->work_items,
+            scratch_pool));
+
+  /* If we updated the BASE properties, then we also have ACTUAL
+     properties to update. Do that now, along with queueing a work
+     item to write out an old-style props file.  */
+  if (cdb->new_base_props != NULL)
+    {
+      apr_hash_t *props;
+      apr_array_header_t *prop_diffs;
+
+      SVN_ERR_ASSERT(cdb->new_actual_props != NULL);
+
+      /* If the ACTUAL props are the same as the BASE props, then we
+         should "write" a NULL. This will remove the props from the
+         ACTUAL_NODE row, and remove the old-style props file, indicating
+         "no change".  */
+      props = cdb->new_actual_props;
+      SVN_ERR(svn_prop_diffs(&prop_diffs, cdb->new_actual_props,
+                             cdb->new_base_props, scratch_pool));
+      if (prop_diffs->nelts == 0)
+        props = NULL;
+
+      SVN_ERR(build_write_actual_props(&work_items, db->local_abspath,
+                                       svn_wc__db_kind_dir,
+                                       props,
+                                       scratch_pool));
+      SVN_ERR(svn_wc__db_op_set_props(eb->db, db->local_abspath,
+                                      props,
+                                      NULL /* conflict */,
+                                      work_items,
+                                      scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 /* An svn_delta_editor_t function. */
 static svn_error_t *
 close_directory(void *dir_baton,
@@ -3086,6 +3349,7 @@ close_directory(void *dir_baton,
       const char *changed_author;
       apr_hash_t *props;
       svn_skel_t *work_items;
+      struct close_directory_baton cdb;
 
       /* ### we know a base node already exists. it was created in
          ### open_directory or add_directory.  let's just preserve the
@@ -3124,53 +3388,20 @@ close_directory(void *dir_baton,
                                          pool));
         }
 
-      /* ### NOTE: from this point onwards, we make TWO changes to the
-         ### database in a non-transactional way. some kind of revamp
-         ### needs to happend to bring this down to a single DB transaction
-         ### to perform the changes and install all the needed work items.  */
-
-      SVN_ERR(svn_wc__db_base_add_directory(
-                eb->db, db->local_abspath,
-                db->new_relpath,
-                eb->repos_root, eb->repos_uuid,
-                *eb->target_revision,
-                props,
-                changed_rev, changed_date, changed_author,
-                NULL /* children */,
-                depth,
-                NULL /* conflict */,
-                work_items,
-                pool));
-
-      /* If we updated the BASE properties, then we also have ACTUAL
-         properties to update. Do that now, along with queueing a work
-         item to write out an old-style props file.  */
-      if (new_base_props != NULL)
-        {
-          apr_array_header_t *prop_diffs;
-
-          SVN_ERR_ASSERT(new_actual_props != NULL);
-
-          /* If the ACTUAL props are the same as the BASE props, then we
-             should "write" a NULL. This will remove the props from the
-             ACTUAL_NODE row, and remove the old-style props file, indicating
-             "no change".  */
-          props = new_actual_props;
-          SVN_ERR(svn_prop_diffs(&prop_diffs, new_actual_props, new_base_props,
-                                 pool));
-          if (prop_diffs->nelts == 0)
-            props = NULL;
-
-          SVN_ERR(build_write_actual_props(&work_items, db->local_abspath,
-                                           svn_wc__db_kind_dir,
-                                           props,
-                                           pool));
-          SVN_ERR(svn_wc__db_op_set_props(eb->db, db->local_abspath,
-                                          props,
-                                          NULL /* conflict */,
-                                          work_items,
-                                          pool));
-        }
+      /* Record the new metadata, and queue the work items, in a single
+         transaction.  */
+      cdb.db = db;
+      cdb.props = props;
+      cdb.changed_rev = changed_rev;
+      cdb.changed_date = changed_date;
+      cdb.changed_author = changed_author;
+      cdb.depth = depth;
+      cdb.work_items = work_items;
+      cdb.new_base_props = new_base_props;
+      cdb.new_actual_props = new_actual_props;
+
+      SVN_ERR(svn_wc__db_with_transaction(eb->db, db->local_abspath,
+                                          close_directory_txn, &cdb, pool));
     }
 
   /* Process all of the queued work items for this directory.  */
@@ -3178,6 +3409,10 @@ close_directory(void *dir_baton,
                          eb->cancel_func, eb->cancel_baton,
                          pool));
 
+  if (apr_hash_count(db->dehydrated) || apr_hash_count(db->hydrated))
+    SVN_ERR(svn_wc__set_dehydrated(db->local_abspath, db->dehydrated,
+                                   db->hydrated, pool));
+
   /* We're done with this directory, so remove one reference from the
      bump information. This may trigger a number of actions. See
      maybe_bump_dir_info() for more information.  */
@@ -3965,6 +4200,15 @@ open_file(const char *path,
                                NULL, NULL, NULL, NULL, NULL,
                                eb->db, fb->local_abspath, subpool, subpool));
 
+  /* Read the directory's list of dehydrated files once, rather than for
+     every file opened in it. */
+  if (! pb->listed_dehydrated)
+    SVN_ERR(svn_wc__read_dehydrated(&pb->listed_dehydrated, pb->local_abspath,
+                                    pb->pool, subpool));
+  SVN_ERR(svn_wc__internal_is_dehydrated(&fb->dehydrated, eb->db,
+                                         fb->local_abspath,
+                                         pb->listed_dehydrated, subpool));
+
   /* Is this path a conflict victim? */
   SVN_ERR(node_already_conflicted(&already_conflicted, eb->db,
                                   fb->local_abspath, pool));
@@ -4023,6 +4267,48 @@ open_file(const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Set *CONTENTS to the BASE text of the dehydrated file FB, fetched from
+   the repository into a temporary file that is removed when RESULT_POOL
+   is cleared.  */
+static svn_error_t *
+fetch_dehydrated_base(svn_stream_t **contents,
+                      struct file_baton *fb,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  struct edit_baton *eb = fb->edit_baton;
+  const char *repos_relpath;
+  const char *temp_dir_abspath;
+  const char *tmp_abspath;
+  svn_stream_t *tmp_contents;
+
+  if (! eb->fetch_func)
+    return svn_error_createf(SVN_ERR_WC_PATH_UNEXPECTED_STATUS, NULL,
+                             _("Can't update '%s' before fetching its "
+                               "text"),
+                             svn_dirent_local_style(fb->local_abspath,
+                                                    scratch_pool));
+
+  SVN_ERR(svn_wc__db_scan_base_repos(&repos_relpath, NULL, NULL,
+                                     eb->db, fb->local_abspath,
+                                     scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath, eb->db,
+                                         fb->local_abspath,
+                                         scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_open_unique(&tmp_contents, &tmp_abspath,
+                                 temp_dir_abspath,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 result_pool, scratch_pool));
+  SVN_ERR(eb->fetch_func(eb->fetch_baton, repos_relpath, fb->old_revision,
+                         tmp_contents, NULL, NULL, scratch_pool));
+  SVN_ERR(svn_stream_close(tmp_contents));
+
+  return svn_error_return(svn_stream_open_readonly(contents, tmp_abspath,
+                                                   result_pool,
+                                                   scratch_pool));
+}
+
+
 /* An svn_delta_editor_t function. */
 static svn_error_t *
 apply_textdelta(void *file_baton,
@@ -4046,6 +4332,27 @@ apply_textdelta(void *file_baton,
       return SVN_NO_ERROR;
     }
 
+  if (fb->edit_baton->lazy)
+    {
+      /* The driver doesn't send the text.  New files are recorded
+         without one, as are files that never had one; close_file() gets
+         the checksum of the new text. */
+      if (! (fb->adding_file && ! fb->obstruction_found
+             && ! fb->add_existed)
+          && ! fb->dehydrated)
+        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 _("Can't update the text of '%s' without "
+                                   "fetching it"),
+                                 svn_dirent_local_style(fb->local_abspath,
+                                                        pool));
+
+      fb->dehydrated = TRUE;
+      fb->dehydrated_text_changed = TRUE;
+      *handler = svn_delta_noop_window_handler;
+      *handler_baton = NULL;
+      return SVN_NO_ERROR;
+    }
+
   fb->received_textdelta = TRUE;
 
   /* Before applying incoming svndiff data to text base, make sure
@@ -4092,9 +4399,14 @@ apply_textdelta(void *file_baton,
 
   if (! fb->adding_file)
     {
-      SVN_ERR(svn_wc__get_ultimate_base_contents(&source, fb->edit_baton->db,
-                                                 fb->local_abspath,
-                                                 handler_pool, handler_pool));
+      if (fb->dehydrated)
+        SVN_ERR(fetch_dehydrated_base(&source, fb, handler_pool, pool));
+      else
+        SVN_ERR(svn_wc__get_ultimate_base_contents(&source,
+                                                   fb->edit_baton->db,
+                                                   fb->local_abspath,
+                                                   handler_pool,
+                                                   handler_pool));
       if (source == NULL)
         source = svn_stream_empty(handler_pool);
     }
@@ -4126,11 +4438,14 @@ apply_textdelta(void *file_baton,
       hb->source_checksum_stream = source;
     }
 
-  /* Open the text base for writing (this will get us a temporary file).  */
-  err = svn_wc__open_writable_base(&target, &hb->new_text_base_tmp_abspath,
-                                   NULL, &hb->new_text_base_sha1_checksum,
-                                   fb->edit_baton->db, fb->local_abspath,
-                                   handler_pool, pool);
+  /* Open the text base for writing (this will get us a temporary file).
+     The stream calculates both checksums, so svn_txdelta_apply() doesn't
+     need to.  */
+  err = open_text_base_writer(&target, &hb->new_text_base_tmp_abspath,
+                              &hb->new_text_base_md5_checksum,
+                              &hb->new_text_base_sha1_checksum,
+                              fb->edit_baton->db, fb->local_abspath,
+                              handler_pool, pool);
   if (err)
     {
       svn_pool_destroy(handler_pool);
@@ -4139,7 +4454,7 @@ apply_textdelta(void *file_baton,
 
   /* Prepare to apply the delta.  */
   svn_txdelta_apply(source, target,
-                    hb->new_text_base_md5_digest,
+                    NULL,
                     hb->new_text_base_tmp_abspath /* error_info */,
                     handler_pool,
                     &hb->apply_handler, &hb->apply_baton);
@@ -4619,6 +4934,163 @@ merge_file(svn_skel_t **work_items,
 }
 
 
+/* Baton for close_file_txn(). */
+struct close_file_baton
+{
+  struct file_baton *fb;
+
+  /* The kind of the node on disk before the update, as found by
+     close_file(). */
+  svn_node_kind_t kind;
+
+  /* The new BASE node's checksum, or NULL to keep the old one. */
+  const svn_checksum_t *new_checksum;
+
+  apr_hash_t *new_base_props;
+  apr_hash_t *new_actual_props;
+  svn_revnum_t new_changed_rev;
+  apr_time_t new_changed_date;
+  const char *new_changed_author;
+
+  /* The work items to install along with the BASE node. */
+  svn_skel_t *work_items;
+};
+
+/* Write the new BASE, WORKING and ACTUAL metadata of the file described
+   by the struct close_file_baton BATON, and queue its work items.
+   close_file() runs this in a single transaction, so that the changes are
+   committed at once instead of one at a time.  This implements
+   svn_wc__db_txn_callback_t. */
+static svn_error_t *
+close_file_txn(void *baton,
+               apr_pool_t *scratch_pool)
+{
+  struct close_file_baton *cfb = baton;
+  struct file_baton *fb = cfb->fb;
+  struct edit_baton *eb = fb->edit_baton;
+  svn_skel_t *work_item;
+
+  /* Insert/replace the BASE node with all of the new metadata.  */
+  {
+    const svn_checksum_t *new_checksum = cfb->new_checksum;
+    const char *serialised;
+
+    /* If we don't have a NEW checksum, then the base must not have changed.
+       Just carry over the old checksum.  */
+    if (new_checksum == NULL)
+      {
+        SVN_ERR(svn_wc__db_base_get_info(NULL, NULL, NULL,
+                                         NULL, NULL, NULL,
+                                         NULL, NULL, NULL,
+                                         NULL, NULL,
+                                         &new_checksum, NULL, NULL, NULL,
+                                         eb->db, fb->local_abspath,
+                                         scratch_pool, scratch_pool));
+        /* SVN_EXPERIMENTAL_PRISTINE:
+           new_checksum is originally MD-5 but will later be SHA-1.  That's
+           OK here because we just read it and write it back. */
+      }
+
+    if (cfb->kind != svn_node_none)
+      SVN_ERR(svn_wc__db_temp_get_file_external(&serialised,
+                                                eb->db, fb->local_abspath,
+                                                scratch_pool, scratch_pool));
+
+    SVN_ERR(svn_wc__db_base_add_file(eb->db, fb->local_abspath,
+                                     fb->new_relpath,
+                                     eb->repos_root, eb->repos_uuid,
+                                     *eb->target_revision,
+                                     cfb->new_base_props,
+                                     cfb->new_changed_rev,
+                                     cfb->new_changed_date,
+                                     cfb->new_changed_author,
+                                     new_checksum,
+                                     SVN_INVALID_FILESIZE,
+                                     NULL /* conflict */,
+                                     cfb->work_items,
+                                     scratch_pool));
+
+    /* ### ugh. deal with preserving the file external value in the database.
+       ### there is no official API, so we do it this way. maybe we should
+       ### have a temp API into wc_db.  */
+    if (cfb->kind != svn_node_none && serialised)
+      {
+        const char *file_external_repos_relpath;
+        svn_opt_revision_t file_external_peg_rev, file_external_rev;
+
+        SVN_ERR(svn_wc__unserialize_file_external(&file_external_repos_relpath,
+                                                  &file_external_peg_rev,
+                                                  &file_external_rev,
+                                                  serialised, scratch_pool));
+
+        SVN_ERR(svn_wc__db_temp_op_set_file_external(
+                                                  eb->db, fb->local_abspath,
+                                                  file_external_repos_relpath,
+                                                  &file_external_peg_rev,
+                                                  &file_external_rev,
+                                                  scratch_pool));
+      }
+  }
+
+  /* Deal with the WORKING tree, based on updates to the BASE tree.  */
+
+  /* An ancestor was locally-deleted. This file is being added within
+     that tree. We need to schedule this file for deletion.  */
+  if (fb->dir_baton->in_deleted_and_tree_conflicted_subtree && fb->adding_file)
+    {
+      /* ### temporary hack. we should simply write a WORKING_NODE.  */
+
+      svn_wc_entry_t tmp_entry;
+
+      tmp_entry.schedule = svn_wc_schedule_delete;
+      SVN_ERR(svn_wc__entry_modify(eb->db, fb->local_abspath,
+                                   svn_node_file,
+                                   &tmp_entry, SVN_WC__ENTRY_MODIFY_SCHEDULE,
+                                   scratch_pool));
+    }
+
+  /* If this file was locally-added and is now being added by the update, we
+     can toss the local-add, turning this into a local-edit.  */
+  if (fb->add_existed && fb->adding_file)
+    {
+      SVN_ERR(svn_wc__db_temp_op_remove_working(eb->db, fb->local_abspath,
+                                                scratch_pool));
+    }
+
+  /* Now we need to update the ACTUAL tree, with the result of the
+     properties merge. */
+  {
+    apr_hash_t *props;
+    apr_array_header_t *prop_diffs;
+
+    SVN_ERR_ASSERT(cfb->new_actual_props != NULL);
+
+    /* If the ACTUAL props are the same as the BASE props, then we
+       should "write" a NULL. This will remove the props from the
+       ACTUAL_NODE row, and remove the old-style props file, indicating
+       "no change".  */
+    props = cfb->new_actual_props;
+    SVN_ERR(svn_prop_diffs(&prop_diffs, cfb->new_actual_props,
+                           cfb->new_base_props, scratch_pool));
+    if (prop_diffs->nelts == 0)
+      props = NULL;
+
+    SVN_ERR(build_write_actual_props(&work_item, fb->local_abspath,
+                                     svn_wc__db_kind_file,
+                                     props,
+                                     scratch_pool));
+    SVN_ERR(svn_wc__db_op_set_props(eb->db, fb->local_abspath,
+                                    props,
+                                    NULL /* conflict */,
+                                    work_item,
+                                    scratch_pool));
+  }
+
+
+  return SVN_NO_ERROR;
+}
+
+
 /* An svn_delta_editor_t function. */
 /* Mostly a wrapper around merge_file. */
 static svn_error_t *
@@ -4684,6 +5156,19 @@ close_file(void *file_baton,
                      new_text_base_sha1_checksum &&
                      new_text_base_abspath);
     }
+  else if (fb->dehydrated_text_changed)
+    {
+      /* A lazy edit only tells us the checksum of the new text, which
+         is all we record. */
+      if (! expected_md5_checksum)
+        return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                 _("No checksum was sent for '%s'"),
+                                 svn_dirent_local_style(fb->local_abspath,
+                                                        pool));
+      new_text_base_md5_checksum = expected_md5_checksum;
+      new_text_base_sha1_checksum = NULL;
+      new_text_base_abspath = NULL;
+    }
   else
     {
       SVN_ERR_ASSERT(! fb->new_text_base_tmp_abspath
@@ -4867,8 +5352,19 @@ close_file(void *file_baton,
                                         pool));
 
   /* Do the hard work. This will queue some additional work.  */
-  SVN_ERR(merge_file(&work_item, &install_pristine, &install_from,
-                     &content_state, fb, new_text_base_abspath, pool));
+  if (fb->dehydrated && ! fb->received_textdelta)
+    {
+      /* There is no text to merge into, nor any to install. */
+      work_item = NULL;
+      install_pristine = FALSE;
+      install_from = NULL;
+      content_state = fb->dehydrated_text_changed
+                        ? svn_wc_notify_state_changed
+                        : svn_wc_notify_state_unchanged;
+    }
+  else
+    SVN_ERR(merge_file(&work_item, &install_pristine, &install_from,
+                       &content_state, fb, new_text_base_abspath, pool));
   all_work_items = svn_wc__wq_merge(all_work_items, work_item, pool);
 
   if (install_pristine)
@@ -4896,7 +5392,8 @@ close_file(void *file_baton,
      status of the working file? The LOCK_STATE will signal what we should
      do for this node.  */
   if (new_text_base_abspath == NULL
-      && lock_state == svn_wc_notify_lock_state_unlocked)
+      && lock_state == svn_wc_notify_lock_state_unlocked
+      && ! fb->dehydrated)
     {
       /* If a lock was removed and we didn't update the text contents, we
          might need to set the file read-only.
@@ -4928,133 +5425,30 @@ close_file(void *file_baton,
       all_work_items = svn_wc__wq_merge(all_work_items, work_item, pool);
     }
 
-  /* ### NOTE: from this point onwards, we make several changes to the
-     ### database in a non-transactional way. we also queue additional
-     ### work after these changes. some revamps need to be performed to
-     ### bring this down to a single DB transaction to perform all the
-     ### changes and to install all the needed work items.  */
-
-  /* Insert/replace the BASE node with all of the new metadata.  */
+  /* Record the new metadata, and queue the work items, in a single
+     transaction.  */
   {
+    struct close_file_baton cfb;
+
+    cfb.fb = fb;
+    cfb.kind = kind;
 #ifdef SVN_EXPERIMENTAL_PRISTINE
-      /* Set the 'checksum' column of the file's BASE_NODE row to
-       * NEW_TEXT_BASE_SHA1_CHECKSUM.  The pristine text identified by that
-       * checksum is already in the pristine store. */
-    const svn_checksum_t *new_checksum = new_text_base_sha1_checksum;
+    /* Set the 'checksum' column of the file's BASE_NODE row to
+     * NEW_TEXT_BASE_SHA1_CHECKSUM.  The pristine text identified by that
+     * checksum is already in the pristine store. */
+    cfb.new_checksum = new_text_base_sha1_checksum;
 #else
-    const svn_checksum_t *new_checksum = new_text_base_md5_checksum;
+    cfb.new_checksum = new_text_base_md5_checksum;
 #endif
-    const char *serialised;
-
-    /* If we don't have a NEW checksum, then the base must not have changed.
-       Just carry over the old checksum.  */
-    if (new_checksum == NULL)
-      {
-        SVN_ERR(svn_wc__db_base_get_info(NULL, NULL, NULL,
-                                         NULL, NULL, NULL,
-                                         NULL, NULL, NULL,
-                                         NULL, NULL,
-                                         &new_checksum, NULL, NULL, NULL,
-                                         eb->db, fb->local_abspath,
-                                         pool, pool));
-        /* SVN_EXPERIMENTAL_PRISTINE:
-           new_checksum is originally MD-5 but will later be SHA-1.  That's
-           OK here because we just read it and write it back. */
-      }
-
-    if (kind != svn_node_none)
-      SVN_ERR(svn_wc__db_temp_get_file_external(&serialised,
-                                                eb->db, fb->local_abspath,
-                                                pool, pool));
-
-    SVN_ERR(svn_wc__db_base_add_file(eb->db, fb->local_abspath,
-                                     fb->new_relpath,
-                                     eb->repos_root, eb->repos_uuid,
-                                     *eb->target_revision,
-                                     new_base_props,
-                                     new_changed_rev,
-                                     new_changed_date,
-                                     new_changed_author,
-                                     new_checksum,
-                                     SVN_INVALID_FILESIZE,
-                                     NULL /* conflict */,
-                                     all_work_items,
-                                     pool));
-
-    /* ### ugh. deal with preserving the file external value in the database.
-       ### there is no official API, so we do it this way. maybe we should
-       ### have a temp API into wc_db.  */
-    if (kind != svn_node_none && serialised)
-      {
-        const char *file_external_repos_relpath;
-        svn_opt_revision_t file_external_peg_rev, file_external_rev;
-
-        SVN_ERR(svn_wc__unserialize_file_external(&file_external_repos_relpath,
-                                                  &file_external_peg_rev,
-                                                  &file_external_rev,
-                                                  serialised, pool));
-
-        SVN_ERR(svn_wc__db_temp_op_set_file_external(
-                                                  eb->db, fb->local_abspath,
-                                                  file_external_repos_relpath,
-                                                  &file_external_peg_rev,
-                                                  &file_external_rev,
-                                                  pool));
-      }
-  }
-
-  /* Deal with the WORKING tree, based on updates to the BASE tree.  */
-
-  /* An ancestor was locally-deleted. This file is being added within
-     that tree. We need to schedule this file for deletion.  */
-  if (fb->dir_baton->in_deleted_and_tree_conflicted_subtree && fb->adding_file)
-    {
-      /* ### temporary hack. we should simply write a WORKING_NODE.  */
-
-      svn_wc_entry_t tmp_entry;
-
-      tmp_entry.schedule = svn_wc_schedule_delete;
-      SVN_ERR(svn_wc__entry_modify(eb->db, fb->local_abspath,
-                                   svn_node_file,
-                                   &tmp_entry, SVN_WC__ENTRY_MODIFY_SCHEDULE,
-                                   pool));
-    }
-
-  /* If this file was locally-added and is now being added by the update, we
-     can toss the local-add, turning this into a local-edit.  */
-  if (fb->add_existed && fb->adding_file)
-    {
-      SVN_ERR(svn_wc__db_temp_op_remove_working(eb->db, fb->local_abspath,
-                                                pool));
-    }
-
-  /* Now we need to update the ACTUAL tree, with the result of the
-     properties merge. */
-  {
-    apr_hash_t *props;
-    apr_array_header_t *prop_diffs;
-
-    SVN_ERR_ASSERT(new_actual_props != NULL);
-
-    /* If the ACTUAL props are the same as the BASE props, then we
-       should "write" a NULL. This will remove the props from the
-       ACTUAL_NODE row, and remove the old-style props file, indicating
-       "no change".  */
-    props = new_actual_props;
-    SVN_ERR(svn_prop_diffs(&prop_diffs, new_actual_props, new_base_props,
-                           pool));
-    if (prop_diffs->nelts == 0)
-      props = NULL;
-
-    SVN_ERR(build_write_actual_props(&work_item, fb->local_abspath,
-                                     svn_wc__db_kind_file,
-                                     props,
-                                     pool));
-    SVN_ERR(svn_wc__db_op_set_props(eb->db, fb->local_abspath,
-                                    props,
-                                    NULL /* conflict */,
-                                    work_item,
-                                    pool));
+    cfb.new_base_props = new_base_props;
+    cfb.new_actual_props = new_actual_props;
+    cfb.new_changed_rev = new_changed_rev;
+    cfb.new_changed_date = new_changed_date;
+    cfb.new_changed_author = new_changed_author;
+    cfb.work_items = all_work_items;
+
+    SVN_ERR(svn_wc__db_with_transaction(eb->db, fb->local_abspath,
+                                        close_file_txn, &cfb, pool));
   }
 
   /* ### we may as well run whatever is in the queue right now. this
@@ -5067,6 +5461,16 @@ close_file(void *file_baton,
                          eb->cancel_func, eb->cancel_baton,
                          pool));
 
+  /* close_directory() updates the list of dehydrated files. */
+  if (fb->dehydrated)
+    {
+      struct dir_baton *pb = fb->dir_baton;
+      const char *name = apr_pstrdup(pb->pool, fb->name);
+
+      apr_hash_set(fb->received_textdelta ? pb->hydrated : pb->dehydrated,
+                   name, APR_HASH_KEY_STRING, name);
+    }
+
   /* We have one less referrer to the directory's bump information. */
   SVN_ERR(maybe_bump_dir_info(eb, fb->bump_info, pool));
 
@@ -5210,6 +5614,7 @@ make_editor(svn_revnum_t *target_revision,
             void *external_baton,
             svn_wc_get_file_t fetch_func,
             void *fetch_baton,
+            svn_boolean_t lazy,
             const char *diff3_cmd,
             const apr_array_header_t *preserved_exts,
             const svn_delta_editor_t **editor,
@@ -5284,6 +5689,7 @@ make_editor(svn_revnum_t *target_revision,
   eb->conflict_baton           = conflict_baton;
   eb->fetch_func               = fetch_func;
   eb->fetch_baton              = fetch_baton;
+  eb->lazy                     = lazy;
   eb->allow_unver_obstructions = allow_unver_obstructions;
   eb->close_edit_complete      = FALSE;
   eb->skipped_trees            = apr_hash_make(edit_pool);
@@ -5373,11 +5779,57 @@ svn_wc_get_update_editor4(const svn_delta_editor_t **editor,
                      cancel_func, cancel_baton,
                      conflict_func, conflict_baton,
                      external_func, external_baton,
-                     fetch_func, fetch_baton,
+                     fetch_func, fetch_baton, FALSE,
                      diff3_cmd, preserved_exts, editor, edit_baton,
                      result_pool, scratch_pool);
 }
 
+svn_error_t *
+svn_wc__get_lazy_update_editor(const svn_delta_editor_t **editor,
+                               void **edit_baton,
+                               svn_revnum_t *target_revision,
+                               svn_wc_context_t *wc_ctx,
+                               const char *anchor_abspath,
+                               const char *target_basename,
+                               svn_boolean_t use_commit_times,
+                               svn_depth_t depth,
+                               svn_boolean_t depth_is_sticky,
+                               svn_boolean_t allow_unver_obstructions,
+                               const char *diff3_cmd,
+                               const apr_array_header_t *preserved_exts,
+                               svn_wc_get_file_t fetch_func,
+                               void *fetch_baton,
+                               svn_wc_conflict_resolver_func_t conflict_func,
+                               void *conflict_baton,
+                               svn_wc_external_update_t external_func,
+                               void *external_baton,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               svn_wc_notify_func2_t notify_func,
+                               void *notify_baton,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+#ifdef SVN_EXPERIMENTAL_PRISTINE
+  /* A dehydrated file is one without a text base; there is no way yet to
+     say that a pristine text is missing from the pristine store. */
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Can't check out files without their texts "
+                            "into a working copy with a pristine store"));
+#else
+  return make_editor(target_revision, wc_ctx, anchor_abspath,
+                     target_basename, use_commit_times,
+                     NULL, depth, depth_is_sticky, allow_unver_obstructions,
+                     notify_func, notify_baton,
+                     cancel_func, cancel_baton,
+                     conflict_func, conflict_baton,
+                     external_func, external_baton,
+                     fetch_func, fetch_baton, TRUE,
+                     diff3_cmd, preserved_exts, editor, edit_baton,
+                     result_pool, scratch_pool);
+#endif
+}
+
 svn_error_t *
 svn_wc_get_switch_editor4(const svn_delta_editor_t **editor,
                           void **edit_baton,
@@ -5415,7 +5867,7 @@ svn_wc_get_switch_editor4(const svn_delta_editor_t **editor,
                      cancel_func, cancel_baton,
                      conflict_func, conflict_baton,
                      external_func, external_baton,
-                     fetch_func, fetch_baton,
+                     fetch_func, fetch_baton, FALSE,
                      diff3_cmd, preserved_exts,
                      editor, edit_baton,
                      result_pool, scratch_pool);
@@ -5626,10 +6078,8 @@ svn_wc__check_wc_root(svn_boolean_t *wc_root,
 
     if (switched)
       {
-        const char *expected_relpath = svn_relpath_join(parent_repos_relpath,
-                                                        name, scratch_pool);
-
-        *switched = (strcmp(expected_relpath, repos_relpath) != 0);
+        *switched = ! svn_relpath__is_joined(repos_relpath,
+                                             parent_repos_relpath, name);
       }
     }
 
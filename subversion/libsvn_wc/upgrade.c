@@ -550,6 +550,45 @@ ensure_repos_info(svn_wc_entry_t *entry,
 }
 
 
+struct write_upgraded_dir_baton
+{
+  svn_wc__db_t *db;
+  apr_int64_t repos_id;
+  apr_int64_t wc_id;
+  const char *dir_abspath;
+
+  /* The old entries of DIR_ABSPATH.  */
+  apr_hash_t *entries;
+
+  /* The wcprops of DIR_ABSPATH and its files, or NULL if they are lost.  */
+  apr_hash_t *all_wcprops;
+};
+
+
+/* Write the entries and the wcprops described by the struct
+   write_upgraded_dir_baton BATON into SDB.  Implements
+   svn_sqlite__transaction_callback_t.  */
+static svn_error_t *
+write_upgraded_dir(void *baton,
+                   svn_sqlite__db_t *sdb,
+                   apr_pool_t *scratch_pool)
+{
+  struct write_upgraded_dir_baton *wtb = baton;
+
+  /* This nests the transaction of svn_wc__write_upgraded_entries()
+     inside of ours.  */
+  SVN_ERR(svn_wc__write_upgraded_entries(wtb->db, sdb, wtb->repos_id,
+                                         wtb->wc_id, wtb->dir_abspath,
+                                         wtb->entries, scratch_pool));
+
+  if (wtb->all_wcprops)
+    SVN_ERR(svn_wc__db_upgrade_apply_dav_cache(sdb, wtb->all_wcprops,
+                                               scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Upgrade the working copy directory represented by DB/DIR_ABSPATH
    from OLD_FORMAT to the wc-ng format (SVN_WC__WC_NG_VERSION)'.
 
@@ -570,6 +609,7 @@ upgrade_to_wcng(svn_wc__db_t *db,
   svn_sqlite__db_t *sdb;
   apr_int64_t repos_id;
   apr_int64_t wc_id;
+  struct write_upgraded_dir_baton wtb;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
 
   /* Don't try to mess with the WC if there are old log files left. */
@@ -625,27 +665,32 @@ upgrade_to_wcng(svn_wc__db_t *db,
   SVN_ERR(svn_wc__db_temp_reset_format(SVN_WC__VERSION, db, dir_abspath,
                                        iterpool));
   SVN_ERR(svn_wc__db_wclock_set(db, dir_abspath, 0, iterpool));
-  SVN_ERR(svn_wc__write_upgraded_entries(db, sdb, repos_id, wc_id,
-                                         dir_abspath, entries,
-                                         iterpool));
 
   /***** WC PROPS *****/
 
   /* Ugh. We don't know precisely where the wcprops are. Ignore them.  */
+  wtb.all_wcprops = NULL;
   if (old_format != SVN_WC__WCPROPS_LOST)
     {
-      apr_hash_t *all_wcprops;
-
       if (old_format <= SVN_WC__WCPROPS_MANY_FILES_VERSION)
-        SVN_ERR(read_many_wcprops(&all_wcprops, dir_abspath,
+        SVN_ERR(read_many_wcprops(&wtb.all_wcprops, dir_abspath,
                                   iterpool, iterpool));
       else
-        SVN_ERR(read_wcprops(&all_wcprops, dir_abspath,
+        SVN_ERR(read_wcprops(&wtb.all_wcprops, dir_abspath,
                              iterpool, iterpool));
-
-      SVN_ERR(svn_wc__db_upgrade_apply_dav_cache(sdb, all_wcprops, iterpool));
     }
 
+  /* Write the entries and the wcprops in a single transaction.  Outside
+     of one, every wcprops row would be committed (and synced) on its
+     own.  */
+  wtb.db = db;
+  wtb.repos_id = repos_id;
+  wtb.wc_id = wc_id;
+  wtb.dir_abspath = dir_abspath;
+  wtb.entries = entries;
+  SVN_ERR(svn_sqlite__with_transaction(sdb, write_upgraded_dir, &wtb,
+                                       iterpool));
+
   /* Upgrade all the properties (including "this dir").
 
      Note: this must come AFTER the entries have been migrated into the
@@ -1144,17 +1189,32 @@ bump_to_17(void *baton, svn_sqlite__db_t *sdb, apr_pool_t *scratch_pool)
 }
 
 
+/* The text bases to be moved into the pristine store once the
+   PRISTINE rows for them have been committed.  */
+struct bump_to_18_baton
+{
+  const char *wcroot_abspath;
+
+  /* Pairs of text base path and pristine path, as const char *.  */
+  apr_array_header_t *moves;
+  apr_pool_t *result_pool;
+};
+
+
 static svn_error_t *
-migrate_text_bases(const char *wcroot_abspath,
+migrate_text_bases(struct bump_to_18_baton *b18,
                    svn_sqlite__db_t *sdb,
                    apr_pool_t *scratch_pool)
 {
   apr_hash_t *dirents;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_hash_index_t *hi;
-  const char *text_base_dir = svn_wc__adm_child(wcroot_abspath,
+  const char *text_base_dir = svn_wc__adm_child(b18->wcroot_abspath,
                                                 TEXT_BASE_SUBDIR,
                                                 scratch_pool);
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PRISTINE));
 
   SVN_ERR(svn_io_get_dir_filenames(&dirents, text_base_dir, scratch_pool));
   for (hi = apr_hash_first(scratch_pool, dirents); hi;
@@ -1165,34 +1225,25 @@ migrate_text_bases(const char *wcroot_abspath,
       const char *text_base_path;
       svn_checksum_t *md5_checksum;
       svn_checksum_t *sha1_checksum;
-      svn_sqlite__stmt_t *stmt;
+      svn_stream_t *stream;
       apr_finfo_t finfo;
 
       svn_pool_clear(iterpool);
       text_base_path = svn_dirent_join(text_base_dir, text_base_basename,
                                        iterpool);
 
-      /* ### This code could be a bit smarter: we could chain checksum
-             streams instead of reading the file twice; we could check to
-             see if a pristine row exists before attempting to insert one;
-             we could check and see if a pristine file exists before
-             attempting to copy a new one over it.
-             
-             However, I think simplicity is the big win here, especially since
-             this is code that runs exactly once on a user's machine: when
-             doing the upgrade.  If you disagree, feel free to add the
-             complexity. :)  */
-
-      /* Gather the two checksums. */
-      SVN_ERR(svn_io_file_checksum2(&md5_checksum, text_base_path,
-                                    svn_checksum_md5, iterpool));
-      SVN_ERR(svn_io_file_checksum2(&sha1_checksum, text_base_path,
-                                    svn_checksum_sha1, iterpool));
+      /* Gather the two checksums, reading the file only once. */
+      SVN_ERR(svn_stream_open_readonly(&stream, text_base_path,
+                                       iterpool, iterpool));
+      stream = svn_stream_checksummed2(stream, &md5_checksum, NULL,
+                                       svn_checksum_md5, TRUE, iterpool);
+      stream = svn_stream_checksummed2(stream, &sha1_checksum, NULL,
+                                       svn_checksum_sha1, TRUE, iterpool);
+      SVN_ERR(svn_stream_close(stream));
 
       SVN_ERR(svn_io_stat(&finfo, text_base_path, APR_FINFO_SIZE, iterpool));
 
       /* Insert a row into the pristine table. */
-      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PRISTINE));
       SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, iterpool));
       SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, iterpool));
       SVN_ERR(svn_sqlite__bind_int64(stmt, 3, finfo.size));
@@ -1201,15 +1252,19 @@ migrate_text_bases(const char *wcroot_abspath,
       /* Compute the path of the pristine.
          Note: in format 18, pristines are not yet sharded, so don't include
          that in the path computation. */
-      pristine_path = svn_dirent_join_many(iterpool,
-                                           wcroot_abspath,
+      pristine_path = svn_dirent_join_many(b18->result_pool,
+                                           b18->wcroot_abspath,
                                            svn_wc_get_adm_dir(iterpool),
                                            PRISTINE_STORAGE_RELPATH,
+                                           svn_checksum_to_cstring(
+                                             sha1_checksum, iterpool),
                                            NULL);
 
-      /* Finally, copy the file over. */
-      SVN_ERR(svn_io_copy_file(text_base_path, pristine_path, TRUE,
-                               iterpool));
+      /* The text base itself is moved once the transaction is committed;
+         until then the old working copy must stay intact.  */
+      APR_ARRAY_PUSH(b18->moves, const char *)
+        = apr_pstrdup(b18->result_pool, text_base_path);
+      APR_ARRAY_PUSH(b18->moves, const char *) = pristine_path;
     }
 
   svn_pool_destroy(iterpool);
@@ -1221,9 +1276,44 @@ migrate_text_bases(const char *wcroot_abspath,
 static svn_error_t *
 bump_to_18(void *baton, svn_sqlite__db_t *sdb, apr_pool_t *scratch_pool)
 {
-  const char *wcroot_abspath = baton;
+  struct bump_to_18_baton *b18 = baton;
+
+  SVN_ERR(migrate_text_bases(b18, sdb, scratch_pool));
 
-  SVN_ERR(migrate_text_bases(wcroot_abspath, sdb, scratch_pool));
+  return SVN_NO_ERROR;
+}
+
+
+/* Move the text bases recorded in B18 into the pristine store.  Text bases
+   are removed at the end of the upgrade anyway, so this renames them
+   rather than copying their contents; svn_io_file_move() only falls back
+   to copying if a rename is impossible.  */
+static svn_error_t *
+move_text_bases(const struct bump_to_18_baton *b18,
+                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < b18->moves->nelts; i += 2)
+    {
+      const char *text_base_path = APR_ARRAY_IDX(b18->moves, i,
+                                                 const char *);
+      const char *pristine_path = APR_ARRAY_IDX(b18->moves, i + 1,
+                                                const char *);
+      svn_node_kind_t kind;
+
+      svn_pool_clear(iterpool);
+
+      /* Identical text bases of several files share a pristine.  */
+      SVN_ERR(svn_io_check_path(pristine_path, &kind, iterpool));
+      if (kind == svn_node_file)
+        SVN_ERR(svn_io_remove_file2(text_base_path, FALSE, iterpool));
+      else
+        SVN_ERR(svn_io_file_move(text_base_path, pristine_path, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
@@ -1335,6 +1425,7 @@ svn_wc__upgrade_sdb(int *result_format,
       case 17:
         {
           const char *pristine_dir;
+          struct bump_to_18_baton b18;
 
           /* Create the '.svn/pristine' directory.  */
           pristine_dir = svn_wc__adm_child(wcroot_abspath,
@@ -1342,9 +1433,14 @@ svn_wc__upgrade_sdb(int *result_format,
                                            scratch_pool);
           SVN_ERR(svn_io_dir_make(pristine_dir, APR_OS_DEFAULT, scratch_pool));
 
-          /* Move text bases into the pristine directory, and update the db */
-          SVN_ERR(svn_sqlite__with_transaction(sdb, bump_to_18, wcroot_abspath,
+          /* Record the text bases in the db, then move them into the
+             pristine directory.  */
+          b18.wcroot_abspath = wcroot_abspath;
+          b18.moves = apr_array_make(scratch_pool, 0, sizeof(const char *));
+          b18.result_pool = scratch_pool;
+          SVN_ERR(svn_sqlite__with_transaction(sdb, bump_to_18, &b18,
                                                scratch_pool));
+          SVN_ERR(move_text_bases(&b18, scratch_pool));
         }
 
         *result_format = 18;
@@ -103,6 +103,43 @@ where wc_id = ?1 and parent_relpath = ?2;
 SELECT local_relpath FROM WORKING_NODE
 WHERE wc_id = ?1 AND parent_relpath = ?2;
 
+-- STMT_SELECT_BASE_NODE_CHILDREN_INFO
+select local_relpath, base_node.repos_id, base_node.repos_relpath,
+  presence, kind, revnum, changed_rev, changed_date, changed_author, depth,
+  lock_token, lock_owner, lock_comment, lock_date, translated_size,
+  last_mod_time
+from base_node
+left outer join lock on base_node.repos_id = lock.repos_id
+  and base_node.repos_relpath = lock.repos_relpath
+where wc_id = ?1 and parent_relpath = ?2;
+
+-- STMT_SELECT_WORKING_NODE_CHILDREN_INFO
+select local_relpath, presence, kind, changed_rev, changed_date,
+  changed_author, depth, translated_size, last_mod_time
+from working_node
+where wc_id = ?1 and parent_relpath = ?2;
+
+-- STMT_SELECT_ACTUAL_CHILDREN_INFO
+select local_relpath, prop_reject, changelist, conflict_old, conflict_new,
+  conflict_working, properties
+from actual_node
+where wc_id = ?1 and parent_relpath = ?2;
+
+-- STMT_SELECT_ACTUAL_CHILDREN_CHANGELIST
+select local_relpath, changelist from actual_node
+where wc_id = ?1 and parent_relpath = ?2 and changelist is not null;
+
+-- STMT_SELECT_CHILD_DIRECTORIES
+select local_relpath from working_node
+where wc_id = ?1 and parent_relpath = ?2 and kind in ('dir', 'subdir')
+  and presence != 'excluded'
+union
+select local_relpath from base_node
+where wc_id = ?1 and parent_relpath = ?2 and kind in ('dir', 'subdir')
+  and presence in ('normal', 'incomplete')
+  and local_relpath not in (select local_relpath from working_node
+                            where wc_id = ?1 and parent_relpath = ?2);
+
 -- STMT_SELECT_WORKING_IS_FILE
 select kind == 'file' from working_node
 where wc_id = ?1 and local_relpath = ?2;
@@ -279,12 +316,15 @@ SELECT id FROM WORK_QUEUE LIMIT 1;
 -- STMT_INSERT_WORK_ITEM
 INSERT INTO WORK_QUEUE (work) values (?1);
 
--- STMT_SELECT_WORK_ITEM
-SELECT id, work FROM WORK_QUEUE ORDER BY id LIMIT 1;
+-- STMT_SELECT_WORK_ITEMS
+SELECT id, work FROM WORK_QUEUE ORDER BY id LIMIT ?1;
 
 -- STMT_DELETE_WORK_ITEM
 DELETE FROM WORK_QUEUE WHERE id = ?1;
 
+-- STMT_DELETE_WORK_ITEMS_UPTO
+DELETE FROM WORK_QUEUE WHERE id <= ?1;
+
 -- STMT_INSERT_PRISTINE
 INSERT OR IGNORE INTO PRISTINE (checksum, md5_checksum, size, refcount)
 VALUES (?1, ?2, ?3, 1);
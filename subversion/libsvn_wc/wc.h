@@ -289,6 +289,7 @@ struct svn_wc_traversal_info_t
 #define SVN_WC__ADM_DIR_PROP_REVERT     "dir-prop-revert"
 #define SVN_WC__ADM_PRISTINE            "pristine"
 #define SVN_WC__ADM_NONEXISTENT_PATH    "nonexistent-path"
+#define SVN_WC__ADM_DEHYDRATED          "dehydrated"
 
 /* The basename of the ".prej" file, if a directory ever has property
    conflicts.  This .prej file will appear *within* the conflicted
@@ -366,6 +367,24 @@ svn_wc__internal_text_modified_p(svn_boolean_t *modified_p,
                                  svn_boolean_t compare_textbases,
                                  apr_pool_t *scratch_pool);
 
+/* Like svn_wc__internal_text_modified_p() with FORCE_COMPARISON set to
+ * FALSE, for callers that already have what the size and timestamp
+ * check needs: DIRENT describes LOCAL_ABSPATH as returned by
+ * svn_io_get_dirents3() with ONLY_CHECK_TYPE set to FALSE, and
+ * RECORDED_SIZE and RECORDED_MOD_TIME are the translated size and last
+ * modification time recorded for it in DB.  The file is only read if
+ * that check fails.
+ */
+svn_error_t *
+svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
+                                 svn_wc__db_t *db,
+                                 const char *local_abspath,
+                                 const svn_io_dirent2_t *dirent,
+                                 svn_filesize_t recorded_size,
+                                 apr_time_t recorded_mod_time,
+                                 svn_boolean_t compare_textbases,
+                                 apr_pool_t *scratch_pool);
+
 
 
 /* Merge the difference between LEFT_ABSPATH and RIGHT_ABSPATH into
@@ -595,6 +614,49 @@ svn_wc__internal_is_file_external(svn_boolean_t *file_external,
                                   apr_pool_t *scratch_pool);
 
 
+/* Library-internal version of svn_wc__node_get_unmodified_files(). */
+svn_error_t *
+svn_wc__internal_get_unmodified_files(apr_hash_t **unmodified,
+                                      svn_wc__db_t *db,
+                                      const char *dir_abspath,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool);
+
+
+/* Set *NAMES to a hash whose keys are the basenames of the files listed
+   as dehydrated in the administrative area of DIR_ABSPATH, allocated in
+   RESULT_POOL.  */
+svn_error_t *
+svn_wc__read_dehydrated(apr_hash_t **names,
+                        const char *dir_abspath,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
+
+/* Set *DEHYDRATED to TRUE if the file LOCAL_ABSPATH was checked out
+   without its text and hasn't got it since, otherwise to FALSE.  See
+   svn_wc__get_lazy_update_editor().
+
+   If NAMES is not NULL, it is what svn_wc__read_dehydrated() returned for
+   the directory of LOCAL_ABSPATH, which saves reading the list again.  */
+svn_error_t *
+svn_wc__internal_is_dehydrated(svn_boolean_t *dehydrated,
+                               svn_wc__db_t *db,
+                               const char *local_abspath,
+                               apr_hash_t *names,
+                               apr_pool_t *scratch_pool);
+
+
+/* Add the basenames that are keys of ADDED to the list of dehydrated
+   files in the administrative area of DIR_ABSPATH, and remove those that
+   are keys of REMOVED.  Either hash may be NULL.  */
+svn_error_t *
+svn_wc__set_dehydrated(const char *dir_abspath,
+                       apr_hash_t *added,
+                       apr_hash_t *removed,
+                       apr_pool_t *scratch_pool);
+
+
 /* Upgrade the wc sqlite database given in SDB for the wc located at
    WCROOT_ABSPATH. It's current/starting format is given by START_FORMAT.
    After the upgrade is complete (to as far as the automatic upgrade will
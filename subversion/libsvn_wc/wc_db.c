@@ -357,28 +357,45 @@ get_pristine_fname(const char **pristine_abspath,
 static svn_error_t *
 fetch_repos_info(const char **repos_root_url,
                  const char **repos_uuid,
-                 svn_sqlite__db_t *sdb,
+                 svn_wc__db_wcroot_t *wcroot,
                  apr_int64_t repos_id,
                  apr_pool_t *result_pool)
 {
-  svn_sqlite__stmt_t *stmt;
-  svn_boolean_t have_row;
+  const char **info = apr_hash_get(wcroot->repos_cache, &repos_id,
+                                   sizeof(repos_id));
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
-                                    STMT_SELECT_REPOSITORY_BY_ID));
-  SVN_ERR(svn_sqlite__bindf(stmt, "i", repos_id));
-  SVN_ERR(svn_sqlite__step(&have_row, stmt));
-  if (!have_row)
-    return svn_error_createf(SVN_ERR_WC_CORRUPT, svn_sqlite__reset(stmt),
-                             _("No REPOSITORY table entry for id '%ld'"),
-                             (long int)repos_id);
+  if (!info)
+    {
+      apr_pool_t *cache_pool = apr_hash_pool_get(wcroot->repos_cache);
+      apr_int64_t *key;
+      svn_sqlite__stmt_t *stmt;
+      svn_boolean_t have_row;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_SELECT_REPOSITORY_BY_ID));
+      SVN_ERR(svn_sqlite__bindf(stmt, "i", repos_id));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      if (!have_row)
+        return svn_error_createf(SVN_ERR_WC_CORRUPT, svn_sqlite__reset(stmt),
+                                 _("No REPOSITORY table entry for id '%ld'"),
+                                 (long int)repos_id);
+
+      info = apr_palloc(cache_pool, 2 * sizeof(*info));
+      info[0] = svn_sqlite__column_text(stmt, 0, cache_pool);
+      info[1] = svn_sqlite__column_text(stmt, 1, cache_pool);
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      key = apr_palloc(cache_pool, sizeof(*key));
+      *key = repos_id;
+      apr_hash_set(wcroot->repos_cache, key, sizeof(*key), info);
+    }
 
   if (repos_root_url)
-    *repos_root_url = svn_sqlite__column_text(stmt, 0, result_pool);
+    *repos_root_url = info[0] ? apr_pstrdup(result_pool, info[0]) : NULL;
   if (repos_uuid)
-    *repos_uuid = svn_sqlite__column_text(stmt, 1, result_pool);
+    *repos_uuid = info[1] ? apr_pstrdup(result_pool, info[1]) : NULL;
 
-  return svn_error_return(svn_sqlite__reset(stmt));
+  return SVN_NO_ERROR;
 }
 
 
@@ -1162,6 +1179,43 @@ prop_upgrade_trees(svn_boolean_t *base_exists,
 }
 
 
+struct init_db_baton
+{
+  /* For the REPOSITORY row.  */
+  const char *repos_root_url;
+  const char *repos_uuid;
+
+  /* Output values.  */
+  apr_int64_t repos_id;
+  apr_int64_t wc_id;
+};
+
+
+/* Create the schema of SDB and insert the initial rows, as described by
+   the struct init_db_baton BATON.  Implements
+   svn_sqlite__transaction_callback_t.  */
+static svn_error_t *
+init_db(void *baton,
+        svn_sqlite__db_t *sdb,
+        apr_pool_t *scratch_pool)
+{
+  struct init_db_baton *idb = baton;
+  svn_sqlite__stmt_t *stmt;
+
+  /* Create the database's schema.  */
+  SVN_ERR(svn_sqlite__exec_statements(sdb, STMT_CREATE_SCHEMA));
+
+  /* Insert the repository. */
+  SVN_ERR(create_repos_id(&idb->repos_id, idb->repos_root_url,
+                          idb->repos_uuid, sdb, scratch_pool));
+
+  /* Insert the wcroot. */
+  /* ### Right now, this just assumes wc metadata is being stored locally. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_WCROOT));
+  return svn_error_return(svn_sqlite__insert(&idb->wc_id, stmt));
+}
+
+
 /* */
 static svn_error_t *
 create_db(svn_sqlite__db_t **sdb,
@@ -1171,26 +1225,25 @@ create_db(svn_sqlite__db_t **sdb,
           const char *repos_root_url,
           const char *repos_uuid,
           const char *sdb_fname,
+          const svn_sqlite__tuning_t *tuning,
           apr_pool_t *result_pool,
           apr_pool_t *scratch_pool)
 {
-  svn_sqlite__stmt_t *stmt;
+  struct init_db_baton idb;
 
   SVN_ERR(svn_wc__db_util_open_db(sdb, dir_abspath, sdb_fname,
-                                  svn_sqlite__mode_rwcreate, result_pool,
-                                  scratch_pool));
+                                  svn_sqlite__mode_rwcreate, tuning,
+                                  result_pool, scratch_pool));
 
-  /* Create the database's schema.  */
-  SVN_ERR(svn_sqlite__exec_statements(*sdb, STMT_CREATE_SCHEMA));
+  idb.repos_root_url = repos_root_url;
+  idb.repos_uuid = repos_uuid;
 
-  /* Insert the repository. */
-  SVN_ERR(create_repos_id(repos_id, repos_root_url, repos_uuid, *sdb,
-                          scratch_pool));
+  /* Creating the schema is a dozen statements; doing them all in one
+     transaction saves a journal sync for each of them.  */
+  SVN_ERR(svn_sqlite__with_transaction(*sdb, init_db, &idb, scratch_pool));
 
-  /* Insert the wcroot. */
-  /* ### Right now, this just assumes wc metadata is being stored locally. */
-  SVN_ERR(svn_sqlite__get_statement(&stmt, *sdb, STMT_INSERT_WCROOT));
-  SVN_ERR(svn_sqlite__insert(wc_id, stmt));
+  *repos_id = idb.repos_id;
+  *wc_id = idb.wc_id;
 
   return SVN_NO_ERROR;
 }
@@ -1223,7 +1276,8 @@ svn_wc__db_init(svn_wc__db_t *db,
 
   /* Create the SDB and insert the basic rows.  */
   SVN_ERR(create_db(&sdb, &repos_id, &wc_id, local_abspath, repos_root_url,
-                    repos_uuid, SDB_FILE, db->state_pool, scratch_pool));
+                    repos_uuid, SDB_FILE, &db->sqlite_tuning,
+                    db->state_pool, scratch_pool));
 
   /* Begin construction of the PDH.  */
   pdh = apr_pcalloc(db->state_pool, sizeof(*pdh));
@@ -1309,6 +1363,53 @@ svn_wc__db_from_relpath(const char **local_abspath,
 }
 
 
+/* Baton for with_transaction_cb(). */
+struct with_transaction_baton
+{
+  svn_wc__db_txn_callback_t cb_func;
+  void *cb_baton;
+};
+
+/* Run the callback of svn_wc__db_with_transaction().  This implements
+   svn_sqlite__transaction_callback_t. */
+static svn_error_t *
+with_transaction_cb(void *baton,
+                    svn_sqlite__db_t *sdb,
+                    apr_pool_t *scratch_pool)
+{
+  struct with_transaction_baton *wtb = baton;
+
+  return svn_error_return(wtb->cb_func(wtb->cb_baton, scratch_pool));
+}
+
+
+svn_error_t *
+svn_wc__db_with_transaction(svn_wc__db_t *db,
+                            const char *local_abspath,
+                            svn_wc__db_txn_callback_t cb_func,
+                            void *cb_baton,
+                            apr_pool_t *scratch_pool)
+{
+  svn_wc__db_pdh_t *pdh;
+  const char *local_relpath;
+  struct with_transaction_baton wtb;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_pdh_parse_local_abspath(&pdh, &local_relpath, db,
+                              local_abspath, svn_sqlite__mode_readwrite,
+                              scratch_pool, scratch_pool));
+  VERIFY_USABLE_PDH(pdh);
+
+  wtb.cb_func = cb_func;
+  wtb.cb_baton = cb_baton;
+
+  return svn_error_return(svn_sqlite__with_transaction(pdh->wcroot->sdb,
+                                                       with_transaction_cb,
+                                                       &wtb, scratch_pool));
+}
+
+
 svn_error_t *
 svn_wc__db_base_add_directory(svn_wc__db_t *db,
                               const char *local_abspath,
@@ -1791,7 +1892,7 @@ svn_wc__db_base_get_info(svn_wc__db_status_t *status,
           else
             {
               err = fetch_repos_info(repos_root_url, repos_uuid,
-                                     pdh->wcroot->sdb,
+                                     pdh->wcroot,
                                      svn_sqlite__column_int64(stmt, 0),
                                      result_pool);
             }
@@ -1945,6 +2046,150 @@ svn_wc__db_base_get_children(const apr_array_header_t **children,
 }
 
 
+svn_error_t *
+svn_wc__db_base_get_children_info(apr_hash_t **nodes,
+                                  svn_wc__db_t *db,
+                                  const char *dir_abspath,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_wc__db_pdh_t *pdh;
+  const char *dir_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_hash_t *repos_root_urls = apr_hash_make(scratch_pool);
+  apr_array_header_t *subdirs = apr_array_make(scratch_pool, 0,
+                                               sizeof(const char *));
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(dir_abspath));
+
+  SVN_ERR(svn_wc__db_pdh_parse_local_abspath(&pdh, &dir_relpath, db,
+                                             dir_abspath,
+                                             svn_sqlite__mode_readonly,
+                                             scratch_pool, scratch_pool));
+  VERIFY_USABLE_PDH(pdh);
+
+  *nodes = apr_hash_make(result_pool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, pdh->wcroot->sdb,
+                                    STMT_SELECT_BASE_NODE_CHILDREN_INFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", pdh->wcroot->wc_id, dir_relpath));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      struct svn_wc__db_base_info_t *child = apr_pcalloc(result_pool,
+                                                         sizeof(*child));
+      const char *name = svn_relpath_basename(
+                           svn_sqlite__column_text(stmt, 0, NULL),
+                           result_pool);
+
+      apr_hash_set(*nodes, name, APR_HASH_KEY_STRING, child);
+
+      child->kind = svn_sqlite__column_token(stmt, 4, kind_map);
+      if (child->kind == svn_wc__db_kind_subdir)
+        {
+          /* Only a stub; filled in below. */
+          APR_ARRAY_PUSH(subdirs, const char *) = name;
+          SVN_ERR(svn_sqlite__step(&have_row, stmt));
+          continue;
+        }
+
+      child->status = svn_sqlite__column_token(stmt, 3, presence_map);
+      child->revnum = svn_sqlite__column_revnum(stmt, 5);
+      child->repos_relpath = svn_sqlite__column_text(stmt, 2, result_pool);
+
+      if (!svn_sqlite__column_is_null(stmt, 1))
+        {
+          apr_int64_t repos_id = svn_sqlite__column_int64(stmt, 1);
+          const char *repos_root_url = apr_hash_get(repos_root_urls,
+                                                    &repos_id,
+                                                    sizeof(repos_id));
+
+          if (!repos_root_url)
+            {
+              apr_int64_t *key = apr_palloc(scratch_pool, sizeof(*key));
+              svn_error_t *err;
+
+              err = fetch_repos_info(&repos_root_url, NULL,
+                                     pdh->wcroot, repos_id,
+                                     result_pool);
+              if (err)
+                return svn_error_compose_create(err,
+                                                svn_sqlite__reset(stmt));
+
+              *key = repos_id;
+              apr_hash_set(repos_root_urls, key, sizeof(*key),
+                           repos_root_url);
+            }
+          child->repos_root_url = repos_root_url;
+        }
+
+      if (child->kind == svn_wc__db_kind_dir)
+        {
+          const char *depth_str = svn_sqlite__column_text(stmt, 9, NULL);
+
+          child->depth = depth_str ? svn_depth_from_word(depth_str)
+                                   : svn_depth_unknown;
+        }
+      else
+        child->depth = svn_depth_unknown;
+
+      if (!svn_sqlite__column_is_null(stmt, 10))
+        {
+          child->lock = apr_pcalloc(result_pool, sizeof(*child->lock));
+          child->lock->token = svn_sqlite__column_text(stmt, 10,
+                                                       result_pool);
+          if (!svn_sqlite__column_is_null(stmt, 11))
+            child->lock->owner = svn_sqlite__column_text(stmt, 11,
+                                                         result_pool);
+          if (!svn_sqlite__column_is_null(stmt, 12))
+            child->lock->comment = svn_sqlite__column_text(stmt, 12,
+                                                           result_pool);
+          if (!svn_sqlite__column_is_null(stmt, 13))
+            child->lock->date = svn_sqlite__column_int64(stmt, 13);
+        }
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* Like svn_wc__db_base_get_info(), look at the subdirectories' own
+     databases. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < subdirs->nelts; i++)
+    {
+      const char *name = APR_ARRAY_IDX(subdirs, i, const char *);
+      struct svn_wc__db_base_info_t *child = apr_hash_get(*nodes, name,
+                                                          APR_HASH_KEY_STRING);
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_wc__db_base_get_info(&child->status, &child->kind,
+                                     &child->revnum, &child->repos_relpath,
+                                     &child->repos_root_url, NULL, NULL,
+                                     NULL, NULL, NULL, &child->depth, NULL,
+                                     NULL, NULL, &child->lock,
+                                     db, svn_dirent_join(dir_abspath, name,
+                                                         iterpool),
+                                     result_pool, iterpool);
+      if (err && err->apr_err == SVN_ERR_WC_PATH_NOT_FOUND)
+        {
+          svn_error_clear(err);
+          child->status = svn_wc__db_status_not_present;
+          child->kind = svn_wc__db_kind_dir;
+        }
+      else
+        SVN_ERR(err);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_wc__db_base_set_dav_cache(svn_wc__db_t *db,
                               const char *local_abspath,
@@ -1963,6 +2208,39 @@ svn_wc__db_base_set_dav_cache(svn_wc__db_t *db,
 }
 
 
+svn_error_t *
+svn_wc__db_base_clear_dav_cache_recursive(svn_wc__db_t *db,
+                                          const char *local_abspath,
+                                          apr_pool_t *scratch_pool)
+{
+  svn_wc__db_pdh_t *pdh;
+  const char *local_relpath;
+  const char *like_arg;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_pdh_parse_local_abspath(&pdh, &local_relpath, db,
+                              local_abspath, svn_sqlite__mode_readwrite,
+                              scratch_pool, scratch_pool));
+  VERIFY_USABLE_PDH(pdh);
+
+  if (local_relpath[0] == 0)
+    like_arg = "%";
+  else
+    like_arg = apr_pstrcat(scratch_pool,
+                           escape_sqlite_like(local_relpath, scratch_pool),
+                           "/%", NULL);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, pdh->wcroot->sdb,
+                                    STMT_CLEAR_BASE_RECURSIVE_DAV_CACHE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "iss", pdh->wcroot->wc_id, local_relpath,
+                            like_arg));
+
+  return svn_error_return(svn_sqlite__step_done(stmt));
+}
+
+
 svn_error_t *
 svn_wc__db_base_get_dav_cache(apr_hash_t **props,
                               svn_wc__db_t *db,
@@ -2093,6 +2371,62 @@ svn_wc__db_pristine_get_tempdir(const char **temp_dir_abspath,
 }
 
 
+/* Install the pristine text in TEMPFILE_ABSPATH, whose checksum is
+   SHA1_CHECKSUM, at PRISTINE_ABSPATH, sharing it with the pristine store
+   shared between working copies at DB->shared_pristine_abspath.
+
+   Files are shared as hard links, so the link count of a file in the
+   shared store is the number of working copies using it, plus one. When
+   the shared store can't be used, e.g. because it is on another file
+   system, the pristine text is installed as if there was no shared store. */
+static svn_error_t *
+install_shared_pristine(svn_wc__db_t *db,
+                        const char *tempfile_abspath,
+                        const char *pristine_abspath,
+                        const svn_checksum_t *sha1_checksum,
+                        apr_pool_t *scratch_pool)
+{
+  const char *hexdigest = svn_checksum_to_cstring(sha1_checksum, scratch_pool);
+  const char *subdir_abspath;
+  const char *shared_abspath;
+  apr_finfo_t temp_finfo;
+  apr_finfo_t shared_finfo;
+  svn_error_t *err;
+
+  subdir_abspath = svn_dirent_join(db->shared_pristine_abspath,
+                                   apr_pstrndup(scratch_pool, hexdigest, 2),
+                                   scratch_pool);
+  shared_abspath = svn_dirent_join(subdir_abspath, hexdigest, scratch_pool);
+
+  /* If another working copy has provided this text already, use theirs.
+     Comparing the sizes catches files that were truncated in the store. */
+  SVN_ERR(svn_io_stat(&temp_finfo, tempfile_abspath, APR_FINFO_SIZE,
+                      scratch_pool));
+  err = svn_io_stat(&shared_finfo, shared_abspath, APR_FINFO_SIZE,
+                    scratch_pool);
+  if (!err && shared_finfo.size == temp_finfo.size)
+    {
+      err = svn_io_create_hard_link(pristine_abspath, shared_abspath,
+                                    scratch_pool);
+      if (!err)
+        return svn_error_return(svn_io_remove_file2(tempfile_abspath, FALSE,
+                                                    scratch_pool));
+    }
+  svn_error_clear(err);
+
+  SVN_ERR(svn_io_file_rename(tempfile_abspath, pristine_abspath,
+                             scratch_pool));
+
+  /* Offer our copy to other working copies. If another working copy got
+     there first, or the store is unusable, we just keep our own copy.  */
+  svn_error_clear(svn_io_make_dir_recursively(subdir_abspath, scratch_pool));
+  svn_error_clear(svn_io_create_hard_link(shared_abspath, pristine_abspath,
+                                          scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_wc__db_pristine_install(svn_wc__db_t *db,
                             const char *tempfile_abspath,
@@ -2131,8 +2465,12 @@ svn_wc__db_pristine_install(svn_wc__db_t *db,
                              scratch_pool, scratch_pool));
 
   /* Put the file into its target location.  */
-  SVN_ERR(svn_io_file_rename(tempfile_abspath, pristine_abspath,
-                             scratch_pool));
+  if (db->shared_pristine_abspath)
+    SVN_ERR(install_shared_pristine(db, tempfile_abspath, pristine_abspath,
+                                    sha1_checksum, scratch_pool));
+  else
+    SVN_ERR(svn_io_file_rename(tempfile_abspath, pristine_abspath,
+                               scratch_pool));
 
   SVN_ERR(svn_io_stat(&finfo, pristine_abspath, APR_FINFO_SIZE,
                       scratch_pool));
@@ -3427,10 +3765,10 @@ set_tc_txn(void *baton, svn_sqlite__db_t *sdb, apr_pool_t *scratch_pool)
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
   const char *tree_conflict_data;
-  apr_hash_t *conflicts;
 
   /* Get the conflict information for the parent of LOCAL_ABSPATH. */
-  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_ACTUAL_NODE));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                    STMT_SELECT_ACTUAL_TREE_CONFLICT));
   SVN_ERR(svn_sqlite__bindf(stmt, "is", stb->wc_id, stb->local_relpath));
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
 
@@ -3438,28 +3776,25 @@ set_tc_txn(void *baton, svn_sqlite__db_t *sdb, apr_pool_t *scratch_pool)
   if (!have_row)
     tree_conflict_data = NULL;
   else
-    tree_conflict_data = svn_sqlite__column_text(stmt, 5, scratch_pool);
+    tree_conflict_data = svn_sqlite__column_text(stmt, 0, scratch_pool);
 
   SVN_ERR(svn_sqlite__reset(stmt));
 
-  /* Parse the conflict data, set the desired conflict, and then rewrite
-     the conflict data. */
-  SVN_ERR(svn_wc__read_tree_conflicts(&conflicts, tree_conflict_data,
-                                      stb->parent_abspath, scratch_pool));
-
-  apr_hash_set(conflicts, svn_dirent_basename(stb->local_abspath,
-                                              scratch_pool),
-               APR_HASH_KEY_STRING, stb->tree_conflict);
-
-  if (apr_hash_count(conflicts) == 0 && !have_row)
+  if (!have_row && stb->tree_conflict == NULL)
     {
       /* We're removing conflict information that doesn't even exist, so
          don't bother rewriting it, just exit. */
       return SVN_NO_ERROR;
     }
 
-  SVN_ERR(svn_wc__write_tree_conflicts(&tree_conflict_data, conflicts,
-                                       scratch_pool));
+  /* Replace just the victim's entry in the conflict data; the other
+     victims' descriptions are copied over as they are. */
+  SVN_ERR(svn_wc__set_tree_conflict_data(&tree_conflict_data,
+                                         tree_conflict_data,
+                                         svn_dirent_basename(
+                                                  stb->local_abspath, NULL),
+                                         stb->tree_conflict,
+                                         scratch_pool, scratch_pool));
 
   if (have_row)
     {
@@ -3583,15 +3918,19 @@ svn_wc__db_op_read_tree_conflict(
                      apr_pool_t *scratch_pool)
 {
   const char *parent_abspath;
-  apr_hash_t *tree_conflicts;
+  svn_wc__db_pdh_t *pdh;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  const char *tree_conflict_data;
   svn_error_t *err;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
   parent_abspath = svn_dirent_dirname(local_abspath, scratch_pool);
 
-  err = svn_wc__db_op_read_all_tree_conflicts(&tree_conflicts, db,
-                                              parent_abspath,
-                                              result_pool, scratch_pool);
+  err = svn_wc__db_pdh_parse_local_abspath(&pdh, &local_relpath, db,
+                              parent_abspath, svn_sqlite__mode_readwrite,
+                              scratch_pool, scratch_pool);
   if (err && err->apr_err == SVN_ERR_WC_NOT_WORKING_COPY)
     {
        /* We walked off the top of a working copy.  */
@@ -3601,16 +3940,26 @@ svn_wc__db_op_read_tree_conflict(
     }
   else if (err)
     return svn_error_return(err);
+  VERIFY_USABLE_PDH(pdh);
 
-  if (tree_conflicts)
-    *tree_conflict = apr_hash_get(tree_conflicts,
-                                  svn_dirent_basename(local_abspath,
-                                                      scratch_pool),
-                                  APR_HASH_KEY_STRING);
-  else
-    *tree_conflict = NULL;
+  /* Get the conflict information for the parent of LOCAL_ABSPATH. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, pdh->wcroot->sdb,
+                                    STMT_SELECT_ACTUAL_TREE_CONFLICT));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", pdh->wcroot->wc_id, local_relpath));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
 
-  return SVN_NO_ERROR;
+  tree_conflict_data = have_row ? svn_sqlite__column_text(stmt, 0,
+                                                          scratch_pool)
+                                : NULL;
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* Only convert the description of LOCAL_ABSPATH, not those of all
+     of its siblings. */
+  return svn_error_return(svn_wc__read_tree_conflict(tree_conflict,
+                                                     tree_conflict_data,
+                                                     local_abspath,
+                                                     result_pool,
+                                                     scratch_pool));
 }
 
 svn_error_t *
@@ -3995,10 +4344,9 @@ is_add_or_root_of_copy(svn_boolean_t *add_or_root_of_copy,
                && original_revision == parent_original_revision
                && !strcmp(original_repos_uuid, parent_original_repos_uuid)
                && !strcmp(original_repos_root, parent_original_repos_root)
-               && !strcmp(original_repos_relpath,
-                          svn_dirent_join(parent_original_repos_relpath,
-                                          name,
-                                          scratch_pool)))
+               && svn_relpath__is_joined(original_repos_relpath,
+                                         parent_original_repos_relpath,
+                                         name))
         /* An instance of the merge bug */
         *add_or_root_of_copy = FALSE;
     }
@@ -4171,38 +4519,40 @@ svn_wc__db_temp_op_delete(svn_wc__db_t *db,
 }
 
 
-svn_error_t *
-svn_wc__db_read_info(svn_wc__db_status_t *status,
-                     svn_wc__db_kind_t *kind,
-                     svn_revnum_t *revision,
-                     const char **repos_relpath,
-                     const char **repos_root_url,
-                     const char **repos_uuid,
-                     svn_revnum_t *changed_rev,
-                     apr_time_t *changed_date,
-                     const char **changed_author,
-                     apr_time_t *last_mod_time,
-                     svn_depth_t *depth,
-                     const svn_checksum_t **checksum,
-                     svn_filesize_t *translated_size,
-                     const char **target,
-                     const char **changelist,
-                     const char **original_repos_relpath,
-                     const char **original_root_url,
-                     const char **original_uuid,
-                     svn_revnum_t *original_revision,
-                     svn_boolean_t *text_mod,
-                     svn_boolean_t *props_mod,
-                     svn_boolean_t *base_shadowed,
-                     svn_boolean_t *conflicted,
-                     svn_wc__db_lock_t **lock,
-                     svn_wc__db_t *db,
-                     const char *local_abspath,
-                     apr_pool_t *result_pool,
-                     apr_pool_t *scratch_pool)
+/* Like svn_wc__db_read_info(), but for LOCAL_RELPATH in PDH, bypassing the
+   node cache. */
+static svn_error_t *
+read_info(svn_wc__db_status_t *status,
+          svn_wc__db_kind_t *kind,
+          svn_revnum_t *revision,
+          const char **repos_relpath,
+          const char **repos_root_url,
+          const char **repos_uuid,
+          svn_revnum_t *changed_rev,
+          apr_time_t *changed_date,
+          const char **changed_author,
+          apr_time_t *last_mod_time,
+          svn_depth_t *depth,
+          const svn_checksum_t **checksum,
+          svn_filesize_t *translated_size,
+          const char **target,
+          const char **changelist,
+          const char **original_repos_relpath,
+          const char **original_root_url,
+          const char **original_uuid,
+          svn_revnum_t *original_revision,
+          svn_boolean_t *text_mod,
+          svn_boolean_t *props_mod,
+          svn_boolean_t *base_shadowed,
+          svn_boolean_t *conflicted,
+          svn_wc__db_lock_t **lock,
+          svn_wc__db_t *db,
+          svn_wc__db_pdh_t *pdh,
+          const char *local_relpath,
+          const char *local_abspath,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
 {
-  svn_wc__db_pdh_t *pdh;
-  const char *local_relpath;
   svn_sqlite__stmt_t *stmt_base;
   svn_sqlite__stmt_t *stmt_work;
   svn_sqlite__stmt_t *stmt_act;
@@ -4211,13 +4561,6 @@ svn_wc__db_read_info(svn_wc__db_status_t *status,
   svn_boolean_t have_act;
   svn_error_t *err = NULL;
 
-  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
-
-  SVN_ERR(svn_wc__db_pdh_parse_local_abspath(&pdh, &local_relpath, db,
-                              local_abspath, svn_sqlite__mode_readonly,
-                              scratch_pool, scratch_pool));
-  VERIFY_USABLE_PDH(pdh);
-
   SVN_ERR(svn_sqlite__get_statement(&stmt_base, pdh->wcroot->sdb,
                                     lock ? STMT_SELECT_BASE_NODE_WITH_LOCK
                                          : STMT_SELECT_BASE_NODE));
@@ -4381,7 +4724,7 @@ svn_wc__db_read_info(svn_wc__db_status_t *status,
                      err,
                      fetch_repos_info(repos_root_url,
                                       repos_uuid,
-                                      pdh->wcroot->sdb,
+                                      pdh->wcroot,
                                       svn_sqlite__column_int64(stmt_base, 0),
                                       result_pool));
         }
@@ -4457,7 +4800,7 @@ svn_wc__db_read_info(svn_wc__db_status_t *status,
                 err = svn_error_compose_create(
                          err,
                          svn_error_createf(
-                               err->apr_err, err2,
+                               err2->apr_err, err2,
                               _("The node '%s' has a corrupt checksum value."),
                               svn_dirent_local_style(local_abspath,
                                                      scratch_pool)));
@@ -4507,7 +4850,7 @@ svn_wc__db_read_info(svn_wc__db_status_t *status,
           err = svn_error_compose_create(
                      err,
                      fetch_repos_info(original_root_url, original_uuid,
-                                      pdh->wcroot->sdb,
+                                      pdh->wcroot,
                                       svn_sqlite__column_int64(stmt_work, 9),
                                       result_pool));
         }
@@ -4548,7 +4891,7 @@ svn_wc__db_read_info(svn_wc__db_status_t *status,
         }
       if (lock)
         {
-          if (svn_sqlite__column_is_null(stmt_base, 14))
+          if (!have_base || svn_sqlite__column_is_null(stmt_base, 14))
             *lock = NULL;
           else
             {
@@ -4604,6 +4947,223 @@ svn_wc__db_read_info(svn_wc__db_status_t *status,
 }
 
 
+/* The maximum number of nodes kept in the node cache of a wcroot. */
+#define NODE_CACHE_SIZE 1024
+
+/* The result of svn_wc__db_read_info() for a node, as kept in the node
+   cache of its wcroot.  The members have the same meaning as the
+   identically named arguments of svn_wc__db_read_info(); CONFLICTED is
+   left out because it depends on the parent directory. */
+typedef struct cached_info_t
+{
+  svn_wc__db_status_t status;
+  svn_wc__db_kind_t kind;
+  svn_revnum_t revision;
+  const char *repos_relpath;
+  const char *repos_root_url;
+  const char *repos_uuid;
+  svn_revnum_t changed_rev;
+  apr_time_t changed_date;
+  const char *changed_author;
+  apr_time_t last_mod_time;
+  svn_depth_t depth;
+  const svn_checksum_t *checksum;
+  svn_filesize_t translated_size;
+  const char *target;
+  const char *changelist;
+  const char *original_repos_relpath;
+  const char *original_root_url;
+  const char *original_uuid;
+  svn_revnum_t original_revision;
+  svn_boolean_t text_mod;
+  svn_boolean_t props_mod;
+  svn_boolean_t base_shadowed;
+  svn_wc__db_lock_t *lock;
+} cached_info_t;
+
+/* Set *INFO to the cached information about LOCAL_RELPATH in PDH, reading
+   it into the cache if necessary.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+get_cached_info(const cached_info_t **info,
+                svn_wc__db_t *db,
+                svn_wc__db_pdh_t *pdh,
+                const char *local_relpath,
+                const char *local_abspath,
+                apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot = pdh->wcroot;
+  apr_int64_t generation = svn_sqlite__changes_generation(wcroot->sdb);
+  cached_info_t *new_info;
+
+  /* Anything we wrote may have changed any cached node. */
+  if (generation != wcroot->node_cache_generation
+      || apr_hash_count(wcroot->node_cache) >= NODE_CACHE_SIZE)
+    {
+      svn_pool_clear(wcroot->node_cache_pool);
+      wcroot->node_cache = apr_hash_make(wcroot->node_cache_pool);
+      wcroot->node_cache_generation = generation;
+    }
+
+  *info = apr_hash_get(wcroot->node_cache, local_relpath,
+                       APR_HASH_KEY_STRING);
+  if (*info)
+    return SVN_NO_ERROR;
+
+  new_info = apr_pcalloc(wcroot->node_cache_pool, sizeof(*new_info));
+  SVN_ERR(read_info(&new_info->status, &new_info->kind,
+                    &new_info->revision, &new_info->repos_relpath,
+                    &new_info->repos_root_url, &new_info->repos_uuid,
+                    &new_info->changed_rev, &new_info->changed_date,
+                    &new_info->changed_author, &new_info->last_mod_time,
+                    &new_info->depth, &new_info->checksum,
+                    &new_info->translated_size, &new_info->target,
+                    &new_info->changelist, &new_info->original_repos_relpath,
+                    &new_info->original_root_url, &new_info->original_uuid,
+                    &new_info->original_revision, &new_info->text_mod,
+                    &new_info->props_mod, &new_info->base_shadowed,
+                    NULL, &new_info->lock,
+                    db, pdh, local_relpath, local_abspath,
+                    wcroot->node_cache_pool, scratch_pool));
+
+  apr_hash_set(wcroot->node_cache,
+               apr_pstrdup(wcroot->node_cache_pool, local_relpath),
+               APR_HASH_KEY_STRING, new_info);
+  *info = new_info;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a copy of the string STR in POOL, or NULL if STR is NULL. */
+static const char *
+dup_or_null(const char *str, apr_pool_t *pool)
+{
+  return str ? apr_pstrdup(pool, str) : NULL;
+}
+
+svn_error_t *
+svn_wc__db_read_info(svn_wc__db_status_t *status,
+                     svn_wc__db_kind_t *kind,
+                     svn_revnum_t *revision,
+                     const char **repos_relpath,
+                     const char **repos_root_url,
+                     const char **repos_uuid,
+                     svn_revnum_t *changed_rev,
+                     apr_time_t *changed_date,
+                     const char **changed_author,
+                     apr_time_t *last_mod_time,
+                     svn_depth_t *depth,
+                     const svn_checksum_t **checksum,
+                     svn_filesize_t *translated_size,
+                     const char **target,
+                     const char **changelist,
+                     const char **original_repos_relpath,
+                     const char **original_root_url,
+                     const char **original_uuid,
+                     svn_revnum_t *original_revision,
+                     svn_boolean_t *text_mod,
+                     svn_boolean_t *props_mod,
+                     svn_boolean_t *base_shadowed,
+                     svn_boolean_t *conflicted,
+                     svn_wc__db_lock_t **lock,
+                     svn_wc__db_t *db,
+                     const char *local_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  svn_wc__db_pdh_t *pdh;
+  const char *local_relpath;
+  const cached_info_t *info;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_pdh_parse_local_abspath(&pdh, &local_relpath, db,
+                              local_abspath, svn_sqlite__mode_readonly,
+                              scratch_pool, scratch_pool));
+  VERIFY_USABLE_PDH(pdh);
+
+  /* Only cache while we own the write lock: nobody else may change the
+     database then, and svn_sqlite__changes_generation() tells us about
+     our own changes.  Tree conflicts are recorded in the parent, so
+     don't bother with the cache if the caller asks for them. */
+  if (!pdh->locked || conflicted)
+    return svn_error_return(
+             read_info(status, kind, revision, repos_relpath, repos_root_url,
+                       repos_uuid, changed_rev, changed_date, changed_author,
+                       last_mod_time, depth, checksum, translated_size,
+                       target, changelist, original_repos_relpath,
+                       original_root_url, original_uuid, original_revision,
+                       text_mod, props_mod, base_shadowed, conflicted, lock,
+                       db, pdh, local_relpath, local_abspath,
+                       result_pool, scratch_pool));
+
+  SVN_ERR(get_cached_info(&info, db, pdh, local_relpath, local_abspath,
+                          scratch_pool));
+
+  if (status)
+    *status = info->status;
+  if (kind)
+    *kind = info->kind;
+  if (revision)
+    *revision = info->revision;
+  if (repos_relpath)
+    *repos_relpath = dup_or_null(info->repos_relpath, result_pool);
+  if (repos_root_url)
+    *repos_root_url = dup_or_null(info->repos_root_url, result_pool);
+  if (repos_uuid)
+    *repos_uuid = dup_or_null(info->repos_uuid, result_pool);
+  if (changed_rev)
+    *changed_rev = info->changed_rev;
+  if (changed_date)
+    *changed_date = info->changed_date;
+  if (changed_author)
+    *changed_author = dup_or_null(info->changed_author, result_pool);
+  if (last_mod_time)
+    *last_mod_time = info->last_mod_time;
+  if (depth)
+    *depth = info->depth;
+  if (checksum)
+    *checksum = info->checksum ? svn_checksum_dup(info->checksum, result_pool)
+                               : NULL;
+  if (translated_size)
+    *translated_size = info->translated_size;
+  if (target)
+    *target = dup_or_null(info->target, result_pool);
+  if (changelist)
+    *changelist = dup_or_null(info->changelist, result_pool);
+  if (original_repos_relpath)
+    *original_repos_relpath = dup_or_null(info->original_repos_relpath,
+                                          result_pool);
+  if (original_root_url)
+    *original_root_url = dup_or_null(info->original_root_url, result_pool);
+  if (original_uuid)
+    *original_uuid = dup_or_null(info->original_uuid, result_pool);
+  if (original_revision)
+    *original_revision = info->original_revision;
+  if (text_mod)
+    *text_mod = info->text_mod;
+  if (props_mod)
+    *props_mod = info->props_mod;
+  if (base_shadowed)
+    *base_shadowed = info->base_shadowed;
+  if (lock)
+    {
+      if (info->lock)
+        {
+          *lock = apr_pcalloc(result_pool, sizeof(**lock));
+          (*lock)->token = dup_or_null(info->lock->token, result_pool);
+          (*lock)->owner = dup_or_null(info->lock->owner, result_pool);
+          (*lock)->comment = dup_or_null(info->lock->comment, result_pool);
+          (*lock)->date = info->lock->date;
+        }
+      else
+        *lock = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_wc__db_read_prop(const svn_string_t **propval,
                      svn_wc__db_t *db,
@@ -4743,6 +5303,371 @@ svn_wc__db_read_children(const apr_array_header_t **children,
                          db, local_abspath, result_pool, scratch_pool);
 }
 
+svn_error_t *
+svn_wc__db_read_children_info(apr_hash_t **nodes,
+                              apr_hash_t **conflicts,
+                              svn_wc__db_t *db,
+                              const char *dir_abspath,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  svn_wc__db_pdh_t *pdh;
+  const char *dir_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  const char *tree_conflict_data;
+  apr_hash_t *repos_root_urls = apr_hash_make(scratch_pool);
+  apr_hash_t *subdirs = apr_hash_make(scratch_pool);
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(dir_abspath));
+
+  SVN_ERR(svn_wc__db_pdh_parse_local_abspath(&pdh, &dir_relpath, db,
+                                             dir_abspath,
+                                             svn_sqlite__mode_readonly,
+                                             scratch_pool, scratch_pool));
+  VERIFY_USABLE_PDH(pdh);
+
+  *nodes = apr_hash_make(result_pool);
+  *conflicts = apr_hash_make(result_pool);
+
+  /* The BASE nodes.  This mirrors svn_wc__db_read_info(). */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, pdh->wcroot->sdb,
+                                    STMT_SELECT_BASE_NODE_CHILDREN_INFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", pdh->wcroot->wc_id, dir_relpath));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      struct svn_wc__db_info_t *child = apr_pcalloc(result_pool,
+                                                    sizeof(*child));
+      const char *name = svn_relpath_basename(
+                           svn_sqlite__column_text(stmt, 0, NULL),
+                           result_pool);
+      svn_error_t *err = NULL;
+
+      child->kind = svn_sqlite__column_token(stmt, 4, kind_map);
+      child->status = svn_sqlite__column_token(stmt, 3, presence_map);
+      if (child->kind == svn_wc__db_kind_subdir
+          && child->status == svn_wc__db_status_normal)
+        child->status = svn_wc__db_status_obstructed;
+
+      child->revnum = svn_sqlite__column_revnum(stmt, 5);
+      child->repos_relpath = svn_sqlite__column_text(stmt, 2, result_pool);
+
+      if (!svn_sqlite__column_is_null(stmt, 1))
+        {
+          apr_int64_t repos_id = svn_sqlite__column_int64(stmt, 1);
+          const char *repos_root_url = apr_hash_get(repos_root_urls,
+                                                    &repos_id,
+                                                    sizeof(repos_id));
+
+          if (!repos_root_url)
+            {
+              apr_int64_t *key = apr_palloc(scratch_pool, sizeof(*key));
+
+              err = fetch_repos_info(&repos_root_url, NULL,
+                                     pdh->wcroot, repos_id,
+                                     result_pool);
+              if (err)
+                return svn_error_compose_create(err,
+                                                svn_sqlite__reset(stmt));
+
+              *key = repos_id;
+              apr_hash_set(repos_root_urls, key, sizeof(*key),
+                           repos_root_url);
+            }
+          child->repos_root_url = repos_root_url;
+        }
+
+      child->changed_rev = svn_sqlite__column_revnum(stmt, 6);
+      child->changed_date = svn_sqlite__column_int64(stmt, 7);
+      child->changed_author = svn_sqlite__column_text(stmt, 8, result_pool);
+      child->last_mod_time = svn_sqlite__column_int64(stmt, 15);
+      child->translated_size = get_translated_size(stmt, 14);
+
+      if (child->kind == svn_wc__db_kind_dir
+          || child->kind == svn_wc__db_kind_subdir)
+        {
+          const char *depth_str = svn_sqlite__column_text(stmt, 9, NULL);
+
+          child->depth = depth_str ? svn_depth_from_word(depth_str)
+                                   : svn_depth_unknown;
+        }
+      else
+        child->depth = svn_depth_unknown;
+
+      if (!svn_sqlite__column_is_null(stmt, 10))
+        {
+          child->lock = apr_pcalloc(result_pool, sizeof(*child->lock));
+          child->lock->token = svn_sqlite__column_text(stmt, 10,
+                                                       result_pool);
+          if (!svn_sqlite__column_is_null(stmt, 11))
+            child->lock->owner = svn_sqlite__column_text(stmt, 11,
+                                                         result_pool);
+          if (!svn_sqlite__column_is_null(stmt, 12))
+            child->lock->comment = svn_sqlite__column_text(stmt, 12,
+                                                           result_pool);
+          if (!svn_sqlite__column_is_null(stmt, 13))
+            child->lock->date = svn_sqlite__column_int64(stmt, 13);
+        }
+
+      apr_hash_set(*nodes, name, APR_HASH_KEY_STRING, child);
+      if (child->kind == svn_wc__db_kind_subdir)
+        apr_hash_set(subdirs, name, APR_HASH_KEY_STRING, name);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* The WORKING nodes, which override most of the BASE information. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, pdh->wcroot->sdb,
+                                    STMT_SELECT_WORKING_NODE_CHILDREN_INFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", pdh->wcroot->wc_id, dir_relpath));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const char *name = svn_relpath_basename(
+                           svn_sqlite__column_text(stmt, 0, NULL),
+                           scratch_pool);
+      struct svn_wc__db_info_t *child = apr_hash_get(*nodes, name,
+                                                     APR_HASH_KEY_STRING);
+      svn_wc__db_status_t work_status;
+
+      if (child)
+        child->base_shadowed = TRUE;
+      else
+        {
+          child = apr_pcalloc(result_pool, sizeof(*child));
+          name = apr_pstrdup(result_pool, name);
+          apr_hash_set(*nodes, name, APR_HASH_KEY_STRING, child);
+        }
+
+      child->kind = svn_sqlite__column_token(stmt, 2, kind_map);
+      if (child->kind == svn_wc__db_kind_subdir)
+        apr_hash_set(subdirs, name, APR_HASH_KEY_STRING, name);
+      else
+        apr_hash_set(subdirs, name, APR_HASH_KEY_STRING, NULL);
+
+      work_status = svn_sqlite__column_token(stmt, 1, presence_map);
+      if (work_status == svn_wc__db_status_incomplete)
+        child->status = svn_wc__db_status_incomplete;
+#ifdef SVN_EXPERIMENTAL_COPY
+      else if (work_status == svn_wc__db_status_excluded)
+        child->status = svn_wc__db_status_excluded;
+#endif
+      else if (work_status == svn_wc__db_status_not_present
+               || work_status == svn_wc__db_status_base_deleted)
+        child->status = (child->kind == svn_wc__db_kind_subdir)
+                          ? svn_wc__db_status_obstructed_delete
+                          : svn_wc__db_status_deleted;
+      else
+        child->status = (child->kind == svn_wc__db_kind_subdir)
+                          ? svn_wc__db_status_obstructed_add
+                          : svn_wc__db_status_added;
+
+      /* Our path is implied by our parent somewhere up the tree. */
+      child->revnum = SVN_INVALID_REVNUM;
+      child->repos_relpath = NULL;
+      child->repos_root_url = NULL;
+
+      child->changed_rev = svn_sqlite__column_revnum(stmt, 3);
+      child->changed_date = svn_sqlite__column_int64(stmt, 4);
+      child->changed_author = svn_sqlite__column_text(stmt, 5, result_pool);
+      child->last_mod_time = svn_sqlite__column_int64(stmt, 8);
+      child->translated_size = get_translated_size(stmt, 7);
+
+      if (child->kind == svn_wc__db_kind_dir
+          || child->kind == svn_wc__db_kind_subdir)
+        {
+          const char *depth_str = svn_sqlite__column_text(stmt, 6, NULL);
+
+          child->depth = depth_str ? svn_depth_from_word(depth_str)
+                                   : svn_depth_unknown;
+        }
+      else
+        child->depth = svn_depth_unknown;
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* The ACTUAL nodes. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, pdh->wcroot->sdb,
+                                    STMT_SELECT_ACTUAL_CHILDREN_INFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", pdh->wcroot->wc_id, dir_relpath));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const char *name = svn_relpath_basename(
+                           svn_sqlite__column_text(stmt, 0, NULL),
+                           result_pool);
+      struct svn_wc__db_info_t *child = apr_hash_get(*nodes, name,
+                                                     APR_HASH_KEY_STRING);
+      svn_boolean_t conflicted;
+
+      conflicted = !svn_sqlite__column_is_null(stmt, 1)   /* prop_reject */
+                   || !svn_sqlite__column_is_null(stmt, 3) /* old */
+                   || !svn_sqlite__column_is_null(stmt, 4) /* new */
+                   || !svn_sqlite__column_is_null(stmt, 5); /* working */
+
+      if (conflicted)
+        apr_hash_set(*conflicts, name, APR_HASH_KEY_STRING, name);
+
+      /* A row in ACTUAL_NODE without a BASE or WORKING node is corrupt;
+         svn_wc__db_read_info() will tell the caller if it asks. */
+      if (child)
+        {
+          child->changelist = svn_sqlite__column_text(stmt, 2, result_pool);
+          child->props_mod = !svn_sqlite__column_is_null(stmt, 6);
+          child->conflicted = conflicted;
+        }
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* And the tree conflicts, which are stored on the directory itself. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, pdh->wcroot->sdb,
+                                    STMT_SELECT_ACTUAL_TREE_CONFLICT));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", pdh->wcroot->wc_id, dir_relpath));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    tree_conflict_data = svn_sqlite__column_text(stmt, 0, scratch_pool);
+  else
+    tree_conflict_data = NULL;
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  if (tree_conflict_data)
+    {
+      apr_hash_t *conflict_items;
+
+      SVN_ERR(svn_wc__read_tree_conflicts(&conflict_items, tree_conflict_data,
+                                          dir_abspath, scratch_pool));
+
+      for (hi = apr_hash_first(scratch_pool, conflict_items);
+           hi;
+           hi = apr_hash_next(hi))
+        {
+          const char *name =
+              svn_dirent_basename(svn__apr_hash_index_key(hi), result_pool);
+          struct svn_wc__db_info_t *child = apr_hash_get(*nodes, name,
+                                                         APR_HASH_KEY_STRING);
+
+          apr_hash_set(*conflicts, name, APR_HASH_KEY_STRING, name);
+          if (child)
+            child->conflicted = TRUE;
+        }
+    }
+
+  /* The rows of subdirectories in this database are only stubs; unless
+     they are obstructed, svn_wc__db_read_info() looks at the
+     subdirectory's own database.  Do the same. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, subdirs); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = svn__apr_hash_index_key(hi);
+      struct svn_wc__db_info_t *child = apr_hash_get(*nodes, name,
+                                                     APR_HASH_KEY_STRING);
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_wc__db_read_info(&child->status, &child->kind,
+                                   &child->revnum, &child->repos_relpath,
+                                   &child->repos_root_url, NULL,
+                                   &child->changed_rev, &child->changed_date,
+                                   &child->changed_author,
+                                   &child->last_mod_time,
+                                   &child->depth, NULL,
+                                   &child->translated_size, NULL,
+                                   &child->changelist, NULL, NULL, NULL,
+                                   NULL, NULL, &child->props_mod,
+                                   &child->base_shadowed,
+                                   &child->conflicted, &child->lock,
+                                   db, svn_dirent_join(dir_abspath, name,
+                                                       iterpool),
+                                   result_pool, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Like svn_wc__db_read_info(), never show the stub kind. */
+  for (hi = apr_hash_first(scratch_pool, *nodes); hi; hi = apr_hash_next(hi))
+    {
+      struct svn_wc__db_info_t *child = svn__apr_hash_index_val(hi);
+
+      if (child->kind == svn_wc__db_kind_subdir)
+        child->kind = svn_wc__db_kind_dir;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_read_children_changelists(apr_hash_t **changelists,
+                                     const apr_array_header_t **subdirs,
+                                     svn_wc__db_t *db,
+                                     const char *dir_abspath,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  svn_wc__db_pdh_t *pdh;
+  const char *dir_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_array_header_t *dirs;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(dir_abspath));
+
+  SVN_ERR(svn_wc__db_pdh_parse_local_abspath(&pdh, &dir_relpath, db,
+                                             dir_abspath,
+                                             svn_sqlite__mode_readonly,
+                                             scratch_pool, scratch_pool));
+  VERIFY_USABLE_PDH(pdh);
+
+  *changelists = apr_hash_make(result_pool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, pdh->wcroot->sdb,
+                                    STMT_SELECT_ACTUAL_CHILDREN_CHANGELIST));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", pdh->wcroot->wc_id, dir_relpath));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const char *name = svn_relpath_basename(
+                           svn_sqlite__column_text(stmt, 0, NULL),
+                           result_pool);
+
+      apr_hash_set(*changelists, name, APR_HASH_KEY_STRING,
+                   svn_sqlite__column_text(stmt, 1, result_pool));
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  if (subdirs)
+    {
+      dirs = apr_array_make(result_pool, 4, sizeof(const char *));
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, pdh->wcroot->sdb,
+                                        STMT_SELECT_CHILD_DIRECTORIES));
+      SVN_ERR(svn_sqlite__bindf(stmt, "is", pdh->wcroot->wc_id,
+                                dir_relpath));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      while (have_row)
+        {
+          APR_ARRAY_PUSH(dirs, const char *) = svn_relpath_basename(
+                           svn_sqlite__column_text(stmt, 0, NULL),
+                           result_pool);
+
+          SVN_ERR(svn_sqlite__step(&have_row, stmt));
+        }
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      *subdirs = dirs;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 struct relocate_baton
 {
   apr_int64_t wc_id;
@@ -4859,7 +5784,7 @@ svn_wc__db_global_relocate(svn_wc__db_t *db,
       rb.repos_relpath = svn_sqlite__column_text(stmt, 1, scratch_pool);
       SVN_ERR(svn_sqlite__reset(stmt));
 
-      SVN_ERR(fetch_repos_info(NULL, &rb.repos_uuid, pdh->wcroot->sdb,
+      SVN_ERR(fetch_repos_info(NULL, &rb.repos_uuid, pdh->wcroot,
                                rb.old_repos_id, scratch_pool));
     }
   else
@@ -5559,7 +6484,7 @@ svn_wc__db_scan_base_repos(const char **repos_relpath,
                                  result_pool, scratch_pool));
 
   if (repos_root_url || repos_uuid)
-    return fetch_repos_info(repos_root_url, repos_uuid, pdh->wcroot->sdb,
+    return fetch_repos_info(repos_root_url, repos_uuid, pdh->wcroot,
                             repos_id, result_pool);
 
   return SVN_NO_ERROR;
@@ -5705,7 +6630,7 @@ svn_wc__db_scan_addition(svn_wc__db_status_t *status,
                                                               result_pool);
           if (original_root_url || original_uuid)
             SVN_ERR(fetch_repos_info(original_root_url, original_uuid,
-                                     pdh->wcroot->sdb,
+                                     pdh->wcroot,
                                      svn_sqlite__column_int64(stmt, 9),
                                      result_pool));
           if (original_revision)
@@ -6000,7 +6925,7 @@ svn_wc__db_upgrade_begin(svn_sqlite__db_t **sdb,
      ### SDB_FILE as we perform the upgrade.  */
   return svn_error_return(create_db(sdb, repos_id, wc_id, dir_abspath,
                                     repos_root_url, repos_uuid,
-                                    SDB_FILE,
+                                    SDB_FILE, NULL,
                                     result_pool, scratch_pool));
 }
 
@@ -6246,15 +7171,50 @@ svn_wc__db_wq_fetch(apr_uint64_t *id,
                     const char *wri_abspath,
                     apr_pool_t *result_pool,
                     apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *ids;
+  apr_array_header_t *work_items;
+
+  SVN_ERR_ASSERT(id != NULL);
+  SVN_ERR_ASSERT(work_item != NULL);
+
+  SVN_ERR(svn_wc__db_wq_fetch_batch(&ids, &work_items, db, wri_abspath, 1,
+                                    result_pool, scratch_pool));
+
+  if (work_items->nelts == 0)
+    {
+      *id = 0;
+      *work_item = NULL;
+    }
+  else
+    {
+      *id = APR_ARRAY_IDX(ids, 0, apr_uint64_t);
+      *work_item = APR_ARRAY_IDX(work_items, 0, svn_skel_t *);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__db_wq_fetch_batch(apr_array_header_t **ids,
+                          apr_array_header_t **work_items,
+                          svn_wc__db_t *db,
+                          const char *wri_abspath,
+                          int max_items,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
 {
   svn_wc__db_pdh_t *pdh;
   const char *local_relpath;
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
 
-  SVN_ERR_ASSERT(id != NULL);
-  SVN_ERR_ASSERT(work_item != NULL);
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+  SVN_ERR_ASSERT(max_items > 0);
+
+  *ids = apr_array_make(result_pool, max_items, sizeof(apr_uint64_t));
+  *work_items = apr_array_make(result_pool, max_items, sizeof(svn_skel_t *));
 
   SVN_ERR(svn_wc__db_pdh_parse_local_abspath(&pdh, &local_relpath, db,
                               wri_abspath, svn_sqlite__mode_readonly,
@@ -6273,32 +7233,29 @@ svn_wc__db_wq_fetch(apr_uint64_t *id,
           /* This node is a directory which is not on disk (since
              LOCAL_RELPATH is specifying the stub). Therefore, it
              has no items in the work queue.  */
-          *id = 0;
-          *work_item = NULL;
           return SVN_NO_ERROR;
         }
     }
 #endif
 
   SVN_ERR(svn_sqlite__get_statement(&stmt, pdh->wcroot->sdb,
-                                    STMT_SELECT_WORK_ITEM));
+                                    STMT_SELECT_WORK_ITEMS));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, max_items));
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
 
-  if (!have_row)
-    {
-      *id = 0;
-      *work_item = NULL;
-    }
-  else
+  while (have_row)
     {
       apr_size_t len;
       const void *val;
 
-      *id = svn_sqlite__column_int64(stmt, 0);
+      APR_ARRAY_PUSH(*ids, apr_uint64_t) = svn_sqlite__column_int64(stmt, 0);
 
       val = svn_sqlite__column_blob(stmt, 1, &len, result_pool);
 
-      *work_item = svn_skel__parse(val, len, result_pool);
+      APR_ARRAY_PUSH(*work_items, svn_skel_t *)
+        = svn_skel__parse(val, len, result_pool);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
     }
 
   return svn_error_return(svn_sqlite__reset(stmt));
@@ -6348,6 +7305,46 @@ svn_wc__db_wq_completed(svn_wc__db_t *db,
 }
 
 
+svn_error_t *
+svn_wc__db_wq_completed_upto(svn_wc__db_t *db,
+                             const char *wri_abspath,
+                             apr_uint64_t last_id,
+                             apr_pool_t *scratch_pool)
+{
+  svn_wc__db_pdh_t *pdh;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+  SVN_ERR_ASSERT(last_id != 0);
+
+  SVN_ERR(svn_wc__db_pdh_parse_local_abspath(&pdh, &local_relpath, db,
+                              wri_abspath, svn_sqlite__mode_readwrite,
+                              scratch_pool, scratch_pool));
+  VERIFY_USABLE_PDH(pdh);
+
+#ifndef SINGLE_DB
+  if (*local_relpath != '\0')
+    {
+      svn_wc__db_kind_t kind;
+
+      SVN_ERR(svn_wc__db_read_kind(&kind, db, wri_abspath, TRUE,
+                                   scratch_pool));
+      if (kind == svn_wc__db_kind_dir)
+        {
+          /* See svn_wc__db_wq_completed().  */
+          return SVN_NO_ERROR;
+        }
+    }
+#endif
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, pdh->wcroot->sdb,
+                                    STMT_DELETE_WORK_ITEMS_UPTO));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, last_id));
+  return svn_error_return(svn_sqlite__step_done(stmt));
+}
+
+
 /* ### temporary API. remove before release.  */
 svn_error_t *
 svn_wc__db_temp_get_format(int *format,
@@ -7893,7 +8890,7 @@ svn_wc__db_temp_elide_copyfrom(svn_wc__db_t *db,
   /* Everything matches up. Grab the details for ORIGINAL_REPOS_ID and
      compare to the parent.  */
   SVN_ERR(fetch_repos_info(NULL, &original_uuid,
-                           pdh->wcroot->sdb, original_repos_id,
+                           pdh->wcroot, original_repos_id,
                            scratch_pool));
   if (strcmp(original_uuid, parent_uuid) != 0)
     return SVN_NO_ERROR;
@@ -413,6 +413,27 @@ svn_wc__db_from_relpath(const char **local_abspath,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool);
 
+
+/* Callback for svn_wc__db_with_transaction(). */
+typedef svn_error_t *(*svn_wc__db_txn_callback_t)(void *baton,
+                                                  apr_pool_t *scratch_pool);
+
+/* Call CB_FUNC with CB_BATON and SCRATCH_POOL inside a single transaction
+   on the database holding the metadata of LOCAL_ABSPATH.
+
+   The changes CB_FUNC makes to that database through DB are committed
+   together when it returns, which is much cheaper than committing each
+   of them on its own, or are all rolled back if it returns an error.
+
+   ### with one database per directory, changes CB_FUNC makes to other
+   ### directories' databases are not part of the transaction.  */
+svn_error_t *
+svn_wc__db_with_transaction(svn_wc__db_t *db,
+                            const char *local_abspath,
+                            svn_wc__db_txn_callback_t cb_func,
+                            void *cb_baton,
+                            apr_pool_t *scratch_pool);
+
 /* @} */
 
 /* Different kinds of trees
@@ -767,6 +788,40 @@ svn_wc__db_base_get_children(const apr_array_header_t **children,
                              apr_pool_t *scratch_pool);
 
 
+/* Information about a BASE node, as returned for each child by
+   svn_wc__db_base_get_children_info().  The members have the same
+   meaning as the identically named arguments of
+   svn_wc__db_base_get_info(). */
+struct svn_wc__db_base_info_t {
+  svn_wc__db_status_t status;
+  svn_wc__db_kind_t kind;
+  svn_revnum_t revnum;
+  const char *repos_relpath;
+  const char *repos_root_url;
+  svn_depth_t depth;
+  svn_wc__db_lock_t *lock;
+};
+
+/* Set *NODES to a hash mapping the basenames of the BASE children of
+   DIR_ABSPATH in DB to struct svn_wc__db_base_info_t * values, holding
+   what svn_wc__db_base_get_info() would return for each of them.
+
+   Unlike calling svn_wc__db_base_get_info() for every child, this reads
+   the BASE rows of all file children with one query.  Subdirectories are
+   still read from their own database.  A subdirectory that has no BASE
+   node of its own (it was not-present and has been added back) is
+   returned with status svn_wc__db_status_not_present.
+
+   Allocate *NODES in RESULT_POOL and do temporary allocations in
+   SCRATCH_POOL. */
+svn_error_t *
+svn_wc__db_base_get_children_info(apr_hash_t **nodes,
+                                  svn_wc__db_t *db,
+                                  const char *dir_abspath,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
+
 /* Set the dav cache for LOCAL_ABSPATH to PROPS.  Use SCRATCH_POOL for
    temporary allocations. */
 svn_error_t *
@@ -776,6 +831,16 @@ svn_wc__db_base_set_dav_cache(svn_wc__db_t *db,
                               apr_pool_t *scratch_pool);
 
 
+/* Clear the dav cache of LOCAL_ABSPATH and of all BASE nodes below it
+   that are stored in the same database, using a single statement rather
+   than one update per node.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_wc__db_base_clear_dav_cache_recursive(svn_wc__db_t *db,
+                                          const char *local_abspath,
+                                          apr_pool_t *scratch_pool);
+
+
 /* Retrieve the dav cache for LOCAL_ABSPATH into *PROPS, allocated in
    RESULT_POOL.  Use SCRATCH_POOL for temporary allocations.  Return
    SVN_ERR_WC_PATH_NOT_FOUND if no dav cache can be located for
@@ -1549,6 +1614,70 @@ svn_wc__db_read_children(const apr_array_header_t **children,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
+/* Information about a node, as returned for each child by
+   svn_wc__db_read_children_info().  The members have the same meaning
+   as the identically named arguments of svn_wc__db_read_info(). */
+struct svn_wc__db_info_t {
+  svn_wc__db_status_t status;
+  svn_wc__db_kind_t kind;
+  svn_revnum_t revnum;
+  const char *repos_relpath;
+  const char *repos_root_url;
+  svn_revnum_t changed_rev;
+  const char *changed_author;
+  apr_time_t changed_date;
+  apr_time_t last_mod_time;
+  svn_depth_t depth;
+  svn_filesize_t translated_size;
+  const char *changelist;
+  svn_boolean_t props_mod;
+  svn_boolean_t base_shadowed;
+  svn_boolean_t conflicted;
+  svn_wc__db_lock_t *lock;
+};
+
+/* Set *NODES to a hash mapping the basenames of the immediate children
+   of DIR_ABSPATH in DB to struct svn_wc__db_info_t * values, holding
+   what svn_wc__db_read_info() would return for each of them.
+
+   Set *CONFLICTS to a hash whose keys are the basenames of the conflict
+   victims among the children, as svn_wc__db_read_conflict_victims()
+   would return them.
+
+   Unlike calling svn_wc__db_read_info() for every child, this reads the
+   BASE, WORKING and ACTUAL rows of all children with one query each.
+
+   Allocate *NODES and *CONFLICTS in RESULT_POOL and do temporary
+   allocations in SCRATCH_POOL. */
+svn_error_t *
+svn_wc__db_read_children_info(apr_hash_t **nodes,
+                              apr_hash_t **conflicts,
+                              svn_wc__db_t *db,
+                              const char *dir_abspath,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+/* Set *CHANGELISTS to a hash mapping the basenames of those immediate
+   children of DIR_ABSPATH in DB which are in a changelist to the name of
+   that changelist.  If SUBDIRS is not NULL, set *SUBDIRS to an array of
+   the basenames of the child directories of DIR_ABSPATH which are not
+   hidden, the ones svn_wc__node_walk_children() would descend into.
+
+   Unlike svn_wc__db_read_children_info(), this only reads the ACTUAL
+   rows that have a changelist, using the ACTUAL_NODE parent index, so
+   its cost depends on the number of changelist members rather than on
+   the number of files in DIR_ABSPATH.
+
+   Allocate *CHANGELISTS and *SUBDIRS in RESULT_POOL and do temporary
+   allocations in SCRATCH_POOL. */
+svn_error_t *
+svn_wc__db_read_children_changelists(apr_hash_t **changelists,
+                                     const apr_array_header_t **subdirs,
+                                     svn_wc__db_t *db,
+                                     const char *dir_abspath,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
+
 /* Read into *VICTIMS the basenames of the immediate children of
    LOCAL_ABSPATH in DB that are conflicted.
 
@@ -2104,6 +2233,24 @@ svn_wc__db_wq_fetch(apr_uint64_t *id,
                     apr_pool_t *scratch_pool);
 
 
+/* Like svn_wc__db_wq_fetch(), but fetch up to MAX_ITEMS work items at
+   once. The identifiers are returned in *IDS, an array of apr_uint64_t,
+   and the data in *WORK_ITEMS, an array of svn_skel_t *, both in the order
+   the items were queued. If there are no work items to be completed, both
+   arrays are empty.
+
+   RESULT_POOL will be used to allocate the arrays and work items, and
+   SCRATCH_POOL will be used for all temporary allocations.  */
+svn_error_t *
+svn_wc__db_wq_fetch_batch(apr_array_header_t **ids,
+                          apr_array_header_t **work_items,
+                          svn_wc__db_t *db,
+                          const char *wri_abspath,
+                          int max_items,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+
 /* In the WCROOT associated with DB and WRI_ABSPATH, mark work item ID as
    completed. If an error occurs, then it is unknown whether the work item
    has been marked as completed.
@@ -2115,6 +2262,21 @@ svn_wc__db_wq_completed(svn_wc__db_t *db,
                         apr_uint64_t id,
                         apr_pool_t *scratch_pool);
 
+
+/* Like svn_wc__db_wq_completed(), but mark all work items up to and
+   including LAST_ID as completed, in a single database transaction.
+
+   Since work items are fetched in the order they were queued, this is
+   the way to record that the items fetched by svn_wc__db_wq_fetch_batch()
+   have been completed, up to and including LAST_ID.
+
+   Uses SCRATCH_POOL for all temporary allocations.  */
+svn_error_t *
+svn_wc__db_wq_completed_upto(svn_wc__db_t *db,
+                             const char *wri_abspath,
+                             apr_uint64_t last_id,
+                             apr_pool_t *scratch_pool);
+
 /* @} */
 
 
@@ -26,6 +26,7 @@
 #include <assert.h>
 
 #include "svn_dirent_uri.h"
+#include "svn_pools.h"
 
 #include "wc.h"
 #include "adm_files.h"
@@ -221,6 +222,21 @@ svn_wc__db_open(svn_wc__db_t **db,
   (*db)->dir_data = apr_hash_make(result_pool);
   (*db)->state_pool = result_pool;
 
+  SVN_ERR(svn_sqlite__read_tuning(&(*db)->sqlite_tuning, config,
+                                  SVN_CONFIG_SECTION_WORKING_COPY));
+
+  {
+    const char *shared_dir;
+
+    svn_config_get(config, &shared_dir, SVN_CONFIG_SECTION_WORKING_COPY,
+                   SVN_CONFIG_OPTION_SHARED_PRISTINE_DIR, NULL);
+    if (shared_dir && *shared_dir)
+      SVN_ERR(svn_dirent_get_absolute(&(*db)->shared_pristine_abspath,
+                                      svn_dirent_internal_style(shared_dir,
+                                                                scratch_pool),
+                                      result_pool));
+  }
+
   return SVN_NO_ERROR;
 }
 
@@ -315,6 +331,10 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
   (*wcroot)->sdb = sdb;
   (*wcroot)->wc_id = wc_id;
   (*wcroot)->format = format;
+  (*wcroot)->repos_cache = apr_hash_make(result_pool);
+  (*wcroot)->node_cache_pool = svn_pool_create(result_pool);
+  (*wcroot)->node_cache = apr_hash_make((*wcroot)->node_cache_pool);
+  (*wcroot)->node_cache_generation = -1;
 
   /* SDB will be NULL for pre-NG working copies. We only need to run a
      cleanup when the SDB is present.  */
@@ -492,6 +512,7 @@ svn_wc__db_pdh_parse_local_abspath(svn_wc__db_pdh_t **pdh,
       svn_error_t *err;
 
       err = svn_wc__db_util_open_db(&sdb, local_abspath, SDB_FILE, smode,
+                                    &db->sqlite_tuning,
                                     db->state_pool, scratch_pool);
       if (err == NULL)
         break;
@@ -633,6 +654,7 @@ svn_wc__db_pdh_parse_local_abspath(svn_wc__db_pdh_t **pdh,
         {
           svn_error_t *err = svn_wc__db_util_open_db(&sdb, parent_dir,
                                                      SDB_FILE, smode,
+                                                     &db->sqlite_tuning,
                                                      db->state_pool,
                                                      scratch_pool);
           if (err)
@@ -41,6 +41,13 @@ struct svn_wc__db_t {
      to figure out where we should look for the corresponding datastore. */
   svn_config_t *config;
 
+  /* The SQLite settings from CONFIG, applied to each wc.db we open.  */
+  svn_sqlite__tuning_t sqlite_tuning;
+
+  /* The pristine store shared between working copies, as configured in
+     CONFIG, or NULL.  */
+  const char *shared_pristine_abspath;
+
   /* Should we attempt to automatically upgrade the database when it is
      opened, and found to be not-current?  */
   svn_boolean_t auto_upgrade;
@@ -75,6 +82,20 @@ typedef struct {
      format has not (yet) been determined, this will be UNKNOWN_FORMAT.  */
   int format;
 
+  /* The rows of the REPOSITORY table read so far, mapping an apr_int64_t
+     repos_id to a const char *[2] holding the root URL and the UUID.
+     These rows are never changed once written.  */
+  apr_hash_t *repos_cache;
+
+  /* The results of svn_wc__db_read_info() for nodes in this wcroot,
+     mapping a const char *local_relpath to the cached information, all
+     allocated in NODE_CACHE_POOL.  The cache is only valid as long as
+     svn_sqlite__changes_generation() of SDB still returns
+     NODE_CACHE_GENERATION.  */
+  apr_hash_t *node_cache;
+  apr_int64_t node_cache_generation;
+  apr_pool_t *node_cache_pool;
+
 } svn_wc__db_wcroot_t;
 
 /**  Pristine Directory Handle
@@ -167,12 +188,14 @@ svn_wc__db_util_fetch_wc_id(apr_int64_t *wc_id,
                             svn_sqlite__db_t *sdb,
                             apr_pool_t *scratch_pool);
 
-/* */
+/* Open the database SDB_FNAME in the administrative area of DIR_ABSPATH
+   in *SDB, applying TUNING (which may be NULL) to it.  */
 svn_error_t *
 svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
                         const char *dir_abspath,
                         const char *sdb_fname,
                         svn_sqlite__mode_t smode,
+                        const svn_sqlite__tuning_t *tuning,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool);
 
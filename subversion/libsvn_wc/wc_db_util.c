@@ -80,6 +80,7 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
                         const char *dir_abspath,
                         const char *sdb_fname,
                         svn_sqlite__mode_t smode,
+                        const svn_sqlite__tuning_t *tuning,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool)
 {
@@ -88,6 +89,6 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
 
   return svn_error_return(svn_sqlite__open(sdb, sdb_abspath,
                                            smode, statements,
-                                           0, NULL,
+                                           0, NULL, tuning,
                                            result_pool, scratch_pool));
 }
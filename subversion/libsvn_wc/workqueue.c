@@ -1873,6 +1873,7 @@ run_file_install(svn_wc__db_t *db,
   svn_boolean_t use_commit_times;
   svn_boolean_t record_fileinfo;
   svn_boolean_t special;
+  const char *source_abspath;
   svn_stream_t *src_stream;
   svn_subst_eol_style_t style;
   const char *eol;
@@ -1888,23 +1889,23 @@ run_file_install(svn_wc__db_t *db,
   if (arg4 == NULL)
     {
       /* Get the pristine contents (from WORKING or BASE, as appropriate).  */
-      SVN_ERR(svn_wc__get_pristine_contents(&src_stream, db, local_abspath,
-                                            scratch_pool, scratch_pool));
-      SVN_ERR_ASSERT(src_stream != NULL);
+      SVN_ERR(svn_wc__get_pristine_contents_path(&source_abspath, db,
+                                                 local_abspath,
+                                                 scratch_pool, scratch_pool));
+      SVN_ERR_ASSERT(source_abspath != NULL);
     }
   else
     {
-      const char *source_abspath;
-
       /* Use the provided path for the source.  */
       source_abspath = apr_pstrmemdup(scratch_pool, arg4->data, arg4->len);
-      SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
-                                       scratch_pool, scratch_pool));
     }
 
   SVN_ERR(svn_wc__get_special(&special, db, local_abspath, scratch_pool));
   if (special)
     {
+      SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
+                                       scratch_pool, scratch_pool));
+
       /* When this stream is closed, the resulting special file will
          atomically be created/moved into place at LOCAL_ABSPATH.  */
       SVN_ERR(svn_subst_create_specialfile(&dst_stream, local_abspath,
@@ -1926,42 +1927,55 @@ run_file_install(svn_wc__db_t *db,
   SVN_ERR(svn_wc__get_keywords(&keywords, db, local_abspath, NULL,
                                scratch_pool, scratch_pool));
 
-  if (svn_subst_translation_required(style, eol, keywords,
-                                     FALSE /* special */,
-                                     TRUE /* force_eol_check */))
+  if (! svn_subst_translation_required(style, eol, keywords,
+                                       FALSE /* special */,
+                                       TRUE /* force_eol_check */))
+    {
+      /* The working file is identical to the source. Copy the file as a
+         whole, which shares its blocks with the pristine text on file
+         systems that support copy-on-write clones. This also goes through
+         a temporary file and a rename.  */
+      SVN_ERR(svn_io_copy_file(source_abspath, local_abspath,
+                               FALSE /* copy_perms */, scratch_pool));
+    }
+  else
     {
       /* Wrap it in a translating (expanding) stream.  */
+      SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
+                                       scratch_pool, scratch_pool));
       src_stream = svn_subst_stream_translated(src_stream, eol,
                                                TRUE /* repair */,
                                                keywords,
                                                TRUE /* expand */,
                                                scratch_pool);
-    }
 
-  /* Where is the Right Place to put a temp file in this working copy?  */
-  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath,
-                                         db, local_abspath,
-                                         scratch_pool, scratch_pool));
+      /* Where is the Right Place to put a temp file in this working
+         copy?  */
+      SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath,
+                                             db, local_abspath,
+                                             scratch_pool, scratch_pool));
 
-  /* Translate to a temporary file. We don't want the user seeing a partial
-     file, nor let them muck with it while we translate. We may also need to
-     get its TRANSLATED_SIZE before the user can monkey it.  */
-  SVN_ERR(svn_stream_open_unique(&dst_stream, &dst_abspath,
-                                 temp_dir_abspath,
-                                 svn_io_file_del_none,
-                                 scratch_pool, scratch_pool));
+      /* Translate to a temporary file. We don't want the user seeing a
+         partial file, nor let them muck with it while we translate. We
+         may also need to get its TRANSLATED_SIZE before the user can
+         monkey it.  */
+      SVN_ERR(svn_stream_open_unique(&dst_stream, &dst_abspath,
+                                     temp_dir_abspath,
+                                     svn_io_file_del_none,
+                                     scratch_pool, scratch_pool));
 
-  /* Copy from the source to the dest, translating as we go. This will also
-     close both streams.  */
-  SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
-                           cancel_func, cancel_baton,
-                           scratch_pool));
+      /* Copy from the source to the dest, translating as we go. This will
+         also close both streams.  */
+      SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
+                               cancel_func, cancel_baton,
+                               scratch_pool));
 
-  /* ### post-commit feature: avoid overwrite if same as working file.  */
+      /* ### post-commit feature: avoid overwrite if same as working file.  */
 
-  /* All done. Move the file into place.  */
-  /* ### fix this. we should delay the rename.  */
-  SVN_ERR(svn_io_file_rename(dst_abspath, local_abspath, scratch_pool));
+      /* All done. Move the file into place.  */
+      /* ### fix this. we should delay the rename.  */
+      SVN_ERR(svn_io_file_rename(dst_abspath, local_abspath, scratch_pool));
+    }
 
   /* Tweak the on-disk file according to its properties.  */
   SVN_ERR(sync_file_flags(db, local_abspath, scratch_pool));
@@ -2371,6 +2385,26 @@ dispatch_work_item(svn_wc__db_t *db,
 }
 
 
+/* The number of work items svn_wc__wq_run() fetches at once.  */
+#define WQ_BATCH_SIZE 64
+
+/* Return TRUE if WORK_ITEM only works on a single node and leaves the
+   administrative area alone, so that the items following it in the same
+   queue can be run without looking at the queue again. Returning FALSE
+   is always safe.  */
+static svn_boolean_t
+is_batchable(const svn_skel_t *work_item)
+{
+  return (svn_skel__matches_atom(work_item->children, OP_FILE_INSTALL)
+          || svn_skel__matches_atom(work_item->children, OP_FILE_REMOVE)
+          || svn_skel__matches_atom(work_item->children, OP_SYNC_FILE_FLAGS)
+          || svn_skel__matches_atom(work_item->children, OP_RECORD_FILEINFO)
+          || svn_skel__matches_atom(work_item->children, OP_PREJ_INSTALL)
+          || svn_skel__matches_atom(work_item->children,
+                                    OP_WRITE_OLD_PROPS));
+}
+
+
 svn_error_t *
 svn_wc__wq_run(svn_wc__db_t *db,
                const char *wri_abspath,
@@ -2379,6 +2413,7 @@ svn_wc__wq_run(svn_wc__db_t *db,
                apr_pool_t *scratch_pool)
 {
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *itempool = svn_pool_create(scratch_pool);
 
 #ifdef DEBUG_WORK_QUEUE
   SVN_DBG(("wq_run: wri='%s'\n", wri_abspath));
@@ -2387,8 +2422,11 @@ svn_wc__wq_run(svn_wc__db_t *db,
   while (TRUE)
     {
       svn_wc__db_kind_t kind;
-      apr_uint64_t id;
-      svn_skel_t *work_item;
+      apr_array_header_t *ids;
+      apr_array_header_t *work_items;
+      apr_uint64_t last_id = 0;
+      svn_error_t *err = SVN_NO_ERROR;
+      int i;
 
       /* Stop work queue processing, if requested. A future 'svn cleanup'
          should be able to continue the processing.  */
@@ -2405,18 +2443,48 @@ svn_wc__wq_run(svn_wc__db_t *db,
       if (kind == svn_wc__db_kind_unknown)
         break;
 
-      SVN_ERR(svn_wc__db_wq_fetch(&id, &work_item, db, wri_abspath,
-                                  iterpool, iterpool));
-      if (work_item == NULL)
+      SVN_ERR(svn_wc__db_wq_fetch_batch(&ids, &work_items, db, wri_abspath,
+                                        WQ_BATCH_SIZE, iterpool, iterpool));
+      if (work_items->nelts == 0)
         break;
 
-      SVN_ERR(dispatch_work_item(db, wri_abspath, work_item,
-                                 cancel_func, cancel_baton, iterpool));
+      /* Run the items in the order they were queued, so that items on the
+         same node still see each other's effects. Stop after an item that
+         may change the administrative area, since the items following it
+         may no longer be valid; we will fetch them again.  */
+      for (i = 0; i < work_items->nelts; i++)
+        {
+          const svn_skel_t *work_item = APR_ARRAY_IDX(work_items, i,
+                                                      const svn_skel_t *);
+
+          svn_pool_clear(itempool);
+
+          if (cancel_func && i > 0)
+            err = cancel_func(cancel_baton);
+
+          if (!err)
+            err = dispatch_work_item(db, wri_abspath, work_item,
+                                     cancel_func, cancel_baton, itempool);
+          if (err)
+            break;
+
+          last_id = APR_ARRAY_IDX(ids, i, apr_uint64_t);
+
+          if (!is_batchable(work_item))
+            break;
+        }
 
-      /* The work item finished without error. Mark it completed.  */
-      SVN_ERR(svn_wc__db_wq_completed(db, wri_abspath, id, iterpool));
+      /* Mark the items that finished without error completed, in a single
+         transaction, even if a later one failed.  */
+      if (last_id != 0)
+        err = svn_error_compose_create(
+                err,
+                svn_wc__db_wq_completed_upto(db, wri_abspath, last_id,
+                                             iterpool));
+      SVN_ERR(err);
     }
 
+  svn_pool_destroy(itempool);
   svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
 }
@@ -565,6 +565,50 @@ subreq_bypass(request_rec *r,
   return OK;
 }
 
+/*
+ * This function is used as a provider to let mod_dav_svn, when it
+ * bypasses the generation of apache requests, find out whether it can
+ * skip checking the paths beneath REPOS_PATH one by one.  Return OK if
+ * REPOS_PATH and everything beneath it is readable.  As that is only an
+ * optimization, no verdict is logged.
+ */
+static int
+subtree_readable(request_rec *r,
+                 const char *repos_path,
+                 const char *repos_name)
+{
+  svn_error_t *svn_err;
+  svn_authz_t *access_conf;
+  authz_svn_config_rec *conf;
+  svn_boolean_t authz_access_granted = FALSE;
+
+  conf = ap_get_module_config(r->per_dir_config,
+                              &authz_svn_module);
+
+  if (!conf->anonymous || !conf->access_file)
+    return HTTP_FORBIDDEN;
+
+  access_conf = get_access_conf(r, conf);
+  if (access_conf == NULL)
+    return HTTP_FORBIDDEN;
+
+  svn_err = svn_repos_authz_check_access(access_conf, repos_name,
+                                         repos_path,
+                                         get_username_to_authorize(r, conf),
+                                         svn_authz_read | svn_authz_recursive,
+                                         &authz_access_granted,
+                                         r->pool);
+  if (svn_err)
+    {
+      /* The paths will be checked one by one, and the error show up
+         there. */
+      svn_error_clear(svn_err);
+      return HTTP_FORBIDDEN;
+    }
+
+  return authz_access_granted ? OK : HTTP_FORBIDDEN;
+}
+
 /*
  * Hooks
  */
@@ -713,6 +757,11 @@ register_hooks(apr_pool_t *p)
                        AUTHZ_SVN__SUBREQ_BYPASS_PROV_NAME,
                        AUTHZ_SVN__SUBREQ_BYPASS_PROV_VER,
                        (void*)subreq_bypass);
+  ap_register_provider(p,
+                       AUTHZ_SVN__SUBTREE_READABLE_PROV_GRP,
+                       AUTHZ_SVN__SUBTREE_READABLE_PROV_NAME,
+                       AUTHZ_SVN__SUBTREE_READABLE_PROV_VER,
+                       (void*)subtree_readable);
 }
 
 module AP_MODULE_DECLARE_DATA authz_svn_module =
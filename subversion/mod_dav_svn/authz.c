@@ -49,6 +49,7 @@ allow_read(request_rec *r,
   enum dav_svn__build_what uri_type;
   svn_boolean_t allowed = FALSE;
   authz_svn__subreq_bypass_func_t allow_read_bypass = NULL;
+  dav_svn__request_stats_t *stats;
 
   /* Easy out:  if the admin has explicitly set 'SVNPathAuthz Off',
      then this whole callback does nothing. */
@@ -57,6 +58,10 @@ allow_read(request_rec *r,
       return TRUE;
     }
 
+  stats = dav_svn__get_request_stats(r);
+  if (stats)
+    stats->authz_checks++;
+
   /* If bypass is specified and authz has exported the provider.
      Otherwise, we fall through to the full version.  This should be
      safer than allowing or disallowing all accesses if there is a
@@ -185,15 +190,110 @@ authz_read(svn_boolean_t *allowed,
 svn_repos_authz_func_t
 dav_svn__authz_read_func(dav_svn__authz_read_baton *baton)
 {
+  authz_svn__subtree_readable_func_t subtree_readable;
+
   /* Easy out: If the admin has explicitly set 'SVNPathAuthz Off',
      then we don't need to do any authorization checks. */
   if (! dav_svn__get_pathauthz_flag(baton->r))
     return NULL;
 
+  /* Neither do we if the user may read the whole repository, which
+     saves the callers checking every path they touch.  Only when we
+     bypass the apache subrequests is mod_authz_svn the only module to
+     ask, and can it tell us that. */
+  subtree_readable = dav_svn__get_pathauthz_subtree_readable(baton->r);
+  if (subtree_readable != NULL
+      && subtree_readable(baton->r, "/", baton->repos->repo_name) == OK)
+    return NULL;
+
   return authz_read;
 }
 
 
+/* This function implements 'svn_repos_authz_callback_t', for the
+   commit editor of batched commits.
+
+   Ask the authz modules loaded into apache whether the REQUIRED access
+   to PATH in ROOT is allowed, by performing a subrequest against the
+   public URI of PATH: a DELETE for recursive write access, a PUT for
+   write access, and a GET, as allow_read() does, for read access.  Set
+   *ALLOWED to TRUE if the subrequest succeeds, FALSE otherwise.
+
+   Recursive read access, which copy sources need, is only checked for
+   PATH itself unless mod_authz_svn can tell us about the whole subtree.
+
+   BATON must be a pointer to a dav_svn__authz_read_baton.
+   Use POOL for for any temporary allocation.
+*/
+static svn_error_t *
+authz_commit(svn_repos_authz_access_t required,
+             svn_boolean_t *allowed,
+             svn_fs_root_t *root,
+             const char *path,
+             void *baton,
+             apr_pool_t *pool)
+{
+  dav_svn__authz_read_baton *arb = baton;
+  const char *uri;
+  request_rec *subreq;
+  dav_svn__request_stats_t *stats;
+
+  if (! (required & svn_authz_write))
+    {
+      authz_svn__subtree_readable_func_t subtree_readable = NULL;
+      svn_revnum_t rev = SVN_INVALID_REVNUM;
+
+      if (required & svn_authz_recursive)
+        subtree_readable = dav_svn__get_pathauthz_subtree_readable(arb->r);
+      if (subtree_readable != NULL)
+        {
+          *allowed = (subtree_readable(arb->r, path,
+                                       arb->repos->repo_name) == OK);
+          return SVN_NO_ERROR;
+        }
+
+      if (root && svn_fs_is_revision_root(root))
+        rev = svn_fs_revision_root_revision(root);
+
+      *allowed = allow_read(arb->r, arb->repos, path, rev, pool);
+      return SVN_NO_ERROR;
+    }
+
+  stats = dav_svn__get_request_stats(arb->r);
+  if (stats)
+    stats->authz_checks++;
+
+  uri = dav_svn__build_uri(arb->repos, DAV_SVN__BUILD_URI_PUBLIC,
+                           SVN_INVALID_REVNUM, path, FALSE, pool);
+  subreq = ap_sub_req_method_uri((required & svn_authz_recursive)
+                                   ? "DELETE" : "PUT",
+                                 uri, arb->r, NULL);
+
+  *allowed = FALSE;
+  if (subreq)
+    {
+      if (subreq->status == HTTP_OK)
+        *allowed = TRUE;
+
+      ap_destroy_sub_req(subreq);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_repos_authz_callback_t
+dav_svn__authz_commit_func(dav_svn__authz_read_baton *baton)
+{
+  /* Easy out: If the admin has explicitly set 'SVNPathAuthz Off',
+     then we don't need to do any authorization checks. */
+  if (! dav_svn__get_pathauthz_flag(baton->r))
+    return NULL;
+
+  return authz_commit;
+}
+
+
 svn_boolean_t
 dav_svn__allow_read(const dav_resource *resource,
                    svn_revnum_t rev,
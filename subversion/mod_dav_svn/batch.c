@@ -0,0 +1,1108 @@
+/*
+ * batch.c: forwarding whole commits from a mirror to its master
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* A mirror configured with "SVNMasterBatchCommits On" doesn't proxy the
+   requests of an HTTPv2 commit to the master one by one.  It builds the
+   commit in a transaction of its own instead, and when the client MERGEs
+   that transaction, encodes it as a single POST request against the
+   master's 'me' resource, which commits it and answers as to the MERGE.
+
+   The body of that request is a sequence of records in the format of
+   the binary update report (see reports/update.c): the revision
+   properties and lock tokens of the commit, then the drive of a commit
+   editor rooted at the repository root.  */
+
+#include <string.h>
+
+#include <apr_strings.h>
+#include <apr_buckets.h>
+
+#include <httpd.h>
+#include <http_protocol.h>
+#include <mod_dav.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_path.h"
+#include "svn_dirent_uri.h"
+#include "svn_props.h"
+#include "svn_delta.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+#include "svn_dav.h"
+
+#include "private/svn_log.h"
+#include "private/svn_dav_protocol.h"
+
+#include "dav_svn.h"
+
+
+dav_error *
+dav_svn__create_batch_txn(const dav_svn_repos *repos,
+                          const char **ptxn_name,
+                          apr_pool_t *pool)
+{
+  svn_revnum_t rev;
+  svn_fs_txn_t *txn;
+  svn_error_t *serr;
+
+  serr = svn_fs_youngest_rev(&rev, repos->fs, pool);
+  if (serr != NULL)
+    {
+      return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                  "could not determine youngest revision",
+                                  repos->pool);
+    }
+
+  serr = svn_fs_begin_txn2(&txn, repos->fs, rev, 0, repos->pool);
+  if (serr != NULL)
+    {
+      return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                  "could not begin a transaction",
+                                  repos->pool);
+    }
+
+  serr = svn_fs_txn_name(ptxn_name, txn, pool);
+  if (serr != NULL)
+    {
+      return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                  "could not fetch transaction name",
+                                  repos->pool);
+    }
+
+  return NULL;
+}
+
+
+/*** Encoding a commit, on the mirror. ***/
+
+/* Store N at BUF as a 4-byte big-endian number. */
+static void
+encode_length(char *buf, apr_size_t n)
+{
+  buf[0] = (char)((n >> 24) & 0xff);
+  buf[1] = (char)((n >> 16) & 0xff);
+  buf[2] = (char)((n >> 8) & 0xff);
+  buf[3] = (char)(n & 0xff);
+}
+
+
+/* The temporary file a commit is encoded into.  The file is buffered,
+   so the many small writes are cheap. */
+typedef struct spool_t
+{
+  apr_file_t *file;
+
+  /* How much has been written so far. */
+  apr_off_t len;
+
+  /* The transaction's base revision, which replaying it doesn't tell. */
+  svn_revnum_t base_rev;
+
+  apr_pool_t *pool;
+} spool_t;
+
+
+/* Append the LEN bytes at DATA to SPOOL. */
+static svn_error_t *
+spool_write(spool_t *spool, const char *data, apr_size_t len)
+{
+  SVN_ERR(svn_io_file_write_full(spool->file, data, len, NULL,
+                                 spool->pool));
+  spool->len += len;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Append a record with code CODE made of the NFIELDS FIELDS to SPOOL. */
+static svn_error_t *
+write_record(spool_t *spool,
+             char code,
+             int nfields,
+             const svn_string_t *const *fields)
+{
+  char header[5];
+  apr_size_t len = 0;
+  int i;
+
+  for (i = 0; i < nfields; i++)
+    len += 4 + fields[i]->len;
+
+  header[0] = code;
+  encode_length(header + 1, len);
+  SVN_ERR(spool_write(spool, header, 5));
+
+  for (i = 0; i < nfields; i++)
+    {
+      encode_length(header, fields[i]->len);
+      SVN_ERR(spool_write(spool, header, 4));
+      SVN_ERR(spool_write(spool, fields[i]->data, fields[i]->len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Append a record with code CODE whose fields are the NULL-terminated
+   list of C strings that follow to SPOOL.  Use POOL for temporary
+   allocations. */
+static svn_error_t *
+write_cstring_record(spool_t *spool,
+                     char code,
+                     apr_pool_t *pool,
+                     ...)
+{
+  const svn_string_t *fields[3];
+  const char *field;
+  int nfields = 0;
+  va_list ap;
+
+  va_start(ap, pool);
+  while (nfields < (int)(sizeof(fields) / sizeof(fields[0]))
+         && (field = va_arg(ap, const char *)) != NULL)
+    fields[nfields++] = svn_string_create(field, pool);
+  va_end(ap);
+
+  return write_record(spool, code, nfields, fields);
+}
+
+
+/* The editor replaying the transaction into the spool.  All of its
+   batons are the spool_t itself; entries are named relative to their
+   parent directory, so none of them needs to know its path. */
+
+static svn_error_t *
+enc_open_root(void *edit_baton,
+              svn_revnum_t base_revision,
+              apr_pool_t *pool,
+              void **root_baton)
+{
+  spool_t *spool = edit_baton;
+
+  *root_baton = spool;
+  return write_cstring_record(spool, SVN_DAV__BIN_OPEN_ROOT, pool,
+                              apr_ltoa(pool, spool->base_rev), NULL);
+}
+
+
+static svn_error_t *
+enc_delete_entry(const char *path,
+                 svn_revnum_t revision,
+                 void *parent_baton,
+                 apr_pool_t *pool)
+{
+  return write_cstring_record(parent_baton, SVN_DAV__BIN_DELETE_ENTRY, pool,
+                              svn_relpath_basename(path, pool),
+                              SVN_IS_VALID_REVNUM(revision)
+                                ? apr_ltoa(pool, revision) : NULL,
+                              NULL);
+}
+
+
+static svn_error_t *
+enc_add_helper(char code,
+               const char *path,
+               spool_t *spool,
+               const char *copyfrom_path,
+               svn_revnum_t copyfrom_revision,
+               apr_pool_t *pool,
+               void **child_baton)
+{
+  *child_baton = spool;
+  return write_cstring_record(spool, code, pool,
+                              svn_relpath_basename(path, pool),
+                              copyfrom_path,
+                              copyfrom_path
+                                ? apr_ltoa(pool, copyfrom_revision) : NULL,
+                              NULL);
+}
+
+
+static svn_error_t *
+enc_open_helper(char code,
+                const char *path,
+                spool_t *spool,
+                svn_revnum_t base_revision,
+                apr_pool_t *pool,
+                void **child_baton)
+{
+  *child_baton = spool;
+  return write_cstring_record(spool, code, pool,
+                              svn_relpath_basename(path, pool),
+                              apr_ltoa(pool, base_revision), NULL);
+}
+
+
+static svn_error_t *
+enc_add_directory(const char *path,
+                  void *parent_baton,
+                  const char *copyfrom_path,
+                  svn_revnum_t copyfrom_revision,
+                  apr_pool_t *pool,
+                  void **child_baton)
+{
+  return enc_add_helper(SVN_DAV__BIN_ADD_DIR, path, parent_baton,
+                        copyfrom_path, copyfrom_revision, pool, child_baton);
+}
+
+
+static svn_error_t *
+enc_open_directory(const char *path,
+                   void *parent_baton,
+                   svn_revnum_t base_revision,
+                   apr_pool_t *pool,
+                   void **child_baton)
+{
+  return enc_open_helper(SVN_DAV__BIN_OPEN_DIR, path, parent_baton,
+                         base_revision, pool, child_baton);
+}
+
+
+static svn_error_t *
+enc_add_file(const char *path,
+             void *parent_baton,
+             const char *copyfrom_path,
+             svn_revnum_t copyfrom_revision,
+             apr_pool_t *pool,
+             void **file_baton)
+{
+  return enc_add_helper(SVN_DAV__BIN_ADD_FILE, path, parent_baton,
+                        copyfrom_path, copyfrom_revision, pool, file_baton);
+}
+
+
+static svn_error_t *
+enc_open_file(const char *path,
+              void *parent_baton,
+              svn_revnum_t base_revision,
+              apr_pool_t *pool,
+              void **file_baton)
+{
+  return enc_open_helper(SVN_DAV__BIN_OPEN_FILE, path, parent_baton,
+                         base_revision, pool, file_baton);
+}
+
+
+static svn_error_t *
+enc_change_prop(void *baton,
+                const char *name,
+                const svn_string_t *value,
+                apr_pool_t *pool)
+{
+  const svn_string_t *fields[2];
+
+  fields[0] = svn_string_create(name, pool);
+  fields[1] = value;
+
+  return write_record(baton, SVN_DAV__BIN_CHANGE_PROP, value ? 2 : 1,
+                      fields);
+}
+
+
+static svn_error_t *
+enc_close_directory(void *dir_baton, apr_pool_t *pool)
+{
+  return write_record(dir_baton, SVN_DAV__BIN_CLOSE_DIR, 0, NULL);
+}
+
+
+/* This implements 'svn_write_fn_t', writing the data as a chunk of
+   svndiff. */
+static svn_error_t *
+enc_svndiff_write(void *baton, const char *data, apr_size_t *len)
+{
+  spool_t *spool = baton;
+  char header[5];
+
+  header[0] = SVN_DAV__BIN_SVNDIFF_CHUNK;
+  encode_length(header + 1, *len);
+  SVN_ERR(spool_write(spool, header, 5));
+
+  return spool_write(spool, data, *len);
+}
+
+
+struct enc_window_baton
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  spool_t *spool;
+};
+
+
+/* This implements 'svn_txdelta_window_handler_t', marking the end of
+   the svndiff data after the real handler has flushed it. */
+static svn_error_t *
+enc_window_handler(svn_txdelta_window_t *window, void *baton)
+{
+  struct enc_window_baton *wb = baton;
+
+  SVN_ERR(wb->handler(window, wb->handler_baton));
+
+  if (window == NULL)
+    SVN_ERR(write_record(wb->spool, SVN_DAV__BIN_TEXTDELTA_END, 0, NULL));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+enc_apply_textdelta(void *file_baton,
+                    const char *base_checksum,
+                    apr_pool_t *pool,
+                    svn_txdelta_window_handler_t *handler,
+                    void **handler_baton)
+{
+  spool_t *spool = file_baton;
+  struct enc_window_baton *wb = apr_palloc(pool, sizeof(*wb));
+  svn_stream_t *stream;
+
+  SVN_ERR(write_cstring_record(spool, SVN_DAV__BIN_APPLY_TEXTDELTA, pool,
+                               base_checksum, NULL));
+
+  stream = svn_stream_create(spool, pool);
+  svn_stream_set_write(stream, enc_svndiff_write);
+
+  /* Commits go over the wire between servers, so compress them. */
+  svn_txdelta_to_svndiff2(&wb->handler, &wb->handler_baton, stream, 1, pool);
+  wb->spool = spool;
+
+  *handler = enc_window_handler;
+  *handler_baton = wb;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+enc_close_file(void *file_baton, const char *text_checksum, apr_pool_t *pool)
+{
+  return write_cstring_record(file_baton, SVN_DAV__BIN_CLOSE_FILE, pool,
+                              text_checksum, NULL);
+}
+
+
+static svn_error_t *
+enc_close_edit(void *edit_baton, apr_pool_t *pool)
+{
+  return write_record(edit_baton, SVN_DAV__BIN_CLOSE_EDIT, 0, NULL);
+}
+
+
+/* Encode the transaction TXN_NAME of the repository at FS_PATH, and
+   the lock tokens in LOCKS, into SPOOL; then remove the transaction.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+spool_commit(spool_t *spool,
+             const char *fs_path,
+             const char *txn_name,
+             apr_hash_t *locks,
+             apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  apr_hash_t *txnprops;
+  apr_hash_index_t *hi;
+  svn_delta_editor_t *editor;
+  apr_status_t status;
+
+  SVN_ERR(svn_repos_open2(&repos, fs_path, NULL, pool));
+  fs = svn_repos_fs(repos);
+  SVN_ERR(svn_fs_open_txn(&txn, fs, txn_name, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  spool->base_rev = svn_fs_txn_base_revision(txn);
+
+  /* The master sets the author and date of the new revision itself. */
+  SVN_ERR(svn_fs_txn_proplist(&txnprops, txn, pool));
+  for (hi = apr_hash_first(pool, txnprops); hi; hi = apr_hash_next(hi))
+    {
+      const void *key;
+      void *val;
+      const svn_string_t *fields[2];
+
+      apr_hash_this(hi, &key, NULL, &val);
+      if (strcmp(key, SVN_PROP_REVISION_AUTHOR) == 0
+          || strcmp(key, SVN_PROP_REVISION_DATE) == 0)
+        continue;
+
+      fields[0] = svn_string_create(key, pool);
+      fields[1] = val;
+      SVN_ERR(write_record(spool, SVN_DAV__BIN_REVPROP, 2, fields));
+    }
+
+  for (hi = apr_hash_first(pool, locks); hi; hi = apr_hash_next(hi))
+    {
+      const void *key;
+      void *val;
+
+      apr_hash_this(hi, &key, NULL, &val);
+      SVN_ERR(write_cstring_record(spool, SVN_DAV__BIN_LOCK_TOKEN, pool,
+                                   key, val, NULL));
+    }
+
+  editor = svn_delta_default_editor(pool);
+  editor->open_root = enc_open_root;
+  editor->delete_entry = enc_delete_entry;
+  editor->add_directory = enc_add_directory;
+  editor->open_directory = enc_open_directory;
+  editor->change_dir_prop = enc_change_prop;
+  editor->close_directory = enc_close_directory;
+  editor->add_file = enc_add_file;
+  editor->open_file = enc_open_file;
+  editor->apply_textdelta = enc_apply_textdelta;
+  editor->change_file_prop = enc_change_prop;
+  editor->close_file = enc_close_file;
+  editor->close_edit = enc_close_edit;
+
+  /* Copies are sent as such, whatever their source revision: the
+     mirror has all of those the master has. */
+  SVN_ERR(svn_repos_replay2(root, "", 0, TRUE, editor, spool,
+                            NULL, NULL, pool));
+  SVN_ERR(editor->close_edit(spool, pool));
+
+  status = apr_file_flush(spool->file);
+  if (status)
+    return svn_error_wrap_apr(status, "Can't flush the batched commit");
+
+  /* The transaction is no use any more, whatever the master makes of
+     the commit: the client aborts a failed one, and doesn't mind if
+     there's nothing left to abort. */
+  return svn_fs_purge_txn(fs, txn_name, pool);
+}
+
+
+dav_error *
+dav_svn__spool_batch_commit(apr_bucket_brigade **body,
+                            apr_off_t *len,
+                            request_rec *r,
+                            const char *fs_path,
+                            const char *txn_name,
+                            apr_hash_t *locks)
+{
+  spool_t *spool = apr_pcalloc(r->pool, sizeof(*spool));
+  apr_pool_t *subpool = svn_pool_create(r->pool);
+  svn_error_t *serr;
+
+  spool->pool = r->pool;
+  serr = svn_io_open_unique_file3(&spool->file, NULL, NULL,
+                                  svn_io_file_del_on_pool_cleanup,
+                                  r->pool, subpool);
+  if (! serr)
+    serr = spool_commit(spool, fs_path, txn_name, locks, subpool);
+  svn_pool_destroy(subpool);
+
+  if (serr)
+    return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                "Could not prepare the commit for the "
+                                "master server.", r->pool);
+
+  *body = apr_brigade_create(r->pool, r->connection->bucket_alloc);
+  apr_brigade_insert_file(*body, spool->file, 0, spool->len, r->pool);
+  *len = spool->len;
+
+  return NULL;
+}
+
+
+/*** Decoding and committing a commit, on the master. ***/
+
+/* An open directory or file of the commit. */
+typedef struct batch_node_t
+{
+  struct batch_node_t *parent;
+  svn_boolean_t is_dir;
+
+  /* The path relative to the repository root, and the editor baton. */
+  const char *path;
+  void *baton;
+
+  apr_pool_t *pool;
+} batch_node_t;
+
+
+typedef struct batch_commit_t
+{
+  request_rec *r;
+
+  /* The request body received but not yet processed is BUF, from
+     OFFSET on; BB is for reading more. */
+  apr_bucket_brigade *bb;
+  svn_stringbuf_t *buf;
+  apr_size_t offset;
+  svn_boolean_t seen_eos;
+
+  /* What the records before the opening of the root say. */
+  apr_hash_t *revprops;
+  apr_hash_t *locks;
+
+  /* The commit editor, the innermost open node, and the svndiff
+     parser of the text delta being received, if any. */
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  batch_node_t *node;
+  svn_stream_t *delta_stream;
+  svn_boolean_t closed;
+
+  /* What the commit made. */
+  svn_revnum_t new_rev;
+  const char *post_commit_err;
+
+  apr_pool_t *pool;
+} batch_commit_t;
+
+
+/* Return the 4-byte big-endian number at DATA. */
+static apr_size_t
+decode_length(const char *data)
+{
+  const unsigned char *p = (const unsigned char *)data;
+
+  return ((apr_size_t)p[0] << 24) | ((apr_size_t)p[1] << 16)
+         | ((apr_size_t)p[2] << 8) | (apr_size_t)p[3];
+}
+
+
+static svn_error_t *
+malformed_record(char code)
+{
+  return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                           "Malformed '%c' record in batched commit", code);
+}
+
+
+/* Make sure at least LEN bytes of the request body, past BC->offset,
+   are in BC->buf. */
+static svn_error_t *
+read_body(batch_commit_t *bc, apr_size_t len)
+{
+  if (bc->buf->len - bc->offset >= len)
+    return SVN_NO_ERROR;
+
+  /* Drop what has been processed before reading more. */
+  if (bc->offset > 0)
+    {
+      memmove(bc->buf->data, bc->buf->data + bc->offset,
+              bc->buf->len - bc->offset);
+      bc->buf->len -= bc->offset;
+      bc->buf->data[bc->buf->len] = '\0';
+      bc->offset = 0;
+    }
+
+  while (bc->buf->len < len)
+    {
+      apr_bucket *bucket;
+      apr_status_t status;
+
+      if (bc->seen_eos)
+        return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                "Unexpected end of batched commit");
+
+      status = ap_get_brigade(bc->r->input_filters, bc->bb,
+                              AP_MODE_READBYTES, APR_BLOCK_READ,
+                              SVN__STREAM_CHUNK_SIZE);
+      if (status != APR_SUCCESS)
+        return svn_error_wrap_apr(status, "Error reading batched commit");
+
+      for (bucket = APR_BRIGADE_FIRST(bc->bb);
+           bucket != APR_BRIGADE_SENTINEL(bc->bb);
+           bucket = APR_BUCKET_NEXT(bucket))
+        {
+          const char *data;
+          apr_size_t data_len;
+
+          if (APR_BUCKET_IS_EOS(bucket))
+            {
+              bc->seen_eos = TRUE;
+              break;
+            }
+
+          if (APR_BUCKET_IS_METADATA(bucket))
+            continue;
+
+          status = apr_bucket_read(bucket, &data, &data_len, APR_BLOCK_READ);
+          if (status != APR_SUCCESS)
+            return svn_error_wrap_apr(status, "Error reading batched commit");
+
+          svn_stringbuf_appendbytes(bc->buf, data, data_len);
+        }
+
+      apr_brigade_cleanup(bc->bb);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Set *FIELDS to the fields of the record with code CODE whose LEN bytes
+   of payload are at DATA, as an array of svn_string_t *.  Allocate in
+   POOL. */
+static svn_error_t *
+parse_fields(apr_array_header_t **fields,
+             char code,
+             const char *data,
+             apr_size_t len,
+             apr_pool_t *pool)
+{
+  *fields = apr_array_make(pool, 3, sizeof(svn_string_t *));
+
+  while (len > 0)
+    {
+      apr_size_t field_len;
+
+      if (len < 4)
+        return malformed_record(code);
+
+      field_len = decode_length(data);
+      if (field_len > len - 4)
+        return malformed_record(code);
+
+      APR_ARRAY_PUSH(*fields, svn_string_t *)
+        = svn_string_ncreate(data + 4, field_len, pool);
+      data += 4 + field_len;
+      len -= 4 + field_len;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#define FIELD(fields, i) (APR_ARRAY_IDX(fields, i, svn_string_t *)->data)
+
+
+/* Open a node called NAME in the innermost open directory of BC, or the
+   root if NAME is NULL, and make it the innermost node. */
+static svn_error_t *
+push_node(batch_node_t **node,
+          batch_commit_t *bc,
+          svn_boolean_t is_dir,
+          const char *name)
+{
+  apr_pool_t *pool = svn_pool_create(bc->node ? bc->node->pool : bc->pool);
+
+  *node = apr_pcalloc(pool, sizeof(**node));
+  (*node)->parent = bc->node;
+  (*node)->is_dir = is_dir;
+  (*node)->pool = pool;
+
+  if (name == NULL)
+    (*node)->path = "";
+  else if (svn_path_is_single_path_component(name))
+    (*node)->path = svn_relpath_join(bc->node->path, name, pool);
+  else
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             "Invalid entry name '%s' in batched commit",
+                             name);
+
+  bc->node = *node;
+  return SVN_NO_ERROR;
+}
+
+
+/* Forget the innermost node of BC, whose editor baton is closed. */
+static void
+pop_node(batch_commit_t *bc)
+{
+  batch_node_t *node = bc->node;
+
+  bc->node = node->parent;
+  svn_pool_destroy(node->pool);
+}
+
+
+/* The copy sources of a batched commit are repository paths, which the
+   commit editor takes as URLs below an empty repository URL. */
+static const char *
+copyfrom_url(apr_array_header_t *fields, int i, apr_pool_t *pool)
+{
+  if (fields->nelts < i + 2)
+    return NULL;
+
+  return svn_path_uri_encode(FIELD(fields, i), pool);
+}
+
+
+/* Act as the record with code CODE, whose LEN bytes of payload are at
+   DATA, says.  Until BC's editor exists, only revision properties and
+   lock tokens are expected.  Use POOL for temporary allocations. */
+static svn_error_t *
+process_record(batch_commit_t *bc,
+               char code,
+               const char *data,
+               apr_size_t len,
+               apr_pool_t *pool)
+{
+  const svn_delta_editor_t *editor = bc->editor;
+  batch_node_t *node = bc->node;
+  apr_array_header_t *fields;
+  svn_boolean_t in_dir = (node && node->is_dir);
+  svn_boolean_t in_file = (node && ! node->is_dir && ! bc->delta_stream);
+
+  /* The text delta data is the only thing that's not made of fields. */
+  if (code == SVN_DAV__BIN_SVNDIFF_CHUNK)
+    {
+      if (! bc->delta_stream)
+        return malformed_record(code);
+
+      return svn_stream_write(bc->delta_stream, data, &len);
+    }
+
+  SVN_ERR(parse_fields(&fields, code, data, len, pool));
+
+  if (! editor)
+    {
+      switch (code)
+        {
+          case SVN_DAV__BIN_REVPROP:
+            if (fields->nelts != 2)
+              return malformed_record(code);
+            apr_hash_set(bc->revprops, apr_pstrdup(bc->pool, FIELD(fields, 0)),
+                         APR_HASH_KEY_STRING,
+                         svn_string_dup(APR_ARRAY_IDX(fields, 1,
+                                                      svn_string_t *),
+                                        bc->pool));
+            return SVN_NO_ERROR;
+
+          case SVN_DAV__BIN_LOCK_TOKEN:
+            if (fields->nelts != 2)
+              return malformed_record(code);
+            apr_hash_set(bc->locks, apr_pstrdup(bc->pool, FIELD(fields, 0)),
+                         APR_HASH_KEY_STRING,
+                         apr_pstrdup(bc->pool, FIELD(fields, 1)));
+            return SVN_NO_ERROR;
+
+          default:
+            return malformed_record(code);
+        }
+    }
+
+  switch (code)
+    {
+      case SVN_DAV__BIN_OPEN_ROOT:
+        if (node || bc->closed || fields->nelts != 1)
+          return malformed_record(code);
+        SVN_ERR(push_node(&node, bc, TRUE, NULL));
+        return editor->open_root(bc->edit_baton,
+                                 SVN_STR_TO_REV(FIELD(fields, 0)),
+                                 node->pool, &node->baton);
+
+      case SVN_DAV__BIN_DELETE_ENTRY:
+        if (! in_dir || fields->nelts < 1)
+          return malformed_record(code);
+        if (! svn_path_is_single_path_component(FIELD(fields, 0)))
+          return malformed_record(code);
+        return editor->delete_entry(svn_relpath_join(node->path,
+                                                     FIELD(fields, 0), pool),
+                                    fields->nelts > 1
+                                      ? SVN_STR_TO_REV(FIELD(fields, 1))
+                                      : SVN_INVALID_REVNUM,
+                                    node->baton, pool);
+
+      case SVN_DAV__BIN_ADD_DIR:
+      case SVN_DAV__BIN_ADD_FILE:
+        {
+          svn_boolean_t is_dir = (code == SVN_DAV__BIN_ADD_DIR);
+          void *parent_baton = node ? node->baton : NULL;
+
+          if (! in_dir || fields->nelts < 1)
+            return malformed_record(code);
+          SVN_ERR(push_node(&node, bc, is_dir, FIELD(fields, 0)));
+          if (is_dir)
+            return editor->add_directory(node->path, parent_baton,
+                                         copyfrom_url(fields, 1, node->pool),
+                                         fields->nelts > 2
+                                           ? SVN_STR_TO_REV(FIELD(fields, 2))
+                                           : SVN_INVALID_REVNUM,
+                                         node->pool, &node->baton);
+          else
+            return editor->add_file(node->path, parent_baton,
+                                    copyfrom_url(fields, 1, node->pool),
+                                    fields->nelts > 2
+                                      ? SVN_STR_TO_REV(FIELD(fields, 2))
+                                      : SVN_INVALID_REVNUM,
+                                    node->pool, &node->baton);
+        }
+
+      case SVN_DAV__BIN_OPEN_DIR:
+      case SVN_DAV__BIN_OPEN_FILE:
+        {
+          svn_boolean_t is_dir = (code == SVN_DAV__BIN_OPEN_DIR);
+          void *parent_baton = node ? node->baton : NULL;
+          svn_revnum_t base_rev;
+
+          if (! in_dir || fields->nelts != 2)
+            return malformed_record(code);
+          base_rev = SVN_STR_TO_REV(FIELD(fields, 1));
+          SVN_ERR(push_node(&node, bc, is_dir, FIELD(fields, 0)));
+          if (is_dir)
+            return editor->open_directory(node->path, parent_baton, base_rev,
+                                          node->pool, &node->baton);
+          else
+            return editor->open_file(node->path, parent_baton, base_rev,
+                                     node->pool, &node->baton);
+        }
+
+      case SVN_DAV__BIN_CHANGE_PROP:
+        {
+          const svn_string_t *value;
+
+          if (! (in_dir || in_file) || fields->nelts < 1)
+            return malformed_record(code);
+          value = (fields->nelts > 1)
+                    ? APR_ARRAY_IDX(fields, 1, svn_string_t *) : NULL;
+          if (in_dir)
+            return editor->change_dir_prop(node->baton, FIELD(fields, 0),
+                                           value, pool);
+          else
+            return editor->change_file_prop(node->baton, FIELD(fields, 0),
+                                            value, pool);
+        }
+
+      case SVN_DAV__BIN_APPLY_TEXTDELTA:
+        {
+          svn_txdelta_window_handler_t handler;
+          void *handler_baton;
+
+          if (! in_file)
+            return malformed_record(code);
+          SVN_ERR(editor->apply_textdelta(node->baton,
+                                          fields->nelts > 0
+                                            ? FIELD(fields, 0) : NULL,
+                                          node->pool,
+                                          &handler, &handler_baton));
+          bc->delta_stream = svn_txdelta_parse_svndiff(handler, handler_baton,
+                                                       TRUE, node->pool);
+          return SVN_NO_ERROR;
+        }
+
+      case SVN_DAV__BIN_TEXTDELTA_END:
+        if (! bc->delta_stream)
+          return malformed_record(code);
+        SVN_ERR(svn_stream_close(bc->delta_stream));
+        bc->delta_stream = NULL;
+        return SVN_NO_ERROR;
+
+      case SVN_DAV__BIN_CLOSE_FILE:
+        if (! in_file)
+          return malformed_record(code);
+        SVN_ERR(editor->close_file(node->baton,
+                                   fields->nelts > 0 ? FIELD(fields, 0) : NULL,
+                                   pool));
+        pop_node(bc);
+        return SVN_NO_ERROR;
+
+      case SVN_DAV__BIN_CLOSE_DIR:
+        if (! in_dir)
+          return malformed_record(code);
+        SVN_ERR(editor->close_directory(node->baton, pool));
+        pop_node(bc);
+        return SVN_NO_ERROR;
+
+      case SVN_DAV__BIN_CLOSE_EDIT:
+        if (node)
+          return malformed_record(code);
+        SVN_ERR(editor->close_edit(bc->edit_baton, pool));
+        bc->closed = TRUE;
+        return SVN_NO_ERROR;
+
+      default:
+        return malformed_record(code);
+    }
+}
+
+
+/* Process the records of the request body of BC, up to the end of the
+   edit, or up to but not including the opening of the root if STOP_AT_ROOT
+   is set. */
+static svn_error_t *
+process_records(batch_commit_t *bc, svn_boolean_t stop_at_root)
+{
+  apr_pool_t *iterpool = svn_pool_create(bc->pool);
+
+  while (! bc->closed)
+    {
+      const char *record;
+      apr_size_t len;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(read_body(bc, 5));
+      record = bc->buf->data + bc->offset;
+      if (stop_at_root && record[0] == SVN_DAV__BIN_OPEN_ROOT)
+        break;
+
+      len = decode_length(record + 1);
+      SVN_ERR(read_body(bc, 5 + len));
+      record = bc->buf->data + bc->offset;
+
+      SVN_ERR(process_record(bc, record[0], record + 5, len, iterpool));
+      bc->offset += 5 + len;
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
+/* This implements 'svn_commit_callback2_t'. */
+static svn_error_t *
+commit_callback(const svn_commit_info_t *commit_info,
+                void *baton,
+                apr_pool_t *pool)
+{
+  batch_commit_t *bc = baton;
+
+  bc->new_rev = commit_info->revision;
+  if (commit_info->post_commit_err)
+    bc->post_commit_err = apr_pstrdup(bc->pool, commit_info->post_commit_err);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Return the error response for SERR, an error of the batched commit
+   BC against RESOURCE, as merge() would. */
+static int
+commit_failed(batch_commit_t *bc,
+              dav_resource *resource,
+              svn_error_t *serr)
+{
+  int status = HTTP_CONFLICT;
+  const char *msg = "An error occurred while committing the transaction.";
+
+  if (bc->editor && ! bc->closed)
+    svn_error_clear(bc->editor->abort_edit(bc->edit_baton, bc->pool));
+
+  if (serr->apr_err == SVN_ERR_INCORRECT_PARAMS)
+    {
+      status = HTTP_BAD_REQUEST;
+      msg = "Could not read the batched commit.";
+    }
+  else if (serr->apr_err == SVN_ERR_AUTHZ_UNWRITABLE
+           || serr->apr_err == SVN_ERR_AUTHZ_UNREADABLE)
+    {
+      status = HTTP_FORBIDDEN;
+      msg = "Access denied.";
+    }
+
+  return dav_svn__error_response_tag(resource->info->r,
+                                     dav_svn__convert_err(serr, status, msg,
+                                                          resource->pool));
+}
+
+
+int
+dav_svn__method_post_batch(dav_resource *resource)
+{
+  request_rec *r = resource->info->r;
+  dav_svn_repos *repos = resource->info->repos;
+  apr_pool_t *pool = resource->pool;
+  batch_commit_t *bc = apr_pcalloc(pool, sizeof(*bc));
+  dav_svn__authz_read_baton arb;
+  svn_boolean_t disable_merge_response = FALSE;
+  svn_error_t *serr;
+  dav_error *derr;
+
+  bc->r = r;
+  bc->bb = apr_brigade_create(pool, r->connection->bucket_alloc);
+  bc->buf = svn_stringbuf_create_ensure(SVN__STREAM_CHUNK_SIZE, pool);
+  bc->revprops = apr_hash_make(pool);
+  bc->locks = apr_hash_make(pool);
+  bc->new_rev = SVN_INVALID_REVNUM;
+  bc->pool = pool;
+
+  serr = process_records(bc, TRUE);
+  if (serr)
+    return commit_failed(bc, resource, serr);
+
+  /* As in merge(), the lock tokens come in the body rather than in an
+     If: header. */
+  if (apr_hash_count(bc->locks))
+    {
+      derr = dav_svn__push_locks(resource, bc->locks, pool);
+      if (derr)
+        return dav_svn__error_response_tag(r, derr);
+    }
+
+  /* The author is whoever the master authenticated, and the date is
+     that of the commit. */
+  apr_hash_set(bc->revprops, SVN_PROP_REVISION_AUTHOR, APR_HASH_KEY_STRING,
+               repos->username ? svn_string_create(repos->username, pool)
+                               : NULL);
+  apr_hash_set(bc->revprops, SVN_PROP_REVISION_DATE, APR_HASH_KEY_STRING,
+               NULL);
+
+  /* The mirror checked the client's requests against its own authz
+     configuration, but the master is the one to decide. */
+  arb.r = r;
+  arb.repos = repos;
+
+  serr = svn_repos_get_commit_editor5(&bc->editor, &bc->edit_baton,
+                                      repos->repos, NULL, "", "/",
+                                      bc->revprops, commit_callback, bc,
+                                      dav_svn__authz_commit_func(&arb), &arb,
+                                      pool);
+  /* A failing post-commit hook doesn't fail the edit; the commit
+     callback hears of it. */
+  if (! serr)
+    serr = process_records(bc, FALSE);
+  if (serr)
+    return commit_failed(bc, resource, serr);
+
+  dav_svn__register_deltification_cleanup(repos->repos, bc->new_rev,
+                                          r->connection->pool);
+
+  dav_svn__operational_log(resource->info,
+                           svn_log__commit(bc->new_rev, r->pool));
+
+  if (resource->info->svn_client_options != NULL)
+    {
+      if (ap_strstr_c(resource->info->svn_client_options,
+                      SVN_DAV_OPTION_RELEASE_LOCKS)
+          && apr_hash_count(bc->locks))
+        {
+          serr = dav_svn__release_locks(bc->locks, repos->repos, r, pool);
+          if (serr != NULL)
+            return dav_svn__error_response_tag(
+                     r, dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                             "Error releasing locks", pool));
+        }
+
+      if (ap_strstr_c(resource->info->svn_client_options,
+                      SVN_DAV_OPTION_NO_MERGE_RESPONSE))
+        disable_merge_response = TRUE;
+    }
+
+  /* Respond the way mod_dav does to a MERGE. */
+  r->status = HTTP_OK;
+  ap_set_content_type(r, DAV_XML_CONTENT_TYPE);
+
+  derr = dav_svn__merge_response(r->output_filters, repos, bc->new_rev,
+                                 (char *)bc->post_commit_err, NULL,
+                                 disable_merge_response, pool);
+  if (derr)
+    return dav_svn__error_response_tag(r, derr);
+
+  return OK;
+}
@@ -271,6 +271,11 @@ struct dav_resource_private {
      interface (ie: /path/to/item?p=PEGREV]? */
   svn_boolean_t pegged;
 
+  /* was this resource addressed by a URL naming a fixed revision (a
+     version, baseline collection or revision root URL), so that what it
+     refers to can never change? */
+  svn_boolean_t immutable;
+
   /* Cache any revprop change error */
   svn_error_t *revprop_error;
 
@@ -308,6 +313,13 @@ svn_boolean_t dav_svn__get_pathauthz_flag(request_rec *r);
  */
 authz_svn__subreq_bypass_func_t dav_svn__get_pathauthz_bypass(request_rec *r);
 
+/* for the repository referred to by this request, if subrequests are
+ * bypassed, the function telling whether a whole subtree is readable,
+ * or NULL.
+ */
+authz_svn__subtree_readable_func_t
+dav_svn__get_pathauthz_subtree_readable(request_rec *r);
+
 /* for the repository referred to by this request, is a GET of
    SVNParentPath allowed? */
 svn_boolean_t dav_svn__get_list_parentpath_flag(request_rec *r);
@@ -360,10 +372,20 @@ const char *dav_svn__get_xslt_uri(request_rec *r);
 /* ### Is this assumed to be URI-encoded? */
 const char *dav_svn__get_master_uri(request_rec *r);
 
+/* Return whether HTTPv2 commits are built in a local transaction and
+   forwarded to the master as a single request (for mirroring).
+   Comes from the <SVNMasterBatchCommits> directive. */
+svn_boolean_t dav_svn__get_master_batch_commits_flag(request_rec *r);
+
 /* Return the disk path to the activities db.
    Comes from the <SVNActivitiesDB> directive. */
 const char *dav_svn__get_activities_db(request_rec *r);
 
+/* Return the time above which a request is logged as slow, or 0 if slow
+   requests are not logged.
+   Comes from the <SVNSlowRequestThreshold> directive. */
+apr_interval_time_t dav_svn__get_slow_request_threshold(request_rec *r);
+
 /* Return the server-relative URI of the repository root.
    Comes from the <Location> directive. */
 /* ### Is this assumed to be URI-encoded? */
@@ -425,6 +447,12 @@ int dav_svn__method_post(request_rec *r);
 
 /*** repos.c ***/
 
+/* Set up the per-process pool of open repositories that connections
+   share, one at a time, allocated in POOL.  Called once per child
+   process; until then every connection opens its own repository. */
+void
+dav_svn__init_repos_pool(apr_pool_t *pool);
+
 /* generate an ETag for RESOURCE and return it, allocated in POOL. */
 const char *
 dav_svn__getetag(const dav_resource *resource, apr_pool_t *pool);
@@ -475,6 +503,12 @@ extern const dav_hooks_propdb dav_svn__hooks_propdb;
 /*** lock.c ***/
 extern const dav_hooks_locks dav_svn__hooks_locks;
 
+/* Lock or unlock the paths listed in the body of the POST request
+   against the 'me' RESOURCE, and respond with the outcome for each.
+   Return an HTTP status code, as dav_svn__method_post() does. */
+int
+dav_svn__method_post_locks(dav_resource *resource);
+
 
 /*** version.c ***/
 
@@ -526,6 +560,23 @@ dav_svn__push_locks(dav_resource *resource,
                     apr_pool_t *pool);
 
 
+/* Helper: free every lock in LOCKS, which live in REPOS.  Log any
+   errors for R.  Use POOL for temporary work. */
+svn_error_t *
+dav_svn__release_locks(apr_hash_t *locks,
+                       svn_repos_t *repos,
+                       request_rec *r,
+                       apr_pool_t *pool);
+
+
+/* Helper: schedule the deltification of REVISION in REPOS for when
+   POOL, usually the connection pool, is cleaned up. */
+void
+dav_svn__register_deltification_cleanup(svn_repos_t *repos,
+                                        svn_revnum_t revision,
+                                        apr_pool_t *pool);
+
+
 extern const dav_hooks_vsn dav_svn__hooks_vsn;
 
 
@@ -671,6 +722,14 @@ dav_svn__allow_read(const dav_resource *resource,
 svn_repos_authz_func_t
 dav_svn__authz_read_func(dav_svn__authz_read_baton *baton);
 
+/* If authz is enabled in the specified BATON, return an authorization
+   callback for svn_repos_get_commit_editor5(), which asks the authz
+   modules loaded into apache by way of PUT (write access), DELETE
+   (recursive write access) and GET (read access) subrequests.
+   Otherwise, return NULL. */
+svn_repos_authz_callback_t
+dav_svn__authz_commit_func(dav_svn__authz_read_baton *baton);
+
 
 /*** util.c ***/
 
@@ -800,6 +859,21 @@ svn_error_t *dav_svn__brigade_printf(apr_bucket_brigade *bb,
                                      ...)
   __attribute__((format(printf, 3, 4)));
 
+/* Write NULL-terminated string STR to OUTPUT using BB, quoted for use in
+   XML the way apr_xml_quote_string() would do it: '&', '<' and '>' are
+   replaced by entity references, and so is '"' if QUOTES is set.  Runs
+   of characters which need no quoting are written without being copied
+   into a temporary string first.  */
+svn_error_t *dav_svn__brigade_xml_quote(apr_bucket_brigade *bb,
+                                        ap_filter_t *output,
+                                        const char *str,
+                                        svn_boolean_t quotes);
+
+/* Pass everything written to BB so far down to OUTPUT and flush the
+   filter chain, so that the client receives it right away.  */
+svn_error_t *dav_svn__brigade_flush(apr_bucket_brigade *bb,
+                                    ap_filter_t *output);
+
 
 
 
@@ -845,6 +919,35 @@ dav_svn__make_base64_output_stream(apr_bucket_brigade *bb,
 void
 dav_svn__operational_log(struct dav_resource_private *info, const char *line);
 
+/* What a request cost, for the "SVN-STATS" operational log variable. */
+typedef struct dav_svn__request_stats_t
+{
+  /* When the request opened the repository. */
+  apr_time_t start;
+
+  /* Time spent waiting for the network to take the response. */
+  apr_interval_time_t send_time;
+
+  /* Number of path-based authz checks made. */
+  apr_uint64_t authz_checks;
+
+  /* Number of nodes an update-style report sent or skipped. */
+  apr_uint64_t nodes;
+
+  /* The filesystem whose cache statistics count towards the request. */
+  svn_fs_t *fs;
+} dav_svn__request_stats_t;
+
+/* Start collecting statistics for request R, which uses FS.  Does
+ * nothing for subrequests or if R already collects them. */
+void
+dav_svn__start_request_stats(request_rec *r, svn_fs_t *fs);
+
+/* Return the statistics of request R, or of the main request if R is a
+ * subrequest, or NULL if there are none. */
+dav_svn__request_stats_t *
+dav_svn__get_request_stats(request_rec *r);
+
 /* Flush BB if it's okay and useful to do so, but treat PREFERRED_ERR
  * as a more important error to return (if it is non-NULL).
  *
@@ -890,6 +993,38 @@ dav_svn__final_flush_or_error(request_rec *r, apr_bucket_brigade *bb,
  */
 int dav_svn__error_response_tag(request_rec *r, dav_error *err);
 
+/*** batch.c ***/
+
+/* Create a new transaction based on HEAD in REPOS for a commit that
+   will be forwarded to the master, setting *PTXN_NAME to its name.
+   Unlike dav_svn__create_txn(), run no hooks and check no locks: the
+   master does that when the commit reaches it.  Use POOL for
+   allocations. */
+dav_error *
+dav_svn__create_batch_txn(const dav_svn_repos *repos,
+                          const char **ptxn_name,
+                          apr_pool_t *pool);
+
+/* Encode the changes made in the transaction TXN_NAME of the repository
+   at FS_PATH, its properties, and the lock tokens in LOCKS (as returned
+   by dav_svn__build_lock_hash()) as a batched commit, and remove the
+   transaction.  Set *BODY to a brigade holding the encoded commit, and
+   *LEN to its length.  Allocate in R->pool. */
+dav_error *
+dav_svn__spool_batch_commit(apr_bucket_brigade **body,
+                            apr_off_t *len,
+                            request_rec *r,
+                            const char *fs_path,
+                            const char *txn_name,
+                            apr_hash_t *locks);
+
+/* Commit the batched commit in the body of the POST request against
+   the 'me' RESOURCE, and respond as to a MERGE.  Return an HTTP status
+   code, as dav_svn__method_post() does. */
+int
+dav_svn__method_post_batch(dav_resource *resource);
+
+
 /*** mirror.c ***/
 
 /* Perform the fixup hook for the R request.  */
@@ -904,11 +1039,30 @@ apr_status_t dav_svn__location_in_filter(ap_filter_t *f,
                                          apr_read_type_e block,
                                          apr_off_t readbytes);
 
+/* An Apache input filter which replaces the request body with the
+   brigade set as the context of filter F, as a proxied request's body
+   which isn't the one the client sent.  It reads into BB data, in MODE
+   mode (which must be AP_MODE_READBYTES), at most READBYTES bytes. */
+apr_status_t dav_svn__spooled_body_in_filter(ap_filter_t *f,
+                                             apr_bucket_brigade *bb,
+                                             ap_input_mode_t mode,
+                                             apr_read_type_e block,
+                                             apr_off_t readbytes);
+
 /* An Apache output filter F which rewrites the response headers for
  * location headers.  It will modify the stream in BB. */
 apr_status_t dav_svn__location_header_filter(ap_filter_t *f,
                                              apr_bucket_brigade *bb);
 
+/* An Apache output filter F which measures the time spent passing BB on,
+   for the send_time of the request statistics in F->ctx. */
+apr_status_t dav_svn__stats_output_filter(ap_filter_t *f,
+                                          apr_bucket_brigade *bb);
+
+/* Implements the #log_transaction hook: put the statistics of request R
+   into "SVN-STATS" and log R if it was slow. */
+int dav_svn__log_request_stats(request_rec *r);
+
 /* An Apache output filter F which rewrites the response body for
  * location headers.  It will modify the stream in BB. */
 apr_status_t dav_svn__location_body_filter(ap_filter_t *f,
@@ -21,6 +21,8 @@
  * ====================================================================
  */
 
+#include <string.h>
+
 #include <apr_uuid.h>
 #include <apr_time.h>
 
@@ -34,6 +36,10 @@
 #include "svn_time.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "svn_xml.h"
+#include "svn_dirent_uri.h"
+#include "private/svn_fs_private.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_log.h"
 
 #include "dav_svn.h"
@@ -947,6 +953,293 @@ refresh_locks(dav_lockdb *lockdb,
 }
 
 
+/*** Bulk locking ***/
+
+/* The outcome of locking or unlocking one path. */
+typedef struct lock_outcome_t
+{
+  const char *path;
+  svn_lock_t *lock;
+  svn_error_t *err;
+} lock_outcome_t;
+
+/* Implements svn_fs__lock_callback_t, appending the outcome for PATH to
+   BATON, an array of lock_outcome_t, allocated in the array's pool. */
+static svn_error_t *
+gather_outcome(void *baton,
+               const char *path,
+               const svn_lock_t *lock,
+               svn_error_t *fs_err,
+               apr_pool_t *pool)
+{
+  apr_array_header_t *outcomes = baton;
+  lock_outcome_t *outcome = apr_array_push(outcomes);
+
+  outcome->path = apr_pstrdup(outcomes->pool, path);
+  outcome->lock = lock ? svn_lock_dup(lock, outcomes->pool) : NULL;
+  outcome->err = svn_error_dup(fs_err);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Clear the errors of the lock_outcome_t OUTCOMES. */
+static void
+clear_outcomes(apr_array_header_t *outcomes)
+{
+  int i;
+
+  for (i = 0; i < outcomes->nelts; i++)
+    svn_error_clear(APR_ARRAY_IDX(outcomes, i, lock_outcome_t).err);
+}
+
+
+/* Return the value of the attribute NAME of ELEM, or NULL. */
+static const char *
+get_attr(const apr_xml_elem *elem, const char *name)
+{
+  const apr_xml_attr *attr;
+
+  for (attr = elem->attr; attr; attr = attr->next)
+    if (strcmp(attr->name, name) == 0)
+      return attr->value;
+
+  return NULL;
+}
+
+
+/* Write an element for ERR, named NAME and with the extra attributes
+   ATTRS (either empty or starting with a space), to BB/OUTPUT. */
+static svn_error_t *
+send_error(apr_bucket_brigade *bb,
+           ap_filter_t *output,
+           const char *name,
+           const char *attrs,
+           svn_error_t *err,
+           apr_pool_t *pool)
+{
+  char errbuf[256];
+  const char *msg = svn_err_best_message(err, errbuf, sizeof(errbuf));
+
+  return dav_svn__brigade_printf(bb, output,
+                                 "<S:%s%s code=\"%d\">%s</S:%s>" DEBUG_CR,
+                                 name, attrs, err->apr_err,
+                                 apr_xml_quote_string(pool, msg, 0), name);
+}
+
+
+/* Write the element for OUTCOME to BB/OUTPUT. */
+static svn_error_t *
+send_outcome(apr_bucket_brigade *bb,
+             ap_filter_t *output,
+             const lock_outcome_t *outcome,
+             apr_pool_t *pool)
+{
+  const char *path = apr_xml_quote_string(pool, outcome->path, 1);
+  const svn_lock_t *lock = outcome->lock;
+
+  if (outcome->err)
+    return send_error(bb, output, "failed",
+                      apr_psprintf(pool, " path=\"%s\"", path),
+                      outcome->err, pool);
+
+  if (! lock)
+    return dav_svn__brigade_printf(bb, output,
+                                   "<S:unlocked path=\"%s\"/>" DEBUG_CR,
+                                   path);
+
+  SVN_ERR(dav_svn__brigade_printf(
+            bb, output,
+            "<S:locked path=\"%s\" token=\"%s\" owner=\"%s\""
+            " creationdate=\"%s\"",
+            path,
+            apr_xml_quote_string(pool, lock->token, 1),
+            apr_xml_quote_string(pool, lock->owner, 1),
+            svn_time_to_cstring(lock->creation_date, pool)));
+  if (lock->expiration_date)
+    SVN_ERR(dav_svn__brigade_printf(
+              bb, output, " expirationdate=\"%s\"",
+              svn_time_to_cstring(lock->expiration_date, pool)));
+
+  return dav_svn__brigade_puts(bb, output, "/>" DEBUG_CR);
+}
+
+
+int
+dav_svn__method_post_locks(dav_resource *resource)
+{
+  request_rec *r = resource->info->r;
+  dav_svn_repos *repos = resource->info->repos;
+  apr_pool_t *pool = resource->pool;
+  apr_xml_doc *doc;
+  apr_xml_elem *child;
+  dav_svn__authz_read_baton arb;
+  svn_repos_authz_callback_t authz_func;
+  svn_boolean_t do_lock, force;
+  const char *comment = NULL;
+  const char *value;
+  apr_hash_t *targets = apr_hash_make(pool);
+  apr_array_header_t *paths = apr_array_make(pool, 16, sizeof(const char *));
+  apr_array_header_t *outcomes = apr_array_make(pool, 16,
+                                                sizeof(lock_outcome_t));
+  apr_bucket_brigade *bb;
+  ap_filter_t *output = r->output_filters;
+  dav_error *derr = NULL;
+  svn_error_t *op_err, *serr;
+  int ns, status, i;
+
+  status = ap_xml_parse_input(r, &doc);
+  if (status != OK)
+    return status;
+
+  if (doc == NULL || doc->root == NULL)
+    return HTTP_BAD_REQUEST;
+
+  ns = dav_svn__find_ns(doc->namespaces, SVN_XML_NAMESPACE);
+  if (ns == -1 || doc->root->ns != ns)
+    return HTTP_BAD_REQUEST;
+
+  if (strcmp(doc->root->name, "lock-many") == 0)
+    do_lock = TRUE;
+  else if (strcmp(doc->root->name, "unlock-many") == 0)
+    do_lock = FALSE;
+  else
+    return HTTP_BAD_REQUEST;
+
+  value = get_attr(doc->root, do_lock ? "steal-lock" : "break-lock");
+  force = (value && strcmp(value, "true") == 0);
+
+  arb.r = r;
+  arb.repos = repos;
+  authz_func = dav_svn__authz_commit_func(&arb);
+
+  for (child = doc->root->first_child; child != NULL; child = child->next)
+    {
+      const char *path;
+      svn_boolean_t allowed = TRUE;
+
+      if (child->ns != ns)
+        continue;
+
+      if (do_lock && strcmp(child->name, "comment") == 0)
+        {
+          comment = dav_xml_get_cdata(child, pool, 0);
+          continue;
+        }
+
+      if (strcmp(child->name, do_lock ? "lock-target" : "unlock-target") != 0)
+        continue;
+
+      path = get_attr(child, "path");
+      if (! path || *path != '/')
+        return HTTP_BAD_REQUEST;
+      path = svn_uri_canonicalize(path, pool);
+      APR_ARRAY_PUSH(paths, const char *) = path;
+
+      /* As for a LOCK or UNLOCK request, mod_authz_svn's say is write
+         access to the path.  A path it refuses just fails. */
+      if (authz_func)
+        {
+          serr = authz_func(svn_authz_write, &allowed, NULL, path, &arb,
+                            pool);
+          if (serr)
+            return dav_svn__error_response_tag(
+                     r, dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                             "Failed to check path access.",
+                                             pool));
+        }
+      if (! allowed)
+        {
+          serr = svn_error_create(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
+                                  "Path is not accessible.");
+          svn_error_clear(gather_outcome(outcomes, path, NULL, serr, pool));
+          svn_error_clear(serr);
+          continue;
+        }
+
+      if (do_lock)
+        {
+          svn_fs__lock_target_t *target = apr_palloc(pool, sizeof(*target));
+
+          value = get_attr(child, "rev");
+          target->token = NULL;
+          target->current_rev = value ? SVN_STR_TO_REV(value)
+                                      : SVN_INVALID_REVNUM;
+          apr_hash_set(targets, path, APR_HASH_KEY_STRING, target);
+        }
+      else
+        {
+          /* svn_repos__fs_unlock_many() takes an empty token for none. */
+          value = get_attr(child, "token");
+          apr_hash_set(targets, path, APR_HASH_KEY_STRING,
+                       value ? value : "");
+        }
+    }
+
+  /* The pre-lock hook still runs for each path, but the post-lock hook
+     runs just once, and all paths share one trip through the FS. */
+  if (do_lock)
+    op_err = svn_repos__fs_lock_many(repos->repos, targets, comment,
+                                     FALSE /* not DAV comment */,
+                                     0 /* no expiration */, force,
+                                     gather_outcome, outcomes, pool);
+  else
+    op_err = svn_repos__fs_unlock_many(repos->repos, targets, force,
+                                       gather_outcome, outcomes, pool);
+
+  if (op_err && op_err->apr_err == SVN_ERR_FS_NO_USER)
+    {
+      svn_error_clear(op_err);
+      clear_outcomes(outcomes);
+      return dav_svn__error_response_tag(
+               r, dav_new_error(pool, HTTP_UNAUTHORIZED,
+                                DAV_ERR_LOCK_SAVE_LOCK,
+                                do_lock
+                                  ? "Anonymous lock creation is not allowed."
+                                  : "Anonymous lock removal is not allowed."));
+    }
+
+  /* Log the (un)locking as a 'high-level' action. */
+  dav_svn__operational_log(resource->info,
+                           do_lock ? svn_log__lock(paths, force, r->pool)
+                                   : svn_log__unlock(paths, force, r->pool));
+
+  r->status = HTTP_OK;
+  ap_set_content_type(r, DAV_XML_CONTENT_TYPE);
+  bb = apr_brigade_create(pool, output->c->bucket_alloc);
+
+  serr = dav_svn__brigade_puts(bb, output,
+                               DAV_XML_HEADER DEBUG_CR
+                               "<S:lock-many-response xmlns:S=\""
+                               SVN_XML_NAMESPACE "\">" DEBUG_CR);
+  for (i = 0; i < outcomes->nelts && ! serr; i++)
+    serr = send_outcome(bb, output,
+                        &APR_ARRAY_IDX(outcomes, i, lock_outcome_t), pool);
+
+  /* Whatever failed besides the single paths, such as the post-lock
+     hook, comes last. */
+  if (! serr && op_err)
+    serr = send_error(bb, output, "error", "", op_err, pool);
+  if (! serr)
+    serr = dav_svn__brigade_puts(bb, output,
+                                 "</S:lock-many-response>" DEBUG_CR);
+
+  svn_error_clear(op_err);
+  clear_outcomes(outcomes);
+
+  if (serr)
+    derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                "Error writing the lock-many response.",
+                                pool);
+
+  derr = dav_svn__final_flush_or_error(r, bb, output, derr, pool);
+  if (derr)
+    return dav_svn__error_response_tag(r, derr);
+
+  return OK;
+}
+
+
 /* The main locking vtable, provided to mod_dav */
 const dav_hooks_locks dav_svn__hooks_locks = {
   get_supportedlock,
@@ -27,6 +27,13 @@
 
 #include <httpd.h>
 #include <http_core.h>
+#include <http_protocol.h>
+#include <mod_dav.h>
+
+#include "svn_path.h"
+#include "svn_dirent_uri.h"
+#include "mod_dav_svn.h"
+#include "private/svn_dav_protocol.h"
 
 #include "dav_svn.h"
 
@@ -36,10 +43,12 @@
    specified in the SVNMasterURI Apache configuration value.
    URI_SEGMENT is the URI bits relative to the repository root (but if
    non-empty, *does* have a leading slash delimiter).
-   MASTER_URI and URI_SEGMENT are not URI-encoded. */
+   MASTER_URI and URI_SEGMENT are not URI-encoded.  If REWRITE_BODY is
+   set, rewrite the locations in the request body as well. */
 static void proxy_request_fixup(request_rec *r,
                                 const char *master_uri,
-                                const char *uri_segment)
+                                const char *uri_segment,
+                                svn_boolean_t rewrite_body)
 {
     assert((uri_segment[0] == '\0')
            || (uri_segment[0] == '/'));
@@ -53,7 +62,224 @@ static void proxy_request_fixup(request_rec *r,
     r->handler = "proxy-server";
     ap_add_output_filter("LocationRewrite", NULL, r, r->connection);
     ap_add_output_filter("ReposRewrite", NULL, r, r->connection);
-    ap_add_input_filter("IncomingRewrite", NULL, r, r->connection);
+    if (rewrite_body)
+        ap_add_input_filter("IncomingRewrite", NULL, r, r->connection);
+}
+
+
+/* Return whether R, a request against SEG (the URI bits from the
+   repository root on), belongs to an HTTPv2 commit that we build
+   ourselves to forward to the master at the MERGE.  SPECIAL_URI is
+   the configured special URI component. */
+static svn_boolean_t is_local_commit_request(request_rec *r,
+                                             const char *seg,
+                                             const char *special_uri)
+{
+    const char *dest, *content_type;
+
+    /* A batched commit some client sends us is for the master to judge,
+       and so are locks, which only the master keeps. */
+    if (r->method_number == M_POST) {
+        content_type = apr_table_get(r->headers_in, "Content-Type");
+        if (content_type
+            && (strcmp(content_type, SVN_DAV__BATCH_COMMIT_MIME_TYPE) == 0
+                || strcmp(content_type, SVN_DAV__LOCKS_MIME_TYPE) == 0))
+            return FALSE;
+
+        return ap_strstr_c(seg, apr_pstrcat(r->pool, special_uri, "/me",
+                                            NULL)) != NULL;
+    }
+
+    if (ap_strstr_c(seg, apr_pstrcat(r->pool, special_uri, "/txn/", NULL))
+        || ap_strstr_c(seg, apr_pstrcat(r->pool, special_uri, "/txr/",
+                                        NULL)))
+        return TRUE;
+
+    /* A COPY is aimed at its source, which exists here all right. */
+    dest = apr_table_get(r->headers_in, "Destination");
+    return (r->method_number == M_COPY && dest
+            && ap_strstr_c(dest, apr_pstrcat(r->pool, special_uri, "/txr/",
+                                             NULL)));
+}
+
+
+/* Read the whole body of R into *BODY, allocated in R->pool. */
+static apr_status_t read_request_body(apr_bucket_brigade **body,
+                                      request_rec *r)
+{
+    apr_bucket_brigade *bb;
+    int seen_eos = 0;
+
+    *body = apr_brigade_create(r->pool, r->connection->bucket_alloc);
+    bb = apr_brigade_create(r->pool, r->connection->bucket_alloc);
+
+    do {
+        apr_bucket *bucket;
+        apr_status_t rv;
+
+        rv = ap_get_brigade(r->input_filters, bb, AP_MODE_READBYTES,
+                            APR_BLOCK_READ, HUGE_STRING_LEN);
+        if (rv != APR_SUCCESS)
+            return rv;
+
+        while (!APR_BRIGADE_EMPTY(bb)) {
+            bucket = APR_BRIGADE_FIRST(bb);
+            if (APR_BUCKET_IS_EOS(bucket))
+                seen_eos = 1;
+
+            rv = apr_bucket_setaside(bucket, r->pool);
+            if (rv != APR_SUCCESS && rv != APR_ENOTIMPL)
+                return rv;
+
+            APR_BUCKET_REMOVE(bucket);
+            if (APR_BUCKET_IS_METADATA(bucket))
+                apr_bucket_destroy(bucket);
+            else
+                APR_BRIGADE_INSERT_TAIL(*body, bucket);
+        }
+    } while (!seen_eos);
+
+    return APR_SUCCESS;
+}
+
+
+/* Parse BODY, the body of the MERGE request R, into *DOC, or set *DOC
+   to NULL if it isn't XML. */
+static apr_status_t parse_merge_body(apr_xml_doc **doc,
+                                     apr_bucket_brigade *body,
+                                     request_rec *r)
+{
+    apr_xml_parser *parser = apr_xml_parser_create(r->pool);
+    apr_bucket *bucket;
+
+    *doc = NULL;
+    for (bucket = APR_BRIGADE_FIRST(body);
+         bucket != APR_BRIGADE_SENTINEL(body);
+         bucket = APR_BUCKET_NEXT(bucket)) {
+        const char *data;
+        apr_size_t len;
+        apr_status_t rv;
+
+        rv = apr_bucket_read(bucket, &data, &len, APR_BLOCK_READ);
+        if (rv != APR_SUCCESS)
+            return rv;
+
+        if (apr_xml_parser_feed(parser, data, len) != APR_SUCCESS) {
+            (void) apr_xml_parser_done(parser, NULL);
+            return APR_SUCCESS;
+        }
+    }
+
+    if (apr_xml_parser_done(parser, doc) != APR_SUCCESS)
+        *doc = NULL;
+
+    return APR_SUCCESS;
+}
+
+
+/* Return the name of the transaction that the MERGE request body DOC
+   names as its source, or NULL if it names something else, such as an
+   activity.  SPECIAL_URI is the configured special URI component. */
+static const char *merge_source_txn(apr_xml_doc *doc,
+                                    const char *special_uri,
+                                    request_rec *r)
+{
+    apr_xml_elem *source, *href;
+    const char *txn_name;
+    apr_uri_t uri;
+
+    if (!doc || !doc->root
+        || !(source = dav_find_child(doc->root, "source"))
+        || !(href = dav_find_child(source, "href")))
+        return NULL;
+
+    if (apr_uri_parse(r->pool, dav_xml_get_cdata(href, r->pool, 1), &uri)
+        || !uri.path)
+        return NULL;
+
+    txn_name = ap_strstr_c(svn_path_uri_decode(uri.path, r->pool),
+                           apr_pstrcat(r->pool, special_uri, "/txn/", NULL));
+    if (!txn_name)
+        return NULL;
+
+    txn_name += strlen(special_uri) + 5;
+    txn_name = apr_pstrndup(r->pool, txn_name, strcspn(txn_name, "/"));
+
+    return *txn_name ? txn_name : NULL;
+}
+
+
+/* Handle the MERGE request R in batch mode: if it merges a transaction
+   we built ourselves, turn it into a POST of the whole commit against
+   the master's 'me' resource; otherwise proxy it as usual.  ROOT_DIR,
+   MASTER_URI and SPECIAL_URI are our configuration, and SEG the URI
+   bits from the repository root on. */
+static int batch_merge_fixup(request_rec *r,
+                             const char *root_dir,
+                             const char *master_uri,
+                             const char *special_uri,
+                             const char *seg)
+{
+    apr_bucket_brigade *body;
+    apr_xml_doc *doc;
+    const char *txn_name, *fs_path, *cleaned_uri, *repos_name;
+    const char *relative_path, *repos_path;
+    int trailing_slash;
+    apr_hash_t *locks;
+    apr_off_t len;
+    apr_status_t rv;
+    dav_error *derr;
+
+    /* We have to read the body to tell, so the proxied request gets
+       what we read, one way or the other. */
+    rv = read_request_body(&body, r);
+    if (rv == APR_SUCCESS)
+        rv = parse_merge_body(&doc, body, r);
+    if (rv != APR_SUCCESS)
+        return HTTP_BAD_REQUEST;
+
+    txn_name = merge_source_txn(doc, special_uri, r);
+    if (!txn_name) {
+        proxy_request_fixup(r, master_uri, seg, TRUE);
+        ap_add_input_filter("SpooledBody", body, r, r->connection);
+        return OK;
+    }
+
+    /* The lock tokens come in the body, relative to the MERGE target. */
+    derr = dav_svn_split_uri(r, r->uri, root_dir, &cleaned_uri,
+                             &trailing_slash, &repos_name, &relative_path,
+                             &repos_path);
+    if (!derr)
+        derr = dav_svn_get_repos_path(r, root_dir, &fs_path);
+    if (!derr) {
+        apr_pool_userdata_set(doc, "svn-request-body", NULL, r->pool);
+        derr = dav_svn__build_lock_hash(&locks, r,
+                                        svn_uri_join("/", repos_path
+                                                          ? repos_path : "",
+                                                     r->pool),
+                                        r->pool);
+    }
+    if (!derr)
+        derr = dav_svn__spool_batch_commit(&body, &len, r, fs_path, txn_name,
+                                           locks);
+    if (derr)
+        return dav_svn__error_response_tag(r, derr);
+
+    r->method = "POST";
+    r->method_number = M_POST;
+    apr_table_setn(r->headers_in, "Content-Type",
+                   SVN_DAV__BATCH_COMMIT_MIME_TYPE);
+    apr_table_setn(r->headers_in, "Content-Length",
+                   apr_off_t_toa(r->pool, len));
+    apr_table_unset(r->headers_in, "Transfer-Encoding");
+
+    /* The commit is binary, with no locations in it to rewrite. */
+    proxy_request_fixup(r, master_uri,
+                        apr_pstrcat(r->pool, "/", special_uri, "/me", NULL),
+                        FALSE);
+    ap_add_input_filter("SpooledBody", body, r, r->connection);
+
+    return OK;
 }
 
 
@@ -67,6 +293,7 @@ int dav_svn__proxy_request_fixup(request_rec *r)
 
     if (root_dir && master_uri) {
         const char *seg;
+        svn_boolean_t batch = dav_svn__get_master_batch_commits_flag(r);
 
         /* We know we can always safely handle these. */
         if (r->method_number == M_REPORT ||
@@ -74,6 +301,16 @@ int dav_svn__proxy_request_fixup(request_rec *r)
             return OK;
         }
 
+        /* In batch mode, HTTPv2 commits are ours until the MERGE. */
+        seg = ap_strstr(r->uri, root_dir);
+        if (batch && seg) {
+            if (r->method_number == M_MERGE)
+                return batch_merge_fixup(r, root_dir, master_uri, special_uri,
+                                         seg + strlen(root_dir));
+            if (is_local_commit_request(r, seg, special_uri))
+                return OK;
+        }
+
         /* These are read-only requests -- the kind we like to handle
            ourselves -- but we need to make sure they aren't aimed at
            resources that only exist on the master server such as
@@ -89,7 +326,7 @@ int dav_svn__proxy_request_fixup(request_rec *r)
                     || ap_strstr_c(seg, apr_pstrcat(r->pool, special_uri,
                                                     "/txr/", NULL))) {
                     seg += strlen(root_dir);
-                    proxy_request_fixup(r, master_uri, seg);
+                    proxy_request_fixup(r, master_uri, seg, TRUE);
                 }
             }
             return OK;
@@ -104,13 +341,47 @@ int dav_svn__proxy_request_fixup(request_rec *r)
                     r->method_number == M_UNLOCK ||
                     ap_strstr_c(seg, special_uri))) {
             seg += strlen(root_dir);
-            proxy_request_fixup(r, master_uri, seg);
+            proxy_request_fixup(r, master_uri, seg, TRUE);
             return OK;
         }
     }
     return OK;
 }
 
+
+apr_status_t dav_svn__spooled_body_in_filter(ap_filter_t *f,
+                                             apr_bucket_brigade *bb,
+                                             ap_input_mode_t mode,
+                                             apr_read_type_e block,
+                                             apr_off_t readbytes)
+{
+    apr_bucket_brigade *body = f->ctx;
+    apr_bucket *after;
+    apr_status_t rv;
+
+    if (mode != AP_MODE_READBYTES)
+        return APR_ENOTIMPL;
+
+    if (APR_BRIGADE_EMPTY(body)) {
+        APR_BRIGADE_INSERT_TAIL(bb, apr_bucket_eos_create(bb->bucket_alloc));
+        return APR_SUCCESS;
+    }
+
+    rv = apr_brigade_partition(body, readbytes, &after);
+    if (rv != APR_SUCCESS && rv != APR_INCOMPLETE)
+        return rv;
+
+    while (APR_BRIGADE_FIRST(body) != after) {
+        apr_bucket *bucket = APR_BRIGADE_FIRST(body);
+
+        APR_BUCKET_REMOVE(bucket);
+        APR_BRIGADE_INSERT_TAIL(bb, bucket);
+    }
+
+    return APR_SUCCESS;
+}
+
+
 typedef struct locate_ctx_t
 {
     const apr_strmatch_pattern *pattern;
@@ -28,6 +28,7 @@
 #include <http_config.h>
 #include <http_request.h>
 #include <http_log.h>
+#include <http_protocol.h>
 #include <ap_provider.h>
 #include <mod_dav.h>
 
@@ -37,6 +38,9 @@
 #include "svn_dso.h"
 #include "mod_dav_svn.h"
 
+#include "private/svn_cache.h"
+#include "private/svn_fs_private.h"
+
 #include "dav_svn.h"
 #include "mod_authz_svn.h"
 
@@ -85,7 +89,9 @@ typedef struct {
   enum conf_flag list_parentpath;    /* whether to allow GET of parentpath */
   const char *root_dir;              /* our top-level directory */
   const char *master_uri;            /* URI to the master SVN repos */
+  enum conf_flag master_batch_commits; /* whether to forward whole commits */
   const char *activities_db;         /* path to activities database(s) */
+  apr_int64_t slow_request_threshold; /* log slower requests (ms), or 0 */
 } dir_conf_t;
 
 
@@ -98,6 +104,9 @@ extern module AP_MODULE_DECLARE_DATA dav_svn_module;
 /* The authz_svn provider for bypassing path authz. */
 static authz_svn__subreq_bypass_func_t pathauthz_bypass_func = NULL;
 
+/* The authz_svn provider telling whether a subtree is readable. */
+static authz_svn__subtree_readable_func_t pathauthz_subtree_func = NULL;
+
 static int
 init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
 {
@@ -116,9 +125,32 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
   /* This returns void, so we can't check for error. */
   svn_utf_initialize(p);
 
+  /* Allocate the FSFS cache now, before the MPM forks its children,
+   * so that all of them share it. */
+  {
+    svn_cache__config_t settings = *svn_cache__get_global_config();
+
+    settings.shared = TRUE;
+    serr = svn_cache__set_global_config(&settings);
+    if (serr)
+      {
+        ap_log_perror(APLOG_MARK, APLOG_WARNING, serr->apr_err, p,
+                      "mod_dav_svn: error creating the shared cache: '%s'",
+                      serr->message ? serr->message : "(no more info)");
+        svn_error_clear(serr);
+      }
+  }
+
   return OK;
 }
 
+/* Implements the #child_init hook. */
+static void
+init_child(apr_pool_t *p, server_rec *s)
+{
+  dav_svn__init_repos_pool(p);
+}
+
 static int
 init_dso(apr_pool_t *pconf, apr_pool_t *plog, apr_pool_t *ptemp)
 {
@@ -195,7 +227,11 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
 
   newconf->fs_path = INHERIT_VALUE(parent, child, fs_path);
   newconf->master_uri = INHERIT_VALUE(parent, child, master_uri);
+  newconf->master_batch_commits = INHERIT_VALUE(parent, child,
+                                                master_batch_commits);
   newconf->activities_db = INHERIT_VALUE(parent, child, activities_db);
+  newconf->slow_request_threshold = INHERIT_VALUE(parent, child,
+                                                  slow_request_threshold);
   newconf->repo_name = INHERIT_VALUE(parent, child, repo_name);
   newconf->xslt_uri = INHERIT_VALUE(parent, child, xslt_uri);
   newconf->fs_parent_path = INHERIT_VALUE(parent, child, fs_parent_path);
@@ -241,6 +277,20 @@ SVNMasterURI_cmd(cmd_parms *cmd, void *config, const char *arg1)
 }
 
 
+static const char *
+SVNMasterBatchCommits_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->master_batch_commits = CONF_FLAG_ON;
+  else
+    conf->master_batch_commits = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+
 static const char *
 SVNActivitiesDB_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -320,6 +370,11 @@ SVNPathAuthz_cmd(cmd_parms *cmd, void *config, const char *arg1)
                                           AUTHZ_SVN__SUBREQ_BYPASS_PROV_GRP,
                                           AUTHZ_SVN__SUBREQ_BYPASS_PROV_NAME,
                                           AUTHZ_SVN__SUBREQ_BYPASS_PROV_VER);
+      if (pathauthz_subtree_func == NULL)
+        pathauthz_subtree_func=ap_lookup_provider(
+                                       AUTHZ_SVN__SUBTREE_READABLE_PROV_GRP,
+                                       AUTHZ_SVN__SUBTREE_READABLE_PROV_NAME,
+                                       AUTHZ_SVN__SUBTREE_READABLE_PROV_VER);
     }
   else
     conf->path_authz_method = CONF_PATHAUTHZ_ON;
@@ -342,6 +397,51 @@ SVNListParentPath_cmd(cmd_parms *cmd, void *config, int arg)
 }
 
 
+static const char *
+SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  svn_cache__config_t settings = *svn_cache__get_global_config();
+  char *end;
+  apr_int64_t value = apr_strtoi64(arg1, &end, 10);
+
+  if (*arg1 == '\0' || *end != '\0' || value < 0)
+    return "Invalid decimal number for the SVN in-memory cache size";
+
+  settings.cache_size = (apr_uint64_t)value * 0x400; /* in kBytes */
+  svn_error_clear(svn_cache__set_global_config(&settings));
+
+  return NULL;
+}
+
+
+static const char *
+SVNCacheFullTexts_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  svn_cache__config_t settings = *svn_cache__get_global_config();
+
+  settings.cache_fulltexts = arg;
+  svn_error_clear(svn_cache__set_global_config(&settings));
+
+  return NULL;
+}
+
+
+static const char *
+SVNSlowRequestThreshold_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  char *end;
+  apr_int64_t value = apr_strtoi64(arg1, &end, 10);
+
+  if (*arg1 == '\0' || *end != '\0' || value < 0)
+    return "Invalid decimal number for the SVN slow request threshold";
+
+  conf->slow_request_threshold = value;
+
+  return NULL;
+}
+
+
 static const char *
 SVNPath_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -501,6 +601,16 @@ dav_svn__get_master_uri(request_rec *r)
 }
 
 
+svn_boolean_t
+dav_svn__get_master_batch_commits_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->master_batch_commits == CONF_FLAG_ON;
+}
+
+
 const char *
 dav_svn__get_xslt_uri(request_rec *r)
 {
@@ -613,6 +723,20 @@ dav_svn__get_pathauthz_bypass(request_rec *r)
   return NULL;
 }
 
+/* Function pointer to ask mod_authz_svn whether a subtree is readable if
+ * we bypass to it directly.  NULL otherwise. */
+authz_svn__subtree_readable_func_t
+dav_svn__get_pathauthz_subtree_readable(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  if (conf->path_authz_method==CONF_PATHAUTHZ_BYPASS)
+    return pathauthz_subtree_func;
+  return NULL;
+}
+
 
 svn_boolean_t
 dav_svn__get_list_parentpath_flag(request_rec *r)
@@ -634,6 +758,118 @@ dav_svn__get_activities_db(request_rec *r)
 }
 
 
+apr_interval_time_t
+dav_svn__get_slow_request_threshold(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->slow_request_threshold * 1000;
+}
+
+
+/** Request statistics **/
+
+void
+dav_svn__start_request_stats(request_rec *r, svn_fs_t *fs)
+{
+  dav_svn__request_stats_t *stats;
+  apr_hash_t *ignored;
+
+  if (r->main || ap_get_module_config(r->request_config, &dav_svn_module))
+    return;
+
+  stats = apr_pcalloc(r->pool, sizeof(*stats));
+  stats->start = apr_time_now();
+  stats->fs = fs;
+  ap_set_module_config(r->request_config, &dav_svn_module, stats);
+
+  /* The FS is used by no other request while this one runs, so its cache
+     counters count this request's accesses from here on. */
+  svn_error_clear(svn_fs__get_cache_info(&ignored, fs, TRUE, r->pool));
+
+  ap_add_output_filter("SVN-STATS", stats, r, r->connection);
+}
+
+
+dav_svn__request_stats_t *
+dav_svn__get_request_stats(request_rec *r)
+{
+  while (r->main)
+    r = r->main;
+
+  return ap_get_module_config(r->request_config, &dav_svn_module);
+}
+
+
+apr_status_t
+dav_svn__stats_output_filter(ap_filter_t *f,
+                             apr_bucket_brigade *bb)
+{
+  dav_svn__request_stats_t *stats = f->ctx;
+  apr_time_t start = apr_time_now();
+  apr_status_t status = ap_pass_brigade(f->next, bb);
+
+  stats->send_time += apr_time_now() - start;
+  return status;
+}
+
+
+int
+dav_svn__log_request_stats(request_rec *r)
+{
+  dav_svn__request_stats_t *stats;
+  apr_interval_time_t elapsed, threshold;
+  apr_uint64_t gets = 0, hits = 0;
+  apr_hash_t *caches;
+  const char *line;
+
+  stats = ap_get_module_config(r->request_config, &dav_svn_module);
+  if (stats == NULL)
+    return DECLINED;
+
+  elapsed = apr_time_now() - stats->start;
+
+  if (svn_fs__get_cache_info(&caches, stats->fs, FALSE, r->pool) == NULL)
+    {
+      apr_hash_index_t *hi;
+
+      for (hi = apr_hash_first(r->pool, caches); hi; hi = apr_hash_next(hi))
+        {
+          const svn_cache__info_t *info = svn__apr_hash_index_val(hi);
+
+          gets += info->gets;
+          hits += info->hits;
+        }
+    }
+
+  /* "svn" is the time spent in Subversion itself, i.e. everything but
+     waiting for the client to take the response. */
+  line = apr_psprintf(r->pool,
+                      "time=%" APR_TIME_T_FMT " svn=%" APR_TIME_T_FMT
+                      " send=%" APR_TIME_T_FMT " bytes=%" APR_OFF_T_FMT
+                      " cache-hits=%" APR_UINT64_T_FMT
+                      " cache-misses=%" APR_UINT64_T_FMT
+                      " authz=%" APR_UINT64_T_FMT " nodes=%" APR_UINT64_T_FMT,
+                      elapsed, elapsed - stats->send_time, stats->send_time,
+                      r->bytes_sent, hits, gets - hits,
+                      stats->authz_checks, stats->nodes);
+  apr_table_set(r->subprocess_env, "SVN-STATS", line);
+
+  threshold = dav_svn__get_slow_request_threshold(r);
+  if (threshold > 0 && elapsed >= threshold)
+    {
+      const char *action = apr_table_get(r->subprocess_env, "SVN-ACTION");
+
+      ap_log_rerror(APLOG_MARK, APLOG_WARNING, 0, r,
+                    "Slow request '%s': %s",
+                    action ? action : r->the_request, line);
+    }
+
+  return DECLINED;
+}
+
+
 static void
 merge_xml_filter_insert(request_rec *r)
 {
@@ -768,6 +1004,50 @@ static int dav_svn__handler(request_rec *r)
 }
 
 
+/* Response handler for locations configured with "SetHandler
+   svn-cache-stats": report the usage statistics of the process-wide
+   membuffer cache as plain text.  The FSFS caches of the individual
+   repositories live only as long as the request that opened them, so
+   the membuffer they share is what gives a picture of the server. */
+static int dav_svn__cache_stats_handler(request_rec *r)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__info_t info;
+  svn_error_t *serr;
+
+  if (r->handler == NULL || strcmp(r->handler, "svn-cache-stats") != 0)
+    return DECLINED;
+
+  r->allowed = (AP_METHOD_BIT << M_GET);
+  if (r->method_number != M_GET)
+    return HTTP_METHOD_NOT_ALLOWED;
+
+  ap_set_content_type(r, "text/plain");
+  if (r->header_only)
+    return OK;
+
+  membuffer = svn_cache__get_global_membuffer_cache();
+  if (membuffer == NULL)
+    {
+      ap_rputs("membuffer: disabled\n", r);
+      return OK;
+    }
+
+  serr = svn_cache__membuffer_get_info(membuffer, &info, FALSE, r->pool);
+  if (serr)
+    {
+      ap_log_rerror(APLOG_MARK, APLOG_ERR, serr->apr_err, r,
+                    "Can't read cache statistics: %s", serr->message);
+      svn_error_clear(serr);
+      return HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+  ap_rprintf(r, "%s\n",
+             svn_cache__format_info("membuffer", &info, r->pool)->data);
+  return OK;
+}
+
+
 
 
 
@@ -819,6 +1099,12 @@ static const command_rec cmds[] =
   AP_INIT_TAKE1("SVNMasterURI", SVNMasterURI_cmd, NULL, ACCESS_CONF,
                 "specifies a URI to access a master Subversion repository"),
 
+  /* per directory/location */
+  AP_INIT_FLAG("SVNMasterBatchCommits", SVNMasterBatchCommits_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "build HTTPv2 commits locally and forward each to the master "
+               "as a single request (default is Off)."),
+
   /* per directory/location */
   AP_INIT_TAKE1("SVNActivitiesDB", SVNActivitiesDB_cmd, NULL, ACCESS_CONF,
                 "specifies the location in the filesystem in which the "
@@ -837,6 +1123,26 @@ static const command_rec cmds[] =
                "enables server advertising of support for version 2 of "
                "Subversion's HTTP protocol (default values is On)."),
 
+  /* per server */
+  AP_INIT_TAKE1("SVNInMemoryCacheSize", SVNInMemoryCacheSize_cmd, NULL,
+                RSRC_CONF,
+                "specifies the size in kB of Subversion's in-memory object "
+                "cache which is shared by all server processes (default "
+                "value is 16384; 0 disables the cache)."),
+
+  /* per server */
+  AP_INIT_FLAG("SVNCacheFullTexts", SVNCacheFullTexts_cmd, NULL,
+               RSRC_CONF,
+               "enables or disables caching of file contents "
+               "(default is On)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNSlowRequestThreshold", SVNSlowRequestThreshold_cmd, NULL,
+                ACCESS_CONF|RSRC_CONF,
+                "specifies the time in milliseconds above which a request "
+                "is logged to the error log as slow (default value is 0, "
+                "which logs none)."),
+
   { NULL }
 };
 
@@ -858,6 +1164,7 @@ register_hooks(apr_pool_t *pconf)
 {
   ap_hook_pre_config(init_dso, NULL, NULL, APR_HOOK_REALLY_FIRST);
   ap_hook_post_config(init, NULL, NULL, APR_HOOK_MIDDLE);
+  ap_hook_child_init(init_child, NULL, NULL, APR_HOOK_MIDDLE);
 
   /* our provider */
   dav_register_provider(pconf, "svn", &provider);
@@ -871,6 +1178,9 @@ register_hooks(apr_pool_t *pconf)
   /* general request handler for methods which mod_dav DECLINEs. */
   ap_hook_handler(dav_svn__handler, NULL, NULL, APR_HOOK_LAST);
 
+  /* cache statistics, see SetHandler svn-cache-stats */
+  ap_hook_handler(dav_svn__cache_stats_handler, NULL, NULL, APR_HOOK_MIDDLE);
+
   /* live property handling */
   dav_hook_gather_propsets(dav_svn__gather_propsets, NULL, NULL,
                            APR_HOOK_MIDDLE);
@@ -886,7 +1196,16 @@ register_hooks(apr_pool_t *pconf)
                             NULL, AP_FTYPE_CONTENT_SET);
   ap_register_input_filter("IncomingRewrite", dav_svn__location_in_filter,
                            NULL, AP_FTYPE_CONTENT_SET);
+  ap_register_input_filter("SpooledBody", dav_svn__spooled_body_in_filter,
+                           NULL, AP_FTYPE_PROTOCOL);
   ap_hook_fixups(dav_svn__proxy_request_fixup, NULL, NULL, APR_HOOK_MIDDLE);
+
+  /* Request statistics for the operational log; they must be in place
+     before mod_log_config writes the log. */
+  ap_register_output_filter("SVN-STATS", dav_svn__stats_output_filter,
+                            NULL, AP_FTYPE_TRANSCODE);
+  ap_hook_log_transaction(dav_svn__log_request_stats, NULL, NULL,
+                          APR_HOOK_FIRST);
 }
 
 
@@ -23,6 +23,7 @@
 
 #include <apr_pools.h>
 #include <apr_strings.h>
+#include <apr_time.h>
 #include <apr_xml.h>
 
 #include <mod_dav.h>
@@ -41,6 +42,11 @@
 #include "../dav_svn.h"
 
 
+/* Log items are pushed to the client at least this often (in
+   microseconds), even if they would not fill a buffer yet. */
+#define FLUSH_INTERVAL apr_time_from_msec(500)
+
+
 struct log_receiver_baton
 {
   /* this buffers the output for a bit and is automatically flushed,
@@ -60,6 +66,9 @@ struct log_receiver_baton
 
   /* whether the client requested any custom revprops */
   svn_boolean_t requested_custom_revprops;
+
+  /* When we last flushed the output, or 0 if we never did. */
+  apr_time_t last_flush;
 };
 
 
@@ -123,31 +132,48 @@ log_receiver(void *baton,
           svn_pool_clear(iterpool);
           apr_hash_this(hi, (void *)&name, NULL, (void *)&value);
           if (strcmp(name, SVN_PROP_REVISION_AUTHOR) == 0)
-            SVN_ERR(dav_svn__brigade_printf
-                    (lrb->bb, lrb->output,
-                     "<D:creator-displayname>%s</D:creator-displayname>"
-                     DEBUG_CR,
-                     apr_xml_quote_string(iterpool, value->data, 0)));
+            {
+              SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
+                                            "<D:creator-displayname>"));
+              SVN_ERR(dav_svn__brigade_xml_quote(lrb->bb, lrb->output,
+                                                 value->data, FALSE));
+              SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
+                                            "</D:creator-displayname>"
+                                            DEBUG_CR));
+            }
           else if (strcmp(name, SVN_PROP_REVISION_DATE) == 0)
-            /* ### this should be DAV:creation-date, but we need to format
-               ### that date a bit differently */
-            SVN_ERR(dav_svn__brigade_printf
-                    (lrb->bb, lrb->output,
-                     "<S:date>%s</S:date>" DEBUG_CR,
-                     apr_xml_quote_string(iterpool, value->data, 0)));
+            {
+              /* ### this should be DAV:creation-date, but we need to format
+                 ### that date a bit differently */
+              SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
+                                            "<S:date>"));
+              SVN_ERR(dav_svn__brigade_xml_quote(lrb->bb, lrb->output,
+                                                 value->data, FALSE));
+              SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
+                                            "</S:date>" DEBUG_CR));
+            }
           else if (strcmp(name, SVN_PROP_REVISION_LOG) == 0)
-            SVN_ERR(dav_svn__brigade_printf
-                    (lrb->bb, lrb->output,
-                     "<D:comment>%s</D:comment>" DEBUG_CR,
-                     apr_xml_quote_string(pool,
-                                          svn_xml_fuzzy_escape(value->data,
-                                                               iterpool), 0)));
+            {
+              SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
+                                            "<D:comment>"));
+              SVN_ERR(dav_svn__brigade_xml_quote
+                      (lrb->bb, lrb->output,
+                       svn_xml_fuzzy_escape(value->data, iterpool), FALSE));
+              SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
+                                            "</D:comment>" DEBUG_CR));
+            }
           else
-            SVN_ERR(dav_svn__brigade_printf
-                    (lrb->bb, lrb->output,
-                     "<S:revprop name=\"%s\">%s</S:revprop>" DEBUG_CR,
-                     apr_xml_quote_string(iterpool, name, 0),
-                     apr_xml_quote_string(iterpool, value->data, 0)));
+            {
+              SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
+                                            "<S:revprop name=\""));
+              SVN_ERR(dav_svn__brigade_xml_quote(lrb->bb, lrb->output,
+                                                 name, FALSE));
+              SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output, "\">"));
+              SVN_ERR(dav_svn__brigade_xml_quote(lrb->bb, lrb->output,
+                                                 value->data, FALSE));
+              SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
+                                            "</S:revprop>" DEBUG_CR));
+            }
         }
     }
 
@@ -233,16 +259,21 @@ log_receiver(void *baton,
           /* If we need to close the element, then send the attributes
              that apply to all changed items and then close the element. */
           if (close_element)
-            SVN_ERR(dav_svn__brigade_printf
-                    (lrb->bb, lrb->output,
-                     " node-kind=\"%s\""
-                     " text-mods=\"%s\""
-                     " prop-mods=\"%s\">%s</%s>" DEBUG_CR,
-                     svn_node_kind_to_word(log_item->node_kind),
-                     svn_tristate_to_word(log_item->text_modified),
-                     svn_tristate_to_word(log_item->props_modified),
-                     apr_xml_quote_string(iterpool, path, 0),
-                     close_element));
+            {
+              SVN_ERR(dav_svn__brigade_printf
+                      (lrb->bb, lrb->output,
+                       " node-kind=\"%s\""
+                       " text-mods=\"%s\""
+                       " prop-mods=\"%s\">",
+                       svn_node_kind_to_word(log_item->node_kind),
+                       svn_tristate_to_word(log_item->text_modified),
+                       svn_tristate_to_word(log_item->props_modified)));
+              SVN_ERR(dav_svn__brigade_xml_quote(lrb->bb, lrb->output,
+                                                 path, FALSE));
+              SVN_ERR(dav_svn__brigade_printf(lrb->bb, lrb->output,
+                                              "</%s>" DEBUG_CR,
+                                              close_element));
+            }
         }
     }
 
@@ -251,6 +282,16 @@ log_receiver(void *baton,
   SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
                                 "</S:log-item>" DEBUG_CR));
 
+  /* Scanning the history of a path that rarely changes may take a while
+     between two items.  Don't let the client wait for a buffer to fill
+     up; it may only want the first few of them.  The flush also notices
+     early when the client has hung up, which ends the scan. */
+  if (apr_time_now() - lrb->last_flush >= FLUSH_INTERVAL)
+    {
+      SVN_ERR(dav_svn__brigade_flush(lrb->bb, lrb->output));
+      lrb->last_flush = apr_time_now();
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -374,6 +415,7 @@ dav_svn__log_report(const dav_resource *resource,
   lrb.output = output;
   lrb.needs_header = TRUE;
   lrb.stack_depth = 0;
+  lrb.last_flush = 0;
   /* lrb.requested_custom_revprops set above */
 
   /* Our svn_log_entry_receiver_t sends the <S:log-report> header in
@@ -42,11 +42,15 @@
 #include "../dav_svn.h"
 
 
+/* Number of files sent between explicit flushes of the response. */
+#define FLUSH_INTERVAL_FILES 64
+
 typedef struct {
   apr_bucket_brigade *bb;
   ap_filter_t *output;
   svn_boolean_t started;
   svn_boolean_t sending_textdelta;
+  int unflushed_files;
 } edit_baton_t;
 
 
@@ -92,6 +96,21 @@ maybe_close_textdelta(edit_baton_t *eb)
 }
 
 
+/* Push the report written so far down the filter chain every
+   FLUSH_INTERVAL_FILES files.  Filters that buffer their input, such as
+   compression, would otherwise hold on to an ever growing part of the
+   replay of large revisions. */
+static svn_error_t *
+maybe_flush(edit_baton_t *eb)
+{
+  if (++eb->unflushed_files < FLUSH_INTERVAL_FILES)
+    return SVN_NO_ERROR;
+
+  eb->unflushed_files = 0;
+  return dav_svn__brigade_flush(eb->bb, eb->output);
+}
+
+
 static svn_error_t *
 add_file_or_directory(const char *file_or_directory,
                       const char *path,
@@ -348,7 +367,7 @@ close_file(void *file_baton, const char *text_checksum, apr_pool_t *pool)
   else
     SVN_ERR(dav_svn__brigade_puts(eb->bb, eb->output, "/>" DEBUG_CR));
 
-  return SVN_NO_ERROR;
+  return maybe_flush(eb);
 }
 
 
@@ -375,6 +394,7 @@ make_editor(const svn_delta_editor_t **editor,
   eb->output = output;
   eb->started = FALSE;
   eb->sending_textdelta = FALSE;
+  eb->unflushed_files = 0;
 
   e->set_target_revision = set_target_revision;
   e->open_root = open_root;
@@ -26,6 +26,7 @@
 #include <apr_xml.h>
 
 #include <http_request.h>
+#include <http_protocol.h>
 #include <http_log.h>
 #include <mod_dav.h>
 
@@ -78,8 +79,15 @@ typedef struct {
   /* True iff client requested all data inline in the report. */
   svn_boolean_t send_all;
 
+  /* True iff client requested the report in the binary encoding (which
+     implies SEND_ALL). */
+  svn_boolean_t binary;
+
   /* SVNDIFF version to send to client.  */
   int svndiff_version;
+
+  /* The statistics of the request, counting the nodes; may be NULL. */
+  dav_svn__request_stats_t *stats;
 } update_ctx_t;
 
 typedef struct item_baton_t {
@@ -183,6 +191,9 @@ make_child_baton(item_baton_t *parent, const char *path, apr_pool_t *pool)
   baton->name = svn_relpath_basename(path, pool);
   baton->parent = parent;
 
+  if (baton->uc->stats)
+    baton->uc->stats->nodes++;
+
   /* Telescope the path based on uc->anchor.  */
   baton->path = svn_uri_join(parent->path, baton->name, pool);
 
@@ -243,6 +254,9 @@ absent_helper(svn_boolean_t is_dir,
 {
   update_ctx_t *uc = parent->uc;
 
+  if (uc->stats)
+    uc->stats->nodes++;
+
   if (! uc->resource_walk)
     {
       SVN_ERR(dav_svn__brigade_printf
@@ -290,10 +304,12 @@ add_helper(svn_boolean_t is_dir,
 
   if (uc->resource_walk)
     {
-      SVN_ERR(dav_svn__brigade_printf(child->uc->bb, child->uc->output,
-                                      "<S:resource path=\"%s\">" DEBUG_CR,
-                                      apr_xml_quote_string(pool, child->path3,
-                                                           1)));
+      SVN_ERR(dav_svn__brigade_puts(child->uc->bb, child->uc->output,
+                                    "<S:resource path=\""));
+      SVN_ERR(dav_svn__brigade_xml_quote(child->uc->bb, child->uc->output,
+                                         child->path3, TRUE));
+      SVN_ERR(dav_svn__brigade_puts(child->uc->bb, child->uc->output,
+                                    "\">" DEBUG_CR));
     }
   else
     {
@@ -504,13 +520,20 @@ maybe_start_update_report(update_ctx_t *uc)
 {
   if ((! uc->resource_walk) && (! uc->started_update))
     {
-      SVN_ERR(dav_svn__brigade_printf(uc->bb, uc->output,
-                                      DAV_XML_HEADER DEBUG_CR
-                                      "<S:update-report xmlns:S=\""
-                                      SVN_XML_NAMESPACE "\" "
-                                      "xmlns:V=\"" SVN_DAV_PROP_NS_DAV "\" "
-                                      "xmlns:D=\"DAV:\" %s>" DEBUG_CR,
-                                      uc->send_all ? "send-all=\"true\"" : ""));
+      /* A binary report has no preamble, just a different type.
+         Nothing has been written yet, so it is not too late to set it. */
+      if (uc->binary)
+        ap_set_content_type(uc->resource->info->r,
+                            SVN_DAV__BINARY_UPDATE_MIME_TYPE);
+      else
+        SVN_ERR(dav_svn__brigade_printf(uc->bb, uc->output,
+                                        DAV_XML_HEADER DEBUG_CR
+                                        "<S:update-report xmlns:S=\""
+                                        SVN_XML_NAMESPACE "\" "
+                                        "xmlns:V=\"" SVN_DAV_PROP_NS_DAV "\" "
+                                        "xmlns:D=\"DAV:\" %s>" DEBUG_CR,
+                                        uc->send_all
+                                          ? "send-all=\"true\"" : ""));
 
       uc->started_update = TRUE;
     }
@@ -557,12 +580,19 @@ upd_open_root(void *edit_baton,
 
   *root_baton = b;
 
+  if (uc->stats)
+    uc->stats->nodes++;
+
   SVN_ERR(maybe_start_update_report(uc));
 
   if (uc->resource_walk)
-    SVN_ERR(dav_svn__brigade_printf(uc->bb, uc->output,
-                                    "<S:resource path=\"%s\">" DEBUG_CR,
-                                    apr_xml_quote_string(pool, b->path3, 1)));
+    {
+      SVN_ERR(dav_svn__brigade_puts(uc->bb, uc->output,
+                                    "<S:resource path=\""));
+      SVN_ERR(dav_svn__brigade_xml_quote(uc->bb, uc->output,
+                                         b->path3, TRUE));
+      SVN_ERR(dav_svn__brigade_puts(uc->bb, uc->output, "\">" DEBUG_CR));
+    }
   else
     SVN_ERR(dav_svn__brigade_printf(uc->bb, uc->output,
                                     "<S:open-directory rev=\"%ld\">" DEBUG_CR,
@@ -591,6 +621,10 @@ upd_delete_entry(const char *path,
   const char *qname = apr_xml_quote_string(pool,
                                            svn_relpath_basename(path, pool),
                                            1);
+
+  if (parent->uc->stats)
+    parent->uc->stats->nodes++;
+
   return dav_svn__brigade_printf(parent->uc->bb, parent->uc->output,
                                  "<S:delete-entry name=\"%s\"/>" DEBUG_CR,
                                  qname);
@@ -901,6 +935,375 @@ upd_close_edit(void *edit_baton, apr_pool_t *pool)
 }
 
 
+/*** The binary encoding of the report.
+
+   Instead of XML, the response is a sequence of records, each a one
+   byte SVN_DAV__BIN_* code followed by the length of the rest of the
+   record as a 4-byte big-endian number.  The rest of the record is a
+   sequence of fields, each also a 4-byte length followed by that many
+   bytes, except for SVN_DAV__BIN_SVNDIFF_CHUNK, whose payload is raw
+   svndiff data.  The records follow the editor drive one to one, so no
+   closing tags, escaping or base64 are needed.  ***/
+
+
+/* Store N at BUF as a 4-byte big-endian number. */
+static void
+encode_length(char *buf, apr_size_t n)
+{
+  buf[0] = (char)((n >> 24) & 0xff);
+  buf[1] = (char)((n >> 16) & 0xff);
+  buf[2] = (char)((n >> 8) & 0xff);
+  buf[3] = (char)(n & 0xff);
+}
+
+
+/* Send a record with code CODE made of the NFIELDS FIELDS to UC's
+   output. */
+static svn_error_t *
+send_record(update_ctx_t *uc,
+            char code,
+            int nfields,
+            const svn_string_t *const *fields)
+{
+  char header[5];
+  apr_size_t len = 0;
+  int i;
+
+  for (i = 0; i < nfields; i++)
+    len += 4 + fields[i]->len;
+
+  header[0] = code;
+  encode_length(header + 1, len);
+  SVN_ERR(dav_svn__brigade_write(uc->bb, uc->output, header, 5));
+
+  for (i = 0; i < nfields; i++)
+    {
+      encode_length(header, fields[i]->len);
+      SVN_ERR(dav_svn__brigade_write(uc->bb, uc->output, header, 4));
+      SVN_ERR(dav_svn__brigade_write(uc->bb, uc->output,
+                                     fields[i]->data, fields[i]->len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Send a record with code CODE whose fields are the NULL-terminated
+   list of C strings that follow, to UC's output.  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+send_cstring_record(update_ctx_t *uc,
+                    char code,
+                    apr_pool_t *pool,
+                    ...)
+{
+  const svn_string_t *fields[3];
+  const char *field;
+  int nfields = 0;
+  va_list ap;
+
+  va_start(ap, pool);
+  while (nfields < (int)(sizeof(fields) / sizeof(fields[0]))
+         && (field = va_arg(ap, const char *)) != NULL)
+    fields[nfields++] = svn_string_create(field, pool);
+  va_end(ap);
+
+  return send_record(uc, code, nfields, fields);
+}
+
+
+/* Send the version resource URL of BATON, as send_vsn_url() does. */
+static svn_error_t *
+bin_send_vsn_url(item_baton_t *baton, apr_pool_t *pool)
+{
+  const char *path = get_real_fs_path(baton, pool);
+  svn_revnum_t revision = dav_svn__get_safe_cr(baton->uc->rev_root, path,
+                                               pool);
+  const char *href = dav_svn__build_uri(baton->uc->resource->info->repos,
+                                        DAV_SVN__BUILD_URI_VERSION,
+                                        revision, path, 0 /* add_href */,
+                                        pool);
+
+  return send_cstring_record(baton->uc, SVN_DAV__BIN_CHECKED_IN, pool,
+                             href, NULL);
+}
+
+
+static svn_error_t *
+bin_set_target_revision(void *edit_baton,
+                        svn_revnum_t target_revision,
+                        apr_pool_t *pool)
+{
+  update_ctx_t *uc = edit_baton;
+
+  SVN_ERR(maybe_start_update_report(uc));
+  return send_cstring_record(uc, SVN_DAV__BIN_TARGET_REVISION, pool,
+                             apr_ltoa(pool, target_revision), NULL);
+}
+
+
+static svn_error_t *
+bin_open_root(void *edit_baton,
+              svn_revnum_t base_revision,
+              apr_pool_t *pool,
+              void **root_baton)
+{
+  update_ctx_t *uc = edit_baton;
+  item_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+
+  b->uc = uc;
+  b->pool = pool;
+  b->path = uc->anchor;
+  b->path2 = uc->dst_path;
+  b->path3 = "";
+  *root_baton = b;
+
+  SVN_ERR(maybe_start_update_report(uc));
+  SVN_ERR(send_cstring_record(uc, SVN_DAV__BIN_OPEN_ROOT, pool,
+                              apr_ltoa(pool, base_revision), NULL));
+
+  /* As in upd_open_root(), only when there's no target. */
+  if (! *uc->target)
+    SVN_ERR(bin_send_vsn_url(b, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+bin_delete_entry(const char *path,
+                 svn_revnum_t revision,
+                 void *parent_baton,
+                 apr_pool_t *pool)
+{
+  item_baton_t *parent = parent_baton;
+
+  return send_cstring_record(parent->uc, SVN_DAV__BIN_DELETE_ENTRY, pool,
+                             svn_relpath_basename(path, pool), NULL);
+}
+
+
+static svn_error_t *
+bin_add_helper(char code,
+               const char *path,
+               item_baton_t *parent,
+               const char *copyfrom_path,
+               svn_revnum_t copyfrom_revision,
+               apr_pool_t *pool,
+               void **child_baton)
+{
+  item_baton_t *child = make_child_baton(parent, path, pool);
+
+  SVN_ERR(send_cstring_record(child->uc, code, pool, child->name,
+                              copyfrom_path,
+                              copyfrom_path
+                                ? apr_ltoa(pool, copyfrom_revision) : NULL,
+                              NULL));
+  SVN_ERR(bin_send_vsn_url(child, pool));
+
+  *child_baton = child;
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+bin_open_helper(char code,
+                const char *path,
+                item_baton_t *parent,
+                svn_revnum_t base_revision,
+                apr_pool_t *pool,
+                void **child_baton)
+{
+  item_baton_t *child = make_child_baton(parent, path, pool);
+
+  SVN_ERR(send_cstring_record(child->uc, code, pool, child->name,
+                              apr_ltoa(pool, base_revision), NULL));
+  SVN_ERR(bin_send_vsn_url(child, pool));
+
+  *child_baton = child;
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+bin_add_directory(const char *path,
+                  void *parent_baton,
+                  const char *copyfrom_path,
+                  svn_revnum_t copyfrom_revision,
+                  apr_pool_t *pool,
+                  void **child_baton)
+{
+  return bin_add_helper(SVN_DAV__BIN_ADD_DIR, path, parent_baton,
+                        copyfrom_path, copyfrom_revision, pool, child_baton);
+}
+
+
+static svn_error_t *
+bin_open_directory(const char *path,
+                   void *parent_baton,
+                   svn_revnum_t base_revision,
+                   apr_pool_t *pool,
+                   void **child_baton)
+{
+  return bin_open_helper(SVN_DAV__BIN_OPEN_DIR, path, parent_baton,
+                         base_revision, pool, child_baton);
+}
+
+
+static svn_error_t *
+bin_add_file(const char *path,
+             void *parent_baton,
+             const char *copyfrom_path,
+             svn_revnum_t copyfrom_revision,
+             apr_pool_t *pool,
+             void **file_baton)
+{
+  return bin_add_helper(SVN_DAV__BIN_ADD_FILE, path, parent_baton,
+                        copyfrom_path, copyfrom_revision, pool, file_baton);
+}
+
+
+static svn_error_t *
+bin_open_file(const char *path,
+              void *parent_baton,
+              svn_revnum_t base_revision,
+              apr_pool_t *pool,
+              void **file_baton)
+{
+  return bin_open_helper(SVN_DAV__BIN_OPEN_FILE, path, parent_baton,
+                         base_revision, pool, file_baton);
+}
+
+
+/* The property value goes out as is, so unlike upd_change_xxx_prop()
+   this needs to worry neither about escaping nor about entry props. */
+static svn_error_t *
+bin_change_xxx_prop(void *baton,
+                    const char *name,
+                    const svn_string_t *value,
+                    apr_pool_t *pool)
+{
+  item_baton_t *b = baton;
+  const svn_string_t *fields[2];
+
+  fields[0] = svn_string_create(name, pool);
+  fields[1] = value;
+
+  return send_record(b->uc, SVN_DAV__BIN_CHANGE_PROP, value ? 2 : 1, fields);
+}
+
+
+static svn_error_t *
+bin_absent_directory(const char *path, void *parent_baton, apr_pool_t *pool)
+{
+  item_baton_t *parent = parent_baton;
+
+  return send_cstring_record(parent->uc, SVN_DAV__BIN_ABSENT_DIR, pool,
+                             svn_relpath_basename(path, pool), NULL);
+}
+
+
+static svn_error_t *
+bin_absent_file(const char *path, void *parent_baton, apr_pool_t *pool)
+{
+  item_baton_t *parent = parent_baton;
+
+  return send_cstring_record(parent->uc, SVN_DAV__BIN_ABSENT_FILE, pool,
+                             svn_relpath_basename(path, pool), NULL);
+}
+
+
+static svn_error_t *
+bin_close_directory(void *dir_baton, apr_pool_t *pool)
+{
+  item_baton_t *b = dir_baton;
+
+  return send_record(b->uc, SVN_DAV__BIN_CLOSE_DIR, 0, NULL);
+}
+
+
+/* This implements 'svn_write_fn_t', sending the data as a chunk of
+   svndiff. */
+static svn_error_t *
+bin_svndiff_write(void *baton, const char *data, apr_size_t *len)
+{
+  update_ctx_t *uc = baton;
+  char header[5];
+
+  header[0] = SVN_DAV__BIN_SVNDIFF_CHUNK;
+  encode_length(header + 1, *len);
+  SVN_ERR(dav_svn__brigade_write(uc->bb, uc->output, header, 5));
+
+  return dav_svn__brigade_write(uc->bb, uc->output, data, *len);
+}
+
+
+/* This implements 'svn_txdelta_window_handler_t', marking the end of
+   the svndiff data after the real handler has flushed it. */
+static svn_error_t *
+bin_window_handler(svn_txdelta_window_t *window, void *baton)
+{
+  struct window_handler_baton *wb = baton;
+
+  SVN_ERR(wb->handler(window, wb->handler_baton));
+
+  if (window == NULL)
+    SVN_ERR(send_record(wb->uc, SVN_DAV__BIN_TEXTDELTA_END, 0, NULL));
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+bin_apply_textdelta(void *file_baton,
+                    const char *base_checksum,
+                    apr_pool_t *pool,
+                    svn_txdelta_window_handler_t *handler,
+                    void **handler_baton)
+{
+  item_baton_t *file = file_baton;
+  struct window_handler_baton *wb;
+  svn_stream_t *stream;
+
+  SVN_ERR(send_cstring_record(file->uc, SVN_DAV__BIN_APPLY_TEXTDELTA, pool,
+                              base_checksum, NULL));
+
+  wb = apr_palloc(file->pool, sizeof(*wb));
+  wb->seen_first_window = FALSE;
+  wb->uc = file->uc;
+
+  stream = svn_stream_create(file->uc, file->pool);
+  svn_stream_set_write(stream, bin_svndiff_write);
+  svn_txdelta_to_svndiff2(&(wb->handler), &(wb->handler_baton),
+                          stream, file->uc->svndiff_version, file->pool);
+
+  *handler = bin_window_handler;
+  *handler_baton = wb;
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+bin_close_file(void *file_baton, const char *text_checksum, apr_pool_t *pool)
+{
+  item_baton_t *file = file_baton;
+
+  return send_cstring_record(file->uc, SVN_DAV__BIN_CLOSE_FILE, pool,
+                             text_checksum, NULL);
+}
+
+
+static svn_error_t *
+bin_close_edit(void *edit_baton, apr_pool_t *pool)
+{
+  update_ctx_t *uc = edit_baton;
+
+  SVN_ERR(maybe_start_update_report(uc));
+  return send_record(uc, SVN_DAV__BIN_CLOSE_EDIT, 0, NULL);
+}
+
+
 /* Return a specific error associated with the contents of TAGNAME
    being malformed.  Use pool for allocations.  */
 static dav_error *
@@ -984,7 +1387,12 @@ dav_svn__update_report(const dav_resource *resource,
               && (strcmp(this_attr->value, "true") == 0))
             {
               uc.send_all = TRUE;
-              break;
+            }
+          else if ((strcmp(this_attr->name, "binary") == 0)
+                   && (strcmp(this_attr->value, "true") == 0))
+            {
+              uc.send_all = TRUE;
+              uc.binary = TRUE;
             }
         }
     }
@@ -1111,6 +1519,11 @@ dav_svn__update_report(const dav_resource *resource,
   if (!saw_depth && !saw_recursive && (requested_depth == svn_depth_unknown))
     requested_depth = svn_depth_infinity;
 
+  /* The binary encoding has no room for a resource walk, and a client
+     asking for it gets the new version resource URLs inline anyway. */
+  if (uc.binary)
+    resource_walk = FALSE;
+
   /* If the client never sent a <src-path> element, it's old and
      sending a style of report that we no longer allow. */
   if (! src_path)
@@ -1137,6 +1550,7 @@ dav_svn__update_report(const dav_resource *resource,
 
   uc.svndiff_version = resource->info->svndiff_version;
   uc.resource = resource;
+  uc.stats = dav_svn__get_request_stats(resource->info->r);
   uc.output = output;
   uc.anchor = src_path;
   uc.target = target;
@@ -1187,21 +1601,42 @@ dav_svn__update_report(const dav_resource *resource,
      case of an update or status, these paths should be identical.  In
      the case of a switch, they should be different. */
   editor = svn_delta_default_editor(resource->pool);
-  editor->set_target_revision = upd_set_target_revision;
-  editor->open_root = upd_open_root;
-  editor->delete_entry = upd_delete_entry;
-  editor->add_directory = upd_add_directory;
-  editor->open_directory = upd_open_directory;
-  editor->change_dir_prop = upd_change_xxx_prop;
-  editor->close_directory = upd_close_directory;
-  editor->absent_directory = upd_absent_directory;
-  editor->add_file = upd_add_file;
-  editor->open_file = upd_open_file;
-  editor->apply_textdelta = upd_apply_textdelta;
-  editor->change_file_prop = upd_change_xxx_prop;
-  editor->close_file = upd_close_file;
-  editor->absent_file = upd_absent_file;
-  editor->close_edit = upd_close_edit;
+  if (uc.binary)
+    {
+      editor->set_target_revision = bin_set_target_revision;
+      editor->open_root = bin_open_root;
+      editor->delete_entry = bin_delete_entry;
+      editor->add_directory = bin_add_directory;
+      editor->open_directory = bin_open_directory;
+      editor->change_dir_prop = bin_change_xxx_prop;
+      editor->close_directory = bin_close_directory;
+      editor->absent_directory = bin_absent_directory;
+      editor->add_file = bin_add_file;
+      editor->open_file = bin_open_file;
+      editor->apply_textdelta = bin_apply_textdelta;
+      editor->change_file_prop = bin_change_xxx_prop;
+      editor->close_file = bin_close_file;
+      editor->absent_file = bin_absent_file;
+      editor->close_edit = bin_close_edit;
+    }
+  else
+    {
+      editor->set_target_revision = upd_set_target_revision;
+      editor->open_root = upd_open_root;
+      editor->delete_entry = upd_delete_entry;
+      editor->add_directory = upd_add_directory;
+      editor->open_directory = upd_open_directory;
+      editor->change_dir_prop = upd_change_xxx_prop;
+      editor->close_directory = upd_close_directory;
+      editor->absent_directory = upd_absent_directory;
+      editor->add_file = upd_add_file;
+      editor->open_file = upd_open_file;
+      editor->apply_textdelta = upd_apply_textdelta;
+      editor->change_file_prop = upd_change_xxx_prop;
+      editor->close_file = upd_close_file;
+      editor->absent_file = upd_absent_file;
+      editor->close_edit = upd_close_edit;
+    }
   if ((serr = svn_repos_begin_report2(&rbaton, revnum,
                                       repos->repos,
                                       src_path, target,
@@ -1488,8 +1923,9 @@ dav_svn__update_report(const dav_resource *resource,
     }
 
   /* Close the report body, unless some error prevented it from being
-     started in the first place. */
-  if (uc.started_update)
+     started in the first place.  A binary report was closed along with
+     the edit. */
+  if (uc.started_update && ! uc.binary)
     {
       if ((serr = dav_svn__brigade_puts(uc.bb, uc.output,
                                         "</S:update-report>" DEBUG_CR)))
@@ -1508,6 +1944,28 @@ dav_svn__update_report(const dav_resource *resource,
   if (derr && rbaton)
     svn_error_clear(svn_repos_abort_report(rbaton, resource->pool));
 
+  /* Once a binary report has started, the status line is long gone, so
+     tell the client what went wrong with a record of its own: a code and
+     a message for each error in the chain, outermost first. */
+  if (derr && uc.binary && uc.started_update)
+    {
+      apr_array_header_t *fields = apr_array_make(resource->pool, 4,
+                                                  sizeof(svn_string_t *));
+      dav_error *err;
+
+      for (err = derr; err; err = err->prev)
+        {
+          APR_ARRAY_PUSH(fields, const svn_string_t *)
+            = svn_string_create(apr_itoa(resource->pool, err->error_id),
+                                resource->pool);
+          APR_ARRAY_PUSH(fields, const svn_string_t *)
+            = svn_string_create(err->desc ? err->desc : "", resource->pool);
+        }
+
+      svn_error_clear(send_record(&uc, SVN_DAV__BIN_ERROR, fields->nelts,
+                                  (const svn_string_t *const *)fields->elts));
+    }
+
   /* Destroy our subpool. */
   svn_pool_destroy(subpool);
 
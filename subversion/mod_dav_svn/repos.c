@@ -26,6 +26,7 @@
 #include <apr_strings.h>
 #include <apr_hash.h>
 #include <apr_lib.h>
+#include <apr_thread_mutex.h>
 
 #include <httpd.h>
 #include <http_request.h>
@@ -48,6 +49,7 @@
 #include "svn_ra.h"  /* for SVN_RA_CAPABILITY_* */
 #include "svn_dirent_uri.h"
 #include "private/svn_log.h"
+#include "private/svn_dav_protocol.h"
 
 #include "dav_svn.h"
 
@@ -164,6 +166,8 @@ parse_version_uri(dav_resource_combined *comb,
   if (comb->priv.root.rev == SVN_INVALID_REVNUM)
     return TRUE;
 
+  comb->priv.immutable = TRUE;
+
   return FALSE;
 }
 
@@ -373,6 +377,7 @@ parse_baseline_coll_uri(dav_resource_combined *comb,
   comb->res.versioned = TRUE;
   comb->priv.root.rev = revnum;
   comb->priv.repos_path = slash;
+  comb->priv.immutable = TRUE;
 
   return FALSE;
 }
@@ -1416,6 +1421,155 @@ cleanup_fs_access(void *data)
 }
 
 
+/* Open repositories that no connection is using at the moment, kept for
+   the next connection to the same repository so that the in-process
+   caches of its filesystem stay warm and it needn't be opened again.
+   Maps const char * filesystem paths to arrays of svn_repos_t *.  The
+   hash and the arrays are allocated in IDLE_REPOS_POOL, the repositories
+   in subpools of it; all of them, and IDLE_REPOS_POOL itself, are only
+   touched with IDLE_REPOS_MUTEX held. */
+static apr_hash_t *idle_repos = NULL;
+static apr_pool_t *idle_repos_pool = NULL;
+#if APR_HAS_THREADS
+static apr_thread_mutex_t *idle_repos_mutex = NULL;
+#endif
+
+
+/* Lock IDLE_REPOS_MUTEX. */
+static svn_error_t *
+lock_idle_repos(void)
+{
+#if APR_HAS_THREADS
+  apr_status_t status = apr_thread_mutex_lock(idle_repos_mutex);
+  if (status)
+    return svn_error_wrap_apr(status, "Can't lock the repository pool");
+#endif
+  return SVN_NO_ERROR;
+}
+
+/* Unlock IDLE_REPOS_MUTEX. */
+static void
+unlock_idle_repos(void)
+{
+#if APR_HAS_THREADS
+  apr_thread_mutex_unlock(idle_repos_mutex);
+#endif
+}
+
+
+void
+dav_svn__init_repos_pool(apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+#if APR_HAS_THREADS
+  if (apr_thread_mutex_create(&idle_repos_mutex, APR_THREAD_MUTEX_DEFAULT,
+                              subpool) != APR_SUCCESS)
+    {
+      /* Without the mutex, every connection opens its own repository. */
+      svn_pool_destroy(subpool);
+      return;
+    }
+#endif
+
+  idle_repos = apr_hash_make(subpool);
+  idle_repos_pool = subpool;
+}
+
+
+/* A repository checked out of IDLE_REPOS by a connection. */
+struct checked_out_repos_t
+{
+  /* The element of IDLE_REPOS to return it to. */
+  apr_array_header_t *stack;
+
+  svn_repos_t *repos;
+};
+
+
+/* Pool cleanup handler.  Return the repository checked out in DATA, a
+   struct checked_out_repos_t *, to IDLE_REPOS when the connection that
+   used it goes away. */
+static apr_status_t
+return_repos(void *data)
+{
+  struct checked_out_repos_t *baton = data;
+  svn_error_t *serr = lock_idle_repos();
+
+  if (serr)
+    {
+      /* The repository stays open but unused until the process exits. */
+      svn_error_clear(serr);
+      return APR_SUCCESS;
+    }
+
+  APR_ARRAY_PUSH(baton->stack, svn_repos_t *) = baton->repos;
+  unlock_idle_repos();
+
+  return APR_SUCCESS;
+}
+
+
+/* Set *REPOS_P to the repository at FS_PATH for the connection whose pool
+   is CONN_POOL: one taken from IDLE_REPOS if there is one, or a newly
+   opened one.  It is returned to IDLE_REPOS when CONN_POOL is cleaned up,
+   and no other connection uses it until then.  If the repository pool
+   wasn't set up, simply open the repository in CONN_POOL. */
+static svn_error_t *
+checkout_repos(svn_repos_t **repos_p,
+               const char *fs_path,
+               apr_pool_t *conn_pool)
+{
+  struct checked_out_repos_t *baton;
+  apr_pool_t *repos_pool = NULL;
+  svn_error_t *serr;
+
+  if (idle_repos_pool == NULL)
+    return svn_repos_open2(repos_p, fs_path, NULL, conn_pool);
+
+  baton = apr_palloc(conn_pool, sizeof(*baton));
+  baton->repos = NULL;
+
+  SVN_ERR(lock_idle_repos());
+  baton->stack = apr_hash_get(idle_repos, fs_path, APR_HASH_KEY_STRING);
+  if (baton->stack == NULL)
+    {
+      baton->stack = apr_array_make(idle_repos_pool, 1,
+                                    sizeof(svn_repos_t *));
+      apr_hash_set(idle_repos, apr_pstrdup(idle_repos_pool, fs_path),
+                   APR_HASH_KEY_STRING, baton->stack);
+    }
+  if (baton->stack->nelts > 0)
+    baton->repos = *(svn_repos_t **)apr_array_pop(baton->stack);
+  else
+    repos_pool = svn_pool_create(idle_repos_pool);
+  unlock_idle_repos();
+
+  if (baton->repos == NULL)
+    {
+      /* Nobody else uses REPOS_POOL, so we needn't hold the mutex while
+         opening the repository in it. */
+      serr = svn_repos_open2(&baton->repos, fs_path, NULL, repos_pool);
+      if (serr)
+        {
+          svn_error_t *lock_err = lock_idle_repos();
+
+          if (lock_err)
+            return svn_error_compose_create(serr, lock_err);
+
+          svn_pool_destroy(repos_pool);
+          unlock_idle_repos();
+          return serr;
+        }
+    }
+
+  apr_pool_cleanup_register(conn_pool, baton, return_repos,
+                            apr_pool_cleanup_null);
+  *repos_p = baton->repos;
+  return SVN_NO_ERROR;
+}
+
+
 /* Helper func to construct a special 'parentpath' private resource. */
 static dav_error *
 get_parentpath_resource(request_rec *r,
@@ -2094,10 +2248,10 @@ get_resource(request_rec *r,
   repos->repos = userdata;
   if (repos->repos == NULL)
     {
-      serr = svn_repos_open(&(repos->repos), fs_path, r->connection->pool);
+      serr = checkout_repos(&(repos->repos), fs_path, r->connection->pool);
       if (serr != NULL)
         {
-          /* The error returned by svn_repos_open might contain the
+          /* The error returned by svn_repos_open2 might contain the
              actual path to the failed repository.  We don't want to
              leak that path back to the client, because that would be
              a security risk, but we do want to log the real error on
@@ -2111,8 +2265,10 @@ get_resource(request_rec *r,
       apr_pool_userdata_set(repos->repos, repos_key,
                             NULL, r->connection->pool);
 
-      /* Store the capabilities of the current connection, making sure
-         to use the same pool repos->repos itself was created in. */
+      /* Store the capabilities of the current connection.  The repos
+         object may have served other connections before, so this
+         replaces whatever they stored; the list lives as long as this
+         connection has the repos checked out. */
       serr = svn_repos_remember_client_capabilities
         (repos->repos, capabilities_as_list(repos->client_capabilities,
                                             r->connection->pool));
@@ -2128,6 +2284,9 @@ get_resource(request_rec *r,
   /* cache the filesystem object */
   repos->fs = svn_repos_fs(repos->repos);
 
+  /* what the request costs goes to the operational log */
+  dav_svn__start_request_stats(r, repos->fs);
+
   /* capture warnings during cleanup of the FS */
   svn_fs_set_warning_func(repos->fs, log_warning, r);
 
@@ -2887,6 +3046,33 @@ dav_svn__getetag(const dav_resource *resource, apr_pool_t *pool)
 
   /* ### what kind of etag to return for activities, etc.? */
 
+  /* The full text of a file at a fixed revision never changes, so give it
+     an etag derived from its content, which stays the same across the
+     different URLs that name it and lets caches revalidate cheaply.  An
+     svndiff against some delta base is a different representation, which
+     keeps the etag below. */
+  if (resource->info->immutable && ! resource->collection
+      && resource->info->delta_base == NULL)
+    {
+      svn_checksum_t *checksum;
+
+      serr = svn_fs_file_checksum(&checksum, svn_checksum_sha1,
+                                  resource->info->root.root,
+                                  resource->info->repos_path, FALSE, pool);
+      if (! serr && ! checksum)
+        serr = svn_fs_file_checksum(&checksum, svn_checksum_md5,
+                                    resource->info->root.root,
+                                    resource->info->repos_path, TRUE, pool);
+      if (! serr)
+        return apr_psprintf(pool, "\"%s:%s\"",
+                            checksum->kind == svn_checksum_sha1
+                              ? "sha1" : "md5",
+                            svn_checksum_to_cstring(checksum, pool));
+
+      /* Fall back to the etag every other resource gets. */
+      svn_error_clear(serr);
+    }
+
   if ((serr = svn_fs_node_created_rev(&created_rev, resource->info->root.root,
                                       resource->info->repos_path,
                                       pool)))
@@ -2940,14 +3126,13 @@ set_headers(request_rec *r, const dav_resource *resource)
   apr_table_setn(r->headers_out, "ETag",
                  dav_svn__getetag(resource, resource->pool));
 
-#if 0
-  /* As version resources don't change, encourage caching. */
-  /* ### FIXME: This conditional is wrong -- type is often REGULAR,
-     ### and the resource doesn't seem to be baselined. */
-  if (resource->type == DAV_RESOURCE_TYPE_VERSION)
-    /* Cache resource for one week (specified in seconds). */
-    apr_table_setn(r->headers_out, "Cache-Control", "max-age=604800");
-#endif
+  /* As files at a fixed revision don't change, encourage caching.  We
+     don't say "public": a shared cache must still not hand responses to
+     authenticated requests to anyone else. */
+  if (resource->info->immutable && ! resource->collection)
+    /* Cache resource for one year (specified in seconds). */
+    apr_table_setn(r->headers_out, "Cache-Control",
+                   "max-age=31536000, immutable");
 
   /* we accept byte-ranges */
   apr_table_setn(r->headers_out, "Accept-Ranges", "bytes");
@@ -3410,6 +3595,24 @@ deliver(const dav_resource *resource, ap_filter_t *output)
       return NULL;
     }
 
+  /* mod_dav doesn't evaluate the conditional headers of a GET itself.  A
+     client or cache revalidating a file at a fixed revision against the
+     etag set_headers() gave it can be spared the content. */
+  if (resource->info->immutable && resource->info->delta_base == NULL
+      && ap_meets_conditions(resource->info->r) == HTTP_NOT_MODIFIED)
+    {
+      resource->info->r->status = HTTP_NOT_MODIFIED;
+
+      bb = apr_brigade_create(resource->pool, output->c->bucket_alloc);
+      bkt = apr_bucket_eos_create(output->c->bucket_alloc);
+      APR_BRIGADE_INSERT_TAIL(bb, bkt);
+      if ((status = ap_pass_brigade(output, bb)) != APR_SUCCESS)
+        return dav_new_error(resource->pool, HTTP_INTERNAL_SERVER_ERROR, 0,
+                             "Could not write EOS to filter.");
+
+      return NULL;
+    }
+
 
   /* If we have a base for a delta, then we want to compute an svndiff
      between the provided base and the requested resource. For a simple
@@ -4295,6 +4498,7 @@ int dav_svn__method_post(request_rec *r)
   dav_resource *resource;
   dav_error *derr;
   const char *txn_name;
+  const char *content_type;
 
   derr = get_resource(r, dav_svn__get_root_dir(r),
                       "ignored", 0, &resource);
@@ -4304,8 +4508,27 @@ int dav_svn__method_post(request_rec *r)
   if (resource->info->restype != DAV_SVN_RESTYPE_ME)
     return HTTP_BAD_REQUEST;
 
-  /* Create a Subversion repository transaction based on HEAD. */
-  derr = dav_svn__create_txn(resource->info->repos, &txn_name, resource->pool);
+  /* A mirror forwarding a whole commit at once. */
+  content_type = apr_table_get(r->headers_in, "Content-Type");
+  if (content_type
+      && strcmp(content_type, SVN_DAV__BATCH_COMMIT_MIME_TYPE) == 0)
+    return dav_svn__method_post_batch(resource);
+
+  /* A client locking or unlocking many paths at once. */
+  if (content_type
+      && strcmp(content_type, SVN_DAV__LOCKS_MIME_TYPE) == 0)
+    return dav_svn__method_post_locks(resource);
+
+  /* Create a Subversion repository transaction based on HEAD.  A mirror
+     forwarding its commits to the master keeps the transaction to
+     itself until the MERGE. */
+  if (dav_svn__get_master_uri(r)
+      && dav_svn__get_master_batch_commits_flag(r))
+    derr = dav_svn__create_batch_txn(resource->info->repos, &txn_name,
+                                     resource->pool);
+  else
+    derr = dav_svn__create_txn(resource->info->repos, &txn_name,
+                               resource->pool);
   if (derr)
     return dav_svn__error_response_tag(r, derr);
 
@@ -453,6 +453,74 @@ dav_svn__brigade_printf(apr_bucket_brigade *bb,
 }
 
 
+svn_error_t *
+dav_svn__brigade_xml_quote(apr_bucket_brigade *bb,
+                           ap_filter_t *output,
+                           const char *str,
+                           svn_boolean_t quotes)
+{
+  const char *p = str;
+  apr_status_t apr_err;
+
+  while (1)
+    {
+      const char *entity;
+      const char *q = p;
+
+      /* Write out the run of characters which need no quoting. */
+      while (*q && *q != '&' && *q != '<' && *q != '>'
+             && (! quotes || *q != '"'))
+        q++;
+      if (q > p)
+        {
+          apr_err = apr_brigade_write(bb, ap_filter_flush, output, p, q - p);
+          if (apr_err)
+            return svn_error_create(apr_err, 0, NULL);
+        }
+
+      if (*q == '\0')
+        break;
+
+      if (*q == '&')
+        entity = "&amp;";
+      else if (*q == '<')
+        entity = "&lt;";
+      else if (*q == '>')
+        entity = "&gt;";
+      else
+        entity = "&quot;";
+
+      apr_err = apr_brigade_puts(bb, ap_filter_flush, output, entity);
+      if (apr_err)
+        return svn_error_create(apr_err, 0, NULL);
+
+      p = q + 1;
+    }
+
+  /* Check for an aborted connection, since the brigade functions don't
+     appear to be return useful errors when the connection is dropped. */
+  if (output->c->aborted)
+    return svn_error_create(SVN_ERR_APMOD_CONNECTION_ABORTED, 0, NULL);
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+dav_svn__brigade_flush(apr_bucket_brigade *bb,
+                       ap_filter_t *output)
+{
+  apr_status_t apr_err;
+  apr_err = ap_fflush(output, bb);
+  if (apr_err)
+    return svn_error_create(apr_err, 0, NULL);
+  /* Check for an aborted connection, since the brigade functions don't
+     appear to be return useful errors when the connection is dropped. */
+  if (output->c->aborted)
+    return svn_error_create(SVN_ERR_APMOD_CONNECTION_ABORTED, 0, NULL);
+  return SVN_NO_ERROR;
+}
+
+
 
 
 dav_error *
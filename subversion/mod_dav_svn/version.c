@@ -143,6 +143,8 @@ get_vsn_options(apr_pool_t *p, apr_text_header *phdr)
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_DEPTH);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_LOG_REVPROPS);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_PARTIAL_REPLAY);
+  apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_BINARY_UPDATE);
+  apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_LOCK_MANY);
   /* Mergeinfo is a special case: here we merely say that the server
    * knows how to handle mergeinfo -- whether the repository does too
    * is a separate matter.
@@ -787,7 +789,7 @@ cleanup_deltify(void *data)
      subpool, then destroy it before exiting. */
   apr_pool_t *subpool = svn_pool_create(cdb->pool);
 
-  err = svn_repos_open(&repos, cdb->repos_path, subpool);
+  err = svn_repos_open2(&repos, cdb->repos_path, NULL, subpool);
   if (err)
     {
       ap_log_perror(APLOG_MARK, APLOG_ERR, err->apr_err, cdb->pool,
@@ -823,10 +825,10 @@ cleanup_deltify(void *data)
    revision against which to deltify.  POOL is both the pool on which
    to register the cleanup function and the pool that will be used for
    temporary allocations while deltifying. */
-static void
-register_deltification_cleanup(svn_repos_t *repos,
-                               svn_revnum_t revision,
-                               apr_pool_t *pool)
+void
+dav_svn__register_deltification_cleanup(svn_repos_t *repos,
+                                        svn_revnum_t revision,
+                                        apr_pool_t *pool)
 {
   struct cleanup_deltify_baton *cdb = apr_palloc(pool, sizeof(*cdb));
 
@@ -946,9 +948,9 @@ dav_svn__checkin(dav_resource *resource,
                             NULL, resource->info->r->pool);
 
       /* Commit was successful, so schedule deltification. */
-      register_deltification_cleanup(resource->info->repos->repos,
-                                     new_rev,
-                                     resource->info->r->connection->pool);
+      dav_svn__register_deltification_cleanup(
+        resource->info->repos->repos, new_rev,
+        resource->info->r->connection->pool);
 
       /* If caller wants it, return the new VR that was created by
          the checkin. */
@@ -1268,14 +1270,11 @@ dav_svn__push_locks(dav_resource *resource,
 }
 
 
-/* Helper for merge().  Free every lock in LOCKS.  The locks
-   live in REPOS.  Log any errors for REQUEST.  Use POOL for temporary
-   work.*/
-static svn_error_t *
-release_locks(apr_hash_t *locks,
-              svn_repos_t *repos,
-              request_rec *r,
-              apr_pool_t *pool)
+svn_error_t *
+dav_svn__release_locks(apr_hash_t *locks,
+                       svn_repos_t *repos,
+                       request_rec *r,
+                       apr_pool_t *pool)
 {
   apr_hash_index_t *hi;
   const void *key;
@@ -1411,8 +1410,9 @@ merge(dav_resource *target,
     }
 
   /* Commit was successful, so schedule deltification. */
-  register_deltification_cleanup(source->info->repos->repos, new_rev,
-                                 source->info->r->connection->pool);
+  dav_svn__register_deltification_cleanup(source->info->repos->repos,
+                                          new_rev,
+                                          source->info->r->connection->pool);
 
   /* We've detected a 'high level' svn action to log. */
   dav_svn__operational_log(target->info,
@@ -1441,8 +1441,8 @@ merge(dav_resource *target,
                                 SVN_DAV_OPTION_RELEASE_LOCKS)))
           && apr_hash_count(locks))
         {
-          serr = release_locks(locks, source->info->repos->repos,
-                               source->info->r, pool);
+          serr = dav_svn__release_locks(locks, source->info->repos->repos,
+                                        source->info->r, pool);
           if (serr != NULL)
             return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
                                         "Error releasing locks", pool);
@@ -35,6 +35,7 @@
 #include "cl.h"
 
 #include "svn_private_config.h"
+#include "private/svn_client_private.h"
 
 
 /*** Code. ***/
@@ -112,6 +113,10 @@ svn_cl__checkout(apr_getopt_t *os,
         return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL);
     }
 
+  if (opt_state->lazy && opt_state->force)
+    return svn_error_create(SVN_ERR_CL_MUTUALLY_EXCLUSIVE_ARGS, NULL,
+                            _("--lazy and --force are mutually exclusive"));
+
   if (! opt_state->quiet)
     SVN_ERR(svn_cl__get_notifier(&ctx->notify_func2, &ctx->notify_baton2, TRUE,
                                  FALSE, FALSE, pool));
@@ -163,7 +168,14 @@ svn_cl__checkout(apr_getopt_t *os,
           revision.kind = svn_opt_revision_head;
       }
 
-      SVN_ERR(svn_client_checkout3
+      if (opt_state->lazy)
+        SVN_ERR(svn_client__checkout_lazy(NULL, true_url, target_dir,
+                                          &peg_revision, &revision,
+                                          opt_state->depth,
+                                          opt_state->ignore_externals,
+                                          ctx, subpool));
+      else
+        SVN_ERR(svn_client_checkout3
               (NULL, true_url, target_dir,
                &peg_revision,
                &revision,
@@ -228,6 +228,7 @@ typedef struct svn_cl__opt_state_t
                                       patching */
   svn_boolean_t show_diff;        /* produce diff output */
   svn_boolean_t internal_diff;    /* override diff_cmd in config file */
+  svn_boolean_t lazy;             /* check out without file contents */
 } svn_cl__opt_state_t;
 
 
@@ -252,6 +253,7 @@ svn_opt_subcommand_t
   svn_cl__diff,
   svn_cl__export,
   svn_cl__help,
+  svn_cl__hydrate,
   svn_cl__import,
   svn_cl__info,
   svn_cl__lock,
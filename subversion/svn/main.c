@@ -121,6 +121,7 @@ typedef enum {
   opt_ignore_whitespace,
   opt_show_diff,
   opt_internal_diff,
+  opt_lazy,
 } svn_cl__longopt_t;
 
 /* Option codes and descriptions for the command line client.
@@ -196,7 +197,13 @@ const apr_getopt_option_t svn_cl__options[] =
                        "                            "
                        "    -p (--show-c-function):\n"
                        "                            "
-                       "       Show C function name in diff output.")},
+                       "       Show C function name in diff output.\n"
+                       "                            "
+                       "    --histogram:\n"
+                       "                            "
+                       "       Use histogram diff, which is faster on files\n"
+                       "                            "
+                       "       with many repeated lines.")},
   {"targets",       opt_targets, 1,
                     N_("pass contents of file ARG as additional args")},
   {"depth",         opt_depth, 1,
@@ -367,6 +374,10 @@ const apr_getopt_option_t svn_cl__options[] =
                        N_("override diff-cmd specified in config file\n"
                        "                             "
                        "[alias: --idiff]")},
+  {"lazy",          opt_lazy, 0,
+                    N_("check out files without their contents\n"
+                       "                             "
+                       "(see 'svn help hydrate')")},
   /* Long-opt Aliases
    *
    * These have NULL desriptions, but an option code that matches some
@@ -486,9 +497,13 @@ const svn_opt_subcommand_desc2_t svn_cl__cmd_table[] =
      "  to the working copy.  All properties from the repository are applied\n"
      "  to the obstructing path.\n"
      "\n"
+     "  If --lazy is used, only the checksums of the files are recorded and\n"
+     "  the files are left out of the working copy until 'svn hydrate'\n"
+     "  fetches them.  Externals are checked out as usual.\n"
+     "\n"
      "  See also 'svn help update' for a list of possible characters\n"
      "  reporting the action taken.\n"),
-    {'r', 'q', 'N', opt_depth, opt_force, opt_ignore_externals} },
+    {'r', 'q', 'N', opt_depth, opt_force, opt_ignore_externals, opt_lazy} },
 
   { "cleanup", svn_cl__cleanup, {0}, N_
     ("Recursively clean up the working copy, removing locks, resuming\n"
@@ -600,6 +615,15 @@ const svn_opt_subcommand_desc2_t svn_cl__cmd_table[] =
     {0} },
   /* This command is also invoked if we see option "--help", "-h" or "-?". */
 
+  { "hydrate", svn_cl__hydrate, {0}, N_
+    ("Fetch the files left out by 'svn checkout --lazy'.\n"
+     "usage: hydrate [PATH...]\n"
+     "\n"
+     "  Until a file has been fetched, it is missing from the working copy\n"
+     "  but shown as unmodified, and it can't be edited, diffed, reverted\n"
+     "  or blamed.  'svn update' fetches the files it changes on its own.\n"),
+    {'q', opt_depth} },
+
   { "import", svn_cl__import, {0}, N_
     ("Commit an unversioned file or tree into the repository.\n"
      "usage: import [PATH] URL\n"
@@ -1764,6 +1788,9 @@ main(int argc, const char *argv[])
       case opt_internal_diff:
         opt_state.internal_diff = TRUE;
         break;
+      case opt_lazy:
+        opt_state.lazy = TRUE;
+        break;
       default:
         /* Hmmm. Perhaps this would be a good place to squirrel away
            opts that commands like svn diff might need. Hmmm indeed. */
@@ -22,8 +22,13 @@
  */
 
 
+#include <string.h>
+
 #include <apr_file_io.h>
 #include <apr_signal.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 
 #include "svn_pools.h"
 #include "svn_cmdline.h"
@@ -40,7 +45,10 @@
 #include "svn_props.h"
 #include "svn_time.h"
 #include "svn_user.h"
+#include "svn_sorts.h"
 
+#include "private/svn_cache.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_opt_private.h"
 
 #include "svn_private_config.h"
@@ -107,6 +115,220 @@ create_stdio_stream(svn_stream_t **stream,
 }
 
 
+#if APR_HAS_THREADS
+/* The amount of data that may be read from stdin ahead of the parser
+   and the maximum amount read in one go. */
+#define READ_AHEAD_BUFFER_SIZE (16 * 1024 * 1024)
+#define READ_AHEAD_CHUNK_SIZE (64 * 1024)
+
+/* Baton for a stream that reads stdin on a separate thread.  This lets
+   a process feeding us, e.g. 'svnadmin dump', keep going while we are
+   busy committing instead of blocking on a full pipe. */
+typedef struct read_ahead_baton_t
+{
+  /* The root pool this baton, its buffer and its synchronization objects
+     are allocated in.  It must outlive the reader thread, so it is only
+     destroyed once that thread has been joined. */
+  apr_pool_t *thread_pool;
+
+  /* The file to read from, used by the reader thread only. */
+  apr_file_t *file;
+
+  /* Ring buffer holding LEN bytes of data starting at START. */
+  char *buffer;
+  apr_size_t start;
+  apr_size_t len;
+
+  /* Set by the reader thread when it hit EOF or an error other than
+     EOF, respectively. */
+  svn_boolean_t eof;
+  apr_status_t status;
+
+  /* Set while the reader thread is waiting for input. */
+  svn_boolean_t reading;
+
+  /* Set by the consumer to make the reader thread terminate. */
+  svn_boolean_t closed;
+
+  /* All the above, except for THREAD_POOL and FILE, are protected by
+     MUTEX.  COND gets signalled whenever any of them changed. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+  apr_thread_t *thread;
+} read_ahead_baton_t;
+
+/* Thread function filling the buffer of DATA, a read_ahead_baton_t. */
+static void * APR_THREAD_FUNC
+read_ahead_thread(apr_thread_t *thread, void *data)
+{
+  read_ahead_baton_t *b = data;
+
+  apr_thread_mutex_lock(b->mutex);
+  while (! b->closed)
+    {
+      apr_size_t end, len;
+      apr_status_t status;
+
+      if (b->len == READ_AHEAD_BUFFER_SIZE)
+        {
+          apr_thread_cond_wait(b->cond, b->mutex);
+          continue;
+        }
+
+      /* Read into the contiguous free space behind the data, which the
+         consumer won't touch. */
+      end = (b->start + b->len) % READ_AHEAD_BUFFER_SIZE;
+      len = READ_AHEAD_BUFFER_SIZE - b->len;
+      if (len > READ_AHEAD_BUFFER_SIZE - end)
+        len = READ_AHEAD_BUFFER_SIZE - end;
+      if (len > READ_AHEAD_CHUNK_SIZE)
+        len = READ_AHEAD_CHUNK_SIZE;
+
+      b->reading = TRUE;
+      apr_thread_mutex_unlock(b->mutex);
+      status = apr_file_read(b->file, b->buffer + end, &len);
+      apr_thread_mutex_lock(b->mutex);
+      b->reading = FALSE;
+
+      b->len += len;
+      if (APR_STATUS_IS_EOF(status))
+        b->eof = TRUE;
+      else if (status)
+        b->status = status;
+      apr_thread_cond_broadcast(b->cond);
+
+      if (status)
+        break;
+    }
+  apr_thread_mutex_unlock(b->mutex);
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Implements svn_read_fn_t for a read_ahead_baton_t. */
+static svn_error_t *
+read_ahead_read(void *baton, char *buffer, apr_size_t *len)
+{
+  read_ahead_baton_t *b = baton;
+  apr_size_t done = 0;
+  apr_status_t status = APR_SUCCESS;
+
+  apr_thread_mutex_lock(b->mutex);
+  while (done < *len)
+    {
+      apr_size_t chunk;
+
+      if (b->len == 0)
+        {
+          if (b->eof || b->status)
+            {
+              status = b->status;
+              break;
+            }
+          apr_thread_cond_wait(b->cond, b->mutex);
+          continue;
+        }
+
+      chunk = *len - done;
+      if (chunk > b->len)
+        chunk = b->len;
+      if (chunk > READ_AHEAD_BUFFER_SIZE - b->start)
+        chunk = READ_AHEAD_BUFFER_SIZE - b->start;
+
+      memcpy(buffer + done, b->buffer + b->start, chunk);
+      done += chunk;
+      b->start = (b->start + chunk) % READ_AHEAD_BUFFER_SIZE;
+      b->len -= chunk;
+      apr_thread_cond_broadcast(b->cond);
+    }
+  apr_thread_mutex_unlock(b->mutex);
+
+  /* Report errors only once all data read before them got consumed. */
+  if (done == 0 && status)
+    return svn_error_wrap_apr(status, _("Can't read stdin"));
+
+  *len = done;
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function stopping the reader thread of BATON, a
+   read_ahead_baton_t. */
+static apr_status_t
+read_ahead_cleanup(void *baton)
+{
+  read_ahead_baton_t *b = baton;
+  apr_pool_t *thread_pool = b->thread_pool;
+  svn_boolean_t reading;
+  apr_status_t retval;
+
+  apr_thread_mutex_lock(b->mutex);
+  b->closed = TRUE;
+  reading = b->reading;
+  apr_thread_cond_broadcast(b->cond);
+  apr_thread_mutex_unlock(b->mutex);
+
+  /* A thread blocked waiting for input can't be stopped.  It will go
+     away with the process, so we must not destroy anything it uses. */
+  if (reading)
+    return APR_SUCCESS;
+
+  apr_thread_join(&retval, b->thread);
+  svn_pool_destroy(thread_pool);
+
+  return APR_SUCCESS;
+}
+
+/* Set *STREAM to a stream reading stdin on a separate thread.  If that
+   thread can't be started, fall back to create_stdio_stream(). */
+static svn_error_t *
+create_read_ahead_stdin_stream(svn_stream_t **stream,
+                               apr_pool_t *pool)
+{
+  /* Everything the reader thread touches lives in a root pool of its
+     own, which POOL's cleanup leaves alone while the thread may still
+     be running. */
+  apr_pool_t *thread_pool = svn_pool_create(NULL);
+  read_ahead_baton_t *b = apr_pcalloc(thread_pool, sizeof(*b));
+  apr_status_t apr_err;
+
+  b->thread_pool = thread_pool;
+  apr_err = apr_thread_mutex_create(&b->mutex, APR_THREAD_MUTEX_DEFAULT,
+                                    thread_pool);
+  if (! apr_err)
+    apr_err = apr_thread_cond_create(&b->cond, thread_pool);
+  if (apr_err)
+    {
+      svn_pool_destroy(thread_pool);
+      return create_stdio_stream(stream, apr_file_open_stdin, pool);
+    }
+
+  apr_err = apr_file_open_stdin(&b->file, thread_pool);
+  if (apr_err)
+    {
+      svn_pool_destroy(thread_pool);
+      return svn_error_wrap_apr(apr_err, _("Can't open stdio file"));
+    }
+
+  b->buffer = apr_palloc(thread_pool, READ_AHEAD_BUFFER_SIZE);
+  apr_err = apr_thread_create(&b->thread, NULL, read_ahead_thread, b,
+                              thread_pool);
+  if (apr_err)
+    {
+      svn_pool_destroy(thread_pool);
+      return create_stdio_stream(stream, apr_file_open_stdin, pool);
+    }
+
+  apr_pool_cleanup_register(pool, b, read_ahead_cleanup,
+                            apr_pool_cleanup_null);
+
+  *stream = svn_stream_create(b, pool);
+  svn_stream_set_read(*stream, read_ahead_read);
+  return SVN_NO_ERROR;
+}
+#endif
+
+
 /* Helper to parse local repository path.  Try parsing next parameter
  * of OS as a local path to repository.  If successfull *REPOS_PATH
  * will contain internal style path to the repository.
@@ -153,14 +375,16 @@ warning_func(void *baton,
 }
 
 
-/* Helper to open a repository and set a warning func (so we don't
- * SEGFAULT when libsvn_fs's default handler gets run).  */
+/* Helper to open a repository with FS_CONFIG (which may be NULL) and
+ * set a warning func (so we don't SEGFAULT when libsvn_fs's default
+ * handler gets run).  */
 static svn_error_t *
 open_repos(svn_repos_t **repos,
            const char *path,
+           apr_hash_t *fs_config,
            apr_pool_t *pool)
 {
-  SVN_ERR(svn_repos_open(repos, path, pool));
+  SVN_ERR(svn_repos_open2(repos, path, fs_config, pool));
   svn_fs_set_warning_func(svn_repos_fs(*repos), warning_func, NULL);
   return SVN_NO_ERROR;
 }
@@ -231,7 +455,10 @@ enum
     svnadmin__pre_1_4_compatible,
     svnadmin__pre_1_5_compatible,
     svnadmin__pre_1_6_compatible,
-    svnadmin__pre_1_7_compatible
+    svnadmin__pre_1_7_compatible,
+    svnadmin__pre_1_8_compatible,
+    svnadmin__cache_stats,
+    svnadmin__jobs
   };
 
 /* Option codes and descriptions.
@@ -253,7 +480,7 @@ static const apr_getopt_option_t options_table[] =
      N_("specify revision number ARG (or X:Y range)")},
 
     {"incremental",   svnadmin__incremental, 0,
-     N_("dump incrementally")},
+     N_("dump or hotcopy incrementally")},
 
     {"deltas",        svnadmin__deltas, 0,
      N_("use deltas in dump output")},
@@ -321,6 +548,16 @@ static const apr_getopt_option_t options_table[] =
      N_("use format compatible with Subversion versions\n"
         "                             earlier than 1.7")},
 
+    {"pre-1.8-compatible",     svnadmin__pre_1_8_compatible, 0,
+     N_("use format compatible with Subversion versions\n"
+        "                             earlier than 1.8")},
+
+    {"cache-stats",   svnadmin__cache_stats, 0,
+     N_("print cache usage statistics to stderr when done")},
+
+    {"jobs",          svnadmin__jobs, 1,
+     N_("use up to ARG threads where supported")},
+
     {NULL}
   };
 
@@ -342,7 +579,7 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
    {svnadmin__bdb_txn_nosync, svnadmin__bdb_log_keep,
     svnadmin__config_dir, svnadmin__fs_type, svnadmin__pre_1_4_compatible,
     svnadmin__pre_1_5_compatible, svnadmin__pre_1_6_compatible,
-    svnadmin__pre_1_7_compatible} },
+    svnadmin__pre_1_7_compatible, svnadmin__pre_1_8_compatible} },
 
   {"deltify", subcommand_deltify, {0}, N_
    ("usage: svnadmin deltify [-r LOWER[:UPPER]] REPOS_PATH\n\n"
@@ -364,7 +601,8 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     "every path present in the repository as of that revision.  (In either\n"
     "case, the second and subsequent revisions, if any, describe only paths\n"
     "changed in those revisions.)\n"),
-   {'r', svnadmin__incremental, svnadmin__deltas, 'q'} },
+   {'r', svnadmin__incremental, svnadmin__deltas, 'q',
+    svnadmin__cache_stats, svnadmin__jobs} },
 
   {"help", subcommand_help, {"?", "h"}, N_
    ("usage: svnadmin help [SUBCOMMAND...]\n\n"
@@ -373,8 +611,10 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
 
   {"hotcopy", subcommand_hotcopy, {0}, N_
    ("usage: svnadmin hotcopy REPOS_PATH NEW_REPOS_PATH\n\n"
-    "Makes a hot copy of a repository.\n"),
-   {svnadmin__clean_logs} },
+    "Makes a hot copy of a repository.\n"
+    "If --incremental is passed and NEW_REPOS_PATH holds an earlier hot copy\n"
+    "of REPOS_PATH, only the data changed since then is copied (FSFS only).\n"),
+   {svnadmin__clean_logs, svnadmin__incremental} },
 
   {"list-dblogs", subcommand_list_dblogs, {0}, N_
    ("usage: svnadmin list-dblogs REPOS_PATH\n\n"
@@ -393,10 +633,12 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     "Read a 'dumpfile'-formatted stream from stdin, committing\n"
     "new revisions into the repository's filesystem.  If the repository\n"
     "was previously empty, its UUID will, by default, be changed to the\n"
-    "one specified in the stream.  Progress feedback is sent to stdout.\n"),
+    "one specified in the stream.  Progress feedback is sent to stdout.\n"
+    "With --jobs larger than 1, stdin is read ahead on a separate thread;\n"
+    "all such values have the same effect.\n"),
    {'q', svnadmin__ignore_uuid, svnadmin__force_uuid,
     svnadmin__use_pre_commit_hook, svnadmin__use_post_commit_hook,
-    svnadmin__parent_dir} },
+    svnadmin__parent_dir, svnadmin__jobs} },
 
   {"lslocks", subcommand_lslocks, {0}, N_
    ("usage: svnadmin lslocks REPOS_PATH [PATH-IN-REPOS]\n\n"
@@ -413,7 +655,7 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
    ("usage: svnadmin pack REPOS_PATH\n\n"
     "Possibly compact the repository into a more efficient storage model.\n"
     "This may not apply to all repositories, in which case, exit.\n"),
-   {'q'} },
+   {'q', svnadmin__jobs} },
 
   {"recover", subcommand_recover, {0}, N_
    ("usage: svnadmin recover REPOS_PATH\n\n"
@@ -479,7 +721,7 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
   {"verify", subcommand_verify, {0}, N_
    ("usage: svnadmin verify REPOS_PATH\n\n"
     "Verifies the data stored in the repository.\n"),
-   {'r', 'q'} },
+   {'r', 'q', svnadmin__cache_stats, svnadmin__jobs} },
 
   { NULL, NULL, {0}, NULL, {0} }
 };
@@ -495,6 +737,7 @@ struct svnadmin_opt_state
   svn_boolean_t pre_1_5_compatible;                 /* --pre-1.5-compatible */
   svn_boolean_t pre_1_6_compatible;                 /* --pre-1.6-compatible */
   svn_boolean_t pre_1_7_compatible;                 /* --pre-1.7-compatible */
+  svn_boolean_t pre_1_8_compatible;                 /* --pre-1.8-compatible */
   svn_opt_revision_t start_revision, end_revision;  /* -r X[:Y] */
   svn_boolean_t help;                               /* --help or -? */
   svn_boolean_t version;                            /* --version */
@@ -510,6 +753,8 @@ struct svnadmin_opt_state
   svn_boolean_t clean_logs;                         /* --clean-logs */
   svn_boolean_t bypass_hooks;                       /* --bypass-hooks */
   svn_boolean_t wait;                               /* --wait */
+  svn_boolean_t cache_stats;                        /* --cache-stats */
+  int jobs;                                         /* --jobs */
   enum svn_repos_load_uuid uuid_action;             /* --ignore-uuid,
                                                        --force-uuid */
   const char *parent_dir;
@@ -590,6 +835,11 @@ subcommand_create(apr_getopt_t *os, void *baton, apr_pool_t *pool)
                  APR_HASH_KEY_STRING,
                  "1");
 
+  if (opt_state->pre_1_8_compatible)
+    apr_hash_set(fs_config, SVN_FS_CONFIG_PRE_1_8_COMPATIBLE,
+                 APR_HASH_KEY_STRING,
+                 "1");
+
   SVN_ERR(svn_config_get_config(&config, opt_state->config_dir, pool));
   SVN_ERR(svn_repos_create(&repos, opt_state->repository_path,
                            NULL, NULL,
@@ -610,7 +860,7 @@ subcommand_deltify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_revnum_t youngest, revision;
   apr_pool_t *subpool = svn_pool_create(pool);
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, NULL, pool));
   fs = svn_repos_fs(repos);
   SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
 
@@ -830,6 +1080,45 @@ recode_stream_create(FILE *std_stream, apr_pool_t *pool)
 }
 
 
+/* Print the usage statistics of the caches used by FS as well as
+   those of the process-wide membuffer to stderr.  Use POOL for
+   allocations. */
+static svn_error_t *
+print_cache_stats(svn_fs_t *fs, apr_pool_t *pool)
+{
+  apr_hash_t *cache_info;
+  apr_array_header_t *sorted;
+  svn_membuffer_t *membuffer;
+  int i;
+
+  SVN_ERR(svn_fs__get_cache_info(&cache_info, fs, FALSE, pool));
+  sorted = svn_sort__hash(cache_info, svn_sort_compare_items_lexically, pool);
+
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      svn_string_t *line = svn_cache__format_info(item->key, item->value,
+                                                  pool);
+
+      SVN_ERR(svn_cmdline_fprintf(stderr, pool, "%s\n", line->data));
+    }
+
+  membuffer = svn_cache__get_global_membuffer_cache();
+  if (membuffer)
+    {
+      svn_cache__info_t info;
+
+      SVN_ERR(svn_cache__membuffer_get_info(membuffer, &info, FALSE, pool));
+      SVN_ERR(svn_cmdline_fprintf(stderr, pool, "%s\n",
+                                  svn_cache__format_info(_("membuffer"),
+                                                         &info,
+                                                         pool)->data));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -842,7 +1131,7 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_revnum_t youngest;
   svn_stream_t *progress_stream = NULL;
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, NULL, pool));
   fs = svn_repos_fs(repos);
   SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
 
@@ -876,9 +1165,13 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
 
   SVN_ERR(svn_repos_dump_fs3(repos, stdout_stream, lower, upper,
                              opt_state->incremental, opt_state->use_deltas,
+                             opt_state->jobs,
                              !opt_state->quiet ? repos_notify_handler : NULL,
                              progress_stream, check_cancel, NULL, pool));
 
+  if (opt_state->cache_stats)
+    SVN_ERR(print_cache_stats(fs, pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -920,10 +1213,21 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   struct svnadmin_opt_state *opt_state = baton;
   svn_repos_t *repos;
   svn_stream_t *stdin_stream, *stdout_stream = NULL;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+
+  /* A Berkeley DB filesystem needs to flush its log only once per loaded
+     revision rather than for every one of its many trails. */
+  apr_hash_set(fs_config, SVN_FS_CONFIG_BDB_GROUP_COMMIT,
+               APR_HASH_KEY_STRING, "1");
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, fs_config, pool));
 
   /* Read the stream from STDIN.  Users can redirect a file. */
+#if APR_HAS_THREADS
+  if (opt_state->jobs > 1)
+    SVN_ERR(create_read_ahead_stdin_stream(&stdin_stream, pool));
+  else
+#endif
   SVN_ERR(create_stdio_stream(&stdin_stream,
                               apr_file_open_stdin, pool));
 
@@ -952,7 +1256,7 @@ subcommand_lstxns(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   apr_array_header_t *txns;
   int i;
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, NULL, pool));
   fs = svn_repos_fs(repos);
   SVN_ERR(svn_fs_list_transactions(&txns, fs, pool));
 
@@ -1028,7 +1332,7 @@ subcommand_recover(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   /* Since db transactions may have been replayed, it's nice to tell
      people what the latest revision is.  It also proves that the
      recovery actually worked. */
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, NULL, pool));
   SVN_ERR(svn_fs_youngest_rev(&youngest_rev, svn_repos_fs(repos), pool));
   SVN_ERR(svn_cmdline_printf(pool, _("The latest repos revision is %ld.\n"),
                              youngest_rev));
@@ -1098,7 +1402,7 @@ subcommand_rmtxns(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   int i;
   apr_pool_t *subpool = svn_pool_create(pool);
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, NULL, pool));
   fs = svn_repos_fs(repos);
 
   SVN_ERR(svn_opt_parse_all_args(&args, os, pool));
@@ -1174,7 +1478,7 @@ set_revprop(const char *prop_name, const char *filename,
   SVN_ERR(svn_subst_translate_string(&prop_value, prop_value, NULL, pool));
 
   /* Open the filesystem  */
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, NULL, pool));
 
   /* If we are bypassing the hooks system, we just hit the filesystem
      directly. */
@@ -1243,7 +1547,7 @@ subcommand_setuuid(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (args->nelts == 1)
     uuid = APR_ARRAY_IDX(args, 0, const char *);
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, NULL, pool));
   fs = svn_repos_fs(repos);
   return svn_fs_set_uuid(fs, uuid, pool);
 }
@@ -1290,14 +1594,15 @@ subcommand_pack(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_repos_t *repos;
   svn_stream_t *progress_stream = NULL;
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, NULL, pool));
 
   /* Progress feedback goes to STDOUT, unless they asked to suppress it. */
   if (! opt_state->quiet)
     progress_stream = recode_stream_create(stderr, pool);
 
   return svn_error_return(
-    svn_repos_fs_pack2(repos, !opt_state->quiet ? repos_notify_handler : NULL,
+    svn_repos_fs_pack2(repos, opt_state->jobs,
+                       !opt_state->quiet ? repos_notify_handler : NULL,
                        progress_stream, check_cancel, NULL, pool));
 }
 
@@ -1312,7 +1617,7 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_revnum_t youngest, lower, upper;
   svn_stream_t *progress_stream;
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, NULL, pool));
   fs = svn_repos_fs(repos);
   SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
 
@@ -1330,10 +1635,15 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     progress_stream = recode_stream_create(stderr, pool);
 
-  return svn_repos_verify_fs2(repos, lower, upper,
-                              !opt_state->quiet
-                                ? repos_notify_handler : NULL,
-                              progress_stream, check_cancel, NULL, pool);
+  SVN_ERR(svn_repos_verify_fs2(repos, lower, upper, opt_state->jobs,
+                               !opt_state->quiet
+                                 ? repos_notify_handler : NULL,
+                               progress_stream, check_cancel, NULL, pool));
+
+  if (opt_state->cache_stats)
+    SVN_ERR(print_cache_stats(fs, pool));
+
+  return SVN_NO_ERROR;
 }
 
 
@@ -1343,10 +1653,11 @@ subcommand_hotcopy(apr_getopt_t *os, void *baton, apr_pool_t *pool)
 {
   struct svnadmin_opt_state *opt_state = baton;
 
-  SVN_ERR(svn_repos_hotcopy(opt_state->repository_path,
-                            opt_state->new_repository_path,
-                            opt_state->clean_logs,
-                            pool));
+  SVN_ERR(svn_repos_hotcopy2(opt_state->repository_path,
+                             opt_state->new_repository_path,
+                             opt_state->clean_logs,
+                             opt_state->incremental,
+                             check_cancel, NULL, pool));
 
   return SVN_NO_ERROR;
 }
@@ -1371,7 +1682,7 @@ subcommand_lslocks(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (targets->nelts)
     fs_path = APR_ARRAY_IDX(targets, 0, const char *);
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, NULL, pool));
 
   /* Fetch all locks on or below the root directory. */
   SVN_ERR(svn_repos_fs_get_locks(&locks, repos, fs_path, NULL, NULL, pool));
@@ -1422,7 +1733,7 @@ subcommand_rmlocks(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   const char *username;
   apr_pool_t *subpool = svn_pool_create(pool);
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, NULL, pool));
   fs = svn_repos_fs(repos);
 
   /* svn_fs_unlock() demands that some username be associated with the
@@ -1617,6 +1928,7 @@ main(int argc, const char *argv[])
   /* Initialize opt_state. */
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
+  opt_state.jobs = 1;
 
   /* Parse options. */
   err = svn_cmdline__getopt_init(&os, argc, argv, pool);
@@ -1705,6 +2017,30 @@ main(int argc, const char *argv[])
       case svnadmin__pre_1_7_compatible:
         opt_state.pre_1_7_compatible = TRUE;
         break;
+      case svnadmin__pre_1_8_compatible:
+        opt_state.pre_1_8_compatible = TRUE;
+        break;
+      case svnadmin__cache_stats:
+        opt_state.cache_stats = TRUE;
+        break;
+      case svnadmin__jobs:
+        {
+          char *end;
+          opt_state.jobs = (int) strtol(opt_arg, &end, 10);
+          if (end == opt_arg || *end != '\0')
+            {
+              err = svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Non-numeric jobs argument given"));
+              return svn_cmdline_handle_exit_error(err, pool, "svnadmin: ");
+            }
+          if (opt_state.jobs <= 0)
+            {
+              err = svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                     _("Argument to --jobs must be positive"));
+              return svn_cmdline_handle_exit_error(err, pool, "svnadmin: ");
+            }
+        }
+        break;
       case svnadmin__fs_type:
         err = svn_utf_cstring_to_utf8(&opt_state.fs_type, opt_arg, pool);
         if (err)
@@ -1921,6 +2257,6 @@ subcommand_crashtest(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   struct svnadmin_opt_state *opt_state = baton;
   svn_repos_t *repos;
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, NULL, pool));
   abort();
 }
@@ -43,6 +43,7 @@
 #include "svn_mergeinfo.h"
 
 #include "private/svn_mergeinfo_private.h"
+#include "private/svn_dep_compat.h"
 
 
 /*** Code. ***/
@@ -59,19 +60,45 @@
    directly wrap the OS's file-handles, which don't know or care about
    translation.  Thus dump/load works correctly on Win32.
 */
+#if APR_VERSION_AT_LEAST(1, 3, 0)
+/* The size of the buffers of the stdio streams.  The dump stream parser
+   reads headers one byte at a time, and without a buffer every byte
+   would take a system call. */
+#define STDIO_BUFFER_SIZE (256 * 1024)
+#endif
+
+/* Set *STREAM to a stream for stdout if OUTPUT is set, else for stdin.
+   Closing the stdout stream flushes and closes stdout. */
 static svn_error_t *
 create_stdio_stream(svn_stream_t **stream,
-                    APR_DECLARE(apr_status_t) open_fn(apr_file_t **,
-                                                      apr_pool_t *),
+                    svn_boolean_t output,
                     apr_pool_t *pool)
 {
   apr_file_t *stdio_file;
-  apr_status_t apr_err = open_fn(&stdio_file, pool);
+  apr_status_t apr_err;
+
+#if APR_VERSION_AT_LEAST(1, 3, 0)
+  if (output)
+    apr_err = apr_file_open_flags_stdout(&stdio_file,
+                                         APR_WRITE | APR_BUFFERED, pool);
+  else
+    apr_err = apr_file_open_flags_stdin(&stdio_file,
+                                        APR_READ | APR_BUFFERED, pool);
+  if (! apr_err)
+    apr_err = apr_file_buffer_set(stdio_file,
+                                  apr_palloc(pool, STDIO_BUFFER_SIZE),
+                                  STDIO_BUFFER_SIZE);
+#else
+  if (output)
+    apr_err = apr_file_open_stdout(&stdio_file, pool);
+  else
+    apr_err = apr_file_open_stdin(&stdio_file, pool);
+#endif
 
   if (apr_err)
     return svn_error_wrap_apr(apr_err, _("Can't open stdio file"));
 
-  *stream = svn_stream_from_aprfile2(stdio_file, TRUE, pool);
+  *stream = svn_stream_from_aprfile2(stdio_file, ! output, pool);
   return SVN_NO_ERROR;
 }
 
@@ -108,38 +135,43 @@ write_prop_to_stringbuf(svn_stringbuf_t **strbuf,
 }
 
 
-/* Prefix matching function to compare node-path with set of prefixes. */
+/* Prefix matching function to compare node-path with set of prefixes.
+   PFXSET has the prefixes as keys; rather than comparing PATH with each
+   of them, look up each of the prefixes PATH could match. */
 static svn_boolean_t
-ary_prefix_match(const apr_array_header_t *pfxlist, const char *path)
+hash_prefix_match(apr_hash_t *pfxset, const char *path)
 {
-  int i, pfx_len, path_len = strlen(path);
-  const char *pfx;
+  apr_ssize_t len = strlen(path);
 
-  for (i = 0; i < pfxlist->nelts; i++)
+  while (TRUE)
     {
-      pfx = APR_ARRAY_IDX(pfxlist, i, const char *);
-      pfx_len = strlen(pfx);
-      if (path_len < pfx_len)
-        continue;
-      if (strncmp(path, pfx, pfx_len) == 0
-          && (path[pfx_len] == '\0' || path[pfx_len] == '/'))
+      if (apr_hash_get(pfxset, path, len))
         return TRUE;
-    }
 
-  return FALSE;
+      /* Go on with the parent; a prefix must end where a path component
+         does. */
+      do
+        {
+          if (len == 0)
+            return FALSE;
+        }
+      while (path[--len] != '/');
+    }
 }
 
 
 /* Check whether we need to skip this PATH based on its presence in
-   the PREFIXES list, and the DO_EXCLUDE option. */
+   the PREFIXES list (or, with glob matching off, the PREFIX_SET made of
+   it), and the DO_EXCLUDE option. */
 static APR_INLINE svn_boolean_t
 skip_path(const char *path, const apr_array_header_t *prefixes,
-          svn_boolean_t do_exclude, svn_boolean_t glob)
+          apr_hash_t *prefix_set, svn_boolean_t do_exclude,
+          svn_boolean_t glob)
 {
   const svn_boolean_t matches =
     (glob
      ? svn_cstring_match_glob_list(path, prefixes)
-     : ary_prefix_match(prefixes, path));
+     : hash_prefix_match(prefix_set, path));
 
   /* NXOR */
   return (matches ? do_exclude : !do_exclude);
@@ -181,6 +213,7 @@ struct parse_baton_t
   svn_boolean_t preserve_revprops;
   svn_boolean_t skip_missing_merge_sources;
   apr_array_header_t *prefixes;
+  apr_hash_t *prefix_set;  /* The PREFIXES, as keys. */
 
   /* Input and output streams. */
   svn_stream_t *in_stream;
@@ -188,8 +221,10 @@ struct parse_baton_t
 
   /* State for the filtering process. */
   apr_int32_t rev_drop_count;
-  apr_hash_t *dropped_nodes;
-  apr_hash_t *renumber_history;  /* svn_revnum_t -> struct revmap_t */
+  apr_hash_t *dropped_nodes;     /* Only kept for reporting, if !QUIET. */
+  /* struct revmap_t, indexed by original revision minus RENUMBER_BASE. */
+  apr_array_header_t *renumber_history;
+  svn_revnum_t renumber_base;
   svn_revnum_t last_live_revision;
   /* The oldest original revision, greater than r0, in the input
      stream which was not filtered. */
@@ -247,6 +282,55 @@ struct node_baton_t
 
 
 
+/* Record in PB's renumbering history that original revision REV maps to
+   MAPPED_REV, and whether it WAS_DROPPED. */
+static void
+set_revmap(struct parse_baton_t *pb,
+           svn_revnum_t rev,
+           svn_revnum_t mapped_rev,
+           svn_boolean_t was_dropped)
+{
+  struct revmap_t *revmap;
+
+  if (! SVN_IS_VALID_REVNUM(pb->renumber_base))
+    pb->renumber_base = rev;
+  else if (rev < pb->renumber_base)
+    return;
+
+  /* Revisions come in ascending order, so this only fills holes in the
+     numbering, if any. */
+  while (rev - pb->renumber_base >= pb->renumber_history->nelts)
+    {
+      revmap = &APR_ARRAY_PUSH(pb->renumber_history, struct revmap_t);
+      revmap->rev = SVN_INVALID_REVNUM;
+      revmap->was_dropped = FALSE;
+    }
+
+  revmap = &APR_ARRAY_IDX(pb->renumber_history, rev - pb->renumber_base,
+                          struct revmap_t);
+  revmap->rev = mapped_rev;
+  revmap->was_dropped = was_dropped;
+}
+
+/* Return the entry for original revision REV in PB's renumbering history,
+   or NULL if there is none. */
+static struct revmap_t *
+get_revmap(struct parse_baton_t *pb, svn_revnum_t rev)
+{
+  struct revmap_t *revmap;
+
+  if (! SVN_IS_VALID_REVNUM(pb->renumber_base)
+      || rev < pb->renumber_base
+      || rev - pb->renumber_base >= pb->renumber_history->nelts)
+    return NULL;
+
+  revmap = &APR_ARRAY_IDX(pb->renumber_history, rev - pb->renumber_base,
+                          struct revmap_t);
+  return SVN_IS_VALID_REVNUM(revmap->rev) || revmap->was_dropped
+         ? revmap : NULL;
+}
+
+
 /* Filtering vtable members */
 
 /* New revision: set up revision_baton, decide if we skip it. */
@@ -403,16 +487,7 @@ output_revision(struct revision_baton_t *rb)
 
       if (rb->pb->do_renumber_revs)
         {
-          svn_revnum_t *rr_key;
-          struct revmap_t *rr_val;
-          apr_pool_t *rr_pool = apr_hash_pool_get(rb->pb->renumber_history);
-          rr_key = apr_palloc(rr_pool, sizeof(*rr_key));
-          rr_val = apr_palloc(rr_pool, sizeof(*rr_val));
-          *rr_key = rb->rev_orig;
-          rr_val->rev = rb->rev_actual;
-          rr_val->was_dropped = FALSE;
-          apr_hash_set(rb->pb->renumber_history, rr_key,
-                       sizeof(*rr_key), rr_val);
+          set_revmap(rb->pb, rb->rev_orig, rb->rev_actual, FALSE);
           rb->pb->last_live_revision = rb->rev_actual;
         }
 
@@ -426,18 +501,7 @@ output_revision(struct revision_baton_t *rb)
       /* We're dropping this revision. */
       rb->pb->rev_drop_count++;
       if (rb->pb->do_renumber_revs)
-        {
-          svn_revnum_t *rr_key;
-          struct revmap_t *rr_val;
-          apr_pool_t *rr_pool = apr_hash_pool_get(rb->pb->renumber_history);
-          rr_key = apr_palloc(rr_pool, sizeof(*rr_key));
-          rr_val = apr_palloc(rr_pool, sizeof(*rr_val));
-          *rr_key = rb->rev_orig;
-          rr_val->rev = rb->pb->last_live_revision;
-          rr_val->was_dropped = TRUE;
-          apr_hash_set(rb->pb->renumber_history, rr_key,
-                       sizeof(*rr_key), rr_val);
-        }
+        set_revmap(rb->pb, rb->rev_orig, rb->pb->last_live_revision, TRUE);
 
       if (! rb->pb->quiet)
         SVN_ERR(svn_cmdline_fprintf(stderr, subpool,
@@ -489,17 +553,18 @@ new_node_record(void **node_baton,
   if (copyfrom_path)
     copyfrom_path = svn_uri_join("/", copyfrom_path, pool);
 
-  nb->do_skip = skip_path(node_path, pb->prefixes,
+  nb->do_skip = skip_path(node_path, pb->prefixes, pb->prefix_set,
                           pb->do_exclude, pb->glob);
 
   /* If we're skipping the node, take note of path, discarding the
      rest.  */
   if (nb->do_skip)
     {
-      apr_hash_set(pb->dropped_nodes,
-                   apr_pstrdup(apr_hash_pool_get(pb->dropped_nodes),
-                               node_path),
-                   APR_HASH_KEY_STRING, (void *)1);
+      if (! pb->quiet)
+        apr_hash_set(pb->dropped_nodes,
+                     apr_pstrdup(apr_hash_pool_get(pb->dropped_nodes),
+                                 node_path),
+                     APR_HASH_KEY_STRING, (void *)1);
       nb->rb->had_dropped_nodes = TRUE;
     }
   else
@@ -509,7 +574,8 @@ new_node_record(void **node_baton,
 
       /* Test if this node was copied from dropped source. */
       if (copyfrom_path &&
-          skip_path(copyfrom_path, pb->prefixes, pb->do_exclude, pb->glob))
+          skip_path(copyfrom_path, pb->prefixes, pb->prefix_set,
+                    pb->do_exclude, pb->glob))
         {
           /* This node was copied from a dropped source.
              We have a problem, since we did not want to drop this node too.
@@ -568,7 +634,7 @@ new_node_record(void **node_baton,
 
           /* Rewrite Node-Copyfrom-Rev if we are renumbering revisions.
              The number points to some revision in the past. We keep track
-             of revision renumbering in an apr_hash, which maps original
+             of revision renumbering in an array, which maps original
              revisions to new ones. Dropped revision are mapped to -1.
              This should never happen here.
           */
@@ -579,9 +645,7 @@ new_node_record(void **node_baton,
               struct revmap_t *cf_renum_val;
 
               cf_orig_rev = SVN_STR_TO_REV(val);
-              cf_renum_val = apr_hash_get(pb->renumber_history,
-                                          &cf_orig_rev,
-                                          sizeof(svn_revnum_t));
+              cf_renum_val = get_revmap(pb, cf_orig_rev);
               if (! (cf_renum_val && SVN_IS_VALID_REVNUM(cf_renum_val->rev)))
                 return svn_error_createf
                   (SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
@@ -705,7 +769,8 @@ adjust_mergeinfo(svn_string_t **final_val, const svn_string_t *initial_val,
       int i;
 
       /* Determine whether the merge_source is a part of the prefix. */
-      if (skip_path(merge_source, pb->prefixes, pb->do_exclude, pb->glob))
+      if (skip_path(merge_source, pb->prefixes, pb->prefix_set,
+                    pb->do_exclude, pb->glob))
         {
           if (pb->skip_missing_merge_sources)
             continue;
@@ -726,15 +791,13 @@ adjust_mergeinfo(svn_string_t **final_val, const svn_string_t *initial_val,
               svn_merge_range_t *range = APR_ARRAY_IDX(rangelist, i,
                                                        svn_merge_range_t *);
 
-              revmap_start = apr_hash_get(pb->renumber_history,
-                                          &range->start, sizeof(svn_revnum_t));
+              revmap_start = get_revmap(pb, range->start);
               if (! (revmap_start && SVN_IS_VALID_REVNUM(revmap_start->rev)))
                 return svn_error_createf
                   (SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
                    _("No valid revision range 'start' in filtered stream"));
 
-              revmap_end = apr_hash_get(pb->renumber_history,
-                                        &range->end, sizeof(svn_revnum_t));
+              revmap_end = get_revmap(pb, range->end);
               if (! (revmap_end && SVN_IS_VALID_REVNUM(revmap_end->rev)))
                 return svn_error_createf
                   (SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
@@ -994,14 +1057,13 @@ parse_baton_initialize(struct parse_baton_t **pb,
                        apr_pool_t *pool)
 {
   struct parse_baton_t *baton = apr_palloc(pool, sizeof(*baton));
+  int i;
 
   /* Read the stream from STDIN.  Users can redirect a file. */
-  SVN_ERR(create_stdio_stream(&(baton->in_stream),
-                              apr_file_open_stdin, pool));
+  SVN_ERR(create_stdio_stream(&(baton->in_stream), FALSE, pool));
 
   /* Have the parser dump results to STDOUT. Users can redirect a file. */
-  SVN_ERR(create_stdio_stream(&(baton->out_stream),
-                              apr_file_open_stdout, pool));
+  SVN_ERR(create_stdio_stream(&(baton->out_stream), TRUE, pool));
 
   baton->do_exclude = do_exclude;
 
@@ -1015,10 +1077,17 @@ parse_baton_initialize(struct parse_baton_t **pb,
   baton->quiet = opt_state->quiet;
   baton->glob = opt_state->glob;
   baton->prefixes = opt_state->prefixes;
+  baton->prefix_set = apr_hash_make(pool);
+  for (i = 0; i < baton->prefixes->nelts; i++)
+    apr_hash_set(baton->prefix_set,
+                 APR_ARRAY_IDX(baton->prefixes, i, const char *),
+                 APR_HASH_KEY_STRING, (void *)1);
   baton->skip_missing_merge_sources = opt_state->skip_missing_merge_sources;
   baton->rev_drop_count = 0; /* used to shift revnums while filtering */
   baton->dropped_nodes = apr_hash_make(pool);
-  baton->renumber_history = apr_hash_make(pool);
+  baton->renumber_history = apr_array_make(pool, 0,
+                                           sizeof(struct revmap_t));
+  baton->renumber_base = SVN_INVALID_REVNUM;
   baton->last_live_revision = SVN_INVALID_REVNUM;
   baton->oldest_original_rev = SVN_INVALID_REVNUM;
 
@@ -1136,6 +1205,7 @@ do_filter(apr_getopt_t *os,
   SVN_ERR(parse_baton_initialize(&pb, opt_state, do_exclude, pool));
   SVN_ERR(svn_repos_parse_dumpstream2(pb->in_stream, &filtering_vtable, pb,
                                       NULL, NULL, pool));
+  SVN_ERR(svn_stream_close(pb->out_stream));
 
   /* The rest of this is just reporting.  If we aren't reporting, get
      outta here. */
@@ -1157,29 +1227,16 @@ do_filter(apr_getopt_t *os,
       SVN_ERR(svn_cmdline_fputs(_("Revisions renumbered as follows:\n"),
                                 stderr, subpool));
 
-      /* Get the keys of the hash, sort them, then print the hash keys
-         and values, sorted by keys. */
-      num_keys = apr_hash_count(pb->renumber_history);
-      keys = apr_array_make(pool, num_keys + 1, sizeof(svn_revnum_t));
-      for (hi = apr_hash_first(pool, pb->renumber_history);
-           hi;
-           hi = apr_hash_next(hi))
+      /* The history is sorted by original revision already. */
+      for (i = 0; i < pb->renumber_history->nelts; i++)
         {
-          const svn_revnum_t *revnum = svn__apr_hash_index_key(hi);
+          svn_revnum_t this_key = pb->renumber_base + i;
+          struct revmap_t *this_val = get_revmap(pb, this_key);
 
-          APR_ARRAY_PUSH(keys, svn_revnum_t) = *revnum;
-        }
-      qsort(keys->elts, keys->nelts,
-            keys->elt_size, svn_sort_compare_revisions);
-      for (i = 0; i < keys->nelts; i++)
-        {
-          svn_revnum_t this_key;
-          struct revmap_t *this_val;
+          if (! this_val)
+            continue;
 
           svn_pool_clear(subpool);
-          this_key = APR_ARRAY_IDX(keys, i, svn_revnum_t);
-          this_val = apr_hash_get(pb->renumber_history, &this_key,
-                                  sizeof(this_key));
           if (this_val->was_dropped)
             SVN_ERR(svn_cmdline_fprintf(stderr, subpool,
                                         _("   %ld => (dropped)\n"),
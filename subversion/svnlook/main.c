@@ -545,80 +545,174 @@ print_dirs_changed_tree(svn_repos_node_t *node,
 }
 
 
-/* Recursively print all nodes in the tree that have been modified
-   (do not include directories affected only by "bubble-up"). */
+/* A directory added with history by the change being printed by
+   do_changed() or do_diff(). */
+struct changed_copy_t
+{
+  const char *path;
+  const char *copyfrom_path;
+  svn_revnum_t copyfrom_rev;
+};
+
+
+/* Set *BASE_ROOT_P and *BASE_PATH_P to the root and path (UTF-8!) that
+   PATH in ROOT was based on before the change of ROOT.  BASE_ROOT is the
+   root that change is based on; COPIES is a stack of the struct
+   changed_copy_t of the ancestors of PATH copied by the change.  Allocate
+   the results in POOL. */
 static svn_error_t *
-print_changed_tree(svn_repos_node_t *node,
-                   const char *path /* UTF-8! */,
-                   svn_boolean_t copy_info,
-                   apr_pool_t *pool)
+get_base_location(svn_fs_root_t **base_root_p,
+                  const char **base_path_p,
+                  svn_fs_root_t *root,
+                  svn_fs_root_t *base_root,
+                  const char *path,
+                  const apr_array_header_t *copies,
+                  apr_pool_t *pool)
 {
-  const char *full_path;
-  char status[4] = "_  ";
-  int print_me = 1;
-  apr_pool_t *subpool;
+  /* Below a copy, the node came with the copy source. */
+  if (copies->nelts > 0)
+    {
+      struct changed_copy_t *copy
+        = &APR_ARRAY_IDX(copies, copies->nelts - 1, struct changed_copy_t);
+
+      SVN_ERR(svn_fs_revision_root(base_root_p, svn_fs_root_fs(root),
+                                   copy->copyfrom_rev, pool));
+      *base_path_p = svn_dirent_join(copy->copyfrom_path,
+                                     svn_dirent_is_child(copy->path, path,
+                                                         pool),
+                                     pool);
+    }
+  else
+    {
+      *base_root_p = base_root;
+      *base_path_p = path;
+    }
 
-  SVN_ERR(check_cancel(NULL));
+  return SVN_NO_ERROR;
+}
 
-  if (! node)
+
+/* Set *KIND to the kind of the node which PATH (UTF-8!) referred to before
+   it got deleted or replaced by the change of ROOT.  BASE_ROOT and COPIES
+   are as for get_base_location().  Use POOL for temporary allocations. */
+static svn_error_t *
+get_deleted_kind(svn_node_kind_t *kind,
+                 svn_fs_root_t *root,
+                 svn_fs_root_t *base_root,
+                 const char *path,
+                 const apr_array_header_t *copies,
+                 apr_pool_t *pool)
+{
+  const char *base_path;
+
+  SVN_ERR(get_base_location(&base_root, &base_path, root, base_root, path,
+                            copies, pool));
+  SVN_ERR(svn_fs_check_path(kind, base_root, base_path, pool));
+  if (*kind == svn_node_none)
+    return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                             _("'%s' not found in filesystem"),
+                             path[0] == '/' ? path + 1 : path);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Print the CHANGE of PATH (UTF-8!) in ROOT, unless it is just the
+   "bubble-up" of changes below.  BASE_ROOT and COPIES are as for
+   get_base_location(); push PATH onto COPIES (allocated in RESULT_POOL)
+   if CHANGE copies a directory.  Print the copy sources if COPY_INFO is
+   set.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+print_change(svn_fs_root_t *root,
+             svn_fs_root_t *base_root,
+             const char *path,
+             svn_fs_path_change2_t *change,
+             apr_array_header_t *copies,
+             svn_boolean_t copy_info,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  const char *display_path = (path[0] == '/') ? path + 1 : path;
+  svn_node_kind_t kind = change->node_kind;
+  char status[4] = "_  ";
+
+  if (change->change_kind == svn_fs_path_change_reset)
     return SVN_NO_ERROR;
 
-  /* Print the node. */
-  if (node->action == 'A')
-    {
-      status[0] = 'A';
-      if (copy_info && node->copyfrom_path)
-        status[2] = '+';
-    }
-  else if (node->action == 'D')
-    status[0] = 'D';
-  else if (node->action == 'R')
+  /* A replacement shows as the deletion of the old node followed by the
+     addition of the new one. */
+  if (change->change_kind == svn_fs_path_change_delete
+      || change->change_kind == svn_fs_path_change_replace)
     {
-      if ((! node->text_mod) && (! node->prop_mod))
-        print_me = 0;
-      if (node->text_mod)
-        status[0] = 'U';
-      if (node->prop_mod)
-        status[1] = 'U';
+      svn_node_kind_t deleted_kind = kind;
+
+      if (change->change_kind == svn_fs_path_change_replace
+          || deleted_kind == svn_node_unknown)
+        SVN_ERR(get_deleted_kind(&deleted_kind, root, base_root, path,
+                                 copies, scratch_pool));
+
+      SVN_ERR(svn_cmdline_printf(scratch_pool, "D   %s%s\n", display_path,
+                                 deleted_kind == svn_node_dir ? "/" : ""));
+
+      if (change->change_kind == svn_fs_path_change_delete)
+        return SVN_NO_ERROR;
     }
-  else
-    print_me = 0;
 
-  /* Print this node unless told to skip it. */
-  if (print_me)
+  if (kind == svn_node_unknown)
+    SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+
+  if (change->change_kind == svn_fs_path_change_add
+      || change->change_kind == svn_fs_path_change_replace)
     {
-      SVN_ERR(svn_cmdline_printf(pool, "%s %s%s\n",
-                                 status,
-                                 path,
-                                 node->kind == svn_node_dir ? "/" : ""));
-      if (copy_info && node->copyfrom_path)
+      const char *copyfrom_path = change->copyfrom_path;
+      svn_revnum_t copyfrom_rev = change->copyfrom_rev;
+
+      if (! change->copyfrom_known)
+        SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                   root, path, scratch_pool));
+      if (! SVN_IS_VALID_REVNUM(copyfrom_rev))
+        copyfrom_path = NULL;
+
+      status[0] = 'A';
+      if (copy_info && copyfrom_path)
+        status[2] = '+';
+
+      SVN_ERR(svn_cmdline_printf(scratch_pool, "%s %s%s\n",
+                                 status, display_path,
+                                 kind == svn_node_dir ? "/" : ""));
+      if (copy_info && copyfrom_path)
         /* Remove the leading slash from the copyfrom path for consistency
            with the rest of the output. */
-        SVN_ERR(svn_cmdline_printf(pool, "    (from %s%s:r%ld)\n",
-                                   (node->copyfrom_path[0] == '/'
-                                    ? node->copyfrom_path + 1
-                                    : node->copyfrom_path),
-                                   (node->kind == svn_node_dir ? "/" : ""),
-                                   node->copyfrom_rev));
-    }
+        SVN_ERR(svn_cmdline_printf(scratch_pool, "    (from %s%s:r%ld)\n",
+                                   (copyfrom_path[0] == '/'
+                                    ? copyfrom_path + 1
+                                    : copyfrom_path),
+                                   (kind == svn_node_dir ? "/" : ""),
+                                   copyfrom_rev));
+
+      if (copyfrom_path && kind == svn_node_dir)
+        {
+          struct changed_copy_t *copy
+            = &APR_ARRAY_PUSH(copies, struct changed_copy_t);
 
-  /* Return here if the node has no children. */
-  node = node->child;
-  if (! node)
-    return SVN_NO_ERROR;
+          copy->path = apr_pstrdup(result_pool, path);
+          copy->copyfrom_path = apr_pstrdup(result_pool, copyfrom_path);
+          copy->copyfrom_rev = copyfrom_rev;
+        }
 
-  /* Recursively handle the node's children. */
-  subpool = svn_pool_create(pool);
-  full_path = svn_dirent_join(path, node->name, subpool);
-  SVN_ERR(print_changed_tree(node, full_path, copy_info, subpool));
-  while (node->sibling)
-    {
-      svn_pool_clear(subpool);
-      node = node->sibling;
-      full_path = svn_dirent_join(path, node->name, subpool);
-      SVN_ERR(print_changed_tree(node, full_path, copy_info, subpool));
+      return SVN_NO_ERROR;
     }
-  svn_pool_destroy(subpool);
+
+  /* A modification; only files have text. */
+  if (change->text_mod && kind == svn_node_file)
+    status[0] = 'U';
+  if (change->prop_mod)
+    status[1] = 'U';
+
+  if (status[0] != '_' || status[1] != ' ')
+    SVN_ERR(svn_cmdline_printf(scratch_pool, "%s %s%s\n",
+                               status, display_path,
+                               kind == svn_node_dir ? "/" : ""));
 
   return SVN_NO_ERROR;
 }
@@ -885,10 +979,12 @@ display_prop_diffs(const apr_array_header_t *prop_diffs,
 
 
 
-/* Recursively print all nodes in the tree that have been modified
-   (do not include directories affected only by "bubble-up"). */
+/* Print the diff of NODE, the change of PATH (UTF-8!) in ROOT, against
+   BASE_PATH (UTF-8!) in BASE_ROOT, unless NODE is just the "bubble-up" of
+   changes below.  NODE stands for its own change only; its children are
+   not looked at.  Write temporary files to TMPDIR. */
 static svn_error_t *
-print_diff_tree(svn_fs_root_t *root,
+print_diff_node(svn_fs_root_t *root,
                 svn_fs_root_t *base_root,
                 svn_repos_node_t *node,
                 const char *path /* UTF-8! */,
@@ -902,14 +998,8 @@ print_diff_tree(svn_fs_root_t *root,
   svn_boolean_t orig_empty = FALSE;
   svn_boolean_t is_copy = FALSE;
   svn_boolean_t binary = FALSE;
-  apr_pool_t *subpool;
   svn_stringbuf_t *header;
 
-  SVN_ERR(check_cancel(NULL));
-
-  if (! node)
-    return SVN_NO_ERROR;
-
   header = svn_stringbuf_create("", pool);
 
   /* Print copyfrom history for the top node of a copied tree. */
@@ -1117,28 +1207,6 @@ print_diff_tree(svn_fs_root_t *root,
         SVN_ERR(display_prop_diffs(props, base_proptable, path, pool));
     }
 
-  /* Return here if the node has no children. */
-  node = node->child;
-  if (! node)
-    return SVN_NO_ERROR;
-
-  /* Recursively handle the node's children. */
-  subpool = svn_pool_create(pool);
-  SVN_ERR(print_diff_tree(root, base_root, node,
-                          svn_dirent_join(path, node->name, subpool),
-                          svn_dirent_join(base_path, node->name, subpool),
-                          c, tmpdir, subpool));
-  while (node->sibling)
-    {
-      svn_pool_clear(subpool);
-      node = node->sibling;
-      SVN_ERR(print_diff_tree(root, base_root, node,
-                              svn_dirent_join(path, node->name, subpool),
-                              svn_dirent_join(base_path, node->name, subpool),
-                              c, tmpdir, subpool));
-    }
-  svn_pool_destroy(subpool);
-
   return SVN_NO_ERROR;
 }
 
@@ -1443,9 +1511,11 @@ do_cat(svnlook_ctxt_t *c, const char *path, apr_pool_t *pool)
 static svn_error_t *
 do_changed(svnlook_ctxt_t *c, apr_pool_t *pool)
 {
-  svn_fs_root_t *root;
+  svn_fs_root_t *root, *base_root;
   svn_revnum_t base_rev_id;
-  svn_repos_node_t *tree;
+  svn_fs_path_change_iterator_t *changes;
+  apr_array_header_t *copies;
+  apr_pool_t *iterpool;
 
   SVN_ERR(get_root(&root, c, pool));
   if (c->is_revision)
@@ -1459,22 +1529,146 @@ do_changed(svnlook_ctxt_t *c, apr_pool_t *pool)
        _("Transaction '%s' is not based on a revision; how odd"),
        c->txn_name);
 
-  SVN_ERR(generate_delta_tree(&tree, c->repos, root, base_rev_id,
-                              TRUE, pool));
-  if (tree)
-    SVN_ERR(print_changed_tree(tree, "", c->copy_info, pool));
+  SVN_ERR(svn_fs_revision_root(&base_root, svn_fs_root_fs(root),
+                               base_rev_id, pool));
+
+  /* Print the changes as they come, in depth-first order, rather than
+     building a tree of all of them first. */
+  SVN_ERR(svn_fs_paths_changed_iterator(&changes, root, pool));
+  copies = apr_array_make(pool, 4, sizeof(struct changed_copy_t));
+  iterpool = svn_pool_create(pool);
+  while (TRUE)
+    {
+      const char *path;
+      svn_fs_path_change2_t *change;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_cancel(NULL));
+
+      SVN_ERR(svn_fs_path_change_get(&path, &change, changes, iterpool));
+      if (! path)
+        break;
+
+      /* Forget about copies PATH is not part of. */
+      while (copies->nelts > 0)
+        {
+          struct changed_copy_t *copy
+            = &APR_ARRAY_IDX(copies, copies->nelts - 1,
+                             struct changed_copy_t);
+
+          if (svn_dirent_is_ancestor(copy->path, path))
+            break;
+          copies->nelts--;
+        }
+
+      SVN_ERR(print_change(root, base_root, path, change, copies,
+                           c->copy_info, pool, iterpool));
+    }
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
 
 
-/* Print some diff-y stuff in a TBD way. :-) */
+/* Print the diff of the CHANGE of PATH (UTF-8!) in ROOT, unless it is
+   just the "bubble-up" of changes below.  BASE_ROOT and COPIES are as for
+   get_base_location(); push PATH onto COPIES (allocated in RESULT_POOL)
+   if CHANGE copies a directory.  Write temporary files to TMPDIR.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+print_diff_change(svn_fs_root_t *root,
+                  svn_fs_root_t *base_root,
+                  const char *path,
+                  svn_fs_path_change2_t *change,
+                  apr_array_header_t *copies,
+                  const svnlook_ctxt_t *c,
+                  const char *tmpdir,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  const char *display_path = (path[0] == '/') ? path + 1 : path;
+  svn_repos_node_t node = { 0 };
+  svn_fs_root_t *node_base_root;
+  const char *base_path;
+
+  if (change->change_kind == svn_fs_path_change_reset)
+    return SVN_NO_ERROR;
+
+  /* Diffs label paths without the leading slash. */
+  SVN_ERR(get_base_location(&node_base_root, &base_path, root, base_root,
+                            path, copies, scratch_pool));
+  if (base_path[0] == '/')
+    base_path++;
+  node.copyfrom_rev = SVN_INVALID_REVNUM;
+
+  /* A replacement shows as the deletion of the old node followed by the
+     addition of the new one. */
+  if (change->change_kind == svn_fs_path_change_delete
+      || change->change_kind == svn_fs_path_change_replace)
+    {
+      node.action = 'D';
+      node.kind = change->node_kind;
+      if (change->change_kind == svn_fs_path_change_replace
+          || node.kind == svn_node_unknown)
+        SVN_ERR(get_deleted_kind(&node.kind, root, base_root, path,
+                                 copies, scratch_pool));
+
+      SVN_ERR(print_diff_node(root, node_base_root, &node, display_path,
+                              base_path, c, tmpdir, scratch_pool));
+
+      if (change->change_kind == svn_fs_path_change_delete)
+        return SVN_NO_ERROR;
+    }
+
+  node.kind = change->node_kind;
+  if (node.kind == svn_node_unknown)
+    SVN_ERR(svn_fs_check_path(&node.kind, root, path, scratch_pool));
+  node.text_mod = change->text_mod;
+  node.prop_mod = change->prop_mod;
+
+  if (change->change_kind == svn_fs_path_change_add
+      || change->change_kind == svn_fs_path_change_replace)
+    {
+      node.action = 'A';
+      node.copyfrom_path = change->copyfrom_path;
+      node.copyfrom_rev = change->copyfrom_rev;
+      if (! change->copyfrom_known)
+        SVN_ERR(svn_fs_copied_from(&node.copyfrom_rev, &node.copyfrom_path,
+                                   root, path, scratch_pool));
+      if (! SVN_IS_VALID_REVNUM(node.copyfrom_rev))
+        node.copyfrom_path = NULL;
+
+      if (node.copyfrom_path && node.kind == svn_node_dir)
+        {
+          struct changed_copy_t *copy
+            = &APR_ARRAY_PUSH(copies, struct changed_copy_t);
+
+          copy->path = apr_pstrdup(result_pool, path);
+          copy->copyfrom_path = apr_pstrdup(result_pool,
+                                            node.copyfrom_path);
+          copy->copyfrom_rev = node.copyfrom_rev;
+        }
+    }
+  else
+    node.action = 'R';
+
+  return print_diff_node(root, node_base_root, &node, display_path,
+                         base_path, c, tmpdir, scratch_pool);
+}
+
+
+/* Print GNU-style diffs of the changes of the revision or transaction
+   in C, as they come from the changed-paths list, rather than building
+   a tree of all of them first. */
 static svn_error_t *
 do_diff(svnlook_ctxt_t *c, apr_pool_t *pool)
 {
   svn_fs_root_t *root, *base_root;
   svn_revnum_t base_rev_id;
-  svn_repos_node_t *tree;
+  svn_fs_path_change_iterator_t *changes;
+  apr_array_header_t *copies;
+  const char *tmpdir;
+  apr_pool_t *iterpool;
 
   SVN_ERR(get_root(&root, c, pool));
   if (c->is_revision)
@@ -1488,18 +1682,41 @@ do_diff(svnlook_ctxt_t *c, apr_pool_t *pool)
        _("Transaction '%s' is not based on a revision; how odd"),
        c->txn_name);
 
-  SVN_ERR(generate_delta_tree(&tree, c->repos, root, base_rev_id,
-                              TRUE, pool));
-  if (tree)
+  SVN_ERR(svn_fs_revision_root(&base_root, c->fs, base_rev_id, pool));
+  SVN_ERR(svn_io_temp_dir(&tmpdir, pool));
+
+  SVN_ERR(svn_fs_paths_changed_iterator(&changes, root, pool));
+  copies = apr_array_make(pool, 4, sizeof(struct changed_copy_t));
+  iterpool = svn_pool_create(pool);
+  while (TRUE)
     {
-      const char *tmpdir;
+      const char *path;
+      svn_fs_path_change2_t *change;
 
-      SVN_ERR(svn_fs_revision_root(&base_root, c->fs, base_rev_id, pool));
-      SVN_ERR(svn_io_temp_dir(&tmpdir, pool));
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_cancel(NULL));
+
+      SVN_ERR(svn_fs_path_change_get(&path, &change, changes, iterpool));
+      if (! path)
+        break;
+
+      /* Forget about copies PATH is not part of. */
+      while (copies->nelts > 0)
+        {
+          struct changed_copy_t *copy
+            = &APR_ARRAY_IDX(copies, copies->nelts - 1,
+                             struct changed_copy_t);
+
+          if (svn_dirent_is_ancestor(copy->path, path))
+            break;
+          copies->nelts--;
+        }
 
-      SVN_ERR(print_diff_tree(root, base_root, tree, "", "",
-                              c, tmpdir, pool));
+      SVN_ERR(print_diff_change(root, base_root, path, change, copies,
+                                c, tmpdir, pool, iterpool));
     }
+  svn_pool_destroy(iterpool);
+
   return SVN_NO_ERROR;
 }
 
@@ -1828,7 +2045,8 @@ get_ctxt_baton(svnlook_ctxt_t **baton_p,
 {
   svnlook_ctxt_t *baton = apr_pcalloc(pool, sizeof(*baton));
 
-  SVN_ERR(svn_repos_open(&(baton->repos), opt_state->repos_path, pool));
+  SVN_ERR(svn_repos_open2(&(baton->repos), opt_state->repos_path, NULL,
+                          pool));
   baton->fs = svn_repos_fs(baton->repos);
   svn_fs_set_warning_func(baton->fs, warning_func, NULL);
   baton->show_ids = opt_state->show_ids;
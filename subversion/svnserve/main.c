@@ -32,6 +32,12 @@
 #include <apr_thread_proc.h>
 #include <apr_portable.h>
 
+#if APR_HAS_THREADS
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#include <apr_poll.h>
+#endif
+
 #include <locale.h>
 
 #include "svn_cmdline.h"
@@ -48,6 +54,9 @@
 #include "svn_version.h"
 #include "svn_io.h"
 
+#include "private/svn_cache.h"
+#include "private/svn_ra_svn_private.h"
+
 #include "svn_private_config.h"
 #include "winservice.h"
 
@@ -62,6 +71,7 @@
 enum connection_handling_mode {
   connection_mode_fork,   /* Create a process per connection */
   connection_mode_thread, /* Create a thread per connection */
+  connection_mode_workers, /* Hand connections to a fixed set of threads */
   connection_mode_single  /* One connection at a time in this process */
 };
 
@@ -143,6 +153,18 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_SERVICE     262
 #define SVNSERVE_OPT_CONFIG_FILE 263
 #define SVNSERVE_OPT_LOG_FILE 264
+#define SVNSERVE_OPT_CACHE_FULLTEXTS 265
+#define SVNSERVE_OPT_WORKER_THREADS 266
+#define SVNSERVE_OPT_MAX_CONNECTIONS 267
+#define SVNSERVE_OPT_STATS_FILE 268
+
+/* The default number of accepted connections that may wait for a worker
+   thread, see --max-connections. */
+#define DEFAULT_MAX_CONNECTIONS 64
+
+/* The number of idle worker sessions that may wait for their next
+   command without keeping a thread busy. */
+#define MAX_IDLE_SESSIONS 8192
 
 static const apr_getopt_option_t svnserve__options[] =
   {
@@ -193,12 +215,48 @@ static const apr_getopt_option_t svnserve__options[] =
     {"threads",          'T', 0, N_("use threads instead of fork "
                                     "[mode: daemon]")},
 #endif
+#if APR_HAS_THREADS
+    {"worker-threads",   SVNSERVE_OPT_WORKER_THREADS, 1,
+     N_("serve connections with a fixed set of ARG\n"
+        "                             "
+        "threads, which keep the repositories open in\n"
+        "                             "
+        "between connections\n"
+        "                             "
+        "[mode: daemon]")},
+    {"max-connections",  SVNSERVE_OPT_MAX_CONNECTIONS, 1,
+     N_("let at most ARG accepted connections wait\n"
+        "                             "
+        "for a worker thread. Default: 64.\n"
+        "                             "
+        "[mode: daemon, with --worker-threads]")},
+#endif
+    {"memory-cache-size", 'M', 1,
+     N_("size of the extra in-memory cache in MB used to\n"
+        "                             "
+        "minimize redundant operations. Default: 16.\n"
+        "                             "
+        "In fork mode, all connections share one cache.\n"
+        "                             "
+        "[used for FSFS repositories only]")},
+    {"cache-fulltexts", SVNSERVE_OPT_CACHE_FULLTEXTS, 1,
+     N_("enable or disable caching of file contents\n"
+        "                             "
+        "Default is yes.\n"
+        "                             "
+        "[used for FSFS repositories only]")},
     {"foreground",        SVNSERVE_OPT_FOREGROUND, 0,
      N_("run in foreground (useful for debugging)\n"
         "                             "
         "[mode: daemon]")},
     {"log-file",         SVNSERVE_OPT_LOG_FILE, 1,
      N_("svnserve log file")},
+    {"stats-file",       SVNSERVE_OPT_STATS_FILE, 1,
+     N_("keep per-command latencies and other\n"
+        "                             "
+        "server statistics in file ARG\n"
+        "                             "
+        "[not with one process per connection]")},
     {"pid-file",         SVNSERVE_OPT_PID_FILE, 1,
 #ifdef WIN32
      N_("write server process ID to file ARG\n"
@@ -220,6 +278,15 @@ static const apr_getopt_option_t svnserve__options[] =
   };
 
 
+/* Return TRUE if ARG is one of the usual spellings of "no". */
+static svn_boolean_t is_false_word(const char *arg)
+{
+  return svn_cstring_casecmp(arg, "no") == 0
+      || svn_cstring_casecmp(arg, "false") == 0
+      || svn_cstring_casecmp(arg, "off") == 0
+      || strcmp(arg, "0") == 0;
+}
+
 static void usage(const char *progname, apr_pool_t *pool)
 {
   if (!progname)
@@ -321,6 +388,307 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
 
   return NULL;
 }
+
+/* A connection served by the worker threads. */
+struct worker_session_t {
+  svn_ra_svn_conn_t *conn;
+  apr_socket_t *sock;
+  apr_pool_t *pool;
+
+  /* The session once the handshake is done, and the worker serving it.
+     A session stays with its worker, since it may use repositories from
+     that worker's cache. */
+  serve_session_t *session;
+  struct worker_t *worker;
+
+  /* For watching the connection while the session is idle. */
+  apr_pollfd_t pfd;
+
+  /* The next session in the ready list of WORKER. */
+  struct worker_session_t *next;
+};
+
+/* A worker thread. */
+struct worker_t {
+  struct worker_pool_t *workers;
+
+  /* Idle sessions of this worker that received their next command, in
+     order.  Protected by WORKERS->MUTEX. */
+  struct worker_session_t *ready_first;
+  struct worker_session_t *ready_last;
+};
+
+/* A fixed set of threads serving the connections the main thread
+   accepts, see --worker-threads. */
+struct worker_pool_t {
+  /* New connections waiting for a worker, in a ring of MAX_QUEUED slots:
+     QUEUED of them, starting at QUEUE[FIRST].  Access to these and to the
+     workers' ready lists is serialized by MUTEX, and COND gets signalled
+     whenever any of them changes. */
+  struct worker_session_t **queue;
+  int max_queued;
+  int first;
+  int queued;
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* Sessions waiting for their next command, watched by the I/O thread,
+     or NULL if idle sessions keep their worker waiting. */
+  apr_pollset_t *pollset;
+
+  /* The parameters each worker starts its own copy of. */
+  serve_params_t *params;
+};
+
+/* Stop watching S, and queue it for its worker. */
+static void session_ready(struct worker_session_t *s)
+{
+  struct worker_t *worker = s->worker;
+  struct worker_pool_t *workers = worker->workers;
+
+  apr_thread_mutex_lock(workers->mutex);
+  s->next = NULL;
+  if (worker->ready_last)
+    worker->ready_last->next = s;
+  else
+    worker->ready_first = s;
+  worker->ready_last = s;
+  apr_thread_cond_broadcast(workers->cond);
+  apr_thread_mutex_unlock(workers->mutex);
+}
+
+/* Thread function of the I/O thread: hand each idle session of DATA, a
+   struct worker_pool_t, back to its worker once its connection becomes
+   readable, which includes the client hanging up. */
+static void * APR_THREAD_FUNC io_thread(apr_thread_t *tid, void *data)
+{
+  struct worker_pool_t *workers = data;
+
+  while (1)
+    {
+      const apr_pollfd_t *descriptors;
+      apr_int32_t n;
+      apr_int32_t i;
+      apr_status_t status;
+
+      status = apr_pollset_poll(workers->pollset, -1, &n, &descriptors);
+      if (status)
+        continue; /* EINTR, mostly. */
+
+      for (i = 0; i < n; i++)
+        {
+          struct worker_session_t *s = descriptors[i].client_data;
+
+          apr_pollset_remove(workers->pollset, &s->pfd);
+          session_ready(s);
+        }
+    }
+
+  /* NOTREACHED */
+  return NULL;
+}
+
+/* Have the I/O thread of WORKERS watch S until its next command arrives.
+   Return FALSE if S can't be watched and must be served right away. */
+static svn_boolean_t park_session(struct worker_pool_t *workers,
+                                  struct worker_session_t *s)
+{
+  if (! workers->pollset)
+    return FALSE;
+
+  s->pfd.p = s->pool;
+  s->pfd.desc_type = APR_POLL_SOCKET;
+  s->pfd.reqevents = APR_POLLIN;
+  s->pfd.rtnevents = 0;
+  s->pfd.desc.s = s->sock;
+  s->pfd.client_data = s;
+
+  /* Once added, S belongs to the I/O thread. */
+  return apr_pollset_add(workers->pollset, &s->pfd) == APR_SUCCESS;
+}
+
+/* Thread function serving the sessions of DATA, a struct worker_t, and
+   new connections from its worker pool.  Repositories stay open for
+   later connections to them.
+
+   A session is served as long as commands keep arriving; when the client
+   has nothing more to say for the moment, it is parked with the I/O thread
+   instead of keeping this thread waiting. */
+static void * APR_THREAD_FUNC worker_thread(apr_thread_t *tid, void *data)
+{
+  struct worker_t *worker = data;
+  struct worker_pool_t *workers = worker->workers;
+  serve_params_t params = *workers->params;
+  apr_pool_t *iterpool = svn_pool_create(NULL);
+
+  params.repos_cache = apr_hash_make(svn_pool_create(NULL));
+
+  while (1)
+    {
+      struct worker_session_t *s;
+      svn_boolean_t done = FALSE;
+      svn_boolean_t parked = FALSE;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      /* Sessions we already serve come before new connections. */
+      apr_thread_mutex_lock(workers->mutex);
+      while (! worker->ready_first && workers->queued == 0)
+        apr_thread_cond_wait(workers->cond, workers->mutex);
+      if (worker->ready_first)
+        {
+          s = worker->ready_first;
+          worker->ready_first = s->next;
+          if (! worker->ready_first)
+            worker->ready_last = NULL;
+        }
+      else
+        {
+          s = workers->queue[workers->first];
+          workers->first = (workers->first + 1) % workers->max_queued;
+          workers->queued--;
+          apr_thread_cond_broadcast(workers->cond);
+        }
+      apr_thread_mutex_unlock(workers->mutex);
+
+      if (! s->session)
+        {
+          s->worker = worker;
+          err = serve_session_open(&s->session, s->conn, &params, s->pool);
+          done = (err || ! s->session);
+        }
+
+      while (! done)
+        {
+          svn_pool_clear(iterpool);
+
+          if (! svn_ra_svn__data_available(s->conn))
+            {
+              /* The client will wait for our response before it sends
+                 anything else. */
+              err = svn_ra_svn_flush(s->conn, iterpool);
+              if (err)
+                break;
+
+              parked = park_session(workers, s);
+              if (parked)
+                break;
+            }
+
+          err = serve_session_command(&done, s->session, iterpool);
+          if (err)
+            break;
+        }
+
+      if (parked)
+        continue;
+
+      if (s->session)
+        serve_session_close(s->session, iterpool);
+      log_error(err, params.log_file, svn_ra_svn_conn_remote_host(s->conn),
+                NULL, NULL, /* user, repos */
+                iterpool);
+      svn_error_clear(err);
+      svn_pool_destroy(s->pool);
+      svn_pool_clear(iterpool);
+    }
+
+  /* NOTREACHED */
+  return NULL;
+}
+
+/* Start NTHREADS detached worker threads serving connections with
+   PARAMS, at most MAX_QUEUED of which may wait for a worker, and the
+   I/O thread watching their idle sessions.  Set *WORKERS to the new
+   worker pool, allocated in POOL. */
+static svn_error_t *start_workers(struct worker_pool_t **workers,
+                                  int nthreads,
+                                  int max_queued,
+                                  serve_params_t *params,
+                                  apr_pool_t *pool)
+{
+  struct worker_pool_t *w = apr_pcalloc(pool, sizeof(*w));
+  apr_threadattr_t *tattr;
+  apr_thread_t *tid;
+  apr_status_t status;
+  int i;
+
+  w->queue = apr_palloc(pool, max_queued * sizeof(*w->queue));
+  w->max_queued = max_queued;
+  w->params = params;
+
+  status = apr_thread_mutex_create(&w->mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create mutex"));
+  status = apr_thread_cond_create(&w->cond, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  /* Watching sessions from one thread while the workers add them needs
+     a thread-safe pollset, which APR provides with epoll, kqueue and
+     event ports.  Without it, each session keeps its worker. */
+  status = apr_pollset_create(&w->pollset, MAX_IDLE_SESSIONS, pool,
+                              APR_POLLSET_THREADSAFE);
+  if (status)
+    w->pollset = NULL;
+
+  status = apr_threadattr_create(&tattr, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create threadattr"));
+  status = apr_threadattr_detach_set(tattr, 1);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't set detached state"));
+
+  for (i = 0; i < nthreads; i++)
+    {
+      struct worker_t *worker = apr_pcalloc(pool, sizeof(*worker));
+
+      worker->workers = w;
+      status = apr_thread_create(&tid, tattr, worker_thread, worker, pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create thread"));
+    }
+
+  if (w->pollset)
+    {
+      status = apr_thread_create(&tid, tattr, io_thread, w, pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create thread"));
+    }
+
+  *workers = w;
+  return SVN_NO_ERROR;
+}
+
+/* Wait until WORKERS can take another connection. */
+static void wait_for_worker(struct worker_pool_t *workers)
+{
+  apr_thread_mutex_lock(workers->mutex);
+  while (workers->queued == workers->max_queued)
+    apr_thread_cond_wait(workers->cond, workers->mutex);
+  apr_thread_mutex_unlock(workers->mutex);
+}
+
+/* Queue CONN on SOCK, which live in POOL, for the next idle thread of
+   WORKERS.  wait_for_worker() must have made room for it. */
+static void queue_connection(struct worker_pool_t *workers,
+                             svn_ra_svn_conn_t *conn,
+                             apr_socket_t *sock,
+                             apr_pool_t *pool)
+{
+  struct worker_session_t *s = apr_pcalloc(pool, sizeof(*s));
+
+  s->conn = conn;
+  s->sock = sock;
+  s->pool = pool;
+
+  apr_thread_mutex_lock(workers->mutex);
+  workers->queue[(workers->first + workers->queued) % workers->max_queued]
+    = s;
+  workers->queued++;
+  apr_thread_cond_broadcast(workers->cond);
+  apr_thread_mutex_unlock(workers->mutex);
+}
 #endif
 
 /* Write the PID of the current process as a decimal number, followed by a
@@ -383,6 +751,9 @@ int main(int argc, const char *argv[])
   apr_thread_t *tid;
 
   struct serve_thread_t *thread_data;
+  struct worker_pool_t *workers = NULL;
+  int worker_threads = 0;
+  int max_connections = DEFAULT_MAX_CONNECTIONS;
 #endif
   enum connection_handling_mode handling_mode = CONNECTION_DEFAULT;
   apr_uint16_t port = SVN_RA_SVN_PORT;
@@ -394,7 +765,9 @@ int main(int argc, const char *argv[])
   const char *config_filename = NULL;
   const char *pid_filename = NULL;
   const char *log_filename = NULL;
+  const char *stats_filename = NULL;
   svn_node_kind_t kind;
+  svn_cache__config_t cache_settings = *svn_cache__get_global_config();
 
   /* Initialize the app. */
   if (svn_cmdline_init("svnserve", stderr) != EXIT_SUCCESS)
@@ -429,6 +802,8 @@ int main(int argc, const char *argv[])
   params.pwdb = NULL;
   params.authzdb = NULL;
   params.log_file = NULL;
+  params.repos_cache = NULL;
+  params.stats = NULL;
 
   while (1)
     {
@@ -480,6 +855,14 @@ int main(int argc, const char *argv[])
           host = arg;
           break;
 
+        case 'M':
+          cache_settings.cache_size = 0x100000 * apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_CACHE_FULLTEXTS:
+          cache_settings.cache_fulltexts = ! is_false_word(arg);
+          break;
+
         case 't':
           if (run_mode != run_mode_tunnel)
             {
@@ -528,6 +911,31 @@ int main(int argc, const char *argv[])
           handling_mode = connection_mode_thread;
           break;
 
+#if APR_HAS_THREADS
+        case SVNSERVE_OPT_WORKER_THREADS:
+          worker_threads = atoi(arg);
+          if (worker_threads <= 0)
+            {
+              svn_error_clear(svn_cmdline_fprintf(stderr, pool,
+                  _("svnserve: Invalid number of worker threads '%s'.\n"),
+                  arg));
+              return EXIT_FAILURE;
+            }
+          handling_mode = connection_mode_workers;
+          break;
+
+        case SVNSERVE_OPT_MAX_CONNECTIONS:
+          max_connections = atoi(arg);
+          if (max_connections <= 0)
+            {
+              svn_error_clear(svn_cmdline_fprintf(stderr, pool,
+                  _("svnserve: Invalid number of connections '%s'.\n"),
+                  arg));
+              return EXIT_FAILURE;
+            }
+          break;
+#endif
+
 #ifdef WIN32
         case SVNSERVE_OPT_SERVICE:
           if (run_mode != run_mode_service)
@@ -559,6 +967,13 @@ int main(int argc, const char *argv[])
                                               pool));
           break;
 
+        case SVNSERVE_OPT_STATS_FILE:
+          SVN_INT_ERR(svn_utf_cstring_to_utf8(&stats_filename, arg, pool));
+          stats_filename = svn_dirent_internal_style(stats_filename, pool);
+          SVN_INT_ERR(svn_dirent_get_absolute(&stats_filename, stats_filename,
+                                              pool));
+          break;
+
         }
     }
   if (os->ind != argc)
@@ -591,6 +1006,36 @@ int main(int argc, const char *argv[])
                                  APR_WRITE | APR_CREATE | APR_APPEND,
                                  APR_OS_DEFAULT, pool));
 
+  /* Configure the FSFS caches before any repository gets opened.  When
+   * forking a process per connection, put the cache into shared memory
+   * so that all connections profit from each other's work. */
+  cache_settings.shared = (run_mode == run_mode_daemon
+                           && handling_mode == connection_mode_fork);
+  err = svn_cache__set_global_config(&cache_settings);
+  if (err)
+    {
+      svn_handle_warning2(stderr, err, "svnserve: ");
+      svn_error_clear(err);
+    }
+
+  /* The counters live in this process, so they can't see connections
+   * served by child processes. */
+  if (stats_filename)
+    {
+      if (run_mode == run_mode_daemon
+          && handling_mode == connection_mode_fork)
+        {
+          svn_error_clear
+            (svn_cmdline_fprintf
+               (stderr, pool,
+                _("Option --stats-file requires --threads or "
+                  "--worker-threads in daemon mode.\n")));
+          exit(1);
+        }
+      SVN_INT_ERR(server_stats_create(&params.stats, stats_filename, pool));
+      SVN_INT_ERR(server_stats_write(params.stats, TRUE, pool));
+    }
+
   if (params.tunnel_user && run_mode != run_mode_tunnel)
     {
       svn_error_clear
@@ -740,7 +1185,14 @@ int main(int argc, const char *argv[])
       return svn_cmdline_handle_exit_error(err, pool, "svnserve: ");
     }
 
-  apr_socket_listen(sock, 7);
+#if APR_HAS_THREADS
+  /* Connections that arrive while all workers are busy and the queue is
+     full wait in the listen queue; make room for a burst of them. */
+  if (handling_mode == connection_mode_workers)
+    apr_socket_listen(sock, max_connections);
+  else
+#endif
+    apr_socket_listen(sock, 7);
 
 #if APR_HAS_FORK
   if (run_mode != run_mode_listen_once && !foreground)
@@ -764,6 +1216,14 @@ int main(int argc, const char *argv[])
   if (pid_filename)
     SVN_INT_ERR(write_pid_file(pid_filename, pool));
 
+#if APR_HAS_THREADS
+  /* Start the workers only now, since daemonizing forks. */
+  if (handling_mode == connection_mode_workers
+      && run_mode != run_mode_listen_once)
+    SVN_INT_ERR(start_workers(&workers, worker_threads, max_connections,
+                              &params, pool));
+#endif
+
 #ifdef WIN32
   status = apr_os_sock_get(&winservice_svnserve_accept_socket, sock);
   if (status)
@@ -781,6 +1241,13 @@ int main(int argc, const char *argv[])
         return ERROR_SUCCESS;
 #endif
 
+#if APR_HAS_THREADS
+      /* Leave new connections in the listen queue until a worker can
+         take them. */
+      if (workers)
+        wait_for_worker(workers);
+#endif
+
       /* Non-standard pool handling.  The main thread never blocks to join
          the connection threads so it cannot clean up after each one.  So
          separate pools, that can be cleared at thread exit, are used */
@@ -907,6 +1374,12 @@ int main(int argc, const char *argv[])
 #endif
           break;
 
+        case connection_mode_workers:
+#if APR_HAS_THREADS
+          queue_connection(workers, conn, usock, connection_pool);
+#endif
+          break;
+
         case connection_mode_single:
           /* Serve one connection at a time. */
           svn_error_clear(serve(conn, &params, connection_pool));
@@ -42,6 +42,7 @@
 #include "svn_ra.h"              /* for SVN_RA_CAPABILITY_* */
 #include "svn_ra_svn.h"
 #include "svn_repos.h"
+#include "svn_diff.h"
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
 #include "svn_time.h"
@@ -50,8 +51,13 @@
 #include "svn_mergeinfo.h"
 #include "svn_user.h"
 
+#include "private/svn_cache.h"
+#include "private/svn_config_private.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_log.h"
 #include "private/svn_mergeinfo_private.h"
+#include "private/svn_ra_svn_private.h"
+#include "private/svn_repos_private.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -374,12 +380,31 @@ static svn_error_t *authz_check_access_cb(svn_boolean_t *allowed,
   return authz_check_access(allowed, path, svn_authz_read, sb, pool);
 }
 
-/* If authz is enabled in the specified BATON, return a read authorization
-   function. Otherwise, return NULL. */
+/* If authz is enabled in the specified BATON, and the user may not read
+   the whole repository, return a read authorization function.
+   Otherwise, return NULL, so that callers skip checking every path. */
 static svn_repos_authz_func_t authz_check_access_cb_func(server_baton_t *baton)
 {
   if (baton->authzdb)
-     return authz_check_access_cb;
+    {
+      apr_pool_t *subpool = svn_pool_create(baton->pool);
+      svn_boolean_t readable;
+      svn_error_t *err;
+
+      err = authz_check_access(&readable, "/",
+                               svn_authz_read | svn_authz_recursive,
+                               baton, subpool);
+      svn_pool_destroy(subpool);
+      if (err)
+        {
+          /* Leave it to the path by path checks to report this. */
+          svn_error_clear(err);
+          readable = FALSE;
+        }
+
+      if (! readable)
+        return authz_check_access_cb;
+    }
   return NULL;
 }
 
@@ -640,13 +665,18 @@ static svn_boolean_t lookup_access(apr_pool_t *pool,
  *
  * PATH and NEEDS_USERNAME are passed along to lookup_access, their
  * behaviour is documented there.
+ *
+ * If MAY_AUTHENTICATE is FALSE, fail instead of attempting to
+ * authenticate the client; this is for commands the client pipelined,
+ * whose responses it reads only after sending further commands.
  */
-static svn_error_t *must_have_access(svn_ra_svn_conn_t *conn,
-                                     apr_pool_t *pool,
-                                     server_baton_t *b,
-                                     svn_repos_authz_access_t required,
-                                     const char *path,
-                                     svn_boolean_t needs_username)
+static svn_error_t *check_access(svn_ra_svn_conn_t *conn,
+                                 apr_pool_t *pool,
+                                 server_baton_t *b,
+                                 svn_repos_authz_access_t required,
+                                 const char *path,
+                                 svn_boolean_t needs_username,
+                                 svn_boolean_t may_authenticate)
 {
   enum access_type req = (required & svn_authz_write) ?
     WRITE_ACCESS : READ_ACCESS;
@@ -666,7 +696,8 @@ static svn_error_t *must_have_access(svn_ra_svn_conn_t *conn,
      requiring a username because we need one to be able to check
      authz configuration again with a different user credentials than
      the first time round. */
-  if (b->user == NULL
+  if (may_authenticate
+      && b->user == NULL
       && get_access(b, AUTHENTICATED) >= req
       && (b->tunnel_user || b->pwdb || b->use_sasl))
     SVN_ERR(auth_request(conn, pool, b, req, TRUE));
@@ -685,6 +716,18 @@ static svn_error_t *must_have_access(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Like check_access(), attempting to authenticate the client if
+ * needed. */
+static svn_error_t *must_have_access(svn_ra_svn_conn_t *conn,
+                                     apr_pool_t *pool,
+                                     server_baton_t *b,
+                                     svn_repos_authz_access_t required,
+                                     const char *path,
+                                     svn_boolean_t needs_username)
+{
+  return check_access(conn, pool, b, required, path, needs_username, TRUE);
+}
+
 /* --- REPORTER COMMAND SET --- */
 
 /* To allow for pipelining, reporter commands have no reponses.  If we
@@ -1347,6 +1390,46 @@ static svn_error_t *get_file(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   return SVN_NO_ERROR;
 }
 
+/* Set *DIRENT_FIELDS to the SVN_DIRENT_* flags for the field words in
+   DIRENT_FIELDS_LIST, or to SVN_DIRENT_ALL if that is NULL. */
+static svn_error_t *parse_dirent_fields(apr_uint64_t *dirent_fields,
+                                        apr_array_header_t *dirent_fields_list)
+{
+  svn_ra_svn_item_t *elt;
+  int i;
+
+  if (! dirent_fields_list)
+    {
+      *dirent_fields = SVN_DIRENT_ALL;
+      return SVN_NO_ERROR;
+    }
+
+  *dirent_fields = 0;
+  for (i = 0; i < dirent_fields_list->nelts; ++i)
+    {
+      elt = &APR_ARRAY_IDX(dirent_fields_list, i, svn_ra_svn_item_t);
+
+      if (elt->kind != SVN_RA_SVN_WORD)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                "Dirent field not a string");
+
+      if (strcmp(SVN_RA_SVN_DIRENT_KIND, elt->u.word) == 0)
+        *dirent_fields |= SVN_DIRENT_KIND;
+      else if (strcmp(SVN_RA_SVN_DIRENT_SIZE, elt->u.word) == 0)
+        *dirent_fields |= SVN_DIRENT_SIZE;
+      else if (strcmp(SVN_RA_SVN_DIRENT_HAS_PROPS, elt->u.word) == 0)
+        *dirent_fields |= SVN_DIRENT_HAS_PROPS;
+      else if (strcmp(SVN_RA_SVN_DIRENT_CREATED_REV, elt->u.word) == 0)
+        *dirent_fields |= SVN_DIRENT_CREATED_REV;
+      else if (strcmp(SVN_RA_SVN_DIRENT_TIME, elt->u.word) == 0)
+        *dirent_fields |= SVN_DIRENT_TIME;
+      else if (strcmp(SVN_RA_SVN_DIRENT_LAST_AUTHOR, elt->u.word) == 0)
+        *dirent_fields |= SVN_DIRENT_LAST_AUTHOR;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *get_dir(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                             apr_array_header_t *params, void *baton)
 {
@@ -1360,50 +1443,19 @@ static svn_error_t *get_dir(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   svn_boolean_t want_props, want_contents;
   apr_uint64_t dirent_fields;
   apr_array_header_t *dirent_fields_list = NULL;
-  svn_ra_svn_item_t *elt;
-  int i;
+  apr_uint64_t pipelined;
 
-  SVN_ERR(svn_ra_svn_parse_tuple(params, pool, "c(?r)bb?l", &path, &rev,
+  SVN_ERR(svn_ra_svn_parse_tuple(params, pool, "c(?r)bb?l?B", &path, &rev,
                                  &want_props, &want_contents,
-                                 &dirent_fields_list));
-
-  if (! dirent_fields_list)
-    {
-      dirent_fields = SVN_DIRENT_ALL;
-    }
-  else
-    {
-      dirent_fields = 0;
-
-      for (i = 0; i < dirent_fields_list->nelts; ++i)
-        {
-          elt = &APR_ARRAY_IDX(dirent_fields_list, i, svn_ra_svn_item_t);
-
-          if (elt->kind != SVN_RA_SVN_WORD)
-            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
-                                    "Dirent field not a string");
-
-          if (strcmp(SVN_RA_SVN_DIRENT_KIND, elt->u.word) == 0)
-            dirent_fields |= SVN_DIRENT_KIND;
-          else if (strcmp(SVN_RA_SVN_DIRENT_SIZE, elt->u.word) == 0)
-            dirent_fields |= SVN_DIRENT_SIZE;
-          else if (strcmp(SVN_RA_SVN_DIRENT_HAS_PROPS, elt->u.word) == 0)
-            dirent_fields |= SVN_DIRENT_HAS_PROPS;
-          else if (strcmp(SVN_RA_SVN_DIRENT_CREATED_REV, elt->u.word) == 0)
-            dirent_fields |= SVN_DIRENT_CREATED_REV;
-          else if (strcmp(SVN_RA_SVN_DIRENT_TIME, elt->u.word) == 0)
-            dirent_fields |= SVN_DIRENT_TIME;
-          else if (strcmp(SVN_RA_SVN_DIRENT_LAST_AUTHOR, elt->u.word) == 0)
-            dirent_fields |= SVN_DIRENT_LAST_AUTHOR;
-        }
-    }
+                                 &dirent_fields_list, &pipelined));
+  SVN_ERR(parse_dirent_fields(&dirent_fields, dirent_fields_list));
 
   full_path = svn_uri_join(b->fs_path->data,
                            svn_uri_canonicalize(path, pool), pool);
 
   /* Check authorizations */
-  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read,
-                           full_path, FALSE));
+  SVN_ERR(check_access(conn, pool, b, svn_authz_read, full_path, FALSE,
+                       pipelined != TRUE));
 
   if (!SVN_IS_VALID_REVNUM(rev))
     SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->fs, pool));
@@ -1511,6 +1563,160 @@ static svn_error_t *get_dir(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   return SVN_NO_ERROR;
 }
 
+/* Send the entry PATH described by DIRENT to the connection BATON.
+   Implements svn_repos_dirent_receiver_t. */
+static svn_error_t *list_receiver(const char *path,
+                                  svn_dirent_t *dirent,
+                                  void *baton,
+                                  apr_pool_t *pool)
+{
+  svn_ra_svn_conn_t *conn = baton;
+
+  return svn_ra_svn_write_tuple(conn, pool, "cwnbr(?c)(?c)", path,
+                                svn_node_kind_to_word(dirent->kind),
+                                (apr_uint64_t) dirent->size,
+                                dirent->has_props, dirent->created_rev,
+                                dirent->time
+                                  ? svn_time_to_cstring(dirent->time, pool)
+                                  : NULL,
+                                dirent->last_author);
+}
+
+static svn_error_t *list(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                         apr_array_header_t *params, void *baton)
+{
+  server_baton_t *b = baton;
+  const char *path, *full_path, *depth_word;
+  svn_revnum_t rev;
+  svn_depth_t depth;
+  apr_array_header_t *dirent_fields_list;
+  apr_uint64_t dirent_fields;
+  svn_fs_root_t *root;
+  svn_error_t *err, *write_err;
+
+  SVN_ERR(svn_ra_svn_parse_tuple(params, pool, "c(?r)wl", &path, &rev,
+                                 &depth_word, &dirent_fields_list));
+  depth = svn_depth_from_word(depth_word);
+  SVN_ERR(parse_dirent_fields(&dirent_fields, dirent_fields_list));
+
+  full_path = svn_uri_join(b->fs_path->data,
+                           svn_uri_canonicalize(path, pool), pool);
+
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read, full_path, FALSE));
+
+  if (!SVN_IS_VALID_REVNUM(rev))
+    SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->fs, pool));
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__list(full_path, rev, depth, pool)));
+
+  SVN_CMD_ERR(svn_fs_revision_root(&root, b->fs, rev, pool));
+
+  /* Stream the entries.  (Can't report errors back to the client at
+     this point.) */
+  err = svn_repos_list(root, full_path, depth, (apr_uint32_t) dirent_fields,
+                       authz_check_access_cb_func(b), b,
+                       list_receiver, conn, NULL, NULL, pool);
+
+  write_err = svn_ra_svn_write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+  return svn_ra_svn_write_cmd_response(conn, pool, "");
+}
+
+/* Baton for archive_write(). */
+typedef struct archive_baton_t
+{
+  svn_ra_svn_conn_t *conn;
+  apr_pool_t *pool;
+  svn_boolean_t write_failed;
+} archive_baton_t;
+
+/* Send the LEN bytes at DATA to the connection in the archive_baton_t
+   BATON as a string.  Implements svn_write_fn_t. */
+static svn_error_t *archive_write(void *baton, const char *data,
+                                  apr_size_t *len)
+{
+  archive_baton_t *ab = baton;
+  svn_string_t chunk;
+  svn_error_t *err;
+
+  /* An empty string would end the archive. */
+  if (*len == 0)
+    return SVN_NO_ERROR;
+
+  svn_pool_clear(ab->pool);
+  chunk.data = data;
+  chunk.len = *len;
+  err = svn_ra_svn_write_string(ab->conn, ab->pool, &chunk);
+  if (err)
+    ab->write_failed = TRUE;
+  return err;
+}
+
+static svn_error_t *get_archive(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                                apr_array_header_t *params, void *baton)
+{
+  server_baton_t *b = baton;
+  const char *path, *full_path, *prefix;
+  svn_revnum_t rev;
+  svn_fs_root_t *root;
+  svn_node_kind_t kind;
+  archive_baton_t ab;
+  svn_stream_t *stream;
+  svn_error_t *err, *write_err;
+
+  SVN_ERR(svn_ra_svn_parse_tuple(params, pool, "c(?r)c", &path, &rev,
+                                 &prefix));
+  full_path = svn_uri_join(b->fs_path->data,
+                           svn_uri_canonicalize(path, pool), pool);
+
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read, full_path, FALSE));
+
+  if (!SVN_IS_VALID_REVNUM(rev))
+    SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->fs, pool));
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__get_archive(full_path, rev, pool)));
+
+  SVN_CMD_ERR(svn_fs_revision_root(&root, b->fs, rev, pool));
+  SVN_CMD_ERR(svn_fs_check_path(&kind, root, full_path, pool));
+  if (kind == svn_node_none)
+    SVN_CMD_ERR(svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                                  "Path '%s' not found", full_path));
+
+  /* Send successful command response, then the archive. */
+  SVN_ERR(svn_ra_svn_write_cmd_response(conn, pool, ""));
+
+  ab.conn = conn;
+  ab.pool = svn_pool_create(pool);
+  ab.write_failed = FALSE;
+  stream = svn_stream_create(&ab, pool);
+  svn_stream_set_write(stream, archive_write);
+
+  err = svn_repos_archive(root, full_path, prefix,
+                          authz_check_access_cb_func(b), b, stream,
+                          NULL, NULL, pool);
+  svn_pool_destroy(ab.pool);
+
+  /* A broken connection can't take the end of the archive either. */
+  if (ab.write_failed)
+    return err;
+
+  write_err = svn_ra_svn_write_cstring(conn, pool, "");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+  return svn_ra_svn_write_cmd_response(conn, pool, "");
+}
+
 static svn_error_t *update(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                            apr_array_header_t *params, void *baton)
 {
@@ -1986,14 +2192,16 @@ static svn_error_t *stat_cmd(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   const char *path, *full_path, *cdate;
   svn_fs_root_t *root;
   svn_dirent_t *dirent;
+  apr_uint64_t pipelined;
 
-  SVN_ERR(svn_ra_svn_parse_tuple(params, pool, "c(?r)", &path, &rev));
+  SVN_ERR(svn_ra_svn_parse_tuple(params, pool, "c(?r)?B", &path, &rev,
+                                 &pipelined));
   full_path = svn_uri_join(b->fs_path->data,
                            svn_uri_canonicalize(path, pool), pool);
 
   /* Check authorizations */
-  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read,
-                           full_path, FALSE));
+  SVN_ERR(check_access(conn, pool, b, svn_authz_read, full_path, FALSE,
+                       pipelined != TRUE));
 
   if (!SVN_IS_VALID_REVNUM(rev))
     SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->fs, pool));
@@ -2324,6 +2532,92 @@ static svn_error_t *lock(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   return SVN_NO_ERROR;
 }
 
+/* The outcome of locking or unlocking one path in lock_many() or
+   unlock_many(). */
+typedef struct lock_result_t
+{
+  svn_lock_t *lock;
+  svn_error_t *err;
+} lock_result_t;
+
+/* Implements svn_fs__lock_callback_t, recording the outcome for PATH in
+   the hash of lock_result_t * BATON, allocated in the hash's pool. */
+static svn_error_t *lock_result_callback(void *baton, const char *path,
+                                         const svn_lock_t *lock,
+                                         svn_error_t *fs_err,
+                                         apr_pool_t *pool)
+{
+  apr_hash_t *results = baton;
+  apr_pool_t *result_pool = apr_hash_pool_get(results);
+  lock_result_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  if (lock)
+    result->lock = svn_lock_dup(lock, result_pool);
+  result->err = svn_error_dup(fs_err);
+  apr_hash_set(results, apr_pstrdup(result_pool, path), APR_HASH_KEY_STRING,
+               result);
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the outcomes in RESULTS for the FULL_PATHS requested, in order,
+   as the responses to a lock-many (if DO_LOCK) or unlock-many command,
+   where PATHS are the paths as the client sent them. */
+static svn_error_t *write_lock_results(svn_ra_svn_conn_t *conn,
+                                       apr_pool_t *pool,
+                                       svn_boolean_t do_lock,
+                                       const apr_array_header_t *paths,
+                                       const apr_array_header_t *full_paths,
+                                       apr_hash_t *results)
+{
+  apr_pool_t *subpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i < full_paths->nelts; i++)
+    {
+      const char *full_path = APR_ARRAY_IDX(full_paths, i, const char *);
+      lock_result_t *result = apr_hash_get(results, full_path,
+                                           APR_HASH_KEY_STRING);
+
+      svn_pool_clear(subpool);
+
+      /* Nothing was reported if the whole operation failed early. */
+      if (! result)
+        continue;
+
+      if (result->err)
+        SVN_ERR(svn_ra_svn_write_cmd_failure(conn, subpool, result->err));
+      else if (do_lock)
+        {
+          SVN_ERR(svn_ra_svn_write_tuple(conn, subpool, "w!", "success"));
+          SVN_ERR(write_lock(conn, subpool, result->lock));
+          SVN_ERR(svn_ra_svn_write_tuple(conn, subpool, "!"));
+        }
+      else
+        SVN_ERR(svn_ra_svn_write_tuple(conn, subpool, "w(c)", "success",
+                                       APR_ARRAY_IDX(paths, i,
+                                                     const char *)));
+    }
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Clear the errors left in the lock_result_t * values of RESULTS. */
+static void clear_lock_results(apr_hash_t *results, apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(pool, results); hi; hi = apr_hash_next(hi))
+    {
+      lock_result_t *result = svn__apr_hash_index_val(hi);
+
+      svn_error_clear(result->err);
+      result->err = SVN_NO_ERROR;
+    }
+}
+
 static svn_error_t *lock_many(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                               apr_array_header_t *params, void *baton)
 {
@@ -2332,33 +2626,31 @@ static svn_error_t *lock_many(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   const char *comment;
   svn_boolean_t steal_lock;
   int i;
-  apr_pool_t *subpool;
   const char *path;
   const char *full_path;
   svn_revnum_t current_rev;
-  apr_array_header_t *log_paths;
-  svn_lock_t *l;
+  apr_array_header_t *paths, *log_paths;
+  apr_hash_t *targets = apr_hash_make(pool);
+  apr_hash_t *results = apr_hash_make(pool);
   svn_error_t *err = SVN_NO_ERROR, *write_err;
 
   SVN_ERR(svn_ra_svn_parse_tuple(params, pool, "(?c)bl", &comment, &steal_lock,
                                  &path_revs));
 
-  subpool = svn_pool_create(pool);
-
   /* Because we can only send a single auth reply per request, we send
      a reply before parsing the lock commands.  This means an authz
      access denial will abort the processing of the locks and return
      an error. */
   SVN_ERR(must_have_access(conn, pool, b, svn_authz_write, NULL, TRUE));
 
-  /* Loop through the lock requests. */
+  /* Gather the lock requests, checking them all before locking any. */
+  paths = apr_array_make(pool, path_revs->nelts, sizeof(path));
   log_paths = apr_array_make(pool, path_revs->nelts, sizeof(full_path));
   for (i = 0; i < path_revs->nelts; ++i)
     {
       svn_ra_svn_item_t *item = &APR_ARRAY_IDX(path_revs, i,
                                                svn_ra_svn_item_t);
-
-      svn_pool_clear(subpool);
+      svn_fs__lock_target_t *target;
 
       if (item->kind != SVN_RA_SVN_LIST)
         return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
@@ -2367,11 +2659,10 @@ static svn_error_t *lock_many(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
       SVN_ERR(svn_ra_svn_parse_tuple(item->u.list, pool, "c(?r)", &path,
                                      &current_rev));
 
-      /* Allocate the full_path out of pool so it will survive for use
-       * by operational logging, after this loop. */
       full_path = svn_uri_join(b->fs_path->data,
-                               svn_uri_canonicalize(path, subpool),
+                               svn_uri_canonicalize(path, pool),
                                pool);
+      APR_ARRAY_PUSH(paths, const char *) = path;
       APR_ARRAY_PUSH(log_paths, const char *) = full_path;
 
       if (! lookup_access(pool, b, conn, svn_authz_write, full_path, TRUE))
@@ -2381,38 +2672,34 @@ static svn_error_t *lock_many(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
           break;
         }
 
-      err = svn_repos_fs_lock(&l, b->repos, full_path,
-                              NULL, comment, FALSE,
-                              0, /* No expiration time. */
-                              current_rev,
-                              steal_lock, subpool);
+      target = apr_palloc(pool, sizeof(*target));
+      target->token = NULL;
+      target->current_rev = current_rev;
+      apr_hash_set(targets, full_path, APR_HASH_KEY_STRING, target);
+    }
 
-      if (err)
-        {
-          if (SVN_ERR_IS_LOCK_ERROR(err))
-            {
-              write_err = svn_ra_svn_write_cmd_failure(conn, pool, err);
-              svn_error_clear(err);
-              err = NULL;
-              SVN_ERR(write_err);
-            }
-          else
-            break;
-        }
-      else
+  /* Lock them all at once, running the post-lock hook just once. */
+  if (! err)
+    {
+      err = svn_repos__fs_lock_many(b->repos, targets, comment, FALSE,
+                                    0, /* No expiration time. */
+                                    steal_lock, lock_result_callback,
+                                    results, pool);
+
+      write_err = write_lock_results(conn, pool, TRUE, paths, log_paths,
+                                     results);
+      clear_lock_results(results, pool);
+      if (write_err)
         {
-          SVN_ERR(svn_ra_svn_write_tuple(conn, subpool, "w!", "success"));
-          SVN_ERR(write_lock(conn, subpool, l));
-          SVN_ERR(svn_ra_svn_write_tuple(conn, subpool, "!"));
+          svn_error_clear(err);
+          return write_err;
         }
     }
 
-  svn_pool_destroy(subpool);
-
   SVN_ERR(log_command(b, conn, pool, "%s",
                       svn_log__lock(log_paths, steal_lock, pool)));
 
-  /* NOTE: err might contain a fatal locking error from the loop above. */
+  /* NOTE: err might contain a fatal locking error from above. */
   write_err = svn_ra_svn_write_word(conn, pool, "done");
   if (!write_err)
     SVN_CMD_ERR(err);
@@ -2457,12 +2744,13 @@ static svn_error_t *unlock_many(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   svn_boolean_t break_lock;
   apr_array_header_t *unlock_tokens;
   int i;
-  apr_pool_t *subpool;
   const char *path;
   const char *full_path;
-  apr_array_header_t *log_paths;
+  apr_array_header_t *paths, *log_paths;
   const char *token;
-  svn_error_t *err = SVN_NO_ERROR, *write_err;
+  apr_hash_t *targets = apr_hash_make(pool);
+  apr_hash_t *results = apr_hash_make(pool);
+  svn_error_t *err, *write_err;
 
   SVN_ERR(svn_ra_svn_parse_tuple(params, pool, "bl", &break_lock,
                                  &unlock_tokens));
@@ -2470,32 +2758,28 @@ static svn_error_t *unlock_many(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   /* Username required unless break_lock was specified. */
   SVN_ERR(must_have_access(conn, pool, b, svn_authz_write, NULL, ! break_lock));
 
-  subpool = svn_pool_create(pool);
-
-  /* Loop through the unlock requests. */
+  /* Gather the unlock requests, checking them all before unlocking any. */
+  paths = apr_array_make(pool, unlock_tokens->nelts, sizeof(path));
   log_paths = apr_array_make(pool, unlock_tokens->nelts, sizeof(full_path));
   for (i = 0; i < unlock_tokens->nelts; i++)
     {
       svn_ra_svn_item_t *item = &APR_ARRAY_IDX(unlock_tokens, i,
                                                svn_ra_svn_item_t);
 
-      svn_pool_clear(subpool);
-
       if (item->kind != SVN_RA_SVN_LIST)
         return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
                                 "Unlock request should be a list of lists");
 
-      SVN_ERR(svn_ra_svn_parse_tuple(item->u.list, subpool, "c(?c)", &path,
+      SVN_ERR(svn_ra_svn_parse_tuple(item->u.list, pool, "c(?c)", &path,
                                      &token));
 
-      /* Allocate the full_path out of pool so it will survive for use
-       * by operational logging, after this loop. */
       full_path = svn_uri_join(b->fs_path->data,
-                               svn_uri_canonicalize(path, subpool),
+                               svn_uri_canonicalize(path, pool),
                                pool);
+      APR_ARRAY_PUSH(paths, const char *) = path;
       APR_ARRAY_PUSH(log_paths, const char *) = full_path;
 
-      if (! lookup_access(subpool, b, conn, svn_authz_write, full_path,
+      if (! lookup_access(pool, b, conn, svn_authz_write, full_path,
                           ! break_lock))
         return svn_error_create(SVN_ERR_RA_SVN_CMD_ERR,
                                 error_create_and_log(SVN_ERR_RA_NOT_AUTHORIZED,
@@ -2503,35 +2787,33 @@ static svn_error_t *unlock_many(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                                      b, conn, pool),
                                 NULL);
 
-      err = svn_repos_fs_unlock(b->repos, full_path, token, break_lock,
-                                subpool);
-      if (err)
-        {
-          if (SVN_ERR_IS_UNLOCK_ERROR(err))
-            {
-              write_err = svn_ra_svn_write_cmd_failure(conn, pool, err);
-              svn_error_clear(err);
-              err = NULL;
-              SVN_ERR(write_err);
-            }
-          else
-            break;
-        }
-      else
-        SVN_ERR(svn_ra_svn_write_tuple(conn, subpool, "w(c)", "success",
-                                       path));
+      /* svn_repos__fs_unlock_many() takes an empty token for none. */
+      apr_hash_set(targets, full_path, APR_HASH_KEY_STRING,
+                   token ? token : "");
     }
 
-  svn_pool_destroy(subpool);
+  /* Unlock them all at once, running the post-unlock hook just once. */
+  err = svn_repos__fs_unlock_many(b->repos, targets, break_lock,
+                                  lock_result_callback, results, pool);
+
+  write_err = write_lock_results(conn, pool, FALSE, paths, log_paths,
+                                 results);
+  clear_lock_results(results, pool);
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
 
   SVN_ERR(log_command(b, conn, pool, "%s",
                       svn_log__unlock(log_paths, break_lock, pool)));
 
-  /* NOTE: err might contain a fatal unlocking error from the loop above. */
+  /* NOTE: err might contain a fatal unlocking error from above. */
   write_err = svn_ra_svn_write_word(conn, pool, "done");
   if (! write_err)
     SVN_CMD_ERR(err);
   svn_error_clear(err);
+  SVN_ERR(write_err);
   SVN_ERR(svn_ra_svn_write_cmd_response(conn, pool, ""));
 
   return SVN_NO_ERROR;
@@ -2716,6 +2998,79 @@ get_deleted_rev(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* This implements svn_blame_chunk_receiver_t. */
+static svn_error_t *
+blame_chunk_receiver(void *baton,
+                     svn_linenum_t start_line,
+                     svn_revnum_t revision,
+                     apr_hash_t *rev_props,
+                     apr_pool_t *pool)
+{
+  svn_ra_svn_conn_t *conn = baton;
+
+  SVN_ERR(svn_ra_svn_write_tuple(conn, pool, "n(?r)(!",
+                                 (apr_uint64_t) start_line, revision));
+  SVN_ERR(svn_ra_svn_write_proplist(conn, pool, rev_props));
+  return svn_ra_svn_write_tuple(conn, pool, "!)");
+}
+
+static svn_error_t *
+get_file_blame(svn_ra_svn_conn_t *conn,
+               apr_pool_t *pool,
+               apr_array_header_t *params,
+               void *baton)
+{
+  server_baton_t *b = baton;
+  svn_error_t *err, *write_err;
+  const char *path, *full_path;
+  svn_revnum_t start_rev, end_rev;
+  apr_array_header_t *option_items;
+  apr_array_header_t *diff_args;
+  svn_diff_file_options_t *diff_options;
+  svn_boolean_t ignore_mime_type;
+  int i;
+
+  SVN_ERR(svn_ra_svn_parse_tuple(params, pool, "crrlb", &path, &start_rev,
+                                 &end_rev, &option_items,
+                                 &ignore_mime_type));
+  path = svn_uri_canonicalize(path, pool);
+  SVN_ERR(trivial_auth_request(conn, pool, b));
+  full_path = svn_uri_join(b->fs_path->data, path, pool);
+
+  diff_args = apr_array_make(pool, option_items->nelts, sizeof(const char *));
+  for (i = 0; i < option_items->nelts; i++)
+    {
+      svn_ra_svn_item_t *item = &APR_ARRAY_IDX(option_items, i,
+                                               svn_ra_svn_item_t);
+
+      if (item->kind != SVN_RA_SVN_STRING)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Diff option not a string"));
+      APR_ARRAY_PUSH(diff_args, const char *) = item->u.string->data;
+    }
+  diff_options = svn_diff_file_options_create(pool);
+  SVN_CMD_ERR(svn_diff_file_options_parse(diff_options, diff_args, pool));
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__get_file_blame(full_path, start_rev, end_rev,
+                                              pool)));
+
+  err = svn_repos_get_file_blame(b->repos, full_path, start_rev, end_rev,
+                                 diff_options, ignore_mime_type,
+                                 authz_check_access_cb_func(b), b,
+                                 blame_chunk_receiver, conn, pool);
+  write_err = svn_ra_svn_write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+  SVN_ERR(svn_ra_svn_write_cmd_response(conn, pool, ""));
+
+  return SVN_NO_ERROR;
+}
+
 static const svn_ra_svn_cmd_entry_t main_commands[] = {
   { "reparent",        reparent },
   { "get-latest-rev",  get_latest_rev },
@@ -2726,6 +3081,8 @@ static const svn_ra_svn_cmd_entry_t main_commands[] = {
   { "commit",          commit },
   { "get-file",        get_file },
   { "get-dir",         get_dir },
+  { "list",            list },
+  { "get-archive",     get_archive },
   { "update",          update },
   { "switch",          switch_cmd },
   { "status",          status },
@@ -2746,6 +3103,7 @@ static const svn_ra_svn_cmd_entry_t main_commands[] = {
   { "replay",          replay },
   { "replay-range",    replay_range },
   { "get-deleted-rev", get_deleted_rev },
+  { "get-file-blame",  get_file_blame },
   { NULL }
 };
 
@@ -2801,11 +3159,166 @@ repos_path_valid(const char *path)
   return TRUE;
 }
 
+/* The number of repositories kept open at most in a repository cache. */
+#define MAX_CACHED_REPOS 16
+
+/* The size and modification time of a configuration file, used to tell
+   whether the file changed since it was read. */
+typedef struct config_stamp_t
+{
+  const char *path;
+  apr_time_t mtime;
+  apr_off_t size;
+} config_stamp_t;
+
+/* A repository kept open in between connections, see
+   serve_params_t.repos_cache. */
+typedef struct cached_repos_t
+{
+  svn_repos_t *repos;
+
+  /* The configuration read from the repository's conf directory,
+     allocated in CONFIG_POOL, or all NULL if not read yet. */
+  svn_config_t *cfg;
+  svn_config_t *pwdb;
+  svn_authz_t *authzdb;
+  apr_pool_t *config_pool;
+
+  /* The files CFG, PWDB and AUTHZDB were read from, when they were read.
+     Unused entries have a NULL path. */
+  config_stamp_t stamps[3];
+} cached_repos_t;
+
+/* Set STAMP to the current size and modification time of PATH, allocated
+   in POOL.  A missing file gets a zero size and time. */
+static svn_error_t *
+get_config_stamp(config_stamp_t *stamp, const char *path, apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+  svn_error_t *err;
+
+  stamp->path = apr_pstrdup(pool, path);
+  stamp->mtime = 0;
+  stamp->size = 0;
+
+  err = svn_io_stat(&finfo, path, APR_FINFO_MTIME | APR_FINFO_SIZE, pool);
+  if (err && (APR_STATUS_IS_ENOENT(err->apr_err)
+              || APR_STATUS_IS_ENOTDIR(err->apr_err)))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  stamp->mtime = finfo.mtime;
+  stamp->size = finfo.size;
+  return SVN_NO_ERROR;
+}
+
+/* Fill in the cfg, pwdb and authzdb fields of B from the configuration of
+   CACHED's repository, reading it again only if one of its files changed
+   since the last time.  CONN is used for logging errors, POOL for
+   temporary allocations. */
+static svn_error_t *
+load_cached_configs(cached_repos_t *cached,
+                    server_baton_t *b,
+                    svn_ra_svn_conn_t *conn,
+                    apr_pool_t *pool)
+{
+  config_stamp_t stamps[3];
+  const char *conf_dir;
+  const char *path;
+  apr_pool_t *config_pool;
+  svn_error_t *err;
+  int i;
+
+  if (cached->cfg)
+    {
+      svn_boolean_t changed = FALSE;
+
+      for (i = 0; i < 3 && !changed && cached->stamps[i].path; i++)
+        {
+          config_stamp_t stamp;
+
+          SVN_ERR(get_config_stamp(&stamp, cached->stamps[i].path, pool));
+          changed = (stamp.mtime != cached->stamps[i].mtime
+                     || stamp.size != cached->stamps[i].size);
+        }
+
+      if (!changed)
+        {
+          b->cfg = cached->cfg;
+          b->pwdb = cached->pwdb;
+          b->authzdb = cached->authzdb;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Stat the files before reading them, so that changes made while we
+     read them are noticed next time. */
+  config_pool = svn_pool_create(apr_hash_pool_get(b->repos_cache));
+  path = svn_repos_svnserve_conf(cached->repos, pool);
+  conf_dir = svn_repos_conf_dir(cached->repos, pool);
+  memset(stamps, 0, sizeof(stamps));
+  i = 0;
+  err = get_config_stamp(&stamps[i++], path, config_pool);
+
+  if (!err)
+    err = load_configs(&b->cfg, &b->pwdb, &b->authzdb, path, FALSE,
+                       conf_dir, b, conn, config_pool);
+
+  /* The password and authz files are only known now. */
+  if (!err)
+    {
+      svn_config_get(b->cfg, &path, SVN_CONFIG_SECTION_GENERAL,
+                     SVN_CONFIG_OPTION_PASSWORD_DB, NULL);
+      if (path)
+        err = get_config_stamp(&stamps[i++],
+                               svn_dirent_join(conf_dir, path, pool),
+                               config_pool);
+    }
+  if (!err)
+    {
+      svn_config_get(b->cfg, &path, SVN_CONFIG_SECTION_GENERAL,
+                     SVN_CONFIG_OPTION_AUTHZ_DB, NULL);
+      if (path)
+        err = get_config_stamp(&stamps[i++],
+                               svn_dirent_join(conf_dir, path, pool),
+                               config_pool);
+    }
+
+  if (err)
+    {
+      svn_pool_destroy(config_pool);
+      b->cfg = NULL;
+      b->pwdb = NULL;
+      b->authzdb = NULL;
+      return err;
+    }
+
+  /* These are shared by all later connections to the repository. */
+  svn_config__set_read_only(b->cfg, pool);
+  if (b->pwdb)
+    svn_config__set_read_only(b->pwdb, pool);
+
+  memcpy(cached->stamps, stamps, sizeof(stamps));
+  if (cached->config_pool)
+    svn_pool_destroy(cached->config_pool);
+  cached->config_pool = config_pool;
+  cached->cfg = b->cfg;
+  cached->pwdb = b->pwdb;
+  cached->authzdb = b->authzdb;
+
+  return SVN_NO_ERROR;
+}
+
 /* Look for the repository given by URL, using ROOT as the virtual
  * repository root.  If we find one, fill in the repos, fs, cfg,
  * repos_url, and fs_path fields of B.  Set B->repos's client
  * capabilities to CAPABILITIES, which must be at least as long-lived
- * as POOL, and whose elements are SVN_RA_CAPABILITY_*.
+ * as POOL, and whose elements are SVN_RA_CAPABILITY_*.  Take the
+ * repository and its configuration from B->repos_cache, if it is not
+ * NULL, or add them there.
  */
 static svn_error_t *find_repos(const char *url, const char *root,
                                server_baton_t *b,
@@ -2815,6 +3328,7 @@ static svn_error_t *find_repos(const char *url, const char *root,
 {
   const char *path, *full_path, *repos_root, *fs_path;
   svn_stringbuf_t *url_buf;
+  cached_repos_t *cached = NULL;
 
   /* Skip past the scheme and authority part. */
   path = skip_scheme_part(url);
@@ -2846,7 +3360,27 @@ static svn_error_t *find_repos(const char *url, const char *root,
                              "No repository found in '%s'", url);
 
   /* Open the repository and fill in b with the resulting information. */
-  SVN_ERR(svn_repos_open(&b->repos, repos_root, pool));
+  if (b->repos_cache)
+    {
+      cached = apr_hash_get(b->repos_cache, repos_root, APR_HASH_KEY_STRING);
+      if (! cached && apr_hash_count(b->repos_cache) < MAX_CACHED_REPOS)
+        {
+          apr_pool_t *repos_pool = apr_hash_pool_get(b->repos_cache);
+
+          cached = apr_pcalloc(repos_pool, sizeof(*cached));
+          SVN_ERR(svn_repos_open2(&cached->repos, repos_root, NULL,
+                                  repos_pool));
+          apr_hash_set(b->repos_cache, apr_pstrdup(repos_pool, repos_root),
+                       APR_HASH_KEY_STRING, cached);
+        }
+    }
+
+  /* Sessions may still use the cached repositories, so once the cache
+     is full, further ones are only opened for this connection. */
+  if (cached)
+    b->repos = cached->repos;
+  else
+    SVN_ERR(svn_repos_open2(&b->repos, repos_root, NULL, pool));
   SVN_ERR(svn_repos_remember_client_capabilities(b->repos, capabilities));
   b->fs = svn_repos_fs(b->repos);
   fs_path = full_path + strlen(repos_root);
@@ -2864,7 +3398,9 @@ static svn_error_t *find_repos(const char *url, const char *root,
 
   /* If the svnserve configuration files have not been loaded then
      load them from the repository. */
-  if (NULL == b->cfg)
+  if (NULL == b->cfg && cached)
+    SVN_ERR(load_cached_configs(cached, b, conn, pool));
+  else if (NULL == b->cfg)
     SVN_ERR(load_configs(&b->cfg, &b->pwdb, &b->authzdb,
                          svn_repos_svnserve_conf(b->repos, pool), FALSE,
                          svn_repos_conf_dir(b->repos, pool),
@@ -2919,32 +3455,116 @@ fs_warning_func(void *baton, svn_error_t *err)
   svn_pool_clear(b->pool);
 }
 
-svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
-                   apr_pool_t *pool)
+/* Warning function for filesystems kept open in between connections.
+   BATON is the log file, possibly NULL. */
+static void
+idle_fs_warning_func(void *baton, svn_error_t *err)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  log_error(err, baton, NULL, NULL, NULL, pool);
+  svn_pool_destroy(pool);
+}
+
+/* Context for reset_fs_warning_func(). */
+struct reset_fs_warning_baton
+{
+  svn_fs_t *fs;
+  apr_file_t *log_file;
+};
+
+/* Pool cleanup handler.  Make sure a filesystem that outlives the
+   connection doesn't keep pointing to the connection's warning baton. */
+static apr_status_t reset_fs_warning_func(void *data)
+{
+  struct reset_fs_warning_baton *baton = data;
+
+  svn_fs_set_warning_func(baton->fs, idle_fs_warning_func, baton->log_file);
+  return APR_SUCCESS;
+}
+
+/* Log the usage statistics of the caches used during the session B
+   as well as those of the process-wide membuffer, if logging has been
+   enabled.  Use POOL for allocations. */
+static svn_error_t *
+log_cache_stats(server_baton_t *b,
+                svn_ra_svn_conn_t *conn,
+                apr_pool_t *pool)
+{
+  apr_hash_t *cache_info;
+  apr_hash_index_t *hi;
+  svn_membuffer_t *membuffer;
+
+  if (b->log_file == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs__get_cache_info(&cache_info, b->fs, FALSE, pool));
+  for (hi = apr_hash_first(pool, cache_info); hi; hi = apr_hash_next(hi))
+    SVN_ERR(log_command(b, conn, pool, "cache %s",
+                        svn_cache__format_info(svn__apr_hash_index_key(hi),
+                                               svn__apr_hash_index_val(hi),
+                                               pool)->data));
+
+  membuffer = svn_cache__get_global_membuffer_cache();
+  if (membuffer)
+    {
+      svn_cache__info_t info;
+
+      SVN_ERR(svn_cache__membuffer_get_info(membuffer, &info, FALSE, pool));
+      SVN_ERR(log_command(b, conn, pool, "cache %s",
+                          svn_cache__format_info("membuffer", &info,
+                                                 pool)->data));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* The state of a connection past the initial handshake. */
+struct serve_session_t
+{
+  server_baton_t b;
+  fs_warning_baton_t warn_baton;
+  svn_ra_svn_conn_t *conn;
+
+  /* main_commands, keyed by command name. */
+  apr_hash_t *cmd_hash;
+
+  /* Where to count this session and its commands; possibly NULL. */
+  server_stats_t *stats;
+};
+
+svn_error_t *serve_session_open(serve_session_t **session,
+                                svn_ra_svn_conn_t *conn,
+                                serve_params_t *params,
+                                apr_pool_t *pool)
 {
   svn_error_t *err, *io_err;
   apr_uint64_t ver;
   const char *uuid, *client_url, *ra_client_string, *client_string;
   apr_array_header_t *caplist, *cap_words;
-  server_baton_t b;
-  fs_warning_baton_t warn_baton;
+  serve_session_t *s = apr_pcalloc(pool, sizeof(*s));
+  server_baton_t *b = &s->b;
   svn_stringbuf_t *cap_log = svn_stringbuf_create("", pool);
-
-  b.tunnel = params->tunnel;
-  b.tunnel_user = get_tunnel_user(params, pool);
-  b.read_only = params->read_only;
-  b.user = NULL;
-  b.cfg = params->cfg;
-  b.pwdb = params->pwdb;
-  b.authzdb = params->authzdb;
-  b.realm = NULL;
-  b.log_file = params->log_file;
-  b.pool = pool;
-  b.use_sasl = FALSE;
+  const svn_ra_svn_cmd_entry_t *command;
+
+  *session = NULL;
+
+  b->tunnel = params->tunnel;
+  b->tunnel_user = get_tunnel_user(params, pool);
+  b->read_only = params->read_only;
+  b->user = NULL;
+  b->cfg = params->cfg;
+  b->pwdb = params->pwdb;
+  b->authzdb = params->authzdb;
+  b->realm = NULL;
+  b->log_file = params->log_file;
+  b->repos_cache = params->repos_cache;
+  b->pool = pool;
+  b->use_sasl = FALSE;
 
   /* Send greeting.  We don't support version 1 any more, so we can
    * send an empty mechlist. */
-  SVN_ERR(svn_ra_svn_write_cmd_response(conn, pool, "nn()(wwwwwww)",
+  SVN_ERR(svn_ra_svn_write_cmd_response(conn, pool, "nn()(wwwwwwwwwwwww)",
                                         (apr_uint64_t) 2, (apr_uint64_t) 2,
                                         SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                         SVN_RA_SVN_CAP_SVNDIFF1,
@@ -2952,7 +3572,13 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
                                         SVN_RA_SVN_CAP_COMMIT_REVPROPS,
                                         SVN_RA_SVN_CAP_DEPTH,
                                         SVN_RA_SVN_CAP_LOG_REVPROPS,
-                                        SVN_RA_SVN_CAP_PARTIAL_REPLAY));
+                                        SVN_RA_SVN_CAP_PARTIAL_REPLAY,
+                                        SVN_RA_SVN_CAP_LARGE_DELTA_WINDOWS,
+                                        SVN_RA_SVN_CAP_FILE_BLAME,
+                                        SVN_RA_SVN_CAP_PIPELINED_READS,
+                                        SVN_RA_SVN_CAP_COMPRESSED_STREAM,
+                                        SVN_RA_SVN_CAP_LIST,
+                                        SVN_RA_SVN_CAP_ARCHIVE));
 
   /* Read client response, which we assume to be in version 2 format:
    * version, capability list, and client URL; then we do an auth
@@ -2972,6 +3598,11 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
   if (! svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_EDIT_PIPELINE))
     return SVN_NO_ERROR;
 
+  /* The client switched to compression right after sending its
+     response, if it asked for it. */
+  if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_COMPRESSED_STREAM))
+    SVN_ERR(svn_ra_svn__enable_compression(conn, pool));
+
   /* find_repos needs the capabilities as a list of words (eventually
      they get handed to the start-commit hook).  While we could add a
      new interface to re-retrieve them from conn and convert the
@@ -3002,19 +3633,19 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
       }
   }
 
-  err = find_repos(client_url, params->root, &b, conn, cap_words, pool);
+  err = find_repos(client_url, params->root, b, conn, cap_words, pool);
   if (!err)
     {
-      SVN_ERR(auth_request(conn, pool, &b, READ_ACCESS, FALSE));
-      if (current_access(&b) == NO_ACCESS)
+      SVN_ERR(auth_request(conn, pool, b, READ_ACCESS, FALSE));
+      if (current_access(b) == NO_ACCESS)
         err = error_create_and_log(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
                                    "Not authorized for access",
-                                   &b, conn, pool);
+                                   b, conn, pool);
     }
   if (err)
     {
-      log_error(err, b.log_file, svn_ra_svn_conn_remote_host(conn),
-                b.user, NULL, pool);
+      log_error(err, b->log_file, svn_ra_svn_conn_remote_host(conn),
+                b->user, NULL, pool);
       io_err = svn_ra_svn_write_cmd_failure(conn, pool, err);
       svn_error_clear(err);
       SVN_ERR(io_err);
@@ -3030,18 +3661,29 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
     client_string = "-";
   else
     client_string = svn_path_uri_encode(client_string, pool);
-  SVN_ERR(log_command(&b, conn, pool,
+  SVN_ERR(log_command(b, conn, pool,
                       "open %" APR_UINT64_T_FMT " cap=(%s) %s %s %s",
                       ver, cap_log->data,
-                      svn_path_uri_encode(b.fs_path->data, pool),
+                      svn_path_uri_encode(b->fs_path->data, pool),
                       ra_client_string, client_string));
 
-  warn_baton.server = &b;
-  warn_baton.conn = conn;
-  warn_baton.pool = svn_pool_create(pool);
-  svn_fs_set_warning_func(b.fs, fs_warning_func, &warn_baton);
+  s->conn = conn;
+  s->warn_baton.server = b;
+  s->warn_baton.conn = conn;
+  s->warn_baton.pool = svn_pool_create(pool);
+  svn_fs_set_warning_func(b->fs, fs_warning_func, &s->warn_baton);
+  if (params->repos_cache)
+    {
+      struct reset_fs_warning_baton *reset_baton;
+
+      reset_baton = apr_palloc(pool, sizeof(*reset_baton));
+      reset_baton->fs = b->fs;
+      reset_baton->log_file = b->log_file;
+      apr_pool_cleanup_register(pool, reset_baton, reset_fs_warning_func,
+                                apr_pool_cleanup_null);
+    }
 
-  SVN_ERR(svn_fs_get_uuid(b.fs, &uuid, pool));
+  SVN_ERR(svn_fs_get_uuid(b->fs, &uuid, pool));
 
   /* We can't claim mergeinfo capability until we know whether the
      repository supports mergeinfo (i.e., is not a 1.4 repository),
@@ -3051,15 +3693,102 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
      the client has sent the url. */
   {
     svn_boolean_t supports_mergeinfo;
-    SVN_ERR(svn_repos_has_capability(b.repos, &supports_mergeinfo,
+    SVN_ERR(svn_repos_has_capability(b->repos, &supports_mergeinfo,
                                      SVN_REPOS_CAPABILITY_MERGEINFO, pool));
 
     SVN_ERR(svn_ra_svn_write_tuple(conn, pool, "w(cc(!",
-                                   "success", uuid, b.repos_url));
+                                   "success", uuid, b->repos_url));
     if (supports_mergeinfo)
       SVN_ERR(svn_ra_svn_write_word(conn, pool, SVN_RA_SVN_CAP_MERGEINFO));
     SVN_ERR(svn_ra_svn_write_tuple(conn, pool, "!))"));
   }
 
-  return svn_ra_svn_handle_commands2(conn, pool, main_commands, &b, FALSE);
+  s->cmd_hash = apr_hash_make(pool);
+  for (command = main_commands; command->cmdname; command++)
+    apr_hash_set(s->cmd_hash, command->cmdname, APR_HASH_KEY_STRING,
+                 command);
+
+  s->stats = params->stats;
+  if (s->stats)
+    server_stats_session_start(s->stats);
+
+  *session = s;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *serve_session_command(svn_boolean_t *terminate,
+                                   serve_session_t *session,
+                                   apr_pool_t *pool)
+{
+  const char *cmdname;
+  apr_array_header_t *params;
+  apr_time_t start;
+
+  if (! session->stats)
+    return svn_ra_svn__handle_command(terminate, session->cmd_hash,
+                                      &session->b, session->conn, FALSE,
+                                      pool);
+
+  /* Time the command from when it has arrived, not including the time
+     the client took to send it. */
+  SVN_ERR(svn_ra_svn__read_command(&cmdname, &params, session->conn, FALSE,
+                                   pool));
+  if (! cmdname)
+    {
+      *terminate = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  start = apr_time_now();
+  SVN_ERR(svn_ra_svn__run_command(terminate, session->cmd_hash,
+                                  &session->b, session->conn,
+                                  cmdname, params, pool));
+
+  /* Don't let clients fill the statistics with made-up commands. */
+  if (apr_hash_get(session->cmd_hash, cmdname, APR_HASH_KEY_STRING))
+    server_stats_command(session->stats, session->b.repos_name, cmdname,
+                         apr_time_now() - start, pool);
+  return SVN_NO_ERROR;
+}
+
+void serve_session_close(serve_session_t *session, apr_pool_t *pool)
+{
+  /* Caching is transparent to the client; don't let failures to report
+     on it mask the session's status. */
+  svn_error_clear(log_cache_stats(&session->b, session->conn, pool));
+
+  if (session->stats)
+    {
+      apr_uint64_t bytes_in, bytes_out;
+
+      svn_ra_svn__get_io_counts(&bytes_in, &bytes_out, session->conn);
+      server_stats_session_end(session->stats, session->b.repos_name,
+                               bytes_in, bytes_out, pool);
+    }
+}
+
+svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
+                   apr_pool_t *pool)
+{
+  serve_session_t *session;
+  apr_pool_t *iterpool;
+  svn_boolean_t done = FALSE;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(serve_session_open(&session, conn, params, pool));
+  if (! session)
+    return SVN_NO_ERROR;
+
+  iterpool = svn_pool_create(pool);
+  while (! done)
+    {
+      svn_pool_clear(iterpool);
+      err = serve_session_command(&done, session, iterpool);
+      if (err)
+        break;
+    }
+  svn_pool_destroy(iterpool);
+  serve_session_close(session, pool);
+
+  return err;
 }
@@ -54,9 +54,13 @@ typedef struct server_baton_t {
   svn_boolean_t use_sasl;  /* Use Cyrus SASL for authentication;
                               always false if SVN_HAVE_SASL not defined */
   apr_file_t *log_file;    /* Log filehandle. */
+  apr_hash_t *repos_cache; /* Repositories kept open; possibly NULL. */
   apr_pool_t *pool;
 } server_baton_t;
 
+/* Counters shared by all connections of a server, see --stats-file. */
+typedef struct server_stats_t server_stats_t;
+
 enum authn_type { UNAUTHENTICATED, AUTHENTICATED };
 enum access_type { NO_ACCESS, READ_ACCESS, WRITE_ACCESS };
 
@@ -101,12 +105,78 @@ typedef struct serve_params_t {
 
   /* A filehandle open for writing logs to; possibly NULL. */
   apr_file_t *log_file;
+
+  /* Repositories opened for earlier connections served by the same
+     thread, together with their parsed configuration, keyed by their
+     root path and allocated in the hash's pool, or NULL to open the
+     repository and read its configuration anew for each connection. */
+  apr_hash_t *repos_cache;
+
+  /* Where to count sessions and commands, shared by all threads; possibly
+     NULL. */
+  server_stats_t *stats;
 } serve_params_t;
 
 /* Serve the connection CONN according to the parameters PARAMS. */
 svn_error_t *serve(svn_ra_svn_conn_t *conn, serve_params_t *params,
                    apr_pool_t *pool);
 
+/* A connection past its initial handshake, whose commands can be served
+   one at a time. */
+typedef struct serve_session_t serve_session_t;
+
+/* Greet the client on CONN, find the repository it asks for and
+   authenticate it according to PARAMS, like serve() does before handling
+   commands.  Set *SESSION to the resulting session, allocated in POOL,
+   or to NULL if the connection is done already.  POOL must live as long
+   as the connection. */
+svn_error_t *serve_session_open(serve_session_t **session,
+                                svn_ra_svn_conn_t *conn,
+                                serve_params_t *params,
+                                apr_pool_t *pool);
+
+/* Read one command from SESSION's connection and handle it.  Set
+   *TERMINATE to TRUE if the session is over.  Use POOL for the command's
+   allocations. */
+svn_error_t *serve_session_command(svn_boolean_t *terminate,
+                                   serve_session_t *session,
+                                   apr_pool_t *pool);
+
+/* Log the end of SESSION, using POOL for temporary allocations. */
+void serve_session_close(serve_session_t *session, apr_pool_t *pool);
+
+/* Set *STATS to a new, empty set of counters, allocated in POOL, that
+   will be written to the file at PATH. */
+svn_error_t *server_stats_create(server_stats_t **stats,
+                                 const char *path,
+                                 apr_pool_t *pool);
+
+/* Count the start of a session in STATS. */
+void server_stats_session_start(server_stats_t *stats);
+
+/* Count the command CMDNAME, which took ELAPSED to handle, for the
+   repository REPOS_NAME in STATS.  Use POOL for temporary allocations. */
+void server_stats_command(server_stats_t *stats,
+                          const char *repos_name,
+                          const char *cmdname,
+                          apr_interval_time_t elapsed,
+                          apr_pool_t *pool);
+
+/* Count the end of a session with the repository REPOS_NAME in STATS,
+   which received BYTES_IN and sent BYTES_OUT.  Use POOL for temporary
+   allocations. */
+void server_stats_session_end(server_stats_t *stats,
+                              const char *repos_name,
+                              apr_uint64_t bytes_in,
+                              apr_uint64_t bytes_out,
+                              apr_pool_t *pool);
+
+/* Write STATS to its file, unless that was done recently and FORCE is
+   FALSE.  Use POOL for temporary allocations. */
+svn_error_t *server_stats_write(server_stats_t *stats,
+                                svn_boolean_t force,
+                                apr_pool_t *pool);
+
 /* Load a svnserve configuration file located at FILENAME into CFG,
    any referenced password database into PWDB and any referenced
    authorization database into AUTHZDB.  If MUST_EXIST is true and
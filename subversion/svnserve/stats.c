@@ -0,0 +1,364 @@
+/*
+ * stats.c :  Server-wide counters for svnserve, see --stats-file
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <apr_general.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
+#include <apr_time.h>
+#if APR_HAS_THREADS
+#include <apr_thread_mutex.h>
+#endif
+
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+#include "svn_sorts.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_time.h"
+#include "svn_private_config.h"
+
+#include "private/svn_cache.h"
+
+#include "server.h"
+
+/* How often the statistics file gets rewritten, at most. */
+#define STATS_INTERVAL apr_time_from_sec(10)
+
+/* The upper bounds, in microseconds, of the latency buckets commands are
+   counted in.  Slower commands land in an extra last bucket. */
+static const apr_interval_time_t latency_bounds[] =
+  { 1000, 10000, 100000, 1000000, 10000000 };
+#define NUM_BOUNDS (sizeof(latency_bounds) / sizeof(latency_bounds[0]))
+
+/* What we know about one command, or about all commands for one
+   repository. */
+typedef struct command_stats_t {
+  apr_uint64_t count;
+  apr_interval_time_t total_time;
+  apr_interval_time_t max_time;
+  apr_uint64_t latency[NUM_BOUNDS + 1];
+} command_stats_t;
+
+/* What we know about one repository. */
+typedef struct repos_stats_t {
+  apr_uint64_t sessions;
+  apr_uint64_t bytes_in;
+  apr_uint64_t bytes_out;
+  command_stats_t commands;
+} repos_stats_t;
+
+struct server_stats_t {
+  /* The file the statistics are written to. */
+  const char *path;
+
+  apr_time_t started;
+
+  apr_uint64_t sessions;
+  int active_sessions;
+  apr_uint64_t bytes_in;
+  apr_uint64_t bytes_out;
+
+  /* command_stats_t by command name, and repos_stats_t by repository
+     name, allocated in POOL. */
+  apr_hash_t *commands;
+  apr_hash_t *repositories;
+
+  /* When the file was last written, how many sessions had been started
+     back then, and when it's due to be written again. */
+  apr_time_t last_write;
+  apr_uint64_t last_sessions;
+  apr_time_t next_write;
+
+  /* Serializes all access to the above. */
+#if APR_HAS_THREADS
+  apr_thread_mutex_t *mutex;
+#endif
+
+  apr_pool_t *pool;
+};
+
+static void
+lock_stats(server_stats_t *stats)
+{
+#if APR_HAS_THREADS
+  apr_thread_mutex_lock(stats->mutex);
+#endif
+}
+
+static void
+unlock_stats(server_stats_t *stats)
+{
+#if APR_HAS_THREADS
+  apr_thread_mutex_unlock(stats->mutex);
+#endif
+}
+
+svn_error_t *
+server_stats_create(server_stats_t **stats,
+                    const char *path,
+                    apr_pool_t *pool)
+{
+  server_stats_t *s = apr_pcalloc(pool, sizeof(*s));
+
+#if APR_HAS_THREADS
+  apr_status_t status = apr_thread_mutex_create(&s->mutex,
+                                                APR_THREAD_MUTEX_DEFAULT,
+                                                pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create mutex"));
+#endif
+
+  s->path = path;
+  s->started = apr_time_now();
+  s->last_write = s->started;
+  s->next_write = s->started;
+  /* The hashes grow in whichever thread sees a new command or repository
+     first, so they get a pool of their own. */
+  s->pool = svn_pool_create(NULL);
+  s->commands = apr_hash_make(s->pool);
+  s->repositories = apr_hash_make(s->pool);
+
+  *stats = s;
+  return SVN_NO_ERROR;
+}
+
+/* Return the entry for KEY in HASH of STATS, creating an empty one
+   of SIZE bytes if there is none.  STATS must be locked. */
+static void *
+get_entry(server_stats_t *stats, apr_hash_t *hash, const char *key,
+          apr_size_t size)
+{
+  void *entry = apr_hash_get(hash, key, APR_HASH_KEY_STRING);
+
+  if (! entry)
+    {
+      entry = apr_pcalloc(stats->pool, size);
+      apr_hash_set(hash, apr_pstrdup(stats->pool, key),
+                   APR_HASH_KEY_STRING, entry);
+    }
+  return entry;
+}
+
+/* Count a command that took ELAPSED in CMD. */
+static void
+add_command(command_stats_t *cmd, apr_interval_time_t elapsed)
+{
+  apr_size_t i;
+
+  for (i = 0; i < NUM_BOUNDS; i++)
+    if (elapsed < latency_bounds[i])
+      break;
+
+  cmd->count++;
+  cmd->total_time += elapsed;
+  if (elapsed > cmd->max_time)
+    cmd->max_time = elapsed;
+  cmd->latency[i]++;
+}
+
+void
+server_stats_session_start(server_stats_t *stats)
+{
+  lock_stats(stats);
+  stats->sessions++;
+  stats->active_sessions++;
+  unlock_stats(stats);
+}
+
+void
+server_stats_command(server_stats_t *stats,
+                     const char *repos_name,
+                     const char *cmdname,
+                     apr_interval_time_t elapsed,
+                     apr_pool_t *pool)
+{
+  lock_stats(stats);
+  add_command(get_entry(stats, stats->commands, cmdname,
+                        sizeof(command_stats_t)),
+              elapsed);
+  if (repos_name)
+    {
+      repos_stats_t *repos = get_entry(stats, stats->repositories,
+                                       repos_name, sizeof(repos_stats_t));
+      add_command(&repos->commands, elapsed);
+    }
+  unlock_stats(stats);
+
+  svn_error_clear(server_stats_write(stats, FALSE, pool));
+}
+
+void
+server_stats_session_end(server_stats_t *stats,
+                         const char *repos_name,
+                         apr_uint64_t bytes_in,
+                         apr_uint64_t bytes_out,
+                         apr_pool_t *pool)
+{
+  lock_stats(stats);
+  stats->active_sessions--;
+  stats->bytes_in += bytes_in;
+  stats->bytes_out += bytes_out;
+  if (repos_name)
+    {
+      repos_stats_t *repos = get_entry(stats, stats->repositories,
+                                       repos_name, sizeof(repos_stats_t));
+      repos->sessions++;
+      repos->bytes_in += bytes_in;
+      repos->bytes_out += bytes_out;
+    }
+  unlock_stats(stats);
+
+  svn_error_clear(server_stats_write(stats, FALSE, pool));
+}
+
+/* Append the counters in CMD to BUF, allocating in POOL. */
+static void
+format_command(svn_stringbuf_t *buf,
+               const command_stats_t *cmd,
+               apr_pool_t *pool)
+{
+  apr_size_t i;
+
+  svn_stringbuf_appendcstr(buf,
+    apr_psprintf(pool, " count %" APR_UINT64_T_FMT
+                 " total-ms %" APR_INT64_T_FMT
+                 " max-ms %" APR_INT64_T_FMT,
+                 cmd->count,
+                 (apr_int64_t) cmd->total_time / 1000,
+                 (apr_int64_t) cmd->max_time / 1000));
+
+  for (i = 0; i < NUM_BOUNDS; i++)
+    svn_stringbuf_appendcstr(buf,
+      apr_psprintf(pool, " le-%" APR_INT64_T_FMT "ms %" APR_UINT64_T_FMT,
+                   (apr_int64_t) latency_bounds[i] / 1000,
+                   cmd->latency[i]));
+  svn_stringbuf_appendcstr(buf,
+    apr_psprintf(pool, " more %" APR_UINT64_T_FMT "\n",
+                 cmd->latency[NUM_BOUNDS]));
+}
+
+/* Return the current content of the statistics file for STATS, which
+   must be locked, allocated in POOL. */
+static svn_stringbuf_t *
+format_stats(server_stats_t *stats, apr_time_t now, apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create("", pool);
+  apr_array_header_t *sorted;
+  apr_interval_time_t interval = now - stats->last_write;
+  int i;
+
+  svn_stringbuf_appendcstr(buf,
+    apr_psprintf(pool,
+                 "updated %s\n"
+                 "uptime %" APR_INT64_T_FMT "\n"
+                 "sessions %" APR_UINT64_T_FMT "\n"
+                 "active-sessions %d\n"
+                 "sessions-per-second %.2f\n"
+                 "bytes-in %" APR_UINT64_T_FMT "\n"
+                 "bytes-out %" APR_UINT64_T_FMT "\n",
+                 svn_time_to_cstring(now, pool),
+                 (apr_int64_t) apr_time_sec(now - stats->started),
+                 stats->sessions,
+                 stats->active_sessions,
+                 interval > 0
+                   ? (double) (stats->sessions - stats->last_sessions)
+                       * APR_USEC_PER_SEC / interval
+                   : 0.0,
+                 stats->bytes_in,
+                 stats->bytes_out));
+
+  sorted = svn_sort__hash(stats->commands, svn_sort_compare_items_lexically,
+                          pool);
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+
+      svn_stringbuf_appendcstr(buf, apr_psprintf(pool, "command %s",
+                                                 (const char *) item->key));
+      format_command(buf, item->value, pool);
+    }
+
+  sorted = svn_sort__hash(stats->repositories,
+                          svn_sort_compare_items_lexically, pool);
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      repos_stats_t *repos = item->value;
+
+      svn_stringbuf_appendcstr(buf,
+        apr_psprintf(pool, "repository %s sessions %" APR_UINT64_T_FMT
+                     " bytes-in %" APR_UINT64_T_FMT
+                     " bytes-out %" APR_UINT64_T_FMT,
+                     (const char *) item->key, repos->sessions,
+                     repos->bytes_in, repos->bytes_out));
+      format_command(buf, &repos->commands, pool);
+    }
+
+  return buf;
+}
+
+svn_error_t *
+server_stats_write(server_stats_t *stats,
+                   svn_boolean_t force,
+                   apr_pool_t *pool)
+{
+  apr_time_t now = apr_time_now();
+  svn_stringbuf_t *buf;
+  svn_membuffer_t *membuffer;
+  const char *tmp_path;
+
+  lock_stats(stats);
+  if (! force && now < stats->next_write)
+    {
+      unlock_stats(stats);
+      return SVN_NO_ERROR;
+    }
+  buf = format_stats(stats, now, pool);
+  stats->last_write = now;
+  stats->last_sessions = stats->sessions;
+  stats->next_write = now + STATS_INTERVAL;
+  unlock_stats(stats);
+
+  membuffer = svn_cache__get_global_membuffer_cache();
+  if (membuffer)
+    {
+      svn_cache__info_t info;
+
+      SVN_ERR(svn_cache__membuffer_get_info(membuffer, &info, FALSE, pool));
+      svn_stringbuf_appendcstr(buf, "cache ");
+      svn_stringbuf_appendcstr(buf, svn_cache__format_info("membuffer", &info,
+                                                           pool)->data);
+      svn_stringbuf_appendbytes(buf, "\n", 1);
+    }
+
+  /* Replace the file at once, so that readers never see half of it. */
+  SVN_ERR(svn_io_write_unique(&tmp_path, svn_dirent_dirname(stats->path,
+                                                            pool),
+                              buf->data, buf->len, svn_io_file_del_none,
+                              pool));
+  return svn_io_file_rename(tmp_path, stats->path, pool);
+}
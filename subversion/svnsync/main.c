@@ -29,6 +29,8 @@
 #include "svn_auth.h"
 #include "svn_opt.h"
 #include "svn_ra.h"
+#include "svn_repos.h"
+#include "svn_fs.h"
 #include "svn_utf.h"
 #include "svn_subst.h"
 #include "svn_string.h"
@@ -37,12 +39,18 @@
 #include "private/svn_cmdline_private.h"
 
 #include "sync.h"
+#include "spool.h"
 
 #include "svn_private_config.h"
 
 #include <apr_network_io.h>
 #include <apr_signal.h>
 #include <apr_uuid.h>
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
 
 static svn_opt_subcommand_t initialize_cmd,
                             synchronize_cmd,
@@ -65,6 +73,7 @@ enum svnsync__opt {
   svnsync_opt_version,
   svnsync_opt_trust_server_cert,
   svnsync_opt_allow_non_empty,
+  svnsync_opt_direct_fs,
 };
 
 #define SVNSYNC_OPTS_DEFAULT svnsync_opt_non_interactive, \
@@ -116,8 +125,15 @@ static const svn_opt_subcommand_desc2_t svnsync_cmd_table[] =
          "ignoring what is recorded in the destination repository as the\n"
          "source URL.  Specifying SOURCE_URL is recommended in particular\n"
          "if untrusted users/administrators may have write access to the\n"
-         "DEST_URL repository.\n"),
-      { SVNSYNC_OPTS_DEFAULT, 'q', svnsync_opt_disable_locking } },
+         "DEST_URL repository.\n"
+         "\n"
+         "If DEST_URL is a file:// URL, --direct-fs writes the revisions\n"
+         "straight into the destination repository's filesystem instead of\n"
+         "committing them through the repository access layer.  This is\n"
+         "much faster when seeding a large mirror, but the destination\n"
+         "repository's hooks are not run.\n"),
+      { SVNSYNC_OPTS_DEFAULT, 'q', svnsync_opt_disable_locking,
+        svnsync_opt_direct_fs } },
     { "copy-revprops", copy_revprops_cmd, { 0 },
       N_("usage:\n"
          "\n"
@@ -206,6 +222,12 @@ static const apr_getopt_option_t svnsync_options[] =
                           "corrupt the mirror unless you ensure that no other\n"
                           "                             "
                           "instance of svnsync is running concurrently.")},
+    {"direct-fs",      svnsync_opt_direct_fs, 0,
+                       N_("write revisions straight into the filesystem of\n"
+                          "                             "
+                          "a local (file://) destination repository, without\n"
+                          "                             "
+                          "running its hooks")},
     {"version",        svnsync_opt_version, 0,
                        N_("show program version information")},
     {"help",           'h', 0,
@@ -230,6 +252,7 @@ typedef struct {
   svn_boolean_t disable_locking;
   svn_boolean_t quiet;
   svn_boolean_t allow_non_empty;
+  svn_boolean_t direct_fs;
   svn_boolean_t version;
   svn_boolean_t help;
   svn_opt_revision_t start_rev;
@@ -358,6 +381,7 @@ typedef struct {
 
   /* synchronize only */
   svn_revnum_t committed_rev;
+  svn_boolean_t direct_fs;
 
   /* copy-revprops only */
   svn_revnum_t start_rev;
@@ -675,6 +699,7 @@ make_subcommand_baton(opt_baton_t *opt_baton,
   b->sync_callbacks.auth_baton = opt_baton->sync_auth_baton;
   b->quiet = opt_baton->quiet;
   b->allow_non_empty = opt_baton->allow_non_empty;
+  b->direct_fs = opt_baton->direct_fs;
   b->to_url = to_url;
   b->from_url = from_url;
   b->start_rev = start_rev;
@@ -914,6 +939,10 @@ typedef struct {
   svn_boolean_t has_commit_revprops_capability;
   int normalized_rev_props_count;
   int normalized_node_props_count;
+
+  /* The destination repository, if revisions are committed straight
+     into its filesystem rather than through TO_SESSION; else NULL. */
+  svn_repos_t *to_repos;
 } replay_baton_t;
 
 /* Return a replay baton allocated from POOL and populated with
@@ -958,6 +987,17 @@ filter_include_date_author_sync(const char *key)
   return ! filter_exclude_date_author_sync(key);
 }
 
+/* Return TRUE iff KEY is the name of an svnsync property.
+ * Implements filter_func_t. Use with filter_props() to filter out
+ * svnsync properties only.
+ */
+static svn_boolean_t
+filter_exclude_sync(const char *key)
+{
+  return (strncmp(key, SVNSYNC_PROP_PREFIX,
+                  sizeof(SVNSYNC_PROP_PREFIX) - 1) == 0);
+}
+
 
 /* Return TRUE iff KEY is the name of the svn:log property.
  * Implements filter_func_t. Use with filter_props() to only exclude svn:log.
@@ -981,6 +1021,137 @@ filter_include_log(const char *key)
 }
 
 
+/* Set the property NAME on revision 0 of the destination repository of
+ * the replay baton RB to VALUE, or delete it if VALUE is NULL.  Use POOL
+ * for temporary allocations.
+ */
+static svn_error_t *
+change_sync_prop(replay_baton_t *rb,
+                 const char *name,
+                 const svn_string_t *value,
+                 apr_pool_t *pool)
+{
+  if (rb->to_repos)
+    return svn_fs_change_rev_prop(svn_repos_fs(rb->to_repos), 0, name,
+                                  value, pool);
+
+  return svn_ra_change_rev_prop(rb->to_session, 0, name, value, pool);
+}
+
+/* Edit baton of the editor committing a revision straight into the
+ * filesystem of the destination repository.  The repository commit
+ * editor it wraps does all the work in TXN, except for committing it:
+ * svn_repos_fs_commit_txn() would run the hooks.
+ */
+typedef struct direct_edit_baton_t {
+  const svn_delta_editor_t *wrapped_editor;
+  void *wrapped_edit_baton;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+
+  /* The svn:date of the source revision, or NULL if it has none. */
+  const svn_string_t *date;
+
+  /* Where commit_callback() records the new revision. */
+  subcommand_baton_t *sb;
+} direct_edit_baton_t;
+
+/* Implements svn_delta_editor_t.open_root for the direct commit editor. */
+static svn_error_t *
+direct_open_root(void *edit_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **root_baton)
+{
+  direct_edit_baton_t *eb = edit_baton;
+
+  return eb->wrapped_editor->open_root(eb->wrapped_edit_baton,
+                                       base_revision, pool, root_baton);
+}
+
+/* Implements svn_delta_editor_t.close_edit for the direct commit editor. */
+static svn_error_t *
+direct_close_edit(void *edit_baton,
+                  apr_pool_t *pool)
+{
+  direct_edit_baton_t *eb = edit_baton;
+  svn_commit_info_t *commit_info = svn_create_commit_info(pool);
+  const char *conflict;
+  svn_error_t *err;
+
+  err = svn_fs_commit_txn(&conflict, &commit_info->revision, eb->txn, pool);
+  if (err)
+    {
+      svn_error_clear(svn_fs_abort_txn(eb->txn, pool));
+      return svn_error_return(err);
+    }
+
+  /* svn_fs_commit_txn rewrites svn:date to the current time, just like
+     it does when loading a dump file. */
+  SVN_ERR(svn_fs_change_rev_prop(eb->fs, commit_info->revision,
+                                 SVN_PROP_REVISION_DATE, eb->date, pool));
+
+  return commit_callback(commit_info, eb->sb, pool);
+}
+
+/* Implements svn_delta_editor_t.abort_edit for the direct commit editor. */
+static svn_error_t *
+direct_abort_edit(void *edit_baton,
+                  apr_pool_t *pool)
+{
+  direct_edit_baton_t *eb = edit_baton;
+
+  return svn_fs_abort_txn(eb->txn, pool);
+}
+
+/* Set *EDITOR and *EDIT_BATON to an editor committing a revision with
+ * the revision properties REV_PROPS straight into the filesystem of the
+ * destination repository of the replay baton RB, without running any
+ * of its hooks.  Allocate them in POOL.
+ */
+static svn_error_t *
+get_direct_commit_editor(const svn_delta_editor_t **editor,
+                         void **edit_baton,
+                         replay_baton_t *rb,
+                         apr_hash_t *rev_props,
+                         apr_pool_t *pool)
+{
+  svn_delta_editor_t *direct_editor = apr_palloc(pool,
+                                                 sizeof(*direct_editor));
+  direct_edit_baton_t *eb = apr_pcalloc(pool, sizeof(*eb));
+  svn_revnum_t youngest;
+
+  eb->fs = svn_repos_fs(rb->to_repos);
+  eb->date = apr_hash_get(rev_props, SVN_PROP_REVISION_DATE,
+                          APR_HASH_KEY_STRING);
+  eb->sb = rb->sb;
+
+  /* The revision properties go into the transaction, so that they
+     appear along with the revision itself. */
+  SVN_ERR(svn_fs_youngest_rev(&youngest, eb->fs, pool));
+  SVN_ERR(svn_fs_begin_txn2(&eb->txn, eb->fs, youngest, 0, pool));
+  SVN_ERR(svn_fs_change_txn_props(eb->txn,
+                                  svn_prop_hash_to_array(rev_props, pool),
+                                  pool));
+
+  SVN_ERR(svn_repos_get_commit_editor5(&eb->wrapped_editor,
+                                       &eb->wrapped_edit_baton,
+                                       rb->to_repos, eb->txn,
+                                       rb->sb->to_url, "/",
+                                       apr_hash_make(pool),
+                                       NULL, NULL, NULL, NULL, pool));
+
+  *direct_editor = *eb->wrapped_editor;
+  direct_editor->open_root = direct_open_root;
+  direct_editor->close_edit = direct_close_edit;
+  direct_editor->abort_edit = direct_abort_edit;
+
+  *editor = direct_editor;
+  *edit_baton = eb;
+
+  return SVN_NO_ERROR;
+}
+
 /* Callback function for svn_ra_replay_range, invoked when starting to parse
  * a replay report.
  */
@@ -1012,44 +1183,58 @@ replay_rev_started(svn_revnum_t revision,
      NOTE: We have to set this before we start the commit editor,
      because ra_svn doesn't let you change rev props during a
      commit. */
-  SVN_ERR(svn_ra_change_rev_prop(rb->to_session, 0,
-                                 SVNSYNC_PROP_CURRENTLY_COPYING,
-                                 svn_string_createf(pool, "%ld",
-                                                    revision),
-                                 pool));
+  SVN_ERR(change_sync_prop(rb, SVNSYNC_PROP_CURRENTLY_COPYING,
+                           svn_string_createf(pool, "%ld", revision),
+                           pool));
+
+  /* Committing straight into the destination's filesystem, we can give
+     the new revision all its properties at once. */
+  if (rb->to_repos)
+    {
+      filtered = filter_props(&filtered_count, rev_props,
+                              filter_exclude_sync, pool);
+      SVN_ERR(svnsync_normalize_revprops(filtered, &normalized_count, pool));
+      rb->normalized_rev_props_count += normalized_count;
 
-  /* The actual copy is just a replay hooked up to a commit.  Include
-     all the revision properties from the source repositories, except
-     'svn:author' and 'svn:date', those are not guaranteed to get
-     through the editor anyway.
-     If we're syncing to an non-commit-revprops capable server, filter
-     out all revprops except svn:log and add them later in
-     revplay_rev_finished. */
-  filtered = filter_props(&filtered_count, rev_props,
-                          (rb->has_commit_revprops_capability
-                            ? filter_exclude_date_author_sync
-                            : filter_include_log),
-                          pool);
-
-  /* svn_ra_get_commit_editor3 requires the log message to be
-     set. It's possible that we didn't receive 'svn:log' here, so we
-     have to set it to at least the empty string. If there's a svn:log
-     property on this revision, we will write the actual value in the
-     replay_rev_finished callback. */
-  if (! apr_hash_get(filtered, SVN_PROP_REVISION_LOG, APR_HASH_KEY_STRING))
-    apr_hash_set(filtered, SVN_PROP_REVISION_LOG, APR_HASH_KEY_STRING,
-                 svn_string_create("", pool));
-
-  /* If necessary, normalize line ending style, and add the number
-     of changes to the overall count in the replay baton. */
-  SVN_ERR(svnsync_normalize_revprops(filtered, &normalized_count, pool));
-  rb->normalized_rev_props_count += normalized_count;
-
-  SVN_ERR(svn_ra_get_commit_editor3(rb->to_session, &commit_editor,
-                                    &commit_baton,
-                                    filtered,
-                                    commit_callback, rb->sb,
-                                    NULL, FALSE, pool));
+      SVN_ERR(get_direct_commit_editor(&commit_editor, &commit_baton, rb,
+                                       filtered, pool));
+    }
+  else
+    {
+      /* The actual copy is just a replay hooked up to a commit.  Include
+         all the revision properties from the source repositories, except
+         'svn:author' and 'svn:date', those are not guaranteed to get
+         through the editor anyway.
+         If we're syncing to an non-commit-revprops capable server, filter
+         out all revprops except svn:log and add them later in
+         revplay_rev_finished. */
+      filtered = filter_props(&filtered_count, rev_props,
+                              (rb->has_commit_revprops_capability
+                                ? filter_exclude_date_author_sync
+                                : filter_include_log),
+                              pool);
+
+      /* svn_ra_get_commit_editor3 requires the log message to be
+         set. It's possible that we didn't receive 'svn:log' here, so we
+         have to set it to at least the empty string. If there's a svn:log
+         property on this revision, we will write the actual value in the
+         replay_rev_finished callback. */
+      if (! apr_hash_get(filtered, SVN_PROP_REVISION_LOG,
+                         APR_HASH_KEY_STRING))
+        apr_hash_set(filtered, SVN_PROP_REVISION_LOG, APR_HASH_KEY_STRING,
+                     svn_string_create("", pool));
+
+      /* If necessary, normalize line ending style, and add the number
+         of changes to the overall count in the replay baton. */
+      SVN_ERR(svnsync_normalize_revprops(filtered, &normalized_count, pool));
+      rb->normalized_rev_props_count += normalized_count;
+
+      SVN_ERR(svn_ra_get_commit_editor3(rb->to_session, &commit_editor,
+                                        &commit_baton,
+                                        filtered,
+                                        commit_callback, rb->sb,
+                                        NULL, FALSE, pool));
+    }
 
   /* There's one catch though, the diff shows us props we can't send
      over the RA interface, so we need an editor that's smart enough
@@ -1096,38 +1281,47 @@ replay_rev_finished(svn_revnum_t revision,
               _("Commit created rev %ld but should have created %ld"),
               rb->sb->committed_rev, revision);
 
-  SVN_ERR(svn_ra_rev_proplist(rb->to_session, revision, &existing_props,
-                              subpool));
-
-
-  /* Ok, we're done with the data, now we just need to copy the remaining
-     'svn:date' and 'svn:author' revprops and we're all set.
-     If the server doesn't support revprops-in-a-commit, we still have to
-     set all revision properties except svn:log. */
-  filtered = filter_props(&filtered_count, rev_props,
-                          (rb->has_commit_revprops_capability
-                            ? filter_include_date_author_sync
-                            : filter_exclude_log),
-                          subpool);
-
-  /* If necessary, normalize line ending style, and add the number
-     of changes to the overall count in the replay baton. */
-  SVN_ERR(svnsync_normalize_revprops(filtered, &normalized_count, pool));
-  rb->normalized_rev_props_count += normalized_count;
-
-  SVN_ERR(write_revprops(&filtered_count, rb->to_session, revision, filtered,
-                         subpool));
-
-  /* Remove all extra properties in TARGET. */
-  SVN_ERR(remove_props_not_in_source(rb->to_session, revision,
-                                     rev_props, existing_props, subpool));
+  if (rb->to_repos)
+    {
+      /* The revision got all its properties when it was committed. */
+      filter_props(&filtered_count, rev_props, filter_exclude_sync,
+                   subpool);
+    }
+  else
+    {
+      SVN_ERR(svn_ra_rev_proplist(rb->to_session, revision, &existing_props,
+                                  subpool));
+
+
+      /* Ok, we're done with the data, now we just need to copy the
+         remaining 'svn:date' and 'svn:author' revprops and we're all set.
+         If the server doesn't support revprops-in-a-commit, we still have
+         to set all revision properties except svn:log. */
+      filtered = filter_props(&filtered_count, rev_props,
+                              (rb->has_commit_revprops_capability
+                                ? filter_include_date_author_sync
+                                : filter_exclude_log),
+                              subpool);
+
+      /* If necessary, normalize line ending style, and add the number
+         of changes to the overall count in the replay baton. */
+      SVN_ERR(svnsync_normalize_revprops(filtered, &normalized_count, pool));
+      rb->normalized_rev_props_count += normalized_count;
+
+      SVN_ERR(write_revprops(&filtered_count, rb->to_session, revision,
+                             filtered, subpool));
+
+      /* Remove all extra properties in TARGET. */
+      SVN_ERR(remove_props_not_in_source(rb->to_session, revision,
+                                         rev_props, existing_props,
+                                         subpool));
+    }
 
   svn_pool_clear(subpool);
 
   /* Ok, we're done, bring the last-merged-rev property up to date. */
-  SVN_ERR(svn_ra_change_rev_prop
-          (rb->to_session,
-           0,
+  SVN_ERR(change_sync_prop
+          (rb,
            SVNSYNC_PROP_LAST_MERGED_REV,
            svn_string_create(apr_psprintf(pool, "%ld", revision),
                              subpool),
@@ -1135,9 +1329,8 @@ replay_rev_finished(svn_revnum_t revision,
 
   /* And finally drop the currently copying prop, since we're done
      with this revision. */
-  SVN_ERR(svn_ra_change_rev_prop(rb->to_session, 0,
-                                 SVNSYNC_PROP_CURRENTLY_COPYING,
-                                 NULL, subpool));
+  SVN_ERR(change_sync_prop(rb, SVNSYNC_PROP_CURRENTLY_COPYING, NULL,
+                           subpool));
 
   /* Notify the user that we copied revision properties. */
   if (! rb->sb->quiet)
@@ -1148,6 +1341,334 @@ replay_rev_finished(svn_revnum_t revision,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+/* The number of revisions that may be replayed from the source ahead
+ * of the one being committed to the destination.
+ */
+#define PIPELINE_DEPTH 4
+
+/* A revision replayed from the source, waiting to be committed. */
+typedef struct spooled_rev_t {
+  svn_revnum_t revision;
+  apr_hash_t *rev_props;
+  svnsync_spool_t *spool;
+} spooled_rev_t;
+
+/* State shared between the thread replaying revisions from the source
+ * and the main thread, which commits them to the destination meanwhile.
+ */
+typedef struct sync_pipeline_t {
+  /* Revision number N, counting from 0, is spooled in
+     REVS[N % PIPELINE_DEPTH], allocated in REV_POOLS[N % PIPELINE_DEPTH].
+     QUEUED revisions have been replayed completely so far and COMMITTED
+     of them have been committed.  Access to these counters, DONE,
+     SHUTDOWN and ERR is serialized by MUTEX and COND gets signalled
+     whenever they change. */
+  spooled_rev_t revs[PIPELINE_DEPTH];
+  apr_pool_t *rev_pools[PIPELINE_DEPTH];
+  apr_uint64_t queued;
+  apr_uint64_t committed;
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *cond;
+
+  /* Set by the replay thread once it is done, along with the error
+     replaying failed with, if any. */
+  svn_boolean_t done;
+  svn_error_t *err;
+
+  /* Set by the main thread to make the replay thread stop. */
+  svn_boolean_t shutdown;
+
+  /* What the replay thread replays. */
+  svn_ra_session_t *from_session;
+  svn_revnum_t start_revision;
+  svn_revnum_t end_revision;
+
+  /* The pool the replay thread allocates from, and the one holding the
+     structure itself, its mutex, condition and thread.  Like the
+     revision pools, these are root pools. */
+  apr_pool_t *replay_pool;
+  apr_pool_t *pool;
+  apr_thread_t *thread;
+} sync_pipeline_t;
+
+/* Callback function for svn_ra_replay_range on the replay thread,
+ * setting up the spooling of REVISION once its slot is free.
+ */
+static svn_error_t *
+spool_rev_started(svn_revnum_t revision,
+                  void *replay_baton,
+                  const svn_delta_editor_t **editor,
+                  void **edit_baton,
+                  apr_hash_t *rev_props,
+                  apr_pool_t *pool)
+{
+  sync_pipeline_t *pl = replay_baton;
+  spooled_rev_t *rev;
+  apr_pool_t *rev_pool;
+  const svn_delta_editor_t *spool_editor;
+  void *spool_baton;
+  svn_boolean_t shutdown;
+
+  /* Revision N - PIPELINE_DEPTH has to be committed before its slot
+     can be reused. */
+  apr_thread_mutex_lock(pl->mutex);
+  while (! pl->shutdown && pl->queued >= pl->committed + PIPELINE_DEPTH)
+    apr_thread_cond_wait(pl->cond, pl->mutex);
+  shutdown = pl->shutdown;
+  apr_thread_mutex_unlock(pl->mutex);
+
+  if (shutdown)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  rev_pool = pl->rev_pools[pl->queued % PIPELINE_DEPTH];
+  svn_pool_clear(rev_pool);
+
+  rev = &pl->revs[pl->queued % PIPELINE_DEPTH];
+  rev->revision = revision;
+  rev->rev_props = svn_prop_hash_dup(rev_props, rev_pool);
+  SVN_ERR(svnsync_spool_editor(&rev->spool, &spool_editor, &spool_baton,
+                               rev_pool));
+
+  return svn_delta_get_cancellation_editor(check_cancel, NULL,
+                                           spool_editor, spool_baton,
+                                           editor, edit_baton, pool);
+}
+
+/* Callback function for svn_ra_replay_range on the replay thread,
+ * handing the spooled REVISION to the main thread.
+ */
+static svn_error_t *
+spool_rev_finished(svn_revnum_t revision,
+                   void *replay_baton,
+                   const svn_delta_editor_t *editor,
+                   void *edit_baton,
+                   apr_hash_t *rev_props,
+                   apr_pool_t *pool)
+{
+  sync_pipeline_t *pl = replay_baton;
+
+  apr_thread_mutex_lock(pl->mutex);
+  pl->queued++;
+  apr_thread_cond_broadcast(pl->cond);
+  apr_thread_mutex_unlock(pl->mutex);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function replaying the revisions of DATA, a sync_pipeline_t,
+ * into its slots.
+ */
+static void * APR_THREAD_FUNC
+replay_thread(apr_thread_t *thread, void *data)
+{
+  sync_pipeline_t *pl = data;
+  svn_error_t *err;
+
+  err = svn_ra_replay_range(pl->from_session, pl->start_revision,
+                            pl->end_revision, 0, TRUE, spool_rev_started,
+                            spool_rev_finished, pl, pl->replay_pool);
+
+  apr_thread_mutex_lock(pl->mutex);
+  pl->err = err;
+  pl->done = TRUE;
+  apr_thread_cond_broadcast(pl->cond);
+  apr_thread_mutex_unlock(pl->mutex);
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Destroy all pools of PL, including the one PL lives in. */
+static void
+destroy_pipeline_pools(sync_pipeline_t *pl)
+{
+  int i;
+
+  for (i = 0; i < PIPELINE_DEPTH; i++)
+    svn_pool_destroy(pl->rev_pools[i]);
+  svn_pool_destroy(pl->replay_pool);
+  svn_pool_destroy(pl->pool);
+}
+
+/* Return a new pipeline with a thread replaying START_REVISION through
+ * END_REVISION from FROM_SESSION, or NULL if the thread could not be
+ * started.
+ */
+static sync_pipeline_t *
+start_pipeline(svn_ra_session_t *from_session,
+               svn_revnum_t start_revision,
+               svn_revnum_t end_revision)
+{
+  apr_pool_t *pipeline_pool = svn_pool_create(NULL);
+  sync_pipeline_t *pl = apr_pcalloc(pipeline_pool, sizeof(*pl));
+  int i;
+
+  if (apr_thread_mutex_create(&pl->mutex, APR_THREAD_MUTEX_DEFAULT,
+                              pipeline_pool)
+      || apr_thread_cond_create(&pl->cond, pipeline_pool))
+    {
+      svn_pool_destroy(pipeline_pool);
+      return NULL;
+    }
+
+  pl->pool = pipeline_pool;
+  pl->from_session = from_session;
+  pl->start_revision = start_revision;
+  pl->end_revision = end_revision;
+  pl->replay_pool = svn_pool_create(NULL);
+  for (i = 0; i < PIPELINE_DEPTH; i++)
+    pl->rev_pools[i] = svn_pool_create(NULL);
+
+  if (apr_thread_create(&pl->thread, NULL, replay_thread, pl,
+                        pipeline_pool))
+    {
+      destroy_pipeline_pools(pl);
+      return NULL;
+    }
+
+  return pl;
+}
+
+/* Commit the revisions the replay thread of PL spools, in order, using
+ * the replay baton RB, until all of them are committed or replaying
+ * fails.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+commit_spooled_revs(sync_pipeline_t *pl,
+                    replay_baton_t *rb,
+                    apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  while (TRUE)
+    {
+      spooled_rev_t *rev;
+      const svn_delta_editor_t *editor;
+      void *edit_baton;
+      svn_boolean_t done;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      svn_pool_clear(iterpool);
+
+      apr_thread_mutex_lock(pl->mutex);
+      while (! pl->done && pl->committed == pl->queued)
+        apr_thread_cond_wait(pl->cond, pl->mutex);
+      done = (pl->committed == pl->queued);
+      if (done)
+        {
+          err = pl->err;
+          pl->err = SVN_NO_ERROR;
+        }
+      apr_thread_mutex_unlock(pl->mutex);
+
+      if (done)
+        {
+          svn_pool_destroy(iterpool);
+          return svn_error_return(err);
+        }
+
+      /* This is just what svn_ra_replay_range would have done with the
+         revision, had it been called with the replay_rev_* callbacks. */
+      rev = &pl->revs[pl->committed % PIPELINE_DEPTH];
+      SVN_ERR(replay_rev_started(rev->revision, rb, &editor, &edit_baton,
+                                 rev->rev_props, iterpool));
+      SVN_ERR(svnsync_spool_replay(rev->spool, editor, edit_baton,
+                                   iterpool));
+      SVN_ERR(replay_rev_finished(rev->revision, rb, editor, edit_baton,
+                                  rev->rev_props, iterpool));
+
+      apr_thread_mutex_lock(pl->mutex);
+      pl->committed++;
+      apr_thread_cond_broadcast(pl->cond);
+      apr_thread_mutex_unlock(pl->mutex);
+    }
+}
+
+/* Copy START_REVISION through END_REVISION from FROM_SESSION using the
+ * replay baton RB, replaying later revisions from the source while
+ * earlier ones are being committed to the destination.  Set *STARTED to
+ * FALSE, and do nothing else, if the replay thread could not be started.
+ * Use POOL for temporary allocations.
+ */
+static svn_error_t *
+replay_pipelined(svn_boolean_t *started,
+                 svn_ra_session_t *from_session,
+                 svn_revnum_t start_revision,
+                 svn_revnum_t end_revision,
+                 replay_baton_t *rb,
+                 apr_pool_t *pool)
+{
+  sync_pipeline_t *pl = start_pipeline(from_session, start_revision,
+                                       end_revision);
+  svn_error_t *err;
+  apr_status_t retval;
+
+  *started = (pl != NULL);
+  if (! pl)
+    return SVN_NO_ERROR;
+
+  err = commit_spooled_revs(pl, rb, pool);
+
+  /* If committing failed, the replay thread may still be waiting for a
+     slot; tell it to give up. */
+  apr_thread_mutex_lock(pl->mutex);
+  pl->shutdown = TRUE;
+  apr_thread_cond_broadcast(pl->cond);
+  apr_thread_mutex_unlock(pl->mutex);
+  apr_thread_join(&retval, pl->thread);
+
+  svn_error_clear(pl->err);
+  destroy_pipeline_pools(pl);
+
+  return svn_error_return(err);
+}
+#endif
+
+/* Open the repository at the file:// URL TO_URL as *REPOS, allocated
+ * in POOL, for committing revisions straight into its filesystem.
+ */
+static svn_error_t *
+open_direct_repos(svn_repos_t **repos,
+                  const char *to_url,
+                  apr_pool_t *pool)
+{
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  const char *hostname, *path;
+
+  if (strncmp(to_url, "file://", 7) != 0)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("--direct-fs requires a file:// destination "
+                               "URL, not '%s'"), to_url);
+
+  /* Like ra_local, accept only an empty or "localhost" hostname. */
+  hostname = to_url + 7;
+  path = strchr(hostname, '/');
+  if (! path)
+    path = "/";
+  else if (path != hostname
+           && ! (path - hostname == 9
+                 && strncmp(hostname, "localhost", 9) == 0))
+    return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, NULL,
+                             _("Local URL '%s' contains unsupported "
+                               "hostname"), to_url);
+
+  path = svn_path_uri_decode(path, pool);
+#if defined(WIN32) || defined(__CYGWIN__)
+  /* file:///X:/path names the local path X:/path. */
+  if (path[1] && path[2] == ':')
+    path++;
+#endif
+
+  /* A Berkeley DB filesystem needs to flush its log only once per
+     committed revision rather than for every one of its many trails. */
+  apr_hash_set(fs_config, SVN_FS_CONFIG_BDB_GROUP_COMMIT,
+               APR_HASH_KEY_STRING, "1");
+
+  return svn_repos_open2(repos, svn_dirent_internal_style(path, pool),
+                         fs_config, pool);
+}
+
 /* Synchronize the repository associated with RA session TO_SESSION,
  * using information found in BATON, while the repository is
  * locked.  Implements `with_locked_func_t' interface.
@@ -1261,21 +1782,41 @@ do_synchronize(svn_ra_session_t *to_session,
      into the destination repository. */
   rb = make_replay_baton(from_session, to_session, baton, pool);
 
-  /* For compatibility with older svnserve versions, check first if we
-     support adding revprops to the commit. */
-  SVN_ERR(svn_ra_has_capability(rb->to_session,
-                                &rb->has_commit_revprops_capability,
-                                SVN_RA_CAPABILITY_COMMIT_REVPROPS,
-                                pool));
+  if (baton->direct_fs)
+    {
+      SVN_ERR(open_direct_repos(&rb->to_repos, baton->to_url, pool));
+    }
+  else
+    {
+      /* For compatibility with older svnserve versions, check first if
+         we support adding revprops to the commit. */
+      SVN_ERR(svn_ra_has_capability(rb->to_session,
+                                    &rb->has_commit_revprops_capability,
+                                    SVN_RA_CAPABILITY_COMMIT_REVPROPS,
+                                    pool));
+    }
 
   start_revision = last_merged + 1;
   end_revision = from_latest;
 
   SVN_ERR(check_cancel(NULL));
 
+#if APR_HAS_THREADS
+  {
+    svn_boolean_t started;
+
+    SVN_ERR(replay_pipelined(&started, from_session, start_revision,
+                             end_revision, rb, pool));
+    if (! started)
+      SVN_ERR(svn_ra_replay_range(from_session, start_revision,
+                                  end_revision, 0, TRUE, replay_rev_started,
+                                  replay_rev_finished, rb, pool));
+  }
+#else
   SVN_ERR(svn_ra_replay_range(from_session, start_revision, end_revision,
                               0, TRUE, replay_rev_started,
                               replay_rev_finished, rb, pool));
+#endif
 
   SVN_ERR(log_properties_normalized(rb->normalized_rev_props_count
                                       + normalized_rev_props_count,
@@ -1698,8 +2239,11 @@ main(int argc, const char *argv[])
   if (err)
     return svn_cmdline_handle_exit_error(err, NULL, "svnsync: ");
 
-  /* Create our top-level pool.  Use a separate mutexless allocator,
-   * given this application is single threaded.
+  /* Create our top-level pool.  Use a separate allocator.  Since 'sync'
+   * replays from the source on one thread while committing to the
+   * destination on another, and each uses its own RA session allocated
+   * beneath this pool, the allocator needs a mutex when threads are
+   * available.
    */
   if (apr_allocator_create(&allocator))
     return EXIT_FAILURE;
@@ -1709,6 +2253,16 @@ main(int argc, const char *argv[])
   pool = svn_pool_create_ex(NULL, allocator);
   apr_allocator_owner_set(allocator, pool);
 
+#if APR_HAS_THREADS
+  {
+    apr_thread_mutex_t *mutex;
+
+    if (apr_thread_mutex_create(&mutex, APR_THREAD_MUTEX_DEFAULT, pool))
+      return EXIT_FAILURE;
+    apr_allocator_mutex_set(allocator, mutex);
+  }
+#endif
+
   err = svn_ra_initialize(pool);
   if (err)
     return svn_cmdline_handle_exit_error(err, pool, "svnsync: ");
@@ -1823,6 +2377,10 @@ main(int argc, const char *argv[])
             opt_baton.allow_non_empty = TRUE;
             break;
 
+          case svnsync_opt_direct_fs:
+            opt_baton.direct_fs = TRUE;
+            break;
+
           case 'q':
             opt_baton.quiet = TRUE;
             break;
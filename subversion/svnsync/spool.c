@@ -0,0 +1,623 @@
+/*
+ * spool.c :  Recording editor drives for svnsync to replay them later.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_strings.h>
+
+#include "svn_pools.h"
+#include "svn_delta.h"
+#include "svn_io.h"
+#include "svn_string.h"
+
+#include "spool.h"
+
+#include "svn_private_config.h"
+
+
+/* The amount of svndiff data a spool keeps in memory.  Anything beyond
+ * it goes to a temporary file.
+ */
+#define SPOOL_MEMORY_LIMIT (1024 * 1024)
+
+
+/* The kinds of editor calls we record. */
+typedef enum op_kind_t {
+  op_set_target_revision,
+  op_open_root,
+  op_delete_entry,
+  op_add_directory,
+  op_open_directory,
+  op_change_dir_prop,
+  op_close_directory,
+  op_absent_directory,
+  op_add_file,
+  op_open_file,
+  op_apply_textdelta,
+  op_change_file_prop,
+  op_close_file,
+  op_absent_file
+} op_kind_t;
+
+/* One recorded editor call.  Directory and file batons are identified
+ * by numbers, handed out in the order the batons were created.
+ */
+typedef struct edit_op_t {
+  op_kind_t kind;
+
+  /* The baton the call was made on: the parent directory for calls that
+   * take a path, the node itself for the others. */
+  int baton_id;
+
+  /* The baton created by open_root, add_* or open_*. */
+  int new_id;
+
+  /* The path of the node, or the name of the property. */
+  const char *path;
+
+  /* The new property value, or NULL to delete the property. */
+  const svn_string_t *value;
+
+  /* The copyfrom path, or the checksum passed to apply_textdelta or
+   * close_file. */
+  const char *copyfrom_path;
+
+  /* The copyfrom, base or target revision. */
+  svn_revnum_t revision;
+
+  /* For apply_textdelta, where its svndiff data is stored. */
+  svn_boolean_t in_file;
+  apr_off_t offset;
+  apr_off_t len;
+} edit_op_t;
+
+struct svnsync_spool_t {
+  /* The recorded calls, as edit_op_t *. */
+  apr_array_header_t *ops;
+
+  /* The number of batons created so far. */
+  int num_batons;
+
+  /* The svndiff data kept in memory, and the temporary file with the
+   * rest, if any, along with its size. */
+  svn_stringbuf_t *mem;
+  apr_file_t *file;
+  apr_off_t file_len;
+
+  /* The apply_textdelta call whose data is being written. */
+  edit_op_t *delta_op;
+
+  apr_pool_t *pool;
+};
+
+/* The baton of a directory or file being recorded. */
+typedef struct node_baton_t {
+  svnsync_spool_t *spool;
+  int id;
+} node_baton_t;
+
+
+/*** Recording ***/
+
+/* Append a call of KIND on the baton BATON_ID to SPOOL and return it. */
+static edit_op_t *
+record_op(svnsync_spool_t *spool, op_kind_t kind, int baton_id)
+{
+  edit_op_t *op = apr_pcalloc(spool->pool, sizeof(*op));
+
+  op->kind = kind;
+  op->baton_id = baton_id;
+  op->new_id = -1;
+  op->revision = SVN_INVALID_REVNUM;
+  APR_ARRAY_PUSH(spool->ops, edit_op_t *) = op;
+
+  return op;
+}
+
+/* Record a call of KIND creating a new baton, on the baton BATON_ID of
+ * SPOOL, and set *CHILD_BATON to the new one. */
+static edit_op_t *
+record_open_op(svnsync_spool_t *spool,
+               op_kind_t kind,
+               int baton_id,
+               void **child_baton)
+{
+  edit_op_t *op = record_op(spool, kind, baton_id);
+  node_baton_t *nb = apr_palloc(spool->pool, sizeof(*nb));
+
+  nb->spool = spool;
+  nb->id = spool->num_batons++;
+  op->new_id = nb->id;
+  *child_baton = nb;
+
+  return op;
+}
+
+static svn_error_t *
+set_target_revision(void *edit_baton,
+                    svn_revnum_t target_revision,
+                    apr_pool_t *pool)
+{
+  edit_op_t *op = record_op(edit_baton, op_set_target_revision, -1);
+
+  op->revision = target_revision;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_root(void *edit_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **root_baton)
+{
+  edit_op_t *op = record_open_op(edit_baton, op_open_root, -1, root_baton);
+
+  op->revision = base_revision;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+delete_entry(const char *path,
+             svn_revnum_t base_revision,
+             void *parent_baton,
+             apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  edit_op_t *op = record_op(pb->spool, op_delete_entry, pb->id);
+
+  op->path = apr_pstrdup(pb->spool->pool, path);
+  op->revision = base_revision;
+  return SVN_NO_ERROR;
+}
+
+/* Record the add_* or open_* call of KIND, as described by the
+ * arguments of add_directory(). */
+static svn_error_t *
+record_add_or_open(op_kind_t kind,
+                   const char *path,
+                   void *parent_baton,
+                   const char *copyfrom_path,
+                   svn_revnum_t revision,
+                   void **child_baton)
+{
+  node_baton_t *pb = parent_baton;
+  apr_pool_t *pool = pb->spool->pool;
+  edit_op_t *op = record_open_op(pb->spool, kind, pb->id, child_baton);
+
+  op->path = apr_pstrdup(pool, path);
+  op->copyfrom_path = copyfrom_path ? apr_pstrdup(pool, copyfrom_path)
+                                    : NULL;
+  op->revision = revision;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+add_directory(const char *path,
+              void *parent_baton,
+              const char *copyfrom_path,
+              svn_revnum_t copyfrom_rev,
+              apr_pool_t *pool,
+              void **child_baton)
+{
+  return record_add_or_open(op_add_directory, path, parent_baton,
+                            copyfrom_path, copyfrom_rev, child_baton);
+}
+
+static svn_error_t *
+open_directory(const char *path,
+               void *parent_baton,
+               svn_revnum_t base_revision,
+               apr_pool_t *pool,
+               void **child_baton)
+{
+  return record_add_or_open(op_open_directory, path, parent_baton,
+                            NULL, base_revision, child_baton);
+}
+
+static svn_error_t *
+add_file(const char *path,
+         void *parent_baton,
+         const char *copyfrom_path,
+         svn_revnum_t copyfrom_rev,
+         apr_pool_t *pool,
+         void **file_baton)
+{
+  return record_add_or_open(op_add_file, path, parent_baton,
+                            copyfrom_path, copyfrom_rev, file_baton);
+}
+
+static svn_error_t *
+open_file(const char *path,
+          void *parent_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **file_baton)
+{
+  return record_add_or_open(op_open_file, path, parent_baton,
+                            NULL, base_revision, file_baton);
+}
+
+/* Record the change_*_prop call of KIND on the baton NODE_BATON. */
+static svn_error_t *
+record_prop(op_kind_t kind,
+            void *node_baton,
+            const char *name,
+            const svn_string_t *value)
+{
+  node_baton_t *nb = node_baton;
+  apr_pool_t *pool = nb->spool->pool;
+  edit_op_t *op = record_op(nb->spool, kind, nb->id);
+
+  op->path = apr_pstrdup(pool, name);
+  op->value = value ? svn_string_dup(value, pool) : NULL;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+change_dir_prop(void *dir_baton,
+                const char *name,
+                const svn_string_t *value,
+                apr_pool_t *pool)
+{
+  return record_prop(op_change_dir_prop, dir_baton, name, value);
+}
+
+static svn_error_t *
+change_file_prop(void *file_baton,
+                 const char *name,
+                 const svn_string_t *value,
+                 apr_pool_t *pool)
+{
+  return record_prop(op_change_file_prop, file_baton, name, value);
+}
+
+static svn_error_t *
+close_directory(void *dir_baton,
+                apr_pool_t *pool)
+{
+  node_baton_t *db = dir_baton;
+
+  record_op(db->spool, op_close_directory, db->id);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+close_file(void *file_baton,
+           const char *text_checksum,
+           apr_pool_t *pool)
+{
+  node_baton_t *fb = file_baton;
+  edit_op_t *op = record_op(fb->spool, op_close_file, fb->id);
+
+  op->copyfrom_path = text_checksum
+                        ? apr_pstrdup(fb->spool->pool, text_checksum)
+                        : NULL;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+absent_directory(const char *path,
+                 void *parent_baton,
+                 apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  edit_op_t *op = record_op(pb->spool, op_absent_directory, pb->id);
+
+  op->path = apr_pstrdup(pb->spool->pool, path);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+absent_file(const char *path,
+            void *parent_baton,
+            apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  edit_op_t *op = record_op(pb->spool, op_absent_file, pb->id);
+
+  op->path = apr_pstrdup(pb->spool->pool, path);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t, appending the svndiff data of the current
+ * apply_textdelta call to the spool BATON. */
+static svn_error_t *
+write_delta_data(void *baton, const char *data, apr_size_t *len)
+{
+  svnsync_spool_t *spool = baton;
+  edit_op_t *op = spool->delta_op;
+
+  /* Once the memory is used up, move the data of this call to the
+     temporary file and keep writing there. */
+  if (! op->in_file && spool->mem->len + *len > SPOOL_MEMORY_LIMIT)
+    {
+      apr_size_t moved = spool->mem->len - (apr_size_t) op->offset;
+
+      if (! spool->file)
+        SVN_ERR(svn_io_open_unique_file3(&spool->file, NULL, NULL,
+                                         svn_io_file_del_on_pool_cleanup,
+                                         spool->pool, spool->pool));
+      SVN_ERR(svn_io_file_write_full(spool->file,
+                                     spool->mem->data + op->offset,
+                                     moved, NULL, spool->pool));
+      spool->mem->len = (apr_size_t) op->offset;
+      spool->mem->data[spool->mem->len] = '\0';
+
+      op->in_file = TRUE;
+      op->offset = spool->file_len;
+      spool->file_len += moved;
+    }
+
+  if (op->in_file)
+    {
+      SVN_ERR(svn_io_file_write_full(spool->file, data, *len, NULL,
+                                     spool->pool));
+      spool->file_len += *len;
+    }
+  else
+    svn_stringbuf_appendbytes(spool->mem, data, *len);
+
+  op->len += *len;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t, ending the current apply_textdelta call of
+ * the spool BATON. */
+static svn_error_t *
+close_delta_data(void *baton)
+{
+  svnsync_spool_t *spool = baton;
+
+  spool->delta_op = NULL;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+apply_textdelta(void *file_baton,
+                const char *base_checksum,
+                apr_pool_t *pool,
+                svn_txdelta_window_handler_t *handler,
+                void **handler_baton)
+{
+  node_baton_t *fb = file_baton;
+  svnsync_spool_t *spool = fb->spool;
+  edit_op_t *op = record_op(spool, op_apply_textdelta, fb->id);
+  svn_stream_t *stream;
+
+  op->copyfrom_path = base_checksum ? apr_pstrdup(spool->pool, base_checksum)
+                                    : NULL;
+  if (spool->file && spool->mem->len >= SPOOL_MEMORY_LIMIT)
+    {
+      op->in_file = TRUE;
+      op->offset = spool->file_len;
+    }
+  else
+    op->offset = spool->mem->len;
+  spool->delta_op = op;
+
+  /* Store the windows as uncompressed svndiff; they're read back soon. */
+  stream = svn_stream_create(spool, pool);
+  svn_stream_set_write(stream, write_delta_data);
+  svn_stream_set_close(stream, close_delta_data);
+  svn_txdelta_to_svndiff2(handler, handler_baton, stream, 0, pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+close_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+abort_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svnsync_spool_editor(svnsync_spool_t **spool,
+                     const svn_delta_editor_t **editor,
+                     void **edit_baton,
+                     apr_pool_t *pool)
+{
+  svn_delta_editor_t *spool_editor = svn_delta_default_editor(pool);
+  svnsync_spool_t *s = apr_pcalloc(pool, sizeof(*s));
+
+  s->ops = apr_array_make(pool, 64, sizeof(edit_op_t *));
+  s->mem = svn_stringbuf_create_ensure(SVN__STREAM_CHUNK_SIZE, pool);
+  s->pool = pool;
+
+  spool_editor->set_target_revision = set_target_revision;
+  spool_editor->open_root = open_root;
+  spool_editor->delete_entry = delete_entry;
+  spool_editor->add_directory = add_directory;
+  spool_editor->open_directory = open_directory;
+  spool_editor->change_dir_prop = change_dir_prop;
+  spool_editor->close_directory = close_directory;
+  spool_editor->absent_directory = absent_directory;
+  spool_editor->add_file = add_file;
+  spool_editor->open_file = open_file;
+  spool_editor->apply_textdelta = apply_textdelta;
+  spool_editor->change_file_prop = change_file_prop;
+  spool_editor->close_file = close_file;
+  spool_editor->absent_file = absent_file;
+  spool_editor->close_edit = close_edit;
+  spool_editor->abort_edit = abort_edit;
+
+  *spool = s;
+  *editor = spool_editor;
+  *edit_baton = s;
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Replaying ***/
+
+/* Write the svndiff data recorded for OP in SPOOL to STREAM.  Use POOL
+ * for temporary allocations. */
+static svn_error_t *
+write_recorded_delta(svnsync_spool_t *spool,
+                     const edit_op_t *op,
+                     svn_stream_t *stream,
+                     apr_pool_t *pool)
+{
+  char *buf;
+  apr_off_t remaining = op->len;
+  apr_off_t offset = op->offset;
+
+  if (! op->in_file)
+    {
+      apr_size_t len = (apr_size_t) op->len;
+
+      return svn_stream_write(stream, spool->mem->data + op->offset, &len);
+    }
+
+  buf = apr_palloc(pool, SVN__STREAM_CHUNK_SIZE);
+  SVN_ERR(svn_io_file_seek(spool->file, APR_SET, &offset, pool));
+  while (remaining > 0)
+    {
+      apr_size_t len = remaining > SVN__STREAM_CHUNK_SIZE
+                         ? SVN__STREAM_CHUNK_SIZE
+                         : (apr_size_t) remaining;
+
+      SVN_ERR(svn_io_file_read_full(spool->file, buf, len, NULL, pool));
+      SVN_ERR(svn_stream_write(stream, buf, &len));
+      remaining -= len;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svnsync_spool_replay(svnsync_spool_t *spool,
+                     const svn_delta_editor_t *editor,
+                     void *edit_baton,
+                     apr_pool_t *pool)
+{
+  /* The batons of the destination editor by our baton numbers, and the
+     pools of the files that are open. */
+  void **batons = apr_pcalloc(pool, (spool->num_batons + 1)
+                                    * sizeof(*batons));
+  apr_pool_t **file_pools = apr_pcalloc(pool, (spool->num_batons + 1)
+                                              * sizeof(*file_pools));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i < spool->ops->nelts; i++)
+    {
+      const edit_op_t *op = APR_ARRAY_IDX(spool->ops, i, edit_op_t *);
+      void *baton = op->baton_id >= 0 ? batons[op->baton_id] : NULL;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      svn_stream_t *stream;
+
+      svn_pool_clear(iterpool);
+
+      switch (op->kind)
+        {
+          case op_set_target_revision:
+            SVN_ERR(editor->set_target_revision(edit_baton, op->revision,
+                                                iterpool));
+            break;
+
+          case op_open_root:
+            SVN_ERR(editor->open_root(edit_baton, op->revision, pool,
+                                      &batons[op->new_id]));
+            break;
+
+          case op_delete_entry:
+            SVN_ERR(editor->delete_entry(op->path, op->revision, baton,
+                                         iterpool));
+            break;
+
+          case op_add_directory:
+            SVN_ERR(editor->add_directory(op->path, baton, op->copyfrom_path,
+                                          op->revision, pool,
+                                          &batons[op->new_id]));
+            break;
+
+          case op_open_directory:
+            SVN_ERR(editor->open_directory(op->path, baton, op->revision,
+                                           pool, &batons[op->new_id]));
+            break;
+
+          case op_change_dir_prop:
+            SVN_ERR(editor->change_dir_prop(baton, op->path, op->value,
+                                            iterpool));
+            break;
+
+          case op_close_directory:
+            SVN_ERR(editor->close_directory(baton, iterpool));
+            break;
+
+          case op_absent_directory:
+            SVN_ERR(editor->absent_directory(op->path, baton, iterpool));
+            break;
+
+          case op_add_file:
+            file_pools[op->new_id] = svn_pool_create(pool);
+            SVN_ERR(editor->add_file(op->path, baton, op->copyfrom_path,
+                                     op->revision, file_pools[op->new_id],
+                                     &batons[op->new_id]));
+            break;
+
+          case op_open_file:
+            file_pools[op->new_id] = svn_pool_create(pool);
+            SVN_ERR(editor->open_file(op->path, baton, op->revision,
+                                      file_pools[op->new_id],
+                                      &batons[op->new_id]));
+            break;
+
+          case op_apply_textdelta:
+            SVN_ERR(editor->apply_textdelta(baton, op->copyfrom_path,
+                                            file_pools[op->baton_id],
+                                            &handler, &handler_baton));
+            stream = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE,
+                                               iterpool);
+            SVN_ERR(write_recorded_delta(spool, op, stream, iterpool));
+            SVN_ERR(svn_stream_close(stream));
+            break;
+
+          case op_change_file_prop:
+            SVN_ERR(editor->change_file_prop(baton, op->path, op->value,
+                                             iterpool));
+            break;
+
+          case op_close_file:
+            SVN_ERR(editor->close_file(baton, op->copyfrom_path, iterpool));
+            svn_pool_destroy(file_pools[op->baton_id]);
+            file_pools[op->baton_id] = NULL;
+            break;
+
+          case op_absent_file:
+            SVN_ERR(editor->absent_file(op->path, baton, iterpool));
+            break;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
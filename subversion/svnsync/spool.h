@@ -0,0 +1,70 @@
+/*
+ * spool.h :  Recording editor drives for svnsync to replay them later.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SPOOL_H
+#define SPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+#include "svn_types.h"
+#include "svn_delta.h"
+
+
+/* A recorded editor drive. */
+typedef struct svnsync_spool_t svnsync_spool_t;
+
+
+/* Set *EDITOR and *EDIT_BATON to an editor that records how it is
+ * driven in *SPOOL, so that the drive can be repeated later with
+ * svnsync_spool_replay().  Text deltas are kept in memory up to a
+ * limit, and written to a temporary file beyond it.  Allocate the spool
+ * in POOL; the temporary file goes away when POOL is cleaned up.
+ *
+ * The editor's close_edit and abort_edit do nothing.
+ */
+svn_error_t *
+svnsync_spool_editor(svnsync_spool_t **spool,
+                     const svn_delta_editor_t **editor,
+                     void **edit_baton,
+                     apr_pool_t *pool);
+
+
+/* Drive EDITOR and EDIT_BATON the way the editor returned along with
+ * SPOOL was driven, up to but not including close_edit, which is left
+ * to the caller.  Use POOL for all allocations.
+ */
+svn_error_t *
+svnsync_spool_replay(svnsync_spool_t *spool,
+                     const svn_delta_editor_t *editor,
+                     void *edit_baton,
+                     apr_pool_t *pool);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif  /* SPOOL_H */
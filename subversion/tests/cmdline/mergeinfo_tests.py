@@ -477,6 +477,53 @@ def mergeinfo_on_pegged_wc_path(sbox):
     adjust_error_for_server_version(''),
     ['4', '5'], A_path, A_COPY_path + '@PREV', '--show-revs', 'eligible')
 
+#----------------------------------------------------------------------
+def mergeinfo_with_history_cache(sbox):
+  "'mergeinfo' with the history cache enabled"
+
+  sbox.build()
+  wc_dir = sbox.wc_dir
+  expected_disk, expected_status = set_up_branch(sbox)
+
+  # Some paths we'll care about
+  A_path      = os.path.join(wc_dir, "A")
+  A_COPY_path = os.path.join(wc_dir, "A_COPY")
+
+  # r7 - Merge -c3,6 from A to A_COPY.
+  svntest.actions.run_and_verify_svn(None, None, [], 'merge', '-c3,6',
+                                     sbox.repo_url + '/A', A_COPY_path)
+  svntest.actions.run_and_verify_svn(None, None, [],
+                                     'ci', wc_dir,
+                                     '-m', 'Merge r3 and r6')
+
+  # Use a configuration area of our own, with the cache enabled.
+  config_dir = sbox.add_wc_path('config')
+  svntest.main.create_config_dir(config_dir, """
+#
+[auth]
+password-stores =
+
+[miscellany]
+interactive-conflicts = false
+mergeinfo-cache = yes
+""")
+  cache_dir = os.path.join(config_dir, 'mergeinfo-cache')
+
+  # The first run fills the cache and the second one answers from it,
+  # which must not make a difference.
+  for i in range(2):
+    svntest.actions.run_and_verify_mergeinfo(
+      adjust_error_for_server_version(''),
+      ['3', '6'], A_path, A_COPY_path, '--show-revs', 'merged',
+      '--config-dir', config_dir)
+    svntest.actions.run_and_verify_mergeinfo(
+      adjust_error_for_server_version(''),
+      ['4', '5'], A_path, A_COPY_path, '--show-revs', 'eligible',
+      '--config-dir', config_dir)
+
+    if not os.path.isdir(cache_dir) or not os.listdir(cache_dir):
+      raise svntest.Failure("No history cached in '%s'" % cache_dir)
+
 ########################################################################
 # Run the tests
 
@@ -492,6 +539,8 @@ test_list = [ None,
               SkipUnless(recursive_mergeinfo, server_has_mergeinfo),
               SkipUnless(mergeinfo_on_pegged_wc_path,
                          server_has_mergeinfo),
+              SkipUnless(mergeinfo_with_history_cache,
+                         server_has_mergeinfo),
              ]
 
 if __name__ == '__main__':
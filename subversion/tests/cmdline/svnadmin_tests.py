@@ -1217,6 +1217,102 @@ def hotcopy_symlink(sbox):
   if (not (os.path.exists(hotcopy_symlink_path))):
     raise svntest.Failure
 
+def verify_with_jobs(sbox):
+  "svnadmin verify --jobs reports revisions in order"
+
+  sbox.build(create_wc = False)
+
+  # Create r2 through r6.
+  for i in range(2, 7):
+    svntest.actions.run_and_verify_svn(None, None, [],
+                                       'mkdir', '-m', 'log_msg',
+                                       sbox.repo_url + '/dir%d' % i)
+
+  exit_code, output, errput = svntest.main.run_svnadmin("verify",
+                                                        "--jobs", "3",
+                                                        sbox.repo_dir)
+  svntest.verify.compare_and_display_lines(
+    "Error while running 'svnadmin verify --jobs'.",
+    'STDERR', ["* Verified revision %d.\n" % i for i in range(0, 7)],
+    errput)
+
+def load_with_jobs(sbox):
+  "svnadmin load --jobs reading ahead on stdin"
+
+  sbox.build(create_wc = False)
+  dump = svntest.actions.run_and_verify_dump(sbox.repo_dir)
+
+  load_repo, load_url = sbox.add_repo_path('load')
+  svntest.main.create_repos(load_repo)
+  exit_code, output, errput = svntest.main.run_command_stdin(
+    svntest.main.svnadmin_binary, [], 0, 1, dump,
+    'load', '--jobs', '2', '--quiet', load_repo)
+  svntest.verify.verify_outputs("Unexpected stderr output", None, errput,
+                                None, [])
+
+  svntest.verify.compare_and_display_lines(
+    "Error comparing the loaded repository.", 'DUMP', dump,
+    svntest.actions.run_and_verify_dump(load_repo))
+
+def dump_with_jobs(sbox):
+  "svnadmin dump --jobs matches the serial dump"
+
+  sbox.build(create_wc = False)
+
+  # Create r2 through r6, including a copy and some deltas.
+  svntest.actions.run_and_verify_svn(None, None, [],
+                                     'copy', '-m', 'log_msg',
+                                     sbox.repo_url + '/A',
+                                     sbox.repo_url + '/A2')
+  for i in range(3, 7):
+    svntest.actions.run_and_verify_svn(None, None, [],
+                                       'mkdir', '-m', 'log_msg',
+                                       sbox.repo_url + '/dir%d' % i)
+
+  for args in [[], ['--incremental', '-r', '2:6'], ['--deltas']]:
+    exit_code, expected, errput = svntest.main.run_svnadmin(
+      'dump', '--quiet', sbox.repo_dir, *args)
+    exit_code, output, errput = svntest.main.run_svnadmin(
+      'dump', '--quiet', '--jobs', '3', sbox.repo_dir, *args)
+    svntest.verify.compare_and_display_lines(
+      "Error comparing 'svnadmin dump --jobs' output.", 'DUMP',
+      expected, output)
+
+def hotcopy_incremental(sbox):
+  "'svnadmin hotcopy --incremental' updates a copy"
+
+  sbox.build(create_wc = False)
+  backup_dir, backup_url = sbox.add_repo_path('backup')
+
+  svntest.actions.run_and_verify_svnadmin(None, None, [],
+                                          'hotcopy', '--incremental',
+                                          sbox.repo_dir, backup_dir)
+
+  # Create r2 through r4, change a revprop of r1 and pack whatever the
+  # sharding allows to pack.
+  for i in range(2, 5):
+    svntest.actions.run_and_verify_svn(None, None, [],
+                                       'mkdir', '-m', 'log_msg',
+                                       sbox.repo_url + '/dir%d' % i)
+  svntest.actions.enable_revprop_changes(sbox.repo_dir)
+  svntest.actions.run_and_verify_svn(None, None, [],
+                                     'propset', '--revprop', '-r', '1',
+                                     'svn:log', 'new log', sbox.repo_url)
+  svntest.actions.run_and_verify_svnadmin(None, None, [],
+                                          'pack', sbox.repo_dir)
+
+  svntest.actions.run_and_verify_svnadmin(None, None, [],
+                                          'hotcopy', '--incremental',
+                                          sbox.repo_dir, backup_dir)
+
+  exit_code, expected, errput = svntest.main.run_svnadmin(
+    'dump', '--quiet', sbox.repo_dir)
+  exit_code, output, errput = svntest.main.run_svnadmin(
+    'dump', '--quiet', backup_dir)
+  svntest.verify.compare_and_display_lines(
+    "Error comparing the incremental hotcopy to its source.", 'DUMP',
+    expected, output)
+
 ########################################################################
 # Run the tests
 
@@ -1246,6 +1342,10 @@ test_list = [ None,
                          svntest.main.is_fs_type_fsfs),
               XFail(dont_drop_valid_mergeinfo_during_incremental_loads),
               SkipUnless(hotcopy_symlink, svntest.main.is_posix_os),
+              verify_with_jobs,
+              load_with_jobs,
+              dump_with_jobs,
+              SkipUnless(hotcopy_incremental, svntest.main.is_fs_type_fsfs),
              ]
 
 if __name__ == '__main__':
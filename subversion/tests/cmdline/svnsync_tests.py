@@ -55,18 +55,18 @@ def build_repos(sbox):
   svntest.main.create_repos(sbox.repo_dir)
 
 
-def run_sync(url, source_url=None, expected_error=None):
+def run_sync(url, source_url=None, expected_error=None, *args):
   "Synchronize the mirror repository with the master"
   if source_url is not None:
     exit_code, output, errput = svntest.main.run_svnsync(
       "synchronize", url, source_url,
       "--username", svntest.main.wc_author,
-      "--password", svntest.main.wc_passwd)
+      "--password", svntest.main.wc_passwd, *args)
   else: # Allow testing of old source-URL-less syntax
     exit_code, output, errput = svntest.main.run_svnsync(
       "synchronize", url,
       "--username", svntest.main.wc_author,
-      "--password", svntest.main.wc_passwd)
+      "--password", svntest.main.wc_passwd, *args)
   if errput:
     if expected_error is None:
       raise SVNUnexpectedStderr(errput)
@@ -136,9 +136,11 @@ def run_info(url, expected_error=None):
     raise SVNUnexpectedStdout("Missing stdout")
 
 
-def run_test(sbox, dump_file_name, subdir = None, exp_dump_file_name = None):
+def run_test(sbox, dump_file_name, subdir = None, exp_dump_file_name = None,
+             direct_fs = False):
   """Load a dump file, sync repositories, and compare contents with the original
-or another dump file."""
+or another dump file.  If DIRECT_FS is true, sync straight into the
+destination's filesystem."""
 
   # Create the empty master repository.
   build_repos(sbox)
@@ -170,7 +172,13 @@ or another dump file."""
     repo_url = repo_url + subdir
   run_init(dest_sbox.repo_url, repo_url)
 
-  run_sync(dest_sbox.repo_url, repo_url)
+  if direct_fs:
+    # --direct-fs needs a file:// URL, whatever RA layer is being tested.
+    dest_file_url = svntest.main.test_area_url + '/' \
+                      + svntest.main.pathname2url(dest_sbox.repo_dir)
+    run_sync(dest_file_url, repo_url, None, "--direct-fs")
+  else:
+    run_sync(dest_sbox.repo_url, repo_url)
   run_copy_revprops(dest_sbox.repo_url, repo_url)
 
   # Remove some SVNSync-specific housekeeping properties from the
@@ -775,6 +783,14 @@ def commit_a_copy_of_root(sbox):
   #Testcase for issue 3438.
   run_test(sbox, "repo_with_copy_of_root_dir.dump")
 
+def direct_fs_revprops(sbox):
+  "sync revprops straight into the destination fs"
+  run_test(sbox, "revprops.dump", direct_fs=True)
+
+def direct_fs_no_author(sbox):
+  "sync revs with no svn:author into the dest fs"
+  run_test(sbox, "no-author.dump", direct_fs=True)
+
 
 ########################################################################
 # Run the tests
@@ -815,6 +831,8 @@ test_list = [ None,
               copy_bad_line_endings,
               delete_svn_props,
               commit_a_copy_of_root,
+              direct_fs_revprops,
+              direct_fs_no_author,
              ]
 
 if __name__ == '__main__':
@@ -36,6 +36,7 @@
 #include "svn_delta.h"
 #include "svn_pools.h"
 #include "svn_error.h"
+#include "private/svn_delta_private.h"
 
 #include "../../libsvn_delta/delta.h"
 #include "delta-window-test.h"
@@ -284,9 +285,16 @@ copy_tempfile(apr_file_t *fp, apr_pool_t *pool)
 
 
 
-/* Implements svn_test_driver_t. */
+/* Run the random delta test, creating deltas with windows of
+   WINDOW_SIZE bytes and files up to MAXLEN_FACTOR times the configured
+   maximum length.  The svndiff data is compressed at COMPRESSION_LEVEL
+   and parsed back with DECODE_CONCURRENTLY.  Use POOL for allocations. */
 static svn_error_t *
-random_test(apr_pool_t *pool)
+do_random_test(apr_size_t window_size,
+               apr_uint32_t maxlen_factor,
+               int compression_level,
+               svn_boolean_t decode_concurrently,
+               apr_pool_t *pool)
 {
   apr_uint32_t seed, bytes_range, maxlen;
   int i, iterations, dump_files, print_windows;
@@ -296,6 +304,7 @@ random_test(apr_pool_t *pool)
      or something. */
   init_params(&seed, &maxlen, &iterations, &dump_files, &print_windows,
               &random_bytes, &bytes_range, pool);
+  maxlen *= maxlen_factor;
 
   for (i = 0; i < iterations; i++)
     {
@@ -327,18 +336,18 @@ random_test(apr_pool_t *pool)
                         NULL, NULL, delta_pool, &handler, &handler_baton);
 
       /* Make stage 3: reparse the text delta.  */
-      stream = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE,
-                                         delta_pool);
+      stream = svn_txdelta_parse_svndiff2(handler, handler_baton, TRUE,
+                                          decode_concurrently, delta_pool);
 
       /* Make stage 2: encode the text delta in svndiff format.  */
-      svn_txdelta_to_svndiff2(&handler, &handler_baton, stream, 1,
-                              delta_pool);
+      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream, 1,
+                              compression_level, delta_pool);
 
       /* Make stage 1: create the text delta.  */
-      svn_txdelta(&txdelta_stream,
-                  svn_stream_from_aprfile(source, delta_pool),
-                  svn_stream_from_aprfile(target, delta_pool),
-                  delta_pool);
+      svn_txdelta2(&txdelta_stream,
+                   svn_stream_from_aprfile(source, delta_pool),
+                   svn_stream_from_aprfile(target, delta_pool),
+                   window_size, delta_pool);
 
       SVN_ERR(svn_txdelta_send_txstream(txdelta_stream,
                                         handler,
@@ -358,6 +367,53 @@ random_test(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_test(apr_pool_t *pool)
+{
+  return do_random_test(SVN_DELTA_DEFAULT_WINDOW_SIZE, 1,
+                        SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, FALSE, pool);
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_small_window_test(apr_pool_t *pool)
+{
+  return do_random_test(8 * 1024, 1, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                        FALSE, pool);
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_large_window_test(apr_pool_t *pool)
+{
+  return do_random_test(4 * SVN_DELTA_DEFAULT_WINDOW_SIZE, 8,
+                        SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, FALSE, pool);
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_uncompressed_test(apr_pool_t *pool)
+{
+  return do_random_test(SVN_DELTA_DEFAULT_WINDOW_SIZE, 1,
+                        SVN_DELTA_COMPRESSION_LEVEL_NONE, FALSE, pool);
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_fast_compression_test(apr_pool_t *pool)
+{
+  return do_random_test(SVN_DELTA_DEFAULT_WINDOW_SIZE, 1, 1, FALSE, pool);
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_concurrent_decoding_test(apr_pool_t *pool)
+{
+  return do_random_test(8 * 1024, 1, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                        TRUE, pool);
+}
+
 
 
 /* (Note: *LAST_SEED is an output parameter.) */
@@ -498,6 +554,108 @@ random_combine_test(apr_pool_t *pool)
 }
 
 
+/* Return TRUE if the delta windows A and B are identical. */
+static svn_boolean_t
+windows_equal(const svn_txdelta_window_t *a, const svn_txdelta_window_t *b)
+{
+  int i;
+
+  if (a->sview_offset != b->sview_offset
+      || a->sview_len != b->sview_len
+      || a->tview_len != b->tview_len
+      || a->num_ops != b->num_ops
+      || a->src_ops != b->src_ops
+      || a->new_data->len != b->new_data->len
+      || memcmp(a->new_data->data, b->new_data->data, a->new_data->len))
+    return FALSE;
+
+  for (i = 0; i < a->num_ops; i++)
+    if (a->ops[i].action_code != b->ops[i].action_code
+        || a->ops[i].offset != b->ops[i].offset
+        || a->ops[i].length != b->ops[i].length)
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Implements svn_test_driver_t.  Compose the windows of random delta
+   pairs both with svn_txdelta_compose_windows() and with a composition
+   context reused across all of them, and check that both give the same
+   results. */
+static svn_error_t *
+compose_context_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed, bytes_range, maxlen;
+  int i, iterations, dump_files, print_windows;
+  const char *random_bytes;
+  svn_txdelta__compose_ctx_t *ctx = svn_txdelta__compose_ctx_create(pool);
+
+  init_params(&seed, &maxlen, &iterations, &dump_files, &print_windows,
+              &random_bytes, &bytes_range, pool);
+
+  for (i = 0; i < iterations; i++)
+    {
+      apr_uint32_t subseed_base = svn_test_rand(&seed);
+      apr_pool_t *delta_pool = svn_pool_create(pool);
+      apr_pool_t *wpool = svn_pool_create(delta_pool);
+      apr_file_t *source = generate_random_file(maxlen, subseed_base, &seed,
+                                                random_bytes, bytes_range,
+                                                dump_files, delta_pool);
+      apr_file_t *middle = generate_random_file(maxlen, subseed_base, &seed,
+                                                random_bytes, bytes_range,
+                                                dump_files, delta_pool);
+      apr_file_t *target = generate_random_file(maxlen, subseed_base, &seed,
+                                                random_bytes, bytes_range,
+                                                dump_files, delta_pool);
+      apr_file_t *middle_copy = copy_tempfile(middle, delta_pool);
+      svn_txdelta_stream_t *txdelta_stream_A;
+      svn_txdelta_stream_t *txdelta_stream_B;
+
+      svn_txdelta(&txdelta_stream_A,
+                  svn_stream_from_aprfile(source, delta_pool),
+                  svn_stream_from_aprfile(middle, delta_pool),
+                  delta_pool);
+      svn_txdelta(&txdelta_stream_B,
+                  svn_stream_from_aprfile(middle_copy, delta_pool),
+                  svn_stream_from_aprfile(target, delta_pool),
+                  delta_pool);
+
+      while (TRUE)
+        {
+          svn_txdelta_window_t *window_A, *window_B;
+          svn_txdelta_window_t *plain, *reused;
+
+          svn_pool_clear(wpool);
+          SVN_ERR(svn_txdelta_next_window(&window_A, txdelta_stream_A,
+                                          wpool));
+          SVN_ERR(svn_txdelta_next_window(&window_B, txdelta_stream_B,
+                                          wpool));
+          if (!window_A || !window_B)
+            break;
+          if (window_B->src_ops == 0)
+            continue;
+
+          plain = svn_txdelta_compose_windows(window_A, window_B, wpool);
+          reused = svn_txdelta__compose_windows(window_A, window_B, ctx,
+                                                wpool);
+          if (!windows_equal(plain, reused))
+            return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                     "Composed windows differ "
+                                     "(seed %lu)",
+                                     (unsigned long) subseed_base);
+        }
+
+      apr_file_close(source);
+      apr_file_close(middle);
+      apr_file_close(target);
+      apr_file_close(middle_copy);
+      svn_pool_destroy(delta_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Change to 1 to enable the unit test for the delta combiner's range index: */
 #if 0
 #include "range-index-test.h"
@@ -514,6 +672,18 @@ struct svn_test_descriptor_t test_funcs[] =
                    "random delta test"),
     SVN_TEST_PASS2(random_combine_test,
                    "random combine delta test"),
+    SVN_TEST_PASS2(random_small_window_test,
+                   "random delta test with small windows"),
+    SVN_TEST_PASS2(random_large_window_test,
+                   "random delta test with large windows"),
+    SVN_TEST_PASS2(random_uncompressed_test,
+                   "random delta test without compression"),
+    SVN_TEST_PASS2(random_fast_compression_test,
+                   "random delta test with fast compression"),
+    SVN_TEST_PASS2(random_concurrent_decoding_test,
+                   "random delta test decoding on a separate thread"),
+    SVN_TEST_PASS2(compose_context_test,
+                   "compose windows with a reused context"),
 #ifdef SVN_RANGE_INDEX_TEST_H
     SVN_TEST_PASS2(random_range_index_test,
                    "random range index test"),
@@ -2271,6 +2271,195 @@ merge_adjacent_changes(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Return the lines "line FIRST\n" up to and including "line LAST\n",
+   allocated in POOL. */
+static const char *
+numbered_lines(int first, int last, apr_pool_t *pool)
+{
+  svn_stringbuf_t *lines = svn_stringbuf_create("", pool);
+  int i;
+
+  for (i = first; i <= last; i++)
+    svn_stringbuf_appendcstr(lines, apr_psprintf(pool, "line %d\n", i));
+
+  return lines->data;
+}
+
+/* Files that differ only in the middle of a long run of identical lines.
+   The file diffs skip those lines, so this checks that they still produce
+   the same output as the in-memory diffs, which don't. */
+static svn_error_t *
+identical_prefix_and_suffix(apr_pool_t *pool)
+{
+  const char *prefix = numbered_lines(1, 200, pool);
+  const char *suffix = numbered_lines(206, 400, pool);
+
+  SVN_ERR(two_way_diff("pfx1", "pfx2",
+                       apr_pstrcat(pool, prefix,
+                                   "a\n" "b\n" "c\n" "d\n" "e\n",
+                                   suffix, (char *)NULL),
+                       apr_pstrcat(pool, prefix,
+                                   "a\n" "B\n" "c\n" "d\n" "e\n" "f\n",
+                                   suffix, (char *)NULL),
+
+                       "--- pfx1"               NL
+                       "+++ pfx2"               NL
+                       "@@ -199,10 +199,11 @@" NL
+                       " line 199\n"
+                       " line 200\n"
+                       " a\n"
+                       "-b\n"
+                       "+B\n"
+                       " c\n"
+                       " d\n"
+                       " e\n"
+                       "+f\n"
+                       " line 206\n"
+                       " line 207\n"
+                       " line 208\n",
+                       NULL, pool));
+
+  SVN_ERR(three_way_merge("pfx3", "pfx4", "pfx5",
+                          apr_pstrcat(pool, prefix,
+                                      "a\n" "b\n" "c\n" "d\n" "e\n",
+                                      suffix, (char *)NULL),
+                          apr_pstrcat(pool, prefix,
+                                      "a\n" "B\n" "c\n" "d\n" "e\n",
+                                      suffix, (char *)NULL),
+                          apr_pstrcat(pool, prefix,
+                                      "a\n" "b\n" "c\n" "d\n" "E\n",
+                                      suffix, (char *)NULL),
+                          apr_pstrcat(pool, prefix,
+                                      "a\n" "B\n" "c\n" "d\n" "E\n",
+                                      suffix, (char *)NULL),
+                          NULL,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  SVN_ERR(three_way_merge("pfx6", "pfx7", "pfx8",
+                          apr_pstrcat(pool, prefix,
+                                      "a\n" "b\n" "c\n",
+                                      suffix, (char *)NULL),
+                          apr_pstrcat(pool, prefix,
+                                      "a\n" "x\n" "c\n",
+                                      suffix, (char *)NULL),
+                          apr_pstrcat(pool, prefix,
+                                      "a\n" "y\n" "c\n",
+                                      suffix, (char *)NULL),
+                          apr_pstrcat(pool, prefix,
+                                      "a\n"
+                                      "<<<<<<< pfx7\n"
+                                      "x\n"
+                                      "=======\n"
+                                      "y\n"
+                                      ">>>>>>> pfx8\n"
+                                      "c\n",
+                                      suffix, (char *)NULL),
+                          NULL,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  /* Only a prefix, and only a suffix. */
+  SVN_ERR(three_way_merge("pfx9", "pfx10", "pfx11",
+                          prefix,
+                          apr_pstrcat(pool, prefix, "a\n", (char *)NULL),
+                          prefix,
+                          apr_pstrcat(pool, prefix, "a\n", (char *)NULL),
+                          NULL,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  SVN_ERR(three_way_merge("pfx12", "pfx13", "pfx14",
+                          suffix,
+                          suffix,
+                          apr_pstrcat(pool, "a\n", suffix, (char *)NULL),
+                          apr_pstrcat(pool, "a\n", suffix, (char *)NULL),
+                          NULL,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Files with many repeated lines, diffed with the histogram algorithm. */
+static svn_error_t *
+test_histogram_diff(apr_pool_t *pool)
+{
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+  apr_array_header_t *args = apr_array_make(pool, 1, sizeof(const char *));
+
+  APR_ARRAY_PUSH(args, const char *) = "--histogram";
+  SVN_ERR(svn_diff_file_options_parse(diff_opts, args, pool));
+  if (diff_opts->algorithm != svn_diff_file_algorithm_histogram)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "--histogram didn't select the histogram diff");
+
+  /* The unique lines anchor the diff, so the new block is reported as
+     inserted in front of the "b" block. */
+  SVN_ERR(two_way_diff("hist1", "hist2",
+                       "{\n"
+                       "a\n"
+                       "}\n"
+                       "{\n"
+                       "b\n"
+                       "}\n",
+
+                       "{\n"
+                       "a\n"
+                       "}\n"
+                       "{\n"
+                       "c\n"
+                       "}\n"
+                       "{\n"
+                       "b\n"
+                       "}\n",
+
+                       "--- hist1"          NL
+                       "+++ hist2"          NL
+                       "@@ -2,5 +2,8 @@"    NL
+                       " a\n"
+                       " }\n"
+                       " {\n"
+                       "+c\n"
+                       "+}\n"
+                       "+{\n"
+                       " b\n"
+                       " }\n",
+                       diff_opts, pool));
+
+  SVN_ERR(three_way_merge("hist3", "hist4", "hist5",
+                          "{\n" "a\n" "}\n"
+                          "{\n" "b\n" "}\n"
+                          "{\n" "c\n" "}\n",
+
+                          "{\n" "A\n" "}\n"
+                          "{\n" "b\n" "}\n"
+                          "{\n" "c\n" "}\n",
+
+                          "{\n" "a\n" "}\n"
+                          "{\n" "b\n" "}\n"
+                          "{\n" "C\n" "}\n",
+
+                          "{\n" "A\n" "}\n"
+                          "{\n" "b\n" "}\n"
+                          "{\n" "C\n" "}\n",
+                          diff_opts,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  /* Nothing but repeated lines. */
+  SVN_ERR(three_way_merge("hist6", "hist7", "hist8",
+                          "x\n" "x\n" "y\n" "x\n" "y\n",
+                          "x\n" "y\n" "x\n" "y\n",
+                          "x\n" "x\n" "y\n" "x\n" "y\n",
+                          "x\n" "y\n" "x\n" "y\n",
+                          diff_opts,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* ========================================================================== */
@@ -2300,5 +2489,9 @@ struct svn_test_descriptor_t test_funcs[] =
                    "3-way merge, adjacent changes"),
     SVN_TEST_PASS2(test_three_way_merge_conflict_styles,
                    "3-way merge with conflict styles"),
+    SVN_TEST_PASS2(identical_prefix_and_suffix,
+                   "diff with identical prefix and suffix"),
+    SVN_TEST_PASS2(test_histogram_diff,
+                   "diff with the histogram algorithm"),
     SVN_TEST_NULL
   };
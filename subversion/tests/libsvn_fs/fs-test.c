@@ -34,6 +34,7 @@
 #include "svn_checksum.h"
 #include "svn_mergeinfo.h"
 #include "svn_props.h"
+#include "svn_path.h"
 
 #include "private/svn_fs_private.h"
 
@@ -4749,6 +4750,500 @@ obliterate_1(const svn_test_opts_t *opts,
                           "Feature and test are still under development");
 }
 
+/* Look up paths in several roots of the same revision, such that later
+   lookups may start at nodes found through earlier roots. */
+static svn_error_t *
+revision_root_paths(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t youngest_rev;
+  svn_node_kind_t kind;
+  svn_filesize_t length;
+  svn_error_t *err;
+  int i;
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-revision-root-paths",
+                              opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+
+  for (i = 0; i < 2; i++)
+    {
+      SVN_ERR(svn_fs_revision_root(&root, fs, youngest_rev, pool));
+
+      SVN_ERR(svn_fs_check_path(&kind, root, "A/D/G/rho", pool));
+      SVN_TEST_ASSERT(kind == svn_node_file);
+      SVN_ERR(svn_fs_check_path(&kind, root, "/A/D/G/pi", pool));
+      SVN_TEST_ASSERT(kind == svn_node_file);
+      SVN_ERR(svn_fs_check_path(&kind, root, "A/D/H", pool));
+      SVN_TEST_ASSERT(kind == svn_node_dir);
+      SVN_ERR(svn_fs_check_path(&kind, root, "/", pool));
+      SVN_TEST_ASSERT(kind == svn_node_dir);
+      SVN_ERR(svn_fs_check_path(&kind, root, "A/D/G/zeta", pool));
+      SVN_TEST_ASSERT(kind == svn_node_none);
+
+      err = svn_fs_file_length(&length, root, "A/D/G/rho/zeta", pool);
+      SVN_TEST_ASSERT(err && err->apr_err == SVN_ERR_FS_NOT_DIRECTORY);
+      svn_error_clear(err);
+
+      err = svn_fs_file_length(&length, root, "A/D/Z/zeta", pool);
+      SVN_TEST_ASSERT(err && err->apr_err == SVN_ERR_FS_NOT_FOUND);
+      svn_error_clear(err);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Look up many paths at once and compare the results with those of
+   single-path lookups. */
+static svn_error_t *
+check_paths(const svn_test_opts_t *opts,
+            apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  apr_array_header_t *paths;
+  int i, j;
+  static const char *const path_list[] =
+    {
+      "A/D/G/rho", "/A/D/H/psi", "iota", "/A/D/G/zeta", "A/D/G",
+      "A/D/G/rho/zeta", "/", "A/B/E/alpha", "A-", "A/D/H/psi",
+      "A/C", "Z/Y/X", "A/D/H/omega", "", NULL
+    };
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-check-paths", opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A-", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D/H/psi", pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "Z", pool));
+
+  paths = apr_array_make(pool, 0, sizeof(const char *));
+  for (i = 0; path_list[i]; i++)
+    APR_ARRAY_PUSH(paths, const char *) = path_list[i];
+
+  for (j = 0; j < 2; j++)
+    {
+      svn_fs_root_t *root = j ? txn_root : rev_root;
+      apr_array_header_t *kinds, *ids;
+
+      SVN_ERR(svn_fs_check_paths(&kinds, &ids, root, paths, pool));
+      SVN_TEST_ASSERT(kinds->nelts == paths->nelts);
+      SVN_TEST_ASSERT(ids->nelts == paths->nelts);
+
+      for (i = 0; i < paths->nelts; i++)
+        {
+          const char *path = APR_ARRAY_IDX(paths, i, const char *);
+          svn_node_kind_t kind = APR_ARRAY_IDX(kinds, i, svn_node_kind_t);
+          const svn_fs_id_t *id = APR_ARRAY_IDX(ids, i, const svn_fs_id_t *);
+          svn_node_kind_t expected_kind;
+          const svn_fs_id_t *expected_id;
+
+          SVN_ERR(svn_fs_check_path(&expected_kind, root, path, pool));
+          if (kind != expected_kind)
+            return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                     "wrong kind for '%s'", path);
+
+          if (expected_kind == svn_node_none)
+            {
+              SVN_TEST_ASSERT(id == NULL);
+              continue;
+            }
+
+          SVN_ERR(svn_fs_node_id(&expected_id, root, path, pool));
+          if (! id || svn_fs_compare_ids(id, expected_id) != 0)
+            return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                     "wrong node id for '%s'", path);
+        }
+
+      /* Spot-check a few results against the tree itself. */
+      SVN_TEST_ASSERT(APR_ARRAY_IDX(kinds, 0, svn_node_kind_t)
+                      == svn_node_file);
+      SVN_TEST_ASSERT(APR_ARRAY_IDX(kinds, 5, svn_node_kind_t)
+                      == svn_node_none);
+      SVN_TEST_ASSERT(APR_ARRAY_IDX(kinds, 6, svn_node_kind_t)
+                      == svn_node_dir);
+      SVN_TEST_ASSERT(APR_ARRAY_IDX(kinds, 11, svn_node_kind_t)
+                      == svn_node_none);
+      SVN_TEST_ASSERT(APR_ARRAY_IDX(kinds, 1, svn_node_kind_t)
+                      == (j ? svn_node_none : svn_node_file));
+    }
+
+  /* Node IDs are optional, and so are paths. */
+  {
+    apr_array_header_t *kinds;
+
+    SVN_ERR(svn_fs_check_paths(&kinds, NULL, rev_root, paths, pool));
+    SVN_TEST_ASSERT(kinds->nelts == paths->nelts);
+    SVN_TEST_ASSERT(APR_ARRAY_IDX(kinds, 2, svn_node_kind_t)
+                    == svn_node_file);
+
+    apr_array_clear(paths);
+    SVN_ERR(svn_fs_check_paths(&kinds, NULL, rev_root, paths, pool));
+    SVN_TEST_ASSERT(kinds->nelts == 0);
+  }
+
+  return SVN_NO_ERROR;
+}
+
+/* Compare the changes svn_fs_paths_changed_iterator() returns for ROOT
+   with those of svn_fs_paths_changed2(). */
+static svn_error_t *
+verify_changes_iteration(svn_fs_root_t *root,
+                         apr_pool_t *pool)
+{
+  apr_hash_t *expected;
+  svn_fs_path_change_iterator_t *iterator;
+  const char *path, *prev_path = NULL;
+  svn_fs_path_change2_t *change;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  unsigned int count = 0;
+
+  SVN_ERR(svn_fs_paths_changed2(&expected, root, pool));
+  SVN_ERR(svn_fs_paths_changed_iterator(&iterator, root, pool));
+
+  while (TRUE)
+    {
+      svn_fs_path_change2_t *expected_change;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_path_change_get(&path, &change, iterator, iterpool));
+      if (! path)
+        break;
+
+      expected_change = apr_hash_get(expected, path, APR_HASH_KEY_STRING);
+      if (! expected_change)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "unexpected change of '%s'", path);
+
+      if (change->change_kind != expected_change->change_kind
+          || change->text_mod != expected_change->text_mod
+          || change->prop_mod != expected_change->prop_mod
+          || change->node_kind != expected_change->node_kind
+          || svn_fs_compare_ids(change->node_rev_id,
+                                expected_change->node_rev_id) != 0)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "wrong change of '%s'", path);
+
+      if (change->copyfrom_known && expected_change->copyfrom_known
+          && (change->copyfrom_rev != expected_change->copyfrom_rev
+              || (change->copyfrom_path == NULL)
+                  != (expected_change->copyfrom_path == NULL)
+              || (change->copyfrom_path
+                  && strcmp(change->copyfrom_path,
+                            expected_change->copyfrom_path) != 0)))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "wrong copyfrom of '%s'", path);
+
+      if (prev_path && svn_path_compare_paths(prev_path, path) >= 0)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "'%s' returned after '%s'",
+                                 path, prev_path);
+
+      prev_path = apr_pstrdup(pool, path);
+      count++;
+    }
+
+  if (count != apr_hash_count(expected))
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "got %u changes instead of %u",
+                             count, apr_hash_count(expected));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+paths_changed_iterator(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-paths-changed-iterator",
+                              opts, pool));
+
+  /* Revision 1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(verify_changes_iteration(rev_root, pool));
+
+  /* Revision 2: all kinds of changes, some of them made in more than
+     one step. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A", txn_root, "A2", pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A2/C", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A2/mu", "new mu\n", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "new iota\n", pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "iota", "prop",
+                                  svn_string_create("value", pool), pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D", "prop",
+                                  svn_string_create("value", pool), pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/B/lambda", pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A/B/lambda", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/B/lambda/zeta", pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/C", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A-", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/D/G/ephemeral", pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D/G/ephemeral", pool));
+  SVN_ERR(verify_changes_iteration(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(verify_changes_iteration(rev_root, pool));
+
+  /* Revision 3: nothing at all. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(verify_changes_iteration(rev_root, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Skip to OFFSET in the contents of PATH under ROOT and check that the
+   next bytes read match EXPECTED, which holds the EXPECTED_LEN bytes of
+   the file's full contents. */
+static svn_error_t *
+check_skip(svn_fs_root_t *root,
+           const char *path,
+           apr_size_t offset,
+           const char *expected,
+           apr_size_t expected_len,
+           apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  apr_size_t len = offset;
+  apr_size_t want;
+  char buf[1000];
+
+  if (offset > expected_len)
+    offset = expected_len;
+
+  SVN_ERR(svn_fs_file_contents(&stream, root, path, pool));
+  SVN_ERR(svn_stream_skip(stream, &len));
+  if (len != offset)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "skipped %" APR_SIZE_T_FMT " bytes of '%s' "
+                             "instead of %" APR_SIZE_T_FMT,
+                             len, path, offset);
+
+  want = expected_len - offset;
+  if (want > sizeof(buf))
+    want = sizeof(buf);
+  len = sizeof(buf);
+  SVN_ERR(svn_stream_read(stream, buf, &len));
+  if (len != want || memcmp(buf, expected + offset, want) != 0)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "wrong data after skipping %" APR_SIZE_T_FMT
+                             " bytes of '%s'", offset, path);
+
+  return svn_stream_close(stream);
+}
+
+static svn_error_t *
+skip_in_file_contents(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_size_t filesize = 350000;
+  apr_uint32_t seed = 42;
+  svn_string_t contents[3];
+  apr_size_t offsets[] = { 0, 1, 102399, 102400, 150000, 204800, 349000,
+                           349999, 350000, 400000 };
+  int i, j;
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-skip-in-file-contents",
+                              opts, pool));
+
+  /* Three revisions of a file that spans several delta windows, the
+     later ones changed at the start, in the middle and at the end. */
+  for (i = 0; i < 3; i++)
+    {
+      char *data = apr_palloc(pool, filesize);
+      svn_txdelta_window_handler_t wh_func;
+      void *wh_baton;
+
+      if (i == 0)
+        random_data_to_buffer(data, filesize, TRUE, &seed);
+      else
+        {
+          memcpy(data, contents[i - 1].data, filesize);
+          random_data_to_buffer(data, 20, TRUE, &seed);
+          random_data_to_buffer(data + 160000, 20, TRUE, &seed);
+          random_data_to_buffer(data + filesize - 20, 20, TRUE, &seed);
+        }
+      contents[i].data = data;
+      contents[i].len = filesize;
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      if (i == 0)
+        SVN_ERR(svn_fs_make_file(txn_root, "bigfile", pool));
+      SVN_ERR(svn_fs_apply_textdelta(&wh_func, &wh_baton, txn_root,
+                                     "bigfile", NULL, NULL, pool));
+      SVN_ERR(svn_txdelta_send_string(&contents[i], wh_func, wh_baton,
+                                      pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+      SVN_ERR(svn_fs_deltify_revision(fs, youngest_rev, pool));
+    }
+
+  /* Skip to offsets within, at and across window boundaries. */
+  for (i = 0; i < 3; i++)
+    {
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i + 1, pool));
+      for (j = 0; j < (int) (sizeof(offsets) / sizeof(offsets[0])); j++)
+        SVN_ERR(check_skip(rev_root, "bigfile", offsets[j],
+                           contents[i].data, contents[i].len, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Check that svn_fs__dir_entries_sorted() returns the NUM_ENTRIES
+   entries of PATH in ROOT in strictly ascending name order. */
+static svn_error_t *
+check_dir_entries_sorted(svn_fs_root_t *root,
+                         const char *path,
+                         int num_entries,
+                         apr_pool_t *pool)
+{
+  apr_array_header_t *entries;
+  int i;
+
+  SVN_ERR(svn_fs__dir_entries_sorted(&entries, root, path, pool));
+  if (entries->nelts != num_entries)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "expected %d entries in '%s', got %d",
+                             num_entries, path, entries->nelts);
+
+  for (i = 1; i < entries->nelts; i++)
+    {
+      const svn_fs_dirent_t *prev = APR_ARRAY_IDX(entries, i - 1,
+                                                  svn_fs_dirent_t *);
+      const svn_fs_dirent_t *entry = APR_ARRAY_IDX(entries, i,
+                                                   svn_fs_dirent_t *);
+
+      if (strcmp(prev->name, entry->name) >= 0)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "'%s' listed before '%s' in '%s'",
+                                 prev->name, entry->name, path);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+dir_entries_sorted(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  int i;
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-dir-entries-sorted",
+                              opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+
+  /* A directory large enough to get sorted by radix, with plenty of
+     common prefixes, added in no particular order. */
+  SVN_ERR(svn_fs_make_dir(txn_root, "big", pool));
+  for (i = 0; i < 200; i++)
+    SVN_ERR(svn_fs_make_file(txn_root,
+                             apr_psprintf(pool, "big/file%s%d",
+                                          i % 2 ? "-" : "", (i * 37) % 200),
+                             pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "big/file", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "big/File", pool));
+
+  SVN_ERR(check_dir_entries_sorted(txn_root, "big", 202, pool));
+  SVN_ERR(check_dir_entries_sorted(txn_root, "A/D", 3, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+
+  /* Twice for revisions: reading the directory, then from the cache. */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  for (i = 0; i < 2; i++)
+    {
+      SVN_ERR(check_dir_entries_sorted(rev_root, "big", 202, pool));
+      SVN_ERR(check_dir_entries_sorted(rev_root, "A/D", 3, pool));
+      SVN_ERR(check_dir_entries_sorted(rev_root, "A/B/E", 2, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+compare_id_locations(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  const svn_fs_id_t *old_id, *new_id, *txn_id;
+  int expected;
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-compare-id-locations",
+                              opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "old", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "new", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_node_id(&old_id, rev_root, "old", pool));
+  SVN_ERR(svn_fs_node_id(&new_id, rev_root, "new", pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "txn", pool));
+  SVN_ERR(svn_fs_node_id(&txn_id, txn_root, "txn", pool));
+
+  /* Only FSFS stores node-revisions in revision files. */
+  expected = strcmp(opts->fs_type, "fsfs") == 0 ? -1 : 0;
+
+  if (svn_fs__compare_id_locations(old_id, old_id) != 0
+      || svn_fs__compare_id_locations(old_id, new_id) != expected
+      || svn_fs__compare_id_locations(new_id, old_id) != -expected
+      || svn_fs__compare_id_locations(new_id, txn_id) != expected
+      || svn_fs__compare_id_locations(txn_id, old_id) != -expected)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "node-revisions not ordered by location");
+
+  return SVN_NO_ERROR;
+}
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -4830,5 +5325,17 @@ struct svn_test_descriptor_t test_funcs[] =
                        "create and modify small file"),
     SVN_TEST_OPTS_WIMP(obliterate_1,
                        "obliterate 1", "obliterate is in development"),
+    SVN_TEST_OPTS_PASS(revision_root_paths,
+                       "look up paths in several revision roots"),
+    SVN_TEST_OPTS_PASS(check_paths,
+                       "look up many paths at once"),
+    SVN_TEST_OPTS_PASS(paths_changed_iterator,
+                       "iterate over changed paths in order"),
+    SVN_TEST_OPTS_PASS(skip_in_file_contents,
+                       "skip within file contents"),
+    SVN_TEST_OPTS_PASS(dir_entries_sorted,
+                       "list directory entries sorted by name"),
+    SVN_TEST_OPTS_PASS(compare_id_locations,
+                       "order node-revisions by storage location"),
     SVN_TEST_NULL
   };
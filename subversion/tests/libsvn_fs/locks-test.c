@@ -28,6 +28,7 @@
 
 #include "svn_error.h"
 #include "svn_fs.h"
+#include "private/svn_fs_private.h"
 
 #include "../svn_test_fs.h"
 
@@ -957,6 +958,128 @@ lock_out_of_date(const svn_test_opts_t *opts,
 }
 
 
+/* Baton for lock_many_callback(). */
+struct lock_many_baton_t
+{
+  /* Maps the paths locked or unlocked to their tokens, or to "" when
+     unlocking. */
+  apr_hash_t *done;
+
+  /* How many paths failed. */
+  int failed;
+};
+
+/* This implements svn_fs__lock_callback_t, recording the outcome in
+   BATON, a 'struct lock_many_baton_t *'. */
+static svn_error_t *
+lock_many_callback(void *baton,
+                   const char *path,
+                   const svn_lock_t *lock,
+                   svn_error_t *fs_err,
+                   apr_pool_t *pool)
+{
+  struct lock_many_baton_t *b = baton;
+  apr_pool_t *hash_pool = apr_hash_pool_get(b->done);
+
+  if (fs_err)
+    b->failed++;
+  else
+    apr_hash_set(b->done, apr_pstrdup(hash_pool, path), APR_HASH_KEY_STRING,
+                 lock ? apr_pstrdup(hash_pool, lock->token) : "");
+
+  return SVN_NO_ERROR;
+}
+
+/* Test that svn_fs__lock_many() and svn_fs__unlock_many() handle each
+   path on its own, and that svn_fs_get_locks() finds exactly the locks
+   below a path, and not those on a sibling whose name starts with the
+   same characters. */
+static svn_error_t *
+lock_many(const svn_test_opts_t *opts,
+          apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  const char *conflict;
+  svn_revnum_t newrev;
+  svn_fs_access_t *access;
+  apr_hash_t *targets;
+  apr_hash_index_t *hi;
+  struct lock_many_baton_t b;
+  struct get_locks_baton_t *get_locks_baton;
+  svn_fs__lock_target_t target;
+  const char *paths[] = { "/A/B/lambda", "/A/B/E/alpha", "/A/B-x", "/A/mu",
+                          "/A/B", "/A/nonexistent" };
+  apr_size_t i;
+
+  /* Prepare a filesystem and a new txn. */
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-lock-many", opts, pool));
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, 0, SVN_FS_TXN_CHECK_LOCKS, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+
+  /* Create the greek tree, plus a file next to /A/B whose name starts
+     with "B", and commit it. */
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/A/B-x", pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &newrev, txn, pool));
+
+  /* We are now 'bubba'. */
+  SVN_ERR(svn_fs_create_access(&access, "bubba", pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+
+  /* Lock four files, a directory and a path that doesn't exist. */
+  target.token = NULL;
+  target.current_rev = SVN_INVALID_REVNUM;
+  targets = apr_hash_make(pool);
+  for (i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+    apr_hash_set(targets, paths[i], APR_HASH_KEY_STRING, &target);
+
+  b.done = apr_hash_make(pool);
+  b.failed = 0;
+  SVN_ERR(svn_fs__lock_many(fs, targets, "", FALSE, 0, FALSE,
+                            lock_many_callback, &b, pool));
+  if (apr_hash_count(b.done) != 4 || b.failed != 2)
+    return svn_error_createf
+      (SVN_ERR_TEST_FAILED, NULL,
+       "Expected 4 paths locked and 2 failures, got %u and %d",
+       apr_hash_count(b.done), b.failed);
+
+  /* Only the locks below /A/B count as being under it. */
+  get_locks_baton = make_get_locks_baton(pool);
+  SVN_ERR(svn_fs_get_locks(fs, "/A/B", get_locks_callback,
+                           get_locks_baton, pool));
+  SVN_ERR(verify_matching_lock_paths(get_locks_baton, paths, 2, pool));
+
+  /* Unlock them all, again along with the directory and the missing
+     path. */
+  targets = apr_hash_make(pool);
+  for (hi = apr_hash_first(pool, b.done); hi; hi = apr_hash_next(hi))
+    apr_hash_set(targets, svn__apr_hash_index_key(hi), APR_HASH_KEY_STRING,
+                 svn__apr_hash_index_val(hi));
+  apr_hash_set(targets, "/A/B", APR_HASH_KEY_STRING, "");
+  apr_hash_set(targets, "/A/nonexistent", APR_HASH_KEY_STRING, "");
+
+  b.done = apr_hash_make(pool);
+  b.failed = 0;
+  SVN_ERR(svn_fs__unlock_many(fs, targets, FALSE, lock_many_callback, &b,
+                              pool));
+  if (apr_hash_count(b.done) != 4 || b.failed != 2)
+    return svn_error_createf
+      (SVN_ERR_TEST_FAILED, NULL,
+       "Expected 4 paths unlocked and 2 failures, got %u and %d",
+       apr_hash_count(b.done), b.failed);
+
+  get_locks_baton = make_get_locks_baton(pool);
+  SVN_ERR(svn_fs_get_locks(fs, "/", get_locks_callback,
+                           get_locks_baton, pool));
+  SVN_ERR(verify_matching_lock_paths(get_locks_baton, paths, 0, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+
 
 /* ------------------------------------------------------------------------ */
 
@@ -991,5 +1114,7 @@ struct svn_test_descriptor_t test_funcs[] =
                        "breaking, stealing, refreshing a lock"),
     SVN_TEST_OPTS_PASS(lock_out_of_date,
                        "check out-of-dateness before locking"),
+    SVN_TEST_OPTS_PASS(lock_many,
+                       "lock and unlock many paths at once"),
     SVN_TEST_NULL
   };
@@ -1465,6 +1465,64 @@ orphaned_textmod_change(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+
+static svn_error_t *
+group_commit(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t youngest_rev = 0;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  svn_stringbuf_t *contents;
+
+  /* Create a filesystem, and reopen it with group-committed trails. */
+  SVN_ERR(svn_test__create_bdb_fs(&fs, "test-repo-group-commit", opts,
+                                  subpool));
+  svn_pool_clear(subpool);
+  apr_hash_set(fs_config, SVN_FS_CONFIG_BDB_GROUP_COMMIT,
+               APR_HASH_KEY_STRING, "1");
+  SVN_ERR(svn_fs_open(&fs, "test-repo-group-commit", fs_config, subpool));
+
+  /* Revision 1:  Create and commit the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, subpool));
+
+  /* Revision 2:  Modify "iota". */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "group-committed iota\n", subpool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, subpool));
+
+  /* Leave a transaction behind, too. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_make_file(txn_root, "uncommitted", subpool));
+  svn_pool_clear(subpool);
+
+  /* Both revisions must be there when opening the filesystem normally. */
+  SVN_ERR(svn_fs_open(&fs, "test-repo-group-commit", NULL, subpool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, fs, subpool));
+  if (youngest_rev != 2)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Expected youngest revision 2, got %ld",
+                             youngest_rev);
+  SVN_ERR(svn_fs_revision_root(&root, fs, youngest_rev, subpool));
+  SVN_ERR(svn_test__get_file_contents(root, "iota", &contents, subpool));
+  if (strcmp(contents->data, "group-committed iota\n") != 0)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Unexpected contents of 'iota': '%s'",
+                             contents->data);
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -1492,5 +1550,7 @@ struct svn_test_descriptor_t test_funcs[] =
                        "ensure no-op for redundant copies"),
     SVN_TEST_OPTS_PASS(orphaned_textmod_change,
                        "test for orphaned textmod changed paths"),
+    SVN_TEST_OPTS_PASS(group_commit,
+                       "commit revisions with group-committed trails"),
     SVN_TEST_NULL
   };
@@ -729,6 +729,119 @@ copy_string(const svn_test_opts_t *opts,
 }
 
 
+/* Baton for txn_body_string_read(). */
+struct read_args
+{
+  svn_fs_t *fs;
+  const char *key;
+  svn_filesize_t offset;
+  char *buf;
+  apr_size_t len;
+};
+
+
+static svn_error_t *
+txn_body_string_read(void *baton, trail_t *trail)
+{
+  struct read_args *b = baton;
+  return svn_fs_bdb__string_read(b->fs, b->key, b->buf, b->offset, &b->len,
+                                 trail, trail->pool);
+}
+
+
+/* Read all of string KEY in FS from each offset in OFFSETS (terminated
+   by -1), and compare with EXPECTED. */
+static svn_error_t *
+verify_string_reads(svn_fs_t *fs,
+                    const char *key,
+                    const svn_stringbuf_t *expected,
+                    const svn_filesize_t *offsets,
+                    apr_pool_t *pool)
+{
+  struct read_args args;
+
+  args.fs = fs;
+  args.key = key;
+  args.buf = apr_palloc(pool, expected->len + 10);
+  for (; *offsets >= 0; offsets++)
+    {
+      /* Ask for more than there is. */
+      args.offset = *offsets;
+      args.len = expected->len - (apr_size_t) args.offset + 10;
+      SVN_ERR(svn_fs_base__retry_txn(fs, txn_body_string_read, &args,
+                                     FALSE, pool));
+
+      if (args.len != expected->len - (apr_size_t) args.offset)
+        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                 "read from offset %" SVN_FILESIZE_T_FMT
+                                 " returned %" APR_SIZE_T_FMT " bytes",
+                                 args.offset, args.len);
+      if (memcmp(args.buf, expected->data + args.offset, args.len) != 0)
+        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                 "read from offset %" SVN_FILESIZE_T_FMT
+                                 " returned unexpected contents",
+                                 args.offset);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+multi_record_string(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  struct string_args args;
+  svn_fs_t *fs;
+  svn_stringbuf_t *expected = svn_stringbuf_create("", pool);
+  svn_filesize_t offsets[6];
+  const char *old_key;
+  int i;
+
+  /* Create a new fs and repos */
+  SVN_ERR(svn_test__create_bdb_fs
+          (&fs, "test-repo-multi-record-string", opts,
+           pool));
+
+  /* Spread a string across many records of different sizes, including
+     empty ones and one too large for a single batch of records. */
+  args.fs = fs;
+  args.key = NULL;
+  for (i = 0; i < 200; i++)
+    {
+      apr_size_t len = (i == 100) ? 2000000 : (i * 37) % 1000;
+      char *text = apr_palloc(pool, len);
+
+      memset(text, 'a' + i % 26, len);
+      args.text = text;
+      args.len = len;
+      SVN_ERR(svn_fs_base__retry_txn(args.fs, txn_body_string_append, &args,
+                                     FALSE, pool));
+      svn_stringbuf_appendbytes(expected, text, len);
+    }
+
+  offsets[0] = 0;
+  offsets[1] = 1;
+  offsets[2] = 50000;
+  offsets[3] = expected->len - 100;
+  offsets[4] = expected->len;
+  offsets[5] = -1;
+  SVN_ERR(verify_string_reads(fs, args.key, expected, offsets, pool));
+
+  /* Copies must be complete, too. */
+  old_key = args.key;
+  SVN_ERR(svn_fs_base__retry_txn(args.fs, txn_body_string_copy, &args,
+                                 FALSE, pool));
+  if ((! args.key) || (! strcmp(old_key, args.key)))
+    return svn_error_create(SVN_ERR_FS_GENERAL, NULL,
+                            "copy of string failed to return new key");
+  SVN_ERR(verify_string_reads(fs, args.key, expected, offsets, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+
 
 /* The test table.  */
 
@@ -751,5 +864,7 @@ struct svn_test_descriptor_t test_funcs[] =
                        "write a string, then abort during an overwrite"),
     SVN_TEST_OPTS_PASS(copy_string,
                        "create and copy a string"),
+    SVN_TEST_OPTS_PASS(multi_record_string,
+                       "read and copy a string of many records"),
     SVN_TEST_NULL
   };
@@ -0,0 +1,541 @@
+/* fs-fs-bench.c --- time FSFS read and write hot paths
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* Each test here is a benchmark scenario rather than a correctness
+ * check.  Besides the usual PASS/FAIL line, every scenario prints one
+ * line per measurement of the form
+ *
+ *     BENCH <tab> scenario <tab> operations <tab> microseconds
+ *
+ * Run it with --fs-type=fsfs --quiet to get the measurements only.  The
+ * repositories are filled with the same pseudo-random data on every run,
+ * so results from different builds can be compared directly. */
+
+#include <stdio.h>
+#include <string.h>
+#include <apr_pools.h>
+#include <apr_strings.h>
+#include <apr_time.h>
+
+#include "../svn_test.h"
+#include "../../libsvn_fs_fs/fs.h"
+
+#include "svn_pools.h"
+#include "svn_path.h"
+#include "svn_fs.h"
+
+#include "../svn_test_fs.h"
+
+
+/*-----------------------------------------------------------------*/
+
+/** Helper routines. **/
+
+/* Print the result of a measurement: SCENARIO did OPS operations in
+   ELAPSED microseconds. */
+static void
+report(const char *scenario, int ops, apr_interval_time_t elapsed)
+{
+  printf("BENCH\t%s\t%d\t%" APR_TIME_T_FMT "\n", scenario, ops, elapsed);
+  fflush(stdout);
+}
+
+/* Return SIZE bytes of printable pseudo-random text, derived from SEED
+   alone, allocated in POOL. */
+static const char *
+make_contents(apr_size_t size, apr_uint32_t seed, apr_pool_t *pool)
+{
+  char *buf = apr_palloc(pool, size + 1);
+  apr_size_t i;
+
+  for (i = 0; i < size; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      buf[i] = (i % 64 == 63) ? '\n' : (char)('a' + (seed >> 16) % 26);
+    }
+  buf[size] = '\0';
+  return buf;
+}
+
+/* Bail out of the benchmarks that only make sense for FSFS. */
+static svn_error_t *
+require_fsfs(const svn_test_opts_t *opts)
+{
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "benchmarks only apply to FSFS");
+  return SVN_NO_ERROR;
+}
+
+/* Commit the transaction TXN in FS, setting *NEW_REV. */
+static svn_error_t *
+commit(svn_revnum_t *new_rev, svn_fs_txn_t *txn, apr_pool_t *pool)
+{
+  const char *conflict;
+
+  SVN_ERR(svn_fs_commit_txn(&conflict, new_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(*new_rev));
+  return SVN_NO_ERROR;
+}
+
+/* Read the file PATH in ROOT to its end, without keeping it. */
+static svn_error_t *
+read_file(svn_fs_root_t *root, const char *path, apr_pool_t *pool)
+{
+  svn_stream_t *contents;
+  char buf[SVN__STREAM_CHUNK_SIZE];
+  apr_size_t len;
+
+  SVN_ERR(svn_fs_file_contents(&contents, root, path, pool));
+  do
+    {
+      len = sizeof(buf);
+      SVN_ERR(svn_stream_read(contents, buf, &len));
+    }
+  while (len == sizeof(buf));
+
+  return svn_stream_close(contents);
+}
+
+/* Write the format number and maximum number of files per directory
+   to a new format file in PATH, overwriting a previously existing file.
+   This is the same as in fs-pack-test.c. */
+static svn_error_t *
+write_format(const char *path,
+             int format,
+             int max_files_per_dir,
+             apr_pool_t *pool)
+{
+  const char *contents = apr_psprintf(pool, "%d\nlayout sharded %d\n",
+                                      format, max_files_per_dir);
+  const char *path_tmp;
+
+  path = svn_path_join(path, "format", pool);
+  SVN_ERR(svn_io_write_unique(&path_tmp, svn_path_dirname(path, pool),
+                              contents, strlen(contents),
+                              svn_io_file_del_none, pool));
+#ifdef WIN32
+  SVN_ERR(svn_io_set_file_read_write(path, TRUE, pool));
+#endif /* WIN32 */
+  SVN_ERR(svn_io_file_rename(path_tmp, path, pool));
+
+  return svn_io_set_file_read_only(path, FALSE, pool);
+}
+
+
+/*-----------------------------------------------------------------*/
+
+/** The benchmarks. **/
+
+/* A file of DELTA_FILE_SIZE bytes, changed in DELTA_REVS revisions. */
+#define DELTA_FILE_SIZE 65536
+#define DELTA_REVS 500
+#define DELTA_READS 200
+
+/* Commit a long series of small changes to one file, so that its
+   representations form long delta chains, and read it back. */
+static svn_error_t *
+deep_delta_chain(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  char *contents;
+  apr_time_t start;
+  int i;
+
+  SVN_ERR(require_fsfs(opts));
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-bench-delta", opts, pool));
+
+  contents = apr_pstrdup(pool, make_contents(DELTA_FILE_SIZE, 1, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "file", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "file", contents, pool));
+  SVN_ERR(commit(&rev, txn, pool));
+
+  start = apr_time_now();
+  for (i = 0; i < DELTA_REVS; i++)
+    {
+      svn_pool_clear(iterpool);
+
+      /* Change a few bytes in a different place every time. */
+      memcpy(contents + (i * 7919) % (DELTA_FILE_SIZE - 16),
+             make_contents(15, i, iterpool), 15);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "file", contents, iterpool));
+      SVN_ERR(commit(&rev, txn, iterpool));
+    }
+  report("delta-chain-commit", DELTA_REVS, apr_time_now() - start);
+
+  start = apr_time_now();
+  for (i = 0; i < DELTA_READS; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(read_file(root, "file", iterpool));
+    }
+  report("delta-chain-read-head", DELTA_READS, apr_time_now() - start);
+
+  /* Every revision in turn, as 'svn blame' and 'svn log -v' would. */
+  start = apr_time_now();
+  for (i = 1; i <= rev; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, i, iterpool));
+      SVN_ERR(read_file(root, "file", iterpool));
+    }
+  report("delta-chain-read-all", (int) rev, apr_time_now() - start);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* A directory of HUGE_DIR_SIZE entries, to which HUGE_DIR_ADDS more are
+   added one commit at a time. */
+#define HUGE_DIR_SIZE 20000
+#define HUGE_DIR_ADDS 100
+#define HUGE_DIR_READS 50
+
+/* Create a directory with very many entries, change it, list it and
+   look up its entries. */
+static svn_error_t *
+huge_directory(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start;
+  int i;
+
+  SVN_ERR(require_fsfs(opts));
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-bench-dir", opts, pool));
+
+  start = apr_time_now();
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "dir", pool));
+  for (i = 0; i < HUGE_DIR_SIZE; i++)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "dir/file-%d", i);
+      SVN_ERR(svn_fs_make_file(root, path, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, path, path, iterpool));
+    }
+  SVN_ERR(commit(&rev, txn, pool));
+  report("huge-dir-create", HUGE_DIR_SIZE, apr_time_now() - start);
+
+  start = apr_time_now();
+  for (i = 0; i < HUGE_DIR_ADDS; i++)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "dir/added-%d", i);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      SVN_ERR(svn_fs_make_file(root, path, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, path, path, iterpool));
+      SVN_ERR(commit(&rev, txn, iterpool));
+    }
+  report("huge-dir-add-one", HUGE_DIR_ADDS, apr_time_now() - start);
+
+  start = apr_time_now();
+  for (i = 0; i < HUGE_DIR_READS; i++)
+    {
+      apr_hash_t *entries;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_fs_dir_entries(&entries, root, "dir", iterpool));
+      SVN_TEST_ASSERT(apr_hash_count(entries)
+                      == HUGE_DIR_SIZE + HUGE_DIR_ADDS);
+    }
+  report("huge-dir-list", HUGE_DIR_READS, apr_time_now() - start);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  start = apr_time_now();
+  for (i = 0; i < HUGE_DIR_SIZE; i++)
+    {
+      svn_node_kind_t kind;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_check_path(&kind, root,
+                                apr_psprintf(iterpool, "dir/file-%d", i),
+                                iterpool));
+      SVN_TEST_ASSERT(kind == svn_node_file);
+    }
+  report("huge-dir-lookup", HUGE_DIR_SIZE, apr_time_now() - start);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* PACK_REVS revisions in shards of PACK_SHARD_SIZE, each changing a file
+   of PACK_FILE_SIZE bytes. */
+#define PACK_SHARD_SIZE 100
+#define PACK_REVS 1000
+#define PACK_FILE_SIZE 4096
+
+/* Read every revision of FS up to YOUNGEST, reporting it as SCENARIO. */
+static svn_error_t *
+read_all_revisions(svn_fs_t *fs,
+                   svn_revnum_t youngest,
+                   const char *scenario,
+                   apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start = apr_time_now();
+  svn_revnum_t rev;
+
+  for (rev = 1; rev <= youngest; rev++)
+    {
+      svn_fs_root_t *root;
+      apr_hash_t *changes;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_fs_paths_changed2(&changes, root, iterpool));
+      SVN_ERR(read_file(root, "file", iterpool));
+    }
+  report(scenario, (int) youngest, apr_time_now() - start);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Read the same revisions from a sharded repository before and after
+   packing it. */
+static svn_error_t *
+packed_vs_unpacked(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  const char *dir = "test-repo-bench-pack";
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev = 0;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start;
+
+  SVN_ERR(require_fsfs(opts));
+  if (opts->server_minor_version && opts->server_minor_version < 6)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "packing needs FSFS format 4");
+
+  SVN_ERR(svn_test__create_fs(&fs, dir, opts, subpool));
+  svn_pool_clear(subpool);
+  SVN_ERR(write_format(dir, SVN_FS_FS__FORMAT_NUMBER, PACK_SHARD_SIZE,
+                       subpool));
+  SVN_ERR(svn_fs_open(&fs, dir, NULL, subpool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, subpool));
+  SVN_ERR(svn_fs_make_file(root, "file", subpool));
+  SVN_ERR(commit(&rev, txn, subpool));
+
+  while (rev < PACK_REVS)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "file",
+                                          make_contents(PACK_FILE_SIZE,
+                                                        (apr_uint32_t) rev,
+                                                        iterpool),
+                                          iterpool));
+      SVN_ERR(commit(&rev, txn, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Read through a freshly opened filesystem each time, so that the
+     caches start out cold. */
+  svn_pool_clear(subpool);
+  SVN_ERR(svn_fs_open(&fs, dir, NULL, subpool));
+  SVN_ERR(read_all_revisions(fs, rev, "read-unpacked", subpool));
+
+  svn_pool_clear(subpool);
+  start = apr_time_now();
+  SVN_ERR(svn_fs_pack2(dir, 1, NULL, NULL, NULL, NULL, subpool));
+  report("pack", (int) rev / PACK_SHARD_SIZE, apr_time_now() - start);
+
+  svn_pool_clear(subpool);
+  SVN_ERR(svn_fs_open(&fs, dir, NULL, subpool));
+  SVN_ERR(read_all_revisions(fs, rev, "read-packed", subpool));
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+/* SHARING_REVS revisions each adding SHARING_FILES files of
+   SHARING_FILE_SIZE bytes. */
+#define SHARING_REVS 100
+#define SHARING_FILES 50
+#define SHARING_FILE_SIZE 8192
+
+/* Commit SHARING_REVS revisions to FS each adding SHARING_FILES files,
+   which all have the same contents if SHARED, and report the time as
+   SCENARIO. */
+static svn_error_t *
+commit_files(svn_fs_t *fs,
+             svn_boolean_t shared,
+             const char *scenario,
+             apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  const char *same = make_contents(SHARING_FILE_SIZE, 42, pool);
+  svn_revnum_t rev;
+  apr_time_t start;
+  int i, j;
+
+  SVN_ERR(svn_fs_youngest_rev(&rev, fs, pool));
+
+  start = apr_time_now();
+  for (i = 0; i < SHARING_REVS; i++)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *root;
+      const char *dir;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      dir = apr_psprintf(iterpool, "%s-%d", scenario, i);
+      SVN_ERR(svn_fs_make_dir(root, dir, iterpool));
+      for (j = 0; j < SHARING_FILES; j++)
+        {
+          const char *path = apr_psprintf(iterpool, "%s/%d", dir, j);
+
+          SVN_ERR(svn_fs_make_file(root, path, iterpool));
+          SVN_ERR(svn_test__set_file_contents(
+                    root, path,
+                    shared ? same
+                           : make_contents(SHARING_FILE_SIZE,
+                                           i * SHARING_FILES + j + 1,
+                                           iterpool),
+                    iterpool));
+        }
+      SVN_ERR(commit(&rev, txn, iterpool));
+    }
+  report(scenario, SHARING_REVS, apr_time_now() - start);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Compare the commit throughput for contents that rep-sharing finds in
+   the rep cache with that for new contents. */
+static svn_error_t *
+rep_sharing_commits(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+
+  SVN_ERR(require_fsfs(opts));
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-bench-sharing", opts, pool));
+
+  SVN_ERR(commit_files(fs, FALSE, "commit-unique-reps", pool));
+  return commit_files(fs, TRUE, "commit-shared-reps", pool);
+}
+
+/* A revision changing WIDE_REV_PATHS paths, whose changes are read
+   WIDE_REV_READS times. */
+#define WIDE_REV_PATHS 20000
+#define WIDE_REV_READS 20
+
+/* Read the changed paths of a revision that touches very many nodes. */
+static svn_error_t *
+wide_paths_changed(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start;
+  int i;
+
+  SVN_ERR(require_fsfs(opts));
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-bench-changes", opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  for (i = 0; i < WIDE_REV_PATHS; i++)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+
+      /* Spread the paths over a hundred directories. */
+      if (i < 100)
+        SVN_ERR(svn_fs_make_dir(root, apr_psprintf(iterpool, "d%d", i),
+                                iterpool));
+      path = apr_psprintf(iterpool, "d%d/f%d", i % 100, i);
+      SVN_ERR(svn_fs_make_file(root, path, iterpool));
+    }
+  SVN_ERR(commit(&rev, txn, pool));
+
+  start = apr_time_now();
+  for (i = 0; i < WIDE_REV_READS; i++)
+    {
+      apr_hash_t *changes;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_fs_paths_changed2(&changes, root, iterpool));
+      SVN_TEST_ASSERT(apr_hash_count(changes) == WIDE_REV_PATHS + 100);
+    }
+  report("paths-changed-wide", WIDE_REV_READS, apr_time_now() - start);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
+/* The test table.  */
+
+struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_OPTS_PASS(deep_delta_chain,
+                       "benchmark long delta chains"),
+    SVN_TEST_OPTS_PASS(huge_directory,
+                       "benchmark a huge directory"),
+    SVN_TEST_OPTS_PASS(packed_vs_unpacked,
+                       "benchmark packed and unpacked reads"),
+    SVN_TEST_OPTS_PASS(rep_sharing_commits,
+                       "benchmark commits with rep-sharing"),
+    SVN_TEST_OPTS_PASS(wide_paths_changed,
+                       "benchmark paths_changed on a wide revision"),
+    SVN_TEST_NULL
+  };
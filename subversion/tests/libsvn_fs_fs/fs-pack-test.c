@@ -20,14 +20,17 @@
  * ====================================================================
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <apr_pools.h>
 
 #include "../svn_test.h"
 #include "../../libsvn_fs_fs/fs.h"
+#include "../../libsvn_fs_fs/fs_fs.h"
 
 #include "svn_pools.h"
+#include "svn_dirent_uri.h"
 #include "svn_props.h"
 #include "svn_fs.h"
 
@@ -104,12 +107,14 @@ get_rev_contents(svn_revnum_t rev, apr_pool_t *pool)
 }
 
 /* Create a packed filesystem in DIR.  Set the shard size to SHARD_SIZE
-   and create MAX_REV number of revisions.  Use POOL for allocations. */
+   and create MAX_REV number of revisions.  Pack it with up to JOBS
+   threads.  Use POOL for allocations. */
 static svn_error_t *
 create_packed_filesystem(const char *dir,
                          const svn_test_opts_t *opts,
                          int max_rev,
                          int shard_size,
+                         int jobs,
                          apr_pool_t *pool)
 {
   svn_fs_t *fs;
@@ -156,7 +161,7 @@ create_packed_filesystem(const char *dir,
   svn_pool_destroy(subpool);
 
   /* Now pack the FS */
-  return svn_fs_pack(dir, NULL, NULL, NULL, NULL, pool);
+  return svn_fs_pack2(dir, jobs, NULL, NULL, NULL, NULL, pool);
 }
 
 /* Pack a filesystem.  */
@@ -179,7 +184,7 @@ pack_filesystem(const svn_test_opts_t *opts,
       || (opts->server_minor_version && (opts->server_minor_version < 6)))
     return SVN_NO_ERROR;
 
-  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE, 1,
                                    pool));
 
   /* Check to see that the pack files exist, and that the rev directories
@@ -203,6 +208,24 @@ pack_filesystem(const svn_test_opts_t *opts,
                                  "Expected manifest file '%s' not found",
                                  path);
 
+      path = svn_path_join_many(pool, REPO_NAME, "revs",
+            apr_psprintf(pool, "%d.pack", i / SHARD_SIZE),
+            PATH_PACKED_MANIFEST_INDEX, NULL);
+      SVN_ERR(svn_io_check_path(path, &kind, pool));
+      if (kind != svn_node_file)
+        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                 "Expected manifest index '%s' not found",
+                                 path);
+
+      path = svn_path_join_many(pool, REPO_NAME, "revs",
+            apr_psprintf(pool, "%d.pack", i / SHARD_SIZE),
+            PATH_PACKED_CHANGES_INDEX, NULL);
+      SVN_ERR(svn_io_check_path(path, &kind, pool));
+      if (kind != svn_node_file)
+        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                 "Expected changes index '%s' not found",
+                                 path);
+
       /* This directory should not exist. */
       path = svn_path_join_many(pool, REPO_NAME, "revs",
             apr_psprintf(pool, "%d", i / SHARD_SIZE), NULL);
@@ -256,7 +279,7 @@ pack_even_filesystem(const svn_test_opts_t *opts,
       || (opts->server_minor_version && (opts->server_minor_version < 6)))
     return SVN_NO_ERROR;
 
-  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE, 1,
                                    pool));
 
   path = svn_path_join_many(pool, REPO_NAME, "revs", "2.pack", NULL);
@@ -287,7 +310,7 @@ read_packed_fs(const svn_test_opts_t *opts,
       || (opts->server_minor_version && (opts->server_minor_version < 6)))
     return SVN_NO_ERROR;
 
-  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, 11, 5, pool));
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, 11, 5, 1, pool));
   SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
 
   for (i = 1; i < 12; i++)
@@ -313,6 +336,219 @@ read_packed_fs(const svn_test_opts_t *opts,
 }
 #undef REPO_NAME
 
+/* Check reading from a filesystem packed by several threads. */
+#define REPO_NAME "test-repo-read-concurrently-packed-fs"
+#define SHARD_SIZE 2
+#define MAX_REV 13
+static svn_error_t *
+read_concurrently_packed_fs(const svn_test_opts_t *opts,
+                            apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_stream_t *rstream;
+  svn_stringbuf_t *rstring;
+  svn_revnum_t i;
+  char buf[80];
+  apr_file_t *file;
+  apr_size_t len;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 7)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE, 4,
+                                   pool));
+
+  /* All completed shards must have been published. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_path_join(REPO_NAME, PATH_MIN_UNPACKED_REV,
+                                         pool),
+                           APR_READ | APR_BUFFERED, APR_OS_DEFAULT, pool));
+  len = sizeof(buf);
+  SVN_ERR(svn_io_read_length_line(file, buf, &len, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  if (SVN_STR_TO_REV(buf) != ((MAX_REV + 1) / SHARD_SIZE) * SHARD_SIZE)
+    return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                             "Bad '%s' contents", PATH_MIN_UNPACKED_REV);
+
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+  for (i = 1; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stringbuf_t *sb;
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, pool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", pool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, pool));
+
+      if (i == 1)
+        sb = svn_stringbuf_create("This is the file 'iota'.\n", pool);
+      else
+        sb = svn_stringbuf_create(get_rev_contents(i, pool), pool);
+
+      if (! svn_stringbuf_compare(rstring, sb))
+        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                 "Bad data in revision %ld.", i);
+    }
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* Check reading from a filesystem packed without manifest indexes. */
+#define REPO_NAME "test-repo-read-packed-fs-no-index"
+static svn_error_t *
+read_packed_fs_without_index(const svn_test_opts_t *opts,
+                             apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_stream_t *rstream;
+  svn_stringbuf_t *rstring;
+  svn_revnum_t i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 6)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, 11, 5, 1, pool));
+
+  /* Older releases did not write the binary index; remove it. */
+  for (i = 0; i < 2; i++)
+    SVN_ERR(svn_io_remove_file2(svn_path_join_many(pool, REPO_NAME, "revs",
+                                  apr_psprintf(pool, "%ld.pack", i),
+                                  PATH_PACKED_MANIFEST_INDEX, NULL),
+                                FALSE, pool));
+
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+
+  for (i = 1; i < 12; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stringbuf_t *sb;
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, pool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", pool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, pool));
+
+      if (i == 1)
+        sb = svn_stringbuf_create("This is the file 'iota'.\n", pool);
+      else
+        sb = svn_stringbuf_create(get_rev_contents(i, pool), pool);
+
+      if (! svn_stringbuf_compare(rstring, sb))
+        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                 "Bad data in revision %ld.", i);
+    }
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+/* Compare the changed paths of revisions 1 to MAX_REV in FS1 and FS2.
+   Use POOL for allocations. */
+static svn_error_t *
+compare_paths_changed(svn_fs_t *fs1,
+                      svn_fs_t *fs2,
+                      svn_revnum_t max_rev,
+                      apr_pool_t *pool)
+{
+  svn_revnum_t i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  for (i = 1; i <= max_rev; i++)
+    {
+      svn_fs_root_t *root1, *root2;
+      apr_hash_t *changes1, *changes2;
+      apr_hash_index_t *hi;
+      svn_fs_path_change2_t *change;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root1, fs1, i, iterpool));
+      SVN_ERR(svn_fs_revision_root(&root2, fs2, i, iterpool));
+      SVN_ERR(svn_fs_paths_changed2(&changes1, root1, iterpool));
+      SVN_ERR(svn_fs_paths_changed2(&changes2, root2, iterpool));
+
+      if (apr_hash_count(changes1) != apr_hash_count(changes2))
+        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                 "Different number of changes in r%ld", i);
+
+      for (hi = apr_hash_first(iterpool, changes1); hi; hi = apr_hash_next(hi))
+        {
+          const char *path = svn__apr_hash_index_key(hi);
+          svn_fs_path_change2_t *expected = svn__apr_hash_index_val(hi);
+
+          change = apr_hash_get(changes2, path, APR_HASH_KEY_STRING);
+          if (! change
+              || change->change_kind != expected->change_kind
+              || change->text_mod != expected->text_mod
+              || change->prop_mod != expected->prop_mod
+              || svn_fs_compare_ids(change->node_rev_id,
+                                    expected->node_rev_id) != 0)
+            return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                     "Bad change of '%s' in r%ld", path, i);
+        }
+
+      /* Every revision but the first one modified iota. */
+      change = apr_hash_get(changes1, "/iota", APR_HASH_KEY_STRING);
+      if (! change
+          || (i > 1 && change->change_kind != svn_fs_path_change_modify))
+        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                 "Missing change of '/iota' in r%ld", i);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Check the changed paths read through the packed changes index. */
+#define REPO_NAME "test-repo-paths-changed-packed-fs"
+#define SHARD_SIZE 5
+#define MAX_REV 12
+static svn_error_t *
+paths_changed_packed_fs(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_fs_t *fs, *unpacked_fs;
+  const char *unpacked_name = REPO_NAME "-unpacked";
+  apr_int64_t i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 7)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE, 1,
+                                   pool));
+
+  /* The same history without any packing. */
+  SVN_ERR(create_packed_filesystem(unpacked_name, opts, MAX_REV, 1000, 1,
+                                   pool));
+
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+  SVN_ERR(svn_fs_open(&unpacked_fs, unpacked_name, NULL, pool));
+  SVN_ERR(compare_paths_changed(unpacked_fs, fs, MAX_REV, pool));
+
+  /* Older releases did not write the changes index; remove it. */
+  for (i = 0; i < (MAX_REV + 1) / SHARD_SIZE; i++)
+    SVN_ERR(svn_io_remove_file2(svn_path_join_many(pool, REPO_NAME, "revs",
+                                  apr_psprintf(pool, "%" APR_INT64_T_FMT
+                                               ".pack", i),
+                                  PATH_PACKED_CHANGES_INDEX, NULL),
+                                FALSE, pool));
+
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+  SVN_ERR(compare_paths_changed(unpacked_fs, fs, MAX_REV, pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
 /* Check reading from a packed filesystem. */
 #define REPO_NAME "test-repo-commit-packed-fs"
 static svn_error_t *
@@ -331,7 +567,7 @@ commit_packed_fs(const svn_test_opts_t *opts,
     return SVN_NO_ERROR;
 
   /* Create the packed FS and open it. */
-  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, 11, 5, pool));
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, 11, 5, 1, pool));
   SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
 
   /* Now do a commit. */
@@ -368,7 +604,8 @@ get_set_revprop_packed_fs(const svn_test_opts_t *opts,
     return SVN_NO_ERROR;
 
   /* Create the packed FS and open it. */
-  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE, pool));
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE, 1,
+                                   pool));
   SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
 
   subpool = svn_pool_create(pool);
@@ -380,7 +617,7 @@ get_set_revprop_packed_fs(const svn_test_opts_t *opts,
   svn_pool_clear(subpool);
 
   /* Pack the repository. */
-  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_pack2(REPO_NAME, 1, NULL, NULL, NULL, NULL, pool));
 
   /* Try to get revprop for revision 0. */
   SVN_ERR(svn_fs_revision_prop(&prop_value, fs, 0, SVN_PROP_REVISION_AUTHOR, pool));
@@ -391,6 +628,848 @@ get_set_revprop_packed_fs(const svn_test_opts_t *opts,
 
   return SVN_NO_ERROR;
 }
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* Look up entries in a directory large enough to get searched in-place. */
+#define REPO_NAME "test-repo-large-directory"
+#define DIR_SIZE 5000
+static svn_error_t *
+large_directory(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  const char *conflict;
+  svn_revnum_t after_rev;
+  apr_hash_t *entries;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 7)))
+    return SVN_NO_ERROR;
+
+  /* Commit a directory with many entries.  Every third one is a
+     sub-directory. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "big", pool));
+  for (i = 0; i < DIR_SIZE; i++)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "big/entry-%d", i * 2);
+      if (i % 3)
+        SVN_ERR(svn_fs_make_file(txn_root, path, iterpool));
+      else
+        SVN_ERR(svn_fs_make_dir(txn_root, path, iterpool));
+    }
+  SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, pool));
+
+  /* Reopen the filesystem to start with empty caches. */
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, after_rev, pool));
+
+  /* Existing and missing entries must be found or not found, resp. */
+  for (i = 0; i < 2 * DIR_SIZE; i++)
+    {
+      svn_node_kind_t kind, expected;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_check_path(&kind, rev_root,
+                                apr_psprintf(iterpool, "big/entry-%d", i),
+                                iterpool));
+
+      if (i % 2)
+        expected = svn_node_none;
+      else
+        expected = (i / 2) % 3 ? svn_node_file : svn_node_dir;
+
+      if (kind != expected)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Unexpected kind of entry-%d", i);
+    }
+
+  /* The full listing must be complete as well. */
+  SVN_ERR(svn_fs_dir_entries(&entries, rev_root, "big", pool));
+  if (apr_hash_count(entries) != DIR_SIZE)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Expected %d entries, found %u", DIR_SIZE,
+                             apr_hash_count(entries));
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef DIR_SIZE
+
+/* Commit with the new revision being written outside the write lock. */
+#define REPO_NAME "test-repo-prepared-commits"
+static svn_error_t *
+prepared_commits(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn, *txn2;
+  svn_fs_root_t *txn_root, *rev_root;
+  const char *conflict;
+  svn_revnum_t after_rev;
+  svn_stringbuf_t *contents;
+  svn_stream_t *stream;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 7)))
+    return SVN_NO_ERROR;
+
+  /* Create a filesystem and enable prepared commits for it. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                             "[" CONFIG_SECTION_COMMITS "]\n"
+                             CONFIG_OPTION_PREPARE_OUTSIDE_LOCK " = true\n",
+                             pool));
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+
+  /* A plain commit. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, pool));
+  SVN_TEST_ASSERT(after_rev == 1);
+
+  /* Two txns based on the same revision.  The second one will be out
+     of date and has to be merged before it can be prepared. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "new iota", pool));
+  SVN_ERR(svn_fs_begin_txn(&txn2, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn2, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "new mu", pool));
+
+  SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn, pool));
+  SVN_TEST_ASSERT(after_rev == 2);
+  SVN_ERR(svn_fs_commit_txn(&conflict, &after_rev, txn2, pool));
+  SVN_TEST_ASSERT(after_rev == 3);
+
+  /* Read the result through a fresh FS object. */
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, after_rev, pool));
+
+  SVN_ERR(svn_fs_file_contents(&stream, rev_root, "iota", pool));
+  SVN_ERR(svn_test__stream_to_string(&contents, stream, pool));
+  SVN_TEST_ASSERT(strcmp(contents->data, "new iota") == 0);
+
+  SVN_ERR(svn_fs_file_contents(&stream, rev_root, "A/mu", pool));
+  SVN_ERR(svn_test__stream_to_string(&contents, stream, pool));
+  SVN_TEST_ASSERT(strcmp(contents->data, "new mu") == 0);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+/* Return the size of the file for revision REV in the unpacked
+   filesystem at REPO_NAME in *SIZE. */
+static svn_error_t *
+get_rev_file_size(svn_filesize_t *size,
+                  const char *repo_name,
+                  svn_revnum_t rev,
+                  apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+  const char *path = svn_dirent_join_many(pool, repo_name, "revs", "0",
+                                          apr_psprintf(pool, "%ld", rev),
+                                          NULL);
+
+  SVN_ERR(svn_io_stat(&finfo, path, APR_FINFO_SIZE, pool));
+  *size = finfo.size;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add a file PATH with CONTENTS to FS in a new revision. */
+static svn_error_t *
+commit_file(svn_fs_t *fs,
+            const char *path,
+            const char *contents,
+            apr_pool_t *pool)
+{
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  const char *conflict;
+  svn_revnum_t youngest, after_rev;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, path, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, path, contents, pool));
+  return svn_fs_commit_txn(&conflict, &after_rev, txn, pool);
+}
+
+/* Share reps whose rep-cache entries are still queued for a batch. */
+#define REPO_NAME "test-repo-batched-rep-cache"
+static svn_error_t *
+batched_rep_cache(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_stringbuf_t *contents = svn_stringbuf_create("", pool);
+  svn_filesize_t first_size, size;
+  apr_pool_t *subpool;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 7)))
+    return SVN_NO_ERROR;
+
+  for (i = 0; i < 1000; i++)
+    svn_stringbuf_appendcstr(contents,
+                             apr_psprintf(pool, "line %d of shared text\n",
+                                          i));
+
+  /* Collect rep-cache entries for more revisions than we commit. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                             "[" CONFIG_SECTION_REP_SHARING "]\n"
+                             CONFIG_OPTION_BATCH_REVISIONS " = 100\n",
+                             pool));
+
+  subpool = svn_pool_create(pool);
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, subpool));
+  SVN_ERR(commit_file(fs, "a", contents->data, subpool));
+  SVN_ERR(commit_file(fs, "b", contents->data, subpool));
+
+  /* The second commit must have shared the queued rep of the first. */
+  SVN_ERR(get_rev_file_size(&first_size, REPO_NAME, 1, pool));
+  SVN_ERR(get_rev_file_size(&size, REPO_NAME, 2, pool));
+  SVN_TEST_ASSERT(size < first_size / 2);
+
+  /* Closing the FS writes the queued entries to the database. */
+  svn_pool_destroy(subpool);
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+  SVN_ERR(commit_file(fs, "c", contents->data, pool));
+  SVN_ERR(get_rev_file_size(&size, REPO_NAME, 3, pool));
+  SVN_TEST_ASSERT(size < first_size / 2);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+/* Share reps with the rep-cache lookups going through a Bloom filter. */
+#define REPO_NAME "test-repo-rep-cache-bloom"
+static svn_error_t *
+rep_cache_bloom_filter(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_stringbuf_t *contents = svn_stringbuf_create("", pool);
+  svn_filesize_t first_size, size;
+  svn_node_kind_t kind;
+  apr_pool_t *subpool;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 7)))
+    return SVN_NO_ERROR;
+
+  for (i = 0; i < 1000; i++)
+    svn_stringbuf_appendcstr(contents,
+                             apr_psprintf(pool, "line %d of shared text\n",
+                                          i));
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                             "[" CONFIG_SECTION_REP_SHARING "]\n"
+                             CONFIG_OPTION_ENABLE_BLOOM_FILTER " = true\n",
+                             pool));
+
+  subpool = svn_pool_create(pool);
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, subpool));
+  SVN_ERR(commit_file(fs, "a", contents->data, subpool));
+  SVN_ERR(commit_file(fs, "b", contents->data, subpool));
+  svn_pool_destroy(subpool);
+
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, "rep-cache.bloom",
+                                            pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* The filter read back from disk must know about the first rep. */
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+  SVN_ERR(commit_file(fs, "c", contents->data, pool));
+
+  SVN_ERR(get_rev_file_size(&first_size, REPO_NAME, 1, pool));
+  SVN_ERR(get_rev_file_size(&size, REPO_NAME, 2, pool));
+  SVN_TEST_ASSERT(size < first_size / 2);
+  SVN_ERR(get_rev_file_size(&size, REPO_NAME, 3, pool));
+  SVN_TEST_ASSERT(size < first_size / 2);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+/* Have several FS objects track the youngest revision together. */
+#define REPO_NAME "test-repo-shared-youngest"
+static svn_error_t *
+shared_youngest_rev(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs, *fs2;
+  const char *current = svn_dirent_join(REPO_NAME, PATH_CURRENT, pool);
+  svn_revnum_t youngest;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_open(&fs2, REPO_NAME, NULL, pool));
+  SVN_ERR(commit_file(fs, "a", "a", pool));
+
+  /* Make 'current' old enough for its stamp to be shared and ask
+     twice, such that the second call uses the shared value. */
+  SVN_ERR(svn_io_set_file_affected_time(apr_time_now()
+                                          - apr_time_from_sec(60),
+                                        current, pool));
+  for (i = 0; i < 2; i++)
+    {
+      SVN_ERR(svn_fs_youngest_rev(&youngest, fs2, pool));
+      SVN_TEST_ASSERT(youngest == 1);
+      SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+      SVN_TEST_ASSERT(youngest == 1);
+    }
+
+  /* New commits must be visible right away. */
+  SVN_ERR(commit_file(fs, "b", "b", pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs2, pool));
+  SVN_TEST_ASSERT(youngest == 2);
+  SVN_ERR(commit_file(fs2, "c", "c", pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_ASSERT(youngest == 3);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+/* Cache revprops, both packed and unpacked ones, and see changes made
+   through any FS object in this process right away. */
+#define REPO_NAME "test-repo-revprop-cache"
+#define SHARD_SIZE 2
+#define MAX_REV 5
+static svn_error_t *
+revprop_cache(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs, *fs2;
+  const char *revprop_files[2];
+  svn_revnum_t revs[2] = { 1, MAX_REV };
+  svn_string_t *value;
+  int i, k;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 7)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE, 1,
+                                   pool));
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+  SVN_ERR(svn_fs_open(&fs2, REPO_NAME, NULL, pool));
+
+  revprop_files[0] = svn_dirent_join_many(pool, REPO_NAME, PATH_REVPROPS_DIR,
+                                          PATH_REVPROPS_DB, NULL);
+  revprop_files[1] = svn_dirent_join_many(pool, REPO_NAME, PATH_REVPROPS_DIR,
+                                          apr_psprintf(pool, "%d",
+                                                       MAX_REV / SHARD_SIZE),
+                                          apr_psprintf(pool, "%d", MAX_REV),
+                                          NULL);
+
+  for (k = 0; k < 2; k++)
+    {
+      const char *author = apr_psprintf(pool, "author-%d", k);
+
+      /* Make the revprop files old enough for their contents to be
+         cached and read them twice, such that the second read may use
+         the cache. */
+      for (i = 0; i < 2; i++)
+        SVN_ERR(svn_io_set_file_affected_time(apr_time_now()
+                                                - apr_time_from_sec(60),
+                                              revprop_files[i], pool));
+      for (i = 0; i < 4; i++)
+        {
+          SVN_ERR(svn_fs_revision_prop(&value, i % 2 ? fs2 : fs,
+                                       revs[i / 2], SVN_PROP_REVISION_LOG,
+                                       pool));
+          SVN_TEST_ASSERT(value != NULL);
+        }
+
+      /* Changes must be visible right away, through either FS object. */
+      for (i = 0; i < 2; i++)
+        {
+          SVN_ERR(svn_fs_change_rev_prop(k ? fs2 : fs, revs[i],
+                                         SVN_PROP_REVISION_AUTHOR,
+                                         svn_string_create(author, pool),
+                                         pool));
+          SVN_ERR(svn_fs_revision_prop(&value, fs, revs[i],
+                                       SVN_PROP_REVISION_AUTHOR, pool));
+          SVN_TEST_STRING_ASSERT(value->data, author);
+          SVN_ERR(svn_fs_revision_prop(&value, fs2, revs[i],
+                                       SVN_PROP_REVISION_AUTHOR, pool));
+          SVN_TEST_STRING_ASSERT(value->data, author);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* Check the predecessor skip links of a frequently changed file. */
+#define REPO_NAME "test-repo-predecessor-skip-links"
+#define NUM_CHANGES 40
+static svn_error_t *
+predecessor_skip_links(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  const svn_fs_id_t *ids[NUM_CHANGES + 1];
+  node_revision_t *noderev, *ancestor;
+  svn_stringbuf_t *contents;
+  svn_revnum_t rev;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 7)))
+    return SVN_NO_ERROR;
+
+  /* Revision I + 1 will contain the node-rev with predecessor count I. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  for (i = 0; i <= NUM_CHANGES; i++)
+    {
+      svn_pool_clear(subpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, i, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      if (i == 0)
+        SVN_ERR(svn_fs_make_file(txn_root, "iota", subpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(subpool,
+                                                       "change %d\n", i),
+                                          subpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, subpool));
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+      SVN_ERR(svn_fs_node_id(&ids[i], root, "iota", pool));
+    }
+  svn_pool_destroy(subpool);
+
+  /* Every link must point to the skip-delta base, unless that is the
+     predecessor anyway. */
+  for (i = 0; i <= NUM_CHANGES; i++)
+    {
+      int count = i & (i - 1);
+
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, ids[i], pool));
+      SVN_TEST_ASSERT(noderev->predecessor_count == i);
+      if (i > 1 && count != i - 1)
+        {
+          SVN_TEST_ASSERT(noderev->predecessor_skip_id);
+          SVN_TEST_ASSERT(svn_fs_compare_ids(noderev->predecessor_skip_id,
+                                             ids[count]) == 0);
+        }
+      else
+        SVN_TEST_ASSERT(noderev->predecessor_skip_id == NULL);
+    }
+
+  /* Any ancestor must be reachable from the youngest node-rev. */
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, ids[NUM_CHANGES],
+                                       pool));
+  for (i = 0; i <= NUM_CHANGES; i++)
+    {
+      SVN_ERR(svn_fs_fs__get_ancestor(&ancestor, fs, noderev, i, pool));
+      SVN_TEST_ASSERT(svn_fs_compare_ids(ancestor->id, ids[i]) == 0);
+    }
+
+  /* File contents based on skip-deltas must still be intact. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, NUM_CHANGES + 1, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "iota", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data,
+                         apr_psprintf(pool, "change %d\n", NUM_CHANGES));
+
+  return SVN_NO_ERROR;
+}
+#undef NUM_CHANGES
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-mergeinfo-index"
+
+/* Verify that the explicit mergeinfo below PATH in revision REV of FS
+   consists of EXPECTED, a NULL-terminated list of alternating paths and
+   mergeinfo strings.  Use POOL for allocations. */
+static svn_error_t *
+check_descendant_mergeinfo(svn_fs_t *fs,
+                           svn_revnum_t rev,
+                           const char *path,
+                           const char *const *expected,
+                           apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+  svn_mergeinfo_catalog_t catalog;
+  unsigned int count = 0;
+
+  APR_ARRAY_PUSH(paths, const char *) = path;
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_get_mergeinfo(&catalog, root, paths, svn_mergeinfo_explicit,
+                               TRUE, pool));
+
+  for (; *expected; expected += 2, count++)
+    {
+      svn_mergeinfo_t mergeinfo = apr_hash_get(catalog, expected[0],
+                                               APR_HASH_KEY_STRING);
+      svn_string_t *mergeinfo_string;
+
+      if (! mergeinfo)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "No mergeinfo for '%s' in r%ld",
+                                 expected[0], rev);
+      SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_string, mergeinfo, pool));
+      SVN_TEST_STRING_ASSERT(mergeinfo_string->data, expected[1]);
+    }
+
+  if (apr_hash_count(catalog) != count)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Expected %u paths with mergeinfo below '%s' "
+                             "in r%ld, got %u", count, path, rev,
+                             apr_hash_count(catalog));
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify the mergeinfo below several paths in all revisions of the
+   filesystem at PATH, as created by the mergeinfo_index test.  Use POOL
+   for allocations. */
+static svn_error_t *
+check_mergeinfo_index_fs(const char *path,
+                         apr_pool_t *pool)
+{
+  const char *const r1_root[] = {
+    "/A/B", "/branch/B:1",
+    "/A/D/G", "/branch/G:1",
+    "/A/D/gamma", "/branch/gamma:1",
+    NULL };
+  const char *const r2_root[] = {
+    "/A/D/G", "/branch/G:1",
+    "/A/D/gamma", "/branch/gamma:1",
+    "/A2/B", "/branch/B:1",
+    "/A2/D/G", "/branch/G:1",
+    "/A2/D/gamma", "/branch/gamma:1",
+    "/iota", "/branch/iota:2",
+    NULL };
+  const char *const r3_root[] = {
+    "/A2/B", "/branch/B:1",
+    "/A2/D/G", "/branch/G:1",
+    "/A2/D/H", "/branch/H:3",
+    "/iota", "/branch/iota:2",
+    NULL };
+  const char *const r3_a2[] = {
+    "/A2/B", "/branch/B:1",
+    "/A2/D/G", "/branch/G:1",
+    "/A2/D/H", "/branch/H:3",
+    NULL };
+  const char *const r3_a[] = { NULL };
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_fs_t *fs;
+
+  /* Close FS again when done, so its index may be removed. */
+  SVN_ERR(svn_fs_open(&fs, path, NULL, subpool));
+  SVN_ERR(check_descendant_mergeinfo(fs, 1, "/", r1_root, subpool));
+  SVN_ERR(check_descendant_mergeinfo(fs, 2, "/", r2_root, subpool));
+  SVN_ERR(check_descendant_mergeinfo(fs, 3, "/", r3_root, subpool));
+  SVN_ERR(check_descendant_mergeinfo(fs, 3, "/A2", r3_a2, subpool));
+  SVN_ERR(check_descendant_mergeinfo(fs, 3, "A", r3_a, subpool));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+mergeinfo_index(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t rev;
+  const char *index_path;
+  svn_node_kind_t kind;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 7)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, subpool));
+  index_path = svn_dirent_join(svn_fs_path(fs, pool), "mergeinfo-index.db",
+                               pool);
+
+  /* r1: The greek tree, with mergeinfo on a few nodes. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/B", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/branch/B:1", pool),
+                                  pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D/G", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/branch/G:1", pool),
+                                  pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D/gamma", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/branch/gamma:1", pool),
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: Copy A, then drop the mergeinfo of the source's A/B. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_copy(root, "A", txn_root, "A2", pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/B", SVN_PROP_MERGEINFO,
+                                  NULL, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "iota", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/branch/iota:2", pool),
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r3: Delete A/D and change the mergeinfo within the copy. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D", pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A2/D/H", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/branch/H:3", pool),
+                                  pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A2/D/gamma", SVN_PROP_MERGEINFO,
+                                  NULL, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  svn_pool_destroy(subpool);
+
+  /* The index must give the same results as crawling the tree, which
+     happens once it has been removed. */
+  SVN_ERR(svn_io_check_path(index_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(check_mergeinfo_index_fs(REPO_NAME, pool));
+
+  SVN_ERR(svn_io_remove_file2(index_path, FALSE, pool));
+  SVN_ERR(check_mergeinfo_index_fs(REPO_NAME, pool));
+
+  /* Upgrading rebuilds the index. */
+  SVN_ERR(svn_fs_upgrade(REPO_NAME, pool));
+  SVN_ERR(svn_io_check_path(index_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(check_mergeinfo_index_fs(REPO_NAME, pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-max-deltification-walk"
+#define NUM_CHANGES 40
+#define MAX_WALK 3
+
+/* Set *LENGTH to the number of reps that have to be read to reconstruct
+   the text rep at OFFSET in revision REV of the unpacked filesystem at
+   REPO_NAME.  Use POOL for allocations. */
+static svn_error_t *
+get_delta_chain_length(int *length,
+                       svn_revnum_t rev,
+                       apr_off_t offset,
+                       apr_pool_t *pool)
+{
+  *length = 0;
+  while (TRUE)
+    {
+      svn_stringbuf_t *rev_contents;
+      const char *path = svn_dirent_join_many(pool, REPO_NAME, "revs", "0",
+                                              apr_psprintf(pool, "%ld", rev),
+                                              NULL);
+      long base_rev, base_offset, base_length;
+
+      SVN_ERR(svn_stringbuf_from_file2(&rev_contents, path, pool));
+      SVN_TEST_ASSERT(offset < (apr_off_t)rev_contents->len);
+      ++*length;
+
+      if (sscanf(rev_contents->data + offset, "DELTA %ld %ld %ld\n",
+                 &base_rev, &base_offset, &base_length) != 3)
+        break;
+
+      rev = base_rev;
+      offset = base_offset;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Limit the length of delta chains through fsfs.conf. */
+static svn_error_t *
+max_deltification_walk(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  const svn_fs_id_t *id;
+  node_revision_t *noderev;
+  svn_stringbuf_t *contents;
+  svn_revnum_t rev;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  int i, length;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 7)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_io_file_create(svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                             apr_psprintf(pool,
+                                          "[" CONFIG_SECTION_DELTIFICATION "]\n"
+                                          CONFIG_OPTION_MAX_DELTIFICATION_WALK
+                                          " = %d\n", MAX_WALK),
+                             pool));
+  SVN_ERR(svn_fs_open(&fs, REPO_NAME, NULL, pool));
+
+  for (i = 0; i < NUM_CHANGES; i++)
+    {
+      svn_pool_clear(subpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, i, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      if (i == 0)
+        SVN_ERR(svn_fs_make_file(txn_root, "iota", subpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(subpool,
+                                                       "change %d\n", i),
+                                          subpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, subpool));
+
+      /* No chain may exceed the limit, and the contents must be intact. */
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, subpool));
+      SVN_ERR(svn_fs_node_id(&id, root, "iota", subpool));
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, subpool));
+      SVN_ERR(get_delta_chain_length(&length, noderev->data_rep->revision,
+                                     noderev->data_rep->offset, subpool));
+      SVN_TEST_ASSERT(length <= MAX_WALK);
+
+      SVN_ERR(svn_test__get_file_contents(root, "iota", &contents, subpool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             apr_psprintf(subpool, "change %d\n", i));
+    }
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+#undef MAX_WALK
+#undef NUM_CHANGES
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-shared-prop-reps"
+
+/* Set *REP to a copy of the prop rep of PATH in revision REV of FS.
+   Use POOL for allocations. */
+static svn_error_t *
+get_prop_rep(representation_t **rep,
+             svn_fs_t *fs,
+             svn_revnum_t rev,
+             const char *path,
+             apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  const svn_fs_id_t *id;
+  node_revision_t *noderev;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_node_id(&id, root, path, pool));
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool));
+  SVN_TEST_ASSERT(noderev->prop_rep);
+  *rep = noderev->prop_rep;
+
+  return SVN_NO_ERROR;
+}
+
+/* Share identical property reps, within a revision and across them. */
+static svn_error_t *
+shared_prop_reps(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_stringbuf_t *ignores = svn_stringbuf_create("", pool);
+  svn_string_t *value;
+  representation_t *rep1, *rep2, *rep3;
+  svn_revnum_t rev;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 7)))
+    return SVN_NO_ERROR;
+
+  for (i = 0; i < 100; i++)
+    svn_stringbuf_appendcstr(ignores, apr_psprintf(pool, "*.ext%d\n", i));
+  value = svn_string_create_from_buf(ignores, pool);
+
+  /* r1: Two directories with the same properties. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/B", SVN_PROP_IGNORE, value,
+                                  pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/C", SVN_PROP_IGNORE, value,
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: A third one. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D/G", SVN_PROP_IGNORE, value,
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* All of them must use the rep written first. */
+  SVN_ERR(get_prop_rep(&rep1, fs, rev, "A/B", pool));
+  SVN_ERR(get_prop_rep(&rep2, fs, rev, "A/C", pool));
+  SVN_ERR(get_prop_rep(&rep3, fs, rev, "A/D/G", pool));
+  SVN_TEST_ASSERT(rep1->revision == 1);
+  SVN_TEST_ASSERT(rep2->revision == 1 && rep2->offset == rep1->offset);
+  SVN_TEST_ASSERT(rep3->revision == 1 && rep3->offset == rep1->offset);
+  SVN_TEST_ASSERT(! svn_fs_fs__noderev_same_rep_key(rep1, rep2));
+
+  /* And the properties must be intact. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_node_prop(&value, root, "A/D/G", SVN_PROP_IGNORE, pool));
+  SVN_TEST_ASSERT(value);
+  SVN_TEST_STRING_ASSERT(value->data, ignores->data);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
 
 /* ------------------------------------------------------------------------ */
 
@@ -405,9 +1484,35 @@ struct svn_test_descriptor_t test_funcs[] =
                        "pack FSFS where revs % shard = 0"),
     SVN_TEST_OPTS_PASS(read_packed_fs,
                        "read from a packed FSFS filesystem"),
+    SVN_TEST_OPTS_PASS(read_packed_fs_without_index,
+                       "read from a packed FSFS filesystem without index"),
+    SVN_TEST_OPTS_PASS(read_concurrently_packed_fs,
+                       "read from a FSFS filesystem packed by threads"),
+    SVN_TEST_OPTS_PASS(paths_changed_packed_fs,
+                       "read changed paths from a packed FSFS filesystem"),
     SVN_TEST_OPTS_PASS(commit_packed_fs,
                        "commit to a packed FSFS filesystem"),
     SVN_TEST_OPTS_PASS(get_set_revprop_packed_fs,
                        "get/set revprop while packing FSFS filesystem"),
+    SVN_TEST_OPTS_PASS(large_directory,
+                       "look up entries in a large FSFS directory"),
+    SVN_TEST_OPTS_PASS(prepared_commits,
+                       "commit with preparation outside the write lock"),
+    SVN_TEST_OPTS_PASS(batched_rep_cache,
+                       "share reps with rep-cache entries not yet written"),
+    SVN_TEST_OPTS_PASS(rep_cache_bloom_filter,
+                       "share reps with a rep-cache Bloom filter"),
+    SVN_TEST_OPTS_PASS(shared_youngest_rev,
+                       "share the youngest revision between FS objects"),
+    SVN_TEST_OPTS_PASS(revprop_cache,
+                       "cache revprops and see changes right away"),
+    SVN_TEST_OPTS_PASS(predecessor_skip_links,
+                       "follow predecessor skip links"),
+    SVN_TEST_OPTS_PASS(mergeinfo_index,
+                       "query mergeinfo through the mergeinfo index"),
+    SVN_TEST_OPTS_PASS(max_deltification_walk,
+                       "limit the length of delta chains"),
+    SVN_TEST_OPTS_PASS(shared_prop_reps,
+                       "share identical property reps"),
     SVN_TEST_NULL
   };
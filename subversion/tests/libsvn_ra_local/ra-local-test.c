@@ -25,10 +25,12 @@
 
 #include <apr_general.h>
 #include <apr_pools.h>
+#include <apr_strings.h>
 
 #include "svn_error.h"
 #include "svn_delta.h"
 #include "svn_ra.h"
+#include "svn_repos.h"
 #include "svn_client.h"
 
 #include "../svn_test.h"
@@ -274,6 +276,222 @@ split_url_test(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Test svn_ra_stat_many() and svn_ra_get_dir_many(). */
+static svn_error_t *
+stat_and_get_dir_many(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  apr_array_header_t *paths;
+  apr_hash_t *results;
+  svn_dirent_t *dirent;
+  svn_ra_dir_listing_t *listing;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-stat-many", opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, svn_repos_fs(repos), 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  SVN_ERR(svn_ra_initialize(pool));
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  SVN_ERR(svn_test__current_directory_url(&url, "test-repo-stat-many",
+                                          pool));
+  SVN_ERR(svn_ra_open3(&session, url, NULL, cbtable, NULL, NULL, pool));
+
+  paths = apr_array_make(pool, 3, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "iota";
+  APR_ARRAY_PUSH(paths, const char *) = "A/B";
+  APR_ARRAY_PUSH(paths, const char *) = "A/nonexistent";
+  SVN_ERR(svn_ra_stat_many(session, &results, paths, youngest_rev, pool));
+
+  if (apr_hash_count(results) != 2)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Expected 2 dirents, got %u",
+                             apr_hash_count(results));
+  dirent = apr_hash_get(results, "iota", APR_HASH_KEY_STRING);
+  if (! dirent || dirent->kind != svn_node_file)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "Wrong dirent for 'iota'");
+  dirent = apr_hash_get(results, "A/B", APR_HASH_KEY_STRING);
+  if (! dirent || dirent->kind != svn_node_dir)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "Wrong dirent for 'A/B'");
+
+  paths = apr_array_make(pool, 2, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "A";
+  APR_ARRAY_PUSH(paths, const char *) = "A/B";
+  SVN_ERR(svn_ra_get_dir_many(session, &results, paths, youngest_rev,
+                              SVN_DIRENT_KIND, FALSE, pool));
+
+  listing = apr_hash_get(results, "A", APR_HASH_KEY_STRING);
+  if (! listing || apr_hash_count(listing->dirents) != 4
+      || listing->fetched_rev != youngest_rev || listing->props)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "Wrong listing for 'A'");
+  listing = apr_hash_get(results, "A/B", APR_HASH_KEY_STRING);
+  if (! listing || apr_hash_count(listing->dirents) != 3)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "Wrong listing for 'A/B'");
+  dirent = apr_hash_get(listing->dirents, "E", APR_HASH_KEY_STRING);
+  if (! dirent || dirent->kind != svn_node_dir)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "Wrong entry 'A/B/E'");
+
+  /* A path that isn't a directory fails the whole call. */
+  APR_ARRAY_PUSH(paths, const char *) = "iota";
+  err = svn_ra_get_dir_many(session, &results, paths, youngest_rev,
+                            SVN_DIRENT_KIND, FALSE, pool);
+  if (! err)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "Listing a file should fail");
+  svn_error_clear(err);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Implements svn_ra_dirent_receiver_t, appending PATH to the
+   svn_stringbuf_t BATON, followed by a space. */
+static svn_error_t *
+collect_list_entry(const char *path,
+                   svn_dirent_t *dirent,
+                   void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *buf = baton;
+
+  svn_stringbuf_appendcstr(buf, path);
+  if (dirent->kind == svn_node_dir)
+    svn_stringbuf_appendbytes(buf, "/", 1);
+  svn_stringbuf_appendbytes(buf, " ", 1);
+  return SVN_NO_ERROR;
+}
+
+/* Test svn_ra_list(). */
+static svn_error_t *
+list_test(const svn_test_opts_t *opts,
+          apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_stringbuf_t *buf = svn_stringbuf_create("", pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-list", opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, svn_repos_fs(repos), 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  SVN_ERR(svn_ra_initialize(pool));
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  SVN_ERR(svn_test__current_directory_url(&url, "test-repo-list", pool));
+  SVN_ERR(svn_ra_open3(&session, url, NULL, cbtable, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_list(session, "A/B", youngest_rev, svn_depth_infinity,
+                      SVN_DIRENT_KIND, collect_list_entry, buf, pool));
+  if (strcmp(buf->data, "E/ E/alpha E/beta F/ lambda ") != 0)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Unexpected listing '%s'", buf->data);
+
+  svn_stringbuf_setempty(buf);
+  SVN_ERR(svn_ra_list(session, "A/B", SVN_INVALID_REVNUM, svn_depth_files,
+                      SVN_DIRENT_KIND, collect_list_entry, buf, pool));
+  if (strcmp(buf->data, "lambda ") != 0)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Unexpected listing '%s'", buf->data);
+
+  svn_stringbuf_setempty(buf);
+  SVN_ERR(svn_ra_list(session, "A/D", youngest_rev, svn_depth_immediates,
+                      SVN_DIRENT_KIND, collect_list_entry, buf, pool));
+  if (strcmp(buf->data, "G/ H/ gamma ") != 0)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Unexpected listing '%s'", buf->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Test svn_ra_get_archive(). */
+static svn_error_t *
+archive_test(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_stringbuf_t *archive = svn_stringbuf_create("", pool);
+  svn_stringbuf_t *members = svn_stringbuf_create("", pool);
+  apr_size_t offset = 0;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-archive", opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, svn_repos_fs(repos), 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  SVN_ERR(svn_ra_initialize(pool));
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  SVN_ERR(svn_test__current_directory_url(&url, "test-repo-archive", pool));
+  SVN_ERR(svn_ra_open3(&session, url, NULL, cbtable, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_get_archive(session, "A/B", youngest_rev, "B",
+                             svn_stream_from_stringbuf(archive, pool),
+                             pool));
+
+  /* Walk the member headers, checking their checksums and collecting
+     their names, up to the end-of-archive marker. */
+  while (offset + 1024 <= archive->len)
+    {
+      const char *block = archive->data + offset;
+      apr_int64_t size;
+      apr_uint32_t sum = 0;
+      int i;
+
+      if (block[0] == '\0')
+        break;
+
+      for (i = 0; i < 512; i++)
+        sum += (i >= 148 && i < 156) ? ' ' : (unsigned char)block[i];
+      if (apr_strtoi64(apr_pstrndup(pool, block + 148, 6), NULL, 8) != sum)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Bad header checksum at offset %"
+                                 APR_SIZE_T_FMT, offset);
+
+      svn_stringbuf_appendcstr(members, apr_pstrndup(pool, block, 100));
+      svn_stringbuf_appendbytes(members, " ", 1);
+
+      size = apr_strtoi64(apr_pstrndup(pool, block + 124, 11), NULL, 8);
+      offset += 512 + (apr_size_t) ((size + 511) / 512 * 512);
+    }
+
+  if (strcmp(members->data, "B/ B/E/ B/E/alpha B/E/beta B/F/ B/lambda ") != 0)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Unexpected archive members '%s'",
+                             members->data);
+
+  if (offset + 1024 != archive->len)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Archive of %" APR_SIZE_T_FMT " bytes doesn't "
+                             "end after its members", archive->len);
+
+  return SVN_NO_ERROR;
+}
 
 
 /* The test table.  */
@@ -299,5 +517,11 @@ struct svn_test_descriptor_t test_funcs[] =
                    "svn_ra_local__split_URL: valid host names"),
     SVN_TEST_OPTS_PASS(split_url_test,
                        "test svn_ra_local__split_URL correctness"),
+    SVN_TEST_OPTS_PASS(stat_and_get_dir_many,
+                       "test svn_ra_stat_many and svn_ra_get_dir_many"),
+    SVN_TEST_OPTS_PASS(list_test,
+                       "test svn_ra_list"),
+    SVN_TEST_OPTS_PASS(archive_test,
+                       "test svn_ra_get_archive"),
     SVN_TEST_NULL
   };
@@ -33,7 +33,10 @@
 #include "svn_path.h"
 #include "svn_delta.h"
 #include "svn_config.h"
+#include "svn_dirent_uri.h"
+#include "svn_string.h"
 #include "svn_props.h"
+#include "svn_time.h"
 
 #include "../svn_test_fs.h"
 
@@ -442,6 +445,85 @@ node_tree_delete_under_copy(const svn_test_opts_t *opts,
 }
 
 
+static svn_error_t *
+replay_low_water_mark(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *revision_1_root, *revision_2_root;
+  svn_fs_root_t *revision_3_root;
+  svn_revnum_t youngest_rev;
+  void *edit_baton;
+  const svn_delta_editor_t *editor;
+  svn_repos_node_t *tree, *node;
+  svn_repos_node_t *dir_node = NULL, *file_node = NULL;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-replay-low-water-mark",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&revision_1_root, fs, youngest_rev, pool));
+
+  /* Revision 2:  Change iota, but leave A alone. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "changed\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&revision_2_root, fs, youngest_rev, pool));
+
+  /* Revision 3:  Copy both of them from revision 1. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_copy(revision_1_root, "A", txn_root, "Z", pool));
+  SVN_ERR(svn_fs_copy(revision_1_root, "iota", txn_root, "iota2", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&revision_3_root, fs, youngest_rev, pool));
+
+  /* Replay revision 3 to a receiver that knows revision 2 and later. */
+  SVN_ERR(svn_repos_node_editor(&editor, &edit_baton, repos,
+                                revision_2_root, revision_3_root,
+                                pool, subpool));
+  SVN_ERR(svn_repos_replay2(revision_3_root, "", 2, FALSE,
+                            editor, edit_baton, NULL, NULL, subpool));
+  tree = svn_repos_node_from_baton(edit_baton);
+  svn_pool_destroy(subpool);
+
+  for (node = tree->child; node; node = node->sibling)
+    {
+      if (strcmp(node->name, "Z") == 0)
+        dir_node = node;
+      else if (strcmp(node->name, "iota2") == 0)
+        file_node = node;
+    }
+
+  /* A is the same in revision 2, so it still gets copied, only from
+     there; iota is not, so it has to be sent in full. */
+  if (! dir_node
+      || dir_node->copyfrom_rev != 2
+      || ! dir_node->copyfrom_path
+      || strcmp(dir_node->copyfrom_path, "/A") != 0
+      || dir_node->child)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "Copy of an unchanged directory got expanded");
+
+  if (! file_node
+      || SVN_IS_VALID_REVNUM(file_node->copyfrom_rev)
+      || ! file_node->text_mod)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "Copy of a changed file not sent in full");
+
+  return SVN_NO_ERROR;
+}
+
+
 /* Helper for revisions_changed(). */
 static const char *
 print_chrevs(const apr_array_header_t *revs_got,
@@ -1151,6 +1233,33 @@ authz(apr_pool_t *pool)
     /* Sentinel */
     { NULL, NULL, svn_authz_none, FALSE }
   };
+  /* The paths and expected replies for phase 4, which uses groups,
+     aliases, inverted rules and tokens, and several users in turn. */
+  struct
+  {
+    const char *path;
+    const char *user;
+    const svn_repos_authz_access_t required;
+    const svn_boolean_t expected;
+  } test_set4[] = {
+    /* Group members reached through subgroups and aliases. */
+    { "/A", "socrates", svn_authz_write, TRUE },
+    { "/A", "aristotle", svn_authz_write, TRUE },
+    /* Inverted rules apply to anonymous users as well. */
+    { "/A", NULL, svn_authz_write, FALSE },
+    { "/A", NULL, svn_authz_read, TRUE },
+    /* An explicit grant wins over a denial from another rule. */
+    { "/A/B", "socrates", svn_authz_read, TRUE },
+    { "/A/B", "socrates", svn_authz_write, FALSE },
+    { "/A/B", "plato", svn_authz_read, TRUE },
+    { "/A/B/C", NULL, svn_authz_read, TRUE },
+    /* Section names are case-insensitive. */
+    { "/case", NULL, svn_authz_read, TRUE },
+    { "/A", "plato", svn_authz_read | svn_authz_recursive, TRUE },
+    { "/A", "plato", svn_authz_write | svn_authz_recursive, FALSE },
+    { NULL, "socrates", svn_authz_write, TRUE },
+    { NULL, "nobody", svn_authz_write, FALSE },
+  };
 
   /* The test logic:
    *
@@ -1291,6 +1400,61 @@ authz(apr_pool_t *pool)
                             "Regression: incomplete ancestry test "
                             "for recursive access lookup.");
 
+  /* The authz rules for the phase 4 tests */
+  contents =
+    "[aliases]"                                                              NL
+    "sage = socrates"                                                        NL
+    ""                                                                       NL
+    "[groups]"                                                               NL
+    "philosophers = &sage, plato"                                            NL
+    "academy = @philosophers, aristotle"                                     NL
+    ""                                                                       NL
+    "[greek:/A]"                                                             NL
+    "@academy = rw"                                                          NL
+    "~@philosophers = r"                                                     NL
+    ""                                                                       NL
+    "[/A/B]"                                                                 NL
+    "&sage ="                                                                NL
+    "$authenticated = r"                                                     NL
+    ""                                                                       NL
+    "[greek:/Case]"                                                          NL
+    "* = r"                                                                  NL;
+
+  /* Load the test authz rules. */
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, subpool));
+
+  /* Go through the checks twice, so that the second time around they
+     are answered from the rules already resolved for each user. */
+  for (i = 0; i < 2 * (int)(sizeof(test_set4) / sizeof(test_set4[0])); i++)
+    {
+      int j = i % (int)(sizeof(test_set4) / sizeof(test_set4[0]));
+
+      SVN_ERR(svn_repos_authz_check_access(authz_cfg, "greek",
+                                           test_set4[j].path,
+                                           test_set4[j].user,
+                                           test_set4[j].required,
+                                           &access_granted, subpool));
+
+      if (access_granted != test_set4[j].expected)
+        {
+          return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                   "Authz incorrectly %s %s%s access "
+                                   "to greek:%s for user %s",
+                                   access_granted ?
+                                   "grants" : "denies",
+                                   test_set4[j].required
+                                   & svn_authz_recursive ?
+                                   "recursive " : "",
+                                   test_set4[j].required
+                                   & svn_authz_write ?
+                                   "write" : "read",
+                                   test_set4[j].path ?
+                                   test_set4[j].path : "(any)",
+                                   test_set4[j].user ?
+                                   test_set4[j].user : "-");
+        }
+    }
+
   /* That's a wrap! */
   svn_pool_destroy(subpool);
   return SVN_NO_ERROR;
@@ -2107,6 +2271,211 @@ reporter_depth_exclude(const svn_test_opts_t *opts,
 }
 
 
+/* Test that the reporter updates a mixed-revision working copy, whose
+   parts are unchanged in some of the revisions it updates across. */
+static svn_error_t *
+reporter_mixed_revisions(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *r1_root, *r2_root;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-reporter-mixed-revs",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Revision 2: change mu and something below A/D. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  {
+    static svn_test__txn_script_command_t script_entries[] = {
+      { 'e', "A/mu",      "Changed file 'mu'.\n" },
+      { 'e', "A/D/gamma", "Changed file 'gamma'.\n" },
+    };
+    SVN_ERR(svn_test__txn_script_exec(txn_root,
+                                      script_entries,
+                                      sizeof(script_entries)/
+                                       sizeof(script_entries[0]),
+                                      subpool));
+  }
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Revision 3: replace A/D/H with a copy of A/B/E and change iota. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&r2_root, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D/H", subpool));
+  SVN_ERR(svn_fs_copy(r2_root, "A/B/E", txn_root, "A/D/H", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                      "Changed file 'iota'.\n", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Build the working copy in a txn: r3, except for A/mu from r1 and
+     A/D from r2. */
+  SVN_ERR(svn_fs_revision_root(&r1_root, fs, 1, subpool));
+  SVN_ERR(svn_fs_revision_root(&r2_root, fs, 2, subpool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/mu", subpool));
+  SVN_ERR(svn_fs_copy(r1_root, "A/mu", txn_root, "A/mu", subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D", subpool));
+  SVN_ERR(svn_fs_copy(r2_root, "A/D", txn_root, "A/D", subpool));
+
+  /* Update it to r3, recording the editor commands in the txn. */
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                               txn_root, "", subpool));
+  SVN_ERR(svn_repos_begin_report2(&report_baton, 3, repos, "/", "", NULL,
+                                  TRUE, svn_depth_infinity, FALSE, FALSE,
+                                  editor, edit_baton, NULL, NULL, subpool));
+  SVN_ERR(svn_repos_set_path3(report_baton, "", 3,
+                              svn_depth_infinity,
+                              FALSE, NULL, subpool));
+  SVN_ERR(svn_repos_set_path3(report_baton, "A/mu", 1,
+                              svn_depth_infinity,
+                              FALSE, NULL, subpool));
+  SVN_ERR(svn_repos_set_path3(report_baton, "A/D", 2,
+                              svn_depth_infinity,
+                              FALSE, NULL, subpool));
+  SVN_ERR(svn_repos_finish_report(report_baton, subpool));
+
+  /* Confirm that the txn now looks like r3. */
+  {
+    static svn_test__tree_entry_t entries[] = {
+      { "iota",        "Changed file 'iota'.\n" },
+      { "A",           0 },
+      { "A/mu",        "Changed file 'mu'.\n" },
+      { "A/B",         0 },
+      { "A/B/lambda",  "This is the file 'lambda'.\n" },
+      { "A/B/E",       0 },
+      { "A/B/E/alpha", "This is the file 'alpha'.\n" },
+      { "A/B/E/beta",  "This is the file 'beta'.\n" },
+      { "A/B/F",       0 },
+      { "A/C",         0 },
+      { "A/D",         0 },
+      { "A/D/gamma",   "Changed file 'gamma'.\n" },
+      { "A/D/G",       0 },
+      { "A/D/G/pi",    "This is the file 'pi'.\n" },
+      { "A/D/G/rho",   "This is the file 'rho'.\n" },
+      { "A/D/G/tau",   "This is the file 'tau'.\n" },
+      { "A/D/H",       0 },
+      { "A/D/H/alpha", "This is the file 'alpha'.\n" },
+      { "A/D/H/beta",  "This is the file 'beta'.\n" }
+    };
+    SVN_ERR(svn_test__validate_tree(txn_root,
+                                    entries,
+                                    sizeof(entries)/sizeof(entries[0]),
+                                    subpool));
+  }
+
+  svn_error_clear(svn_fs_abort_txn(txn, subpool));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Test that the reporter copes with a report too large to keep in
+   memory. */
+static svn_error_t *
+reporter_large_report(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+  svn_stringbuf_t *token;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-reporter-large-report",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* A lock token larger than any report we keep in memory. */
+  token = svn_stringbuf_create("opaquelocktoken:", subpool);
+  while (token->len < 100 * 1024)
+    svn_stringbuf_appendcstr(token, "0123456789abcdef");
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                               txn_root, "", subpool));
+  SVN_ERR(svn_repos_begin_report2(&report_baton, youngest_rev, repos,
+                                  "/", "", NULL, TRUE, svn_depth_infinity,
+                                  FALSE, FALSE, editor, edit_baton,
+                                  NULL, NULL, subpool));
+  SVN_ERR(svn_repos_set_path3(report_baton, "", youngest_rev,
+                              svn_depth_infinity,
+                              FALSE, NULL, subpool));
+  SVN_ERR(svn_repos_set_path3(report_baton, "A/mu", youngest_rev,
+                              svn_depth_infinity,
+                              FALSE, token->data, subpool));
+  SVN_ERR(svn_repos_set_path3(report_baton, "iota", youngest_rev,
+                              svn_depth_infinity,
+                              FALSE, NULL, subpool));
+  SVN_ERR(svn_repos_finish_report(report_baton, subpool));
+
+  /* Nothing changed, so the txn still has the greek tree. */
+  {
+    static svn_test__tree_entry_t entries[] = {
+      { "iota",        "This is the file 'iota'.\n" },
+      { "A",           0 },
+      { "A/mu",        "This is the file 'mu'.\n" },
+      { "A/B",         0 },
+      { "A/B/lambda",  "This is the file 'lambda'.\n" },
+      { "A/B/E",       0 },
+      { "A/B/E/alpha", "This is the file 'alpha'.\n" },
+      { "A/B/E/beta",  "This is the file 'beta'.\n" },
+      { "A/B/F",       0 },
+      { "A/C",         0 },
+      { "A/D",         0 },
+      { "A/D/gamma",   "This is the file 'gamma'.\n" },
+      { "A/D/G",       0 },
+      { "A/D/G/pi",    "This is the file 'pi'.\n" },
+      { "A/D/G/rho",   "This is the file 'rho'.\n" },
+      { "A/D/G/tau",   "This is the file 'tau'.\n" },
+      { "A/D/H",       0 },
+      { "A/D/H/chi",   "This is the file 'chi'.\n" },
+      { "A/D/H/psi",   "This is the file 'psi'.\n" },
+      { "A/D/H/omega", "This is the file 'omega'.\n" }
+    };
+    SVN_ERR(svn_test__validate_tree(txn_root,
+                                    entries,
+                                    sizeof(entries)/sizeof(entries[0]),
+                                    subpool));
+  }
+
+  svn_error_clear(svn_fs_abort_txn(txn, subpool));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /* Test if prop values received by the server are validated.
  * These tests "send" property values to the server and diagnose the
@@ -2337,6 +2706,161 @@ get_logs(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+
+/* Log receiver which appends the revision number to the svn_stringbuf_t *
+   BATON. */
+static svn_error_t *
+log_rev_receiver(void *baton,
+                 svn_log_entry_t *log_entry,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *revs = baton;
+
+  svn_stringbuf_appendcstr(revs, apr_psprintf(pool, " %ld",
+                                              log_entry->revision));
+  return SVN_NO_ERROR;
+}
+
+/* Set *RESULT to the revisions logged for each set of paths in PATHS,
+   a NULL-terminated list of space-separated paths, once following copies
+   and once not, in the repository at REPOS_PATH.  Allocate *RESULT in
+   POOL. */
+static svn_error_t *
+logged_revisions(svn_stringbuf_t **result,
+                 const char *repos_path,
+                 const char *const *paths,
+                 apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_repos_t *repos;
+  int strict;
+
+  *result = svn_stringbuf_create("", pool);
+
+  /* Close the repository again when done, so its index may be removed. */
+  SVN_ERR(svn_repos_open(&repos, repos_path, subpool));
+  for (; *paths; paths++)
+    for (strict = 0; strict <= 1; strict++)
+      {
+        apr_array_header_t *targets = svn_cstring_split(*paths, " ", TRUE,
+                                                        subpool);
+
+        svn_stringbuf_appendcstr(*result, apr_psprintf(subpool, "\n%s%s:",
+                                                       *paths,
+                                                       strict ? " (strict)"
+                                                              : ""));
+        SVN_ERR(svn_repos_get_logs4(repos, targets, SVN_INVALID_REVNUM, 0,
+                                    0, FALSE, strict, FALSE, NULL, NULL,
+                                    NULL, log_rev_receiver, *result,
+                                    subpool));
+      }
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_logs_indexed(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *indexed, *walked;
+  const char *index_path;
+  svn_node_kind_t kind;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  const char *const paths[] = {
+    "/", "A", "A/mu", "A/C", "A/D/gamma", "A2", "A2/mu", "A2/B",
+    "A2/B/E/alpha", "A2/D/G", "iota", "A/mu iota", "A2/B/lambda A/D",
+    NULL };
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 7)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-get-logs-indexed",
+                                 opts, subpool));
+  fs = svn_repos_fs(repos);
+  index_path = svn_dirent_join(svn_fs_path(fs, pool), "log-index.db", pool);
+
+  /* r1: The greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* r2: Tweak A/mu and A/B/E/alpha. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "r2", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/alpha", "r2",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* r3: Copy A to A2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_copy(root, "A", txn_root, "A2", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* r4: Tweak A2/mu and A/D/gamma. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A2/mu", "r4", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/gamma", "r4",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* r5: Replace A/C without history and tweak iota. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/C", subpool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A/C", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "r5", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* r6: Replace A2/B/E/alpha with a copy of A/mu and A2/D/G with one of
+     A/D/G, and tweak A2/B/lambda. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A2/B/E/alpha", subpool));
+  SVN_ERR(svn_fs_copy(root, "A/mu", txn_root, "A2/B/E/alpha", subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A2/D/G", subpool));
+  SVN_ERR(svn_fs_copy(root, "A/D/G", txn_root, "A2/D/G", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A2/B/lambda", "r6",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* r7: Tweak A2/B/E/alpha and A/D/G/pi. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A2/B/E/alpha", "r7",
+                                      subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/pi", "r7", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_destroy(subpool);
+
+  /* The logs must be the same as those from walking the node history,
+     which happens once the index has been removed. */
+  SVN_ERR(svn_io_check_path(index_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(logged_revisions(&indexed, "test-repo-get-logs-indexed", paths,
+                           pool));
+
+  SVN_ERR(svn_io_remove_file2(index_path, FALSE, pool));
+  SVN_ERR(logged_revisions(&walked, "test-repo-get-logs-indexed", paths,
+                           pool));
+  SVN_TEST_STRING_ASSERT(indexed->data, walked->data);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Tests for svn_repos_get_file_revsN() */
 
@@ -2450,6 +2974,265 @@ test_get_file_revs(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Tests for svn_repos_get_file_blame() */
+struct blame_chunk_t
+{
+  svn_linenum_t start_line;
+  svn_revnum_t revision;
+};
+
+static svn_error_t *
+blame_chunk_receiver(void *baton,
+                     svn_linenum_t start_line,
+                     svn_revnum_t revision,
+                     apr_hash_t *rev_props,
+                     apr_pool_t *pool)
+{
+  apr_array_header_t *chunks = baton;
+  struct blame_chunk_t *chunk = apr_array_push(chunks);
+
+  if (SVN_IS_VALID_REVNUM(revision) != (rev_props != NULL))
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Unexpected revision properties for r%ld",
+                             revision);
+
+  chunk->start_line = start_line;
+  chunk->revision = revision;
+  return SVN_NO_ERROR;
+}
+
+/* Check that CHUNKS holds the NUM_EXPECTED chunks EXPECTED. */
+static svn_error_t *
+check_blame_chunks(const apr_array_header_t *chunks,
+                   const struct blame_chunk_t *expected,
+                   int num_expected)
+{
+  int i;
+
+  if (chunks->nelts != num_expected)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Got %d blame chunks, expected %d",
+                             chunks->nelts, num_expected);
+
+  for (i = 0; i < num_expected; i++)
+    {
+      struct blame_chunk_t *chunk = &APR_ARRAY_IDX(chunks, i,
+                                                   struct blame_chunk_t);
+
+      if (chunk->start_line != expected[i].start_line
+          || chunk->revision != expected[i].revision)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Blame chunk %d is line %lu, r%ld; "
+                                 "expected line %lu, r%ld", i,
+                                 chunk->start_line, chunk->revision,
+                                 expected[i].start_line,
+                                 expected[i].revision);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_get_file_blame(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_array_header_t *chunks;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_error_t *err;
+  const struct blame_chunk_t all_results[] = {
+    { 0, 2 },
+    { 1, 3 },
+  };
+  const struct blame_chunk_t partial_results[] = {
+    { 0, SVN_INVALID_REVNUM },
+    { 1, 3 },
+  };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-get-file-blame",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 2:  Replace the contents of A/mu. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                      "line 1\nline 2\nline 3\n", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 3:  Change a line of A/mu and append one. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                      "line 1\nLINE 2\nline 3\nline 4\n",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 4:  Leave A/mu alone. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "Revision 4\n",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revision 5:  Delete a line of A/mu, joining two chunks of r3. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                      "line 1\nLINE 2\nline 4\n", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  chunks = apr_array_make(pool, 4, sizeof(struct blame_chunk_t));
+  SVN_ERR(svn_repos_get_file_blame(repos, "/A/mu", 0, youngest_rev, NULL,
+                                   FALSE, NULL, NULL,
+                                   blame_chunk_receiver, chunks, subpool));
+  SVN_ERR(check_blame_chunks(chunks, all_results,
+                             sizeof(all_results) / sizeof(all_results[0])));
+
+  /* Lines last changed before the start revision have no revision. */
+  apr_array_clear(chunks);
+  SVN_ERR(svn_repos_get_file_blame(repos, "/A/mu", 3, youngest_rev, NULL,
+                                   FALSE, NULL, NULL,
+                                   blame_chunk_receiver, chunks, subpool));
+  SVN_ERR(check_blame_chunks(chunks, partial_results,
+                             sizeof(partial_results)
+                             / sizeof(partial_results[0])));
+
+  /* Revision 6:  Make A/mu binary. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/mu", SVN_PROP_MIME_TYPE,
+                                  svn_string_create("image/jpeg", subpool),
+                                  subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  err = svn_repos_get_file_blame(repos, "/A/mu", 0, youngest_rev, NULL,
+                                 FALSE, NULL, NULL,
+                                 blame_chunk_receiver, chunks, subpool);
+  SVN_TEST_ASSERT(err && err->apr_err == SVN_ERR_CLIENT_IS_BINARY_FILE);
+  svn_error_clear(err);
+
+  apr_array_clear(chunks);
+  SVN_ERR(svn_repos_get_file_blame(repos, "/A/mu", 0, youngest_rev, NULL,
+                                   TRUE, NULL, NULL,
+                                   blame_chunk_receiver, chunks, subpool));
+  SVN_ERR(check_blame_chunks(chunks, all_results,
+                             sizeof(all_results) / sizeof(all_results[0])));
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Check that svn_repos_dated_revision() in REPOS, whose revisions 0 to
+   NUM_REVS - 1 are dated BASE + DATES[rev] * STEP / 2, resolves all
+   times from a step before r0 to a step after the youngest revision,
+   in half steps, to the youngest revision not younger than them. */
+static svn_error_t *
+check_dated_revisions(svn_repos_t *repos,
+                      apr_time_t base,
+                      apr_time_t step,
+                      const int *dates,
+                      int num_revs,
+                      apr_pool_t *pool)
+{
+  int k;
+
+  for (k = -2; k <= dates[num_revs - 1] + 2; k++)
+    {
+      apr_time_t tm = base + k * (step / 2);
+      svn_revnum_t rev = SVN_INVALID_REVNUM;
+      svn_revnum_t expected = 0;
+      int i;
+
+      for (i = 0; i < num_revs; i++)
+        if (dates[i] <= k)
+          expected = i;
+
+      SVN_ERR(svn_repos_dated_revision(&rev, repos, tm, pool));
+      if (rev != expected)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "time %s resolved to r%ld instead of r%ld",
+                                 svn_time_to_cstring(tm, pool),
+                                 rev, expected);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+dated_revision(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_revnum_t youngest_rev = 0;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  apr_time_t base = apr_time_from_sec(1000000000);
+  apr_time_t step = apr_time_from_sec(10);
+  /* The dates of r0 to r6, in half steps from BASE. */
+  int dates[] = { 0, 2, 4, 6, 8, 10, 12 };
+  svn_revnum_t rev;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-dated-revision",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Six empty revisions, dated a step apart. */
+  while (youngest_rev < 6)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      subpool));
+      svn_pool_clear(subpool);
+    }
+
+  for (rev = 0; rev <= youngest_rev; rev++)
+    {
+      const char *date = svn_time_to_cstring(base + dates[rev] * (step / 2),
+                                             subpool);
+
+      SVN_ERR(svn_fs_change_rev_prop(fs, rev, SVN_PROP_REVISION_DATE,
+                                     svn_string_create(date, subpool),
+                                     subpool));
+      svn_pool_clear(subpool);
+    }
+  SVN_ERR(check_dated_revisions(repos, base, step, dates, 7, pool));
+
+  /* Move r3 half a step later. */
+  dates[3] = 7;
+  SVN_ERR(svn_fs_change_rev_prop(fs, 3, SVN_PROP_REVISION_DATE,
+                                 svn_string_create(
+                                   svn_time_to_cstring(
+                                     base + dates[3] * (step / 2), pool),
+                                   pool),
+                                 pool));
+  SVN_ERR(check_dated_revisions(repos, base, step, dates, 7, pool));
+
+  /* Without the FSFS date index, the answers stay the same. */
+  if (strcmp(opts->fs_type, "fsfs") == 0)
+    {
+      SVN_ERR(svn_io_remove_file2(svn_dirent_join(svn_fs_path(fs, pool),
+                                                  "rev-dates", pool),
+                                  FALSE, pool));
+      SVN_ERR(check_dated_revisions(repos, base, step, dates, 7, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -2460,6 +3243,8 @@ struct svn_test_descriptor_t test_funcs[] =
                        "test svn_repos_dir_delta2"),
     SVN_TEST_OPTS_PASS(node_tree_delete_under_copy,
                        "test deletions under copies in node_tree code"),
+    SVN_TEST_OPTS_PASS(replay_low_water_mark,
+                       "test replaying copies older than the low water mark"),
     SVN_TEST_OPTS_PASS(revisions_changed,
                        "test svn_repos_history() (partially)"),
     SVN_TEST_OPTS_PASS(node_locations,
@@ -2478,11 +3263,21 @@ struct svn_test_descriptor_t test_funcs[] =
                        "test svn_repos_node_location_segments"),
     SVN_TEST_OPTS_PASS(reporter_depth_exclude,
                        "test reporter and svn_depth_exclude"),
+    SVN_TEST_OPTS_PASS(reporter_mixed_revisions,
+                       "test reporting a mixed-revision working copy"),
+    SVN_TEST_OPTS_PASS(reporter_large_report,
+                       "test a report too large to keep in memory"),
     SVN_TEST_OPTS_PASS(prop_validation,
                        "test if revprops are validated by repos"),
     SVN_TEST_OPTS_PASS(get_logs,
                        "test svn_repos_get_logs ranges and limits"),
+    SVN_TEST_OPTS_PASS(get_logs_indexed,
+                       "test svn_repos_get_logs with a log index"),
     SVN_TEST_OPTS_PASS(test_get_file_revs,
                        "test svn_repos_get_file_revsN"),
+    SVN_TEST_OPTS_PASS(test_get_file_blame,
+                       "test svn_repos_get_file_blame"),
+    SVN_TEST_OPTS_PASS(dated_revision,
+                       "test svn_repos_dated_revision"),
     SVN_TEST_NULL
   };
@@ -0,0 +1,181 @@
+/*
+ * base64-test.c:  tests the base64 encoding and decoding functions.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_base64.h"
+
+#include "../svn_test.h"
+
+static svn_error_t *
+test_base64_vectors(apr_pool_t *pool)
+{
+  static const struct {
+    const char *plain;
+    const char *encoded;
+  } vectors[] = {
+    { "", "" },
+    { "f", "Zg==" },
+    { "fo", "Zm8=" },
+    { "foo", "Zm9v" },
+    { "foob", "Zm9vYg==" },
+    { "fooba", "Zm9vYmE=" },
+    { "foobar", "Zm9vYmFy" },
+  };
+  apr_size_t i;
+
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+    {
+      const svn_string_t *result;
+
+      result = svn_base64_encode_string2(
+                 svn_string_create(vectors[i].plain, pool), FALSE, pool);
+      if (strcmp(result->data, vectors[i].encoded) != 0)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Encoding '%s' gave '%s', expected '%s'",
+                                 vectors[i].plain, result->data,
+                                 vectors[i].encoded);
+
+      result = svn_base64_decode_string(
+                 svn_string_create(vectors[i].encoded, pool), pool);
+      if (strcmp(result->data, vectors[i].plain) != 0)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Decoding '%s' gave '%s', expected '%s'",
+                                 vectors[i].encoded, result->data,
+                                 vectors[i].plain);
+    }
+
+  /* Line breaks and other characters outside of the alphabet are
+     skipped wherever they are. */
+  {
+    const svn_string_t *result
+      = svn_base64_decode_string(svn_string_create("Zm\n9v\r\nYm Fy\n",
+                                                   pool), pool);
+
+    if (strcmp(result->data, "foobar") != 0)
+      return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                               "Decoding with line breaks gave '%s'",
+                               result->data);
+  }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the LEN bytes at DATA to STREAM in chunks of at most CHUNK
+   bytes, then close STREAM. */
+static svn_error_t *
+write_in_chunks(svn_stream_t *stream,
+                const char *data,
+                apr_size_t len,
+                apr_size_t chunk)
+{
+  while (len > 0)
+    {
+      apr_size_t n = len < chunk ? len : chunk;
+
+      SVN_ERR(svn_stream_write(stream, data, &n));
+      data += n;
+      len -= n;
+    }
+
+  return svn_stream_close(stream);
+}
+
+static svn_error_t *
+test_base64_streams(apr_pool_t *pool)
+{
+  static const apr_size_t lengths[] = { 0, 1, 2, 3, 56, 57, 58, 1000, 4099 };
+  static const apr_size_t chunks[] = { 1, 2, 3, 4, 5, 76, 77, 1024 };
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_size_t i, j, k;
+
+  for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+    for (j = 0; j < sizeof(chunks) / sizeof(chunks[0]); j++)
+      {
+        svn_stringbuf_t *plain, *encoded, *decoded;
+        const svn_string_t *expected;
+
+        svn_pool_clear(iterpool);
+
+        plain = svn_stringbuf_create("", iterpool);
+        for (k = 0; k < lengths[i]; k++)
+          {
+            char c = (char)((k * 131 + 7) & 0xff);
+
+            svn_stringbuf_appendbytes(plain, &c, 1);
+          }
+
+        /* Encoding through a stream, whatever the chunk size, gives the
+           same result as encoding in one go. */
+        encoded = svn_stringbuf_create("", iterpool);
+        SVN_ERR(write_in_chunks(
+                  svn_base64_encode(svn_stream_from_stringbuf(encoded,
+                                                              iterpool),
+                                    iterpool),
+                  plain->data, plain->len, chunks[j]));
+
+        expected = svn_base64_encode_string2(
+                     svn_string_ncreate(plain->data, plain->len, iterpool),
+                     TRUE, iterpool);
+        if (encoded->len != expected->len
+            || memcmp(encoded->data, expected->data, expected->len) != 0)
+          return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                   "Encoding %" APR_SIZE_T_FMT " bytes in "
+                                   "chunks of %" APR_SIZE_T_FMT " differs",
+                                   lengths[i], chunks[j]);
+
+        /* And decoding it again gives back the original data. */
+        decoded = svn_stringbuf_create("", iterpool);
+        SVN_ERR(write_in_chunks(
+                  svn_base64_decode(svn_stream_from_stringbuf(decoded,
+                                                              iterpool),
+                                    iterpool),
+                  encoded->data, encoded->len, chunks[j]));
+
+        if (decoded->len != plain->len
+            || memcmp(decoded->data, plain->data, plain->len) != 0)
+          return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                   "Decoding %" APR_SIZE_T_FMT " bytes in "
+                                   "chunks of %" APR_SIZE_T_FMT " differs",
+                                   lengths[i], chunks[j]);
+      }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* An array of all test functions */
+struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_base64_vectors,
+                   "base64 encoding and decoding of known values"),
+    SVN_TEST_PASS2(test_base64_streams,
+                   "base64 streams with various write sizes"),
+    SVN_TEST_NULL
+  };
@@ -30,6 +30,7 @@
 #include "svn_pools.h"
 
 #include "private/svn_cache.h"
+#include "private/svn_temp_serializer.h"
 #include "svn_private_config.h"
 
 #include "../svn_test.h"
@@ -67,7 +68,7 @@ serialize_revnum(char **data,
 /* Implements svn_cache__deserialize_func_t */
 static svn_error_t *
 deserialize_revnum(void **out,
-                   const char *data,
+                   char *data,
                    apr_size_t data_len,
                    apr_pool_t *pool)
 {
@@ -155,6 +156,425 @@ test_inprocess_cache_basic(apr_pool_t *pool)
   return basic_cache_test(cache, TRUE, pool);
 }
 
+static svn_error_t *
+test_membuffer_cache_basic(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1024,
+                                            TRUE, FALSE, pool));
+
+  /* Create a cache with just one entry. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            pool));
+
+  return basic_cache_test(cache, FALSE, pool);
+}
+
+static svn_error_t *
+test_membuffer_cache_eviction(apr_pool_t *pool)
+{
+  svn_cache__t *cache, *other_cache;
+  svn_membuffer_t *membuffer;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t i, *answer;
+  svn_boolean_t found;
+
+  /* A tiny membuffer that will have to evict most of what we put in. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 8*1024, 1024,
+                                            TRUE, FALSE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(i), "first:", pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&other_cache, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(i), "second:", pool));
+
+  for (i = 0; i < 10000; ++i)
+    {
+      svn_revnum_t hot = 0;
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_cache__set(cache, &i, &i, iterpool));
+
+      /* Whatever we get back must be correct. */
+      SVN_ERR(svn_cache__get((void **) &answer, &found, cache, &i,
+                             iterpool));
+      if (found && *answer != i)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "expected %ld but found '%ld'", i, *answer);
+
+      /* Caches sharing a membuffer must not see each other's entries. */
+      SVN_ERR(svn_cache__get((void **) &answer, &found, other_cache, &i,
+                             iterpool));
+      if (found)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "found entry '%ld' in the wrong cache", i);
+
+      /* A frequently used entry should survive. */
+      SVN_ERR(svn_cache__get((void **) &answer, &found, cache, &hot,
+                             iterpool));
+      if (!found)
+        SVN_ERR(svn_cache__set(cache, &hot, &hot, iterpool));
+      else if (*answer != 0)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "expected 0 but found '%ld'", *answer);
+    }
+
+  i = 0;
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, &i, iterpool));
+  if (!found)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "frequently used entry got evicted");
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__partial_getter_func_t.  Return the serialized
+ * revision number plus the offset given in BATON. */
+static svn_error_t *
+get_revnum_plus(void **out,
+                const char *data,
+                apr_size_t data_len,
+                void *baton,
+                apr_pool_t *pool)
+{
+  svn_revnum_t *rev = apr_palloc(pool, sizeof(*rev));
+
+  if (data_len != sizeof(*rev))
+    return svn_error_create(SVN_ERR_REVNUM_PARSE_FAILURE, NULL,
+                            _("Bad size for revision number in cache"));
+
+  memcpy(rev, data, sizeof(*rev));
+  *rev += *(svn_revnum_t *)baton;
+  *out = rev;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_cache_get_partial(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_revnum_t rev = 42, offset = 100, *answer;
+  svn_boolean_t found;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 64*1024, 0,
+                                            TRUE, FALSE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "partial:", pool));
+
+  SVN_ERR(svn_cache__get_partial((void **) &answer, &found, cache, "one",
+                                 get_revnum_plus, &offset, pool));
+  if (found)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "found entry in empty cache");
+
+  SVN_ERR(svn_cache__set(cache, "one", &rev, pool));
+  SVN_ERR(svn_cache__get_partial((void **) &answer, &found, cache, "one",
+                                 get_revnum_plus, &offset, pool));
+  if (! found || *answer != rev + offset)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "partial getter returned wrong value");
+
+  /* In-process caches don't support partial access. */
+  SVN_ERR(svn_cache__create_inprocess(&cache, dup_revnum,
+                                      APR_HASH_KEY_STRING,
+                                      1, 1, TRUE, pool));
+  SVN_ERR(svn_cache__set(cache, "one", &rev, pool));
+  SVN_ERR(svn_cache__get_partial((void **) &answer, &found, cache, "one",
+                                 get_revnum_plus, &offset, pool));
+  if (found)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "in-process cache supports partial getters");
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that the counters in INFO match the expected values. */
+static svn_error_t *
+check_cache_info(const svn_cache__info_t *info,
+                 apr_uint64_t gets,
+                 apr_uint64_t hits,
+                 apr_uint64_t sets,
+                 apr_uint64_t evictions,
+                 apr_uint64_t used_entries)
+{
+  if (info->gets != gets || info->hits != hits || info->sets != sets
+      || info->evictions != evictions || info->used_entries != used_entries)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "unexpected cache statistics: %s",
+                             svn_cache__format_info("test", info,
+                                                    svn_pool_create(NULL))
+                               ->data);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_cache_info(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_cache__info_t info;
+  svn_revnum_t i, *answer;
+  svn_boolean_t found;
+
+  /* Two pages of one entry each. */
+  SVN_ERR(svn_cache__create_inprocess(&cache, dup_revnum, sizeof(i),
+                                      2, 1, TRUE, pool));
+  for (i = 0; i < 3; ++i)
+    SVN_ERR(svn_cache__set(cache, &i, &i, pool));
+  for (i = 0; i < 3; ++i)
+    SVN_ERR(svn_cache__get((void **) &answer, &found, cache, &i, pool));
+
+  SVN_ERR(svn_cache__get_info(cache, &info, TRUE, pool));
+  SVN_ERR(check_cache_info(&info, 3, 2, 3, 1, 2));
+  if (info.total_entries != 2)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "wrong inprocess cache capacity");
+
+  /* The counters have been reset. */
+  SVN_ERR(svn_cache__get_info(cache, &info, FALSE, pool));
+  SVN_ERR(check_cache_info(&info, 0, 0, 0, 0, 2));
+
+  /* Membuffer totals cover all caches using it. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 64*1024, 0,
+                                            TRUE, FALSE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(i), "info:", pool));
+  for (i = 0; i < 4; ++i)
+    SVN_ERR(svn_cache__set(cache, &i, &i, pool));
+  for (i = 0; i < 8; ++i)
+    SVN_ERR(svn_cache__get((void **) &answer, &found, cache, &i, pool));
+
+  SVN_ERR(svn_cache__get_info(cache, &info, FALSE, pool));
+  SVN_ERR(check_cache_info(&info, 8, 4, 4, 0, 4));
+  SVN_ERR(svn_cache__membuffer_get_info(membuffer, &info, TRUE, pool));
+  SVN_ERR(check_cache_info(&info, 8, 4, 4, 0, 4));
+  if (info.used_size != 4 * sizeof(i) || info.total_size == 0)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "wrong membuffer size statistics");
+
+  SVN_ERR(svn_cache__membuffer_get_info(membuffer, &info, FALSE, pool));
+  SVN_ERR(check_cache_info(&info, 0, 0, 0, 0, 4));
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the revnums 1 to 3 under themselves in CACHE, look up the keys
+   1, 4, 3 and 1 again with a single svn_cache__get_many call and verify
+   the results and the access counters. */
+static svn_error_t *
+get_many_cache_test(svn_cache__t *cache,
+                    apr_pool_t *pool)
+{
+  svn_revnum_t revs[] = { 1, 4, 3, 1 };
+  const void *keys[4];
+  void *values[4];
+  svn_boolean_t found[4];
+  svn_cache__info_t info;
+  svn_revnum_t i;
+
+  for (i = 1; i <= 3; ++i)
+    SVN_ERR(svn_cache__set(cache, &i, &i, pool));
+  for (i = 0; i < 4; ++i)
+    keys[i] = &revs[i];
+
+  SVN_ERR(svn_cache__get_info(cache, &info, TRUE, pool));
+  SVN_ERR(svn_cache__get_many(values, found, cache, keys, 4, pool));
+
+  for (i = 0; i < 4; ++i)
+    {
+      if (found[i] != (revs[i] != 4))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "wrong lookup result for key %ld",
+                                 revs[i]);
+      if (found[i] && *(svn_revnum_t *)values[i] != revs[i])
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "expected %ld but found %ld", revs[i],
+                                 *(svn_revnum_t *)values[i]);
+    }
+
+  SVN_ERR(svn_cache__get_info(cache, &info, FALSE, pool));
+  if (info.gets != 4 || info.hits != 3)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "wrong statistics for svn_cache__get_many");
+
+  /* An empty request is fine, too. */
+  return svn_cache__get_many(values, found, cache, keys, 0, pool);
+}
+
+static svn_error_t *
+test_cache_get_many(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+
+  SVN_ERR(svn_cache__create_inprocess(&cache, dup_revnum,
+                                      sizeof(svn_revnum_t), 1, 4, TRUE,
+                                      pool));
+  SVN_ERR(get_many_cache_test(cache, pool));
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 64*1024, 0,
+                                            TRUE, FALSE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(svn_revnum_t),
+                                            "many:", pool));
+  return get_many_cache_test(cache, pool);
+}
+
+/* Implements svn_iter_apr_hash_cb_t, counting the entries in the
+   apr_int64_t at BATON. */
+static svn_error_t *
+count_entries(void *baton,
+              const void *key,
+              apr_ssize_t klen,
+              void *val,
+              apr_pool_t *pool)
+{
+  (*(apr_int64_t *)baton)++;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_inprocess_cache_segments(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_cache__info_t info;
+  svn_revnum_t i, *answer;
+  svn_boolean_t found, completed;
+  apr_int64_t count = 0;
+
+  /* Large enough to get split into segments. */
+  SVN_ERR(svn_cache__create_inprocess(&cache, dup_revnum, sizeof(i),
+                                      256, 16, TRUE, pool));
+  for (i = 0; i < 500; ++i)
+    SVN_ERR(svn_cache__set(cache, &i, &i, pool));
+
+  for (i = 0; i < 500; ++i)
+    {
+      SVN_ERR(svn_cache__get((void **) &answer, &found, cache, &i, pool));
+      if (! found || *answer != i)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "wrong cache entry for key %ld", i);
+    }
+
+  SVN_ERR(svn_cache__get_info(cache, &info, FALSE, pool));
+  SVN_ERR(check_cache_info(&info, 500, 500, 500, 0, 500));
+  if (info.total_entries != 256 * 16)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "wrong inprocess cache capacity");
+
+  /* Iteration covers all segments. */
+  SVN_ERR(svn_cache__iter(&completed, cache, count_entries, &count, pool));
+  if (! completed || count != 500)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "iteration missed cache entries");
+
+  return SVN_NO_ERROR;
+}
+
+/* A simple linked list to exercise the svn_temp_serializer__* API. */
+typedef struct test_node_t
+{
+  const char *name;
+  int value;
+  struct test_node_t *next;
+} test_node_t;
+
+/* Serialize the list starting at *NODE_P into CONTEXT. */
+static void
+serialize_test_list(svn_temp_serializer__context_t *context,
+                    test_node_t * const *node_p)
+{
+  const test_node_t *node = *node_p;
+
+  svn_temp_serializer__push(context, (const void * const *)node_p,
+                            sizeof(*node));
+  if (node)
+    {
+      svn_temp_serializer__add_string(context, &node->name);
+      serialize_test_list(context, &node->next);
+    }
+  svn_temp_serializer__pop(context);
+}
+
+static svn_error_t *
+test_temp_serializer(apr_pool_t *pool)
+{
+  test_node_t nodes[3] = { { "first", 1, NULL },
+                           { NULL, 2, NULL },
+                           { "third", 3, NULL } };
+  test_node_t *list, *node;
+  const test_node_t *in_place;
+  svn_temp_serializer__context_t *context;
+  svn_stringbuf_t *serialized;
+  char *copy;
+
+  nodes[0].next = &nodes[1];
+  nodes[1].next = &nodes[2];
+
+  context = svn_temp_serializer__init(&nodes[0], sizeof(nodes[0]), 0, pool);
+  svn_temp_serializer__add_string(context, &nodes[0].name);
+  serialize_test_list(context, &nodes[0].next);
+  serialized = svn_temp_serializer__get(context);
+
+  /* The serialized data must be relocatable. */
+  copy = apr_palloc(pool, serialized->len);
+  memcpy(copy, serialized->data, serialized->len);
+  memset(serialized->data, 0, serialized->len);
+
+  /* Read it in place first. */
+  in_place = (const test_node_t *)copy;
+  in_place = svn_temp_deserializer__ptr(in_place,
+                                        (const void * const *)&in_place->next);
+  if (in_place->value != 2 || in_place->name != NULL)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "in-place access to serialized data failed");
+
+  /* Then resolve all pointers. */
+  list = (test_node_t *)copy;
+  svn_temp_deserializer__resolve(list, (void **)&list->name);
+  for (node = list; node->next; node = node->next)
+    {
+      svn_temp_deserializer__resolve(node, (void **)&node->next);
+      svn_temp_deserializer__resolve(node->next, (void **)&node->next->name);
+    }
+
+  node = list;
+  if (strcmp(node->name, "first") || node->value != 1)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "first list element corrupt");
+  node = node->next;
+  if (node->name != NULL || node->value != 2)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "second list element corrupt");
+  node = node->next;
+  if (strcmp(node->name, "third") || node->value != 3 || node->next)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "third list element corrupt");
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_memcache_basic(const svn_test_opts_t *opts,
                     apr_pool_t *pool)
@@ -245,6 +665,39 @@ test_memcache_long_key(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_memcache_get_many(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_config_t *config;
+  svn_memcache_t *memcache = NULL;
+  const char *prefix = apr_psprintf(pool,
+                                    "test_memcache_get_many-%" APR_TIME_T_FMT,
+                                    apr_time_now());
+
+  if (opts->config_file)
+    {
+      SVN_ERR(svn_config_read(&config, opts->config_file, TRUE, pool));
+      SVN_ERR(svn_cache__make_memcache_from_config(&memcache, config, pool));
+    }
+
+  if (! memcache)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "not configured to use memcached");
+
+  SVN_ERR(svn_cache__create_memcache(&cache,
+                                    memcache,
+                                    serialize_revnum,
+                                    deserialize_revnum,
+                                    sizeof(svn_revnum_t),
+                                    prefix,
+                                    pool));
+
+  return get_many_cache_test(cache, pool);
+}
+
+
 
 /* The test table.  */
 
@@ -253,9 +706,25 @@ struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_PASS2(test_inprocess_cache_basic,
                    "basic inprocess svn_cache test"),
+    SVN_TEST_PASS2(test_membuffer_cache_basic,
+                   "basic membuffer svn_cache test"),
+    SVN_TEST_PASS2(test_membuffer_cache_eviction,
+                   "membuffer svn_cache eviction"),
+    SVN_TEST_PASS2(test_cache_get_partial,
+                   "svn_cache__get_partial"),
+    SVN_TEST_PASS2(test_cache_info,
+                   "svn_cache statistics"),
+    SVN_TEST_PASS2(test_cache_get_many,
+                   "svn_cache__get_many"),
+    SVN_TEST_PASS2(test_inprocess_cache_segments,
+                   "segmented inprocess svn_cache"),
+    SVN_TEST_PASS2(test_temp_serializer,
+                   "svn_temp_serializer round trip"),
     SVN_TEST_OPTS_PASS(test_memcache_basic,
                        "basic memcache svn_cache test"),
     SVN_TEST_OPTS_PASS(test_memcache_long_key,
                        "memcache svn_cache with very long keys"),
+    SVN_TEST_OPTS_PASS(test_memcache_get_many,
+                       "memcache svn_cache__get_many"),
     SVN_TEST_NULL
   };
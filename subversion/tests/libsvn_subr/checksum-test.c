@@ -60,11 +60,52 @@ test_checksum_parse(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_checksum_md5_sha1(apr_pool_t *pool)
+{
+  static const apr_size_t lengths[] = { 0, 1, 63, 64, 8191, 8192, 8193,
+                                        100000 };
+  char *data = apr_palloc(pool, 100000);
+  apr_size_t i;
+
+  for (i = 0; i < 100000; i++)
+    data[i] = (char)((i * 131 + 7) & 0xff);
+
+  for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+    {
+      svn_checksum_ctx_t *ctx = svn_checksum__ctx_create_md5_sha1(pool);
+      svn_checksum_t *md5, *sha1, *expected_md5, *expected_sha1;
+      apr_size_t done;
+
+      /* Feed the data in uneven pieces. */
+      for (done = 0; done < lengths[i]; done += 5000)
+        SVN_ERR(svn_checksum_update(ctx, data + done,
+                                    lengths[i] - done < 5000
+                                      ? lengths[i] - done : 5000));
+      SVN_ERR(svn_checksum__final_md5_sha1(&md5, &sha1, ctx, pool));
+
+      SVN_ERR(svn_checksum(&expected_md5, svn_checksum_md5, data,
+                           lengths[i], pool));
+      SVN_ERR(svn_checksum(&expected_sha1, svn_checksum_sha1, data,
+                           lengths[i], pool));
+
+      if (! svn_checksum_match(md5, expected_md5)
+          || ! svn_checksum_match(sha1, expected_sha1))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Checksums of %" APR_SIZE_T_FMT " bytes "
+                                 "computed together differ", lengths[i]);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 struct svn_test_descriptor_t test_funcs[] =
   {
     SVN_TEST_NULL,
     SVN_TEST_PASS2(test_checksum_parse,
                    "checksum parse"),
+    SVN_TEST_PASS2(test_checksum_md5_sha1,
+                   "computing MD5 and SHA-1 checksums together"),
     SVN_TEST_NULL
   };
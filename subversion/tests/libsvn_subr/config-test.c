@@ -28,6 +28,7 @@
 
 
 
+#include <ctype.h>
 #include <string.h>
 
 #include <apr_getopt.h>
@@ -35,6 +36,7 @@
 
 #include "svn_error.h"
 #include "svn_config.h"
+#include "private/svn_config_private.h"
 
 #include "../svn_test.h"
 
@@ -144,6 +146,66 @@ test_text_retrieval(apr_pool_t *pool)
 }
 
 
+static svn_error_t *
+test_read_only(apr_pool_t *pool)
+{
+  svn_config_t *cfg;
+  int i;
+  const char *cfg_file;
+  const char *value;
+  char long_key[300];
+
+  if (!srcdir)
+    SVN_ERR(init_params(pool));
+
+  cfg_file = apr_pstrcat(pool, srcdir, "/", "config-test.cfg", NULL);
+  SVN_ERR(svn_config_read(&cfg, cfg_file, TRUE, pool));
+
+  memset(long_key, 'x', sizeof(long_key) - 1);
+  long_key[sizeof(long_key) - 1] = '\0';
+  svn_config_set(cfg, "section1", long_key, "long value");
+
+  svn_config__set_read_only(cfg, pool);
+
+  if (! svn_config__is_read_only(cfg))
+    return fail(pool, "Config not read-only after making it so");
+
+  /* The values are the same as before, however the names are spelled. */
+  for (i = 0; config_keys[i] != NULL; i++)
+    {
+      const char *key = config_keys[i];
+      const char *upper_key = apr_pstrdup(pool, key);
+      const char *lower_val, *upper_val;
+      char *p;
+
+      for (p = (char *)upper_key; *p; p++)
+        *p = (char)toupper((unsigned char)*p);
+
+      svn_config_get(cfg, &lower_val, "section1", key, "default value");
+      svn_config_get(cfg, &upper_val, "SECTION1", upper_key, NULL);
+
+      if (lower_val == NULL || strcmp(lower_val, config_values[i]) != 0)
+        return fail(pool, "Expected value '%s' not equal to '%s' for "
+                    "option '%s'", config_values[i], lower_val, key);
+      if (upper_val == NULL || strcmp(upper_val, config_values[i]) != 0)
+        return fail(pool, "Expected value '%s' not equal to '%s' for "
+                    "option '%s'", config_values[i], upper_val, upper_key);
+    }
+
+  /* Names too long for the lookup buffer are fine, too. */
+  memset(long_key, 'X', sizeof(long_key) - 1);
+  svn_config_get(cfg, &value, "Section1", long_key, "default value");
+  if (value == NULL || strcmp(value, "long value") != 0)
+    return fail(pool, "Expected the value of a long option name");
+
+  long_key[0] = 'Y';
+  svn_config_get(cfg, &value, "Section1", long_key, "default value");
+  if (value == NULL || strcmp(value, "default value") != 0)
+    return fail(pool, "Expected the default value for a long option name");
+
+  return SVN_NO_ERROR;
+}
+
 static const char *true_keys[] = {"true1", "true2", "true3", "true4",
                                   NULL};
 static const char *false_keys[] = {"false1", "false2", "false3", "false4",
@@ -248,5 +310,7 @@ struct svn_test_descriptor_t test_funcs[] =
                    "test svn_config boolean conversion"),
     SVN_TEST_PASS2(test_has_section,
                    "test svn_config_has_section"),
+    SVN_TEST_PASS2(test_read_only,
+                   "test read-only svn_config"),
     SVN_TEST_NULL
   };
@@ -412,6 +412,14 @@ test_relpath_join(apr_pool_t *pool)
     { "a", "def", "a/def" },
     { "a", "d", "a/d" },
     { SVN_EMPTY_PATH, "abc", "abc" },
+    { "abc", SVN_EMPTY_PATH, "abc" },
+  };
+  static const char * const not_joins[][3] = {
+    { "abc", "def", "abcdef" },
+    { "abc", "def", "abc/de" },
+    { "abc", "def", "abc/defg" },
+    { "abc", "def", "ab/def" },
+    { SVN_EMPTY_PATH, "abc", "/abc" },
   };
 
   for (i = 0; i < COUNT_OF(joins); i++)
@@ -427,6 +435,12 @@ test_relpath_join(apr_pool_t *pool)
                                  "\"%s\". expected \"%s\"",
                                  base, comp, result, expect);
 
+      if (! svn_relpath__is_joined(expect, base, comp))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "svn_relpath__is_joined(\"%s\", \"%s\", "
+                                 "\"%s\") returned FALSE",
+                                 expect, base, comp);
+
       /*result = svn_relpath_join_many(pool, base, comp, NULL);
       if (strcmp(result, expect))
         return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
@@ -435,6 +449,15 @@ test_relpath_join(apr_pool_t *pool)
                                  base, comp, result, expect);*/
     }
 
+  for (i = 0; i < COUNT_OF(not_joins); i++)
+    if (svn_relpath__is_joined(not_joins[i][2], not_joins[i][0],
+                               not_joins[i][1]))
+      return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                               "svn_relpath__is_joined(\"%s\", \"%s\", "
+                               "\"%s\") returned TRUE",
+                               not_joins[i][2], not_joins[i][0],
+                               not_joins[i][1]);
+
   return SVN_NO_ERROR;
 }
 
@@ -2687,7 +2710,7 @@ struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_PASS2(test_dirent_join,
                    "test svn_dirent_join(_many)"),
     SVN_TEST_PASS2(test_relpath_join,
-                   "test svn_relpath_join"),
+                   "test svn_relpath_join and svn_relpath__is_joined"),
     SVN_TEST_PASS2(test_uri_join,
                    "test svn_uri_join"),
     SVN_TEST_PASS2(test_dirent_basename,
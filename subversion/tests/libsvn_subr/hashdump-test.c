@@ -25,7 +25,9 @@
 
 #include <stdio.h>       /* for sprintf() */
 #include <stdlib.h>
+#include <string.h>
 #include <apr_pools.h>
+#include <apr_strings.h>
 #include <apr_hash.h>
 #include <apr_file_io.h>
 
@@ -169,6 +171,64 @@ test3(apr_pool_t *pool)
 
 
 
+static svn_error_t *
+test_hash_parse(apr_pool_t *pool)
+{
+  apr_hash_t *hash = apr_hash_make(pool);
+  apr_hash_t *oldhash = apr_hash_make(pool);
+  apr_hash_t *parsed = apr_hash_make(pool);
+  svn_stringbuf_t *buf = svn_stringbuf_create("", pool);
+  svn_string_t *value;
+  svn_error_t *err;
+
+  apr_hash_set(hash, "color", APR_HASH_KEY_STRING,
+               svn_string_create("red", pool));
+  apr_hash_set(hash, "wine review", APR_HASH_KEY_STRING,
+               svn_string_create(review, pool));
+  apr_hash_set(hash, "empty", APR_HASH_KEY_STRING,
+               svn_string_create("", pool));
+
+  /* The format written is unchanged. */
+  SVN_ERR(svn_hash_write2(hash, svn_stream_from_stringbuf(buf, pool),
+                          SVN_HASH_TERMINATOR, pool));
+  SVN_TEST_STRING_ASSERT(apr_psprintf(pool, "%.56s", buf->data),
+                         "K 5\ncolor\nV 3\nred\nK 5\nempty\nV 0\n\n"
+                         "K 11\nwine review\nV 376\n");
+  SVN_TEST_STRING_ASSERT(buf->data + buf->len - 4, "END\n");
+
+  /* And it parses in place to the same hash. */
+  SVN_ERR(svn_hash__parse(parsed, buf, SVN_HASH_TERMINATOR, pool));
+  SVN_TEST_ASSERT(apr_hash_count(parsed) == 3);
+  value = apr_hash_get(parsed, "wine review", APR_HASH_KEY_STRING);
+  SVN_TEST_ASSERT(value && strcmp(value->data, review) == 0
+                  && value->len == strlen(review));
+  value = apr_hash_get(parsed, "empty", APR_HASH_KEY_STRING);
+  SVN_TEST_ASSERT(value && value->len == 0 && value->data[0] == '\0');
+
+  /* Incremental dumps list changes and deletions only. */
+  apr_hash_set(oldhash, "color", APR_HASH_KEY_STRING,
+               svn_string_create("red", pool));
+  apr_hash_set(oldhash, "price", APR_HASH_KEY_STRING,
+               svn_string_create("US $6.50", pool));
+  apr_hash_set(hash, "wine review", APR_HASH_KEY_STRING, NULL);
+  svn_stringbuf_setempty(buf);
+  SVN_ERR(svn_hash_write_incremental(hash, oldhash,
+                                     svn_stream_from_stringbuf(buf, pool),
+                                     NULL, pool));
+  SVN_TEST_STRING_ASSERT(buf->data, "K 5\nempty\nV 0\n\nD 5\nprice\n");
+
+  /* Truncated data is rejected. */
+  buf = svn_stringbuf_create("K 5\ncolor\nV 30\nred\nEND\n", pool);
+  err = svn_hash__parse(apr_hash_make(pool), buf, SVN_HASH_TERMINATOR,
+                        pool);
+  SVN_TEST_ASSERT(err && err->apr_err == SVN_ERR_MALFORMED_FILE);
+  svn_error_clear(err);
+
+  return SVN_NO_ERROR;
+}
+
+
+
 
 /*
    ====================================================================
@@ -186,5 +246,7 @@ struct svn_test_descriptor_t test_funcs[] =
                    "read a file into a hash"),
     SVN_TEST_PASS2(test3,
                    "write hash out, read back in, compare"),
+    SVN_TEST_PASS2(test_hash_parse,
+                   "write hashes to and parse them from memory"),
     SVN_TEST_NULL
   };
@@ -408,6 +408,78 @@ verify_ranges_match(const apr_array_header_t *actual_rangelist,
   return SVN_NO_ERROR;
 }
 
+/* Mergeinfo with a broken line and lines for the same path with and
+   without a leading slash. */
+static const char *lazy_mergeinfo = "/trunk: 5,7-9\n"
+                                    "/branch:3\n"
+                                    "/trunk/sub:1-2*\n"
+                                    "branch: 4\n"
+                                    "/broken:x-y";
+
+static svn_error_t *
+test_parse_path(apr_pool_t *pool)
+{
+  svn_merge_range_t trunk_ranges[] = { {4, 5, TRUE}, {6, 9, TRUE} };
+  svn_merge_range_t branch_ranges[] = { {2, 4, TRUE} };
+  svn_merge_range_t sub_ranges[] = { {0, 2, FALSE} };
+  apr_array_header_t *rangelist;
+  svn_boolean_t is_noninheritable;
+  svn_error_t *err;
+
+  SVN_ERR(svn_mergeinfo__parse_path(&rangelist, lazy_mergeinfo, "/trunk",
+                                    pool, pool));
+  if (! rangelist)
+    return fail(pool, "Expected a rangelist for '/trunk'; got nothing");
+  SVN_ERR(verify_ranges_match(rangelist, trunk_ranges, 2,
+                              "svn_mergeinfo__parse_path", "parse", pool));
+
+  /* Both lines for the branch count, whichever way it is asked for. */
+  SVN_ERR(svn_mergeinfo__parse_path(&rangelist, lazy_mergeinfo, "branch",
+                                    pool, pool));
+  if (! rangelist)
+    return fail(pool, "Expected a rangelist for 'branch'; got nothing");
+  SVN_ERR(verify_ranges_match(rangelist, branch_ranges, 1,
+                              "svn_mergeinfo__parse_path", "parse", pool));
+
+  SVN_ERR(svn_mergeinfo__parse_path(&rangelist, lazy_mergeinfo, "/trunk/sub",
+                                    pool, pool));
+  if (! rangelist)
+    return fail(pool, "Expected a rangelist for '/trunk/sub'; got nothing");
+  SVN_ERR(verify_ranges_match(rangelist, sub_ranges, 1,
+                              "svn_mergeinfo__parse_path", "parse", pool));
+
+  SVN_ERR(svn_mergeinfo__parse_path(&rangelist, lazy_mergeinfo, "/nowhere",
+                                    pool, pool));
+  if (rangelist)
+    return fail(pool, "Expected no rangelist for '/nowhere'");
+
+  /* The broken line only matters when it is asked for. */
+  err = svn_mergeinfo__parse_path(&rangelist, lazy_mergeinfo, "/broken",
+                                  pool, pool);
+  if (err == SVN_NO_ERROR)
+    return fail(pool, "svn_mergeinfo__parse_path failed to detect an error");
+  else if (err->apr_err != SVN_ERR_MERGEINFO_PARSE_ERROR)
+    {
+      svn_error_clear(err);
+      return fail(pool, "svn_mergeinfo__parse_path returned some error other"
+                  " than SVN_ERR_MERGEINFO_PARSE_ERROR");
+    }
+  svn_error_clear(err);
+
+  SVN_ERR(svn_mergeinfo__string_has_noninheritable(&is_noninheritable,
+                                                   "/trunk:1-2*\n/a:3",
+                                                   pool));
+  if (! is_noninheritable)
+    return fail(pool, "'/trunk:1-2*' should be non-inheritable");
+  SVN_ERR(svn_mergeinfo__string_has_noninheritable(&is_noninheritable,
+                                                   "/trunk:1-2\n/a:3",
+                                                   pool));
+  if (is_noninheritable)
+    return fail(pool, "'/trunk:1-2' should not be non-inheritable");
+
+  return SVN_NO_ERROR;
+}
+
 /* Verify that DELTAS matches EXPECTED_DELTAS (both expected to
    contain only a rangelist for "/trunk").  Return an error based
    careful examination if they do not match.  FUNC_VERIFIED is the
@@ -1086,6 +1158,66 @@ test_rangelist_intersect_randomly(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_rangelist_merge_randomly(apr_pool_t *pool)
+{
+  int i;
+  apr_pool_t *iterpool;
+
+  random_rev_array_seed = (apr_uint32_t) apr_time_now();
+
+  iterpool = svn_pool_create(pool);
+
+  for (i = 0; i < 20; i++)
+    {
+      svn_boolean_t first_revs[RANDOM_REV_ARRAY_LENGTH],
+        second_revs[RANDOM_REV_ARRAY_LENGTH],
+        expected_revs[RANDOM_REV_ARRAY_LENGTH];
+      apr_array_header_t *first_rangelist, *second_rangelist,
+        *expected_rangelist, *actual_rangelist;
+      /* There will be at most RANDOM_REV_ARRAY_LENGTH ranges in
+         expected_rangelist. */
+      svn_merge_range_t expected_range_array[RANDOM_REV_ARRAY_LENGTH];
+      int j;
+
+      svn_pool_clear(iterpool);
+
+      randomly_fill_rev_array(first_revs);
+      randomly_fill_rev_array(second_revs);
+      /* There is no change numbered "r0" */
+      first_revs[0] = FALSE;
+      second_revs[0] = FALSE;
+      for (j = 0; j < RANDOM_REV_ARRAY_LENGTH; j++)
+        expected_revs[j] = second_revs[j] || first_revs[j];
+
+      SVN_ERR(rev_array_to_rangelist(&first_rangelist, first_revs, iterpool));
+      SVN_ERR(rev_array_to_rangelist(&second_rangelist, second_revs, iterpool));
+      SVN_ERR(rev_array_to_rangelist(&expected_rangelist, expected_revs,
+                                     iterpool));
+
+      for (j = 0; j < expected_rangelist->nelts; j++)
+        {
+          expected_range_array[j] = *(APR_ARRAY_IDX(expected_rangelist, j,
+                                                    svn_merge_range_t *));
+        }
+
+      /* svn_rangelist_merge() may modify the ranges it merges into. */
+      actual_rangelist = svn_rangelist_dup(first_rangelist, iterpool);
+      SVN_ERR(svn_rangelist_merge(&actual_rangelist, second_rangelist,
+                                  iterpool));
+
+      SVN_ERR(verify_ranges_match(actual_rangelist,
+                                  expected_range_array,
+                                  expected_rangelist->nelts,
+                                  "svn_rangelist_merge random call",
+                                  "merge", iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* ### Share code with test_diff_mergeinfo() and test_remove_rangelist(). */
 static svn_error_t *
 test_remove_mergeinfo(apr_pool_t *pool)
@@ -1666,6 +1798,8 @@ struct svn_test_descriptor_t test_funcs[] =
                    "parse single line mergeinfo and combine ranges"),
     SVN_TEST_PASS2(test_parse_broken_mergeinfo,
                    "parse broken single line mergeinfo"),
+    SVN_TEST_PASS2(test_parse_path,
+                   "parse mergeinfo for a single path"),
     SVN_TEST_PASS2(test_remove_rangelist,
                    "remove rangelists"),
     SVN_TEST_PASS2(test_rangelist_remove_randomly,
@@ -1690,6 +1824,8 @@ struct svn_test_descriptor_t test_funcs[] =
                    "turning mergeinfo back into a string"),
     SVN_TEST_PASS2(test_rangelist_merge,
                    "merge of rangelists"),
+    SVN_TEST_PASS2(test_rangelist_merge_randomly,
+                   "test rangelist merge with random data"),
     SVN_TEST_PASS2(test_rangelist_diff,
                    "diff of rangelists"),
     SVN_TEST_PASS2(test_remove_prefix_from_catalog,
@@ -635,6 +635,133 @@ test_stream_seek_translated(apr_pool_t *pool)
 }
 
 
+
+static svn_error_t *
+test_stream_skip(apr_pool_t *pool)
+{
+  static const char *data = "OneTwoThree";
+  static const char *fname = "test_stream_skip.txt";
+  svn_stream_t *streams[4];
+  apr_file_t *f;
+  apr_size_t len;
+  apr_size_t i;
+
+  SVN_ERR(svn_io_file_open(&f, fname, (APR_READ | APR_WRITE | APR_CREATE |
+                                       APR_TRUNCATE | APR_DELONCLOSE),
+                           APR_OS_DEFAULT, pool));
+  len = strlen(data);
+  SVN_ERR(svn_io_file_write_full(f, data, len, NULL, pool));
+
+  streams[0] = svn_stream_from_aprfile2(f, TRUE, pool);
+  SVN_ERR(svn_stream_reset(streams[0]));
+  streams[1] = svn_stream_from_stringbuf(svn_stringbuf_create(data, pool),
+                                         pool);
+  streams[2] = svn_stream_from_string(svn_string_create(data, pool), pool);
+  /* A stream without a skip handler of its own. */
+  streams[3] = svn_stream_checksummed2(
+                 svn_stream_from_string(svn_string_create(data, pool), pool),
+                 NULL, NULL, svn_checksum_md5, FALSE, pool);
+
+  for (i = 0; i < sizeof(streams) / sizeof(streams[0]); i++)
+    {
+      char buf[4];
+
+      len = 3;
+      SVN_ERR(svn_stream_skip(streams[i], &len));
+      SVN_TEST_ASSERT(len == 3);
+      len = 3;
+      SVN_ERR(svn_stream_read(streams[i], buf, &len));
+      buf[len] = '\0';
+      SVN_TEST_STRING_ASSERT(buf, "Two");
+
+      /* Skipping past the end stops there. */
+      len = 10;
+      SVN_ERR(svn_stream_skip(streams[i], &len));
+      SVN_TEST_ASSERT(len == 5);
+      len = 10;
+      SVN_ERR(svn_stream_skip(streams[i], &len));
+      SVN_TEST_ASSERT(len == 0);
+    }
+
+  /* A range only allows skipping within the range. */
+  streams[0] = svn_stream_from_aprfile_range_readonly(f, TRUE, 3, 6, pool);
+  len = 10;
+  SVN_ERR(svn_stream_skip(streams[0], &len));
+  SVN_TEST_ASSERT(len == 3);
+
+  SVN_ERR(svn_io_file_close(f, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* The character at position POS of a line of LEN characters
+   in test_stream_readline_long_lines(). */
+static char
+long_line_char(int pos, int len)
+{
+  return (pos % 7 == 6 && pos + 1 < len) ? '\r' : 'x';
+}
+
+static svn_error_t *
+test_stream_readline_long_lines(apr_pool_t *pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create("", pool);
+  svn_stream_t *streams[2];
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i, j;
+
+  /* Lines of all lengths around the read-ahead size, some of them
+     containing parts of the EOL sequence. */
+  for (i = 0; i < 300; i++)
+    {
+      for (j = 0; j < i; j++)
+        {
+          char c = long_line_char(j, i);
+
+          svn_stringbuf_appendbytes(text, &c, 1);
+        }
+      svn_stringbuf_appendcstr(text, "\r\n");
+    }
+  svn_stringbuf_appendcstr(text, "last");
+
+  streams[0] = svn_stream_from_stringbuf(text, pool);
+  /* A stream that can't seek, read one byte at a time. */
+  streams[1] = svn_stream_checksummed2(svn_stream_from_stringbuf(text, pool),
+                                       NULL, NULL, svn_checksum_md5, FALSE,
+                                       pool);
+
+  for (i = 0; i < 2; i++)
+    {
+      svn_boolean_t eof = FALSE;
+      int line = 0;
+
+      while (! eof)
+        {
+          svn_stringbuf_t *str;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_stream_readline(streams[i], &str, "\r\n", &eof,
+                                      iterpool));
+          if (eof)
+            {
+              SVN_TEST_STRING_ASSERT(str->data, "last");
+              break;
+            }
+
+          SVN_TEST_ASSERT(str->len == (apr_size_t)line);
+          for (j = 0; j < line; j++)
+            SVN_TEST_ASSERT(str->data[j] == long_line_char(j, line));
+          line++;
+        }
+
+      SVN_TEST_ASSERT(line == 300);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -661,5 +788,9 @@ struct svn_test_descriptor_t test_funcs[] =
                    "test stream seeking for stringbufs"),
     SVN_TEST_XFAIL2(test_stream_seek_translated,
                     "test stream seeking for translated streams"),
+    SVN_TEST_PASS2(test_stream_skip,
+                   "test stream skipping"),
+    SVN_TEST_PASS2(test_stream_readline_long_lines,
+                   "test reading lines longer than the read-ahead"),
     SVN_TEST_NULL
   };
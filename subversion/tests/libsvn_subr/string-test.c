@@ -39,6 +39,7 @@
 #include "svn_io.h"
 #include "svn_error.h"
 #include "svn_string.h"   /* This includes <apr_*.h> */
+#include "private/svn_string_private.h"
 
 
 /* A quick way to create error messages.  */
@@ -511,6 +512,42 @@ test23(apr_pool_t *pool)
   return test_stringbuf_unequal("abc", "abb", pool);
 }
 
+static svn_error_t *
+test24(apr_pool_t *pool)
+{
+  svn_stringbuf_t *s = svn_stringbuf_create("abc", pool);
+
+  /* Growing to an exact size must not round it up... */
+  svn_stringbuf__ensure_exact(s, 1000);
+  if (s->blocksize != 1000 || s->len != 3 || strcmp(s->data, "abc") != 0)
+    return fail(pool, "exact reservation changed the contents or "
+                "reserved %" APR_SIZE_T_FMT " bytes", s->blocksize);
+
+  /* ...nor shrink a block that is already big enough. */
+  svn_stringbuf__ensure_exact(s, 10);
+  if (s->blocksize != 1000)
+    return fail(pool, "exact reservation shrank the block");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test25(apr_pool_t *pool)
+{
+  svn_stringbuf_t *s = svn_stringbuf_create("abc", pool);
+  const char *data;
+  svn_string_t *str;
+
+  svn_stringbuf_appendcstr(s, "def");
+  data = s->data;
+  str = svn_stringbuf__morph_into_string(s);
+
+  if (str->data != data || str->len != 6 || strcmp(str->data, "abcdef") != 0)
+    return fail(pool, "morphing a stringbuf copied or changed the data");
+
+  return SVN_NO_ERROR;
+}
+
 /*
    ====================================================================
    If you add a new test to this file, update this array.
@@ -568,5 +605,9 @@ struct svn_test_descriptor_t test_funcs[] =
                    "compare stringbufs; different lengths"),
     SVN_TEST_PASS2(test23,
                    "compare stringbufs; same length, different content"),
+    SVN_TEST_PASS2(test24,
+                   "reserve an exact block size"),
+    SVN_TEST_PASS2(test25,
+                   "turn a stringbuf into a string without copying"),
     SVN_TEST_NULL
   };
@@ -1265,6 +1265,48 @@ mixed_to_crlf_unexpand_author_date_rev_url(apr_pool_t *pool)
 }
 
 
+
+/** Long runs of characters that need no translation. **/
+
+/* Translate lines of every length from 0 to 40 with a '$' or a
+ * newline at each position, so that the interesting characters turn up
+ * at every offset relative to a machine word, and compare with a
+ * straightforward translation. */
+static svn_error_t *
+long_boring_runs(apr_pool_t *pool)
+{
+  svn_stringbuf_t *src = svn_stringbuf_create("", pool);
+  svn_stringbuf_t *expected = svn_stringbuf_create("", pool);
+  const char *dst;
+  int len;
+  int pos;
+  int i;
+
+  for (len = 0; len <= 40; len++)
+    for (pos = 0; pos < len; pos++)
+      for (i = 0; i < len; i++)
+        {
+          char c = (char)('a' + i % 26);
+
+          if (i == pos)
+            c = (len % 2) ? '$' : '\n';
+
+          svn_stringbuf_appendbytes(src, &c, 1);
+          if (c == '\n')
+            svn_stringbuf_appendcstr(expected, "\r\n");
+          else
+            svn_stringbuf_appendbytes(expected, &c, 1);
+        }
+
+  /* Without keywords, '$' is not interesting. */
+  SVN_ERR(svn_subst_translate_cstring2(src->data, &dst, "\r\n", FALSE,
+                                       NULL, FALSE, pool));
+  SVN_TEST_STRING_ASSERT(dst, expected->data);
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /* The test table.  */
 
@@ -1360,5 +1402,7 @@ struct svn_test_descriptor_t test_funcs[] =
                    "cr_to_crlf; unexpand rev and url"),
     SVN_TEST_PASS2(mixed_to_crlf_unexpand_author_date_rev_url,
                    "mixed_to_crlf; unexpand author, date, rev, url"),
+    SVN_TEST_PASS2(long_boring_runs,
+                   "translate long runs of boring characters"),
     SVN_TEST_NULL
   };
@@ -214,6 +214,68 @@ utf_validate2(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Compare the two implementations on long, mostly ASCII strings, with
+   a few multi-byte or random octets placed at all sorts of offsets and
+   alignments. */
+static svn_error_t *
+utf_validate_ascii_runs(apr_pool_t *pool)
+{
+  int i;
+
+  seed_val();
+
+  for (i = 0; i < 20000; ++i)
+    {
+      char buf[160];
+      char *str = buf + range_rand(0, 7);
+      apr_size_t len = range_rand(0, 150);
+      apr_size_t j;
+      int k;
+
+      for (j = 0; j < len; ++j)
+        str[j] = (char)range_rand('a', 'z');
+
+      for (k = range_rand(0, 3); k > 0 && len > 0; --k)
+        {
+          apr_size_t pos = range_rand(0, len - 1);
+
+          switch (range_rand(0, 2))
+            {
+            case 0:
+              str[pos] = (char)range_rand(0, 255);
+              break;
+            case 1:
+              if (pos + 1 < len)
+                {
+                  str[pos] = '\xC5';
+                  str[pos + 1] = '\x81';
+                }
+              break;
+            default:
+              if (pos + 2 < len)
+                {
+                  str[pos] = '\xE5';
+                  str[pos + 1] = '\x81';
+                  str[pos + 2] = '\x81';
+                }
+              break;
+            }
+        }
+
+      if (svn_utf__last_valid(str, len) != svn_utf__last_valid2(str, len))
+        return svn_error_createf
+          (SVN_ERR_TEST_FAILED, NULL, "ascii run last_valid test %d failed",
+           i);
+
+      if (svn_utf__is_valid(str, len)
+          != (svn_utf__last_valid2(str, len) == str + len))
+        return svn_error_createf
+          (SVN_ERR_TEST_FAILED, NULL, "ascii run is_valid test %d failed", i);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Test conversion from different codepages to utf8. */
 static svn_error_t *
 test_utf_cstring_to_utf8_ex2(apr_pool_t *pool)
@@ -304,6 +366,8 @@ struct svn_test_descriptor_t test_funcs[] =
                    "test is_valid/last_valid"),
     SVN_TEST_PASS2(utf_validate2,
                    "test last_valid/last_valid2"),
+    SVN_TEST_PASS2(utf_validate_ascii_runs,
+                   "test last_valid/is_valid on mostly ASCII data"),
     SVN_TEST_PASS2(test_utf_cstring_to_utf8_ex2,
                    "test svn_utf_cstring_to_utf8_ex2"),
     SVN_TEST_PASS2(test_utf_cstring_from_utf8_ex2,
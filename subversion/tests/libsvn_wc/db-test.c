@@ -35,6 +35,7 @@
 #include "svn_io.h"
 
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 #include "svn_pools.h"
 
 #include "private/svn_sqlite.h"
@@ -329,7 +330,7 @@ create_fake_wc(const char *subdir, int format, apr_pool_t *scratch_pool)
   svn_error_clear(svn_io_remove_file(dbpath, scratch_pool));
   SVN_ERR(svn_sqlite__open(&sdb, dbpath, svn_sqlite__mode_rwcreate,
                            my_statements,
-                           0, NULL,
+                           0, NULL, NULL,
                            scratch_pool, scratch_pool));
 
   /* Create the database's schema.  */
@@ -815,6 +816,199 @@ test_children(apr_pool_t *pool)
 }
 
 
+static svn_error_t *
+test_base_children_info(apr_pool_t *pool)
+{
+  const char *local_abspath;
+  svn_wc__db_t *db;
+  apr_hash_t *nodes;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(create_open(&db, &local_abspath,
+                      "test_base_children_info", SVN_WC__VERSION,
+                      svn_wc__db_openmode_readonly, pool));
+
+  SVN_ERR(svn_wc__db_base_get_children_info(&nodes, db, local_abspath,
+                                            pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(nodes) == 12);
+
+  /* Every child should look just like it does to
+     svn_wc__db_base_get_info(). */
+  for (hi = apr_hash_first(pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = svn__apr_hash_index_key(hi);
+      const struct svn_wc__db_base_info_t *info = svn__apr_hash_index_val(hi);
+      svn_wc__db_status_t status;
+      svn_wc__db_kind_t kind;
+      svn_revnum_t revision;
+      const char *repos_relpath;
+      const char *repos_root_url;
+      svn_depth_t depth;
+      svn_wc__db_lock_t *lock;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_wc__db_base_get_info(
+                &status, &kind, &revision,
+                &repos_relpath, &repos_root_url, NULL,
+                NULL, NULL, NULL, NULL,
+                &depth, NULL, NULL, NULL, &lock,
+                db, svn_dirent_join(local_abspath, name, iterpool),
+                iterpool, iterpool));
+      SVN_TEST_ASSERT(info->status == status);
+      SVN_TEST_ASSERT(info->kind == kind);
+      SVN_TEST_ASSERT(info->revnum == revision);
+      SVN_TEST_STRING_ASSERT(info->repos_relpath, repos_relpath);
+      SVN_TEST_STRING_ASSERT(info->repos_root_url, repos_root_url);
+      SVN_TEST_ASSERT(info->depth == depth);
+      SVN_TEST_ASSERT((info->lock == NULL) == (lock == NULL));
+      if (lock)
+        SVN_TEST_STRING_ASSERT(info->lock->token, lock->token);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+test_children_info(apr_pool_t *pool)
+{
+  const char *local_abspath;
+  svn_wc__db_t *db;
+  apr_hash_t *nodes;
+  apr_hash_t *conflicts;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(create_open(&db, &local_abspath,
+                      "test_children_info", SVN_WC__VERSION,
+                      svn_wc__db_openmode_readonly, pool));
+
+  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts,
+                                        db, local_abspath, pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(nodes) == 13);
+  SVN_TEST_ASSERT(apr_hash_count(conflicts) == 0);
+
+  /* Every child should look just like it does to svn_wc__db_read_info(). */
+  for (hi = apr_hash_first(pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = svn__apr_hash_index_key(hi);
+      const struct svn_wc__db_info_t *info = svn__apr_hash_index_val(hi);
+      svn_wc__db_status_t status;
+      svn_wc__db_kind_t kind;
+      svn_revnum_t revision;
+      const char *repos_relpath;
+      const char *repos_root_url;
+      svn_revnum_t changed_rev;
+      apr_time_t changed_date;
+      const char *changed_author;
+      apr_time_t last_mod_time;
+      svn_depth_t depth;
+      svn_filesize_t translated_size;
+      const char *changelist;
+      svn_boolean_t props_mod;
+      svn_boolean_t base_shadowed;
+      svn_boolean_t conflicted;
+      svn_wc__db_lock_t *lock;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_wc__db_read_info(
+                &status, &kind, &revision,
+                &repos_relpath, &repos_root_url, NULL,
+                &changed_rev, &changed_date, &changed_author, &last_mod_time,
+                &depth, NULL, &translated_size, NULL,
+                &changelist, NULL, NULL, NULL, NULL,
+                NULL, &props_mod, &base_shadowed,
+                &conflicted, &lock,
+                db, svn_dirent_join(local_abspath, name, iterpool),
+                iterpool, iterpool));
+      SVN_TEST_ASSERT(info->status == status);
+      SVN_TEST_ASSERT(info->kind == kind);
+      SVN_TEST_ASSERT(info->revnum == revision);
+      SVN_TEST_STRING_ASSERT(info->repos_relpath, repos_relpath);
+      SVN_TEST_STRING_ASSERT(info->repos_root_url, repos_root_url);
+      SVN_TEST_ASSERT(info->changed_rev == changed_rev);
+      SVN_TEST_ASSERT(info->changed_date == changed_date);
+      SVN_TEST_STRING_ASSERT(info->changed_author, changed_author);
+      SVN_TEST_ASSERT(info->last_mod_time == last_mod_time);
+      SVN_TEST_ASSERT(info->depth == depth);
+      SVN_TEST_ASSERT(info->translated_size == translated_size);
+      SVN_TEST_STRING_ASSERT(info->changelist, changelist);
+      SVN_TEST_ASSERT(info->props_mod == props_mod);
+      SVN_TEST_ASSERT(info->base_shadowed == base_shadowed);
+      SVN_TEST_ASSERT(info->conflicted == conflicted);
+      SVN_TEST_ASSERT((info->lock == NULL) == (lock == NULL));
+    }
+
+  /* The tree conflicts recorded on I are on children that don't exist. */
+  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts,
+                                        db,
+                                        svn_dirent_join(local_abspath, "I",
+                                                        pool),
+                                        pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(nodes) == 0);
+  SVN_TEST_ASSERT(apr_hash_count(conflicts) == 2);
+  SVN_TEST_ASSERT(apr_hash_get(conflicts, "F", APR_HASH_KEY_STRING) != NULL);
+  SVN_TEST_ASSERT(apr_hash_get(conflicts, "G", APR_HASH_KEY_STRING) != NULL);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+test_children_changelists(apr_pool_t *pool)
+{
+  const char *local_abspath;
+  svn_wc__db_t *db;
+  apr_hash_t *changelists;
+  const apr_array_header_t *subdirs;
+  apr_hash_t *subdir_hash;
+
+  SVN_ERR(create_open(&db, &local_abspath,
+                      "test_children_changelists", SVN_WC__VERSION,
+                      svn_wc__db_openmode_readonly, pool));
+
+  SVN_ERR(svn_wc__db_read_children_changelists(&changelists, &subdirs,
+                                               db, local_abspath,
+                                               pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(changelists) == 1);
+  SVN_TEST_STRING_ASSERT(apr_hash_get(changelists, "I", APR_HASH_KEY_STRING),
+                         "changelist");
+
+  /* The directories that aren't hidden, including the deleted K but not
+     the incomplete node E of unknown kind. */
+  SVN_TEST_ASSERT(subdirs->nelts == 5);
+  SVN_ERR(svn_hash_from_cstring_keys(&subdir_hash, subdirs, pool));
+  SVN_TEST_ASSERT(apr_hash_get(subdir_hash, "I", APR_HASH_KEY_STRING));
+  SVN_TEST_ASSERT(apr_hash_get(subdir_hash, "J", APR_HASH_KEY_STRING));
+  SVN_TEST_ASSERT(apr_hash_get(subdir_hash, "K", APR_HASH_KEY_STRING));
+  SVN_TEST_ASSERT(apr_hash_get(subdir_hash, "L", APR_HASH_KEY_STRING));
+  SVN_TEST_ASSERT(apr_hash_get(subdir_hash, "M", APR_HASH_KEY_STRING));
+
+  /* J has no changelist members.  Its deleted directories J-c and J-e
+     aren't hidden, and J-e is listed once although it has both a BASE
+     and a WORKING row. */
+  SVN_ERR(svn_wc__db_read_children_changelists(
+            &changelists, &subdirs, db,
+            svn_dirent_join(local_abspath, "J", pool), pool, pool));
+  SVN_TEST_ASSERT(apr_hash_count(changelists) == 0);
+  SVN_TEST_ASSERT(subdirs->nelts == 4);
+  SVN_ERR(svn_hash_from_cstring_keys(&subdir_hash, subdirs, pool));
+  SVN_TEST_ASSERT(apr_hash_get(subdir_hash, "J-b", APR_HASH_KEY_STRING));
+  SVN_TEST_ASSERT(apr_hash_get(subdir_hash, "J-c", APR_HASH_KEY_STRING));
+  SVN_TEST_ASSERT(apr_hash_get(subdir_hash, "J-e", APR_HASH_KEY_STRING));
+  SVN_TEST_ASSERT(apr_hash_get(subdir_hash, "J-f", APR_HASH_KEY_STRING));
+
+  return SVN_NO_ERROR;
+}
+
+
 static svn_error_t *
 test_working_info(apr_pool_t *pool)
 {
@@ -1408,6 +1602,124 @@ test_work_queue(apr_pool_t *pool)
 }
 
 
+static svn_error_t *
+test_work_queue_batch(apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *local_abspath;
+  svn_skel_t *work_item;
+  apr_array_header_t *ids;
+  apr_array_header_t *work_items;
+  int i;
+
+  SVN_ERR(create_open(&db, &local_abspath, "test_work_queue_batch",
+                      SVN_WC__VERSION, svn_wc__db_openmode_readwrite, pool));
+
+  /* Create five work items.  */
+  for (i = 0; i < 5; i++)
+    {
+      work_item = svn_skel__make_empty_list(pool);
+      svn_skel__prepend_int(i, work_item, pool);
+      SVN_ERR(svn_wc__db_wq_add(db, local_abspath, work_item, pool));
+    }
+
+  /* The first three come back in the order they were queued.  */
+  SVN_ERR(svn_wc__db_wq_fetch_batch(&ids, &work_items, db, local_abspath, 3,
+                                    pool, pool));
+  SVN_TEST_ASSERT(ids->nelts == 3 && work_items->nelts == 3);
+  for (i = 0; i < 3; i++)
+    SVN_TEST_ASSERT(detect_work_item(APR_ARRAY_IDX(work_items, i,
+                                                   svn_skel_t *)) == i);
+
+  /* Complete the first two; the third one is fetched again.  */
+  SVN_ERR(svn_wc__db_wq_completed_upto(db, local_abspath,
+                                       APR_ARRAY_IDX(ids, 1, apr_uint64_t),
+                                       pool));
+
+  SVN_ERR(svn_wc__db_wq_fetch_batch(&ids, &work_items, db, local_abspath, 10,
+                                    pool, pool));
+  SVN_TEST_ASSERT(ids->nelts == 3 && work_items->nelts == 3);
+  for (i = 0; i < 3; i++)
+    SVN_TEST_ASSERT(detect_work_item(APR_ARRAY_IDX(work_items, i,
+                                                   svn_skel_t *)) == i + 2);
+
+  SVN_ERR(svn_wc__db_wq_completed_upto(db, local_abspath,
+                                       APR_ARRAY_IDX(ids, 2, apr_uint64_t),
+                                       pool));
+
+  SVN_ERR(svn_wc__db_wq_fetch_batch(&ids, &work_items, db, local_abspath, 10,
+                                    pool, pool));
+  SVN_TEST_ASSERT(ids->nelts == 0 && work_items->nelts == 0);
+
+  return SVN_NO_ERROR;
+}
+
+
+static svn_error_t *
+test_node_cache(apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *local_abspath;
+  const char *a_abspath;
+  svn_wc__db_kind_t kind;
+  const char *changelist;
+  const char *repos_root_url;
+  const char *repos_uuid;
+  svn_revnum_t revision;
+
+  SVN_ERR(create_open(&db, &local_abspath, "test_node_cache",
+                      SVN_WC__VERSION, svn_wc__db_openmode_readwrite, pool));
+  a_abspath = svn_dirent_join(local_abspath, "A", pool);
+
+  /* Nodes are only cached while we own the lock. */
+  SVN_ERR(svn_wc__db_temp_mark_locked(db, local_abspath, pool));
+
+  SVN_ERR(svn_wc__db_read_info(NULL, &kind, &revision, NULL,
+                               &repos_root_url, &repos_uuid,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL,
+                               db, local_abspath, pool, pool));
+  SVN_TEST_ASSERT(kind == svn_wc__db_kind_dir);
+  SVN_TEST_ASSERT(revision == 1);
+  SVN_TEST_STRING_ASSERT(repos_root_url, ROOT_ONE);
+  SVN_TEST_STRING_ASSERT(repos_uuid, UUID_ONE);
+
+  SVN_ERR(svn_wc__db_read_info(NULL, &kind, &revision, NULL,
+                               &repos_root_url, &repos_uuid,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               &changelist, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL,
+                               db, a_abspath, pool, pool));
+  SVN_TEST_ASSERT(kind == svn_wc__db_kind_file);
+  SVN_TEST_ASSERT(revision == 1);
+  SVN_TEST_ASSERT(repos_root_url == NULL);
+  SVN_TEST_ASSERT(repos_uuid == NULL);
+  SVN_TEST_ASSERT(changelist == NULL);
+
+  /* Our own changes must show up right away. */
+  SVN_ERR(svn_wc__db_op_set_changelist(db, a_abspath, "foo", pool));
+  SVN_ERR(svn_wc__db_read_info(NULL, &kind, &revision, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               &changelist, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL,
+                               db, a_abspath, pool, pool));
+  SVN_TEST_ASSERT(kind == svn_wc__db_kind_file);
+  SVN_TEST_ASSERT(revision == 1);
+  SVN_TEST_STRING_ASSERT(changelist, "foo");
+
+  SVN_ERR(svn_wc__db_op_set_changelist(db, a_abspath, NULL, pool));
+  SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               &changelist, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL,
+                               db, a_abspath, pool, pool));
+  SVN_TEST_ASSERT(changelist == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+
 struct svn_test_descriptor_t test_funcs[] =
   {
     SVN_TEST_NULL,
@@ -1417,6 +1729,12 @@ struct svn_test_descriptor_t test_funcs[] =
                    "insert different nodes into wc.db"),
     SVN_TEST_PASS2(test_children,
                    "getting the list of BASE or WORKING children"),
+    SVN_TEST_PASS2(test_base_children_info,
+                   "reading information about all BASE children"),
+    SVN_TEST_PASS2(test_children_info,
+                   "reading information about all children"),
+    SVN_TEST_PASS2(test_children_changelists,
+                   "reading the changelists of all children"),
     SVN_TEST_PASS2(test_working_info,
                    "reading information about the WORKING tree"),
     SVN_TEST_PASS2(test_pdh,
@@ -1431,5 +1749,9 @@ struct svn_test_descriptor_t test_funcs[] =
                    "upgrading to format 15"),
     SVN_TEST_PASS2(test_work_queue,
                    "work queue processing"),
+    SVN_TEST_PASS2(test_work_queue_batch,
+                   "fetching and completing work items in batches"),
+    SVN_TEST_PASS2(test_node_cache,
+                   "reading nodes through the node cache"),
     SVN_TEST_NULL
   };
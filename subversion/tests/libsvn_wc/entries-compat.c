@@ -344,7 +344,7 @@ make_one_db(const char *dirpath,
   svn_error_clear(svn_io_remove_file(dbpath, scratch_pool));
   SVN_ERR(svn_sqlite__open(&sdb, dbpath, svn_sqlite__mode_rwcreate,
                            my_statements,
-                           0, NULL,
+                           0, NULL, NULL,
                            scratch_pool, scratch_pool));
 
   /* Create the database's schema.  */
@@ -281,6 +281,109 @@ test_write_2_tree_conflicts(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_read_single_tree_conflict(apr_pool_t *pool)
+{
+  const char *tree_conflict_data;
+  const svn_wc_conflict_description2_t *conflict;
+  const char *local_abspath;
+
+  tree_conflict_data =
+    "((conflict Foo.c file update deleted edited "
+      "(version 0  2 -1 0  0 ) (version 0  2 -1 0  0 )) "
+     "(conflict Bar.h file update edited deleted "
+      "(version 0  2 -1 0  0 ) (version 0  2 -1 0  0 )))";
+
+  SVN_ERR(svn_dirent_get_absolute(&local_abspath, "Bar.h", pool));
+  SVN_ERR(svn_wc__read_tree_conflict(&conflict, tree_conflict_data,
+                                     local_abspath, pool, pool));
+
+  if (conflict == NULL
+      || conflict->node_kind != svn_node_file
+      || conflict->action    != svn_wc_conflict_action_edit
+      || conflict->reason    != svn_wc_conflict_reason_deleted
+      || conflict->operation != svn_wc_operation_update
+      || strcmp(conflict->local_abspath, local_abspath) != 0)
+    return fail(pool, "Unexpected tree conflict for Bar.h");
+
+  /* A victim that is only a prefix of another one's name. */
+  SVN_ERR(svn_dirent_get_absolute(&local_abspath, "Foo", pool));
+  SVN_ERR(svn_wc__read_tree_conflict(&conflict, tree_conflict_data,
+                                     local_abspath, pool, pool));
+  if (conflict != NULL)
+    return fail(pool, "Unexpected tree conflict for Foo");
+
+  SVN_ERR(svn_wc__read_tree_conflict(&conflict, NULL, local_abspath,
+                                     pool, pool));
+  if (conflict != NULL)
+    return fail(pool, "Unexpected tree conflict without conflict data");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_set_tree_conflict_data(apr_pool_t *pool)
+{
+  svn_wc_conflict_description2_t *conflict;
+  const char *tree_conflict_data;
+  const char *expected;
+  const char *local_abspath;
+
+  SVN_ERR(svn_dirent_get_absolute(&local_abspath, "Foo.c", pool));
+  conflict = svn_wc_conflict_description_create_tree2(
+                    local_abspath, svn_node_file, svn_wc_operation_update,
+                    NULL, NULL, pool);
+  conflict->action = svn_wc_conflict_action_delete;
+  conflict->reason = svn_wc_conflict_reason_edited;
+
+  /* Add a conflict to existing data. */
+  SVN_ERR(svn_wc__set_tree_conflict_data(
+                    &tree_conflict_data,
+                    "((conflict Bar.h file update edited deleted "
+                      "(version 0  2 -1 0  0 ) (version 0  2 -1 0  0 )))",
+                    "Foo.c", conflict, pool, pool));
+
+  expected = "((conflict Foo.c file update deleted edited "
+                "(version 0  2 -1 0  0 ) (version 0  2 -1 0  0 )) "
+              "(conflict Bar.h file update edited deleted "
+                "(version 0  2 -1 0  0 ) (version 0  2 -1 0  0 )))";
+  if (strcmp(expected, tree_conflict_data) != 0)
+    return fail(pool, "Unexpected text after adding a tree conflict\n"
+                      "  Expected: %s\n"
+                      "  Actual:   %s\n", expected, tree_conflict_data);
+
+  /* Replace it. */
+  conflict->reason = svn_wc_conflict_reason_obstructed;
+  SVN_ERR(svn_wc__set_tree_conflict_data(&tree_conflict_data,
+                                         tree_conflict_data,
+                                         "Foo.c", conflict, pool, pool));
+
+  expected = "((conflict Foo.c file update deleted obstructed "
+                "(version 0  2 -1 0  0 ) (version 0  2 -1 0  0 )) "
+              "(conflict Bar.h file update edited deleted "
+                "(version 0  2 -1 0  0 ) (version 0  2 -1 0  0 )))";
+  if (strcmp(expected, tree_conflict_data) != 0)
+    return fail(pool, "Unexpected text after replacing a tree conflict\n"
+                      "  Expected: %s\n"
+                      "  Actual:   %s\n", expected, tree_conflict_data);
+
+  /* And remove both of them again. */
+  SVN_ERR(svn_wc__set_tree_conflict_data(&tree_conflict_data,
+                                         tree_conflict_data,
+                                         "Bar.h", NULL, pool, pool));
+  SVN_ERR(svn_wc__set_tree_conflict_data(&tree_conflict_data,
+                                         tree_conflict_data,
+                                         "Foo.c", NULL, pool, pool));
+
+  expected = "()";
+  if (strcmp(expected, tree_conflict_data) != 0)
+    return fail(pool, "Unexpected text after removing tree conflicts\n"
+                      "  Expected: %s\n"
+                      "  Actual:   %s\n", expected, tree_conflict_data);
+
+  return SVN_NO_ERROR;
+}
+
 #ifdef THIS_TEST_RAISES_MALFUNCTION
 static svn_error_t *
 test_write_invalid_tree_conflicts(apr_pool_t *pool)
@@ -388,6 +491,10 @@ struct svn_test_descriptor_t test_funcs[] =
                    "write 1 tree conflict"),
     SVN_TEST_PASS2(test_write_2_tree_conflicts,
                    "write 2 tree conflicts"),
+    SVN_TEST_PASS2(test_read_single_tree_conflict,
+                   "read 1 of 2 tree conflicts"),
+    SVN_TEST_PASS2(test_set_tree_conflict_data,
+                   "set and remove single tree conflicts"),
 #ifdef THIS_TEST_RAISES_MALFUNCTION
     SVN_TEST_PASS2(test_write_invalid_tree_conflicts,
                    "detect broken tree conflict data while writing"),
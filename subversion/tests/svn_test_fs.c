@@ -88,7 +88,10 @@ make_fs_config(const char *fs_type,
                fs_type);
   if (server_minor_version)
     {
-      if (server_minor_version == 6)
+      if (server_minor_version == 7)
+        apr_hash_set(fs_config, SVN_FS_CONFIG_PRE_1_8_COMPATIBLE,
+                     APR_HASH_KEY_STRING, "1");
+      else if (server_minor_version == 6)
         apr_hash_set(fs_config, SVN_FS_CONFIG_PRE_1_7_COMPATIBLE,
                      APR_HASH_KEY_STRING, "1");
       else if (server_minor_version == 5)
@@ -230,7 +233,7 @@ svn_test__create_repos(svn_repos_t **repos_p,
                                   pool));
   if (must_reopen)
     {
-      SVN_ERR(svn_repos_open(&repos, name, pool));
+      SVN_ERR(svn_repos_open2(&repos, name, NULL, pool));
       svn_fs_set_warning_func(svn_repos_fs(repos), fs_warning_handler, NULL);
     }
 
@@ -363,7 +363,7 @@ main(int argc, const char *argv[])
                 exit(1);
               }
             if ((opts.server_minor_version < 3)
-                || (opts.server_minor_version > 6))
+                || (opts.server_minor_version > 7))
               {
                 fprintf(stderr, "FAIL: Invalid minor version given\n");
                 exit(1);
@@ -271,18 +271,18 @@ drive(struct operation *operation,
           if (strcmp(child->src_file, "-"))
             {
               SVN_ERR(svn_io_file_open(&f, child->src_file, APR_READ,
-                                       APR_OS_DEFAULT, pool));
+                                       APR_OS_DEFAULT, subpool));
             }
           else
             {
-              apr_status_t apr_err = apr_file_open_stdin(&f, pool);
+              apr_status_t apr_err = apr_file_open_stdin(&f, subpool);
               if (apr_err)
                 return svn_error_wrap_apr(apr_err, "Can't open stdin");
             }
-          contents = svn_stream_from_aprfile(f, pool);
+          contents = svn_stream_from_aprfile(f, subpool);
           SVN_ERR(svn_txdelta_send_stream(contents, handler,
-                                          handler_baton, NULL, pool));
-          SVN_ERR(svn_io_file_close(f, pool));
+                                          handler_baton, NULL, subpool));
+          SVN_ERR(svn_io_file_close(f, subpool));
         }
       /* If we opened a file, we need to apply outstanding propmods,
          then close it. */
@@ -360,6 +360,48 @@ subtract_anchor(const char *anchor, const char *url, apr_pool_t *pool)
     return svn_path_uri_decode(svn_path_is_child(anchor, url, pool), pool);
 }
 
+/* Record in KINDS, a hash mapping "REV:PATH" to svn_node_kind_t *, that
+   PATH is of kind KIND in REV. */
+static void
+remember_kind(apr_hash_t *kinds,
+              const char *path,
+              svn_revnum_t rev,
+              svn_node_kind_t kind,
+              apr_pool_t *pool)
+{
+  svn_node_kind_t *value = apr_palloc(pool, sizeof(*value));
+
+  *value = kind;
+  apr_hash_set(kinds, apr_psprintf(pool, "%ld:%s", rev, path),
+               APR_HASH_KEY_STRING, value);
+}
+
+/* Set *KIND to the kind of PATH in REV, taking it from KINDS (see
+   remember_kind()) if it is known there, and asking SESSION otherwise. */
+static svn_error_t *
+check_path(svn_node_kind_t *kind,
+           apr_hash_t *kinds,
+           svn_ra_session_t *session,
+           const char *path,
+           svn_revnum_t rev,
+           apr_pool_t *pool)
+{
+  svn_node_kind_t *known = apr_hash_get(kinds,
+                                        apr_psprintf(pool, "%ld:%s",
+                                                     rev, path),
+                                        APR_HASH_KEY_STRING);
+
+  if (known)
+    {
+      *kind = *known;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_ra_check_path(session, path, rev, kind, pool));
+  remember_kind(kinds, path, rev, *kind, pool);
+  return SVN_NO_ERROR;
+}
+
 /* Add PATH to the operations tree rooted at OPERATION, creating any
    intermediate nodes that are required.  Here's what's expected for
    each action type:
@@ -376,7 +418,8 @@ subtract_anchor(const char *anchor, const char *url, apr_pool_t *pool)
    Node type information is obtained for any copy source (to determine
    whether to create a file or directory) and for any deleted path (to
    ensure it exists since svn_delta_editor_t->delete_entry doesn't
-   return an error on non-existent nodes). */
+   return an error on non-existent nodes).  Kinds already in KINDS are
+   not looked up again. */
 static svn_error_t *
 build(action_code_t action,
       const char *path,
@@ -388,6 +431,7 @@ build(action_code_t action,
       svn_revnum_t head,
       const char *anchor,
       svn_ra_session_t *session,
+      apr_hash_t *kinds,
       struct operation *operation,
       apr_pool_t *pool)
 {
@@ -434,10 +478,9 @@ build(action_code_t action,
         return svn_error_createf(SVN_ERR_BAD_URL, NULL,
                                  "cannot set properties on a location being"
                                  " deleted ('%s')", path);
-      SVN_ERR(svn_ra_check_path(session,
-                                copy_src ? copy_src : path,
-                                copy_src ? copy_rev : head,
-                                &operation->kind, pool));
+      SVN_ERR(check_path(&operation->kind, kinds, session,
+                         copy_src ? copy_src : path,
+                         copy_src ? copy_rev : head, pool));
       if (operation->kind == svn_node_none)
         return svn_error_createf(SVN_ERR_BAD_URL, NULL,
                                  "propset: '%s' not found", path);
@@ -474,10 +517,9 @@ build(action_code_t action,
   if (action == ACTION_RM)
     {
       operation->operation = OP_DELETE;
-      SVN_ERR(svn_ra_check_path(session,
-                                copy_src ? copy_src : path,
-                                copy_src ? copy_rev : head,
-                                &operation->kind, pool));
+      SVN_ERR(check_path(&operation->kind, kinds, session,
+                         copy_src ? copy_src : path,
+                         copy_src ? copy_rev : head, pool));
       if (operation->kind == svn_node_none)
         {
           if (copy_src && strcmp(path, copy_src))
@@ -504,10 +546,9 @@ build(action_code_t action,
              which incorrectly replaces existing directories.
              Therefore we need to check if the target exists
              and raise an error here. */
-          SVN_ERR(svn_ra_check_path(session,
-                                    copy_src ? copy_src : path,
-                                    copy_src ? copy_rev : head,
-                                    &operation->kind, pool));
+          SVN_ERR(check_path(&operation->kind, kinds, session,
+                             copy_src ? copy_src : path,
+                             copy_src ? copy_rev : head, pool));
           if (operation->kind != svn_node_none)
             {
               if (copy_src && strcmp(path, copy_src))
@@ -519,8 +560,8 @@ build(action_code_t action,
                                          "'%s' already exists", path);
             }
         }
-      SVN_ERR(svn_ra_check_path(session, subtract_anchor(anchor, url, pool),
-                                rev, &operation->kind, pool));
+      SVN_ERR(check_path(&operation->kind, kinds, session,
+                         subtract_anchor(anchor, url, pool), rev, pool));
       if (operation->kind == svn_node_none)
         return svn_error_createf(SVN_ERR_BAD_URL, NULL,
                                  "'%s' not found",
@@ -544,10 +585,9 @@ build(action_code_t action,
         }
       else
         {
-          SVN_ERR(svn_ra_check_path(session,
-                                    copy_src ? copy_src : path,
-                                    copy_src ? copy_rev : head,
-                                    &operation->kind, pool));
+          SVN_ERR(check_path(&operation->kind, kinds, session,
+                             copy_src ? copy_src : path,
+                             copy_src ? copy_rev : head, pool));
           if (operation->kind == svn_node_file)
             operation->operation = OP_OPEN;
           else if (operation->kind == svn_node_none)
@@ -590,6 +630,99 @@ struct action {
   const char *prop_value;
 };
 
+/* Add the path of URL relative to ANCHOR to the paths to look up in REV,
+   in PATHS_BY_REV, a hash mapping svn_revnum_t to arrays of paths. */
+static void
+add_prefetch_path(apr_hash_t *paths_by_rev,
+                  const char *anchor,
+                  const char *url,
+                  svn_revnum_t rev,
+                  apr_pool_t *pool)
+{
+  apr_array_header_t *paths = apr_hash_get(paths_by_rev, &rev, sizeof(rev));
+
+  if (! paths)
+    {
+      svn_revnum_t *key = apr_palloc(pool, sizeof(*key));
+
+      *key = rev;
+      paths = apr_array_make(pool, 16, sizeof(const char *));
+      apr_hash_set(paths_by_rev, key, sizeof(*key), paths);
+    }
+
+  APR_ARRAY_PUSH(paths, const char *) = subtract_anchor(anchor, url, pool);
+}
+
+/* Look up the kinds of the paths and copy sources of ACTIONS that build()
+   is going to check, with a single svn_ra_stat_many() call per revision
+   rather than a round trip per path, and record them in KINDS (see
+   remember_kind()).  Paths below copies are left to build(). */
+static svn_error_t *
+prefetch_kinds(apr_hash_t *kinds,
+               const apr_array_header_t *actions,
+               const char *anchor,
+               svn_revnum_t head,
+               svn_ra_session_t *session,
+               apr_pool_t *pool)
+{
+  apr_hash_t *paths_by_rev = apr_hash_make(pool);
+  apr_hash_index_t *hi;
+  int i;
+
+  for (i = 0; i < actions->nelts; ++i)
+    {
+      struct action *action = APR_ARRAY_IDX(actions, i, struct action *);
+
+      switch (action->action)
+        {
+        case ACTION_MV:
+          add_prefetch_path(paths_by_rev, anchor, action->path[0], head, pool);
+          add_prefetch_path(paths_by_rev, anchor, action->path[1], head, pool);
+          break;
+        case ACTION_CP:
+          if (! SVN_IS_VALID_REVNUM(action->rev))
+            add_prefetch_path(paths_by_rev, anchor, action->path[0], head,
+                              pool);
+          else if (action->rev <= head)
+            add_prefetch_path(paths_by_rev, anchor, action->path[0],
+                              action->rev, pool);
+          add_prefetch_path(paths_by_rev, anchor, action->path[1], head, pool);
+          break;
+        case ACTION_MKDIR:
+          break;
+        default:
+          add_prefetch_path(paths_by_rev, anchor, action->path[0], head, pool);
+          break;
+        }
+    }
+
+  for (hi = apr_hash_first(pool, paths_by_rev); hi; hi = apr_hash_next(hi))
+    {
+      const void *key;
+      void *val;
+      svn_revnum_t rev;
+      apr_array_header_t *paths;
+      apr_hash_t *dirents;
+
+      apr_hash_this(hi, &key, NULL, &val);
+      rev = *(const svn_revnum_t *)key;
+      paths = val;
+
+      SVN_ERR(svn_ra_stat_many(session, &dirents, paths, rev, pool));
+      for (i = 0; i < paths->nelts; ++i)
+        {
+          const char *path = APR_ARRAY_IDX(paths, i, const char *);
+          svn_dirent_t *dirent = apr_hash_get(dirents, path,
+                                              APR_HASH_KEY_STRING);
+
+          remember_kind(kinds, path, rev,
+                        dirent ? dirent->kind : svn_node_none, pool);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 execute(const apr_array_header_t *actions,
         const char *anchor,
@@ -609,6 +742,7 @@ execute(const apr_array_header_t *actions,
   struct operation root;
   svn_error_t *err;
   apr_hash_t *config;
+  apr_hash_t *kinds = apr_hash_make(pool);
   int i;
 
   SVN_ERR(svn_config_get_config(&config, config_dir, pool));
@@ -627,6 +761,11 @@ execute(const apr_array_header_t *actions,
       head = base_revision;
     }
 
+  /* This only saves round trips; build() looks up anything it needs
+     that isn't known yet. */
+  svn_error_clear(prefetch_kinds(kinds, actions, anchor, head, session,
+                                 pool));
+
   root.children = apr_hash_make(pool);
   root.operation = OP_OPEN;
   for (i = 0; i < actions->nelts; ++i)
@@ -640,10 +779,10 @@ execute(const apr_array_header_t *actions,
           path2 = subtract_anchor(anchor, action->path[1], pool);
           SVN_ERR(build(ACTION_RM, path1, NULL,
                         SVN_INVALID_REVNUM, NULL, NULL, NULL, head, anchor,
-                        session, &root, pool));
+                        session, kinds, &root, pool));
           SVN_ERR(build(ACTION_CP, path2, action->path[0],
                         head, NULL, NULL, NULL, head, anchor,
-                        session, &root, pool));
+                        session, kinds, &root, pool));
           break;
         case ACTION_CP:
           path1 = subtract_anchor(anchor, action->path[0], pool);
@@ -652,25 +791,25 @@ execute(const apr_array_header_t *actions,
             action->rev = head;
           SVN_ERR(build(ACTION_CP, path2, action->path[0],
                         action->rev, NULL, NULL, NULL, head, anchor,
-                        session, &root, pool));
+                        session, kinds, &root, pool));
           break;
         case ACTION_RM:
           path1 = subtract_anchor(anchor, action->path[0], pool);
           SVN_ERR(build(ACTION_RM, path1, NULL,
                         SVN_INVALID_REVNUM, NULL, NULL, NULL, head, anchor,
-                        session, &root, pool));
+                        session, kinds, &root, pool));
           break;
         case ACTION_MKDIR:
           path1 = subtract_anchor(anchor, action->path[0], pool);
           SVN_ERR(build(ACTION_MKDIR, path1, action->path[0],
                         SVN_INVALID_REVNUM, NULL, NULL, NULL, head, anchor,
-                        session, &root, pool));
+                        session, kinds, &root, pool));
           break;
         case ACTION_PUT:
           path1 = subtract_anchor(anchor, action->path[0], pool);
           SVN_ERR(build(ACTION_PUT, path1, action->path[0],
                         SVN_INVALID_REVNUM, NULL, NULL, action->path[1],
-                        head, anchor, session, &root, pool));
+                        head, anchor, session, kinds, &root, pool));
           break;
         case ACTION_PROPSET:
         case ACTION_PROPDEL:
@@ -678,7 +817,7 @@ execute(const apr_array_header_t *actions,
           SVN_ERR(build(action->action, path1, action->path[0],
                         SVN_INVALID_REVNUM,
                         action->prop_name, action->prop_value,
-                        NULL, head, anchor, session, &root, pool));
+                        NULL, head, anchor, session, kinds, &root, pool));
           break;
         }
     }
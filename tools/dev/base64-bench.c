@@ -0,0 +1,167 @@
+/* base64-bench.c -- time base64 encoding and decoding streams
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr.h>
+#include <apr_general.h>
+#include <apr_time.h>
+
+#include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_base64.h"
+
+
+/* The size of the writes, about that of an svndiff window. */
+#define CHUNK_SIZE 16384
+
+/* Write the LEN bytes at DATA to STREAM, CHUNK_SIZE bytes at a time,
+ * and close it. */
+static svn_error_t *
+write_chunks(svn_stream_t *stream, const char *data, apr_size_t len)
+{
+  while (len > 0)
+    {
+      apr_size_t n = len < CHUNK_SIZE ? len : CHUNK_SIZE;
+
+      SVN_ERR(svn_stream_write(stream, data, &n));
+      data += n;
+      len -= n;
+    }
+
+  return svn_stream_close(stream);
+}
+
+/* Base64-encode and decode SIZE bytes of pseudo-random data ITERATIONS
+ * times through the streaming API, as the DAV layers do with text deltas,
+ * and print how long that took to OSTREAM. */
+static svn_error_t *
+do_bench(svn_stream_t *ostream,
+         apr_size_t size,
+         int iterations,
+         apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *plain = svn_stringbuf_create_ensure(size, pool);
+  apr_interval_time_t encode_time = 0, decode_time = 0;
+  apr_uint32_t seed = 1;
+  int i;
+
+  for (plain->len = 0; plain->len < size; plain->len++)
+    {
+      seed = seed * 1103515245 + 12345;
+      plain->data[plain->len] = (char)(seed >> 16);
+    }
+  plain->data[plain->len] = '\0';
+
+  for (i = 0; i < iterations; i++)
+    {
+      svn_stringbuf_t *encoded, *decoded;
+      apr_time_t start;
+
+      svn_pool_clear(iterpool);
+      encoded = svn_stringbuf_create_ensure(size / 3 * 4 + size / 57 + 8,
+                                            iterpool);
+      decoded = svn_stringbuf_create_ensure(size, iterpool);
+
+      start = apr_time_now();
+      SVN_ERR(write_chunks(svn_base64_encode(
+                             svn_stream_from_stringbuf(encoded, iterpool),
+                             iterpool),
+                           plain->data, plain->len));
+      encode_time += apr_time_now() - start;
+
+      start = apr_time_now();
+      SVN_ERR(write_chunks(svn_base64_decode(
+                             svn_stream_from_stringbuf(decoded, iterpool),
+                             iterpool),
+                           encoded->data, encoded->len));
+      decode_time += apr_time_now() - start;
+
+      if (decoded->len != plain->len
+          || memcmp(decoded->data, plain->data, plain->len) != 0)
+        return svn_error_create(SVN_ERR_BASE, NULL,
+                                "decoded data differs from the original");
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_stream_printf(ostream, pool,
+                           "%d iterations of %" APR_SIZE_T_FMT " bytes, "
+                           "encode %" APR_TIME_T_FMT " usec, "
+                           "decode %" APR_TIME_T_FMT " usec "
+                           "(%.1f / %.1f MB/s)\n",
+                           iterations, size, encode_time, decode_time,
+                           encode_time
+                             ? (double)size * iterations / encode_time
+                             : 0.0,
+                           decode_time
+                             ? (double)size * iterations / decode_time
+                             : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+  apr_pool_t *pool;
+  svn_stream_t *ostream;
+  int rc;
+  svn_error_t *svn_err;
+
+  apr_initialize();
+
+  pool = svn_pool_create(NULL);
+
+  svn_err = svn_stream_for_stdout(&ostream, pool);
+  if (svn_err)
+    {
+      svn_handle_error2(svn_err, stdout, FALSE, "base64-bench: ");
+      rc = 2;
+    }
+  else if (argc == 3 && atoi(argv[1]) > 0 && atoi(argv[2]) > 0)
+    {
+      svn_err = do_bench(ostream, (apr_size_t)atoi(argv[1]) * 1024,
+                         atoi(argv[2]), pool);
+      if (svn_err == NULL)
+        {
+          rc = 0;
+        }
+      else
+        {
+          svn_handle_error2(svn_err, stdout, FALSE, "base64-bench: ");
+          rc = 2;
+        }
+    }
+  else
+    {
+      svn_error_clear(svn_stream_printf(ostream, pool,
+                                        "Usage: %s <kilobytes> "
+                                        "<iterations>\n",
+                                        argv[0]));
+      rc = 2;
+    }
+
+  apr_terminate();
+
+  return rc;
+}
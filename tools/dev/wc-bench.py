@@ -0,0 +1,297 @@
+#!/usr/bin/env python
+#
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+#
+#
+# wc-bench.py:  (See wc-bench.py --help.)
+#
+# Times working copy operations on a large synthetic tree.
+#
+# The script creates a repository, fills trunk with a tree of the
+# requested shape, makes a branch, and then builds up history the way
+# random-commits.py does: each commit appends a line to a handful of
+# randomly chosen files.  It then times checkout, status, update,
+# merge and blame against that history, along with repeated runs of
+# trivial commands which show the client's start-up cost.
+#
+# The same --seed always gives the same tree and the same history, so
+# numbers from different builds of Subversion can be compared.
+#
+# Each measurement is printed as one tab-separated line:
+#
+#   BENCH  scheme  operation  count  wall  user  sys  blocks-in  blocks-out  sql
+#
+# where the times are in seconds, the block counts are the child
+# processes' file system input and output operations as reported by
+# getrusage(), and sql is the number of SQLite statements the client
+# ran, or '-' if the client was not built with SQLITE3_DEBUG (whose
+# trace output is what is counted).
+#
+# The repository can be reached over file:// (the default), over svn://
+# with an svnserve started by this script, or over http:// with a URL
+# of an existing, empty and writable repository served by mod_dav_svn.
+
+import os
+import sys
+import time
+import random
+import shutil
+import resource
+import getopt
+try:
+  my_getopt = getopt.gnu_getopt
+except AttributeError:
+  my_getopt = getopt.getopt
+import subprocess
+
+
+def usage(exit_code):
+  sys.stderr.write(
+"""Usage: wc-bench.py [OPTIONS] WORK-DIR
+
+Build a repository and working copies in WORK-DIR (which must not
+exist) and print the time taken by common working copy operations.
+
+Options:
+  --bin-dir=DIR       directory holding svn, svnadmin and svnserve
+                      (default: found on the PATH)
+  --scheme=SCHEME     one of 'file', 'svn' or 'http' (default: file)
+  --url=URL           the repository root URL for --scheme=http
+  --port=PORT         the port for the svnserve of --scheme=svn
+                      (default: 3691)
+  --depth=N           levels of directories below trunk (default: 3)
+  --dirs=N            subdirectories per directory (default: 5)
+  --files=N           files per directory (default: 10)
+  --lines=N           lines per file (default: 50)
+  --revisions=N       commits of history to create (default: 100)
+  --max-files=N       files changed per commit, at most (default: 10)
+  --seed=N            seed for the tree and the history (default: 0)
+  --help              show this text
+""")
+  sys.exit(exit_code)
+
+
+class Benchmark:
+  def __init__(self, bin_dir, scheme):
+    self.bin_dir = bin_dir
+    self.scheme = scheme
+
+  def program(self, name):
+    if self.bin_dir:
+      return os.path.join(self.bin_dir, name)
+    return name
+
+  def run(self, args, cwd=None):
+    """Run svn with ARGS and return its standard output."""
+    proc = subprocess.Popen([self.program('svn'), '--non-interactive']
+                            + args,
+                            cwd=cwd, stdout=subprocess.PIPE)
+    output = proc.communicate()[0].decode('utf-8', 'replace')
+    if proc.returncode != 0:
+      raise Exception("'svn %s' failed" % ' '.join(args))
+    return output
+
+  def time(self, operation, count, args, cwd=None):
+    """Run svn with ARGS, COUNT times over, and report it as OPERATION."""
+    before = resource.getrusage(resource.RUSAGE_CHILDREN)
+    start = time.time()
+    sql = 0
+    traced = False
+    for i in range(count):
+      output = self.run(args, cwd)
+      if 'sql="' in output:
+        traced = True
+        sql += output.count('sql="')
+    wall = time.time() - start
+    after = resource.getrusage(resource.RUSAGE_CHILDREN)
+
+    print('BENCH\t%s\t%s\t%d\t%.3f\t%.3f\t%.3f\t%d\t%d\t%s'
+          % (self.scheme, operation, count, wall,
+             after.ru_utime - before.ru_utime,
+             after.ru_stime - before.ru_stime,
+             after.ru_inblock - before.ru_inblock,
+             after.ru_oublock - before.ru_oublock,
+             traced and str(sql) or '-'))
+    sys.stdout.flush()
+
+
+def make_tree(path, depth, dirs, files, lines, rand):
+  """Create a tree of DEPTH levels below PATH and return its files."""
+  made = []
+  for i in range(files):
+    name = os.path.join(path, 'file%d.txt' % i)
+    f = open(name, 'w')
+    for j in range(lines):
+      f.write('line %d of %s: %d\n' % (j, name, rand.randrange(1000000)))
+    f.close()
+    made.append(name)
+  if depth > 0:
+    for i in range(dirs):
+      name = os.path.join(path, 'dir%d' % i)
+      os.mkdir(name)
+      made.extend(make_tree(name, depth - 1, dirs, files, lines, rand))
+  return made
+
+
+def main():
+  try:
+    opts, args = my_getopt(sys.argv[1:], '',
+                           ['bin-dir=', 'scheme=', 'url=', 'port=',
+                            'depth=', 'dirs=', 'files=', 'lines=',
+                            'revisions=', 'max-files=', 'seed=', 'help'])
+  except getopt.GetoptError:
+    usage(1)
+
+  bin_dir = None
+  scheme = 'file'
+  url = None
+  port = 3691
+  depth, dirs, files, lines = 3, 5, 10, 50
+  revisions, max_files = 100, 10
+  seed = 0
+  for opt, value in opts:
+    if opt == '--help':
+      usage(0)
+    elif opt == '--bin-dir':
+      bin_dir = value
+    elif opt == '--scheme':
+      scheme = value
+    elif opt == '--url':
+      url = value.rstrip('/')
+    elif opt == '--port':
+      port = int(value)
+    elif opt == '--depth':
+      depth = int(value)
+    elif opt == '--dirs':
+      dirs = int(value)
+    elif opt == '--files':
+      files = int(value)
+    elif opt == '--lines':
+      lines = int(value)
+    elif opt == '--revisions':
+      revisions = int(value)
+    elif opt == '--max-files':
+      max_files = int(value)
+    elif opt == '--seed':
+      seed = int(value)
+
+  if len(args) != 1 or scheme not in ('file', 'svn', 'http'):
+    usage(1)
+  if (scheme == 'http') != (url is not None):
+    sys.stderr.write("wc-bench.py: --url goes with --scheme=http\n")
+    sys.exit(1)
+
+  work_dir = os.path.abspath(args[0])
+  os.mkdir(work_dir)
+  bench = Benchmark(bin_dir, scheme)
+  rand = random.Random(seed)
+  server = None
+
+  try:
+    if scheme != 'http':
+      repos = os.path.join(work_dir, 'repos')
+      subprocess.check_call([bench.program('svnadmin'), 'create', repos])
+      if scheme == 'file':
+        url = 'file://' + repos
+      else:
+        conf = open(os.path.join(repos, 'conf', 'svnserve.conf'), 'w')
+        conf.write('[general]\nanon-access = write\n')
+        conf.close()
+        server = subprocess.Popen([bench.program('svnserve'), '-d',
+                                   '--foreground', '--listen-port',
+                                   str(port), '-r', repos])
+        url = 'svn://localhost:%d' % port
+        time.sleep(1)
+
+    trunk = url + '/trunk'
+    wc = os.path.join(work_dir, 'wc')
+
+    # The initial tree.
+    bench.run(['mkdir', '-m', 'trunk', trunk])
+    bench.run(['checkout', trunk, wc])
+    tree = make_tree(wc, depth, dirs, files, lines, rand)
+    bench.run(['add', '--force', '-q', '.'], cwd=wc)
+    bench.time('commit-tree', 1, ['commit', '-m', 'tree', '-q'], cwd=wc)
+    bench.run(['copy', '-m', 'branch', trunk, url + '/branch'])
+    bench.run(['update', '-q'], cwd=wc)
+
+    # The history, in the manner of random-commits.py.
+    start = time.time()
+    for i in range(revisions):
+      changed = rand.sample(tree, rand.randrange(1, max_files + 1))
+      for name in changed:
+        f = open(name, 'a')
+        f.write('part of change #%d\n' % (i + 1))
+        f.close()
+      bench.run(['commit', '-q', '-m', 'commit #%d' % (i + 1)] + changed)
+    print('BENCH\t%s\tcommit-history\t%d\t%.3f\t-\t-\t-\t-\t-'
+          % (scheme, revisions, time.time() - start))
+
+    # Read-only and update operations on a fresh working copy.
+    shutil.rmtree(wc)
+    bench.time('checkout', 1, ['checkout', '-q', trunk, wc])
+
+    # Commands which do next to no work, so that the time is mostly the
+    # client's start-up: loading modules, reading the configuration and
+    # setting up authentication.
+    bench.time('startup-version', 100, ['--version', '--quiet'])
+    bench.time('startup-info', 100, ['info'], cwd=wc)
+    bench.time('status', 10, ['status', '-q'], cwd=wc)
+    bench.time('status-verbose', 1, ['status', '-v'], cwd=wc)
+    bench.time('status-remote', 1, ['status', '-u', '-q'], cwd=wc)
+    bench.run(['update', '-q', '-r', '2'], cwd=wc)  # just the tree
+    bench.time('update', 1, ['update', '-q'], cwd=wc)
+    bench.time('update-noop', 10, ['update', '-q'], cwd=wc)
+
+    # Modify part of the tree locally and look at it.  The fresh working
+    # copy is where the old one was, so the paths in TREE still apply.
+    for name in rand.sample(tree, len(tree) // 10 or 1):
+      f = open(name, 'a')
+      f.write('local change\n')
+      f.close()
+    bench.time('status-modified', 10, ['status', '-q'], cwd=wc)
+    bench.time('commit-modified', 1, ['commit', '-q', '-m', 'local'],
+               cwd=wc)
+
+    # Blame the file with the longest history.
+    counts = {}
+    log = bench.run(['log', '-v', '-q', trunk])
+    for line in log.splitlines():
+      line = line.strip()
+      if line.startswith('M /trunk/'):
+        counts[line[2:]] = counts.get(line[2:], 0) + 1
+    if counts:
+      busiest = max(counts.keys(), key=lambda k: (counts[k], k))
+      bench.time('blame', 1, ['blame', url + busiest])
+
+    # Merge all of trunk's history to the branch.
+    branch_wc = os.path.join(work_dir, 'branch')
+    bench.run(['checkout', '-q', url + '/branch', branch_wc])
+    bench.time('merge', 1, ['merge', '-q', trunk], cwd=branch_wc)
+    bench.time('commit-merge', 1, ['commit', '-q', '-m', 'merge'],
+               cwd=branch_wc)
+  finally:
+    if server:
+      server.terminate()
+      server.wait()
+
+
+if __name__ == '__main__':
+  main()
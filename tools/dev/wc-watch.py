@@ -0,0 +1,247 @@
+#!/usr/bin/env python
+#
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+#
+#
+# wc-watch.py:  (See wc-watch.py --help.)
+#
+# Keeps a change journal for a working copy, which lets 'svn status'
+# skip reading directories in which nothing changed since its last run.
+#
+# The script watches every directory below the working copy root with
+# inotify, so it only works on Linux.  It writes .svn/status-journal in
+# the root: a header line identifying this run, then the path of every
+# directory, relative to the root and "." for the root itself, in which
+# anything was created, removed or written to.  A change in a .svn
+# directory counts as a change in the directory it belongs to.
+#
+# The journal is only trusted while the script runs: it removes the
+# journal when it exits or the kernel drops events, and touches it
+# every few seconds so that svn ignores it if the script gets killed.
+#
+# The journal grows with every change; restart the script to start
+# over with an empty one.
+#
+
+import ctypes
+import ctypes.util
+import getopt
+import os
+import select
+import signal
+import struct
+import sys
+import time
+
+IN_MODIFY      = 0x00000002
+IN_ATTRIB      = 0x00000004
+IN_CLOSE_WRITE = 0x00000008
+IN_MOVED_FROM  = 0x00000040
+IN_MOVED_TO    = 0x00000080
+IN_CREATE      = 0x00000100
+IN_DELETE      = 0x00000200
+IN_DELETE_SELF = 0x00000400
+IN_MOVE_SELF   = 0x00000800
+IN_Q_OVERFLOW  = 0x00004000
+IN_IGNORED     = 0x00008000
+IN_ONLYDIR     = 0x01000000
+IN_DONT_FOLLOW = 0x02000000
+IN_ISDIR       = 0x40000000
+
+WATCH_MASK = (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM
+              | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_DELETE_SELF
+              | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW)
+
+EVENT_HEADER = struct.Struct('iIII')
+
+ADM_DIR = b'.svn'
+JOURNAL_NAME = b'status-journal'
+JOURNAL_HEADER = b'svn-status-journal 1 '
+
+# Files of the journal and of svn's record of what it found unchanged
+# live next to each other; changes to them are not changes to the
+# working copy.
+OWN_PREFIX = b'status-'
+
+# Must be well below JOURNAL_MAX_AGE in libsvn_wc/status.c.
+HEARTBEAT = 10
+
+def fsencode(path):
+  if isinstance(path, bytes):
+    return path
+  return path.encode(sys.getfilesystemencoding())
+
+class Overflow(Exception):
+  pass
+
+class Watcher:
+  def __init__(self, root):
+    self.root = os.path.abspath(fsencode(root))
+    self.adm = os.path.join(self.root, ADM_DIR)
+    self.journal_path = os.path.join(self.adm, JOURNAL_NAME)
+    self.libc = ctypes.CDLL(ctypes.util.find_library('c'), use_errno=True)
+    self.fd = self.libc.inotify_init()
+    if self.fd < 0:
+      raise OSError(ctypes.get_errno(), 'inotify_init() failed')
+    self.watches = {}
+
+  def add_tree(self, top):
+    "Watch TOP and all directories below it; return their paths."
+    added = []
+    for dirpath, dirnames, filenames in os.walk(top):
+      wd = self.libc.inotify_add_watch(self.fd, dirpath, WATCH_MASK)
+      if wd < 0:
+        # Removed again before we got to it; its parent has an event.
+        dirnames[:] = []
+        continue
+      self.watches[wd] = dirpath
+      added.append(dirpath)
+    return added
+
+  def remove_tree(self, top):
+    """Stop watching TOP and all directories below it.  Their watches
+    would follow them to wherever they were moved, under the old name."""
+    prefix = os.path.join(top, b'')
+    for wd, dirpath in list(self.watches.items()):
+      if dirpath == top or dirpath.startswith(prefix):
+        self.libc.inotify_rm_watch(self.fd, wd)
+        del self.watches[wd]
+
+  def owner(self, dirpath):
+    """Return the journal path of the versioned directory that a change
+    in DIRPATH changes."""
+    relpath = os.path.relpath(dirpath, self.root)
+    parts = relpath.split(os.sep.encode('ascii'))
+    if ADM_DIR in parts:
+      parts = parts[:parts.index(ADM_DIR)]
+    if not parts or parts == [b'.']:
+      return b'.'
+    return b'/'.join(parts)
+
+  def start(self):
+    self.add_tree(self.root)
+    token = ('%d-%d' % (int(time.time()), os.getpid())).encode('ascii')
+    # Only create the journal once everything is being watched.
+    f = open(self.journal_path, 'wb')
+    f.write(JOURNAL_HEADER + token + b'\n')
+    f.close()
+    self.journal = open(self.journal_path, 'ab')
+
+  def stop(self):
+    try:
+      os.remove(self.journal_path)
+    except OSError:
+      pass
+
+  def read_events(self):
+    "Return the journal paths of the directories changed by pending events."
+    changed = []
+    buf = os.read(self.fd, 65536)
+    pos = 0
+    while pos < len(buf):
+      wd, mask, cookie, length = EVENT_HEADER.unpack_from(buf, pos)
+      pos += EVENT_HEADER.size
+      name = buf[pos:pos + length].rstrip(b'\0')
+      pos += length
+
+      if mask & IN_Q_OVERFLOW:
+        raise Overflow()
+      dirpath = self.watches.get(wd)
+      if dirpath is None:
+        continue
+      if mask & IN_IGNORED:
+        del self.watches[wd]
+        continue
+      if dirpath == self.adm and name.startswith(OWN_PREFIX):
+        continue
+
+      changed.append(self.owner(dirpath))
+      if mask & IN_ISDIR and mask & IN_MOVED_FROM:
+        self.remove_tree(os.path.join(dirpath, name))
+      if mask & IN_ISDIR and mask & (IN_CREATE | IN_MOVED_TO):
+        for added in self.add_tree(os.path.join(dirpath, name)):
+          changed.append(self.owner(added))
+    return changed
+
+  def run(self):
+    last_beat = time.time()
+    while True:
+      readable = select.select([self.fd], [], [], HEARTBEAT)[0]
+      if readable:
+        changed = self.read_events()
+        if changed:
+          seen = set()
+          lines = []
+          for relpath in changed:
+            if relpath not in seen:
+              seen.add(relpath)
+              lines.append(relpath + b'\n')
+          # svn ignores an incomplete last line, so it never reads a
+          # path that is still being written.
+          self.journal.write(b''.join(lines))
+          self.journal.flush()
+      if time.time() - last_beat >= HEARTBEAT:
+        os.utime(self.journal_path, None)
+        last_beat = time.time()
+
+def usage(status):
+  sys.stderr.write("""usage: wc-watch.py WCROOT
+
+Keep .svn/status-journal in the working copy root WCROOT up to date
+until interrupted, so that 'svn status' can skip unchanged directories.
+Linux only.
+""")
+  sys.exit(status)
+
+def main():
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], 'h', ['help'])
+  except getopt.GetoptError:
+    usage(1)
+  for opt, value in opts:
+    if opt in ('-h', '--help'):
+      usage(0)
+  if len(args) != 1:
+    usage(1)
+
+  watcher = Watcher(args[0])
+  if not os.path.isdir(watcher.adm):
+    sys.stderr.write("wc-watch.py: '%s' is not a working copy root\n"
+                     % args[0])
+    sys.exit(1)
+
+  def terminate(signum, frame):
+    raise KeyboardInterrupt()
+  signal.signal(signal.SIGTERM, terminate)
+
+  watcher.start()
+  try:
+    try:
+      watcher.run()
+    except KeyboardInterrupt:
+      pass
+    except Overflow:
+      sys.stderr.write("wc-watch.py: missed events, journal removed\n")
+      sys.exit(1)
+  finally:
+    watcher.stop()
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,128 @@
+/* diff-bench.c -- time file diffs
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <stdlib.h>
+
+#include <apr.h>
+#include <apr_general.h>
+#include <apr_tables.h>
+#include <apr_time.h>
+
+#include "svn_pools.h"
+#include "svn_diff.h"
+#include "svn_io.h"
+
+
+/* Diff ORIGINAL against MODIFIED ITERATIONS times with the diff options
+ * in ARGS and print how long that took to OSTREAM. */
+static svn_error_t *
+do_bench(svn_stream_t *ostream,
+         const char *original, const char *modified,
+         int iterations,
+         const apr_array_header_t *args,
+         apr_pool_t *pool)
+{
+  svn_diff_file_options_t *options = svn_diff_file_options_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start;
+  apr_time_t elapsed;
+  svn_boolean_t has_changes = FALSE;
+  int i;
+
+  SVN_ERR(svn_diff_file_options_parse(options, args, pool));
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; i++)
+    {
+      svn_diff_t *diff;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_diff_file_diff_2(&diff, original, modified, options,
+                                   iterpool));
+      has_changes = svn_diff_contains_diffs(diff);
+    }
+  elapsed = apr_time_now() - start;
+
+  svn_pool_destroy(iterpool);
+
+  return svn_stream_printf(ostream, pool,
+                           "%d iterations, %s, %" APR_TIME_T_FMT " usec "
+                           "(%" APR_TIME_T_FMT " usec per diff)\n",
+                           iterations,
+                           has_changes ? "different" : "identical",
+                           elapsed, elapsed / iterations);
+}
+
+int main(int argc, char *argv[])
+{
+  apr_pool_t *pool;
+  svn_stream_t *ostream;
+  int rc;
+  svn_error_t *svn_err;
+
+  apr_initialize();
+
+  pool = svn_pool_create(NULL);
+
+  svn_err = svn_stream_for_stdout(&ostream, pool);
+  if (svn_err)
+    {
+      svn_handle_error2(svn_err, stdout, FALSE, "diff-bench: ");
+      rc = 2;
+    }
+  else if (argc >= 4 && atoi(argv[3]) > 0)
+    {
+      apr_array_header_t *args = apr_array_make(pool, argc - 4,
+                                                sizeof(const char *));
+      int i;
+
+      for (i = 4; i < argc; i++)
+        APR_ARRAY_PUSH(args, const char *) = argv[i];
+
+      svn_err = do_bench(ostream, argv[1], argv[2], atoi(argv[3]), args,
+                         pool);
+      if (svn_err == NULL)
+        {
+          rc = 0;
+        }
+      else
+        {
+          svn_handle_error2(svn_err, stdout, FALSE, "diff-bench: ");
+          rc = 2;
+        }
+    }
+  else
+    {
+      svn_error_clear(svn_stream_printf(ostream, pool,
+                                        "Usage: %s <file1> <file2> "
+                                        "<iterations> [diff options...]\n"
+                                        "Diff options: -b, -w, "
+                                        "--ignore-eol-style, --histogram\n",
+                                        argv[0]));
+      rc = 2;
+    }
+
+  apr_terminate();
+
+  return rc;
+}
@@ -138,7 +138,10 @@ build_index(const char *repos_path, apr_pool_t *pool)
                               "[%%%dd/%%%dd]  Found %%d new lines of history."
                               "\n", slotsize, slotsize);
 
-  /* Now, iterate over all the revisions, calling index_revision_adds(). */
+  /* Now, iterate over all the revisions, calling index_revision_adds().
+     FSFS writes the origins found to its index in large batches, which
+     keeps this bulk load cheap; the final batch gets written when the
+     repository is closed along with POOL. */
   subpool = svn_pool_create(pool);
   for (i = 0; i < youngest_rev; i++)
     {
@@ -75,6 +75,27 @@ The update report::
     status <PATH> r<N> depth=<D>?
     switch <FROM-PATH> <TO-PATH>@<N> depth=<D>?
     update <PATH> r<N> depth=<D>? send-copyfrom-args?
+
+SVN-STATS strings
+-----------------
+
+mod_dav_svn also sets SVN-STATS to what the request cost, as words of
+the form <NAME>=<N>::
+
+    time=<N> svn=<N> send=<N> bytes=<N> cache-hits=<N> cache-misses=<N> authz=<N> nodes=<N>
+
+time is the number of microseconds from opening the repository to
+logging the request, of which svn were spent in Subversion and send
+waiting for the client to take the response.  bytes is the size of
+the response, cache-hits and cache-misses count the lookups in the
+repository's caches, authz the path-based authz checks, and nodes the
+nodes sent by update-style reports.
+
+To aggregate them, log both strings, e.g. with::
+
+    LogFormat "%{SVN-ACTION}e %{SVN-STATS}e" svn-stats
+
+and feed each action and its stats to a StatsAggregator.
 """
 
 
@@ -164,6 +185,18 @@ def _parse_mergeinfo_inheritance(word):
         raise BadMergeinfoInheritanceError(word)
     return svn_inheritance_from_word(word)
 
+def parse_stats(line):
+    """Return a dict mapping the names in an SVN-STATS string to ints.
+
+    Words that aren't of the form <NAME>=<N> are ignored.
+    """
+    stats = {}
+    for word in line.split():
+        name, sep, value = word.partition('=')
+        if sep and value.isdigit():
+            stats[name] = int(value)
+    return stats
+
 def _match(line, *patterns):
     """Return a re.match object from matching patterns against line.
 
@@ -458,3 +491,32 @@ class Parser(object):
         send_copyfrom_args = m.group(5) is not None
         self.handle_update(path, revision, depth, send_copyfrom_args)
         return line[m.end():]
+
+
+class StatsAggregator(object):
+    """Sum up SVN-STATS by action, e.g. 'update' or 'log', to find out
+    which kinds of requests cost the server the most.
+    """
+    def __init__(self):
+        # action -> {name -> total}, plus 'count' and 'max-time'
+        self.totals = {}
+
+    def add(self, action, stats):
+        """Count the SVN-STATS string stats of a request whose SVN-ACTION
+        string is action."""
+        words = action.split()
+        if not words:
+            return
+        totals = self.totals.setdefault(words[0], {'count': 0,
+                                                   'max-time': 0})
+        totals['count'] += 1
+        for name, value in parse_stats(stats).items():
+            totals[name] = totals.get(name, 0) + value
+            if name == 'time' and value > totals['max-time']:
+                totals['max-time'] = value
+
+    def report(self, key='time'):
+        """Return a list of (action, totals) pairs, the action with the
+        largest total of key first."""
+        return sorted(self.totals.items(),
+                      key=lambda item: item[1].get(key, 0), reverse=True)
@@ -354,6 +354,26 @@ class TestCase(unittest.TestCase):
         self.assertEqual(self.result, ('/foo', 9, svn.core.svn_depth_unknown,
                                        True))
 
+    def test_parse_stats(self):
+        self.assertEqual(svn_server_log_parse.parse_stats(''), {})
+        self.assertEqual(svn_server_log_parse.parse_stats('-'), {})
+        self.assertEqual(svn_server_log_parse.parse_stats(
+                           'time=120 svn=100 send=20 bytes=5 foo bar=x'),
+                         {'time': 120, 'svn': 100, 'send': 20, 'bytes': 5})
+
+    def test_stats_aggregator(self):
+        aggregator = svn_server_log_parse.StatsAggregator()
+        aggregator.add('update /foo r9', 'time=100 nodes=3')
+        aggregator.add('log (/) r9:1', 'time=500 nodes=0')
+        aggregator.add('update /bar r9', 'time=300 nodes=7')
+        aggregator.add('', 'time=999')
+        report = aggregator.report()
+        self.assertEqual([x[0] for x in report], ['log', 'update'])
+        self.assertEqual(report[1][1], {'count': 2, 'max-time': 300,
+                                        'time': 400, 'nodes': 10})
+        report = aggregator.report('nodes')
+        self.assertEqual([x[0] for x in report], ['update', 'log'])
+
 if __name__ == '__main__':
     if len(sys.argv) == 1:
         # No arguments so run the unit tests.